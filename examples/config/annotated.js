@@ -39,6 +39,22 @@
   // Unix epoch as its random number seed.
   seed: 123456,
 
+  // RANDOM NUMBER ENGINE (optional)
+  //
+  // The "random_engine" JSON object selects the pseudorandom number engine
+  // used by MARLEY. The "type" key may be set to either "mt19937_64" (the
+  // default 64-bit Mersenne Twister) or "philox" (the counter-based
+  // Philox4x64-10 engine). When the Philox engine is used, the random numbers
+  // for each event are determined entirely by the seed, the stream ID, and
+  // the event number, so any event may be regenerated on its own. The
+  // optional "stream" key gives a non-negative integer stream ID (default 0).
+  // Runs that share a seed but use different stream IDs are guaranteed to
+  // use non-overlapping random numbers, which makes this engine convenient
+  // for sharded productions.
+  //
+  // If this key is omitted, the Mersenne Twister will be used.
+  random_engine: { type: "mt19937_64" },
+
   // INCIDENT NEUTRINO DIRECTION (optional)
   //
   // The "direction" JSON object stores a 3-vector that represents the
@@ -139,6 +155,49 @@
   //
   reactions: [ "ve40ArCC_Bhattacharya2009.react", "ES.react" ],
 
+  // ENABLED REACTIONS (optional)
+  //
+  // By default, every reaction loaded from the files above is used. If the
+  // "enabled_reactions" array is present, then only the reactions that it
+  // lists are used, and the others are disabled. Each entry is either a
+  // reaction description (as printed in the list of active reactions at the
+  // end of the generator setup, e.g., "νe + 40Ar --> e⁻ + 40K*") or the
+  // position of the reaction (counting from zero) in the vector returned by
+  // marley::Generator::get_reactions(). Together with
+  // "source", "target", and "direction", this key may also be applied to an
+  // existing Generator via marley::JSONConfig::reconfigure(), which keeps
+  // the loaded reactions and all of the cached cross section, nuclear
+  // model, and decay tables. This is useful when scanning over many
+  // sources in a single program.
+  //enabled_reactions: [ 0 ],
+
+  // DETECTOR MATERIALS (optional)
+  //
+  // A detector built from several materials (e.g., liquid argon, the steel
+  // of its cryostat, and a xenon dopant) may be simulated in a single job by
+  // replacing the "target" and "reactions" keys with a "materials" array.
+  // Each entry gives a "target" object and a "reactions" array with the same
+  // format as above, together with an optional "name" and an "exposure"
+  // (default 1). The exposure is proportional to the number of target atoms
+  // in the material times the live time; only relative values matter.
+  //
+  // The materials are merged into one composite target with exposure-weighted
+  // nuclide fractions, and each reaction is enabled only for the nuclides of
+  // the materials that list its data file. Events are then distributed among
+  // the materials in proportion to exposure times flux-averaged cross
+  // section. All materials share the same nuclear structure data, so this
+  // is much cheaper than running a separate job per material. Materials that
+  // contain the same nuclide must enable the same reactions on it.
+  //
+  //materials: [
+  //  { name: "liquid argon", exposure: 0.99,
+  //    target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },
+  //    reactions: [ "ve40ArCC_Bhattacharya2009.react", "ES.react" ] },
+  //  { name: "cryostat steel", exposure: 0.01,
+  //    target: { nuclides: [ 1000260560 ], atom_fractions: [ 1.0 ] },
+  //    reactions: [ "my_ES_56Fe.react" ] },
+  //],
+
   // NEUTRINO SOURCE SPECIFICATION (required)
   //
   // The "source" JSON object describes the incident neutrino spectrum. The
@@ -177,6 +236,9 @@
   //   interpolation on a set of grid
   //   points
   //
+  //   Time-binned spectrum (one of the       "time-binned"
+  //   above in each time bin)
+  //
   //   ROOT TH1                               "th1"
   //
   //   ROOT TGraph                            "tgraph"
@@ -265,6 +327,51 @@
   //  in energy, logarithmic in probability density), and "loglin"
   //  (logarithmic in energy, linear in probability density).
   //
+  //  Large tables may be kept in a separate binary file instead of being
+  //  written out in the configuration. The file is memory-mapped and read
+  //  without any text parsing, so the startup time does not depend on the
+  //  size of the table. Any of the arrays used by the histogram, grid, and
+  //  time-binned sources may be replaced by a file name or by an object
+  //  that selects one column of a table:
+  //
+  //  source: {
+  //    type: "grid",
+  //    neutrino: "ve",
+  //    energies: { file: "flux.npy", column: 0 },
+  //    prob_densities: { file: "flux.npy", column: 1 },
+  //  },
+  //
+  //  Files that begin with the NumPy magic string are read as .npy files
+  //  (1D or 2D arrays of 32- or 64-bit floating-point numbers, e.g., saved
+  //  using numpy.save()). Any other file is read as a headerless sequence of
+  //  little-endian 64-bit floating-point numbers stored row by row. For
+  //  such a file, the "columns" key gives the number of values in each row
+  //  (1 by default). The file is found using the MARLEY search path if it
+  //  is not present in the working directory.
+  //
+  //  TIME-BINNED
+  //
+  //  source: {
+  //    type: "time-binned",
+  //    neutrino: "ve",
+  //    time_edges: [ 0., 0.1, 1., 10. ],  // Time bin edges (N + 1 values)
+  //    weights: [ 5., 3., 1. ],           // Number of neutrinos emitted in
+  //                                       // each bin (do not need to be
+  //                                       // normalized to unity)
+  //    bins: [                            // Energy spectrum for each bin
+  //      { type: "fd", Emin: 0, Emax: 60, temperature: 5.0 },
+  //      { type: "fd", Emin: 0, Emax: 60, temperature: 3.5 },
+  //      { type: "fd", Emin: 0, Emax: 60, temperature: 2.0 },
+  //    ],
+  //  },
+  //
+  //  Each element of the "bins" array uses the same format as an ordinary
+  //  source specification (without the "neutrino" key). The cross-section-
+  //  weighted energy CDF of every bin is tabulated once at startup. Each
+  //  event is assigned a bin and an energy from these tables, and its time
+  //  is sampled uniformly within the bin. The sampled time is stored with
+  //  the event (in the same units as the bin edges).
+  //
   //
   //  TH1
   //
@@ -300,6 +407,376 @@
     energy: 15.0,          // MeV
   },
 
+  // DE-EXCITATION PRECISION PRESET (optional)
+  //
+  // The "precision" key selects a consistent group of numerical settings for
+  // the nuclear de-excitation calculations. Allowed values are
+  //
+  //   "validation": Numerov step of 0.05 fm and optical model matching
+  //                 threshold of 1e-4 MeV, 129-point Chebyshev interpolants
+  //                 for the continuum excitation energy distributions, a
+  //                 sampling tolerance of 1e-14, adaptive integration of the
+  //                 continuum widths to a relative tolerance of 1e-8, and
+  //                 no model tables. This is intended for checking the
+  //                 accuracy of the other presets (e.g., of gamma-ray lines)
+  //                 and is considerably slower than "production".
+  //
+  //   "production": The defaults (Numerov step of 0.1 fm, threshold of
+  //                 1e-3 MeV, 65-point interpolants, sampling tolerance of
+  //                 1e-12, and the fixed-order integration rule).
+  //
+  //   "fast":       Numerov step of 0.15 fm, threshold of 1e-2 MeV, 33-point
+  //                 interpolants, sampling tolerance of 1e-8, and tables
+  //                 (with twice the usual grid spacing) for the transmission
+  //                 coefficients, level densities, and gamma-ray strength
+  //                 functions. This is suitable when only the total visible
+  //                 energy of each event matters.
+  //
+  // The preset is applied before the other keys in this file, so any of the
+  // settings above that also have their own key (e.g.,
+  // "integration_tolerance" or "transmission_mode") may still be changed
+  // individually.
+  //
+  // Measured costs and accuracy of the presets for 30 MeV dark matter
+  // absorption on 40Ar (examples/config/benchmarks/dm_40Ar_continuum*.js,
+  // about 31% of events populate the unbound continuum), obtained with
+  //
+  //   marthroughput dm_40Ar_continuum.js dm_40Ar_continuum_validation.js
+  //     dm_40Ar_continuum_fast.js
+  //
+  // on a single core (Linux, g++ 12.2, -O3), median of three runs:
+  //
+  //   preset          events/s (5000 events)   events/s (long runs)
+  //   "validation"              330                 610 (10^4 events)
+  //   "production"             2600                9500 (5x10^4 events)
+  //   "fast"                   2500               10800 (5x10^4 events)
+  //
+  // The startup time (~6 ms) and peak memory use (~20 MB) were the same for
+  // all three. In short runs, building the "fast" tables costs about as much
+  // as they save.
+  //
+  // Relative to "validation", the total Hauser-Feshbach widths of 40K states
+  // (Ex = 8.5-26 MeV, J = 0-3, both parities) differ by at most 1.1e-3
+  // ("production") and 1.4e-3 ("fast"). The branching ratios of the
+  // individual exit channels differ by at most 9e-4 and 1.2e-3 (absolute).
+  // Gamma-ray line energies come from the discrete level data and are
+  // identical for all presets. For 4x10^4 events with the same seed, the
+  // event-level results agree within their statistical uncertainties:
+  //
+  //   preset         n      p      alpha   <N_gamma>   <E_gamma> (MeV)
+  //   "validation"  0.199  0.0756  0.0529    2.541       3.887
+  //   "production"  0.199  0.0755  0.0530    2.543       3.890
+  //   "fast"        0.199  0.0754  0.0531    2.543       3.887
+  //   (uncertainty  0.002  0.0013  0.0011    0.006       0.011)
+  //
+  // Here n, p, and alpha are the fractions of events that emit each nuclear
+  // fragment. The intensity of the strongest line (770 keV, 0.448 per event
+  // for "validation") differs by at most 0.002 per event (uncertainty
+  // 0.003).
+  //
+  // If this key is omitted, the "production" settings will be used.
+  //precision: "production",
+
+  // HAUSER-FESHBACH DECAY CACHE SIZE (optional)
+  //
+  // MARLEY stores the exit channel widths computed for each Hauser-Feshbach
+  // decay of an unbound compound nucleus so that they may be reused whenever
+  // the same nuclear state (species, excitation energy, spin, and parity) is
+  // encountered again. This is common for the initial decay step, since the
+  // primary reaction populates a fixed set of nuclear levels. The
+  // "hf_decay_cache_size" key gives the maximum number of nuclear states to
+  // store. When the cache is full, the least recently used entry is
+  // discarded. A value of zero disables the cache. The cache does not change
+  // the generated events.
+  //
+  // If this key is omitted, a value of 1024 will be assumed.
+  hf_decay_cache_size: 1024,
+
+  // NUMERICAL INTEGRATION TOLERANCE (optional)
+  //
+  // Total decay widths for the continuum and the normalization of the
+  // reacting neutrino energy distribution are computed by numerical
+  // integration. By default, continuum widths are obtained from the same
+  // 65-point Chebyshev interpolant later used to sample the final
+  // excitation energy, and a fixed Clenshaw-Curtis rule with 101 points is
+  // used for the normalization. If the "integration_tolerance" key is set to a positive value, an
+  // adaptive rule is used instead. It refines the integral until successive
+  // estimates agree to within the given relative tolerance. This usually
+  // needs many fewer evaluations of smooth integrands. A warning is printed
+  // if the tolerance cannot be met.
+  //
+  // If this key is omitted or set to zero, the fixed rule will be used.
+  //integration_tolerance: 1e-6,
+
+  // FRAGMENT PARTIAL WAVE TRUNCATION (optional)
+  //
+  // The differential widths for fragment emission to the continuum sum over
+  // the fragment orbital angular momentum l up to "fragment_lmax" (5 by
+  // default). Each term requires the optical model transmission
+  // coefficients for that l. These become tiny for large l when the fragment
+  // energy is low. If the "fragment_l_tolerance" key is set to a positive
+  // value, the sum stops at the first l whose contribution is no more than
+  // the given fraction of the width accumulated so far, and the remaining
+  // transmission coefficients are never computed. This changes the widths
+  // slightly (by roughly the given fraction), so individual events will not
+  // match those generated with this option disabled.
+  //
+  // If this key is omitted or set to zero, all l up to "fragment_lmax" will
+  // be used.
+  //fragment_l_tolerance: 1e-4,
+
+  // LAZY CONTINUUM WIDTHS (optional)
+  //
+  // Each Hauser-Feshbach decay normally computes the total width of every
+  // continuum exit channel (n, p, d, t, h, alpha, and gamma) before choosing
+  // one of them. If the "lazy_continuum_widths" key is set to true, cheap
+  // upper bounds on these widths are used instead, and the exact width of a
+  // channel is only computed when the channel is proposed during rejection
+  // sampling. The exit channels are sampled from the same distribution
+  // either way, but the random number sequence differs, so individual events
+  // will not match those generated with this option disabled.
+  //
+  // If this key is omitted, a value of false will be assumed.
+  //lazy_continuum_widths: true,
+
+  // PARALLEL EXIT CHANNELS (optional)
+  //
+  // A compound nucleus with a high excitation energy may have many open exit
+  // channels, and building all of them dominates the time needed to
+  // generate the slowest events. If "exit_channel_threads" is set to a
+  // positive integer, a pool of that many helper threads (shared by all
+  // event generation threads) is started, and the widths for each emitted
+  // particle species are computed at the same time. The channels are stored
+  // in the usual order, so the generated events are unchanged.
+  //
+  // If this key is omitted, a value of 0 (no helper threads) will be assumed.
+  //exit_channel_threads: 4,
+
+  // POOLED DISCRETE EXIT CHANNELS (optional)
+  //
+  // A Hauser-Feshbach decay normally keeps one exit channel for each
+  // discrete level that can be reached by emitting each kind of particle.
+  // For nuclei with many known levels, most of these channels are very
+  // unlikely. If the "discrete_pool_tolerance" key is set to a positive
+  // value, the least likely discrete channels are merged into a single
+  // channel per emitted particle, as long as their combined width stays
+  // below the given fraction of the total decay width. When a pooled channel
+  // is chosen, one of its levels is selected in proportion to its width, so
+  // the decays follow the same distribution. This saves memory and speeds
+  // up sampling, but individual events will not match those generated with
+  // this option disabled.
+  //
+  // If this key is omitted or set to zero, no channels will be pooled.
+  //discrete_pool_tolerance: 1e-3,
+
+  // GAMMA CASCADE PATH TABLES (optional)
+  //
+  // The gamma-ray cascades between discrete nuclear levels are normally
+  // sampled one transition at a time. If the "cascade_path_tolerance" key
+  // is set to a positive value, MARLEY instead lists the most probable
+  // complete cascades that begin at each level when the level data are
+  // loaded. The list stops once the remaining cascades have a total
+  // probability below the given value (or once 64 cascades have been found).
+  // A whole cascade can then be chosen using one random draw, and the
+  // remaining cascades are still sampled one step at a time. This can speed
+  // up high-statistics jobs. The cascades are sampled from the same
+  // distribution either way, but the random number sequence differs, so
+  // individual events will not match those generated without the tables.
+  //
+  // If this key is omitted or set to zero, the tables will not be used.
+  //cascade_path_tolerance: 1e-3,
+
+  // STRUCTURE DATA PREFETCH (optional)
+  //
+  // MARLEY looks up the discrete level data for each nuclide the first time
+  // that it is needed. The folders on the search path are listed only once,
+  // but this can still happen in the middle of event generation. If the
+  // "prefetch_structure_data" key is set to true, all of the folders on the
+  // search path are listed and every data file in the structure index is
+  // located during startup instead. This may be helpful when the data files
+  // are stored on a network filesystem.
+  //
+  // If this key is omitted, a value of false will be assumed.
+  //prefetch_structure_data: false,
+
+  // NUCLEAR STRUCTURE MEMORY BUDGET (optional)
+  //
+  // The nuclear structure data, model tables, and cached Hauser-Feshbach
+  // decays grow with the number of nuclides visited during a run. The
+  // "memory_budget" key gives a limit (in MB) on their combined size. When
+  // the limit is exceeded, the least recently used cached decays are
+  // discarded. The other data are only counted against the budget. In the
+  // marley executable, the budget is shared equally among the worker
+  // threads. The budget does not change the generated events.
+  //
+  // If this key is omitted or set to zero, no limit is applied.
+  //memory_budget: 512,
+
+  // OPTICAL MODEL TRANSMISSION MODE (optional)
+  //
+  // Fragment emission widths in the unbound continuum are computed using
+  // transmission coefficients obtained from a nuclear optical model. If the
+  // "transmission_mode" key is set to "exact" (the default), then the
+  // Schrodinger equation is solved numerically every time a transmission
+  // coefficient is needed. If it is set to "table", then the transmission
+  // coefficients are computed exactly on a uniform energy grid (with a
+  // spacing of 50 keV) as they are needed, and values in between the grid
+  // points are obtained by monotone cubic interpolation. The "table" setting
+  // is faster but slightly changes the generated events.
+  transmission_mode: "exact",
+
+  // LEVEL DENSITY MODE (optional)
+  //
+  // Nuclear level densities are needed many times during each
+  // Hauser-Feshbach decay. If the "level_density_mode" key is set to "table",
+  // then the total level density and spin cut-off parameter for each nuclide
+  // are tabulated on a uniform excitation energy grid (with a spacing of
+  // 10 keV) as they are needed, and values in between the grid points are
+  // obtained by interpolation. The default setting, "exact", evaluates the
+  // level density model directly every time. Like "transmission_mode", the
+  // "table" setting is faster but slightly changes the generated events.
+  level_density_mode: "exact",
+
+  // GAMMA-RAY STRENGTH FUNCTION MODE (optional)
+  //
+  // The "gamma_strength_mode" key works in the same way for the gamma-ray
+  // transmission coefficients. If it is set to "table", they are tabulated
+  // for each nuclide, transition type, and multipolarity on a uniform
+  // gamma-ray energy grid (with a spacing of 10 keV) as they are needed,
+  // and cubic interpolation is used in between the grid points. The default
+  // is "exact".
+  gamma_strength_mode: "exact",
+
+  // CROSS SECTION MODE (optional)
+  //
+  // The total cross section for each nuclear reaction is a sum over all
+  // kinematically accessible final nuclear levels. If the "xs_mode" key is
+  // set to "table", then the partial cross sections to every level are
+  // computed once at startup on an adaptive grid of projectile energies that
+  // spans the energy range of the source, and values in between the grid
+  // points are obtained by linear interpolation. The grid is refined until
+  // the total cross section is interpolated with a relative accuracy of
+  // about 1e-4. The default, "exact", sums over the levels every time a
+  // cross section is needed. The "table" setting is faster but slightly
+  // changes the generated events. When tables are used, the final nuclear
+  // level for each event is also sampled from the tabulated partial cross
+  // sections without evaluating them at the exact projectile energy.
+  xs_mode: "exact",
+
+  // The tables normally end at the maximum energy of the source. Programs
+  // that request events at other energies via the Generator::create_event()
+  // overload for a fixed projectile (e.g., to follow an external flux) may
+  // extend them up to "xs_table_max_energy" (MeV).
+  //xs_table_max_energy: 100.,
+
+  // Instead of building the tables at startup, they may be loaded from a
+  // binary file written by the mardumpxs tool with the per-level cross
+  // sections enabled (see examples/executables/mardumpxs.cc). Tables are
+  // taken from the file only for reactions whose projectile, target,
+  // ejectile, residue, and nuclear levels match, and only if they extend to
+  // the maximum energy that is needed. The remaining tables are built as
+  // usual. If this key is omitted, then all tables are built at startup.
+  //xs_table_file: "xs_tables.bin",
+
+  // REACTION BUNDLE (optional)
+  //
+  // Name of a binary file that holds a precompiled form of the reaction
+  // data for this job: the parsed reaction data files, the particle masses
+  // and thresholds for each reaction, the tabulated Fermi functions, and
+  // (when "xs_mode" is "table") the total cross section tables. If the file
+  // is found (either at the given location or in a folder on the
+  // MARLEY_SEARCH_PATH), then it is read in a single step at startup, and
+  // none of these need to be computed again. Otherwise, it is written once
+  // the reactions have been configured. A bundle is ignored (and rewritten)
+  // if it was written by a different version of MARLEY or if any of the
+  // reaction data files have changed since. Cross section tables are taken
+  // from the bundle only if it was written using the same "coulomb_mode".
+  // By default, no bundle is used.
+  //reaction_bundle: "marley_reactions.bin",
+
+  // CEvNS ENGINE (optional)
+  //
+  // Coherent elastic neutrino-nucleus scattering (CEvNS) is described by an
+  // NC reaction whose only matrix element is a Fermi transition to the
+  // nuclear ground state. If the "cevns_engine" key is set to "coherent",
+  // then each such reaction is handled by a dedicated engine that computes
+  // the cross section in closed form and never runs the nuclear de-excitation
+  // step. The default, "generic", treats these reactions like any other. When
+  // the coherent engine is used, the "cevns_form_factor" key may be set to
+  // "helm" to include the Helm nuclear form factor. The default is "none".
+  //cevns_engine: "coherent",
+  //cevns_form_factor: "helm",
+
+  // IMPORTANCE SAMPLING (optional)
+  //
+  // Rare final states may be oversampled by biasing the choices made while
+  // generating each event. Every event is then given a weight that
+  // compensates for the biases, so that weighted histograms reproduce the
+  // unbiased distributions. Unweighted events (weight 1) are produced when
+  // this key is omitted.
+  //
+  // Each entry in the "reactions" array multiplies the probability of
+  // choosing the matching reactions by "factor". Reactions may be selected
+  // using a "process" ("CC", "NC", "ES", or "DM") and/or the PDG code of the
+  // "target" atom. Entries without either key apply to every reaction. The
+  // optional "levels" array biases the choice of final nuclear level for
+  // the matching reactions: the partial cross section to each level with
+  // Ex_min <= Ex <= Ex_max (MeV) is multiplied by the factor.
+  //
+  // Each entry in the "exit_channels" array multiplies the partial widths of
+  // the Hauser-Feshbach decays that emit the particle with the given PDG
+  // code by "factor". All bias factors must be positive.
+  //biasing: {
+  //  reactions: [ { process: "NC", factor: 10.,
+  //    levels: [ { Ex_min: 8., Ex_max: 12., factor: 5. } ] } ],
+  //  exit_channels: [ { particle: 2112, factor: 3. } ],
+  //},
+
+  // EVENT FILTER (optional)
+  //
+  // Analyses that only use events passing a cut on the primary interaction
+  // may skip the rest of the work for all other events. Each primary
+  // interaction is tested before the nuclear de-excitation and rotation
+  // steps, and it is resampled until it passes. The cuts are given as
+  // optional lower ("_min") and upper ("_max") bounds on the ejectile
+  // kinetic energy ("ejectile_KE", MeV) and the excitation energy of the
+  // residue ("Ex", MeV). Events that pass the filter are the same as in an
+  // unfiltered run with the same seed. At the end of the run, the marley
+  // executable logs the (weighted) fraction of primary interactions that
+  // were accepted. The flux-averaged total cross section must be multiplied
+  // by this fraction to normalize the filtered events. If this key is
+  // omitted, then every event is kept.
+  //event_filter: {
+  //  ejectile_KE_min: 5.,
+  //  Ex_max: 12.,
+  //},
+
+  // MODEL TABLE CACHE (optional)
+  //
+  // Name of a binary file used to keep the tables built when any of the
+  // "transmission_mode", "level_density_mode", or "gamma_strength_mode"
+  // keys is set to "table". If the file is found (either at the given
+  // location or in a folder on the MARLEY_SEARCH_PATH), then its tables are
+  // loaded at startup. The marley executable writes the updated tables back
+  // to the file at the end of the run. The file is ignored if it was written
+  // by a different version of MARLEY or using different values of
+  // "fragment_lmax" or "gamma_lmax". By default, no file is used. The
+  // mardecaytables program (see examples/executables) can be used to build
+  // the file for a job configuration before any events are generated.
+  //model_table_cache: "marley_model_tables.bin",
+
+  // MODEL TABLE PRECOMPUTATION (optional)
+  //
+  // When "transmission_mode" or "level_density_mode" is set to "table", the
+  // tables are normally filled as the events need them. If the
+  // "precompute_model_tables" key is true, then the tables for every nuclide
+  // that can be reached by fragment emission from the reaction residues are
+  // filled at startup instead. The work is shared among one thread per
+  // hardware thread, or among the given number of threads if an integer is
+  // used. This makes the time taken by the first events more predictable and
+  // does not change the generated events. By default, it is disabled.
+  //precompute_model_tables: true,
+
   // EXECUTABLE SETTINGS (optional)
   //
   // The entries within the executable_settings JSON object are used to
@@ -318,6 +795,200 @@
     // If this key is omitted, a value of 1000 will be assumed.
     events: 100000,
 
+    // THREAD COUNT (optional)
+    //
+    // Specifies the number of threads to use for event generation. Each
+    // thread uses its own copy of the generator, which is configured using
+    // the settings in this file and reseeded with seed + n, where n is the
+    // zero-based thread index. Events are distributed among the threads in
+    // a round-robin fashion and written to the output files in a fixed
+    // order, so the results of a multi-threaded run depend only on the seed
+    // and the number of threads. If the counter-based random number engine
+    // is selected (see the "random_engine" key above), every thread shares
+    // the same seed, and the results are also independent of the number of
+    // threads. Resuming a previous run is only supported when a single thread
+    // is used.
+    //
+    // If this key is omitted, a value of 1 will be assumed.
+    threads: 1,
+
+    // PIPELINED EVENT GENERATION (optional)
+    //
+    // The time needed to de-excite the final-state nucleus varies a lot from
+    // one event to the next, while the primary interaction is always cheap.
+    // If the "pipeline" key is set to true, one thread creates the primary
+    // interactions for all of the events, and the remaining threads each take
+    // the next waiting event and de-excite it. The finished events are
+    // written in their original order. A few slow decays then no longer
+    // stall the other threads. This mode needs at least two threads and
+    // the counter-based random number engine (see the "random_engine" key
+    // above), and it cannot be used with checkpoints. The de-excitations use
+    // a separate part of each event's random numbers, so the results are
+    // independent of the number of threads but differ from those generated
+    // with this option disabled.
+    //
+    // If this key is omitted, a value of false will be assumed.
+    //pipeline: true,
+
+    // THREAD AFFINITY (optional)
+    //
+    // On machines with more than one NUMA node (e.g., dual-socket servers),
+    // memory is faster to reach from the CPUs on the node where it lives.
+    // The "thread_affinity" key pins each event generation thread to a
+    // fixed CPU, so the nuclear models and decay caches that a thread
+    // builds for itself are placed on its own node and stay there. The
+    // value "compact" fills every CPU on the first node before moving on to
+    // the next one, while "spread" assigns the threads to the nodes in turn.
+    // Only the CPUs that the job is allowed to use are considered. Pinning
+    // is only supported on Linux and has no effect on the generated events.
+    //
+    // If this key is omitted, a value of "none" will be assumed.
+    //thread_affinity: "spread",
+
+    // STRUCTURE DATA REPLICATION (optional)
+    //
+    // The decay schemes and angular momentum coupling tables are normally
+    // shared by all threads, so threads on other NUMA nodes read them across
+    // the interconnect. If the "replicate_structure" key is true, each node
+    // used by the threads gets its own copy of the nuclear structure data,
+    // which is loaded by a thread on that node. Any memory budget (see the
+    // "memory_budget" key above) applies to each copy separately.
+    // This requires a "thread_affinity" setting other than "none" and does
+    // nothing when all of the threads are on a single node. The generated
+    // events are unchanged.
+    //
+    // If this key is omitted, a value of false will be assumed.
+    //replicate_structure: true,
+
+    // CACHE PREWARMING (optional)
+    //
+    // The first events that reach a new nuclear state spend extra time
+    // building the tables and decay widths used by the de-excitation step.
+    // If the "prewarm" key is true, this work is done before the first
+    // event instead. Starting from the configured reactions and the source
+    // energy range, the tabulated nuclear models (as for the
+    // "precompute_model_tables" key above) are filled for every nuclide
+    // that may be reached. Then each thread builds the Hauser-Feshbach
+    // decays for all of the initial residue states that the reactions can
+    // produce. Each event then takes about the same time from the first one
+    // onward, which helps benchmarks and the event server. An integer may
+    // be given instead of true to set the number of threads used to fill
+    // the tables (zero means one per hardware thread). The generated events
+    // are unchanged.
+    //
+    // If this key is omitted, a value of false will be assumed.
+    //prewarm: true,
+
+    // INSTRUMENTATION REPORT (optional)
+    //
+    // If this key is present, the time spent in each major step of event
+    // generation (reaction sampling, creation of the primary event, nuclear
+    // de-excitation, Hauser-Feshbach decay setup, optical model S-matrix
+    // elements, construction of Chebyshev interpolants, rejection sampling,
+    // and writing events to the output files) is measured and written, along
+    // with call counts and related quantities such as the number of
+    // rejection sampling trials, to the named JSON file at the end of the
+    // run. Statistics are reported separately for each thread and in total.
+    // Collecting them slows down event generation somewhat, so this key
+    // should normally be omitted.
+    //instrumentation_file: "marley_instrumentation.json",
+
+    // SLOW EVENT TRACING (optional)
+    //
+    // MARLEY may be built with tracing zones that show each step of event
+    // generation on the timeline of an external profiler (e.g., via
+    // "make TRACING=tracy", "itt", or "perf"). When it is, any event whose
+    // nuclear de-excitation takes longer than "trace_slow_event_ms"
+    // milliseconds is tagged with a message listing every nuclear state
+    // (nucleus, excitation energy, and spin-parity) in its decay chain. The
+    // setting is ignored (with a warning) if tracing was not compiled in.
+    //
+    // If this key is omitted, a value of 10 will be assumed.
+    //trace_slow_event_ms: 10,
+
+    // MEMORY REPORT (optional)
+    //
+    // The "memory_report_file" key gives the name of a JSON file that will
+    // receive an estimate of the memory held by the nuclear structure data
+    // at the end of the run. The estimate is broken down by nuclide and by
+    // type of data (decay schemes, nuclear models, and cached
+    // Hauser-Feshbach decays) for each worker thread. The total is always
+    // written to the log at the info level.
+    //memory_report_file: "marley_memory.json",
+
+    // HISTOGRAM OUTPUT (optional)
+    //
+    // Studies that only need a few distributions may fill histograms while
+    // the events are generated instead of writing the full events to disk.
+    // The "definitions" array describes each histogram. It gives the name
+    // of an observable ("x") and a uniform binning ("bins", "min", and
+    // "max"). A 2D histogram also needs the "y", "y_bins", "y_min", and
+    // "y_max" keys. The allowed observables are the projectile energy
+    // ("Ev"), the ejectile kinetic energy ("ejectile_KE"), the residue
+    // excitation energy ("Ex"), the summed kinetic energy of the charged
+    // final-state particles and photons apart from the residue
+    // ("visible_energy"), and the number of de-excitation products
+    // ("num_products", "num_gammas", "num_neutrons", "num_protons", and
+    // "num_alphas"). All energies are in MeV. Each thread fills its own copy
+    // of the histograms. At the end of the run the copies are merged and
+    // written to the named JSON file, along with the flux-averaged total
+    // cross section. Every histogram stores the summed event weights and
+    // squared weights in each bin. The first and last entries of each axis
+    // are the underflow and overflow bins, and the x index varies fastest.
+    // To skip writing the events entirely, set the "output" key (see below)
+    // to an empty array. This key cannot be used with checkpoints.
+    //histograms: {
+    //  file: "marley_hists.json",
+    //  definitions: [
+    //    { name: "El", x: "ejectile_KE", bins: 100, min: 0., max: 50. },
+    //    { name: "Ng_Evis", x: "visible_energy", bins: 50, min: 0.,
+    //      max: 50., y: "num_gammas", y_bins: 10, y_min: 0., y_max: 10. },
+    //  ],
+    //},
+
+    // CHECKPOINTS (optional)
+    //
+    // If the "checkpoint" key is present, the state of the run (the number
+    // of completed events, the random number engine state of each thread,
+    // and the size of each output file) is saved periodically to the named
+    // file. A new checkpoint is written once the given number of "events"
+    // or "seconds" has elapsed since the previous one. At least one of
+    // these keys must be given. A final checkpoint is also written if the
+    // run is interrupted via ctrl+C.
+    //
+    // If the checkpoint file already exists when the marley executable is
+    // started, then the run continues from it. Each output file is first
+    // truncated to its size when the checkpoint was taken, so the
+    // finished files are identical to those of an uninterrupted run. The
+    // job configuration file and the number of threads must not be changed
+    // before restarting. The checkpoint file is deleted once the run is
+    // complete. Checkpoints may be used with the "ascii", "hepevt", "json",
+    // and "binary" output formats.
+    //checkpoint: { file: "marley.ckpt", events: 100000, seconds: 600 },
+
+    // SHARDED PRODUCTIONS
+    //
+    // A large production may be split among several independent jobs
+    // (shards) that share this job configuration file. Running
+    // "marley --shard I/N config.js" generates shard I (counting from zero)
+    // of N, which contains a contiguous range of the requested events. With
+    // "--shard auto", the shard index and count are taken from the
+    // environment variables MARLEY_SHARD_INDEX and MARLEY_SHARD_COUNT, from
+    // the rank and size of MPI_COMM_WORLD set by the MPI launcher (e.g.,
+    // "mpirun -n 8 marley --shard auto config.js"), or from the task ID and
+    // count of a Slurm job array. Each shard writes to its own output files,
+    // with ".shardI" inserted before the extension of each file name (e.g.,
+    // "events.shard3.ascii"). The same is done for the checkpoint,
+    // instrumentation, and memory report files. Unless the counter-based
+    // Philox engine is used, each shard is seeded differently.
+    //
+    // Once every shard is finished, "marley --merge N config.js" combines the
+    // events from the shards (in order) into the output files named in the
+    // configuration. The flux-averaged total cross section is taken from the
+    // first shard. The shards are read from the first output file that does
+    // not use the "hdf5" format. When the Philox engine is used, the merged
+    // files contain the same events as those of an unsharded run.
+
     // EVENT OUTPUT (optional)
     //
     // The "output" JSON array contains a list of JSON objects representing
@@ -331,19 +1002,21 @@
     //           supported.
     //
     //   - format: The format to use when storing the events in the file.
-    //             Valid values are "ascii", "hepevt", "json", and "root".
+    //             Valid values are "ascii", "hepevt", "json", "binary",
+    //             "hdf5", and "root".
     //             Details about the format options are given below.
     //
     //   - mode: The file I/O mode to use when writing to this file. For
     //           the "ascii" and "hepevt" formats, valid values are
     //           "overwrite" (erase any previously existing file contents)
     //           and "append" (continue output immediately after any
-    //           existing file contents). For the "json" and "root" formats,
-    //           valid values are "overwrite" and "resume". If the "resume"
-    //           mode is chosen, the generator will restore its previous state
-    //           from an incomplete run (e.g., a run that was interrupted
-    //           by the user via ctrl+C) that was saved to the output file
-    //           and continue from where it left off.
+    //           existing file contents). For the "json", "binary", "hdf5",
+    //           and "root" formats, valid values are "overwrite" and
+    //           "resume".
+    //           If the "resume" mode is chosen, the generator will restore
+    //           its previous state from an incomplete run (e.g., a run that
+    //           was interrupted by the user via ctrl+C) that was saved to
+    //           the output file and continue from where it left off.
     //
     //   - force: Boolean value used only for the "overwrite" mode. If
     //            it is true, the marley executable will not prompt the
@@ -357,6 +1030,121 @@
     //             behavior results in the most compact JSON-format output
     //             files.
     //
+    //   - index: Boolean value that, if true, causes an index file to be
+    //            written alongside the output file. Its name is formed by
+    //            appending ".idx" to the output file name. For each event,
+    //            the index records the location of the event in the output
+    //            file together with the random number seed, stream ID, and
+    //            event number used to generate it. This allows the
+    //            marley::EventFileReader::seek_event() function to jump
+    //            directly to any event. If the counter-based random number
+    //            engine was used, any indexed event may also be regenerated
+    //            by itself using marley::Generator::set_event_number().
+    //            For the "hdf5" format, the location of each event is its
+    //            row number in the /events datasets. Index files cannot be
+    //            written for compressed text output. If this key is
+    //            omitted, a value of false is assumed.
+    //
+    //   - compression: Compression algorithm used when writing the file.
+    //                  Valid values are "none" (the default) and "zstd".
+    //                  The latter is available only if MARLEY was built
+    //                  with the Zstandard library, and it may be used with
+    //                  the "ascii", "hepevt", and "json" formats. The
+    //                  compressed files may be decompressed using the
+    //                  standard zstd command-line tool, and they may be
+    //                  read directly by the marley::EventFileReader class.
+    //                  For the "root" format, the values "zlib", "lzma",
+    //                  "lz4", and "zstd" select the algorithm that ROOT
+    //                  uses to compress the event tree. If this key is
+    //                  omitted for a ROOT file, ROOT's default is used.
+    //                  For the "hdf5" format, the value "gzip" enables
+    //                  HDF5's built-in deflate filter for every dataset.
+    //
+    //   - compression_level: Integer Zstandard compression level. Higher
+    //                        values give smaller files at the cost of
+    //                        slower output. If this key is omitted, or if
+    //                        its value is zero, the library's default
+    //                        level is used. ROOT and HDF5 files accept
+    //                        levels from 1 to 9.
+    //
+    //   - rotate_events: Maximum number of events in each part of a
+    //                    rotating output file. If this key or the
+    //                    "rotate_bytes" key is given a positive value, then
+    //                    the events are split among a numbered sequence of
+    //                    files. The file name must then contain a single
+    //                    printf-style integer conversion (e.g.,
+    //                    "events_%04d.root"), which is replaced by the
+    //                    part number (counting from zero). A new part is
+    //                    started once either limit is reached. Each part is
+    //                    a complete output file that stores its own copy of
+    //                    the flux-averaged total cross section and (for the
+    //                    formats that support it) of the job configuration
+    //                    and the generator state after its last event.
+    //                    Completed parts are closed by background threads
+    //                    while the events are written to the next one. The
+    //                    file name pattern may be given to
+    //                    marley::EventFileReader or to marsum in place of a
+    //                    file name to read every part in order. Rotating
+    //                    output files may only use the "overwrite" mode, and
+    //                    they may not be used with an index, checkpoints,
+    //                    or the "resume" mode.
+    //
+    //   - rotate_bytes: Size in bytes at which a part of a rotating output
+    //                   file is considered full (see "rotate_events"). The
+    //                   size is checked periodically as the events are
+    //                   written, so the parts may somewhat exceed it.
+    //
+    // The following key is used only for the "binary" and "root" formats:
+    //
+    //   - layout: Either "event" (the default), which stores every
+    //             quantity in the marley::Event objects, or a reduced
+    //             layout. For the "root" format, the value "summary"
+    //             writes the "flat" mst tree produced by the marsum
+    //             utility. Files that use the summary layout may be
+    //             analyzed without the MARLEY class dictionaries. For the
+    //             "binary" format, the value "kinematics" stores only the
+    //             weight and time of each event together with the PDG code,
+    //             total energy, and 3-momentum of each final particle (see
+    //             marley::KinematicsBlock). This roughly halves the size of
+    //             the file and the time spent writing it. Files that use
+    //             either reduced layout cannot be read back using
+    //             marley::EventFileReader. Binary files that use the
+    //             kinematics layout also cannot be merged by marsum or
+    //             written with an index.
+    //
+    // The following key is used only for the "binary", "hdf5", and "root"
+    // formats:
+    //
+    //   - precision: Either "double" (the default) or "single". In single
+    //                precision, the kinetic energy and 3-momentum of each
+    //                particle are stored as 32-bit floats, which roughly
+    //                halves the size of the event records. For the "binary"
+    //                format, the masses are omitted unless they differ
+    //                from the values in MARLEY's mass table, and
+    //                marley::EventFileReader looks them up again when it
+    //                reconstructs the events. Single precision cannot be
+    //                combined with the "kinematics" layout. For the "hdf5"
+    //                format, the energy datasets hold kinetic energies
+    //                (e.g., KE instead of E) and the masses are also
+    //                stored as floats. For the "root" format, single
+    //                precision requires the "summary" layout, whose energy
+    //                and momentum branches are then stored as Double32_t.
+    //
+    // The following keys are used only for the "root" format:
+    //
+    //   - basket_size: Buffer size in bytes for each branch of the event
+    //                  tree (default 32000). Larger baskets reduce the
+    //                  I/O overhead at the cost of more memory.
+    //
+    //   - split_level: Split level of the marley::Event branch (default
+    //                  99). This key is ignored by the "summary" layout.
+    //
+    //   - auto_flush: Value passed to TTree::SetAutoFlush(). Positive values
+    //                 give the number of events between flushes, negative
+    //                 values give an approximate number of bytes, and zero
+    //                 disables automatic flushing. ROOT's default (-30000000)
+    //                 is used if this key is omitted.
+    //
     // The allowed output file formats are
     //
     //   - "ascii": The native format for MARLEY events. Files written in
@@ -375,9 +1163,36 @@
     //             interrupted the run via ctrl+C). The function
     //             marley::Event::to_json() controls the output format.
     //
-    //   - "root": Stores the generated marley::Event objects in a ROOT
-    //             TTree. This format is only available if MARLEY has been
-    //             built with ROOT support.
+    //   - "binary": A compact native format that stores the events in
+    //               blocks of fixed-width little-endian columns (see
+    //               marley::BinaryEventBlock). A header at the start of the
+    //               file holds the flux-averaged total cross section and
+    //               the number of events. The job configuration and the
+    //               state of the generator are saved at the end of the
+    //               file when execution terminates, as for the "json"
+    //               format. Files in this format may be read using the
+    //               marley::EventFileReader class.
+    //
+    //   - "hdf5": Stores the events in an HDF5 file as one-dimensional
+    //             datasets that may be loaded directly as NumPy arrays
+    //             (e.g., using h5py). The /events group holds one entry
+    //             per event for the scalar quantities (Ex, twoJ, parity,
+    //             and the projectile and ejectile 4-momenta) together with
+    //             the initial_offsets and final_offsets datasets. The
+    //             /initial_particles and /final_particles groups store the
+    //             particles of all events one after another. The particles
+    //             of event i have indices from offsets[i] up to (but not
+    //             including) offsets[i + 1], as for jagged arrays in Apache
+    //             Arrow and Awkward Array. The flux-averaged total cross
+    //             section (MeV^(-2)) is stored as an attribute of the root
+    //             group, and the generator state is saved to the /metadata
+    //             dataset when execution terminates. This format is only
+    //             available if MARLEY has been built with HDF5 support.
+    //
+    //   - "root": Stores the generated events in a ROOT TTree, either as
+    //             marley::Event objects or in the flat summary layout (see
+    //             the "layout" key above). This format is only available
+    //             if MARLEY has been built with ROOT support.
     //
     // If this key is omitted, then the following configuration
     // is assumed:
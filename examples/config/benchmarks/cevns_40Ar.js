@@ -0,0 +1,33 @@
+// Throughput benchmark: coherent elastic neutrino-nucleus scattering on 40Ar
+// for muon neutrinos from a decay-at-rest source, binary output
+// Run using the marthroughput example program (see
+// examples/executables/marthroughput.cc)
+{
+  seed: 123456,
+
+  target: {
+    nuclides: [ 1000180400 ], // 40Ar
+    atom_fractions: [ 1.0 ],
+  },
+
+  reactions: [ "CEvNS40Ar.react" ],
+
+  // Use the dedicated elastic scattering engine for CEvNS
+  cevns_engine: "coherent",
+
+  // Keep the logger quiet so that it does not affect the timings
+  log: [ { file: "stdout", level: "warning" } ],
+
+  source: {
+    type: "dar",
+    neutrino: "vu",
+  },
+
+  direction: { x: 0.0, y: 0.0, z: 1.0 },
+
+  // Settings used by marthroughput
+  benchmark: {
+    events: 200000,  // Number of events to generate
+    format: "binary", // Output format ("ascii", "hepevt", "json", or "binary")
+  },
+}
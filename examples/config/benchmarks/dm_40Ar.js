@@ -0,0 +1,33 @@
+// Throughput benchmark: dark matter absorption on 40Ar, ASCII output
+// Run using the marthroughput example program (see
+// examples/executables/marthroughput.cc)
+{
+  seed: 123456,
+
+  target: {
+    nuclides: [ 1000180400 ], // 40Ar
+    atom_fractions: [ 1.0 ],
+  },
+
+  reactions: [ "dmAr.react" ],
+
+  // Keep the logger quiet so that it does not affect the timings
+  log: [ { file: "stdout", level: "warning" } ],
+
+  source: {
+    type: "monoDM",
+    neutrino: "dm",
+    energy: 10000.0, // MeV
+    mass: 10.0,     // Dark matter particle mass (MeV)
+    velocity: 0.001,
+    LAMBDA: 1000000.0, // UV cutoff (MeV)
+  },
+
+  direction: { x: 0.0, y: 0.0, z: 1.0 },
+
+  // Settings used by marthroughput
+  benchmark: {
+    events: 50000,  // Number of events to generate
+    format: "ascii", // Output format ("ascii", "hepevt", "json", or "binary")
+  },
+}
@@ -0,0 +1,34 @@
+// Throughput benchmark: neutrino-electron elastic scattering in argon using
+// a supernova-like Fermi-Dirac spectrum, ASCII output
+// Run using the marthroughput example program (see
+// examples/executables/marthroughput.cc)
+{
+  seed: 123456,
+
+  target: {
+    nuclides: [ 1000180400 ], // 40Ar
+    atom_fractions: [ 1.0 ],
+  },
+
+  reactions: [ "ES.react" ],
+
+  // Keep the logger quiet so that it does not affect the timings
+  log: [ { file: "stdout", level: "warning" } ],
+
+  source: {
+    type: "fermi-dirac",
+    neutrino: "ve",
+    Emin: 0.0,         // Minimum neutrino energy (MeV)
+    Emax: 60.0,        // Maximum neutrino energy (MeV)
+    temperature: 3.5,  // Temperature (MeV)
+    eta: 0.0,          // Pinching parameter (dimensionless)
+  },
+
+  direction: { x: 0.0, y: 0.0, z: 1.0 },
+
+  // Settings used by marthroughput
+  benchmark: {
+    events: 100000,  // Number of events to generate
+    format: "ascii", // Output format ("ascii", "hepevt", "json", or "binary")
+  },
+}
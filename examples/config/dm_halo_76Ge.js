@@ -0,0 +1,47 @@
+// Example job configuration for dark matter absorption with particle speeds
+// drawn from the standard halo model
+{
+  seed: 123456, // Random number seed (omit to use time since Unix epoch)
+
+  // Pure 76Ge target
+  target: {
+    nuclides: [ 1000320760 ], //76Ge
+    atom_fractions: [ 1.0 ],
+  },
+
+  // Simulate CC dm scattering on 76Ge
+  reactions: [ "dm.react" ],
+  log: [ { file: "stdout", level: "info" } ],
+
+  // Dark matter source specification
+    source: {
+      type: "haloDM",
+      neutrino: "dm",
+      mass: 2.0, // dark matter particle mass (MeV)
+      LAMBDA: 1000000.0, // UV cutoff parameter
+
+      // Truncated Maxwell-Boltzmann speed distribution in the detector frame.
+      // The values shown are the defaults.
+      v0: 220.,      // most probable speed in the galactic frame (km/s)
+      v_esc: 544.,   // galactic escape speed (km/s)
+      v_earth: 232., // detector speed relative to the galactic frame (km/s)
+
+      // The dark matter cross sections are evaluated once at the median
+      // speed of each of this many equal-probability speed bins
+      velocity_bins: 64,
+    },
+
+  // Incident neutrino direction 3-vector
+  direction: { x: 0.0, y: 0.0, z: 1.0 },
+
+  // Settings for marley command-line executable
+  executable_settings: {
+
+    // The number of events to generate
+    events: 100,
+
+    // Event output configuration
+     output: [ { file: "events.ascii", format: "ascii", mode: "overwrite" } ],
+
+  },
+}
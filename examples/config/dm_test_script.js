@@ -21,7 +21,7 @@
       neutrino: "dm",
       energy: 10000.0,        // Neutrino energy (MeV)
       mass: 4.0, // dark matter particle mass (MeV)
-      velocity: 0.001, // dark matter particle velocity (m/s (i think) )
+      velocity: 0.001, // dark matter particle speed (in units of c)
       LAMBDA: 10000000.0, // UV cutoff parameter ( I need to think more carefully about this param )
     },
 
@@ -0,0 +1,61 @@
+// Validation of the faster de-excitation settings for dark matter absorption
+// on 40Ar with enough energy to populate the unbound continuum
+// Run using the marvalidate example program (see
+// examples/executables/marvalidate.cc)
+{
+  seed: 123456,
+
+  target: {
+    nuclides: [ 1000180400 ], // 40Ar
+    atom_fractions: [ 1.0 ],
+  },
+
+  reactions: [ "dmAr.react" ],
+
+  log: [ { file: "stdout", level: "warning" } ],
+
+  source: {
+    type: "monoDM",
+    neutrino: "dm",
+    energy: 10000.0, // MeV
+    mass: 30.0,     // Dark matter particle mass (MeV)
+    velocity: 0.001,
+    LAMBDA: 1000000.0, // UV cutoff (MeV)
+  },
+
+  direction: { x: 0.0, y: 0.0, z: 1.0 },
+
+  // Settings used by marvalidate
+  validation: {
+    events: 20000,
+    reference_events: 200000,
+    reference_file: "dm_40Ar_continuum_reference.json",
+    threads: 0, // Use all available hardware threads
+    min_p_value: 0.001,
+    xsec_tolerance: 0.001,
+
+    // The reference uses the most accurate settings
+    reference: { precision: "validation" },
+
+    modes: [
+      { name: "production", overrides: { precision: "production" } },
+      { name: "hf_cache_off", overrides: { hf_decay_cache_size: 0 } },
+      { name: "model_tables", overrides: { transmission_mode: "table",
+        level_density_mode: "table", gamma_strength_mode: "table" } },
+      { name: "xs_table", overrides: { xs_mode: "table" } },
+      { name: "fast", overrides: { precision: "fast" } },
+    ],
+
+    histograms: [
+      { name: "Ex", x: "Ex", bins: 60, min: 0.0, max: 30.0 },
+      { name: "visible_energy", x: "visible_energy", bins: 60, min: 0.0,
+        max: 30.0 },
+      { name: "num_gammas", x: "num_gammas", bins: 15, min: -0.5,
+        max: 14.5 },
+      { name: "num_neutrons", x: "num_neutrons", bins: 5, min: -0.5,
+        max: 4.5 },
+      { name: "num_protons", x: "num_protons", bins: 5, min: -0.5,
+        max: 4.5 },
+    ],
+  },
+}
@@ -0,0 +1,56 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <exception>
+#include <iostream>
+#include <string>
+
+// MARLEY includes
+#include "marley/StructureDatabase.hh"
+
+// Converts discrete level data files in MARLEY's native format (e.g., those
+// in data/structure) into the compiled binary format. Each compiled file is
+// written next to its original, and it will be used automatically by
+// marley::StructureDatabase when it is up to date.
+int main(int argc, char* argv[]) {
+
+  // If the user has not supplied any command-line arguments, display the
+  // standard help message and exit
+  if (argc <= 1) {
+    std::cout << "Usage: " << argv[0] << " DATA_FILE...\n";
+    return 0;
+  }
+
+  int status = 0;
+  for ( int s = 1; s < argc; ++s ) {
+    std::string file_name( argv[s] );
+    std::string compiled_file_name = file_name
+      + marley::StructureDatabase::COMPILED_DECAY_SCHEME_SUFFIX;
+    try {
+      int num_schemes = marley::StructureDatabase::compile_decay_schemes(
+        file_name, compiled_file_name );
+      std::cout << "Compiled " << num_schemes << " decay schemes from "
+        << file_name << " into " << compiled_file_name << '\n';
+    }
+    catch ( const std::exception& error ) {
+      std::cerr << error.what() << '\n';
+      status = 1;
+    }
+  }
+
+  return status;
+}
@@ -0,0 +1,262 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/HauserFeshbachDecay.hh"
+#include "marley/JSON.hh"
+#include "marley/Logger.hh"
+#include "marley/MassTable.hh"
+#include "marley/Particle.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/marley_utils.hh"
+
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
+// Builds a model table cache file (see the "model_table_cache" key in
+// examples/config/annotated.js) for a job configuration file ahead of time.
+// Production jobs that load the file then skip the slow first evaluations of
+// the tabulated nuclear models.
+//
+// The tables are filled in two steps. First, the optical model and level
+// density tables for every nuclide that can be reached from the residues of
+// the configured reactions are computed up to the largest excitation energy
+// available to each (see StructureDatabase::precompute_model_tables()).
+// Then the Hauser-Feshbach decay widths of each nuclide are evaluated on a
+// grid of excitation energies above its unbound threshold, for every spin up
+// to max_spin and both parities. This fills any remaining table entries that
+// are used by the exit channels (e.g., the gamma-ray strength functions).
+// Both steps are shared among several threads, and the second one is split
+// across nuclides and excitation energies.
+//
+// The job configuration file must enable at least one kind of table (via the
+// "transmission_mode", "level_density_mode", "gamma_strength_mode", or
+// "precision" keys), and production jobs must use the same settings. All
+// tool settings are optional and are read from a "decay_tables" object:
+//
+//   decay_tables: {
+//     Ex_step: 0.5,  // Spacing (MeV) of the excitation energy grid
+//     max_spin: 8,   // Largest compound nucleus spin (hbar) to evaluate
+//     threads: 0,    // 0 = use all available hardware threads
+//   }
+//
+// Setting Ex_step to zero skips the second step.
+
+namespace {
+
+  // Default settings for the excitation energy grid
+  constexpr double DEFAULT_EX_STEP = 0.5; // MeV
+  constexpr int DEFAULT_MAX_SPIN = 8;
+
+  // Helper functions for loading optional settings from the job
+  // configuration file
+  void get_double_param( const marley::JSON& json,
+    const std::string& param_key, double& value )
+  {
+    if ( !json.has_key(param_key) ) return;
+
+    const auto& temp_js = json.at( param_key );
+    bool ok = false;
+    value = temp_js.to_double( ok );
+    if ( !ok ) throw marley::Error("Unrecognized " + param_key
+      + " value " + temp_js.to_string() + " encountered in the"
+      " job configuration file.");
+  }
+
+  void get_int_param( const marley::JSON& json,
+    const std::string& param_key, int& value )
+  {
+    if ( !json.has_key(param_key) ) return;
+
+    const auto& temp_js = json.at( param_key );
+    bool ok = false;
+    value = temp_js.to_long( ok );
+    if ( !ok ) throw marley::Error("Unrecognized " + param_key
+      + " value " + temp_js.to_string() + " encountered in the"
+      " job configuration file.");
+  }
+
+}
+
+int main(int argc, char* argv[]) {
+
+  // If the user has not supplied enough command-line arguments, display the
+  // standard help message and exit
+  if (argc <= 2) {
+    std::cout << "Usage: " << argv[0] << " OUTPUT_FILE CONFIG_FILE\n";
+    return 1;
+  }
+
+  // Get the output and config file names from the command line
+  std::string output_file_name( argv[1] );
+  std::string config_file_name( argv[2] );
+
+  // Check whether the output file exists and warn the user before
+  // overwriting it if it does
+  std::ifstream temp_stream( output_file_name );
+  if ( temp_stream ) {
+    bool overwrite = marley_utils::prompt_yes_no(
+      "Really overwrite " + output_file_name + '?');
+    if ( !overwrite ) {
+      std::cout << "Decay table generation aborted.\n";
+      return 0;
+    }
+  }
+
+  // Configure a new Generator object
+  #ifdef USE_ROOT
+    marley::RootJSONConfig config( config_file_name );
+  #else
+    marley::JSONConfig config( config_file_name );
+  #endif
+  marley::Generator gen = config.create_generator();
+  marley::StructureDatabase& sdb = gen.get_structure_db();
+
+  // Load the tool settings, using the defaults for any that are missing
+  double Ex_step = DEFAULT_EX_STEP;
+  int max_spin = DEFAULT_MAX_SPIN;
+  int num_threads = 0;
+
+  const marley::JSON& json = config.get_json();
+  if ( json.has_key("decay_tables") ) {
+    const marley::JSON& settings = json.at( "decay_tables" );
+    get_double_param( settings, "Ex_step", Ex_step );
+    get_int_param( settings, "max_spin", max_spin );
+    get_int_param( settings, "threads", num_threads );
+  }
+
+  if ( Ex_step < 0. ) throw marley::Error( "Negative Ex_step value "
+    + std::to_string(Ex_step) + " encountered in the job configuration"
+    " file." );
+  if ( max_spin < 0 ) throw marley::Error( "Negative max_spin value "
+    + std::to_string(max_spin) + " encountered in the job configuration"
+    " file." );
+
+  using TMode = marley::OpticalModel::TransmissionMode;
+  if ( sdb.get_transmission_mode() != TMode::Table
+    && !sdb.get_tabulate_level_densities()
+    && !sdb.get_tabulate_gamma_strength_functions() )
+  {
+    throw marley::Error( "The job configuration file " + config_file_name
+      + " does not enable tables for any of the nuclear models, so there"
+      " are no decay tables to build." );
+  }
+
+  if ( num_threads <= 0 ) {
+    num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+
+  // Step 1: Fill the optical model and level density tables
+  std::map<int, double> max_Ex = gen.max_residue_excitation_energies();
+  if ( max_Ex.empty() ) throw marley::Error( "None of the configured"
+    " reactions leaves a nuclear residue in an excited state." );
+  sdb.precompute_model_tables( max_Ex, num_threads );
+
+  // Step 2: Evaluate the Hauser-Feshbach decay widths on the grid. The
+  // widths themselves depend on the exact excitation energy, so they are
+  // not kept. Every job is a single excitation energy for a nuclide.
+  std::vector< std::tuple<int, double> > jobs;
+  if ( Ex_step > 0. ) {
+    const auto& mt = marley::MassTable::Instance();
+    auto nuclides = marley::StructureDatabase::find_accessible_nuclides(
+      max_Ex );
+    for ( const auto& pair : nuclides ) {
+      double Ex_min = mt.unbound_threshold( pair.first );
+      double Ex_max = pair.second;
+      if ( Ex_max <= Ex_min ) continue;
+
+      // The last grid point is always the largest excitation energy
+      int num_steps = static_cast<int>( std::ceil((Ex_max - Ex_min)
+        / Ex_step) );
+      for ( int s = 1; s <= num_steps; ++s ) {
+        jobs.emplace_back( pair.first, std::min(Ex_max, Ex_min + s*Ex_step) );
+      }
+    }
+  }
+
+  num_threads = std::min( num_threads, std::max( 1,
+    static_cast<int>(jobs.size()) ) );
+
+  MARLEY_LOG_INFO() << "Evaluating Hauser-Feshbach decays at " << jobs.size()
+    << " excitation energies using " << num_threads << " thread(s)";
+
+  // Each thread acts as its own worker, with its own copies of the models
+  // (seeded with the tables from step 1). Their tables are merged when the
+  // file is written.
+  sdb.set_concurrent( true );
+  sdb.set_lazy_continuum_widths( false );
+
+  std::atomic<size_t> next_job( 0u );
+  std::vector<std::exception_ptr> errors( num_threads );
+
+  auto worker = [&]( int t ) {
+    try {
+      const auto& mt = marley::MassTable::Instance();
+      for ( size_t j = next_job++; j < jobs.size(); j = next_job++ ) {
+        int pdg = std::get<0>( jobs[j] );
+        double Ex = std::get<1>( jobs[j] );
+
+        // Use a neutral atom at rest as the compound nucleus
+        marley::Particle nucleus( pdg, mt.get_atomic_mass(pdg), 0 );
+
+        // Nuclei with odd mass numbers have half-integer spins
+        int two_J_min = marley_utils::get_particle_A( pdg ) % 2;
+        for ( int twoJ = two_J_min; twoJ <= 2*max_spin; twoJ += 2 ) {
+          for ( bool positive : { true, false } ) {
+            marley::Parity Pi( positive );
+            marley::HauserFeshbachDecay hfd( nucleus, Ex, twoJ, Pi, sdb );
+          }
+        }
+      }
+    }
+    catch ( ... ) {
+      errors[ t ] = std::current_exception();
+      next_job = jobs.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for ( int t = 1; t < num_threads; ++t ) threads.emplace_back( worker, t );
+  worker( 0 );
+  for ( auto& th : threads ) th.join();
+  for ( const auto& e : errors ) if ( e ) std::rethrow_exception( e );
+
+  sdb.save_model_tables( output_file_name );
+
+  std::cout << "Wrote decay tables for " << max_Ex.size() << " residue"
+    << ( max_Ex.size() == 1 ? "" : "s" ) << " to " << output_file_name
+    << '\n';
+
+  return 0;
+}
@@ -0,0 +1,379 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/Logger.hh"
+#include "marley/marley_utils.hh"
+
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
+// Scans the dark matter absorption cross section over a two-dimensional grid
+// of dark matter masses and UV cutoffs. The cross section scales exactly as
+// LAMBDA^(-4), so the (expensive) sum over nuclear levels is evaluated only
+// once per mass with LAMBDA = 1 and then rescaled for every cutoff value.
+//
+// All scan settings are optional and are read from a "dm_scan" object in the
+// job configuration file:
+//
+//   dm_scan: {
+//     mass_min: 1.5, mass_max: 15., mass_steps: 50,  // MeV
+//     mass_spacing: "linear",                         // or "log"
+//     cutoff_min: 1e5, cutoff_max: 1e8, cutoff_steps: 50, // MeV
+//     cutoff_spacing: "linear",                       // or "log"
+//     threads: 0,             // 0 = use all available hardware threads
+//     format: "csv",          // or "binary"
+//     background: 9430.,      // Expected background counts
+//     exposure: 1e6,          // Detector mass (kg)
+//     target_mass: 37214.65445386492, // Mass of one target atom (MeV)
+//     targets_per_atom: 21.,  // Scattering centers per target atom
+//     dm_density: 200.,       // Local dark matter density (MeV / cm^3)
+//     flux_speed: 3e10,       // Speed used to compute the flux (cm / s)
+//     live_time: 3.154e7,     // Exposure time (s)
+//   }
+//
+// Each output row contains the dark matter mass (MeV), the UV cutoff (MeV),
+// the total cross section (cm^2), the reference cross section
+// (hbar*c)^2 * m^2 / (4 * pi * LAMBDA^4) (cm^2), the expected number of
+// signal events, and the significance (signal / sqrt(background)). Rows are
+// ordered by mass and then by cutoff. The binary format starts with three
+// unsigned 64-bit integers (the number of masses, the number of cutoffs, and
+// the number of columns) followed by the rows as native-endian doubles.
+
+namespace {
+
+  // Default settings for the scan grid
+  constexpr double DEFAULT_MASS_MIN = 1.5;
+  constexpr double DEFAULT_MASS_MAX = 15.;
+  constexpr double DEFAULT_CUTOFF_MIN = 100000.;
+  constexpr double DEFAULT_CUTOFF_MAX = 100000000.;
+  constexpr int DEFAULT_NUM_STEPS = 50;
+
+  // Default projectile PDG code and kinetic energy (MeV). The dark matter
+  // cross section does not depend on the kinetic energy.
+  constexpr int DEFAULT_PDG = marley_utils::DM;
+  constexpr double DEFAULT_KE = 1.;
+
+  // Default settings used to convert cross sections to event rates. These
+  // correspond to one kiloton-year of 40Ar.
+  constexpr double DEFAULT_BACKGROUND = 9430.;
+  constexpr double DEFAULT_EXPOSURE = 1e6;
+  constexpr double DEFAULT_TARGET_MASS = 37214.65445386492;
+  constexpr double DEFAULT_TARGETS_PER_ATOM = 21.;
+  constexpr double DEFAULT_DM_DENSITY = 200.;
+  constexpr double DEFAULT_FLUX_SPEED = 3e10;
+  constexpr double DEFAULT_LIVE_TIME = 3.154e7;
+
+  // Conversion factors
+  constexpr double KG_PER_MEV = 1.78266192e-30;
+  constexpr double HBAR_C_CM = marley_utils::hbar_c * 1e-13; // MeV*cm
+
+  // Number of values written for each grid point
+  constexpr size_t NUM_COLUMNS = 6u;
+
+  // Helper functions for loading optional scan parameters from the job
+  // configuration file
+  void get_double_scan_param( const marley::JSON& json,
+    const std::string& param_key, double& value )
+  {
+    if ( !json.has_key(param_key) ) return;
+
+    const auto& temp_js = json.at( param_key );
+    bool ok = false;
+    value = temp_js.to_double( ok );
+    if ( !ok ) throw marley::Error("Unrecognized " + param_key
+      + " value " + temp_js.to_string() + " encountered in the"
+      " job configuration file.");
+  }
+
+  void get_int_scan_param( const marley::JSON& json,
+    const std::string& param_key, int& value )
+  {
+    if ( !json.has_key(param_key) ) return;
+
+    const auto& temp_js = json.at( param_key );
+    bool ok = false;
+    value = temp_js.to_long( ok );
+    if ( !ok ) throw marley::Error("Unrecognized " + param_key
+      + " value " + temp_js.to_string() + " encountered in the"
+      " job configuration file.");
+  }
+
+  void get_string_scan_param( const marley::JSON& json,
+    const std::string& param_key, std::string& value )
+  {
+    if ( !json.has_key(param_key) ) return;
+
+    const auto& temp_js = json.at( param_key );
+    bool ok = false;
+    value = temp_js.to_string( ok );
+    if ( !ok ) throw marley::Error("Unrecognized " + param_key
+      + " value " + temp_js.to_string() + " encountered in the"
+      " job configuration file.");
+  }
+
+  // Builds a grid of num_points values between x_min and x_max (inclusive)
+  // using either "linear" or "log" spacing
+  std::vector<double> make_grid( double x_min, double x_max, int num_points,
+    const std::string& spacing, const std::string& name )
+  {
+    if ( num_points < 1 ) throw marley::Error( "The number of " + name
+      + " steps must be positive" );
+
+    bool log_spacing = false;
+    if ( spacing == "log" ) log_spacing = true;
+    else if ( spacing != "linear" ) throw marley::Error( "Unrecognized "
+      + name + "_spacing value \"" + spacing + "\" encountered in the job"
+      " configuration file." );
+
+    if ( log_spacing && ( x_min <= 0. || x_max <= 0. ) ) throw marley::Error(
+      "Logarithmic " + name + " spacing requires positive grid limits" );
+
+    std::vector<double> grid( num_points, x_min );
+    if ( num_points == 1 ) return grid;
+
+    for ( int i = 0; i < num_points; ++i ) {
+      double t = static_cast<double>( i ) / ( num_points - 1 );
+      if ( log_spacing ) grid[ i ] = x_min * std::pow( x_max / x_min, t );
+      else grid[ i ] = x_min + t*( x_max - x_min );
+    }
+    return grid;
+  }
+
+}
+
+int main(int argc, char* argv[]) {
+
+  // If the user has not supplied enough command-line arguments, display the
+  // standard help message and exit
+  if (argc <= 2) {
+    std::cout << "Usage: " << argv[0] << " OUTPUT_FILE CONFIG_FILE\n";
+    return 1;
+  }
+
+  // Get the output and config file names from the command line
+  std::string output_file_name( argv[1] );
+  std::string config_file_name( argv[2] );
+
+  // Check whether the output file exists and warn the user before
+  // overwriting it if it does
+  std::ifstream temp_stream( output_file_name );
+  if ( temp_stream ) {
+    bool overwrite = marley_utils::prompt_yes_no(
+      "Really overwrite " + output_file_name + '?');
+    if ( !overwrite ) {
+      std::cout << "Dark matter parameter scan aborted.\n";
+      return 0;
+    }
+  }
+
+  // Configure a new Generator object
+  #ifdef USE_ROOT
+    marley::RootJSONConfig config( config_file_name );
+  #else
+    marley::JSONConfig config( config_file_name );
+  #endif
+  const marley::Generator gen = config.create_generator();
+
+  // Load the scan settings, using the defaults for any that are missing
+  double mass_min = DEFAULT_MASS_MIN;
+  double mass_max = DEFAULT_MASS_MAX;
+  double cutoff_min = DEFAULT_CUTOFF_MIN;
+  double cutoff_max = DEFAULT_CUTOFF_MAX;
+  int mass_steps = DEFAULT_NUM_STEPS;
+  int cutoff_steps = DEFAULT_NUM_STEPS;
+  std::string mass_spacing( "linear" );
+  std::string cutoff_spacing( "linear" );
+  int num_threads = 0;
+  std::string format( "csv" );
+
+  double background = DEFAULT_BACKGROUND;
+  double exposure = DEFAULT_EXPOSURE;
+  double target_mass = DEFAULT_TARGET_MASS;
+  double targets_per_atom = DEFAULT_TARGETS_PER_ATOM;
+  double dm_density = DEFAULT_DM_DENSITY;
+  double flux_speed = DEFAULT_FLUX_SPEED;
+  double live_time = DEFAULT_LIVE_TIME;
+
+  const marley::JSON& json = config.get_json();
+  if ( json.has_key("dm_scan") ) {
+    const marley::JSON& scan = json.at( "dm_scan" );
+
+    get_double_scan_param( scan, "mass_min", mass_min );
+    get_double_scan_param( scan, "mass_max", mass_max );
+    get_int_scan_param( scan, "mass_steps", mass_steps );
+    get_string_scan_param( scan, "mass_spacing", mass_spacing );
+
+    get_double_scan_param( scan, "cutoff_min", cutoff_min );
+    get_double_scan_param( scan, "cutoff_max", cutoff_max );
+    get_int_scan_param( scan, "cutoff_steps", cutoff_steps );
+    get_string_scan_param( scan, "cutoff_spacing", cutoff_spacing );
+
+    get_int_scan_param( scan, "threads", num_threads );
+    get_string_scan_param( scan, "format", format );
+
+    get_double_scan_param( scan, "background", background );
+    get_double_scan_param( scan, "exposure", exposure );
+    get_double_scan_param( scan, "target_mass", target_mass );
+    get_double_scan_param( scan, "targets_per_atom", targets_per_atom );
+    get_double_scan_param( scan, "dm_density", dm_density );
+    get_double_scan_param( scan, "flux_speed", flux_speed );
+    get_double_scan_param( scan, "live_time", live_time );
+  }
+
+  bool binary = false;
+  if ( format == "binary" ) binary = true;
+  else if ( format != "csv" ) throw marley::Error( "Unrecognized format"
+    " value \"" + format + "\" encountered in the job configuration file." );
+
+  std::vector<double> masses = make_grid( mass_min, mass_max, mass_steps,
+    mass_spacing, "mass" );
+  std::vector<double> cutoffs = make_grid( cutoff_min, cutoff_max,
+    cutoff_steps, cutoff_spacing, "cutoff" );
+
+  if ( num_threads <= 0 ) {
+    num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+  num_threads = std::min( num_threads, mass_steps );
+
+  MARLEY_LOG_INFO() << "Scanning " << masses.size() << " dark matter masses"
+    << " and " << cutoffs.size() << " UV cutoffs using " << num_threads
+    << " thread(s)";
+
+  // Compute the cross section (MeV^(-2)) for LAMBDA = 1 at each mass. The
+  // Generator is only used through const member functions here, so the
+  // worker threads can share it.
+  std::vector<double> unit_xsecs( masses.size(), 0. );
+  std::atomic<size_t> next_mass( 0u );
+  std::vector<std::exception_ptr> errors( num_threads );
+
+  auto worker = [&]( int t ) {
+    try {
+      for ( size_t i = next_mass++; i < masses.size(); i = next_mass++ ) {
+        unit_xsecs[ i ] = gen.total_xs( DEFAULT_PDG, DEFAULT_KE,
+          masses[ i ], 1. );
+      }
+    }
+    catch ( ... ) {
+      errors[ t ] = std::current_exception();
+      next_mass = masses.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for ( int t = 1; t < num_threads; ++t ) threads.emplace_back( worker, t );
+  worker( 0 );
+  for ( auto& th : threads ) th.join();
+  for ( const auto& e : errors ) if ( e ) std::rethrow_exception( e );
+
+  // Precompute everything that depends only on the cutoff
+  std::vector<double> inv_cutoff4( cutoffs.size() );
+  for ( size_t j = 0u; j < cutoffs.size(); ++j ) {
+    inv_cutoff4[ j ] = 1. / std::pow( cutoffs[ j ], 4 );
+  }
+
+  // Number of scattering centers in the detector
+  double num_targets = targets_per_atom * exposure
+    / ( KG_PER_MEV * target_mass );
+
+  double hbar_c2 = HBAR_C_CM * HBAR_C_CM; // MeV^2 * cm^2
+  double inv_sqrt_bkg = 1. / std::sqrt( background );
+
+  std::ofstream out_file;
+  if ( binary ) {
+    out_file.open( output_file_name, std::ios::binary );
+    uint64_t header[ 3 ] = { masses.size(), cutoffs.size(), NUM_COLUMNS };
+    out_file.write( reinterpret_cast<const char*>(header), sizeof(header) );
+  }
+  else {
+    out_file.open( output_file_name );
+    out_file << "mass,cutoff,xsec,y,events,significance\n";
+    out_file << std::setprecision( std::numeric_limits<double>::digits10 );
+  }
+
+  // Storage for one mass value's worth of rows, reused for every mass
+  std::vector<double> xsecs( cutoffs.size() );
+  std::vector<double> ys( cutoffs.size() );
+  std::vector<double> events( cutoffs.size() );
+  std::vector<double> sigs( cutoffs.size() );
+  std::vector<double> block( cutoffs.size() * NUM_COLUMNS );
+
+  for ( size_t i = 0u; i < masses.size(); ++i ) {
+
+    double m = masses[ i ];
+    double xs_scale = unit_xsecs[ i ] * hbar_c2;
+    double y_scale = hbar_c2 * m * m / ( 4. * marley_utils::pi );
+    double events_per_cm2 = flux_speed * ( dm_density / m ) * num_targets
+      * live_time;
+
+    // Simple elementwise loops over contiguous arrays, which the compiler
+    // can vectorize
+    for ( size_t j = 0u; j < cutoffs.size(); ++j ) {
+      xsecs[ j ] = xs_scale * inv_cutoff4[ j ];
+      ys[ j ] = y_scale * inv_cutoff4[ j ];
+      events[ j ] = xsecs[ j ] * events_per_cm2;
+      sigs[ j ] = events[ j ] * inv_sqrt_bkg;
+    }
+
+    if ( binary ) {
+      for ( size_t j = 0u; j < cutoffs.size(); ++j ) {
+        double* row = &block[ j * NUM_COLUMNS ];
+        row[ 0 ] = m;
+        row[ 1 ] = cutoffs[ j ];
+        row[ 2 ] = xsecs[ j ];
+        row[ 3 ] = ys[ j ];
+        row[ 4 ] = events[ j ];
+        row[ 5 ] = sigs[ j ];
+      }
+      out_file.write( reinterpret_cast<const char*>(block.data()),
+        block.size() * sizeof(double) );
+    }
+    else {
+      for ( size_t j = 0u; j < cutoffs.size(); ++j ) {
+        out_file << m << ',' << cutoffs[ j ] << ',' << xsecs[ j ] << ','
+          << ys[ j ] << ',' << events[ j ] << ',' << sigs[ j ] << '\n';
+      }
+    }
+
+    MARLEY_LOG_DEBUG() << "dm mass = " << m << " MeV, dm total xsec at"
+      << " UV cutoff = 1 MeV is " << unit_xsecs[ i ] << " MeV^(-2)";
+  }
+
+  if ( !out_file ) throw marley::Error( "Failed to write the dark matter"
+    " parameter scan to " + output_file_name );
+
+  return 0;
+}
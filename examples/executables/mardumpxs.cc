@@ -15,11 +15,18 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 // Standard library includes
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 // MARLEY includes
+#include "marley/CrossSectionTable.hh"
 #include "marley/DecayScheme.hh"
 #include "marley/Generator.hh"
 #include "marley/JSON.hh"
@@ -34,6 +41,25 @@
   #include "marley/JSONConfig.hh"
 #endif
 
+// Dumps total cross sections on a uniform grid of projectile kinetic
+// energies. By default, the abundance-weighted total over all configured
+// reactions is written as text (one "KE xsec" line per energy, in MeV and
+// 10^(-42) cm^2 / atom) for the projectile given by "xsec_dump_pdg".
+//
+// If "xsec_dump_format" is set to "binary", then a compact table is written
+// instead for every configured reaction (each at its own projectile). These
+// cross sections are per target atom, without the abundance weighting, and
+// are stored in MARLEY natural units (MeV^(-2)). The grid for each nuclear
+// reaction also includes the energies at which its levels open up. If
+// "xsec_dump_levels" is true, then the partial cross sections to each
+// nuclear level are stored as well, and the file may then be loaded as the
+// cross section table of a job via the "xs_table_file" key (see
+// examples/config/annotated.js). See marley::CrossSectionTable for the
+// format.
+//
+// The cross sections are evaluated in parallel using "xsec_dump_threads"
+// threads (default 0 = all available hardware threads).
+
 namespace {
   // Default settings for the projectile kinetic energy range and number of
   // steps for the total cross section dump
@@ -44,6 +70,96 @@ namespace {
   // Default projectile PDG code
   constexpr int DEFAULT_PDG = marley_utils::ELECTRON_NEUTRINO;
 
+  // Default settings for the sampling estimate of the flux-averaged total
+  // cross section (see the "xsec_dump_flux_average" key below)
+  constexpr int DEFAULT_FLUX_AVG_POINTS = 256;
+  constexpr int DEFAULT_FLUX_AVG_REPLICATES = 16;
+
+  // Number of energies evaluated by each parallel job
+  constexpr size_t CHUNK_SIZE = 64u;
+
+  // Calls job( j ) for j = 0, 1, ..., num_jobs - 1, sharing the calls among
+  // num_threads threads. The first exception thrown by a job (if any) is
+  // rethrown once all of the threads have finished.
+  void run_parallel( size_t num_jobs, int num_threads,
+    const std::function<void(size_t)>& job )
+  {
+    num_threads = std::min( num_threads, std::max( 1,
+      static_cast<int>(num_jobs) ) );
+
+    std::atomic<size_t> next_job( 0u );
+    std::vector<std::exception_ptr> errors( num_threads );
+
+    auto worker = [&]( int t ) {
+      try {
+        for ( size_t j = next_job++; j < num_jobs; j = next_job++ ) job( j );
+      }
+      catch ( ... ) {
+        errors[ t ] = std::current_exception();
+        next_job = num_jobs;
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for ( int t = 1; t < num_threads; ++t ) threads.emplace_back( worker, t );
+    worker( 0 );
+    for ( auto& th : threads ) th.join();
+    for ( const auto& e : errors ) if ( e ) std::rethrow_exception( e );
+  }
+
+  // Builds a binary cross section table for a single reaction on the given
+  // grid (extended by the level thresholds of a nuclear reaction)
+  marley::CrossSectionTable make_table( const marley::Reaction& react,
+    std::vector<double> KEs, bool store_levels, int num_threads )
+  {
+    marley::CrossSectionTable table;
+    table.description = react.get_description();
+    table.pdg_a = react.pdg_a();
+    table.pdg_b = react.pdg_b();
+    table.pdg_c = react.pdg_c();
+    table.pdg_d = react.pdg_d();
+
+    const auto* nr = dynamic_cast< const marley::NuclearReaction* >( &react );
+    if ( nr && !KEs.empty() ) {
+      auto KE_levels = nr->level_threshold_KEs( KEs.front(), KEs.back() );
+      KEs.insert( KEs.end(), KE_levels.cbegin(), KE_levels.cend() );
+      std::sort( KEs.begin(), KEs.end() );
+      KEs.erase( std::unique(KEs.begin(), KEs.end()), KEs.end() );
+    }
+    store_levels = store_levels && nr;
+
+    size_t num_KEs = KEs.size();
+    size_t num_levels = 0u;
+    if ( store_levels ) {
+      for ( const auto& mat_el : nr->matrix_elements() ) {
+        table.level_energies.push_back( mat_el.level_energy() );
+      }
+      num_levels = table.level_energies.size();
+      table.level_xsecs.assign( num_KEs * num_levels, 0. );
+    }
+
+    table.totals.assign( num_KEs, 0. );
+    size_t num_chunks = ( num_KEs + CHUNK_SIZE - 1u ) / CHUNK_SIZE;
+    run_parallel( num_chunks, num_threads, [&]( size_t c ) {
+      size_t begin = c * CHUNK_SIZE;
+      size_t end = std::min( begin + CHUNK_SIZE, num_KEs );
+      if ( !store_levels ) {
+        react.total_xs_batch( table.pdg_a, &KEs[ begin ],
+          &table.totals[ begin ], end - begin );
+        return;
+      }
+      std::vector<double> levels;
+      for ( size_t i = begin; i < end; ++i ) {
+        table.totals[ i ] = nr->exact_xs_by_level( KEs[i], levels );
+        std::copy( levels.cbegin(), levels.cend(),
+          table.level_xsecs.begin() + i*num_levels );
+      }
+    } );
+
+    table.KEs = std::move( KEs );
+    return table;
+  }
+
   // Helper functions for loading custom dump parameters from the job
   // configuration file
   // TODO: reduce code duplication between these two functions
@@ -104,9 +220,6 @@ int main(int argc, char* argv[]) {
     }
   }
 
-  // Open the output file for writing
-  std::ofstream out_file( output_file_name );
-
   // Configure a new Generator object
   #ifdef USE_ROOT
     marley::RootJSONConfig config( config_file_name );
@@ -136,25 +249,78 @@ int main(int argc, char* argv[]) {
   // desired projectile energy range
   double delta_KE_step = ( KEmax - KEmin ) / num_steps;
 
-  // Initial projectile energy to use in the loop
-  double KE = KEmin;
+  // Build the list of projectile energies, then compute the total cross
+  // section at all of them at once (summed over all active reactions and
+  // weighted by nuclide abundance in the target material)
+  std::vector<double> KEs( num_steps );
+  for ( int s = 0; s < num_steps; ++s ) {
+    KEs[ s ] = KEmin + ( s + 1 )*delta_KE_step;
+  }
+
+  int num_threads = 0;
+  get_int_dump_param( json, "xsec_dump_threads", num_threads );
+  if ( num_threads <= 0 ) {
+    num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+  }
+
+  std::string format = "text";
+  if ( json.has_key("xsec_dump_format") ) {
+    format = json.at( "xsec_dump_format" ).to_string();
+    if ( format != "text" && format != "binary" ) throw marley::Error(
+      "Unrecognized xsec_dump_format value \"" + format + "\" encountered"
+      " in the job configuration file. Allowed values are \"text\" and"
+      " \"binary\"." );
+  }
+
+  if ( format == "binary" ) {
+    bool store_levels = false;
+    if ( json.has_key("xsec_dump_levels") ) {
+      bool ok = false;
+      store_levels = json.at( "xsec_dump_levels" ).to_bool( ok );
+      if ( !ok ) throw marley::Error( "Unrecognized xsec_dump_levels value "
+        + json.at("xsec_dump_levels").to_string() + " encountered in the"
+        " job configuration file." );
+    }
+
+    std::vector<marley::CrossSectionTable> tables;
+    for ( const auto& react : gen.get_reactions() ) {
+      tables.push_back( make_table(*react, KEs, store_levels, num_threads) );
+      MARLEY_LOG_INFO() << "Tabulated " << ( tables.back().has_levels() ?
+        "per-level" : "total" ) << " cross sections for the reaction "
+        << react->get_description() << " at " << tables.back().KEs.size()
+        << " projectile kinetic energies";
+    }
+
+    marley::CrossSectionTable::save( output_file_name, tables );
+    std::cout << "Wrote cross section tables for " << tables.size()
+      << " reaction" << ( tables.size() == 1u ? "" : "s" ) << " to "
+      << output_file_name << '\n';
+    return 0;
+  }
+
+  std::vector<double> xsecs( num_steps );
+  size_t num_chunks = ( KEs.size() + CHUNK_SIZE - 1u ) / CHUNK_SIZE;
+  run_parallel( num_chunks, num_threads, [&]( size_t c ) {
+    size_t begin = c * CHUNK_SIZE;
+    size_t end = std::min( begin + CHUNK_SIZE, KEs.size() );
+    gen.total_xs_batch( projectile_pdg, &KEs[ begin ], &xsecs[ begin ],
+      end - begin );
+  } );
+
+  // Open the output file for writing
+  std::ofstream out_file( output_file_name );
 
   // Ready for the dump now
   // Energies are dumped in units of MeV
   // Cross section values are dumped in units of 10^(-42) cm^2 / atom
   for ( int s = 0; s < num_steps; ++s ) {
 
-    // Update the projectile energy for this step
-    KE += delta_KE_step;
-
-    // Compute the total cross section at this projectile
-    // energy (summed over all active reactions and weighted
-    // by nuclide abundance in the target material)
-    double xsec = gen.total_xs( projectile_pdg, KE );
+    double KE = KEs[ s ];
 
     // Convert the total cross section from MARLEY natural units (MeV^{-2}) to
     // conventional units (10^{-42} cm^2)
-    xsec *= marley_utils::hbar_c2 * marley_utils::fm2_to_minus40_cm2 * 1e2;
+    double xsec = xsecs[ s ] * marley_utils::hbar_c2
+      * marley_utils::fm2_to_minus40_cm2 * 1e2;
 
     // Write the current kinetic energy and total cross section to the output
     // file
@@ -165,5 +331,50 @@ int main(int argc, char* argv[]) {
       << xsec << " \u00D7 10^{-42} cm^2 / atom";
   }
 
+  // If requested, also estimate the total cross section averaged over the
+  // configured neutrino source. This uses far fewer cross section
+  // evaluations than a fine energy grid, and it comes with an error
+  // estimate. The settings are read from an optional object, e.g.,
+  //
+  //   xsec_dump_flux_average: {
+  //     method: "qmc",    // "qmc" (default) or "stratified"
+  //     points: 256,      // Total number of cross section evaluations
+  //     replicates: 16,   // Independent randomizations ("qmc" only)
+  //   }
+  if ( json.has_key("xsec_dump_flux_average") ) {
+    const marley::JSON& settings = json.at( "xsec_dump_flux_average" );
+
+    using Method = marley::Generator::FluxAverageMethod;
+    Method method = Method::QuasiMonteCarlo;
+    if ( settings.has_key("method") ) {
+      std::string method_name = settings.at( "method" ).to_string();
+      if ( method_name == "stratified" ) method = Method::Stratified;
+      else if ( method_name != "qmc" ) throw marley::Error( "Unrecognized"
+        " flux-averaged cross section method \"" + method_name
+        + "\" encountered in the job configuration file. Allowed values"
+        " are \"qmc\" and \"stratified\"." );
+    }
+
+    int num_points = DEFAULT_FLUX_AVG_POINTS;
+    int num_replicates = DEFAULT_FLUX_AVG_REPLICATES;
+    get_int_dump_param( settings, "points", num_points );
+    get_int_dump_param( settings, "replicates", num_replicates );
+    if ( num_points <= 0 || num_replicates <= 0 ) throw marley::Error(
+      "The points and replicates values given in xsec_dump_flux_average"
+      " must be positive" );
+
+    auto estimate = gen.estimate_flux_averaged_total_xs( method, num_points,
+      num_replicates );
+
+    double to_conventional = marley_utils::hbar_c2
+      * marley_utils::fm2_to_minus40_cm2 * 1e2;
+    MARLEY_LOG_INFO() << "Flux-averaged total xsec = " << estimate.value
+      * to_conventional << " \u00B1 " << estimate.error * to_conventional
+      << " \u00D7 10^{-42} cm^2 / atom (" << estimate.num_evaluations
+      << " evaluations)";
+    MARLEY_LOG_INFO() << "Quadrature result = " << gen.flux_averaged_total_xs()
+      * to_conventional << " \u00D7 10^{-42} cm^2 / atom";
+  }
+
   return 0;
 }
@@ -41,8 +41,8 @@ void print_particle_info( const marley::Particle& p ) {
 
 void print_event_info(const marley::Event& e, const size_t num) {
 
-  const std::vector< marley::Particle* > initials = e.get_initial_particles();
-  const std::vector< marley::Particle* > finals = e.get_final_particles();
+  const std::vector< marley::Particle >& initials = e.get_initial_particles();
+  const std::vector< marley::Particle >& finals = e.get_final_particles();
 
   size_t num_initial = initials.size();
   size_t num_final = finals.size();
@@ -60,13 +60,13 @@ void print_event_info(const marley::Event& e, const size_t num) {
   std::cout << e.parity() << '\n';
 
   std::cout << "Initial particles" << '\n';
-  for ( const auto* particle_i : initials ) {
-    print_particle_info( *particle_i );
+  for ( const auto& particle_i : initials ) {
+    print_particle_info( particle_i );
   }
 
   std::cout << "Final particles" << '\n';
-  for ( const auto* particle_f : finals ) {
-    print_particle_info( *particle_f );
+  for ( const auto& particle_f : finals ) {
+    print_particle_info( particle_f );
   }
 }
 
@@ -0,0 +1,327 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// POSIX includes
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/Logger.hh"
+#include "marley/OutputFile.hh"
+
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
+// Measures end-to-end event generation throughput for one or more job
+// configuration files (see examples/config/benchmarks/). Each configuration
+// is run in a separate child process so that its peak memory use can be
+// measured independently. The following quantities are recorded:
+//
+//   startup_s:       Time needed to parse the configuration and build the
+//                    Generator (s)
+//   events_per_s:    Events generated and written per second
+//   peak_rss_mb:     Peak resident set size of the process (MiB)
+//   bytes_per_event: Size of the output file divided by the number of events
+//
+// The settings used for each configuration are read from its "benchmark"
+// object:
+//
+//   benchmark: {
+//     events: 10000,   // Number of events to generate
+//     format: "ascii", // Output format ("ascii", "hepevt", "json", "binary")
+//   }
+//
+// Usage:
+//
+//   marthroughput [--output results.json] [--baseline baselines.json]
+//     [--tolerance 0.25] CONFIG_FILE...
+//
+// When a baseline file (in the same format as the output) is given, each
+// result is compared to the baseline entry with the same name. A slowdown
+// or growth larger than the tolerance (as a fraction of the baseline value)
+// is reported as a regression, and the program then exits with status 1.
+// The output size per event should not depend on the machine, so it is
+// compared using a tolerance of 1%. The timing baselines, on the other
+// hand, are only meaningful on the machine where they were recorded.
+
+namespace {
+
+  constexpr long DEFAULT_EVENTS = 10000;
+  constexpr double DEFAULT_TOLERANCE = 0.25;
+  constexpr double BYTES_TOLERANCE = 0.01;
+
+  // Returns the file name without its directory or extension
+  std::string base_name( const std::string& file_name ) {
+    size_t start = file_name.find_last_of( '/' );
+    start = ( start == std::string::npos ) ? 0u : start + 1u;
+    size_t end = file_name.find_last_of( '.' );
+    if ( end == std::string::npos || end < start ) end = file_name.size();
+    return file_name.substr( start, end - start );
+  }
+
+  // Peak resident set size of the calling process (MiB)
+  double peak_rss_mb() {
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    #ifdef __APPLE__
+      return usage.ru_maxrss / 1048576.; // bytes
+    #else
+      return usage.ru_maxrss / 1024.; // KiB
+    #endif
+  }
+
+  // Runs the benchmark for a single configuration file
+  marley::JSON run_benchmark( const std::string& config_file ) {
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    #ifdef USE_ROOT
+      marley::RootJSONConfig config( config_file );
+    #else
+      marley::JSONConfig config( config_file );
+    #endif
+
+    marley::Generator gen = config.create_generator();
+    std::chrono::duration<double> startup = Clock::now() - start;
+
+    marley::JSON json = config.get_json();
+    marley::JSON settings = json.get_object( "benchmark", false );
+    long num_events = settings.get_long( "events", DEFAULT_EVENTS );
+    std::string format = settings.get_string( "format", "ascii" );
+    if ( num_events <= 0 ) throw marley::Error( "The number of benchmark"
+      " events must be positive" );
+
+    std::string out_name = "marthroughput_" + base_name( config_file )
+      + ".out";
+    std::unique_ptr<marley::OutputFile> out;
+    if ( format == "binary" ) out = std::make_unique<marley::BinaryOutputFile>(
+      out_name, format, "overwrite", true );
+    else out = std::make_unique<marley::TextOutputFile>( out_name, format,
+      "overwrite", true );
+
+    out->write_flux_avg_tot_xsec( gen.flux_averaged_total_xs() );
+
+    marley::Event ev;
+    start = Clock::now();
+    for ( long e = 0; e < num_events; ++e ) {
+      gen.create_event( ev );
+      out->write_event( &ev );
+    }
+    out->close( config.get_json(), gen, num_events );
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::ifstream out_file( out_name, std::ios::binary | std::ios::ate );
+    double bytes = static_cast<double>( out_file.tellg() );
+    out_file.close();
+    std::remove( out_name.c_str() );
+
+    marley::JSON result = marley::JSON::object();
+    result[ "name" ] = base_name( config_file );
+    result[ "events" ] = num_events;
+    result[ "format" ] = format;
+    result[ "startup_s" ] = startup.count();
+    result[ "events_per_s" ] = num_events / elapsed.count();
+    result[ "peak_rss_mb" ] = peak_rss_mb();
+    result[ "bytes_per_event" ] = bytes / num_events;
+    return result;
+  }
+
+  // Runs run_benchmark() in a child process and returns its result
+  marley::JSON run_in_child( const std::string& config_file ) {
+
+    int fds[ 2 ];
+    if ( pipe(fds) != 0 ) throw marley::Error( "Could not create a pipe" );
+
+    // Don't let the child process inherit (and later repeat) any buffered
+    // output
+    std::cout.flush();
+
+    pid_t pid = fork();
+    if ( pid < 0 ) throw marley::Error( "Could not start a child process" );
+
+    if ( pid == 0 ) {
+      close( fds[0] );
+      int status = 0;
+      std::string text;
+      try {
+        text = run_benchmark( config_file ).dump_string();
+      }
+      catch ( const std::exception& error ) {
+        std::cerr << "Benchmark " << config_file << " failed: "
+          << error.what() << '\n';
+        status = 1;
+      }
+      size_t written = 0u;
+      while ( written < text.size() ) {
+        ssize_t n = write( fds[1], text.data() + written,
+          text.size() - written );
+        if ( n <= 0 ) break;
+        written += n;
+      }
+      close( fds[1] );
+      std::cout.flush();
+      _exit( status );
+    }
+
+    close( fds[1] );
+    std::string text;
+    char buffer[ 4096 ];
+    ssize_t n;
+    while ( (n = read(fds[0], buffer, sizeof(buffer))) > 0 ) {
+      text.append( buffer, n );
+    }
+    close( fds[0] );
+
+    int status = 0;
+    waitpid( pid, &status, 0 );
+    if ( !WIFEXITED(status) || WEXITSTATUS(status) != 0 || text.empty() ) {
+      throw marley::Error( "The benchmark for " + config_file + " failed" );
+    }
+    return marley::JSON::load( text );
+  }
+
+  // Compares a single quantity to its baseline value. If higher_is_better
+  // is true, a decrease counts as a regression, and vice versa.
+  bool check( const marley::JSON& result, const marley::JSON& baseline,
+    const std::string& key, double tolerance, bool higher_is_better )
+  {
+    if ( !baseline.has_key(key) ) return true;
+    double value = result.at( key ).to_double();
+    double base = baseline.at( key ).to_double();
+    double change = ( base != 0. ) ? ( value - base ) / base : 0.;
+
+    bool ok = higher_is_better ? ( change >= -tolerance )
+      : ( change <= tolerance );
+
+    std::cout << "  " << std::left << std::setw( 16 ) << key << std::right
+      << std::setw( 14 ) << value << "  (baseline " << base << ", "
+      << std::showpos << std::setprecision( 3 ) << 100. * change
+      << std::noshowpos << std::setprecision( 6 ) << "%)"
+      << ( ok ? "" : "  REGRESSION" ) << '\n';
+    return ok;
+  }
+
+}
+
+int main( int argc, char* argv[] ) {
+
+  std::string output_file;
+  std::string baseline_file;
+  double tolerance = DEFAULT_TOLERANCE;
+  std::vector<std::string> config_files;
+
+  for ( int a = 1; a < argc; ++a ) {
+    std::string arg( argv[a] );
+    if ( (arg == "--output" || arg == "--baseline" || arg == "--tolerance")
+      && a + 1 < argc )
+    {
+      std::string value( argv[++a] );
+      if ( arg == "--output" ) output_file = value;
+      else if ( arg == "--baseline" ) baseline_file = value;
+      else tolerance = std::stod( value );
+    }
+    else if ( !arg.empty() && arg.front() == '-' ) {
+      std::cout << "Usage: " << argv[0] << " [--output FILE] [--baseline"
+        << " FILE] [--tolerance FRACTION] CONFIG_FILE...\n";
+      return 1;
+    }
+    else config_files.push_back( arg );
+  }
+
+  if ( config_files.empty() ) {
+    std::cout << "Usage: " << argv[0] << " [--output FILE] [--baseline"
+      << " FILE] [--tolerance FRACTION] CONFIG_FILE...\n";
+    return 1;
+  }
+
+  try {
+    marley::JSON baselines = marley::JSON::array();
+    if ( !baseline_file.empty() ) {
+      baselines = marley::JSON::load_file( baseline_file ).at( "results" );
+    }
+
+    marley::JSON results = marley::JSON::array();
+    bool all_ok = true;
+
+    for ( const auto& config_file : config_files ) {
+      marley::JSON result = run_in_child( config_file );
+      results.append( result );
+
+      std::string name = result.at( "name" ).to_string();
+      std::cout << name << '\n';
+
+      const marley::JSON* baseline = nullptr;
+      for ( const auto& b : baselines.array_range() ) {
+        if ( b.at("name").to_string() == name ) baseline = &b;
+      }
+
+      if ( !baseline ) {
+        for ( const auto& key : { "startup_s", "events_per_s",
+          "peak_rss_mb", "bytes_per_event" } )
+        {
+          std::cout << "  " << std::left << std::setw( 16 ) << key
+            << std::right << std::setw( 14 ) << result.at( key ).to_double()
+            << '\n';
+        }
+        continue;
+      }
+
+      all_ok &= check( result, *baseline, "startup_s", tolerance, false );
+      all_ok &= check( result, *baseline, "events_per_s", tolerance, true );
+      all_ok &= check( result, *baseline, "peak_rss_mb", tolerance, false );
+      all_ok &= check( result, *baseline, "bytes_per_event", BYTES_TOLERANCE,
+        false );
+    }
+
+    if ( !output_file.empty() ) {
+      marley::JSON report = marley::JSON::object();
+      report[ "results" ] = results;
+      std::ofstream out( output_file );
+      out << report.dump_string( 2 ) << '\n';
+    }
+
+    if ( !all_ok ) {
+      std::cout << "Performance regressions were found\n";
+      return 1;
+    }
+  }
+  catch ( const std::exception& error ) {
+    std::cerr << "[ERROR]: " << error.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,568 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// GNU Scientific Library includes
+#include "gsl/gsl_cdf.h"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventHistograms.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/StructureDatabase.hh"
+
+// Checks the distributions of events generated using faster (tabulated,
+// cached, or lower-precision) settings against high-statistics reference
+// distributions obtained with the most accurate settings. Events for each
+// setting are generated in parallel and histogrammed on the fly (see
+// marley::EventHistograms). The reference histograms are stored in a file
+// and reused by later runs until the settings used to create them change.
+//
+// The validation is described by the "validation" object in a job
+// configuration file (see examples/config/validation/). The rest of the file
+// is an ordinary job configuration.
+//
+//   validation: {
+//     events: 100000,            // Events to generate for each mode
+//     reference_events: 1000000, // Events to generate for the reference
+//     reference_file: "ref.json", // Cache file for the reference histograms
+//     threads: 0,                // 0 = use all available hardware threads
+//     min_p_value: 0.001,        // Smallest acceptable p-value
+//     xsec_tolerance: 0.001,     // Largest acceptable relative change in
+//                                // the flux-averaged total cross section
+//
+//     // Job configuration keys that are changed for the reference
+//     reference: { precision: "validation" },
+//
+//     // Modes to check against the reference. Each mode gives the job
+//     // configuration keys that it changes, and it may also use its own
+//     // values of "min_p_value" and "xsec_tolerance".
+//     modes: [
+//       { name: "production", overrides: { precision: "production" } },
+//       { name: "tables", overrides: { xs_mode: "table" } },
+//     ],
+//
+//     // Histograms to compare (in the format used by the "histograms" key
+//     // of a job configuration file)
+//     histograms: [ { name: "Ex", x: "Ex", bins: 60, min: 0, max: 30 } ],
+//   }
+//
+// Each histogram is compared to the reference using two tests of whether
+// both were drawn from the same distribution. Only the shapes are compared,
+// since the normalization of each histogram is the number of events. The
+// first test is a chi-squared test for two weighted histograms. The second
+// is a Kolmogorov-Smirnov test applied to the binned cumulative
+// distributions (1D histograms only). This is somewhat conservative, so its
+// p-values tend to be larger than the unbinned ones would be. A mode passes
+// if both p-values for every histogram are at least "min_p_value" and its
+// flux-averaged total cross section agrees with the reference one. Since
+// every histogram is tested, a few chance failures are expected when many
+// histograms and modes are checked using a large "min_p_value".
+//
+// The speedup of each mode is its event generation rate divided by that of
+// the reference. The reference rate is stored in the cache file, so the
+// speedups are only meaningful on the machine where the reference was made
+// (use --regenerate to remake it).
+//
+// Usage:
+//
+//   marvalidate [--output results.json] [--threads N] [--regenerate]
+//     CONFIG_FILE
+//
+// The program exits with status 1 if any mode fails.
+
+namespace {
+
+  constexpr long DEFAULT_EVENTS = 100000;
+  constexpr long DEFAULT_REFERENCE_EVENTS = 1000000;
+  constexpr double DEFAULT_MIN_P_VALUE = 1e-3;
+  constexpr double DEFAULT_XSEC_TOLERANCE = 1e-3;
+
+  // Minimum expected number of events in each group of bins used for the
+  // chi-squared test
+  constexpr double MIN_GROUP_ENTRIES = 5.;
+
+  // Added to the seed used for the reference so that its events are
+  // independent of those generated for the modes
+  constexpr uint_fast64_t REFERENCE_SEED_OFFSET = 1000003u;
+
+  // Returns the file name without its directory or extension
+  std::string base_name( const std::string& file_name ) {
+    size_t start = file_name.find_last_of( '/' );
+    start = ( start == std::string::npos ) ? 0u : start + 1u;
+    size_t end = file_name.find_last_of( '.' );
+    if ( end == std::string::npos || end < start ) end = file_name.size();
+    return file_name.substr( start, end - start );
+  }
+
+  // Returns a copy of the job configuration without its "validation" object
+  // and with the given keys replaced
+  marley::JSON make_config( const marley::JSON& json,
+    const marley::JSON& overrides )
+  {
+    marley::JSON config = marley::JSON::object();
+    for ( const auto& pair : json.object_range() ) {
+      if ( pair.first != "validation" ) config[ pair.first ] = pair.second;
+    }
+    if ( overrides.is_null() ) return config;
+    if ( !overrides.is_object() ) throw marley::Error( "The overrides for"
+      " each validation mode must be given as a JSON object" );
+    for ( const auto& pair : overrides.object_range() ) {
+      config[ pair.first ] = pair.second;
+    }
+    return config;
+  }
+
+  // Event generation results for one mode
+  struct RunResult {
+    marley::JSON histograms; // Output of EventHistograms::to_json()
+    double startup_s;
+    double events_per_s;
+  };
+
+  // Generates events using the given job configuration on several threads
+  // at once and histograms them
+  RunResult generate( const marley::JSON& config, const marley::JSON& specs,
+    long num_events, int num_threads, uint_fast64_t seed_offset )
+  {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    marley::JSONConfig jc( config );
+
+    // As in the marley executable, the worker Generators share the
+    // StructureDatabase of the first one. With the counter-based random
+    // number engine, each thread generates a separate range of event numbers.
+    // Otherwise, each thread uses its own seed.
+    std::vector< std::unique_ptr<marley::Generator> > gens;
+    gens.push_back( std::make_unique<marley::Generator>(
+      jc.create_generator()) );
+    uint_fast64_t seed = gens.front()->get_seed() + seed_offset;
+    bool counter_based = gens.front()->counter_based_rng();
+
+    auto sdb = gens.front()->get_shared_structure_db();
+    if ( num_threads > 1 ) {
+      marley::StructureDatabase::WorkerScope main_worker(
+        gens.front().get() );
+      sdb->set_concurrent( true );
+    }
+    for ( int t = 1; t < num_threads; ++t ) {
+      gens.push_back( std::make_unique<marley::Generator>(
+        jc.create_generator(sdb)) );
+    }
+
+    std::vector<long> first_events;
+    for ( int t = 0; t <= num_threads; ++t ) {
+      first_events.push_back( num_events * t / num_threads );
+    }
+    for ( int t = 0; t < num_threads; ++t ) {
+      if ( counter_based ) {
+        gens[ t ]->reseed( seed );
+        gens[ t ]->set_event_number( first_events[ t ] );
+      }
+      else gens[ t ]->reseed( seed + t );
+    }
+
+    std::vector<marley::EventHistograms> hists( num_threads,
+      marley::EventHistograms(specs) );
+    std::vector<std::exception_ptr> errors( num_threads );
+
+    std::chrono::duration<double> startup = Clock::now() - start;
+    start = Clock::now();
+
+    auto worker = [&]( int t ) {
+      try {
+        marley::Event ev;
+        for ( long e = first_events[ t ]; e < first_events[ t + 1 ]; ++e ) {
+          gens[ t ]->create_event( ev );
+          hists[ t ].fill( ev );
+        }
+      }
+      catch ( ... ) {
+        errors[ t ] = std::current_exception();
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for ( int t = 1; t < num_threads; ++t ) threads.emplace_back( worker, t );
+    worker( 0 );
+    for ( auto& th : threads ) th.join();
+    for ( const auto& e : errors ) if ( e ) std::rethrow_exception( e );
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    for ( int t = 1; t < num_threads; ++t ) hists.front().merge( hists[ t ] );
+
+    RunResult result;
+    result.histograms = hists.front().to_json(
+      gens.front()->flux_averaged_total_xs() );
+    result.startup_s = startup.count();
+    result.events_per_s = num_events / elapsed.count();
+    return result;
+  }
+
+  std::vector<double> to_vector( const marley::JSON& array ) {
+    std::vector<double> values;
+    for ( const auto& v : array.array_range() ) {
+      values.push_back( v.to_double() );
+    }
+    return values;
+  }
+
+  // Kolmogorov distribution Q_KS(lambda), i.e., the asymptotic probability
+  // that the scaled KS distance exceeds lambda
+  double kolmogorov_q( double lambda ) {
+    if ( lambda < 0.2 ) return 1.;
+    double sum = 0.;
+    double sign = 1.;
+    for ( int j = 1; j <= 100; ++j ) {
+      double term = sign * std::exp( -2. * j * j * lambda * lambda );
+      sum += term;
+      if ( std::abs(term) < 1e-12 * std::abs(sum) ) break;
+      sign = -sign;
+    }
+    return std::min( 1., std::max(0., 2. * sum) );
+  }
+
+  // Compares a histogram to its reference counterpart and returns a JSON
+  // object describing the result
+  marley::JSON compare_histograms( const marley::JSON& hist,
+    const marley::JSON& ref, double min_p_value, bool& passed )
+  {
+    std::vector<double> w1 = to_vector( hist.at("sum_w") );
+    std::vector<double> s1 = to_vector( hist.at("sum_w2") );
+    std::vector<double> w2 = to_vector( ref.at("sum_w") );
+    std::vector<double> s2 = to_vector( ref.at("sum_w2") );
+    if ( w1.size() != w2.size() ) throw marley::Error( "The binning of the"
+      " histogram \"" + hist.at("name").to_string() + "\" does not match"
+      " that of the reference" );
+
+    double W1 = 0.;
+    double W2 = 0.;
+    double S1 = 0.;
+    double S2 = 0.;
+    for ( size_t b = 0u; b < w1.size(); ++b ) {
+      W1 += w1[ b ];
+      W2 += w2[ b ];
+      S1 += s1[ b ];
+      S2 += s2[ b ];
+    }
+
+    marley::JSON result = marley::JSON::object();
+    result[ "name" ] = hist.at( "name" );
+    if ( W1 <= 0. || W2 <= 0. ) {
+      result[ "passed" ] = false;
+      passed = false;
+      return result;
+    }
+
+    // Chi-squared test for two weighted histograms with free normalizations.
+    // Neighboring bins are combined until each group is expected to hold at
+    // least MIN_GROUP_ENTRIES events in the smaller sample, since the
+    // chi-squared distribution is a poor approximation for sparse bins.
+    double n1 = W1 * W1 / S1;
+    double n2 = W2 * W2 / S2;
+    struct Group { double w1 = 0., s1 = 0., w2 = 0., s2 = 0.; };
+    std::vector<Group> groups( 1 );
+    for ( size_t b = 0u; b < w1.size(); ++b ) {
+      Group& g = groups.back();
+      g.w1 += w1[ b ];
+      g.s1 += s1[ b ];
+      g.w2 += w2[ b ];
+      g.s2 += s2[ b ];
+      double fraction = 0.5 * ( g.w1 / W1 + g.w2 / W2 );
+      if ( fraction * std::min(n1, n2) >= MIN_GROUP_ENTRIES ) {
+        groups.emplace_back();
+      }
+    }
+    // Add any sparse bins left over at the end to the previous group
+    if ( groups.size() > 1u ) {
+      Group last = groups.back();
+      groups.pop_back();
+      groups.back().w1 += last.w1;
+      groups.back().s1 += last.s1;
+      groups.back().w2 += last.w2;
+      groups.back().s2 += last.s2;
+    }
+
+    double chi2 = 0.;
+    int ndof = -1;
+    for ( const auto& g : groups ) {
+      double variance = W2 * W2 * g.s1 + W1 * W1 * g.s2;
+      if ( variance <= 0. ) continue;
+      double diff = W2 * g.w1 - W1 * g.w2;
+      chi2 += diff * diff / variance;
+      ++ndof;
+    }
+    double chi2_p = ( ndof > 0 ) ? gsl_cdf_chisq_Q( chi2, ndof ) : 1.;
+    result[ "chi2" ] = chi2;
+    result[ "ndof" ] = ndof;
+    result[ "chi2_p_value" ] = chi2_p;
+    bool ok = ( chi2_p >= min_p_value );
+
+    // Kolmogorov-Smirnov test using the effective numbers of entries
+    if ( !hist.has_key("y") ) {
+      double distance = 0.;
+      double cdf1 = 0.;
+      double cdf2 = 0.;
+      for ( size_t b = 0u; b < w1.size(); ++b ) {
+        cdf1 += w1[ b ] / W1;
+        cdf2 += w2[ b ] / W2;
+        distance = std::max( distance, std::abs(cdf1 - cdf2) );
+      }
+      double sqrt_n = std::sqrt( n1 * n2 / (n1 + n2) );
+      double ks_p = kolmogorov_q( (sqrt_n + 0.12 + 0.11 / sqrt_n)
+        * distance );
+      result[ "ks_distance" ] = distance;
+      result[ "ks_p_value" ] = ks_p;
+      ok &= ( ks_p >= min_p_value );
+    }
+
+    result[ "passed" ] = ok;
+    passed &= ok;
+    return result;
+  }
+
+  // Loads the cached reference histograms, or regenerates them if the cache
+  // is missing or was made using different settings
+  marley::JSON get_reference( const std::string& file_name,
+    const marley::JSON& key, const marley::JSON& specs, long num_events,
+    int num_threads, bool regenerate )
+  {
+    if ( !regenerate ) {
+      std::ifstream in( file_name );
+      if ( in ) {
+        marley::JSON cached = marley::JSON::load( in );
+        if ( cached.has_key("key") && cached.at("key").dump_string()
+          == key.dump_string() )
+        {
+          std::cout << "Using the reference histograms from " << file_name
+            << '\n';
+          return cached;
+        }
+        std::cout << "The settings used to create " << file_name
+          << " have changed\n";
+      }
+    }
+
+    std::cout << "Generating " << num_events << " reference events using "
+      << num_threads << " thread(s)\n";
+    RunResult run = generate( key.at("config"), specs, num_events,
+      num_threads, REFERENCE_SEED_OFFSET );
+
+    marley::JSON cached = marley::JSON::object();
+    cached[ "key" ] = key;
+    cached[ "events_per_s" ] = run.events_per_s;
+    cached[ "threads" ] = num_threads;
+    cached[ "histograms" ] = run.histograms;
+
+    std::ofstream out( file_name );
+    if ( !out ) throw marley::Error( "Could not write the reference"
+      " histograms to \"" + file_name + "\"" );
+    out << cached.dump_string() << '\n';
+    std::cout << "Saved the reference histograms to " << file_name << '\n';
+    return cached;
+  }
+
+  void print_usage( const char* name ) {
+    std::cout << "Usage: " << name << " [--output FILE] [--threads N]"
+      << " [--regenerate] CONFIG_FILE\n";
+  }
+
+}
+
+int main( int argc, char* argv[] ) {
+
+  std::string output_file;
+  std::string config_file;
+  int num_threads = -1;
+  bool regenerate = false;
+
+  for ( int a = 1; a < argc; ++a ) {
+    std::string arg( argv[a] );
+    if ( (arg == "--output" || arg == "--threads") && a + 1 < argc ) {
+      std::string value( argv[++a] );
+      if ( arg == "--output" ) output_file = value;
+      else num_threads = std::stoi( value );
+    }
+    else if ( arg == "--regenerate" ) regenerate = true;
+    else if ( !arg.empty() && arg.front() != '-' && config_file.empty() ) {
+      config_file = arg;
+    }
+    else {
+      print_usage( argv[0] );
+      return 1;
+    }
+  }
+
+  if ( config_file.empty() ) {
+    print_usage( argv[0] );
+    return 1;
+  }
+
+  try {
+    marley::JSON json = marley::JSON::load_file( config_file );
+    if ( !json.has_key("validation") ) throw marley::Error( "The"
+      " configuration file " + config_file + " does not contain a"
+      " \"validation\" object" );
+    marley::JSON settings = json.at( "validation" );
+
+    long num_events = settings.get_long( "events", DEFAULT_EVENTS );
+    long ref_events = settings.get_long( "reference_events",
+      DEFAULT_REFERENCE_EVENTS );
+    if ( num_events <= 0 || ref_events <= 0 ) throw marley::Error( "The"
+      " numbers of validation events must be positive" );
+
+    if ( num_threads < 0 ) num_threads = settings.get_long( "threads", 0 );
+    if ( num_threads <= 0 ) {
+      num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+
+    double min_p_value = settings.get_double( "min_p_value",
+      DEFAULT_MIN_P_VALUE );
+    double xsec_tolerance = settings.get_double( "xsec_tolerance",
+      DEFAULT_XSEC_TOLERANCE );
+
+    marley::JSON specs = settings.get_object( "histograms", false );
+    if ( !specs.is_array() || specs.length() == 0 ) throw marley::Error(
+      "At least one histogram must be given in the \"histograms\" array"
+      " of the \"validation\" object" );
+
+    std::string ref_file = settings.get_string( "reference_file",
+      base_name(config_file) + "_reference.json" );
+
+    // Everything that determines the reference histograms (except for the
+    // number of threads, which only changes which events are generated)
+    marley::JSON key = marley::JSON::object();
+    key[ "config" ] = make_config( json, settings.has_key("reference")
+      ? settings.at("reference") : marley::JSON() );
+    key[ "histograms" ] = specs;
+    key[ "events" ] = ref_events;
+
+    marley::JSON ref = get_reference( ref_file, key, specs, ref_events,
+      num_threads, regenerate );
+    const marley::JSON& ref_hists = ref.at( "histograms" );
+    double ref_rate = ref.at( "events_per_s" ).to_double();
+    double ref_xsec = ref_hists.at( "flux_avg_tot_xsec" ).to_double();
+
+    marley::JSON modes = settings.get_object( "modes", false );
+    if ( !modes.is_array() ) throw marley::Error( "The \"modes\" key in"
+      " the \"validation\" object must have an array value" );
+
+    marley::JSON results = marley::JSON::array();
+    bool all_ok = true;
+
+    for ( auto& mode : modes.array_range() ) {
+      std::string name = mode.get_string( "name" );
+      double mode_min_p = mode.get_double( "min_p_value", min_p_value );
+      double mode_xsec_tol = mode.get_double( "xsec_tolerance",
+        xsec_tolerance );
+
+      marley::JSON config = make_config( json, mode.has_key("overrides")
+        ? mode.at("overrides") : marley::JSON() );
+
+      std::cout << name << '\n';
+      RunResult run = generate( config, specs, num_events, num_threads, 0u );
+
+      bool passed = true;
+      double xsec = run.histograms.at( "flux_avg_tot_xsec" ).to_double();
+      double xsec_change = ( xsec - ref_xsec ) / ref_xsec;
+      if ( std::abs(xsec_change) > mode_xsec_tol ) passed = false;
+
+      std::cout << "  " << std::left << std::setw( 24 ) << "events_per_s"
+        << std::right << std::setw( 12 ) << run.events_per_s << "  (speedup "
+        << std::setprecision( 3 ) << run.events_per_s / ref_rate
+        << std::setprecision( 6 ) << ")\n";
+      std::cout << "  " << std::left << std::setw( 24 ) << "xsec change"
+        << std::right << std::setw( 12 ) << xsec_change
+        << ( std::abs(xsec_change) > mode_xsec_tol ? "  FAILED" : "" )
+        << '\n';
+
+      marley::JSON comparisons = marley::JSON::array();
+      const marley::JSON& hists = run.histograms.at( "histograms" );
+      for ( int h = 0; h < hists.length(); ++h ) {
+        bool hist_ok = true;
+        marley::JSON c = compare_histograms( hists.at(h),
+          ref_hists.at("histograms").at(h), mode_min_p, hist_ok );
+        passed &= hist_ok;
+        comparisons.append( c );
+
+        std::cout << "  " << std::left << std::setw( 24 )
+          << c.at( "name" ).to_string() << std::right;
+        if ( c.has_key("chi2_p_value") ) {
+          std::cout << "  chi2/ndof = " << c.at( "chi2" ).to_double()
+            << '/' << c.at( "ndof" ).to_long() << ", p = "
+            << c.at( "chi2_p_value" ).to_double();
+        }
+        if ( c.has_key("ks_p_value") ) {
+          std::cout << ", KS p = " << c.at( "ks_p_value" ).to_double();
+        }
+        std::cout << ( hist_ok ? "" : "  FAILED" ) << '\n';
+      }
+
+      marley::JSON result = marley::JSON::object();
+      result[ "name" ] = name;
+      result[ "events" ] = num_events;
+      result[ "threads" ] = num_threads;
+      result[ "startup_s" ] = run.startup_s;
+      result[ "events_per_s" ] = run.events_per_s;
+      result[ "speedup" ] = run.events_per_s / ref_rate;
+      result[ "flux_avg_tot_xsec" ] = xsec;
+      result[ "xsec_change" ] = xsec_change;
+      result[ "histograms" ] = comparisons;
+      result[ "passed" ] = passed;
+      results.append( result );
+
+      all_ok &= passed;
+    }
+
+    if ( !output_file.empty() ) {
+      marley::JSON report = marley::JSON::object();
+      report[ "reference_file" ] = ref_file;
+      report[ "reference_events" ] = ref_events;
+      report[ "reference_events_per_s" ] = ref_rate;
+      report[ "results" ] = results;
+      std::ofstream out( output_file );
+      out << report.dump_string( 2 ) << '\n';
+    }
+
+    if ( !all_ok ) {
+      std::cout << "Some modes do not agree with the reference\n";
+      return 1;
+    }
+  }
+  catch ( const std::exception& error ) {
+    std::cerr << "[ERROR]: " << error.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
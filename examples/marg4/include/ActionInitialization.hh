@@ -0,0 +1,46 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+
+// Standard library includes
+#include <memory>
+
+// Geant4 includes
+#include "G4VUserActionInitialization.hh"
+
+// MARLEY includes
+#include "marley/JSONConfig.hh"
+
+// Creates the user actions for the master thread and for each worker thread.
+// The parsed MARLEY configuration is built once (on the master) and shared
+// read-only by all of the workers, each of which constructs its own
+// marley::Generator from it.
+class ActionInitialization : public G4VUserActionInitialization
+{
+  public:
+    ActionInitialization(std::shared_ptr<const marley::JSONConfig> config,
+      int num_workers);
+
+    virtual void Build() const override;
+
+  protected:
+    // MARLEY configuration shared by all threads
+    std::shared_ptr<const marley::JSONConfig> config_;
+
+    // Number of worker threads that will build a marley::Generator
+    int num_workers_;
+};
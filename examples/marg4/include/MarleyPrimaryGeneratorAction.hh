@@ -17,13 +17,17 @@
 #pragma once
 
 // Standard library includes
+#include <memory>
 #include <string>
 
 // Geant4 includes
 #include "G4VUserPrimaryGeneratorAction.hh"
 
 // MARLEY includes
+#include "marley/Event.hh"
+#include "marley/EventPool.hh"
 #include "marley/Generator.hh"
+#include "marley/JSONConfig.hh"
 
 class G4Event;
 
@@ -32,9 +36,38 @@ class MarleyPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
   public:
     MarleyPrimaryGeneratorAction(const std::string& config_file_name);
 
+    // Creates the marley::Generator for a single thread using a shared
+    // configuration. The worker ID (counting from zero) and total number of
+    // workers are used to give each thread an independent random number
+    // stream and its share of any structure data memory budget.
+    MarleyPrimaryGeneratorAction(const marley::JSONConfig& config,
+      int worker_id, int num_workers);
+
     virtual void GeneratePrimaries(G4Event*) override;
 
   protected:
-    // MARLEY event generator object
-    marley::Generator marley_generator_;
+    // MARLEY event generator object. This is handed over to event_pool_
+    // (and left null) unless the counter-based random number engine is used.
+    std::unique_ptr<marley::Generator> marley_generator_;
+
+    // Sets up the random number stream and memory budget for
+    // marley_generator_, then starts event_pool_ if it is needed
+    void configure_for_worker(int worker_id, int num_workers);
+
+    // Whether the counter-based random number engine is in use. If it is,
+    // each MARLEY event is generated from the subsequence labeled by the
+    // Geant4 event ID, and the results do not depend on the number of
+    // worker threads.
+    bool counter_based_ = false;
+
+    // Maximum number of MARLEY events to generate ahead of time
+    static constexpr size_t EVENT_POOL_DEPTH = 1000;
+
+    // Creates MARLEY events on a background thread while Geant4 tracks
+    // the previous ones. The events are received in the same order as if
+    // they were generated here, so the results are reproducible.
+    std::unique_ptr<marley::EventPool> event_pool_;
+
+    // The current MARLEY event. Its storage is reused for each new event.
+    marley::Event event_;
 };
@@ -0,0 +1,47 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Geant4 includes
+#include "G4Threading.hh"
+
+// marg4 includes
+#include "ActionInitialization.hh"
+#include "EventAction.hh"
+#include "MarleyPrimaryGeneratorAction.hh"
+
+ActionInitialization::ActionInitialization(
+  std::shared_ptr<const marley::JSONConfig> config, int num_workers)
+  : G4VUserActionInitialization(), config_( config ),
+  num_workers_( num_workers )
+{
+}
+
+// Called once for each worker thread in multithreaded mode, or once on the
+// master thread in sequential mode
+void ActionInitialization::Build() const
+{
+  // The thread ID is negative in sequential mode
+  int worker_id = G4Threading::G4GetThreadId();
+  if ( worker_id < 0 ) worker_id = 0;
+
+  // The primary generator action interfaces with MARLEY
+  SetUserAction( new MarleyPrimaryGeneratorAction(*config_, worker_id,
+    num_workers_) );
+
+  // The event action prints the current event number at the beginning of
+  // every hundredth event without doing anything else.
+  SetUserAction( new EventAction );
+}
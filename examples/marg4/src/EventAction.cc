@@ -14,6 +14,7 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <atomic>
 #include <iostream>
 
 #include "EventAction.hh"
@@ -24,11 +25,11 @@ EventAction::EventAction()
 
 void EventAction::BeginOfEventAction(const G4Event* /*anEvent*/)
 {
-  // Print the event number at the beginning of every hundredth event
-  static unsigned long long event_count = 0;
-  if ( event_count % 100 == 0 ) std::cout << "Beginning event #" << event_count
-    << '\n';
-  ++event_count;
+  // Print the event number at the beginning of every hundredth event. The
+  // count is shared by all worker threads in multithreaded mode.
+  static std::atomic<unsigned long long> event_count( 0 );
+  unsigned long long count = event_count++;
+  if ( count % 100 == 0 ) std::cout << "Beginning event #" << count << '\n';
 }
 
 void EventAction::EndOfEventAction(const G4Event*)
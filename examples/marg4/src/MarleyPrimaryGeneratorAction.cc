@@ -15,7 +15,11 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 // Standard library includes
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 // Geant4 includes
 #include "G4Event.hh"
@@ -53,7 +57,59 @@ MarleyPrimaryGeneratorAction::MarleyPrimaryGeneratorAction(
   marley::JSONConfig config( config_file_name );
   #endif
 
-  marley_generator_= config.create_generator();
+  marley_generator_.reset( new marley::Generator(config.create_generator()) );
+  configure_for_worker( 0, 1 );
+}
+
+MarleyPrimaryGeneratorAction::MarleyPrimaryGeneratorAction(
+  const marley::JSONConfig& config, int worker_id, int num_workers)
+  : G4VUserPrimaryGeneratorAction()
+{
+  // Geant4 builds the user actions for all of the worker threads at the same
+  // time. Parsing is already done, and the reaction data files are only read
+  // once per process (see marley::ReactionDataRegistry), but some neutrino
+  // sources (e.g., those that read ROOT histograms) are not safe to create
+  // concurrently. Build the Generator objects one at a time.
+  static std::mutex setup_mutex;
+  {
+    std::lock_guard<std::mutex> lock( setup_mutex );
+    marley_generator_.reset( new marley::Generator(
+      config.create_generator()) );
+  }
+  configure_for_worker( worker_id, num_workers );
+}
+
+void MarleyPrimaryGeneratorAction::configure_for_worker(int worker_id,
+  int num_workers)
+{
+  // When the counter-based random number engine is in use, every event is
+  // drawn from its own subsequence, so the workers share the configured seed
+  // and stream ID. Otherwise, each worker is reseeded deterministically based
+  // on the configured seed (as is done by the marley executable) so that
+  // multithreaded runs are reproducible.
+  counter_based_ = marley_generator_->counter_based_rng();
+  if ( !counter_based_ && worker_id > 0 ) {
+    marley_generator_->reseed( marley_generator_->get_seed() + worker_id );
+  }
+
+  // Each worker owns a separate StructureDatabase, so share any memory
+  // budget for the nuclear structure data equally among them
+  auto& sdb = marley_generator_->get_structure_db();
+  size_t memory_budget = sdb.get_memory_budget();
+  if ( num_workers > 1 && memory_budget > 0u ) {
+    sdb.set_memory_budget( std::max( memory_budget / num_workers,
+      static_cast<size_t>(1u) ) );
+  }
+
+  // Events drawn from the counter-based engine depend on the Geant4 event
+  // ID, which is not known in advance, so they are generated on demand.
+  // Otherwise, hand the Generator over to a pool that fills up with new
+  // events in the background.
+  if ( counter_based_ ) return;
+  std::vector< std::unique_ptr<marley::Generator> > gens;
+  gens.push_back( std::move(marley_generator_) );
+  event_pool_.reset( new marley::EventPool(std::move(gens),
+    EVENT_POOL_DEPTH) );
 }
 
 void MarleyPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
@@ -61,8 +117,18 @@ void MarleyPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   // Create a new primary vertex at the spacetime origin.
   G4PrimaryVertex* vertex = new G4PrimaryVertex(0., 0., 0., 0.); // x,y,z,t0
 
-  // Generate a new MARLEY event using the owned marley::Generator object
-  marley::Event ev = marley_generator_.create_event();
+  // With the counter-based random number engine, generate the MARLEY event
+  // labeled by the Geant4 event ID. Since event IDs are unique across the
+  // worker threads, this gives each worker independent random numbers.
+  if ( counter_based_ ) {
+    marley_generator_->set_event_number( anEvent->GetEventID() );
+    marley_generator_->create_event( event_ );
+  }
+  // Otherwise, take the next pre-generated event from the pool. This only
+  // waits if event generation has fallen behind tracking.
+  else event_pool_->pop( 0, event_ );
+
+  const marley::Event& ev = event_;
 
   // This line, if uncommented, will print the event in ASCII format
   // to standard output
@@ -73,11 +139,11 @@ void MarleyPrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 
     // Convert each one from a marley::Particle into a G4PrimaryParticle.
     // Do this by first setting the PDG code and the 4-momentum components.
-    G4PrimaryParticle* particle = new G4PrimaryParticle( fp->pdg_code(),
-      fp->px(), fp->py(), fp->pz(), fp->total_energy() );
+    G4PrimaryParticle* particle = new G4PrimaryParticle( fp.pdg_code(),
+      fp.px(), fp.py(), fp.pz(), fp.total_energy() );
 
     // Also set the charge of the G4PrimaryParticle appropriately
-    particle->SetCharge( fp->charge() );
+    particle->SetCharge( fp.charge() );
 
     // Add the fully-initialized G4PrimaryParticle to the primary vertex
     vertex->SetPrimary( particle );
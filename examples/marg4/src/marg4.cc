@@ -19,30 +19,44 @@
 
 // Geant4 includes
 #include "G4PhysListFactory.hh"
-#include "G4RunManager.hh"
+#ifdef G4MULTITHREADED
+  #include "G4MTRunManager.hh"
+#else
+  #include "G4RunManager.hh"
+#endif
 #include "G4VModularPhysicsList.hh"
 
+// MARLEY includes
+#include "marley/StructureDatabase.hh"
+#ifdef USE_ROOT
+  #include "marley/RootJSONConfig.hh"
+#else
+  #include "marley/JSONConfig.hh"
+#endif
+
 // marg4 includes
+#include "ActionInitialization.hh"
 #include "DetectorConstruction.hh"
-#include "MarleyPrimaryGeneratorAction.hh"
-#include "EventAction.hh"
 
 namespace {
 
-  // Retrieves the desired number of events from the first command
-  // line argument. Based on https://stackoverflow.com/a/2797823/4081973
+  // Retrieves a nonnegative integer (e.g., the desired number of events)
+  // from a command line argument. The description is used in error messages.
+  // Based on https://stackoverflow.com/a/2797823/4081973
   // Returns true if everything went well, or false if there was a problem
-  bool get_num_events( const std::string& arg, int& x ) {
+  bool get_count( const std::string& arg, const std::string& description,
+    int& x )
+  {
     try {
       size_t pos;
       x = std::stoi( arg, &pos );
       if ( pos < arg.size() ) {
-        std::cerr << "Trailing characters after number of events: " << arg
-          << '\n';
+        std::cerr << "Trailing characters after " << description << ": "
+          << arg << '\n';
         return false;
       }
       if ( x < 0 ) {
-        std::cerr << "Negative number of events: " << arg << '\n';
+        std::cerr << "Negative " << description << ": " << arg << '\n';
         return false;
       }
     }
@@ -64,19 +78,52 @@ namespace {
 int main( int argc, char* argv[] ) {
 
   if ( argc <= 2 ) {
-    std::cout << "Usage: marg4 NUM_EVENTS MARLEY_CONFIG_FILE\n";
+    std::cout << "Usage: marg4 NUM_EVENTS MARLEY_CONFIG_FILE [NUM_THREADS]\n";
     return 1;
   }
 
   int num_events = 0;
-  bool num_ok = get_num_events( argv[1], num_events );
+  bool num_ok = get_count( argv[1], "number of events", num_events );
   if ( !num_ok ) return 2;
 
   // Retrieve the configuration file name from the command-line argument
   std::string config_file_name( argv[2] );
 
-  // Initialize the Geant4 run manager
+  // Parse the MARLEY configuration file once. The resulting object is shared
+  // read-only by all of the threads. If the USE_ROOT preprocessor macro is
+  // defined, then parse the configuration file using a RootJSONConfig object
+  // to make ROOT-dependent configuration options available (e.g., the use of
+  // a "th1" or "tgraph" neutrino source)
+  #ifdef USE_ROOT
+  std::shared_ptr<const marley::JSONConfig> config
+    = std::make_shared<marley::RootJSONConfig>( config_file_name );
+  #else
+  std::shared_ptr<const marley::JSONConfig> config
+    = std::make_shared<marley::JSONConfig>( config_file_name );
+  #endif
+
+  // Initialize the Geant4 run manager. If Geant4 was built with
+  // multithreading support, then use the number of worker threads given
+  // by the optional third command-line argument (or a single worker thread
+  // if it is omitted).
+  #ifdef G4MULTITHREADED
+  int num_threads = 1;
+  if ( argc > 3 ) {
+    bool threads_ok = get_count( argv[3], "number of threads", num_threads );
+    if ( !threads_ok ) return 3;
+    if ( num_threads == 0 ) {
+      std::cerr << "At least one thread is required\n";
+      return 3;
+    }
+  }
+  std::unique_ptr<G4MTRunManager> rm( new G4MTRunManager );
+  rm->SetNumberOfThreads( num_threads );
+  #else
+  int num_threads = 1;
+  if ( argc > 3 ) std::cerr << "Geant4 was built without multithreading"
+    " support. The number of threads will be ignored.\n";
   std::unique_ptr<G4RunManager> rm( new G4RunManager );
+  #endif
 
   // ** Set mandatory initialization classes **
   // Define the geometry for the simulation
@@ -94,16 +141,15 @@ int main( int argc, char* argv[] ) {
   rm->SetUserInitialization( refList );
 
   // ** Set user actions **
-
-  // The primary generator action interfaces with MARLEY
-  MarleyPrimaryGeneratorAction* mpga
-    = new MarleyPrimaryGeneratorAction( config_file_name );
-  rm->SetUserAction( mpga );
-
-  // The event action prints the current event number at the beginning of
-  // every hundredth event without doing anything else.
-  EventAction* eva = new EventAction;
-  rm->SetUserAction( eva );
+  // These are created for each worker thread by the action initialization.
+  // Each worker thread gets its own MARLEY generator built from the shared
+  // configuration.
+  rm->SetUserInitialization( new ActionInitialization(config, num_threads) );
+
+  // The tables of nuclear fragments and ground-state spin-parities are
+  // shared by all StructureDatabase objects and are loaded lazily. Load
+  // them now, before any worker threads are started.
+  marley::StructureDatabase::fragments();
 
   rm->Initialize();
 
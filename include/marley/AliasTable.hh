@@ -0,0 +1,131 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Discrete probability distribution sampled using Walker's alias
+  /// method
+  /// @details After an O(n) setup step (performed using Vose's algorithm), a
+  /// sample may be drawn in constant time using a single uniform random
+  /// number. The internal storage is retained when the table is rebuilt, so an
+  /// AliasTable that is repeatedly loaded with new weights does not perform
+  /// any memory allocations once it has grown to its largest size. Objects of
+  /// this class may be passed to Generator::sample_from_distribution().
+  class AliasTable {
+
+    public:
+
+      /// @brief Create an empty table
+      AliasTable() {}
+
+      /// @brief Create a table using the weights in the range [begin, end)
+      template<typename It> AliasTable(It begin, It end);
+
+      /// @brief Replace the contents of the table using the weights in the
+      /// range [begin, end)
+      /// @details The weights need not be normalized, but they must all be
+      /// nonnegative. Otherwise, a marley::Error will be thrown. If every
+      /// weight is zero, then the first entry will always be sampled (as is
+      /// done by std::discrete_distribution in libstdc++).
+      template<typename It> void build(It begin, It end);
+
+      /// @brief Sample an index from the table
+      /// @details If the table contains only a single entry, then zero is
+      /// returned without consuming any random numbers.
+      /// @param gen Uniform random bit generator to use for sampling
+      template<class URBG> size_t operator()(URBG& gen) const;
+
+      /// @brief Returns the number of entries in the table
+      inline size_t size() const { return prob_.size(); }
+
+      /// @brief Returns true if the table has not yet been built
+      inline bool empty() const { return prob_.empty(); }
+
+      /// @brief Returns the sum of the weights used to build the table
+      inline double total_weight() const { return total_weight_; }
+
+      /// @brief Removes all entries from the table
+      void clear();
+
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by the table
+      inline size_t memory_usage() const {
+        return prob_.capacity() * sizeof(double) + ( alias_.capacity()
+          + small_.capacity() + large_.capacity() ) * sizeof(size_t);
+      }
+
+    protected:
+
+      /// @brief Helper function that fills prob_ and alias_ using the
+      /// (unnormalized) weights currently stored in prob_
+      void build_tables();
+
+      /// @brief Probability of keeping each column index (rather than
+      /// using its alias)
+      std::vector<double> prob_;
+
+      /// @brief Alias index for each column
+      std::vector<size_t> alias_;
+
+      /// @brief Scratch storage for the indices of underfull columns
+      /// during setup
+      std::vector<size_t> small_;
+
+      /// @brief Scratch storage for the indices of overfull columns
+      /// during setup
+      std::vector<size_t> large_;
+
+      /// @brief Sum of the weights used to build the table
+      double total_weight_ = 0.;
+  };
+
+  // Inline function definitions
+  template<typename It> AliasTable::AliasTable(It begin, It end)
+  {
+    this->build( begin, end );
+  }
+
+  template<typename It> void AliasTable::build(It begin, It end)
+  {
+    prob_.clear();
+    for ( auto it = begin; it != end; ++it ) prob_.push_back( *it );
+    this->build_tables();
+  }
+
+  template<class URBG> size_t AliasTable::operator()(URBG& gen) const
+  {
+    size_t n = prob_.size();
+    if ( n == 1u ) return 0u;
+
+    // Use a single uniform random number to choose both a column and
+    // whether to keep it or take its alias
+    double u = std::generate_canonical<double,
+      std::numeric_limits<double>::digits>( gen ) * n;
+    size_t column = static_cast<size_t>( u );
+    // Guard against round-off (and a known issue with some implementations
+    // of std::generate_canonical that can return exactly one)
+    if ( column >= n ) column = n - 1u;
+
+    if ( u - column < prob_[ column ] ) return column;
+    return alias_[ column ];
+  }
+
+}
@@ -0,0 +1,87 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "marley/MappedFile.hh"
+
+namespace marley {
+
+  /// @brief Memory-mapped table of floating-point numbers stored in a
+  /// binary file
+  /// @details Two formats are understood. Files that begin with the NumPy
+  /// magic string are read as .npy files, which may hold a 1D or 2D array
+  /// of 32- or 64-bit floating-point numbers in either byte order and in
+  /// either C or Fortran order. Any other file is read as a headerless
+  /// sequence of little-endian 64-bit floating-point numbers, stored row by
+  /// row with a fixed number of columns.
+  ///
+  /// The values are read directly from the mapped file, so large tables
+  /// (e.g., tabulated neutrino fluxes) can be used without first being
+  /// converted to text and parsed.
+  class ArrayFile {
+
+    public:
+
+      /// @param file_name Name of the file to map
+      /// @param raw_columns Number of columns in a headerless file (ignored
+      /// for .npy files, which describe their own shape)
+      ArrayFile(const std::string& file_name, size_t raw_columns = 1u);
+
+      /// @brief Number of rows in the table (the length of a 1D array)
+      inline size_t rows() const { return rows_; }
+
+      /// @brief Number of columns in the table (one for a 1D array)
+      inline size_t columns() const { return columns_; }
+
+      /// @brief Get a single value from the table
+      double value(size_t row, size_t column) const;
+
+      /// @brief Get a copy of every value in one column of the table
+      std::vector<double> column(size_t column) const;
+
+    private:
+
+      /// @brief Parses the header of a .npy file and sets the table
+      /// layout accordingly
+      void read_npy_header();
+
+      std::string file_name_;
+      std::unique_ptr<marley::MappedFile> file_;
+
+      /// @brief Pointer to the first value in the table
+      const char* values_ = nullptr;
+
+      size_t rows_ = 0u;
+      size_t columns_ = 1u;
+
+      /// @brief Size of each value (bytes), either 4 or 8
+      size_t item_size_ = sizeof(double);
+
+      /// @brief Whether the byte order of the stored values differs from
+      /// that of the machine
+      bool swap_bytes_ = false;
+
+      /// @brief Whether the table is stored column by column instead of
+      /// row by row
+      bool fortran_order_ = false;
+  };
+
+}
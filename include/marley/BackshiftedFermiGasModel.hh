@@ -53,13 +53,24 @@ namespace marley {
       virtual double level_density(double Ex, int two_J, marley::Parity Pi)
         override;
 
+      /// @copydoc LevelDensityModel::spin_cutoff_squared()
+      virtual double spin_cutoff_squared(double Ex) override;
+
+      /// @copydoc LevelDensityModel::level_density_all_spins()
+      /// @details The spin-independent level density is computed only once,
+      /// and the spin-dependent Gaussian factors are obtained by recurrence
+      /// rather than by calling std::exp() for each spin.
+      virtual void level_density_all_spins(double Ex, marley::Parity Pi,
+        int two_J_min, int two_J_max, marley::ScratchVector<double>& rhos)
+        override;
+
     protected:
 
       /// Helper function used when evaluating the spin cutoff parameter
       inline double compute_sigma_F2(double Ex, double a) {
         double U = Ex - Delta_BFM_;
 
-        double sigma_F2 = 0.01389 * std::pow(A_, 5.0/3.0)
+        double sigma_F2 = 0.01389 * A_five_thirds_
           * std::sqrt(a * U) / a_tilde_;
 
         return sigma_F2;
@@ -70,6 +81,18 @@ namespace marley {
 
       double sigma_; ///< spin cut-off parameter
 
+      /// @brief Excitation energy (MeV) used in the most recent call to
+      /// level_density(double)
+      /// @details Decay width calculations ask for the level density at the
+      /// same excitation energy once for each final-state parity. Since
+      /// parity equipartition is assumed, the result of the previous call is
+      /// simply reused in that case.
+      double cached_Ex_;
+      double cached_rho_; ///< Total level density at cached_Ex_ (MeV<sup> -1</sup>)
+      double cached_sigma_; ///< Spin cut-off parameter at cached_Ex_
+
+      double A_five_thirds_; ///< A<sup>5/3</sup> for this nuclide
+
       double a_tilde_; ///< asymptotic level density parameter (MeV<sup> -1</sup>)
       double gamma_; ///< damping parameter (MeV<sup> -1</sup>)
       double delta_W_; ///< shell correction energy (MeV)
@@ -0,0 +1,238 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "marley/EventBatch.hh"
+
+namespace marley {
+
+  class Event;
+
+  /// @brief Column-oriented storage for a block of events in MARLEY's
+  /// binary output format
+  /// @details A binary event file starts with a fixed-size header (see
+  /// BinaryEventBlock::write_header()). It is followed by a series of
+  /// records, each of which begins with a 32-bit tag. Event blocks are
+  /// written by BinaryEventBlock::write(). A final metadata record holds the
+  /// generator state and job configuration as JSON text.
+  ///
+  /// Within an event block, each quantity is stored as a contiguous column
+  /// of fixed-width values (32-bit integers or IEEE 754 doubles) in the
+  /// same layout used in memory by marley::EventBatch. The event
+  /// columns hold the excitation energy, two times the spin, the parity,
+  /// the numbers of initial and final particles, the weight (starting with
+  /// version 2 of the format), and the time (starting with version 3) for
+  /// each event. The
+  /// particle columns hold the PDG code, the four-momentum, the mass, and
+  /// the charge of every particle in the block. The initial particles of
+  /// each event come first, followed by its final particles. All values
+  /// are little-endian regardless of the host byte order.
+  ///
+  /// Starting with version 4 of the format, the header also records the
+  /// layout of the event blocks. Files that use the kinematics layout hold
+  /// KinematicsBlock records instead. They cannot be read back as
+  /// marley::Event objects.
+  ///
+  /// Starting with version 5, the upper 16 bits of the header's layout
+  /// field give the precision used for the particle kinematics (see
+  /// Precision). Event blocks written using single precision replace the
+  /// total energy, 3-momentum, and mass columns with 32-bit columns for
+  /// the kinetic energy and 3-momentum, followed by the charge column and
+  /// a short list of masses that cannot be obtained from the MassTable.
+  class BinaryEventBlock : public EventBatch {
+
+    public:
+
+      /// @brief Record tags used in binary event files
+      enum class RecordTag : uint32_t { events = 1u, metadata = 2u,
+        kinematics = 3u };
+
+      /// @brief Layouts used for the event records in a binary event file
+      /// @details Files that use the "event" layout store BinaryEventBlock
+      /// records. Those that use the "kinematics" layout store
+      /// KinematicsBlock records.
+      enum class Layout : uint32_t { event = 0u, kinematics = 1u };
+
+      /// @brief Precision used to store the particle kinematics in an
+      /// event block
+      /// @details Single-precision blocks store the kinetic energy and
+      /// 3-momentum of each particle as 32-bit floats, which roughly halves
+      /// the size of a block. Storing the kinetic energy (rather than the
+      /// total energy) keeps the recoil energies of heavy nuclei accurate.
+      /// The masses are looked up in the MassTable using the PDG code and
+      /// charge when the block is read. Any mass that differs from the
+      /// tabulated value (e.g., that of a user-defined dark matter
+      /// particle) is stored explicitly as a double.
+      enum class Precision : uint32_t { full = 0u, single = 1u };
+
+      /// @brief Identifies a MARLEY binary event file
+      static const std::string MAGIC;
+
+      /// @brief Version number for the binary event format
+      static constexpr uint32_t FORMAT_VERSION = 5u;
+
+      /// @brief Number of bytes occupied by the file header
+      static constexpr std::streamoff HEADER_SIZE = 40;
+
+      /// @brief Contents of a binary event file header
+      struct Header {
+        /// @brief Flux-averaged total cross section (MeV<sup> -2</sup>)
+        double flux_avg_tot_xsec = 0.;
+        /// @brief Number of events stored in the file
+        int64_t event_count = 0;
+        /// @brief Position of the metadata record, or zero if there is none
+        uint64_t metadata_position = 0u;
+        /// @brief Version of the binary event format used by the file.
+        /// Files are always written using FORMAT_VERSION, but files
+        /// written using earlier versions may still be read.
+        uint32_t format_version = FORMAT_VERSION;
+        /// @brief Layout of the event records (always Layout::event for
+        /// files written before version 4 of the format)
+        Layout layout = Layout::event;
+        /// @brief Precision of the particle kinematics (always
+        /// Precision::full for files written before version 5 of the
+        /// format)
+        Precision precision = Precision::full;
+      };
+
+      /// @brief Write a file header to a binary stream
+      static void write_header(std::ostream& out, const Header& header);
+
+      /// @brief Read a file header from a binary stream
+      /// @return True if a valid header was read, or false otherwise
+      static bool read_header(std::istream& in, Header& header);
+
+      /// @brief Write a metadata record to a binary stream
+      static void write_metadata(std::ostream& out,
+        const std::string& json_text);
+
+      /// @brief Read the body of a metadata record (after its tag) from a
+      /// binary stream
+      static bool read_metadata(std::istream& in, std::string& json_text);
+
+      /// @brief Read the tag that starts the next record
+      /// @return True if a tag was read, or false otherwise
+      static bool read_tag(std::istream& in, RecordTag& tag);
+
+      /// @brief Write the block (including its record tag) to a binary
+      /// stream
+      /// @param precision Precision to use for the particle kinematics
+      void write(std::ostream& out,
+        Precision precision = Precision::full) const;
+
+      /// @brief Read the body of an event block record (after its tag) from
+      /// a binary stream, replacing the current contents
+      /// @param format_version Version of the format used by the stream.
+      /// Blocks written before version 2 do not store event weights, so
+      /// every event is given unit weight. Those written before version 3
+      /// do not store event times, which are set to zero.
+      /// @param precision Precision of the particle kinematics (taken from
+      /// the file header)
+      /// @return True if the block was read successfully, or false otherwise
+      bool read(std::istream& in, uint32_t format_version = FORMAT_VERSION,
+        Precision precision = Precision::full);
+
+      /// @brief Skip over the body of an event block record (after its tag)
+      /// without loading its contents
+      /// @param[out] num_events Number of events stored in the skipped block
+      /// @param format_version Version of the format used by the stream
+      /// @param precision Precision of the particle kinematics
+      /// @return True if the block header could be read and the stream was
+      /// successfully repositioned, or false otherwise
+      static bool skip(std::istream& in, uint32_t& num_events,
+        uint32_t format_version = FORMAT_VERSION,
+        Precision precision = Precision::full);
+
+    private:
+
+      /// @brief Helper for read() that loads the single-precision particle
+      /// columns (after the PDG codes) and recovers the masses and total
+      /// energies
+      bool read_single_precision(std::istream& in, uint32_t num_particles);
+  };
+
+
+  /// @brief Column-oriented storage for a block of events in the kinematics
+  /// layout of MARLEY's binary output format
+  /// @details This minimal layout keeps only what is needed by most
+  /// detector response studies. The event columns hold the number of final
+  /// particles, the weight, and the time for each event. The particle
+  /// columns hold the PDG code, the total energy, and the 3-momentum of
+  /// every final particle. The initial particles, excitation energy, spin,
+  /// parity, masses, and charges are not stored. The block is written in
+  /// the same way as a BinaryEventBlock, except that its record tag is
+  /// BinaryEventBlock::RecordTag::kinematics.
+  class KinematicsBlock {
+
+    public:
+
+      inline KinematicsBlock() {}
+
+      /// @brief Add the final particles of an event to the end of the
+      /// block
+      void add_event(const marley::Event& ev);
+
+      /// @brief Add the final particles of some of the events stored in an
+      /// EventBatch to the end of the block
+      /// @param batch The batch containing the events to add
+      /// @param first Position in batch of the first event to add
+      /// @param count The number of events to add
+      void append(const marley::EventBatch& batch, size_t first,
+        size_t count);
+
+      /// @brief Get the number of events stored in the block
+      inline size_t size() const { return num_finals_.size(); }
+
+      /// @brief Remove all events from the block
+      /// @details The storage allocated for the columns is retained
+      void clear();
+
+      /// @brief Write the block (including its record tag) to a binary
+      /// stream
+      void write(std::ostream& out) const;
+
+      /// @brief Skip over the body of a kinematics block record (after its
+      /// tag)
+      /// @param[out] num_events Number of events stored in the skipped block
+      /// @return True if the block header could be read and the stream was
+      /// successfully repositioned, or false otherwise
+      static bool skip(std::istream& in, uint32_t& num_events);
+
+    protected:
+
+      /// @name Event columns
+      //@{
+      std::vector<int32_t> num_finals_;
+      std::vector<double> weights_;
+      std::vector<double> times_;
+      //@}
+
+      /// @name Particle columns
+      //@{
+      std::vector<int32_t> pdgs_;
+      std::vector<double> Es_;
+      std::vector<double> pxs_;
+      std::vector<double> pys_;
+      std::vector<double> pzs_;
+      //@}
+  };
+
+}
@@ -0,0 +1,400 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#include "marley/ChebyshevInterpolatingFunction.hh"
+#include "marley/Instrumentation.hh"
+#include "marley/marley_utils.hh"
+
+namespace marley {
+
+  template <size_t N> class ChebyshevCDF;
+
+  /// @brief Approximate representation of a 1D continuous function using a
+  /// fixed number of Chebyshev points
+  /// @details This is a counterpart of ChebyshevInterpolatingFunction for
+  /// grids whose size is known at compile time (e.g.,
+  /// DEFAULT_N_CHEBYSHEV). All of the data are stored inline, so no heap
+  /// allocations are needed, and the loops have fixed trip counts. The
+  /// barycentric weights and the coefficient tables used for integration
+  /// are computed at compile time. The cosines that determine the node
+  /// positions are computed once per grid size. The same arithmetic is used
+  /// as in ChebyshevInterpolatingFunction, so both classes give identical
+  /// results for the same grid size.
+  /// @tparam N Grid size parameter (N + 1 total points)
+  template <size_t N> class ChebyshevInterpolant {
+
+    static_assert( N >= 2u, "A ChebyshevInterpolant needs at least three"
+      " grid points" );
+
+    public:
+
+      /// @brief Number of grid points
+      static constexpr size_t NUM_POINTS = N + 1u;
+
+      /// @param func Any callable object that returns the function value
+      /// at a given x
+      /// @param x_min Lower edge of the grid
+      /// @param x_max Upper edge of the grid
+      template <typename Function> ChebyshevInterpolant(const Function& func,
+        double x_min, double x_max);
+
+      /// @brief Constructor for functions that are evaluated at many points
+      /// with each call
+      /// @details The callable object func(x, y, n) must load y[i] with the
+      /// value of the function at x[i] for i = 0 to n - 1. It is called
+      /// exactly once.
+      template <typename BatchFunction> ChebyshevInterpolant(BatchEvaluation,
+        const BatchFunction& func, double x_min, double x_max);
+
+      /// @brief Approximates the represented function using the barycentric
+      /// formula
+      inline double evaluate(double x) const {
+        return marley::barycentric_interpolate( xs_.data(), fs_.data(),
+          TABLES.weights, NUM_POINTS, x );
+      }
+
+      /// @brief Returns the integral of this function on the interval
+      /// [x_min, x_max]
+      inline double integral() const { return integral_; }
+
+      inline const std::array<double, NUM_POINTS>& chebyshev_coeffs() const
+        { return coeffs_; }
+
+      inline const std::array<double, NUM_POINTS>& Fs() const
+        { return fs_; }
+
+      inline const std::array<double, NUM_POINTS>& Xs() const
+        { return xs_; }
+
+      inline double x_min() const { return x_min_; }
+      inline double x_max() const { return x_max_; }
+
+      /// @brief Returns the CDF obtained by integrating this function
+      inline ChebyshevCDF<N> cdf() const { return ChebyshevCDF<N>( *this ); }
+
+    private:
+
+      template <size_t M> friend class ChebyshevCDF;
+
+      /// @brief Default constructor used by ChebyshevCDF
+      ChebyshevInterpolant() = default;
+
+      /// @brief Tables that depend only on the grid size
+      struct Tables {
+
+        constexpr Tables();
+
+        /// @brief Barycentric weights for each of the grid points
+        double weights[ NUM_POINTS ];
+
+        /// @brief Values of 1 - k<sup>2</sup> used for Clenshaw-Curtis
+        /// quadrature
+        double integral_denoms[ NUM_POINTS ];
+
+        /// @brief Values of (-1)<sup>j + 1</sup> used by cdf()
+        double cdf_signs[ NUM_POINTS ];
+
+        /// @brief Values of j<sup>2</sup> - 1 used by cdf()
+        double cdf_denoms[ NUM_POINTS ];
+      };
+
+      static constexpr Tables TABLES = Tables();
+
+      /// @brief Returns the values of cos(pi*j / N) for j = 0 to N
+      /// @details The table is filled the first time that it is needed.
+      /// The std::cos function is used (rather than a compile-time
+      /// approximation) so that the node positions match those used by
+      /// ChebyshevInterpolatingFunction exactly.
+      static const std::array<double, NUM_POINTS>& cosines();
+
+      /// @brief Loads xs_ with the Chebyshev points on [x_min_, x_max_]
+      void set_points();
+
+      /// @brief Computes integral_ from the Chebyshev coefficients
+      void compute_integral();
+
+      double x_min_; ///< Lower edge of the grid
+      double x_max_; ///< Upper edge of the grid
+      double integral_; ///< Integral of the function on [x_min_, x_max_]
+
+      /// @brief Chebyshev points at which the function was evaluated
+      std::array<double, NUM_POINTS> xs_;
+
+      /// @brief Function values at the grid points
+      std::array<double, NUM_POINTS> fs_;
+
+      /// @brief Coefficients of the Chebyshev expansion of this function
+      std::array<double, NUM_POINTS> coeffs_;
+  };
+
+  /// @brief Cumulative density function obtained by integrating a
+  /// ChebyshevInterpolant
+  /// @details The CDF is represented using one more grid point than the
+  /// PDF. A copy of the PDF and a guide table are kept so that the CDF may
+  /// be inverted efficiently (see inverse_cdf()).
+  template <size_t N> class ChebyshevCDF {
+
+    public:
+
+      /// @brief Approximates the (unnormalized) CDF at x
+      inline double evaluate(double x) const { return cdf_.evaluate( x ); }
+
+      /// @brief Returns the integral of the CDF on the interval
+      /// [x_min, x_max]
+      inline double integral() const { return cdf_.integral(); }
+
+      /// @brief Returns the function whose integral is represented
+      inline const ChebyshevInterpolant<N>& pdf() const { return pdf_; }
+
+      /// @brief Finds the x value at which the normalized CDF equals a given
+      /// probability
+      /// @details The same method is used as in
+      /// ChebyshevInterpolatingFunction::inverse_cdf().
+      /// @param prob Cumulative probability on [0, 1]
+      /// @param tolerance Absolute tolerance on the returned x value
+      double inverse_cdf(double prob, double tolerance) const;
+
+    private:
+
+      template <size_t M> friend class ChebyshevInterpolant;
+
+      /// @brief Integrates the given PDF
+      explicit ChebyshevCDF(const ChebyshevInterpolant<N>& pdf);
+
+      /// @brief Fills inv_xs_, inv_cdfs_, and guide_
+      void build_inverse_table();
+
+      /// @brief Number of grid points used to represent the CDF
+      static constexpr size_t NUM_POINTS = N + 2u;
+
+      ChebyshevInterpolant<N> pdf_;
+      ChebyshevInterpolant<N + 1u> cdf_;
+
+      /// @brief Grid points sorted in ascending order
+      std::array<double, NUM_POINTS> inv_xs_;
+
+      /// @brief Nondecreasing CDF values at each of the points in inv_xs_
+      std::array<double, NUM_POINTS> inv_cdfs_;
+
+      /// @brief Guide table storing, for equally-spaced probabilities, the
+      /// index of the last entry in inv_cdfs_ that does not exceed them
+      std::array<size_t, NUM_POINTS> guide_;
+  };
+
+  // Inline function definitions
+  template <size_t N> constexpr ChebyshevInterpolant<N>::Tables::Tables()
+    : weights{}, integral_denoms{}, cdf_signs{}, cdf_denoms{}
+  {
+    // The barycentric weights for Chebyshev points of the second kind
+    // alternate in sign and are halved at the two endpoints
+    for ( size_t j = 0u; j < NUM_POINTS; ++j ) {
+      double sign = ( j % 2u == 0u ) ? 1. : -1.;
+      weights[ j ] = ( j == 0u || j == N ) ? sign / 2. : sign;
+      integral_denoms[ j ] = 1. - static_cast<double>( j * j );
+      cdf_signs[ j ] = -sign;
+      cdf_denoms[ j ] = j*j - 1.0;
+    }
+  }
+
+  template <size_t N> constexpr typename ChebyshevInterpolant<N>::Tables
+    ChebyshevInterpolant<N>::TABLES;
+
+  template <size_t N> const std::array<double,
+    ChebyshevInterpolant<N>::NUM_POINTS>& ChebyshevInterpolant<N>::cosines()
+  {
+    static const std::array<double, NUM_POINTS> the_cosines = []() {
+      std::array<double, NUM_POINTS> result;
+      for ( size_t j = 0u; j < NUM_POINTS; ++j ) {
+        result[ j ] = std::cos( static_cast<double>(marley_utils::pi * j)
+          / N );
+      }
+      return result;
+    }();
+    return the_cosines;
+  }
+
+  template <size_t N> void ChebyshevInterpolant<N>::set_points() {
+    const auto& cosines = ChebyshevInterpolant<N>::cosines();
+    for ( size_t j = 0u; j < NUM_POINTS; ++j ) {
+      // Affine transformation from [-1, 1] to [x_min_, x_max_]
+      xs_[ j ] = ( ( x_max_ - x_min_ )*cosines[ j ] + ( x_max_ + x_min_ ) )
+        / 2.;
+    }
+  }
+
+  template <size_t N> void ChebyshevInterpolant<N>::compute_integral() {
+    // Compute the integral over [x_min_, x_max_] via Clenshaw-Curtis
+    // quadrature. Only even Chebyshev polynomials contribute.
+    integral_ = 0.;
+    for ( size_t k = 0u; k <= N; k += 2u ) {
+      double term = coeffs_[ k ] * 2.0 / TABLES.integral_denoms[ k ];
+      if ( k == 0u || k == N ) term /= 2.;
+      integral_ += term;
+    }
+    integral_ *= ( x_max_ - x_min_ ) / 2.;
+  }
+
+  template <size_t N> template <typename Function>
+    ChebyshevInterpolant<N>::ChebyshevInterpolant(const Function& func,
+    double x_min, double x_max) : ChebyshevInterpolant( BATCH_EVALUATION,
+    [&func](const double* x, double* y, size_t n) -> void {
+      for ( size_t i = 0u; i < n; ++i ) y[ i ] = func( x[ i ] );
+    }, x_min, x_max ) {}
+
+  template <size_t N> template <typename BatchFunction>
+    ChebyshevInterpolant<N>::ChebyshevInterpolant(BatchEvaluation,
+    const BatchFunction& func, double x_min, double x_max)
+    : x_min_( x_min ), x_max_( x_max )
+  {
+    marley::Instrumentation::ScopedTimer timer(
+      marley::Instrumentation::Probe::ChebyshevConstruction );
+
+    set_points();
+    func( xs_.data(), fs_.data(), NUM_POINTS );
+
+    // Find the Chebyshev coefficients and normalize them by dividing by N
+    coeffs_ = fs_;
+    marley::chebyshev_cosine_transform( coeffs_.data(), NUM_POINTS );
+    for ( double& c : coeffs_ ) c /= N;
+
+    compute_integral();
+
+    marley::Instrumentation::add_value(
+      marley::Instrumentation::Probe::ChebyshevConstruction, N );
+  }
+
+  template <size_t N> ChebyshevCDF<N>::ChebyshevCDF(
+    const ChebyshevInterpolant<N>& pdf) : pdf_( pdf )
+  {
+    const auto& a = pdf.coeffs_;
+    const auto& tables = ChebyshevInterpolant<N>::TABLES;
+    auto& beta = cdf_.coeffs_;
+
+    cdf_.x_min_ = pdf.x_min_;
+    cdf_.x_max_ = pdf.x_max_;
+
+    // Integrate the Chebyshev series term by term
+    double beta_0 = a[ 0 ];
+    beta_0 += -0.5 * a[ 1 ];
+    for ( size_t j = 2u; j <= N; ++j ) {
+      beta_0 += 2.*a[ j ] * tables.cdf_signs[ j ] / tables.cdf_denoms[ j ];
+    }
+    beta[ 0 ] = beta_0;
+    for ( size_t k = 1u; k < N; ++k ) {
+      beta[ k ] = ( a[ k - 1u ] - a[ k + 1u ] ) / ( 2 * k );
+    }
+    beta[ N ] = a[ N - 1u ] / ( 2 * N );
+    beta[ N + 1u ] = a[ N ] / ( 2 * (N + 1u) );
+
+    for ( double& b : beta ) b *= ( cdf_.x_max_ - cdf_.x_min_ ) / 2.;
+
+    cdf_.compute_integral();
+    cdf_.set_points();
+
+    cdf_.fs_ = beta;
+    marley::chebyshev_cosine_transform( cdf_.fs_.data(), NUM_POINTS );
+    for ( double& f : cdf_.fs_ ) f *= 0.5;
+
+    build_inverse_table();
+  }
+
+  template <size_t N> void ChebyshevCDF<N>::build_inverse_table() {
+
+    // The Chebyshev points are stored in descending order, so reverse them.
+    // Enforce monotonicity of the tabulated CDF values (small violations can
+    // occur due to the polynomial approximation).
+    const auto& xs = cdf_.xs_;
+    const auto& fs = cdf_.fs_;
+    double running_max = 0.;
+    for ( size_t i = 0u; i < NUM_POINTS; ++i ) {
+      size_t j = NUM_POINTS - 1u - i;
+      inv_xs_[ i ] = xs[ j ];
+      running_max = std::max( running_max, fs[ j ] );
+      inv_cdfs_[ i ] = running_max;
+    }
+    inv_xs_.front() = cdf_.x_min_;
+    inv_xs_.back() = cdf_.x_max_;
+    inv_cdfs_.front() = 0.;
+
+    // Build the guide table using one entry per grid point
+    double norm = inv_cdfs_.back();
+    size_t i = 0u;
+    for ( size_t k = 0u; k < NUM_POINTS; ++k ) {
+      double c = norm * k / NUM_POINTS;
+      while ( i + 2u < NUM_POINTS && inv_cdfs_[ i + 1u ] <= c ) ++i;
+      guide_[ k ] = i;
+    }
+  }
+
+  template <size_t N> double ChebyshevCDF<N>::inverse_cdf(double prob,
+    double tolerance) const
+  {
+    if ( prob <= 0. ) return cdf_.x_min_;
+    else if ( prob >= 1. ) return cdf_.x_max_;
+
+    // Find the grid interval containing the target CDF value using the
+    // guide table
+    double norm = inv_cdfs_.back();
+    double target = prob * norm;
+
+    size_t k = std::min( static_cast<size_t>(prob * NUM_POINTS),
+      NUM_POINTS - 1u );
+    size_t i = guide_[ k ];
+    constexpr size_t LAST = NUM_POINTS - 2u;
+    while ( i < LAST && inv_cdfs_[ i + 1u ] <= target ) ++i;
+
+    double a = inv_xs_[ i ];
+    double b = inv_xs_[ i + 1u ];
+    double ca = inv_cdfs_[ i ];
+    double cb = inv_cdfs_[ i + 1u ];
+
+    // Initial guess from linear interpolation between the grid points
+    double x = a;
+    if ( cb > ca ) x = a + ( b - a ) * ( target - ca ) / ( cb - ca );
+
+    // Refine the guess using Newton's method, falling back to bisection
+    // whenever a step would leave the bracketing interval
+    constexpr int MAX_ITERATIONS = 100;
+    for ( int iter = 0; iter < MAX_ITERATIONS; ++iter ) {
+
+      double residual = cdf_.evaluate( x ) - target;
+      if ( residual == 0. ) return x;
+      else if ( residual > 0. ) b = x;
+      else a = x;
+
+      double deriv = pdf_.evaluate( x );
+      double x_new;
+      if ( deriv > 0. ) x_new = x - residual / deriv;
+      else x_new = a - 1.; // Force bisection
+
+      if ( x_new <= a || x_new >= b ) x_new = ( a + b ) / 2.;
+
+      if ( std::abs( x_new - x ) <= tolerance || ( b - a ) <= tolerance ) {
+        return x_new;
+      }
+      x = x_new;
+    }
+
+    return x;
+  }
+
+}
@@ -15,9 +15,12 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <cmath>
 #include <functional>
+#include <memory>
 #include <vector>
 
+#include "marley/Instrumentation.hh"
 #include "marley/marley_utils.hh"
 
 namespace marley {
@@ -25,40 +28,100 @@ namespace marley {
   // Default Chebyshev grid size to use (when not using adaptive sizing)
   constexpr size_t DEFAULT_N_CHEBYSHEV = 64u;
 
+  /// @brief Tag type used to select the constructor of
+  /// ChebyshevInterpolatingFunction that accepts a batched function
+  struct BatchEvaluation {};
+
+  /// @brief Tag value used to select the constructor of
+  /// ChebyshevInterpolatingFunction that accepts a batched function
+  constexpr BatchEvaluation BATCH_EVALUATION = BatchEvaluation();
+
+  /// @brief Replaces the n values in data with their discrete cosine
+  /// transform (as computed by FFTPACK4)
+  void chebyshev_cosine_transform(double* data, size_t n);
+
+  /// @brief Evaluates a polynomial interpolant using the barycentric formula
+  /// @param xs Chebyshev points at which the function was evaluated
+  /// @param fs Function values at the points
+  /// @param ws Barycentric weights for each of the points
+  /// @param num_points Length of the xs, fs, and ws arrays
+  /// @param x Point at which the interpolant will be evaluated
+  inline double barycentric_interpolate(const double* xs, const double* fs,
+    const double* ws, size_t num_points, double x)
+  {
+    // The sums are accumulated in several independent lanes. This
+    // shortens the dependency chain and allows the compiler to use SIMD
+    // instructions for the main loop.
+    constexpr size_t LANES = 4u;
+    double numer[ LANES ] = { 0. };
+    double denom[ LANES ] = { 0. };
+
+    size_t j = 0u;
+    for ( ; j + LANES <= num_points; j += LANES ) {
+      for ( size_t k = 0u; k < LANES; ++k ) {
+        double temp = ws[ j + k ] / ( x - xs[ j + k ] );
+        denom[ k ] += temp;
+        numer[ k ] += temp * fs[ j + k ];
+      }
+    }
+    for ( ; j < num_points; ++j ) {
+      double temp = ws[ j ] / ( x - xs[ j ] );
+      denom[ 0 ] += temp;
+      numer[ 0 ] += temp * fs[ j ];
+    }
+
+    double px = ( ( numer[0] + numer[1] ) + ( numer[2] + numer[3] ) )
+      / ( ( denom[0] + denom[1] ) + ( denom[2] + denom[3] ) );
+
+    // If the requested x value is exactly equal to one of the grid points
+    // where we previously evaluated the function, then the sums above
+    // will have overflowed. In that case, just return the stored value.
+    if ( !std::isfinite(px) ) {
+      for ( size_t i = 0u; i < num_points; ++i ) {
+        if ( xs[ i ] == x ) return fs[ i ];
+      }
+    }
+
+    return px;
+  }
+
   /// @brief Approximate representation of a 1D continuous function
+  /// @details See ChebyshevInterpolant for a fixed-size version that avoids
+  /// heap allocations
   class ChebyshevInterpolatingFunction {
 
     public:
 
-      // N = 0 triggers adaptive grid sizing
-      ChebyshevInterpolatingFunction(const std::function<double(double)>& func,
+      // N = 0 triggers adaptive grid sizing. Any callable object (including
+      // a std::function<double(double)>) may be used for func. Passing a
+      // lambda directly allows it to be inlined into the node evaluations.
+      template <typename Function>
+        ChebyshevInterpolatingFunction(const Function& func,
         double x_min, double x_max, size_t N = 0);
 
+      /// @brief Constructor for functions that are evaluated at many points
+      /// with each call
+      /// @details The callable object func(x, y, n) must load y[i] with the
+      /// value of the function at x[i] for i = 0 to n - 1. It is called
+      /// once for each grid size tried, which allows it to share any setup
+      /// work among all of the points.
+      template <typename BatchFunction>
+        ChebyshevInterpolatingFunction(BatchEvaluation,
+        const BatchFunction& func, double x_min, double x_max, size_t N = 0);
+
       /// @brief Approximates the represented function using the barycentric
       /// formula
       inline double evaluate(double x) const {
-        double numer = 0.;
-        double denom = 0.;
-        double w_j = -1.;
-        for ( size_t j = 0; j <= N_; ++j ) {
-          w_j = -w_j; // w_j = (-1)^(j)
-          double x_j = Xs_.at( j );
-          double f_j = Fs_.at( j );
-          // If the requested x value is exactly equal to one
-          // of the grid points where we previously evaluated the
-          // function, then just return that
-          if ( x_j == x ) return f_j;
-
-          double temp = w_j / ( x - x_j );
-          if ( j == 0 || j == N_ ) temp /= 2.;
-          denom += temp;
-          numer += temp * f_j;
-        }
-
-        double px = numer / denom;
-        return px;
+        return marley::barycentric_interpolate( Xs_.data(), Fs_.data(),
+          Ws_.data(), N_ + 1, x );
       }
 
+      /// @brief Evaluates the represented function at each of n points
+      /// @param[in] x Array of points at which to evaluate the function
+      /// @param[out] out Array that will be loaded with the function values
+      /// @param n Length of the x and out arrays
+      void evaluate_batch(const double* x, double* out, size_t n) const;
+
       // @brief Returns the integral of this function on the interval [x_min_,
       // x_max_]
       inline double integral() const { return integral_; };
@@ -76,6 +139,24 @@ namespace marley {
 
       ChebyshevInterpolatingFunction cdf() const;
 
+      /// @brief Returns true if this object was created by cdf() and can
+      /// therefore be inverted using inverse_cdf()
+      inline bool has_inverse_table() const { return bool( pdf_ ); }
+
+      /// @brief For an object created by cdf(), finds the x value at which
+      /// the normalized CDF equals a given probability
+      /// @details A guide table built from the CDF values at the grid points
+      /// is used to find a bracketing interval, and the result is refined
+      /// using safeguarded Newton steps with the PDF as the derivative.
+      /// A marley::Error will be thrown if has_inverse_table() is false.
+      /// @param prob Cumulative probability on [0, 1]
+      /// @param tolerance Absolute tolerance on the returned x value
+      double inverse_cdf(double prob, double tolerance) const;
+
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by this object (including the PDF kept by a CDF)
+      size_t memory_usage() const;
+
     protected:
 
       /// @brief Default constructor used by cdf()
@@ -102,13 +183,29 @@ namespace marley {
       /// @brief Function values at the grid points
       std::vector<double> Fs_;
 
+      /// @brief Barycentric weights for each of the grid points
+      std::vector<double> Ws_;
+
+      /// @brief For an object created by cdf(), the function whose integral
+      /// it represents (used for Newton steps in inverse_cdf())
+      std::shared_ptr<const ChebyshevInterpolatingFunction> pdf_;
+
+      /// @brief Grid points sorted in ascending order (used by inverse_cdf())
+      std::vector<double> inv_xs_;
+
+      /// @brief Nondecreasing CDF values at each of the points in inv_xs_
+      std::vector<double> inv_cdfs_;
+
+      /// @brief Guide table storing, for equally-spaced probabilities, the
+      /// index of the last entry in inv_cdfs_ that does not exceed them
+      std::vector<size_t> guide_;
+
       /// @brief Coefficients of the Chebyshev expansion of this function
+      /// @details These are calculated using discrete cosine transforms from
+      /// FFTPACK4. The helper arrays that it needs for each transform size
+      /// are cached and shared by all objects.
       std::vector<double> chebyshev_coeffs_;
 
-      // Helper arrays for discrete cosine transforms calculated using FFTPACK4
-      std::vector<double> wsave_;
-      std::vector<int> ifac_;
-
       /// @brief For a given N, returns the x position of the
       /// jth Chebyshev point (of the second kind)
       /// @todo If needed for speed, consider caching the std::cos evaluations
@@ -122,6 +219,107 @@ namespace marley {
       }
 
       void compute_integral();
+
+      /// @brief Computes the Chebyshev coefficients from the current function
+      /// values Fs_
+      /// @return True if the coefficients have converged (or the maximum
+      /// grid size has been reached), or false otherwise
+      bool compute_coefficients();
+
+      /// @brief Helper function that finishes construction of the object once
+      /// the grid size has been chosen
+      void finish_construction();
+
+      /// @brief Fills Ws_ using the barycentric weights for the current
+      /// grid size
+      void compute_weights();
+
+      /// @brief Fills inv_xs_, inv_cdfs_, and guide_ for use by
+      /// inverse_cdf()
+      void build_inverse_table();
   };
 
+  // Inline function definitions
+  template <typename Function>
+    ChebyshevInterpolatingFunction::ChebyshevInterpolatingFunction(
+    const Function& func, double x_min, double x_max, size_t N)
+    : ChebyshevInterpolatingFunction( BATCH_EVALUATION,
+      [&func](const double* x, double* y, size_t n) -> void {
+        for ( size_t i = 0u; i < n; ++i ) y[ i ] = func( x[ i ] );
+      }, x_min, x_max, N ) {}
+
+  template <typename BatchFunction>
+    ChebyshevInterpolatingFunction::ChebyshevInterpolatingFunction(
+    BatchEvaluation, const BatchFunction& func, double x_min, double x_max,
+    size_t N) : x_min_( x_min ), x_max_( x_max )
+  {
+    marley::Instrumentation::ScopedTimer timer(
+      marley::Instrumentation::Probe::ChebyshevConstruction );
+
+    bool ok;
+
+    if ( N != 0 ) {
+      ok = true;
+      N_ = N;
+    }
+    else {
+      ok = false;
+      N_ = 1;
+    }
+
+    // Adaptively find a good grid size by doubling N until the highest
+    // Chebyshev coefficients become negligible. The points used for a given
+    // value of N are the even-indexed points for 2N, so the function values
+    // found at them in the previous iteration are reused.
+    size_t prev_N = 0u;
+
+    // Storage for the new points (and the function values there) added by
+    // each doubling of the grid size
+    std::vector<double> new_xs;
+    std::vector<double> new_fs;
+
+    do {
+
+      if ( !ok ) N_ *= 2;
+
+      Xs_.resize( N_ + 1 );
+      Fs_.resize( N_ + 1 );
+
+      if ( prev_N > 0u ) {
+        // Move the old values to their new positions, working backwards so
+        // that none are overwritten before they have been moved
+        for ( size_t j = prev_N; j > 0u; --j ) {
+          Xs_[ 2*j ] = Xs_[ j ];
+          Fs_[ 2*j ] = Fs_[ j ];
+        }
+
+        // Gather the new odd-indexed points so that the function may be
+        // evaluated at all of them using a single call
+        size_t num_new = N_ / 2;
+        new_xs.resize( num_new );
+        new_fs.resize( num_new );
+        for ( size_t k = 0u; k < num_new; ++k ) {
+          size_t j = 2*k + 1;
+          Xs_[ j ] = chebyshev_point( j );
+          new_xs[ k ] = Xs_[ j ];
+        }
+        func( new_xs.data(), new_fs.data(), num_new );
+        for ( size_t k = 0u; k < num_new; ++k ) Fs_[ 2*k + 1 ] = new_fs[ k ];
+      }
+      else {
+        for ( size_t j = 0; j <= N_; ++j ) Xs_[ j ] = chebyshev_point( j );
+        func( Xs_.data(), Fs_.data(), N_ + 1 );
+      }
+      prev_N = N_;
+
+      if ( compute_coefficients() ) ok = true;
+
+    } while ( !ok );
+
+    marley::Instrumentation::add_value(
+      marley::Instrumentation::Probe::ChebyshevConstruction, N_ );
+
+    finish_construction();
+  }
+
 }
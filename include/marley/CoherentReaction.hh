@@ -0,0 +1,156 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <memory>
+#include <string>
+
+#include "marley/Event.hh"
+#include "marley/Parity.hh"
+#include "marley/Reaction.hh"
+#include "marley/TargetAtom.hh"
+
+namespace marley {
+
+  class Generator;
+  class NuclearReaction;
+
+  /// @brief Coherent elastic neutrino-nucleus scattering (CEvNS)
+  /// @details This class handles the same physics as a NuclearReaction whose
+  /// only matrix element is a ground-state-to-ground-state Fermi transition
+  /// for an NC process, but it uses closed-form expressions throughout.
+  /// The total cross section is computed directly, the recoil is sampled
+  /// by inverting its cumulative distribution, and the residue is always
+  /// left in its ground state (so no de-excitation cascade is needed). For
+  /// high-statistics studies, sample_recoil() bypasses the creation of a
+  /// full marley::Event entirely. A Helm nuclear form factor may optionally
+  /// be included.
+  class CoherentReaction : public marley::Reaction {
+
+    public:
+
+      /// @brief Nuclear form factor to include in the cross section
+      enum class FormFactor { NONE, HELM };
+
+      /// @brief Compact record of a single sampled CEvNS interaction
+      /// @details All quantities are given in the lab frame, with the polar
+      /// angle measured relative to the projectile direction
+      struct Recoil {
+        double KEa; ///< Projectile kinetic energy (MeV)
+        double KE_recoil; ///< Nuclear recoil kinetic energy (MeV)
+        double cos_theta_recoil; ///< Nuclear recoil polar angle cosine
+        double phi_recoil; ///< Nuclear recoil azimuthal angle (radians)
+      };
+
+      /// @param pdg_a Projectile PDG code
+      /// @param pdg_b Target PDG code
+      /// @param strength The NC B(F) value for the ground-state transition
+      CoherentReaction(int pdg_a, int pdg_b, double strength);
+
+      /// @brief Creates a CoherentReaction equivalent to a NuclearReaction
+      /// that describes pure CEvNS
+      /// @return A CoherentReaction object, or nullptr if nr is not an NC
+      /// reaction with a single ground-state Fermi matrix element
+      static std::unique_ptr<CoherentReaction> from_nuclear_reaction(
+        const marley::NuclearReaction& nr);
+
+      inline virtual marley::TargetAtom atomic_target() const override final
+        { return marley::TargetAtom( pdg_b_ ); }
+
+      /// @brief Total cross section (MeV<sup> -2</sup>)
+      virtual double total_xs(int pdg_a, double KEa) const override;
+
+      /// @brief Dark matter absorption does not proceed via CEvNS, so this
+      /// always returns zero
+      virtual double total_xs(int pdg_a, double KEa, double dm_mass,
+        double UV_cutoff, double dm_velocity
+        = marley_utils::DM_DEFAULT_VELOCITY) const override;
+
+      /// @brief Differential cross section
+      /// @f$d\sigma/d\cos\theta_{c}^{\mathrm{CM}}@f$ (MeV<sup> -2</sup>)
+      virtual double diff_xs(int pdg_a, double KEa, double cos_theta_c_cm)
+        const override;
+
+      virtual marley::Event create_event(int pdg_a, double KEa,
+        marley::Generator& gen) const override;
+
+      virtual marley::Event create_event(int pdg_a, double KEa,
+        double dm_mass, double dm_velocity, double dm_cutoff,
+        marley::Generator& gen) const override;
+
+      virtual void create_event(int pdg_a, double KEa,
+        marley::Generator& gen, marley::Event& ev) const override;
+
+      using marley::Reaction::create_event;
+
+      /// @brief Samples a single interaction without creating an Event
+      /// @param KEa Lab-frame projectile kinetic energy (MeV)
+      /// @param gen Reference to the Generator to use for random sampling
+      Recoil sample_recoil(double KEa, marley::Generator& gen) const;
+
+      inline virtual double threshold_kinetic_energy() const override
+        { return 0.; }
+
+      /// @brief Returns the nuclear form factor in use
+      inline FormFactor form_factor() const { return form_factor_; }
+
+      /// @brief Sets the nuclear form factor to use
+      inline void set_form_factor( FormFactor ff ) { form_factor_ = ff; }
+
+      /// @brief Evaluates the square of the nuclear form factor
+      /// @param q2 Squared three-momentum transfer (MeV<sup>2</sup>)
+      double form_factor_squared(double q2) const;
+
+      /// Convert a string to a FormFactor value
+      static FormFactor form_factor_from_string( const std::string& str );
+
+    protected:
+
+      /// @brief Samples a CM frame scattering cosine for the ejectile
+      /// @param beta_c_cm Speed of the ejectile in the CM frame
+      /// @param pc_cm Ejectile 3-momentum magnitude (MeV) in the CM frame
+      /// @param gen Reference to the Generator to use for random sampling
+      double sample_cos_theta_c_cm(double beta_c_cm, double pc_cm,
+        marley::Generator& gen) const;
+
+      /// @brief Cross section without the form factor (MeV<sup> -2</sup>)
+      /// @param[out] beta_c_cm Speed of the ejectile in the CM frame
+      /// @param[out] pc_cm Ejectile 3-momentum magnitude (MeV) in the CM
+      /// frame
+      double point_total_xs(double KEa, double& beta_c_cm, double& pc_cm)
+        const;
+
+      /// @brief Product of the B(F) value and @f$Q_W^2 / 4@f$, where
+      /// @f$Q_W@f$ is the weak nuclear charge of the target
+      double strength_factor_;
+
+      /// @brief Nuclear form factor to include in the cross section
+      FormFactor form_factor_ = FormFactor::NONE;
+
+      /// @brief Helm form factor diffraction radius (MeV<sup> -1</sup>)
+      double helm_R0_;
+
+      /// @brief Helm form factor surface thickness (MeV<sup> -1</sup>)
+      double helm_s_;
+
+      /// @brief Two times the ground-state spin of the target
+      int twoJ_gs_;
+
+      /// @brief Ground-state parity of the target
+      marley::Parity P_gs_;
+  };
+
+}
@@ -0,0 +1,135 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <streambuf>
+#include <vector>
+
+// Opaque Zstandard context types (defined in zstd.h)
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+namespace marley {
+
+  /// @brief Stream buffer that compresses all characters written to it
+  /// using the Zstandard algorithm and forwards the compressed data to
+  /// another stream buffer
+  /// @details Compressed output files are made of one or more complete
+  /// Zstandard frames, so they may be inspected using the standard zstd
+  /// command-line tool. This class is only functional if MARLEY was built
+  /// with Zstandard support (see compression_available()).
+  class CompressingStreamBuf : public std::streambuf {
+
+    public:
+
+      /// @param sink Stream buffer that will receive the compressed data
+      /// @param level Zstandard compression level. A value of zero selects
+      /// the library's default level.
+      CompressingStreamBuf(std::streambuf* sink, int level = 0);
+
+      /// @brief Ends the current frame (if any) before destruction
+      virtual ~CompressingStreamBuf();
+
+      CompressingStreamBuf(const CompressingStreamBuf&) = delete;
+      CompressingStreamBuf& operator=(const CompressingStreamBuf&) = delete;
+
+      /// @brief Compresses all pending input and ends the current frame
+      /// @details Any characters written afterwards will begin a new frame.
+      /// @return True if all of the compressed data were accepted by the
+      /// sink stream buffer, or false otherwise
+      bool finish();
+
+    protected:
+
+      virtual int_type overflow(int_type ch) override;
+
+      /// @brief Flushes all pending input through the compressor and
+      /// synchronizes the sink stream buffer
+      virtual int sync() override;
+
+    private:
+
+      /// @brief Compresses the contents of the put area and writes the
+      /// result to the sink
+      /// @param end_directive ZSTD_EndDirective value to use
+      bool compress(int end_directive);
+
+      std::streambuf* sink_;
+      ZSTD_CCtx_s* cctx_ = nullptr;
+      std::vector<char> in_buffer_;
+      std::vector<char> out_buffer_;
+
+      /// @brief Whether the current frame has received data that have not
+      /// yet been terminated by finish()
+      bool frame_open_ = false;
+  };
+
+  /// @brief Stream buffer that decompresses Zstandard-compressed data read
+  /// from another stream buffer
+  /// @details Seeking is supported only for returning to the start of the
+  /// data (as done by marley::EventFileReader while determining the file
+  /// format) and for querying the current uncompressed position.
+  class DecompressingStreamBuf : public std::streambuf {
+
+    public:
+
+      /// @param source Stream buffer that holds the compressed data
+      DecompressingStreamBuf(std::streambuf* source);
+
+      virtual ~DecompressingStreamBuf();
+
+      DecompressingStreamBuf(const DecompressingStreamBuf&) = delete;
+      DecompressingStreamBuf& operator=(const DecompressingStreamBuf&)
+        = delete;
+
+      /// @brief Returns true if the data held by a stream buffer begin with
+      /// a Zstandard frame header
+      /// @details The position of the stream buffer is reset to the start
+      /// of the data before returning.
+      static bool is_compressed(std::streambuf& source);
+
+    protected:
+
+      virtual int_type underflow() override;
+
+      virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which = std::ios_base::in) override;
+
+      virtual pos_type seekpos(pos_type pos,
+        std::ios_base::openmode which = std::ios_base::in) override;
+
+    private:
+
+      std::streambuf* source_;
+      ZSTD_DCtx_s* dctx_ = nullptr;
+      std::vector<char> in_buffer_;
+      std::vector<char> out_buffer_;
+
+      /// @brief Number of compressed bytes currently held in in_buffer_
+      size_t in_size_ = 0u;
+      /// @brief Index of the next compressed byte to decompress
+      size_t in_pos_ = 0u;
+
+      /// @brief Number of decompressed characters that preceded the
+      /// current contents of the get area
+      std::streamoff out_offset_ = 0;
+  };
+
+  /// @brief Returns true if MARLEY was built with support for compressed
+  /// output files, or false otherwise
+  bool compression_available();
+
+}
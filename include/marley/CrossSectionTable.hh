@@ -0,0 +1,85 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Total (and optionally per-level) cross sections for a single
+  /// Reaction tabulated on a grid of projectile kinetic energies
+  /// @details Tables are written in a compact binary format by the mardumpxs
+  /// tool. A file may hold tables for any number of reactions. Tables that
+  /// include the per-level values for a NuclearReaction may be loaded
+  /// directly as its cross section table (see
+  /// NuclearReaction::use_xs_table()).
+  struct CrossSectionTable {
+
+    std::string description; ///< Reaction description string
+    int pdg_a = 0; ///< PDG code for the projectile
+    int pdg_b = 0; ///< PDG code for the target
+    int pdg_c = 0; ///< PDG code for the ejectile
+    int pdg_d = 0; ///< PDG code for the residue
+
+    /// @brief Projectile kinetic energies (MeV) in increasing order
+    std::vector<double> KEs;
+
+    /// @brief Total cross section (MeV<sup> -2</sup>) at each energy
+    std::vector<double> totals;
+
+    /// @brief Excitation energy (MeV) of each final nuclear level, or empty
+    /// if the per-level cross sections are not stored
+    std::vector<double> level_energies;
+
+    /// @brief Partial cross section (MeV<sup> -2</sup>) to each level
+    /// @details Entry i * level_energies.size() + j holds the value for
+    /// level j at KEs[i]
+    std::vector<double> level_xsecs;
+
+    /// @brief Returns true if the per-level cross sections are stored
+    inline bool has_levels() const { return !level_xsecs.empty(); }
+
+    /// @brief Writes this table to a binary stream
+    void write(std::ostream& out) const;
+
+    /// @brief Reads a table written by write()
+    /// @return True if a valid table was read, or false otherwise
+    bool read(std::istream& in);
+
+    /// @brief Writes a set of tables to a binary file, replacing any
+    /// existing contents
+    static void save(const std::string& file_name,
+      const std::vector<CrossSectionTable>& tables);
+
+    /// @brief Loads all of the tables from a file written by save()
+    /// @details If the file cannot be read, is invalid, or was written by a
+    /// different version of MARLEY, then a warning is logged and no tables
+    /// are loaded.
+    /// @param file_name Name of the file to read
+    /// @param[out] tables Loaded with the tables stored in the file
+    /// @return True if the tables were loaded successfully, or false
+    /// otherwise
+    static bool load(const std::string& file_name,
+      std::vector<CrossSectionTable>& tables);
+
+    /// @brief Version number for the binary file format
+    static constexpr uint32_t FORMAT_VERSION = 1u;
+  };
+
+}
@@ -19,6 +19,7 @@
 #include <memory>
 #include <vector>
 
+#include "marley/AliasTable.hh"
 #include "marley/Level.hh"
 
 namespace marley {
@@ -67,6 +68,9 @@ namespace marley {
 
       /// @brief Gets a pointer to the Level in the DecayScheme
       /// whose excitation energy is closest to E_level
+      /// @details The first call builds a bucket index over the level
+      /// energies (see build_level_index()) that is used for all later
+      /// lookups until another level is added.
       /// @param E_level excitation energy (MeV)
       /// @note Returns nullptr if the DecayScheme doesn't own any Level
       /// objects
@@ -74,7 +78,12 @@ namespace marley {
 
       /// @brief Simulates nuclear de-excitation via &gamma;-ray emission(s)
       /// @details Gamma-rays will be randomly emitted until the nucleus
-      /// reaches its ground state.
+      /// reaches its ground state. The first call builds a flat copy of the
+      /// level and &gamma;-ray data that is used for all later cascades, so
+      /// the levels should not be modified (except via add_level() or
+      /// read_from_stream()) afterwards. If cascade path tables are enabled
+      /// (see set_cascade_path_tolerance()), the whole cascade is usually
+      /// chosen using a single random draw.
       /// @param[in] initial_level Reference to the first level that will
       /// de-excite via &gamma;-ray emission
       /// @param[in,out] event Reference to an Event object that will store
@@ -100,6 +109,18 @@ namespace marley {
       /// is the same as the output format in DecayScheme::print()
       void read_from_stream(std::istream& in);
 
+      /// @brief Write this DecayScheme object to a binary stream
+      /// @details The data are the same as those written by
+      /// DecayScheme::print(), but they can be read back much more quickly
+      /// using read_from_binary_stream().
+      void write_binary(std::ostream& out) const;
+
+      /// @brief Use a binary std::istream written by write_binary() to
+      /// initialize this DecayScheme object, replacing any previous data.
+      /// @details If the data cannot be read, then the failbit is set on
+      /// the stream.
+      void read_from_binary_stream(std::istream& in);
+
       /// @brief Print LaTeX source code that gives a tabular
       /// representation of the DecayScheme object
       void print_latex_table(std::ostream& ostr = std::cout);
@@ -111,6 +132,53 @@ namespace marley {
       /// @brief Returns the nuclear PDG code corresponding to Z and A
       int pdg() const;
 
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by this object (levels, gammas, and the cascade table)
+      size_t memory_usage() const;
+
+      /// @brief Fills the table of gamma-ray cascade data used by
+      /// do_cascade()
+      /// @details This is otherwise done on the first call to do_cascade().
+      /// Building the table in advance allows the DecayScheme to be shared
+      /// between threads.
+      void build_cascade_table();
+
+      /// @brief Get the probability of cascades that are left out of the
+      /// cascade path tables
+      /// @details A value of zero means that the path tables are disabled.
+      inline double get_cascade_path_tolerance() const
+        { return cascade_path_tolerance_; }
+
+      /// @brief Enables or disables precomputed tables of complete
+      /// &gamma;-ray cascades
+      /// @details When the tolerance is positive, build_cascade_table()
+      /// lists the most probable cascades that begin at each level until
+      /// they cover all but (at most) the given fraction of the total
+      /// probability, or until max_paths of them have been found. Each
+      /// cascade is then chosen with one draw from an alias table. The
+      /// remaining cascades are sampled one &gamma;-ray at a time, as usual,
+      /// so the cascades are sampled from the same distribution either way.
+      /// The random number sequence differs, however, so individual events
+      /// will not match those generated with the path tables disabled.
+      /// @param tolerance Fraction of the probability for each starting
+      /// level that may be left to step-by-step sampling (zero disables the
+      /// path tables)
+      /// @param max_paths Maximum number of cascades to store for each
+      /// starting level
+      void set_cascade_path_tolerance( double tolerance,
+        size_t max_paths = DEFAULT_MAX_CASCADE_PATHS );
+
+      /// @brief Default maximum number of cascades stored in the path table
+      /// for each starting level
+      static constexpr size_t DEFAULT_MAX_CASCADE_PATHS = 64u;
+
+      /// @brief Fills the bucket index used to find the level closest to a
+      /// given excitation energy
+      /// @details This is otherwise done on the first call to
+      /// get_pointer_to_closest_level(), and it is also done by
+      /// build_cascade_table().
+      void build_level_index();
+
     protected:
 
       int Z_; ///< Atomic number
@@ -119,6 +187,10 @@ namespace marley {
       /// @brief Level objects owned by this DecayScheme
       std::vector< std::unique_ptr<marley::Level> > levels_;
 
+      /// @brief Excitation energies (MeV) of the levels, stored in the same
+      /// (ascending) order as levels_
+      std::vector<double> level_energies_;
+
       /// @brief Get the index of the first level whose energy
       /// is not less than Ex
       /// @param Ex Excitation energy (MeV)
@@ -127,6 +199,95 @@ namespace marley {
 
     private:
 
+      /// @brief Contiguous copy of the data needed to simulate gamma-ray
+      /// cascades
+      /// @details Levels are referred to by their indices in levels_. The
+      /// gammas owned by level k have indices gamma_offsets[k] through
+      /// gamma_offsets[k + 1] - 1.
+      struct CascadeTable {
+
+        /// @brief Atomic mass (MeV) of the neutral atom in each level
+        std::vector<double> level_masses;
+
+        /// @brief Index of the first gamma owned by each level, followed by
+        /// the total number of gammas
+        std::vector<size_t> gamma_offsets;
+
+        /// @brief Energy (MeV) of each gamma
+        std::vector<double> gamma_energies;
+
+        /// @brief Index of the final level for each gamma, or
+        /// NO_END_LEVEL if it could not be found
+        std::vector<size_t> end_levels;
+
+        /// @brief Samplers that choose a gamma for each level (in terms of
+        /// its position within the level)
+        std::vector<marley::AliasTable> gamma_samplers;
+
+        /// @brief Index of the first cascade path listed for each level,
+        /// followed by the total number of paths
+        /// @details The paths for each level are sorted lexicographically
+        /// by their gamma indices. These vectors are empty if the path
+        /// tables are disabled.
+        std::vector<size_t> path_offsets;
+
+        /// @brief Index (in path_gammas) of the first gamma in each path,
+        /// followed by the total number of gammas in all paths
+        std::vector<size_t> path_gamma_offsets;
+
+        /// @brief Indices of the gammas emitted along each path
+        std::vector<size_t> path_gammas;
+
+        /// @brief Samplers that choose a path for each level
+        /// @details If the listed paths do not cover every possible
+        /// cascade, the sampler has one more entry than the number of paths.
+        /// It represents all of the other cascades.
+        std::vector<marley::AliasTable> path_samplers;
+      };
+
+      /// @brief Value of CascadeTable::end_levels for gammas whose final
+      /// level is not owned by this DecayScheme
+      static constexpr size_t NO_END_LEVEL = static_cast<size_t>( -1 );
+
+      /// @brief Flat copy of the data needed by do_cascade()
+      CascadeTable cascade_table_;
+
+      /// @brief Whether cascade_table_ is up to date
+      bool cascade_table_ready_ = false;
+
+      /// @brief Probability of cascades that may be left out of the path
+      /// tables for each level (zero if the path tables are disabled)
+      double cascade_path_tolerance_ = 0.;
+
+      /// @brief Maximum number of cascades listed in the path table for
+      /// each level
+      size_t max_cascade_paths_ = DEFAULT_MAX_CASCADE_PATHS;
+
+      /// @brief Helper function for build_cascade_table() that lists the
+      /// most probable cascades beginning at each level
+      void build_cascade_paths();
+
+      /// @brief Samples a cascade beginning at level k one gamma at a time,
+      /// rejecting any that are listed in the path table for that level
+      /// @param[out] path Indices of the gammas emitted during the cascade
+      void sample_unlisted_path( size_t k, marley::Generator& gen,
+        std::vector<size_t>& path ) const;
+
+      /// @brief Index of the first level in each of a set of equal-width
+      /// excitation energy buckets that span the levels, followed by the
+      /// total number of levels
+      /// @details Bucket b covers energies from level_energies_.front()
+      /// + b*bucket_width_ up to the start of the next bucket. There is
+      /// roughly one level per bucket on average, so the closest level to
+      /// a given energy is usually found after checking one or two entries.
+      std::vector<size_t> level_buckets_;
+
+      /// @brief Width (MeV) of the buckets in level_buckets_
+      double bucket_width_ = 0.;
+
+      /// @brief Whether level_buckets_ is up to date
+      bool level_index_ready_ = false;
+
       /// @brief Helper function that selects the correct parser
       /// when constructing the DecayScheme using a data file
       void parse(const std::string& filename,
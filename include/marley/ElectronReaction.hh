@@ -39,13 +39,23 @@ namespace marley {
 
       ElectronReaction(int pdg_a, int target_atom_pdg);
 
+      /// @brief Enumerated type used to choose the method for sampling the
+      /// CM frame scattering cosine of the ejectile
+      /// @details INVERSE_CDF (the default) inverts the cumulative
+      /// distribution of the tree-level differential cross section, which is
+      /// a quadratic function of the scattering cosine. REJECTION uses
+      /// rejection sampling on diff_xs() and is retained for validation.
+      enum class CosThetaSampling { INVERSE_CDF, REJECTION };
+
       inline virtual marley::TargetAtom atomic_target() const override final
         { return atom_; }
 
       // Total reaction cross section (in MeV^(-2)) for an incident
       // projectile with lab-frame kinetic energy Ea
       virtual double total_xs(int pdg_a, double KEa) const override;
-      virtual double total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const override;
+      virtual double total_xs(int pdg_a, double KEa, double dm_mass,
+        double UV_cutoff, double dm_velocity
+        = marley_utils::DM_DEFAULT_VELOCITY) const override;
 
       // Differential cross section (MeV^(-2)) in the CM frame
       virtual double diff_xs(int pdg_a, double KEa, double cos_theta_c_cm)
@@ -58,6 +68,12 @@ namespace marley {
       virtual marley::Event create_event(int particle_id_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
         marley::Generator& gen) const override;
 
+      // Creates an event object in place, reusing the storage owned by ev
+      virtual void create_event(int particle_id_a, double KEa,
+        marley::Generator& gen, marley::Event& ev) const override;
+
+      using marley::Reaction::create_event;
+
 
       inline virtual double threshold_kinetic_energy() const override
         { return KEa_threshold_; }
@@ -65,6 +81,14 @@ namespace marley {
       inline double g1() const { return g1_; }
       inline double g2() const { return g2_; }
 
+      /// Return the method used to sample ejectile scattering cosines
+      inline CosThetaSampling cos_theta_sampling() const
+        { return cos_theta_sampling_; }
+
+      /// Set the method used to sample ejectile scattering cosines
+      inline void set_cos_theta_sampling( CosThetaSampling method )
+        { cos_theta_sampling_ = method; }
+
     private:
 
       // Atomic target involved in this reaction
@@ -77,17 +101,45 @@ namespace marley {
       // Threshold kinetic energy of the projectile
       double KEa_threshold_;
 
+      // Method used to sample the CM frame scattering cosine of the ejectile
+      CosThetaSampling cos_theta_sampling_ = CosThetaSampling::INVERSE_CDF;
+
+      /// @brief Rejection sampling envelope computed for the most recent
+      /// projectile seen by rejection_sample_cos_theta_c_cm()
+      /// @details Monoenergetic sources (and histogram sources with only a
+      /// few bins) repeatedly request the same projectile energy, so the
+      /// maximum differential cross section is only recomputed when the
+      /// projectile changes.
+      struct EnvelopeCache {
+
+        /// @brief Whether the remaining members hold valid results
+        bool valid = false;
+
+        int pdg_a = 0; ///< PDG code of the projectile
+        double KEa = 0.; ///< Projectile kinetic energy (MeV)
+
+        /// @brief Maximum of diff_xs() over [COS_MIN, COS_MAX]
+        double max = 0.;
+      };
+
+      /// @brief Cached rejection sampling envelope
+      mutable EnvelopeCache envelope_cache_;
+
       /// @brief Helper function for the constructor.
       /// @details Sets the g1_ and g2_ member variables to the appropriate
       /// values based on the projectile PDG code (pdg_a_). Complains if the
       /// projectile PDG code isn't recognized.
       void set_coupling_constants();
 
-      // Sample a CM frame scattering cosine for the ejectile. The first
-      // argument is Mandelstam s.  This function assumes that the coupling
-      // constants g1 and g2 have already been updated, so make sure to use it
-      // only after calling determine_coupling_constants.
-      double sample_cos_theta_c_cm(double s, marley::Generator& gen);
+      // Sample a CM frame scattering cosine for the ejectile by inverting
+      // the cumulative distribution function. The first argument is
+      // Mandelstam s.
+      double sample_cos_theta_c_cm(double s, marley::Generator& gen) const;
+
+      // Sample a CM frame scattering cosine for the ejectile using rejection
+      // sampling. The third argument is Mandelstam s.
+      double rejection_sample_cos_theta_c_cm(int pdg_a, double KEa, double s,
+        marley::Generator& gen) const;
   };
 
 }
@@ -41,6 +41,8 @@ namespace marley {
   // rootcint so that we won't have issues using marley::Event objects with
   // ROOT 5.
   class JSON;
+  class JSONValue;
+  class JSONWriter;
   #endif
 
   /// @brief Container for ingoing and outgoing momentum 4-vectors from a
@@ -54,15 +56,13 @@ namespace marley {
   /// object will be in its ground state, and the final_particles_ member of
   /// this class will include Particle objects representing the de-excitation
   /// products.
-  /// @note This class manually manages memory (using the
-  /// &ldquo;<a href="http://tinyurl.com/mohpthc">rule of 5</a>&rdquo;)
-  /// for the Particle objects that it owns. A better implementation from a
-  /// modern C++ perspective would be to use vectors of
-  /// std::unique_ptr<marley::Particle> objects and let those manage the memory
-  /// (i.e., use the
-  /// &ldquo;<a href="http://tinyurl.com/mohpthc">rule of zero</a>&rdquo;).
-  /// This design choice was made to ensure compatibility with ROOT 5, which
-  /// cannot generate dictionaries for C++11 classes like std::unique_ptr.
+  /// @note The Particle objects are stored by value in contiguous vectors,
+  /// so creating, copying, and destroying an Event requires only one heap
+  /// allocation for each vector rather than one per particle. The
+  /// projectile and target always have indices 0 and 1 in the vector of
+  /// initial particles, and the ejectile and residue have indices 0 and 1 in
+  /// the vector of final particles. As for any std::vector, references to
+  /// the particles are invalidated when a new one is added to the event.
   class Event {
 
     public:
@@ -82,21 +82,29 @@ namespace marley {
         const marley::Particle& d, double Ex, int twoJ,
         const marley::Parity& P);
 
-      // Destructor
-      ~Event();
-
       /// @brief Copy constructor
-      Event(const Event& other_event);
+      Event(const Event& other_event) = default;
 
       /// @brief Move constructor
       Event(Event&& other_event);
 
       /// @brief Copy assignment operator
-      Event& operator=(const Event& other_event);
+      /// @details Existing storage for the particles is reused when possible
+      Event& operator=(const Event& other_event) = default;
 
       /// @brief Move assignment operator
       Event& operator=(Event&& other_event);
 
+      /// @brief Replace the contents of this event with a two-two
+      /// scattering event
+      /// @details The result is the same as assigning a new Event created
+      /// using the two-two scattering constructor, except that the storage
+      /// already allocated for the particles is reused. The weight is reset
+      /// to unity and the time to zero.
+      void assign(const marley::Particle& a, const marley::Particle& b,
+        const marley::Particle& c, const marley::Particle& d, double Ex,
+        int twoJ, const marley::Parity& P);
+
       /// @brief Get a const reference to the projectile
       const marley::Particle& projectile() const;
       /// @brief Get a const reference to the target
@@ -116,17 +124,17 @@ namespace marley {
       marley::Particle& residue();
 
       /// @brief Get a const reference to the vector of initial particles
-      inline const std::vector<marley::Particle*>& get_initial_particles()
+      inline const std::vector<marley::Particle>& get_initial_particles()
         const;
 
       /// @brief Get a non-const reference to the vector of initial particles
-      inline std::vector<marley::Particle*>& get_initial_particles();
+      inline std::vector<marley::Particle>& get_initial_particles();
 
       /// @brief Get a const reference to the vector of final particles
-      inline const std::vector<marley::Particle*>& get_final_particles() const;
+      inline const std::vector<marley::Particle>& get_final_particles() const;
 
       /// @brief Get a non-const reference to the vector of final particles
-      inline std::vector<marley::Particle*>& get_final_particles();
+      inline std::vector<marley::Particle>& get_final_particles();
 
       /// @brief Returns the number of initial particles in the Event
       inline size_t initial_particle_count() const;
@@ -160,6 +168,26 @@ namespace marley {
       /// initial two-body reaction
       inline marley::Parity parity() const;
 
+      /// @brief Get the statistical weight of this event
+      /// @details The weight is unity unless importance sampling was used to
+      /// generate the event (see marley::Generator::set_reaction_bias()).
+      /// Weighted histograms filled using this value reproduce the
+      /// distributions that would be obtained without biasing.
+      inline double weight() const;
+
+      /// @brief Set the statistical weight of this event
+      inline void set_weight(double weight);
+
+      /// @brief Get the emission time of the projectile
+      /// @details The time is zero unless the event was generated using a
+      /// time-dependent source (see marley::TimeBinnedNeutrinoSource), in
+      /// which case it is expressed in the units used to define the time
+      /// bins of that source.
+      inline double time() const;
+
+      /// @brief Set the emission time of the projectile
+      inline void set_time(double time);
+
       /// @brief Add a Particle to the vector of initial particles
       void add_initial_particle(const marley::Particle& p);
 
@@ -183,6 +211,14 @@ namespace marley {
       void write_hepevt(size_t event_num, double flux_avg_tot_xsec,
         std::ostream& out) const;
 
+      /// @brief Append a HEPEVT record for this event to a std::string
+      /// @details This gives exactly the same text as the std::ostream
+      /// overload, but the record is rendered directly into the string
+      /// without any stream formatting. Reusing one string for many events
+      /// avoids repeated memory allocations.
+      void write_hepevt(size_t event_num, double flux_avg_tot_xsec,
+        std::string& buffer) const;
+
       /// @brief Print this event to a std::ostream
       /// @param out The std::ostream to which this event will be written
       void print(std::ostream& out) const;
@@ -221,26 +257,38 @@ namespace marley {
       /// object contents will have been cleared by this function.
       bool read_hepevt(std::istream& in, double* flux_avg_tot_xsec = nullptr);
 
-      /// @brief Deletes all particles from the event and resets
-      /// the nuclear excitation energy to zero
+      /// @brief Deletes all particles from the event, resets
+      /// the nuclear excitation energy and time to zero, and resets the
+      /// weight to unity
       void clear();
 
       #ifndef __MAKECINT__
       /// @brief Create a JSON representation of this event
       marley::JSON to_json() const;
 
+      /// @brief Write the JSON representation of this event directly to a
+      /// JSONWriter
+      /// @details Produces the same text as serializing the result of
+      /// to_json(), but without building an intermediate marley::JSON
+      /// object
+      void write_json(marley::JSONWriter& writer) const;
+
       /// @brief Replace the existing event contents with those read
       /// from a JSON representation
       void from_json(const marley::JSON& json);
+
+      /// @brief Replace the existing event contents with those read
+      /// from a value stored in a JSONDocument
+      void from_json(const marley::JSONValue& json);
       #endif
 
     protected:
 
-      /// @brief Vector of pointers to each of the initial state particles
-      std::vector<marley::Particle*> initial_particles_;
+      /// @brief Each of the initial state particles
+      std::vector<marley::Particle> initial_particles_;
 
-      /// @brief Vector of pointers to each of the final state particles
-      std::vector<marley::Particle*> final_particles_;
+      /// @brief Each of the final state particles
+      std::vector<marley::Particle> final_particles_;
 
       /// @brief Excitation energy (MeV) of the residue immediately after the
       /// two-two scattering reaction
@@ -256,38 +304,53 @@ namespace marley {
       /// scattering reaction
       Parity parity_;
 
+      /// @brief Statistical weight of the event (unity unless importance
+      /// sampling was used)
+      double weight_ = 1.;
+
+      /// @brief Emission time of the projectile (zero unless a
+      /// time-dependent source was used)
+      double time_ = 0.;
+
       /// @brief Helper function for write_hepevt()
       /// @param p Particle to write to the HEPEVT record
-      /// @param os std::ostream being written to
+      /// @param buffer String to which the particle entry will be appended
       /// @param status Integer status code to use for this particle
       /// in the HEPEVT output
       /// @param jmohep1 Index of the first mother for this particle
       /// (used only for a "MARLEY info" dummy particle at the moment)
       /// @param jmohep2 Index of the second mother for this particle
       /// (used only for a "MARLEY info" dummy particle at the moment)
-      void dump_hepevt_particle(const marley::Particle& p, std::ostream& os,
-        int status, int jmohep1 = 0, int jmohep2 = 0) const;
+      void dump_hepevt_particle(const marley::Particle& p,
+        std::string& buffer, int status, int jmohep1 = 0,
+        int jmohep2 = 0) const;
 
-      /// @brief Deletes all owned Particle objects and clears the
-      /// vectors of initial and final particles
-      void delete_particles();
+      #ifndef __MAKECINT__
+      /// @brief Shared implementation of the from_json() overloads
+      /// @tparam JSONType marley::JSON or marley::JSONValue
+      template <typename JSONType> void load_json(const JSONType& json);
+      #endif
   };
 
   // Inline function definitions
   inline double Event::Ex() const { return Ex_; }
   inline int Event::twoJ() const { return twoJ_; }
   inline marley::Parity Event::parity() const { return parity_; }
+  inline double Event::weight() const { return weight_; }
+  inline void Event::set_weight(double weight) { weight_ = weight; }
+  inline double Event::time() const { return time_; }
+  inline void Event::set_time(double time) { time_ = time; }
 
-  inline const std::vector<marley::Particle*>& Event::get_initial_particles()
+  inline const std::vector<marley::Particle>& Event::get_initial_particles()
     const { return initial_particles_; }
 
-  inline std::vector<marley::Particle*>& Event::get_initial_particles()
+  inline std::vector<marley::Particle>& Event::get_initial_particles()
     { return initial_particles_; }
 
-  inline const std::vector<marley::Particle*>& Event::get_final_particles()
+  inline const std::vector<marley::Particle>& Event::get_final_particles()
     const { return final_particles_; }
 
-  inline std::vector<marley::Particle*>& Event::get_final_particles()
+  inline std::vector<marley::Particle>& Event::get_final_particles()
     { return final_particles_; }
 
   inline size_t Event::initial_particle_count() const
@@ -297,11 +360,11 @@ namespace marley {
     { return final_particles_.size(); }
 
   inline const marley::Particle& Event::initial_particle( size_t idx ) const {
-    return *initial_particles_.at( idx );
+    return initial_particles_.at( idx );
   }
 
   inline const marley::Particle& Event::final_particle( size_t idx ) const {
-    return *final_particles_.at( idx );
+    return final_particles_.at( idx );
   }
 
 }
@@ -0,0 +1,201 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace marley {
+
+  class Event;
+
+  /// @brief Structure-of-arrays storage for a batch of events
+  /// @details Each quantity is stored as a contiguous column with one entry
+  /// per event or per particle, so that analysis code can loop over the
+  /// particles of many events at once without going through the Particle
+  /// accessors. The event columns hold the excitation energy, two times the
+  /// spin, the parity, the weight, the time, and the numbers of initial and
+  /// final particles for each event. The particle columns hold the PDG code, the total energy,
+  /// the 3-momentum, the mass, and the charge of every particle in the
+  /// batch. The initial particles of each event come first, followed by
+  /// its final particles. The particles of event i thus occupy the indices
+  /// from first_particle(i) up to (but not including)
+  /// first_particle(i) + num_initial(i) + num_final(i).
+  ///
+  /// A batch may be filled directly using Generator::create_events() and
+  /// written using OutputFile::write_events().
+  class EventBatch {
+
+    public:
+
+      inline EventBatch() {}
+
+      inline virtual ~EventBatch() = default;
+
+      /// @brief Add an event to the end of the batch
+      void add_event(const marley::Event& ev);
+
+      /// @brief Add some of the events stored in another batch to the end
+      /// of this one
+      /// @param other The batch containing the events to add
+      /// @param first Position in other of the first event to add
+      /// @param count The number of events to add
+      void append(const marley::EventBatch& other, size_t first,
+        size_t count);
+
+      /// @brief Load an event stored in the batch into an Event object
+      /// @param index Position of the event in the batch
+      /// @param[out] ev Event object that will be filled
+      void get_event(size_t index, marley::Event& ev) const;
+
+      /// @brief Get the number of events stored in the batch
+      inline size_t size() const;
+
+      /// @brief Get the total number of particles stored in the batch
+      inline size_t num_particles() const;
+
+      /// @brief Remove all events from the batch
+      /// @details The storage allocated for the columns is retained so that
+      /// the batch may be refilled without reallocating
+      void clear();
+
+      /// @brief Allocate enough storage for a given number of events and
+      /// particles
+      void reserve(size_t num_events, size_t num_particles);
+
+      /// @brief Get the index of the first particle of an event
+      inline size_t first_particle(size_t index) const;
+
+      /// @brief Get the index of the first final particle of an event
+      inline size_t first_final_particle(size_t index) const;
+
+      /// @brief Get the number of initial particles in an event
+      inline int num_initial(size_t index) const;
+
+      /// @brief Get the number of final particles in an event
+      inline int num_final(size_t index) const;
+
+      /// @name Event columns
+      //@{
+      inline const std::vector<double>& Exs() const;
+      inline const std::vector<int32_t>& twoJs() const;
+      inline const std::vector<int32_t>& parities() const;
+      inline const std::vector<double>& weights() const;
+      inline const std::vector<double>& times() const;
+      inline const std::vector<int32_t>& num_initials() const;
+      inline const std::vector<int32_t>& num_finals() const;
+      inline const std::vector<size_t>& first_particles() const;
+      //@}
+
+      /// @name Particle columns
+      //@{
+      inline const std::vector<int32_t>& pdgs() const;
+      inline const std::vector<double>& Es() const;
+      inline const std::vector<double>& pxs() const;
+      inline const std::vector<double>& pys() const;
+      inline const std::vector<double>& pzs() const;
+      inline const std::vector<double>& masses() const;
+      inline const std::vector<int32_t>& charges() const;
+      //@}
+
+    protected:
+
+      /// @name Event columns
+      //@{
+      std::vector<double> Exs_;
+      std::vector<int32_t> twoJs_;
+      std::vector<int32_t> parities_;
+      std::vector<double> weights_;
+      std::vector<double> times_;
+      std::vector<int32_t> num_initials_;
+      std::vector<int32_t> num_finals_;
+      //@}
+
+      /// @brief Index of each event's first particle in the particle columns
+      std::vector<size_t> first_particles_;
+
+      /// @name Particle columns
+      //@{
+      std::vector<int32_t> pdgs_;
+      std::vector<double> Es_;
+      std::vector<double> pxs_;
+      std::vector<double> pys_;
+      std::vector<double> pzs_;
+      std::vector<double> masses_;
+      std::vector<int32_t> charges_;
+      //@}
+  };
+
+  // Inline function definitions
+  inline size_t EventBatch::size() const { return Exs_.size(); }
+
+  inline size_t EventBatch::num_particles() const { return pdgs_.size(); }
+
+  inline size_t EventBatch::first_particle(size_t index) const
+    { return first_particles_[ index ]; }
+
+  inline size_t EventBatch::first_final_particle(size_t index) const
+    { return first_particles_[ index ] + num_initials_[ index ]; }
+
+  inline int EventBatch::num_initial(size_t index) const
+    { return num_initials_[ index ]; }
+
+  inline int EventBatch::num_final(size_t index) const
+    { return num_finals_[ index ]; }
+
+  inline const std::vector<double>& EventBatch::Exs() const { return Exs_; }
+
+  inline const std::vector<int32_t>& EventBatch::twoJs() const
+    { return twoJs_; }
+
+  inline const std::vector<int32_t>& EventBatch::parities() const
+    { return parities_; }
+
+  inline const std::vector<double>& EventBatch::weights() const
+    { return weights_; }
+
+  inline const std::vector<double>& EventBatch::times() const
+    { return times_; }
+
+  inline const std::vector<int32_t>& EventBatch::num_initials() const
+    { return num_initials_; }
+
+  inline const std::vector<int32_t>& EventBatch::num_finals() const
+    { return num_finals_; }
+
+  inline const std::vector<size_t>& EventBatch::first_particles() const
+    { return first_particles_; }
+
+  inline const std::vector<int32_t>& EventBatch::pdgs() const
+    { return pdgs_; }
+
+  inline const std::vector<double>& EventBatch::Es() const { return Es_; }
+
+  inline const std::vector<double>& EventBatch::pxs() const { return pxs_; }
+
+  inline const std::vector<double>& EventBatch::pys() const { return pys_; }
+
+  inline const std::vector<double>& EventBatch::pzs() const { return pzs_; }
+
+  inline const std::vector<double>& EventBatch::masses() const
+    { return masses_; }
+
+  inline const std::vector<int32_t>& EventBatch::charges() const
+    { return charges_; }
+
+}
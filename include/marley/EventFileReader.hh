@@ -15,17 +15,21 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
-#include <deque>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 
-#include "marley/JSON.hh"
+#include "marley/CompressedStream.hh"
+#include "marley/EventIndex.hh"
+#include "marley/JSONDocument.hh"
 #include "marley/OutputFile.hh"
 
 namespace marley {
 
-  // Forward-declare the Event class
+  // Forward-declare the Event and EventBatch classes
   class Event;
+  class EventBatch;
 
   /// @brief Object that parses MARLEY output files written in any of the
   /// available formats, except for ROOT format
@@ -35,6 +39,11 @@ namespace marley {
 
     public:
 
+      /// @param file_name Name of the file to read. A file name pattern
+      /// with a single integer conversion (see
+      /// marley::RotatingOutputFile::is_pattern()) may be given instead if
+      /// no file has that exact name. In that case, the parts written
+      /// using the pattern are read in order as a single set of events.
       EventFileReader( const std::string& file_name );
 
       virtual ~EventFileReader() = default;
@@ -47,16 +56,52 @@ namespace marley {
       /// condition for iterating over events in the output file
       virtual bool next_event( marley::Event& ev );
 
+      /// @brief Read up to a given number of events into an EventBatch
+      /// @details Any previous contents of the batch are replaced. For
+      /// binary-format files, the columns are copied directly from each
+      /// event block without creating Event objects. Other formats are
+      /// read one event at a time.
+      /// @param max_events Maximum number of events to read
+      /// @param[out] batch EventBatch that will be loaded with the events
+      /// @return The number of events that were read. This is less than
+      /// max_events only if the end of the file was reached.
+      virtual size_t next_events( size_t max_events,
+        marley::EventBatch& batch );
+
       /// @brief Returns the flux-averaged total cross section
       /// used to produce the events in the file
       /// @details For file formats which do not include this information,
-      /// this function will return zero
+      /// this function will return zero. When reading a set of parts, the
+      /// value stored in the part that is currently being read is used.
       /// @param[in] natural_units If true, then this function will
       /// return the flux-averaged total cross section in natural units
       /// (MeV<sup> -2</sup>). If false (default), then 10<sup>-42</sup>
       /// cm<sup>2</sup> will be used.
       double flux_averaged_xsec( bool natural_units = false );
 
+      /// @brief Position the reader so that the next call to next_event()
+      /// will load the event with a given index
+      /// @details Except for the JSON and ROOT formats, this requires the
+      /// index file (see marley::EventIndex) that the marley executable
+      /// writes for an output file when its "index" option is enabled.
+      /// Seeking is not possible within compressed files or sets of
+      /// parts.
+      /// @param event_index Position of the event in the file (starting
+      /// from zero)
+      /// @return True if the requested event exists, or false otherwise
+      virtual bool seek_event( size_t event_index );
+
+      /// @brief Load the index file entry for an event
+      /// @details The entry includes the generator settings needed to
+      /// regenerate the event
+      /// @param event_index Position of the event in the file (starting
+      /// from zero)
+      /// @param[out] entry Object that will be loaded with the entry
+      /// @return True if the index includes the requested event, or false
+      /// otherwise
+      bool get_index_entry( size_t event_index,
+        marley::EventIndex::Entry& entry );
+
       /// @brief Stream operator for reading in the next event
       inline EventFileReader& operator>>( marley::Event& ev ) {
         next_event( ev );
@@ -74,21 +119,47 @@ namespace marley {
       /// read
       std::string file_name_;
 
+      /// @brief Names of every file in the set of parts being read (empty
+      /// unless a file name pattern was given to the constructor)
+      std::vector<std::string> part_names_;
+
+      /// @brief Position in part_names_ of the next part to read
+      size_t next_part_ = 0u;
+
       /// @brief Format of the output file being read
       /// @details This format will be determined automatically by
       /// deduce_file_format() and does not need to be specified by the user
       OutputFile::Format format_;
 
+      /// @brief Decompressor used when reading a compressed file (null
+      /// otherwise)
+      std::unique_ptr<marley::DecompressingStreamBuf> decompressor_;
+
       /// @brief Input stream used to read from textual output formats
       std::ifstream in_;
 
       /// @brief Used to parse events from JSON-format files
-      marley::JSON json_event_array_;
-      /// @brief Used to iterate over events from JSON-format files
-      marley::JSON::JSONWrapper< std::deque< marley::JSON > >
-        json_event_array_wrapper_;
-      /// @brief Iterator to the next JSON event in json_event_array
-      std::deque<marley::JSON>::iterator json_event_iter_;
+      marley::JSONDocument json_doc_;
+      /// @brief Handles to each of the events stored in json_doc_
+      std::vector<marley::JSONValue> json_events_;
+      /// @brief Index of the next event to load from json_events_
+      /// @details This is one past the end of json_events_ once an attempt
+      /// has been made to read beyond the last event
+      size_t json_event_index_ = 0u;
+
+      /// @brief Holds the current block of events from binary-format files
+      marley::BinaryEventBlock binary_block_;
+      /// @brief Index of the next event to load from binary_block_
+      size_t binary_event_index_ = 0u;
+      /// @brief Version of the format used by a binary-format file
+      uint32_t binary_format_version_
+        = marley::BinaryEventBlock::FORMAT_VERSION;
+      /// @brief Precision of the kinematics in a binary-format file
+      marley::BinaryEventBlock::Precision binary_precision_
+        = marley::BinaryEventBlock::Precision::full;
+
+      /// @brief Stream used to read the index file (opened as needed)
+      std::ifstream index_in_;
 
       /// @brief Flux-averaged total cross section
       /// (MeV<sup> -2</sup>) used to produce the events in the file,
@@ -102,6 +173,10 @@ namespace marley {
       /// one of the other public member functions.
       bool initialized_ = false;
 
+      /// @brief Opens the file for reading, installing a decompressor as
+      /// the stream buffer for in_ if the file contents are compressed
+      void open_input(std::ios::openmode mode);
+
       /// @brief Helper function that auto-detects which of the available output
       /// formats is appropriate for the requested file
       virtual bool deduce_file_format();
@@ -109,6 +184,17 @@ namespace marley {
       /// @brief Prepares the file for reading the events
       virtual void initialize();
 
+      /// @brief Prepares the next file in a set of parts for reading
+      /// @return True if another part was opened, or false if the last one
+      /// has already been read
+      virtual bool open_next_part();
+
+      /// @brief Loads event blocks from a binary-format file until one with
+      /// unread events is found
+      /// @return True if an unread event is available in binary_block_, or
+      /// false if the end of the events was reached
+      bool load_binary_events();
+
       /// @brief This function should be called at the beginning of all public
       /// member functions of EventFileReader that interact with data in
       /// the file
@@ -0,0 +1,130 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <string>
+#include <vector>
+
+#include "marley/JSON.hh"
+
+namespace marley {
+
+  class Event;
+
+  /// @brief Set of 1D and 2D histograms of event observables that are
+  /// filled as the events are generated
+  /// @details This allows studies that only need a few distributions to
+  /// skip writing (and later rereading) the full events. Each thread that
+  /// creates events should fill its own copy of the histograms. The copies
+  /// are combined using merge() at the end of the run. Each histogram has
+  /// an underflow and an overflow bin along every axis, and it stores both
+  /// the sum of the event weights and the sum of their squares in each bin.
+  class EventHistograms {
+
+    public:
+
+      /// @brief Quantities that may be histogrammed
+      enum class Observable {
+        Ev, ///< Total energy of the projectile (MeV)
+        EjectileKE, ///< Kinetic energy of the ejectile (MeV)
+        Ex, ///< Excitation energy of the residue after the two-two
+            ///< scattering reaction (MeV)
+        VisibleEnergy, ///< Total kinetic energy of the charged final-state
+                       ///< particles and photons, excluding the residue (MeV)
+        NumProducts, ///< Number of de-excitation products
+        NumGammas, ///< Number of de-excitation photons
+        NumNeutrons, ///< Number of de-excitation neutrons
+        NumProtons, ///< Number of de-excitation protons
+        NumAlphas ///< Number of de-excitation alpha particles
+      };
+
+      /// @brief Build a set of empty histograms
+      /// @param specs JSON array of histogram specifications. Each one is
+      /// an object with the keys "name", "x", "bins", "min", and "max"
+      /// (plus "y", "y_bins", "y_min", and "y_max" for a 2D histogram),
+      /// where "x" and "y" are observable names (see observable_names()).
+      EventHistograms(const marley::JSON& specs);
+
+      /// @brief Add an event to every histogram
+      void fill(const marley::Event& ev);
+
+      /// @brief Add the contents of another set of histograms to this one
+      /// @details Both sets must have been built from the same
+      /// specifications
+      void merge(const marley::EventHistograms& other);
+
+      /// @brief Returns a JSON object that describes the binning and
+      /// contents of every histogram
+      /// @param xsec Flux-averaged total cross section (MeV<sup> -2</sup>)
+      /// to store alongside the histograms
+      marley::JSON to_json(double xsec) const;
+
+      /// @brief Writes the output of to_json() to a file
+      void write(const std::string& file_name, double xsec) const;
+
+      /// @brief Number of events added to the histograms so far
+      inline long num_events() const { return num_events_; }
+
+      /// @brief Look up an Observable by name, throwing a marley::Error if
+      /// it is not recognized
+      static Observable observable_from_name(const std::string& name);
+
+      /// @brief Returns a comma-separated list of the allowed observable
+      /// names
+      static std::string observable_names();
+
+      /// @brief Computes an observable for an event
+      static double evaluate(Observable obs, const marley::Event& ev);
+
+    private:
+
+      /// @brief Uniform binning of one histogram axis
+      struct Axis {
+        Observable obs;
+        std::string name; ///< Name of the observable
+        int bins;
+        double min;
+        double max;
+
+        /// @brief Returns the bin index for a value, where zero is the
+        /// underflow bin and bins + 1 is the overflow bin
+        int find_bin(double value) const;
+      };
+
+      struct Histogram {
+        std::string name;
+        Axis x;
+        bool two_dim = false;
+        Axis y; ///< Unused unless two_dim is true
+
+        /// @brief Sum of the event weights in each bin (including the
+        /// underflow and overflow bins). The x index varies fastest.
+        std::vector<double> sum_w;
+
+        /// @brief Sum of the squared event weights in each bin
+        std::vector<double> sum_w2;
+      };
+
+      /// @brief Parses the binning of an axis from a histogram specification
+      static Axis make_axis(const marley::JSON& spec, const std::string& hname,
+        const std::string& prefix);
+
+      std::vector<Histogram> histograms_;
+
+      long num_events_ = 0;
+  };
+
+}
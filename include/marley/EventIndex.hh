@@ -0,0 +1,99 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace marley {
+
+  /// @brief Sidecar file that maps event numbers to their locations in a
+  /// MARLEY output file
+  /// @details An index file starts with a 16-byte header (the MAGIC string
+  /// followed by a 32-bit format version and 32 reserved bits). It is
+  /// followed by one fixed-size Entry for each event in the output file, in
+  /// the order that the events were written, so the entry for any event may
+  /// be found without reading the others. All values are stored as
+  /// little-endian unsigned integers.
+  class EventIndex {
+
+    public:
+
+      /// @brief Location of an event together with the information needed
+      /// to regenerate it
+      struct Entry {
+        /// @brief Byte offset of the event (or, for the binary format, of
+        /// its event block) from the start of the output file. For the
+        /// ROOT format, this is the TTree entry number instead.
+        uint64_t offset = 0u;
+        /// @brief Position of the event within its binary event block
+        /// (zero for all other formats)
+        uint32_t sub_index = 0u;
+        /// @brief Whether the generator used the counter-based random
+        /// number engine. If it did not, then the remaining members cannot
+        /// be used to regenerate the event by itself.
+        bool counter_based = false;
+        /// @brief Random number seed used by the generator
+        uint64_t seed = 0u;
+        /// @brief Stream ID used by the counter-based random number engine
+        uint64_t stream_id = 0u;
+        /// @brief Generator event number (see
+        /// marley::Generator::set_event_number())
+        uint64_t event_number = 0u;
+      };
+
+      /// @brief Identifies a MARLEY event index file
+      static const std::string MAGIC;
+
+      /// @brief Version number for the index file format
+      static constexpr uint32_t FORMAT_VERSION = 1u;
+
+      /// @brief Number of bytes occupied by the file header
+      static constexpr std::streamoff HEADER_SIZE = 16;
+
+      /// @brief Number of bytes occupied by each entry
+      static constexpr std::streamoff ENTRY_SIZE = 40;
+
+      /// @brief Get the name of the index file for an output file
+      inline static std::string file_name(const std::string& event_file);
+
+      /// @brief Write an index file header to a binary stream
+      static void write_header(std::ostream& out);
+
+      /// @brief Read an index file header from a binary stream
+      /// @return True if a valid header was read, or false otherwise
+      static bool read_header(std::istream& in);
+
+      /// @brief Write an entry to a binary stream
+      static void write_entry(std::ostream& out, const Entry& entry);
+
+      /// @brief Read the entry for a given event from an index file stream
+      /// @param in Binary stream for the index file
+      /// @param event_index Position of the event in the output file
+      /// (starting from zero)
+      /// @param[out] entry Entry that will be loaded
+      /// @return True if the entry was read successfully, or false otherwise
+      /// (e.g., if the index does not include the requested event)
+      static bool read_entry(std::istream& in, uint64_t event_index,
+        Entry& entry);
+  };
+
+  // Inline function definitions
+  inline std::string EventIndex::file_name(const std::string& event_file)
+    { return event_file + ".idx"; }
+
+}
@@ -0,0 +1,142 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+
+namespace marley {
+
+  /// @brief Pool of pre-generated events that is filled by Generator objects
+  /// running on background threads
+  /// @details Each consumer (e.g., a Geant4 worker thread) is paired with a
+  /// dedicated Generator, which runs on its own producer thread and keeps a
+  /// bounded buffer of up to depth() completed events ready for that
+  /// consumer. Consumer i therefore always receives the events created by
+  /// Generator i, in the order they were created, regardless of thread
+  /// scheduling, so runs are reproducible for fixed Generator seeds. As
+  /// long as event generation keeps up with the consumers, pop() returns
+  /// immediately. The Generator objects may not be used by anything else
+  /// while they belong to the pool.
+  class EventPool {
+
+    public:
+
+      /// @param generators Generator objects to use as producers. The pool
+      /// takes ownership of them, and the number of consumers is equal to
+      /// the number of Generator objects.
+      /// @param depth Maximum number of completed events buffered for each
+      /// consumer
+      EventPool( std::vector< std::unique_ptr<marley::Generator> > generators,
+        size_t depth = DEFAULT_DEPTH );
+
+      /// @brief Stops the producer threads, discarding any buffered events
+      ~EventPool();
+
+      /// @brief Deleted copy constructor
+      EventPool(const EventPool&) = delete;
+
+      /// @brief Deleted copy assignment operator
+      EventPool& operator=(const EventPool&) = delete;
+
+      /// @brief Default number of events buffered for each consumer
+      static constexpr size_t DEFAULT_DEPTH = 1000u;
+
+      /// @brief Get the next event for a consumer
+      /// @details Blocks only if no event is ready yet. The previous
+      /// contents of ev are handed back to the pool so that their storage
+      /// can be reused. If the producer for this consumer encountered an
+      /// error, then the exception it threw is rethrown here.
+      /// @param consumer Index of the consumer (counting from zero)
+      /// @param[out] ev Event object that will receive the next event
+      void pop( size_t consumer, marley::Event& ev );
+
+      /// @brief Get the next event for a consumer if one is ready
+      /// @details Like pop(), but returns immediately
+      /// @return True if ev was loaded with a new event, or false if none
+      /// was ready
+      bool try_pop( size_t consumer, marley::Event& ev );
+
+      /// @brief Get the number of consumers served by the pool
+      inline size_t num_consumers() const { return channels_.size(); }
+
+      /// @brief Get the maximum number of events buffered for each consumer
+      inline size_t depth() const { return depth_; }
+
+      /// @brief Get the Generator that produces events for a consumer
+      /// @details The Generator is in use by a producer thread, so only
+      /// its const member functions that read settings fixed before the
+      /// pool was created (e.g., get_seed()) may be safely called.
+      const marley::Generator& get_generator( size_t consumer ) const;
+
+    protected:
+
+      /// @brief Producer thread and event buffer for a single consumer
+      struct Channel {
+
+        /// @brief Generator that fills the buffer
+        std::unique_ptr<marley::Generator> generator;
+
+        /// @brief Ring buffer of completed events
+        std::vector<marley::Event> slots;
+
+        /// @brief Total number of events added to the buffer so far
+        uint64_t head = 0u;
+
+        /// @brief Total number of events removed from the buffer so far
+        uint64_t tail = 0u;
+
+        /// @brief First error encountered by the producer thread (if any)
+        std::exception_ptr error;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+      };
+
+      /// @brief Main loop for the producer thread serving a consumer
+      void produce( size_t consumer );
+
+      /// @brief Tells the producer threads to stop and waits for them
+      void stop_producers();
+
+      /// @brief Helper for pop() and try_pop(). Must be called with
+      /// ch.mutex locked and at least one buffered event.
+      void take( Channel& ch, std::unique_lock<std::mutex>& lock,
+        marley::Event& ev );
+
+      /// @brief Get the Channel for a consumer, complaining if the index
+      /// is out of range
+      Channel& channel( size_t consumer );
+
+      size_t depth_;
+      std::vector< std::unique_ptr<Channel> > channels_;
+
+      /// @brief Set to true when the producer threads should stop
+      std::atomic<bool> stop_{ false };
+  };
+
+}
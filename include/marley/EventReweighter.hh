@@ -0,0 +1,127 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <functional>
+#include <vector>
+
+#include "marley/Generator.hh"
+
+namespace marley {
+
+  // Forward-declare some needed classes
+  class Event;
+  class EventFileReader;
+  class JSONConfig;
+
+  /// @brief Computes weights that reinterpret previously generated events
+  /// as if they had been produced using an alternative configuration
+  /// @details The weight assigned to each event is the likelihood ratio
+  /// for its primary 2 &rarr; 2 interaction. The density of a stored event
+  /// under each configuration is evaluated at its projectile energy, CM frame
+  /// ejectile scattering cosine, and final nuclear level as
+  /// @f$\phi(E_a)\sum_r f_r\,d\sigma_r/d\cos\theta_c^{\mathrm{CM}}@f$, where
+  /// the sum runs over all reactions able to produce the event and
+  /// @f$f_r@f$ is the atom fraction of the target involved in reaction r.
+  /// Variations of the matrix elements, Coulomb corrections, incident
+  /// spectrum, and target composition may therefore be studied without
+  /// regenerating the events. The nuclear de-excitation cascade (and the
+  /// spin-parity sampled for continuum levels) is not reweighted, so
+  /// variations of the Hauser-Feshbach model parameters have no effect on
+  /// the computed weights. For dark matter reactions, the model parameters
+  /// are taken from each configuration's source.
+  class EventReweighter {
+
+    public:
+
+      /// @brief Normalization convention for the computed weights
+      enum class Normalization {
+        /// Weights reproduce the alternative event rate (the mean weight is
+        /// the ratio of the flux-averaged total cross sections)
+        RATE,
+        /// Weights are rescaled so that only the shape of the event
+        /// distribution changes (the mean weight is unity)
+        SHAPE
+      };
+
+      /// @param nominal Configuration used to generate the stored events
+      /// @param alternative Configuration describing the systematic
+      /// variation of interest
+      /// @param norm Normalization convention to use for the weights
+      EventReweighter( const marley::JSONConfig& nominal,
+        const marley::JSONConfig& alternative,
+        Normalization norm = Normalization::RATE );
+
+      /// @brief Compute the likelihood ratio for a stored event
+      /// @details The weight already stored in the Event (e.g., from
+      /// importance sampling) is not included in the returned value
+      /// @param ev Event produced using the nominal configuration
+      double weight( const marley::Event& ev ) const;
+
+      /// @brief Compute weights for every event remaining in a file
+      /// @param reader EventFileReader used to read the stored events
+      /// @param callback Function that will be called with each event and
+      /// its computed weight
+      /// @return The number of events that were reweighted
+      size_t reweight( marley::EventFileReader& reader,
+        const std::function<void(const marley::Event&, double)>& callback )
+        const;
+
+      /// @brief Compute weights for every event remaining in a file
+      /// @param reader EventFileReader used to read the stored events
+      /// @param[out] weights Vector to which the computed weights will be
+      /// appended in the order that the events appear in the file
+      /// @return The number of events that were reweighted
+      size_t reweight( marley::EventFileReader& reader,
+        std::vector<double>& weights ) const;
+
+      /// @brief Get the normalization convention used for the weights
+      inline Normalization normalization() const { return norm_; }
+
+      /// @brief Get a const reference to the Generator built from the
+      /// nominal configuration
+      inline const marley::Generator& nominal_generator() const
+        { return nominal_; }
+
+      /// @brief Get a const reference to the Generator built from the
+      /// alternative configuration
+      inline const marley::Generator& alternative_generator() const
+        { return alternative_; }
+
+    protected:
+
+      /// @brief Computes the (unnormalized) probability density of a stored
+      /// event for the configuration represented by a Generator
+      /// @param gen Generator to use for the calculation
+      /// @param ev Event whose density should be computed
+      /// @param cos_theta_c_cm CM frame scattering cosine of the ejectile
+      /// @param[out] matched Set to true if at least one of the Generator's
+      /// reactions is able to produce the event, or false otherwise
+      double event_density( const marley::Generator& gen,
+        const marley::Event& ev, double cos_theta_c_cm, bool& matched ) const;
+
+      marley::Generator nominal_; ///< Generator for the nominal configuration
+      /// Generator for the alternative configuration
+      marley::Generator alternative_;
+
+      Normalization norm_; ///< Normalization convention for the weights
+
+      /// @brief Factor applied to all weights to implement the chosen
+      /// normalization convention
+      double norm_factor_ = 1.;
+  };
+
+}
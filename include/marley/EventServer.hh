@@ -0,0 +1,198 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <atomic>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "marley/BinaryEventBlock.hh"
+#include "marley/Generator.hh"
+
+namespace marley {
+
+  /// @brief Serves batches of events to other processes on the same machine
+  /// over a Unix domain socket
+  /// @details The server keeps a fixed set of Generator objects (which may
+  /// share a StructureDatabase in concurrent mode) ready between requests,
+  /// so clients avoid the startup cost of the marley executable. Each
+  /// connection may send any number of requests. A request asks for a
+  /// number of events, either for a fixed projectile species, kinetic
+  /// energy, atomic target, and direction (see
+  /// Generator::create_event(int, double, int, const std::array<double, 3>&))
+  /// or sampled from the neutrino source in the job configuration. Each
+  /// request is handled by whichever Generator is free, so the server can
+  /// answer as many requests at once as it has Generator objects.
+  ///
+  /// All integers and floating-point numbers in the protocol are
+  /// little-endian. A request is REQUEST_SIZE bytes long and contains, in
+  /// order, the number of events (uint32), the projectile PDG code (int32),
+  /// the nuclear PDG code of the target atom (int32), a reserved field
+  /// (uint32, zero), the projectile kinetic energy in MeV (double), and the
+  /// three components of the projectile direction (double). A projectile
+  /// PDG code of zero requests events from the configured neutrino source,
+  /// and the remaining fields are then ignored. The response starts with a
+  /// status code (uint32) and the length in bytes of the body that follows
+  /// (uint64). If the status is OK, the body is an event block record
+  /// in MARLEY's binary output format (see BinaryEventBlock::write()).
+  /// Otherwise, the body is an error message.
+  class EventServer {
+
+    public:
+
+      /// @brief Status codes sent at the start of each response
+      enum class Status : uint32_t { OK = 0u, ERROR = 1u };
+
+      /// @brief Number of bytes in a request
+      static constexpr size_t REQUEST_SIZE = 48u;
+
+      /// @brief Number of bytes in the fixed part of a response
+      static constexpr size_t RESPONSE_HEADER_SIZE = 12u;
+
+      /// @brief Largest number of events that may be requested at once
+      static constexpr uint32_t MAX_EVENTS_PER_REQUEST = 1000000u;
+
+      /// @brief Contents of a request for events
+      struct Request {
+        /// @brief Number of events to create
+        uint32_t num_events = 1u;
+        /// @brief PDG code of the projectile, or zero to sample events
+        /// from the configured neutrino source
+        int32_t pdg_a = 0;
+        /// @brief Nuclear PDG code of the target atom
+        int32_t pdg_atom = 0;
+        /// @brief Kinetic energy of the projectile (MeV)
+        double KEa = 0.;
+        /// @brief Direction of the projectile
+        std::array<double, 3> dir_vec = { 0., 0., 1. };
+      };
+
+      /// @param generators Generator objects used to serve requests. The
+      /// server takes ownership of them.
+      /// @param socket_path Path of the Unix domain socket to create. Any
+      /// existing socket at this location is replaced.
+      EventServer( std::vector< std::unique_ptr<marley::Generator> >
+        generators, const std::string& socket_path );
+
+      /// @brief Closes the listening socket and removes it from the file
+      /// system
+      ~EventServer();
+
+      /// @brief Deleted copy constructor
+      EventServer(const EventServer&) = delete;
+
+      /// @brief Deleted copy assignment operator
+      EventServer& operator=(const EventServer&) = delete;
+
+      /// @brief Accept connections and serve requests until keep_running()
+      /// returns false
+      /// @details The predicate is checked a few times per second. Before
+      /// returning, run() waits for any requests that are being served to
+      /// finish and closes all open connections.
+      void run( const std::function<bool()>& keep_running );
+
+      /// @brief Get the path of the socket used by the server
+      inline const std::string& socket_path() const { return socket_path_; }
+
+      /// @brief Get the total number of requests served so far
+      inline uint64_t requests_served() const { return requests_served_; }
+
+      /// @brief Encode a request in the format sent over the socket
+      static std::string encode_request( const Request& request );
+
+      /// @brief Decode a request received over the socket
+      /// @param data Pointer to REQUEST_SIZE bytes
+      static Request decode_request( const char* data );
+
+      /// @brief Send a request to a server and wait for its response
+      /// @details This is a simple client that may be used by programs that
+      /// do not want to implement the protocol themselves.
+      /// @param socket_fd File descriptor for a socket that is connected to
+      /// the server (see connect())
+      /// @param request Events to ask for
+      /// @param[out] block Object that will be loaded with the events
+      /// @return True if the events were received, or false if the
+      /// connection was lost. If the server was unable to create the
+      /// events, then a marley::Error is thrown with its message.
+      static bool request_events( int socket_fd, const Request& request,
+        marley::BinaryEventBlock& block );
+
+      /// @brief Connect to a server listening on a Unix domain socket
+      /// @return The file descriptor for the connected socket, which should
+      /// be closed by the caller once it is no longer needed
+      static int connect( const std::string& socket_path );
+
+    protected:
+
+      /// @brief Thread serving a single client connection
+      struct Connection {
+        int fd = -1;
+        std::thread thread;
+        /// @brief Set to true once the thread has finished
+        std::atomic<bool> done{ false };
+      };
+
+      /// @brief Serve all of the requests sent over a connection until it
+      /// is closed by the client or the server is stopped
+      void serve_connection( Connection& conn );
+
+      /// @brief Create the events for a single request and encode the
+      /// response
+      /// @param request Events to create
+      /// @param block Scratch object used to store the events
+      /// @param[out] response Encoded response to send to the client
+      void handle_request( const Request& request,
+        marley::BinaryEventBlock& block, std::string& response );
+
+      /// @brief Join the threads for connections that have been closed
+      /// @param wait_for_all If true, then wait for every thread to finish
+      void reap_connections( bool wait_for_all );
+
+      /// @brief Borrow a Generator that is not in use, waiting if needed
+      marley::Generator& acquire_generator();
+
+      /// @brief Return a Generator borrowed by acquire_generator()
+      void release_generator( marley::Generator& gen );
+
+      std::vector< std::unique_ptr<marley::Generator> > generators_;
+
+      /// @brief Generator objects not currently serving a request
+      std::vector<marley::Generator*> idle_generators_;
+      std::mutex idle_mutex_;
+      std::condition_variable idle_cv_;
+
+      std::string socket_path_;
+
+      /// @brief File descriptor for the listening socket
+      int listen_fd_ = -1;
+
+      /// @brief Open connections
+      std::vector< std::unique_ptr<Connection> > connections_;
+
+      /// @brief Set to true when the connection threads should stop
+      std::atomic<bool> stop_{ false };
+
+      std::atomic<uint64_t> requests_served_{ 0u };
+  };
+
+}
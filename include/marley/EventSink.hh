@@ -0,0 +1,45 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+
+namespace marley {
+
+  // Forward-declare the Event class
+  class Event;
+
+  /// @brief Abstract base class for entities that receive completed
+  /// marley::Event objects from a Generator
+  /// @details EventSink objects are used by the batched
+  /// Generator::create_events() interface. The Event passed to receive_event()
+  /// is owned by the Generator and its storage will be reused for the next
+  /// event in the batch, so implementations that need to retain the event
+  /// must copy (or move) it.
+  class EventSink {
+
+    public:
+
+      inline EventSink() {}
+
+      inline virtual ~EventSink() = default;
+
+      /// @brief Receives a completed Event object
+      /// @param[in,out] ev The completed Event. Its contents may be moved
+      /// away by the EventSink if desired.
+      virtual void receive_event( marley::Event& ev ) = 0;
+  };
+
+}
@@ -0,0 +1,64 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <cstddef>
+
+namespace marley {
+
+  class Event;
+
+  /// @brief Scalar quantities that describe a single event in the "flat"
+  /// summary tree format
+  /// @details The summary tree (called "mst") is written by the marsum
+  /// utility and, if requested, directly by marley::RootOutputFile. Each
+  /// member corresponds to a branch of the same name (except for parity,
+  /// which is stored in the "parity" branch, and flux_avg_tot_xsec, which
+  /// is stored in the "xsec" branch). The remaining branches hold the
+  /// properties of the final-state particles other than the ejectile and
+  /// residue (the de-excitation products), of which there are np.
+  struct EventSummary {
+
+    /// @brief Index of the first final-state particle that is not the
+    /// ejectile or residue (first de-excitation product)
+    /// @todo Make this easier to maintain. If you change the layout of
+    /// marley::Event, this will break.
+    static constexpr size_t FIRST_PRODUCT_INDEX = 2u;
+
+    /// @brief Load the scalar quantities from an event
+    /// @param ev Event to summarize
+    /// @param xsec Flux-averaged total cross section (10<sup>-42</sup>
+    /// cm<sup>2</sup>) to store alongside the event
+    void set(const marley::Event& ev, double xsec);
+
+    double Ex; ///< Nuclear excitation energy
+    int twoJ; ///< Two times the residue spin immediately after the two-two
+              ///< scattering reaction
+    int parity; ///< Integer representation of the intrinsic parity of the
+                ///< residue immediately following the two-two reaction
+    double flux_avg_tot_xsec; ///< Flux-averaged total cross section
+    double weight; ///< Event weight
+    double time; ///< Projectile emission time
+    double Ev, KEv, pxv, pyv, pzv; ///< Projectile
+    double Mt; ///< Target mass
+    double El, KEl, pxl, pyl, pzl; ///< Ejectile
+    double Er, KEr, pxr, pyr, pzr; ///< Residue (after de-excitations)
+    int pdgv, pdgt, pdgl, pdgr; ///< PDG codes
+    int np; ///< Number of de-excitation products
+  };
+
+}
@@ -17,17 +17,22 @@
 #pragma once
 
 // standard library includes
+#include <array>
 #include <memory>
 #include <vector>
 
 // MARLEY includes
+#include "marley/AliasTable.hh"
+#include "marley/ChebyshevInterpolant.hh"
 #include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Fragment.hh"
 #include "marley/Generator.hh"
 #include "marley/IteratorToPointerMember.hh"
 #include "marley/Level.hh"
 #include "marley/MassTable.hh"
+#include "marley/MonotonicArena.hh"
 #include "marley/Parity.hh"
+#include "marley/SpinCouplingTable.hh"
 #include "marley/marley_utils.hh"
 
 namespace marley {
@@ -61,6 +66,12 @@ namespace marley {
 
       virtual ~ExitChannel() = default;
 
+      /// @brief Exit channels may be stored by value in containers (see
+      /// HauserFeshbachDecay), so keep them copyable and movable despite
+      /// the user-declared destructor
+      ExitChannel( const ExitChannel& ) = default;
+      ExitChannel( ExitChannel&& ) = default;
+
       /// @brief Returns true if this channel accesses the particle-unbound
       /// continuum of nuclear levels or false otherwise
       virtual bool is_continuum() const = 0;
@@ -186,8 +197,10 @@ namespace marley {
     public:
 
       /// @param fragment Fragment emitted in this exit channel
-      FragmentExitChannel(const marley::Fragment& fragment)
-        : fragment_pdg_( fragment.get_pid() ) {}
+      /// @details The kinematic constants and model references used by the
+      /// decay width calculations are computed once here. This relies on
+      /// the (virtual) ExitChannel base having been initialized first.
+      FragmentExitChannel(const marley::Fragment& fragment);
 
       virtual int emitted_particle_pdg() const final override
         { return fragment_pdg_; }
@@ -195,16 +208,39 @@ namespace marley {
       virtual bool emits_fragment() const final override
         { return true; }
 
-      virtual int final_nucleus_pdg() const final override;
+      inline virtual int final_nucleus_pdg() const final override
+        { return remnant_pdg_; }
+
+      /// @brief Returns the separation energy (MeV) for the emitted fragment
+      inline double separation_energy() const { return Sa_; }
 
     protected:
 
       /// @brief Helper function that returns that maximum possible excitation
       /// energy for the daughter nucleus after emission of the fragment
-      double max_Exf() const;
+      inline double max_Exf() const { return Exf_max_; }
 
       /// @brief PDG code identifying the emitted fragment
       int fragment_pdg_;
+
+      /// @brief Two times the spin of the emitted fragment
+      int two_s_;
+
+      /// @brief Intrinsic parity of the emitted fragment
+      marley::Parity Pa_;
+
+      /// @brief PDG code identifying the final nucleus
+      int remnant_pdg_;
+
+      /// @brief Separation energy (MeV) for the emitted fragment
+      double Sa_;
+
+      /// @brief Maximum possible excitation energy (MeV) for the final
+      /// nucleus
+      double Exf_max_;
+
+      /// @brief Optical model for the final nucleus
+      marley::OpticalModel* om_;
   };
 
   /// @brief Abstract base class for ExitChannel objects that represent
@@ -212,7 +248,10 @@ namespace marley {
   class GammaExitChannel : virtual public ExitChannel {
     public:
 
-      GammaExitChannel() {}
+      /// @details The gamma-ray strength function model for the nucleus is
+      /// looked up once here. This relies on the (virtual) ExitChannel base
+      /// having been initialized first.
+      GammaExitChannel();
 
       virtual int emitted_particle_pdg() const final override
         { return marley_utils::PHOTON; }
@@ -233,6 +272,9 @@ namespace marley {
 
       marley::GammaStrengthFunctionModel::TransitionType get_transition_type(
         int mpol, marley::Parity Pf ) const;
+
+      /// @brief Gamma-ray strength function model for the nucleus
+      marley::GammaStrengthFunctionModel* gsfm_;
   };
 
   /// @brief Abstract base class for ExitChannel objects that lead to the
@@ -262,8 +304,41 @@ namespace marley {
       virtual double differential_width( double Exf,
         bool store_jpi_widths = false ) const = 0;
 
+      /// @brief Evaluates differential_width() at each of n final nuclear
+      /// excitation energies
+      /// @details Scratch storage for the level densities and transmission
+      /// coefficients is shared by all of the points, and the concrete
+      /// implementation is called for each one without virtual dispatch.
+      /// This is used to build the Chebyshev polynomial approximant to the
+      /// differential width.
+      /// @param[in] Exfs Array of final excitation energies (MeV)
+      /// @param[out] widths Array that will be loaded with the differential
+      /// widths
+      /// @param n Length of the Exfs and widths arrays
+      virtual void differential_widths( const double* Exfs, double* widths,
+        size_t n ) const = 0;
+
       inline virtual bool is_continuum() const final override { return true; }
 
+      /// @brief Returns true if computation of the total width was deferred
+      /// during construction and has not been done yet
+      /// @details While the computation is deferred, width() returns zero.
+      /// Use width_upper_bound() to obtain an estimate instead.
+      inline bool width_is_deferred() const { return width_deferred_; }
+
+      /// @brief Computes the total width if it was deferred during
+      /// construction
+      void resolve_width();
+
+      /// @brief Returns an inexpensive upper bound on the total width (MeV)
+      /// @details The continuum is split into a few subintervals. On each
+      /// of them, the transmission coefficients are evaluated at the lower
+      /// edge (where the emitted particle is most energetic) and the level
+      /// densities at the upper edge. The bound is exact as long as the
+      /// former do not decrease with the energy of the emitted particle and
+      /// the latter do not decrease with excitation energy.
+      double width_upper_bound() const;
+
       /// @brief Sets the flag that will skip sampling of a final-state
       /// nuclear spin-parity value in do_decay()
       /// @details The skipping functionality should only be used for testing
@@ -299,6 +374,11 @@ namespace marley {
       /// used when integrating over the continuum
       virtual double E_c_max() const = 0;
 
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by this channel, including its excitation energy PDF and CDF
+      /// (once they have been built)
+      size_t memory_usage() const;
+
     protected:
 
       /// Minimum accessible nuclear excitation energy (MeV) in the continuum
@@ -308,10 +388,66 @@ namespace marley {
       /// computing differential fragment (gamma-ray) decay widths
       int l_max_;
 
+      /// @brief Flag that indicates that the total width has not been
+      /// computed yet
+      bool width_deferred_ = false;
+
+      /// @brief Helper function for the constructors of derived classes.
+      /// Computes the total width unless its computation should be deferred
+      /// (see resolve_width()).
+      void initialize_width( bool defer_width );
+
+      /// @brief Builds the Chebyshev polynomial approximant to the
+      /// differential width on the interval [E_c_min_, Exf_max]
+      std::unique_ptr<marley::ChebyshevInterpolatingFunction> build_Exf_pdf(
+        double Exf_max ) const;
+
+      /// @brief Fixed-size approximant used when the numerical settings
+      /// request the default number of Chebyshev points
+      using FixedExfPDF = marley::ChebyshevInterpolant<DEFAULT_N_CHEBYSHEV>;
+
+      /// @brief CDF obtained by integrating a FixedExfPDF
+      using FixedExfCDF = marley::ChebyshevCDF<DEFAULT_N_CHEBYSHEV>;
+
+      /// @brief Returns true if the fixed-size approximants should be used
+      /// in place of ChebyshevInterpolatingFunction objects
+      bool use_fixed_grid() const;
+
+      /// @brief Fixed-size version of build_Exf_pdf()
+      std::unique_ptr<FixedExfPDF> build_fixed_Exf_pdf( double Exf_max ) const;
+
+      /// @brief Scratch storage used while computing differential widths
+      struct WidthScratch {
+
+        /// @param arena Arena from which the storage will be taken (if
+        /// nullptr, then the storage is allocated on the heap)
+        WidthScratch( marley::MonotonicArena* arena );
+
+        /// @brief Final-state level densities for each spin, with one
+        /// vector for each parity
+        std::array<marley::ScratchVector<double>, 2> rhos;
+
+        /// @brief Transmission coefficients
+        marley::ScratchVector<double> Ts;
+      };
+
+      /// @brief Evaluates the differential decay width using transmission
+      /// coefficients computed at the final excitation energy Exf_T and
+      /// level densities computed at the final excitation energy Exf_rho
+      /// @details When both energies are equal, this is the same as
+      /// differential_width(). Using different values allows
+      /// width_upper_bound() to bound the differential width on an interval.
+      virtual double differential_width( double Exf_T, double Exf_rho,
+        bool store_jpi_widths ) const = 0;
+
       /// @brief Table of possible final-state spin-parities together
       /// with their partial differential decay widths
       mutable std::vector<SpinParityWidth> jpi_widths_table_;
 
+      /// @brief Alias table used to sample from jpi_widths_table_
+      /// @details Its storage is reused whenever a new spin-parity is sampled
+      mutable marley::AliasTable jpi_sampler_;
+
       /// @brief Flag that allows skipping the sampling of a final
       /// nuclear spin-parity (useful only for testing purposes)
       mutable bool skip_jpi_sampling_ = false;
@@ -321,6 +457,16 @@ namespace marley {
       /// @details This pointer will be initialized lazily during the
       /// first call to do_decay()
       mutable std::unique_ptr<marley::ChebyshevInterpolatingFunction> Exf_cdf_;
+
+      /// @brief Chebyshev polynomial interpolant to the differential decay
+      /// width, built by compute_total_width() and released once Exf_cdf_
+      /// has been constructed from it
+      mutable std::unique_ptr<marley::ChebyshevInterpolatingFunction> Exf_pdf_;
+
+      /// @brief Versions of Exf_cdf_ and Exf_pdf_ used instead of them when
+      /// use_fixed_grid() is true
+      mutable std::unique_ptr<FixedExfCDF> fixed_Exf_cdf_;
+      mutable std::unique_ptr<FixedExfPDF> fixed_Exf_pdf_;
   };
 
   /// @brief %Fragment emission ExitChannel that leads to a discrete nuclear
@@ -377,21 +523,48 @@ namespace marley {
       /// @copydoc marley::ExitChannel::ExitChannel()
       /// @copydoc marley::ContinuumExitChannel( double, int )
       /// @copydoc marley::FragmentExitChannel( const marley::Fragment& )
+      /// @param defer_width Whether computation of the total width should
+      /// be deferred until resolve_width() is called
       FragmentContinuumExitChannel(int pdgi, int qi, double Exi, int twoJi,
         marley::Parity Pi, double rho_i, marley::StructureDatabase& sdb,
-        double Ec_min, const marley::Fragment& frag)
+        double Ec_min, const marley::Fragment& frag, bool defer_width = false)
         : ExitChannel( pdgi, qi, Exi, twoJi, Pi, rho_i, sdb ),
         ContinuumExitChannel( Ec_min, sdb.get_fragment_l_max() ),
-        FragmentExitChannel( frag )
+        FragmentExitChannel( frag ),
+        ldm_( &sdb.get_level_density_model(remnant_pdg_) ),
+        couplings_( &sdb.get_fragment_continuum_couplings(twoJi, two_s_,
+          l_max_) )
       {
-        this->compute_total_width();
+        this->initialize_width( defer_width );
       }
 
-      virtual double differential_width( double Exf,
-        bool store_jpi_widths = false ) const final override;
+      inline virtual double differential_width( double Exf,
+        bool store_jpi_widths = false ) const final override
+        { return this->differential_width( Exf, Exf, store_jpi_widths ); }
 
       inline virtual double E_c_max() const final override
         { return this->max_Exf(); }
+
+      virtual void differential_widths( const double* Exfs, double* widths,
+        size_t n ) const final override;
+
+    protected:
+
+      virtual double differential_width( double Exf_T, double Exf_rho,
+        bool store_jpi_widths ) const final override;
+
+      /// @brief Helper function for the other differential_width()
+      /// overloads and differential_widths() that uses preallocated scratch
+      /// storage
+      double differential_width( double Exf_T, double Exf_rho,
+        bool store_jpi_widths, WidthScratch& scratch ) const;
+
+      /// @brief Level density model for the final nucleus
+      marley::LevelDensityModel* ldm_;
+
+      /// @brief Allowed (l, two_j, twoJf) combinations for the differential
+      /// width (owned by the StructureDatabase)
+      const marley::SpinCouplingTable* couplings_;
   };
 
   /// @brief %Gamma emission exit channel that leads to the unbound continuum
@@ -404,19 +577,45 @@ namespace marley {
       /// @copydoc marley::ExitChannel::ExitChannel()
       /// @copydoc marley::ContinuumExitChannel( double, int )
       /// @copydoc marley::GammaExitChannel()
+      /// @param defer_width Whether computation of the total width should
+      /// be deferred until resolve_width() is called
       GammaContinuumExitChannel(int pdgi, int qi, double Exi, int twoJi,
         marley::Parity Pi, double rho_i, marley::StructureDatabase& sdb,
-        double Ec_min) : ExitChannel( pdgi, qi, Exi, twoJi, Pi, rho_i, sdb ),
+        double Ec_min, bool defer_width = false)
+        : ExitChannel( pdgi, qi, Exi, twoJi, Pi, rho_i, sdb ),
         ContinuumExitChannel( Ec_min, sdb.get_gamma_l_max() ),
-        GammaExitChannel()
+        GammaExitChannel(), ldm_( &sdb.get_level_density_model(pdgi) ),
+        couplings_( &sdb.get_gamma_continuum_couplings(twoJi, l_max_) )
       {
-        this->compute_total_width();
+        this->initialize_width( defer_width );
       }
 
-      virtual double differential_width( double Exf,
-        bool store_jpi_widths = false ) const final override;
+      inline virtual double differential_width( double Exf,
+        bool store_jpi_widths = false ) const final override
+        { return this->differential_width( Exf, Exf, store_jpi_widths ); }
 
       inline virtual double E_c_max() const final override
         { return Exi_; }
+
+      virtual void differential_widths( const double* Exfs, double* widths,
+        size_t n ) const final override;
+
+    protected:
+
+      virtual double differential_width( double Exf_T, double Exf_rho,
+        bool store_jpi_widths ) const final override;
+
+      /// @brief Helper function for the other differential_width()
+      /// overloads and differential_widths() that uses preallocated scratch
+      /// storage
+      double differential_width( double Exf_T, double Exf_rho,
+        bool store_jpi_widths, WidthScratch& scratch ) const;
+
+      /// @brief Level density model for the nucleus
+      marley::LevelDensityModel* ldm_;
+
+      /// @brief Allowed (multipolarity, twoJf, parity) combinations for the
+      /// differential width (owned by the StructureDatabase)
+      const marley::SpinCouplingTable* couplings_;
   };
 }
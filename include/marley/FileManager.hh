@@ -16,12 +16,21 @@
 
 #pragma once
 #include <functional>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace marley {
 
   /// @brief Singleton class that handles file searches
+  /// @details The contents of each directory searched by find_file() are
+  /// listed only once, and the result of every search (including a failed
+  /// one) is remembered. Repeated requests for data files therefore do not
+  /// touch the filesystem again, which matters when the search path is on a
+  /// network filesystem with slow metadata operations. If files may be added
+  /// to the searched directories during a run, then clear_cache() should be
+  /// called before looking for them.
   class FileManager {
 
     public:
@@ -53,7 +62,9 @@ namespace marley {
 
       /// @brief Searches for a file in the given directories
       /// @details The search is non-recursive, i.e., no subdirectories
-      /// are included in the search
+      /// are included in the search. If base_name already refers to an
+      /// existing file (relative to the current working directory or as an
+      /// absolute path), then it is returned unchanged.
       /// @param base_name The base name (file name without any path)
       /// of the desired file
       /// @param search_dirs A vector of strings specifying the directories
@@ -102,6 +113,16 @@ namespace marley {
       /// @brief Returns the path to the root MARLEY folder
       inline std::string marley_dir() const { return marley_dir_; }
 
+      /// @brief Lists the contents of every directory in a search path
+      /// so that later calls to find_file() need no filesystem access
+      /// @param search_path A string containing a ':'-delimited list
+      /// of directories to list
+      void prefetch(const std::string& search_path
+        = FileManager::default_search_path_) const;
+
+      /// @brief Forgets all directory listings and search results
+      void clear_cache() const;
+
     protected:
 
       /// @brief Create the singleton FileManager object
@@ -121,9 +142,30 @@ namespace marley {
       static bool dir_iterate(const std::string& dir_name,
         const std::function<bool(const std::string&, const std::string&)>& func);
 
+      /// @brief Helper function for find_file() and prefetch(). Returns the
+      /// regular files in a directory, keyed by base name, listing the
+      /// directory if this has not been done before.
+      /// @details The caller must hold a lock on cache_mutex_
+      const std::unordered_map<std::string, std::string>& dir_listing(
+        const std::string& dir_name) const;
+
       /// @brief By default, use this search path when looking for files
       static std::string default_search_path_;
 
+      /// @brief Mutex that guards dir_listings_ and found_files_
+      /// @details The singleton may be used by several threads at once
+      /// (e.g., when decay schemes are loaded lazily by worker threads)
+      mutable std::mutex cache_mutex_;
+
+      /// @brief Full paths to the regular files in each directory that
+      /// has been listed, keyed by directory name and then by base name
+      mutable std::unordered_map<std::string,
+        std::unordered_map<std::string, std::string> > dir_listings_;
+
+      /// @brief Results of previous calls to find_file(), keyed by the base
+      /// name followed by the searched directories
+      mutable std::unordered_map<std::string, std::string> found_files_;
+
       /// @brief Stores the value of the MARLEY environment variable
       /// (which points to the root folder of the source code distribution)
       std::string marley_dir_;
@@ -15,6 +15,7 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <cstddef>
 
 namespace marley {
 
@@ -66,6 +67,17 @@ namespace marley {
       virtual double transmission_coefficient(TransitionType type, int l,
         double e_gamma) = 0;
 
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by the model (e.g., for cached tables)
+      /// @details The default implementation returns zero
+      virtual size_t memory_usage() const { return 0u; }
+
+      /// @brief Get the atomic number
+      inline int Z() const { return Z_; }
+
+      /// @brief Get the mass number
+      inline int A() const { return A_; }
+
     protected:
 
       /// @brief Check that l > 0 and throw a marley::Error if it is not.
@@ -15,19 +15,33 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <array>
+#include <cmath>
+#include <functional>
 #include <limits>
+#include <map>
 #include <memory>
 #include <random>
 #include <sstream>
 #include <vector>
 
+#include "marley/AliasTable.hh"
+#include "marley/ChebyshevInterpolant.hh"
+#include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/GammaStrengthFunctionModel.hh"
+#include "marley/Event.hh"
+#include "marley/Instrumentation.hh"
+#include "marley/EventBatch.hh"
+#include "marley/EventSink.hh"
 #include "marley/NeutrinoSource.hh"
 #include "marley/NuclearReaction.hh"
+#include "marley/NucleusDecayer.hh"
 #include "marley/LevelDensityModel.hh"
+#include "marley/MonotonicArena.hh"
 #include "marley/OpticalModel.hh"
 #include "marley/Parity.hh"
 #include "marley/ProjectileDirectionRotator.hh"
+#include "marley/RandomEngine.hh"
 #include "marley/RotationMatrix.hh"
 #include "marley/StructureDatabase.hh"
 #include "marley/Target.hh"
@@ -35,7 +49,6 @@
 
 namespace marley {
 
-  class ChebyshevInterpolatingFunction;
   class JSONConfig;
 
   /// @brief The MARLEY Event generator
@@ -54,6 +67,61 @@ namespace marley {
       /// and StructureDatabase objects owned by this Generator
       marley::Event create_event();
 
+      /// @brief Create an Event in place, replacing the previous contents
+      /// of ev
+      /// @details This is equivalent to ev = create_event(), but it allows
+      /// the storage owned by ev to be reused when it is called repeatedly
+      void create_event( marley::Event& ev );
+
+      /// @brief Creates only the primary interaction for a new event,
+      /// replacing the previous contents of ev
+      /// @details Together with finish_event(), this splits the work done
+      /// by create_event() into two stages that may run on different
+      /// Generator objects built from the same configuration (e.g., in the
+      /// pipelined mode of the marley executable). The second stage draws
+      /// its random numbers from a separate subsequence for the event, so
+      /// the results do not depend on which Generator finishes the event,
+      /// but they differ from those of create_event(). The counter-based
+      /// random number engine must be in use.
+      /// @returns The event number that must be passed to finish_event()
+      uint64_t create_primary_event( marley::Event& ev );
+
+      /// @brief Applies the nuclear de-excitations and the projectile
+      /// direction rotation to an event made by create_primary_event()
+      /// @param ev The event to finish
+      /// @param event_num The value returned by create_primary_event()
+      void finish_event( marley::Event& ev, uint64_t event_num );
+
+      /// @brief Create a batch of events, passing each of them in turn to an
+      /// EventSink
+      /// @details A single scratch Event object is reused for the entire
+      /// batch, so the EventSink must copy or move any events that it needs
+      /// to retain.
+      /// @param num_events The number of events to create
+      /// @param sink The EventSink that will receive the completed events
+      void create_events( size_t num_events, marley::EventSink& sink );
+
+      /// @brief Create a batch of events, storing them in a std::vector
+      /// @details Any previous contents of the vector are replaced. Event
+      /// objects already present in the vector (e.g., from a previous call
+      /// to this function) are reused rather than reallocated.
+      /// @param num_events The number of events to create
+      /// @param[out] events Vector that will be loaded with the new events
+      void create_events( size_t num_events,
+        std::vector<marley::Event>& events );
+
+      /// @brief Create a batch of events and return them in a std::vector
+      /// @param num_events The number of events to create
+      std::vector<marley::Event> create_events( size_t num_events );
+
+      /// @brief Create a batch of events, storing them in structure-of-arrays
+      /// form
+      /// @details Any previous contents of the EventBatch are replaced. Its
+      /// column storage is reused rather than reallocated.
+      /// @param num_events The number of events to create
+      /// @param[out] batch EventBatch that will be loaded with the new events
+      void create_events( size_t num_events, marley::EventBatch& batch );
+
       /// @brief Get the seed used to initialize this Generator
       inline uint_fast64_t get_seed() const;
 
@@ -69,13 +137,60 @@ namespace marley {
       /// this Generator
       std::string get_state_string() const;
 
+      /// @brief Selects the random number engine to use
+      /// @param use_it If true, the counter-based Philox engine will be
+      /// used. If false, the 64-bit Mersenne Twister will be used (default).
+      /// @details With the counter-based engine, the random numbers for
+      /// each event are drawn from an independent subsequence identified by
+      /// the seed, the stream ID, and the event number. Any single event can
+      /// therefore be regenerated by calling set_event_number() before
+      /// create_event(), and runs that use different stream IDs are
+      /// guaranteed not to share random numbers.
+      inline void set_counter_based_rng(bool use_it);
+
+      /// @brief Returns true if the counter-based random number engine
+      /// is in use, or false otherwise
+      inline bool counter_based_rng() const;
+
+      /// @brief Sets the stream ID used by the counter-based random number
+      /// engine
+      inline void set_rng_stream(uint64_t stream_id);
+
+      /// @brief Gets the stream ID used by the counter-based random number
+      /// engine
+      inline uint64_t get_rng_stream() const;
+
+      /// @brief Sets the number of the next event to be created
+      /// @details This affects the random numbers used by create_event()
+      /// only when the counter-based random number engine is active
+      inline void set_event_number(uint64_t event_num);
+
+      /// @brief Gets the number of the next event to be created
+      inline uint64_t get_event_number() const;
+
       /// @brief Sample a random number uniformly on either [min, max) or
       /// [min, max]
       /// @param min Lower bound of the sampling interval
       /// @param max Upper bound of the sampling interval
       /// @param inclusive Whether the upper bound should be included (true)
       /// or excluded (false) from the possible sampling outcomes
-      double uniform_random_double(double min, double max, bool inclusive);
+      inline double uniform_random_double(double min, double max,
+        bool inclusive);
+
+      /// @brief Sample a random number uniformly on [0, 1)
+      /// @details This is the building block for all of the uniform sampling
+      /// helpers. It consumes exactly one output of the random number engine
+      /// and gives the same result as std::generate_canonical, so that
+      /// switching between the helpers leaves the generated events unchanged.
+      inline double uniform01();
+
+      /// @brief Sample a random number uniformly on [min, max)
+      inline double uniform(double min, double max);
+
+      /// @brief Sample an isotropic direction
+      /// @param[out] cos_theta Polar cosine, sampled uniformly on [-1, 1]
+      /// @param[out] phi Azimuthal angle, sampled uniformly on [0, 2&pi;)
+      inline void isotropic_direction(double& cos_theta, double& phi);
 
       /// @brief Sample from a given 1D probability density function f(x) on
       /// the interval [xmin, xmax] using a simple rejection method
@@ -90,6 +205,15 @@ namespace marley {
         double xmin, double xmax, double& fmax, double safety_factor = 1.01,
         double max_search_tolerance = DEFAULT_REJECTION_SAMPLING_TOLERANCE_);
 
+      /// @brief Templated version of rejection_sample() that accepts any
+      /// callable object
+      /// @details Passing a lambda directly (rather than wrapping it in a
+      /// std::function) allows the compiler to inline it into the sampling
+      /// loop. The std::function overload is a thin wrapper around this one.
+      template <typename Function> double rejection_sample(const Function& f,
+        double xmin, double xmax, double& fmax, double safety_factor = 1.01,
+        double max_search_tolerance = DEFAULT_REJECTION_SAMPLING_TOLERANCE_);
+
       /// @brief Sample from a given 1D cumulative density function cdf(x) on
       /// the interval [xmin, xmax] using bisection
       /// @param cdf Cumulative density function to use for sampling
@@ -109,10 +233,34 @@ namespace marley {
       double inverse_transform_sample(const std::function<double(double)>& f,
         double xmin, double xmax, double bisection_tolerance = 1e-12);
 
+      /// @brief Sample from a given fixed-size cumulative density function on
+      /// the interval [xmin, xmax] using its inverse table
+      /// @param cdf Cumulative density function to use for sampling
+      /// @param xmin Lower bound of the sampling interval
+      /// @param xmax Upper bound of the sampling interval
+      /// @return Sampled value of x
+      template <size_t N> double inverse_transform_sample(
+        const marley::ChebyshevCDF<N>& cdf, double xmin, double xmax,
+        double bisection_tolerance = 1e-12);
+
       /// @brief Get a reference to the StructureDatabase owned by this
       /// Generator
       marley::StructureDatabase& get_structure_db();
 
+      /// @brief Get a shared pointer to the StructureDatabase used by this
+      /// Generator
+      inline std::shared_ptr<marley::StructureDatabase>
+        get_shared_structure_db() const { return structure_db_; }
+
+      /// @brief Replace the StructureDatabase used by this Generator
+      /// @details This allows several Generator objects to share a single
+      /// database. If they are used by different threads, then the database
+      /// must be in concurrent mode (see
+      /// marley::StructureDatabase::set_concurrent()). Since the existing
+      /// reactions may refer to the old database, this function must be
+      /// called before any reactions are added.
+      void set_structure_db( std::shared_ptr<marley::StructureDatabase> sdb );
+
       /// @brief Get a const reference to the vector of Reaction objects
       /// owned by this Generator
       inline const std::vector< std::unique_ptr<marley::Reaction> >&
@@ -125,11 +273,117 @@ namespace marley {
       /// @brief Clear the vector of Reaction objects owned by this Generator
       void clear_reactions();
 
+      /// @brief Find the largest excitation energy (MeV) that the residue of
+      /// each nuclear reaction can reach using projectiles from the source
+      /// @details This is used to choose which nuclear model tables to
+      /// precompute (see StructureDatabase::precompute_model_tables())
+      /// @return Excitation energies keyed by residue PDG code
+      std::map<int, double> max_residue_excitation_energies() const;
+
+      /// @brief Fill the caches used by the nuclear de-excitation step
+      /// before any events are generated
+      /// @details The nuclear model tables for every nuclide that the
+      /// residues can reach are filled in parallel (see
+      /// StructureDatabase::precompute_model_tables()), and then
+      /// prewarm_decays() is called. The time taken by each event is then
+      /// about the same from the first one onward. The generated events are
+      /// unchanged.
+      /// @param num_threads Number of threads to use for the tables, or zero
+      /// to use one per hardware thread
+      void prewarm(unsigned num_threads = 0u);
+
+      /// @brief Builds the Hauser-Feshbach decays for all initial residue
+      /// states that the configured reactions may produce (see
+      /// NuclearReaction::prewarm_decays())
+      /// @details In concurrent mode, each Generator keeps its own decay
+      /// cache, so this should be called for every Generator that shares
+      /// the StructureDatabase. Different Generators may do so at the same
+      /// time.
+      void prewarm_decays();
+
       /// @brief Sample a Reaction and an energy for the reacting neutrino
       /// @param[out] E Total energy of the neutrino undergoing the reaction
       /// @return Reference to the sampled Reaction owned by this Generator
       marley::Reaction& sample_reaction(double& E);
 
+      /// @brief Sample a Reaction and an energy for the reacting neutrino,
+      /// applying the configured reaction biases
+      /// @param[out] E Total energy of the neutrino undergoing the reaction
+      /// @param[out] weight Event weight that compensates for the bias
+      /// applied to the choice of Reaction
+      /// @return Reference to the sampled Reaction owned by this Generator
+      marley::Reaction& sample_reaction(double& E, double& weight);
+
+      /// @brief Type of the callback used by set_event_filter()
+      using EventFilter = std::function<bool(const marley::Event&)>;
+
+      /// @brief Keep only events whose primary interaction passes a test
+      /// @details The filter is called on each primary interaction before
+      /// any de-excitation or rotation is done. Rejected interactions are
+      /// discarded and resampled, so that the later stages are only run for
+      /// events that will be kept. Since the filtered events are a subset of
+      /// all possible ones, the flux-averaged total cross section must be
+      /// multiplied by filter_accepted_fraction() to normalize them.
+      /// Setting a new filter resets the acceptance counters, and an empty
+      /// filter disables filtering.
+      /// @param filter Callback that returns true if an event should be
+      /// kept
+      void set_event_filter( EventFilter filter );
+
+      /// @brief Returns true if an event filter has been configured, or
+      /// false otherwise
+      inline bool has_event_filter() const;
+
+      /// @brief Number of primary interactions tested by the event filter
+      inline uint64_t filter_trials() const;
+
+      /// @brief Number of primary interactions accepted by the event filter
+      inline uint64_t filter_accepted() const;
+
+      /// @brief Sum of the event weights for the primary interactions
+      /// accepted by the event filter
+      inline double filter_accepted_weight() const;
+
+      /// @brief Weighted fraction of primary interactions accepted by the
+      /// event filter so far
+      /// @details This is unity if no interactions have been tested
+      double filter_accepted_fraction() const;
+
+      /// @brief Make a Reaction more or less likely to be sampled
+      /// @details Biasing is used to oversample rare reactions. The
+      /// probability of choosing each Reaction is multiplied by its bias
+      /// factor (and then renormalized), while the distribution of reacting
+      /// neutrino energies is left unchanged. Each Event is given a weight
+      /// (see marley::Event::weight()) that compensates for the bias, so
+      /// that weighted distributions are the same as unbiased ones.
+      /// @param index Position of the Reaction in the vector returned by
+      /// get_reactions()
+      /// @param factor Positive bias factor (unity disables biasing)
+      void set_reaction_bias(size_t index, double factor);
+
+      /// @brief Get the bias factor for a Reaction
+      /// @param index Position of the Reaction in the vector returned by
+      /// get_reactions()
+      double reaction_bias(size_t index) const;
+
+      /// @brief Make nuclear de-excitations that emit a given particle
+      /// more or less likely to be sampled
+      /// @details The partial decay widths of the Hauser-Feshbach exit
+      /// channels that emit the particle are multiplied by the factor
+      /// when sampling. The event weight compensates for the bias as in
+      /// set_reaction_bias().
+      /// @param pdg PDG code of the emitted particle
+      /// @param factor Positive bias factor (unity disables biasing)
+      void set_exit_channel_bias(int pdg, double factor);
+
+      /// @brief Get the bias factor for Hauser-Feshbach exit channels that
+      /// emit a given particle
+      double exit_channel_bias(int pdg) const;
+
+      /// @brief Returns true if any exit channel bias factors have been
+      /// configured, or false otherwise
+      inline bool has_exit_channel_biases() const;
+
       /// @brief Probability density function that describes the distribution
       /// of reacting neutrino energies
       /// @details This function computes the cross-section weighted neutrino
@@ -157,6 +411,54 @@ namespace marley {
       /// @param source A pointer to the new Target to use
       void set_target(std::unique_ptr<marley::Target> target);
 
+      /// @brief Enable or disable a Reaction
+      /// @details A disabled Reaction is never sampled and does not
+      /// contribute to any total cross section computed by this Generator.
+      /// It keeps its cross section tables, so it may be enabled again
+      /// later at no cost. All reactions are enabled by default.
+      /// @param index Position of the Reaction in the vector returned by
+      /// get_reactions()
+      /// @param enabled Whether the Reaction should be used
+      void set_reaction_enabled(size_t index, bool enabled);
+
+      /// @brief Returns true if a Reaction is enabled or false otherwise
+      /// @param index Position of the Reaction in the vector returned by
+      /// get_reactions()
+      bool reaction_enabled(size_t index) const;
+
+      /// @brief Set of changes applied together by reconfigure()
+      struct Reconfiguration {
+
+        /// @brief New NeutrinoSource, or nullptr to keep the current one
+        std::unique_ptr<marley::NeutrinoSource> source;
+
+        /// @brief New Target, or nullptr to keep the current one
+        std::unique_ptr<marley::Target> target;
+
+        /// @brief Whether to replace the incident neutrino direction with
+        /// direction
+        bool change_direction = false;
+
+        /// @brief New incident neutrino direction (see
+        /// set_neutrino_direction())
+        std::array<double, 3> direction = {{ 0., 0., 1. }};
+
+        /// @brief New enabled state for the reactions, keyed by their
+        /// positions in the vector returned by get_reactions()
+        std::map<size_t, bool> reactions_enabled;
+      };
+
+      /// @brief Changes the source, target, incident direction, and enabled
+      /// reactions of an existing Generator
+      /// @details This is much cheaper than building a new Generator with
+      /// JSONConfig::create_generator(). The reactions, the StructureDatabase,
+      /// and all of their caches (cross section tables, nuclear model
+      /// tables, and cached Hauser-Feshbach decays) are kept. Only the
+      /// tables used to sample reacting neutrino energies are rebuilt, and
+      /// that happens once after all of the changes have been made (and
+      /// not at all if only the direction changes).
+      void reconfigure(Reconfiguration changes);
+
       /// @brief Get a const reference to the Target owned by this
       /// Generator
       /// @details Throws a marley::Error if this Generator does not own a
@@ -164,27 +466,28 @@ namespace marley {
       const marley::Target& get_target() const;
 
       /// @brief Sample from an arbitrary probability distribution (defined
-      /// here as any object that implements an operator()(std::mt19937_64&)
-      /// function)
+      /// here as any object that implements an
+      /// operator()(marley::RandomEngine&) function)
       /// @detail This template function is based on
       /// https://stackoverflow.com/a/9154394/4081973
       template <class RandomNumberDistribution>
         inline auto sample_from_distribution(RandomNumberDistribution& rnd)
         -> decltype( std::declval<RandomNumberDistribution&>().operator()(
-        std::declval<std::mt19937_64&>()) )
+        std::declval<marley::RandomEngine&>()) )
       {
         return rnd(rand_gen_);
       }
 
       /// @brief Sample from an arbitrary probability distribution (defined
       /// here as any object that implements an
-      /// operator()(std::mt19937_64&, const ParamType&) function) using the
-      /// parameters params
+      /// operator()(marley::RandomEngine&, const ParamType&) function) using
+      /// the parameters params
       template <class RandomNumberDistribution, typename ParamType>
         inline auto sample_from_distribution(RandomNumberDistribution& rnd,
         const ParamType& params) -> decltype(
         std::declval<RandomNumberDistribution&>().operator()(
-        std::declval<std::mt19937_64&>(), std::declval<const ParamType&>() ) )
+        std::declval<marley::RandomEngine&>(),
+        std::declval<const ParamType&>() ) )
       {
         return rnd(rand_gen_, params);
       }
@@ -220,6 +523,55 @@ namespace marley {
       /// @return Total cross section (MeV<sup> -2</sup>)
       double flux_averaged_total_xs() const;
 
+      /// @brief Sampling schemes that may be used by
+      /// estimate_flux_averaged_total_xs()
+      enum class FluxAverageMethod {
+        Stratified, ///< Two uniform points in each of a set of equal-width
+                    ///< energy strata
+        QuasiMonteCarlo ///< Randomly shifted replicates of the base-2
+                        ///< van der Corput (1D Sobol) sequence
+      };
+
+      /// @brief Result of estimate_flux_averaged_total_xs()
+      struct FluxAverageEstimate {
+        double value = 0.; ///< Flux-averaged total cross section
+                           ///< (MeV<sup> -2</sup>)
+        double error = 0.; ///< Estimated standard error on the value
+        size_t num_evaluations = 0u; ///< Number of energies at which the
+                                     ///< total cross section was computed
+      };
+
+      /// @brief Estimates the flux-averaged total cross section by sampling
+      /// the neutrino energy, providing an uncertainty on the result
+      /// @details This gives the same quantity as flux_averaged_total_xs(),
+      /// but it does not rely on the fixed nodes used to normalize the
+      /// energy distribution (or, for a HaloDMSource, on the median speed of
+      /// each velocity bin). For a HaloDMSource, the points are spread over
+      /// the cumulative speed distribution. For other sources with an energy
+      /// spectrum, they are spread evenly over the energy range. Both schemes
+      /// converge much faster than plain Monte Carlo for smooth cross
+      /// sections. The random shifts come from a private engine seeded with
+      /// get_seed(), so calling this function does not change the events
+      /// that are generated. Monoenergetic sources need no sampling, so the
+      /// exact value is returned with zero error.
+      /// @param method Sampling scheme to use
+      /// @param num_points Total number of cross section evaluations. This
+      /// is rounded up to a multiple of two (Stratified) or of num_replicates
+      /// (QuasiMonteCarlo).
+      /// @param num_replicates Number of independent randomizations of the
+      /// quasi-random sequence used to estimate the error (QuasiMonteCarlo
+      /// only)
+      FluxAverageEstimate estimate_flux_averaged_total_xs(
+        FluxAverageMethod method, size_t num_points,
+        size_t num_replicates = 16u) const;
+
+      /// @brief Get the dark matter particle speed (in units of c) used for
+      /// the most recent event
+      /// @details For a HaloDMSource, this is sampled for each event from
+      /// within the chosen velocity bin. The cross sections for the event
+      /// are evaluated at the median speed of that bin.
+      inline double dm_velocity() const { return dm_velocity_; }
+
       /// @brief Computes the total cross section at fixed energy for all
       /// configured reactions involving a particular target atom.
       /// @details Atom fractions in the owned Target are ignored by this
@@ -245,7 +597,21 @@ namespace marley {
       /// @param KEa The kinetic energy of the projectile (MeV)
       /// @return Abundance-weighted total cross section (MeV<sup> -2</sup> / atom)
       double total_xs(int pdg_a, double KEa) const;
-      double total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const;
+      double total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff,
+        double dm_velocity = marley_utils::DM_DEFAULT_VELOCITY) const;
+
+      /// @brief Computes the abundance-weighted total cross section for all
+      /// configured reactions at each of n projectile kinetic energies
+      /// @details Gives the same results as calling total_xs( int, double )
+      /// for each energy, but the lookups of the projectile and target atom
+      /// fraction are done once per reaction rather than once per energy
+      /// @param pdg_a The PDG code for the projectile
+      /// @param[in] KEas Array of projectile kinetic energies (MeV)
+      /// @param[out] out Array that will be loaded with the abundance-weighted
+      /// total cross sections (MeV<sup> -2</sup> / atom)
+      /// @param n Length of the KEas and out arrays
+      void total_xs_batch(int pdg_a, const double* KEas, double* out,
+        size_t n) const;
 
       /// @brief Creates an event object for a fixed projectile species,
       /// kinetic energy, and atomic target
@@ -276,6 +642,11 @@ namespace marley {
       /// use in E_pdf()
       void normalize_E_pdf();
 
+      /// @brief Helper function for rejection_sample() that warns the user
+      /// and updates fmax when a PDF value exceeds the estimated maximum
+      void handle_rejection_fmax_exceeded(double val, double x, double& fmax,
+        double safety_factor) const;
+
       /// @brief Print the MARLEY logo (called once during construction of
       /// the first Generator object) to any active Logger streams
       void print_logo();
@@ -283,8 +654,9 @@ namespace marley {
       /// @brief Seed for the random number generator
       uint_fast64_t seed_;
 
-      /// @brief 64-bit Mersenne Twister random number generator
-      std::mt19937_64 rand_gen_;
+      /// @brief Random number engine (either a 64-bit Mersenne Twister or
+      /// a counter-based Philox engine)
+      marley::RandomEngine rand_gen_;
 
       /// @brief Default stopping tolerance for rejection sampling
       static constexpr double DEFAULT_REJECTION_SAMPLING_TOLERANCE_ = 1e-8;
@@ -299,9 +671,18 @@ namespace marley {
       /// composite)
       std::unique_ptr<marley::Target> target_;
 
+      /// @brief Scratch memory for the calculations needed to create a
+      /// single event
+      /// @details This is handed to the StructureDatabase for use by the
+      /// decay code and is reset at the start of each event. It is stored
+      /// on the heap so that its address does not change if the Generator
+      /// is moved.
+      std::unique_ptr<marley::MonotonicArena> event_arena_;
+
       /// @brief StructureDatabase used to simulate nuclear de-excitations
       /// when creating Event objects
-      std::unique_ptr<marley::StructureDatabase> structure_db_;
+      /// @details This may be shared with other Generator objects
+      std::shared_ptr<marley::StructureDatabase> structure_db_;
 
       /// @brief Reaction(s) used to sample reacting neutrino energies
       std::vector< std::unique_ptr<marley::Reaction> > reactions_;
@@ -312,8 +693,81 @@ namespace marley {
       /// are therefore updated with every call to E_pdf().
       std::vector<double> total_xs_values_;
 
-      /// @brief Discrete distribution used for Reaction sampling
-      std::discrete_distribution<size_t> r_index_dist_;
+      /// @brief Atom fraction in the Target of the target atom for each
+      /// element of reactions_ (unity if there is no Target)
+      std::vector<double> reaction_atom_fractions_;
+
+      /// @brief Weight applied to the total cross section of each element of
+      /// reactions_ when sampling projectiles from the source. This is the
+      /// atom fraction, or zero for reactions that involve a different
+      /// projectile.
+      std::vector<double> source_reaction_weights_;
+
+      /// @brief Recomputes reaction_atom_fractions_ and
+      /// source_reaction_weights_ after a change to the reactions, target,
+      /// or source
+      /// @details Disabled reactions are given weights of zero
+      void update_reaction_weights();
+
+      /// @brief Alias table used for Reaction sampling
+      /// @details Its storage is reused each time that a Reaction is sampled
+      marley::AliasTable r_index_table_;
+
+      /// @brief Bias factor for each element of reactions_
+      std::vector<double> reaction_biases_;
+
+      /// @brief Whether each element of reactions_ is enabled
+      std::vector<bool> reactions_enabled_;
+
+      /// @brief Optional test applied to each primary interaction
+      EventFilter event_filter_;
+
+      /// @brief Counters used to compute filter_accepted_fraction()
+      uint64_t filter_trials_ = 0u;
+      uint64_t filter_accepted_ = 0u;
+      double filter_accepted_weight_ = 0.;
+
+      /// @brief Maximum number of consecutive primary interactions that may
+      /// be rejected by the event filter before giving up
+      static constexpr uint64_t MAX_FILTER_TRIALS_ = 1000000u;
+
+      /// @brief Helper function for create_event() and
+      /// create_primary_event(). Samples primary interactions in ev until
+      /// one passes the event filter (if any).
+      /// @param event_num Number of the event being created, used to choose
+      /// the random numbers for any resampled interactions
+      void sample_primary_event( marley::Event& ev, uint64_t event_num );
+
+      /// @brief Samples a reaction and creates a single primary interaction
+      /// in ev
+      void sample_one_primary_event( marley::Event& ev );
+
+      /// @brief Scratch storage for the biased cross sections used to
+      /// sample a Reaction
+      std::vector<double> biased_xs_values_;
+
+      /// @brief Scratch storage for the indices of the reactions that can
+      /// handle the initial state requested by create_event( int, double,
+      /// int, const std::array<double, 3>& )
+      std::vector<size_t> external_r_indices_;
+
+      /// @brief Scratch storage for the total cross sections of the
+      /// reactions listed in external_r_indices_
+      std::vector<double> external_xs_values_;
+
+      /// @brief Bias factors for Hauser-Feshbach exit channels, keyed by
+      /// the PDG code of the emitted particle
+      std::map<int, double> exit_channel_biases_;
+
+      /// @brief Samples an index from a set of reaction cross sections,
+      /// applying the configured reaction biases
+      /// @param xsecs Total cross section for each candidate Reaction
+      /// @param indices Position in reactions_ of each candidate Reaction,
+      /// or nullptr if the candidates are all elements of reactions_
+      /// @param[out] weight Event weight that compensates for the bias
+      /// @return Position of the sampled candidate in xsecs
+      size_t sample_reaction_index(const std::vector<double>& xsecs,
+        const std::vector<size_t>* indices, double& weight);
 
       /// @brief Whether the generator should weight the incident
       /// neutrino spectrum by the reaction cross section(s)
@@ -321,26 +775,89 @@ namespace marley {
       /// are doing!
       bool weight_flux_ = true;
 
-      /// @brief Current estimate of the maximum value of E_pdf(),
-      /// the probability density used for sampling reacting neutrino
-      /// energies.
-      /// @details This variable is used to double-check the validity
-      /// of the estimated maximum during rejection sampling
-      double E_pdf_max_;
-
-      /// @brief When E_pdf(), the probability density used for
-      /// sampling reacting neutrino energies, is changed or
-      /// initialized for the first time, E_pdf_max_ is set
-      /// to this value.
-      double E_PDF_MAX_DEFAULT_ = marley_utils::UNKNOWN_MAX;
-
-      /// @brief Sets the default value of E_pdf_max_
-      /// @details This function is used only in cases where the user
-      /// has provided their own estimate of the PDF maximum (likely
-      /// because automatic estimation failed)
-      inline void set_default_E_pdf_max( double def_max ) {
-        E_PDF_MAX_DEFAULT_ = def_max;
-      }
+      /// @brief Number of Chebyshev grid points used when tabulating
+      /// E_pdf() in normalize_E_pdf()
+      static constexpr size_t E_PDF_N_CHEBYSHEV_ = 256u;
+
+      /// @brief Number of energy grid points used to tabulate the
+      /// flux-weighted total cross section for each bin of a
+      /// TimeBinnedNeutrinoSource
+      static constexpr size_t TIME_BIN_ENERGY_POINTS_ = 512u;
+
+      /// @brief Lowest energy (MeV) on the grid used for the time bin tables
+      double time_bin_Emin_ = 0.;
+
+      /// @brief Spacing (MeV) of the grid used for the time bin tables
+      double time_bin_dE_ = 0.;
+
+      /// @brief Atom-fraction-weighted total cross section at each point on
+      /// the energy grid used for the time bin tables
+      std::vector<double> time_bin_xs_;
+
+      /// @brief Cumulative integral of the flux-weighted total cross section
+      /// over the energy grid for each time bin
+      /// @details The entries for bin b occupy the indices from
+      /// b*TIME_BIN_ENERGY_POINTS_ up to (but not including)
+      /// (b + 1)*TIME_BIN_ENERGY_POINTS_.
+      std::vector<double> time_bin_cdfs_;
+
+      /// @brief Alias table used to sample a time bin
+      /// @details This is empty unless the source is a
+      /// TimeBinnedNeutrinoSource.
+      marley::AliasTable time_bin_table_;
+
+      /// @brief Emission time sampled for the current event
+      double sampled_time_ = 0.;
+
+      /// @brief Tabulates the flux-weighted total cross section for each bin
+      /// of a time-dependent source and updates norm_
+      void build_time_bin_tables(
+        const marley::TimeBinnedNeutrinoSource& tbs );
+
+      /// @brief Discards the tables built by build_time_bin_tables()
+      void clear_time_bin_tables();
+
+      /// @brief Samples a time bin and a reacting neutrino energy (MeV) from
+      /// the tables built by build_time_bin_tables()
+      /// @details The sampled emission time is stored in sampled_time_.
+      double sample_time_binned_energy();
+
+      /// @brief Atom-fraction-weighted dark matter total cross section for
+      /// each reaction, evaluated at the median speed of each velocity bin
+      /// of a HaloDMSource
+      /// @details The entries for bin b occupy the indices from
+      /// b*reactions_.size() up to (but not including)
+      /// (b + 1)*reactions_.size().
+      std::vector<double> dm_bin_xs_;
+
+      /// @brief Alias table used to sample a dark matter velocity bin
+      /// @details This is empty unless the source is a HaloDMSource.
+      marley::AliasTable dm_bin_table_;
+
+      /// @brief Dark matter speed (c) sampled for the current event
+      double dm_velocity_ = marley_utils::DM_DEFAULT_VELOCITY;
+
+      /// @brief Dark matter speed (c) used to compute the cross sections for
+      /// the current event
+      double dm_xs_velocity_ = marley_utils::DM_DEFAULT_VELOCITY;
+
+      /// @brief Evaluates the dark matter cross sections in each velocity
+      /// bin of a HaloDMSource and updates norm_
+      void build_dm_velocity_tables( const marley::HaloDMSource& halo );
+
+      /// @brief Discards the tables built by build_dm_velocity_tables()
+      void clear_dm_velocity_tables();
+
+      /// @brief Updates total_xs_values_ at the neutrino energy E (MeV) and
+      /// returns their sum
+      double update_total_xs_values(double E);
+
+      /// @brief Precomputed cumulative density function for E_pdf(), used
+      /// to sample reacting neutrino energies by inverse transform
+      /// @details This is rebuilt by normalize_E_pdf() whenever the source,
+      /// target, or reactions change. It is left empty for monoenergetic
+      /// sources.
+      std::unique_ptr< marley::ChebyshevCDF<E_PDF_N_CHEBYSHEV_> > E_pdf_cdf_;
 
       /// @brief Flag manipulated by JSONConfig to prevent premature
       /// normalization of E_pdf() during construction of a Generator
@@ -351,6 +868,21 @@ namespace marley {
       /// the configured projectile direction
       marley::ProjectileDirectionRotator rotator_;
 
+      /// @brief EventProcessor that applies nuclear de-excitations to the
+      /// events created by this Generator
+      marley::NucleusDecayer decayer_;
+
+      /// @brief Scratch Event reused by create_events() when filling an
+      /// EventSink
+      marley::Event scratch_event_;
+
+      /// @brief Helper object used to rotate events produced by
+      /// create_event( int, double, int, const std::array<double, 3>& )
+      /// @details This is kept separate from rotator_ so that the
+      /// configured projectile direction is not altered by calls that
+      /// supply their own direction 3-vector
+      marley::ProjectileDirectionRotator external_rotator_;
+
       /// @brief Flag that controls whether de-excitations are applied
       /// after two-two scatters are simulated
       /// @details This should be set to true except under unusual
@@ -386,9 +918,147 @@ namespace marley {
   inline const std::vector<std::unique_ptr<marley::Reaction> >&
     Generator::get_reactions() const { return reactions_; }
 
+  inline bool Generator::has_exit_channel_biases() const
+    { return !exit_channel_biases_.empty(); }
+
+  inline bool Generator::has_event_filter() const
+    { return static_cast<bool>( event_filter_ ); }
+
+  inline uint64_t Generator::filter_trials() const { return filter_trials_; }
+
+  inline uint64_t Generator::filter_accepted() const
+    { return filter_accepted_; }
+
+  inline double Generator::filter_accepted_weight() const
+    { return filter_accepted_weight_; }
+
   inline const std::array<double, 3>& Generator::neutrino_direction()
     { return rotator_.projectile_direction(); }
 
   inline void Generator::set_do_deexcitations( bool do_them )
     { do_deexcitations_ = do_them; }
+
+  inline void Generator::set_counter_based_rng( bool use_it )
+    { rand_gen_.set_counter_based( use_it ); }
+
+  inline bool Generator::counter_based_rng() const
+    { return rand_gen_.counter_based(); }
+
+  inline void Generator::set_rng_stream( uint64_t stream_id )
+    { rand_gen_.set_stream_id( stream_id ); }
+
+  inline uint64_t Generator::get_rng_stream() const
+    { return rand_gen_.stream_id(); }
+
+  inline void Generator::set_event_number( uint64_t event_num )
+    { rand_gen_.set_event_number( event_num ); }
+
+  inline uint64_t Generator::get_event_number() const
+    { return rand_gen_.event_number(); }
+
+  inline double Generator::uniform01() {
+    // Scale by 2^(-64), which maps the full range of the 64-bit engine
+    // output onto [0, 1]. Rounding to double precision can yield exactly
+    // one for the largest outputs, so fold that case back into [0, 1).
+    static_assert( marley::RandomEngine::min() == 0u
+      && marley::RandomEngine::max()
+      == std::numeric_limits<uint64_t>::max(), "uniform01() assumes that"
+      " the random number engine produces full-range 64-bit integers" );
+    constexpr double two_to_minus_64 = 1. / 18446744073709551616.;
+    double u = static_cast<double>( rand_gen_() ) * two_to_minus_64;
+    if ( u >= 1. ) u = std::nextafter( 1., 0. );
+    return u;
+  }
+
+  inline double Generator::uniform( double min, double max )
+    { return uniform01()*( max - min ) + min; }
+
+  // The inclusive flag determines whether or not max is included in the
+  // range. That is, when inclusive == false, the sampling is done on the
+  // interval [min, max), while inclusive == true uses [min, max].
+  inline double Generator::uniform_random_double( double min, double max,
+    bool inclusive )
+  {
+    // Find the double value that comes immediately after max. This allows
+    // us to sample uniformly on [min, max] rather than [min,max). This trick
+    // comes from http://tinyurl.com/n3ocg3p.
+    if ( inclusive ) max = std::nextafter( max,
+      std::numeric_limits<double>::max() );
+    return uniform( min, max );
+  }
+
+  inline void Generator::isotropic_direction( double& cos_theta,
+    double& phi )
+  {
+    // Width of the interval [-1, 1] used to sample the polar cosine,
+    // including the upper endpoint
+    static const double cos_width = std::nextafter( 1.,
+      std::numeric_limits<double>::max() ) + 1.;
+    cos_theta = uniform01()*cos_width - 1.;
+    phi = uniform01()*marley_utils::two_pi;
+  }
+
+  template <size_t N> double Generator::inverse_transform_sample(
+    const marley::ChebyshevCDF<N>& cdf, double xmin, double xmax,
+    double bisection_tolerance)
+  {
+    // Sample a probability value uniformly on [0, 1]
+    double prob = uniform_random_double(0., 1., true);
+
+    // If we chose an endpoint, we're done, so just return the appropriate one
+    if ( prob == 0. ) return xmin;
+    else if ( prob == 1. ) return xmax;
+
+    return cdf.inverse_cdf( prob, bisection_tolerance );
+  }
+
+  template <typename Function> double Generator::rejection_sample(
+    const Function& f, double xmin, double xmax, double& fmax,
+    double safety_factor, double max_search_tolerance)
+  {
+    // If we were passed the value marley_utils::UNKNOWN_MAX for fmax, then
+    // this signals that we need to search for the function maximum
+    // ourselves. Otherwise, we'll assume that the value passed over is good.
+    if ( fmax == marley_utils::UNKNOWN_MAX  ) {
+      // This variable will be loaded with the value of x
+      // that corresponds to the maximum of f(x).
+      // We don't actually use this, but currently it's
+      // a required parameter of marley_utils::maximize
+      double x_at_max;
+
+      // Maximize the function and multiply by a safety factor just
+      // in case we didn't quite find the exact peak
+      fmax = marley_utils::maximize(f, xmin, xmax, max_search_tolerance,
+        x_at_max) * safety_factor;
+    }
+
+    marley::Instrumentation::ScopedTimer timer(
+      marley::Instrumentation::Probe::RejectionSample );
+
+    double x, y, val;
+    long trials = 0;
+
+    do {
+      ++trials;
+
+      // Sample x value uniformly from [xmin, xmax]
+      x = uniform_random_double(xmin, xmax, true);
+
+      // Sample y uniformly from [0, fmax]
+      y = uniform_random_double(0, fmax, true);
+
+      val = f(x);
+      if ( val > fmax ) {
+        handle_rejection_fmax_exceeded( val, x, fmax, safety_factor );
+      }
+    }
+    // Keep sampling until you get a y value less than f(x)
+    // (the probability density function evaluated at the sampled value of x)
+    while ( y > val );
+
+    marley::Instrumentation::add_value(
+      marley::Instrumentation::Probe::RejectionSample, trials );
+
+    return x;
+  }
 }
@@ -0,0 +1,115 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <memory>
+#include <string>
+
+#include "marley/OutputFile.hh"
+
+namespace marley {
+
+  /// @brief Writes events to an HDF5 file as columns of fixed-width values
+  /// @details The file holds one-dimensional datasets that can be loaded
+  /// directly as NumPy arrays (e.g., using h5py). The /events group
+  /// contains one entry per event in each of the datasets Ex, twoJ, and
+  /// parity, together with the PDG code, total energy, and 3-momentum of
+  /// the projectile (projectile_pdg, projectile_E, projectile_px,
+  /// projectile_py, projectile_pz) and ejectile (ejectile_pdg, etc.).
+  ///
+  /// The /initial_particles and /final_particles groups each contain the
+  /// datasets pdg, E, px, py, pz, mass, and charge, which store the
+  /// corresponding particles of all events one after another. The
+  /// /events/initial_offsets and /events/final_offsets datasets each have
+  /// one more entry than the number of events. The particles belonging to
+  /// event i have indices from offsets[i] up to (but not including)
+  /// offsets[i + 1]. This is the same convention used for jagged arrays by
+  /// Apache Arrow and Awkward Array.
+  ///
+  /// The flux-averaged total cross section (MeV<sup> -2</sup>) is stored
+  /// in the flux_avg_tot_xsec attribute of the root group. When the file
+  /// is closed, the job configuration and generator state are saved to the
+  /// /metadata dataset as JSON text (with the same contents as for the
+  /// binary format) so that the run can be resumed later.
+  ///
+  /// If single precision is requested, then the energy and momentum
+  /// datasets (including the masses) are stored as 32-bit floats, and the
+  /// E, projectile_E, and ejectile_E datasets are replaced by KE,
+  /// projectile_KE, and ejectile_KE, which hold kinetic energies. This
+  /// keeps the recoil energies of heavy nuclei accurate. The root group's
+  /// single_precision attribute is set to 1 for such files.
+  ///
+  /// This class is only usable if MARLEY was built with HDF5 support. If
+  /// it was not, then the constructor will throw a marley::Error.
+  class HDF5OutputFile : public OutputFile {
+
+    public:
+
+      /// @param compression Either "none" (the default) or "gzip", which
+      /// enables HDF5's built-in deflate filter
+      /// @param compression_level Level to use for gzip compression (1-9),
+      /// or zero to use the default level
+      /// @param single_precision Whether to store the energies and momenta
+      /// in single precision
+      HDF5OutputFile(const std::string& name, const std::string& format,
+        const std::string& mode, bool force = false,
+        const std::string& compression = "none", int compression_level = 0,
+        bool single_precision = false);
+
+      virtual ~HDF5OutputFile();
+
+      /// @brief Number of events buffered in memory before they are added
+      /// to the datasets
+      static constexpr size_t EVENTS_PER_BLOCK = 1024u;
+
+      virtual bool resume(std::unique_ptr<marley::Generator>& gen,
+        long& num_previous_events) override;
+
+      int_fast64_t bytes_written() override;
+
+      virtual void write_event(const marley::Event* event) override;
+
+      virtual void write_events(const marley::EventBatch& batch) override;
+
+      virtual void close(const marley::JSON& json_config,
+        const GeneratorState& gen_state, const long num_events) override;
+
+      virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
+
+    private:
+
+      virtual void open() override;
+
+      // Rewrites the /metadata dataset so that it holds the same "gen_state"
+      // information used by the JSON format
+      void write_generator_state(const marley::JSON& json_config,
+        const GeneratorState& gen_state, const long num_events) override;
+
+      // Storage for the HDF5 objects and the buffered column values. The
+      // definition is hidden so that this header does not depend on the
+      // HDF5 headers.
+      struct Columns;
+      std::unique_ptr<Columns> columns_;
+
+      // Deflate compression level (zero disables compression)
+      int deflate_level_ = 0;
+
+      /// @brief Storage for the number of bytes written to disk
+      int_fast64_t byte_count_ = 0;
+  };
+
+}
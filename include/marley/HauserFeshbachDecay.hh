@@ -15,9 +15,10 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
-#include <memory>
 #include <ostream>
+#include <vector>
 
+#include "marley/AliasTable.hh"
 #include "marley/ExitChannel.hh"
 #include "marley/Parity.hh"
 
@@ -42,6 +43,16 @@ namespace marley {
         double Exi, int twoJi, marley::Parity Pi,
         marley::StructureDatabase& sdb );
 
+      /// @brief Rebuilds this object for a new compound nucleus state
+      /// @details The exit channel storage is cleared and refilled in place,
+      /// so its capacity is reused across calls. This allows a single
+      /// HauserFeshbachDecay object to be recycled (e.g., by the cache in
+      /// StructureDatabase::get_hf_decay()) without reallocating.
+      /// @copydetails HauserFeshbachDecay( const marley::Particle&, double,
+      /// int, marley::Parity, marley::StructureDatabase& )
+      void reset( const marley::Particle& compound_nucleus, double Exi,
+        int twoJi, marley::Parity Pi, marley::StructureDatabase& sdb );
+
       /// @brief Simulates a decay of the compound nucleus
       /// @param[out] Exf Final nuclear excitation energy (MeV)
       /// @param[out] twoJf Two times the final nuclear spin
@@ -51,55 +62,266 @@ namespace marley {
       /// @param[out] residual_nucleus Particle object representing the
       /// final-state nucleus
       /// param gen Generator to use for random sampling
+      /// @param[in,out] weight If this is not nullptr, then the event weight
+      /// that it points to is multiplied by the correction for any exit
+      /// channel bias (see Generator::set_exit_channel_bias())
       bool do_decay( double& Exf, int& twoJf, marley::Parity& Pf,
         marley::Particle& emitted_particle, marley::Particle& residual_nucleus,
-        marley::Generator& gen );
+        marley::Generator& gen, double* weight = nullptr );
+
+      /// @brief Simulates a decay of a compound nucleus with the same
+      /// species and excitation as the one used to build this object
+      /// @details This version allows a HauserFeshbachDecay object to be
+      /// reused (e.g., via StructureDatabase::get_hf_decay()) for compound
+      /// nuclei that have different kinematics. The decay widths depend only
+      /// on the compound nucleus species, excitation energy, spin, and
+      /// parity.
+      /// @param compound_nucleus Particle object that represents the excited
+      /// nucleus that will decay
+      bool do_decay( const marley::Particle& compound_nucleus, double& Exf,
+        int& twoJf, marley::Parity& Pf, marley::Particle& emitted_particle,
+        marley::Particle& residual_nucleus, marley::Generator& gen,
+        double* weight = nullptr );
 
       /// @brief Print information about the possible decay channels to a
       /// std::ostream
       void print( std::ostream& out ) const;
 
-      /// @brief Get a non-const reference to the owned vector of ExitChannel
-      /// pointers
-      inline std::vector< std::unique_ptr<marley::ExitChannel> >&
-        exit_channels();
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by this object, including the exit channels and any
+      /// continuum CDFs that they have built
+      size_t memory_usage() const;
 
-      /// @brief Get a const reference to the owned vector of ExitChannel
-      /// pointers
-      inline const std::vector< std::unique_ptr<marley::ExitChannel> >&
-        exit_channels() const;
+      /// @brief Get a const reference to a vector of pointers to the owned
+      /// ExitChannel objects, listed in the order used for sampling
+      /// @details Entries that stand for a pool of negligible discrete
+      /// channels (see StructureDatabase::set_discrete_pool_tolerance()) are
+      /// nullptr
+      inline const std::vector<marley::ExitChannel*>& exit_channels() const;
 
-      /// @brief Helper function for do_decay(). Samples an ExitChannel
-      /// using the partial decay widths as weights
-      const std::unique_ptr<marley::ExitChannel>& sample_exit_channel(
-        marley::Generator& gen) const;
+      /// @brief Samples an ExitChannel using the partial decay widths as
+      /// weights
+      /// @details If a pool of discrete channels is chosen, then one of its
+      /// members is sampled and built. The returned pointer remains valid
+      /// until the next call.
+      /// @param[in,out] weight Optional event weight, updated as in
+      /// do_decay()
+      const marley::ExitChannel* sample_exit_channel(
+        marley::Generator& gen, double* weight = nullptr);
+
+      /// @brief Computes the total widths of any continuum exit channels
+      /// whose computation was deferred
+      /// @details When lazy continuum widths are enabled (see
+      /// StructureDatabase::set_lazy_continuum_widths()), the widths of the
+      /// continuum channels are replaced by inexpensive upper bounds until
+      /// they are needed to make a sampling decision. Until this function
+      /// is called, the total width reported by print() may therefore be an
+      /// upper bound, and the widths of deferred channels returned by
+      /// ExitChannel::width() are zero.
+      void resolve_widths();
 
     private:
 
-      /// @brief Helper function called by the constructor. Loads
-      /// exit_channels_ with ExitChannel objects representing all of the
-      /// possible decay modes
+      /// @brief Concrete type of an owned ExitChannel object
+      enum class ChannelKind { FragmentDiscrete, FragmentContinuum,
+        GammaDiscrete, GammaContinuum, DiscretePool };
+
+      /// @brief Discrete exit channels with negligible widths that are
+      /// sampled together as a single channel
+      /// @details Only the final levels and widths are kept. The exit
+      /// channel object for a member is built when it is sampled.
+      struct DiscretePool {
+        /// PDG code of the emitted particle (all members share it)
+        int pdg;
+        /// Final nuclear levels of the member channels
+        std::vector<const marley::Level*> levels;
+        /// Running sums of the member widths (MeV), in the same order
+        std::vector<double> cumulative_widths;
+      };
+
+      /// @brief Location of an ExitChannel object within the typed storage
+      struct ChannelRef {
+        ChannelKind kind; ///< Selects the vector that owns the channel
+        size_t index; ///< Position of the channel within that vector
+      };
+
+      /// @brief Destination for the exit channels created by
+      /// build_fragment_channels() and build_gamma_channels()
+      struct ChannelOutput {
+        std::vector<marley::FragmentDiscreteExitChannel>& fragment_discrete;
+        std::vector<marley::FragmentContinuumExitChannel>& fragment_continuum;
+        std::vector<marley::GammaDiscreteExitChannel>& gamma_discrete;
+        std::vector<marley::GammaContinuumExitChannel>& gamma_continuum;
+        /// Locations of the new channels in the order they were created
+        std::vector<ChannelRef>& refs;
+        /// Widths (or upper bounds on them) of the new channels (MeV)
+        std::vector<double>& widths;
+      };
+
+      /// @brief Exit channels created by a single task when they are built
+      /// in parallel (see build_channels_in_parallel())
+      struct ChannelLists {
+        std::vector<marley::FragmentDiscreteExitChannel> fragment_discrete;
+        std::vector<marley::FragmentContinuumExitChannel> fragment_continuum;
+        std::vector<marley::GammaDiscreteExitChannel> gamma_discrete;
+        std::vector<marley::GammaContinuumExitChannel> gamma_continuum;
+        std::vector<ChannelRef> refs;
+        std::vector<double> widths;
+
+        inline ChannelOutput output() { return ChannelOutput{
+          fragment_discrete, fragment_continuum, gamma_discrete,
+          gamma_continuum, refs, widths }; }
+      };
+
+      /// @brief A fragment whose emission is energetically allowed
+      struct OpenFragment {
+        const marley::Fragment* fragment;
+        double Exf_max; ///< Maximum final excitation energy (MeV)
+      };
+
+      /// @brief Helper function called by reset(). Loads the exit channel
+      /// storage with ExitChannel objects representing all of the possible
+      /// decay modes
       void build_exit_channels( marley::StructureDatabase& sdb );
 
+      /// @brief Helper function for build_exit_channels(). Creates the
+      /// discrete and continuum exit channels for emission of a single
+      /// fragment.
+      void build_fragment_channels( marley::StructureDatabase& sdb,
+        const OpenFragment& open, double rho_i, bool defer,
+        ChannelOutput& out ) const;
+
+      /// @brief Helper function for build_exit_channels(). Creates the
+      /// discrete and continuum exit channels for gamma-ray emission.
+      void build_gamma_channels( marley::StructureDatabase& sdb,
+        double rho_i, bool defer, ChannelOutput& out ) const;
+
+      /// @brief Helper function for build_exit_channels(). Creates the
+      /// channels for each open fragment (and for gamma-ray emission) as
+      /// separate tasks on the shared TaskPool, then stores them in the
+      /// same order used by the serial calculation.
+      void build_channels_in_parallel( marley::StructureDatabase& sdb,
+        double rho_i, bool defer );
+
+      /// @brief Helper function for do_decay(). Samples the index of an
+      /// exit channel using the partial decay widths (multiplied by any
+      /// exit channel bias factors) as weights
+      /// @details If any continuum widths have been deferred, then a
+      /// rejection method is used. Channels are proposed using the upper
+      /// bounds in place of the deferred widths. When a deferred channel is
+      /// proposed, its width is computed and the proposal is accepted with
+      /// probability equal to the ratio of the width to the bound. The
+      /// accepted channels therefore follow the same distribution as they
+      /// would if all widths had been computed in advance.
+      size_t sample_exit_channel_index( marley::Generator& gen,
+        double* weight );
+
+      /// @brief Helper function for sample_exit_channel_index(). Samples an
+      /// index from an alias table built from the current widths_ (and any
+      /// exit channel biases).
+      size_t sample_index_from_table( marley::Generator& gen );
+
+      /// @brief Helper function for sample_exit_channel_index(). Returns a
+      /// pointer to the owned continuum exit channel with the given index
+      /// in sampling order if its width has been deferred, or nullptr
+      /// otherwise
+      marley::ContinuumExitChannel* get_deferred_channel( size_t index );
+
+      /// @brief Computes the width of a deferred continuum channel and
+      /// updates the sampling tables
+      void resolve_width( size_t index, marley::ContinuumExitChannel& ec );
+
+      /// @brief Helper function for build_exit_channels(). Records a newly
+      /// added channel in the sampling tables
+      void add_channel( ChannelKind kind, size_t index, double width );
+
+      /// @brief Returns a pointer to an owned ExitChannel object, or nullptr
+      /// for a pool of discrete channels
+      marley::ExitChannel* get_channel( const ChannelRef& ref );
+
+      /// @brief Helper function for build_exit_channels(). Moves the
+      /// discrete channels with the smallest widths into pools (one per
+      /// emitted particle species) until their combined width would exceed
+      /// the given fraction of the total width.
+      void pool_discrete_channels( double tolerance );
+
+      /// @brief Samples a member of a pool of discrete channels and builds
+      /// its exit channel object
+      marley::ExitChannel* resolve_pooled_channel( const DiscretePool& pool,
+        marley::Generator& gen );
+
+      /// @brief Returns the PDG code of the particle emitted in the exit
+      /// channel with the given index in sampling order
+      int emitted_particle_pdg( size_t index ) const;
+
       /// @brief Particle object that represents the compound nucleus before it
       /// decays
-      const marley::Particle compound_nucleus_;
-      const double Exi_; ///< Initial nuclear excitation energy
-      const int twoJi_; ///< Two times the initial nuclear spin
-      const marley::Parity Pi_; ///< Two times the initial nuclear parity
+      marley::Particle compound_nucleus_;
+      double Exi_; ///< Initial nuclear excitation energy
+      int twoJi_; ///< Two times the initial nuclear spin
+      marley::Parity Pi_; ///< Two times the initial nuclear parity
+      double rho_i_ = 0.; ///< Initial nuclear level density (MeV<sup>-1</sup>)
+
+      /// @brief Database used to build the exit channels
+      marley::StructureDatabase* sdb_ = nullptr;
 
       /// @brief Total decay width (MeV) for the compound nucleus
+      /// @details This is an upper bound while any continuum widths have
+      /// been deferred
       double total_width_ = 0.;
 
-      /// @brief Table of ExitChannel objects used for sampling decays
-      std::vector< std::unique_ptr<marley::ExitChannel> > exit_channels_;
+      /// @brief Number of continuum exit channels whose widths have been
+      /// deferred
+      size_t num_deferred_widths_ = 0u;
+
+      /// @brief Exit channels are stored by value, one vector per concrete
+      /// type, so that they can be reused without per-channel allocations
+      /// and invoked without virtual dispatch
+      std::vector<marley::FragmentDiscreteExitChannel> fragment_discrete_;
+      std::vector<marley::FragmentContinuumExitChannel> fragment_continuum_;
+      std::vector<marley::GammaDiscreteExitChannel> gamma_discrete_;
+      std::vector<marley::GammaContinuumExitChannel> gamma_continuum_;
+
+      /// @brief Fragments whose emission is energetically allowed (kept as
+      /// a member so that its capacity is reused)
+      std::vector<OpenFragment> open_fragments_;
+
+      /// @brief Pools of negligible discrete exit channels
+      std::vector<DiscretePool> discrete_pools_;
+
+      /// @brief Storage for the most recently sampled member of a pool of
+      /// discrete exit channels (at most one element each)
+      std::vector<marley::FragmentDiscreteExitChannel> pooled_fragment_;
+      std::vector<marley::GammaDiscreteExitChannel> pooled_gamma_;
+
+      /// @brief Locations of the exit channels in sampling order
+      std::vector<ChannelRef> channel_refs_;
+
+      /// @brief Partial decay widths (MeV) of the exit channels in sampling
+      /// order
+      /// @details Upper bounds are stored for continuum channels whose
+      /// widths have been deferred
+      std::vector<double> widths_;
+
+      /// @brief Pointers to the exit channels in sampling order
+      /// @details This is rebuilt after the typed storage has been filled
+      std::vector<marley::ExitChannel*> exit_channels_;
+
+      /// @brief Alias table built from the partial decay widths of the
+      /// exit channels
+      /// @details This is initialized lazily by sample_exit_channel_index()
+      /// and reused for any subsequent samples
+      mutable marley::AliasTable exit_channel_table_;
+
+      /// @brief Event weight correction for each exit channel when exit
+      /// channel biases are in use
+      /// @details This is filled together with exit_channel_table_. It is
+      /// left empty if the Generator does not use exit channel biases.
+      mutable std::vector<double> channel_weights_;
   };
 
   // Inline function definitions
-  inline std::vector<std::unique_ptr<marley::ExitChannel> >&
-    HauserFeshbachDecay::exit_channels() { return exit_channels_; }
-
-  inline const std::vector<std::unique_ptr<marley::ExitChannel> >&
+  inline const std::vector<marley::ExitChannel*>&
     HauserFeshbachDecay::exit_channels() const { return exit_channels_; }
 }
 
@@ -0,0 +1,141 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "marley/JSON.hh"
+
+namespace marley {
+
+  /// @brief Opt-in timers and counters for the steps that dominate the cost
+  /// of generating an event
+  /// @details Each instrumented step (a "probe") accumulates the number of
+  /// times it was run, the total wall-clock time spent in it, and an
+  /// optional per-call value (e.g., the number of trials needed by rejection
+  /// sampling). Statistics are collected separately by each thread without
+  /// any locking and are merged into a shared table, grouped by a label
+  /// chosen with set_thread_label(), when the thread exits. Instrumentation
+  /// is disabled by default, in which case each probe costs a single
+  /// relaxed atomic load.
+  class Instrumentation {
+
+    public:
+
+      /// @brief Steps of event generation that can be instrumented
+      enum class Probe : unsigned {
+        SampleReaction,        ///< Generator::sample_reaction()
+        CreateEvent,           ///< Reaction::create_event()
+        ProcessEvent,          ///< NucleusDecayer::process_event()
+        HauserFeshbachDecay,   ///< HauserFeshbachDecay construction
+        SMatrixElement,        ///< Optical model S-matrix element
+        ChebyshevConstruction, ///< ChebyshevInterpolatingFunction construction
+        RejectionSample,       ///< Generator::rejection_sample()
+        WriteEvent,            ///< OutputFile::write_event()
+        NumProbes              ///< Number of probes (not a real probe)
+      };
+
+      static constexpr size_t NUM_PROBES
+        = static_cast<size_t>( Probe::NumProbes );
+
+      /// @brief Accumulated statistics for a single probe
+      struct Stats {
+        uint64_t calls = 0u; ///< Number of timed calls
+        double seconds = 0.; ///< Total wall-clock time (s)
+        uint64_t value_count = 0u; ///< Number of recorded values
+        double value_sum = 0.; ///< Sum of the recorded values
+        double value_max = 0.; ///< Largest recorded value
+
+        void merge(const Stats& other);
+      };
+
+      using StatsTable = std::array<Stats, NUM_PROBES>;
+
+      /// @brief Measures the time spent in a scope and records it for a
+      /// probe when destroyed (if instrumentation is enabled)
+      class ScopedTimer {
+
+        public:
+
+          explicit inline ScopedTimer(Probe probe) : probe_( probe ),
+            active_( Instrumentation::enabled() )
+          {
+            if ( active_ ) start_ = std::chrono::steady_clock::now();
+          }
+
+          inline ~ScopedTimer() {
+            if ( active_ ) Instrumentation::add_time( probe_,
+              std::chrono::steady_clock::now() - start_ );
+          }
+
+          ScopedTimer(const ScopedTimer&) = delete;
+          ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        private:
+
+          Probe probe_;
+          bool active_;
+          std::chrono::steady_clock::time_point start_;
+      };
+
+      /// @brief Enable or disable the collection of statistics
+      static void enable(bool enabled = true);
+
+      /// @brief Returns true if statistics are being collected
+      static inline bool enabled()
+        { return enabled_.load( std::memory_order_relaxed ); }
+
+      /// @brief Record a timed call of a probe for the current thread
+      static void add_time(Probe probe,
+        std::chrono::steady_clock::duration elapsed);
+
+      /// @brief Record a per-call value (e.g., a trial count or grid size)
+      /// for a probe on the current thread. Does nothing if instrumentation
+      /// is disabled.
+      static inline void add_value(Probe probe, double value)
+        { if ( enabled() ) record_value( probe, value ); }
+
+      /// @brief Set the label under which the current thread's statistics
+      /// will be reported
+      /// @details Threads that share a label (e.g., successive worker
+      /// threads that handle the same share of the events) are combined
+      /// in the report. The default label is "main".
+      static void set_thread_label(const std::string& label);
+
+      /// @brief Build a JSON report of the statistics collected so far
+      /// @details The report includes every thread that has exited and the
+      /// calling thread. Statistics belonging to other running threads are
+      /// not included.
+      static marley::JSON report();
+
+      /// @brief Write the output of report() to a file
+      static void write_report(const std::string& file_name);
+
+      /// @brief Get the name of a probe as used in the report
+      static const char* probe_name(Probe probe);
+
+    private:
+
+      static void record_value(Probe probe, double value);
+
+      static std::atomic<bool> enabled_;
+  };
+
+}
@@ -15,6 +15,7 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <cmath>
 #include <functional>
 #include <vector>
 
@@ -41,6 +42,21 @@ namespace marley {
       double num_integrate(const std::function<double(double)>& f,
         double a, double b) const;
 
+      /// @brief Numerically integrate an arbitrary callable object
+      /// @details This template version allows the integrand to be inlined
+      /// into the quadrature loop. The std::function overload is a thin
+      /// wrapper around it.
+      template <typename Function> double num_integrate(const Function& f,
+        double a, double b) const;
+
+      /// @brief Numerically integrate a function that is evaluated at all
+      /// of the sampling points using a single call
+      /// @details The callable object f(x, y, n) must load y[i] with the
+      /// value of the integrand at x[i] for i = 0 to n - 1. The result is
+      /// identical to that of num_integrate().
+      template <typename BatchFunction> double num_integrate_batch(
+        const BatchFunction& f, double a, double b) const;
+
     private:
 
       /// @brief use 2N_ sampling points to perform numerical integration
@@ -55,4 +71,220 @@ namespace marley {
       static constexpr size_t N_DEFAULT_ = 20; ///< default value of N_
   };
 
+  // Inline function definitions
+  template <typename Function> inline double Integrator::num_integrate(
+    const Function& f, double a, double b) const
+  {
+    double A = (b - a) / 2.;
+    double B = (b + a) / 2.;
+    double C = (f(a) + f(b)) / 2.;
+
+    double integral = weights_[0] * C; // n = 0 term
+    integral += weights_[N_] * f(B); // n = N_ term
+
+    // n = 1 to n = N_ - 1 terms
+    for (size_t n = 1; n < N_; ++n) {
+      double epoint = A * offsets_[n - 1];
+      integral += weights_[n] * (f(B + epoint) + f(B - epoint));
+    }
+
+    return A * integral;
+  }
+
+  template <typename BatchFunction> inline double
+    Integrator::num_integrate_batch(const BatchFunction& f, double a,
+    double b) const
+  {
+    double A = (b - a) / 2.;
+    double B = (b + a) / 2.;
+
+    // Collect the sampling points in the order a, b, B, then pairs of
+    // points placed symmetrically about B
+    std::vector<double> xs;
+    xs.reserve( 2*N_ + 1 );
+    xs.push_back( a );
+    xs.push_back( b );
+    xs.push_back( B );
+    for (size_t n = 1; n < N_; ++n) {
+      double epoint = A * offsets_[n - 1];
+      xs.push_back( B + epoint );
+      xs.push_back( B - epoint );
+    }
+
+    std::vector<double> ys( xs.size() );
+    f( xs.data(), ys.data(), xs.size() );
+
+    // Sum the terms in the same order as num_integrate()
+    double integral = weights_[0] * ( (ys[0] + ys[1]) / 2. );
+    integral += weights_[N_] * ys[2];
+    for (size_t n = 1; n < N_; ++n) {
+      integral += weights_[n] * (ys[2*n + 1] + ys[2*n + 2]);
+    }
+
+    return A * integral;
+  }
+
+  /// @brief Outcome of a numerical integration by an AdaptiveIntegrator
+  struct IntegrationResult {
+    double value = 0.; ///< Estimated value of the integral
+    double error = 0.; ///< Estimated absolute error of value
+    size_t evaluations = 0u; ///< Number of integrand evaluations used
+    bool converged = true; ///< Whether the requested tolerance was met
+  };
+
+  /// @brief Numerical integrator that uses nested <a
+  /// href="http://en.wikipedia.org/wiki/Clenshaw-Curtis_quadrature">Clenshaw-Curtis
+  /// quadrature</a> with an error estimate
+  /// @details The integrand is first evaluated at MIN_POINTS + 1 Chebyshev
+  /// points. The number of intervals between the points is then doubled
+  /// until two successive estimates of the integral agree to within the
+  /// requested tolerance. The points of each rule are a subset of those of
+  /// the next one, so every refinement reuses all of the previous integrand
+  /// evaluations. The difference between the last two estimates is reported
+  /// as the error. If the tolerance is not met using MAX_POINTS + 1 points,
+  /// then the interval is bisected and each half is treated in the same way
+  /// (up to MAX_DEPTH times). Smooth integrands are thus handled using far
+  /// fewer evaluations than the fixed rule used by Integrator, while
+  /// integrands with sharp features get as many as they need.
+  class AdaptiveIntegrator {
+    public:
+
+      /// @param rel_tol Relative tolerance on the value of the integral
+      /// @param abs_tol Absolute tolerance on the value of the integral
+      AdaptiveIntegrator(double rel_tol = DEFAULT_REL_TOL,
+        double abs_tol = 0.);
+
+      /// @brief Numerically integrate an arbitrary callable object over the
+      /// interval [a, b]
+      template <typename Function> IntegrationResult integrate(
+        const Function& f, double a, double b) const;
+
+      /// @brief Numerically integrate an arbitrary callable object over the
+      /// interval [a, b], returning only the value of the integral
+      template <typename Function> inline double num_integrate(
+        const Function& f, double a, double b) const
+        { return integrate( f, a, b ).value; }
+
+      inline double rel_tol() const { return rel_tol_; }
+      inline double abs_tol() const { return abs_tol_; }
+
+      /// @brief Default relative tolerance
+      static constexpr double DEFAULT_REL_TOL = 1e-6;
+
+      /// @brief Number of intervals used by the first rule
+      static constexpr size_t MIN_POINTS = 8u;
+
+      /// @brief Maximum number of intervals used before bisecting
+      static constexpr size_t MAX_POINTS = 256u;
+
+      /// @brief Maximum number of bisections
+      static constexpr int MAX_DEPTH = 6;
+
+    private:
+
+      /// @brief Helper for integrate() that handles a single interval
+      /// @param depth Number of bisections used to reach this interval
+      template <typename Function> IntegrationResult integrate_interval(
+        const Function& f, double a, double b, double abs_tol,
+        int depth) const;
+
+      /// @brief Returns the Clenshaw-Curtis weights on [-1, 1] for the rule
+      /// with num_intervals + 1 points
+      /// @details The weights for each of the nested rules are computed once
+      /// and shared by all AdaptiveIntegrator objects
+      static const std::vector<double>& weights(size_t num_intervals);
+
+      /// @brief Returns cos(j * pi / MAX_POINTS) for j = 0 to MAX_POINTS
+      static const std::vector<double>& nodes();
+
+      double rel_tol_; ///< Relative tolerance
+      double abs_tol_; ///< Absolute tolerance
+  };
+
+  // Inline function definitions
+  template <typename Function> inline IntegrationResult
+    AdaptiveIntegrator::integrate(const Function& f, double a,
+    double b) const
+  {
+    return integrate_interval( f, a, b, abs_tol_, 0 );
+  }
+
+  template <typename Function> IntegrationResult
+    AdaptiveIntegrator::integrate_interval(const Function& f, double a,
+    double b, double abs_tol, int depth) const
+  {
+    double A = (b - a) / 2.;
+    double B = (b + a) / 2.;
+
+    // Integrand values are stored at their positions in the finest rule so
+    // that they can be reused by each refinement without being moved
+    const auto& xs = nodes();
+    std::vector<double> fs( MAX_POINTS + 1 );
+
+    IntegrationResult result;
+    size_t stride = MAX_POINTS / MIN_POINTS;
+    for ( size_t j = 0; j <= MAX_POINTS; j += stride ) {
+      fs[ j ] = f( B + A * xs[j] );
+    }
+    result.evaluations = MIN_POINTS + 1;
+
+    auto estimate = [&fs](size_t num_intervals) -> double {
+      const auto& ws = weights( num_intervals );
+      size_t step = MAX_POINTS / num_intervals;
+      double sum = 0.;
+      for ( size_t j = 0; j <= num_intervals; ++j ) {
+        sum += ws[ j ] * fs[ j * step ];
+      }
+      return sum;
+    };
+
+    double previous = A * estimate( MIN_POINTS );
+    for ( size_t n = 2 * MIN_POINTS; n <= MAX_POINTS; n *= 2 ) {
+      // Only the odd-numbered points of each new rule are new
+      stride /= 2;
+      for ( size_t j = stride; j <= MAX_POINTS; j += 2 * stride ) {
+        fs[ j ] = f( B + A * xs[j] );
+      }
+      result.evaluations += n / 2;
+
+      result.value = A * estimate( n );
+      result.error = std::abs( result.value - previous );
+      if ( result.error <= std::max(abs_tol,
+        rel_tol_ * std::abs(result.value)) )
+      {
+        result.converged = true;
+        return result;
+      }
+      previous = result.value;
+    }
+
+    result.converged = false;
+    if ( depth >= MAX_DEPTH ) return result;
+
+    // Split the absolute tolerance between the two halves
+    double mid = B;
+    auto left = integrate_interval( f, a, mid, abs_tol / 2., depth + 1 );
+    auto right = integrate_interval( f, mid, b, abs_tol / 2., depth + 1 );
+    result.value = left.value + right.value;
+    result.error = left.error + right.error;
+    result.evaluations += left.evaluations + right.evaluations;
+    result.converged = left.converged && right.converged;
+    return result;
+  }
+
+}
+
+namespace marley_utils {
+
+  // Returns the Integrator object used by num_integrate()
+  const marley::Integrator& default_integrator();
+
+  // Numerically integrate an arbitrary callable object using Clenshaw-Curtis
+  // quadrature. This template version allows the integrand to be inlined.
+  template <typename Function> inline double num_integrate(const Function& f,
+    double a, double b)
+  {
+    return default_integrator().num_integrate(f, a, b);
+  }
+
 }
@@ -96,6 +96,13 @@ namespace marley {
       enum class ExtrapolationMethod { Zero, Endpoint,
         Continue, Throw };
 
+      /// @brief Spacing of the grid x values
+      /// @details For Uniform and LogUniform grids, the bin containing a
+      /// requested x value is found by direct index computation rather than
+      /// a binary search. The spacing is detected automatically whenever the
+      /// grid changes.
+      enum class Spacing { Irregular, Uniform, LogUniform };
+
       /// @brief Create an InterpolationGrid without any grid points
       inline InterpolationGrid(InterpolationMethod interp_method
         = InterpolationMethod::LinearLinear, ExtrapolationMethod extrap_method
@@ -113,6 +120,7 @@ namespace marley {
         extrapolation_method_(extrap_method), ordered_pairs_(grid)
       {
         /// @todo Add error checks for the supplied grid
+        detect_spacing();
       }
 
       /// @brief Create an InterpolationGrid from vectors of x and y values
@@ -127,6 +135,7 @@ namespace marley {
           std::string("Vectors of x and y values passed to the constructor")
           + " of marley::InterpolationGrid have unequal sizes.");
 
+        ordered_pairs_.reserve(xs.size());
         double old_x = marley_utils::minus_infinity;
         for (size_t j = 0; j < xs.size(); ++j) {
           double new_x = xs.at(j);
@@ -135,11 +144,20 @@ namespace marley {
             + " are not strictly increasing");
           ordered_pairs_.push_back(OrderedPair(xs.at(j), ys.at(j)));
         }
+
+        detect_spacing();
       };
 
       /// @brief Compute y(x) using the current InterpolationMethod
       SecondNumericType interpolate(FirstNumericType x) const;
 
+      /// @brief Compute y(x) for each of n x values
+      /// @param[in] xs Array of n x values
+      /// @param[out] ys Array of n elements that will be loaded with the
+      /// corresponding y values
+      void interpolate(const FirstNumericType* xs, SecondNumericType* ys,
+        size_t n) const;
+
       /// @brief Add a new ordered pair (x, y) to the grid
       void insert(FirstNumericType x, SecondNumericType y);
 
@@ -147,10 +165,27 @@ namespace marley {
       inline size_t size() const { return ordered_pairs_.size(); }
 
       /// @brief Delete all ordered pairs from the grid
-      inline void clear() { ordered_pairs_.clear(); }
+      inline void clear()
+        { ordered_pairs_.clear(); spacing_ = Spacing::Irregular; }
 
       /// @brief Get a reference to the jth ordered pair from the grid
-      inline OrderedPair& at(size_t j) { return ordered_pairs_.at(j); }
+      /// @details Since the x value may be modified through the returned
+      /// reference, the grid is treated as irregular afterwards until
+      /// detect_spacing() is called again.
+      inline OrderedPair& at(size_t j)
+        { spacing_ = Spacing::Irregular; return ordered_pairs_.at(j); }
+
+      /// @brief Get a const reference to the jth ordered pair from the grid
+      inline const OrderedPair& at(size_t j) const
+        { return ordered_pairs_.at(j); }
+
+      /// @brief Get the spacing of the grid x values
+      inline Spacing spacing() const { return spacing_; }
+
+      /// @brief Check whether the grid x values are uniformly or
+      /// logarithmically uniformly spaced and enable the corresponding
+      /// fast bin lookup
+      void detect_spacing();
 
       /// @brief Get a std::function object that represents y(x) for this
       /// InterpolationGrid
@@ -219,6 +254,22 @@ namespace marley {
       /// @brief The ordered pairs to use as reference points for interpolation
       Grid ordered_pairs_;
 
+      /// @brief Spacing of the grid x values
+      Spacing spacing_ = Spacing::Irregular;
+
+      /// @brief The first grid x value (or its logarithm for a LogUniform
+      /// grid)
+      double spacing_origin_ = 0.;
+
+      /// @brief Inverse of the grid step (in ln(x) for a LogUniform grid)
+      double inverse_step_ = 0.;
+
+      /// @brief Deviations from the ideal grid smaller than this fraction of
+      /// a step are accepted when detecting the spacing
+      /// @details The lookup corrects for them, so the tolerance only needs
+      /// to keep the computed index within a step or two of the true one.
+      static constexpr double SPACING_TOLERANCE = 1e-6;
+
       /// @brief Checks to make sure the grid contains at least two points. If
       /// it doesn't, throw an error.
       /// @details This function should be called by all class methods that
@@ -243,7 +294,8 @@ namespace marley {
         bool extrapolate = false;
         GridConstIterator begin = ordered_pairs_.begin();
         GridConstIterator end = ordered_pairs_.end();
-        GridConstIterator not_less_point = lower_bound(begin, end, x);
+        GridConstIterator not_less_point = ( spacing_ == Spacing::Irregular )
+          ? lower_bound(begin, end, x) : spaced_lower_bound(x);
 
         // Check whether the requested grid point is within the grid limits
         if (not_less_point == begin) {
@@ -266,6 +318,29 @@ namespace marley {
 
         return extrapolate;
       }
+
+      /// @brief Equivalent of lower_bound() over the full grid that computes
+      /// the index directly for a Uniform or LogUniform grid
+      /// @details The computed index is corrected by stepping to neighboring
+      /// points, so the result agrees exactly with the binary search even
+      /// when rounding errors are present.
+      inline GridConstIterator spaced_lower_bound(FirstNumericType x) const
+      {
+        const size_t n = ordered_pairs_.size();
+        if ( !(x > ordered_pairs_.front().first) ) return ordered_pairs_.begin();
+        if ( x > ordered_pairs_.back().first ) return ordered_pairs_.end();
+
+        double t = ( spacing_ == Spacing::Uniform ) ? x : std::log( x );
+        t = std::ceil( (t - spacing_origin_) * inverse_step_ );
+
+        size_t k = 1u;
+        if ( t >= static_cast<double>(n - 1) ) k = n - 1;
+        else if ( t > 1. ) k = static_cast<size_t>( t );
+
+        while ( k > 1u && !(ordered_pairs_[k - 1].first < x) ) --k;
+        while ( ordered_pairs_[k].first < x ) ++k;
+        return ordered_pairs_.begin() + k;
+      }
   };
 
   template <typename FirstNumericType, typename SecondNumericType>
@@ -343,6 +418,60 @@ namespace marley {
     return y_interp;
   }
 
+  template <typename FirstNumericType, typename SecondNumericType>
+    void InterpolationGrid<FirstNumericType, SecondNumericType>::interpolate(
+    const FirstNumericType* xs, SecondNumericType* ys, size_t n) const
+  {
+    for ( size_t j = 0; j < n; ++j ) ys[j] = interpolate( xs[j] );
+  }
+
+  template <typename FirstNumericType, typename SecondNumericType>
+    void InterpolationGrid<FirstNumericType, SecondNumericType>
+    ::detect_spacing()
+  {
+    spacing_ = Spacing::Irregular;
+
+    size_t n = ordered_pairs_.size();
+    if ( n < 3 ) return;
+
+    double x0 = ordered_pairs_.front().first;
+    double x_last = ordered_pairs_.back().first;
+
+    double step = ( x_last - x0 ) / ( n - 1 );
+    bool uniform = ( step > 0. );
+    for ( size_t j = 1; uniform && j < n - 1; ++j ) {
+      double expected = x0 + j*step;
+      if ( std::abs(ordered_pairs_[j].first - expected)
+        > SPACING_TOLERANCE*step )
+      {
+        uniform = false;
+      }
+    }
+
+    if ( uniform ) {
+      spacing_ = Spacing::Uniform;
+      spacing_origin_ = x0;
+      inverse_step_ = 1. / step;
+      return;
+    }
+
+    // Logarithmic spacing requires positive x values
+    if ( !(x0 > 0.) ) return;
+
+    double log_x0 = std::log( x0 );
+    double log_step = ( std::log(x_last) - log_x0 ) / ( n - 1 );
+    if ( !(log_step > 0.) ) return;
+    for ( size_t j = 1; j < n - 1; ++j ) {
+      double expected = log_x0 + j*log_step;
+      if ( std::abs(std::log(ordered_pairs_[j].first) - expected)
+        > SPACING_TOLERANCE*log_step ) return;
+    }
+
+    spacing_ = Spacing::LogUniform;
+    spacing_origin_ = log_x0;
+    inverse_step_ = 1. / log_step;
+  }
+
   template <typename FirstNumericType, typename SecondNumericType>
     void InterpolationGrid<FirstNumericType, SecondNumericType>::insert(
     FirstNumericType x, SecondNumericType y)
@@ -354,8 +483,29 @@ namespace marley {
     GridConstIterator insert_point = upper_bound(ordered_pairs_.begin(),
       ordered_pairs_.end(), x);
 
+    bool append = ( insert_point == ordered_pairs_.end() );
+
     // Insert the new grid point
     ordered_pairs_.insert(insert_point, OrderedPair(x, y));
+
+    // Insertions before the end of the grid may change the spacing anywhere,
+    // so they need the full check
+    size_t n = ordered_pairs_.size();
+    if ( !append || n <= 3 ) {
+      detect_spacing();
+      return;
+    }
+
+    // A point appended to a grid with at least three points only needs to
+    // be compared with the current spacing, so filling a grid in increasing
+    // order takes linear time overall. Appending a point cannot make an
+    // irregular grid regular.
+    if ( spacing_ == Spacing::Irregular ) return;
+    double t = ( spacing_ == Spacing::Uniform ) ? x : std::log( x );
+    double steps = ( t - spacing_origin_ ) * inverse_step_;
+    if ( std::abs(steps - static_cast<double>(n - 1)) > SPACING_TOLERANCE ) {
+      spacing_ = Spacing::Irregular;
+    }
   }
 
 }
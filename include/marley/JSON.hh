@@ -22,6 +22,7 @@
 #include <cctype>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <deque>
 #include <initializer_list>
 #include <iostream>
@@ -32,6 +33,7 @@
 #include <map>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 // MARLEY includes
 #include "marley/marley_utils.hh"
@@ -140,6 +142,12 @@ namespace marley {
       { other.type_ = DataType::Null; other.data_.map_ = nullptr; }
 
       JSON& operator=(JSON&& other) {
+        if ( this == &other ) return *this;
+        // Release the old contents only after taking ownership of the new
+        // ones, since other may be one of our own children
+        JSON old;
+        old.data_ = data_;
+        old.type_ = type_;
         data_ = other.data_;
         type_ = other.type_;
         other.data_.map_ = nullptr;
@@ -167,23 +175,11 @@ namespace marley {
       }
 
       JSON& operator=(const JSON& other) {
-        switch(other.type_) {
-          case DataType::Object:
-            data_.map_ = new std::map<std::string,JSON>(
-              other.data_.map_->begin(), other.data_.map_->end());
-            break;
-          case DataType::Array:
-            data_.list_ = new std::deque<JSON>( other.data_.list_->begin(),
-              other.data_.list_->end());
-            break;
-          case DataType::String:
-            data_.string_ = new std::string(*other.data_.string_);
-            break;
-          default:
-            data_ = other.data_;
-        }
-        type_ = other.type_;
-        return *this;
+        // Copy first so that self-assignment (or assignment from one of our
+        // own children) is safe, then release the old contents
+        if ( this == &other ) return *this;
+        JSON temp( other );
+        return *this = std::move( temp );
       }
 
       ~JSON() {
@@ -246,9 +242,21 @@ namespace marley {
         return JSON::make(JSON::DataType::Object);
       }
 
-      static inline JSON load(const std::string& s);
-      static inline JSON load(std::istream& is);
-      static inline JSON load_file(const std::string& s);
+      /// @brief Parse a JSON object from a string
+      static JSON load(const std::string& s);
+
+      /// @brief Parse a JSON object from a block of memory
+      /// @details Any characters that follow the object are ignored
+      /// @param data Pointer to the first character to parse
+      /// @param size Number of characters available
+      static JSON load(const char* data, size_t size);
+
+      /// @brief Parse a JSON object from an input stream
+      /// @details The stream is left positioned just after the object
+      static JSON load(std::istream& is);
+
+      /// @brief Parse a JSON object from a file
+      static JSON load_file(const std::string& s);
 
       template <typename T> void append(T arg) {
         set_type(DataType::Array);
@@ -471,17 +479,6 @@ namespace marley {
       void print(std::ostream& out, const unsigned int indent_step,
         bool pretty, const unsigned int current_indent = 0) const
       {
-        // Use max_digits10 for outputting double-precision floating-point
-        // numbers. This ensures that repeated input/output via JSON will
-        // not result in any loss of precision. For more information, please
-        // see http://tinyurl.com/p8wyhnn
-        static std::ostringstream out_float;
-        static bool set_precision = false;
-        if (!set_precision) {
-          out_float.precision(std::numeric_limits<double>::max_digits10);
-          set_precision = true;
-        }
-
         unsigned int indent = current_indent;
 
         switch( type_ ) {
@@ -543,15 +540,16 @@ namespace marley {
           case DataType::String:
             out << '\"' + json_escape( *data_.string_ ) + '\"';
             return;
-          case DataType::Floating:
-            // Clear any previous contents of the stringstream
-            out_float.str("");
-            out_float.clear();
-            // Fill it with the new floating-point number
-            out_float << data_.float_;
-            // Output the resulting string to the stream
-            out << out_float.str();
+          case DataType::Floating: {
+            // Use the shortest representation that reads back as the same
+            // double. This ensures that repeated input/output via JSON will
+            // not result in any loss of precision.
+            char buffer[ marley_utils::SHORTEST_DOUBLE_BUFFER_SIZE ];
+            size_t length = marley_utils::format_shortest_double( data_.float_,
+              buffer );
+            out.write( buffer, length );
             return;
+          }
           case DataType::Integral:
             out << data_.integer_;
             return;
@@ -707,331 +705,6 @@ namespace marley {
       DataType type_ = DataType::Null;
   };
 
-  namespace {
-
-    JSON parse_next(std::istream&);
-
-    void issue_parse_error(char found_char, const std::string& message)
-    {
-      std::string msg(message);
-      if (found_char == std::ifstream::traits_type::eof())
-        msg += "end-of-file";
-      else msg += std::string("\'") + found_char + '\'';
-      //MARLEY_LOG_WARNING() << msg;
-      throw marley::Error( msg );
-    }
-
-    void issue_parse_error(const std::string& found_str,
-      const std::string& message, const std::istream& is)
-    {
-      std::string msg(message);
-      if (!is) msg += "end-of-file";
-      else msg += '\'' + found_str + '\'';
-      //MARLEY_LOG_WARNING() << msg;
-      throw marley::Error( msg );
-    }
-
-    // Skips single-line comments // and multi-line comments /* */
-    // These are technically not valid in JSON (the standard doesn't allow
-    // comments), but they are valid in Javascript object literals.
-    void skip_comment(std::istream& in, bool is_multiline = false) {
-      if (is_multiline) {
-        char c;
-        while (in.get(c)) {
-          if (c == '*' && in.peek() == '/') {
-            in.ignore();
-            break;
-          }
-        }
-      }
-      // Ignore all further characters until either a newline or end-of-file
-      else in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    }
-
-    // Skips whitespace and comments, saving the last character read to
-    // read_char.
-    void skip_ws(std::istream& in, char& read_char) {
-      while (read_char = in.get(), std::isspace(read_char)) continue;
-      if (read_char == '/') {
-        char c = in.peek();
-        if (c == '/' || c == '*') {
-          read_char = in.get();
-          skip_comment(in, c == '*');
-          return skip_ws(in, read_char);
-        }
-      }
-    }
-
-    // Removes whitespace and comments from the input stream, putting back
-    // the first non-whitespace and non-comment character it finds.
-    void consume_ws(std::istream& in) {
-      static char next;
-      skip_ws(in, next);
-      in.putback(next);
-    }
-
-    // Removes whitespace and comments from the input stream, returning the
-    // first non-whitespace and non-comment character it finds.
-    char get_next_char(std::istream& in)
-    {
-      static char next;
-      skip_ws(in, next);
-      return next;
-    }
-
-    JSON parse_object(std::istream& in) {
-
-      JSON object = JSON::make(JSON::DataType::Object);
-
-      for (;;) {
-
-        consume_ws(in);
-        JSON key;
-
-        if ( in.peek() == '}' ) {
-          in.ignore();
-          return object;
-        }
-        else if ( in.peek() == '\"' ) {
-          key = parse_next(in);
-        }
-        // The key isn't quoted, so assume it's a single word followed
-        // by a colon. Note that vanilla JSON requires all keys to be quoted,
-        // but Javascript object literals allow unquoted keys.
-        else {
-          std::string key_str;
-          char c;
-          while (in.get(c)) {
-            if (c == ':' || std::isspace(c)) {
-              in.putback(c);
-              break;
-            }
-            key_str += c;
-          }
-          key = key_str;
-        }
-
-        char next = get_next_char(in);
-        if ( next != ':' ) {
-          issue_parse_error(next, "JSON object: Expected colon, found ");
-          break;
-        }
-
-        consume_ws(in);
-        JSON value = parse_next(in);
-        object[key.to_string()] = value;
-
-        next = get_next_char(in);
-        if ( next == ',' ) continue;
-        else if ( next == '}' ) break;
-        else {
-          issue_parse_error(next, "JSON object: Expected comma, found ");
-          break;
-        }
-      }
-
-      return object;
-    }
-
-    JSON parse_array(std::istream& in) {
-      JSON array = JSON::make(JSON::DataType::Array);
-      unsigned index = 0;
-
-      for (;;) {
-
-        consume_ws(in);
-        if (in.peek() == ']') {
-          in.ignore();
-          return array;
-        }
-
-        array[index++] = parse_next(in);
-        consume_ws(in);
-
-        char next = in.get();
-        if (next == ',') continue;
-        else if (next == ']') break;
-        else {
-          issue_parse_error(next, "JSON array: Expected ',' or ']'"
-            ", found ");
-          return JSON::make(JSON::DataType::Array);
-        }
-      }
-
-      return array;
-    }
-
-    JSON parse_string(std::istream& in) {
-      JSON str;
-      std::string val;
-      for(char c = in.get(); c != '\"' && in; c = in.get()) {
-        if (c == '\\') {
-          switch( in.get() ) {
-            case '\"': val += '\"'; break;
-            case '\\': val += '\\'; break;
-            case '/' : val += '/' ; break;
-            case 'b' : val += '\b'; break;
-            case 'f' : val += '\f'; break;
-            case 'n' : val += '\n'; break;
-            case 'r' : val += '\r'; break;
-            case 't' : val += '\t'; break;
-            case 'u' : {
-              val += "\\u" ;
-              for(unsigned i = 1; i <= 4; ++i) {
-                c = in.get();
-                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')
-                  || (c >= 'A' && c <= 'F')) val += c;
-                else {
-                  issue_parse_error(c, "JSON string: Expected hex character"
-                    " in unicode escape, found ");
-                  return JSON::make(JSON::DataType::String);
-                }
-              }
-              break;
-            }
-            default: val += '\\'; break;
-          }
-        }
-        else val += c;
-      }
-      str = val;
-      return str;
-    }
-
-    //FIXME
-    JSON parse_number(std::istream& in, char old) {
-      JSON Number;
-       std::string val, exp_str;
-      char c = old;
-      bool isDouble = false;
-      long exp = 0;
-      for (;;) {
-        if ( (c == '-') || (c >= '0' && c <= '9') )
-          val += c;
-        else if ( c == '.' ) {
-          val += c;
-          isDouble = true;
-        }
-        else
-          break;
-        c = in.get();
-      }
-      if ( c == 'E' || c == 'e' ) {
-        if ( in.peek() == '-' ){ in.ignore(); exp_str += '-';}
-        for (;;) {
-          c = in.get();
-          if ( c >= '0' && c <= '9' )
-            exp_str += c;
-          else if ( !std::isspace( c ) && c != ',' && c != ']' && c != '}' ) {
-            issue_parse_error(c, "JSON number: Expected a number for"
-              " exponent, found ");
-            return JSON::make(JSON::DataType::Null);
-          }
-          else
-            break;
-        }
-        exp = std::stol( exp_str );
-      }
-      else if ( !std::isspace( c ) && c != ',' && c != ']' && c != '}' ) {
-        issue_parse_error(c, "JSON number: unexpected character ");
-        return JSON::make(JSON::DataType::Null);
-      }
-      in.putback(c);
-
-      if ( isDouble )
-        Number = std::stod( val ) * std::pow( 10, exp );
-      else {
-        if ( !exp_str.empty() )
-          Number = std::stol( val ) * std::pow( 10, exp );
-        else
-          Number = std::stol( val );
-      }
-      return  Number ;
-    }
-
-    JSON parse_bool(std::istream& in, char old) {
-      JSON b;
-      std::string s(1, old);
-      if (old == 't') {
-        for (size_t i = 0; i < 3; ++i) s += in.get();
-        if (s == "true") b = true;
-      }
-      else if (old == 'f') {
-        for (size_t i = 0; i < 4; ++i) s += in.get();
-        if (s == "false") b = false;
-      }
-      if (b.type() == JSON::DataType::Null) {
-        // Get the entire string if the user supplied an invalid value
-        while (in.good() && !std::isspace(in.peek())) s += in.get();
-        marley_utils::trim_inplace(s);
-
-        issue_parse_error(s, "JSON bool: Expected 'true' or 'false', found ",
-          in);
-        return JSON::make(JSON::DataType::Null);
-      }
-      return b;
-    }
-
-    JSON parse_null(std::istream& in) {
-      JSON null;
-      std::string s(1, 'n');
-      for (size_t i = 0; i < 3; ++i) s += in.get();
-      if ( s != "null") {
-        issue_parse_error("JSON null: Expected 'null', found ", s, in);
-        return JSON::make(JSON::DataType::Null);
-      }
-      return null;
-    }
-
-    JSON parse_next(std::istream& in) {
-      char value = get_next_char(in);
-      switch(value) {
-        case '[' : return parse_array(in);
-        case '{' : return parse_object(in);
-        case '\"': return parse_string(in);
-        case 't' :
-        case 'f' : return parse_bool(in, value);
-        case 'n' : return parse_null(in);
-        default  :
-          if ((value <= '9' && value >= '0') || value == '-')
-            return parse_number(in, value);
-      }
-      // Complain and throw an error if there was a problem
-      if (!in) throw marley::Error("Unexpected end of JSON configuration"
-        " file found\n");
-      else throw marley::Error(std::string("JSON parse:")
-        + " Unknown starting character '" + value + "'\n");
-      return JSON();
-    }
-  }
-
-  inline JSON JSON::load_file(const std::string& filename) {
-    std::ifstream in(filename);
-    if (in.good()) return load(in);
-    else {
-      throw marley::Error("Could not open the file \"" + filename + "\"");
-      return JSON::make(JSON::DataType::Null);
-    }
-  }
-
-  inline JSON JSON::load(std::istream& in) {
-    char first = get_next_char(in);
-    if (first != '{') {
-      throw marley::Error("Missing '{' at beginning of JSON object");
-      in.putback(first);
-      return parse_object(in);
-    }
-    else {
-      in.putback(first);
-      return parse_next(in);
-    }
-  }
-
-  inline JSON JSON::load(const std::string& str) {
-    std::stringstream iss(str);
-    return load(iss);
-  }
-
 }
 
 // Stream operators for JSON input and output using C++ streams
@@ -17,6 +17,8 @@
 #pragma once
 
 // standard library includes
+#include <map>
+#include <memory>
 #include <string>
 
 // MARLEY includes
@@ -38,15 +40,84 @@ namespace marley {
 
       marley::Generator create_generator() const;
 
+      /// @brief Create a Generator that uses an existing StructureDatabase
+      /// @details The structure settings in the configuration are not
+      /// applied, since they belong to the shared database. This is used to
+      /// create the Generator objects for additional threads.
+      marley::Generator create_generator(
+        std::shared_ptr<marley::StructureDatabase> sdb ) const;
+
+      /// @brief Apply the source, target, direction, and enabled reactions
+      /// given in this configuration to an existing Generator
+      /// @details Only the "source", "target", "direction", and
+      /// "enabled_reactions" keys are used, and any that are missing leave
+      /// the corresponding setting unchanged. The reactions and all of the
+      /// caches owned by the Generator are kept (see
+      /// Generator::reconfigure()).
+      void reconfigure( marley::Generator& gen ) const;
+
       void prepare_direction( marley::Generator& gen ) const;
       void prepare_neutrino_source( marley::Generator& gen ) const;
+
+      /// @brief Create a NeutrinoSource from its JSON specification
+      /// @param source_spec JSON object describing the source
+      /// @param pdg PDG code of the neutrinos produced by the source
+      /// @param log_source Whether to log a message describing the new
+      /// source
+      std::unique_ptr<marley::NeutrinoSource> create_neutrino_source(
+        const marley::JSON& source_spec, int pdg, bool log_source = true )
+        const;
+
+      /// @brief Create a TimeBinnedNeutrinoSource from its JSON specification
+      std::unique_ptr<marley::NeutrinoSource> create_time_binned_source(
+        const marley::JSON& source_spec, int pdg ) const;
+      void prepare_random_engine( marley::Generator& gen ) const;
       void prepare_dm_source( marley::Generator& gen ) const;
-      void prepare_reactions( marley::Generator& gen ) const;
+
+      /// @brief Create the source described by the "source" key
+      /// @details Dark matter sources are created directly. Sources of
+      /// every other type are created by create_neutrino_source().
+      /// @return The new source, or nullptr if the key is missing or null
+      std::unique_ptr<marley::NeutrinoSource> create_dm_source() const;
+
+      /// @brief Load the reactions listed in the configuration
+      /// @param[out] file_names Loaded with the full names of the reaction
+      /// data files that were used
+      void prepare_reactions( marley::Generator& gen,
+        std::vector<std::string>& file_names ) const;
       void prepare_structure( marley::Generator& gen ) const;
       void prepare_target( marley::Generator& gen ) const;
 
+      /// @brief Create the target described by the "target" key
+      /// @details If the key is missing, every target atom involved in one
+      /// of the reactions owned by gen is included with equal weight
+      /// @return The new target, or nullptr if there is nothing to create
+      std::unique_ptr<marley::Target> create_target(
+        const marley::Generator& gen ) const;
+
+      /// @brief Configure the reactions and target for a detector made of
+      /// several materials
+      /// @details Each entry of the "materials" array gives its own target
+      /// composition, reaction data files, and exposure. The materials are
+      /// merged into a single composite target weighted by exposure so that
+      /// one Generator (and one StructureDatabase) serves the whole detector.
+      void prepare_materials( marley::Generator& gen,
+        std::vector<std::string>& file_names ) const;
+      void prepare_biasing( marley::Generator& gen ) const;
+
+      /// @brief Configure cuts that primary interactions must pass before
+      /// the rest of each event is generated
+      void prepare_event_filter( marley::Generator& gen ) const;
+
       void update_logger_settings() const;
 
+      /// @brief Parse the "enabled_reactions" key
+      /// @return The enabled state of each Reaction owned by gen, keyed by
+      /// its position in the vector returned by Generator::get_reactions(),
+      /// or an empty map if the key is missing
+      std::map<size_t, bool> parse_enabled_reactions(
+        const marley::Generator& gen ) const;
+
       InterpMethod get_interpolation_method(const std::string& rule) const;
       int neutrino_pdg(const std::string& nu) const;
 
@@ -0,0 +1,224 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "marley/JSON.hh"
+#include "marley/JSONParser.hh"
+
+namespace marley {
+
+  class MappedFile;
+  class MonotonicArena;
+
+  /// @brief Opaque storage for a single value in a JSONDocument
+  struct JSONNode;
+
+  /// @brief Lightweight handle to a value stored in a JSONDocument
+  /// @details Values are only valid while the document that owns them
+  /// is alive and has not been used to parse a new buffer
+  class JSONValue {
+
+    public:
+
+      /// @brief Iterator over the elements of an array or the members of
+      /// an object
+      class Iterator {
+        public:
+          explicit Iterator(const JSONNode* node) : node_( node ) {}
+          inline JSONValue operator*() const
+            { return JSONValue( node_ ); }
+          Iterator& operator++();
+          inline bool operator!=(const Iterator& other) const
+            { return node_ != other.node_; }
+          inline bool operator==(const Iterator& other) const
+            { return node_ == other.node_; }
+        private:
+          const JSONNode* node_;
+      };
+
+      /// @brief Range of child values usable in a range-based for loop
+      class Range {
+        public:
+          Range(const JSONNode* first) : first_( first ) {}
+          inline Iterator begin() const { return Iterator( first_ ); }
+          inline Iterator end() const { return Iterator( nullptr ); }
+        private:
+          const JSONNode* first_;
+      };
+
+      /// @brief Creates a handle to a null value
+      JSONValue() = default;
+
+      marley::JSON::DataType type() const;
+
+      inline bool is_null() const
+        { return type() == marley::JSON::DataType::Null; }
+      inline bool is_object() const
+        { return type() == marley::JSON::DataType::Object; }
+      inline bool is_array() const
+        { return type() == marley::JSON::DataType::Array; }
+      inline bool is_string() const
+        { return type() == marley::JSON::DataType::String; }
+      inline bool is_float() const
+        { return type() == marley::JSON::DataType::Floating; }
+      inline bool is_integer() const
+        { return type() == marley::JSON::DataType::Integral; }
+      inline bool is_bool() const
+        { return type() == marley::JSON::DataType::Boolean; }
+
+      /// @brief Number of array elements, or -1 for other types
+      int length() const;
+
+      /// @brief Number of array elements or object members, or -1 for
+      /// other types
+      int size() const;
+
+      bool has_key(const std::string& key) const;
+
+      /// @brief Get the value of an object member
+      /// @details A marley::Error is thrown if the key is missing
+      JSONValue at(const std::string& key) const;
+
+      /// @brief Get an array element
+      /// @details A marley::Error is thrown if the index is out of range
+      JSONValue at(unsigned index) const;
+
+      /// @brief For a member of an object, get its key
+      JSONStringView key() const;
+
+      /// @brief For a string, get a view of its (unescaped) contents
+      JSONStringView string_view() const;
+
+      /// @brief Get the contents of a string with special characters
+      /// escaped, matching marley::JSON::to_string()
+      std::string to_string(bool& ok) const;
+
+      inline std::string to_string() const {
+        bool ok;
+        return to_string( ok );
+      }
+
+      double to_double(bool& ok) const;
+      long to_long(bool& ok) const;
+      bool to_bool(bool& ok) const;
+
+      inline double to_double() const {
+        bool ok;
+        return to_double( ok );
+      }
+
+      inline long to_long() const {
+        bool ok;
+        return to_long( ok );
+      }
+
+      /// @brief Range over the elements of an array (empty for other
+      /// types)
+      Range array_range() const;
+
+      /// @brief Range over the members of an object (empty for other
+      /// types). Use key() to retrieve the key of each member.
+      Range object_range() const;
+
+      /// @brief Copy this value (and any children) into a marley::JSON
+      /// object
+      marley::JSON to_json() const;
+
+    private:
+
+      friend class JSONDocument;
+
+      explicit JSONValue(const JSONNode* node) : node_( node ) {}
+
+      const JSONNode* node_ = nullptr;
+  };
+
+  /// @brief Read-only JSON document tree stored in a single arena
+  /// @details Unlike marley::JSON, which allocates every object, array, and
+  /// string separately, a JSONDocument stores all of its nodes in a
+  /// MonotonicArena. Strings without escape sequences are not copied at
+  /// all: they refer directly to the parsed buffer, which must therefore
+  /// outlive the document when it is not owned by it. Parsing a new buffer
+  /// into an existing document reuses the arena storage, so repeatedly
+  /// parsing small values (e.g., individual events) does not allocate once
+  /// the arena is large enough. The JSONValue class provides the same read-only
+  /// accessors as marley::JSON, and to_json() converts any part of the tree
+  /// into a marley::JSON object when a mutable copy is needed.
+  class JSONDocument {
+
+    public:
+
+      /// @brief Handle to a value stored in the document
+      using Value = JSONValue;
+
+      /// @brief Creates an empty document whose root is null
+      JSONDocument();
+
+      /// @brief Parse a single value from a block of memory
+      /// @details The memory is not copied and must outlive the document
+      JSONDocument(const char* data, size_t size);
+
+      /// @brief Parse a single value from a string owned by the document
+      explicit JSONDocument(std::string text);
+
+      ~JSONDocument();
+
+      JSONDocument(JSONDocument&&);
+      JSONDocument& operator=(JSONDocument&&);
+
+      JSONDocument(const JSONDocument&) = delete;
+      JSONDocument& operator=(const JSONDocument&) = delete;
+
+      /// @brief Parse the contents of a file, which is memory-mapped rather
+      /// than copied
+      static JSONDocument load_file(const std::string& file_name);
+
+      /// @brief Replace the contents of the document by parsing a single
+      /// value from a block of memory
+      /// @details Existing arena storage is reused. Any buffer previously
+      /// owned by the document is released, and the new memory must
+      /// outlive the document.
+      /// @return The number of characters consumed
+      size_t parse(const char* data, size_t size);
+
+      /// @brief Get the outermost value in the document
+      inline Value root() const { return Value( root_ ); }
+
+    private:
+
+      /// @brief Discards the tree (but not the arena storage) and any owned
+      /// buffer
+      void clear();
+
+      /// @brief Storage for all nodes and for strings that could not be
+      /// viewed in the parsed buffer
+      std::unique_ptr<marley::MonotonicArena> arena_;
+
+      /// @brief Parsed text, if owned by the document
+      std::unique_ptr<std::string> text_;
+
+      /// @brief Memory mapping of the parsed file, if any
+      std::unique_ptr<marley::MappedFile> file_;
+
+      /// @brief Outermost value in the document
+      const JSONNode* root_ = nullptr;
+  };
+
+}
@@ -0,0 +1,117 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <string>
+
+namespace marley {
+
+  /// @brief Non-owning reference to a sequence of characters
+  class JSONStringView {
+
+    public:
+
+      JSONStringView() = default;
+
+      inline JSONStringView(const char* data, size_t size)
+        : data_( data ), size_( size ) {}
+
+      /// @brief Get a pointer to the first character
+      inline const char* data() const { return data_; }
+
+      /// @brief Get the number of characters
+      inline size_t size() const { return size_; }
+
+      inline bool empty() const { return size_ == 0u; }
+
+      /// @brief Copy the characters into a std::string
+      inline std::string str() const { return std::string( data_, size_ ); }
+
+      inline bool operator==(const std::string& s) const {
+        return s.size() == size_
+          && ( size_ == 0u || std::memcmp(s.data(), data_, size_) == 0 );
+      }
+
+      inline bool operator!=(const std::string& s) const
+        { return !( *this == s ); }
+
+    private:
+
+      const char* data_ = nullptr;
+      size_t size_ = 0u;
+  };
+
+  /// @brief Abstract base class for objects that receive the values found
+  /// by a JSONParser as they are parsed (SAX-style)
+  /// @details String and key views passed to the callbacks point either
+  /// into the buffer being parsed (in which case they remain valid for as
+  /// long as the buffer does) or into scratch storage owned by the parser
+  /// (in which case they are only valid until the callback returns).
+  class JSONHandler {
+
+    public:
+
+      virtual ~JSONHandler() = default;
+
+      virtual void null_value() = 0;
+      virtual void boolean_value(bool b) = 0;
+      virtual void integer_value(long i) = 0;
+      virtual void floating_value(double d) = 0;
+
+      /// @param str Contents of the string with any escape sequences
+      /// already replaced
+      virtual void string_value(const JSONStringView& str) = 0;
+
+      virtual void start_object() = 0;
+
+      /// @brief Called before the value of each member of an object
+      virtual void key(const JSONStringView& k) = 0;
+
+      virtual void end_object() = 0;
+
+      virtual void start_array() = 0;
+      virtual void end_array() = 0;
+  };
+
+  /// @brief Streaming parser for JSON documents
+  /// @details The parser accepts the same relaxed syntax as MARLEY job
+  /// configuration files: Javascript-style comments, unquoted object keys,
+  /// and trailing commas are all allowed. Parsing stops after the first
+  /// complete value, so any input that follows it is left untouched.
+  /// Syntax errors are reported by throwing a marley::Error.
+  class JSONParser {
+
+    public:
+
+      /// @brief Parse a single value from a block of memory
+      /// @param data Pointer to the first character to parse
+      /// @param size Number of characters available
+      /// @param handler Object that will receive the parsed values
+      /// @return The number of characters consumed
+      static size_t parse(const char* data, size_t size,
+        JSONHandler& handler);
+
+      /// @brief Parse a single value from an input stream
+      /// @details The stream is left positioned just after the value
+      /// @param in Stream to read from
+      /// @param handler Object that will receive the parsed values
+      static void parse(std::istream& in, JSONHandler& handler);
+  };
+
+}
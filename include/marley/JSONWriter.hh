@@ -0,0 +1,86 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Streaming writer that serializes JSON text directly into a
+  /// character buffer
+  /// @details JSONWriter produces the same layout as marley::JSON::print()
+  /// without building a marley::JSON object first. Callers emit a sequence
+  /// of begin/end, key, and value calls, which are appended to a
+  /// user-supplied std::string. Floating-point values are written using
+  /// marley_utils::format_shortest_double().
+  class JSONWriter {
+
+    public:
+
+      /// @param out String to which the JSON text will be appended
+      /// @param indent_step Number of spaces per indent level, or a negative
+      /// value to produce the most compact output possible
+      /// @param current_indent Indent level (in spaces) of the enclosing
+      /// JSON text. Used only when pretty-printing.
+      JSONWriter(std::string& out, int indent_step = -1,
+        unsigned current_indent = 0);
+
+      void begin_object();
+      void end_object();
+
+      void begin_array();
+      void end_array();
+
+      /// @brief Write the key for the next member of the current object
+      void key(const char* k);
+
+      void value(double x);
+      void value(long i);
+      inline void value(int i);
+      void value(bool b);
+      void value(const std::string& s);
+      void value(const char* s);
+
+    protected:
+
+      /// @brief Writes any separator and indentation needed before a new
+      /// value
+      void begin_value();
+
+      /// @brief Appends the current indentation
+      void indent();
+
+      /// @brief Appends a string with JSON escape sequences applied
+      void append_escaped(const char* s);
+
+      std::string& out_;
+      bool pretty_;
+      unsigned indent_step_;
+      unsigned indent_;
+
+      /// @brief For each enclosing object or array, whether the next
+      /// element written will be its first one
+      std::vector<bool> first_element_;
+
+      /// @brief Whether a key has just been written
+      bool after_key_ = false;
+  };
+
+  // Inline function definitions
+  inline void JSONWriter::value(int i) { this->value( static_cast<long>(i) ); }
+
+}
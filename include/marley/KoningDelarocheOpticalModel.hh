@@ -17,11 +17,16 @@
 #pragma once
 #include <cmath>
 #include <complex>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "marley/DecayScheme.hh"
 #include "marley/MassTable.hh"
 #include "marley/OpticalModel.hh"
+#include "marley/coulomb_wavefunctions.hh"
 #include "marley/marley_utils.hh"
 
 namespace marley {
@@ -42,21 +47,100 @@ namespace marley {
       /// @param A Mass number of the desired nuclide
       /// @param step_size Step size (fm) to use for numerical integration of
       /// the Schr&ouml;dinger equation
+      /// @param matching_threshold Threshold (MeV) on the magnitude of the
+      /// nuclear part of the potential used to choose the radii at which the
+      /// numerical solution is matched to Coulomb wavefunctions
       KoningDelarocheOpticalModel(int Z, int A, double step_size
-        = DEFAULT_NUMEROV_STEP_SIZE_);
+        = DEFAULT_NUMEROV_STEP_SIZE, double matching_threshold
+        = DEFAULT_MATCHING_RADIUS_THRESHOLD);
+
+      /// @brief Default step size (fm) for computing transmission coefficients
+      /// via the
+      /// <a href="https://en.wikipedia.org/wiki/Numerov%27s_method">Numerov
+      /// method</a>
+      static constexpr double DEFAULT_NUMEROV_STEP_SIZE = 0.1;
+
+      /// @brief Default threshold (MeV) for abs(U - Vc) used to find a
+      /// suitable matching radius for computing transmission coefficients
+      static constexpr double DEFAULT_MATCHING_RADIUS_THRESHOLD = 1e-3;
+
+      /// @brief Default grid spacing (MeV) for transmission coefficient
+      /// tables
+      static constexpr double DEFAULT_TABLE_ENERGY_STEP = 0.05;
 
       virtual std::complex<double> optical_model_potential(double r,
         double fragment_KE_lab, int fragment_pdg, int two_j, int l, int two_s,
         int target_charge = 0) override;
 
+      /// @details In TransmissionMode::Table, transmission coefficients are
+      /// interpolated from a table (one per combination of fragment, angular
+      /// momenta, and target charge) on a uniform grid in total_KE_CM.
+      /// Grid points are computed exactly the first time that they are
+      /// needed and stored for later use. A monotone piecewise cubic Hermite
+      /// interpolant (Fritsch-Carlson) is used between grid points, so the
+      /// interpolated values never overshoot the tabulated ones.
       virtual double transmission_coefficient(double total_KE_CM,
         int fragment_pdg, int two_j, int l, int two_s, int target_charge = 0)
         override;
 
+      /// @details In TransmissionMode::Exact, the Schr&ouml;dinger equation
+      /// is integrated for all of the partial waves at once.
+      virtual void transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s, int l_max,
+        marley::ScratchVector<double>& Tljs,
+        int target_charge = 0) override;
+
+      /// @details In TransmissionMode::Exact, the Schr&ouml;dinger equation
+      /// is integrated for all of the partial waves at once.
+      virtual void partial_wave_transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s,
+        const marley::ScratchVector<std::pair<int, int> >& waves,
+        marley::ScratchVector<double>& Tljs, int target_charge = 0) override;
+
       virtual double total_cross_section(double fragment_KE_lab,
         int fragment_pdg, int two_s, size_t l_max, int target_charge = 0)
         override;
 
+      /// @details This includes the radial grids, the Coulomb wavefunction
+      /// cache, and any tabulated transmission coefficients
+      virtual size_t memory_usage() const override;
+
+      /// @brief Get the grid spacing (MeV) used for transmission coefficient
+      /// tables
+      inline double get_table_energy_step() const;
+
+      /// @brief Set the grid spacing (MeV) used for transmission coefficient
+      /// tables
+      /// @details Any previously tabulated values are discarded
+      void set_table_energy_step(double step);
+
+      /// @brief Discard all tabulated transmission coefficients
+      inline void clear_transmission_tables();
+
+      /// @brief Fills the transmission coefficient tables for a fragment in
+      /// advance
+      /// @details Every grid point that may be needed to interpolate at
+      /// total CM frame kinetic energies up to max_KE_CM is computed for
+      /// all partial waves with @f$ \ell \leq @f$ l_max. The waves are
+      /// integrated together at each grid point, so this is much faster
+      /// than filling the tables one wave at a time. Grid points that have
+      /// already been computed are kept, and the results are identical to
+      /// those obtained on demand by transmission_coefficient().
+      void tabulate(int fragment_pdg, int two_s, int l_max, double max_KE_CM,
+        int target_charge = 0);
+
+      /// @brief Write the tabulated transmission coefficients to a binary
+      /// stream
+      void write_tables(std::ostream& out) const;
+
+      /// @brief Read transmission coefficient tables written by
+      /// write_tables()
+      /// @details Values that were already tabulated are kept. The tables
+      /// are ignored if they were computed using a different Numerov step
+      /// size, matching radius threshold, or table energy grid.
+      /// @return True if the tables were read and used, or false otherwise
+      bool read_tables(std::istream& in);
+
     private:
 
       /// Total CM frame kinetic energy of both particles
@@ -79,10 +163,66 @@ namespace marley {
       std::complex<double> s_matrix_element(int fragment_pdg, int two_j,
         int l, int two_s);
 
-      // Helper functions for computing the optical model potential
-      void calculate_om_parameters(int fragment_pdg, int two_j, int l,
+      /// @brief Computes S-matrix elements for several partial waves at the
+      /// current energy
+      /// @details The radial equations for all of the partial waves are
+      /// integrated together using the Numerov method. The radial shape of
+      /// the potential is taken from the cached RadialGrid for the fragment,
+      /// and the energy-dependent strengths are shared between the waves.
+      /// Results are identical to those of separate s_matrix_element() calls.
+      /// @param fragment_pdg PDG code of the fragment
+      /// @param two_s Two times the spin of the fragment
+      /// @param waves Pairs of l and two_j values for the partial waves
+      /// @param[out] Ss S-matrix elements in the same order as waves
+      /// Temporary storage is obtained using the allocator of Ss.
+      void s_matrix_elements(int fragment_pdg, int two_s,
+        const marley::ScratchVector<std::pair<int, int> >& waves,
+        marley::ScratchVector<std::complex<double> >& Ss);
+
+      /// @brief Lists the (l, two_j) pairs in the order used by
+      /// transmission_coefficients()
+      /// @param[out] waves The (l, two_j) pairs
+      static void partial_waves(int two_s, int l_max,
+        marley::ScratchVector<std::pair<int, int> >& waves);
+
+      /// @brief Converts an S-matrix element into a transmission coefficient
+      static double transmission_coefficient_from_s(
+        const std::complex<double>& S);
+
+      /// @brief Eigenvalue of the spin-orbit operator 2(l.s)
+      static double compute_spin_orbit_eigenvalue(int two_j, int l,
         int two_s);
 
+      /// @brief Energy-independent radial shapes of the potential for a
+      /// particular fragment, evaluated at the Numerov integration points
+      struct RadialGrid {
+        std::vector<double> r; ///< Radius (fm)
+        std::vector<double> f_v; ///< Woods-Saxon shape for the volume terms
+        std::vector<double> dfdr_d; ///< Derivative shape for the surface term
+        /// Squared pion Compton wavelength times the derivative shape for the
+        /// spin-orbit terms (fm)
+        std::vector<double> so_shape;
+        std::vector<double> Vc; ///< Coulomb potential (MeV)
+      };
+
+      /// @brief Radial grids for each fragment, keyed by PDG code
+      std::map<int, RadialGrid> radial_grids_;
+
+      /// @brief Coulomb wavefunctions at recently used matching radii
+      CoulombWavefunctionCache coulomb_cache_;
+
+      /// @brief Adds points to a RadialGrid until it holds at least size of
+      /// them
+      /// @details The geometrical parameters of the fragment must already
+      /// have been set by calculate_om_parameters()
+      void extend_radial_grid(RadialGrid& grid, size_t size) const;
+
+      /// @brief Computes the energy-dependent strengths and geometrical
+      /// parameters of the potential for the current fragment_KE_lab_
+      /// @details These do not depend on the partial wave, so the previous
+      /// results are reused when the fragment and energy are unchanged
+      void calculate_om_parameters(int fragment_pdg, int two_s);
+
       // Compute the optical model potential at radius r
       std::complex<double> omp(double r) const;
 
@@ -100,10 +240,6 @@ namespace marley {
       // with a uniformly charged sphere with radius R and charge Q*e
       double Vc(double r, double R, int Q, int q) const;
 
-      // Non-derivative radial Schrödinger equation terms to use for computing
-      // transmission coefficients via the Numerov method
-      std::complex<double> a(double r, int l);
-
       // Version of Schrodinger equation terms with the optical model potential
       // U pre-computed
       std::complex<double> a(double r, int l, std::complex<double> U) const;
@@ -129,25 +265,63 @@ namespace marley {
       double spin_orbit_eigenvalue; // Eigenvalue of the spin-orbit operator
       int z; // Fragment atomic number
 
-      // Threshold for abs(U - Vc) used to find a suitable matching radius for
-      // computing transmission coefficients.
-      static constexpr double MATCHING_RADIUS_THRESHOLD = 1e-3;
+      // Inputs used for the values currently held by the temporary storage
+      // above and by the kinematic variables. They allow repeated calls with
+      // the same inputs (e.g., one per partial wave) to skip the calculation.
+      bool om_cache_valid_ = false;
+      int om_cache_pdg_ = 0;
+      double om_cache_KE_lab_ = 0.;
+      bool om_cache_spin_zero_ = false;
+
+      bool kin_cache_valid_ = false;
+      int kin_cache_pdg_ = 0;
+      double kin_cache_KE_CM_ = 0.;
+      double kin_cache_target_mass_ = 0.;
+
+      bool target_charge_valid_ = false;
+      int target_charge_ = 0;
 
       /// @brief Step size (fm) for integration of the Schr&ouml;dinger
       /// equation using the Numerov method
-      double step_size_ = DEFAULT_NUMEROV_STEP_SIZE_;
+      double step_size_ = DEFAULT_NUMEROV_STEP_SIZE;
 
-      /// @brief Default step size (fm) for computing transmission coefficients
-      /// via the
-      /// <a href="https://en.wikipedia.org/wiki/Numerov%27s_method">Numerov
-      /// method</a>
-      /// @todo Make this a user-controlled value specified in the
-      /// configuration file
-      static constexpr double DEFAULT_NUMEROV_STEP_SIZE_ = 0.1;
+      /// @brief Threshold (MeV) for abs(U - Vc) used to find a suitable
+      /// matching radius for computing transmission coefficients
+      double matching_threshold_ = DEFAULT_MATCHING_RADIUS_THRESHOLD;
+
+      /// @brief Grid spacing (MeV) for transmission coefficient tables
+      double table_energy_step_ = DEFAULT_TABLE_ENERGY_STEP;
+
+      /// @brief Key type for the transmission coefficient tables
+      /// @details The elements are the fragment PDG code, two times its total
+      /// angular momentum, its orbital angular momentum, two times its spin,
+      /// and the net charge of the target atom
+      using TableKey = std::tuple<int, int, int, int, int>;
+
+      /// @brief Transmission coefficients tabulated at total CM frame kinetic
+      /// energies k * table_energy_step_
+      /// @details Grid points that have not been computed yet hold NaN
+      std::map<TableKey, std::vector<double> > transmission_tables_;
+
+      /// @brief Computes a transmission coefficient by solving the
+      /// Schr&ouml;dinger equation
+      double exact_transmission_coefficient(double total_KE_CM,
+        int fragment_pdg, int two_j, int l, int two_s, int target_charge);
+
+      /// @brief Interpolates a transmission coefficient using the tables
+      double tabulated_transmission_coefficient(double total_KE_CM,
+        int fragment_pdg, int two_j, int l, int two_s, int target_charge);
 
       // More helper functions
       void calculate_kinematic_variables(double KE_tot_CM, int fragment_pdg);
       void update_target_mass(int target_charge);
   };
 
+  // Inline function definitions
+  inline double KoningDelarocheOpticalModel::get_table_energy_step() const
+    { return table_energy_step_; }
+
+  inline void KoningDelarocheOpticalModel::clear_transmission_tables()
+    { transmission_tables_.clear(); }
+
 }
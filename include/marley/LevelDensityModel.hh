@@ -15,6 +15,9 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <vector>
+
+#include "marley/MonotonicArena.hh"
 #include "marley/Parity.hh"
 
 namespace marley {
@@ -45,5 +48,41 @@ namespace marley {
       /// @param Pi The nuclear parity
       /// @return %Level density in MeV<sup> -1</sup>
       virtual double level_density(double Ex, int two_J, marley::Parity Pi) = 0;
+
+      /// Square of the spin cut-off parameter @f$ \sigma^2(E_x) @f$ that
+      /// describes the spin distribution of the nuclear levels
+      /// @param Ex Excitation energy in MeV
+      virtual double spin_cutoff_squared(double Ex) = 0;
+
+      /// %Level densities @f$ \rho(E_x, J, \Pi) @f$ for a ladder of nuclear
+      /// spins with a single parity
+      /// @details The default implementation calls
+      /// level_density(double, int, marley::Parity) once per spin. Derived
+      /// classes may override it to avoid repeating the spin-independent part
+      /// of the calculation.
+      /// @param Ex Excitation energy in MeV
+      /// @param Pi The nuclear parity
+      /// @param two_J_min Two times the smallest nuclear spin of interest
+      /// @param two_J_max Two times the largest nuclear spin of interest
+      /// @param[out] rhos %Level densities in MeV<sup> -1</sup>. On return,
+      /// element k holds the value for two_J = two_J_min + 2k.
+      virtual void level_density_all_spins(double Ex, marley::Parity Pi,
+        int two_J_min, int two_J_max, marley::ScratchVector<double>& rhos);
+
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by the model (e.g., for cached tables)
+      /// @details The default implementation returns zero
+      virtual size_t memory_usage() const { return 0u; }
   };
+
+  // Inline function definitions
+  inline void LevelDensityModel::level_density_all_spins(double Ex,
+    marley::Parity Pi, int two_J_min, int two_J_max,
+    marley::ScratchVector<double>& rhos)
+  {
+    rhos.clear();
+    for ( int two_J = two_J_min; two_J <= two_J_max; two_J += 2 ) {
+      rhos.push_back( level_density(Ex, two_J, Pi) );
+    }
+  }
 }
@@ -16,9 +16,14 @@
 
 #pragma once
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
 #include <vector>
 
 // Forward declare some MARLEY classes and their operator<< functions so that
@@ -139,32 +144,115 @@ namespace marley {
       };
 
       /// @brief Temporary object used for forming logger messages
-      /// @details Upon destruction, a newline is appended to the message. This
-      /// is based on a trick from https://stackoverflow.com/a/57553824
+      /// @details The message is formatted into a buffer owned by the
+      /// calling thread, so no lock is held while its parts are streamed.
+      /// Upon destruction, the finished message is handed to the Logger as
+      /// a single record. This keeps log messages written by different
+      /// threads from being interleaved with each other. The approach is
+      /// based on a trick from https://stackoverflow.com/a/57553824
       class Message {
         public:
-          Message(OutStreamVector& vec) : osvec_( vec ) {}
 
-          inline ~Message() {
-            osvec_ << '\n';
-          }
+          /// @param logger The Logger that will receive the message
+          /// @param lev Logging level of the message
+          /// @param suppressed Number of similar messages that were
+          /// suppressed by a RateLimit since the last one was written
+          Message(Logger& logger, LogLevel lev, uint64_t suppressed = 0u);
+
+          Message(Message&& other);
+
+          ~Message();
 
           template<typename OutputType> Message&&
             operator<<(const OutputType& ot)
           {
-            osvec_ << ot;
+            *os_ << ot;
+            return std::move( *this );
+          }
+
+          /// @brief Allows the use of output manipulators like std::endl
+          inline Message&& operator<<(std::ostream& (*manip)(std::ostream&))
+          {
+            manip( *os_ );
             return std::move( *this );
           }
 
         protected:
-          OutStreamVector& osvec_;
+
+          Logger& logger_;
+          LogLevel level_;
+          uint64_t suppressed_;
+
+          /// @brief Per-thread buffer that receives the message text
+          std::ostringstream* os_;
+
+          /// @brief Whether this object (rather than one it was moved to)
+          /// is responsible for sending the message
+          bool active_;
       };
 
+    public:
+
+      /// @brief Limits how often a frequently repeated log message is
+      /// written
+      /// @details The first few messages are always written. After that, at
+      /// most one message is written per time interval, and it notes how
+      /// many similar messages were suppressed in the meantime. A RateLimit
+      /// is typically declared as a static object next to the log statement
+      /// it controls (see MARLEY_LOG_WARNING_LIMITED()). All of its member
+      /// functions are thread-safe and lock-free.
+      class RateLimit {
+
+        public:
+
+          /// @param burst Number of messages that are always written
+          /// @param interval Minimum time between later messages (s)
+          RateLimit(uint64_t burst = 10u, double interval = 10.);
+
+          /// @brief Returns true if a message may be written now. Otherwise,
+          /// the message is counted as suppressed and false is returned.
+          bool allow();
+
+          /// @brief Returns the number of messages suppressed since the last
+          /// call to this function and resets the count to zero
+          inline uint64_t take_suppressed()
+            { return suppressed_.exchange( 0u, std::memory_order_relaxed ); }
+
+        private:
+
+          uint64_t burst_;
+          std::chrono::steady_clock::duration interval_;
+
+          /// @brief Number of calls to allow() so far
+          std::atomic<uint64_t> count_{ 0u };
+
+          /// @brief Number of messages suppressed since the last call to
+          /// take_suppressed()
+          std::atomic<uint64_t> suppressed_{ 0u };
+
+          /// @brief Earliest time (as a steady_clock tick count) at which
+          /// the next message may be written after the initial burst
+          std::atomic<int64_t> next_allowed_{ 0 };
+      };
+
+      /// @brief Helper for the MARLEY_LOG_* macros that discards a
+      /// completed message so that both branches of the conditional
+      /// expression used by the macros have type void
+      struct Voidifier {
+        inline void operator&(Message&&) const {}
+      };
+
+    private:
+
       /// @brief Create the singleton Logger
       /// @param log_enabled Create the Logger so that it is
       /// initially enabled (true) or disabled (false)
       Logger(bool log_enabled = true);
 
+      /// @brief Stops the background writer thread (if any) after all of
+      /// its queued messages have been written
+      ~Logger();
+
     public:
 
       /// @brief Get the singleton instance of the Logger class
@@ -201,6 +289,8 @@ namespace marley {
       inline void disable();
 
       /// @brief Flush all output streams associated with the Logger
+      /// @details In asynchronous mode, this first waits until every
+      /// message logged so far has been written
       void flush();
 
       /// @brief Send a newline character to all output streams ignoring
@@ -216,6 +306,36 @@ namespace marley {
       /// @param lev marley::Logger::LogLevel of the incoming message
       Message log(LogLevel lev = LogLevel::WARNING);
 
+      /// @brief Prepare the Logger to receive a log message controlled
+      /// by a RateLimit
+      /// @details The caller is responsible for checking RateLimit::allow()
+      /// first. The message notes how many similar messages were suppressed
+      /// since the last one was written.
+      Message log(LogLevel lev, RateLimit& limit);
+
+      /// @brief Enable or disable asynchronous logging
+      /// @details In asynchronous mode, completed messages are pushed onto
+      /// a lock-free queue and written to the streams by a dedicated
+      /// background thread, so threads that log never wait for the output
+      /// streams (or for each other). In synchronous mode (the default),
+      /// each message is written by the thread that completes it while
+      /// briefly holding the Logger's mutex. Switching modes first writes
+      /// any queued messages.
+      void set_async(bool async = true);
+
+      /// @brief Returns true if asynchronous logging is enabled
+      inline bool is_async() const
+        { return async_.load( std::memory_order_acquire ); }
+
+      /// @brief Returns false if a message at the given logging level
+      /// would certainly not be written to any stream
+      /// @details This check is lock-free and is used by the MARLEY_LOG_*
+      /// macros to skip formatting messages that nobody will see
+      inline bool will_log(LogLevel lev) const {
+        return static_cast<int>( lev )
+          <= max_level_.load( std::memory_order_relaxed );
+      }
+
       // Make the singleton Logger uncopyable and unmovable
       /// @brief Deleted copy constructor
       Logger(const Logger&) = delete;
@@ -258,6 +378,39 @@ namespace marley {
 
       /// @brief LogLevel of the last log message
       LogLevel old_level_;
+
+      /// @brief Helper function that recomputes max_level_ after the
+      /// streams or the enabled/disabled state have changed
+      void update_max_level();
+
+      /// @brief Most verbose logging level of any stream (or DISABLED if
+      /// the Logger itself is disabled), stored as an integer
+      std::atomic<int> max_level_{ static_cast<int>(LogLevel::DISABLED) };
+
+      /// @brief Writes a completed message to every stream that accepts
+      /// its logging level
+      void write_record(LogLevel lev, const std::string& text);
+
+      /// @brief Passes a completed message to write_record() or to the
+      /// background writer thread, depending on the current mode
+      void submit(LogLevel lev, std::string&& text);
+
+      /// @brief Lock-free queue and background thread used for asynchronous
+      /// logging (defined in Logger.cc)
+      class AsyncWriter;
+
+      /// @brief Writer used in asynchronous mode (created on first use)
+      std::unique_ptr<AsyncWriter> async_writer_;
+
+      /// @brief Whether asynchronous logging is enabled
+      std::atomic<bool> async_{ false };
+
+      /// @brief Mutex used to serialize writes to the output streams and
+      /// changes to the stream configuration
+      /// @details A recursive mutex is used so that member functions that
+      /// call each other (e.g., clear_streams() and add_stream()) may both
+      /// lock it
+      std::recursive_mutex mutex_;
   };
 
 }
@@ -272,19 +425,45 @@ template<typename OutputType> marley::Logger::OutStreamVector&
   return *this;
 }
 
-// Convenient shortcut functions for recording log messages
-inline auto MARLEY_LOG_ERROR() {
-  return marley::Logger::Instance().log(marley::Logger::LogLevel::ERROR);
-}
-
-inline auto MARLEY_LOG_WARNING() {
-  return marley::Logger::Instance().log(marley::Logger::LogLevel::WARNING);
-}
-
-inline auto MARLEY_LOG_INFO() {
-  return marley::Logger::Instance().log(marley::Logger::LogLevel::INFO);
-}
-
-inline auto MARLEY_LOG_DEBUG() {
-  return marley::Logger::Instance().log(marley::Logger::LogLevel::DEBUG);
-}
+// Least severe logging level whose messages are compiled into MARLEY. The
+// value is that of the corresponding marley::Logger::LogLevel (1 = ERROR,
+// 2 = WARNING, 3 = INFO, 4 = DEBUG). For example, defining
+// MARLEY_MIN_LOG_LEVEL=3 when building removes all debugging messages.
+#ifndef MARLEY_MIN_LOG_LEVEL
+  #define MARLEY_MIN_LOG_LEVEL 4
+#endif
+
+// Starts a log message at the given level. The message is used like a
+// stream (MARLEY_LOG_INFO() << "x = " << x;). If the message is compiled out
+// or would not be written to any stream, none of the << operands are
+// evaluated. The whole message is a single expression, so the macro may be
+// used safely as the body of an unbraced if statement. The & operator binds
+// less tightly than <<, so the Voidifier receives the finished message.
+#define MARLEY_LOG_AT_LEVEL(lev) \
+  ( static_cast<int>(lev) > MARLEY_MIN_LOG_LEVEL \
+    || !marley::Logger::Instance().will_log(lev) ) ? (void) 0 \
+  : marley::Logger::Voidifier() & marley::Logger::Instance().log(lev)
+
+// Like MARLEY_LOG_AT_LEVEL(), but the message is also subject to a
+// marley::Logger::RateLimit
+#define MARLEY_LOG_LIMITED(lev, limit) \
+  ( static_cast<int>(lev) > MARLEY_MIN_LOG_LEVEL \
+    || !marley::Logger::Instance().will_log(lev) || !(limit).allow() ) \
+  ? (void) 0 \
+  : marley::Logger::Voidifier() & marley::Logger::Instance().log(lev, limit)
+
+// Convenient shortcuts for recording log messages
+#define MARLEY_LOG_ERROR() \
+  MARLEY_LOG_AT_LEVEL( marley::Logger::LogLevel::ERROR )
+
+#define MARLEY_LOG_WARNING() \
+  MARLEY_LOG_AT_LEVEL( marley::Logger::LogLevel::WARNING )
+
+#define MARLEY_LOG_INFO() \
+  MARLEY_LOG_AT_LEVEL( marley::Logger::LogLevel::INFO )
+
+#define MARLEY_LOG_DEBUG() \
+  MARLEY_LOG_AT_LEVEL( marley::Logger::LogLevel::DEBUG )
+
+#define MARLEY_LOG_WARNING_LIMITED(limit) \
+  MARLEY_LOG_LIMITED( marley::Logger::LogLevel::WARNING, limit )
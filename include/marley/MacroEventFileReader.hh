@@ -21,8 +21,9 @@
 
 namespace marley {
 
-  // Forward-declare the Event class
+  // Forward-declare the Event and EventBatch classes
   class Event;
+  class EventBatch;
 
   class MacroEventFileReader {
 
@@ -34,6 +35,17 @@ namespace marley {
 
       bool next_event(marley::Event& ev);
 
+      /// @brief Read up to a given number of events into an EventBatch
+      /// @details See marley::RootEventFileReader::next_events(). Reading
+      /// events in batches avoids the per-event overhead of the wrapper and
+      /// of the ROOT dictionaries.
+      size_t next_events(size_t max_events, marley::EventBatch& batch);
+
+      /// @brief Position the reader so that the next call to next_event()
+      /// will load the event with a given index
+      /// @details See marley::EventFileReader::seek_event()
+      bool seek_event(size_t event_index);
+
       operator bool() const;
 
       /// @brief Stream operator for reading in the next event
@@ -0,0 +1,208 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "marley/BinaryEventBlock.hh"
+#include "marley/JSONDocument.hh"
+#include "marley/MappedFile.hh"
+#include "marley/OutputFile.hh"
+
+namespace marley {
+
+  class Event;
+
+  /// @brief Random-access reader for MARLEY output files that are too large
+  /// to parse comfortably through a stream
+  /// @details The file is mapped into memory using a marley::MappedFile.
+  /// An index of the starting position of every event (or of every event
+  /// block for the binary format) is built once when the reader is
+  /// constructed, so that events may be loaded in any order and processed
+  /// by several threads at once using parallel_for_each_event(). All of the
+  /// uncompressed, non-ROOT formats are supported. Unlike for
+  /// marley::EventFileReader, a JSON-format file is never parsed as a whole.
+  class MappedEventFileReader {
+
+    public:
+
+      /// @brief Function called for each event by
+      /// parallel_for_each_event()
+      /// @details The second argument is the index of the calling thread
+      /// (from zero up to one less than the number of threads used). It can
+      /// be used, e.g., to fill a separate histogram for each thread.
+      using EventFunction = std::function<void(const marley::Event&,
+        unsigned)>;
+
+      /// @param file_name Name of the event file (with any needed path
+      /// specification) to be read
+      MappedEventFileReader(const std::string& file_name);
+
+      MappedEventFileReader(const MappedEventFileReader&) = delete;
+      MappedEventFileReader& operator=(const MappedEventFileReader&)
+        = delete;
+
+      /// @brief Get the number of events stored in the file
+      inline size_t num_events() const;
+
+      /// @brief Get the format of the file being read
+      inline OutputFile::Format format() const;
+
+      /// @brief Load the event with a given index
+      /// @param index Position of the event in the file (starting from zero)
+      /// @param[out] ev Object that will be filled with the event record
+      void get_event(size_t index, marley::Event& ev);
+
+      /// @brief Read the next MARLEY event record from the file
+      /// @param[out] ev Reference to the object that will be filled with
+      /// the next event record
+      /// @return True if reading the next event was successful, or false
+      /// otherwise (e.g., after the last event in the file)
+      bool next_event(marley::Event& ev);
+
+      /// @brief Stream operator for reading in the next event
+      inline MappedEventFileReader& operator>>(marley::Event& ev);
+
+      /// @brief Implicit boolean conversion that is false once an attempt
+      /// to read past the last event has been made
+      inline operator bool() const;
+
+      /// @brief Returns the flux-averaged total cross section used to
+      /// produce the events in the file
+      /// @param natural_units If true, then this function will return the
+      /// flux-averaged total cross section in natural units
+      /// (MeV<sup> -2</sup>). If false (default), then 10<sup>-42</sup>
+      /// cm<sup>2</sup> will be used.
+      double flux_averaged_xsec(bool natural_units = false) const;
+
+      /// @brief Call a function for every event in the file using several
+      /// threads
+      /// @details The events are split into contiguous ranges, one per
+      /// thread, and each thread visits the events in its range in order.
+      /// The function may therefore be called concurrently, and it must be
+      /// safe to do so. If it throws an exception, the remaining events are
+      /// skipped and the exception is rethrown once all of the threads have
+      /// finished.
+      /// @param func Function to call for each event
+      /// @param num_threads Number of threads to use. If this is zero, then
+      /// the number of hardware threads will be used.
+      void parallel_for_each_event(const EventFunction& func,
+        unsigned num_threads = 0u) const;
+
+    protected:
+
+      /// @brief Most recently loaded event block for the binary format,
+      /// together with scratch storage for parsing JSON-format events
+      /// @details Reusing the same JSONDocument for every event avoids
+      /// allocating a new tree each time one is loaded
+      struct BlockCache {
+        marley::BinaryEventBlock block;
+        size_t block_index = static_cast<size_t>( -1 );
+        marley::JSONDocument json_doc;
+      };
+
+      /// @brief Determine the file format and build the event index
+      void build_index();
+
+      /// @brief Index an ASCII- or HEPEVT-format file
+      /// @param first_line Position of the first line of the first event
+      void build_text_index(size_t first_line);
+
+      /// @brief Index a JSON-format file
+      void build_json_index();
+
+      /// @brief Index a binary-format file
+      void build_binary_index();
+
+      /// @brief Load an event using a specific stream and block cache
+      /// @details The stream must read from the mapped file data. Giving
+      /// each thread its own stream and cache allows them to load events
+      /// concurrently.
+      void load_event(size_t index, marley::Event& ev, std::istream& in,
+        BlockCache& cache) const;
+
+      /// @brief Name of the file being read
+      std::string file_name_;
+
+      /// @brief Memory mapping of the file contents
+      marley::MappedFile file_;
+
+      /// @brief Stream buffer over the mapped file used by get_event() and
+      /// next_event()
+      marley::MemoryStreamBuf buffer_;
+
+      /// @brief Stream used by get_event() and next_event()
+      std::istream in_;
+
+      /// @brief Block cache used by get_event() and next_event()
+      BlockCache cache_;
+
+      /// @brief Format of the file being read
+      OutputFile::Format format_ = OutputFile::Format::ASCII;
+
+      /// @brief Number of events stored in the file
+      size_t num_events_ = 0u;
+
+      /// @brief Starting position of each event in a text-format file
+      std::vector<size_t> event_offsets_;
+
+      /// @brief Position of the body of each event block in a binary-format
+      /// file
+      std::vector<size_t> block_offsets_;
+
+      /// @brief Index of the first event stored in each event block
+      std::vector<size_t> block_first_events_;
+
+      /// @brief Version of the format used by a binary-format file
+      uint32_t binary_format_version_
+        = marley::BinaryEventBlock::FORMAT_VERSION;
+      /// @brief Precision of the kinematics in a binary-format file
+      marley::BinaryEventBlock::Precision binary_precision_
+        = marley::BinaryEventBlock::Precision::full;
+
+      /// @brief Flux-averaged total cross section (MeV<sup> -2</sup>) used
+      /// to produce the events in the file, or zero if that information is
+      /// not available
+      double flux_avg_tot_xs_ = 0.;
+
+      /// @brief Index of the event that will be loaded by next_event()
+      size_t next_index_ = 0u;
+
+      /// @brief Whether next_event() has not yet failed
+      bool good_ = true;
+  };
+
+  // Inline function definitions
+  inline size_t MappedEventFileReader::num_events() const
+    { return num_events_; }
+
+  inline OutputFile::Format MappedEventFileReader::format() const
+    { return format_; }
+
+  inline MappedEventFileReader& MappedEventFileReader::operator>>(
+    marley::Event& ev)
+  {
+    next_event( ev );
+    return *this;
+  }
+
+  inline MappedEventFileReader::operator bool() const { return good_; }
+
+}
@@ -0,0 +1,85 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+namespace marley {
+
+  /// @brief Read-only memory mapping of an entire file
+  /// @details The operating system keeps a single copy of the mapped pages
+  /// in its page cache, so every process that maps the same file shares it.
+  /// The file contents may be read directly from memory without copying
+  /// them into a private buffer first.
+  class MappedFile {
+
+    public:
+
+      /// @brief Map a file into memory
+      /// @details A marley::Error is thrown if the file cannot be mapped
+      /// @param file_name Name of the file to map
+      MappedFile(const std::string& file_name);
+
+      ~MappedFile();
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      /// @brief Get a pointer to the first byte of the file
+      inline const char* data() const;
+
+      /// @brief Get the size of the file in bytes
+      inline size_t size() const;
+
+    private:
+
+      /// @brief Start of the mapped region, or nullptr for an empty file
+      const char* data_ = nullptr;
+
+      /// @brief Size of the mapped region (bytes)
+      size_t size_ = 0u;
+  };
+
+  /// @brief Stream buffer that reads from a fixed region of memory
+  /// @details This allows a std::istream to read from a MappedFile (or
+  /// any other block of memory) without copying it. The memory must outlive
+  /// the stream buffer.
+  class MemoryStreamBuf : public std::streambuf {
+
+    public:
+
+      /// @param data Pointer to the first byte to read
+      /// @param size Number of bytes that may be read
+      MemoryStreamBuf(const char* data, size_t size);
+
+    protected:
+
+      /// @brief Repositions the get area within the memory region
+      /// @details Positions outside of the region are rejected
+      virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which = std::ios_base::in) override;
+
+      virtual pos_type seekpos(pos_type pos,
+        std::ios_base::openmode which = std::ios_base::in) override;
+  };
+
+  // Inline function definitions
+  inline const char* MappedFile::data() const { return data_; }
+  inline size_t MappedFile::size() const { return size_; }
+
+}
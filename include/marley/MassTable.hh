@@ -15,7 +15,11 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <cmath>
+#include <cstdlib>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace marley {
 
@@ -47,7 +51,7 @@ namespace marley {
       /// @brief Get the mass of a particle
       /// @param pdg_code PDG code identifying the type of particle
       /// @return %Particle mass (MeV)
-      double get_particle_mass(int pdg_code) const;
+      inline double get_particle_mass(int pdg_code) const;
 
       /// @brief Get the mass of an atom
       /// @param pdg_code PDG code identifying the nucleus of the atom
@@ -68,6 +72,34 @@ namespace marley {
       /// @return Atomic mass (MeV)
       double get_atomic_mass(int Z, int A, bool theory_ok = true) const;
 
+      /// @brief Get the mass of an ion
+      /// @details The ion mass is approximated by subtracting q electron
+      /// masses from the atomic mass
+      /// @param pdg_code PDG code identifying the nucleus of the ion
+      /// @param q Net charge of the ion (in units of the elementary charge)
+      /// @param theory_ok Whether to calculate a theoretical atomic mass
+      /// using the liquid drop model if an experimental mass cannot be found
+      /// @return Ion mass (MeV)
+      inline double get_ion_mass(int pdg_code, int q,
+        bool theory_ok = true) const;
+
+      /// @brief Get the mass of an ion
+      /// @param Z Atomic number of the ion
+      /// @param A Mass number of the ion
+      /// @param q Net charge of the ion (in units of the elementary charge)
+      /// @param theory_ok Whether to calculate a theoretical atomic mass
+      /// using the liquid drop model if an experimental mass cannot be found
+      /// @return Ion mass (MeV)
+      inline double get_ion_mass(int Z, int A, int q,
+        bool theory_ok = true) const;
+
+      /// @brief Get the total mass of q electrons
+      /// @details Values for the charge states of all tabulated elements are
+      /// computed when the table is loaded
+      /// @param q Number of electrons
+      /// @return Electron mass times q (MeV)
+      inline double electron_masses(int q) const;
+
       /// @brief Get the separation energy for emission of a nuclear fragment
       /// from a nucleus
       /// @param Z Atomic number for the mother nucleus
@@ -149,6 +181,20 @@ namespace marley {
       /// @param initial_nucleus_pdg PDG code of the initial nucleus
       double unbound_threshold(const int initial_nucleus_pdg) const;
 
+      /// @brief Converts a mass table data file from JSON into the compiled
+      /// binary format
+      /// @details When the singleton MassTable is created, it first looks
+      /// for a compiled version of the mass table data file in the same
+      /// folder. The compiled file has the same name as the original with
+      /// StructureDatabase::COMPILED_DECAY_SCHEME_SUFFIX appended. It is
+      /// used instead of the original whenever it is up to date, which
+      /// avoids parsing several thousand JSON objects at startup.
+      /// @param text_file_name Name of the JSON file to convert
+      /// @param binary_file_name Name of the compiled file to create
+      /// @return The number of masses that were converted
+      static int compile(const std::string& text_file_name,
+        const std::string& binary_file_name);
+
     protected:
 
       /// @brief Create the singleton MassTable object
@@ -156,9 +202,20 @@ namespace marley {
 
     private:
 
+      // Helper function that reads the masses from a JSON data file
+      static void read_json_table(const std::string& file_name,
+        std::unordered_map<int, double>& particle_masses,
+        std::unordered_map<int, double>& atomic_masses);
+
+      // Helper function that reads the masses from a compiled data file.
+      // Returns false if the compiled file is unreadable or out of date with
+      // respect to the JSON file text_file_name.
+      bool read_compiled_table(const std::string& binary_file_name,
+        const std::string& text_file_name);
+
       // Helper function that converts the input JSON array into
       // (PDG code, mass) pairs and stores them in map_to_use
-      void assign_masses(const marley::JSON& obj_array,
+      static void assign_masses(const marley::JSON& obj_array,
         const std::string& array_key,
         std::unordered_map<int, double>& map_to_use);
 
@@ -173,6 +230,41 @@ namespace marley {
       double lookup_atomic_mass(int Z, int A, bool& exp,
         bool theory_ok = true) const;
 
+      // Loads mass with the experimental atomic mass (micro-amu) for the
+      // given nuclide and returns true if one is present in the dense
+      // lookup table. Otherwise, returns false.
+      inline bool find_atomic_mass(int Z, int A, double& mass) const;
+
+      // Fills the dense lookup tables using the contents of the
+      // unordered maps
+      void build_dense_tables();
+
+      // Row of the dense atomic mass table holding all tabulated isotopes
+      // of a single element
+      struct AtomicMassRow {
+        size_t offset = 0; // Index of the first entry in dense_atomic_masses_
+        int A_min = 0; // Mass number of the first entry
+        int A_count = 0; // Number of entries (including gaps)
+      };
+
+      // Dense table of experimental atomic masses (micro-amu) indexed by
+      // (Z, A) via atomic_rows_. Gaps in the table hold NaN.
+      std::vector<double> dense_atomic_masses_;
+      std::vector<AtomicMassRow> atomic_rows_;
+
+      // Dense table of particle masses (MeV) indexed by the absolute value of
+      // the PDG code. PDG codes at or above dense_particle_masses_.size()
+      // (e.g., those of nuclear fragments) are looked up in particle_masses_
+      // instead. Gaps in the table hold NaN.
+      std::vector<double> dense_particle_masses_;
+
+      // Masses (MeV) of q electrons for q = 0, 1, ..., Z_max
+      std::vector<double> electron_masses_;
+
+      // Dense particle mass storage is only used for PDG codes below this
+      // limit (the nucleons have the largest codes of interest)
+      static constexpr int DENSE_PARTICLE_PDG_LIMIT = 10000;
+
       // Lookup table for particle masses. Keys are PDG particle
       // ID numbers, values are masses in micro-amu.
       std::unordered_map<int, double> particle_masses_;
@@ -189,4 +281,48 @@ namespace marley {
       static const std::string data_file_name_;
   };
 
+
+  // Inline function definitions
+  inline double MassTable::get_particle_mass(int pdg_code) const {
+    // The lookup table only includes entries for particles (as opposed to
+    // antiparticles), so flip the sign of the input particle id for the
+    // lookup if it represents an antiparticle.
+    size_t id = std::abs( pdg_code );
+    if ( id < dense_particle_masses_.size() ) {
+      double mass = dense_particle_masses_[ id ];
+      if ( !std::isnan(mass) ) return mass;
+    }
+    // Fall back to the unordered map (which throws for unknown particles)
+    // and convert the stored value from micro-amu to MeV
+    return micro_amu_ * particle_masses_.at( id );
+  }
+
+  inline double MassTable::electron_masses(int q) const {
+    if ( q >= 0 && static_cast<size_t>(q) < electron_masses_.size() ) {
+      return electron_masses_[ q ];
+    }
+    return q * electron_masses_.at( 1 );
+  }
+
+  inline double MassTable::get_ion_mass(int pdg_code, int q,
+    bool theory_ok) const
+  {
+    return get_atomic_mass( pdg_code, theory_ok ) - electron_masses( q );
+  }
+
+  inline double MassTable::get_ion_mass(int Z, int A, int q,
+    bool theory_ok) const
+  {
+    return get_atomic_mass( Z, A, theory_ok ) - electron_masses( q );
+  }
+
+  inline bool MassTable::find_atomic_mass(int Z, int A, double& mass) const
+  {
+    if ( Z < 0 || static_cast<size_t>(Z) >= atomic_rows_.size() ) return false;
+    const auto& row = atomic_rows_[ Z ];
+    int a = A - row.A_min;
+    if ( a < 0 || a >= row.A_count ) return false;
+    mass = dense_atomic_masses_[ row.offset + a ];
+    return !std::isnan( mass );
+  }
 }
@@ -0,0 +1,209 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Monotonic ("bump pointer") memory resource for short-lived
+  /// scratch storage
+  /// @details Memory is handed out from large blocks by advancing an offset,
+  /// and individual allocations are never freed. Instead, all of the memory
+  /// is released at once by reset(), or everything allocated after a
+  /// previously recorded Marker is released by rewind(). The blocks
+  /// themselves are retained, so once an arena has grown large enough, it
+  /// no longer calls the global allocator at all. Each Generator owns one of
+  /// these objects and resets it at the start of every event.
+  /// @note An arena may only be used by a single thread at a time.
+  class MonotonicArena {
+
+    public:
+
+      /// @brief Default size (in bytes) of each block of storage
+      static constexpr size_t DEFAULT_BLOCK_SIZE = 65536u;
+
+      /// @param block_size Minimum size (in bytes) of each block of storage.
+      /// No memory is allocated until it is first needed.
+      explicit MonotonicArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+      MonotonicArena(const MonotonicArena&) = delete;
+      MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+      /// @brief Allocate uninitialized storage
+      /// @param bytes Number of bytes needed
+      /// @param alignment Required alignment (a power of two)
+      void* allocate(size_t bytes,
+        size_t alignment = alignof(std::max_align_t));
+
+      /// @brief Position within the arena recorded by mark()
+      class Marker {
+        friend class MonotonicArena;
+        size_t block_ = 0u;
+        size_t offset_ = 0u;
+      };
+
+      /// @brief Record the current position within the arena
+      inline Marker mark() const;
+
+      /// @brief Release all storage allocated since the Marker was recorded
+      /// @details Any objects occupying that storage must already have been
+      /// destroyed.
+      inline void rewind(const Marker& marker);
+
+      /// @brief Release all allocated storage
+      /// @details If more than one block was needed since the last reset,
+      /// the blocks are merged into a single one so that subsequent use of
+      /// the arena can be served from contiguous storage.
+      void reset();
+
+      /// @brief Total size (in bytes) of the blocks owned by the arena
+      inline size_t capacity() const { return capacity_; }
+
+      /// @brief Releases everything allocated from an arena during its
+      /// lifetime
+      /// @details A null arena pointer is allowed, in which case this
+      /// object does nothing.
+      class Scope {
+        public:
+          inline explicit Scope(MonotonicArena* arena);
+          inline ~Scope();
+          Scope(const Scope&) = delete;
+          Scope& operator=(const Scope&) = delete;
+        private:
+          MonotonicArena* arena_;
+          Marker marker_;
+      };
+
+    private:
+
+      // Makes block_index the current block if it can hold the requested
+      // allocation. Returns a null pointer if it cannot.
+      void* allocate_from(size_t block_index, size_t bytes, size_t alignment);
+
+      struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+      };
+
+      std::vector<Block> blocks_;
+
+      /// @brief Index of the block currently being filled
+      size_t current_ = 0u;
+
+      /// @brief Number of bytes used in the current block
+      size_t offset_ = 0u;
+
+      /// @brief Minimum size of each new block
+      size_t block_size_;
+
+      /// @brief Sum of the sizes of all blocks
+      size_t capacity_ = 0u;
+  };
+
+  /// @brief Allocator that obtains memory from a MonotonicArena
+  /// @details A default-constructed allocator (or one created using a null
+  /// arena pointer) uses the global operator new and operator delete, so
+  /// containers that use this allocator behave like ordinary ones unless an
+  /// arena is provided.
+  template <typename T> class ArenaAllocator {
+
+    public:
+
+      using value_type = T;
+
+      ArenaAllocator() noexcept {}
+
+      ArenaAllocator(MonotonicArena* arena) noexcept : arena_( arena ) {}
+
+      template <typename U> ArenaAllocator(const ArenaAllocator<U>& other)
+        noexcept : arena_( other.arena() ) {}
+
+      inline T* allocate(size_t n);
+
+      inline void deallocate(T* p, size_t n) noexcept;
+
+      /// @brief Returns a pointer to the arena used by this allocator (or
+      /// nullptr if the global heap is used)
+      inline MonotonicArena* arena() const noexcept { return arena_; }
+
+    private:
+
+      MonotonicArena* arena_ = nullptr;
+  };
+
+  /// @brief std::vector that allocates its storage using an ArenaAllocator
+  template <typename T> using ScratchVector
+    = std::vector<T, ArenaAllocator<T> >;
+
+  // Inline function definitions
+  inline MonotonicArena::Marker MonotonicArena::mark() const {
+    Marker marker;
+    marker.block_ = current_;
+    marker.offset_ = offset_;
+    return marker;
+  }
+
+  inline void MonotonicArena::rewind(const Marker& marker) {
+    current_ = marker.block_;
+    offset_ = marker.offset_;
+  }
+
+  inline MonotonicArena::Scope::Scope(MonotonicArena* arena)
+    : arena_( arena )
+  {
+    if ( arena_ ) marker_ = arena_->mark();
+  }
+
+  inline MonotonicArena::Scope::~Scope() {
+    if ( arena_ ) arena_->rewind( marker_ );
+  }
+
+  template <typename T> inline T* ArenaAllocator<T>::allocate(size_t n) {
+    if ( n > std::numeric_limits<size_t>::max() / sizeof(T) ) {
+      throw std::bad_alloc();
+    }
+    size_t bytes = n * sizeof(T);
+    if ( !arena_ ) return static_cast<T*>( ::operator new(bytes) );
+    return static_cast<T*>( arena_->allocate(bytes, alignof(T)) );
+  }
+
+  template <typename T> inline void ArenaAllocator<T>::deallocate(T* p,
+    size_t /*n*/) noexcept
+  {
+    // Storage obtained from an arena is released all at once by the arena
+    // itself
+    if ( !arena_ ) ::operator delete( p );
+  }
+
+  template <typename T, typename U> inline bool operator==(
+    const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+  {
+    return a.arena() == b.arena();
+  }
+
+  template <typename T, typename U> inline bool operator!=(
+    const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+  {
+    return !( a == b );
+  }
+
+}
@@ -16,7 +16,9 @@
 
 #pragma once
 #include <functional>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include "marley/marley_utils.hh"
 #include "marley/InterpolationGrid.hh"
@@ -87,6 +89,10 @@ namespace marley {
 
       int pid_; ///< PDG particle ID for the neutrinos produced by this source
 
+      /// @brief Estimated maximum of pdf() used for rejection sampling in
+      /// sample_incident_neutrino()
+      mutable double pdf_max_ = marley_utils::UNKNOWN_MAX;
+
     private:
       /// PDG particle IDs for each neutrino that could possibly be produced by
       /// a NeutrinoSource object. Attempting to create a NeutrinoSource object
@@ -117,23 +123,112 @@ namespace marley {
   class MonoDMSource : public NeutrinoSource {
     public:
       /// @param particle_id neutrino PDG particle ID
-      /// @param E neutrino energy (MeV)
-      inline MonoDMSource(int particle_id =
-        marley_utils::DM, double M = 1., double V = 1., double LAMBDA = 1.);
+      /// @param M dark matter particle mass (MeV)
+      /// @param V dark matter particle speed (in units of c)
+      /// @param LAMBDA theory UV cutoff
+      inline MonoDMSource(int particle_id = marley_utils::DM, double M = 1.,
+        double V = marley_utils::DM_DEFAULT_VELOCITY, double LAMBDA = 1.);
 
       inline virtual double get_Emax() const override;
       inline virtual double get_Emin() const override;
       inline virtual double pdf(double E) const override;
-      //inline virtual double get_Mass() const override;
-      //inline virtual double get_Velocity() const override;
-      //inline virtual double get_UV() const override;
+
+      /// @brief Get the dark matter particle mass (MeV)
+      inline double mass() const { return dm_mass_; }
+
+      /// @brief Get the (mean) dark matter particle speed (in units of c)
+      inline double velocity() const { return dm_velocity_; }
+
+      /// @brief Get the theory UV cutoff
+      inline double cutoff() const { return dm_UV_cutoff_; }
+
+      /// @brief Sample a dark matter particle speed (in units of c)
+      /// @details The base class always returns the fixed speed given
+      /// to the constructor.
+      inline virtual double sample_velocity(marley::Generator&) const
+        { return dm_velocity_; }
 
     protected:
       double dm_mass_; ///< dm mass (MeV)
-      double dm_velocity_; ///< dm velocity (?/s)
+      double dm_velocity_; ///< dm speed (in units of c)
       double dm_UV_cutoff_; ///< theory uv cutoff param (?)
   };
 
+  /// @brief Dark matter source with particle speeds drawn from the standard
+  /// halo model
+  /// @details Speeds follow a Maxwell-Boltzmann distribution with most
+  /// probable speed @f$v_0@f$, truncated at the galactic escape speed
+  /// @f$v_\text{esc}@f$, as seen by a detector that moves through the halo
+  /// with speed @f$v_E@f$. In the detector frame, the speed distribution is
+  /// @f[ f(v) \propto \frac{v}{v_E}\left[e^{-(v - v_E)^2/v_0^2}
+  /// - e^{-\min(v + v_E,\,v_\text{esc})^2/v_0^2}\right] @f]
+  /// for @f$0 \leq v \leq v_\text{esc} + v_E@f$. Its inverse CDF is tabulated
+  /// once on a uniform probability grid so that speeds may be sampled in
+  /// constant time.
+  ///
+  /// The speed range is also divided into bins of equal probability. The
+  /// Generator evaluates the dark matter cross sections once at the median
+  /// speed of each bin and reuses them for every event.
+  class HaloDMSource : public MonoDMSource {
+    public:
+      /// @param particle_id dark matter PDG particle ID
+      /// @param M dark matter particle mass (MeV)
+      /// @param LAMBDA theory UV cutoff
+      /// @param v0 Most probable speed in the galactic frame (in units of c)
+      /// @param v_esc Galactic escape speed (in units of c)
+      /// @param v_earth Speed of the detector relative to the galactic frame
+      /// (in units of c)
+      /// @param num_bins Number of equal-probability speed bins
+      HaloDMSource(int particle_id, double M, double LAMBDA, double v0,
+        double v_esc, double v_earth,
+        size_t num_bins = DEFAULT_NUM_VELOCITY_BINS);
+
+      /// @brief Sample a speed (in units of c) from the full distribution
+      virtual double sample_velocity(marley::Generator& gen) const override;
+
+      /// @brief Sample a speed (in units of c) from within a single bin
+      double sample_velocity(marley::Generator& gen, size_t bin) const;
+
+      /// @brief Unnormalized probability density for the speed v (in units
+      /// of c)
+      double speed_pdf(double v) const;
+
+      /// @brief Speed (in units of c) below which a fraction u of the
+      /// distribution lies
+      /// @details This uses linear interpolation on the tabulated inverse CDF.
+      inline double quantile(double u) const;
+
+      /// @brief Get the number of equal-probability speed bins
+      inline size_t num_velocity_bins() const { return num_bins_; }
+
+      /// @brief Get the median speed (in units of c) within a bin
+      inline double bin_velocity(size_t bin) const
+        { return quantile( (bin + 0.5) / num_bins_ ); }
+
+      /// @brief Get the maximum speed (in units of c) in the detector frame
+      inline double max_velocity() const { return v_esc_ + v_earth_; }
+
+      inline double v0() const { return v0_; }
+      inline double v_esc() const { return v_esc_; }
+      inline double v_earth() const { return v_earth_; }
+
+      /// @brief Default number of equal-probability speed bins
+      static constexpr size_t DEFAULT_NUM_VELOCITY_BINS = 64u;
+
+    protected:
+
+      /// @brief Number of points used to tabulate the inverse CDF
+      static constexpr size_t NUM_QUANTILES = 2049u;
+
+      double v0_; ///< Most probable speed in the galactic frame (c)
+      double v_esc_; ///< Galactic escape speed (c)
+      double v_earth_; ///< Detector speed in the galactic frame (c)
+      size_t num_bins_; ///< Number of equal-probability speed bins
+
+      /// @brief Speeds at equally-spaced values of the CDF on [0, 1]
+      std::vector<double> quantiles_;
+  };
+
 
   /// @brief Supernova cooling neutrino source approximated using a Fermi-Dirac
   /// distribution
@@ -307,6 +402,88 @@ namespace marley {
       void check_for_errors();
   };
 
+  /// @brief Time-dependent neutrino source described by a series of time
+  /// bins, each with its own energy spectrum
+  /// @details This source is intended for transient sources (e.g., a
+  /// core-collapse supernova) with a spectrum that evolves over time. Time
+  /// bin j covers the interval [t<sub>j</sub>, t<sub>j+1</sub>) and is
+  /// assigned a relative number of emitted neutrinos together with a
+  /// NeutrinoSource that describes their energy spectrum. The pdf() member
+  /// function gives the time-integrated spectrum. When a Generator uses this
+  /// source, it tabulates the flux-weighted total cross section for every
+  /// bin once and then samples the time bin and the reacting neutrino energy
+  /// jointly. The sampled emission time is stored in each Event (see
+  /// marley::Event::time()).
+  class TimeBinnedNeutrinoSource : public NeutrinoSource {
+    public:
+
+      /// @param particle_id neutrino PDG particle ID
+      /// @param time_edges Strictly increasing time bin edges (in any unit).
+      /// There must be one more edge than there are bins.
+      /// @param bin_weights Relative number of neutrinos emitted in each
+      /// time bin
+      /// @param bin_sources Energy spectrum for each time bin. The spectra
+      /// do not need to be normalized, but they must produce neutrinos of the
+      /// type given by particle_id, and they may not be monoenergetic.
+      TimeBinnedNeutrinoSource(int particle_id,
+        const std::vector<double>& time_edges,
+        const std::vector<double>& bin_weights,
+        std::vector< std::unique_ptr<marley::NeutrinoSource> >&& bin_sources);
+
+      inline virtual double get_Emax() const override;
+
+      inline virtual double get_Emin() const override;
+
+      virtual double pdf(double E) const override;
+
+      /// @details A time bin is chosen according to the bin weights, and
+      /// the energy is then sampled from the spectrum for that bin.
+      virtual double sample_incident_neutrino(int& pdg,
+        marley::Generator& gen) const override;
+
+      /// @brief Get the number of time bins
+      inline size_t num_bins() const;
+
+      /// @brief Get the lower edge of time bin j
+      inline double bin_low_time(size_t j) const;
+
+      /// @brief Get the upper edge of time bin j
+      inline double bin_high_time(size_t j) const;
+
+      /// @brief Get the fraction of all emitted neutrinos that belong to
+      /// time bin j
+      inline double bin_fraction(size_t j) const;
+
+      /// @brief Energy spectrum for time bin j, normalized to unity
+      /// @param j Index of the time bin
+      /// @param E neutrino energy (MeV)
+      /// @return Probability density (MeV<sup> -1</sup>)
+      inline double bin_pdf(size_t j, double E) const;
+
+      /// @brief Get the energy spectrum used for time bin j
+      inline const marley::NeutrinoSource& bin_source(size_t j) const;
+
+    protected:
+
+      /// @brief Edges of the time bins
+      std::vector<double> time_edges_;
+
+      /// @brief Fraction of the emitted neutrinos in each time bin
+      std::vector<double> bin_fractions_;
+
+      /// @brief Running sum of bin_fractions_ used to sample a time bin
+      std::vector<double> cumulative_fractions_;
+
+      /// @brief Integral of the (unnormalized) spectrum for each time bin
+      std::vector<double> bin_norms_;
+
+      /// @brief Energy spectrum for each time bin
+      std::vector< std::unique_ptr<marley::NeutrinoSource> > bin_sources_;
+
+      double Emin_; ///< Minimum neutrino energy for all bins (MeV)
+      double Emax_; ///< Maximum neutrino energy for all bins (MeV)
+  };
+
   // Inline function definitions
   inline int NeutrinoSource::get_pid() const { return pid_; }
   inline bool NeutrinoSource::pdg_is_allowed(const int pdg)
@@ -323,13 +500,19 @@ namespace marley {
     : NeutrinoSource(particle_id), dm_mass_(M), dm_velocity_(V), dm_UV_cutoff_(LAMBDA) {}
   inline double MonoDMSource::get_Emax() const { return dm_mass_; }
   inline double MonoDMSource::get_Emin() const { return dm_UV_cutoff_; }
-  //inline double MonoDMSource::get_Mass() const { return dm_mass_; }
-  //inline double MonoDMSource::get_Velocity() const { return dm_velocity_; }
-  //inline double MonoDMSource::get_UV() const { return dm_UV_cutoff_; }
   inline double MonoDMSource::pdf(double E) const
     { return 1.; }
     //{ if (dm_mass_ == M) return 1.; else return 0.; }
 
+  inline double HaloDMSource::quantile(double u) const {
+    if ( u <= 0. ) return quantiles_.front();
+    if ( u >= 1. ) return quantiles_.back();
+    double x = u * ( NUM_QUANTILES - 1u );
+    size_t k = static_cast<size_t>( x );
+    double f = x - k;
+    return ( 1. - f )*quantiles_[ k ] + f*quantiles_[ k + 1u ];
+  }
+
   inline double FermiDiracNeutrinoSource::get_Emax() const { return Emax_; }
   inline double FermiDiracNeutrinoSource::get_Emin() const { return Emin_; }
 
@@ -353,6 +536,21 @@ namespace marley {
   inline double GridNeutrinoSource::pdf(double E) const
     { return grid_.interpolate(E); }
 
+  inline double TimeBinnedNeutrinoSource::get_Emax() const { return Emax_; }
+  inline double TimeBinnedNeutrinoSource::get_Emin() const { return Emin_; }
+  inline size_t TimeBinnedNeutrinoSource::num_bins() const
+    { return bin_sources_.size(); }
+  inline double TimeBinnedNeutrinoSource::bin_low_time(size_t j) const
+    { return time_edges_.at( j ); }
+  inline double TimeBinnedNeutrinoSource::bin_high_time(size_t j) const
+    { return time_edges_.at( j + 1 ); }
+  inline double TimeBinnedNeutrinoSource::bin_fraction(size_t j) const
+    { return bin_fractions_.at( j ); }
+  inline double TimeBinnedNeutrinoSource::bin_pdf(size_t j, double E) const
+    { return bin_sources_[ j ]->pdf( E ) / bin_norms_[ j ]; }
+  inline const marley::NeutrinoSource& TimeBinnedNeutrinoSource::bin_source(
+    size_t j) const { return *bin_sources_.at( j ); }
+
   inline GridNeutrinoSource::GridNeutrinoSource(const Grid& g, int particle_id)
     : NeutrinoSource(particle_id), grid_(g) { check_for_errors(); }
 
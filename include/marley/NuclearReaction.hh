@@ -18,10 +18,13 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <random>
 #include <regex>
 #include <string>
 #include <vector>
 
+#include "marley/AliasTable.hh"
+#include "marley/CrossSectionTable.hh"
 #include "marley/DecayScheme.hh"
 #include "marley/Event.hh"
 #include "marley/Level.hh"
@@ -39,6 +42,26 @@ namespace marley {
 
     public:
 
+      /// @brief Quantities computed by the constructor that depend only on
+      /// the particles involved in the reaction
+      /// @details These are stored in reaction bundle files (see
+      /// ReactionBundle) so that later jobs may skip the mass table lookups
+      /// and the tabulation of the Fermi function
+      struct PrecomputedData {
+        int pdg_a = 0; ///< Projectile PDG code
+        double ma = 0.; ///< Projectile mass (MeV)
+        double mb = 0.; ///< Target mass (MeV)
+        double mc = 0.; ///< Ejectile mass (MeV)
+        double md_gs = 0.; ///< Ground state mass (MeV) of the residue
+        double KEa_threshold = 0.; ///< Threshold kinetic energy (MeV)
+
+        /// @brief Contents of NuclearReaction::fermi_table_
+        std::vector<double> fermi_table;
+        double fermi_table_eta_coeff = 0.;
+        double fermi_table_x_min = 0.;
+        double fermi_table_inv_dx = 0.;
+      };
+
       /// @param pt Type of scattering process represented by this Reaction
       /// @param pdg_a Projectile PDG code
       /// @param pdg_b Target PDG code
@@ -48,9 +71,17 @@ namespace marley {
       /// represented by this NuclearReaction object
       /// @param mat_els A vector of MatrixElement objects that should
       /// be used to compute cross sections for this NuclearReaction
+      /// @param precomputed Values saved from an earlier NuclearReaction
+      /// with the same PDG codes (see precomputed_data()), or nullptr if
+      /// they should be computed here
       NuclearReaction(ProcessType pt, int pdg_a, int pdg_b, int pdg_c,
         int pdg_d, int q_d,
-        const std::shared_ptr<std::vector<marley::MatrixElement> >& mat_els);
+        const std::shared_ptr<std::vector<marley::MatrixElement> >& mat_els,
+        const PrecomputedData* precomputed = nullptr);
+
+      /// @brief Returns the quantities that may be passed to the constructor
+      /// to build an identical NuclearReaction without recomputing them
+      PrecomputedData precomputed_data() const;
 
       /// @brief Enumerated type used to set the method for handling Coulomb
       /// corrections for CC nuclear reactions
@@ -66,19 +97,55 @@ namespace marley {
       virtual marley::Event create_event(int particle_id_a,
         double KEa, double dm_mass, double dm_velocity, double dm_cutoff, marley::Generator& gen) const override;
 
+      virtual void create_event(int particle_id_a, double KEa,
+        marley::Generator& gen, marley::Event& ev) const override;
+      virtual void create_event(int particle_id_a, double KEa,
+        double dm_mass, double dm_velocity, double dm_cutoff,
+        marley::Generator& gen, marley::Event& ev) const override;
+
       /// @brief Compute the
       /// <a href="https://en.wikipedia.org/wiki/Beta_decay#Fermi_function">
       /// Fermi function</a>
       /// @param beta_c <a
       /// href="http://scienceworld.wolfram.com/physics/RelativisticBeta.html">
       /// Dimensionless speed</a> of the ejectile
+      /// @details For charged-current reactions, the value is interpolated
+      /// from a table built by the constructor whenever beta_c lies within
+      /// its bounds. Otherwise, exact_fermi_function() is used.
       double fermi_function(double beta_c) const;
 
+      /// @brief Compute the Fermi function without using the lookup table
+      /// @param beta_c Dimensionless speed of the ejectile
+      double exact_fermi_function(double beta_c) const;
+
+      /// @brief Natural logarithm of exact_fermi_function()
+      /// @details This remains finite at low speeds where the Fermi function
+      /// itself overflows or underflows.
+      /// @param beta_c Dimensionless speed of the ejectile
+      double log_exact_fermi_function(double beta_c) const;
+
       /// @brief Get the maximum possible excitation energy (MeV) of the
       /// final-state residue that is kinematically allowed
       /// @param KEa Projectile lab-frame kinetic energy (MeV)
       double max_level_energy(double KEa) const;
 
+      /// @brief Builds the HauserFeshbachDecay objects for every initial
+      /// state of the residue that is de-excited using the Hauser-Feshbach
+      /// model
+      /// @details Each final level that can be reached with a projectile
+      /// kinetic energy of at most KEa_max and that lies above the unbound
+      /// threshold (or belongs to a nuclide without discrete level data) is
+      /// visited with every spin-parity that create_event() may assign to
+      /// it. The decays are stored in the cache of the StructureDatabase
+      /// (see StructureDatabase::get_hf_decay()), so the first events that
+      /// reach these states do not need to compute their widths.
+      /// @param KEa_max Maximum lab-frame kinetic energy (MeV) of the
+      /// projectile
+      /// @param sdb StructureDatabase whose cache should be filled
+      /// @return The number of states visited
+      size_t prewarm_decays(double KEa_max,
+        marley::StructureDatabase& sdb) const;
+
       /// @brief Sets the DecayScheme object to use for sampling excited levels
       /// in the residue
       void set_decay_scheme(marley::DecayScheme* scheme);
@@ -95,9 +162,110 @@ namespace marley {
       /// @return Reaction total cross section (MeV<sup> -2</sup>)
       /// @note This function returns 0. if pdg_a != pdg_a_.
       //virtual double total_xs(int pdg_a, double KEa) const;// override;
-      //virtual double total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const;// override;
       virtual double total_xs(int pdg_a, double KEa) const;// override;
-      virtual double total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const;// override;
+      virtual double total_xs(int pdg_a, double KEa, double dm_mass,
+        double UV_cutoff, double dm_velocity
+        = marley_utils::DM_DEFAULT_VELOCITY) const override;
+
+      /// @brief Total reaction cross section (MeV<sup> -2</sup>) at each of
+      /// n projectile kinetic energies
+      /// @details Gives the same results as total_xs( int, double ). The
+      /// matrix elements are visited in the outer loop, so the loop over
+      /// levels is run once for the whole batch rather than once per energy.
+      /// @param pdg_a PDG code for the projectile
+      /// @param[in] KEas Array of lab-frame projectile kinetic energies (MeV)
+      /// @param[out] out Array that will be loaded with the total cross
+      /// sections
+      /// @param n Length of the KEas and out arrays
+      virtual void total_xs_batch(int pdg_a, const double* KEas, double* out,
+        size_t n) const override;
+
+      /// @brief Total reaction cross section (MeV<sup> -2</sup>) evaluated
+      /// without using the cross section table
+      /// @details This gives the same result as total_xs( int, double ) when
+      /// no table has been built. It is kept for validating the tabulated
+      /// values.
+      double exact_total_xs(int pdg_a, double KEa) const;
+
+      /// @brief Tabulates the total cross section to each final nuclear level
+      /// on an adaptive grid of projectile kinetic energies
+      /// @details Once the table is built, total_xs( int, double ) and the
+      /// level sampling weights used by create_event() are interpolated from
+      /// it for kinetic energies between the reaction threshold and KEa_max.
+      /// Exact evaluation is used outside of this range. Any existing table is
+      /// replaced.
+      /// @param KEa_max Maximum projectile kinetic energy (MeV) to include in
+      /// the table
+      void build_xs_table( double KEa_max );
+
+      /// @brief Discards the cross section table (if any) so that all
+      /// cross sections will be computed exactly
+      void clear_xs_table();
+
+      /// @brief Uses a table loaded from a file (e.g., one written by the
+      /// mardumpxs tool) as the cross section table for this reaction
+      /// @details The table is accepted only if it stores the per-level
+      /// cross sections, and if its PDG codes and level energies match those
+      /// of this reaction. Any existing table is replaced in that case.
+      /// @return True if the table was accepted, or false otherwise
+      bool use_xs_table(const marley::CrossSectionTable& table);
+
+      /// @brief Returns a copy of the cross section table in a form that
+      /// can be passed to use_xs_table()
+      /// @details The table is empty if has_xs_table() is false
+      marley::CrossSectionTable get_xs_table() const;
+
+      /// @brief Computes the exact partial total cross section to every
+      /// final nuclear level
+      /// @details Like exact_total_xs(), this may be called concurrently
+      /// from several threads.
+      /// @param KEa Lab-frame projectile kinetic energy (MeV)
+      /// @param[out] level_xsecs Loaded with one value per entry in
+      /// matrix_elements(). Inaccessible levels are assigned zero.
+      /// @return The total cross section summed over all levels
+      double exact_xs_by_level(double KEa,
+        std::vector<double>& level_xsecs) const;
+
+      /// @brief Returns the projectile kinetic energies (MeV) between KEa_min
+      /// and KEa_max at which each final level becomes accessible
+      /// @details The partial cross sections have kinks at these energies,
+      /// so they are useful grid points for tables
+      std::vector<double> level_threshold_KEs(double KEa_min,
+        double KEa_max) const;
+
+      /// @brief Returns true if a cross section table is in use or false
+      /// otherwise
+      inline bool has_xs_table() const { return !xs_table_KEs_.empty(); }
+
+      /// @brief Returns the number of grid points in the cross section table
+      inline size_t xs_table_size() const { return xs_table_KEs_.size(); }
+
+      /// @brief Bias factor applied when sampling final nuclear levels
+      /// @details The partial cross section to each level whose excitation
+      /// energy lies within [Ex_min, Ex_max] is multiplied by the factor
+      /// when a level is chosen in create_event(). The weight of the
+      /// resulting Event compensates for the bias.
+      struct LevelBias {
+        double Ex_min; ///< Minimum excitation energy (MeV)
+        double Ex_max; ///< Maximum excitation energy (MeV)
+        double factor; ///< Positive bias factor
+      };
+
+      /// @brief Adds a bias factor for sampling final nuclear levels
+      /// @details If more than one LevelBias applies to a level, then their
+      /// factors are multiplied together.
+      void add_level_bias(const LevelBias& bias);
+
+      /// @brief Removes all level bias factors
+      void clear_level_biases();
+
+      /// @brief Get the level bias factors in use
+      inline const std::vector<LevelBias>& level_biases() const
+        { return level_biases_; }
+
+      /// @brief Get the combined bias factor for a level
+      /// @param Ex Excitation energy of the level (MeV)
+      double level_bias(double Ex) const;
 
       /// @brief Differential cross section
       /// @f$d\sigma/d\cos\theta_{c}^{\mathrm{CM}}@f$
@@ -139,6 +307,21 @@ namespace marley {
       virtual double dm_total_xs(double dm_mass, double dm_velocity, double dm_cutoff, double energy_level, const marley::MatrixElement& me, double KEa,
         double& beta_c_cm, bool check_max_E_level = true) const;
 
+      /// @brief Dark matter version of the single-level differential cross
+      /// section @f$d\sigma/d\cos\theta_{c}^{\mathrm{CM}}@f$
+      /// (MeV<sup> -2</sup>)
+      /// @param mat_el MatrixElement object describing the transition to the
+      /// final nuclear level
+      /// @param KEa Lab-frame projectile kinetic energy (MeV)
+      /// @param dm_mass Dark matter particle mass (MeV)
+      /// @param dm_velocity Dark matter particle speed (in units of c)
+      /// @param dm_cutoff Theory UV cutoff parameter (MeV)
+      /// @param cos_theta_c_cm Ejectile scattering cosine as measured
+      /// in the CM frame
+      double dm_diff_xs(const marley::MatrixElement& mat_el, double KEa,
+        double dm_mass, double dm_velocity, double dm_cutoff,
+        double cos_theta_c_cm) const;
+
       /// Computes an approximate correction factor to account for
       /// effects of the Coulomb potential when calculating cross sections
       /// @param beta_rel_cd The relative speed of the final particles c and d
@@ -172,8 +355,10 @@ namespace marley {
         { return coulomb_mode_; }
 
       /// Set the method for handling Coulomb corrections for this reaction
+      /// @details Any cross section table is discarded since its values
+      /// depend on the Coulomb correction method
       inline void set_coulomb_mode( CoulombMode mode )
-        { coulomb_mode_ = mode; }
+        { coulomb_mode_ = mode; clear_xs_table(); }
 
       /// Convert a string to a CoulombMode value
       static CoulombMode coulomb_mode_from_string( const std::string& str );
@@ -187,12 +372,6 @@ namespace marley {
       /// to and from a std::string
       static std::map<CoulombMode, std::string> coulomb_mode_string_map_;
 
-      /// Helper function used by NuclearReaction::create_event()
-      virtual marley::Event make_event_object(double KEa,
-        double pc_cm, double cos_theta_c_cm, double phi_c_cm, double Ec_cm,
-        double Ed_cm, double E_level, int twoJ, const marley::Parity& P)
-        const override;
-
       /// @brief Samples a polar angle cosine for the ejectile using
       /// the relevant portion of the reaction nuclear matrix element
       /// @param m_type Integer representing the type of transition
@@ -201,9 +380,30 @@ namespace marley {
       /// href="http://scienceworld.wolfram.com/physics/RelativisticBeta.html">
       /// Dimensionless speed</a> of the ejectile in the CM frame
       /// @param gen Reference to the Generator to use for random sampling
+      /// @details The angular distributions are linear in the scattering
+      /// cosine, so they are sampled by exact inversion of the CDF. This
+      /// needs only a single random number per event.
       double sample_cos_theta_c_cm(const marley::MatrixElement& matrix_el,
         double beta_c_cm, marley::Generator& gen) const;
 
+      /// @brief Pointer to a per-level total cross section kernel
+      using LevelXsKernel = double (NuclearReaction::*)(
+        const marley::MatrixElement&, double, double&, bool) const;
+
+      /// @brief Per-level total cross section with the process type fixed
+      /// at compile time
+      /// @details Takes the same arguments as total_xs( const
+      /// marley::MatrixElement&, double, double&, bool ). One instantiation
+      /// exists for each ProcessType, and the constructor selects the
+      /// appropriate one via select_level_xs_kernel().
+      template <ProcessType PT> double level_total_xs(
+        const marley::MatrixElement& me, double KEa, double& beta_c_cm,
+        bool check_max_E_level) const;
+
+      /// @brief Returns the per-level total cross section kernel for the
+      /// given ProcessType
+      static LevelXsKernel select_level_xs_kernel( ProcessType pt );
+
       /// Helper function for total_xs and summed_diff_xs()
       /// @param pdg_a PDG code for the projectile
       /// @param KEa Lab-frame projectile kinetic energy (MeV)
@@ -226,10 +426,82 @@ namespace marley {
       double summed_xs_helper(int pdg_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,double cos_theta_c_cm,
         std::vector<double>* level_xsecs, bool differential) const;
 
+      /// @brief Partial total cross section (MeV<sup> -2</sup>) to a single
+      /// level as used by summed_xs_helper() and total_xs_batch()
+      /// @param mat_el MatrixElement object describing the transition to the
+      /// final nuclear level
+      /// @param KEa Lab-frame projectile kinetic energy (MeV)
+      /// @param[out] beta_c_cm Ejectile speed in the CM frame
+      double summed_level_xs(const marley::MatrixElement& mat_el, double KEa,
+        double& beta_c_cm) const;
+
+      /// @brief Interpolates the cross section table
+      /// @param KEa Lab-frame projectile kinetic energy (MeV), which must
+      /// lie within the table bounds
+      /// @param level_xsecs If this pointer is not nullptr, then the vector
+      /// that it points to is loaded with the partial cross sections in the
+      /// same way as by summed_xs_helper()
+      /// @return The total cross section summed over all levels
+      double tabulated_xs(double KEa, std::vector<double>* level_xsecs) const;
+
+      /// @brief Samples the index of the matrix element that will be used
+      /// to create an event
+      /// @details The partial cross sections to each level are recomputed
+      /// only when the kinematic inputs differ from those used for the
+      /// previous event. Otherwise, the cached alias table is reused.
+      /// @param pdg_a PDG code for the projectile
+      /// @param KEa Lab-frame projectile kinetic energy (MeV)
+      /// @param dm_mass Dark matter particle mass (MeV)
+      /// @param dm_velocity Dark matter particle speed (in units of c)
+      /// @param dm_cutoff Dark matter UV cutoff
+      /// @param dm Whether the dark matter cross sections (true) or the
+      /// usual ones (false) should be used. The three dark matter
+      /// parameters are ignored when this is false.
+      /// @param gen Reference to the Generator to use for random sampling
+      /// @param[out] weight Event weight that compensates for any level
+      /// biases (unity if there are none)
+      size_t sample_matrix_element_index(int pdg_a, double KEa,
+        double dm_mass, double dm_velocity, double dm_cutoff, bool dm,
+        marley::Generator& gen, double& weight) const;
+
+      /// @brief Samples a matrix element index at a projectile energy
+      /// covered by the cross section table
+      /// @details The interpolated level weights at KEa are a mixture of the
+      /// weights at the two neighboring grid points. A grid point is chosen
+      /// with probability proportional to its share of the interpolated sum
+      /// over the accessible levels, and then a level is drawn from that
+      /// point's weights by a binary search of their running sums. This
+      /// gives the same distribution as the weights computed by
+      /// tabulated_xs(), but no per-level work is needed for each new energy.
+      /// @param KEa Lab-frame projectile kinetic energy (MeV), which must
+      /// lie within the table bounds
+      /// @param gen Reference to the Generator to use for random sampling
+      /// @param[out] weight Event weight that compensates for any level
+      /// biases (unity if there are none)
+      size_t sample_tabulated_level(double KEa, marley::Generator& gen,
+        double& weight) const;
+
+      /// @brief Returns true if KEa lies within the cross section table
+      inline bool in_xs_table(double KEa) const {
+        return !xs_table_KEs_.empty() && KEa >= xs_table_KEs_.front()
+          && KEa <= xs_table_KEs_.back();
+      }
+
       /// @brief Creates the description string based on the
       /// PDG code values for the initial and final particles
       void set_description();
 
+      /// @brief Tabulates the natural logarithm of the Fermi function on a
+      /// uniform grid in @f$\ln(\beta_c\gamma_c)@f$
+      /// @details The Fermi function depends only on the residue's charge
+      /// and mass number and on the ejectile's mass and charge, all of which
+      /// are fixed when the reaction is constructed.
+      void build_fermi_table();
+
+      /// @brief Looks up the particle masses in the MassTable and computes
+      /// the threshold kinetic energy for this reaction
+      void compute_masses_and_threshold();
+
       double md_gs_; ///< Ground state mass (MeV) of the residue
 
       int Zi_; ///< Target atomic number
@@ -250,9 +522,158 @@ namespace marley {
       /// for this reaction
       CoulombMode coulomb_mode_ = CoulombMode::FERMI_AND_MEMA;
 
+      /// @brief Per-level total cross section kernel for the process type
+      /// of this reaction
+      LevelXsKernel level_xs_kernel_ = nullptr;
+
       /// @brief Matrix elements representing all of the possible nuclear
       /// transitions that may be caused by this reaction
       std::shared_ptr< std::vector<marley::MatrixElement> > matrix_elements_;
+
+      /// @brief Level sampling weights and the inputs used to compute them
+      /// @details Monoenergetic sources (including the dark matter source)
+      /// request every event at the same kinematic inputs, so the weights
+      /// and alias table from the previous event can be used again as-is.
+      /// Keeping this as a member (rather than a function-local static
+      /// variable) ensures that NuclearReaction objects owned by different
+      /// Generators do not share any mutable state.
+      struct LevelWeightCache {
+
+        /// @brief Whether the remaining members hold valid results
+        bool valid = false;
+
+        /// @brief Whether the dark matter cross sections were used
+        bool dm = false;
+
+        double KEa = 0.; ///< Projectile kinetic energy (MeV)
+        double dm_mass = 0.; ///< Dark matter particle mass (MeV)
+        double dm_velocity = 0.; ///< Dark matter particle speed (c)
+        double dm_cutoff = 0.; ///< Dark matter UV cutoff
+
+        /// @brief Partial total cross sections to each kinematically
+        /// accessible level with a nonvanishing matrix element, multiplied
+        /// by any level bias factors
+        std::vector<double> level_weights;
+
+        /// @brief Ratio of the sums of the biased and unbiased level
+        /// weights
+        double bias_norm = 1.;
+
+        /// @brief Alias table built from the (biased) level_weights
+        marley::AliasTable table;
+
+        /// @brief Returns true if the cached results were computed using
+        /// the given inputs
+        inline bool matches(double KE, double mass, double velocity,
+          double cutoff, bool use_dm) const
+        {
+          if ( !valid || use_dm != dm || KE != KEa ) return false;
+          return !use_dm || ( mass == dm_mass && velocity == dm_velocity
+            && cutoff == dm_cutoff );
+        }
+      };
+
+      /// @brief Cached level sampling weights used by create_event()
+      mutable LevelWeightCache level_cache_;
+
+      /// @brief Level sampling weights saved for each distinct set of dark
+      /// matter parameters seen so far
+      /// @details A HaloDMSource requests one speed per velocity bin, so
+      /// these are reused instead of recomputing the dark matter cross
+      /// sections whenever the speed changes from one event to the next.
+      mutable std::vector<LevelWeightCache> dm_level_caches_;
+
+      /// @brief Maximum number of entries kept in dm_level_caches_
+      static constexpr size_t MAX_DM_LEVEL_CACHES_ = 256u;
+
+      /// @brief Dark matter partial total cross sections for a unit UV
+      /// cutoff
+      /// @details The dark matter cross sections are proportional to
+      /// @f$\Lambda^{-4}@f$, so the values for any cutoff are obtained by
+      /// rescaling these.
+      struct DMLevelRow {
+
+        /// @brief Partial cross section (MeV<sup> -2</sup>) to each level
+        /// with a nonvanishing matrix element, in the same order used by
+        /// summed_xs_helper()
+        std::vector<double> level_xs;
+
+        /// @brief Sum of the entries in level_xs (MeV<sup> -2</sup>)
+        double total = 0.;
+      };
+
+      /// @brief Returns the table row for a given dark matter mass (MeV) and
+      /// speed (in units of c), computing it if needed
+      const DMLevelRow& dm_level_row(double dm_mass, double dm_velocity)
+        const;
+
+      /// @brief Table of dark matter partial cross sections keyed by the
+      /// dark matter mass and speed
+      mutable std::map< std::pair<double, double>, DMLevelRow >
+        dm_level_table_;
+
+      /// @brief Maximum number of rows kept in dm_level_table_
+      static constexpr size_t MAX_DM_LEVEL_TABLE_ROWS_ = 4096u;
+
+      /// @brief Bias factors used when sampling final nuclear levels
+      std::vector<LevelBias> level_biases_;
+
+      /// @brief Values of @f$\ln F + C/\beta_c@f$ at equally-spaced grid
+      /// points in @f$\ln(\beta_c\gamma_c)@f$, where F is the Fermi
+      /// function and C is fermi_table_eta_coeff_
+      /// @details Left empty for reactions that do not need Coulomb
+      /// corrections
+      std::vector<double> fermi_table_;
+
+      /// @brief Coefficient C used to remove the low-speed exponential
+      /// suppression of the Fermi function from fermi_table_
+      /// @details This is @f$2\pi\alpha Z_f@f$ for a final-state antilepton
+      /// and zero otherwise
+      double fermi_table_eta_coeff_ = 0.;
+
+      /// @brief Value of @f$\ln(\beta_c\gamma_c)@f$ at the first grid point
+      /// in fermi_table_
+      double fermi_table_x_min_ = 0.;
+
+      /// @brief Reciprocal of the grid spacing in fermi_table_
+      double fermi_table_inv_dx_ = 0.;
+
+      /// @brief The parameter @f$s = \sqrt{1 - (\alpha Z_f)^2}@f$ used in
+      /// the Fermi function
+      double fermi_s_ = 1.;
+
+      /// @brief The value of @f$\ln[2(1 + s)] - 2\ln\Gamma(1 + 2s)@f$
+      double fermi_log_coeff_ = 0.;
+
+      /// @brief Natural logarithm of twice the nuclear radius of the residue
+      /// times the ejectile mass
+      double fermi_log_2_rho_mc_ = 0.;
+
+      /// @brief Projectile kinetic energies (MeV) used as grid points in the
+      /// cross section table
+      std::vector<double> xs_table_KEs_;
+
+      /// @brief Partial total cross sections (MeV<sup> -2</sup>) to each level
+      /// at the grid points in xs_table_KEs_
+      /// @details Entry i * matrix_elements_->size() + j holds the value for
+      /// level j at grid point i
+      std::vector<double> xs_table_levels_;
+
+      /// @brief Total cross sections (MeV<sup> -2</sup>) at the grid points
+      /// in xs_table_KEs_
+      std::vector<double> xs_table_totals_;
+
+      /// @brief Running sums over the levels of the (biased) partial cross
+      /// sections in xs_table_levels_
+      /// @details Uses the same layout as xs_table_levels_. Built on demand
+      /// by sample_tabulated_level() and cleared whenever the table or the
+      /// level biases change.
+      mutable std::vector<double> xs_table_level_cdfs_;
+
+      /// @brief Running sums of the unbiased partial cross sections
+      /// @details Only filled when level biases are present, since
+      /// xs_table_level_cdfs_ holds the same values otherwise
+      mutable std::vector<double> xs_table_unbiased_cdfs_;
   };
 
 }
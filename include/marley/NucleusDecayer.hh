@@ -14,6 +14,8 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#pragma once
+
 // MARLEY includes
 #include "marley/EventProcessor.hh"
 
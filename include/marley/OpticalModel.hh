@@ -16,6 +16,11 @@
 
 #pragma once
 #include <complex>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "marley/MonotonicArena.hh"
 
 namespace marley {
 
@@ -30,6 +35,16 @@ namespace marley {
 
       virtual ~OpticalModel() = default;
 
+      /// @brief Method used by transmission_coefficient() to obtain its
+      /// return value
+      enum class TransmissionMode {
+        /// @brief Solve the Schr&ouml;dinger equation for every call
+        Exact,
+        /// @brief Interpolate on tabulated transmission coefficients
+        /// (if supported by the derived class, otherwise identical to Exact)
+        Table
+      };
+
       /// @brief Calculate the optical model potential (including the Coulomb
       /// potential)
       /// @param r Distance from nuclear center (fm)
@@ -54,6 +69,40 @@ namespace marley {
       virtual double transmission_coefficient(double total_KE_CM, int fragment_pdg,
         int two_j, int l, int two_s, int target_charge = 0) = 0;
 
+      /// @brief Calculate the transmission coefficients for every partial
+      /// wave of a nuclear fragment up to a maximum orbital angular momentum
+      /// @details The default implementation makes one call to
+      /// transmission_coefficient() per partial wave. Derived classes may
+      /// override it to share work between the partial waves.
+      /// @param total_KE_CM Total CM frame kinetic energy (MeV)
+      /// @param fragment_pdg PDG code of the fragment
+      /// @param two_s Two times the spin of the fragment
+      /// @param l_max Maximum orbital angular momentum of the fragment
+      /// @param[out] Tljs Transmission coefficients ordered by increasing l
+      /// and then by increasing two_j, which runs from |2l - two_s| to
+      /// 2l + two_s in steps of two
+      /// @param target_charge Net charge of the target atom
+      virtual void transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s, int l_max,
+        marley::ScratchVector<double>& Tljs, int target_charge = 0);
+
+      /// @brief Calculate the transmission coefficients for a list of
+      /// partial waves of a nuclear fragment
+      /// @details The default implementation makes one call to
+      /// transmission_coefficient() per partial wave. Derived classes may
+      /// override it to share work between the partial waves.
+      /// @param total_KE_CM Total CM frame kinetic energy (MeV)
+      /// @param fragment_pdg PDG code of the fragment
+      /// @param two_s Two times the spin of the fragment
+      /// @param waves Pairs of l and two_j values for the partial waves
+      /// @param[out] Tljs Transmission coefficients in the same order as
+      /// waves
+      /// @param target_charge Net charge of the target atom
+      virtual void partial_wave_transmission_coefficients(double total_KE_CM,
+        int fragment_pdg, int two_s,
+        const marley::ScratchVector<std::pair<int, int> >& waves,
+        marley::ScratchVector<double>& Tljs, int target_charge = 0);
+
       /// @brief Compute the energy-averaged total cross section
       /// (MeV<sup> -2</sup>) for a nuclear fragment projectile
       /// @details The total cross section given here by the optical model may
@@ -79,6 +128,17 @@ namespace marley {
       virtual double total_cross_section(double fragment_KE_lab,
         int fragment_pdg, int two_s, size_t l_max, int target_charge = 0) = 0;
 
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by the model (e.g., for cached tables)
+      /// @details The default implementation returns zero
+      virtual size_t memory_usage() const { return 0u; }
+
+      /// @brief Get the method used to compute transmission coefficients
+      inline TransmissionMode get_transmission_mode() const;
+
+      /// @brief Set the method used to compute transmission coefficients
+      inline void set_transmission_mode(TransmissionMode mode);
+
       /// @brief Get the atomic number
       inline int Z() const;
 
@@ -89,9 +149,46 @@ namespace marley {
 
       // Nuclear atomic and mass numbers
       int Z_, A_;
+
+      /// @brief Method used to compute transmission coefficients
+      TransmissionMode transmission_mode_ = TransmissionMode::Exact;
   };
 
   // Inline function definitions
+  inline OpticalModel::TransmissionMode OpticalModel::get_transmission_mode()
+    const { return transmission_mode_; }
+
+  inline void OpticalModel::set_transmission_mode(TransmissionMode mode)
+    { transmission_mode_ = mode; }
+
+  inline void OpticalModel::transmission_coefficients(double total_KE_CM,
+    int fragment_pdg, int two_s, int l_max,
+    marley::ScratchVector<double>& Tljs, int target_charge)
+  {
+    Tljs.clear();
+    for (int l = 0; l <= l_max; ++l) {
+      int two_l = 2*l;
+      for (int two_j = std::abs(two_l - two_s);
+        two_j <= two_l + two_s; two_j += 2)
+      {
+        Tljs.push_back( transmission_coefficient(total_KE_CM, fragment_pdg,
+          two_j, l, two_s, target_charge) );
+      }
+    }
+  }
+
+  inline void OpticalModel::partial_wave_transmission_coefficients(
+    double total_KE_CM, int fragment_pdg, int two_s,
+    const marley::ScratchVector<std::pair<int, int> >& waves,
+    marley::ScratchVector<double>& Tljs, int target_charge)
+  {
+    Tljs.clear();
+    for ( const auto& wave : waves ) {
+      Tljs.push_back( transmission_coefficient(total_KE_CM, fragment_pdg,
+        wave.second, wave.first, two_s, target_charge) );
+    }
+  }
+
   inline int OpticalModel::Z() const { return Z_; }
 
   inline int OpticalModel::A() const { return A_; }
@@ -17,8 +17,21 @@
 #pragma once
 
 // standard library includes
+#include <atomic>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+// MARLEY includes
+#include "marley/BinaryEventBlock.hh"
+#include "marley/CompressedStream.hh"
+#include "marley/EventIndex.hh"
+#include "marley/JSON.hh"
 
 namespace marley {
 
@@ -39,6 +52,22 @@ namespace marley {
 
       virtual ~OutputFile() = default;
 
+      /// @brief Generator information that is saved to the metadata of
+      /// those output file formats that support it
+      /// @details A Generator may be passed wherever one of these is
+      /// expected. Taking a copy allows the metadata to be written after
+      /// the Generator itself has moved on to later events (see
+      /// RotatingOutputFile).
+      struct GeneratorState {
+        GeneratorState() = default;
+        GeneratorState(const marley::Generator& gen);
+
+        std::string state_string; ///< Random number engine state
+        uint_fast64_t seed = 0u; ///< Random number seed
+        double flux_avg_xsec = 0.; ///< Flux-averaged total cross section
+                                   ///< (MeV<sup> -2</sup>)
+      };
+
       const std::string& name() const { return name_; }
 
       /// @brief Load a marley::Generator object whose configuration and state
@@ -54,7 +83,7 @@ namespace marley {
       /// @details This function also saves information about the generator
       /// configuration and state to those output file formats that support it.
       virtual void close(const marley::JSON& json_config,
-        const marley::Generator& gen, const long num_events) = 0;
+        const GeneratorState& gen_state, const long num_events) = 0;
 
       /// @brief The number of bytes that have been written during the
       /// current MARLEY session to this file
@@ -65,8 +94,51 @@ namespace marley {
       /// a marley::Error will be thrown
       virtual void write_event(const marley::Event* event) = 0;
 
+      /// @brief Write every event stored in an EventBatch to this output
+      /// file
+      /// @details The default implementation unpacks each event and passes
+      /// it to write_event(). Column-oriented formats override this to copy
+      /// the batch contents directly.
+      virtual void write_events(const marley::EventBatch& batch);
+
       bool mode_is_resume() const { return mode_ == Mode::RESUME; }
 
+      /// @brief Returns true if checkpoint() and restart() may be used with
+      /// this output file, or false otherwise
+      virtual bool supports_checkpoints() const { return false; }
+
+      /// @brief Write all events received so far to disk and describe the
+      /// current contents of the file
+      /// @details The returned JSON object may later be passed to restart()
+      /// to discard any events written after this call. It includes the
+      /// file size and any state needed to continue writing events.
+      /// @param num_events The number of events in the file so far
+      virtual marley::JSON checkpoint(long num_events);
+
+      /// @brief Continue writing to an output file that was opened using
+      /// the "restart" mode
+      /// @details The file is truncated to the size recorded by checkpoint()
+      /// before new events are written to it. An index file (if any) is
+      /// truncated in the same way.
+      /// @param state JSON object previously returned by checkpoint()
+      virtual void restart(const marley::JSON& state);
+
+      /// @brief Start writing an index file (see marley::EventIndex)
+      /// alongside this output file
+      /// @details This should be called after any call to resume() and
+      /// before the first call to write_event(). When appending to or
+      /// resuming an existing output file, new entries are added to its
+      /// existing index. If there is no such index, then a warning is
+      /// printed and no index will be written.
+      /// @param gen Generator that will produce the events. Its seed,
+      /// random number engine settings, and next event number are saved in
+      /// the index entries so that individual events can be regenerated.
+      virtual void enable_index(const marley::Generator& gen);
+
+      /// @brief Returns true if an index file is being written, or false
+      /// otherwise
+      inline bool index_enabled() const { return index_stream_.is_open(); }
+
       /// @brief If needed (for the HEPEVT and ASCII formats), write the
       /// flux-averaged total cross section to the file.
       /// @details This function is a no-op unless we're
@@ -77,8 +149,11 @@ namespace marley {
       // every event format that MARLEY knows how to write. The "ASCII" format
       // is MARLEY's native format for textual input and output of
       // marley::Event objects (via the << and >> operators on std::ostream and
-      // std::istream objects).
-      enum class Format { ROOT, HEPEVT, JSON, ASCII };
+      // std::istream objects). The "BINARY" format is MARLEY's native
+      // column-oriented binary format (see marley::BinaryEventBlock). The
+      // "HDF5" format stores events as HDF5 datasets (see
+      // marley::HDF5OutputFile).
+      enum class Format { ROOT, HEPEVT, JSON, ASCII, BINARY, HDF5 };
 
     protected:
 
@@ -102,7 +177,52 @@ namespace marley {
       /// @brief For the file formats that support it, write metadata containing the
       /// generator state and configuration to the output file.
       virtual void write_generator_state(const marley::JSON& json_config,
-        const marley::Generator& gen, const long num_events) = 0;
+        const GeneratorState& gen_state, const long num_events) = 0;
+
+      /// @brief Adds an entry for the next event to the index file (if
+      /// one is being written)
+      /// @param offset Location of the event in the output file (see
+      /// marley::EventIndex::Entry)
+      /// @param sub_index Position of the event within its binary event
+      /// block
+      void index_event(uint64_t offset, uint32_t sub_index = 0u);
+
+      /// @brief Closes the index file (if one is being written)
+      void close_index();
+
+      /// @brief Helper for checkpoint() that flushes the index file (if one
+      /// is being written) and records its size in a JSON object
+      void checkpoint_index(marley::JSON& state);
+
+      /// @brief Helper for restart() that truncates the index file (if one
+      /// was recorded by checkpoint_index()) to its saved size
+      void restart_index(const marley::JSON& state);
+
+      /// @brief Truncates a file to a given size, throwing a marley::Error
+      /// if this cannot be done
+      static void truncate_file(const std::string& file_name, uint64_t size);
+
+      /// @brief Stream used to write the index file
+      std::ofstream index_stream_;
+
+      /// @brief Template for the next index entry. Its event number is
+      /// incremented each time that an entry is written.
+      marley::EventIndex::Entry index_entry_;
+
+      /// @brief Set to true if resume() rewrote the events that were
+      /// previously stored in the output file
+      bool events_rewritten_ = false;
+
+      /// @brief Locations of the rewritten events (unused unless
+      /// events_rewritten_ is true)
+      std::vector<uint64_t> rewritten_offsets_;
+
+      /// @brief Set to true if restart() truncated an existing index file
+      bool index_restarted_ = false;
+
+      /// @brief Event number for the next index entry saved by
+      /// checkpoint_index() (unused unless index_restarted_ is true)
+      uint64_t restart_event_number_ = 0u;
 
       // Modes to use when writing output to files that are not initially empty
       // OVERWRITE = removes any previous contents of the file, then writes new
@@ -116,8 +236,12 @@ namespace marley {
       //   configuration (including the random number generator state), then
       //   appends new events after those currently saved in the file. This
       //   mode is only allowed for output formats that include such metadata,
-      //   i.e., the ROOT and JSON formats.
-      enum class Mode { OVERWRITE, APPEND, RESUME };
+      //   i.e., the ROOT, JSON, and binary formats.
+      // RESTART = continues a run from a checkpoint. The file is opened by
+      //   restart() rather than by open(). This mode is used by the marley
+      //   executable and is only allowed for formats that support
+      //   checkpoints (see supports_checkpoints()).
+      enum class Mode { OVERWRITE, APPEND, RESUME, RESTART };
 
       std::string name_; ///< Name of the file to receive output
       Format format_; ///< Format to use when writing events to the file
@@ -135,9 +259,30 @@ namespace marley {
       // current indent level. Writes the result to a std::ostream.
       void start_json_output(bool start_array);
 
+      /// @brief Opens the output file using the requested mode flags
+      /// @details If compression is enabled, a new compressor is installed
+      /// as the stream buffer for stream_.
+      void open_stream(std::ios::openmode mode);
+
+      /// @brief Ends any compressed data and closes the output file
+      void close_stream();
+
+      /// @brief Returns the current write position in the output file
+      uint64_t file_position();
+
       // Stream used to read and write from the output file as needed
       std::fstream stream_;
 
+      /// @brief Compressor used when writing a compressed output file (null
+      /// otherwise)
+      std::unique_ptr<marley::CompressingStreamBuf> compressor_;
+
+      /// @brief Whether the output should be compressed
+      bool compress_ = false;
+
+      /// @brief Zstandard compression level (zero selects the default)
+      int compression_level_ = 0;
+
       // Flag used to see if we need a comma in front of the current
       // JSON event or not. Unused by the other formats.
       bool needs_comma_ = false;
@@ -146,6 +291,9 @@ namespace marley {
       /// formats.
       int indent_ = -1; // -1 gives the most compact JSON file possible
 
+      /// @brief Reusable buffer for the JSON or HEPEVT text of each event
+      std::string event_buffer_;
+
       /// @brief Storage for the number of bytes written to disk
       int_fast64_t byte_count_ = 0;
 
@@ -156,8 +304,13 @@ namespace marley {
 
     public:
 
+      /// @param compression Compression algorithm to use when writing
+      /// the file. Valid values are "none" and "zstd".
+      /// @param compression_level Compression level to use (zero selects
+      /// the default for the chosen algorithm)
       TextOutputFile(const std::string& name, const std::string& format,
-        const std::string& mode, bool force = false, int indent = -1);
+        const std::string& mode, bool force = false, int indent = -1,
+        const std::string& compression = "none", int compression_level = 0);
 
       virtual ~TextOutputFile() = default;
 
@@ -165,6 +318,9 @@ namespace marley {
 
       virtual void open() override;
 
+      /// @details Index files cannot be written for compressed output
+      virtual void enable_index(const marley::Generator& gen) override;
+
       // TODO: consider a better way of doing this
       // Returns true if the generator was successfully restored from the
       // saved metadata, or false otherwise.
@@ -176,11 +332,19 @@ namespace marley {
       // Write a new marley::Event to this output file
       virtual void write_event(const marley::Event* event) override;
 
+      virtual bool supports_checkpoints() const override { return true; }
+
+      /// @details If the output is compressed, then the current Zstandard
+      /// frame is ended so that the file may be truncated at this point
+      virtual marley::JSON checkpoint(long num_events) override;
+
+      virtual void restart(const marley::JSON& state) override;
+
       void write_generator_state(const marley::JSON& json_config,
-        const marley::Generator& gen, const long num_events) override;
+        const GeneratorState& gen_state, const long num_events) override;
 
       virtual void close(const marley::JSON& json_config,
-        const marley::Generator& gen, const long num_events) override;
+        const GeneratorState& gen_state, const long num_events) override;
 
       // This function is a no-op for the JSON format (we will write the
       // flux-averaged cross section to the output file when saving the
@@ -188,4 +352,262 @@ namespace marley {
       virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
   };
 
+  /// @brief Output file in MARLEY's native binary event format
+  /// @details Events are buffered and written in blocks of
+  /// EVENTS_PER_BLOCK events each. The header at the start of the file is
+  /// rewritten with the final event count and metadata position when the
+  /// file is closed.
+  class BinaryOutputFile : public OutputFile {
+
+    public:
+
+      /// @param layout Layout of the event records (see
+      /// marley::BinaryEventBlock::Layout). If the kinematics layout is
+      /// used, then only the final particles of each event are written.
+      /// @param precision Precision used for the particle kinematics (see
+      /// marley::BinaryEventBlock::Precision). Single precision may only be
+      /// used with the event layout.
+      BinaryOutputFile(const std::string& name, const std::string& format,
+        const std::string& mode, bool force = false,
+        marley::BinaryEventBlock::Layout layout
+        = marley::BinaryEventBlock::Layout::event,
+        marley::BinaryEventBlock::Precision precision
+        = marley::BinaryEventBlock::Precision::full);
+
+      virtual ~BinaryOutputFile() = default;
+
+      /// @brief Number of events stored in each block written to the file
+      static constexpr size_t EVENTS_PER_BLOCK = 1024u;
+
+      virtual bool resume(std::unique_ptr<marley::Generator>& gen,
+        long& num_previous_events) override;
+
+      /// @details Events that are still buffered in the current block are
+      /// not included in the count
+      int_fast64_t bytes_written() override;
+
+      virtual void write_event(const marley::Event* event) override;
+
+      virtual void write_events(const marley::EventBatch& batch) override;
+
+      virtual bool supports_checkpoints() const override { return true; }
+
+      /// @details Any buffered events are written as a (possibly short)
+      /// block, and the header is updated with the current event count
+      virtual marley::JSON checkpoint(long num_events) override;
+
+      virtual void restart(const marley::JSON& state) override;
+
+      virtual void close(const marley::JSON& json_config,
+        const GeneratorState& gen_state, const long num_events) override;
+
+      virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
+
+    private:
+
+      virtual void open() override;
+
+      // Writes a metadata record with the same contents as the "gen_state"
+      // object used by the JSON format
+      void write_generator_state(const marley::JSON& json_config,
+        const GeneratorState& gen_state, const long num_events) override;
+
+      // Writes the current block of events to the file and empties it
+      void flush_block();
+
+      // Rewrites the header at the start of the file, then returns to the
+      // previous write position
+      void update_header();
+
+      // Stream used to read and write from the output file as needed
+      std::fstream stream_;
+
+      // Events that have not yet been written to the file
+      marley::BinaryEventBlock block_;
+
+      // Events that have not yet been written to the file (used instead of
+      // block_ when the kinematics layout is chosen)
+      marley::KinematicsBlock kinematics_block_;
+
+      // Returns true if the kinematics layout is in use
+      inline bool kinematics_only() const { return header_.layout
+        == marley::BinaryEventBlock::Layout::kinematics; }
+
+      // Current contents of the file header
+      marley::BinaryEventBlock::Header header_;
+
+      /// @brief Storage for the number of bytes written to disk
+      int_fast64_t byte_count_ = 0;
+  };
+
+
+  /// @brief Output file that rotates its events through a numbered sequence
+  /// of files (parts)
+  /// @details The file name is a pattern that contains a single printf-style
+  /// integer conversion (e.g., "events_%04d.root"), which is replaced by the
+  /// zero-based part number. A new part is started once the current one
+  /// holds a given number of events or bytes. Each part is a complete
+  /// output file in its own right. For the formats that store metadata, it
+  /// includes the job configuration, the flux-averaged total cross section,
+  /// and the state of the generator after the last event in the part.
+  /// While events are written to the next part, the completed one is closed
+  /// by a background thread, so slow finalization steps (writing metadata,
+  /// ending a compressed stream, etc.) do not hold up the output. The
+  /// EventFileReader class and the marsum tool accept the pattern in place
+  /// of a file name and read the parts in order as a single set of events.
+  ///
+  /// The part boundaries are chosen by the thread that produces the events
+  /// using rotation_due() and schedule_rotation(). That thread also supplies
+  /// the generator state saved with each completed part. The events may be
+  /// written by a different thread.
+  class RotatingOutputFile : public OutputFile {
+
+    public:
+
+      /// @brief Function that opens the output file for a part given its
+      /// name
+      using Factory = std::function< std::unique_ptr<marley::OutputFile>(
+        const std::string&) >;
+
+      /// @param pattern File name pattern (see part_file_name())
+      /// @param format Output format used for every part
+      /// @param max_events Maximum number of events in each part (zero
+      /// for no limit)
+      /// @param max_bytes Size (in bytes) at which a part is considered
+      /// full (zero for no limit). The size is checked periodically as the
+      /// events are written, so the parts may be somewhat larger than
+      /// this.
+      /// @param factory Opens each part
+      RotatingOutputFile(const std::string& pattern, const std::string& format,
+        long max_events, int_fast64_t max_bytes, Factory factory);
+
+      /// @details Waits for any parts that are still being closed
+      virtual ~RotatingOutputFile();
+
+      /// @details Rotating output files may not be resumed, so this
+      /// function always throws a marley::Error
+      virtual bool resume(std::unique_ptr<marley::Generator>& gen,
+        long& num_previous_events) override;
+
+      /// @details Closes the current part, then waits until every
+      /// completed part has been closed
+      /// @param num_events Ignored. The number of events in the current
+      /// part is used instead.
+      virtual void close(const marley::JSON& json_config,
+        const GeneratorState& gen_state, const long num_events) override;
+
+      /// @brief Total number of bytes written to all of the parts
+      /// @details Parts that are still being closed by a background thread
+      /// are not included
+      int_fast64_t bytes_written() override;
+
+      virtual void write_event(const marley::Event* event) override;
+
+      /// @details The cross section is also written to every later part
+      virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
+
+      /// @brief Sets the job configuration to save in the metadata of the
+      /// completed parts
+      inline void set_config(const marley::JSON& config)
+        { config_ = config; }
+
+      /// @brief Records that another event has been queued for output
+      /// @details This should be called by the thread that produces the
+      /// events, once for each event
+      /// @return True if the current part is full, in which case
+      /// schedule_rotation() should be called before the next event is
+      /// queued
+      bool rotation_due();
+
+      /// @brief Starts a new part after all of the events queued so far
+      /// @param gen_state Generator state to save in the metadata of the
+      /// completed part
+      void schedule_rotation(const GeneratorState& gen_state);
+
+      /// @brief Returns true if a file name contains a single printf-style
+      /// integer conversion (and no other conversions except "%%")
+      static bool is_pattern(const std::string& name);
+
+      /// @brief Returns the name of a part, throwing a marley::Error if
+      /// the pattern is not valid (see is_pattern())
+      /// @param pattern File name pattern, e.g., "events_%04d.ascii"
+      /// @param index Zero-based part number
+      static std::string part_file_name(const std::string& pattern,
+        int index);
+
+      /// @brief Returns the names of the existing parts that match a
+      /// pattern, in order
+      /// @details The search stops at the first missing part
+      static std::vector<std::string> find_parts(const std::string& pattern);
+
+    protected:
+
+      /// @details The first part is opened by the constructor, so this
+      /// function is a no-op
+      virtual void open() override {}
+
+      /// @details Each part saves its own metadata, so this function is a
+      /// no-op
+      virtual void write_generator_state(const marley::JSON&,
+        const GeneratorState&, const long) override {}
+
+      /// @brief Closes the current part (on a background thread, if
+      /// possible) and opens the next one
+      void rotate(const GeneratorState& gen_state);
+
+      /// @brief Waits for completed parts to be closed, rethrowing any
+      /// errors encountered
+      /// @param max_pending Number of parts that may remain open
+      void wait_for_closers(size_t max_pending);
+
+      /// @brief Number of completed parts that may be closed concurrently
+      static constexpr size_t MAX_PENDING_CLOSES = 2u;
+
+      /// @brief Interval (in events) at which the size of the current part
+      /// is checked
+      static constexpr long BYTE_CHECK_INTERVAL = 16;
+
+      long max_events_;
+      int_fast64_t max_bytes_;
+      Factory factory_;
+
+      /// @brief Output file for the part that is currently being written
+      std::unique_ptr<marley::OutputFile> part_;
+      int part_index_ = 0;
+      long part_events_ = 0; ///< Number of events in the current part
+
+      /// @brief Total number of events written to all of the parts
+      long written_events_ = 0;
+
+      /// @brief Bytes in the completed parts that have finished closing
+      int_fast64_t closed_bytes_ = 0;
+
+      marley::JSON config_;
+      double flux_avg_tot_xsec_ = 0.;
+      bool have_xsec_ = false;
+
+      /// @brief Part boundary requested by schedule_rotation()
+      struct Boundary {
+        long event; ///< Total number of events that precede the boundary
+        GeneratorState gen_state;
+      };
+
+      /// @brief Boundaries that the writing thread has not reached yet
+      std::deque<Boundary> boundaries_;
+      std::mutex boundary_mutex_;
+      std::atomic<int> pending_boundaries_{ 0 };
+
+      /// @brief Total number of events queued (used by the producing thread)
+      long queued_events_ = 0;
+      /// @brief Value of queued_events_ at the latest boundary
+      long last_boundary_ = 0;
+
+      /// @brief Size of the current part as of the latest check
+      std::atomic<int_fast64_t> part_bytes_{ 0 };
+
+      /// @brief Tasks that are closing completed parts. Each one returns
+      /// the final size of its part.
+      std::deque< std::future<int_fast64_t> > closers_;
+  };
+
 }
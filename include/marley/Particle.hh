@@ -26,6 +26,8 @@ namespace marley {
   // rootcint so that we won't have issues using marley::Particle objects with
   // ROOT 5.
   class JSON;
+  class JSONValue;
+  class JSONWriter;
   #endif
 
   /// @brief Momentum four-vector for a simulated particle
@@ -133,9 +135,17 @@ namespace marley {
       /// @brief Create a JSON representation of this Particle
       marley::JSON to_json() const;
 
+      /// @brief Write the JSON representation of this Particle directly to
+      /// a JSONWriter
+      void write_json(marley::JSONWriter& writer) const;
+
       /// @brief Replaces the existing object contents with new ones
       /// loaded from a JSON representation of a Particle
       void from_json(const marley::JSON& json);
+
+      /// @brief Replaces the existing object contents with new ones
+      /// loaded from a value stored in a JSONDocument
+      void from_json(const marley::JSONValue& json);
       #endif
 
       /// @brief Resets all data members to zero
@@ -170,6 +180,12 @@ namespace marley {
       /// @todo Add error handling for cases where a marley::Particle is
       /// constructed with a charge that is inappropriate.
       int charge_ = 0;
+
+      #ifndef __MAKECINT__
+      /// @brief Shared implementation of the from_json() overloads
+      /// @tparam JSONType marley::JSON or marley::JSONValue
+      template <typename JSONType> void load_json(const JSONType& json);
+      #endif
   };
 
   // Inline function definitions
@@ -16,6 +16,9 @@
 
 #pragma once
 
+// Standard library includes
+#include <vector>
+
 // MARLEY includes
 #include "marley/EventProcessor.hh"
 #include "marley/RotationMatrix.hh"
@@ -30,6 +33,10 @@ namespace marley {
 
     public:
 
+      /// @brief Maximum number of rotation matrices that will be kept for
+      /// reuse
+      static constexpr size_t MAX_CACHED_ROTATIONS = 8u;
+
       /// @param dir A 3-vector pointing in the desired direction
       /// of the projectile in the rotated coordinate system
       ProjectileDirectionRotator( const ThreeVector& dir = {0., 0., 1.} );
@@ -47,7 +54,6 @@ namespace marley {
 
       inline void set_projectile_direction( const ThreeVector& dir ) {
         dir_vec_ = marley::RotationMatrix::normalize( dir );
-        last_pdir_ = dir_vec_;
       }
 
       ThreeVector sample_isotropic_direction( marley::Generator& gen ) const;
@@ -60,15 +66,36 @@ namespace marley {
       /// projectile
       ThreeVector dir_vec_ = {{ 0., 0., 1. }};
 
-      /// @brief Stores the direction 3-vector for the last projectile
-      /// that triggered a recalculation of the rotation matrix.
-      /// @details Using this information avoids unnecessary recalculations
-      ThreeVector last_pdir_ = {{ 0., 0., 1. }};
-
       /// @brief RotationMatrix used to rotate the coordinate system
       /// of the input Event
       marley::RotationMatrix rot_matrix_;
 
+      /// @brief A previously computed rotation matrix together with the
+      /// (normalized) directions that it relates
+      struct CachedRotation {
+        ThreeVector from;
+        ThreeVector to;
+        marley::RotationMatrix matrix;
+      };
+
+      /// @brief Rotation matrices computed for the most recently requested
+      /// pairs of directions
+      /// @details Using this information avoids unnecessary recalculations
+      /// when only a few distinct directions are used
+      std::vector<CachedRotation> rotation_cache_;
+
+      /// @brief Index of the cache entry that is currently loaded into
+      /// rot_matrix_
+      size_t current_rotation_ = MAX_CACHED_ROTATIONS;
+
+      /// @brief Index of the cache entry that will be replaced next once
+      /// the cache is full
+      size_t next_rotation_ = 0u;
+
+      /// @brief Loads rot_matrix_ with a matrix that rotates the unit
+      /// vector pdir into dir_vec_
+      void update_rotation_matrix( const ThreeVector& pdir );
+
       /// @brief Helper function that does the coordinate system rotation
       /// @param[in,out] ev Event whose Particle 3-vectors will be rotated
       void rotate_event( marley::Event& ev );
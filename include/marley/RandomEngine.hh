@@ -0,0 +1,260 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace marley {
+
+  /// @brief Counter-based pseudorandom number engine implementing the
+  /// Philox4x64-10 algorithm
+  /// @details The algorithm is described in J. K. Salmon et al.,
+  /// "Parallel random numbers: as easy as 1, 2, 3," in Proceedings of the
+  /// 2011 International Conference for High Performance Computing,
+  /// Networking, Storage and Analysis (SC '11). Each output block is a pure
+  /// function of a 128-bit key and a 256-bit counter, so any point in the
+  /// random number sequence may be reached without generating the values
+  /// that precede it. This class satisfies the C++ UniformRandomBitGenerator
+  /// requirements.
+  class PhiloxEngine {
+
+    public:
+
+      using result_type = uint64_t;
+
+      using KeyType = std::array<uint64_t, 2>;
+      using CounterType = std::array<uint64_t, 4>;
+
+      /// @param k0 First word of the key
+      /// @param k1 Second word of the key
+      PhiloxEngine(uint64_t k0 = 0u, uint64_t k1 = 0u) : key_{{ k0, k1 }} {}
+
+      static constexpr result_type min()
+        { return std::numeric_limits<result_type>::min(); }
+
+      static constexpr result_type max()
+        { return std::numeric_limits<result_type>::max(); }
+
+      /// @brief Returns the next 64-bit random value
+      inline result_type operator()();
+
+      /// @brief Sets the key and resets the counter to zero
+      inline void set_key(uint64_t k0, uint64_t k1);
+
+      /// @brief Sets the counter. The next call to operator()() will
+      /// return the first word of the block for this counter value.
+      inline void set_counter(const CounterType& ctr);
+
+      inline const KeyType& key() const { return key_; }
+      inline const CounterType& counter() const { return counter_; }
+
+      /// @brief Computes the Philox4x64-10 output block for a given
+      /// counter and key
+      static CounterType block(const CounterType& ctr, const KeyType& key);
+
+      /// @brief Writes the full engine state to a std::ostream
+      void print(std::ostream& out) const;
+
+      /// @brief Restores the engine state from a std::istream
+      void read(std::istream& in);
+
+    protected:
+
+      /// @brief Key for the block cipher
+      KeyType key_;
+
+      /// @brief Counter value for the next block to be generated
+      CounterType counter_ = {{ 0u, 0u, 0u, 0u }};
+
+      /// @brief Most recently generated block of output values
+      CounterType output_ = {{ 0u, 0u, 0u, 0u }};
+
+      /// @brief Index of the next unused value in output_. A value of four
+      /// indicates that a new block must be generated.
+      unsigned index_ = 4u;
+  };
+
+  /// @brief Pseudorandom number engine used by the Generator class
+  /// @details By default, this engine wraps a 64-bit Mersenne Twister. It
+  /// may alternatively be configured to use the counter-based PhiloxEngine.
+  /// In that mode, the key is formed from the seed and a stream ID, and the
+  /// second counter word is an event number. Every event is thus drawn from
+  /// its own independent subsequence which may be regenerated on its own,
+  /// and streams with different IDs never overlap.
+  class RandomEngine {
+
+    public:
+
+      using result_type = uint64_t;
+
+      static constexpr result_type min()
+        { return std::numeric_limits<result_type>::min(); }
+
+      static constexpr result_type max()
+        { return std::numeric_limits<result_type>::max(); }
+
+      /// @brief Returns the next 64-bit random value
+      inline result_type operator()();
+
+      /// @brief Reseeds the engine
+      /// @details Both the Mersenne Twister and the Philox key are updated,
+      /// and the event number is reset to zero.
+      void seed(uint64_t seed);
+
+      /// @brief Switches between the Mersenne Twister (false) and the
+      /// counter-based Philox engine (true)
+      inline void set_counter_based(bool use_it)
+        { counter_based_ = use_it; update_key(); }
+
+      /// @brief Returns true if the counter-based engine is in use
+      inline bool counter_based() const { return counter_based_; }
+
+      /// @brief Sets the stream ID used as the second word of the Philox key
+      inline void set_stream_id(uint64_t id) { stream_id_ = id; update_key(); }
+
+      /// @brief Returns the stream ID used by the counter-based engine
+      inline uint64_t stream_id() const { return stream_id_; }
+
+      /// @brief Sets the number of the next event to be started via
+      /// start_event()
+      inline void set_event_number(uint64_t num) { event_number_ = num; }
+
+      /// @brief Returns the number of the next event to be started via
+      /// start_event()
+      inline uint64_t event_number() const { return event_number_; }
+
+      /// @brief Positions the counter-based engine at the start of the
+      /// subsequence for the next event and then increments the event
+      /// number. This function does nothing when the Mersenne Twister is
+      /// in use.
+      inline void start_event();
+
+      /// @brief Positions the counter-based engine at the start of a
+      /// secondary subsequence for a given event
+      /// @details Substream zero is the subsequence used by start_event().
+      /// Other values select independent subsequences for the same event,
+      /// which allows different parts of an event to be generated
+      /// reproducibly by different engines (e.g., on different threads).
+      /// The event number is not changed. This function does nothing when
+      /// the Mersenne Twister is in use.
+      inline void start_event_substream(uint64_t event_num,
+        uint64_t substream);
+
+      /// @brief Writes the full engine state to a std::ostream
+      void print(std::ostream& out) const;
+
+      /// @brief Restores the engine state from a std::istream
+      void read(std::istream& in);
+
+    protected:
+
+      /// @brief Helper function that updates the Philox key using the
+      /// current seed and stream ID
+      inline void update_key() { philox_.set_key(seed_, stream_id_); }
+
+      /// @brief 64-bit Mersenne Twister engine
+      std::mt19937_64 mt_;
+
+      /// @brief Counter-based engine
+      marley::PhiloxEngine philox_;
+
+      /// @brief Whether the counter-based engine is in use
+      bool counter_based_ = false;
+
+      /// @brief Seed most recently passed to seed()
+      uint64_t seed_ = 0u;
+
+      /// @brief Stream ID for the counter-based engine
+      uint64_t stream_id_ = 0u;
+
+      /// @brief Number of the next event to be started
+      uint64_t event_number_ = 0u;
+
+      /// @brief Tag that identifies state strings for the counter-based
+      /// engine
+      static constexpr char PHILOX_TAG_[] = "philox4x64";
+  };
+
+  // Inline function definitions
+  inline PhiloxEngine::result_type PhiloxEngine::operator()() {
+    if ( index_ == 4u ) {
+      output_ = block( counter_, key_ );
+      // Increment the 256-bit counter
+      for ( auto& c : counter_ ) if ( ++c != 0u ) break;
+      index_ = 0u;
+    }
+    return output_[ index_++ ];
+  }
+
+  inline void PhiloxEngine::set_key(uint64_t k0, uint64_t k1) {
+    key_ = {{ k0, k1 }};
+    set_counter({{ 0u, 0u, 0u, 0u }});
+  }
+
+  inline void PhiloxEngine::set_counter(const CounterType& ctr) {
+    counter_ = ctr;
+    index_ = 4u;
+  }
+
+  inline RandomEngine::result_type RandomEngine::operator()() {
+    if ( counter_based_ ) return philox_();
+    return mt_();
+  }
+
+  inline void RandomEngine::start_event() {
+    if ( !counter_based_ ) return;
+    philox_.set_counter({{ 0u, event_number_, 0u, 0u }});
+    ++event_number_;
+  }
+
+  inline void RandomEngine::start_event_substream(uint64_t event_num,
+    uint64_t substream)
+  {
+    if ( !counter_based_ ) return;
+    philox_.set_counter({{ 0u, event_num, substream, 0u }});
+  }
+
+}
+
+inline std::ostream& operator<<(std::ostream& out,
+  const marley::PhiloxEngine& pe)
+{
+  pe.print(out);
+  return out;
+}
+
+inline std::istream& operator>>(std::istream& in, marley::PhiloxEngine& pe)
+{
+  pe.read(in);
+  return in;
+}
+
+inline std::ostream& operator<<(std::ostream& out,
+  const marley::RandomEngine& re)
+{
+  re.print(out);
+  return out;
+}
+
+inline std::istream& operator>>(std::istream& in, marley::RandomEngine& re)
+{
+  re.read(in);
+  return in;
+}
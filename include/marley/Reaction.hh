@@ -22,6 +22,7 @@
 #include "marley/Event.hh"
 #include "marley/MassTable.hh"
 #include "marley/TargetAtom.hh"
+#include "marley/marley_utils.hh"
 
 namespace marley {
 
@@ -58,7 +59,30 @@ namespace marley {
       /// @note Functions that override total_xs() should always return zero
       /// if pdg_a != pdg_a_.
       virtual double total_xs(int pdg_a, double KEa) const = 0;
-      virtual double total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const = 0;
+
+      /// @brief Compute the reaction's dark matter absorption cross section
+      /// (MeV<sup> -2</sup>)
+      /// @param pdg_a Projectile's PDG code
+      /// @param KEa Lab-frame kinetic energy of the incident projectile
+      /// @param dm_mass Dark matter particle mass (MeV)
+      /// @param UV_cutoff Theory UV cutoff
+      /// @param dm_velocity Dark matter particle speed (in units of c)
+      virtual double total_xs(int pdg_a, double KEa, double dm_mass,
+        double UV_cutoff, double dm_velocity
+        = marley_utils::DM_DEFAULT_VELOCITY) const = 0;
+
+      /// @brief Compute the reaction's total cross section (MeV<sup> -2</sup>)
+      /// at each of n projectile kinetic energies
+      /// @details The default implementation calls total_xs( int, double )
+      /// for each energy. Derived classes may override it to share work
+      /// between the energies.
+      /// @param pdg_a Projectile's PDG code
+      /// @param[in] KEas Array of lab-frame projectile kinetic energies (MeV)
+      /// @param[out] out Array that will be loaded with the total cross
+      /// sections
+      /// @param n Length of the KEas and out arrays
+      virtual void total_xs_batch(int pdg_a, const double* KEas, double* out,
+        size_t n) const;
 
       /// @brief Differential cross section
       /// @f$d\sigma/d\cos\theta_{c}^{\mathrm{CM}}@f$
@@ -82,6 +106,20 @@ namespace marley {
       virtual marley::Event create_event(int pdg_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
         marley::Generator& gen) const = 0;
 
+      /// @brief Create an event object for this reaction in place,
+      /// replacing the previous contents of ev
+      /// @details This is equivalent to ev = create_event( pdg_a, KEa, gen ),
+      /// but overriding implementations can reuse the storage owned by ev.
+      /// The default implementation simply moves the result of the
+      /// by-value version into ev.
+      virtual void create_event(int pdg_a, double KEa,
+        marley::Generator& gen, marley::Event& ev) const;
+
+      /// @brief Dark matter version of the in-place create_event()
+      virtual void create_event(int pdg_a, double KEa, double dm_mass,
+        double dm_velocity, double dm_cutoff, marley::Generator& gen,
+        marley::Event& ev) const;
+
       /// @brief Get a string that contains the formula for this reaction
       inline const std::string& get_description() const { return description_; }
 
@@ -96,6 +134,12 @@ namespace marley {
       /// @brief Get the target PDG code
       inline int pdg_b() const { return pdg_b_; }
 
+      /// @brief Get the ejectile PDG code
+      inline int pdg_c() const { return pdg_c_; }
+
+      /// @brief Get the residue PDG code
+      inline int pdg_d() const { return pdg_d_; }
+
       /// @brief Get the minimum lab-frame kinetic energy (MeV) of the
       /// projectile that allows this reaction to proceed via a transition to
       /// the residue's ground state
@@ -109,6 +153,8 @@ namespace marley {
 
       /// Factory method called by JSONConfig to build
       /// Reaction objects given a file with matrix element data
+      /// @details The file contents are obtained from the
+      /// ReactionDataRegistry, so each file is only parsed once per process
       static std::vector< std::unique_ptr<Reaction> >
         load_from_file(const std::string& filename,
         marley::StructureDatabase& db);
@@ -157,7 +203,7 @@ namespace marley {
       /// marley::Reaction::create_event() after CM frame scattering angles
       /// have been sampled for the ejectile. For reactions where the residue
       /// may be left in an excited state, the excitation energy should be
-      /// recorded by supplying it as the final argument.
+      /// recorded by supplying it as E_level.
       /// @param KEa Lab-frame kinetic energy (MeV) of the projectile
       /// @param pc_cm Ejectile 3-momentum magnitude (MeV) in the CM frame
       /// @param cos_theta_c_cm Cosine of ejectile's CM frame polar angle
@@ -167,10 +213,15 @@ namespace marley {
       /// @param E_level Residue excitation energy (MeV)
       /// @param twoJ Two times the residue spin
       /// @param P Intrinsic parity of the residue
-      virtual marley::Event make_event_object(double KEa,
+      /// @param[out] event Event object that will be filled. The particles
+      /// are created directly in its existing storage.
+      /// @param q_b Charge of the target
+      /// @param q_d Charge of the residue
+      void make_event_object(double KEa,
         double pc_cm, double cos_theta_c_cm, double phi_c_cm,
         double Ec_cm, double Ed_cm, double E_level, int twoJ,
-        const marley::Parity& P) const;
+        const marley::Parity& P, marley::Event& event, int q_b = 0,
+        int q_d = 0) const;
 
       /// Returns a vector of PDG codes for projectiles that participate
       /// in a particular ProcessType
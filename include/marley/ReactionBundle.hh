@@ -0,0 +1,84 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "marley/CrossSectionTable.hh"
+#include "marley/ReactionDataRegistry.hh"
+
+namespace marley {
+
+  class Generator;
+
+  /// @brief Precompiled form of the reaction data used by a job
+  /// configuration
+  /// @details A bundle holds the parsed contents of each reaction data file,
+  /// the masses, thresholds, and Fermi function tables computed by the
+  /// NuclearReaction constructor, and any total cross section tables that
+  /// were built for the job. It is written to a single binary file, which
+  /// later jobs read in one step instead of parsing the reaction data files
+  /// and recomputing the tables (see the "reaction_bundle" key in
+  /// examples/config/annotated.js).
+  struct ReactionBundle {
+
+    /// @brief Name and parsed contents of each reaction data file
+    std::vector< std::pair< std::string, std::shared_ptr<
+      const marley::ReactionDataRegistry::ReactionData> > > files;
+
+    /// @brief Coulomb correction method used to build xs_tables
+    std::string coulomb_mode;
+
+    /// @brief Total cross section tables for the configured reactions
+    std::vector<marley::CrossSectionTable> xs_tables;
+
+    /// @brief Builds a bundle for the reactions owned by a Generator
+    /// @param file_names Full names of the reaction data files from which
+    /// the reactions were loaded
+    /// @param gen Generator that owns the reactions
+    static ReactionBundle from_generator(
+      const std::vector<std::string>& file_names,
+      const marley::Generator& gen);
+
+    /// @brief Writes the bundle to a binary file, replacing any existing
+    /// contents
+    void save(const std::string& file_name) const;
+
+    /// @brief Loads a bundle written by save()
+    /// @details If the file is invalid, was written by a different version
+    /// of MARLEY, or refers to reaction data files whose contents have
+    /// changed since it was written, then a warning is logged and nothing
+    /// is loaded.
+    /// @param file_name Name of the file to read
+    /// @param[out] bundle Loaded with the contents of the file
+    /// @return True if the bundle was loaded successfully, or false
+    /// otherwise
+    static bool load(const std::string& file_name, ReactionBundle& bundle);
+
+    /// @brief Adds the parsed reaction data files to the
+    /// ReactionDataRegistry so that Reaction::load_from_file() will use
+    /// them instead of parsing the files again
+    void register_reaction_data() const;
+
+    /// @brief Version number for the binary file format
+    static constexpr uint32_t FORMAT_VERSION = 1u;
+  };
+
+}
@@ -0,0 +1,135 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "marley/MatrixElement.hh"
+#include "marley/NuclearReaction.hh"
+#include "marley/Reaction.hh"
+
+namespace marley {
+
+  /// @brief Process-wide cache of parsed reaction data files
+  /// @details Each reaction data file is parsed at most once per process,
+  /// no matter how many Generator objects are built from it. Entries are
+  /// keyed by the file name and by a hash of the file contents, so a file
+  /// that changes on disk is parsed again when it is next requested. The
+  /// cached data are immutable and may be safely shared between threads.
+  /// Binding the matrix elements to discrete nuclear levels depends on the
+  /// StructureDatabase owned by each Generator, so that step is left to
+  /// Reaction::load_from_file().
+  class ReactionDataRegistry {
+
+    public:
+
+      /// @brief Contents of a single reaction data file
+      struct ReactionData {
+
+        /// Type of scattering process described by the file
+        marley::Reaction::ProcessType process_type;
+
+        /// @brief PDG code for the target nucleus
+        /// @details Unused for neutrino-electron elastic scattering
+        int pdg_b = 0;
+
+        /// @brief PDG codes for the target atoms listed for
+        /// neutrino-electron elastic scattering
+        std::vector<int> atomic_targets;
+
+        /// @brief Matrix elements for nuclear reactions, sorted in order
+        /// of increasing level energy
+        /// @details None of these are associated with a discrete nuclear
+        /// level yet, so the level pointers are all nullptr
+        std::vector<marley::MatrixElement> matrix_elements;
+
+        /// @brief FNV-1a hash of the file contents
+        uint64_t content_hash = 0u;
+
+        /// @brief Values computed by the NuclearReaction constructor for
+        /// each projectile
+        /// @details Filled only for entries loaded from a reaction bundle
+        /// (see ReactionBundle). Reaction::load_from_file() passes these on
+        /// to the NuclearReaction constructor when present.
+        std::vector<marley::NuclearReaction::PrecomputedData> precomputed;
+      };
+
+      /// @brief Deleted copy constructor
+      ReactionDataRegistry(const ReactionDataRegistry&) = delete;
+
+      /// @brief Deleted copy assignment operator
+      ReactionDataRegistry& operator=(const ReactionDataRegistry&) = delete;
+
+      /// @brief Get a reference to the singleton instance of the
+      /// ReactionDataRegistry
+      static ReactionDataRegistry& Instance();
+
+      /// @brief Get the parsed contents of a reaction data file
+      /// @details The file is only parsed if no entry with the same name and
+      /// contents is already present in the registry
+      /// @param file_name Name of the reaction data file
+      std::shared_ptr<const ReactionData> get(const std::string& file_name);
+
+      /// @brief Add an entry for a reaction data file that was parsed
+      /// elsewhere (e.g., loaded from a reaction bundle)
+      /// @details The entry is keyed by the file name and the content_hash
+      /// member of the data, and replaces any existing entries for the file.
+      /// It is used by get() only if the current file contents match.
+      void insert(const std::string& file_name,
+        const std::shared_ptr<const ReactionData>& data);
+
+      /// @brief Get the number of files currently held in the registry
+      size_t size() const;
+
+      /// @brief Discard all cached entries
+      /// @details Reactions built from a discarded entry are unaffected
+      void clear();
+
+    private:
+
+      ReactionDataRegistry() = default;
+
+      /// @brief Parse the contents of a reaction data file
+      /// @param file_name Name of the file (used only in error messages)
+      /// @param data Pointer to the first byte of the file contents
+      /// @param size Size of the file contents (bytes)
+      /// @param hash FNV-1a hash of the file contents
+      static std::shared_ptr<const ReactionData> parse(
+        const std::string& file_name, const char* data, size_t size,
+        uint64_t hash);
+
+      /// @brief Stores an entry, dropping any entries for older versions of
+      /// the same file
+      /// @details The caller must hold the lock on mutex_
+      void store(const std::pair<std::string, uint64_t>& key,
+        const std::shared_ptr<const ReactionData>& data);
+
+      /// @brief Guards access to the registry entries
+      mutable std::mutex mutex_;
+
+      /// @brief Cached entries, keyed by file name and FNV-1a hash of the
+      /// file contents
+      std::map< std::pair<std::string, uint64_t>,
+        std::shared_ptr<const ReactionData> > entries_;
+  };
+
+}
@@ -22,6 +22,7 @@
 #include "marley/Error.hh"
 #include "marley/EventFileReader.hh"
 
+#include "TBranch.h"
 #include "TFile.h"
 #include "TTree.h"
 
@@ -39,6 +40,17 @@ namespace marley {
 
       virtual bool next_event(marley::Event& ev) override;
 
+      /// @details For ROOT-format files, the requested range of TTree
+      /// entries is handed to the tree cache, which prefetches the baskets
+      /// for whole clusters of entries at once. Each entry is then unpacked
+      /// directly into the batch without being copied into an Event first.
+      virtual size_t next_events(size_t max_events,
+        marley::EventBatch& batch) override;
+
+      /// @details For ROOT-format files, the TTree entries are accessed
+      /// directly, so no index file is needed
+      virtual bool seek_event(size_t event_index) override;
+
       virtual operator bool() const override;
 
     protected:
@@ -49,6 +61,9 @@ namespace marley {
       // @brief Pointer to the TTree containing the MARLEY events to be loaded
       TTree* ttree_;
 
+      /// @brief Pointer to the branch of ttree_ that stores the events
+      TBranch* event_branch_ = nullptr;
+
       /// @brief Temporary storage for reading events in from a TFile
       std::unique_ptr<marley::Event> event_;
 
@@ -64,6 +79,7 @@ namespace marley {
 
       virtual bool deduce_file_format() override;
       virtual void initialize() override;
+      virtual bool open_next_part() override;
   };
 
 }
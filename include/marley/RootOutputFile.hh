@@ -17,19 +17,59 @@
 #pragma once
 
 // standard library includes
-#include "marley/OutputFile.hh"
+#include <memory>
+#include <string>
 
 // ROOT includes
 #include "TFile.h"
 #include "TTree.h"
 
+// MARLEY includes
+#include "marley/OutputFile.hh"
+#include "marley/RootSummaryTree.hh"
+
 namespace marley {
 
+  /// @brief Settings that control the layout of the TTree written by a
+  /// marley::RootOutputFile and the way in which it is streamed to disk
+  struct RootTreeSettings {
+
+    /// @brief If true, then the events are stored in the "flat" summary
+    /// tree format (see marley::EventSummary) instead of as marley::Event
+    /// objects
+    bool summary = false;
+
+    /// @brief If true, then the energies and momenta in the summary tree
+    /// are stored on disk in single precision. This setting may not be
+    /// used together with the marley::Event layout.
+    bool single_precision = false;
+
+    /// @brief Buffer size (in bytes) used for each branch
+    int basket_size = 32000;
+
+    /// @brief Split level used for the marley::Event branch
+    int split_level = 99;
+
+    /// @brief Value passed to TTree::SetAutoFlush(). Positive values give
+    /// the number of entries between flushes, negative values give the
+    /// approximate number of bytes, and zero disables automatic flushing.
+    Long64_t auto_flush = -30000000;
+
+    /// @brief Name of the compression algorithm to use ("none", "zlib",
+    /// "lzma", "lz4", or "zstd"). If empty, then ROOT's default is used.
+    std::string compression;
+
+    /// @brief Compression level (1-9), or zero to use a default level for
+    /// the chosen algorithm
+    int compression_level = 0;
+  };
+
   class RootOutputFile : public OutputFile {
     public:
 
       RootOutputFile(const std::string& name, const std::string& format,
-        const std::string& mode, bool force = false);
+        const std::string& mode, bool force = false,
+        const marley::RootTreeSettings& settings = marley::RootTreeSettings());
 
       virtual ~RootOutputFile() = default;
 
@@ -37,11 +77,9 @@ namespace marley {
         return file_->GetBytesWritten();
       }
 
-      // This function is a no-op for the ROOT format (we will take
-      // care of saving this information when we write the generator
-      // state variables)
-      inline virtual void write_flux_avg_tot_xsec(double /*avg_tot_xsec*/)
-        override {}
+      // The cross section is saved with the generator state variables, so
+      // it only needs to be remembered here for use in the summary tree
+      virtual void write_flux_avg_tot_xsec(double avg_tot_xsec) override;
 
     private:
 
@@ -55,12 +93,12 @@ namespace marley {
       // loss of consistency. This trick is based on
       // http://tinyurl.com/hb7rqsj
       void write_generator_state(const marley::JSON& json_config,
-        const marley::Generator& gen, const long /*num_events*/) override;
+        const GeneratorState& gen_state, const long /*num_events*/) override;
 
       // Clean up once we're done with the ROOT file. Save some information
       // about the current generator configuration as we clean things up.
       virtual void close(const marley::JSON& json_config,
-        const marley::Generator& gen, const long dummy) override;
+        const GeneratorState& gen_state, const long dummy) override;
 
       virtual bool resume(std::unique_ptr<marley::Generator>& gen,
         long& num_previous_events) override;
@@ -73,6 +111,16 @@ namespace marley {
       // This is a bare pointer, but ROOT will associate it with file_, so we
       // don't want to delete it ourselves or let a smart pointer do it.
       TTree* tree_ = nullptr;
+
+      // Layout and I/O settings for the event tree
+      marley::RootTreeSettings settings_;
+
+      // Fills the event tree when the summary layout is used
+      std::unique_ptr<marley::RootSummaryTree> summary_tree_;
+
+      // Flux-averaged total cross section (10^{-42} cm^2) stored with each
+      // entry of the summary tree
+      double flux_avg_tot_xsec_ = 0.;
   };
 
 }
@@ -0,0 +1,91 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <vector>
+
+// ROOT includes
+#include "TTree.h"
+
+// MARLEY includes
+#include "marley/EventSummary.hh"
+
+namespace marley {
+
+  class Event;
+
+  /// @brief Fills the branches of a "flat" MARLEY summary tree
+  /// @details The layout of the tree is described in the documentation
+  /// for marley::EventSummary. The TTree itself is owned by the caller.
+  class RootSummaryTree {
+
+    public:
+
+      /// @brief Name used for summary trees in ROOT files
+      static constexpr const char* TREE_NAME = "mst";
+
+      /// @brief Title used for newly created summary trees
+      static constexpr const char* TREE_TITLE = "MARLEY summary tree";
+
+      /// @param tree Tree that will receive the events
+      /// @param create_branches If true, then the summary branches will be
+      /// created. If false, then they must already exist in the tree
+      /// (e.g., if it was loaded from a file to continue a previous run).
+      /// @param basket_size Buffer size (in bytes) to use for newly created
+      /// branches
+      /// @param single_precision If true, then newly created branches
+      /// that hold energies and momenta use the Double32_t type, which ROOT
+      /// stores on disk as a 32-bit float
+      RootSummaryTree(TTree* tree, bool create_branches,
+        int basket_size = 32000, bool single_precision = false);
+
+      /// @brief Add a new entry to the tree describing an event
+      /// @param ev Event to summarize
+      /// @param xsec Flux-averaged total cross section (10<sup>-42</sup>
+      /// cm<sup>2</sup>) to store alongside the event
+      void fill(const marley::Event& ev, double xsec);
+
+      /// @brief Add a new entry to the tree using precomputed values
+      /// @details Each of the array arguments should point to es.np values
+      /// describing the de-excitation products
+      void fill(const marley::EventSummary& es, const int* pdgs,
+        const double* Es, const double* KEs, const double* pxs,
+        const double* pys, const double* pzs);
+
+    private:
+
+      // Creates or connects all of the branches. The product branches are
+      // connected to the current storage in the product buffers.
+      void connect_branches(bool create, int basket_size,
+        bool single_precision);
+
+      // Ensure that the product buffers can hold at least np entries,
+      // updating the branch addresses if they move
+      void reserve_products(size_t np);
+
+      // This is a bare pointer since the tree is owned by its TFile
+      TTree* tree_;
+
+      // Storage for the values of the scalar branches
+      marley::EventSummary summary_;
+
+      // Storage for the values of the de-excitation product branches
+      std::vector<int> pdgs_;
+      std::vector<double> Es_, KEs_, pxs_, pys_, pzs_;
+  };
+
+}
@@ -18,6 +18,8 @@
 
 // Standard library includes
 #include <array>
+#include <cstddef>
+#include <vector>
 
 // MARLEY includes
 #include "marley/Particle.hh"
@@ -40,6 +42,14 @@ namespace marley {
       /// from_vec into the 3-vector to_vec
       RotationMatrix(const ThreeVector& from_vec, const ThreeVector& to_vec);
 
+      /// @brief Create a 3&times;3 rotation matrix that rotates the unit
+      /// vector from into the unit vector to
+      /// @details This is a faster version of the two-vector constructor
+      /// for use when both vectors are already known to be normalized. No
+      /// checks are performed on the input.
+      static RotationMatrix from_unit_vectors(const ThreeVector& from,
+        const ThreeVector& to);
+
       /// @brief Create a rotated copy of the 3-vector v
       ThreeVector rotate_copy(const ThreeVector& v);
 
@@ -52,10 +62,32 @@ namespace marley {
       /// @brief Rotate the 3-momentum of a marley::Particle in place
       void rotate_particle_inplace(marley::Particle& p);
 
+      /// @brief Rotate the 3-momenta of an array of count marley::Particle
+      /// objects in place
+      void rotate_particles_inplace(marley::Particle* particles,
+        size_t count);
+
+      /// @brief Rotate the 3-momenta of every marley::Particle in a vector
+      /// in place
+      inline void rotate_particles_inplace(
+        std::vector<marley::Particle>& particles);
+
     protected:
 
+      /// @brief Computes the elements of a matrix that rotates the unit
+      /// vector from into the unit vector to
+      void fill_from_unit_vectors(const ThreeVector& from,
+        const ThreeVector& to);
+
       /// @brief 3&times;3 rotation matrix
       ThreeThreeMatrix matrix_;
   };
 
+  // Inline function definitions
+  inline void RotationMatrix::rotate_particles_inplace(
+    std::vector<marley::Particle>& particles)
+  {
+    this->rotate_particles_inplace( particles.data(), particles.size() );
+  }
+
 }
@@ -0,0 +1,110 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Precomputed list of the angular momentum couplings that
+  /// contribute to a nuclear decay width
+  /// @details The decay width calculations in the ExitChannel classes sum
+  /// over the allowed orbital angular momenta (or multipolarities), total
+  /// emitted angular momenta, and final nuclear spins and parities. These
+  /// depend only on a handful of quantum numbers, so the StructureDatabase
+  /// builds each table once and shares it between all exit channels that
+  /// need it. The terms are stored in the same order as the nested loops
+  /// that they replace, so sums over them are unchanged.
+  class SpinCouplingTable {
+
+    public:
+
+      /// @brief A single term in a decay width sum
+      struct Term {
+        int l; ///< Orbital angular momentum or multipolarity
+        int two_j; ///< Two times the total angular momentum of the ejectile
+        int twoJf; ///< Two times the final nuclear spin
+
+        /// @brief Index of the transmission coefficient to use
+        int T_index;
+
+        /// @brief Index of the final-state level density, equal to
+        /// (twoJf - twoJf_min) / 2
+        int rho_index;
+
+        /// @brief Selects the final nuclear parity (see the builder
+        /// functions)
+        int parity_index;
+      };
+
+      /// @brief Builds the table used for fragment emission to the
+      /// continuum
+      /// @details The transmission coefficient indices follow the (l, two_j)
+      /// order used by OpticalModel::transmission_coefficients(). A
+      /// parity_index of 0 (1) indicates a final nuclear parity equal to
+      /// (opposite to) the one reached with l = 0.
+      /// @param twoJi Two times the initial nuclear spin
+      /// @param two_s Two times the fragment spin
+      /// @param l_max Maximum orbital angular momentum
+      static SpinCouplingTable fragment_continuum( int twoJi, int two_s,
+        int l_max );
+
+      /// @brief Builds the table used for gamma-ray emission to the
+      /// continuum
+      /// @details The terms are ordered by multipolarity, then by final
+      /// spin, then by final parity. A parity_index of 0 (1) indicates
+      /// positive (negative) final parity, and the transmission coefficient
+      /// index is 2*(l - 1) + parity_index.
+      /// @param twoJi Two times the initial nuclear spin
+      /// @param l_max Maximum multipolarity
+      static SpinCouplingTable gamma_continuum( int twoJi, int l_max );
+
+      /// @brief Builds the table used for fragment emission to a discrete
+      /// nuclear level
+      /// @details Only the (l, two_j) pairs that conserve parity are
+      /// included. The twoJf, T_index, rho_index, and parity_index members of
+      /// each term are not used.
+      /// @param twoJi Two times the initial nuclear spin
+      /// @param twoJf Two times the final nuclear spin
+      /// @param two_s Two times the fragment spin
+      /// @param even_l Whether parity conservation requires an even (rather
+      /// than odd) orbital angular momentum
+      static SpinCouplingTable fragment_discrete( int twoJi, int twoJf,
+        int two_s, bool even_l );
+
+      /// @brief Terms to include in the decay width sum
+      inline const std::vector<Term>& terms() const { return terms_; }
+
+      /// @brief Smallest final nuclear spin (times two) that appears
+      inline int twoJf_min() const { return twoJf_min_; }
+
+      /// @brief Largest final nuclear spin (times two) that appears
+      inline int twoJf_max() const { return twoJf_max_; }
+
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by the table
+      inline size_t memory_usage() const
+        { return terms_.capacity() * sizeof(Term); }
+
+    private:
+
+      std::vector<Term> terms_;
+      int twoJf_min_ = 0;
+      int twoJf_max_ = -1;
+  };
+
+}
@@ -0,0 +1,98 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Records how long each stage of MARLEY's initialization takes
+  /// @details Expensive one-time setup steps (loading the mass table, the
+  /// ground-state spin-parity table, reaction data files, etc.) time
+  /// themselves using a StartupProfile::Timer. The accumulated timings may
+  /// be printed using report() to see where startup time is being spent.
+  /// Stages may be nested (e.g., building a Generator includes loading the
+  /// reaction data files), so the times should not be summed.
+  class StartupProfile {
+
+    public:
+
+      /// @brief Measures the time spent in a single stage, which is
+      /// recorded when the Timer is destroyed
+      class Timer {
+
+        public:
+
+          /// @param stage Name of the stage being timed
+          explicit Timer(const std::string& stage);
+          ~Timer();
+
+          Timer(const Timer&) = delete;
+          Timer& operator=(const Timer&) = delete;
+
+        private:
+
+          std::string stage_;
+          std::chrono::steady_clock::time_point start_;
+      };
+
+      /// @brief Accumulated timing information for a single stage
+      struct Entry {
+        std::string stage;
+        double seconds = 0.; ///< Total wall-clock time spent in the stage
+        unsigned count = 0u; ///< Number of times the stage was timed
+      };
+
+      /// @brief Deleted copy constructor
+      StartupProfile(const StartupProfile&) = delete;
+
+      /// @brief Deleted copy assignment operator
+      StartupProfile& operator=(const StartupProfile&) = delete;
+
+      /// @brief Get a reference to the singleton instance of the
+      /// StartupProfile
+      static StartupProfile& Instance();
+
+      /// @brief Add time spent in a stage
+      /// @param stage Name of the stage
+      /// @param seconds Wall-clock time to add (s)
+      void record(const std::string& stage, double seconds);
+
+      /// @brief Get the timing information for every stage recorded so
+      /// far, in the order in which the stages were first completed
+      std::vector<Entry> entries() const;
+
+      /// @brief Print a table of the recorded timings
+      void report(std::ostream& out) const;
+
+      /// @brief Discard all recorded timings
+      void clear();
+
+    private:
+
+      StartupProfile() = default;
+
+      /// @brief Guards access to entries_
+      mutable std::mutex mutex_;
+
+      std::vector<Entry> entries_;
+  };
+
+}
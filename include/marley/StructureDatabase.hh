@@ -15,27 +15,82 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include "marley/DecayScheme.hh"
+#include "marley/Integrator.hh"
+#include "marley/OpticalModel.hh"
+#include "marley/SpinCouplingTable.hh"
 
 namespace marley {
 
   class GammaStrengthFunctionModel;
   class Fragment;
+  class HauserFeshbachDecay;
+  class JSON;
+  class KoningDelarocheOpticalModel;
   class LevelDensityModel;
-  class OpticalModel;
+  class MonotonicArena;
+  class Particle;
+
+  /// @brief Named groups of numerical settings for the de-excitation
+  /// calculations
+  /// @details See StructureDatabase::set_precision() for the settings used
+  /// by each preset
+  enum class Precision { Validation, Production, Fast };
+
+  /// @brief Numerical parameters of the de-excitation calculations that
+  /// trade accuracy for speed
+  struct NumericalSettings {
+
+    /// @brief Returns the settings that belong to a precision preset
+    static NumericalSettings preset( marley::Precision precision );
+
+    /// @brief Step size (fm) for the Numerov integration used by the
+    /// optical model
+    double numerov_step_size;
+
+    /// @brief Threshold (MeV) on the nuclear part of the optical model
+    /// potential used to choose the matching radii
+    double matching_threshold;
+
+    /// @brief Number of Chebyshev points (minus one) used to approximate the
+    /// differential widths of continuum exit channels
+    size_t chebyshev_points;
+
+    /// @brief Tolerance used when sampling the final excitation energy in a
+    /// continuum exit channel by inverting its CDF
+    double sampling_tolerance;
+
+    /// @brief Grid spacing (MeV) for tabulated transmission coefficients
+    double transmission_table_step;
+
+    /// @brief Grid spacing (MeV) for tabulated level densities
+    double level_density_table_step;
+
+    /// @brief Grid spacing (MeV) for tabulated gamma-ray transmission
+    /// coefficients
+    double gamma_strength_table_step;
+  };
 
   /// @brief Container for nuclear structure information organized by nuclide
   /// @details Currently, the StructureDatabase object can hold nuclear
   /// discrete level data (DecayScheme objects), optical models (OpticalModel
   /// objects), @f$\gamma@f$-ray strength function models
   /// (GammaStrengthFunctionModel objects), and level density models
-  /// (LevelDensityModel objects)
+  /// (LevelDensityModel objects). Unless concurrent mode has been enabled
+  /// via set_concurrent(), a StructureDatabase may only be used by one
+  /// thread at a time.
   class StructureDatabase {
 
     public:
@@ -43,6 +98,8 @@ namespace marley {
       /// @brief Creates an empty database.
       StructureDatabase();
 
+      ~StructureDatabase();
+
       /// @brief Construct and add a DecayScheme object to the database that
       /// contains discrete level data for a specific nuclide
       /// @param pdg PDG code for the desired nuclide
@@ -68,9 +125,47 @@ namespace marley {
       std::set<int> find_all_nuclides(const std::string& filename,
         DecayScheme::FileFormat format = DecayScheme::FileFormat::talys);
 
+      /// @brief Converts a discrete level data file in MARLEY's native
+      /// format into the compiled binary format
+      /// @details When get_decay_scheme() loads data from a file listed in
+      /// the structure index, it first looks for a compiled version of
+      /// that file in the same folder. The compiled file has the same name
+      /// as the original with COMPILED_DECAY_SCHEME_SUFFIX appended. It is
+      /// used instead of the original whenever it is up to date.
+      /// @param text_file_name Name of the file to convert
+      /// @param binary_file_name Name of the compiled file to create
+      /// @return The number of decay schemes that were converted
+      static int compile_decay_schemes(const std::string& text_file_name,
+        const std::string& binary_file_name);
+
+      /// @brief Converts the ground-state spin-parity table from its text
+      /// format into the compiled binary format
+      /// @details The compiled file is used in place of the original
+      /// under the same conditions as for compile_decay_schemes()
+      /// @param text_file_name Name of the file to convert
+      /// @param binary_file_name Name of the compiled file to create
+      /// @return The number of nuclides in the table
+      static int compile_gs_spin_parity_table(
+        const std::string& text_file_name,
+        const std::string& binary_file_name);
+
+      /// @brief Suffix used for the names of compiled data files
+      /// @details This applies to discrete level data files, the
+      /// ground-state spin-parity table, and the mass table
+      static const std::string COMPILED_DECAY_SCHEME_SUFFIX;
+
       /// @brief Removes all previously stored data from the database.
       void clear();
 
+      /// @brief Finds every data file listed in the structure index
+      /// @details The index is loaded if this has not been done already, and
+      /// all of the directories on the search path are listed by the
+      /// FileManager. Later calls to get_decay_scheme() for new nuclides then
+      /// need no filesystem access besides opening the data files
+      /// themselves. Otherwise, these lookups happen the first time that
+      /// each nuclide is encountered during event generation.
+      void prefetch_structure_files();
+
       /// @brief Deletes the discrete level data in the database associated
       /// with a given nuclide
       /// @details If a decay scheme does not exist in the database for the
@@ -129,16 +224,21 @@ namespace marley {
       marley::GammaStrengthFunctionModel& get_gamma_strength_function_model(
         const int nuc_pdg);
 
-      /// Retrieves a const reference to the table of DecayScheme objects
+      /// @brief Retrieves a const reference to the table of DecayScheme
+      /// objects
+      /// @details In concurrent mode, this should not be used while other
+      /// threads may be loading decay schemes
       inline const std::unordered_map<int,
         std::unique_ptr<marley::DecayScheme> >& decay_schemes() const
       {
         return decay_scheme_table_;
       }
 
-      /// Retrieves a const reference to the table of Fragment objects
+      /// @brief Retrieves a const reference to the table of Fragment objects
+      /// @details The table is loaded on first use. This is safe to do from
+      /// several threads at once.
       static inline const std::map<int, marley::Fragment>& fragments() {
-        if ( !initialized_gs_spin_parity_table_ ) initialize_jpi_table();
+        std::call_once( jpi_table_once_, initialize_jpi_table );
         return fragment_table_;
       }
 
@@ -155,6 +255,24 @@ namespace marley {
       /// it could not be found
       static const marley::Fragment* get_fragment(const int Z, const int A);
 
+      /// @brief Particle emission thresholds for a nuclide
+      struct ChannelThresholds {
+        /// @brief Separation energy (MeV) of each fragment, in the same
+        /// order as the entries of fragments()
+        std::vector<double> separation_energies;
+
+        /// @brief Smallest of the separation energies (MeV). Below this
+        /// excitation energy, only gamma-ray emission is possible.
+        double unbound_threshold;
+      };
+
+      /// @brief Retrieves the particle emission thresholds for a nuclide
+      /// @details The thresholds are computed from the mass table on first
+      /// use and kept for the lifetime of the database. This may be called
+      /// from several threads at once in concurrent mode.
+      /// @param nuc_pdg PDG code for the nuclide of interest
+      const ChannelThresholds& get_channel_thresholds( int nuc_pdg );
+
       /// @brief Returns the maximum orbital angular momentum to consider
       /// when simulating fragment emission to the continuum
       inline int get_fragment_l_max() const { return fragment_l_max_; }
@@ -165,11 +283,416 @@ namespace marley {
 
       /// @brief Sets the maximum orbital angular momentum to consider
       /// when simulating fragment emission to the continuum
-      inline void set_fragment_l_max( int ell ) { fragment_l_max_ = ell; }
+      inline void set_fragment_l_max( int ell ) {
+        fragment_l_max_ = ell;
+        clear_hf_decay_cache();
+      }
 
       /// @brief Sets the maximum multipolarity to consider when simulating
       /// gamma-ray emission to the continuum
-      inline void set_gamma_l_max( int ell ) { gamma_l_max_ = ell; }
+      inline void set_gamma_l_max( int ell ) {
+        gamma_l_max_ = ell;
+        clear_hf_decay_cache();
+      }
+
+      /// @brief Returns the relative tolerance used to truncate the sum over
+      /// orbital angular momenta in fragment continuum decay widths, or zero
+      /// if the sum always runs up to the fragment l_max
+      inline double get_fragment_l_tolerance() const
+        { return fragment_l_tolerance_; }
+
+      /// @brief Sets the relative tolerance used to truncate the sum over
+      /// orbital angular momenta in fragment continuum decay widths
+      /// @details When this is positive, the sum in
+      /// FragmentContinuumExitChannel::differential_width() stops at the
+      /// first l whose contribution is no more than this fraction of the
+      /// accumulated width. Transmission coefficients fall off with l, so
+      /// this skips the S-matrix calculations for partial waves that cannot
+      /// contribute at low fragment energies. Any cached HauserFeshbachDecay
+      /// objects are discarded.
+      void set_fragment_l_tolerance( double rel_tol );
+
+      /// @brief Returns the method used by the optical models to compute
+      /// transmission coefficients
+      inline marley::OpticalModel::TransmissionMode
+        get_transmission_mode() const { return transmission_mode_; }
+
+      /// @brief Sets the method used by the optical models (both existing
+      /// ones and those created later) to compute transmission coefficients
+      void set_transmission_mode(marley::OpticalModel::TransmissionMode mode);
+
+      /// @brief Returns whether newly created level density models are
+      /// wrapped in a TabulatedLevelDensityModel
+      inline bool get_tabulate_level_densities() const
+        { return tabulate_level_densities_; }
+
+      /// @brief Sets whether level density models are wrapped in a
+      /// TabulatedLevelDensityModel
+      /// @details Any previously created level density models are discarded
+      void set_tabulate_level_densities( bool tabulate );
+
+      /// @brief Returns whether newly created gamma-ray strength function
+      /// models are wrapped in a TabulatedGammaStrengthFunctionModel
+      inline bool get_tabulate_gamma_strength_functions() const
+        { return tabulate_gamma_strength_functions_; }
+
+      /// @brief Sets whether gamma-ray strength function models are wrapped
+      /// in a TabulatedGammaStrengthFunctionModel
+      /// @details Any previously created gamma-ray strength function models
+      /// are discarded
+      void set_tabulate_gamma_strength_functions( bool tabulate );
+
+      /// @brief Returns the name of the file used to keep tabulated model
+      /// values between runs, or an empty string if there is none
+      inline const std::string& get_table_cache_file() const
+        { return table_cache_file_; }
+
+      /// @brief Sets the file used to keep tabulated model values between
+      /// runs
+      /// @details If the file already exists (either at the given location
+      /// or in one of the folders on the MARLEY search path), then the
+      /// tables stored in it are loaded immediately via load_model_tables().
+      /// Otherwise the file will be created by the first call to
+      /// save_table_cache(). The table modes and angular momentum cutoffs
+      /// should be configured before calling this function.
+      void set_table_cache_file(const std::string& file_name);
+
+      /// @brief Writes the current tables to the file chosen via
+      /// set_table_cache_file()
+      /// @details If no file was chosen, this function does nothing
+      void save_table_cache() const;
+
+      /// @brief Writes the tables held by all tabulated optical, level
+      /// density, and gamma-ray strength function models to a binary file
+      /// @details The file begins with a header that records the file
+      /// format version, the MARLEY version that wrote it, and the angular
+      /// momentum cutoffs. Each model adds its own grid settings. In
+      /// concurrent mode, the tables held by all workers are merged.
+      void save_model_tables(const std::string& file_name) const;
+
+      /// @brief Loads tables written by save_model_tables()
+      /// @details Tables are only loaded for model types that are currently
+      /// tabulated. If the header does not match the current settings, the
+      /// file is ignored.
+      /// @return True if the file was used, or false otherwise
+      bool load_model_tables(const std::string& file_name);
+
+      /// @brief Fills the transmission coefficient and level density tables
+      /// needed to simulate the de-excitation of the given nuclides in
+      /// advance
+      /// @details Starting from each compound nucleus, every nuclide that
+      /// can be reached by emitting one or more fragments is found, along
+      /// with the largest excitation energy that it may have. The optical
+      /// model tables (if TransmissionMode::Table is in use) and level
+      /// density tables (if these are tabulated) for all of them are then
+      /// filled up to that energy. The nuclides are shared among several
+      /// threads, each of which builds its own models. The results are kept
+      /// by the database and are loaded into the existing models and into
+      /// every model created later, including those of other workers in
+      /// concurrent mode. Nothing is done if neither kind of table is in
+      /// use.
+      /// @param max_Ex Maximum excitation energy (MeV) of each compound
+      /// nucleus, keyed by PDG code
+      /// @param num_threads Number of threads to use, or zero to use one per
+      /// hardware thread
+      void precompute_model_tables(const std::map<int, double>& max_Ex,
+        unsigned num_threads = 0u);
+
+      /// @brief Copies the tables computed by precompute_model_tables()
+      /// from another database
+      /// @details This is used to fill a replica of the database (e.g., one
+      /// kept for each NUMA node) without computing the tables again. The
+      /// copies are made by the calling thread, and they are loaded into any
+      /// models that the workers create afterwards. Both databases must use
+      /// the same numerical settings.
+      void copy_model_tables(const StructureDatabase& other);
+
+      /// @brief Finds every nuclide that can be reached by emitting one or
+      /// more fragments from the given compound nuclei
+      /// @param max_Ex Maximum excitation energy (MeV) of each compound
+      /// nucleus, keyed by PDG code
+      /// @return The largest excitation energy (MeV) that each nuclide
+      /// (including the compound nuclei themselves) may have, keyed by PDG
+      /// code
+      static std::map<int, double> find_accessible_nuclides(
+        const std::map<int, double>& max_Ex);
+
+      /// @brief Retrieves a HauserFeshbachDecay object for a compound
+      /// nucleus, creating it if one did not already exist
+      /// @details Previously-built objects (including their exit channel
+      /// widths and any continuum CDFs) are stored in a cache with a
+      /// least-recently-used eviction policy. The cache key is the exact
+      /// compound nucleus species, charge, excitation energy, spin, and
+      /// parity, so cached objects give identical results to newly
+      /// constructed ones. Only the kinematics of the compound nucleus
+      /// (which do not affect the decay widths) may differ between uses.
+      /// @param compound_nucleus Particle object that represents the excited
+      /// nucleus
+      /// @param Exi Initial excitation energy (MeV)
+      /// @param twoJi Two times the initial nuclear spin
+      /// @param Pi Initial nuclear parity
+      marley::HauserFeshbachDecay& get_hf_decay(
+        const marley::Particle& compound_nucleus, double Exi, int twoJi,
+        marley::Parity Pi);
+
+      /// @brief Retrieves the angular momentum couplings for fragment
+      /// emission to the continuum, building them if needed
+      /// @copydetails SpinCouplingTable::fragment_continuum()
+      const marley::SpinCouplingTable& get_fragment_continuum_couplings(
+        int twoJi, int two_s, int l_max );
+
+      /// @brief Retrieves the angular momentum couplings for gamma-ray
+      /// emission to the continuum, building them if needed
+      /// @copydetails SpinCouplingTable::gamma_continuum()
+      const marley::SpinCouplingTable& get_gamma_continuum_couplings(
+        int twoJi, int l_max );
+
+      /// @brief Retrieves the angular momentum couplings for fragment
+      /// emission to a discrete level, building them if needed
+      /// @copydetails SpinCouplingTable::fragment_discrete()
+      const marley::SpinCouplingTable& get_fragment_discrete_couplings(
+        int twoJi, int twoJf, int two_s, bool even_l );
+
+      /// @brief Returns the maximum number of HauserFeshbachDecay objects
+      /// that will be stored by get_hf_decay()
+      inline size_t get_hf_decay_cache_size() const
+        { return hf_decay_cache_size_; }
+
+      /// @brief Sets the maximum number of HauserFeshbachDecay objects
+      /// that will be stored by get_hf_decay()
+      /// @details A value of zero disables the cache
+      void set_hf_decay_cache_size( size_t size );
+
+      /// @brief Removes all entries from the HauserFeshbachDecay cache
+      void clear_hf_decay_cache();
+
+      /// @brief Returns the memory budget (bytes) for the data held by the
+      /// database, or zero if there is no limit
+      inline size_t get_memory_budget() const { return memory_budget_; }
+
+      /// @brief Sets the memory budget (bytes) for the data held by the
+      /// database
+      /// @details Whenever a new HauserFeshbachDecay object is stored by
+      /// get_hf_decay(), the footprint of the database is estimated using
+      /// memory_usage(). If it exceeds the budget, then least recently used
+      /// entries are evicted from the cache until it fits (or until only the
+      /// newest entry remains). The other tables are needed by the cached
+      /// objects and are never evicted, so they are only counted against the
+      /// budget. A value of zero (the default) disables the budget.
+      void set_memory_budget( size_t bytes );
+
+      /// @brief Returns the numerical settings used by the de-excitation
+      /// calculations
+      inline const marley::NumericalSettings& get_numerical_settings() const
+        { return numerical_settings_; }
+
+      /// @brief Sets the numerical settings used by the de-excitation
+      /// calculations
+      /// @details The existing optical models, tabulated models, and cached
+      /// HauserFeshbachDecay objects are discarded so that the new settings
+      /// apply to everything computed afterwards.
+      void set_numerical_settings( const marley::NumericalSettings& settings );
+
+      /// @brief Configures the de-excitation calculations using a named
+      /// precision preset
+      /// @details Besides the NumericalSettings, each preset chooses the
+      /// integration tolerance and whether the optical model, level density,
+      /// and gamma-ray strength function values are tabulated.
+      ///   - Validation: Numerov step 0.05 fm, matching threshold 1e-4 MeV,
+      ///     128 Chebyshev points, sampling tolerance 1e-14, adaptive
+      ///     integration with a relative tolerance of 1e-8, and no tables
+      ///   - Production: Numerov step 0.1 fm, matching threshold 1e-3 MeV,
+      ///     64 Chebyshev points, sampling tolerance 1e-12, the fixed-order
+      ///     integration rule, and no tables. These are the defaults.
+      ///   - Fast: Numerov step 0.15 fm, matching threshold 1e-2 MeV,
+      ///     32 Chebyshev points, sampling tolerance 1e-8, the fixed-order
+      ///     integration rule, and tables (with twice the default grid
+      ///     spacing) for all three kinds of model
+      void set_precision( marley::Precision precision );
+
+      /// @brief Returns the relative tolerance used by integrate(), or zero
+      /// if the fixed-order rule of marley_utils::num_integrate() is used
+      inline double get_integration_tolerance() const
+        { return integrator_ ? integrator_->rel_tol() : 0.; }
+
+      /// @brief Sets the relative tolerance used by integrate()
+      /// @details A positive value selects an AdaptiveIntegrator. A value
+      /// of zero (the default) restores the fixed-order rule. Any cached
+      /// HauserFeshbachDecay objects are discarded since their total widths
+      /// depend on this setting.
+      void set_integration_tolerance( double rel_tol );
+
+      /// @brief Returns true if the total widths of continuum exit channels
+      /// are computed only when needed to sample a decay
+      inline bool get_lazy_continuum_widths() const
+        { return lazy_continuum_widths_; }
+
+      /// @brief Sets whether the total widths of continuum exit channels
+      /// should be computed only when needed to sample a decay
+      /// @details When this is enabled, each HauserFeshbachDecay object
+      /// starts from inexpensive upper bounds on its continuum widths (see
+      /// ContinuumExitChannel::width_upper_bound()) and computes them
+      /// exactly only when a rejection sampling step requires it. This
+      /// avoids integrating the differential widths of unlikely channels but
+      /// changes the random number sequence used to sample them. Any cached
+      /// HauserFeshbachDecay objects are discarded.
+      void set_lazy_continuum_widths( bool lazy );
+
+      /// @brief Returns the fraction of each Hauser-Feshbach decay width
+      /// that may be carried by pooled discrete exit channels, or zero if
+      /// pooling is disabled
+      inline double get_discrete_pool_tolerance() const
+        { return discrete_pool_tolerance_; }
+
+      /// @brief Sets the fraction of each Hauser-Feshbach decay width that
+      /// may be carried by pooled discrete exit channels
+      /// @details When this is positive, each HauserFeshbachDecay object
+      /// merges the discrete exit channels with the smallest widths into a
+      /// single channel per emitted particle species, as long as their
+      /// combined width stays below this fraction of the total. A pooled
+      /// channel is resolved to one of its levels (with probability
+      /// proportional to the level's width) only when it is sampled, so the
+      /// decays are sampled from the same distribution. This reduces the
+      /// memory and sampling table size for nuclei with many discrete
+      /// levels, but it changes the random number sequence. Any cached
+      /// HauserFeshbachDecay objects are discarded.
+      void set_discrete_pool_tolerance( double tolerance );
+
+      /// @brief Returns true if the exit channels of each Hauser-Feshbach
+      /// decay may be built by several threads at once
+      inline bool get_parallel_exit_channels() const
+        { return parallel_exit_channels_; }
+
+      /// @brief Sets whether the exit channels of each Hauser-Feshbach
+      /// decay may be built by several threads at once
+      /// @details When this is enabled in concurrent mode, the partial
+      /// widths for each emitted fragment (and for gamma-ray emission) are
+      /// computed as separate tasks on the shared TaskPool, which should be
+      /// given some helper threads. This reduces the time needed to build a
+      /// single highly excited compound nucleus with many open channels.
+      /// The channels are stored in the usual order, so the sampled decays
+      /// do not change. This setting is ignored outside of concurrent mode.
+      inline void set_parallel_exit_channels( bool parallel )
+        { parallel_exit_channels_ = parallel; }
+
+      /// @brief Get the probability of gamma-ray cascades that may be left
+      /// out of the cascade path tables of each decay scheme
+      /// @details A value of zero means that the path tables are disabled.
+      inline double get_cascade_path_tolerance() const
+        { return cascade_path_tolerance_; }
+
+      /// @brief Enables or disables precomputed tables of complete
+      /// gamma-ray cascades for all decay schemes
+      /// @details See DecayScheme::set_cascade_path_tolerance(). In
+      /// concurrent mode, this should not be used while other threads are
+      /// using the database.
+      /// @param tolerance Fraction of the cascade probability for each
+      /// starting level that may be left to step-by-step sampling (zero
+      /// disables the path tables)
+      void set_cascade_path_tolerance( double tolerance );
+
+      /// @brief Numerically integrate an arbitrary callable object over the
+      /// interval [a, b] using the method chosen via
+      /// set_integration_tolerance()
+      /// @details This is used for the total widths of continuum exit
+      /// channels and for the normalization of the reacting neutrino energy
+      /// distribution
+      template <typename Function> inline double integrate(
+        const Function& f, double a, double b) const;
+
+      /// @brief Returns the approximate number of bytes of heap storage held
+      /// by the database
+      size_t memory_usage() const;
+
+      /// @brief Returns a JSON object that describes the memory held by the
+      /// database
+      /// @details The approximate number of bytes is given for each type of
+      /// stored data (decay schemes, models, and cached HauserFeshbachDecay
+      /// objects), both in total and for each nuclide. Cached
+      /// HauserFeshbachDecay objects are listed under the compound nucleus.
+      marley::JSON memory_report() const;
+
+      /// @brief Returns the arena used for scratch storage during decay
+      /// width calculations (or nullptr if none has been provided)
+      /// @details In concurrent mode, each worker uses its own arena, which
+      /// is owned by the database. Within a TaskScope, the arena given to it
+      /// is used instead.
+      marley::MonotonicArena* scratch_arena() const;
+
+      /// @brief Sets the arena used for scratch storage during decay width
+      /// calculations
+      /// @details The arena is not owned by the StructureDatabase. Only
+      /// memory that is released before each calculation returns is taken
+      /// from it, so the arena may safely be reset between events. If arena
+      /// is nullptr, then the global heap is used instead. This setting is
+      /// ignored in concurrent mode.
+      inline void set_scratch_arena( marley::MonotonicArena* arena )
+        { main_state_.scratch_arena = arena; }
+
+      /// @brief Returns true if the database may be used by several threads
+      /// at once, or false otherwise
+      inline bool get_concurrent() const { return concurrent_; }
+
+      /// @brief Sets whether the database may be used by several threads at
+      /// once
+      /// @details In concurrent mode, the decay schemes and angular momentum
+      /// coupling tables are shared by all threads. Each of them is loaded
+      /// exactly once: the first thread to request it does the work while
+      /// any others that need it wait, and it is not modified afterwards.
+      /// The ground-state spin-parity and fragment tables are always shared
+      /// in this way.
+      ///
+      /// The nuclear models and HauserFeshbachDecay objects keep internal
+      /// state while they are evaluated, so these are not shared. Instead,
+      /// each worker gets its own copies of them (and its own scratch arena)
+      /// when they are first needed. A worker is normally a thread, but
+      /// the Generator marks itself as the worker while it creates events
+      /// (see WorkerScope), so a Generator keeps its cached objects even if
+      /// it is run on a different thread each time.
+      ///
+      /// Functions that change the settings of the database (including
+      /// this one) or that report on its contents must not be called while
+      /// other threads are using it. Enabling concurrent mode keeps the
+      /// existing models and cached objects for the calling thread.
+      void set_concurrent( bool concurrent );
+
+      /// @brief While an object of this class exists, the calling thread
+      /// acts as the given worker in concurrent mode
+      /// @details A worker may only be active on one thread at a time
+      class WorkerScope {
+        public:
+          /// @param worker Any pointer that uniquely identifies the worker
+          /// (e.g., the address of the Generator that is using the database)
+          explicit WorkerScope( const void* worker );
+          ~WorkerScope();
+          WorkerScope(const WorkerScope&) = delete;
+          WorkerScope& operator=(const WorkerScope&) = delete;
+        private:
+          const void* previous_worker_;
+      };
+
+      /// @brief Returns the worker that the calling thread currently acts
+      /// as in concurrent mode
+      static const void* current_worker();
+
+      /// @brief While an object of this class exists, the calling thread
+      /// acts as the given worker and uses the given scratch arena
+      /// @details This allows a task run on a helper thread to use the
+      /// models of the worker that submitted it. The tasks that run at once
+      /// for a single worker must not use the same models.
+      class TaskScope {
+        public:
+          /// @param worker Worker that submitted the task (see
+          /// current_worker())
+          /// @param arena Scratch arena for use by the task only
+          TaskScope( const void* worker, marley::MonotonicArena* arena );
+          ~TaskScope();
+          TaskScope(const TaskScope&) = delete;
+          TaskScope& operator=(const TaskScope&) = delete;
+        private:
+          WorkerScope worker_scope_;
+          marley::MonotonicArena* previous_arena_;
+      };
 
       /// @brief Looks up the ground-state spin-parity for a particular nuclide
       /// @param[in] nuc_pdg PDG code for the nuclide of interest
@@ -193,27 +716,40 @@ namespace marley {
       std::unordered_map<int, std::unique_ptr<marley::DecayScheme> >
         decay_scheme_table_;
 
-      /// @brief Lookup table for marley::OpticalModel objects.
-      /// @details Keys are PDG codes, values are unique_ptrs to optical models.
-      std::unordered_map<int, std::unique_ptr<marley::OpticalModel> >
-        optical_model_table_;
-
-      /// @brief Lookup table for marley::LevelDensityModel objects.
-      /// @details Keys are PDG codes, values are unique_ptrs to level
-      /// density models.
-      std::unordered_map<int, std::unique_ptr<marley::LevelDensityModel> >
-        level_density_table_;
-
-      /// @brief Lookup table for marley::GammaStrengthFunctionModel objects.
-      /// @details Keys are PDG codes, values are unique_ptrs to gamma-ray
-      /// strength function models.
-      std::unordered_map<int, std::unique_ptr<
-        marley::GammaStrengthFunctionModel> > gamma_strength_function_table_;
-
       /// @brief Lookup table for nuclear fragments that will be considered
       /// when modeling de-excitations in the unbound continuum
       static std::map<int, marley::Fragment> fragment_table_;
 
+      /// @brief Kinds of SpinCouplingTable stored in spin_coupling_table_
+      enum class CouplingKind { FragmentContinuum, GammaContinuum,
+        FragmentDiscrete };
+
+      /// @brief Key type for spin_coupling_table_
+      /// @details The elements are the kind of table followed by the
+      /// arguments passed to the corresponding SpinCouplingTable builder
+      /// function (padded with zeros)
+      using CouplingKey = std::tuple<CouplingKind, int, int, int, int>;
+
+      /// @brief Angular momentum coupling tables shared by the exit channels
+      /// @details These depend only on quantum numbers, so they are kept
+      /// when the rest of the database is cleared. The elements of a
+      /// std::map are never moved, so exit channels may keep pointers to
+      /// them.
+      std::map<CouplingKey, marley::SpinCouplingTable> spin_coupling_table_;
+
+      /// @brief Helper function for the get_*_couplings() functions
+      template <typename Builder> const marley::SpinCouplingTable&
+        get_couplings( const CouplingKey& key, const Builder& build );
+
+      /// @brief Particle emission thresholds keyed by nuclide PDG code
+      /// @details Like the coupling tables, these depend only on fixed data
+      /// (the nuclear masses), so they are kept when the rest of the
+      /// database is cleared
+      std::map<int, ChannelThresholds> channel_threshold_table_;
+
+      /// @brief Guards channel_threshold_table_ in concurrent mode
+      mutable std::mutex channel_threshold_mutex_;
+
       /// @brief Default value of fragment_l_max_
       static constexpr int DEFAULT_FRAGMENT_L_MAX = 5;
 
@@ -230,9 +766,268 @@ namespace marley {
       /// object) for decays to the unbound continuum via gamma-ray emission
       int gamma_l_max_ = DEFAULT_GAMMA_L_MAX;
 
-      /// @brief Flag that indicates whether the ground-state spin-parities
-      /// have already been loaded from the relevant data file
-      static bool initialized_gs_spin_parity_table_;
+      /// @brief Relative tolerance for truncating the orbital angular
+      /// momentum sum in fragment continuum decay widths (see
+      /// set_fragment_l_tolerance())
+      double fragment_l_tolerance_ = 0.;
+
+      /// @brief Whether level density models are wrapped in a
+      /// TabulatedLevelDensityModel
+      bool tabulate_level_densities_ = false;
+
+      /// @brief Whether gamma-ray strength function models are wrapped in a
+      /// TabulatedGammaStrengthFunctionModel
+      bool tabulate_gamma_strength_functions_ = false;
+
+      /// @brief Method used by the optical models to compute transmission
+      /// coefficients
+      marley::OpticalModel::TransmissionMode transmission_mode_
+        = marley::OpticalModel::TransmissionMode::Exact;
+
+      /// @brief Version number for the format of the files written by
+      /// save_model_tables()
+      static constexpr uint32_t TABLE_CACHE_FORMAT_VERSION = 2u;
+
+      /// @brief Name of the file used to keep tabulated model values between
+      /// runs
+      std::string table_cache_file_;
+
+      /// @brief Key type for the HauserFeshbachDecay cache
+      /// @details The elements are the compound nucleus PDG code, its net
+      /// charge, its excitation energy, two times its spin, and its parity
+      using HFDecayKey = std::tuple<int, int, double, int, bool>;
+
+      /// @brief Default value of hf_decay_cache_size_
+      static constexpr size_t DEFAULT_HF_DECAY_CACHE_SIZE = 1024u;
+
+      /// @brief Maximum number of entries in each HauserFeshbachDecay cache
+      size_t hf_decay_cache_size_ = DEFAULT_HF_DECAY_CACHE_SIZE;
+
+      /// @brief Value type for the HauserFeshbachDecay cache
+      struct HFDecayCacheEntry {
+
+        /// @brief The cached object
+        std::unique_ptr<marley::HauserFeshbachDecay> hfd;
+
+        /// @brief Position of the key in WorkerState::hf_decay_lru
+        std::list<HFDecayKey>::iterator lru_iter;
+
+        /// @brief Number of bytes held by the object when it was last
+        /// measured (only kept up to date when a memory budget is in use)
+        size_t bytes;
+      };
+
+      /// @brief Objects that are modified while they are used to simulate
+      /// nuclear de-excitations
+      /// @details Outside of concurrent mode, only main_state_ is used. In
+      /// concurrent mode, each worker has its own WorkerState.
+      struct WorkerState {
+
+        /// @brief Lookup table for marley::OpticalModel objects.
+        /// @details Keys are PDG codes, values are unique_ptrs to optical
+        /// models.
+        std::unordered_map<int, std::unique_ptr<marley::OpticalModel> >
+          optical_models;
+
+        /// @brief Lookup table for marley::LevelDensityModel objects.
+        /// @details Keys are PDG codes, values are unique_ptrs to level
+        /// density models.
+        std::unordered_map<int, std::unique_ptr<marley::LevelDensityModel> >
+          level_density_models;
+
+        /// @brief Lookup table for marley::GammaStrengthFunctionModel
+        /// objects.
+        /// @details Keys are PDG codes, values are unique_ptrs to gamma-ray
+        /// strength function models.
+        std::unordered_map<int, std::unique_ptr<
+          marley::GammaStrengthFunctionModel> > gamma_strength_function_models;
+
+        /// @brief Cache keys ordered from most to least recently used
+        std::list<HFDecayKey> hf_decay_lru;
+
+        /// @brief Cache of HauserFeshbachDecay objects used by
+        /// get_hf_decay()
+        std::map<HFDecayKey, HFDecayCacheEntry> hf_decay_cache;
+
+        /// @brief Sum of the bytes members of the entries in hf_decay_cache
+        size_t hf_decay_bytes = 0u;
+
+        /// @brief Number of entries that have been evicted from
+        /// hf_decay_cache
+        uint64_t hf_decay_evictions = 0u;
+
+        /// @brief Entry most recently returned by get_hf_decay()
+        /// @details Continuum CDFs are built lazily after an object is
+        /// returned, so the size of this entry is measured again on the next
+        /// call when a memory budget is in use
+        HFDecayCacheEntry* last_hf_decay_entry = nullptr;
+
+        /// @brief Temporary HauserFeshbachDecay object returned by
+        /// get_hf_decay() when the cache is disabled
+        std::unique_ptr<marley::HauserFeshbachDecay> uncached_hf_decay;
+
+        /// @brief Arena used for scratch storage by the decay code
+        marley::MonotonicArena* scratch_arena = nullptr;
+
+        /// @brief Arena owned by this worker (used in concurrent mode)
+        std::unique_ptr<marley::MonotonicArena> own_arena;
+
+        /// @brief Removes all entries from the HauserFeshbachDecay cache
+        void clear_hf_decays();
+
+        /// @brief Approximate number of bytes held by the nuclear models
+        size_t model_memory_usage() const;
+
+        /// @brief Exchanges the models and cached objects (but not the
+        /// scratch arenas) with another WorkerState
+        void swap_contents( WorkerState& other );
+      };
+
+      /// @brief State used outside of concurrent mode
+      mutable WorkerState main_state_;
+
+      /// @brief Whether the database may be used by several threads at once
+      bool concurrent_ = false;
+
+      /// @brief Worker states used in concurrent mode, keyed by worker
+      mutable std::map<const void*, std::unique_ptr<WorkerState> >
+        worker_states_;
+
+      /// @brief Number of entries in worker_states_
+      mutable std::atomic<size_t> num_workers_{ 0u };
+
+      /// @brief Guards worker_states_
+      mutable std::mutex worker_mutex_;
+
+      /// @brief Identifies the current set of entries in worker_states_
+      /// @details Each worker remembers the state it used last, together
+      /// with this number, in thread-local storage. It is drawn from a
+      /// process-wide counter whenever the entries are discarded, so
+      /// remembered states are never used after they are deleted.
+      uint64_t worker_generation_ = 0u;
+
+      /// @brief Returns the WorkerState for the calling worker
+      WorkerState& state() const;
+
+      /// @brief Calls a function for every WorkerState in use
+      template <typename Function> void for_each_state( const Function& f )
+        const;
+
+      /// @brief Memory budget (bytes), or zero if there is none
+      size_t memory_budget_ = 0u;
+
+      /// @brief Helper function for get_hf_decay(). Measures the size of a
+      /// cache entry and updates WorkerState::hf_decay_bytes.
+      void update_hf_decay_bytes( WorkerState& ws, HFDecayCacheEntry& entry );
+
+      /// @brief Helper function for get_hf_decay(). Evicts least recently
+      /// used entries from the cache until the memory budget is satisfied.
+      void enforce_memory_budget( WorkerState& ws );
+
+      /// @brief Helper function for get_optical_model(). Creates an optical
+      /// model using the current numerical settings and adds it to the table.
+      marley::OpticalModel& add_optical_model( int nucleus_pid, int Z,
+        int A );
+
+      /// @brief Helper function for find_accessible_nuclides() and
+      /// precompute_model_tables()
+      /// @param[out] fragment_KE The largest CM frame kinetic energy (MeV)
+      /// available for the emission of each fragment, keyed by the PDG code
+      /// of the nuclide left behind and then by the fragment PDG code
+      static void find_accessible_nuclides(
+        const std::map<int, double>& max_Ex,
+        std::map<int, double>& nuclide_Ex,
+        std::map<int, std::map<int, double> >& fragment_KE);
+
+      /// @brief Creates an optical model using the current numerical
+      /// settings
+      std::unique_ptr<marley::KoningDelarocheOpticalModel>
+        create_optical_model( int Z, int A ) const;
+
+      /// @brief Creates a level density model using the current settings
+      std::unique_ptr<marley::LevelDensityModel>
+        create_level_density_model( int Z, int A ) const;
+
+      /// @brief Optical model tables computed by precompute_model_tables(),
+      /// keyed by nuclide PDG code
+      /// @details The tables are stored in the format written by
+      /// KoningDelarocheOpticalModel::write_tables(). They are not modified
+      /// while the database is in use, so all workers may read them.
+      std::map<int, std::string> optical_model_seeds_;
+
+      /// @brief Level density tables computed by precompute_model_tables(),
+      /// in the format written by TabulatedLevelDensityModel::write_tables()
+      std::map<int, std::string> level_density_seeds_;
+
+      /// @brief Returns the approximate number of bytes held by the decay
+      /// schemes and nuclear models (i.e., everything except the
+      /// HauserFeshbachDecay cache)
+      /// @details In concurrent mode, only the models that belong to ws
+      /// are counted, and the shared tables are divided equally among the
+      /// workers
+      size_t table_memory_usage( const WorkerState& ws ) const;
+
+      /// @brief Approximate number of bytes held by the decay schemes and
+      /// angular momentum coupling tables
+      size_t shared_memory_usage() const;
+
+      /// @brief Guards decay_scheme_table_ and decay_scheme_file_once_ in
+      /// concurrent mode
+      mutable std::mutex decay_scheme_mutex_;
+
+      /// @brief Flags used in concurrent mode to load each discrete level
+      /// data file only once, keyed by file name
+      std::map<std::string, std::once_flag> decay_scheme_file_once_;
+
+      /// @brief Flag used in concurrent mode to load the structure index
+      /// only once
+      std::once_flag structure_index_once_;
+
+      /// @brief Guards spin_coupling_table_ in concurrent mode
+      mutable std::mutex spin_coupling_mutex_;
+
+      /// @brief Helper function for get_decay_scheme(). Reads all of the
+      /// decay schemes from a data file listed in the structure index.
+      /// @param ds_file_name Name of the data file from the index
+      /// @param[out] schemes The decay schemes that were read
+      /// @return The name of the file that was actually read
+      std::string read_decay_scheme_file( const std::string& ds_file_name,
+        std::vector< std::unique_ptr<marley::DecayScheme> >& schemes ) const;
+
+      /// @brief Helper function for get_decay_scheme() in concurrent mode
+      marley::DecayScheme* get_decay_scheme_concurrent( int particle_id );
+
+      /// @brief Integrator used by integrate(), or nullptr if the fixed-order
+      /// rule should be used instead
+      std::unique_ptr<marley::AdaptiveIntegrator> integrator_;
+
+      /// @brief Whether continuum widths should be computed lazily
+      bool lazy_continuum_widths_ = false;
+
+      /// @brief Whether exit channels may be built in parallel (see
+      /// set_parallel_exit_channels())
+      bool parallel_exit_channels_ = false;
+
+      /// @brief Width fraction used for pooling discrete exit channels (see
+      /// set_discrete_pool_tolerance())
+      double discrete_pool_tolerance_ = 0.;
+
+      /// @brief Cascade path tolerance used for all decay schemes (see
+      /// set_cascade_path_tolerance())
+      double cascade_path_tolerance_ = 0.;
+
+      /// @brief Numerical settings used by the de-excitation calculations
+      marley::NumericalSettings numerical_settings_
+        = marley::NumericalSettings::preset( marley::Precision::Production );
+
+      /// @brief Helper function for integrate() that warns about results
+      /// that did not meet the requested tolerance
+      void check_integration_result( const marley::IntegrationResult& result,
+        double a, double b ) const;
+
+      /// @brief Flag used to load the ground-state spin-parities (and the
+      /// fragment table) from the relevant data file only once
+      static std::once_flag jpi_table_once_;
 
       /// @brief Name of the file used as an index for nuclear structure data
       const std::string structure_index_filename_ = "nuclide_index.txt";
@@ -256,9 +1051,42 @@ namespace marley {
       /// nuclear spin-parities
       static void initialize_jpi_table();
 
+      /// @brief Helper function that loads the table of ground-state
+      /// nuclear spin-parities from a compiled data file
+      /// @param binary_file_name Name of the compiled file
+      /// @param text_file_name Name of the original text file
+      /// @return False if the compiled file is unreadable or out of date,
+      /// true otherwise
+      static bool read_compiled_jpi_table(const std::string& binary_file_name,
+        const std::string& text_file_name);
+
       /// @brief Helper function that initializes the file index for
       /// loading nuclear structure data
       void load_structure_index();
+
+      /// @brief Helper function that reads all of the decay schemes from
+      /// a compiled discrete level data file
+      /// @param binary_file_name Name of the compiled file
+      /// @param text_file_name Name of the original file in MARLEY's native
+      /// format
+      /// @param[out] schemes The decay schemes that were read
+      /// @return False if the compiled file is unreadable or out of date
+      /// (the original file has changed since it was compiled), true
+      /// otherwise
+      static bool read_compiled_decay_schemes(
+        const std::string& binary_file_name,
+        const std::string& text_file_name,
+        std::vector<std::unique_ptr<marley::DecayScheme> >& schemes);
   };
 
+  // Inline function definitions
+  template <typename Function> inline double StructureDatabase::integrate(
+    const Function& f, double a, double b) const
+  {
+    if ( !integrator_ ) return marley_utils::num_integrate( f, a, b );
+    marley::IntegrationResult result = integrator_->integrate( f, a, b );
+    if ( !result.converged ) check_integration_result( result, a, b );
+    return result.value;
+  }
+
 }
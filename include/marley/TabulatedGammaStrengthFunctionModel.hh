@@ -0,0 +1,98 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <iostream>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "marley/GammaStrengthFunctionModel.hh"
+
+namespace marley {
+
+  /// @brief Decorator that speeds up gamma-ray transmission coefficient
+  /// calculations for another GammaStrengthFunctionModel by interpolating on
+  /// tabulated values
+  /// @details For each transition type and multipolarity that is requested,
+  /// the transmission coefficients of the wrapped model are tabulated on a
+  /// uniform grid in gamma-ray energy. Grid points are computed the first
+  /// time that they are needed, and four-point (cubic) Lagrange
+  /// interpolation is used in between them. The wrapped model is used
+  /// directly on the first NUM_EXACT_INTERVALS grid intervals and for
+  /// strength function requests.
+  class TabulatedGammaStrengthFunctionModel
+    : public GammaStrengthFunctionModel
+  {
+
+    public:
+
+      /// @param model The gamma-ray strength function model to tabulate
+      /// @param step Grid spacing (MeV) for the tables
+      TabulatedGammaStrengthFunctionModel(
+        std::unique_ptr<marley::GammaStrengthFunctionModel> model,
+        double step = DEFAULT_ENERGY_STEP);
+
+      virtual double strength_function(TransitionType type, int l,
+        double e_gamma) override;
+
+      virtual double transmission_coefficient(TransitionType type, int l,
+        double e_gamma) override;
+
+      virtual size_t memory_usage() const override;
+
+      /// @brief Write the tabulated values to a binary stream
+      void write_tables(std::ostream& out) const;
+
+      /// @brief Read tables written by write_tables()
+      /// @details The tables are ignored if they use a different grid
+      /// spacing or are shorter than the ones already computed.
+      /// @return True if the tables were read successfully, or false
+      /// otherwise
+      bool read_tables(std::istream& in);
+
+      /// @brief Get the gamma-ray strength function model that is being
+      /// tabulated
+      inline const marley::GammaStrengthFunctionModel& get_model() const;
+
+      /// @brief Default grid spacing (MeV) for the tables
+      static constexpr double DEFAULT_ENERGY_STEP = 0.01;
+
+      /// @brief Number of grid intervals, starting from zero energy, on which
+      /// interpolation is not used
+      static constexpr double NUM_EXACT_INTERVALS = 20.;
+
+    private:
+
+      /// @brief The gamma-ray strength function model that is being
+      /// tabulated
+      std::unique_ptr<marley::GammaStrengthFunctionModel> model_;
+
+      /// @brief Grid spacing (MeV) for the tables
+      double step_;
+
+      /// @brief Transmission coefficients at gamma-ray energies k * step_,
+      /// keyed by transition type and multipolarity
+      std::map< std::pair<TransitionType, int>, std::vector<double> >
+        tables_;
+  };
+
+  // Inline function definitions
+  inline const marley::GammaStrengthFunctionModel&
+    TabulatedGammaStrengthFunctionModel::get_model() const { return *model_; }
+
+}
@@ -0,0 +1,116 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "marley/LevelDensityModel.hh"
+
+namespace marley {
+
+  /// @brief Decorator that speeds up another LevelDensityModel by
+  /// interpolating on tabulated values
+  /// @details The logarithm of the total level density
+  /// @f$ \ln\rho(E_x) @f$ and the squared spin cut-off parameter
+  /// @f$ \sigma^2(E_x) @f$ of the wrapped model are tabulated on a uniform
+  /// grid in excitation energy. Grid points are computed the first time that
+  /// they are needed. Values in between them are obtained by linear
+  /// interpolation. The spin and parity dependence is then restored using
+  /// the usual spin distribution
+  /// @f$ \rho(E_x, J) = \rho(E_x)\,(2J + 1)/(2\sigma^2)
+  /// \exp[-(J + 1/2)^2 / (2\sigma^2)] @f$ and parity equipartition, as in
+  /// the BackshiftedFermiGasModel.
+  class TabulatedLevelDensityModel : public LevelDensityModel {
+
+    public:
+
+      /// @param model The level density model to tabulate
+      /// @param step Grid spacing (MeV) for the tables
+      TabulatedLevelDensityModel(std::unique_ptr<marley::LevelDensityModel>
+        model, double step = DEFAULT_ENERGY_STEP);
+
+      /// @copydoc marley::LevelDensityModel::level_density(double)
+      virtual double level_density(double Ex) override;
+
+      /// @copydoc marley::LevelDensityModel::level_density(double, int)
+      virtual double level_density(double Ex, int two_J) override;
+
+      /// @copydoc LevelDensityModel::level_density(double, int, marley::Parity)
+      virtual double level_density(double Ex, int two_J, marley::Parity Pi)
+        override;
+
+      /// @copydoc LevelDensityModel::level_density_all_spins()
+      virtual void level_density_all_spins(double Ex, marley::Parity Pi,
+        int two_J_min, int two_J_max, marley::ScratchVector<double>& rhos)
+        override;
+
+      /// @copydoc LevelDensityModel::spin_cutoff_squared()
+      virtual double spin_cutoff_squared(double Ex) override;
+
+      /// @copydoc LevelDensityModel::memory_usage()
+      virtual size_t memory_usage() const override;
+
+      /// @brief Write the tabulated values to a binary stream
+      void write_tables(std::ostream& out) const;
+
+      /// @brief Read tables written by write_tables()
+      /// @details The tables are ignored if they use a different grid
+      /// spacing or are shorter than the ones already computed.
+      /// @return True if the tables were read successfully, or false
+      /// otherwise
+      bool read_tables(std::istream& in);
+
+      /// @brief Computes every grid point needed to interpolate at
+      /// excitation energies up to Ex_max (MeV) in advance
+      void tabulate(double Ex_max);
+
+      /// @brief Get the level density model that is being tabulated
+      inline const marley::LevelDensityModel& get_model() const;
+
+      /// @brief Default grid spacing (MeV) for the tables
+      static constexpr double DEFAULT_ENERGY_STEP = 0.01;
+
+    private:
+
+      /// @brief Interpolates the tables at excitation energy Ex (MeV)
+      /// @param[out] rho The total level density (MeV<sup> -1</sup>)
+      /// @param[out] sigma2 The squared spin cut-off parameter
+      void interpolate(double Ex, double& rho, double& sigma2);
+
+      /// @brief Adds any missing grid points up to and including k
+      void extend(size_t k);
+
+      /// @brief The level density model that is being tabulated
+      std::unique_ptr<marley::LevelDensityModel> model_;
+
+      /// @brief Grid spacing (MeV) for the tables
+      double step_;
+
+      /// @brief Logarithm of the total level density at grid point k
+      /// (Ex = k * step_)
+      std::vector<double> log_rhos_;
+
+      /// @brief Squared spin cut-off parameter at each grid point
+      std::vector<double> sigma2s_;
+  };
+
+  // Inline function definitions
+  inline const marley::LevelDensityModel&
+    TabulatedLevelDensityModel::get_model() const { return *model_; }
+
+}
@@ -0,0 +1,106 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Process-wide pool of helper threads that run small batches of
+  /// independent tasks
+  /// @details A thread that calls run() works through its own batch of
+  /// tasks alongside the helper threads, so a batch always completes even
+  /// if every helper is busy with batches submitted by other threads (e.g.,
+  /// by other Generator objects running in parallel). The pool is used to
+  /// compute the partial decay widths of a highly excited compound nucleus
+  /// concurrently (see StructureDatabase::set_exit_channel_threads()).
+  class TaskPool {
+
+    public:
+
+      /// @brief Deleted copy constructor
+      TaskPool(const TaskPool&) = delete;
+
+      /// @brief Deleted copy assignment operator
+      TaskPool& operator=(const TaskPool&) = delete;
+
+      /// @brief Get a reference to the singleton instance of the TaskPool
+      static TaskPool& Instance();
+
+      /// @brief Sets the number of helper threads
+      /// @details Existing helpers are stopped (after finishing any queued
+      /// tasks) before the new ones are started. This must not be called
+      /// while any thread is inside run().
+      void set_num_threads(size_t num_threads);
+
+      /// @brief Returns the number of helper threads
+      size_t num_threads() const;
+
+      /// @brief Runs every task in the batch and returns once all of them
+      /// have finished
+      /// @details The order in which the tasks are run is unspecified. If
+      /// any of them throws an exception, the first one is rethrown here
+      /// after the rest of the batch has finished.
+      void run(std::vector< std::function<void()> >& tasks);
+
+    private:
+
+      /// @brief Shared state for one call to run()
+      struct Batch {
+        std::vector< std::function<void()> >* tasks;
+        size_t next = 0u; ///< Index of the next task to be claimed
+        size_t num_done = 0u; ///< Number of tasks that have finished
+        std::exception_ptr error; ///< First exception thrown by a task
+        std::condition_variable done_cv;
+      };
+
+      TaskPool() = default;
+      ~TaskPool();
+
+      /// @brief Main loop for the helper threads
+      void help();
+
+      /// @brief Stops and joins the helper threads
+      void stop_threads();
+
+      /// @brief Runs one claimed task and records its completion
+      /// @details The mutex is unlocked while the task runs
+      void run_task(Batch& batch, size_t index,
+        std::unique_lock<std::mutex>& lock);
+
+      /// @brief Guards all of the members below
+      mutable std::mutex mutex_;
+
+      /// @brief Signals the helpers that a batch is waiting or that they
+      /// should stop
+      std::condition_variable work_cv_;
+
+      /// @brief Batches that still have unclaimed tasks
+      std::deque< std::shared_ptr<Batch> > queue_;
+
+      std::vector<std::thread> threads_;
+
+      bool stop_ = false;
+  };
+
+}
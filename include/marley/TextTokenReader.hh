@@ -0,0 +1,83 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#pragma once
+#include <cstddef>
+#include <istream>
+
+namespace marley {
+
+  class Parity;
+
+  /// @brief Fast extraction of whitespace-separated numbers from a text
+  /// stream
+  /// @details This class reads characters directly from the
+  /// std::streambuf owned by a std::istream, bypassing the sentry objects
+  /// and locale facets used by the formatted input operators. Numbers are
+  /// always parsed as if in the classic "C" locale. The state flags of the
+  /// stream are updated in the same way as for operator>>: a failed
+  /// extraction sets the failbit, and reaching the end of the input sets
+  /// the eofbit. The reader does not keep any characters of its own, so
+  /// the stream may be used normally before and after it.
+  class TextTokenReader {
+
+    public:
+
+      /// @param in The stream from which tokens will be read. It must
+      /// outlive the TextTokenReader.
+      explicit TextTokenReader(std::istream& in);
+
+      TextTokenReader& operator>>(int& value);
+      TextTokenReader& operator>>(double& value);
+      TextTokenReader& operator>>(marley::Parity& parity);
+
+      /// @brief Discard the next few tokens without interpreting them
+      TextTokenReader& skip(size_t num_tokens = 1u);
+
+      /// @brief Checks whether another token follows on the current line
+      /// @details Spaces and tabs are consumed, but the end of the line is
+      /// not. This allows optional trailing fields to be detected.
+      /// @return True if a non-whitespace character precedes the next
+      /// line break, or false otherwise
+      bool token_on_line();
+
+      /// @brief Returns true if no extraction has failed, or false otherwise
+      inline explicit operator bool() const;
+
+      /// @brief Maximum number of characters allowed in a single token.
+      /// Extraction fails for longer tokens.
+      static constexpr size_t MAX_TOKEN_LENGTH = 63u;
+
+    private:
+
+      /// @brief Load the next whitespace-delimited token into token_
+      /// @return True if a token was read, or false otherwise
+      bool next_token();
+
+      std::istream& in_;
+
+      /// @brief Characters of the most recently read token (null-terminated)
+      char token_[ MAX_TOKEN_LENGTH + 1 ];
+
+      /// @brief Number of characters in the most recently read token
+      size_t length_ = 0u;
+  };
+
+  // Inline function definitions
+  inline TextTokenReader::operator bool() const { return !in_.fail(); }
+
+}
@@ -0,0 +1,95 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace marley {
+
+  /// @brief Assigns the threads used for event generation to CPUs and
+  /// NUMA nodes
+  /// @details The NUMA topology is read from sysfs on Linux, keeping only
+  /// the CPUs that the process is allowed to run on. If it cannot be
+  /// determined, all CPUs are treated as belonging to a single node. On
+  /// other platforms, threads are never pinned.
+  ///
+  /// Pinning each thread to a fixed CPU means that the memory it fills
+  /// first (e.g., the per-thread nuclear model tables) is placed on its own
+  /// NUMA node by the operating system's first-touch policy, and stays
+  /// local to the thread for the rest of the run.
+  class ThreadAffinity {
+
+    public:
+
+      /// @brief Ways of assigning threads to CPUs
+      enum class Policy {
+        None,    ///< Threads are not pinned
+        Compact, ///< Fill every CPU on one node before moving to the next
+        Spread   ///< Assign threads to the nodes in turn
+      };
+
+      /// @param policy How threads should be assigned to CPUs
+      explicit ThreadAffinity( Policy policy = Policy::None );
+
+      /// @brief Returns the policy used to assign threads to CPUs
+      inline Policy policy() const { return policy_; }
+
+      /// @brief Returns the number of NUMA nodes with at least one usable CPU
+      inline size_t num_nodes() const { return node_cpus_.size(); }
+
+      /// @brief Returns the index of the NUMA node used by a thread
+      /// @details If there are more threads than usable CPUs, the
+      /// assignments wrap around. Without pinning, every thread is
+      /// considered to belong to node zero.
+      /// @param thread Zero-based index of the thread
+      size_t node_for_thread( size_t thread ) const;
+
+      /// @brief Pins the calling thread to the CPU assigned to a thread
+      /// index
+      /// @details Does nothing if the policy is Policy::None. A warning is
+      /// logged if the operating system refuses the request.
+      /// @param thread Zero-based index of the thread
+      void pin_current_thread( size_t thread ) const;
+
+      /// @brief Restricts the calling thread to the CPUs on a NUMA node
+      /// @details Does nothing if the policy is Policy::None
+      /// @param node Index of the node (less than num_nodes())
+      void pin_current_thread_to_node( size_t node ) const;
+
+      /// @brief Converts a string to a Policy value
+      /// @details Allowed values are "none", "compact", and "spread"
+      static Policy policy_from_string( const std::string& name );
+
+    private:
+
+      /// @brief Sets the CPU affinity of the calling thread
+      static void set_affinity( const std::vector<int>& cpus );
+
+      /// @brief Policy used to assign threads to CPUs
+      Policy policy_;
+
+      /// @brief Usable CPUs on each NUMA node
+      std::vector< std::vector<int> > node_cpus_;
+
+      /// @brief Node index and CPU number assigned to each thread index
+      /// (modulo the number of usable CPUs)
+      std::vector< std::pair<size_t, int> > slots_;
+  };
+
+}
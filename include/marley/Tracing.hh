@@ -0,0 +1,180 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#pragma once
+#include <chrono>
+#include <string>
+
+#include "marley/Parity.hh"
+
+// Tracing zones mark the main steps of event generation on the timeline of
+// an external profiler. Unlike marley::Instrumentation, which accumulates
+// statistics, they record every call, so single slow events can be studied.
+// They are compiled out unless one of the following backends is selected
+// when MARLEY is built (e.g., via "make TRACING=perf"):
+//
+//   MARLEY_TRACING_TRACY  The Tracy profiler (https://github.com/wolfpld/tracy)
+//   MARLEY_TRACING_ITT    The Intel ITT API (VTune and compatible tools)
+//   MARLEY_TRACING_PERF   Markers written to the Linux ftrace trace_marker
+//                         file, which "perf record -e ftrace:print" and
+//                         Perfetto can capture
+//
+// Otherwise, none of the macros below evaluate their arguments.
+#if defined(MARLEY_TRACING_TRACY) || defined(MARLEY_TRACING_ITT) \
+  || defined(MARLEY_TRACING_PERF)
+  #define MARLEY_TRACING
+#endif
+
+#ifdef MARLEY_TRACING_TRACY
+  #include <tracy/Tracy.hpp>
+#endif
+
+namespace marley {
+
+  /// @brief Support functions for the MARLEY_TRACE_* macros
+  class Tracing {
+
+    public:
+
+      /// @brief Returns true if tracing zones were compiled into MARLEY
+      static constexpr bool compiled_in() {
+        #ifdef MARLEY_TRACING
+          return true;
+        #else
+          return false;
+        #endif
+      }
+
+      /// @brief Sets the time (s) that NucleusDecayer::process_event() may
+      /// take before the event is tagged as slow
+      /// @details Each slow event produces a message on the timeline that
+      /// lists every nuclear state (nucleus, excitation energy, and
+      /// spin-parity) visited by its de-excitation chain. A value of zero
+      /// tags every event.
+      static void set_slow_event_threshold( double seconds );
+
+      /// @brief Returns the time (s) above which an event is tagged as slow
+      static double slow_event_threshold();
+
+      /// @brief Adds a message to the timeline of the calling thread
+      static void message( const std::string& text );
+
+      /// @brief Describes a nuclear state for use in zone text and messages
+      static std::string describe_state( int pdg, double Ex, int twoJ,
+        marley::Parity Pi );
+
+      /// @brief Records the de-excitation chain of a single event and tags
+      /// the event if it is slow
+      class DecayChain {
+
+        public:
+
+          DecayChain();
+
+          /// @brief Emits a message describing the chain if the event took
+          /// longer than slow_event_threshold()
+          ~DecayChain();
+
+          DecayChain(const DecayChain&) = delete;
+          DecayChain& operator=(const DecayChain&) = delete;
+
+          /// @brief Adds a nuclear state to the chain
+          void add_state( int pdg, double Ex, int twoJ, marley::Parity Pi );
+
+        private:
+
+          std::chrono::steady_clock::time_point start_;
+          std::string states_;
+      };
+
+      #if defined(MARLEY_TRACING_ITT) || defined(MARLEY_TRACING_PERF)
+
+      /// @brief Static information about a place in the code where a zone
+      /// is opened
+      class Site {
+        public:
+          /// @param name Name of the zone (must be a string literal)
+          explicit Site( const char* name );
+          inline const char* name() const { return name_; }
+          inline void* handle() const { return handle_; }
+        private:
+          const char* name_;
+          void* handle_ = nullptr; ///< Backend-specific handle
+      };
+
+      /// @brief Marks the lifetime of the enclosing scope on the timeline
+      class Zone {
+        public:
+          explicit Zone( const Site& site );
+          ~Zone();
+          Zone(const Zone&) = delete;
+          Zone& operator=(const Zone&) = delete;
+
+          /// @brief Attaches text to the zone
+          void set_text( const std::string& text );
+
+        private:
+          const Site& site_;
+      };
+
+      #endif
+  };
+
+}
+
+#if defined(MARLEY_TRACING_TRACY)
+
+  // Opens a zone with the given name (a string literal) that lasts until
+  // the end of the enclosing scope
+  #define MARLEY_TRACE_ZONE(var, name) ZoneNamedN( var, name, true )
+
+  // Attaches a string to a zone opened by MARLEY_TRACE_ZONE()
+  #define MARLEY_TRACE_TEXT(var, text) do { \
+    const std::string marley_trace_text_( text ); \
+    var.Text( marley_trace_text_.c_str(), marley_trace_text_.size() ); \
+  } while ( false )
+
+#elif defined(MARLEY_TRACING)
+
+  #define MARLEY_TRACE_ZONE(var, name) \
+    static const marley::Tracing::Site var##_site_( name ); \
+    marley::Tracing::Zone var( var##_site_ )
+
+  #define MARLEY_TRACE_TEXT(var, text) var.set_text( text )
+
+#else
+
+  #define MARLEY_TRACE_ZONE(var, name) static_cast<void>( 0 )
+  #define MARLEY_TRACE_TEXT(var, text) static_cast<void>( 0 )
+
+#endif
+
+#ifdef MARLEY_TRACING
+
+  // Starts recording the de-excitation chain of an event
+  #define MARLEY_TRACE_CHAIN(var) marley::Tracing::DecayChain var
+
+  // Adds a nuclear state to a chain started by MARLEY_TRACE_CHAIN()
+  #define MARLEY_TRACE_CHAIN_STATE(var, pdg, Ex, twoJ, Pi) \
+    var.add_state( pdg, Ex, twoJ, Pi )
+
+#else
+
+  #define MARLEY_TRACE_CHAIN(var) static_cast<void>( 0 )
+  #define MARLEY_TRACE_CHAIN_STATE(var, pdg, Ex, twoJ, Pi) \
+    static_cast<void>( 0 )
+
+#endif
@@ -16,8 +16,78 @@
 
 #pragma once
 #include <complex>
+#include <vector>
 
 std::complex<double> coulomb_H_plus(int l, double eta, double rho);
 
+/// @brief Computes the outgoing Coulomb wavefunctions H+ = G + iF for every
+/// orbital angular momentum from zero to l_max using a single GSL call
+/// @param l_max Maximum orbital angular momentum
+/// @param eta Sommerfeld parameter
+/// @param rho Dimensionless radial coordinate
+/// @param[out] Hs Element l holds the wavefunction for orbital angular
+/// momentum l
+void coulomb_H_plus_array(int l_max, double eta, double rho,
+  std::vector<std::complex<double> >& Hs);
+
 void marley_gsl_error_handler(const char* reason, const char* file, int line,
   int gsl_errno);
+
+namespace marley {
+
+  /// @brief Supplies outgoing Coulomb wavefunctions, remembering the results
+  /// for the most recently used values of the Sommerfeld parameter and the
+  /// radial coordinate
+  /// @details Each GSL call computes a whole ladder of orbital angular
+  /// momenta. Repeated requests for any l in the ladder at the same
+  /// (eta, rho) pair are answered without recomputing anything.
+  class CoulombWavefunctionCache {
+
+    public:
+
+      /// @param max_size Maximum number of (eta, rho) pairs to remember
+      CoulombWavefunctionCache(size_t max_size = DEFAULT_MAX_SIZE);
+
+      /// @brief Get the outgoing Coulomb wavefunction H+ = G + iF
+      /// @param l Orbital angular momentum
+      /// @param l_max Maximum orbital angular momentum to compute if the
+      /// ladder for (eta, rho) is not already available. Values smaller than
+      /// l are treated as l.
+      /// @param eta Sommerfeld parameter
+      /// @param rho Dimensionless radial coordinate
+      std::complex<double> H_plus(int l, int l_max, double eta, double rho);
+
+      /// @brief Forget all stored wavefunctions
+      inline void clear();
+
+      /// @brief Returns the approximate number of bytes of heap storage
+      /// held by the cache
+      size_t memory_usage() const;
+
+      /// @brief Default value of max_size_
+      static constexpr size_t DEFAULT_MAX_SIZE = 16u;
+
+    private:
+
+      /// @brief Wavefunctions for a single (eta, rho) pair
+      struct Entry {
+        double eta;
+        double rho;
+        std::vector<std::complex<double> > Hs; ///< Indexed by l
+      };
+
+      /// @brief Stored wavefunctions, replaced in round-robin order
+      std::vector<Entry> entries_;
+
+      /// @brief Index of the next element of entries_ to replace
+      size_t next_ = 0u;
+
+      /// @brief Maximum number of elements in entries_
+      size_t max_size_;
+  };
+
+  // Inline function definitions
+  inline void CoulombWavefunctionCache::clear()
+    { entries_.clear(); next_ = 0u; }
+
+}
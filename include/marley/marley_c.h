@@ -0,0 +1,160 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+/// C interface to the MARLEY event generator. Unlike the C++ classes, this
+/// interface does not depend on the compiler or standard library used to
+/// build libMARLEY, so it may be used from C, from other languages, or by
+/// plugins loaded at runtime via dlopen(). All memory that crosses the
+/// interface is owned by the caller, except for the opaque generator handles
+/// and the error messages. Functions that can fail return a marley_status
+/// code. The message for the most recent error on the calling thread is
+/// available from marley_last_error().
+
+#ifndef MARLEY_C_H
+#define MARLEY_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version of this interface. It is increased whenever a change is made
+/// that is not backwards compatible.
+#define MARLEY_C_API_VERSION 2
+
+/// Status codes returned by the functions in this interface
+typedef enum marley_status {
+  MARLEY_OK = 0, ///< Success
+  MARLEY_ERROR = 1, ///< An error occurred. See marley_last_error().
+  MARLEY_INVALID_ARGUMENT = 2, ///< A required argument was null or invalid
+  MARLEY_BUFFER_TOO_SMALL = 3 ///< A caller-owned buffer was too small
+} marley_status;
+
+/// Opaque handle for a MARLEY event generator. A generator may be used by
+/// only one thread at a time, but separate generators may be used on
+/// different threads concurrently.
+typedef struct marley_generator marley_generator;
+
+/// Caller-owned storage for a batch of events in structure-of-arrays form.
+/// The event columns must hold at least event_capacity entries, and the
+/// particle columns must hold at least particle_capacity entries. Any column
+/// pointer may be null if that quantity is not needed. The particles of each
+/// event are stored contiguously: its initial particles first, followed by
+/// its final particles. Energies and momenta are in MeV.
+typedef struct marley_event_buffers {
+  // Capacities (set by the caller)
+  size_t event_capacity;
+  size_t particle_capacity;
+
+  // Event columns
+  double* Ex; ///< Excitation energy of the residue
+  int32_t* twoJ; ///< Two times the spin of the residue
+  int32_t* parity; ///< Parity of the residue (+1 or -1)
+  double* weight; ///< Event weight
+  double* time; ///< Projectile emission time (zero for most sources)
+  int32_t* num_initial; ///< Number of initial particles
+  int32_t* num_final; ///< Number of final particles
+  uint64_t* first_particle; ///< Index of the event's first particle
+
+  // Particle columns
+  int32_t* pdg; ///< PDG code
+  double* E; ///< Total energy
+  double* px; ///< x-component of the 3-momentum
+  double* py; ///< y-component of the 3-momentum
+  double* pz; ///< z-component of the 3-momentum
+  double* mass; ///< Mass
+  int32_t* charge; ///< Charge (in units of the elementary charge)
+
+  // Counts (set by the generation functions)
+  size_t num_events; ///< Number of events stored
+  size_t num_particles; ///< Number of particles stored
+} marley_event_buffers;
+
+/// Get the message for the most recent error on the calling thread. The
+/// string remains valid until the next call on the same thread.
+const char* marley_last_error(void);
+
+/// Get the MARLEY version string
+const char* marley_version(void);
+
+/// Create a generator from a job configuration file (in the same JSON
+/// format used by the marley executable)
+marley_status marley_generator_create_from_file(const char* file_name,
+  marley_generator** gen);
+
+/// Create a generator from the text of a JSON job configuration
+marley_status marley_generator_create_from_string(const char* json_text,
+  marley_generator** gen);
+
+/// Destroy a generator. Passing a null pointer is allowed.
+void marley_generator_destroy(marley_generator* gen);
+
+/// Create up to num_events events sampled from the configured neutrino
+/// source and store them in the caller's buffers, replacing their previous
+/// contents. Generation stops early if the next event would not fit. That
+/// event is kept and becomes the first one stored by the next call to either
+/// of the generation functions. MARLEY_BUFFER_TOO_SMALL is returned only if
+/// a single event does not fit in empty buffers.
+marley_status marley_generate_events(marley_generator* gen,
+  size_t num_events, marley_event_buffers* buffers);
+
+/// Like marley_generate_events(), but the events are created for a fixed
+/// projectile PDG code, kinetic energy (MeV), target atom (nuclear PDG
+/// code), and projectile direction (a 3-vector, or null for +z)
+marley_status marley_generate_fixed_events(marley_generator* gen,
+  size_t num_events, int pdg_a, double KEa, int pdg_atom,
+  const double* direction, marley_event_buffers* buffers);
+
+/// Get the flux-averaged total cross section (MeV^-2) for the configured
+/// neutrino source
+marley_status marley_flux_averaged_total_xs(marley_generator* gen,
+  double* xs);
+
+/// Get the total cross section (MeV^-2) for a projectile striking a single
+/// atomic target
+marley_status marley_total_xs(marley_generator* gen, int pdg_a, double KEa,
+  int pdg_atom, double* xs);
+
+/// Get the abundance-weighted total cross section (MeV^-2 per atom) at each
+/// of n projectile kinetic energies (MeV)
+marley_status marley_total_xs_batch(marley_generator* gen, int pdg_a,
+  const double* KEas, double* xs, size_t n);
+
+/// Get the seed used by the random number engine
+marley_status marley_get_seed(marley_generator* gen, uint64_t* seed);
+
+/// Reseed the random number engine
+marley_status marley_reseed(marley_generator* gen, uint64_t seed);
+
+/// Save the state of the random number engine as a null-terminated string.
+/// The length of the string (without the terminating null character) is
+/// stored in length. If capacity is too small, MARLEY_BUFFER_TOO_SMALL is
+/// returned and nothing is written to buffer, so the caller may query the
+/// needed size by passing a capacity of zero.
+marley_status marley_get_state(marley_generator* gen, char* buffer,
+  size_t capacity, size_t* length);
+
+/// Restore a state saved by marley_get_state(). Any event kept back by the
+/// generation functions is discarded.
+marley_status marley_set_state(marley_generator* gen, const char* state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -16,6 +16,8 @@
 
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
 #include "marley/Error.hh"
 
@@ -30,6 +32,15 @@ namespace marley_kinematics {
   void lorentz_boost(double beta_x, double beta_y, double beta_z,
     marley::Particle& particle_to_boost);
 
+  // Lorentz boost an array of count particles in a single call. The Lorentz
+  // factor is computed once and shared by all of them.
+  void lorentz_boost(double beta_x, double beta_y, double beta_z,
+    marley::Particle* particles_to_boost, size_t count);
+
+  // Lorentz boost every particle in a vector
+  void lorentz_boost(double beta_x, double beta_y, double beta_z,
+    std::vector<marley::Particle>& particles_to_boost);
+
   /// @brief Handles kinematic calculations needed to decay an initial
   /// particle into two final particles
   /// @details This function load two product Particle objects with the
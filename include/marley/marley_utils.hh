@@ -24,6 +24,7 @@
 #include <chrono>
 #include <cmath>
 #include <complex>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <random>
@@ -31,6 +32,7 @@
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace marley_utils {
 
@@ -120,6 +122,10 @@ namespace marley_utils {
   constexpr double fm2_to_minus40_cm2 = 1e14;
   // Square of the elementary charge
   constexpr double e2 = hbar_c * alpha; // MeV*fm
+  // Speed of light
+  constexpr double c_km_per_s = 299792.458; // km/s
+  // Dark matter speed (in units of c) used when none is specified
+  constexpr double DM_DEFAULT_VELOCITY = 1e-3;
   // Constant to use when approximating nuclear radii via
   // r = r0 * A^(1/3), where A is the nucleus's mass number.
   // See, for example, Introductory Nuclear Physics by Kenneth S. Krane.
@@ -137,13 +143,13 @@ namespace marley_utils {
 
   // Return the PDG particle ID that corresponds to a ground-state
   // nucleus with atomic number Z and mass number A
-  inline int get_nucleus_pid(int Z, int A) {
+  inline constexpr int get_nucleus_pid(int Z, int A) {
     if (Z == 0 && A == 1) return NEUTRON;
     else if (Z == 1 && A == 1) return PROTON;
     else return 10000*Z + 10*A + 1000000000;
   }
 
-  inline int get_particle_Z(int pid) {
+  inline constexpr int get_particle_Z(int pid) {
     if (pid == marley_utils::PROTON) return 1;
     else if (pid == marley_utils::NEUTRON) return 0;
     // nuclear fragment
@@ -152,7 +158,7 @@ namespace marley_utils {
     else return 0;
   }
 
-  inline int get_particle_A(int pid) {
+  inline constexpr int get_particle_A(int pid) {
     if (pid == marley_utils::PROTON) return 1;
     else if (pid == marley_utils::NEUTRON) return 1;
     // nuclear fragment
@@ -206,9 +212,20 @@ namespace marley_utils {
       pow == 0 ? 1 : num * ipow(num, pow - 1);
   }
 
+  // Returns the number of bytes that a std::vector has reserved for its
+  // elements. This is used to estimate the memory held by cached tables.
+  template <typename T, typename Alloc> inline size_t vector_bytes(
+    const std::vector<T, Alloc>& vec) { return vec.capacity() * sizeof(T); }
+
   // Compute the complex gamma function using the Lanczos approximation
   std::complex<double> gamma(std::complex<double> z);
 
+  // Compute ln|Gamma(x + iy)|^2 using the same Lanczos approximation as
+  // gamma(). Its relative accuracy (about 1e-15 for x >= 1/2) matches that
+  // of std::norm(gamma(z)), but it avoids intermediate overflow and the
+  // complex exponential and power functions.
+  double log_norm_gamma(double x, double y);
+
   // Numerically integrate a 1D function using Clenshaw-Curtis quadrature
   double num_integrate(const std::function<double(double)> &f,
     double a, double b);
@@ -221,6 +238,20 @@ namespace marley_utils {
   double maximize(const std::function<double(double)> f, double leftEnd,
     double rightEnd, double epsilon, double& maxLoc);
 
+  // Templated versions of minimize() and maximize() that accept any callable
+  // object. These allow the compiler to inline the objective function rather
+  // than calling it through a std::function.
+  template <typename Function> double minimize(const Function& f,
+    double leftEnd, double rightEnd, double epsilon, double& minLoc);
+
+  template <typename Function> inline double maximize(const Function& f,
+    double leftEnd, double rightEnd, double epsilon, double& maxLoc)
+  {
+    double result = minimize( [&f](double x) -> double { return -1.0*f(x); },
+      leftEnd, rightEnd, epsilon, maxLoc );
+    return -1.0*result;
+  }
+
   // Find both solutions of a quadratic equation while attempting
   // to avoid floating-point arithmetic issues
   void solve_quadratic_equation(double A, double B,
@@ -229,14 +260,76 @@ namespace marley_utils {
   // Efficiently read in an entire file as a std::string
   std::string get_file_contents(std::string filename);
 
-  // Advance to the next line of an ifstream that either matches (match == true)
-  // or does not match (match == false) a given regular expression
-  std::string get_next_line(std::ifstream &file_in, const std::regex &rx,
+  // Computes the 64-bit FNV-1a hash of a block of memory
+  uint64_t fnv1a_hash(const char* data, size_t size);
+
+  // Computes the 64-bit FNV-1a hash of a file's contents. Returns false if
+  // the file could not be read. This is used to detect whether a compiled
+  // data file is out of date with respect to the file it was made from.
+  bool hash_file(const std::string& file_name, uint64_t& hash);
+
+  // Advance to the next line of an input stream that either matches (match ==
+  // true) or does not match (match == false) a given regular expression
+  std::string get_next_line(std::istream &file_in, const std::regex &rx,
     bool match);
   // Do the same, but store the number of lines used in num_lines
-  std::string get_next_line(std::ifstream &file_in, const std::regex &rx,
+  std::string get_next_line(std::istream &file_in, const std::regex &rx,
     bool match, int& num_lines);
 
+  // Write the raw bytes of a trivially copyable value to a binary stream
+  template <typename T> inline void write_binary(std::ostream& out,
+    const T& value)
+  {
+    out.write( reinterpret_cast<const char*>(&value), sizeof(T) );
+  }
+
+  // Write a std::vector of trivially copyable values to a binary stream,
+  // preceded by its size
+  template <typename T> inline void write_binary(std::ostream& out,
+    const std::vector<T>& vec)
+  {
+    write_binary( out, static_cast<uint64_t>(vec.size()) );
+    out.write( reinterpret_cast<const char*>(vec.data()),
+      vec.size() * sizeof(T) );
+  }
+
+  // Write a std::string to a binary stream, preceded by its size
+  inline void write_binary(std::ostream& out, const std::string& str) {
+    write_binary( out, static_cast<uint64_t>(str.size()) );
+    out.write( str.data(), str.size() );
+  }
+
+  // Read a value written by write_binary(). Returns false if the stream
+  // could not provide it.
+  template <typename T> inline bool read_binary(std::istream& in, T& value)
+  {
+    in.read( reinterpret_cast<char*>(&value), sizeof(T) );
+    return static_cast<bool>( in );
+  }
+
+  // Maximum number of elements accepted by read_binary() for a std::vector
+  // or std::string. This guards against huge allocations when reading a
+  // corrupted file.
+  constexpr uint64_t max_binary_read_size = 1ull << 28;
+
+  template <typename T> inline bool read_binary(std::istream& in,
+    std::vector<T>& vec)
+  {
+    uint64_t size;
+    if ( !read_binary(in, size) || size > max_binary_read_size ) return false;
+    vec.resize( size );
+    in.read( reinterpret_cast<char*>(vec.data()), size * sizeof(T) );
+    return static_cast<bool>( in );
+  }
+
+  inline bool read_binary(std::istream& in, std::string& str) {
+    uint64_t size;
+    if ( !read_binary(in, size) || size > max_binary_read_size ) return false;
+    str.resize( size );
+    in.read( &str[0], size );
+    return static_cast<bool>( in );
+  }
+
   // String containing all of the characters that will be
   // considered whitespace by default in the string
   // manipulation functions below
@@ -375,6 +468,17 @@ namespace marley_utils {
   // representing the amount of memory in more readable units
   std::string num_bytes_to_string(double bytes, unsigned precision = 3);
 
+  // Minimum size of the buffer passed to format_shortest_double()
+  constexpr size_t SHORTEST_DOUBLE_BUFFER_SIZE = 32;
+
+  // Writes a short decimal representation of x (in the style of the %g
+  // printf conversion) that reads back as the same double. The digits are
+  // the shortest possible ones in all but a tiny fraction of cases. The
+  // result is null-terminated, and its length (excluding the terminator) is
+  // returned. The buffer must hold at least SHORTEST_DOUBLE_BUFFER_SIZE
+  // characters.
+  size_t format_shortest_double(double x, char* buffer);
+
   // Trim an ENSDF nucid string and make two-letter element symbols have a
   // lowercase last letter. Currently, no checking is done to see if the
   // string is a valid nucid.
@@ -521,4 +625,93 @@ namespace marley_utils {
   extern const std::string marley_logo;
 
   extern const std::string marley_pic;
+
+  // Numerically minimize a function of one variable using Brent's method.
+  // The location where f takes its minimum is returned in the variable
+  // minLoc. Notation and implementation based on Chapter 5 of Richard Brent's
+  // book "Algorithms for Minimization Without Derivatives". This function is
+  // a modified version of a public-domain implementation of Brent's
+  // algorithm. You can download the original source code from
+  // http://tinyurl.com/hhoy3ky.
+  template <typename Function> double minimize(const Function& f,
+    double leftEnd, double rightEnd, double epsilon, double& minLoc)
+  {
+    double d, e, m, p, q, r, tol, t2, u, v, w, fu, fv, fw, fx;
+    const double c = 0.5*(3.0 - std::sqrt(5.0));
+    const double SQRT_DBL_EPSILON = std::sqrt(
+      std::numeric_limits<double>::epsilon() );
+
+    double& a = leftEnd;
+    double& b = rightEnd;
+    double& x = minLoc;
+
+    v = w = x = a + c*(b - a);
+    d = e = 0.0;
+    fv = fw = fx = f(x);
+
+    // Check stopping criteria
+    while (m = 0.5*(a + b),
+      tol = SQRT_DBL_EPSILON*std::abs(x) + epsilon,
+      t2 = 2.0*tol,
+      std::abs(x - m) > t2 - 0.5*(b - a))
+    {
+        p = q = r = 0.0;
+        if (std::abs(e) > tol)
+        {
+            // fit parabola
+            r = (x - w)*(fx - fv);
+            q = (x - v)*(fx - fw);
+            p = (x - v)*q - (x - w)*r;
+            q = 2.0*(q - r);
+            (q > 0.0) ? p = -p : q = -q;
+            r = e; e = d;
+        }
+        if (std::abs(p) < std::abs(0.5*q*r) && p < q*(a - x) && p < q*(b - x))
+        {
+            // A parabolic interpolation step
+            d = p/q;
+            u = x + d;
+            // f must not be evaluated too close to a or b
+            if (u - a < t2 || b - u < t2)
+                d = (x < m) ? tol : -tol;
+        }
+        else
+        {
+            // A golden section step
+            e = (x < m) ? b : a;
+            e -= x;
+            d = c*e;
+        }
+        // f must not be evaluated too close to x
+        if (std::abs(d) >= tol)
+            u = x + d;
+        else if (d > 0.0)
+            u = x + tol;
+        else
+            u = x - tol;
+        fu = f(u);
+        // Update a, b, v, w, and x
+        if (fu <= fx)
+        {
+            (u < x) ? b = x : a = x;
+            v = w; fv = fw;
+            w = x; fw = fx;
+            x = u; fx = fu;
+        }
+        else
+        {
+            (u < x) ? a = u : b = u;
+            if (fu <= fw || w == x)
+            {
+                v = w; fv = fw;
+                w = u; fw = fu;
+            }
+            else if (fu <= fv || v == x || v == w)
+            {
+                v = u; fv = fu;
+            }
+        }
+    }
+    return  fx;
+  }
 }
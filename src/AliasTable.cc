@@ -0,0 +1,84 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <string>
+
+#include "marley/AliasTable.hh"
+#include "marley/Error.hh"
+
+void marley::AliasTable::clear() {
+  prob_.clear();
+  alias_.clear();
+  total_weight_ = 0.;
+}
+
+void marley::AliasTable::build_tables() {
+
+  size_t n = prob_.size();
+
+  if ( n == 0u ) throw marley::Error( "Cannot build an alias table with"
+    " no entries" );
+
+  // Check the weights and compute their sum
+  total_weight_ = 0.;
+  for ( const auto& w : prob_ ) {
+    if ( !(w >= 0.) ) throw marley::Error( "Invalid weight "
+      + std::to_string(w) + " encountered while building an alias table" );
+    total_weight_ += w;
+  }
+
+  // If all of the weights vanish, then always choose the first entry (and
+  // avoid dividing by zero below)
+  if ( !(total_weight_ > 0.) ) {
+    alias_.assign( n, 0u );
+    prob_.assign( n, 0. );
+    prob_.front() = 1.;
+    return;
+  }
+
+  // Scale the weights so that their average is one, then sort the columns
+  // into underfull and overfull sets
+  alias_.resize( n );
+  small_.clear();
+  large_.clear();
+
+  double scale = n / total_weight_;
+  for ( size_t i = 0u; i < n; ++i ) {
+    prob_[ i ] *= scale;
+    alias_[ i ] = i;
+    if ( prob_[ i ] < 1. ) small_.push_back( i );
+    else large_.push_back( i );
+  }
+
+  // Fill each underfull column using probability from an overfull one
+  while ( !small_.empty() && !large_.empty() ) {
+    size_t s = small_.back();
+    small_.pop_back();
+    size_t l = large_.back();
+
+    alias_[ s ] = l;
+    prob_[ l ] = ( prob_[ l ] + prob_[ s ] ) - 1.;
+
+    if ( prob_[ l ] < 1. ) {
+      large_.pop_back();
+      small_.push_back( l );
+    }
+  }
+
+  // Any remaining columns are full up to round-off error
+  for ( const auto& l : large_ ) prob_[ l ] = 1.;
+  for ( const auto& s : small_ ) prob_[ s ] = 1.;
+}
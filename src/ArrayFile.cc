@@ -0,0 +1,203 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// MARLEY includes
+#include "marley/ArrayFile.hh"
+#include "marley/Error.hh"
+
+namespace {
+
+  const std::string NPY_MAGIC( "\x93NUMPY" );
+
+  bool host_is_little_endian() {
+    const uint16_t one = 1u;
+    unsigned char first_byte;
+    std::memcpy( &first_byte, &one, 1u );
+    return first_byte == 1u;
+  }
+
+  // Reads an unsigned little-endian integer of the given size (bytes)
+  size_t read_le_uint( const char* data, size_t size ) {
+    size_t result = 0u;
+    for ( size_t b = size; b-- > 0u; ) {
+      result = ( result << 8 ) | static_cast<unsigned char>( data[b] );
+    }
+    return result;
+  }
+
+  // Returns the text that follows the given key (in single quotes) and its
+  // colon in the Python dictionary literal stored in a .npy header
+  std::string npy_header_value( const std::string& header,
+    const std::string& key, const std::string& file_name )
+  {
+    size_t pos = header.find( '\'' + key + '\'' );
+    if ( pos != std::string::npos ) pos = header.find( ':', pos );
+    if ( pos == std::string::npos ) throw marley::Error( "Missing \"" + key
+      + "\" entry in the header of the .npy file " + file_name );
+    size_t start = header.find_first_not_of( ' ', pos + 1u );
+    if ( start == std::string::npos ) throw marley::Error( "Invalid \""
+      + key + "\" entry in the header of the .npy file " + file_name );
+    return header.substr( start );
+  }
+
+}
+
+marley::ArrayFile::ArrayFile( const std::string& file_name,
+  size_t raw_columns ) : file_name_( file_name ),
+  file_( std::make_unique<marley::MappedFile>(file_name) )
+{
+  const char* data = file_->data();
+  size_t size = file_->size();
+
+  if ( size >= NPY_MAGIC.size()
+    && std::memcmp(data, NPY_MAGIC.data(), NPY_MAGIC.size()) == 0 )
+  {
+    read_npy_header();
+    return;
+  }
+
+  // Headerless files hold little-endian doubles
+  if ( raw_columns == 0u ) throw marley::Error( "Invalid number of columns"
+    " requested for the binary table file " + file_name );
+  if ( size % (raw_columns * sizeof(double)) != 0u ) {
+    throw marley::Error( "The size of the binary table file " + file_name
+      + " is not a multiple of the size of one row of "
+      + std::to_string(raw_columns) + " double-precision values" );
+  }
+  values_ = data;
+  columns_ = raw_columns;
+  rows_ = size / ( raw_columns * sizeof(double) );
+  swap_bytes_ = !host_is_little_endian();
+}
+
+void marley::ArrayFile::read_npy_header() {
+
+  const char* data = file_->data();
+  size_t size = file_->size();
+
+  // The magic string is followed by the major and minor format versions
+  // and the length of the header. Versions 2 and 3 use a four-byte length.
+  size_t pos = NPY_MAGIC.size();
+  if ( size < pos + 4u ) throw marley::Error( "Truncated .npy file "
+    + file_name_ );
+  int major_version = static_cast<unsigned char>( data[pos] );
+  pos += 2u;
+  size_t length_size = ( major_version >= 2 ) ? 4u : 2u;
+  if ( size < pos + length_size ) throw marley::Error( "Truncated .npy file "
+    + file_name_ );
+  size_t header_length = read_le_uint( data + pos, length_size );
+  pos += length_size;
+  if ( size < pos + header_length ) throw marley::Error( "Truncated .npy"
+    " file " + file_name_ );
+
+  std::string header( data + pos, header_length );
+  values_ = data + pos + header_length;
+
+  std::string descr = npy_header_value( header, "descr", file_name_ );
+  if ( descr.size() < 5u || descr.front() != '\'' || descr[4] != '\''
+    || descr[2] != 'f' || (descr[3] != '4' && descr[3] != '8') )
+  {
+    throw marley::Error( "The .npy file " + file_name_ + " does not hold"
+      " 32- or 64-bit floating-point numbers" );
+  }
+  item_size_ = ( descr[3] == '4' ) ? 4u : 8u;
+  char order = descr[1];
+  if ( order == '<' ) swap_bytes_ = !host_is_little_endian();
+  else if ( order == '>' ) swap_bytes_ = host_is_little_endian();
+  else if ( order == '|' || order == '=' ) swap_bytes_ = false;
+  else throw marley::Error( "Unrecognized byte order in the .npy file "
+    + file_name_ );
+
+  std::string fortran = npy_header_value( header, "fortran_order",
+    file_name_ );
+  fortran_order_ = ( fortran.compare(0, 4, "True") == 0 );
+
+  std::string shape = npy_header_value( header, "shape", file_name_ );
+  size_t close = shape.find( ')' );
+  if ( shape.empty() || shape.front() != '(' || close == std::string::npos ) {
+    throw marley::Error( "Invalid array shape in the .npy file "
+      + file_name_ );
+  }
+  std::vector<size_t> dims;
+  std::string dims_text = shape.substr( 1u, close - 1u );
+  size_t start = 0u;
+  while ( start < dims_text.size() ) {
+    size_t comma = dims_text.find( ',', start );
+    if ( comma == std::string::npos ) comma = dims_text.size();
+    std::string dim = dims_text.substr( start, comma - start );
+    dim.erase( std::remove(dim.begin(), dim.end(), ' '), dim.end() );
+    if ( !dim.empty() ) dims.push_back( std::stoul(dim) );
+    start = comma + 1u;
+  }
+  if ( dims.empty() || dims.size() > 2u ) throw marley::Error( "The .npy"
+    " file " + file_name_ + " must hold a 1D or 2D array" );
+
+  rows_ = dims.front();
+  columns_ = ( dims.size() == 2u ) ? dims.back() : 1u;
+
+  if ( static_cast<size_t>(file_->data() + size - values_)
+    < rows_ * columns_ * item_size_ )
+  {
+    throw marley::Error( "Truncated .npy file " + file_name_ );
+  }
+}
+
+double marley::ArrayFile::value( size_t row, size_t column ) const {
+  if ( row >= rows_ || column >= columns_ ) throw marley::Error( "Invalid"
+    " entry (" + std::to_string(row) + ", " + std::to_string(column)
+    + ") requested from the table in " + file_name_ );
+
+  size_t index = fortran_order_ ? column * rows_ + row
+    : row * columns_ + column;
+
+  char bytes[ sizeof(double) ];
+  std::memcpy( bytes, values_ + index * item_size_, item_size_ );
+  if ( swap_bytes_ ) std::reverse( bytes, bytes + item_size_ );
+
+  if ( item_size_ == 4u ) {
+    float result;
+    std::memcpy( &result, bytes, sizeof(float) );
+    return result;
+  }
+  double result;
+  std::memcpy( &result, bytes, sizeof(double) );
+  return result;
+}
+
+std::vector<double> marley::ArrayFile::column( size_t column ) const {
+  if ( column >= columns_ ) throw marley::Error( "Column "
+    + std::to_string(column) + " requested from the table in " + file_name_
+    + ", which has " + std::to_string(columns_) + " column(s)" );
+
+  std::vector<double> result( rows_ );
+
+  // Copy contiguous columns of native doubles in a single step
+  if ( rows_ > 0u && item_size_ == sizeof(double) && !swap_bytes_
+    && (fortran_order_ || columns_ == 1u) )
+  {
+    std::memcpy( result.data(), values_ + column * rows_ * sizeof(double),
+      rows_ * sizeof(double) );
+    return result;
+  }
+
+  for ( size_t r = 0u; r < rows_; ++r ) result[ r ] = value( r, column );
+  return result;
+}
@@ -15,13 +15,15 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #include <cmath>
+#include <limits>
 
 #include "marley/marley_utils.hh"
 #include "marley/MassTable.hh"
 #include "marley/BackshiftedFermiGasModel.hh"
 
 marley::BackshiftedFermiGasModel::BackshiftedFermiGasModel(int Z, int A)
-  : Z_(Z), A_(A)
+  : Z_(Z), A_(A), cached_Ex_(std::numeric_limits<double>::quiet_NaN()),
+  cached_rho_(0.), cached_sigma_(0.)
 {
   int N = A_ - Z_;
   double A_third = std::pow(A_, 1.0/3.0);
@@ -55,6 +57,8 @@ marley::BackshiftedFermiGasModel::BackshiftedFermiGasModel(int Z, int A)
   // Spin cut-off parameter
   sigma_d_global_ = 0.83*std::pow(A_, 0.26);
   Sn_ = mt.get_fragment_separation_energy(Z_, A_, marley_utils::NEUTRON);
+
+  A_five_thirds_ = std::pow(A_, 5.0/3.0);
 }
 
 // rho(Ex, J, Pi) assuming equipartition of parity (the parameter Pi is unused)
@@ -73,9 +77,51 @@ double marley::BackshiftedFermiGasModel::level_density(double Ex, int two_J) {
     / two_sigma2) * rho;
 }
 
+double marley::BackshiftedFermiGasModel::spin_cutoff_squared(double Ex) {
+  // Spin-cutoff parameter sigma_ is updated by the call to
+  // this->level_density(Ex)
+  level_density(Ex);
+  return std::pow(sigma_, 2);
+}
+
+// rho(Ex, J, Pi) for several spins, assuming equipartition of parity (the
+// parameter Pi is unused)
+void marley::BackshiftedFermiGasModel::level_density_all_spins(double Ex,
+  marley::Parity /*Pi*/, int two_J_min, int two_J_max,
+  marley::ScratchVector<double>& rhos)
+{
+  rhos.clear();
+  if ( two_J_max < two_J_min ) return;
+
+  double rho = level_density(Ex);
+  // Spin-cutoff parameter sigma_ is updated by previous call to
+  // this->level_density(Ex)
+  double two_sigma2 = 2 * sigma_ * sigma_;
+
+  // The Gaussian factor g(x) = exp(-x^2 / (4 * two_sigma2)) with x = two_J + 1
+  // is updated for each step x -> x + 2 using the ratio
+  // g(x + 2) / g(x) = exp(-(x + 1) / two_sigma2), which itself changes by the
+  // constant factor exp(-2 / two_sigma2). Only three calls to std::exp() are
+  // therefore needed regardless of the number of spins.
+  double x = two_J_min + 1;
+  double gauss = std::exp(-0.25 * x * x / two_sigma2);
+  double ratio = std::exp(-(x + 1) / two_sigma2);
+  const double ratio_step = std::exp(-2. / two_sigma2);
+  for ( int two_J = two_J_min; two_J <= two_J_max; two_J += 2 ) {
+    rhos.push_back( 0.5 * ( ((two_J + 1) / two_sigma2) * gauss * rho ) );
+    gauss *= ratio;
+    ratio *= ratio_step;
+  }
+}
+
 /// @note Calls to this function update the spin cut-off parameter sigma_
 double marley::BackshiftedFermiGasModel::level_density(double Ex) {
 
+  if ( Ex == cached_Ex_ ) {
+    sigma_ = cached_sigma_;
+    return cached_rho_;
+  }
+
   // Effective excitation energy
   double U = Ex - Delta_BFM_;
 
@@ -122,13 +168,20 @@ double marley::BackshiftedFermiGasModel::level_density(double Ex) {
 
   // For very small excitation energies, take the limit of the total
   // level density as U -> 0 to prevent numerical issues.
+  double rho;
   if (U <= 0) {
     static const double exp1 = std::exp(1);
-    return exp1 * a / (12 * sigma_);
+    rho = exp1 * a / (12 * sigma_);
+  }
+  else {
+    double aU = a * U;
+    double sqrt_aU = std::sqrt(aU);
+    rho = 1. / (12 * sigma_ * (std::sqrt(2 * sqrt_aU)*U*std::exp(-2 * sqrt_aU)
+      + std::exp(-aU - 1)/a));
   }
 
-  double aU = a * U;
-  double sqrt_aU = std::sqrt(aU);
-  return std::pow(12 * sigma_ * (std::sqrt(2 * sqrt_aU)*U*std::exp(-2 * sqrt_aU)
-    + std::exp(-aU - 1)/a), -1);
+  cached_Ex_ = Ex;
+  cached_rho_ = rho;
+  cached_sigma_ = sigma_;
+  return rho;
 }
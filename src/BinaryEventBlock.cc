@@ -0,0 +1,507 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <utility>
+
+#include "marley/BinaryEventBlock.hh"
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/MassTable.hh"
+#include "marley/marley_utils.hh"
+
+// Identifies a MARLEY binary event file
+const std::string marley::BinaryEventBlock::MAGIC = "MARLEYEV";
+
+namespace {
+
+  // Maximum number of events or particles accepted in a single block. This
+  // guards against huge allocations when reading a corrupted file.
+  constexpr uint32_t MAX_BLOCK_ENTRIES = 1u << 24;
+
+  bool host_is_little_endian() {
+    const uint32_t one = 1u;
+    unsigned char first_byte;
+    std::memcpy( &first_byte, &one, 1 );
+    return first_byte == 1u;
+  }
+
+  // Reverses the bytes of each of the count values of size bytes stored at
+  // data
+  void swap_bytes(char* data, size_t size, size_t count) {
+    for ( size_t k = 0u; k < count; ++k ) {
+      std::reverse( data + k*size, data + (k + 1u)*size );
+    }
+  }
+
+  // Writes count fixed-width values in little-endian byte order
+  template <typename T> void write_le(std::ostream& out, const T* values,
+    size_t count)
+  {
+    if ( host_is_little_endian() ) {
+      out.write( reinterpret_cast<const char*>(values), count*sizeof(T) );
+      return;
+    }
+    std::vector<T> temp( values, values + count );
+    char* data = reinterpret_cast<char*>( temp.data() );
+    swap_bytes( data, sizeof(T), count );
+    out.write( data, count*sizeof(T) );
+  }
+
+  template <typename T> void write_le(std::ostream& out, T value) {
+    write_le( out, &value, 1u );
+  }
+
+  template <typename T> void write_column(std::ostream& out,
+    const std::vector<T>& column)
+  {
+    write_le( out, column.data(), column.size() );
+  }
+
+  // Reads count fixed-width values in little-endian byte order
+  template <typename T> bool read_le(std::istream& in, T* values,
+    size_t count)
+  {
+    char* data = reinterpret_cast<char*>( values );
+    in.read( data, count*sizeof(T) );
+    if ( !in ) return false;
+    if ( !host_is_little_endian() ) swap_bytes( data, sizeof(T), count );
+    return true;
+  }
+
+  template <typename T> bool read_le(std::istream& in, T& value) {
+    return read_le( in, &value, 1u );
+  }
+
+  template <typename T> bool read_column(std::istream& in,
+    std::vector<T>& column, size_t size)
+  {
+    column.resize( size );
+    return read_le( in, column.data(), size );
+  }
+
+  // Looks up particle masses (MeV) in the MassTable using the PDG code and
+  // charge. A block holds few distinct kinds of particles, so the results
+  // are cached.
+  class TableMasses {
+
+    public:
+
+      // Returns NaN if the table cannot supply the mass
+      double get(int32_t pdg, int32_t charge) {
+        auto key = std::make_pair( pdg, charge );
+        auto iter = cache_.find( key );
+        if ( iter != cache_.end() ) return iter->second;
+
+        double mass = std::numeric_limits<double>::quiet_NaN();
+        const auto& mt = marley::MassTable::Instance();
+        try {
+          if ( marley_utils::is_ion(pdg) ) mass = mt.get_ion_mass( pdg,
+            charge );
+          else mass = mt.get_particle_mass( pdg );
+        }
+        catch ( const std::exception& ) {}
+
+        cache_.emplace( key, mass );
+        return mass;
+      }
+
+    private:
+
+      std::map< std::pair<int32_t, int32_t>, double > cache_;
+  };
+
+  // Number of bytes used by each particle in the kinematics columns of an
+  // event block
+  size_t particle_kinematics_size(
+    marley::BinaryEventBlock::Precision precision)
+  {
+    // Full precision: total energy, 3-momentum, and mass. Single precision:
+    // kinetic energy and 3-momentum.
+    if ( precision == marley::BinaryEventBlock::Precision::single ) {
+      return 4u*sizeof(float);
+    }
+    return 5u*sizeof(double);
+  }
+
+}
+
+void marley::BinaryEventBlock::write_header(std::ostream& out,
+  const Header& header)
+{
+  out.write( MAGIC.data(), MAGIC.size() );
+  write_le( out, FORMAT_VERSION );
+  write_le( out, static_cast<uint32_t>(header.layout)
+    | (static_cast<uint32_t>(header.precision) << 16) );
+  write_le( out, header.flux_avg_tot_xsec );
+  write_le( out, header.event_count );
+  write_le( out, header.metadata_position );
+}
+
+bool marley::BinaryEventBlock::read_header(std::istream& in, Header& header)
+{
+  std::string magic( MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+  if ( !in || magic != MAGIC ) return false;
+
+  uint32_t version;
+  if ( !read_le(in, version) || version < 1u || version > FORMAT_VERSION ) {
+    return false;
+  }
+  header.format_version = version;
+
+  // Before version 4 of the format, the layout field was reserved (and
+  // always zero). Starting with version 5, its upper 16 bits hold the
+  // precision.
+  uint32_t layout;
+  if ( !read_le(in, layout) ) return false;
+  uint32_t precision = layout >> 16;
+  layout &= 0xFFFFu;
+  if ( layout > static_cast<uint32_t>(Layout::kinematics)
+    || precision > static_cast<uint32_t>(Precision::single)
+    || (version < 5u && precision != 0u) ) return false;
+  header.layout = static_cast<Layout>( layout );
+  header.precision = static_cast<Precision>( precision );
+
+  return read_le( in, header.flux_avg_tot_xsec )
+    && read_le( in, header.event_count )
+    && read_le( in, header.metadata_position );
+}
+
+void marley::BinaryEventBlock::write_metadata(std::ostream& out,
+  const std::string& json_text)
+{
+  write_le( out, static_cast<uint32_t>(RecordTag::metadata) );
+  write_le( out, static_cast<uint64_t>(json_text.size()) );
+  out.write( json_text.data(), json_text.size() );
+}
+
+bool marley::BinaryEventBlock::read_metadata(std::istream& in,
+  std::string& json_text)
+{
+  uint64_t size;
+  if ( !read_le(in, size) ) return false;
+  json_text.resize( size );
+  in.read( &json_text[0], size );
+  return static_cast<bool>( in );
+}
+
+bool marley::BinaryEventBlock::read_tag(std::istream& in, RecordTag& tag) {
+  uint32_t value;
+  if ( !read_le(in, value) ) return false;
+  tag = static_cast<RecordTag>( value );
+  return true;
+}
+
+void marley::BinaryEventBlock::write(std::ostream& out,
+  Precision precision) const
+{
+  write_le( out, static_cast<uint32_t>(RecordTag::events) );
+  write_le( out, static_cast<uint32_t>(Exs_.size()) );
+  write_le( out, static_cast<uint32_t>(pdgs_.size()) );
+
+  write_column( out, Exs_ );
+  write_column( out, twoJs_ );
+  write_column( out, parities_ );
+  write_column( out, num_initials_ );
+  write_column( out, num_finals_ );
+  write_column( out, weights_ );
+  write_column( out, times_ );
+
+  write_column( out, pdgs_ );
+
+  if ( precision == Precision::full ) {
+    write_column( out, Es_ );
+    write_column( out, pxs_ );
+    write_column( out, pys_ );
+    write_column( out, pzs_ );
+    write_column( out, masses_ );
+    write_column( out, charges_ );
+    return;
+  }
+
+  // Convert the kinetic energies and 3-momenta to single precision. The
+  // kinetic energies are computed using the stored masses, which allows the
+  // total energies to be recovered exactly (up to rounding of the kinetic
+  // energy) whenever the masses are.
+  size_t num_particles = pdgs_.size();
+  std::vector<float> values( num_particles );
+  auto write_floats = [&out, &values, num_particles](
+    const std::vector<double>& column, const std::vector<double>* subtract)
+  {
+    for ( size_t p = 0u; p < num_particles; ++p ) {
+      double value = column[ p ];
+      if ( subtract ) value -= ( *subtract )[ p ];
+      values[ p ] = static_cast<float>( value );
+    }
+    write_column( out, values );
+  };
+  write_floats( Es_, &masses_ );
+  write_floats( pxs_, nullptr );
+  write_floats( pys_, nullptr );
+  write_floats( pzs_, nullptr );
+  write_column( out, charges_ );
+
+  // Store any masses that differ from the tabulated values
+  TableMasses table;
+  std::vector<uint32_t> mass_indices;
+  std::vector<double> extra_masses;
+  for ( size_t p = 0u; p < num_particles; ++p ) {
+    if ( table.get(pdgs_[p], charges_[p]) == masses_[p] ) continue;
+    mass_indices.push_back( static_cast<uint32_t>(p) );
+    extra_masses.push_back( masses_[p] );
+  }
+  write_le( out, static_cast<uint32_t>(mass_indices.size()) );
+  write_column( out, mass_indices );
+  write_column( out, extra_masses );
+}
+
+bool marley::BinaryEventBlock::skip(std::istream& in, uint32_t& num_events,
+  uint32_t format_version, Precision precision)
+{
+  uint32_t num_particles;
+  if ( !read_le(in, num_events) || !read_le(in, num_particles)
+    || num_events > MAX_BLOCK_ENTRIES || num_particles > MAX_BLOCK_ENTRIES )
+  {
+    return false;
+  }
+
+  // Seven event columns (three doubles and four 32-bit integers) and the
+  // particle columns (the kinematics and two 32-bit integers). Version 1 of
+  // the format lacks the event weight column, and versions 1 and 2 lack
+  // the event time column.
+  size_t num_event_doubles = 1u;
+  if ( format_version >= 2u ) ++num_event_doubles;
+  if ( format_version >= 3u ) ++num_event_doubles;
+  std::streamoff body_size = static_cast<std::streamoff>( num_events )
+    * ( num_event_doubles*sizeof(double) + 4u*sizeof(int32_t) )
+    + static_cast<std::streamoff>( num_particles )
+    * ( particle_kinematics_size(precision) + 2u*sizeof(int32_t) );
+
+  in.seekg( body_size, std::ios::cur );
+  if ( precision == Precision::full ) return static_cast<bool>( in );
+
+  // Skip the list of masses that differ from the tabulated values
+  uint32_t num_masses;
+  if ( !read_le(in, num_masses) || num_masses > num_particles ) return false;
+  in.seekg( static_cast<std::streamoff>(num_masses)
+    * ( sizeof(uint32_t) + sizeof(double) ), std::ios::cur );
+  return static_cast<bool>( in );
+}
+
+bool marley::BinaryEventBlock::read(std::istream& in,
+  uint32_t format_version, Precision precision)
+{
+  this->clear();
+
+  uint32_t num_events, num_particles;
+  if ( !read_le(in, num_events) || !read_le(in, num_particles)
+    || num_events > MAX_BLOCK_ENTRIES || num_particles > MAX_BLOCK_ENTRIES )
+  {
+    return false;
+  }
+
+  bool ok = read_column( in, Exs_, num_events )
+    && read_column( in, twoJs_, num_events )
+    && read_column( in, parities_, num_events )
+    && read_column( in, num_initials_, num_events )
+    && read_column( in, num_finals_, num_events );
+
+  if ( format_version >= 2u ) {
+    ok = ok && read_column( in, weights_, num_events );
+  }
+  else weights_.assign( num_events, 1. );
+
+  if ( format_version >= 3u ) {
+    ok = ok && read_column( in, times_, num_events );
+  }
+  else times_.assign( num_events, 0. );
+
+  ok = ok && read_column( in, pdgs_, num_particles );
+
+  if ( precision == Precision::full ) {
+    ok = ok && read_column( in, Es_, num_particles )
+      && read_column( in, pxs_, num_particles )
+      && read_column( in, pys_, num_particles )
+      && read_column( in, pzs_, num_particles )
+      && read_column( in, masses_, num_particles )
+      && read_column( in, charges_, num_particles );
+  }
+  else ok = ok && this->read_single_precision( in, num_particles );
+
+  if ( !ok ) {
+    this->clear();
+    return false;
+  }
+
+  // Locate the first particle of each event, checking that the particle
+  // counts are consistent with the size of the particle columns
+  size_t first = 0u;
+  for ( uint32_t e = 0u; e < num_events; ++e ) {
+    first_particles_.push_back( first );
+    if ( num_initials_[e] < 2 || num_finals_[e] < 2 ) ok = false;
+    first += num_initials_[e] + num_finals_[e];
+  }
+
+  if ( !ok || first != num_particles ) {
+    this->clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool marley::BinaryEventBlock::read_single_precision(std::istream& in,
+  uint32_t num_particles)
+{
+  // Kinetic energies (stored temporarily in Es_) and 3-momenta
+  std::vector<float> values;
+  auto read_floats = [&in, &values, num_particles](
+    std::vector<double>& column) -> bool
+  {
+    if ( !read_column(in, values, num_particles) ) return false;
+    column.assign( values.cbegin(), values.cend() );
+    return true;
+  };
+
+  uint32_t num_masses;
+  if ( !read_floats(Es_) || !read_floats(pxs_) || !read_floats(pys_)
+    || !read_floats(pzs_) || !read_column(in, charges_, num_particles)
+    || !read_le(in, num_masses) || num_masses > num_particles )
+  {
+    return false;
+  }
+
+  std::vector<uint32_t> mass_indices;
+  std::vector<double> extra_masses;
+  if ( !read_column(in, mass_indices, num_masses)
+    || !read_column(in, extra_masses, num_masses) ) return false;
+
+  // Look up the remaining masses, then recover the total energies
+  masses_.assign( num_particles, std::numeric_limits<double>::quiet_NaN() );
+  for ( uint32_t m = 0u; m < num_masses; ++m ) {
+    if ( mass_indices[m] >= num_particles ) return false;
+    masses_[ mass_indices[m] ] = extra_masses[ m ];
+  }
+
+  TableMasses table;
+  for ( uint32_t p = 0u; p < num_particles; ++p ) {
+    if ( std::isnan(masses_[p]) ) {
+      masses_[p] = table.get( pdgs_[p], charges_[p] );
+      if ( std::isnan(masses_[p]) ) return false;
+    }
+    Es_[p] += masses_[p];
+  }
+
+  return true;
+}
+
+void marley::KinematicsBlock::add_event(const marley::Event& ev) {
+
+  const auto& finals = ev.get_final_particles();
+  num_finals_.push_back( static_cast<int32_t>(finals.size()) );
+  weights_.push_back( ev.weight() );
+  times_.push_back( ev.time() );
+
+  for ( const auto& p : finals ) {
+    pdgs_.push_back( p.pdg_code() );
+    Es_.push_back( p.total_energy() );
+    pxs_.push_back( p.px() );
+    pys_.push_back( p.py() );
+    pzs_.push_back( p.pz() );
+  }
+}
+
+void marley::KinematicsBlock::append(const marley::EventBatch& batch,
+  size_t first, size_t count)
+{
+  if ( first > batch.size() || count > batch.size() - first ) {
+    throw marley::Error( "Invalid event range passed to"
+      " marley::KinematicsBlock::append()" );
+  }
+
+  for ( size_t e = first; e < first + count; ++e ) {
+    int num_final = batch.num_final( e );
+    num_finals_.push_back( num_final );
+    weights_.push_back( batch.weights()[e] );
+    times_.push_back( batch.times()[e] );
+
+    size_t begin = batch.first_final_particle( e );
+    size_t end = begin + num_final;
+    pdgs_.insert( pdgs_.end(), batch.pdgs().begin() + begin,
+      batch.pdgs().begin() + end );
+    Es_.insert( Es_.end(), batch.Es().begin() + begin,
+      batch.Es().begin() + end );
+    pxs_.insert( pxs_.end(), batch.pxs().begin() + begin,
+      batch.pxs().begin() + end );
+    pys_.insert( pys_.end(), batch.pys().begin() + begin,
+      batch.pys().begin() + end );
+    pzs_.insert( pzs_.end(), batch.pzs().begin() + begin,
+      batch.pzs().begin() + end );
+  }
+}
+
+void marley::KinematicsBlock::clear() {
+  num_finals_.clear();
+  weights_.clear();
+  times_.clear();
+  pdgs_.clear();
+  Es_.clear();
+  pxs_.clear();
+  pys_.clear();
+  pzs_.clear();
+}
+
+void marley::KinematicsBlock::write(std::ostream& out) const {
+  using RecordTag = marley::BinaryEventBlock::RecordTag;
+  write_le( out, static_cast<uint32_t>(RecordTag::kinematics) );
+  write_le( out, static_cast<uint32_t>(num_finals_.size()) );
+  write_le( out, static_cast<uint32_t>(pdgs_.size()) );
+
+  write_column( out, num_finals_ );
+  write_column( out, weights_ );
+  write_column( out, times_ );
+
+  write_column( out, pdgs_ );
+  write_column( out, Es_ );
+  write_column( out, pxs_ );
+  write_column( out, pys_ );
+  write_column( out, pzs_ );
+}
+
+bool marley::KinematicsBlock::skip(std::istream& in, uint32_t& num_events)
+{
+  uint32_t num_particles;
+  if ( !read_le(in, num_events) || !read_le(in, num_particles)
+    || num_events > MAX_BLOCK_ENTRIES || num_particles > MAX_BLOCK_ENTRIES )
+  {
+    return false;
+  }
+
+  // Three event columns (two doubles and one 32-bit integer) and five
+  // particle columns (four doubles and one 32-bit integer)
+  std::streamoff body_size = static_cast<std::streamoff>( num_events )
+    * ( 2u*sizeof(double) + sizeof(int32_t) )
+    + static_cast<std::streamoff>( num_particles )
+    * ( 4u*sizeof(double) + sizeof(int32_t) );
+
+  in.seekg( body_size, std::ios::cur );
+  return static_cast<bool>( in );
+}
@@ -19,6 +19,8 @@
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <mutex>
 
 // FFTPACK4 includes
 #include "fftpack4/fftpack4.h"
@@ -26,79 +28,90 @@
 
 // MARLEY includes
 #include "marley/ChebyshevInterpolatingFunction.hh"
+#include "marley/Error.hh"
 
 namespace {
-  constexpr double MY_EPSILON = std::numeric_limits<double>::epsilon();
-}
 
-marley::ChebyshevInterpolatingFunction::ChebyshevInterpolatingFunction(
-  const std::function<double(double)>& func, double x_min, double x_max,
-  size_t N)
-  : x_min_( x_min ), x_max_( x_max )
-{
-  bool ok;
+  constexpr double MY_EPSILON = std::numeric_limits<double>::epsilon();
 
-  if ( N != 0 ) {
-    ok = true;
-    N_ = N;
-  }
-  else {
-    ok = false;
-    N_ = 1;
+  // Helper arrays prepared by FFTPACK4 for discrete cosine transforms of a
+  // particular size
+  struct CosineTransformPlan {
+    std::vector<double> wsave;
+    std::vector<int> ifac;
+  };
+
+  // Returns the plan for discrete cosine transforms of the given size,
+  // creating it the first time that it is needed. Only a few sizes are used
+  // in practice, so the plans are shared by all threads and never deleted.
+  // They are not modified after creation.
+  const CosineTransformPlan& get_cosine_transform_plan( int size ) {
+    static std::mutex plan_mutex;
+    static std::map<int, std::unique_ptr<CosineTransformPlan> > plans;
+
+    std::lock_guard<std::mutex> lock( plan_mutex );
+    auto& plan = plans[ size ];
+    if ( !plan ) {
+      plan = std::make_unique<CosineTransformPlan>();
+      plan->wsave.assign( 3*size + 15, 0. );
+      plan->ifac.assign( std::max(size / 2, 15), 0 );
+      costi( &size, plan->wsave.data(), plan->ifac.data() );
+    }
+    return *plan;
   }
 
-  // Adaptively find a good grid size
-  // @todo add more explanation
-  do {
+  // Replaces the contents of a vector with its discrete cosine transform
+  void cosine_transform( std::vector<double>& data ) {
+    marley::chebyshev_cosine_transform( data.data(), data.size() );
+  }
+}
 
-    if ( !ok ) N_ *= 2;
+void marley::chebyshev_cosine_transform( double* data, size_t n ) {
+  int size = n;
+  const CosineTransformPlan& plan = get_cosine_transform_plan( size );
 
-    //std::cout << "N = " << N_ << '\n';
+  // FFTPACK4 uses part of the wsave array as working storage, so each
+  // thread transforms using its own copy of the shared plan. The ifac
+  // array is only read.
+  thread_local std::vector<double> wsave;
+  wsave.assign( plan.wsave.cbegin(), plan.wsave.cend() );
+  cost( &size, data, wsave.data(), const_cast<int*>( plan.ifac.data() ) );
+}
 
-    // @todo optimize this
-    Xs_.clear();
-    Fs_.clear();
+bool marley::ChebyshevInterpolatingFunction::compute_coefficients() {
 
-    for ( size_t j = 0; j <= N_; ++j ) {
-      double x = chebyshev_point( j );
-      double f = func(x);
-      Xs_.push_back( x );
-      Fs_.push_back( f );
-    }
+  chebyshev_coeffs_ = Fs_;
+  cosine_transform( chebyshev_coeffs_ );
 
-    chebyshev_coeffs_ = Fs_;
-    wsave_ = std::vector<double>(3*Fs_.size() + 15, 0.);
-    ifac_ = std::vector<int>(Fs_.size() / 2, 0);
+  double biggest_coeff = *std::max_element(chebyshev_coeffs_.cbegin(),
+    chebyshev_coeffs_.cend(), [](double left, double right) -> double
+    { return std::abs(left) < std::abs(right); });
 
-    int my_size = Fs_.size();
-    costi( &my_size, wsave_.data(), ifac_.data() );
-    cost( &my_size, chebyshev_coeffs_.data(), wsave_.data(), ifac_.data() );
+  double upper_limit = 2. * std::abs( biggest_coeff ) * MY_EPSILON;
 
-    double biggest_coeff = *std::max_element(chebyshev_coeffs_.cbegin(),
-      chebyshev_coeffs_.cend(), [](double left, double right) -> double
-      { return std::abs(left) < std::abs(right); });
-
-    double upper_limit = 2. * std::abs( biggest_coeff ) * MY_EPSILON;
+  double last_coeff_mag = std::abs( chebyshev_coeffs_.back() );
+  double next_to_last_coeff_mag = std::abs(
+    chebyshev_coeffs_.at( chebyshev_coeffs_.size() - 2 ));
+  if ( last_coeff_mag < upper_limit && next_to_last_coeff_mag < upper_limit )
+  {
+    return true;
+  }
 
-    double last_coeff_mag = std::abs( chebyshev_coeffs_.back() );
-    double next_to_last_coeff_mag = std::abs(
-      chebyshev_coeffs_.at( chebyshev_coeffs_.size() - 2 ));
-    if ( last_coeff_mag < upper_limit && next_to_last_coeff_mag < upper_limit )
-    {
-      ok = true;
-    }
+  if ( N_ >= N_MAX_ ) {
+    /// @todo PRINT WARNING MESSAGE
+    return true;
+  }
 
-    if ( N_ >= N_MAX_ ) {
-      /// @todo PRINT WARNING MESSAGE
-      ok = true;
-    }
+  return false;
+}
 
-  } while ( !ok );
+void marley::ChebyshevInterpolatingFunction::finish_construction() {
 
   // Normalize the Chebyshev coefficients by dividing by N
   for (double& d : chebyshev_coeffs_) d /= N_;
 
   compute_integral();
+  compute_weights();
 }
 
 void marley::ChebyshevInterpolatingFunction::compute_integral() {
@@ -154,15 +167,134 @@ marley::ChebyshevInterpolatingFunction
     result.Xs_.push_back( x );
   }
 
-  result.wsave_ = std::vector<double>(
-    3*result.chebyshev_coeffs_.size() + 15, 0.);
-  result.ifac_ = std::vector<int>(result.chebyshev_coeffs_.size() / 2, 0);
-
-  int my_size = result.chebyshev_coeffs_.size();
   result.Fs_ = result.chebyshev_coeffs_;
-  costi( &my_size, result.wsave_.data(), result.ifac_.data() );
-  cost( &my_size, result.Fs_.data(), result.wsave_.data(), result.ifac_.data() );
+  cosine_transform( result.Fs_ );
   for (double& d : result.Fs_) d *= 0.5;
 
+  result.compute_weights();
+
+  // Keep a copy of the original function so that it may be used as the
+  // derivative of the CDF during inversion
+  result.pdf_ = std::make_shared<marley::ChebyshevInterpolatingFunction>(
+    *this );
+  result.build_inverse_table();
+
   return result;
 }
+
+void marley::ChebyshevInterpolatingFunction::build_inverse_table() {
+
+  // The Chebyshev points are stored in descending order, so reverse them.
+  // Enforce monotonicity of the tabulated CDF values (small violations can
+  // occur due to the polynomial approximation).
+  size_t num_points = N_ + 1;
+  inv_xs_.resize( num_points );
+  inv_cdfs_.resize( num_points );
+
+  double running_max = 0.;
+  for ( size_t i = 0u; i < num_points; ++i ) {
+    size_t j = num_points - 1u - i;
+    inv_xs_[ i ] = Xs_[ j ];
+    running_max = std::max( running_max, Fs_[ j ] );
+    inv_cdfs_[ i ] = running_max;
+  }
+  inv_xs_.front() = x_min_;
+  inv_xs_.back() = x_max_;
+  inv_cdfs_.front() = 0.;
+
+  // Build the guide table using one entry per grid point
+  size_t num_guides = num_points;
+  guide_.resize( num_guides );
+
+  double norm = inv_cdfs_.back();
+  size_t i = 0u;
+  for ( size_t k = 0u; k < num_guides; ++k ) {
+    double c = norm * k / num_guides;
+    while ( i + 2u < num_points && inv_cdfs_[ i + 1u ] <= c ) ++i;
+    guide_[ k ] = i;
+  }
+}
+
+double marley::ChebyshevInterpolatingFunction::inverse_cdf(double prob,
+  double tolerance) const
+{
+  if ( !pdf_ ) throw marley::Error( "Cannot invert a"
+    " ChebyshevInterpolatingFunction that was not created using cdf()" );
+
+  if ( prob <= 0. ) return x_min_;
+  else if ( prob >= 1. ) return x_max_;
+
+  // Find the grid interval containing the target CDF value using the
+  // guide table
+  double norm = inv_cdfs_.back();
+  double target = prob * norm;
+
+  size_t num_guides = guide_.size();
+  size_t k = std::min( static_cast<size_t>(prob * num_guides),
+    num_guides - 1u );
+  size_t i = guide_[ k ];
+  size_t last = inv_cdfs_.size() - 2u;
+  while ( i < last && inv_cdfs_[ i + 1u ] <= target ) ++i;
+
+  double a = inv_xs_[ i ];
+  double b = inv_xs_[ i + 1u ];
+  double ca = inv_cdfs_[ i ];
+  double cb = inv_cdfs_[ i + 1u ];
+
+  // Initial guess from linear interpolation between the grid points
+  double x = a;
+  if ( cb > ca ) x = a + ( b - a ) * ( target - ca ) / ( cb - ca );
+
+  // Refine the guess using Newton's method, falling back to bisection
+  // whenever a step would leave the bracketing interval
+  constexpr int MAX_ITERATIONS = 100;
+  for ( int iter = 0; iter < MAX_ITERATIONS; ++iter ) {
+
+    double residual = this->evaluate( x ) - target;
+    if ( residual == 0. ) return x;
+    else if ( residual > 0. ) b = x;
+    else a = x;
+
+    double deriv = pdf_->evaluate( x );
+    double x_new;
+    if ( deriv > 0. ) x_new = x - residual / deriv;
+    else x_new = a - 1.; // Force bisection
+
+    if ( x_new <= a || x_new >= b ) x_new = ( a + b ) / 2.;
+
+    if ( std::abs( x_new - x ) <= tolerance || ( b - a ) <= tolerance ) {
+      return x_new;
+    }
+    x = x_new;
+  }
+
+  return x;
+}
+
+void marley::ChebyshevInterpolatingFunction::compute_weights() {
+  // The barycentric weights for Chebyshev points of the second kind
+  // alternate in sign and are halved at the two endpoints
+  Ws_.resize( N_ + 1 );
+  double w_j = -1.;
+  for ( size_t j = 0; j <= N_; ++j ) {
+    w_j = -w_j; // w_j = (-1)^(j)
+    Ws_[ j ] = w_j;
+    if ( j == 0 || j == N_ ) Ws_[ j ] /= 2.;
+  }
+}
+
+void marley::ChebyshevInterpolatingFunction::evaluate_batch(const double* x,
+  double* out, size_t n) const
+{
+  for ( size_t i = 0u; i < n; ++i ) out[ i ] = this->evaluate( x[ i ] );
+}
+
+size_t marley::ChebyshevInterpolatingFunction::memory_usage() const {
+  using marley_utils::vector_bytes;
+  size_t bytes = vector_bytes( Xs_ ) + vector_bytes( Fs_ )
+    + vector_bytes( Ws_ ) + vector_bytes( inv_xs_ )
+    + vector_bytes( inv_cdfs_ ) + vector_bytes( guide_ )
+    + vector_bytes( chebyshev_coeffs_ );
+  if ( pdf_ ) bytes += sizeof( *pdf_ ) + pdf_->memory_usage();
+  return bytes;
+}
@@ -0,0 +1,277 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <algorithm>
+#include <cmath>
+
+#include "marley/marley_utils.hh"
+#include "marley/CoherentReaction.hh"
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/MassTable.hh"
+#include "marley/MatrixElement.hh"
+#include "marley/NuclearReaction.hh"
+#include "marley/StructureDatabase.hh"
+
+namespace {
+
+  // Helm form factor parameters (fm) from J. D. Lewin and P. F. Smith,
+  // Astropart. Phys. 6, 87 (1996)
+  constexpr double HELM_S = 0.9; // skin thickness
+  constexpr double HELM_A = 0.52;
+  constexpr double HELM_C1 = 1.23;
+  constexpr double HELM_C0 = -0.6;
+
+  // Below this value of x = q*R0, use a series expansion for 3*j1(x)/x
+  // to avoid roundoff error
+  constexpr double HELM_SMALL_X = 1e-3;
+
+}
+
+marley::CoherentReaction::CoherentReaction(int pdg_a, int pdg_b,
+  double strength)
+{
+  process_type_ = ProcessType::NC;
+
+  pdg_a_ = pdg_a;
+  pdg_b_ = pdg_b;
+  pdg_c_ = get_ejectile_pdg( pdg_a_, process_type_ );
+  pdg_d_ = pdg_b;
+
+  int Z = marley_utils::get_particle_Z( pdg_b_ );
+  int A = marley_utils::get_particle_A( pdg_b_ );
+
+  // Set the description string based on the particle PDG codes. Use the
+  // same format as marley::NuclearReaction for a ground-state transition.
+  std::string nuc = std::to_string( A )
+    + marley_utils::element_symbols.at( Z );
+  description_ = marley_utils::get_particle_symbol( pdg_a_ ) + " + " + nuc;
+  description_ += " --> " + marley_utils::get_particle_symbol( pdg_c_ );
+  description_ += " + " + nuc;
+
+  // Use the same mass conventions as marley::NuclearReaction. The target
+  // is an atom if its PDG code is greater than 10^9.
+  const auto& mt = marley::MassTable::Instance();
+  ma_ = mt.get_particle_mass( pdg_a_ );
+  mc_ = mt.get_particle_mass( pdg_c_ );
+  if ( pdg_b_ > 1000000000 ) mb_ = mt.get_atomic_mass( pdg_b_ );
+  else mb_ = mt.get_particle_mass( pdg_b_ );
+  md_ = mb_;
+
+  // Weak nuclear charge Q_W = N - (1 - 4*sin^2(theta_W))*Z
+  double Qw = ( A - Z ) - ( 1. - 4.*marley_utils::sin2thetaw )*Z;
+  strength_factor_ = strength * 0.25 * std::pow( Qw, 2 );
+
+  // Helm form factor parameters in natural units (MeV^(-1))
+  double c = HELM_C1*std::cbrt( A ) + HELM_C0;
+  double R0_2 = c*c + (7./3.)*std::pow( marley_utils::pi*HELM_A, 2 )
+    - 5.*HELM_S*HELM_S;
+  helm_R0_ = marley_utils::real_sqrt( R0_2 ) / marley_utils::hbar_c;
+  helm_s_ = HELM_S / marley_utils::hbar_c;
+
+  // CEvNS leaves the nucleus in its ground state
+  marley::StructureDatabase::get_gs_spin_parity( pdg_b_, twoJ_gs_, P_gs_ );
+}
+
+std::unique_ptr<marley::CoherentReaction>
+  marley::CoherentReaction::from_nuclear_reaction(
+  const marley::NuclearReaction& nr)
+{
+  if ( nr.process_type() != ProcessType::NC ) return nullptr;
+
+  const auto& mes = nr.matrix_elements();
+  if ( mes.size() != 1u ) return nullptr;
+
+  const auto& me = mes.front();
+  if ( me.type() != marley::MatrixElement::TransitionType::FERMI
+    || me.level_energy() != 0. ) return nullptr;
+
+  return std::unique_ptr<marley::CoherentReaction>(
+    new marley::CoherentReaction(nr.pdg_a(), nr.pdg_b(), me.strength()) );
+}
+
+double marley::CoherentReaction::point_total_xs(double KEa,
+  double& beta_c_cm, double& pc_cm) const
+{
+  double s, Ec_cm, Ed_cm;
+  two_two_scatter( KEa, s, Ec_cm, pc_cm, Ed_cm );
+  beta_c_cm = pc_cm / Ec_cm;
+
+  double Eb_cm = ( s + mb_*mb_ - ma_*ma_ ) / ( 2. * std::sqrt(s) );
+
+  // Allowed approximation NC cross section for a Fermi transition. This
+  // matches the expression used by marley::NuclearReaction.
+  return ( marley_utils::GF2 / marley_utils::pi ) * ( Eb_cm * Ed_cm / s )
+    * Ec_cm * pc_cm * strength_factor_;
+}
+
+double marley::CoherentReaction::total_xs(int pdg_a, double KEa) const {
+
+  // If the cross section was requested for a different projectile,
+  // then just return zero.
+  if ( pdg_a != pdg_a_ || KEa < 0. ) return 0.;
+
+  double beta_c_cm, pc_cm;
+  double xs = point_total_xs( KEa, beta_c_cm, pc_cm );
+  if ( form_factor_ == FormFactor::NONE ) return xs;
+
+  // Average the squared form factor over the (normalized) angular
+  // distribution of the ejectile
+  double two_pc2 = 2. * pc_cm * pc_cm;
+  double ff2_avg = marley_utils::num_integrate( [=](double x) -> double {
+      return 0.5 * ( 1. + beta_c_cm*x )
+        * this->form_factor_squared( two_pc2 * (1. - x) );
+    }, -1., 1. );
+
+  return xs * ff2_avg;
+}
+
+double marley::CoherentReaction::total_xs(int, double, double, double,
+  double) const
+{
+  return 0.;
+}
+
+double marley::CoherentReaction::diff_xs(int pdg_a, double KEa,
+  double cos_theta_c_cm) const
+{
+  if ( pdg_a != pdg_a_ || KEa < 0. ) return 0.;
+  if ( std::abs(cos_theta_c_cm) > 1. ) return 0.;
+
+  double beta_c_cm, pc_cm;
+  double diff_xsec = 0.5 * point_total_xs( KEa, beta_c_cm, pc_cm )
+    * ( 1. + beta_c_cm*cos_theta_c_cm );
+
+  if ( form_factor_ != FormFactor::NONE ) {
+    diff_xsec *= form_factor_squared( 2. * pc_cm * pc_cm
+      * (1. - cos_theta_c_cm) );
+  }
+
+  return diff_xsec;
+}
+
+double marley::CoherentReaction::form_factor_squared(double q2) const {
+  if ( form_factor_ == FormFactor::NONE ) return 1.;
+
+  // Helm form factor F(q) = 3*j1(q*R0)/(q*R0) * exp(-(q*s)^2 / 2)
+  double x = std::sqrt( std::max(0., q2) ) * helm_R0_;
+  double x2 = x * x;
+  double f;
+  if ( x < HELM_SMALL_X ) f = 1. - x2 / 10.;
+  else f = 3. * ( std::sin(x) - x*std::cos(x) ) / ( x2 * x );
+  f *= std::exp( -0.5 * q2 * helm_s_ * helm_s_ );
+
+  return f * f;
+}
+
+double marley::CoherentReaction::sample_cos_theta_c_cm(double beta_c_cm,
+  double pc_cm, marley::Generator& gen) const
+{
+  double two_pc2 = 2. * pc_cm * pc_cm;
+  while ( true ) {
+    // Invert the CDF of the linear pdf(x) = (1 + a*x) / 2 on [-1, 1], with
+    // a = beta_c_cm. See marley::NuclearReaction::sample_cos_theta_c_cm().
+    double u = gen.uniform_random_double( 0., 1., true );
+    double c = 2. - beta_c_cm - 4.*u;
+    double x = -c / ( 1. + std::sqrt(std::max(0., 1. - beta_c_cm*c)) );
+    x = std::min( 1., std::max( -1., x ) );
+
+    // The squared form factor never exceeds one, so use it directly as
+    // an acceptance probability
+    if ( form_factor_ == FormFactor::NONE ) return x;
+    double ff2 = form_factor_squared( two_pc2 * (1. - x) );
+    if ( gen.uniform_random_double( 0., 1., true ) <= ff2 ) return x;
+  }
+}
+
+marley::Event marley::CoherentReaction::create_event(int pdg_a, double KEa,
+  marley::Generator& gen) const
+{
+  marley::Event ev;
+  this->create_event( pdg_a, KEa, gen, ev );
+  return ev;
+}
+
+marley::Event marley::CoherentReaction::create_event(int, double, double,
+  double, double, marley::Generator&) const
+{
+  throw marley::Error("Dark matter events cannot be created by"
+    " marley::CoherentReaction");
+}
+
+void marley::CoherentReaction::create_event(int pdg_a, double KEa,
+  marley::Generator& gen, marley::Event& ev) const
+{
+  // If the projectile's PDG code doesn't match that stored in this object,
+  // complain and refuse to create an event.
+  if ( pdg_a != pdg_a_ ) throw marley::Error("Could"
+    " not create this event. The requested projectile PDG code "
+    + std::to_string(pdg_a) + " does not match the value "
+    + std::to_string(pdg_a_) + " stored in the Reaction object.");
+
+  double s, Ec_cm, pc_cm, Ed_cm;
+  two_two_scatter( KEa, s, Ec_cm, pc_cm, Ed_cm );
+
+  double cos_theta_c_cm = sample_cos_theta_c_cm( pc_cm / Ec_cm, pc_cm, gen );
+  double phi_c_cm = gen.uniform(0., marley_utils::two_pi);
+
+  // The residue is left in its ground state, so the event is complete
+  // as soon as it is created
+  make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm, Ec_cm, Ed_cm,
+    0., twoJ_gs_, P_gs_, ev );
+}
+
+marley::CoherentReaction::Recoil marley::CoherentReaction::sample_recoil(
+  double KEa, marley::Generator& gen) const
+{
+  double s, Ec_cm, pc_cm, Ed_cm;
+  two_two_scatter( KEa, s, Ec_cm, pc_cm, Ed_cm );
+
+  double cos_theta_c_cm = sample_cos_theta_c_cm( pc_cm / Ec_cm, pc_cm, gen );
+  double phi_c_cm = gen.uniform(0., marley_utils::two_pi);
+
+  // Boost the recoiling nucleus from the CM frame (where it travels opposite
+  // the ejectile) to the lab frame along the projectile direction
+  double Ea = KEa + ma_;
+  double beta = marley_utils::real_sqrt( Ea*Ea - ma_*ma_ ) / ( Ea + mb_ );
+  double gamma = 1. / std::sqrt( 1. - beta*beta );
+
+  double pz_cm = -pc_cm * cos_theta_c_cm;
+  double pt = pc_cm * marley_utils::real_sqrt( 1. - std::pow(cos_theta_c_cm,
+    2) );
+  double pz = gamma * ( pz_cm + beta*Ed_cm );
+  double p = std::sqrt( pz*pz + pt*pt );
+
+  Recoil rec;
+  rec.KEa = KEa;
+  // For elastic scattering, the lab-frame recoil kinetic energy is
+  // exactly -t / (2*md). Using this form avoids cancellation between
+  // the recoil total energy and its mass.
+  rec.KE_recoil = pc_cm * pc_cm * ( 1. - cos_theta_c_cm ) / md_;
+  rec.cos_theta_recoil = ( p > 0. ) ? pz / p : 1.;
+  rec.phi_recoil = std::fmod( phi_c_cm + marley_utils::pi,
+    marley_utils::two_pi );
+  return rec;
+}
+
+marley::CoherentReaction::FormFactor
+  marley::CoherentReaction::form_factor_from_string( const std::string& str )
+{
+  if ( str == "none" ) return FormFactor::NONE;
+  else if ( str == "helm" ) return FormFactor::HELM;
+  else throw marley::Error("Unrecognized CEvNS form factor \"" + str
+    + "\" encountered in marley::CoherentReaction::form_factor_from_string()");
+}
@@ -0,0 +1,274 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <string>
+
+#ifdef USE_ZSTD
+  #include <zstd.h>
+#endif
+
+// MARLEY includes
+#include "marley/CompressedStream.hh"
+#include "marley/Error.hh"
+#include "marley/Logger.hh"
+
+namespace {
+
+  // Frame header magic number bytes for Zstandard-compressed data
+  constexpr unsigned char ZSTD_MAGIC[] = { 0x28, 0xB5, 0x2F, 0xFD };
+
+  #ifdef USE_ZSTD
+    void check_zstd_code(size_t code, const std::string& context) {
+      if ( ZSTD_isError(code) ) throw marley::Error("Zstandard error during "
+        + context + ": " + ZSTD_getErrorName(code));
+    }
+  #endif
+
+}
+
+bool marley::compression_available() {
+  #ifdef USE_ZSTD
+    return true;
+  #else
+    return false;
+  #endif
+}
+
+marley::CompressingStreamBuf::CompressingStreamBuf(std::streambuf* sink,
+  int level) : sink_( sink )
+{
+  #ifdef USE_ZSTD
+    if ( level < ZSTD_minCLevel() || level > ZSTD_maxCLevel() ) {
+      throw marley::Error("Invalid Zstandard compression level "
+        + std::to_string(level) + " requested. Allowed values range from "
+        + std::to_string(ZSTD_minCLevel()) + " to "
+        + std::to_string(ZSTD_maxCLevel()));
+    }
+
+    cctx_ = ZSTD_createCCtx();
+    if ( !cctx_ ) throw marley::Error("Failed to create a Zstandard"
+      " compression context");
+    check_zstd_code( ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel,
+      level), "initialization of the compressor" );
+
+    in_buffer_.resize( ZSTD_CStreamInSize() );
+    out_buffer_.resize( ZSTD_CStreamOutSize() );
+    this->setp( in_buffer_.data(), in_buffer_.data() + in_buffer_.size() );
+  #else
+    (void)level;
+    throw marley::Error("Compressed output was requested, but MARLEY was"
+      " built without Zstandard support");
+  #endif
+}
+
+marley::CompressingStreamBuf::~CompressingStreamBuf() {
+  #ifdef USE_ZSTD
+    // Avoid leaving a truncated frame behind if the owner did not call
+    // finish(). Errors cannot be reported from here, so just log them.
+    try {
+      bool pending = frame_open_ || this->pptr() != this->pbase();
+      if ( pending && !finish() ) {
+        MARLEY_LOG_WARNING() << "Failed to write the final compressed"
+          << " data block";
+      }
+    }
+    catch ( const marley::Error& ) { }
+    ZSTD_freeCCtx( cctx_ );
+  #endif
+}
+
+bool marley::CompressingStreamBuf::compress(int end_directive) {
+  #ifdef USE_ZSTD
+    auto mode = static_cast<ZSTD_EndDirective>( end_directive );
+    ZSTD_inBuffer input = { this->pbase(),
+      static_cast<size_t>(this->pptr() - this->pbase()), 0u };
+
+    bool done = false;
+    while ( !done ) {
+      ZSTD_outBuffer output = { out_buffer_.data(), out_buffer_.size(), 0u };
+      size_t remaining = ZSTD_compressStream2( cctx_, &output, &input, mode );
+      check_zstd_code( remaining, "compression" );
+
+      std::streamsize out_size = static_cast<std::streamsize>( output.pos );
+      if ( out_size > 0 && sink_->sputn(out_buffer_.data(), out_size)
+        != out_size ) return false;
+
+      // When ending a frame or flushing, zstd reports the number of bytes
+      // still waiting to be written out. Otherwise, we're done once all of
+      // the input has been consumed.
+      if ( mode == ZSTD_e_continue ) done = ( input.pos == input.size );
+      else done = ( remaining == 0u );
+    }
+
+    if ( input.size > 0u ) frame_open_ = true;
+    if ( mode == ZSTD_e_end ) frame_open_ = false;
+
+    this->setp( in_buffer_.data(), in_buffer_.data() + in_buffer_.size() );
+    return true;
+  #else
+    (void)end_directive;
+    return false;
+  #endif
+}
+
+bool marley::CompressingStreamBuf::finish() {
+  #ifdef USE_ZSTD
+    return compress( ZSTD_e_end ) && sink_->pubsync() == 0;
+  #else
+    return false;
+  #endif
+}
+
+marley::CompressingStreamBuf::int_type
+  marley::CompressingStreamBuf::overflow(int_type ch)
+{
+  #ifdef USE_ZSTD
+    if ( !compress(ZSTD_e_continue) ) return traits_type::eof();
+    if ( !traits_type::eq_int_type(ch, traits_type::eof()) ) {
+      *this->pptr() = traits_type::to_char_type( ch );
+      this->pbump( 1 );
+    }
+    return traits_type::not_eof( ch );
+  #else
+    (void)ch;
+    return traits_type::eof();
+  #endif
+}
+
+int marley::CompressingStreamBuf::sync() {
+  #ifdef USE_ZSTD
+    if ( !compress(ZSTD_e_flush) ) return -1;
+    return sink_->pubsync();
+  #else
+    return -1;
+  #endif
+}
+
+marley::DecompressingStreamBuf::DecompressingStreamBuf(
+  std::streambuf* source) : source_( source )
+{
+  #ifdef USE_ZSTD
+    dctx_ = ZSTD_createDCtx();
+    if ( !dctx_ ) throw marley::Error("Failed to create a Zstandard"
+      " decompression context");
+
+    in_buffer_.resize( ZSTD_DStreamInSize() );
+    out_buffer_.resize( ZSTD_DStreamOutSize() );
+    char* out = out_buffer_.data();
+    this->setg( out, out, out );
+  #else
+    throw marley::Error("Cannot read a Zstandard-compressed file because"
+      " MARLEY was built without Zstandard support");
+  #endif
+}
+
+marley::DecompressingStreamBuf::~DecompressingStreamBuf() {
+  #ifdef USE_ZSTD
+    ZSTD_freeDCtx( dctx_ );
+  #endif
+}
+
+bool marley::DecompressingStreamBuf::is_compressed(std::streambuf& source)
+{
+  char magic[ sizeof(ZSTD_MAGIC) ];
+  std::streamsize count = source.sgetn( magic, sizeof(magic) );
+  source.pubseekpos( 0, std::ios_base::in );
+
+  if ( count != static_cast<std::streamsize>(sizeof(magic)) ) return false;
+  for ( size_t b = 0u; b < sizeof(magic); ++b ) {
+    if ( static_cast<unsigned char>(magic[b]) != ZSTD_MAGIC[b] ) return false;
+  }
+  return true;
+}
+
+marley::DecompressingStreamBuf::int_type
+  marley::DecompressingStreamBuf::underflow()
+{
+  if ( this->gptr() < this->egptr() ) {
+    return traits_type::to_int_type( *this->gptr() );
+  }
+
+  #ifdef USE_ZSTD
+    out_offset_ += this->egptr() - this->eback();
+    char* out = out_buffer_.data();
+
+    // A single call to ZSTD_decompressStream() may consume input without
+    // producing any output, so keep going until we get some characters
+    // or run out of compressed data
+    while ( true ) {
+      if ( in_pos_ == in_size_ ) {
+        std::streamsize count = source_->sgetn( in_buffer_.data(),
+          static_cast<std::streamsize>(in_buffer_.size()) );
+        if ( count <= 0 ) break;
+        in_size_ = static_cast<size_t>( count );
+        in_pos_ = 0u;
+      }
+
+      ZSTD_inBuffer input = { in_buffer_.data(), in_size_, in_pos_ };
+      ZSTD_outBuffer output = { out, out_buffer_.size(), 0u };
+      check_zstd_code( ZSTD_decompressStream(dctx_, &output, &input),
+        "decompression" );
+      in_pos_ = input.pos;
+
+      if ( output.pos > 0u ) {
+        this->setg( out, out, out + output.pos );
+        return traits_type::to_int_type( *this->gptr() );
+      }
+    }
+
+    this->setg( out, out, out );
+  #endif
+
+  return traits_type::eof();
+}
+
+marley::DecompressingStreamBuf::pos_type
+  marley::DecompressingStreamBuf::seekoff(off_type off,
+  std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if ( (which & std::ios_base::in) && off == 0 ) {
+    if ( dir == std::ios_base::cur ) {
+      return pos_type( out_offset_ + (this->gptr() - this->eback()) );
+    }
+    else if ( dir == std::ios_base::beg ) return seekpos( 0, which );
+  }
+  return pos_type( off_type(-1) );
+}
+
+marley::DecompressingStreamBuf::pos_type
+  marley::DecompressingStreamBuf::seekpos(pos_type pos,
+  std::ios_base::openmode which)
+{
+  // Only rewinding to the start of the data is supported
+  if ( !(which & std::ios_base::in) || pos != pos_type(0) ) {
+    return pos_type( off_type(-1) );
+  }
+
+  if ( source_->pubseekpos(0, std::ios_base::in) != pos_type(0) ) {
+    return pos_type( off_type(-1) );
+  }
+
+  #ifdef USE_ZSTD
+    ZSTD_DCtx_reset( dctx_, ZSTD_reset_session_only );
+  #endif
+  in_size_ = 0u;
+  in_pos_ = 0u;
+  out_offset_ = 0;
+  char* out = out_buffer_.data();
+  this->setg( out, out, out );
+  return pos_type( 0 );
+}
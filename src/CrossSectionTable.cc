@@ -0,0 +1,139 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdio>
+#include <fstream>
+
+// MARLEY includes
+#include "marley/CrossSectionTable.hh"
+#include "marley/Error.hh"
+#include "marley/Logger.hh"
+#include "marley/marley_utils.hh"
+
+constexpr uint32_t marley::CrossSectionTable::FORMAT_VERSION;
+
+namespace {
+
+  // Identifies files written by marley::CrossSectionTable::save()
+  const std::string XS_TABLE_MAGIC = "MARLEY cross section tables";
+
+}
+
+void marley::CrossSectionTable::save( const std::string& file_name,
+  const std::vector<CrossSectionTable>& tables )
+{
+  // Write to a temporary file first so that an interrupted write never
+  // leaves a partial file behind
+  std::string temp_file_name = file_name + ".tmp";
+  std::ofstream out( temp_file_name, std::ios::binary );
+  if ( !out ) throw marley::Error( "Could not open the cross section table"
+    " file " + temp_file_name + " for writing" );
+
+  out.write( XS_TABLE_MAGIC.data(), XS_TABLE_MAGIC.size() );
+  marley_utils::write_binary( out, FORMAT_VERSION );
+  marley_utils::write_binary( out, std::string(MARLEY_VERSION) );
+  marley_utils::write_binary( out, static_cast<uint64_t>(tables.size()) );
+
+  for ( const auto& table : tables ) table.write( out );
+
+  out.close();
+  if ( !out ) throw marley::Error( "Failed to write the cross section table"
+    " file " + temp_file_name );
+
+  if ( std::rename(temp_file_name.c_str(), file_name.c_str()) != 0 ) {
+    throw marley::Error( "Could not rename " + temp_file_name + " to "
+      + file_name + " while saving the cross section tables" );
+  }
+}
+
+bool marley::CrossSectionTable::load( const std::string& file_name,
+  std::vector<CrossSectionTable>& tables )
+{
+  tables.clear();
+
+  std::ifstream in( file_name, std::ios::binary );
+  if ( !in ) {
+    MARLEY_LOG_WARNING() << "Could not open the cross section table file "
+      << file_name;
+    return false;
+  }
+
+  std::string magic( XS_TABLE_MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+
+  uint32_t format_version;
+  std::string version;
+  uint64_t num_tables;
+  if ( !in || magic != XS_TABLE_MAGIC
+    || !marley_utils::read_binary(in, format_version)
+    || format_version != FORMAT_VERSION
+    || !marley_utils::read_binary(in, version)
+    || !marley_utils::read_binary(in, num_tables) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring invalid cross section table file "
+      << file_name;
+    return false;
+  }
+
+  if ( version != MARLEY_VERSION ) {
+    MARLEY_LOG_WARNING() << "Ignoring the cross section table file "
+      << file_name << ", which was written by MARLEY version " << version;
+    return false;
+  }
+
+  for ( uint64_t t = 0u; t < num_tables; ++t ) {
+    CrossSectionTable table;
+    if ( !table.read(in) ) {
+      MARLEY_LOG_WARNING() << "Ignoring invalid cross section table file "
+        << file_name;
+      tables.clear();
+      return false;
+    }
+    tables.push_back( std::move(table) );
+  }
+
+  return true;
+}
+
+void marley::CrossSectionTable::write( std::ostream& out ) const {
+  marley_utils::write_binary( out, description );
+  marley_utils::write_binary( out, pdg_a );
+  marley_utils::write_binary( out, pdg_b );
+  marley_utils::write_binary( out, pdg_c );
+  marley_utils::write_binary( out, pdg_d );
+  marley_utils::write_binary( out, KEs );
+  marley_utils::write_binary( out, totals );
+  marley_utils::write_binary( out, level_energies );
+  marley_utils::write_binary( out, level_xsecs );
+}
+
+bool marley::CrossSectionTable::read( std::istream& in ) {
+  bool ok = marley_utils::read_binary( in, description )
+    && marley_utils::read_binary( in, pdg_a )
+    && marley_utils::read_binary( in, pdg_b )
+    && marley_utils::read_binary( in, pdg_c )
+    && marley_utils::read_binary( in, pdg_d )
+    && marley_utils::read_binary( in, KEs )
+    && marley_utils::read_binary( in, totals )
+    && marley_utils::read_binary( in, level_energies )
+    && marley_utils::read_binary( in, level_xsecs );
+
+  // Check that the array sizes are consistent with each other
+  size_t num_levels = level_energies.size();
+  return ok && totals.size() == KEs.size() && ( level_xsecs.empty()
+    || level_xsecs.size() == KEs.size() * num_levels );
+}
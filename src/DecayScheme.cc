@@ -14,10 +14,13 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
+#include <queue>
 #include <regex>
 #include <string>
 #include <vector>
@@ -29,6 +32,8 @@
 #include "marley/Logger.hh"
 #include "marley/HauserFeshbachDecay.hh"
 
+constexpr size_t marley::DecayScheme::DEFAULT_MAX_CASCADE_PATHS;
+
 // Returns a pointer to the level owned by this decay scheme object
 // that has the closest excitation energy to E_level (E_level
 // has units of MeV).
@@ -39,8 +44,22 @@ marley::Level* marley::DecayScheme::get_pointer_to_closest_level(
   size_t num_levels = levels_.size();
   if (num_levels == 0) return nullptr;
 
-  // Search for the level whose energy is closest to the given value of E_level
-  size_t e_index = level_lower_bound_index(E_level);
+  if ( !level_index_ready_ ) build_level_index();
+
+  // Search for the level whose energy is closest to the given value of
+  // E_level. Start from the first level in its bucket, then move to the
+  // first level with an energy not less than E_level. Checking in both
+  // directions guards against roundoff in the bucket boundaries.
+  const double* E = level_energies_.data();
+  size_t e_index = 0u;
+  if ( bucket_width_ > 0. && E_level > E[0] ) {
+    size_t num_buckets = level_buckets_.size() - 1u;
+    double b = std::floor( (E_level - E[0]) / bucket_width_ );
+    if ( b >= num_buckets ) e_index = num_levels;
+    else e_index = level_buckets_[ static_cast<size_t>(b) ];
+  }
+  while ( e_index > 0 && E[e_index - 1] >= E_level ) --e_index;
+  while ( e_index < num_levels && E[e_index] < E_level ) ++e_index;
 
   if (e_index == num_levels) {
     // The given energy is greater than every level energy in our decay scheme.
@@ -53,91 +72,374 @@ marley::Level* marley::DecayScheme::get_pointer_to_closest_level(
     // If the calculated index does not correspond to the first element, we
     // still need to check which of the two levels found (one on each side) is
     // really the closest. Do so and reassign the index if needed.
-    if (std::abs(E_level - levels_.at(e_index)->energy())
-      > std::abs(E_level - levels_.at(e_index - 1)->energy()))
+    if (std::abs(E_level - E[e_index]) > std::abs(E_level - E[e_index - 1]))
     {
       --e_index;
     }
   }
 
   // Return a pointer to the selected level object
-  return levels_.at(e_index).get();
+  return levels_[ e_index ].get();
+}
+
+void marley::DecayScheme::build_level_index() {
+
+  level_buckets_.clear();
+  bucket_width_ = 0.;
+
+  // Use about one bucket per level. If all of the levels have the same
+  // energy, then the bucket width is left at zero, and lookups start from
+  // the first level.
+  size_t num_levels = level_energies_.size();
+  if ( num_levels > 1u ) {
+    double E_span = level_energies_.back() - level_energies_.front();
+    if ( E_span > 0. ) {
+      bucket_width_ = E_span / num_levels;
+      level_buckets_.reserve( num_levels + 1u );
+      size_t k = 0u;
+      for ( size_t b = 0u; b < num_levels; ++b ) {
+        double E_low = level_energies_.front() + b*bucket_width_;
+        while ( k < num_levels && level_energies_[ k ] < E_low ) ++k;
+        level_buckets_.push_back( k );
+      }
+    }
+  }
+  level_buckets_.push_back( num_levels );
+
+  level_index_ready_ = true;
 }
 
 int marley::DecayScheme::pdg() const {
   return marley_utils::get_nucleus_pid( Z_, A_ );
 }
 
+void marley::DecayScheme::build_cascade_table() {
+
+  const marley::MassTable& mt = marley::MassTable::Instance();
+  double gs_mass = mt.get_atomic_mass( this->pdg() );
+
+  CascadeTable& ct = cascade_table_;
+  ct.level_masses.clear();
+  ct.gamma_offsets.clear();
+  ct.gamma_energies.clear();
+  ct.end_levels.clear();
+  ct.gamma_samplers.resize( levels_.size() );
+
+  for ( size_t k = 0u; k < levels_.size(); ++k ) {
+    marley::Level& lev = *levels_[ k ];
+    ct.level_masses.push_back( gs_mass + lev.energy() );
+    ct.gamma_offsets.push_back( ct.gamma_energies.size() );
+
+    auto& gammas = lev.gammas();
+    for ( const auto& g : gammas ) {
+      ct.gamma_energies.push_back( g.energy() );
+
+      // Convert the final level pointer into an index
+      size_t end_idx = NO_END_LEVEL;
+      const marley::Level* end_lev = g.end_level();
+      if ( end_lev ) {
+        size_t idx = level_lower_bound_index( end_lev->energy() );
+        while ( idx < levels_.size() && levels_[ idx ].get() != end_lev
+          && levels_[ idx ]->energy() == end_lev->energy() ) ++idx;
+        if ( idx < levels_.size() && levels_[ idx ].get() == end_lev ) {
+          end_idx = idx;
+        }
+      }
+      ct.end_levels.push_back( end_idx );
+    }
+
+    if ( gammas.empty() ) ct.gamma_samplers[ k ].clear();
+    else ct.gamma_samplers[ k ].build(
+      marley::Gamma::make_intensity_iterator(gammas.begin()),
+      marley::Gamma::make_intensity_iterator(gammas.end()) );
+  }
+  ct.gamma_offsets.push_back( ct.gamma_energies.size() );
+
+  build_cascade_paths();
+
+  cascade_table_ready_ = true;
+
+  if ( !level_index_ready_ ) build_level_index();
+}
+
 void marley::DecayScheme::do_cascade(marley::Level& initial_level,
   marley::Event& event, marley::Generator& gen, int qIon)
 {
   MARLEY_LOG_DEBUG() << "Beginning gamma cascade at level with energy "
     << initial_level.energy() << " MeV";
 
-  bool cascade_finished = false;
+  if ( !cascade_table_ready_ ) build_cascade_table();
+  const CascadeTable& ct = cascade_table_;
 
-  marley::Level* p_current_level = &initial_level;
+  // Find the index of the initial level
+  size_t k = level_lower_bound_index( initial_level.energy() );
+  while ( k < levels_.size() && levels_[ k ].get() != &initial_level ) ++k;
+  if ( k >= levels_.size() ) throw marley::Error( "Initial level passed to"
+    " marley::DecayScheme::do_cascade() is not owned by this decay scheme" );
 
   const marley::MassTable& mt = marley::MassTable::Instance();
+  int pdg = marley_utils::get_nucleus_pid(Z_, A_);
+  double electron_masses = mt.electron_masses( qIon );
 
-  while (!cascade_finished) {
+  // Adds the gamma with index g to the event and returns the index of its
+  // final level
+  auto emit_gamma = [&]( size_t g ) -> size_t {
 
-    // Randomly select a gamma to produce
-    const marley::Gamma* p_gamma = p_current_level->sample_gamma(gen);
-    if (!p_gamma) {
-      MARLEY_LOG_DEBUG() << "  this level does not have any gammas";
-      cascade_finished = true;
+    size_t k_f = ct.end_levels[ g ];
+    if ( k_f == NO_END_LEVEL ) {
+      throw marley::Error(std::string("This")
+        + "gamma does not have an end level. Cannot continue cascade.");
     }
-    else {
-      p_current_level = p_gamma->end_level();
-      if (!p_current_level) {
-        throw marley::Error(std::string("This")
-          + "gamma does not have an end level. Cannot continue cascade.");
+    MARLEY_LOG_DEBUG() << std::setprecision(15) << std::scientific
+      << "  emitted gamma with energy "
+      << ct.gamma_energies[ g ] << " MeV. New level has energy "
+      << levels_[ k_f ]->energy() << " MeV.";
+
+    // Create new particle objects to represent the emitted gamma and
+    // recoiling nucleus. The mass of the latter is the atomic mass for the
+    // end level minus the masses of any missing electrons.
+    marley::Particle gamma(marley_utils::PHOTON, 0);
+    marley::Particle nucleus(pdg, ct.level_masses[ k_f ] - electron_masses,
+      qIon);
+
+    // Sample a direction assuming that the gammas are emitted
+    // isotropically in the nucleus's rest frame.
+    double gamma_cos_theta, gamma_phi;
+    gen.isotropic_direction(gamma_cos_theta, gamma_phi);
+
+    marley::Particle& residue = event.residue();
+
+    // Determine the final energies and momenta for the recoiling nucleus and
+    // emitted gamma ray. Store them in the final state particle objects.
+    marley_kinematics::two_body_decay(residue, gamma, nucleus,
+      gamma_cos_theta, gamma_phi);
+
+    // Update the residue for this event to take into account changes from
+    // gamma ray emission
+    residue = nucleus;
+
+    // Add the new gamma to the event
+    event.add_final_particle(gamma);
+
+    return k_f;
+  };
+
+  if ( !ct.path_samplers.empty() && !ct.path_samplers[ k ].empty() ) {
+
+    // Choose the complete cascade at once using the path table
+    size_t first_path = ct.path_offsets[ k ];
+    size_t num_paths = ct.path_offsets[ k + 1u ] - first_path;
+    size_t p = gen.sample_from_distribution( ct.path_samplers[ k ] );
+
+    if ( p < num_paths ) {
+      size_t path = first_path + p;
+      for ( size_t j = ct.path_gamma_offsets[ path ];
+        j < ct.path_gamma_offsets[ path + 1u ]; ++j )
+      {
+        k = emit_gamma( ct.path_gammas[ j ] );
       }
-      MARLEY_LOG_DEBUG() << std::setprecision(15) << std::scientific
-        << "  emitted gamma with energy "
-        << p_gamma->energy() << " MeV. New level has energy "
-        << p_current_level->energy() << " MeV.";
-      MARLEY_LOG_DEBUG() << "gamma energy = " << p_gamma->energy();
-
-      // Get the excitation energy of the end level. This will be added to
-      // the ground state mass of the nucleus to determine its
-      // post-gamma-emission mass.
-      double Exf = p_current_level->energy();
-
-      // Create new particle objects to represent the emitted gamma and
-      // recoiling nucleus
-      marley::Particle gamma(marley_utils::PHOTON, 0);
-      int pdg = marley_utils::get_nucleus_pid(Z_, A_);
-      marley::Particle nucleus(pdg, mt.get_atomic_mass(pdg)
-        + Exf - qIon*mt.get_particle_mass(marley_utils::ELECTRON), qIon);
-
-      // Sample a direction assuming that the gammas are emitted
-      // isotropically in the nucleus's rest frame.
-      // sample from [-1,1]
-      double gamma_cos_theta = gen.uniform_random_double(-1, 1, true);
-      // sample from [0,2*pi)
-      double gamma_phi = gen.uniform_random_double(0, 2*marley_utils::pi,
-        false);
-
-      marley::Particle& residue = event.residue();
-
-      // Determine the final energies and momenta for the recoiling nucleus and
-      // emitted gamma ray. Store them in the final state particle objects.
-      marley_kinematics::two_body_decay(residue, gamma, nucleus,
-        gamma_cos_theta, gamma_phi);
-
-      // Update the residue for this event to take into account changes from
-      // gamma ray emission
-      residue = nucleus;
-
-      // Add the new gamma to the event
-      event.add_final_particle(gamma);
+    }
+    else {
+      // The cascade is not listed in the table, so sample it one gamma at
+      // a time instead
+      std::vector<size_t> path;
+      sample_unlisted_path( k, gen, path );
+      for ( size_t g : path ) k = emit_gamma( g );
+    }
+  }
+  else {
+    // Keep going until we reach a level without any gammas
+    while ( ct.gamma_offsets[ k ] != ct.gamma_offsets[ k + 1u ] ) {
+
+      // Randomly select a gamma to produce
+      size_t g = ct.gamma_offsets[ k ]
+        + gen.sample_from_distribution( ct.gamma_samplers[ k ] );
+
+      k = emit_gamma( g );
     }
   }
 
+  MARLEY_LOG_DEBUG() << "  this level does not have any gammas";
   MARLEY_LOG_DEBUG() << "Finished gamma cascade at level with energy "
-    << p_current_level->energy();
+    << levels_[ k ]->energy();
+}
+
+void marley::DecayScheme::set_cascade_path_tolerance( double tolerance,
+  size_t max_paths )
+{
+  if ( tolerance < 0. || tolerance >= 1. ) throw marley::Error( "Invalid"
+    " cascade path tolerance " + std::to_string(tolerance) + " passed to"
+    " marley::DecayScheme::set_cascade_path_tolerance()" );
+  if ( max_paths == 0u ) throw marley::Error( "The maximum number of"
+    " cascade paths passed to marley::DecayScheme::"
+    "set_cascade_path_tolerance() must be positive" );
+
+  if ( tolerance == cascade_path_tolerance_
+    && max_paths == max_cascade_paths_ ) return;
+
+  cascade_path_tolerance_ = tolerance;
+  max_cascade_paths_ = max_paths;
+
+  // Rebuild the cascade table if it was already in use
+  if ( cascade_table_ready_ ) build_cascade_table();
+}
+
+void marley::DecayScheme::build_cascade_paths() {
+
+  CascadeTable& ct = cascade_table_;
+  ct.path_offsets.clear();
+  ct.path_gamma_offsets.clear();
+  ct.path_gammas.clear();
+  ct.path_samplers.clear();
+  if ( cascade_path_tolerance_ <= 0. ) return;
+
+  size_t num_levels = levels_.size();
+  ct.path_samplers.resize( num_levels );
+
+  // Partial cascade that has not yet reached a level without any gammas
+  struct PartialPath {
+    double prob;
+    size_t level;
+    std::vector<size_t> gammas;
+    bool operator<( const PartialPath& other ) const
+      { return prob < other.prob; }
+  };
+
+  // Limit on the number of partial paths that are extended for each
+  // starting level. This keeps the search cheap when the probability is
+  // spread over very many cascades.
+  const size_t max_extensions = 16u * max_cascade_paths_;
+
+  std::vector< std::pair<std::vector<size_t>, double> > paths;
+  for ( size_t k0 = 0u; k0 < num_levels; ++k0 ) {
+
+    ct.path_offsets.push_back( ct.path_gamma_offsets.size() );
+    if ( ct.gamma_offsets[ k0 ] == ct.gamma_offsets[ k0 + 1u ] ) continue;
+
+    // Find the most probable complete cascades by always extending the
+    // most probable partial one
+    paths.clear();
+    double listed_prob = 0.;
+    double unlisted_prob = 0.;
+    std::priority_queue<PartialPath> queue;
+    queue.push( PartialPath{ 1., k0, {} } );
+
+    size_t num_extensions = 0u;
+    while ( !queue.empty() && paths.size() < max_cascade_paths_
+      && listed_prob < 1. - cascade_path_tolerance_
+      && num_extensions < max_extensions )
+    {
+      PartialPath pp = queue.top();
+      queue.pop();
+
+      // Record cascades that have ended
+      if ( ct.gamma_offsets[ pp.level ] == ct.gamma_offsets[ pp.level + 1u ] )
+      {
+        listed_prob += pp.prob;
+        paths.emplace_back( std::move(pp.gammas), pp.prob );
+        continue;
+      }
+
+      // Implausibly long cascades are left to step-by-step sampling
+      if ( pp.gammas.size() >= num_levels ) {
+        unlisted_prob += pp.prob;
+        continue;
+      }
+
+      ++num_extensions;
+      const auto& gammas = levels_[ pp.level ]->gammas();
+      double total_intensity = ct.gamma_samplers[ pp.level ].total_weight();
+      for ( size_t i = 0u; i < gammas.size(); ++i ) {
+        size_t g = ct.gamma_offsets[ pp.level ] + i;
+        double prob = pp.prob * gammas[ i ].relative_intensity()
+          / total_intensity;
+        if ( prob <= 0. ) continue;
+
+        // So are cascades that reach a gamma without a final level
+        if ( ct.end_levels[ g ] == NO_END_LEVEL ) {
+          unlisted_prob += prob;
+          continue;
+        }
+        PartialPath next{ prob, ct.end_levels[ g ], pp.gammas };
+        next.gammas.push_back( g );
+        queue.push( std::move(next) );
+      }
+    }
+
+    while ( !queue.empty() ) {
+      unlisted_prob += queue.top().prob;
+      queue.pop();
+    }
+
+    // Sort the paths so that sample_unlisted_path() can find them quickly
+    std::sort( paths.begin(), paths.end() );
+
+    std::vector<double> weights;
+    for ( auto& path : paths ) {
+      ct.path_gamma_offsets.push_back( ct.path_gammas.size() );
+      ct.path_gammas.insert( ct.path_gammas.end(), path.first.cbegin(),
+        path.first.cend() );
+      weights.push_back( path.second );
+    }
+
+    // Add an extra entry for the cascades that were left out
+    if ( unlisted_prob > 0. ) weights.push_back( unlisted_prob );
+
+    if ( !weights.empty() ) {
+      ct.path_samplers[ k0 ].build( weights.cbegin(), weights.cend() );
+    }
+  }
+  ct.path_offsets.push_back( ct.path_gamma_offsets.size() );
+  ct.path_gamma_offsets.push_back( ct.path_gammas.size() );
+
+  MARLEY_LOG_DEBUG() << "Built cascade path tables with "
+    << ct.path_gamma_offsets.size() - 1u << " paths for " << num_levels
+    << " levels of nuclide " << this->pdg();
+}
+
+void marley::DecayScheme::sample_unlisted_path( size_t k,
+  marley::Generator& gen, std::vector<size_t>& path ) const
+{
+  const CascadeTable& ct = cascade_table_;
+
+  // Compares a listed path to the sampled one
+  auto path_less = [&ct]( size_t listed, const std::vector<size_t>& sampled )
+    -> bool
+  {
+    return std::lexicographical_compare(
+      ct.path_gammas.cbegin() + ct.path_gamma_offsets[ listed ],
+      ct.path_gammas.cbegin() + ct.path_gamma_offsets[ listed + 1u ],
+      sampled.cbegin(), sampled.cend() );
+  };
+
+  std::vector<size_t> listed_paths( ct.path_offsets[ k + 1u ]
+    - ct.path_offsets[ k ] );
+  std::iota( listed_paths.begin(), listed_paths.end(), ct.path_offsets[ k ] );
+
+  // Sampling step-by-step and rejecting the listed paths gives the
+  // remaining cascades with the correct relative probabilities
+  while ( true ) {
+    path.clear();
+    size_t k_f = k;
+    while ( k_f != NO_END_LEVEL
+      && ct.gamma_offsets[ k_f ] != ct.gamma_offsets[ k_f + 1u ] )
+    {
+      size_t g = ct.gamma_offsets[ k_f ]
+        + gen.sample_from_distribution( ct.gamma_samplers[ k_f ] );
+      path.push_back( g );
+      k_f = ct.end_levels[ g ];
+    }
+
+    auto iter = std::lower_bound( listed_paths.cbegin(),
+      listed_paths.cend(), path, path_less );
+    if ( iter == listed_paths.cend() ) return;
+
+    size_t begin = ct.path_gamma_offsets[ *iter ];
+    size_t end = ct.path_gamma_offsets[ *iter + 1u ];
+    bool listed = ( path.size() == end - begin && std::equal(path.cbegin(),
+      path.cend(), ct.path_gammas.cbegin() + begin) );
+    if ( !listed ) return;
+  }
 }
 
 marley::DecayScheme::DecayScheme(int Z, int A) : Z_(Z), A_(A)
@@ -261,6 +563,32 @@ void marley::DecayScheme::parse_talys(const std::string& filename) {
   file_in.close();
 }
 
+size_t marley::DecayScheme::memory_usage() const {
+  using marley_utils::vector_bytes;
+  size_t bytes = vector_bytes( levels_ ) + vector_bytes( level_energies_ )
+    + vector_bytes( level_buckets_ );
+  for ( const auto& level : levels_ ) {
+    // Each level's std::discrete_distribution keeps two doubles per gamma
+    const auto& gammas = level->gammas();
+    bytes += sizeof( marley::Level ) + vector_bytes( gammas )
+      + 2u * gammas.size() * sizeof( double );
+  }
+
+  const auto& ct = cascade_table_;
+  bytes += vector_bytes( ct.level_masses ) + vector_bytes( ct.gamma_offsets )
+    + vector_bytes( ct.gamma_energies ) + vector_bytes( ct.end_levels )
+    + vector_bytes( ct.gamma_samplers ) + vector_bytes( ct.path_offsets )
+    + vector_bytes( ct.path_gamma_offsets ) + vector_bytes( ct.path_gammas )
+    + vector_bytes( ct.path_samplers );
+  for ( const auto& sampler : ct.gamma_samplers ) {
+    bytes += sampler.memory_usage();
+  }
+  for ( const auto& sampler : ct.path_samplers ) {
+    bytes += sampler.memory_usage();
+  }
+  return bytes;
+}
+
 void marley::DecayScheme::print_report(std::ostream& ostr) const {
   // Cycle through each of the levels owned by this decay scheme
   // object in order of increasing energy
@@ -356,11 +684,9 @@ void marley::DecayScheme::print_latex_table(std::ostream& ostr) {
 
 // Finds the index for the first level with excitation energy not less than Ex
 size_t marley::DecayScheme::level_lower_bound_index(double Ex) {
-  const auto E_begin = marley::Level::make_energy_iterator(levels_.cbegin());
-  const auto E_end = marley::Level::make_energy_iterator(levels_.cend());
-
-  const auto closest_E_iter = std::lower_bound(E_begin, E_end, Ex);
-  return std::distance(E_begin, closest_E_iter);
+  const auto closest_E_iter = std::lower_bound(level_energies_.cbegin(),
+    level_energies_.cend(), Ex);
+  return std::distance(level_energies_.cbegin(), closest_E_iter);
 }
 
 // Adds a new level to the decay scheme and returns a reference to it
@@ -369,9 +695,13 @@ marley::Level& marley::DecayScheme::add_level(const marley::Level& level)
   // Compute the numerical index for where we will insert the new level
   size_t index = level_lower_bound_index(level.energy());
 
-  // Insert the new level into the decay scheme
+  // Insert the new level into the decay scheme. The level indices used by
+  // the cascade table and the bucket index are now out of date.
+  cascade_table_ready_ = false;
+  level_index_ready_ = false;
   levels_.insert(levels_.begin() + index,
     std::make_unique<marley::Level>(level));
+  level_energies_.insert(level_energies_.begin() + index, level.energy());
 
   // Return a reference to the newly-added level
   return *levels_.at(index);
@@ -404,6 +734,9 @@ void marley::DecayScheme::print(std::ostream& out) const {
 void marley::DecayScheme::read_from_stream(std::istream& in) {
 
   levels_.clear();
+  level_energies_.clear();
+  cascade_table_ready_ = false;
+  level_index_ready_ = false;
 
   int num_levels;
   in >> Z_ >> A_ >> num_levels;
@@ -426,6 +759,74 @@ void marley::DecayScheme::read_from_stream(std::istream& in) {
   }
 }
 
+void marley::DecayScheme::write_binary(std::ostream& out) const {
+
+  marley_utils::write_binary( out, Z_ );
+  marley_utils::write_binary( out, A_ );
+  marley_utils::write_binary( out, static_cast<int>(levels_.size()) );
+
+  for (const auto& lev : levels_) {
+    marley_utils::write_binary( out, lev->energy() );
+    marley_utils::write_binary( out, lev->twoJ() );
+    marley_utils::write_binary( out, static_cast<int>(lev->parity()) );
+    marley_utils::write_binary( out, static_cast<int>(lev->gammas().size()) );
+    for (const auto& g : lev->gammas()) {
+      marley_utils::write_binary( out, g.energy() );
+      marley_utils::write_binary( out, g.relative_intensity() );
+
+      const auto cit = std::find_if(levels_.cbegin(), levels_.cend(),
+        [&g](const std::unique_ptr<marley::Level>& l)
+        -> bool { return l.get() == g.end_level(); });
+
+      int level_f_idx = -1;
+      if (cit != levels_.cend()) level_f_idx = std::distance(levels_.cbegin(),
+        cit);
+      marley_utils::write_binary( out, level_f_idx );
+    }
+  }
+}
+
+void marley::DecayScheme::read_from_binary_stream(std::istream& in) {
+
+  levels_.clear();
+  level_energies_.clear();
+  cascade_table_ready_ = false;
+  level_index_ready_ = false;
+
+  // This follows the same steps as read_from_stream() so that the
+  // resulting DecayScheme objects are identical
+  int num_levels;
+  if ( !marley_utils::read_binary(in, Z_)
+    || !marley_utils::read_binary(in, A_)
+    || !marley_utils::read_binary(in, num_levels) ) return;
+
+  double energy, ri;
+  int two_j, pi, num_gammas, level_f_idx;
+
+  for ( int i = 0; i < num_levels; ++i ) {
+    if ( !marley_utils::read_binary(in, energy)
+      || !marley_utils::read_binary(in, two_j)
+      || !marley_utils::read_binary(in, pi)
+      || !marley_utils::read_binary(in, num_gammas) ) return;
+    marley::Level& l = add_level( marley::Level(energy, two_j,
+      marley::Parity(pi)) );
+    for ( int j = 0; j < num_gammas; ++j ) {
+      if ( !marley_utils::read_binary(in, energy)
+        || !marley_utils::read_binary(in, ri)
+        || !marley_utils::read_binary(in, level_f_idx) ) return;
+
+      // Reject final level indices that would be out of range
+      if ( level_f_idx < 0
+        || static_cast<size_t>(level_f_idx) >= levels_.size() )
+      {
+        in.setstate( std::ios::failbit );
+        return;
+      }
+      l.add_gamma( energy, ri, levels_.at(level_f_idx).get() );
+    }
+  }
+}
+
 void marley::DecayScheme::parse(const std::string& filename,
   marley::DecayScheme::FileFormat ff)
 {
@@ -114,8 +114,10 @@ double marley::ElectronReaction::total_xs(int pdg_a, double KEa) const {
   return xs;
 }
 
-double marley::ElectronReaction::total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const {
-	return 0;
+double marley::ElectronReaction::total_xs(int, double, double, double,
+  double) const
+{
+  return 0.;
 }
 
 double marley::ElectronReaction::diff_xs(int pdg_a, double KEa,
@@ -156,6 +158,14 @@ double marley::ElectronReaction::diff_xs(int pdg_a, double KEa,
 // performing kinematic calculations
 marley::Event marley::ElectronReaction::create_event(int pdg_a, double KEa,
   marley::Generator& gen) const
+{
+  marley::Event ev;
+  this->create_event( pdg_a, KEa, gen, ev );
+  return ev;
+}
+
+void marley::ElectronReaction::create_event(int pdg_a, double KEa,
+  marley::Generator& gen, marley::Event& ev) const
 {
   // If the projectile's PDG code doesn't match that stored in this object,
   // complain and refuse to create an event.
@@ -173,54 +183,133 @@ marley::Event marley::ElectronReaction::create_event(int pdg_a, double KEa,
   double s, Ec_cm, pc_cm, Ed_cm;
   two_two_scatter(KEa, s, Ec_cm, pc_cm, Ed_cm);
 
-  // Compute the maximum differential cross section to use for rejection
-  // sampling. To do this, we analytically solve for the value of
-  // cos_theta_c_cm (labeled cth below) for which the derivative of the
-  // differential cross section vanishes. This is an extremum of the function
-  // and might correspond to the maximum. If cth is within the allowed angular
-  // range, then it is considered alongside the two endpoints (COS_MIN and
-  // COS_MAX), and the largest of the three values (or just the endpoint values
-  // if cth is outside the allowed range) is chosen as the maximum.
-  double me2_over_s = md_*md_ / s;
-  double B = marley_utils::ONE_HALF * std::pow(g2_*(1. - me2_over_s), 2);
-  double A = g1_*g2_*me2_over_s + g2_*g2_*(1. - me2_over_s) - B;
-  double cth = -A / B;
-
-  // Set the differential cross section to a huge negative value
-  // at cth. This value will be compared to those at the angular
-  // endpoints if cth does not lie in the allowed range. Otherwise,
-  // the correct value will replace this one.
-  double dxs_at_cth = std::numeric_limits<double>::lowest();
-
-  double max = 0.;
-  if ( cth >= COS_MIN && cth <= COS_MAX ) {
-    dxs_at_cth = this->diff_xs(pdg_a, KEa, cth);
+  // Sample a CM frame scattering cosine for the ejectile
+  double cos_theta_c_cm;
+  if ( cos_theta_sampling_ == CosThetaSampling::REJECTION ) {
+    cos_theta_c_cm = rejection_sample_cos_theta_c_cm( pdg_a, KEa, s, gen );
   }
-
-  double dxs_at_min = this->diff_xs(pdg_a, KEa, COS_MIN);
-  double dxs_at_max = this->diff_xs(pdg_a, KEa, COS_MAX);
-
-  // Find the maximum value of the differential cross section
-  max = std::max( { dxs_at_min, dxs_at_max, dxs_at_cth } );
-
-  // Sample a CM frame scattering cosine for the ejectile.
-  double cos_theta_c_cm = gen.rejection_sample(
-    [this, pdg_a, KEa](double ctheta) -> double
-    { return this->diff_xs(pdg_a, KEa, ctheta); }, COS_MIN, COS_MAX, max);
+  else cos_theta_c_cm = sample_cos_theta_c_cm( s, gen );
 
   // Sample a CM frame azimuthal scattering angle (phi) uniformly on [0, 2*pi).
   // We can do this because the differential cross section is independent of
   // the azimuthal angle.
-  double phi_c_cm = gen.uniform_random_double(0., marley_utils::two_pi, false);
+  double phi_c_cm = gen.uniform(0., marley_utils::two_pi);
 
-  // Create and return the completed event object
+  // Load the completed event object
   // Note: electrons have spin 1/2 and positive intrinsic parity
-  return make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm, Ec_cm, Ed_cm,
-    0., 1, marley::Parity(true) );
+  make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm, Ec_cm, Ed_cm,
+    0., 1, marley::Parity(true), ev );
 }
 
-marley::Event marley::ElectronReaction::create_event(int pdg_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
+double marley::ElectronReaction::sample_cos_theta_c_cm(double s,
   marley::Generator& gen) const
+{
+  // In terms of u = cos_theta_c_cm - 1, which lies on [-2, 0], the
+  // differential cross section computed by diff_xs() is proportional to the
+  // quadratic c0 + c1*u + c2*u^2. Its cumulative distribution function is
+  // therefore a cubic polynomial, which we invert numerically.
+  double me2_over_s = md_*md_ / s;
+  double h = marley_utils::ONE_HALF * ( 1. - me2_over_s );
+  double c0 = g1_*g1_ + g2_*g2_;
+  double c1 = g1_*g2_*me2_over_s + 2.*g2_*g2_*h;
+  double c2 = std::pow( g2_*h, 2 );
+
+  constexpr double U_MIN = COS_MIN - 1.;
+  constexpr double U_MAX = COS_MAX - 1.;
+
+  // Unnormalized CDF and PDF
+  auto cdf = [=](double u) -> double {
+    return c0*( u - U_MIN ) + 0.5*c1*( u*u - U_MIN*U_MIN )
+      + marley_utils::ONE_THIRD*c2*( u*u*u - U_MIN*U_MIN*U_MIN );
+  };
+  auto pdf = [=](double u) -> double { return c0 + u*( c1 + u*c2 ); };
+
+  double total = cdf( U_MAX );
+  double target = gen.uniform_random_double( 0., 1., true ) * total;
+
+  // Solve cdf(u) = target using Newton's method, falling back to bisection
+  // whenever a step would leave the bracketing interval. The initial guess
+  // is exact for an isotropic distribution. A handful of iterations is
+  // typically enough to converge.
+  constexpr int MAX_ITERATIONS = 50;
+  constexpr double REL_TOLERANCE = 1e-12;
+  double u_lo = U_MIN;
+  double u_hi = U_MAX;
+  double u = U_MIN + ( U_MAX - U_MIN ) * target / total;
+  for ( int i = 0; i < MAX_ITERATIONS; ++i ) {
+    double diff = cdf( u ) - target;
+    if ( std::abs(diff) <= REL_TOLERANCE * total ) break;
+
+    if ( diff < 0. ) u_lo = u;
+    else u_hi = u;
+
+    double u_new = 0.5*( u_lo + u_hi );
+    double p = pdf( u );
+    if ( p > 0. ) {
+      double u_newton = u - diff / p;
+      if ( u_newton >= u_lo && u_newton <= u_hi ) u_new = u_newton;
+    }
+    u = u_new;
+  }
+
+  // Guard against roundoff error pushing the result outside of the
+  // allowed range
+  return std::min( COS_MAX, std::max( COS_MIN, u + 1. ) );
+}
+
+double marley::ElectronReaction::rejection_sample_cos_theta_c_cm(int pdg_a,
+  double KEa, double s, marley::Generator& gen) const
+{
+  // Compute the maximum differential cross section to use for rejection
+  // sampling unless it is already cached for this projectile. The coupling
+  // constants depend only on pdg_a, and Mandelstam s depends only on pdg_a
+  // and KEa, so these fully determine the envelope.
+  if ( !envelope_cache_.valid || envelope_cache_.pdg_a != pdg_a
+    || envelope_cache_.KEa != KEa )
+  {
+    // To find the maximum, we analytically solve for the value of
+    // cos_theta_c_cm (labeled cth below) for which the derivative of the
+    // differential cross section vanishes. This is an extremum of the
+    // function and might correspond to the maximum. If cth is within the
+    // allowed angular range, then it is considered alongside the two
+    // endpoints (COS_MIN and COS_MAX), and the largest of the three values
+    // (or just the endpoint values if cth is outside the allowed range) is
+    // chosen as the maximum.
+    double me2_over_s = md_*md_ / s;
+    double B = marley_utils::ONE_HALF * std::pow(g2_*(1. - me2_over_s), 2);
+    double A = g1_*g2_*me2_over_s + g2_*g2_*(1. - me2_over_s) - B;
+    double cth = -A / B;
+
+    // Set the differential cross section to a huge negative value
+    // at cth. This value will be compared to those at the angular
+    // endpoints if cth does not lie in the allowed range. Otherwise,
+    // the correct value will replace this one.
+    double dxs_at_cth = std::numeric_limits<double>::lowest();
+
+    if ( cth >= COS_MIN && cth <= COS_MAX ) {
+      dxs_at_cth = this->diff_xs(pdg_a, KEa, cth);
+    }
+
+    double dxs_at_min = this->diff_xs(pdg_a, KEa, COS_MIN);
+    double dxs_at_max = this->diff_xs(pdg_a, KEa, COS_MAX);
+
+    // Find the maximum value of the differential cross section
+    envelope_cache_.max = std::max( { dxs_at_min, dxs_at_max, dxs_at_cth } );
+    envelope_cache_.pdg_a = pdg_a;
+    envelope_cache_.KEa = KEa;
+    envelope_cache_.valid = true;
+  }
+
+  double max = envelope_cache_.max;
+
+  // Sample a CM frame scattering cosine for the ejectile.
+  return gen.rejection_sample(
+    [this, pdg_a, KEa](double ctheta) -> double
+    { return this->diff_xs(pdg_a, KEa, ctheta); }, COS_MIN, COS_MAX, max);
+}
+
+marley::Event marley::ElectronReaction::create_event(int, double, double,
+  double, double, marley::Generator&) const
 {
   return 0.;
 }
@@ -15,14 +15,19 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 #include <algorithm> // std::iter_swap
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <utility>
 
 #include "marley/Error.hh"
 #include "marley/Event.hh"
 #include "marley/JSON.hh"
+#include "marley/JSONDocument.hh"
+#include "marley/JSONWriter.hh"
 #include "marley/MassTable.hh"
+#include "marley/TextTokenReader.hh"
 #include "marley/marley_utils.hh"
 
 // Local constants used only within this file
@@ -36,6 +41,11 @@ namespace {
   constexpr size_t EJECTILE_INDEX = 0u;
   constexpr size_t RESIDUE_INDEX = 1u;
 
+  // Number of final particles for which space is reserved when a new event
+  // is created. This is enough for the products of a typical de-excitation
+  // cascade.
+  constexpr size_t TYPICAL_FINAL_PARTICLE_COUNT = 16u;
+
   // Conversion factor for converting GeV to MeV (the latter of which
   // is used in MARLEY natural units)
   constexpr double GEV_TO_MEV = 1000.;
@@ -56,9 +66,11 @@ namespace {
 // particles. The residue (particle d) has excitation energy Ex and
 // spin-parity 0+.
 marley::Event::Event(double Ex)
-  : initial_particles_{new marley::Particle(), new marley::Particle()},
-  final_particles_{new marley::Particle(), new marley::Particle()},
-  Ex_(Ex), twoJ_(0), parity_(true) {}
+  : initial_particles_(2), final_particles_(2), Ex_(Ex), twoJ_(0),
+  parity_(true)
+{
+  final_particles_.reserve( TYPICAL_FINAL_PARTICLE_COUNT );
+}
 
 // Creates an 2-->2 scattering event with given initial (a & b) and final
 // (c & d) particles. The residue (particle d) has excitation energy Ex,
@@ -67,75 +79,47 @@ marley::Event::Event(double Ex)
 marley::Event::Event(const marley::Particle& a, const marley::Particle& b,
   const marley::Particle& c, const marley::Particle& d, double Ex, int twoJ,
   const marley::Parity& P)
-  : initial_particles_{new marley::Particle(a), new marley::Particle(b)},
-  final_particles_{new marley::Particle(c), new marley::Particle(d)},
-  Ex_(Ex), twoJ_(twoJ), parity_(P) {}
-
-// Destructor
-marley::Event::~Event() {
-  this->delete_particles();
+  : initial_particles_{a, b}, Ex_(Ex), twoJ_(twoJ), parity_(P)
+{
+  final_particles_.reserve( TYPICAL_FINAL_PARTICLE_COUNT );
+  final_particles_.push_back( c );
+  final_particles_.push_back( d );
 }
 
-// Copy constructor
-marley::Event::Event(const marley::Event& other_event)
-  : initial_particles_(other_event.initial_particles_.size()),
-  final_particles_(other_event.final_particles_.size()),
-  Ex_(other_event.Ex_), twoJ_(other_event.twoJ_),
-  parity_(other_event.parity_)
+void marley::Event::assign(const marley::Particle& a,
+  const marley::Particle& b, const marley::Particle& c,
+  const marley::Particle& d, double Ex, int twoJ, const marley::Parity& P)
 {
-  for (size_t i = 0; i < other_event.initial_particles_.size(); ++i) {
-    initial_particles_[i] = new marley::Particle(
-      *other_event.initial_particles_[i]);
-  }
-  for (size_t i = 0; i < other_event.final_particles_.size(); ++i) {
-    final_particles_[i] = new marley::Particle(
-      *other_event.final_particles_[i]);
-  }
-}
+  initial_particles_.clear();
+  initial_particles_.push_back( a );
+  initial_particles_.push_back( b );
 
+  final_particles_.clear();
+  final_particles_.push_back( c );
+  final_particles_.push_back( d );
+
+  Ex_ = Ex;
+  twoJ_ = twoJ;
+  parity_ = P;
+  weight_ = 1.;
+  time_ = 0.;
+}
 
 // Move constructor
 marley::Event::Event(marley::Event&& other_event)
-  : initial_particles_(other_event.initial_particles_.size()),
-  final_particles_(other_event.final_particles_.size()),
+  : initial_particles_(std::move(other_event.initial_particles_)),
+  final_particles_(std::move(other_event.final_particles_)),
   Ex_(other_event.Ex_), twoJ_(other_event.twoJ_),
-  parity_(other_event.parity_)
+  parity_(other_event.parity_), weight_(other_event.weight_),
+  time_(other_event.time_)
 {
   other_event.Ex_ = 0.;
-  for (size_t i = 0; i < other_event.initial_particles_.size(); ++i) {
-    initial_particles_[i] = other_event.initial_particles_[i];
-  }
-  for (size_t i = 0; i < other_event.final_particles_.size(); ++i) {
-    final_particles_[i] = other_event.final_particles_[i];
-  }
+  other_event.weight_ = 1.;
+  other_event.time_ = 0.;
   other_event.initial_particles_.clear();
   other_event.final_particles_.clear();
 }
 
-// Copy assignment operator
-marley::Event& marley::Event::operator=(const marley::Event& other_event) {
-  Ex_ = other_event.Ex_;
-  twoJ_ = other_event.twoJ_;
-  parity_ = other_event.parity_;
-
-  // Delete the old particle objects owned by this event
-  this->delete_particles();
-
-  initial_particles_.resize(other_event.initial_particles_.size());
-  final_particles_.resize(other_event.final_particles_.size());
-
-  for (size_t i = 0; i < other_event.initial_particles_.size(); ++i) {
-    initial_particles_[i] = new marley::Particle(
-      *other_event.initial_particles_[i]);
-  }
-  for (size_t i = 0; i < other_event.final_particles_.size(); ++i) {
-    final_particles_[i] = new marley::Particle(
-      *other_event.final_particles_[i]);
-  }
-
-  return *this;
-}
-
 // Move assignment operator
 marley::Event& marley::Event::operator=(marley::Event&& other_event) {
 
@@ -148,18 +132,16 @@ marley::Event& marley::Event::operator=(marley::Event&& other_event) {
   parity_ = other_event.parity_;
   other_event.parity_ = marley::Parity( true );
 
-  // Delete the old particle objects owned by this event
-  this->delete_particles();
+  weight_ = other_event.weight_;
+  other_event.weight_ = 1.;
 
-  initial_particles_.resize(other_event.initial_particles_.size());
-  final_particles_.resize(other_event.final_particles_.size());
+  time_ = other_event.time_;
+  other_event.time_ = 0.;
 
-  for (size_t i = 0; i < other_event.initial_particles_.size(); ++i) {
-    initial_particles_[i] = other_event.initial_particles_[i];
-  }
-  for (size_t i = 0; i < other_event.final_particles_.size(); ++i) {
-    final_particles_[i] = other_event.final_particles_[i];
-  }
+  // Exchange storage with the other event so that the capacity already
+  // allocated by this one can be reused by it
+  initial_particles_.swap( other_event.initial_particles_ );
+  final_particles_.swap( other_event.final_particles_ );
 
   other_event.initial_particles_.clear();
   other_event.final_particles_.clear();
@@ -168,59 +150,57 @@ marley::Event& marley::Event::operator=(marley::Event&& other_event) {
 }
 
 marley::Particle& marley::Event::projectile() {
-  return *initial_particles_.at(PROJECTILE_INDEX);
+  return initial_particles_.at(PROJECTILE_INDEX);
 }
 
 marley::Particle& marley::Event::target() {
-  return *initial_particles_.at(TARGET_INDEX);
+  return initial_particles_.at(TARGET_INDEX);
 }
 
 marley::Particle& marley::Event::ejectile() {
-  return *final_particles_.at(EJECTILE_INDEX);
+  return final_particles_.at(EJECTILE_INDEX);
 }
 
 marley::Particle& marley::Event::residue() {
-  return *final_particles_.at(RESIDUE_INDEX);
+  return final_particles_.at(RESIDUE_INDEX);
 }
 
 const marley::Particle& marley::Event::projectile() const {
-  return *initial_particles_.at(PROJECTILE_INDEX);
+  return initial_particles_.at(PROJECTILE_INDEX);
 }
 
 const marley::Particle& marley::Event::target() const {
-  return *initial_particles_.at(TARGET_INDEX);
+  return initial_particles_.at(TARGET_INDEX);
 }
 
 const marley::Particle& marley::Event::ejectile() const {
-  return *final_particles_.at(EJECTILE_INDEX);
+  return final_particles_.at(EJECTILE_INDEX);
 }
 
 const marley::Particle& marley::Event::residue() const {
-  return *final_particles_.at(RESIDUE_INDEX);
+  return final_particles_.at(RESIDUE_INDEX);
 }
 
 void marley::Event::add_initial_particle(const marley::Particle& p)
 {
-  initial_particles_.push_back(new marley::Particle(p));
+  initial_particles_.push_back(p);
 }
 
 void marley::Event::add_final_particle(const marley::Particle& p)
 {
-  final_particles_.push_back(new marley::Particle(p));
+  final_particles_.push_back(p);
 }
 
 void marley::Event::clear() {
-  this->delete_particles();
+  // The particle vectors keep their capacity, so an Event that is reused
+  // (e.g., when reading many events from a file) doesn't reallocate them
+  initial_particles_.clear();
+  final_particles_.clear();
   Ex_ = 0.;
   twoJ_ = 0;
   parity_ = marley::Parity( true );
-}
-
-void marley::Event::delete_particles() {
-  for (auto& p : initial_particles_) if (p) delete p;
-  for (auto& p : final_particles_) if (p) delete p;
-  initial_particles_.clear();
-  final_particles_.clear();
+  weight_ = 1.;
+  time_ = 0.;
 }
 
 void marley::Event::print(std::ostream& out) const {
@@ -232,10 +212,11 @@ void marley::Event::print(std::ostream& out) const {
   temp.precision(std::numeric_limits<double>::max_digits10);
 
   temp << initial_particles_.size() << ' ' << final_particles_.size()
-    << ' ' << Ex_ << ' ' << twoJ_ << ' ' << parity_ << '\n';
+    << ' ' << Ex_ << ' ' << twoJ_ << ' ' << parity_ << ' ' << weight_
+    << ' ' << time_ << '\n';
 
-  for (const auto i : initial_particles_) temp << *i << '\n';
-  for (const auto f : final_particles_) temp << *f << '\n';
+  for (const auto& i : initial_particles_) temp << i << '\n';
+  for (const auto& f : final_particles_) temp << f << '\n';
 
   out << temp.str();
 }
@@ -246,11 +227,19 @@ void marley::Event::read(std::istream& in) {
   int num_initial;
   int num_final;
 
-  in >> num_initial >> num_final >> Ex_ >> twoJ_ >> parity_;
+  marley::TextTokenReader reader( in );
+  reader >> num_initial >> num_final >> Ex_ >> twoJ_ >> parity_;
+
+  // The event weight was added to the end of the header line after the
+  // other fields. Events written without it have unit weight.
+  if ( reader && reader.token_on_line() ) reader >> weight_;
+
+  // The same is true of the time, which follows the weight
+  if ( reader && reader.token_on_line() ) reader >> time_;
 
   // If reading the event header line failed for some
   // reason, just return without trying to do anything else.
-  if ( !in ) return;
+  if ( !reader ) return;
 
   // If we have invalid numbers of particles in either the initial or final
   // state (there need to be at least two in each and we can't fill memory when
@@ -272,86 +261,141 @@ void marley::Event::read(std::istream& in) {
   final_particles_.resize( num_final );
 
   for (int i = 0; i < num_initial; ++i) {
-    marley::Particle* p = new marley::Particle;
-    in >> *p;
+    in >> initial_particles_[i];
     if ( !in ) throw marley::Error("Parse error while reading initial"
       " particle #" + std::to_string(i) + " from an ASCII-format event"
       " record");
-    initial_particles_.at(i) = p;
   }
   for (int f = 0; f < num_final; ++f) {
-    marley::Particle* p = new marley::Particle;
-    in >> *p;
+    in >> final_particles_[f];
     if ( !in ) throw marley::Error("Parse error while reading final"
       " particle #" + std::to_string(f) + " from an ASCII-format event"
       " record");
-    final_particles_.at(f) = p;
   }
 }
 
-// Function that dumps a marley::Particle to an output stream in HEPEVT format.
+namespace {
+
+  // Appends the decimal digits of an unsigned integer to a string
+  void append_unsigned( std::string& buffer, uint64_t value ) {
+    char digits[ 20 ];
+    char* end = digits + sizeof( digits );
+    char* p = end;
+    do {
+      *--p = static_cast<char>( '0' + value % 10u );
+      value /= 10u;
+    } while ( value != 0u );
+    buffer.append( p, end - p );
+  }
+
+  // Appends a signed integer to a string
+  void append_int( std::string& buffer, int value ) {
+    if ( value < 0 ) {
+      buffer += '-';
+      append_unsigned( buffer, -static_cast<int64_t>(value) );
+    }
+    else append_unsigned( buffer, value );
+  }
+
+  // Appends a double to a string in the form used by a std::ostream with the
+  // std::scientific flag and a precision of max_digits10. The stream itself
+  // relies on the same printf conversion, so the results are identical.
+  void append_scientific( std::string& buffer, double value ) {
+    constexpr int PRECISION = std::numeric_limits<double>::max_digits10;
+    char digits[ 32 ];
+    int length = std::snprintf( digits, sizeof(digits), "%.*e", PRECISION,
+      value );
+    buffer.append( digits, length );
+  }
+
+}
+
+// Function that appends a marley::Particle to a string in HEPEVT format.
 // This is a private helper function for the publicly-accessible write_hepevt.
 void marley::Event::dump_hepevt_particle(const marley::Particle& p,
-  std::ostream& os, int status, int jmohep1, int jmohep2) const
+  std::string& buffer, int status, int jmohep1, int jmohep2) const
 {
   // Print the status code to begin the particle entry in the HEPEVT record
-  os << status << ' ';
+  append_int( buffer, status );
+  buffer += ' ';
 
   // TODO: improve this entry to give the user more control over the vertex
   // location and to reflect the parent-daughter relationships between
   // particles.
+  append_int( buffer, p.pdg_code() );
+  buffer += ' ';
+  append_int( buffer, jmohep1 );
+  buffer += ' ';
+  append_int( buffer, jmohep2 );
+  buffer += " 0 0 ";
+
   // Convert from MARLEY natural units (MeV) to GeV for the HEPEVT format
-  os << p.pdg_code() << ' ' << jmohep1 << ' ' << jmohep2 << " 0 0 "
-    << p.px() / GEV_TO_MEV << ' ' << p.py() / GEV_TO_MEV
-    << ' ' << p.pz() / GEV_TO_MEV << ' ' << p.total_energy() / GEV_TO_MEV
-    << ' ' << p.mass() / GEV_TO_MEV
-    // The spacetime origin is currently used as the initial position 4-vector
-    // for all particles
-    << " 0. 0. 0. 0." << '\n';
+  append_scientific( buffer, p.px() / GEV_TO_MEV );
+  buffer += ' ';
+  append_scientific( buffer, p.py() / GEV_TO_MEV );
+  buffer += ' ';
+  append_scientific( buffer, p.pz() / GEV_TO_MEV );
+  buffer += ' ';
+  append_scientific( buffer, p.total_energy() / GEV_TO_MEV );
+  buffer += ' ';
+  append_scientific( buffer, p.mass() / GEV_TO_MEV );
+
+  // The spacetime origin is currently used as the initial position 4-vector
+  // for all particles
+  buffer += " 0. 0. 0. 0.\n";
 }
 
 void marley::Event::write_hepevt(size_t event_num, double flux_avg_tot_xsec,
   std::ostream& out) const
 {
-  // Use an temporary ostringstream object so that we can ensure all
-  // floating-point values are output with full precision without disturbing
-  // the user's settings in the "out" stream.
-  std::ostringstream temp;
-  temp.precision( std::numeric_limits<double>::max_digits10 );
-  temp << std::scientific;
+  // Render the record into a temporary string so that the user's settings
+  // in the "out" stream are not disturbed
+  std::string temp;
+  write_hepevt( event_num, flux_avg_tot_xsec, temp );
+  out.write( temp.data(), temp.size() );
+}
 
+void marley::Event::write_hepevt(size_t event_num, double flux_avg_tot_xsec,
+  std::string& buffer) const
+{
   // Create a dummy particle that encodes extra MARLEY-specific information in
   // the HEPEVT format. Preserve MARLEY natural units for these quantities
   // (MeV) by pre-multiplying by the conversion factor used in
-  // dump_hepevt_particle()
+  // dump_hepevt_particle(). The event weight and time are stored in the
+  // x- and y-components of the momentum, respectively.
   marley::Particle dummy_particle;
   dummy_particle.set_total_energy( Ex_ * GEV_TO_MEV );
   dummy_particle.set_mass( flux_avg_tot_xsec * GEV_TO_MEV );
+  dummy_particle.set_px( weight_ * GEV_TO_MEV );
+  dummy_particle.set_py( time_ * GEV_TO_MEV );
 
   // Add one to the total particle count so that our dummy particle will be
   // included correctly
   size_t num_particles = 1 + initial_particles_.size()
     + final_particles_.size();
 
+  // Each particle entry takes fewer than 192 characters
+  buffer.reserve( buffer.size() + 32u + 192u*num_particles );
+
   // Write the HEPEVT header line to the event record
-  temp << event_num  << ' ' << num_particles << '\n';
+  append_unsigned( buffer, event_num );
+  buffer += ' ';
+  append_unsigned( buffer, num_particles );
+  buffer += '\n';
 
   // Write the initial particles to the event record
-  for (const auto i : initial_particles_) dump_hepevt_particle(*i, temp,
+  for (const auto& i : initial_particles_) dump_hepevt_particle(i, buffer,
     HEPEVT_INITIAL_STATE_STATUS_CODE);
 
   // Write our dummy particle to the event record
   // We use the jmohep1 slot to record the twoJ_ data member and the jmohep2
   // slot to record the parity_ data member (both as integers)
-  dump_hepevt_particle( dummy_particle, temp, HEPEVT_MARLEY_INFO_STATUS_CODE,
-    twoJ_, static_cast<int>(parity_) );
+  dump_hepevt_particle( dummy_particle, buffer,
+    HEPEVT_MARLEY_INFO_STATUS_CODE, twoJ_, static_cast<int>(parity_) );
 
   // Write the final particles to the event record
-  for (const auto f : final_particles_) dump_hepevt_particle(*f, temp,
+  for (const auto& f : final_particles_) dump_hepevt_particle(f, buffer,
     HEPEVT_FINAL_STATE_STATUS_CODE);
-
-  // Output the finished HEPEVT format event to the "out" stream
-  out << temp.str();
 }
 
 marley::JSON marley::Event::to_json() const {
@@ -360,18 +404,53 @@ marley::JSON marley::Event::to_json() const {
   event["Ex"] = Ex_;
   event["twoJ"] = twoJ_;
   event["parity"] = static_cast<int>( parity_ );
+  event["weight"] = weight_;
+  event["time"] = time_;
   event["initial_particles"] = marley::JSON::array();
   event["final_particles"] = marley::JSON::array();
 
-  for (const auto ip : initial_particles_)
-    event.at("initial_particles").append(ip->to_json());
+  for (const auto& ip : initial_particles_)
+    event.at("initial_particles").append(ip.to_json());
 
-  for (const auto fp : final_particles_)
-    event.at("final_particles").append(fp->to_json());
+  for (const auto& fp : final_particles_)
+    event.at("final_particles").append(fp.to_json());
 
   return event;
 }
 
+void marley::Event::write_json(marley::JSONWriter& writer) const {
+  // Members are written in the same (alphabetical) order used by the
+  // std::map inside a marley::JSON object
+  writer.begin_object();
+
+  writer.key( "Ex" );
+  writer.value( Ex_ );
+
+  writer.key( "final_particles" );
+  writer.begin_array();
+  for (const auto& fp : final_particles_) fp.write_json( writer );
+  writer.end_array();
+
+  writer.key( "initial_particles" );
+  writer.begin_array();
+  for (const auto& ip : initial_particles_) ip.write_json( writer );
+  writer.end_array();
+
+  writer.key( "parity" );
+  writer.value( static_cast<int>(parity_) );
+
+  writer.key( "time" );
+  writer.value( time_ );
+
+  writer.key( "twoJ" );
+  writer.value( twoJ_ );
+
+  writer.key( "weight" );
+  writer.value( weight_ );
+
+  writer.end_object();
+}
+
 // Reconstructs a marley::Event object from an input HEPEVT-format event record
 // in an input stream. Returns a boolean that reflects whether the input stream
 // state was still good at the end of the attempt to read the HEPEVT record.
@@ -406,11 +485,12 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
 
   int event_num; // HEPEVT event number (ignored)
   int num_particles; // Total number of particles stored in the event
-  in >> event_num  >> num_particles;
+  marley::TextTokenReader reader( in );
+  reader >> event_num  >> num_particles;
 
   // If reading the first line failed for some
   // reason, just return without trying to do anything else.
-  if ( !in ) return false;
+  if ( !reader ) return false;
 
   // If the number of particles in the event is negative or extremely
   // huge (so that it would overload memory) then throw a marley::Error
@@ -422,28 +502,24 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
       "Event::read_hepevt()");
   }
 
-  // Dummy variables used to skip HEPEVT fields that MARLEY doesn't
-  // care about (e.g., the particle production vertex 4-position)
-  int dummy_int;
-  double dummy_double;
-
-  // Fields that we do care about
+  // Fields that we care about. Others (e.g., the particle production
+  // vertex 4-position) are skipped.
   double Etot, px, py, pz, M;
   int status_code, pdg, jmohep1, jmohep2;
   for ( int p = 0; p < num_particles; ++p ) {
 
-    in >> status_code >> pdg >> jmohep1 >> jmohep2;
+    reader >> status_code >> pdg >> jmohep1 >> jmohep2;
 
     // Skip the JDAHEP1 and JDAHEP2 fields (daughter indices)
-    for ( int j = 0; j < 2; ++j ) in >> dummy_int;
+    reader.skip( 2u );
 
     // Read in the particle 4-momentum and mass.
-    in >> px >> py >> pz >> Etot >> M;
+    reader >> px >> py >> pz >> Etot >> M;
 
     // Skip the VHEP1 through VHEP4 fields (production vertex 4-position)
-    for ( int j = 0; j < 4; ++j ) in >> dummy_double;
+    reader.skip( 4u );
 
-    if ( !in ) throw marley::Error("Parse error while reading  particle #"
+    if ( !reader ) throw marley::Error("Parse error while reading  particle #"
       + std::to_string(p) + " from a HEPEVT-format event record");
 
     // If the particle has this status code, it is a dummy particle that
@@ -465,6 +541,12 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
       // The JMOHEP2 field contains an integer representation of the residue
       // parity immediately following the initial two-two scattering reaction
       parity_ = jmohep2;
+      // The PHEP1 field contains the event weight. Records written before
+      // the weight was added leave it equal to zero. Since a generated event
+      // never has zero weight, interpret that value as unit weight.
+      weight_ = ( px == 0. ) ? 1. : px;
+      // The PHEP2 field contains the time (zero in older records)
+      time_ = py;
     }
 
     // If the particle has a status code other than the two used by
@@ -484,15 +566,13 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
     // by MARLEY above, so store it in the event object in the appropriate
     // place.
     if ( status_code == HEPEVT_INITIAL_STATE_STATUS_CODE ) {
-      initial_particles_.push_back(
-        new marley::Particle(pdg, Etot, px, py, pz, M) );
+      initial_particles_.emplace_back( pdg, Etot, px, py, pz, M );
       ++initial_state_particles;
       if ( marley_utils::is_ion(pdg) ) ++initial_state_ions;
     }
     else {
       // status_code == HEPEVT_FINAL_STATE_STATUS_CODE
-      final_particles_.push_back(
-        new marley::Particle(pdg, Etot, px, py, pz, M) );
+      final_particles_.emplace_back( pdg, Etot, px, py, pz, M );
       if ( marley_utils::is_lepton(pdg) ) {
         ++final_state_leptons;
         final_lepton_idx = final_particles_.size() - 1;
@@ -527,7 +607,7 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
   // initial_particles_ array to allow easy retrieval of the projectile and
   // target.
   auto target_iter = initial_particles_.begin() + TARGET_INDEX;
-  if ( !marley_utils::is_ion( (*target_iter)->pdg_code() ) ) {
+  if ( !marley_utils::is_ion( target_iter->pdg_code() ) ) {
     auto begin_ip = initial_particles_.begin();
     std::iter_swap( begin_ip, begin_ip + 1 );
   }
@@ -562,8 +642,8 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
     if ( f == RESIDUE_INDEX ) continue; // skip the residue
 
     const auto& fp = final_particles_.at( f );
-    int pdg_f = fp->pdg_code();
-    if ( marley_utils::is_ion(pdg_f) ) sum_Q_final_ions += fp->charge();
+    int pdg_f = fp.pdg_code();
+    if ( marley_utils::is_ion(pdg_f) ) sum_Q_final_ions += fp.charge();
   }
   this->residue().set_charge( Qf_ion - sum_Q_final_ions );
 
@@ -572,7 +652,16 @@ bool marley::Event::read_hepevt(std::istream& in, double* flux_avg_tot_xsec)
 }
 
 void marley::Event::from_json(const marley::JSON& json) {
+  this->load_json( json );
+}
 
+void marley::Event::from_json(const marley::JSONValue& json) {
+  this->load_json( json );
+}
+
+template <typename JSONType>
+  void marley::Event::load_json(const JSONType& json)
+{
   // TODO: reduce code duplication in this function
 
   // Remove any existing contents from this event
@@ -602,6 +691,25 @@ void marley::Event::from_json(const marley::JSON& json) {
   if ( !ok ) throw marley::Error("Invalid parity value"
     + temp_parity.to_string() + " encountered in input JSON-format event");
 
+  // The weight key is optional. Events written without it have unit weight.
+  if ( json.has_key("weight") ) {
+    ok = false;
+    const auto& temp_weight = json.at("weight");
+    weight_ = temp_weight.to_double( ok );
+    if ( !ok ) throw marley::Error("Invalid event weight"
+      + temp_weight.to_string() + " encountered in input JSON-format event");
+  }
+
+  // The time key is also optional. It is zero unless a time-dependent source
+  // was used.
+  if ( json.has_key("time") ) {
+    ok = false;
+    const auto& temp_time = json.at("time");
+    time_ = temp_time.to_double( ok );
+    if ( !ok ) throw marley::Error("Invalid event time"
+      + temp_time.to_string() + " encountered in input JSON-format event");
+  }
+
   // Retrieve and load the array of initial particles
   if ( !json.has_key("initial_particles") ) throw marley::Error("Missing"
     " initial particle array in input JSON-format event");
@@ -615,8 +723,8 @@ void marley::Event::from_json(const marley::JSON& json) {
     if ( !p_object.is_object() ) throw marley::Error("Invalid particle"
       " object " + p_object.to_string() + " encountered while parsing a"
       " JSON-format particle array");
-    initial_particles_.push_back( new marley::Particle );
-    initial_particles_.back()->from_json( p_object );
+    initial_particles_.emplace_back();
+    initial_particles_.back().from_json( p_object );
   }
 
   // Retrieve and load the array of final particles
@@ -632,8 +740,8 @@ void marley::Event::from_json(const marley::JSON& json) {
     if ( !p_object.is_object() ) throw marley::Error("Invalid particle"
       " object " + p_object.to_string() + " encountered while parsing a"
       " JSON-format particle array");
-    final_particles_.push_back( new marley::Particle );
-    final_particles_.back()->from_json( p_object );
+    final_particles_.emplace_back();
+    final_particles_.back().from_json( p_object );
   }
 
 }
@@ -652,14 +760,16 @@ void marley::Event::print_human_readable(std::ostream& out, int num) const {
   if ( twoJ_is_odd ) out << twoJ << "/2";
   else out << twoJ / 2;
   out << this->parity() << '\n';
+  if ( weight_ != 1. ) out << "The event has weight " << weight_ << '\n';
+  if ( time_ != 0. ) out << "The projectile was emitted at time " << time_
+    << '\n';
 
   out << "Initial particles" << '\n';
-  marley::Particle* p = NULL;
-  for (size_t i = 0u; i < this->get_initial_particles().size(); ++i) {
-    print_particle_info( out, *this->get_initial_particles().at(i) );
+  for ( const auto& p : this->get_initial_particles() ) {
+    print_particle_info( out, p );
   }
   out << "Final particles" << '\n';
-  for (size_t i = 0u; i < this->get_final_particles().size(); ++i) {
-    print_particle_info( out, *this->get_final_particles().at(i) );
+  for ( const auto& p : this->get_final_particles() ) {
+    print_particle_info( out, p );
   }
 }
@@ -0,0 +1,165 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <string>
+
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventBatch.hh"
+
+namespace {
+
+  // Appends the values from positions [first, first + count) of a column to
+  // the end of another one
+  template <typename T> void append_column(std::vector<T>& column,
+    const std::vector<T>& source, size_t first, size_t count)
+  {
+    column.insert( column.end(), source.begin() + first,
+      source.begin() + first + count );
+  }
+
+}
+
+void marley::EventBatch::add_event(const marley::Event& ev) {
+
+  Exs_.push_back( ev.Ex() );
+  twoJs_.push_back( ev.twoJ() );
+  parities_.push_back( static_cast<int>(ev.parity()) );
+  weights_.push_back( ev.weight() );
+  times_.push_back( ev.time() );
+  num_initials_.push_back( ev.initial_particle_count() );
+  num_finals_.push_back( ev.final_particle_count() );
+  first_particles_.push_back( pdgs_.size() );
+
+  auto add_particle = [this](const marley::Particle& p) -> void {
+    pdgs_.push_back( p.pdg_code() );
+    Es_.push_back( p.total_energy() );
+    pxs_.push_back( p.px() );
+    pys_.push_back( p.py() );
+    pzs_.push_back( p.pz() );
+    masses_.push_back( p.mass() );
+    charges_.push_back( static_cast<int32_t>(p.charge()) );
+  };
+
+  for ( const auto& p : ev.get_initial_particles() ) add_particle( p );
+  for ( const auto& p : ev.get_final_particles() ) add_particle( p );
+}
+
+void marley::EventBatch::append(const marley::EventBatch& other,
+  size_t first, size_t count)
+{
+  if ( first > other.size() || count > other.size() - first ) {
+    throw marley::Error( "Invalid event range passed to"
+      " marley::EventBatch::append()" );
+  }
+  if ( count == 0u ) return;
+
+  size_t particle_begin = other.first_particles_[ first ];
+  size_t particle_end = ( first + count < other.size() )
+    ? other.first_particles_[ first + count ] : other.num_particles();
+  size_t num_particles = particle_end - particle_begin;
+
+  append_column( Exs_, other.Exs_, first, count );
+  append_column( twoJs_, other.twoJs_, first, count );
+  append_column( parities_, other.parities_, first, count );
+  append_column( weights_, other.weights_, first, count );
+  append_column( times_, other.times_, first, count );
+  append_column( num_initials_, other.num_initials_, first, count );
+  append_column( num_finals_, other.num_finals_, first, count );
+
+  // Shift the particle indices to account for the particles already
+  // stored in this batch
+  size_t shift = pdgs_.size();
+  for ( size_t e = first; e < first + count; ++e ) {
+    first_particles_.push_back( other.first_particles_[e] - particle_begin
+      + shift );
+  }
+
+  append_column( pdgs_, other.pdgs_, particle_begin, num_particles );
+  append_column( Es_, other.Es_, particle_begin, num_particles );
+  append_column( pxs_, other.pxs_, particle_begin, num_particles );
+  append_column( pys_, other.pys_, particle_begin, num_particles );
+  append_column( pzs_, other.pzs_, particle_begin, num_particles );
+  append_column( masses_, other.masses_, particle_begin, num_particles );
+  append_column( charges_, other.charges_, particle_begin, num_particles );
+}
+
+void marley::EventBatch::clear() {
+  Exs_.clear();
+  twoJs_.clear();
+  parities_.clear();
+  weights_.clear();
+  times_.clear();
+  num_initials_.clear();
+  num_finals_.clear();
+  first_particles_.clear();
+  pdgs_.clear();
+  Es_.clear();
+  pxs_.clear();
+  pys_.clear();
+  pzs_.clear();
+  masses_.clear();
+  charges_.clear();
+}
+
+void marley::EventBatch::reserve(size_t num_events, size_t num_particles) {
+  Exs_.reserve( num_events );
+  twoJs_.reserve( num_events );
+  parities_.reserve( num_events );
+  weights_.reserve( num_events );
+  times_.reserve( num_events );
+  num_initials_.reserve( num_events );
+  num_finals_.reserve( num_events );
+  first_particles_.reserve( num_events );
+  pdgs_.reserve( num_particles );
+  Es_.reserve( num_particles );
+  pxs_.reserve( num_particles );
+  pys_.reserve( num_particles );
+  pzs_.reserve( num_particles );
+  masses_.reserve( num_particles );
+  charges_.reserve( num_particles );
+}
+
+void marley::EventBatch::get_event(size_t index, marley::Event& ev) const
+{
+  if ( index >= this->size() ) throw marley::Error( "Invalid event index "
+    + std::to_string(index) + " passed to"
+    " marley::EventBatch::get_event()" );
+
+  size_t k = first_particles_[ index ];
+  auto particle = [this](size_t j) -> marley::Particle {
+    return marley::Particle( pdgs_[j], Es_[j], pxs_[j], pys_[j], pzs_[j],
+      masses_[j], charges_[j] );
+  };
+
+  int num_initial = num_initials_[ index ];
+  int num_final = num_finals_[ index ];
+
+  // The first two initial and final particles are the projectile, target,
+  // ejectile, and residue
+  ev = marley::Event( particle(k), particle(k + 1u),
+    particle(k + num_initial), particle(k + num_initial + 1u),
+    Exs_[ index ], twoJs_[ index ], marley::Parity(parities_[ index ]) );
+  ev.set_weight( weights_[ index ] );
+  ev.set_time( times_[ index ] );
+
+  for ( int i = 2; i < num_initial; ++i ) {
+    ev.add_initial_particle( particle(k + i) );
+  }
+  for ( int f = 2; f < num_final; ++f ) {
+    ev.add_final_particle( particle(k + num_initial + f) );
+  }
+}
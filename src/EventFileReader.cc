@@ -15,6 +15,7 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 // Standard library includes
+#include <algorithm>
 #include <iterator>
 
 // MARLEY includes
@@ -24,11 +25,36 @@
 #include "marley/EventFileReader.hh"
 
 marley::EventFileReader::EventFileReader(
-  const std::string& file_name) : file_name_(file_name),
-  json_event_array_(),
-  json_event_array_wrapper_( json_event_array_.array_range() ),
-  json_event_iter_( json_event_array_wrapper_.end() )
+  const std::string& file_name) : file_name_(file_name)
 {
+  // A pattern selects every part written using it, unless a file with that
+  // exact name exists
+  if ( marley::RotatingOutputFile::is_pattern(file_name)
+    && !std::ifstream(file_name).good() )
+  {
+    part_names_ = marley::RotatingOutputFile::find_parts( file_name );
+    if ( part_names_.empty() ) throw marley::Error("Could not find any"
+      " parts matching the file name pattern \"" + file_name + '\"');
+    file_name_ = part_names_.front();
+    next_part_ = 1u;
+  }
+}
+
+void marley::EventFileReader::open_input(std::ios::openmode mode) {
+  // Detach any decompressor left over from a previous opening of the file
+  std::istream& is = in_;
+  is.rdbuf( in_.rdbuf() );
+  decompressor_.reset();
+
+  in_.close();
+  in_.open( file_name_, mode );
+
+  // Compressed files may be read transparently in any of the formats
+  if ( in_ && marley::DecompressingStreamBuf::is_compressed(*in_.rdbuf()) ) {
+    decompressor_ = std::make_unique<marley::DecompressingStreamBuf>(
+      in_.rdbuf() );
+    is.rdbuf( decompressor_.get() );
+  }
 }
 
 // Try to read an event from the file using each possible format. If we
@@ -44,6 +70,23 @@ bool marley::EventFileReader::deduce_file_format() {
   if ( fm.find_file(file_name_, "").empty() ) throw marley::Error("Could"
     " not read from the file \"" + file_name_ + '\"');
 
+  // If the file starts with a valid binary header, then it was written in
+  // MARLEY's native binary format
+  this->open_input( std::ios::in | std::ios::binary );
+  marley::BinaryEventBlock::Header header;
+  if ( marley::BinaryEventBlock::read_header(in_, header) ) {
+    if ( header.layout != marley::BinaryEventBlock::Layout::event ) {
+      throw marley::Error("The binary file \"" + file_name_ + "\" uses the"
+        " kinematics layout, which cannot be read back as marley::Event"
+        " objects");
+    }
+    format_ = marley::OutputFile::Format::BINARY;
+    flux_avg_tot_xs_ = header.flux_avg_tot_xsec;
+    binary_format_version_ = header.format_version;
+    binary_precision_ = header.precision;
+    return true;
+  }
+
   // Temporarily turn off logging of marley::Error messages for the
   // try/catch blocks below. Otherwise, we'll end up with lots of noise
   // in the Logger from this function.
@@ -56,7 +99,7 @@ bool marley::EventFileReader::deduce_file_format() {
 
   // If the first character in the file is '{', then
   // assume that the file is a JSON output file
-  in_.open( file_name_ );
+  this->open_input( std::ios::in );
   char temp_char;
   if ( in_ >> temp_char && temp_char == '{' ) {
     format_ = marley::OutputFile::Format::JSON;
@@ -117,6 +160,13 @@ void marley::EventFileReader::initialize() {
       // No further preparation is needed to read the HEPEVT format
       break;
 
+    case marley::OutputFile::Format::BINARY:
+      // The header was already read by deduce_file_format(). Event blocks
+      // will be loaded as needed by next_event().
+      binary_block_.clear();
+      binary_event_index_ = 0u;
+      break;
+
     case marley::OutputFile::Format::JSON: {
 
       // Turn off auto-logging of marley::Error objects so that
@@ -125,18 +175,24 @@ void marley::EventFileReader::initialize() {
       marley::Error::set_logging_status( false );
 
       try {
-        auto json = marley::JSON::load( in_ );
-
+        // Uncompressed files are parsed in place from a memory mapping.
+        // Otherwise, the decompressed text is handed over to the document.
+        if ( decompressor_ ) {
+          std::string text( (std::istreambuf_iterator<char>(in_)),
+            std::istreambuf_iterator<char>() );
+          json_doc_ = marley::JSONDocument( std::move(text) );
+        }
+        else json_doc_ = marley::JSONDocument::load_file( file_name_ );
+
+        auto json = json_doc_.root();
         flux_avg_tot_xs_ = json.at("gen_state").at("flux_avg_xsec")
           .to_double();
 
-        json_event_array_ = json.at("events");
-        json_event_array_wrapper_ = json_event_array_.array_range();
-        json_event_iter_ = json_event_array_wrapper_.begin();
-        // Move the iterator to "one before the beginning" so that
-        // we get the correct behavior in next_event() and
-        // operator bool()
-        --json_event_iter_;
+        json_events_.clear();
+        for ( const auto& ev_json : json.at("events").array_range() ) {
+          json_events_.push_back( ev_json );
+        }
+        json_event_index_ = 0u;
       }
       catch (const std::exception& err) {
         // Rethrow the error after adding commentary
@@ -178,12 +234,19 @@ bool marley::EventFileReader::next_event( marley::Event& ev )
       if ( ev.read_hepevt(in_, &flux_avg_tot_xs_) ) return true;
       break;
 
+    case marley::OutputFile::Format::BINARY:
+      if ( this->load_binary_events() ) {
+        binary_block_.get_event( binary_event_index_++, ev );
+        return true;
+      }
+      break;
+
     case marley::OutputFile::Format::JSON:
-      ++json_event_iter_;
-      if ( json_event_iter_ != json_event_array_wrapper_.end() ) {
-        ev.from_json( *json_event_iter_ );
+      if ( json_event_index_ < json_events_.size() ) {
+        ev.from_json( json_events_.at(json_event_index_++) );
         return true;
       }
+      json_event_index_ = json_events_.size() + 1u;
       break;
 
     default:
@@ -191,10 +254,120 @@ bool marley::EventFileReader::next_event( marley::Event& ev )
         " marley::EventFileReader::next_event()");
   }
 
+  // Continue with the next part (if any)
+  if ( this->open_next_part() ) return this->next_event( ev );
+
   ev = marley::Event();
   return false;
 }
 
+bool marley::EventFileReader::load_binary_events() {
+  // Load the next event block if the current one has been used up. The
+  // metadata record (or the end of the file) follows the last block.
+  bool ok = true;
+  while ( ok && binary_event_index_ >= binary_block_.size() ) {
+    marley::BinaryEventBlock::RecordTag tag;
+    ok = marley::BinaryEventBlock::read_tag( in_, tag )
+      && tag == marley::BinaryEventBlock::RecordTag::events
+      && binary_block_.read( in_, binary_format_version_,
+        binary_precision_ );
+    binary_event_index_ = 0u;
+  }
+
+  if ( !ok ) {
+    binary_block_.clear();
+    in_.setstate( std::ios::failbit );
+  }
+  return ok;
+}
+
+size_t marley::EventFileReader::next_events( size_t max_events,
+  marley::EventBatch& batch )
+{
+  this->ensure_initialized();
+  batch.clear();
+
+  if ( format_ == marley::OutputFile::Format::BINARY ) {
+    // Copy the columns for as many events as possible from each block. A
+    // batch may span more than one part.
+    do {
+      while ( batch.size() < max_events && this->load_binary_events() ) {
+        size_t count = std::min( max_events - batch.size(),
+          binary_block_.size() - binary_event_index_ );
+        batch.append( binary_block_, binary_event_index_, count );
+        binary_event_index_ += count;
+      }
+    } while ( batch.size() < max_events && this->open_next_part() );
+    return batch.size();
+  }
+
+  marley::Event ev;
+  while ( batch.size() < max_events && this->next_event(ev) ) {
+    batch.add_event( ev );
+  }
+  return batch.size();
+}
+
+bool marley::EventFileReader::get_index_entry( size_t event_index,
+  marley::EventIndex::Entry& entry )
+{
+  if ( !index_in_.is_open() ) {
+    std::string index_name = marley::EventIndex::file_name( file_name_ );
+    index_in_.open( index_name, std::ios::in | std::ios::binary );
+    if ( !index_in_ ) throw marley::Error("Could not open the index file \""
+      + index_name + "\" for the events in \"" + file_name_ + '\"');
+    if ( !marley::EventIndex::read_header(index_in_) ) {
+      index_in_.close();
+      throw marley::Error("The file \"" + index_name + "\" is not a MARLEY"
+        " event index file");
+    }
+  }
+
+  return marley::EventIndex::read_entry( index_in_, event_index, entry );
+}
+
+bool marley::EventFileReader::seek_event( size_t event_index )
+{
+  this->ensure_initialized();
+
+  if ( !part_names_.empty() ) throw marley::Error("Cannot seek to an event"
+    " in a set of parts. Please read the part \"" + file_name_ + "\" (or"
+    " another one) on its own instead.");
+
+  // The whole event array is already in memory for the JSON format
+  if ( format_ == marley::OutputFile::Format::JSON ) {
+    if ( event_index >= json_events_.size() ) return false;
+    json_event_index_ = event_index;
+    return true;
+  }
+
+  if ( decompressor_ ) throw marley::Error("Cannot seek to an event in the"
+    " compressed file \"" + file_name_ + '\"');
+
+  marley::EventIndex::Entry entry;
+  if ( !this->get_index_entry(event_index, entry) ) return false;
+
+  in_.clear();
+  in_.seekg( entry.offset );
+
+  if ( format_ == marley::OutputFile::Format::BINARY ) {
+    marley::BinaryEventBlock::RecordTag tag;
+    bool ok = marley::BinaryEventBlock::read_tag( in_, tag )
+      && tag == marley::BinaryEventBlock::RecordTag::events
+      && binary_block_.read( in_, binary_format_version_,
+        binary_precision_ )
+      && entry.sub_index < binary_block_.size();
+    if ( !ok ) {
+      binary_block_.clear();
+      in_.setstate( std::ios::failbit );
+      return false;
+    }
+    binary_event_index_ = entry.sub_index;
+  }
+
+  return static_cast<bool>( in_ );
+}
+
 marley::EventFileReader::operator bool() const {
 
   switch ( format_ ) {
@@ -205,11 +378,12 @@ marley::EventFileReader::operator bool() const {
 
     case marley::OutputFile::Format::ASCII:
     case marley::OutputFile::Format::HEPEVT:
+    case marley::OutputFile::Format::BINARY:
       return static_cast<bool>( in_ );
       break;
 
     case marley::OutputFile::Format::JSON:
-      return ( json_event_iter_ != json_event_array_wrapper_.end() );
+      return ( json_event_index_ <= json_events_.size() );
       break;
 
     default:
@@ -220,6 +394,24 @@ marley::EventFileReader::operator bool() const {
   return false;
 }
 
+bool marley::EventFileReader::open_next_part() {
+  if ( next_part_ >= part_names_.size() ) return false;
+  file_name_ = part_names_.at( next_part_++ );
+
+  // Discard the state left over from the previous part
+  index_in_.close();
+  json_events_.clear();
+  json_doc_ = marley::JSONDocument();
+  json_event_index_ = 0u;
+  binary_block_.clear();
+  binary_event_index_ = 0u;
+  flux_avg_tot_xs_ = 0.;
+
+  initialized_ = false;
+  this->ensure_initialized();
+  return true;
+}
+
 void marley::EventFileReader::ensure_initialized() {
   if ( !initialized_ ) {
     if ( !this->deduce_file_format() ) throw marley::Error("Could not"
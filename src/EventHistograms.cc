@@ -0,0 +1,278 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventHistograms.hh"
+#include "marley/EventSummary.hh"
+#include "marley/Particle.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  using Observable = marley::EventHistograms::Observable;
+
+  const std::map<std::string, Observable> observable_map = {
+    { "Ev", Observable::Ev },
+    { "ejectile_KE", Observable::EjectileKE },
+    { "Ex", Observable::Ex },
+    { "visible_energy", Observable::VisibleEnergy },
+    { "num_products", Observable::NumProducts },
+    { "num_gammas", Observable::NumGammas },
+    { "num_neutrons", Observable::NumNeutrons },
+    { "num_protons", Observable::NumProtons },
+    { "num_alphas", Observable::NumAlphas },
+  };
+
+  // Counts the de-excitation products with a given PDG code
+  double count_products( const marley::Event& ev, int pdg ) {
+    int count = 0;
+    const auto& fps = ev.get_final_particles();
+    for ( size_t p = marley::EventSummary::FIRST_PRODUCT_INDEX;
+      p < fps.size(); ++p )
+    {
+      if ( fps[ p ].pdg_code() == pdg ) ++count;
+    }
+    return count;
+  }
+
+}
+
+marley::EventHistograms::EventHistograms( const marley::JSON& specs ) {
+
+  if ( !specs.is_array() ) throw marley::Error( "The histogram"
+    " specifications must be given as a JSON array" );
+
+  for ( const auto& spec : specs.array_range() ) {
+    if ( !spec.is_object() || !spec.has_key("name") ) throw marley::Error(
+      "Invalid histogram specification " + spec.dump_string()
+      + " encountered. Each histogram must be a JSON object with a name." );
+
+    Histogram hist;
+    bool ok = false;
+    hist.name = spec.at( "name" ).to_string( ok );
+    if ( !ok || hist.name.empty() ) throw marley::Error( "Invalid histogram"
+      " name " + spec.at("name").dump_string() + " encountered" );
+
+    for ( const auto& h : histograms_ ) {
+      if ( h.name == hist.name ) throw marley::Error( "The histogram name \""
+        + hist.name + "\" was used more than once" );
+    }
+
+    hist.x = make_axis( spec, hist.name, "" );
+    size_t num_bins = hist.x.bins + 2;
+
+    hist.two_dim = spec.has_key( "y" );
+    if ( hist.two_dim ) {
+      hist.y = make_axis( spec, hist.name, "y_" );
+      num_bins *= hist.y.bins + 2;
+    }
+
+    hist.sum_w.assign( num_bins, 0. );
+    hist.sum_w2.assign( num_bins, 0. );
+    histograms_.push_back( std::move(hist) );
+  }
+}
+
+marley::EventHistograms::Axis marley::EventHistograms::make_axis(
+  const marley::JSON& spec, const std::string& hname,
+  const std::string& prefix )
+{
+  // The observable for the x axis is given by the "x" key
+  std::string obs_key = prefix.empty() ? "x" : prefix.substr( 0, 1 );
+  std::string bins_key = prefix + "bins";
+  std::string min_key = prefix + "min";
+  std::string max_key = prefix + "max";
+
+  for ( const auto& key : { obs_key, bins_key, min_key, max_key } ) {
+    if ( !spec.has_key(key) ) throw marley::Error( "Missing \"" + key
+      + "\" key in the specification for the histogram \"" + hname + '\"' );
+  }
+
+  Axis axis;
+  bool ok = false;
+  axis.name = spec.at( obs_key ).to_string( ok );
+  if ( !ok ) throw marley::Error( "Invalid observable "
+    + spec.at(obs_key).dump_string() + " given for the histogram \""
+    + hname + '\"' );
+  axis.obs = observable_from_name( axis.name );
+
+  bool ok_bins = false;
+  bool ok_min = false;
+  bool ok_max = false;
+  axis.bins = spec.at( bins_key ).to_long( ok_bins );
+  axis.min = spec.at( min_key ).to_double( ok_min );
+  axis.max = spec.at( max_key ).to_double( ok_max );
+  if ( !ok_bins || !ok_min || !ok_max || axis.bins < 1
+    || !(axis.max > axis.min) )
+  {
+    throw marley::Error( "Invalid binning (" + bins_key + ", " + min_key
+      + ", " + max_key + ") given for the histogram \"" + hname + "\". The"
+      " number of bins must be positive, and the maximum must exceed the"
+      " minimum." );
+  }
+
+  return axis;
+}
+
+int marley::EventHistograms::Axis::find_bin( double value ) const {
+  if ( value < min ) return 0;
+  if ( value >= max ) return bins + 1;
+  int bin = 1 + static_cast<int>( bins * (value - min) / (max - min) );
+  // Guard against roundoff at the upper edge
+  return std::min( bin, bins );
+}
+
+void marley::EventHistograms::fill( const marley::Event& ev ) {
+  double w = ev.weight();
+  for ( auto& hist : histograms_ ) {
+    size_t bin = hist.x.find_bin( evaluate(hist.x.obs, ev) );
+    if ( hist.two_dim ) {
+      bin += ( hist.x.bins + 2 ) * hist.y.find_bin( evaluate(hist.y.obs,
+        ev) );
+    }
+    hist.sum_w[ bin ] += w;
+    hist.sum_w2[ bin ] += w * w;
+  }
+  ++num_events_;
+}
+
+void marley::EventHistograms::merge( const marley::EventHistograms& other ) {
+  if ( other.histograms_.size() != histograms_.size() ) throw marley::Error(
+    "Cannot merge sets of histograms that were built from different"
+    " specifications" );
+
+  for ( size_t h = 0u; h < histograms_.size(); ++h ) {
+    auto& hist = histograms_[ h ];
+    const auto& other_hist = other.histograms_[ h ];
+    if ( other_hist.name != hist.name
+      || other_hist.sum_w.size() != hist.sum_w.size() )
+    {
+      throw marley::Error( "Cannot merge sets of histograms that were built"
+        " from different specifications" );
+    }
+    for ( size_t b = 0u; b < hist.sum_w.size(); ++b ) {
+      hist.sum_w[ b ] += other_hist.sum_w[ b ];
+      hist.sum_w2[ b ] += other_hist.sum_w2[ b ];
+    }
+  }
+  num_events_ += other.num_events_;
+}
+
+marley::JSON marley::EventHistograms::to_json( double xsec ) const {
+
+  auto axis_json = []( const Axis& axis ) -> marley::JSON {
+    marley::JSON result = marley::JSON::object();
+    result[ "observable" ] = marley::JSON( axis.name );
+    result[ "bins" ] = axis.bins;
+    result[ "min" ] = axis.min;
+    result[ "max" ] = axis.max;
+    return result;
+  };
+
+  auto values_json = []( const std::vector<double>& values ) -> marley::JSON
+  {
+    marley::JSON result = marley::JSON::array();
+    for ( double v : values ) result.append( v );
+    return result;
+  };
+
+  marley::JSON hists = marley::JSON::array();
+  for ( const auto& hist : histograms_ ) {
+    marley::JSON h = marley::JSON::object();
+    h[ "name" ] = marley::JSON( hist.name );
+    h[ "x" ] = axis_json( hist.x );
+    if ( hist.two_dim ) h[ "y" ] = axis_json( hist.y );
+    h[ "sum_w" ] = values_json( hist.sum_w );
+    h[ "sum_w2" ] = values_json( hist.sum_w2 );
+    hists.append( h );
+  }
+
+  marley::JSON result = marley::JSON::object();
+  result[ "events" ] = num_events_;
+  result[ "flux_avg_tot_xsec" ] = xsec;
+  result[ "histograms" ] = hists;
+  return result;
+}
+
+void marley::EventHistograms::write( const std::string& file_name,
+  double xsec ) const
+{
+  std::ofstream out( file_name );
+  if ( !out ) throw marley::Error( "Could not open the histogram file \""
+    + file_name + "\" for writing" );
+  out << to_json( xsec ).dump_string( 2 ) << '\n';
+}
+
+marley::EventHistograms::Observable
+  marley::EventHistograms::observable_from_name( const std::string& name )
+{
+  auto iter = observable_map.find( name );
+  if ( iter == observable_map.end() ) throw marley::Error( "Unrecognized"
+    " histogram observable \"" + name + "\". Allowed values are "
+    + observable_names() + '.' );
+  return iter->second;
+}
+
+std::string marley::EventHistograms::observable_names() {
+  std::string names;
+  for ( const auto& pair : observable_map ) {
+    if ( !names.empty() ) names += ", ";
+    names += '\"' + pair.first + '\"';
+  }
+  return names;
+}
+
+double marley::EventHistograms::evaluate( Observable obs,
+  const marley::Event& ev )
+{
+  switch ( obs ) {
+    case Observable::Ev: return ev.projectile().total_energy();
+    case Observable::EjectileKE: return ev.ejectile().kinetic_energy();
+    case Observable::Ex: return ev.Ex();
+    case Observable::VisibleEnergy: {
+      // The residue is skipped, since nuclear recoils are heavily quenched
+      double E_vis = 0.;
+      const auto& fps = ev.get_final_particles();
+      for ( size_t p = 0u; p < fps.size(); ++p ) {
+        if ( &fps[ p ] == &ev.residue() ) continue;
+        int pdg = fps[ p ].pdg_code();
+        if ( fps[ p ].charge() != 0. || pdg == marley_utils::PHOTON ) {
+          E_vis += fps[ p ].kinetic_energy();
+        }
+      }
+      return E_vis;
+    }
+    case Observable::NumProducts:
+      return ev.final_particle_count()
+        - marley::EventSummary::FIRST_PRODUCT_INDEX;
+    case Observable::NumGammas:
+      return count_products( ev, marley_utils::PHOTON );
+    case Observable::NumNeutrons:
+      return count_products( ev, marley_utils::NEUTRON );
+    case Observable::NumProtons:
+      return count_products( ev, marley_utils::PROTON );
+    case Observable::NumAlphas:
+      return count_products( ev, marley_utils::ALPHA );
+  }
+  return 0.;
+}
@@ -0,0 +1,103 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include "marley/EventIndex.hh"
+
+// Identifies a MARLEY event index file
+const std::string marley::EventIndex::MAGIC = "MARLEYIX";
+
+namespace {
+
+  // Index files store every value as a little-endian unsigned integer.
+  // Building the bytes with shifts makes this independent of the host byte
+  // order.
+  template <typename T> void put_le(char* buffer, T value) {
+    for ( size_t b = 0u; b < sizeof(T); ++b ) {
+      buffer[b] = static_cast<char>( (value >> (8u*b)) & 0xFFu );
+    }
+  }
+
+  template <typename T> T get_le(const char* buffer) {
+    T value = 0u;
+    for ( size_t b = 0u; b < sizeof(T); ++b ) {
+      value |= static_cast<T>( static_cast<unsigned char>(buffer[b]) )
+        << (8u*b);
+    }
+    return value;
+  }
+
+  // Byte positions of the members of an entry
+  constexpr size_t OFFSET_POS = 0u;
+  constexpr size_t SUB_INDEX_POS = 8u;
+  constexpr size_t FLAGS_POS = 12u;
+  constexpr size_t SEED_POS = 16u;
+  constexpr size_t STREAM_ID_POS = 24u;
+  constexpr size_t EVENT_NUMBER_POS = 32u;
+
+  // Bit flag used to record whether the counter-based random number engine
+  // was used
+  constexpr uint32_t COUNTER_BASED_FLAG = 1u;
+}
+
+void marley::EventIndex::write_header(std::ostream& out) {
+  char buffer[ HEADER_SIZE ];
+  MAGIC.copy( buffer, MAGIC.size() );
+  put_le<uint32_t>( buffer + 8, FORMAT_VERSION );
+  put_le<uint32_t>( buffer + 12, 0u );
+  out.write( buffer, HEADER_SIZE );
+}
+
+bool marley::EventIndex::read_header(std::istream& in) {
+  char buffer[ HEADER_SIZE ];
+  in.read( buffer, HEADER_SIZE );
+  if ( !in ) return false;
+  if ( std::string(buffer, MAGIC.size()) != MAGIC ) return false;
+  return get_le<uint32_t>( buffer + 8 ) == FORMAT_VERSION;
+}
+
+void marley::EventIndex::write_entry(std::ostream& out, const Entry& entry)
+{
+  char buffer[ ENTRY_SIZE ];
+  put_le<uint64_t>( buffer + OFFSET_POS, entry.offset );
+  put_le<uint32_t>( buffer + SUB_INDEX_POS, entry.sub_index );
+  put_le<uint32_t>( buffer + FLAGS_POS,
+    entry.counter_based ? COUNTER_BASED_FLAG : 0u );
+  put_le<uint64_t>( buffer + SEED_POS, entry.seed );
+  put_le<uint64_t>( buffer + STREAM_ID_POS, entry.stream_id );
+  put_le<uint64_t>( buffer + EVENT_NUMBER_POS, entry.event_number );
+  out.write( buffer, ENTRY_SIZE );
+}
+
+bool marley::EventIndex::read_entry(std::istream& in, uint64_t event_index,
+  Entry& entry)
+{
+  in.clear();
+  in.seekg( HEADER_SIZE + static_cast<std::streamoff>(event_index)
+    * ENTRY_SIZE );
+
+  char buffer[ ENTRY_SIZE ];
+  in.read( buffer, ENTRY_SIZE );
+  if ( !in ) return false;
+
+  entry.offset = get_le<uint64_t>( buffer + OFFSET_POS );
+  entry.sub_index = get_le<uint32_t>( buffer + SUB_INDEX_POS );
+  entry.counter_based = ( get_le<uint32_t>(buffer + FLAGS_POS)
+    & COUNTER_BASED_FLAG ) != 0u;
+  entry.seed = get_le<uint64_t>( buffer + SEED_POS );
+  entry.stream_id = get_le<uint64_t>( buffer + STREAM_ID_POS );
+  entry.event_number = get_le<uint64_t>( buffer + EVENT_NUMBER_POS );
+  return true;
+}
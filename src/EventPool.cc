@@ -0,0 +1,163 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <string>
+#include <utility>
+
+#include "marley/Error.hh"
+#include "marley/EventPool.hh"
+#include "marley/Instrumentation.hh"
+
+marley::EventPool::EventPool(
+  std::vector< std::unique_ptr<marley::Generator> > generators, size_t depth)
+  : depth_( depth )
+{
+  if ( depth_ == 0u ) throw marley::Error("The depth of a marley::EventPool"
+    " must be positive");
+
+  for ( auto& gen : generators ) {
+    if ( !gen ) throw marley::Error("Null Generator passed to the"
+      " marley::EventPool constructor");
+    channels_.emplace_back( new Channel );
+    channels_.back()->generator = std::move( gen );
+    channels_.back()->slots.resize( depth_ );
+  }
+
+  // Start the producer threads only after all of the channels exist
+  try {
+    for ( size_t c = 0u; c < channels_.size(); ++c ) {
+      channels_[ c ]->thread = std::thread( &EventPool::produce, this, c );
+    }
+  }
+  catch ( ... ) {
+    stop_producers();
+    throw;
+  }
+}
+
+marley::EventPool::~EventPool()
+{
+  stop_producers();
+}
+
+void marley::EventPool::stop_producers()
+{
+  stop_ = true;
+  for ( auto& ch : channels_ ) {
+    {
+      // Holding the lock guarantees that the producer is either waiting
+      // (and will be woken up) or will see stop_ before it next waits
+      std::lock_guard<std::mutex> lock( ch->mutex );
+    }
+    ch->not_full.notify_all();
+  }
+  for ( auto& ch : channels_ ) {
+    if ( ch->thread.joinable() ) ch->thread.join();
+  }
+}
+
+void marley::EventPool::produce( size_t consumer )
+{
+  marley::Instrumentation::set_thread_label( "event pool "
+    + std::to_string(consumer) );
+
+  Channel& ch = *channels_[ consumer ];
+  marley::Event scratch;
+  while ( !stop_ ) {
+    try {
+      ch.generator->create_event( scratch );
+    }
+    catch ( ... ) {
+      std::lock_guard<std::mutex> lock( ch.mutex );
+      ch.error = std::current_exception();
+      ch.not_empty.notify_all();
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock( ch.mutex );
+    ch.not_full.wait( lock, [this, &ch]() -> bool {
+      return stop_ || ch.head - ch.tail < depth_;
+    } );
+    if ( stop_ ) return;
+
+    // The consumer will not access this slot until head is incremented.
+    // Swapping hands the storage of the slot's previous (already consumed)
+    // event back to the producer for reuse.
+    marley::Event& slot = ch.slots[ ch.head % depth_ ];
+    lock.unlock();
+    std::swap( slot, scratch );
+    lock.lock();
+
+    ++ch.head;
+    lock.unlock();
+    ch.not_empty.notify_one();
+  }
+}
+
+void marley::EventPool::take( Channel& ch, std::unique_lock<std::mutex>& lock,
+  marley::Event& ev )
+{
+  // The producer will not access this slot until tail is incremented
+  marley::Event& slot = ch.slots[ ch.tail % depth_ ];
+  lock.unlock();
+  std::swap( slot, ev );
+  lock.lock();
+
+  ++ch.tail;
+  lock.unlock();
+  ch.not_full.notify_one();
+}
+
+void marley::EventPool::pop( size_t consumer, marley::Event& ev )
+{
+  Channel& ch = channel( consumer );
+  std::unique_lock<std::mutex> lock( ch.mutex );
+  ch.not_empty.wait( lock, [&ch]() -> bool {
+    return ch.error || ch.head > ch.tail;
+  } );
+
+  // Hand out any events that were completed before an error occurred
+  if ( ch.head == ch.tail ) std::rethrow_exception( ch.error );
+  take( ch, lock, ev );
+}
+
+bool marley::EventPool::try_pop( size_t consumer, marley::Event& ev )
+{
+  Channel& ch = channel( consumer );
+  std::unique_lock<std::mutex> lock( ch.mutex );
+  if ( ch.head == ch.tail ) {
+    if ( ch.error ) std::rethrow_exception( ch.error );
+    return false;
+  }
+  take( ch, lock, ev );
+  return true;
+}
+
+const marley::Generator& marley::EventPool::get_generator(
+  size_t consumer ) const
+{
+  if ( consumer >= channels_.size() ) throw marley::Error("Invalid consumer"
+    " index " + std::to_string(consumer) + " passed to"
+    " marley::EventPool::get_generator()");
+  return *channels_[ consumer ]->generator;
+}
+
+marley::EventPool::Channel& marley::EventPool::channel( size_t consumer )
+{
+  if ( consumer >= channels_.size() ) throw marley::Error("Invalid consumer"
+    " index " + std::to_string(consumer) + " passed to marley::EventPool");
+  return *channels_[ consumer ];
+}
@@ -0,0 +1,232 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/EventReweighter.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/NeutrinoSource.hh"
+#include "marley/NuclearReaction.hh"
+#include "marley/marley_kinematics.hh"
+
+namespace {
+
+  // Tolerance (MeV) used when matching the excitation energy stored in an
+  // Event to the energy of a final nuclear level. Energies are written to
+  // the output files with enough digits to survive a round trip, so this
+  // only needs to absorb rounding from unit conversions.
+  constexpr double LEVEL_ENERGY_TOLERANCE = 1e-5;
+
+  // Relative tolerance used when matching the projectile energy to that of a
+  // monoenergetic source
+  constexpr double MONO_ENERGY_TOLERANCE = 1e-9;
+
+  // Evaluates the normalized PDF of a source at a projectile energy
+  // recovered from a stored event. Monoenergetic sources use an exact
+  // comparison in their pdf() member function, so they are handled here
+  // with a tolerance instead.
+  double source_pdf(const marley::NeutrinoSource& source, double E) {
+    double Emin = source.get_Emin();
+    if ( Emin == source.get_Emax() ) {
+      if ( std::abs(E - Emin) <= MONO_ENERGY_TOLERANCE * std::max(1., Emin) )
+        return 1.;
+      return 0.;
+    }
+    return source.pdf( E );
+  }
+
+  // Dark matter differential cross section for a single final level. For a
+  // halo source, events are spread over the velocity bins in proportion to
+  // the cross section in each, so the bins are averaged with equal weights.
+  double dm_level_diff_xs(const marley::NuclearReaction& nr,
+    const marley::MatrixElement& me, double KEa,
+    const marley::NeutrinoSource& source, double cos_theta_c_cm)
+  {
+    double mass = source.get_Emax();
+    double cutoff = source.get_Emin();
+
+    const auto* halo = dynamic_cast< const marley::HaloDMSource* >(
+      &source );
+    if ( halo ) {
+      double sum = 0.;
+      size_t num_bins = halo->num_velocity_bins();
+      for ( size_t b = 0u; b < num_bins; ++b ) {
+        sum += nr.dm_diff_xs( me, KEa, mass, halo->bin_velocity(b), cutoff,
+          cos_theta_c_cm );
+      }
+      return sum / num_bins;
+    }
+
+    const auto* mono = dynamic_cast< const marley::MonoDMSource* >(
+      &source );
+    double v = mono ? mono->velocity() : marley_utils::DM_DEFAULT_VELOCITY;
+    return nr.dm_diff_xs( me, KEa, mass, v, cutoff, cos_theta_c_cm );
+  }
+
+  // Returns the cosine of the ejectile scattering angle as measured in the
+  // CM frame of the initial two-particle state
+  double cm_scattering_cosine(const marley::Event& ev) {
+
+    marley::Particle projectile = ev.projectile();
+    marley::Particle ejectile = ev.ejectile();
+    const marley::Particle& target = ev.target();
+
+    double E_tot = projectile.total_energy() + target.total_energy();
+    double beta_x = ( projectile.px() + target.px() ) / E_tot;
+    double beta_y = ( projectile.py() + target.py() ) / E_tot;
+    double beta_z = ( projectile.pz() + target.pz() ) / E_tot;
+
+    marley_kinematics::lorentz_boost( beta_x, beta_y, beta_z, projectile );
+    marley_kinematics::lorentz_boost( beta_x, beta_y, beta_z, ejectile );
+
+    double pa = projectile.momentum_magnitude();
+    double pc = ejectile.momentum_magnitude();
+    if ( pa <= 0. || pc <= 0. ) throw marley::Error("Cannot determine the CM"
+      " frame scattering angle for an event with a vanishing projectile or"
+      " ejectile momentum");
+
+    double cos_theta_c_cm = ( projectile.px()*ejectile.px()
+      + projectile.py()*ejectile.py() + projectile.pz()*ejectile.pz() )
+      / (pa * pc);
+
+    // Guard against values that stray slightly outside of the physical
+    // range due to rounding errors
+    return std::max( -1., std::min(1., cos_theta_c_cm) );
+  }
+
+}
+
+marley::EventReweighter::EventReweighter( const marley::JSONConfig& nominal,
+  const marley::JSONConfig& alternative, Normalization norm )
+  : nominal_( nominal.create_generator() ),
+  alternative_( alternative.create_generator() ), norm_( norm )
+{
+  if ( norm_ == Normalization::SHAPE ) {
+    double nominal_xs = nominal_.flux_averaged_total_xs();
+    double alternative_xs = alternative_.flux_averaged_total_xs();
+    if ( nominal_xs <= 0. || alternative_xs <= 0. ) {
+      throw marley::Error("Shape-only event reweighting requires nonzero"
+        " flux-averaged total cross sections for both configurations");
+    }
+    norm_factor_ = nominal_xs / alternative_xs;
+  }
+}
+
+double marley::EventReweighter::event_density( const marley::Generator& gen,
+  const marley::Event& ev, double cos_theta_c_cm, bool& matched ) const
+{
+  const marley::Particle& projectile = ev.projectile();
+  int pdg_a = projectile.pdg_code();
+  int pdg_b = ev.target().pdg_code();
+  int pdg_c = ev.ejectile().pdg_code();
+  double KEa = projectile.kinetic_energy();
+  double Ex = ev.Ex();
+
+  const auto& source = gen.get_source();
+
+  matched = false;
+  double xs_sum = 0.;
+
+  for ( const auto& r : gen.get_reactions() ) {
+
+    if ( r->pdg_a() != pdg_a || r->pdg_b() != pdg_b ) continue;
+    if ( marley::Reaction::get_ejectile_pdg(pdg_a, r->process_type())
+      != pdg_c ) continue;
+
+    matched = true;
+
+    double atom_frac = gen.get_target().atom_fraction( r->atomic_target() );
+    if ( atom_frac <= 0. ) continue;
+
+    const auto* nr = dynamic_cast<const marley::NuclearReaction*>( r.get() );
+    if ( !nr ) {
+      xs_sum += atom_frac * r->diff_xs( pdg_a, KEa, cos_theta_c_cm );
+      continue;
+    }
+
+    // The matrix elements are sorted in order of increasing level energy,
+    // so we can jump straight to the first one that could match
+    const auto& mes = nr->matrix_elements();
+    auto iter = std::lower_bound( mes.cbegin(), mes.cend(),
+      Ex - LEVEL_ENERGY_TOLERANCE, [](const marley::MatrixElement& me,
+      double E) -> bool { return me.level_energy() < E; } );
+
+    bool dm = ( r->process_type() == marley::Reaction::ProcessType::DM );
+
+    for ( ; iter != mes.cend(); ++iter ) {
+      if ( iter->level_energy() > Ex + LEVEL_ENERGY_TOLERANCE ) break;
+
+      // Dark matter events are created using model parameters taken from
+      // the source in the same way as in Generator::create_event()
+      if ( dm ) xs_sum += atom_frac * dm_level_diff_xs( *nr, *iter, KEa,
+        source, cos_theta_c_cm );
+      else xs_sum += atom_frac * nr->diff_xs( *iter, KEa, cos_theta_c_cm );
+    }
+  }
+
+  // Both configurations may describe different incident spectra, so include
+  // the (normalized) source PDF in the density
+  if ( source.get_pid() != pdg_a ) return 0.;
+
+  return source_pdf( source, projectile.total_energy() ) * xs_sum;
+}
+
+double marley::EventReweighter::weight( const marley::Event& ev ) const {
+
+  double cos_theta_c_cm = cm_scattering_cosine( ev );
+
+  bool matched = false;
+  double nominal_density = event_density( nominal_, ev, cos_theta_c_cm,
+    matched );
+
+  if ( !matched || nominal_density <= 0. ) {
+    throw marley::Error("The nominal configuration could not have produced"
+      " an event with projectile " + std::to_string(ev.projectile().pdg_code())
+      + ", target " + std::to_string(ev.target().pdg_code()) + ", and"
+      " excitation energy " + std::to_string(ev.Ex()) + " MeV");
+  }
+
+  // An event that cannot be produced using the alternative configuration is
+  // simply assigned a weight of zero
+  double alternative_density = event_density( alternative_, ev,
+    cos_theta_c_cm, matched );
+
+  return norm_factor_ * alternative_density / nominal_density;
+}
+
+size_t marley::EventReweighter::reweight( marley::EventFileReader& reader,
+  const std::function<void(const marley::Event&, double)>& callback ) const
+{
+  size_t count = 0u;
+  marley::Event ev;
+  while ( reader.next_event(ev) ) {
+    callback( ev, this->weight(ev) );
+    ++count;
+  }
+  return count;
+}
+
+size_t marley::EventReweighter::reweight( marley::EventFileReader& reader,
+  std::vector<double>& weights ) const
+{
+  return this->reweight( reader, [&weights](const marley::Event&, double w)
+    -> void { weights.push_back( w ); } );
+}
@@ -0,0 +1,367 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "marley/Error.hh"
+#include "marley/EventServer.hh"
+#include "marley/Instrumentation.hh"
+#include "marley/Logger.hh"
+
+namespace {
+
+  // Time between checks for a request to stop the server
+  constexpr int POLL_TIMEOUT_MS = 200;
+
+  // The protocol is little-endian regardless of the host byte order
+  template <typename T> void put_le(std::string& out, T value) {
+    uint64_t bits = 0u;
+    std::memcpy( &bits, &value, sizeof(T) );
+    for ( size_t b = 0u; b < sizeof(T); ++b ) {
+      out.push_back( static_cast<char>((bits >> (8u*b)) & 0xFFu) );
+    }
+  }
+
+  template <typename T> T get_le(const char*& data) {
+    uint64_t bits = 0u;
+    for ( size_t b = 0u; b < sizeof(T); ++b ) {
+      bits |= static_cast<uint64_t>( static_cast<unsigned char>(data[b]) )
+        << (8u*b);
+    }
+    data += sizeof(T);
+    T value;
+    std::memcpy( &value, &bits, sizeof(T) );
+    return value;
+  }
+
+  // Waits until the socket is ready for reading. Returns false if stop
+  // was set before then.
+  bool wait_readable(int fd, const std::atomic<bool>& stop) {
+    pollfd pfd = { fd, POLLIN, 0 };
+    while ( !stop ) {
+      int result = poll( &pfd, 1, POLL_TIMEOUT_MS );
+      if ( result > 0 ) return true;
+      if ( result < 0 && errno != EINTR ) return false;
+    }
+    return false;
+  }
+
+  // Reads exactly size bytes from a socket. Returns false if the connection
+  // was closed (or stop was set) first.
+  bool read_all(int fd, char* data, size_t size,
+    const std::atomic<bool>* stop = nullptr)
+  {
+    while ( size > 0u ) {
+      if ( stop && !wait_readable(fd, *stop) ) return false;
+      ssize_t count = recv( fd, data, size, 0 );
+      if ( count < 0 && errno == EINTR ) continue;
+      if ( count <= 0 ) return false;
+      data += count;
+      size -= static_cast<size_t>( count );
+    }
+    return true;
+  }
+
+  // Writes all of a buffer to a socket. Returns false if the connection was
+  // closed first.
+  bool write_all(int fd, const char* data, size_t size) {
+    while ( size > 0u ) {
+      // Use MSG_NOSIGNAL (where available) so that a client that hangs up
+      // early does not raise SIGPIPE
+      #ifdef MSG_NOSIGNAL
+        ssize_t count = send( fd, data, size, MSG_NOSIGNAL );
+      #else
+        ssize_t count = send( fd, data, size, 0 );
+      #endif
+      if ( count < 0 && errno == EINTR ) continue;
+      if ( count <= 0 ) return false;
+      data += count;
+      size -= static_cast<size_t>( count );
+    }
+    return true;
+  }
+
+  // Fills in the address of a Unix domain socket
+  sockaddr_un socket_address(const std::string& socket_path) {
+    sockaddr_un addr;
+    std::memset( &addr, 0, sizeof(addr) );
+    addr.sun_family = AF_UNIX;
+    if ( socket_path.empty() || socket_path.size() >= sizeof(addr.sun_path) )
+    {
+      throw marley::Error("Invalid socket path \"" + socket_path + "\" for"
+        " the MARLEY event server");
+    }
+    std::strncpy( addr.sun_path, socket_path.c_str(),
+      sizeof(addr.sun_path) - 1u );
+    return addr;
+  }
+
+}
+
+marley::EventServer::EventServer(
+  std::vector< std::unique_ptr<marley::Generator> > generators,
+  const std::string& socket_path) : generators_( std::move(generators) ),
+  socket_path_( socket_path )
+{
+  if ( generators_.empty() ) throw marley::Error("At least one Generator"
+    " must be given to the marley::EventServer constructor");
+
+  for ( auto& gen : generators_ ) {
+    if ( !gen ) throw marley::Error("Null Generator passed to the"
+      " marley::EventServer constructor");
+    idle_generators_.push_back( gen.get() );
+  }
+
+  sockaddr_un addr = socket_address( socket_path_ );
+
+  listen_fd_ = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( listen_fd_ < 0 ) throw marley::Error("Could not create a socket for"
+    " the MARLEY event server: " + std::string(std::strerror(errno)) );
+
+  // Replace a socket left behind by a previous server
+  unlink( socket_path_.c_str() );
+
+  if ( bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+    || listen(listen_fd_, SOMAXCONN) < 0 )
+  {
+    std::string message( std::strerror(errno) );
+    close( listen_fd_ );
+    throw marley::Error("Could not listen on the socket \"" + socket_path_
+      + "\": " + message );
+  }
+}
+
+marley::EventServer::~EventServer()
+{
+  stop_ = true;
+  reap_connections( true );
+  if ( listen_fd_ >= 0 ) {
+    close( listen_fd_ );
+    unlink( socket_path_.c_str() );
+  }
+}
+
+void marley::EventServer::run( const std::function<bool()>& keep_running )
+{
+  stop_ = false;
+  MARLEY_LOG_INFO() << "Serving events on " << socket_path_ << " using "
+    << generators_.size() << " generator(s)";
+
+  pollfd pfd = { listen_fd_, POLLIN, 0 };
+  while ( keep_running() ) {
+
+    // Clean up after any clients that have disconnected
+    reap_connections( false );
+
+    int result = poll( &pfd, 1, POLL_TIMEOUT_MS );
+    if ( result < 0 && errno != EINTR ) throw marley::Error("Error while"
+      " waiting for connections to the MARLEY event server: "
+      + std::string(std::strerror(errno)) );
+    if ( result <= 0 ) continue;
+
+    int fd = accept( listen_fd_, nullptr, nullptr );
+    if ( fd < 0 ) {
+      if ( errno == EINTR || errno == ECONNABORTED ) continue;
+      throw marley::Error("Could not accept a connection to the MARLEY"
+        " event server: " + std::string(std::strerror(errno)) );
+    }
+
+    connections_.emplace_back( new Connection );
+    Connection& conn = *connections_.back();
+    conn.fd = fd;
+    conn.thread = std::thread( &EventServer::serve_connection, this,
+      std::ref(conn) );
+  }
+
+  stop_ = true;
+  reap_connections( true );
+}
+
+void marley::EventServer::reap_connections( bool wait_for_all )
+{
+  for ( auto iter = connections_.begin(); iter != connections_.end(); ) {
+    Connection& conn = **iter;
+    if ( wait_for_all || conn.done ) {
+      if ( conn.thread.joinable() ) conn.thread.join();
+      close( conn.fd );
+      iter = connections_.erase( iter );
+    }
+    else ++iter;
+  }
+}
+
+void marley::EventServer::serve_connection( Connection& conn )
+{
+  marley::Instrumentation::set_thread_label( "event server" );
+
+  // Reused from one request to the next to avoid reallocation
+  marley::BinaryEventBlock block;
+  std::string response;
+  char request_data[ REQUEST_SIZE ];
+
+  while ( read_all(conn.fd, request_data, REQUEST_SIZE, &stop_) ) {
+    Request request = decode_request( request_data );
+    this->handle_request( request, block, response );
+    if ( !write_all(conn.fd, response.data(), response.size()) ) break;
+    ++requests_served_;
+  }
+
+  conn.done = true;
+}
+
+void marley::EventServer::handle_request( const Request& request,
+  marley::BinaryEventBlock& block, std::string& response )
+{
+  Status status = Status::OK;
+  std::string body;
+  try {
+    if ( request.num_events > MAX_EVENTS_PER_REQUEST ) {
+      throw marley::Error("Too many events (" + std::to_string(
+        request.num_events) + ") requested from the MARLEY event server."
+        " The limit is " + std::to_string(MAX_EVENTS_PER_REQUEST) + '.');
+    }
+
+    marley::Generator& gen = this->acquire_generator();
+    try {
+      if ( request.pdg_a == 0 ) gen.create_events( request.num_events,
+        block );
+      else {
+        block.clear();
+        for ( uint32_t e = 0u; e < request.num_events; ++e ) {
+          block.add_event( gen.create_event(request.pdg_a, request.KEa,
+            request.pdg_atom, request.dir_vec) );
+        }
+      }
+    }
+    catch ( ... ) {
+      this->release_generator( gen );
+      throw;
+    }
+    this->release_generator( gen );
+
+    std::ostringstream out;
+    block.write( out );
+    body = out.str();
+  }
+  catch ( const std::exception& error ) {
+    status = Status::ERROR;
+    body = error.what();
+  }
+
+  response.clear();
+  put_le( response, static_cast<uint32_t>(status) );
+  put_le( response, static_cast<uint64_t>(body.size()) );
+  response += body;
+}
+
+marley::Generator& marley::EventServer::acquire_generator()
+{
+  std::unique_lock<std::mutex> lock( idle_mutex_ );
+  idle_cv_.wait( lock, [this]() -> bool
+    { return !idle_generators_.empty(); } );
+  marley::Generator* gen = idle_generators_.back();
+  idle_generators_.pop_back();
+  return *gen;
+}
+
+void marley::EventServer::release_generator( marley::Generator& gen )
+{
+  {
+    std::lock_guard<std::mutex> lock( idle_mutex_ );
+    idle_generators_.push_back( &gen );
+  }
+  idle_cv_.notify_one();
+}
+
+std::string marley::EventServer::encode_request( const Request& request )
+{
+  std::string data;
+  data.reserve( REQUEST_SIZE );
+  put_le( data, request.num_events );
+  put_le( data, request.pdg_a );
+  put_le( data, request.pdg_atom );
+  put_le( data, uint32_t(0u) ); // reserved
+  put_le( data, request.KEa );
+  for ( double d : request.dir_vec ) put_le( data, d );
+  return data;
+}
+
+marley::EventServer::Request marley::EventServer::decode_request(
+  const char* data )
+{
+  Request request;
+  request.num_events = get_le<uint32_t>( data );
+  request.pdg_a = get_le<int32_t>( data );
+  request.pdg_atom = get_le<int32_t>( data );
+  get_le<uint32_t>( data ); // reserved
+  request.KEa = get_le<double>( data );
+  for ( double& d : request.dir_vec ) d = get_le<double>( data );
+  return request;
+}
+
+int marley::EventServer::connect( const std::string& socket_path )
+{
+  sockaddr_un addr = socket_address( socket_path );
+
+  int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+  if ( fd < 0 ) throw marley::Error("Could not create a socket: "
+    + std::string(std::strerror(errno)) );
+
+  if ( ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ) {
+    std::string message( std::strerror(errno) );
+    close( fd );
+    throw marley::Error("Could not connect to the MARLEY event server at \""
+      + socket_path + "\": " + message );
+  }
+  return fd;
+}
+
+bool marley::EventServer::request_events( int socket_fd,
+  const Request& request, marley::BinaryEventBlock& block )
+{
+  std::string data = encode_request( request );
+  if ( !write_all(socket_fd, data.data(), data.size()) ) return false;
+
+  char header[ RESPONSE_HEADER_SIZE ];
+  if ( !read_all(socket_fd, header, RESPONSE_HEADER_SIZE) ) return false;
+  const char* ptr = header;
+  auto status = static_cast<Status>( get_le<uint32_t>(ptr) );
+  uint64_t size = get_le<uint64_t>( ptr );
+
+  std::string body( size, '\0' );
+  if ( size > 0u && !read_all(socket_fd, &body[0], size) ) return false;
+
+  if ( status != Status::OK ) throw marley::Error( body );
+
+  std::istringstream in( body );
+  marley::BinaryEventBlock::RecordTag tag;
+  if ( !marley::BinaryEventBlock::read_tag(in, tag)
+    || tag != marley::BinaryEventBlock::RecordTag::events
+    || !block.read(in) )
+  {
+    throw marley::Error("Invalid response received from the MARLEY event"
+      " server");
+  }
+  return true;
+}
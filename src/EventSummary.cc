@@ -0,0 +1,56 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include "marley/Event.hh"
+#include "marley/EventSummary.hh"
+#include "marley/Particle.hh"
+
+void marley::EventSummary::set(const marley::Event& ev, double xsec) {
+
+  pdgv = ev.projectile().pdg_code();
+  Ev = ev.projectile().total_energy();
+  KEv = ev.projectile().kinetic_energy();
+  pxv = ev.projectile().px();
+  pyv = ev.projectile().py();
+  pzv = ev.projectile().pz();
+
+  pdgt = ev.target().pdg_code();
+  Mt = ev.target().mass();
+
+  pdgl = ev.ejectile().pdg_code();
+  El = ev.ejectile().total_energy();
+  KEl = ev.ejectile().kinetic_energy();
+  pxl = ev.ejectile().px();
+  pyl = ev.ejectile().py();
+  pzl = ev.ejectile().pz();
+
+  pdgr = ev.residue().pdg_code();
+  Er = ev.residue().total_energy();
+  KEr = ev.residue().kinetic_energy();
+  pxr = ev.residue().px();
+  pyr = ev.residue().py();
+  pzr = ev.residue().pz();
+
+  Ex = ev.Ex();
+  twoJ = ev.twoJ();
+  parity = static_cast<int>( ev.parity() );
+  flux_avg_tot_xsec = xsec;
+  weight = ev.weight();
+  time = ev.time();
+
+  np = static_cast<int>( ev.final_particle_count() - FIRST_PRODUCT_INDEX );
+}
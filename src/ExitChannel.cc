@@ -14,9 +14,13 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <array>
+
 #include "marley/marley_utils.hh"
 #include "marley/ExitChannel.hh"
 #include "marley/GammaStrengthFunctionModel.hh"
+#include "marley/Integrator.hh"
 #include "marley/LevelDensityModel.hh"
 #include "marley/Logger.hh"
 #include "marley/OpticalModel.hh"
@@ -27,7 +31,10 @@ namespace {
   // Helper function that issues a warning when the final nuclear excitation
   // energy exceeds the energetically accessible maximum value
   void issue_Exf_warning( double Exf, double Exf_max ) {
-    MARLEY_LOG_WARNING() << "Final nuclear excitation energy Exf = "
+    // These warnings can occur once per decay width evaluation, so limit how
+    // often they are written
+    static marley::Logger::RateLimit limit;
+    MARLEY_LOG_WARNING_LIMITED( limit ) << "Final nuclear excitation energy Exf = "
       << Exf << " MeV exceeds the maximum accessible value of " << Exf_max
       << " MeV. The decay width for this exit channel will be set to zero.";
   }
@@ -37,7 +44,8 @@ namespace {
   void issue_Exf_continuum_warning( double Exf, double E_c_min,
     double E_c_max )
   {
-    MARLEY_LOG_WARNING() << "Final nuclear excitation energy Exf = "
+    static marley::Logger::RateLimit limit;
+    MARLEY_LOG_WARNING_LIMITED( limit ) << "Final nuclear excitation energy Exf = "
       << Exf << " MeV lies outside the accessible continuum [ " << E_c_min
       << " MeV, " << E_c_max << " MeV ]. The differential decay width"
       << " will be set to zero.";
@@ -53,41 +61,47 @@ namespace {
 
   // Used to avoid round-off problems in comparisons of floating-point numbers
   constexpr double TINY_OFFSET = 1e-6;
+
+  // Number of subintervals of the continuum used when computing an upper
+  // bound on its total width
+  constexpr int NUM_WIDTH_BOUND_INTERVALS = 8;
+
+  // Factor by which the upper bound on a continuum width is enlarged
+  constexpr double WIDTH_BOUND_SAFETY_FACTOR = 1.01;
 }
 
 using TrType = marley::GammaStrengthFunctionModel::TransitionType;
 
-int marley::FragmentExitChannel::final_nucleus_pdg() const {
+marley::FragmentExitChannel::FragmentExitChannel(
+  const marley::Fragment& fragment) : fragment_pdg_( fragment.get_pid() ),
+  two_s_( fragment.get_two_s() ), Pa_( fragment.get_parity() )
+{
   int Zi = marley_utils::get_particle_Z( pdgi_ );
   int Ai = marley_utils::get_particle_A( pdgi_ );
 
-  int Zfrag = marley_utils::get_particle_Z( fragment_pdg_ );
-  int Afrag = marley_utils::get_particle_A( fragment_pdg_ );
+  int Zf = Zi - marley_utils::get_particle_Z( fragment_pdg_ );
+  int Af = Ai - marley_utils::get_particle_A( fragment_pdg_ );
+
+  remnant_pdg_ = marley_utils::get_nucleus_pid( Zf, Af );
 
-  int Zf = Zi - Zfrag;
-  int Af = Ai - Afrag;
+  const auto& mt = marley::MassTable::Instance();
+  Sa_ = mt.get_fragment_separation_energy( pdgi_, fragment_pdg_ );
+  Exf_max_ = Exi_ - Sa_;
 
-  int pdgf = marley_utils::get_nucleus_pid( Zf, Af );
-  return pdgf;
+  om_ = &sdb_->get_optical_model( remnant_pdg_ );
 }
 
-double marley::FragmentExitChannel::max_Exf() const {
-  const auto& mt = marley::MassTable::Instance();
-  double Sa = mt.get_fragment_separation_energy( pdgi_, fragment_pdg_ );
-  double Exf_max = Exi_ - Sa;
-  return Exf_max;
+marley::GammaExitChannel::GammaExitChannel()
+  : gsfm_( &sdb_->get_gamma_strength_function_model(pdgi_) )
+{
 }
 
 void marley::FragmentDiscreteExitChannel::compute_total_width() {
 
-  int remnant_pdg = this->final_nucleus_pdg();
-  marley::OpticalModel& om = sdb_->get_optical_model( remnant_pdg );
-
-  // Get information about the emitted fragment
-  const marley::Fragment& f = *sdb_->get_fragment( fragment_pdg_ );
+  marley::OpticalModel& om = *om_;
 
-  int two_s = f.get_two_s(); // two times the fragment spin
-  marley::Parity Pa = f.get_parity(); // intrinsic parity
+  int two_s = two_s_; // two times the fragment spin
+  marley::Parity Pa = Pa_; // intrinsic parity
 
   // Maximum possible excitation energy in the daughter nucleus after the
   // fragment is emitted
@@ -110,32 +124,32 @@ void marley::FragmentDiscreteExitChannel::compute_total_width() {
   int twoJf = final_level_.twoJ();
   marley::Parity Pf = final_level_.parity();
 
-  for (int two_j = std::abs(twoJi_ - twoJf); two_j <= twoJi_ + twoJf;
-    two_j += 2)
-  {
-    int j_plus_s = (two_j + two_s) / 2;
-
-    // For each new iteration, increment l and flip the overall final
-    // state parity
-    int l = std::abs(two_j - two_s) / 2;
-    bool l_is_odd = l % 2;
-    marley::Parity P_final_state = Pf * Pa * marley::Parity( !l_is_odd );
-    for ( ; l <= j_plus_s; ++l, !P_final_state )
-    {
-      // The current term in the sum only contributes to the total decay
-      // width if parity is conserved
-      if ( Pi_ == P_final_state ) {
+  // Parity conservation requires Pi = Pf * Pa * (-1)^l, so only even (odd)
+  // values of l contribute when Pi equals (differs from) Pf * Pa. The
+  // allowed (l, two_j) pairs are looked up from a shared table.
+  bool even_l = ( Pi_ == Pf * Pa );
+  const auto& couplings = sdb_->get_fragment_discrete_couplings( twoJi_,
+    twoJf, two_s, even_l );
+
+  // Compute the transmission coefficients for all of the allowed partial
+  // waves together
+  marley::MonotonicArena::Scope scratch_scope( sdb_->scratch_arena() );
+  marley::ArenaAllocator<double> alloc( sdb_->scratch_arena() );
+  marley::ScratchVector<std::pair<int, int> > waves( alloc );
+  for ( const auto& term : couplings.terms() ) {
+    waves.emplace_back( term.l, term.two_j );
+  }
+  marley::ScratchVector<double> Tljs( alloc );
+  om.partial_wave_transmission_coefficients( total_KE_CM_frame,
+    fragment_pdg_, two_s, waves, Tljs );
 
-        double Tlj = om.transmission_coefficient( total_KE_CM_frame,
-          fragment_pdg_, two_j, l, two_s );
+  for ( double Tlj : Tljs ) {
 
-        double partial_width = one_over_two_pi_rho_i_ * Tlj;
+    double partial_width = one_over_two_pi_rho_i_ * Tlj;
 
-        width_ += partial_width;
+    width_ += partial_width;
 
-        // TODO: cache term indexed by l, two_j
-      }
-    }
+    // TODO: cache term indexed by l, two_j
   }
 }
 
@@ -166,8 +180,7 @@ void marley::GammaDiscreteExitChannel::compute_total_width() {
 
   // Retrieve the gamma strength function model used to compute transmission
   // coefficients
-  marley::GammaStrengthFunctionModel& gsfm
-    = sdb_->get_gamma_strength_function_model( pdgi_ );
+  marley::GammaStrengthFunctionModel& gsfm = *gsfm_;
 
   // Get properties of the final nuclear level
   double Exf = final_level_.energy();
@@ -208,14 +221,38 @@ void marley::GammaDiscreteExitChannel::compute_total_width() {
   }
 }
 
-double marley::FragmentContinuumExitChannel::differential_width( double Exf,
-  bool store_jpi_widths ) const
+double marley::FragmentContinuumExitChannel::differential_width(
+  double Exf_T, double Exf_rho, bool store_jpi_widths ) const
+{
+  // Temporary storage is taken from the scratch arena and released when this
+  // function returns
+  marley::MonotonicArena::Scope scratch_scope( sdb_->scratch_arena() );
+  WidthScratch scratch( sdb_->scratch_arena() );
+  return this->differential_width( Exf_T, Exf_rho, store_jpi_widths,
+    scratch );
+}
+
+void marley::FragmentContinuumExitChannel::differential_widths(
+  const double* Exfs, double* widths, size_t n ) const
+{
+  // Share the scratch storage among all of the points. Once the vectors have
+  // grown to the needed size, no further memory is taken from the arena.
+  marley::MonotonicArena::Scope scratch_scope( sdb_->scratch_arena() );
+  WidthScratch scratch( sdb_->scratch_arena() );
+  for ( size_t i = 0u; i < n; ++i ) {
+    widths[ i ] = this->differential_width( Exfs[ i ], Exfs[ i ], false,
+      scratch );
+  }
+}
+
+double marley::FragmentContinuumExitChannel::differential_width(
+  double Exf_T, double Exf_rho, bool store_jpi_widths,
+  WidthScratch& scratch ) const
 {
   if ( store_jpi_widths ) jpi_widths_table_.clear();
 
-  int remnant_pdg = this->final_nucleus_pdg();
-  marley::OpticalModel& om = sdb_->get_optical_model( remnant_pdg );
-  marley::LevelDensityModel& ldm = sdb_->get_level_density_model( remnant_pdg );
+  marley::OpticalModel& om = *om_;
+  marley::LevelDensityModel& ldm = *ldm_;
 
   // Get the maximum accessible final excitation energy
   double Exf_max = this->max_Exf();
@@ -225,53 +262,88 @@ double marley::FragmentContinuumExitChannel::differential_width( double Exf,
 
   if ( Exf_max < E_c_min_ ) throw_continuum_bounds_error( E_c_min_, Exf_max );
 
-  // Check that Exf lies within the continuum
-  if ( Exf < (E_c_min_ - TINY_OFFSET) || Exf > (Exf_max + TINY_OFFSET) ) {
-    // If it doesn't, complain and return zero
-    issue_Exf_continuum_warning( Exf, E_c_min_, Exf_max );
-    return 0.;
+  // Check that both excitation energies lie within the continuum
+  for ( double Exf : { Exf_T, Exf_rho } ) {
+    if ( Exf < (E_c_min_ - TINY_OFFSET) || Exf > (Exf_max + TINY_OFFSET) ) {
+      // If one doesn't, complain and return zero
+      issue_Exf_continuum_warning( Exf, E_c_min_, Exf_max );
+      return 0.;
+    }
   }
 
-  double total_KE_CM_frame = Exf_max - Exf;
-
-  // Get information about the emitted fragment
-  const marley::Fragment& f = *sdb_->get_fragment( fragment_pdg_ );
+  double total_KE_CM_frame = Exf_max - Exf_T;
 
-  int two_s = f.get_two_s(); // two times the fragment spin
-  marley::Parity Pa = f.get_parity(); // intrinsic parity
+  int two_s = two_s_; // two times the fragment spin
+  marley::Parity Pa = Pa_; // intrinsic parity
 
   // Final nuclear parity
   marley::Parity Pf;
   // The orbital parity starts as (-1)^0 = 1. Rather than applying parity
-  // conservation each time, just find the final state parity Pf for l = 0.
-  // Then we can safely flip Pf without further thought for each new l value in
-  // the loop.
+  // conservation for each term, just find the final state parity Pf for
+  // l = 0. Terms with odd l then have the opposite final parity.
   if (Pi_ == Pa) Pf = 1;
   else Pf = -1;
-  // For each new iteration, increment l and flip the final-state parity
-  for (int l = 0; l <= l_max_; ++l, !Pf) {
-    int two_l = 2*l;
-    for (int two_j = std::abs(two_l - two_s);
-      two_j <= two_l + two_s; two_j += 2)
-    {
-      for (int twoJf = std::abs(twoJi_ - two_j);
-        twoJf <= twoJi_ + two_j; twoJf += 2)
-      {
-        double Tlj = om.transmission_coefficient( total_KE_CM_frame,
-          fragment_pdg_, two_j, l, two_s );
-
-        double rho_f = ldm.level_density( Exf, twoJf, Pf );
-
-        double term = one_over_two_pi_rho_i_ * Tlj * rho_f;
-
-        diff_width += term;
-
-        if ( store_jpi_widths ) {
-          jpi_widths_table_.emplace_back( twoJf, Pf, term );
-          // TODO: include (l, two_j) in cached term
-        }
+  const std::array<marley::Parity, 2> Pfs = { Pf, -Pf };
+
+  // Compute the final-state level densities for every spin and parity that
+  // can appear in the sums below.
+  const auto& couplings = *couplings_;
+  int twoJf_min = couplings.twoJf_min();
+  int twoJf_max = couplings.twoJf_max();
+  // Element [0] holds level densities with parity Pf for even l, and
+  // element [1] holds those with parity -Pf for odd l.
+  auto& rhos = scratch.rhos;
+  ldm.level_density_all_spins( Exf_rho, Pfs[0], twoJf_min, twoJf_max,
+    rhos[0] );
+  ldm.level_density_all_spins( Exf_rho, Pfs[1], twoJf_min, twoJf_max,
+    rhos[1] );
+
+  // The transmission coefficients do not depend on the final nuclear spin,
+  // so compute them all at once before summing. They are ordered in the same
+  // way as the (l, two_j) pairs in the coupling table. If the l sum may be
+  // truncated, then they are instead computed one at a time as the sum
+  // reaches them.
+  double l_tol = sdb_->get_fragment_l_tolerance();
+  auto& Tljs = scratch.Ts;
+  if ( l_tol > 0. ) Tljs.clear();
+  else om.transmission_coefficients( total_KE_CM_frame, fragment_pdg_, two_s,
+    l_max_, Tljs );
+
+  // Contribution to the width from the current value of l
+  int current_l = 0;
+  double l_width = 0.;
+
+  // Sum over the allowed (l, two_j, twoJf) combinations
+  for ( const auto& cpl : couplings.terms() ) {
+
+    if ( l_tol > 0. ) {
+      // The terms are ordered by l. Transmission coefficients decrease with
+      // l at fixed energy, so once a full value of l contributes negligibly,
+      // the higher ones may be skipped.
+      if ( cpl.l != current_l ) {
+        if ( diff_width > 0. && l_width <= l_tol * diff_width ) break;
+        current_l = cpl.l;
+        l_width = 0.;
+      }
+      if ( cpl.T_index == static_cast<int>(Tljs.size()) ) {
+        Tljs.push_back( om.transmission_coefficient( total_KE_CM_frame,
+          fragment_pdg_, cpl.two_j, cpl.l, two_s ) );
       }
     }
+
+    double Tlj = Tljs[ cpl.T_index ];
+    double rho_f = rhos[ cpl.parity_index ][ cpl.rho_index ];
+
+    double term = one_over_two_pi_rho_i_ * Tlj * rho_f;
+
+    diff_width += term;
+    l_width += term;
+
+    if ( store_jpi_widths ) {
+      jpi_widths_table_.emplace_back( cpl.twoJf, Pfs[ cpl.parity_index ],
+        term );
+      // TODO: include (l, two_j) in cached term
+    }
   }
   return diff_width;
 }
@@ -289,27 +361,70 @@ void marley::ContinuumExitChannel::compute_total_width() {
   }
 
   // Create a function object to use for integration of the differential decay
-  // width
-  std::function<double(double)> dw = [this](double Exf) -> double {
+  // width. Passing the lambda directly to integrate() allows it to be
+  // inlined into the quadrature loop.
+  auto dw = [this](double Exf) -> double {
     return this->differential_width( Exf );
   };
 
-  // Numerically integrate over the bounds of the continuum using the
-  // function object prepared above
-  width_ = marley_utils::num_integrate( dw, E_c_min_, Ec_max );
+  // If the user requested adaptive integration to a particular tolerance,
+  // then respect that choice. The excitation energy CDF will be built
+  // separately in sample_Exf() if needed.
+  if ( sdb_->get_integration_tolerance() > 0. ) {
+    width_ = sdb_->integrate( dw, E_c_min_, Ec_max );
+    return;
+  }
+
+  // Otherwise, build the Chebyshev polynomial approximant to the PDF for the
+  // final nuclear excitation energy now and integrate it (via Clenshaw-Curtis
+  // quadrature on its coefficients) to obtain the total width. Keeping the
+  // approximant allows sample_Exf() to construct the CDF without evaluating
+  // the differential width again.
+  if ( this->use_fixed_grid() ) {
+    fixed_Exf_pdf_ = this->build_fixed_Exf_pdf( Ec_max );
+    width_ = fixed_Exf_pdf_->integral();
+    return;
+  }
+  Exf_pdf_ = this->build_Exf_pdf( Ec_max );
+  width_ = Exf_pdf_->integral();
 
   // TODO: consider switching to doing the integration with a
   // ChebyshevInterpolatingFunction object. This avoids needing to create one
   // later (and may be comparable in terms of computational cost)
 }
 
-double marley::GammaContinuumExitChannel::differential_width( double Exf,
-  bool store_jpi_widths ) const
+double marley::GammaContinuumExitChannel::differential_width(
+  double Exf_T, double Exf_rho, bool store_jpi_widths ) const
+{
+  // Temporary storage is taken from the scratch arena and released when this
+  // function returns
+  marley::MonotonicArena::Scope scratch_scope( sdb_->scratch_arena() );
+  WidthScratch scratch( sdb_->scratch_arena() );
+  return this->differential_width( Exf_T, Exf_rho, store_jpi_widths,
+    scratch );
+}
+
+void marley::GammaContinuumExitChannel::differential_widths(
+  const double* Exfs, double* widths, size_t n ) const
+{
+  // Share the scratch storage among all of the points. Once the vectors have
+  // grown to the needed size, no further memory is taken from the arena.
+  marley::MonotonicArena::Scope scratch_scope( sdb_->scratch_arena() );
+  WidthScratch scratch( sdb_->scratch_arena() );
+  for ( size_t i = 0u; i < n; ++i ) {
+    widths[ i ] = this->differential_width( Exfs[ i ], Exfs[ i ], false,
+      scratch );
+  }
+}
+
+double marley::GammaContinuumExitChannel::differential_width(
+  double Exf_T, double Exf_rho, bool store_jpi_widths,
+  WidthScratch& scratch ) const
 {
   if ( store_jpi_widths ) jpi_widths_table_.clear();
 
-  auto& ldm = sdb_->get_level_density_model( pdgi_ );
-  auto& gsfm = sdb_->get_gamma_strength_function_model( pdgi_ );
+  auto& ldm = *ldm_;
+  auto& gsfm = *gsfm_;
 
   // Initialize the return value to zero
   double diff_width = 0.;
@@ -317,50 +432,63 @@ double marley::GammaContinuumExitChannel::differential_width( double Exf,
   // Check that the continuum bounds make sense
   if ( Exi_ < E_c_min_ ) throw_continuum_bounds_error( E_c_min_, Exi_ );
 
-  // Check that Exf lies within the continuum
-  if ( Exf < (E_c_min_ - TINY_OFFSET) || Exf > (Exi_ + TINY_OFFSET) ) {
-    // If it doesn't, complain and return zero
-    issue_Exf_continuum_warning( Exf, E_c_min_, Exi_ );
-    return 0.;
+  // Check that both excitation energies lie within the continuum
+  for ( double Exf : { Exf_T, Exf_rho } ) {
+    if ( Exf < (E_c_min_ - TINY_OFFSET) || Exf > (Exi_ + TINY_OFFSET) ) {
+      // If one doesn't, complain and return zero
+      issue_Exf_continuum_warning( Exf, E_c_min_, Exi_ );
+      return 0.;
+    }
   }
 
   // Compute the energy of the emitted gamma-ray
-  double E_gamma = this->gamma_energy( Exf );
+  double E_gamma = this->gamma_energy( Exf_T );
 
-  // Array containing both possible parity values. It is used in
-  // the loop below.
+  // Array containing both possible parity values, in the order used by the
+  // coupling table
   constexpr std::array<marley::Parity, 2>
     parities = { marley::Parity(true), marley::Parity(false) };
 
-  // Sum over multipolarities. There is no monopole radiation, so
-  // the sum begins at mpol = 1.
-  for ( int mpol = 1; mpol <= l_max_; ++mpol ) {
-
-    int two_mpol = 2 * mpol;
-
-    for ( int twoJf = std::abs(twoJi_ - two_mpol); twoJf <= twoJi_ + two_mpol;
-      twoJf += 2 )
-    {
-      for ( const auto& Pf : parities ) {
+  // Compute the final-state level densities for every spin and parity that
+  // can appear in the sums below
+  const auto& couplings = *couplings_;
+  int twoJf_min = couplings.twoJf_min();
+  int twoJf_max = couplings.twoJf_max();
+  auto& rhos = scratch.rhos;
+  for ( size_t p = 0u; p < parities.size(); ++p ) {
+    ldm.level_density_all_spins( Exf_rho, parities[p], twoJf_min, twoJf_max,
+      rhos[p] );
+  }
 
-        // Use the multipolarity and final-state nuclear parity to determine
-        // whether the current partial differential width represents an
-        // electric or magnetic transition
-        TrType type = this->get_transition_type( mpol, Pf );
+  // Use the multipolarity and final-state nuclear parity to determine
+  // whether each partial differential width represents an electric or
+  // magnetic transition. The transmission coefficients do not depend on the
+  // final nuclear spin, so compute them before summing. There is no monopole
+  // radiation, so they begin at mpol = 1.
+  auto& Txls = scratch.Ts;
+  Txls.clear();
+  for ( int mpol = 1; mpol <= l_max_; ++mpol ) {
+    for ( size_t p = 0u; p < parities.size(); ++p ) {
+      TrType type = this->get_transition_type( mpol, parities[p] );
+      Txls.push_back( gsfm.transmission_coefficient(type, mpol, E_gamma) );
+    }
+  }
 
-        double Txl = gsfm.transmission_coefficient( type, mpol, E_gamma );
-        double rho_f = ldm.level_density(Exf, twoJf, Pf);
+  // Sum over the allowed (mpol, twoJf, Pf) combinations
+  for ( const auto& cpl : couplings.terms() ) {
 
-        double term = one_over_two_pi_rho_i_ * Txl * rho_f;
+    double Txl = Txls[ cpl.T_index ];
+    double rho_f = rhos[ cpl.parity_index ][ cpl.rho_index ];
 
-        if ( store_jpi_widths ) {
-          jpi_widths_table_.emplace_back( twoJf, Pf, term );
-          // TODO: include Xl in cached values
-        }
+    double term = one_over_two_pi_rho_i_ * Txl * rho_f;
 
-        diff_width += term;
-      }
+    if ( store_jpi_widths ) {
+      jpi_widths_table_.emplace_back( cpl.twoJf, parities[ cpl.parity_index ],
+        term );
+      // TODO: include Xl in cached values
     }
+
+    diff_width += term;
   }
   return diff_width;
 }
@@ -393,13 +521,12 @@ void marley::ExitChannel::prepare_products(
   // Final ion charge after particle emission
   int qf = qi_ - ep_Z;
 
-  double me = mt.get_particle_mass( marley_utils::ELECTRON );
   int remnant_pdg = this->final_nucleus_pdg();
 
   // Approximate the ground state mass of the ion formed when the fragment is
   // emitted by subtracting qf electron masses from the atomic mass for the
   // final nuclide.
-  double Mfgs_ion = mt.get_atomic_mass( remnant_pdg ) - qf*me;
+  double Mfgs_ion = mt.get_ion_mass( remnant_pdg, qf );
 
   residual_nucleus = marley::Particle( remnant_pdg, Mfgs_ion + Exf, qf );
 
@@ -407,10 +534,9 @@ void marley::ExitChannel::prepare_products(
   // products have been set, choose a direction for the emitted particle.
   // TODO: Consider changing this to a more realistic model instead of
   // isotropic emissions.
-  double cos_theta_emitted_particle
-    = gen.uniform_random_double( -1., 1., true );
-  double phi_emitted_particle
-    = gen.uniform_random_double( 0., marley_utils::two_pi, false );
+  double cos_theta_emitted_particle, phi_emitted_particle;
+  gen.isotropic_direction( cos_theta_emitted_particle,
+    phi_emitted_particle );
 
   // Handle the kinematics calculations for this decay. Load the
   // final-state particle objects with their full 4-momenta.
@@ -418,32 +544,122 @@ void marley::ExitChannel::prepare_products(
     residual_nucleus, cos_theta_emitted_particle, phi_emitted_particle );
 }
 
+marley::ContinuumExitChannel::WidthScratch::WidthScratch(
+  marley::MonotonicArena* arena ) : rhos{ {
+  marley::ScratchVector<double>( marley::ArenaAllocator<double>(arena) ),
+  marley::ScratchVector<double>( marley::ArenaAllocator<double>(arena) ) } },
+  Ts( marley::ArenaAllocator<double>(arena) ) {}
+
+std::unique_ptr<marley::ChebyshevInterpolatingFunction>
+  marley::ContinuumExitChannel::build_Exf_pdf( double Exf_max ) const
+{
+  // Evaluate the differential width at all of the Chebyshev points at once
+  return std::make_unique<marley::ChebyshevInterpolatingFunction>(
+    marley::BATCH_EVALUATION, [this](const double* Exfs, double* widths,
+    size_t n) -> void { this->differential_widths( Exfs, widths, n ); },
+    E_c_min_, Exf_max, sdb_->get_numerical_settings().chebyshev_points );
+}
+
+bool marley::ContinuumExitChannel::use_fixed_grid() const {
+  return sdb_->get_numerical_settings().chebyshev_points
+    == marley::DEFAULT_N_CHEBYSHEV;
+}
+
+std::unique_ptr<marley::ContinuumExitChannel::FixedExfPDF>
+  marley::ContinuumExitChannel::build_fixed_Exf_pdf( double Exf_max ) const
+{
+  return std::make_unique<FixedExfPDF>( marley::BATCH_EVALUATION,
+    [this](const double* Exfs, double* widths, size_t n) -> void
+    { this->differential_widths( Exfs, widths, n ); }, E_c_min_, Exf_max );
+}
+
+void marley::ContinuumExitChannel::initialize_width( bool defer_width ) {
+  width_deferred_ = defer_width;
+  if ( defer_width ) width_ = 0.;
+  else this->compute_total_width();
+}
+
+void marley::ContinuumExitChannel::resolve_width() {
+  if ( !width_deferred_ ) return;
+  this->compute_total_width();
+  width_deferred_ = false;
+}
+
+double marley::ContinuumExitChannel::width_upper_bound() const {
+
+  double Ec_max = this->E_c_max();
+  if ( Ec_max <= E_c_min_ ) return 0.;
+
+  // Add up rectangles whose heights bound the differential width on each
+  // subinterval from above (see the documentation in the header file). The
+  // small safety factor absorbs numerical differences between this sum and
+  // the quadrature used by compute_total_width().
+  double step = ( Ec_max - E_c_min_ ) / NUM_WIDTH_BOUND_INTERVALS;
+  double bound = 0.;
+  for ( int k = 0; k < NUM_WIDTH_BOUND_INTERVALS; ++k ) {
+    double Exf_low = E_c_min_ + k*step;
+    double Exf_high = ( k == NUM_WIDTH_BOUND_INTERVALS - 1 )
+      ? Ec_max : Exf_low + step;
+    bound += ( Exf_high - Exf_low )
+      * this->differential_width( Exf_low, Exf_high, false );
+  }
+
+  return WIDTH_BOUND_SAFETY_FACTOR * bound;
+}
+
 double marley::ContinuumExitChannel::sample_Exf(marley::Generator& gen) const
 {
   // The maximum accessible excitation energy for this exit channel. It
   // will be used when creating the ChebyshevInterpolatingFunction below
   double Emax = this->E_c_max();
+  double tolerance = sdb_->get_numerical_settings().sampling_tolerance;
+
+  // The default grid size uses fixed-size approximants, which are built in
+  // the same way as below
+  if ( this->use_fixed_grid() ) {
+    if ( !fixed_Exf_cdf_ ) {
+      if ( !fixed_Exf_pdf_ ) fixed_Exf_pdf_ = this->build_fixed_Exf_pdf( Emax );
+      fixed_Exf_cdf_ = std::make_unique<FixedExfCDF>( fixed_Exf_pdf_->cdf() );
+      fixed_Exf_pdf_.reset();
+    }
+    return gen.inverse_transform_sample( *fixed_Exf_cdf_, E_c_min_, Emax,
+      tolerance );
+  }
 
   // If we haven't built a CDF for sampling the final nuclear excitation
   // energy yet, then build it before continuing
   if ( !Exf_cdf_ ) {
     // Build a polynomial approximant (at Chebyshev points) to the PDF for the
-    // final nuclear excitation energy
-    marley::ChebyshevInterpolatingFunction pdf_cheb( [this](double Exf)
-      -> double { return this->differential_width(Exf); }, E_c_min_, Emax,
-      marley::DEFAULT_N_CHEBYSHEV );
+    // final nuclear excitation energy unless compute_total_width() already
+    // did so
+    if ( !Exf_pdf_ ) {
+      Exf_pdf_ = this->build_Exf_pdf( Emax );
+    }
 
-    // Store the cumulative density function for possible re-use
+    // Store the cumulative density function for possible re-use. The CDF
+    // keeps its own copy of the PDF, so the approximant is no longer needed.
     Exf_cdf_ = std::make_unique<marley::ChebyshevInterpolatingFunction>(
-      pdf_cheb.cdf() );
+      Exf_pdf_->cdf() );
+    Exf_pdf_.reset();
   }
 
   // Sample a final nuclear excitation energy using the Chebyshev polynomial
   // approximant to the CDF
-  double Exf = gen.inverse_transform_sample( *Exf_cdf_, E_c_min_, Emax );
+  double Exf = gen.inverse_transform_sample( *Exf_cdf_, E_c_min_, Emax,
+    tolerance );
   return Exf;
 }
 
+size_t marley::ContinuumExitChannel::memory_usage() const {
+  size_t bytes = marley_utils::vector_bytes( jpi_widths_table_ )
+    + jpi_sampler_.memory_usage();
+  if ( Exf_cdf_ ) bytes += sizeof( *Exf_cdf_ ) + Exf_cdf_->memory_usage();
+  if ( Exf_pdf_ ) bytes += sizeof( *Exf_pdf_ ) + Exf_pdf_->memory_usage();
+  if ( fixed_Exf_cdf_ ) bytes += sizeof( *fixed_Exf_cdf_ );
+  if ( fixed_Exf_pdf_ ) bytes += sizeof( *fixed_Exf_pdf_ );
+  return bytes;
+}
+
 void marley::ContinuumExitChannel::do_decay(double& Exf, int& two_Jf,
   marley::Parity& Pf, const marley::Particle& compound_nucleus,
   marley::Particle& emitted_particle, marley::Particle& residual_nucleus,
@@ -488,8 +704,8 @@ void marley::ContinuumExitChannel::sample_spin_parity(double Exf, int& twoJ,
     const double>( jpi_widths_table_.cend(),
     &SpinParityWidth::diff_width );
 
-  std::discrete_distribution<size_t> jpi_dist( begin, end );
-  size_t jpi_index = gen.sample_from_distribution( jpi_dist );
+  jpi_sampler_.build( begin, end );
+  size_t jpi_index = gen.sample_from_distribution( jpi_sampler_ );
 
   // Store the results
   const SpinParityWidth& Jpi = jpi_widths_table_.at( jpi_index );
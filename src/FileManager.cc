@@ -102,36 +102,74 @@ std::string marley::FileManager::find_file(const std::string& base_name,
 std::string marley::FileManager::find_file(const std::string& base_name,
   const std::vector<std::string>& search_dirs) const
 {
+  // Reuse the result of an earlier search for the same file if possible
+  std::string key = base_name;
+  for (const auto& dir : search_dirs) key += SEARCH_PATH_DELIMITER + dir;
+
+  std::lock_guard<std::mutex> lock( cache_mutex_ );
+
+  auto found = found_files_.find( key );
+  if ( found != found_files_.end() ) return found->second;
+
   std::string full_path_to_file;
 
   // First check if we can find the file just using base_name. We can
   // avoid the search if it's already accessible (e.g., because the
   // full path was supplied instead of the base name)
-  if ( file_exists(base_name) ) return base_name;
+  if ( file_exists(base_name) ) full_path_to_file = base_name;
+
+  // Otherwise, search the directories in the order listed. If no match is
+  // found, full_path_to_file will remain empty.
+  else for (const auto& dir : search_dirs) {
+    const auto& listing = dir_listing( dir );
+    auto iter = listing.find( base_name );
+    if ( iter != listing.end() ) {
+      full_path_to_file = iter->second;
+      break;
+    }
+  }
 
-  // Search the directories in the order listed. In each directory,
-  // compare all regular file names to the given base name. If a match
-  // is found, stop the search and store the result in full_path_to_file.
-  // If no match is found, full_path_to_file will remain empty.
-  for (const auto& dir : search_dirs) {
-    bool file_found = dir_iterate(dir,
-      [&full_path_to_file, &base_name](const std::string& other_full_path,
-        const std::string& other_base_name) -> bool
-      {
-        if ( base_name == other_base_name ) {
-          // We've found the desired file, so store its full path
-          full_path_to_file = other_full_path;
-          // Signal that we don't need to continue the search any longer
-          return true;
-        }
-        return false;
-      }
-    );
+  found_files_.emplace( key, full_path_to_file );
+  return full_path_to_file;
+}
+
+const std::unordered_map<std::string, std::string>&
+  marley::FileManager::dir_listing(const std::string& dir_name) const
+{
+  auto iter = dir_listings_.find( dir_name );
+  if ( iter != dir_listings_.end() ) return iter->second;
+
+  // A directory that cannot be read gets an empty listing, so the warning
+  // from dir_iterate() is only issued once
+  auto& listing = dir_listings_[ dir_name ];
+  dir_iterate(dir_name,
+    [&listing](const std::string& full_path,
+      const std::string& base_name) -> bool
+    {
+      listing.emplace( base_name, full_path );
+      // Signal that the directory scan should continue
+      return false;
+    }
+  );
+
+  MARLEY_LOG_DEBUG() << "marley::FileManager listed " << listing.size()
+    << " files in \"" << dir_name << '\"';
+
+  return listing;
+}
 
-    if ( file_found ) break;
+void marley::FileManager::prefetch(const std::string& search_path) const
+{
+  std::lock_guard<std::mutex> lock( cache_mutex_ );
+  for (const auto& dir : search_path_to_dir_vector(search_path)) {
+    dir_listing( dir );
   }
+}
 
-  return full_path_to_file;
+void marley::FileManager::clear_cache() const {
+  std::lock_guard<std::mutex> lock( cache_mutex_ );
+  dir_listings_.clear();
+  found_files_.clear();
 }
 
 std::vector<std::string> marley::FileManager::list_all_files(
@@ -187,14 +225,26 @@ bool marley::FileManager::dir_iterate(const std::string& dir_name,
   bool stop_iterations = false;
   while ( file = readdir(directory), !stop_iterations && file ) {
 
-    // Get information about the current file using the stat() function
-    struct stat file_stat;
     std::string base_name = file->d_name;
     std::string full_file_name = dir_name + '/' + base_name;
 
     MARLEY_LOG_DEBUG() << "marley::FileManager found file \""
       << full_file_name << '\"';
 
+    // Most filesystems report the file type in the directory entry itself.
+    // Use it when available to avoid a separate stat() call for each file.
+    #ifdef _DIRENT_HAVE_D_TYPE
+    if ( file->d_type == DT_REG ) {
+      stop_iterations = func( full_file_name, base_name );
+      continue;
+    }
+    else if ( file->d_type != DT_UNKNOWN && file->d_type != DT_LNK ) continue;
+    #endif
+
+    // Otherwise, get information about the current file using the stat()
+    // function
+    struct stat file_stat;
+
     // If we had a problem, complain and try the next file
     if ( stat(full_file_name.c_str(), &file_stat) ) {
       MARLEY_LOG_DEBUG() << "Couldn't stat the file \""
@@ -14,20 +14,38 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <limits>
+#include <random>
 #include <string>
 
 #include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Error.hh"
 #include "marley/Generator.hh"
+#include "marley/Instrumentation.hh"
+#include "marley/Integrator.hh"
 #include "marley/Logger.hh"
 #include "marley/NucleusDecayer.hh"
 #include "marley/Reaction.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/Tracing.hh"
 #include "marley/marley_utils.hh"
 
+namespace {
+
+  // Returns the ith element of the base-2 van der Corput sequence, which is
+  // also the first dimension of the Sobol sequence
+  double radical_inverse_base2( uint64_t i ) {
+    double result = 0.;
+    double f = 0.5;
+    for ( ; i != 0u; i >>= 1, f *= 0.5 ) if ( i & 1u ) result += f;
+    return result;
+  }
+
+}
+
 // The default constructor uses the system time as the seed and a
 // default-constructured monoenergetic neutrino source. No reactions are
 // defined, so the user must call add_reaction() at least once before using a
@@ -35,8 +53,10 @@
 marley::Generator::Generator()
   : seed_( std::chrono::system_clock::now().time_since_epoch().count() ),
   source_(new marley::MonoNeutrinoSource),
+  event_arena_(new marley::MonotonicArena),
   structure_db_(new marley::StructureDatabase)
 {
+  structure_db_->set_scratch_arena( event_arena_.get() );
   print_logo();
   reseed(seed_);
 }
@@ -45,8 +65,10 @@ marley::Generator::Generator()
 // a specific initial seed.
 marley::Generator::Generator(uint_fast64_t seed)
   : seed_(seed), source_(new marley::MonoNeutrinoSource),
+  event_arena_(new marley::MonotonicArena),
   structure_db_(new marley::StructureDatabase)
 {
+  structure_db_->set_scratch_arena( event_arena_.get() );
   print_logo();
   reseed(seed_);
 }
@@ -65,27 +87,157 @@ void marley::Generator::print_logo() {
 }
 
 marley::Event marley::Generator::create_event() {
+  marley::Event ev;
+  this->create_event( ev );
+  return ev;
+}
+
+void marley::Generator::create_event( marley::Event& ev ) {
+
+  // Release the scratch memory used while creating the previous event
+  event_arena_->reset();
+
+  // If the StructureDatabase is shared in concurrent mode, use the models
+  // and cached decay objects that belong to this Generator
+  marley::StructureDatabase::WorkerScope worker( this );
+
+  // If the counter-based random number engine is in use, move to
+  // the subsequence of random numbers reserved for this event
+  uint64_t event_num = rand_gen_.event_number();
+  rand_gen_.start_event();
+
+  // (1) and (2) Sample the primary interaction
+  this->sample_primary_event( ev, event_num );
+
+  // (3) If needed, de-excite the final-state residue
+  if ( do_deexcitations_ ) decayer_.process_event( ev, *this );
+
+  // (4) If needed, rotate the event to match the desired projectile direction
+  rotator_.process_event( ev, *this );
+}
+
+uint64_t marley::Generator::create_primary_event( marley::Event& ev ) {
+
+  if ( !rand_gen_.counter_based() ) throw marley::Error( "The counter-based"
+    " random number engine must be used to split event generation into"
+    " stages" );
+
+  event_arena_->reset();
+  marley::StructureDatabase::WorkerScope worker( this );
+
+  uint64_t event_num = rand_gen_.event_number();
+  rand_gen_.start_event();
+  this->sample_primary_event( ev, event_num );
+  return event_num;
+}
+
+void marley::Generator::finish_event( marley::Event& ev, uint64_t event_num )
+{
+  if ( !rand_gen_.counter_based() ) throw marley::Error( "The counter-based"
+    " random number engine must be used to split event generation into"
+    " stages" );
+
+  event_arena_->reset();
+  marley::StructureDatabase::WorkerScope worker( this );
+
+  // The second stage uses its own subsequence of the event's random numbers
+  rand_gen_.start_event_substream( event_num, 1u );
+
+  if ( do_deexcitations_ ) decayer_.process_event( ev, *this );
+  rotator_.process_event( ev, *this );
+}
+
+void marley::Generator::sample_primary_event( marley::Event& ev,
+  uint64_t event_num )
+{
+  if ( !event_filter_ ) {
+    this->sample_one_primary_event( ev );
+    return;
+  }
+
+  // Resample the primary interaction until it passes the event filter. The
+  // first trial uses the event's usual random numbers, so accepted events
+  // are the same as in an unfiltered run. Later trials of a counter-based
+  // engine use their own substreams (substream 1 is kept for
+  // finish_event()) so that they never overlap the random numbers of
+  // another event.
+  for ( uint64_t trial = 0u; ; ++trial ) {
+    if ( trial > 0u ) rand_gen_.start_event_substream( event_num,
+      1u + trial );
+    if ( trial == MAX_FILTER_TRIALS_ ) throw marley::Error( "The event"
+      " filter rejected " + std::to_string(trial) + " primary interactions"
+      " in a row. Check that its cuts can be satisfied by the configured"
+      " reactions." );
+    this->sample_one_primary_event( ev );
+    ++filter_trials_;
+    if ( event_filter_(ev) ) break;
+  }
+
+  ++filter_accepted_;
+  filter_accepted_weight_ += ev.weight();
+}
+
+void marley::Generator::sample_one_primary_event( marley::Event& ev ) {
 
   // (1) Select a reacting neutrino energy and reaction using the
   // flux-weighted total cross section(s)
   double E_nu = 10;
-  marley::Reaction& r = sample_reaction( E_nu );
+  double r_weight = 1.;
+  marley::Reaction& r = sample_reaction( E_nu, r_weight );
 
   // (2) Create the prompt two-two scattering event using the
-  // sampled reaction object
-  marley::Event ev = r.create_event( source_->get_pid(), 1.59, source_->get_Emax(), 1., source_->get_Emin(),*this );
+  // sampled reaction object. The particles are stored directly in the
+  // storage already owned by ev. Any bias applied to the choice of reaction
+  // is included in the event weight.
+  {
+    marley::Instrumentation::ScopedTimer timer(
+      marley::Instrumentation::Probe::CreateEvent );
+    MARLEY_TRACE_ZONE( trace_zone, "create_event" );
+    // Dark matter sources repurpose Emin and Emax to hold the cutoff and
+    // particle mass, and their events do not use the sampled energy
+    int pdg_a = source_->get_pid();
+    if ( pdg_a == marley_utils::DM ) {
+      r.create_event( pdg_a, 1.59, source_->get_Emax(), dm_xs_velocity_,
+        source_->get_Emin(), *this, ev );
+    }
+    else r.create_event( pdg_a, E_nu, *this, ev );
+  }
+  ev.set_weight( ev.weight() * r_weight );
+  ev.set_time( sampled_time_ );
+}
 
-  // (3) If needed, de-excite the final-state residue
-  if ( do_deexcitations_ ) {
-    marley::NucleusDecayer nd;
-    nd.process_event( ev, *this );
+void marley::Generator::create_events( size_t num_events,
+  marley::EventSink& sink )
+{
+  for ( size_t e = 0u; e < num_events; ++e ) {
+    this->create_event( scratch_event_ );
+    sink.receive_event( scratch_event_ );
   }
+}
 
-  // (4) If needed, rotate the event to match the desired projectile direction
-  rotator_.process_event( ev, *this );
+void marley::Generator::create_events( size_t num_events,
+  std::vector<marley::Event>& events )
+{
+  events.resize( num_events );
+  for ( auto& ev : events ) this->create_event( ev );
+}
 
-  // Return the completed event object
-  return ev;
+void marley::Generator::create_events( size_t num_events,
+  marley::EventBatch& batch )
+{
+  batch.clear();
+  for ( size_t e = 0u; e < num_events; ++e ) {
+    this->create_event( scratch_event_ );
+    batch.add_event( scratch_event_ );
+  }
+}
+
+std::vector<marley::Event> marley::Generator::create_events(
+  size_t num_events )
+{
+  std::vector<marley::Event> events;
+  this->create_events( num_events, events );
+  return events;
 }
 
 void marley::Generator::seed_using_state_string(
@@ -97,12 +249,8 @@ void marley::Generator::seed_using_state_string(
 }
 
 void marley::Generator::reseed(uint_fast64_t seed) {
-  // This is an attempt to do a decent job of seeding the random number
-  // generator, but optimally accomplishing this can be tricky (see, for
-  // example, http://www.pcg-random.org/posts/cpp-seeding-surprises.html)
   seed_ = seed;
-  std::seed_seq seed_sequence{seed_};
-  rand_gen_.seed(seed_sequence);
+  rand_gen_.seed( seed_ );
 
   MARLEY_LOG_INFO() << "Seeded random number generator with " << seed_;
 }
@@ -120,21 +268,56 @@ void marley::Generator::normalize_E_pdf() {
   // normalize_E_pdf() as the Generator is being constructed
   if ( dont_normalize_E_pdf_ ) return;
 
-  // This function is called whenever the reacting neutrino energy PDF changes,
-  // so reset the estimated maximum PDF value to its default. We will update
-  // this during rejection sampling.
-  E_pdf_max_ = E_PDF_MAX_DEFAULT_;
+  // Discard any previously tabulated CDF, which was built using the
+  // old PDF
+  E_pdf_cdf_.reset();
+  clear_time_bin_tables();
+  clear_dm_velocity_tables();
+
+  // Dark matter sources reuse Emin and Emax to store the UV cutoff and the
+  // particle mass, and the events that they produce do not depend on a
+  // sampled projectile energy. Skip the tabulation in that case.
+  if ( source_->get_pid() == marley_utils::DM ) {
+    norm_ = 1.;
+    const auto* halo = dynamic_cast< const marley::HaloDMSource* >(
+      source_.get() );
+    const auto* mono = dynamic_cast< const marley::MonoDMSource* >(
+      source_.get() );
+    if ( halo ) build_dm_velocity_tables( *halo );
+    else if ( mono ) {
+      dm_velocity_ = mono->velocity();
+      dm_xs_velocity_ = dm_velocity_;
+      if ( std::none_of(reactions_enabled_.cbegin(),
+        reactions_enabled_.cend(), [](bool e) -> bool { return e; }) )
+      {
+        throw marley::Error( "All of the dark matter reactions have been"
+          " disabled" );
+      }
+    }
+    return;
+  }
+
+  // Time-dependent sources are sampled using tables prepared separately
+  // for each time bin
+  const auto* tbs = dynamic_cast< const marley::TimeBinnedNeutrinoSource* >(
+    source_.get() );
+  if ( tbs ) {
+    build_time_bin_tables( *tbs );
+    return;
+  }
 
   // Treat monoenergetic sources differently since they can cause
   // problems for the standard numerical integration check
-  if ( source_->get_Emin() == source_->get_Emax() ) {
+  double Emin = source_->get_Emin();
+  double Emax = source_->get_Emax();
+  if ( Emin == Emax ) {
     // Set the normalization factor back to one. It's used
     // in the call to E_pdf() below, so we need to do this before
     // we assign it a different value.
-    norm_ = 1.0; //
+    norm_ = 1.;
     // Now norm_ is assigned to be the product of the total cross section times
     // the source PDF at energy Emin
-    //norm_ = E_pdf( source_->get_Emin() );
+    norm_ = E_pdf( Emin );
     if ( norm_ <= 0. || std::isnan(norm_) ) {
       throw marley::Error("The total cross section for all defined reactions"
         " is <= 0 or NaN for the neutrino energy defined in a monoenergetic"
@@ -152,12 +335,8 @@ void marley::Generator::normalize_E_pdf() {
 
     // Update the normalization factor for use with the reacting neutrino
     // energy probability density function
-    //norm_ = marley_utils::num_integrate( [this](double E)
-    //  -> double { return this->E_pdf(E); }, source_->get_Emin(),
-    //  source_->get_Emax() );
-
-    norm_ = 1.; // extremely silly and dumb hack TODO: change this dumb hack
-
+    norm_ = structure_db_->integrate( [this](double E)
+      -> double { return this->E_pdf(E); }, Emin, Emax );
 
     if ( norm_ <= 0. || std::isnan(norm_) ) {
       throw marley::Error( "The integral of the cross-section-weighted"
@@ -165,40 +344,173 @@ void marley::Generator::normalize_E_pdf() {
         " source spectrum produces significant flux above the reaction"
         " threshold(s)." );
     }
+
+    // Tabulate the CDF for the reacting neutrino energy once so that
+    // sample_reaction() can use inverse transform sampling. This avoids
+    // re-evaluating the total cross section for every reaction at each
+    // trial energy of a rejection method.
+    marley::ChebyshevInterpolant<E_PDF_N_CHEBYSHEV_> pdf_cheb(
+      [this](double E) -> double { return this->E_pdf(E); }, Emin, Emax );
+
+    E_pdf_cdf_ = std::make_unique< marley::ChebyshevCDF<E_PDF_N_CHEBYSHEV_> >(
+      pdf_cheb.cdf() );
   }
 }
 
-// Sample a random double uniformly between min and max using the class
-// member random number generator rand_gen_. The inclusive flag
-// determines whether or not max is included in the range. That is,
-// when inclusive == false, the sampling is done on the interval [min, max),
-// while inclusive == true uses [min, max].
-double marley::Generator::uniform_random_double(double min, double max,
-  bool inclusive)
+void marley::Generator::build_time_bin_tables(
+  const marley::TimeBinnedNeutrinoSource& tbs)
 {
-  // Defaults to sampling from [0,1). We will always
-  // explicitly supply the upper and lower bounds to
-  // this distribution, so we won't worry about the
-  // default setting.
-  static std::uniform_real_distribution<double> udist;
+  // Skip the part of the spectrum that lies below the lowest threshold of
+  // the reactions that the source neutrinos can participate in
+  double Emax = tbs.get_Emax();
+  double threshold = Emax;
+  for ( const auto& r : reactions_ ) {
+    if ( r->pdg_a() != tbs.get_pid() ) continue;
+    threshold = std::min( threshold, r->threshold_kinetic_energy() );
+  }
+  double E_low = std::max( tbs.get_Emin(), threshold );
+
+  if ( !(E_low < Emax) ) throw marley::Error( "None of the neutrinos"
+    " produced by the time-binned source lie above the reaction"
+    " threshold(s)." );
+
+  // The total cross section is evaluated once on an energy grid shared by
+  // all of the time bins
+  const size_t n = TIME_BIN_ENERGY_POINTS_;
+  time_bin_Emin_ = E_low;
+  time_bin_dE_ = ( Emax - E_low ) / ( n - 1u );
+  time_bin_xs_.resize( n );
+  for ( size_t i = 0u; i < n; ++i ) {
+    double xs = update_total_xs_values( time_bin_Emin_ + i*time_bin_dE_ );
+    if ( !weight_flux_ ) xs = ( xs > 0. ) ? 1. : 0.;
+    time_bin_xs_[ i ] = xs;
+  }
 
-  double max_to_use;
+  // Tabulate the CDF of the flux-weighted total cross section for each bin
+  // using the trapezoid rule. Between grid points, the density is treated as
+  // linear in the energy.
+  size_t num_bins = tbs.num_bins();
+  time_bin_cdfs_.assign( num_bins * n, 0. );
+  std::vector<double> bin_totals( num_bins, 0. );
+  for ( size_t b = 0u; b < num_bins; ++b ) {
+
+    double frac = tbs.bin_fraction( b );
+    if ( frac <= 0. ) continue;
+
+    double* cdf = time_bin_cdfs_.data() + b*n;
+    double old_density = frac * tbs.bin_pdf( b, time_bin_Emin_ )
+      * time_bin_xs_[ 0 ];
+    for ( size_t i = 1u; i < n; ++i ) {
+      double density = frac * tbs.bin_pdf( b, time_bin_Emin_
+        + i*time_bin_dE_ ) * time_bin_xs_[ i ];
+      cdf[ i ] = cdf[ i - 1u ] + 0.5 * ( old_density + density )
+        * time_bin_dE_;
+      old_density = density;
+    }
+    bin_totals[ b ] = cdf[ n - 1u ];
+  }
 
-  if ( inclusive ) { // sample from [min, max]
+  norm_ = 0.;
+  for ( double total : bin_totals ) norm_ += total;
 
-    // Find the double value that comes immediately after max. This allows us
-    // to sample uniformly on [min, max] rather than [min,max). This trick
-    // comes from http://tinyurl.com/n3ocg3p.
-    max_to_use = std::nextafter( max, std::numeric_limits<double>::max() );
+  if ( norm_ <= 0. || std::isnan(norm_) ) {
+    throw marley::Error( "The integral of the cross-section-weighted"
+      " neutrino flux is <= 0 or NaN. Please verify that your neutrino"
+      " source spectrum produces significant flux above the reaction"
+      " threshold(s)." );
   }
-  else { // sample from [min, max)
-    max_to_use = max;
+
+  time_bin_table_.build( bin_totals.cbegin(), bin_totals.cend() );
+}
+
+void marley::Generator::build_dm_velocity_tables(
+  const marley::HaloDMSource& halo)
+{
+  // The cross sections are evaluated once at the median speed of each
+  // (equal-probability) velocity bin. Sampling a bin using these as weights
+  // is then equivalent to sampling the speed from the halo distribution
+  // weighted by the total cross section.
+  size_t num_bins = halo.num_velocity_bins();
+  size_t num_reactions = reactions_.size();
+  dm_bin_xs_.assign( num_bins * num_reactions, 0. );
+  std::vector<double> bin_totals( num_bins, 0. );
+
+  for ( size_t b = 0u; b < num_bins; ++b ) {
+    double v = halo.bin_velocity( b );
+    double* xs = dm_bin_xs_.data() + b*num_reactions;
+    for ( size_t j = 0u; j < num_reactions; ++j ) {
+      const auto& react = reactions_.at( j );
+      xs[ j ] = react->total_xs( halo.get_pid(), 1., halo.mass(),
+        halo.cutoff(), v ) * reaction_atom_fractions_[ j ];
+      if ( std::isnan(xs[ j ]) ) xs[ j ] = 0.;
+      bin_totals[ b ] += xs[ j ];
+    }
+    if ( !weight_flux_ ) bin_totals[ b ] = ( bin_totals[ b ] > 0. ) ? 1. : 0.;
   }
 
-  std::uniform_real_distribution<double>::param_type params( min, max_to_use );
+  // Each bin holds the same fraction of the dark matter flux, so the
+  // halo-averaged total cross section is just the mean over the bins
+  norm_ = 0.;
+  for ( double total : bin_totals ) norm_ += total;
+  norm_ /= num_bins;
+
+  if ( norm_ <= 0. || std::isnan(norm_) ) {
+    throw marley::Error( "The halo-averaged dark matter cross section is"
+      " <= 0 or NaN. Please verify that the dark matter mass lies above the"
+      " reaction threshold(s)." );
+  }
 
-  // Sample a random double from this distribution
-  return udist( rand_gen_, params );
+  dm_bin_table_.build( bin_totals.cbegin(), bin_totals.cend() );
+}
+
+void marley::Generator::clear_dm_velocity_tables() {
+  dm_bin_table_.clear();
+  dm_bin_xs_.clear();
+  dm_velocity_ = marley_utils::DM_DEFAULT_VELOCITY;
+  dm_xs_velocity_ = marley_utils::DM_DEFAULT_VELOCITY;
+}
+
+void marley::Generator::clear_time_bin_tables() {
+  time_bin_table_.clear();
+  time_bin_cdfs_.clear();
+  time_bin_xs_.clear();
+  sampled_time_ = 0.;
+}
+
+double marley::Generator::sample_time_binned_energy() {
+
+  const auto& tbs = static_cast< const marley::TimeBinnedNeutrinoSource& >(
+    *source_ );
+
+  // Choose a time bin using the flux-weighted total cross section
+  // integrated over each one
+  size_t b = time_bin_table_( rand_gen_ );
+
+  // Find the energy grid interval by inverting the tabulated CDF
+  const size_t n = TIME_BIN_ENERGY_POINTS_;
+  const double* cdf = time_bin_cdfs_.data() + b*n;
+  double r = uniform_random_double( 0., cdf[n - 1u], false );
+  size_t i = std::upper_bound( cdf + 1, cdf + n, r ) - cdf;
+  if ( i >= n ) i = n - 1u;
+
+  // Sample the energy within the interval from the linear density between
+  // its endpoints
+  double E0 = time_bin_Emin_ + ( i - 1u )*time_bin_dE_;
+  double frac = tbs.bin_fraction( b );
+  double d0 = frac * tbs.bin_pdf( b, E0 ) * time_bin_xs_[ i - 1u ];
+  double d1 = frac * tbs.bin_pdf( b, time_bin_Emin_ + i*time_bin_dE_ )
+    * time_bin_xs_[ i ];
+  double y = r - cdf[ i - 1u ];
+  double denom = d0 + std::sqrt( std::max(0., d0*d0
+    + 2.*(d1 - d0)*y/time_bin_dE_) );
+  double x = ( denom > 0. ) ? 2.*y / denom : 0.;
+  x = std::min( std::max(x, 0.), time_bin_dE_ );
+
+  // The emission time is distributed uniformly within the bin
+  sampled_time_ = uniform_random_double( tbs.bin_low_time(b),
+    tbs.bin_high_time(b), false );
+
+  return E0 + x;
 }
 
 /// @details The rejection method used by this function consists of the
@@ -223,83 +535,29 @@ double marley::Generator::rejection_sample(const std::function<double(double)>&
   double xmin, double xmax, double& fmax, double safety_factor,
   double max_search_tolerance)
 {
-  // If we were passed the value marley_utils::UNKNOWN_MAX for fmax, then this
-  // signals that we need to search for the function maximum ourselves.
-  // Otherwise, we'll assume that the value passed over is good.
-  if ( fmax == marley_utils::UNKNOWN_MAX  ) {
-    // This variable will be loaded with the value of x
-    // that corresponds to the maximum of f(x).
-    // We don't actually use this, but currently it's
-    // a required parameter of marley_utils::maximize
-    double x_at_max;
-
-    // Maximize the function and multiply by a safety factor just
-    // in case we didn't quite find the exact peak
-    fmax = marley_utils::maximize(f, xmin, xmax, max_search_tolerance,
-      x_at_max) * safety_factor;
-  }
-
-  double x, y, val;
-
-  do {
-    // Sample x value uniformly from [xmin, xmax]
-    x = uniform_random_double(xmin, xmax, true);
-
-    // Sample y uniformly from [0, fmax]
-    y = uniform_random_double(0, fmax, true);
-
-    val = f(x);
-    if ( val > fmax ) {
-
-      MARLEY_LOG_WARNING() << "PDF value f(x) = "
-      << val << " at x = " << x << " exceeded the estimated maximum"
-      << " fmax = " << fmax << " during rejection sampling.";
-
-      fmax = val * safety_factor;
-      MARLEY_LOG_WARNING() << "A new estimate fmax = " << val * safety_factor
-        << " will now be adopted.";
-    }
-  }
-  // Keep sampling until you get a y value less than f(x)
-  // (the probability density function evaluated at the sampled value of x)
-  while ( y > val );
+  return this->rejection_sample< std::function<double(double)> >( f, xmin,
+    xmax, fmax, safety_factor, max_search_tolerance );
+}
 
-  return x;
+void marley::Generator::handle_rejection_fmax_exceeded(double val, double x,
+  double& fmax, double safety_factor) const
+{
+  // This warning may be issued by many threads in quick succession, so limit
+  // how often it is written
+  static marley::Logger::RateLimit limit;
+  MARLEY_LOG_WARNING_LIMITED( limit ) << "PDF value f(x) = "
+    << val << " at x = " << x << " exceeded the estimated maximum"
+    << " fmax = " << fmax << " during rejection sampling. A new estimate"
+    << " fmax = " << val * safety_factor << " will now be adopted.";
+
+  fmax = val * safety_factor;
 }
 
 double marley::Generator::E_pdf(double E) {
 
-  // Initialize the return value to zero
-  double pdf = 0.;
-
   // Sum all of the reaction total cross sections, saving
-  // each individual value along the way. Take weighting
-  // by atom fraction in the target material into account.
-  for ( size_t j = 0, s = reactions_.size(); j < s; ++j ) {
-
-    // Get the current reaction
-    const auto& react = reactions_.at( j );
-
-    // Compute the total cross section for the current reaction for a single
-    // target atom
-    double tot_xs = react->total_xs( source_->get_pid(), E );
-
-    // If the target_ member has not been initialized, don't bother doing any
-    // weighting by atom fraction (equivalent to a weight of unity for all
-    // target atoms)
-    if ( target_ ) {
-      // If it has been configured, then apply the appropriate atom fraction
-      // weight from the target as appropriate.
-      tot_xs *= target_->atom_fraction( react->atomic_target() );
-    }
-
-    // Cache the atom-fraction-weighted total cross section for sampling a
-    // reaction mode later
-    total_xs_values_.at( j ) = tot_xs;
-
-    // Add the weighted total cross section value to the total
-    pdf += tot_xs;
-  }
+  // each individual value along the way
+  double pdf = update_total_xs_values( E );
 
   // Normally, we want to fold the flux with the reaction cross section(s)
   // in order to obtain the distribution of reacting neutrino energies
@@ -322,62 +580,235 @@ double marley::Generator::E_pdf(double E) {
   return pdf / norm_;
 }
 
+double marley::Generator::update_total_xs_values(double E) {
+
+  // Initialize the return value to zero
+  double xs_sum = 0.;
+
+  // Sum all of the reaction total cross sections, saving
+  // each individual value along the way. Take weighting
+  // by atom fraction in the target material into account.
+  for ( size_t j = 0, s = reactions_.size(); j < s; ++j ) {
+
+    // Reactions that cannot occur (because they involve another projectile
+    // or a target atom that is absent) do not need to be evaluated
+    double weight = source_reaction_weights_[ j ];
+    if ( weight == 0. ) {
+      total_xs_values_[ j ] = 0.;
+      continue;
+    }
+
+    // Compute the total cross section for the current reaction for a single
+    // target atom, weighted by its atom fraction
+    double tot_xs = reactions_[ j ]->total_xs( source_->get_pid(), E )
+      * weight;
+
+    // Cache the atom-fraction-weighted total cross section for sampling a
+    // reaction mode later
+    total_xs_values_.at( j ) = tot_xs;
+
+    // Add the weighted total cross section value to the total
+    xs_sum += tot_xs;
+  }
+
+  return xs_sum;
+}
+
 marley::Reaction& marley::Generator::sample_reaction(double& E) {
+  double weight;
+  return this->sample_reaction( E, weight );
+}
+
+marley::Reaction& marley::Generator::sample_reaction(double& E,
+  double& weight)
+{
+  marley::Instrumentation::ScopedTimer timer(
+    marley::Instrumentation::Probe::SampleReaction );
+
   if ( reactions_.empty() ) throw marley::Error("Cannot sample"
     " a reaction in marley::Generator::sample_reaction(). The vector of"
     " marley::Reaction objects owned by this generator is empty.");
 
-  // Store the "old" value of E_pdf_max_, i.e., the one we had before calling
-  // rejection_sample(). This will be used to check for problems.
-  double old_max = E_pdf_max_;
-
-  // TODO: protect against source_ changing E_min or E_max after you compute
-  // the normalization factor norm_ in marley::Generator::init()
-  // EVIL hack
-  E = 1.;
-  //E = rejection_sample([this](double E_nu)
-  //  -> double { return this->E_pdf(E_nu); }, source_->get_Emin(),
-  //  source_->get_Emax(), E_pdf_max_);
-
-  // If the value of max changed after the call to rejection_sample() and the
-  // old value wasn't UNKNOWN_MAX, then the rejection sampling routine must
-  // have encountered a PDF value that was larger than our estimated maximum.
-  // Alert the user about this and advise them to change the configuration
-  // appropriately to avoid a biased reacting neutrino energy distribution.
-  static bool issued_long_error_message = false;
-  if ( old_max != marley_utils::UNKNOWN_MAX
-    && old_max != E_pdf_max_ )
-  {
-    if ( !issued_long_error_message ) {
-      MARLEY_LOG_ERROR() << "Estimation of the maximum PDF value failed when"
-        << " using a rejection method to sample reacting neutrino energies.\n"
-        << "This may occur when, e.g., an incident neutrino flux"
-        << " is used that includes multiple sharp peaks.\n"
-        << "To avoid biasing the energy distribution, please rerun the simulation"
-        << " after adding the following line to the MARLEY job configuration"
-        << " file:\n"
-        << "    energy_pdf_max: " << E_pdf_max_ << ",\n"
-        << "If this error message persists after raising energy_pdf_max to a"
-        << " relatively high value, please contact the MARLEY developers for"
-        << " troubleshooting help.";
-      issued_long_error_message = true;
+  // Sample a reacting neutrino energy from the precomputed CDF. For a
+  // monoenergetic source, no sampling is needed.
+  double Emin = source_->get_Emin();
+  double Emax = source_->get_Emax();
+  if ( source_->get_pid() == marley_utils::DM ) {
+    // Dark matter events do not use the projectile energy (see
+    // normalize_E_pdf()), so just use a placeholder value
+    E = 1.;
+
+    // For a halo source, choose a velocity bin and use the cross sections
+    // that were precomputed for it
+    if ( !dm_bin_table_.empty() ) {
+      const auto& halo = static_cast< const marley::HaloDMSource& >(
+        *source_ );
+      size_t b = dm_bin_table_( rand_gen_ );
+      dm_velocity_ = halo.sample_velocity( *this, b );
+      dm_xs_velocity_ = halo.bin_velocity( b );
+
+      size_t num_reactions = reactions_.size();
+      std::copy( dm_bin_xs_.cbegin() + b*num_reactions,
+        dm_bin_xs_.cbegin() + (b + 1u)*num_reactions,
+        total_xs_values_.begin() );
     }
+    // Otherwise, the reactions are not weighted by their cross sections,
+    // and the first enabled one is always used
     else {
-      MARLEY_LOG_ERROR() << "The maximum PDF value for sampling reacting neutrino"
-       << " energies was exceeded again. The new estimated maximum is"
-       << "\n    energy_pdf_max: " << E_pdf_max_ << ',';
+      auto begin = reactions_enabled_.cbegin();
+      size_t first = std::find( begin, reactions_enabled_.cend(), true )
+        - begin;
+      for ( size_t j = 0u; j < total_xs_values_.size(); ++j ) {
+        total_xs_values_[ j ] = ( j == first ) ? 1. : 0.;
+      }
     }
   }
+  else {
+    if ( !time_bin_table_.empty() ) E = sample_time_binned_energy();
+    else if ( E_pdf_cdf_ ) {
+      E = inverse_transform_sample( *E_pdf_cdf_, Emin, Emax );
+    }
+    else E = Emin;
 
-  // The atom-fraction-weighted total cross section values have already been
-  // updated by the final call to E_pdf() during rejection sampling, so we can
-  // now sample a reaction type using our discrete distribution object.
-  std::discrete_distribution<size_t>::param_type
-    params( total_xs_values_.begin(), total_xs_values_.end() );
-  size_t r_index = r_index_dist_( rand_gen_, params );
+    // Update the atom-fraction-weighted total cross section values at the
+    // sampled energy
+    update_total_xs_values( E );
+  }
+
+  // Now sample a reaction type using our alias table.
+  size_t r_index = sample_reaction_index( total_xs_values_, nullptr, weight );
   return *reactions_.at( r_index );
 }
 
+size_t marley::Generator::sample_reaction_index(
+  const std::vector<double>& xsecs, const std::vector<size_t>* indices,
+  double& weight)
+{
+  weight = 1.;
+  bool biased = std::any_of( reaction_biases_.cbegin(),
+    reaction_biases_.cend(), [](double b) -> bool { return b != 1.; } );
+
+  if ( !biased ) {
+    r_index_table_.build( xsecs.cbegin(), xsecs.cend() );
+    return r_index_table_( rand_gen_ );
+  }
+
+  // Sample using the biased cross sections. The ratio of the true and
+  // biased probabilities for the chosen reaction becomes the event weight.
+  double xs_sum = 0.;
+  double biased_sum = 0.;
+  biased_xs_values_.resize( xsecs.size() );
+  for ( size_t j = 0u; j < xsecs.size(); ++j ) {
+    size_t r = indices ? indices->at( j ) : j;
+    biased_xs_values_[ j ] = xsecs[ j ] * reaction_biases_.at( r );
+    xs_sum += xsecs[ j ];
+    biased_sum += biased_xs_values_[ j ];
+  }
+
+  r_index_table_.build( biased_xs_values_.cbegin(),
+    biased_xs_values_.cend() );
+  size_t index = r_index_table_( rand_gen_ );
+
+  size_t r = indices ? indices->at( index ) : index;
+  weight = biased_sum / ( xs_sum * reaction_biases_.at(r) );
+  return index;
+}
+
+void marley::Generator::set_reaction_bias(size_t index, double factor) {
+  if ( index >= reactions_.size() ) throw marley::Error("Invalid reaction"
+    " index " + std::to_string(index) + " passed to marley::Generator::"
+    "set_reaction_bias()");
+  if ( !(factor > 0.) ) throw marley::Error("Invalid reaction bias factor "
+    + std::to_string(factor) + " encountered. Bias factors must be"
+    " positive.");
+  reaction_biases_.at( index ) = factor;
+}
+
+double marley::Generator::reaction_bias(size_t index) const {
+  return reaction_biases_.at( index );
+}
+
+void marley::Generator::set_reaction_enabled(size_t index, bool enabled) {
+  if ( index >= reactions_.size() ) throw marley::Error("Invalid reaction"
+    " index " + std::to_string(index) + " passed to marley::Generator::"
+    "set_reaction_enabled()");
+  if ( reactions_enabled_[ index ] == enabled ) return;
+
+  reactions_enabled_[ index ] = enabled;
+  update_reaction_weights();
+
+  // Update the neutrino energy probability density function to include
+  // only the enabled reactions
+  normalize_E_pdf();
+}
+
+bool marley::Generator::reaction_enabled(size_t index) const {
+  return reactions_enabled_.at( index );
+}
+
+void marley::Generator::reconfigure( Reconfiguration changes ) {
+
+  // Check every reaction index before changing anything
+  for ( const auto& pair : changes.reactions_enabled ) {
+    if ( pair.first >= reactions_.size() ) throw marley::Error("Invalid"
+      " reaction index " + std::to_string(pair.first) + " passed to"
+      " marley::Generator::reconfigure()");
+  }
+
+  if ( changes.change_direction ) set_neutrino_direction(
+    changes.direction );
+
+  bool renormalize = changes.source || changes.target;
+  for ( const auto& pair : changes.reactions_enabled ) {
+    if ( reactions_enabled_[ pair.first ] == pair.second ) continue;
+    reactions_enabled_[ pair.first ] = pair.second;
+    renormalize = true;
+  }
+  if ( !renormalize ) return;
+
+  // Apply the remaining changes before normalizing the neutrino energy
+  // probability density function just once
+  bool old_dont_normalize = dont_normalize_E_pdf_;
+  dont_normalize_E_pdf_ = true;
+  set_source( std::move(changes.source) );
+  set_target( std::move(changes.target) );
+  update_reaction_weights();
+  dont_normalize_E_pdf_ = old_dont_normalize;
+
+  if ( !reactions_.empty() ) normalize_E_pdf();
+}
+
+void marley::Generator::set_event_filter( EventFilter filter ) {
+  event_filter_ = std::move( filter );
+  filter_trials_ = 0u;
+  filter_accepted_ = 0u;
+  filter_accepted_weight_ = 0.;
+}
+
+double marley::Generator::filter_accepted_fraction() const {
+  if ( filter_trials_ == 0u ) return 1.;
+  return filter_accepted_weight_ / filter_trials_;
+}
+
+void marley::Generator::set_exit_channel_bias(int pdg, double factor) {
+  if ( !(factor > 0.) ) throw marley::Error("Invalid exit channel bias"
+    " factor " + std::to_string(factor) + " encountered. Bias factors must"
+    " be positive.");
+
+  if ( factor == 1. ) exit_channel_biases_.erase( pdg );
+  else exit_channel_biases_[ pdg ] = factor;
+
+  // The cached decay objects store exit channel sampling tables that were
+  // built using the old bias factors
+  structure_db_->clear_hf_decay_cache();
+}
+
+double marley::Generator::exit_channel_bias(int pdg) const {
+  auto iter = exit_channel_biases_.find( pdg );
+  if ( iter == exit_channel_biases_.end() ) return 1.;
+  return iter->second;
+}
+
 const marley::NeutrinoSource& marley::Generator::get_source() const {
   if ( source_ ) return *source_;
   else throw marley::Error( "Error in marley::Generator::get_source()."
@@ -399,6 +830,11 @@ void marley::Generator::set_source(
     // the std::unique_ptr passed to this function null afterwards.
     source_.reset( source.release() );
 
+    // Tables built for the old source are no longer valid
+    clear_time_bin_tables();
+    clear_dm_velocity_tables();
+    update_reaction_weights();
+
     // Don't bother to renormalize if there are no reactions defined yet
     if ( reactions_.empty() ) return;
 
@@ -416,10 +852,15 @@ void marley::Generator::add_reaction(std::unique_ptr<marley::Reaction> reaction)
     // Transfer ownership to a new unique_ptr in the reactions vector, leaving
     // the original empty
     reactions_.push_back( std::move(reaction) );
+    reactions_enabled_.push_back( true );
+    update_reaction_weights();
 
     // Add a new entry in the reaction cross sections vector
     total_xs_values_.push_back( 0. );
 
+    // New reactions are unbiased by default
+    reaction_biases_.push_back( 1. );
+
     // TODO: consider adding a check to see whether source_ is non-null.
     // Right now, this shouldn't be possible, but an explicit check might
     // be good.
@@ -430,12 +871,81 @@ void marley::Generator::add_reaction(std::unique_ptr<marley::Reaction> reaction)
   }
 }
 
+std::map<int, double> marley::Generator::max_residue_excitation_energies()
+  const
+{
+  std::map<int, double> max_Ex;
+  if ( !source_ ) return max_Ex;
+
+  int source_pdg = source_->get_pid();
+  double KEa_max = source_->get_Emax();
+  for ( const auto& react : reactions_ ) {
+    const auto* nr = dynamic_cast< const marley::NuclearReaction* >(
+      react.get() );
+    if ( !nr || nr->pdg_a() != source_pdg ) continue;
+    double Ex = nr->max_level_energy( KEa_max );
+    if ( !(Ex > 0.) ) continue;
+    double& stored_Ex = max_Ex[ nr->pdg_d() ];
+    stored_Ex = std::max( stored_Ex, Ex );
+  }
+  return max_Ex;
+}
+
+void marley::Generator::prewarm(unsigned num_threads) {
+  if ( !do_deexcitations_ ) return;
+  auto max_Ex = max_residue_excitation_energies();
+  if ( max_Ex.empty() ) return;
+  marley::StructureDatabase::WorkerScope worker( this );
+  get_structure_db().precompute_model_tables( max_Ex, num_threads );
+  prewarm_decays();
+}
+
+void marley::Generator::prewarm_decays() {
+  if ( !do_deexcitations_ || !source_ ) return;
+
+  marley::StructureDatabase::WorkerScope worker( this );
+  auto& sdb = get_structure_db();
+
+  int source_pdg = source_->get_pid();
+  double KEa_max = source_->get_Emax();
+  size_t num_states = 0u;
+  for ( const auto& react : reactions_ ) {
+    const auto* nr = dynamic_cast< const marley::NuclearReaction* >(
+      react.get() );
+    if ( !nr || nr->pdg_a() != source_pdg ) continue;
+    num_states += nr->prewarm_decays( KEa_max, sdb );
+  }
+
+  MARLEY_LOG_INFO() << "Prepared Hauser-Feshbach decays for " << num_states
+    << " initial residue states";
+}
+
+void marley::Generator::update_reaction_weights() {
+  size_t num_reactions = reactions_.size();
+  reaction_atom_fractions_.assign( num_reactions, 1. );
+  source_reaction_weights_.assign( num_reactions, 1. );
+  for ( size_t j = 0u; j < num_reactions; ++j ) {
+    const auto& react = reactions_[ j ];
+    if ( !reactions_enabled_[ j ] ) reaction_atom_fractions_[ j ] = 0.;
+    else if ( target_ ) reaction_atom_fractions_[ j ] = target_->atom_fraction(
+      react->atomic_target() );
+    source_reaction_weights_[ j ] = reaction_atom_fractions_[ j ];
+    if ( source_ && react->pdg_a() != source_->get_pid() ) {
+      source_reaction_weights_[ j ] = 0.;
+    }
+  }
+}
+
 void marley::Generator::clear_reactions() {
   reactions_.clear();
+  reactions_enabled_.clear();
+  update_reaction_weights();
   total_xs_values_.clear();
+  reaction_biases_.clear();
   // Reset the normalization factor to 1. We don't need it until we define
   // one or more new reactions.
   norm_ = 1.;
+  E_pdf_cdf_.reset();
 }
 
 marley::StructureDatabase& marley::Generator::get_structure_db() {
@@ -444,6 +954,17 @@ marley::StructureDatabase& marley::Generator::get_structure_db() {
     " The member variable structure_db_ == nullptr." );
 }
 
+void marley::Generator::set_structure_db(
+  std::shared_ptr<marley::StructureDatabase> sdb )
+{
+  if ( !sdb ) throw marley::Error( "Null StructureDatabase passed to"
+    " marley::Generator::set_structure_db()" );
+  if ( !reactions_.empty() ) throw marley::Error( "The StructureDatabase"
+    " used by a marley::Generator may not be replaced after reactions have"
+    " been added" );
+  structure_db_ = std::move( sdb );
+}
+
 void marley::Generator::set_neutrino_direction(
   const std::array<double, 3>& dir_vec)
 {
@@ -470,9 +991,7 @@ double marley::Generator::inverse_transform_sample(
 {
   // Build an approximate CDF corresponding to the integral of the input PDF.
   // Use a polynomial approximant at Chebyshev points to do it.
-  /// @todo Remove hard-coded number of points here
-  marley::ChebyshevInterpolatingFunction func(f, xmin, xmax,
-    DEFAULT_N_CHEBYSHEV);
+  marley::ChebyshevInterpolant<DEFAULT_N_CHEBYSHEV> func( f, xmin, xmax );
   auto cdf = func.cdf();
 
   // Now that we have a CDF to use for sampling, delegate the rest of the
@@ -491,6 +1010,12 @@ double marley::Generator::inverse_transform_sample(
   if ( prob == 0. ) return xmin;
   else if ( prob == 1. ) return xmax;
 
+  // If the CDF has a precomputed inverse table, then use it. This requires
+  // only a handful of evaluations of the CDF rather than a full bisection.
+  if ( cdf.has_inverse_table() ) {
+    return cdf.inverse_cdf( prob, bisection_tolerance );
+  }
+
   // A properly normalized CDF should evaluate to unity at x = xmax. We enforce
   // this here so that the user doesn't have to do it in advance.
   double norm = cdf.evaluate( xmax );
@@ -520,6 +1045,10 @@ double marley::Generator::flux_averaged_total_xs() const {
   // by the total cross section, just return zero
   if ( !weight_flux_ ) return 0.;
 
+  // The halo average for a dark matter source was already computed when
+  // the velocity bin tables were built
+  if ( !dm_bin_table_.empty() ) return norm_;
+
   double avg_total_xs = 0.;
 
   // For a monoenergetic source, don't bother to do the full
@@ -530,7 +1059,7 @@ double marley::Generator::flux_averaged_total_xs() const {
     avg_total_xs = norm_ / source_->pdf( Emin );
   }
   else {
-    double source_norm = marley_utils::num_integrate(
+    double source_norm = structure_db_->integrate(
       [this](double Ev) -> double { return this->source_->pdf(Ev); },
       Emin, Emax);
 
@@ -540,6 +1069,144 @@ double marley::Generator::flux_averaged_total_xs() const {
   return avg_total_xs;
 }
 
+marley::Generator::FluxAverageEstimate
+  marley::Generator::estimate_flux_averaged_total_xs( FluxAverageMethod method,
+  size_t num_points, size_t num_replicates ) const
+{
+  FluxAverageEstimate result;
+
+  // Follow the same convention as flux_averaged_total_xs() when flux
+  // weighting is disabled
+  if ( !weight_flux_ ) return result;
+
+  if ( num_points == 0u ) throw marley::Error( "At least one point is"
+    " needed to estimate the flux-averaged total cross section" );
+
+  // Each sampling point u on [0, 1) is mapped to a value of the integrand,
+  // scaled so that its mean over u is the flux-averaged total cross section
+  std::vector<double> us;
+  std::function< void(std::vector<double>&) > integrand;
+
+  const auto* halo = dynamic_cast< const marley::HaloDMSource* >(
+    source_.get() );
+  if ( halo ) {
+    // For the standard halo model, u is the cumulative fraction of the
+    // dark matter speed distribution. This replaces the fixed evaluation at
+    // the median speed of each bin used by build_dm_velocity_tables().
+    integrand = [&]( std::vector<double>& f ) {
+      for ( size_t i = 0u; i < us.size(); ++i ) {
+        double v = halo->quantile( us[ i ] );
+        for ( size_t j = 0u; j < reactions_.size(); ++j ) {
+          double weight = reaction_atom_fractions_[ j ];
+          if ( weight == 0. ) continue;
+          double xs = reactions_[ j ]->total_xs( halo->get_pid(), 1.,
+            halo->mass(), halo->cutoff(), v ) * weight;
+          if ( !std::isnan(xs) ) f[ i ] += xs;
+        }
+      }
+    };
+  }
+  else {
+    double Emin = source_->get_Emin();
+    double Emax = source_->get_Emax();
+
+    // Nothing needs to be sampled for a monoenergetic source
+    if ( Emin == Emax ) {
+      result.value = flux_averaged_total_xs();
+      return result;
+    }
+
+    double source_norm = structure_db_->integrate(
+      [this](double Ev) -> double { return this->source_->pdf(Ev); },
+      Emin, Emax);
+
+    // Otherwise, u is mapped linearly onto the neutrino energy range
+    double width = Emax - Emin;
+    integrand = [&]( std::vector<double>& f ) {
+      std::vector<double> Es( us.size() );
+      for ( size_t i = 0u; i < us.size(); ++i ) {
+        Es[ i ] = Emin + us[ i ]*width;
+      }
+      total_xs_batch( source_->get_pid(), Es.data(), f.data(), Es.size() );
+      for ( size_t i = 0u; i < f.size(); ++i ) {
+        f[ i ] *= source_->pdf( Es[ i ] ) * width / source_norm;
+      }
+    };
+  }
+
+  auto evaluate = [&]() -> std::vector<double> {
+    std::vector<double> f( us.size(), 0. );
+    integrand( f );
+    result.num_evaluations = f.size();
+    return f;
+  };
+
+  // Use a private engine so that the Generator's own random number stream
+  // is left untouched
+  std::mt19937_64 rng( seed_ );
+  std::uniform_real_distribution<double> udist;
+
+  if ( method == FluxAverageMethod::Stratified ) {
+
+    // Two points per stratum are needed to estimate the variance within it
+    size_t num_strata = ( num_points + 1u ) / 2u;
+    for ( size_t h = 0u; h < num_strata; ++h ) {
+      for ( int k = 0; k < 2; ++k ) {
+        us.push_back( (h + udist(rng)) / num_strata );
+      }
+    }
+
+    std::vector<double> f = evaluate();
+    double variance = 0.;
+    for ( size_t h = 0u; h < num_strata; ++h ) {
+      double f1 = f[ 2u*h ];
+      double f2 = f[ 2u*h + 1u ];
+      result.value += 0.5*( f1 + f2 );
+      variance += 0.25*std::pow( f1 - f2, 2 );
+    }
+    result.value /= num_strata;
+    result.error = std::sqrt( variance ) / num_strata;
+  }
+  else {
+
+    if ( num_replicates < 2u ) throw marley::Error( "At least two"
+      " replicates are needed to estimate the uncertainty of a"
+      " quasi-Monte Carlo flux-averaged total cross section" );
+
+    // Each replicate is the same van der Corput point set with its own
+    // random shift (modulo one). The scatter of the replicate means gives
+    // the error estimate.
+    size_t num_per_rep = ( num_points + num_replicates - 1u )
+      / num_replicates;
+    for ( size_t r = 0u; r < num_replicates; ++r ) {
+      double shift = udist( rng );
+      for ( size_t i = 0u; i < num_per_rep; ++i ) {
+        double u = radical_inverse_base2( i ) + shift;
+        if ( u >= 1. ) u -= 1.;
+        us.push_back( u );
+      }
+    }
+
+    std::vector<double> f = evaluate();
+    std::vector<double> means( num_replicates, 0. );
+    for ( size_t r = 0u; r < num_replicates; ++r ) {
+      for ( size_t i = 0u; i < num_per_rep; ++i ) {
+        means[ r ] += f[ r*num_per_rep + i ];
+      }
+      means[ r ] /= num_per_rep;
+      result.value += means[ r ];
+    }
+    result.value /= num_replicates;
+
+    double variance = 0.;
+    for ( double m : means ) variance += std::pow( m - result.value, 2 );
+    result.error = std::sqrt( variance / (num_replicates
+      * (num_replicates - 1u)) );
+  }
+
+  return result;
+}
+
 void marley::Generator::set_target( std::unique_ptr<marley::Target> target )
 {
   // If we're passed a nullptr, then don't bother to do anything
@@ -547,6 +1214,7 @@ void marley::Generator::set_target( std::unique_ptr<marley::Target> target )
     // Transfer ownership of the neutrino target to the generator, leaving
     // the std::unique_ptr passed to this function null afterwards.
     target_.reset( target.release() );
+    update_reaction_weights();
 
     // Don't bother to renormalize if there are no reactions defined yet
     if ( reactions_.empty() ) return;
@@ -580,6 +1248,9 @@ double marley::Generator::total_xs( int pdg_a, double KEa, int pdg_atom,
     // Skip reactions which involve a different projectile
     if ( pdg_a != r->pdg_a() ) continue;
 
+    // Skip reactions which have been disabled
+    if ( !reactions_enabled_[ j ] ) continue;
+
     // If the cross section is non-vanishing, store information about it
     // (as appropriate) and add it to the sum
     double xsec = r->total_xs( pdg_a, KEa );
@@ -598,10 +1269,22 @@ double marley::Generator::total_xs( int pdg_a, double KEa, int pdg_atom,
 marley::Event marley::Generator::create_event( int pdg_a, double KEa,
   int pdg_atom, const std::array<double, 3>& dir_vec )
 {
+  // Release the scratch memory used while creating the previous event
+  event_arena_->reset();
+
+  // If the StructureDatabase is shared in concurrent mode, use the models
+  // and cached decay objects that belong to this Generator
+  marley::StructureDatabase::WorkerScope worker( this );
+
+  // If the counter-based random number engine is in use, move to
+  // the subsequence of random numbers reserved for this event
+  rand_gen_.start_event();
+
   // (1) Sample a reaction mode from all configured reactions that can handle
-  // the given initial-state parameters
-  std::vector<size_t> indices;
-  std::vector<double> xsecs;
+  // the given initial-state parameters. The vectors that receive the
+  // results are reused from one call to the next.
+  auto& indices = external_r_indices_;
+  auto& xsecs = external_xs_values_;
   double tot_xsec = this->total_xs( pdg_a, KEa, pdg_atom, &indices, &xsecs );
 
   if ( xsecs.empty() || tot_xsec <= 0. ) throw marley::Error(
@@ -612,30 +1295,33 @@ marley::Event marley::Generator::create_event( int pdg_a, double KEa,
 
   // The total cross section values and indices in the full reactions_ vector
   // have already been loaded into temporary vectors, so we can immediately use
-  // those to sample a reaction using a discrete distribution.
-  std::discrete_distribution<size_t> react_dist( xsecs.begin(), xsecs.end() );
-  size_t sampled_index = react_dist( rand_gen_ );
+  // those to sample a reaction using an alias table.
+  double r_weight = 1.;
+  size_t sampled_index = sample_reaction_index( xsecs, &indices, r_weight );
   auto& r = reactions_.at( indices.at(sampled_index) );
 
   // (2) Create the prompt two-two scattering event using the sampled reaction
   // object
-  marley::Event ev = r->create_event( pdg_a, KEa, *this );
+  marley::Event ev;
+  {
+    marley::Instrumentation::ScopedTimer timer(
+      marley::Instrumentation::Probe::CreateEvent );
+    MARLEY_TRACE_ZONE( trace_zone, "create_event" );
+    r->create_event( pdg_a, KEa, *this, ev );
+  }
+  ev.set_weight( ev.weight() * r_weight );
 
   // Do the usual post-processing
 
   // (3) If needed, de-excite the final-state residue
-  if ( do_deexcitations_ ) {
-    marley::NucleusDecayer nd;
-    nd.process_event( ev, *this );
-  }
+  if ( do_deexcitations_ ) decayer_.process_event( ev, *this );
 
   // (4) If needed, rotate the event to match the desired projectile direction
   // Set the incident neutrino direction for this event
-  static marley::ProjectileDirectionRotator my_rotator;
-  my_rotator.set_projectile_direction( dir_vec );
+  external_rotator_.set_projectile_direction( dir_vec );
 
   // Rotate the coordinate system of the event if needed
-  my_rotator.process_event( ev, *this );
+  external_rotator_.process_event( ev, *this );
 
   // Return the completed event object
   return ev;
@@ -650,20 +1336,15 @@ double marley::Generator::total_xs( int pdg_a, double KEa ) const {
 
   // Sum all of the reaction total cross sections. Take weighting by atom
   // fraction in the target material into account.
-  for ( const auto& react : reactions_ ) {
+  for ( size_t j = 0, s = reactions_.size(); j < s; ++j ) {
+
+    const auto& react = reactions_[ j ];
+    double weight = reaction_atom_fractions_[ j ];
+    if ( weight == 0. || react->pdg_a() != pdg_a ) continue;
 
     // Compute the total cross section for the current reaction for a single
-    // target atom
-    double xsec = react->total_xs( pdg_a, KEa );
-
-    // If the target_ member has not been initialized, don't bother doing any
-    // weighting by atom fraction (equivalent to a weight of unity for all
-    // target atoms)
-    if ( target_ ) {
-      // If it has been configured, then apply the appropriate atom fraction
-      // weight from the target as appropriate.
-      xsec *= target_->atom_fraction( react->atomic_target() );
-    }
+    // target atom, weighted by its atom fraction
+    double xsec = react->total_xs( pdg_a, KEa ) * weight;
 
     // Add the weighted total cross section value to the total
     tot_xsec += xsec;
@@ -672,29 +1353,45 @@ double marley::Generator::total_xs( int pdg_a, double KEa ) const {
   return tot_xsec;
 }
 
+void marley::Generator::total_xs_batch( int pdg_a, const double* KEas,
+  double* out, size_t n ) const
+{
+  std::fill( out, out + n, 0. );
+
+  // Storage for the cross sections of a single reaction
+  std::vector<double> react_xsecs( n );
+
+  for ( size_t j = 0, s = reactions_.size(); j < s; ++j ) {
+
+    // Reactions involving a different projectile do not contribute
+    const auto& react = reactions_[ j ];
+    if ( pdg_a != react->pdg_a() ) continue;
+
+    // Weight by the atom fraction in the same way as total_xs( int, double )
+    double weight = reaction_atom_fractions_[ j ];
+    if ( weight == 0. ) continue;
+
+    react->total_xs_batch( pdg_a, KEas, react_xsecs.data(), n );
+    for ( size_t i = 0u; i < n; ++i ) out[ i ] += react_xsecs[ i ] * weight;
+  }
+}
+
 // trying to overload another function here to call in examples/executables/dumpdmxs()
-double marley::Generator::total_xs( int pdg_a, double KEa, double mass, double cutoff ) const {
+double marley::Generator::total_xs( int pdg_a, double KEa, double mass, double cutoff,
+  double velocity ) const {
 
   // Initialize the return value to zero
   double tot_xsec = 0.;
 
   // Sum all of the reaction total cross sections. Take weighting by atom
   // fraction in the target material into account.
-  for ( const auto& react : reactions_ ) {
+  for ( size_t j = 0, s = reactions_.size(); j < s; ++j ) {
 
     // Compute the total cross section for the current reaction for a single
-    // target atom
+    // target atom, weighted by its atom fraction
     //double xsec = react->total_xs( pdg_a, KEa );
-    double xsec = react->total_xs( pdg_a, KEa, mass, cutoff );
-
-    // If the target_ member has not been initialized, don't bother doing any
-    // weighting by atom fraction (equivalent to a weight of unity for all
-    // target atoms)
-    if ( target_ ) {
-      // If it has been configured, then apply the appropriate atom fraction
-      // weight from the target as appropriate.
-      xsec *= target_->atom_fraction( react->atomic_target() );
-    }
+    double xsec = reactions_[ j ]->total_xs( pdg_a, KEa, mass, cutoff,
+      velocity ) * reaction_atom_fractions_[ j ];
 
     // Add the weighted total cross section value to the total
     tot_xsec += xsec;
@@ -0,0 +1,752 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventBatch.hh"
+#include "marley/Generator.hh"
+#include "marley/HDF5OutputFile.hh"
+#include "marley/JSON.hh"
+#include "marley/Logger.hh"
+#include "marley/Particle.hh"
+#include "marley/marley_utils.hh"
+
+constexpr size_t marley::HDF5OutputFile::EVENTS_PER_BLOCK;
+
+#ifdef USE_HDF5
+
+#include "hdf5.h"
+
+namespace {
+
+  // The HDF5 library is only thread-safe if it was built with that (non-
+  // default) option, so all calls to it are serialized. This allows more
+  // than one HDF5 file to be served at once by the I/O threads of the
+  // marley executable.
+  std::mutex hdf5_mutex;
+
+  // Number of entries per chunk in each dataset
+  constexpr hsize_t CHUNK_SIZE = 4096u;
+
+  // Version number for the layout of MARLEY HDF5 files
+  constexpr int32_t HDF5_FORMAT_VERSION = 4;
+
+  // Throws a marley::Error if an HDF5 function reported a failure
+  template <typename T> T check(T result, const std::string& action) {
+    if ( result < 0 ) throw marley::Error("HDF5 error encountered while "
+      + action);
+    return result;
+  }
+
+  // Types used to store values of each kind in memory and on disk
+  template <typename T> struct HDF5Types;
+  template <> struct HDF5Types<int32_t> {
+    static hid_t memory() { return H5T_NATIVE_INT32; }
+    static hid_t file() { return H5T_STD_I32LE; }
+  };
+  template <> struct HDF5Types<int64_t> {
+    static hid_t memory() { return H5T_NATIVE_INT64; }
+    static hid_t file() { return H5T_STD_I64LE; }
+  };
+  template <> struct HDF5Types<double> {
+    static hid_t memory() { return H5T_NATIVE_DOUBLE; }
+    static hid_t file() { return H5T_IEEE_F64LE; }
+  };
+
+  // A one-dimensional, extendible dataset together with the values that
+  // have not yet been written to it
+  template <typename T> class Column {
+
+    public:
+
+      Column() {}
+
+      ~Column() { this->close(); }
+
+      // Values are converted to file_type (if it differs from the type used
+      // in memory) when they are written
+      void create(hid_t group, const char* name, int deflate_level,
+        hid_t file_type = HDF5Types<T>::file())
+      {
+        name_ = name;
+        hsize_t dims = 0u;
+        hsize_t max_dims = H5S_UNLIMITED;
+        hid_t space = check( H5Screate_simple(1, &dims, &max_dims),
+          "creating a dataspace" );
+        hid_t dcpl = check( H5Pcreate(H5P_DATASET_CREATE),
+          "creating a dataset property list" );
+        check( H5Pset_chunk(dcpl, 1, &CHUNK_SIZE), "setting a chunk size" );
+        if ( deflate_level > 0 ) check( H5Pset_deflate(dcpl, deflate_level),
+          "enabling compression" );
+        dataset_ = H5Dcreate2( group, name, file_type, space,
+          H5P_DEFAULT, dcpl, H5P_DEFAULT );
+        H5Pclose( dcpl );
+        H5Sclose( space );
+        check( dataset_, "creating the dataset " + name_ );
+        size_ = 0u;
+      }
+
+      void open(hid_t group, const char* name) {
+        name_ = name;
+        dataset_ = check( H5Dopen2(group, name, H5P_DEFAULT),
+          "opening the dataset " + name_ );
+        hid_t space = check( H5Dget_space(dataset_), "accessing the"
+          " dataspace of " + name_ );
+        int rank = H5Sget_simple_extent_dims( space, &size_, nullptr );
+        H5Sclose( space );
+        if ( rank != 1 ) throw marley::Error("The HDF5 dataset " + name_
+          + " is not one-dimensional");
+      }
+
+      inline void push_back(T value) { buffer_.push_back( value ); }
+
+      inline void append(const T* values, size_t count)
+        { buffer_.insert( buffer_.end(), values, values + count ); }
+
+      // Number of values that have not yet been written to the dataset
+      inline size_t buffered() const { return buffer_.size(); }
+
+      // Number of values, including those that are still buffered
+      inline hsize_t size() const { return size_ + buffer_.size(); }
+
+      // Appends the buffered values to the dataset
+      void flush() {
+        if ( buffer_.empty() ) return;
+        hsize_t start = size_;
+        hsize_t count = buffer_.size();
+        hsize_t new_size = size_ + count;
+        check( H5Dset_extent(dataset_, &new_size), "extending " + name_ );
+
+        hid_t file_space = check( H5Dget_space(dataset_), "accessing the"
+          " dataspace of " + name_ );
+        hid_t memory_space = H5Screate_simple( 1, &count, nullptr );
+        herr_t status = H5Sselect_hyperslab( file_space, H5S_SELECT_SET,
+          &start, nullptr, &count, nullptr );
+        if ( status >= 0 ) status = H5Dwrite( dataset_,
+          HDF5Types<T>::memory(), memory_space, file_space, H5P_DEFAULT,
+          buffer_.data() );
+        H5Sclose( memory_space );
+        H5Sclose( file_space );
+        check( status, "writing to " + name_ );
+
+        size_ = new_size;
+        buffer_.clear();
+      }
+
+      void close() {
+        if ( dataset_ >= 0 ) H5Dclose( dataset_ );
+        dataset_ = -1;
+      }
+
+    private:
+
+      std::string name_;
+      hid_t dataset_ = -1;
+
+      // Number of values that have already been written to the dataset
+      hsize_t size_ = 0u;
+
+      std::vector<T> buffer_;
+  };
+
+  // Columns that describe a list of particles
+  struct ParticleColumns {
+
+    Column<int32_t> pdg;
+    Column<double> E, px, py, pz, mass;
+    Column<int32_t> charge;
+
+    // If true, then the E column holds kinetic energies
+    bool kinetic = false;
+
+    // The second argument of func is true for the columns that hold
+    // energies and momenta
+    template <typename Function> void for_each(Function func) {
+      func( pdg, "pdg", false );
+      func( E, kinetic ? "KE" : "E", true );
+      func( px, "px", true );
+      func( py, "py", true );
+      func( pz, "pz", true );
+      func( mass, "mass", true );
+      func( charge, "charge", false );
+    }
+
+    void add(const marley::Particle& p) {
+      pdg.push_back( p.pdg_code() );
+      E.push_back( kinetic ? p.kinetic_energy() : p.total_energy() );
+      px.push_back( p.px() );
+      py.push_back( p.py() );
+      pz.push_back( p.pz() );
+      mass.push_back( p.mass() );
+      charge.push_back( static_cast<int32_t>(p.charge()) );
+    }
+
+    // Adds the particles from positions [first, first + count) of the
+    // particle columns of an EventBatch
+    void append(const marley::EventBatch& batch, size_t first,
+      size_t count)
+    {
+      pdg.append( batch.pdgs().data() + first, count );
+      if ( kinetic ) {
+        for ( size_t j = first; j < first + count; ++j ) {
+          E.push_back( batch.Es()[j] - batch.masses()[j] );
+        }
+      }
+      else E.append( batch.Es().data() + first, count );
+      px.append( batch.pxs().data() + first, count );
+      py.append( batch.pys().data() + first, count );
+      pz.append( batch.pzs().data() + first, count );
+      mass.append( batch.masses().data() + first, count );
+      charge.append( batch.charges().data() + first, count );
+    }
+  };
+
+  // Opens or creates a group within an HDF5 file
+  hid_t access_group(hid_t file, const char* name, bool create) {
+    hid_t group = create
+      ? H5Gcreate2( file, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT )
+      : H5Gopen2( file, name, H5P_DEFAULT );
+    return check( group, std::string("accessing the group ") + name );
+  }
+
+  // Writes a scalar attribute of the root group, replacing any previous
+  // value
+  template <typename T> void write_attribute(hid_t file, const char* name,
+    T value)
+  {
+    if ( check(H5Aexists(file, name), "checking for an attribute") > 0 ) {
+      check( H5Adelete(file, name), "deleting an attribute" );
+    }
+    hid_t space = check( H5Screate(H5S_SCALAR), "creating a dataspace" );
+    hid_t attribute = H5Acreate2( file, name, HDF5Types<T>::file(), space,
+      H5P_DEFAULT, H5P_DEFAULT );
+    herr_t status = attribute;
+    if ( attribute >= 0 ) {
+      status = H5Awrite( attribute, HDF5Types<T>::memory(), &value );
+      H5Aclose( attribute );
+    }
+    H5Sclose( space );
+    check( status, std::string("writing the attribute ") + name );
+  }
+
+  // Reads a scalar attribute of the root group. Returns false if the
+  // attribute does not exist.
+  template <typename T> bool read_attribute(hid_t file, const char* name,
+    T& value)
+  {
+    if ( check(H5Aexists(file, name), "checking for an attribute") <= 0 ) {
+      return false;
+    }
+    hid_t attribute = check( H5Aopen(file, name, H5P_DEFAULT),
+      std::string("opening the attribute ") + name );
+    herr_t status = H5Aread( attribute, HDF5Types<T>::memory(), &value );
+    H5Aclose( attribute );
+    check( status, std::string("reading the attribute ") + name );
+    return true;
+  }
+
+}
+
+struct marley::HDF5OutputFile::Columns {
+
+  ~Columns() { this->close(); }
+
+  // Event columns
+  Column<double> Ex;
+  Column<int32_t> twoJ, parity;
+  Column<double> weight, time;
+  Column<int32_t> projectile_pdg;
+  Column<double> projectile_E, projectile_px, projectile_py, projectile_pz;
+  Column<int32_t> ejectile_pdg;
+  Column<double> ejectile_E, ejectile_px, ejectile_py, ejectile_pz;
+  Column<int64_t> initial_offsets, final_offsets;
+
+  // Particle columns
+  ParticleColumns initial, final;
+
+  // If true, then the energies and momenta are stored in single precision,
+  // and the energy columns hold kinetic energies
+  bool single_precision = false;
+
+  // The third argument of func is true for the columns that hold energies
+  // and momenta
+  template <typename Function> void for_each_event_column(Function func) {
+    bool kinetic = single_precision;
+    func( Ex, "Ex", false );
+    func( twoJ, "twoJ", false );
+    func( parity, "parity", false );
+    func( weight, "weight", false );
+    func( time, "time", false );
+    func( projectile_pdg, "projectile_pdg", false );
+    func( projectile_E, kinetic ? "projectile_KE" : "projectile_E", true );
+    func( projectile_px, "projectile_px", true );
+    func( projectile_py, "projectile_py", true );
+    func( projectile_pz, "projectile_pz", true );
+    func( ejectile_pdg, "ejectile_pdg", false );
+    func( ejectile_E, kinetic ? "ejectile_KE" : "ejectile_E", true );
+    func( ejectile_px, "ejectile_px", true );
+    func( ejectile_py, "ejectile_py", true );
+    func( ejectile_pz, "ejectile_pz", true );
+    func( initial_offsets, "initial_offsets", false );
+    func( final_offsets, "final_offsets", false );
+  }
+
+  void set_single_precision(bool single) {
+    single_precision = single;
+    initial.kinetic = single;
+    final.kinetic = single;
+  }
+
+  // Creates (if create is true) or opens the datasets in a file
+  void access(bool create, int deflate_level) {
+    bool single = single_precision;
+    auto connect = [create, deflate_level, single](hid_t group) {
+      return [group, create, deflate_level, single](auto& column,
+        const char* name, bool kinematic)
+      {
+        if ( !create ) column.open( group, name );
+        else if ( single && kinematic ) column.create( group, name,
+          deflate_level, H5T_IEEE_F32LE );
+        else column.create( group, name, deflate_level );
+      };
+    };
+
+    hid_t events = access_group( file, "events", create );
+    this->for_each_event_column( connect(events) );
+    H5Gclose( events );
+
+    hid_t initial_group = access_group( file, "initial_particles", create );
+    initial.for_each( connect(initial_group) );
+    H5Gclose( initial_group );
+
+    hid_t final_group = access_group( file, "final_particles", create );
+    final.for_each( connect(final_group) );
+    H5Gclose( final_group );
+  }
+
+  void flush() {
+    auto flush_column = [](auto& column, const char*, bool)
+      { column.flush(); };
+    this->for_each_event_column( flush_column );
+    initial.for_each( flush_column );
+    final.for_each( flush_column );
+  }
+
+  void close() {
+    auto close_column = [](auto& column, const char*, bool)
+      { column.close(); };
+    this->for_each_event_column( close_column );
+    initial.for_each( close_column );
+    final.for_each( close_column );
+    if ( file >= 0 ) H5Fclose( file );
+    file = -1;
+  }
+
+  hid_t file = -1;
+};
+
+marley::HDF5OutputFile::HDF5OutputFile(const std::string& name,
+  const std::string& format, const std::string& mode, bool force,
+  const std::string& compression, int compression_level,
+  bool single_precision) : marley::OutputFile(name, format, mode, force),
+  columns_( new Columns )
+{
+  if (format_ != Format::HDF5) throw marley::Error("The output format \""
+    + format + "\" cannot be used with an HDF5OutputFile");
+
+  if (compression == "gzip") {
+    if (compression_level < 0 || compression_level > 9) throw marley::Error(
+      "Invalid gzip compression level " + std::to_string(compression_level)
+      + " requested for the HDF5 file \"" + name + '\"');
+    // Use the same default level as the gzip command-line tool
+    deflate_level_ = ( compression_level == 0 ) ? 6 : compression_level;
+  }
+  else if (compression != "none") throw marley::Error("Unrecognized"
+    " compression algorithm \"" + compression + "\" requested for the"
+    " HDF5 file \"" + name + '\"');
+
+  columns_->set_single_precision( single_precision );
+  this->open();
+}
+
+marley::HDF5OutputFile::~HDF5OutputFile() {
+  std::lock_guard<std::mutex> lock( hdf5_mutex );
+  columns_.reset();
+}
+
+void marley::HDF5OutputFile::open() {
+  bool file_exists = check_if_file_exists(name_);
+
+  if (mode_ == Mode::OVERWRITE && file_exists && !force_) {
+    bool overwrite = marley_utils::prompt_yes_no("Overwrite file "
+      + name_);
+    if (!overwrite) {
+      MARLEY_LOG_INFO() << "Cancelling overwrite of output file \""
+        << name_ << '\"';
+      mode_ = Mode::RESUME;
+    }
+  }
+
+  if (mode_ == Mode::RESUME) {
+    if (!file_exists) throw marley::Error("Cannot resume run. Could"
+      " not open the HDF5 file \"" + name_ + '\"');
+    // The file will be opened by resume()
+    return;
+  }
+  else if (mode_ != Mode::OVERWRITE)
+    throw marley::Error("Unrecognized file mode encountered in"
+      " HDF5OutputFile::open()");
+
+  std::lock_guard<std::mutex> lock( hdf5_mutex );
+
+  columns_->file = H5Fcreate( name_.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT,
+    H5P_DEFAULT );
+  if ( columns_->file < 0 ) throw marley::Error("Could not open the HDF5"
+    " output file \"" + name_ + '\"');
+
+  write_attribute( columns_->file, "format_version", HDF5_FORMAT_VERSION );
+  write_attribute( columns_->file, "flux_avg_tot_xsec", 0. );
+  write_attribute( columns_->file, "single_precision",
+    static_cast<int32_t>(columns_->single_precision) );
+  columns_->access( true, deflate_level_ );
+
+  // The offsets for the first event start at zero
+  columns_->initial_offsets.push_back( 0 );
+  columns_->final_offsets.push_back( 0 );
+}
+
+bool marley::HDF5OutputFile::resume(std::unique_ptr<marley::Generator>& gen,
+  long& num_previous_events)
+{
+  if (mode_ != Mode::RESUME) {
+    throw marley::Error("Cannot call HDF5Output"
+      "File::resume() for an output mode other than \"resume\"");
+    return false;
+  }
+
+  MARLEY_LOG_INFO() << "Continuing previous run from HDF5 file "
+    << name_;
+
+  std::lock_guard<std::mutex> lock( hdf5_mutex );
+
+  columns_->file = H5Fopen( name_.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
+  if ( columns_->file < 0 ) throw marley::Error("The file \"" + name_
+    + "\" is not a valid HDF5 file");
+
+  // The metadata dataset is written when the file is closed. If it is
+  // missing, then the previous run was not terminated cleanly.
+  std::string json_text;
+  bool metadata_ok = H5Lexists( columns_->file, "metadata",
+    H5P_DEFAULT ) > 0;
+  if ( metadata_ok ) {
+    hid_t dataset = check( H5Dopen2(columns_->file, "metadata",
+      H5P_DEFAULT), "opening the metadata dataset" );
+    hid_t type = H5Dget_type( dataset );
+    json_text.assign( H5Tget_size(type), '\0' );
+    metadata_ok = H5Dread( dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+      &json_text.front() ) >= 0;
+    H5Tclose( type );
+    H5Dclose( dataset );
+  }
+
+  if (!metadata_ok) {
+    throw marley::Error("Missing generator configuration in HDF5"
+      " file \"" + name_ + "\": could not restore previous state");
+    return false;
+  }
+
+  // Remove any padding after the JSON text
+  json_text.erase( json_text.find_last_not_of('\0') + 1u );
+  marley::JSON gen_state = marley::JSON::load(json_text);
+
+  if (!gen_state.has_key("config")) {
+    throw marley::Error("Failed to load previous configuration from"
+      " the HDF5 file \"" + name_ + '\"');
+    return false;
+  }
+  const marley::JSON& config = gen_state.at("config");
+
+  if (!gen_state.has_key("generator_state_string")) {
+    throw marley::Error("Failed to load previous generator state from"
+      " the HDF5 file \"" + name_ + '\"');
+    return false;
+  }
+  std::string state_string
+    = gen_state.at("generator_state_string").to_string();
+
+  if (!gen_state.has_key("seed")) {
+    throw marley::Error("Failed to load previous random number"
+      " generator seed from the HDF5 file \"" + name_ + '\"');
+    return false;
+  }
+  std::string seed = gen_state.at("seed").to_string();
+
+  bool count_ok = true;
+  if (!gen_state.has_key("event_count")) count_ok = false;
+  else num_previous_events = gen_state.at(
+    "event_count").to_long(count_ok);
+
+  if (!count_ok) {
+    throw marley::Error("Failed to load previous event count"
+      " from the HDF5 file \"" + name_ + '\"');
+    return false;
+  }
+
+  // Files written before the single_precision attribute was added always
+  // use double precision
+  int32_t single_precision = 0;
+  read_attribute( columns_->file, "single_precision", single_precision );
+  if ( (single_precision != 0) != columns_->single_precision ) {
+    throw marley::Error("Cannot resume run. The precision of the HDF5 file"
+      " \"" + name_ + "\" does not match the one requested in the job"
+      " configuration.");
+    return false;
+  }
+
+  // Reopen the datasets so that new events are appended to them
+  columns_->access( false, deflate_level_ );
+
+  hsize_t num_rows = columns_->Ex.size();
+  if ( num_rows != static_cast<hsize_t>(num_previous_events)
+    || columns_->initial_offsets.size() != num_rows + 1u
+    || columns_->final_offsets.size() != num_rows + 1u )
+  {
+    throw marley::Error("Cannot resume run. The event datasets in the HDF5"
+      " file \"" + name_ + "\" are inconsistent with its metadata.");
+    return false;
+  }
+
+  gen = this->restore_generator( config );
+  gen->seed_using_state_string( state_string );
+
+  MARLEY_LOG_INFO() << "The previous run was initialized using"
+    << " the random number generator seed " << seed;
+
+  return true;
+}
+
+int_fast64_t marley::HDF5OutputFile::bytes_written() {
+  // If the file is open, then update the byte count. Otherwise, just
+  // use the saved value.
+  std::lock_guard<std::mutex> lock( hdf5_mutex );
+  hsize_t size = 0u;
+  if ( columns_->file >= 0 && H5Fget_filesize(columns_->file, &size) >= 0 ) {
+    byte_count_ = static_cast<int_fast64_t>( size );
+  }
+  return byte_count_;
+}
+
+void marley::HDF5OutputFile::write_event(const marley::Event* event) {
+  if (!event) throw marley::Error("Null pointer passed to"
+    " HDF5OutputFile::write_event()");
+
+  auto& c = *columns_;
+
+  // Index entries for the HDF5 format hold the row number of each event
+  if ( index_enabled() ) this->index_event( c.Ex.size() );
+
+  c.Ex.push_back( event->Ex() );
+  c.twoJ.push_back( event->twoJ() );
+  c.parity.push_back( static_cast<int>(event->parity()) );
+  c.weight.push_back( event->weight() );
+  c.time.push_back( event->time() );
+
+  const auto& projectile = event->projectile();
+  c.projectile_pdg.push_back( projectile.pdg_code() );
+  c.projectile_E.push_back( c.single_precision
+    ? projectile.kinetic_energy() : projectile.total_energy() );
+  c.projectile_px.push_back( projectile.px() );
+  c.projectile_py.push_back( projectile.py() );
+  c.projectile_pz.push_back( projectile.pz() );
+
+  const auto& ejectile = event->ejectile();
+  c.ejectile_pdg.push_back( ejectile.pdg_code() );
+  c.ejectile_E.push_back( c.single_precision
+    ? ejectile.kinetic_energy() : ejectile.total_energy() );
+  c.ejectile_px.push_back( ejectile.px() );
+  c.ejectile_py.push_back( ejectile.py() );
+  c.ejectile_pz.push_back( ejectile.pz() );
+
+  for ( const auto& p : event->get_initial_particles() ) c.initial.add( p );
+  for ( const auto& p : event->get_final_particles() ) c.final.add( p );
+  c.initial_offsets.push_back(
+    static_cast<int64_t>(c.initial.pdg.size()) );
+  c.final_offsets.push_back(
+    static_cast<int64_t>(c.final.pdg.size()) );
+
+  if ( c.Ex.buffered() >= EVENTS_PER_BLOCK ) {
+    std::lock_guard<std::mutex> lock( hdf5_mutex );
+    c.flush();
+  }
+}
+
+void marley::HDF5OutputFile::write_events(const marley::EventBatch& batch)
+{
+  auto& c = *columns_;
+
+  for ( size_t e = 0u; e < batch.size(); ++e ) {
+
+    if ( index_enabled() ) this->index_event( c.Ex.size() );
+
+    c.Ex.push_back( batch.Exs()[e] );
+    c.twoJ.push_back( batch.twoJs()[e] );
+    c.parity.push_back( batch.parities()[e] );
+    c.weight.push_back( batch.weights()[e] );
+    c.time.push_back( batch.times()[e] );
+
+    // The projectile and ejectile are the first initial and final
+    // particles, respectively
+    size_t j = batch.first_particle( e );
+    c.projectile_pdg.push_back( batch.pdgs()[j] );
+    c.projectile_E.push_back( c.single_precision
+      ? batch.Es()[j] - batch.masses()[j] : batch.Es()[j] );
+    c.projectile_px.push_back( batch.pxs()[j] );
+    c.projectile_py.push_back( batch.pys()[j] );
+    c.projectile_pz.push_back( batch.pzs()[j] );
+
+    size_t k = batch.first_final_particle( e );
+    c.ejectile_pdg.push_back( batch.pdgs()[k] );
+    c.ejectile_E.push_back( c.single_precision
+      ? batch.Es()[k] - batch.masses()[k] : batch.Es()[k] );
+    c.ejectile_px.push_back( batch.pxs()[k] );
+    c.ejectile_py.push_back( batch.pys()[k] );
+    c.ejectile_pz.push_back( batch.pzs()[k] );
+
+    c.initial.append( batch, j, batch.num_initial(e) );
+    c.final.append( batch, k, batch.num_final(e) );
+    c.initial_offsets.push_back(
+      static_cast<int64_t>(c.initial.pdg.size()) );
+    c.final_offsets.push_back(
+      static_cast<int64_t>(c.final.pdg.size()) );
+
+    if ( c.Ex.buffered() >= EVENTS_PER_BLOCK ) {
+      std::lock_guard<std::mutex> lock( hdf5_mutex );
+      c.flush();
+    }
+  }
+}
+
+void marley::HDF5OutputFile::write_generator_state(
+  const marley::JSON& json_config, const GeneratorState& gen_state,
+  const long num_events)
+{
+  marley::JSON temp = marley::JSON::object();
+
+  temp["config"] = json_config;
+  temp["generator_state_string"] = gen_state.state_string;
+  temp["seed"] = std::to_string(gen_state.seed);
+  temp["event_count"] = num_events;
+  temp["flux_avg_xsec"] = gen_state.flux_avg_xsec;
+
+  std::string json_text = temp.dump_string();
+
+  hid_t file = columns_->file;
+  if ( check(H5Lexists(file, "metadata", H5P_DEFAULT), "checking for the"
+    " metadata dataset") > 0 )
+  {
+    check( H5Ldelete(file, "metadata", H5P_DEFAULT), "deleting the old"
+      " metadata" );
+  }
+
+  hid_t type = check( H5Tcopy(H5T_C_S1), "creating a string type" );
+  H5Tset_size( type, std::max<size_t>(json_text.size(), 1u) );
+  hid_t space = H5Screate( H5S_SCALAR );
+  hid_t dataset = H5Dcreate2( file, "metadata", type, space, H5P_DEFAULT,
+    H5P_DEFAULT, H5P_DEFAULT );
+  herr_t status = dataset;
+  if ( dataset >= 0 ) {
+    status = H5Dwrite( dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+      json_text.c_str() );
+    H5Dclose( dataset );
+  }
+  H5Sclose( space );
+  H5Tclose( type );
+  check( status, "writing the metadata dataset" );
+}
+
+void marley::HDF5OutputFile::close(const marley::JSON& json_config,
+  const GeneratorState& gen_state, const long num_events)
+{
+  {
+    std::lock_guard<std::mutex> lock( hdf5_mutex );
+    if ( columns_->file < 0 ) return;
+
+    columns_->flush();
+
+    // Save the current state of the generator in case we want to resume a
+    // run later
+    write_generator_state(json_config, gen_state, num_events);
+  }
+
+  this->bytes_written();
+
+  {
+    std::lock_guard<std::mutex> lock( hdf5_mutex );
+    columns_->close();
+  }
+  this->close_index();
+}
+
+void marley::HDF5OutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
+{
+  std::lock_guard<std::mutex> lock( hdf5_mutex );
+  if ( columns_->file >= 0 ) write_attribute( columns_->file,
+    "flux_avg_tot_xsec", avg_tot_xsec );
+}
+
+#else
+
+// Without HDF5 support, the constructor always throws, so the remaining
+// member functions will never be called
+struct marley::HDF5OutputFile::Columns {};
+
+marley::HDF5OutputFile::HDF5OutputFile(const std::string& name,
+  const std::string& format, const std::string& mode, bool force,
+  const std::string&, int, bool)
+  : marley::OutputFile(name, format, mode, force)
+{
+  throw marley::Error("The HDF5 output file \"" + name + "\" cannot be"
+    " written because MARLEY was built without HDF5 support");
+}
+
+marley::HDF5OutputFile::~HDF5OutputFile() = default;
+
+void marley::HDF5OutputFile::open() {}
+
+bool marley::HDF5OutputFile::resume(std::unique_ptr<marley::Generator>&,
+  long&) { return false; }
+
+int_fast64_t marley::HDF5OutputFile::bytes_written() { return byte_count_; }
+
+void marley::HDF5OutputFile::write_event(const marley::Event*) {}
+
+void marley::HDF5OutputFile::write_events(const marley::EventBatch&) {}
+
+void marley::HDF5OutputFile::write_generator_state(const marley::JSON&,
+  const GeneratorState&, const long) {}
+
+void marley::HDF5OutputFile::close(const marley::JSON&,
+  const GeneratorState&, const long) {}
+
+void marley::HDF5OutputFile::write_flux_avg_tot_xsec(double) {}
+
+#endif
@@ -14,32 +14,96 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
-#include <memory>
+#include <algorithm>
+#include <functional>
+#include <utility>
 
 #include "marley/ExitChannel.hh"
 #include "marley/Generator.hh"
 #include "marley/MassTable.hh"
 #include "marley/HauserFeshbachDecay.hh"
+#include "marley/Instrumentation.hh"
+#include "marley/Logger.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/TaskPool.hh"
 #include "marley/marley_utils.hh"
 
 marley::HauserFeshbachDecay::HauserFeshbachDecay(const marley::Particle&
   compound_nucleus, double Exi, int twoJi, marley::Parity Pi,
-  marley::StructureDatabase& sdb) : compound_nucleus_(compound_nucleus),
-  Exi_(Exi), twoJi_(twoJi), Pi_(Pi)
+  marley::StructureDatabase& sdb)
 {
+  this->reset( compound_nucleus, Exi, twoJi, Pi, sdb );
+}
+
+void marley::HauserFeshbachDecay::reset(
+  const marley::Particle& compound_nucleus, double Exi, int twoJi,
+  marley::Parity Pi, marley::StructureDatabase& sdb)
+{
+  marley::Instrumentation::ScopedTimer timer(
+    marley::Instrumentation::Probe::HauserFeshbachDecay );
+
+  compound_nucleus_ = compound_nucleus;
+  Exi_ = Exi;
+  twoJi_ = twoJi;
+  Pi_ = Pi;
+
   build_exit_channels( sdb );
 }
 
+void marley::HauserFeshbachDecay::add_channel( ChannelKind kind, size_t index,
+  double width )
+{
+  channel_refs_.push_back( ChannelRef{ kind, index } );
+  widths_.push_back( width );
+  total_width_ += width;
+}
+
+marley::ExitChannel* marley::HauserFeshbachDecay::get_channel(
+  const ChannelRef& ref )
+{
+  switch ( ref.kind ) {
+    case ChannelKind::FragmentDiscrete:
+      return &fragment_discrete_[ ref.index ];
+    case ChannelKind::FragmentContinuum:
+      return &fragment_continuum_[ ref.index ];
+    case ChannelKind::GammaDiscrete:
+      return &gamma_discrete_[ ref.index ];
+    case ChannelKind::GammaContinuum:
+      return &gamma_continuum_[ ref.index ];
+    case ChannelKind::DiscretePool:
+      return nullptr;
+  }
+  throw marley::Error( "Unrecognized exit channel type encountered in"
+    " marley::HauserFeshbachDecay::get_channel()" );
+}
+
 void marley::HauserFeshbachDecay::build_exit_channels(
   marley::StructureDatabase& sdb)
 {
-  // Remove any pre-existing ExitChannel objects, just in case
+  // Remove any pre-existing ExitChannel objects. The vectors keep their
+  // capacity, so refilling them for a new compound nucleus state does not
+  // normally require any new allocations.
+  fragment_discrete_.clear();
+  fragment_continuum_.clear();
+  gamma_discrete_.clear();
+  gamma_continuum_.clear();
+  discrete_pools_.clear();
+  pooled_fragment_.clear();
+  pooled_gamma_.clear();
+  channel_refs_.clear();
+  widths_.clear();
   exit_channels_.clear();
+  exit_channel_table_.clear();
+  channel_weights_.clear();
+  num_deferred_widths_ = 0u;
+
+  // Check whether the widths of continuum channels should be computed only
+  // when they are needed for sampling
+  bool defer = sdb.get_lazy_continuum_widths();
 
   int pdgi = compound_nucleus_.pdg_code();
   int Zi = marley_utils::get_particle_Z( pdgi );
   int Ai = marley_utils::get_particle_A( pdgi );
-  int qi = compound_nucleus_.charge(); // Get net charge of initial ion
 
   // Get the initial nuclear level density (MeV^{-1}) in the vicinity of the
   // initial nuclear level. This will be used to apply an overall normalization
@@ -48,33 +112,25 @@ void marley::HauserFeshbachDecay::build_exit_channels(
   // meaningful units when possible.
   marley::LevelDensityModel& ldm = sdb.get_level_density_model( Zi, Ai );
   double rho_i = ldm.level_density( Exi_, twoJi_, Pi_ );
+  rho_i_ = rho_i;
+  sdb_ = &sdb;
 
   total_width_ = 0.; // total compound nucleus decay width
 
-  for ( const auto& pair : sdb.fragments() ) {
-
-    const marley::Fragment& f = pair.second;
-
-    // Get information about the current fragment
-    int two_s = f.get_two_s(); // spin
-    marley::Parity Pa = f.get_parity();
-    int fragment_pid = f.get_pid();
-    int Za = f.get_Z(); // atomic number
-    double Ma = f.get_mass(); // mass
+  // The separation energies for this nuclide are computed only once. If the
+  // excitation energy is below all of them, only gamma-ray emission is
+  // possible, so the fragment channels are skipped entirely.
+  const auto& thresholds = sdb.get_channel_thresholds( pdgi );
+  bool fragments_open = ( Exi_ > thresholds.unbound_threshold );
+  size_t f_index = 0u;
 
-    // Get information about the final-state nucleus
-    int Zf = Zi - f.get_Z(); // atomic number
-    int Af = Ai - f.get_A(); // mass number
-    int pdg_final = marley_utils::get_nucleus_pid(Zf, Af);
+  open_fragments_.clear();
+  for ( const auto& pair : sdb.fragments() ) {
 
-    // Approximate the ground state mass of the ion formed when the fragment f
-    // is emitted by adding (Za - qi) electron masses to the atomic mass for
-    // the final nucleus.
-    const auto& mt = marley::MassTable::Instance();
-    double Sa = mt.get_fragment_separation_energy( Zi, Ai, fragment_pid );
+    if ( !fragments_open ) break;
 
-    // Get discrete level data (if any) and models for the final nucleus
-    marley::DecayScheme* ds = sdb.get_decay_scheme(pdg_final);
+    const marley::Fragment& f = pair.second;
+    double Sa = thresholds.separation_energies[ f_index++ ];
 
     // Determine the maximum excitation energy available after fragment
     // emission in the final nucleus. This is simply the difference
@@ -87,59 +143,122 @@ void marley::HauserFeshbachDecay::build_exit_channels(
     // numerical problems.
     if ( Exf_max <= 0. ) continue;
 
-    // Let the continuum go down to 0 MeV unless there is a decay scheme object
-    // available for the final nuclide (we'll check this in a second).
-    double E_c_min = 0.;
-
-    // If discrete level data are available for the final nuclide, get decay
-    // widths for each accessible level
-    if (ds) {
-
-      // Get a vector of pointers to levels in the decay scheme. The levels are
-      // sorted in order of increasing excitation energy.
-      const auto& levels = ds->get_levels();
-
-      // Use the maximum discrete level energy from the decay scheme object as
-      // the lower bound for the continuum
-      // TODO: consider whether this is the best approach
-      if (levels.size() > 0) E_c_min = levels.back()->energy();
-
-      // Loop over the final discrete nuclear levels in order of increasing
-      // energy until the new level energy exceeds the maximum value. For each
-      // energetically allowed level, if a transition to it for a given
-      // fragment orbital angular momentum l and total angular momentum j
-      // conserves parity, then compute an optical model transmission
-      // coefficient and add it to the total.
-      for (const auto& level : levels) {
-        double Exf = level->energy();
-        if (Exf < Exf_max)  {
-
-          // Store information for this decay channel
-	  auto ec = std::make_unique<marley::FragmentDiscreteExitChannel>(
-            pdgi, qi, Exi_, twoJi_, Pi_, rho_i, sdb, *level, f );
-
-          total_width_ += ec->width();
-
-          exit_channels_.push_back( std::move(ec) );
-        }
-        else break;
-      }
+    open_fragments_.push_back( OpenFragment{ &f, Exf_max } );
+  }
+
+  // The channels for each fragment (and for gamma-ray emission) use
+  // separate nuclear models, so they may be built at the same time by
+  // several threads if the database allows it
+  if ( sdb.get_parallel_exit_channels() && sdb.get_concurrent()
+    && !open_fragments_.empty() && marley::TaskPool::Instance().num_threads() )
+  {
+    build_channels_in_parallel( sdb, rho_i, defer );
+  }
+  else {
+    ChannelOutput out{ fragment_discrete_, fragment_continuum_,
+      gamma_discrete_, gamma_continuum_, channel_refs_, widths_ };
+    for ( const auto& open : open_fragments_ ) {
+      build_fragment_channels( sdb, open, rho_i, defer, out );
     }
+    build_gamma_channels( sdb, rho_i, defer, out );
+  }
+
+  for ( double width : widths_ ) total_width_ += width;
+
+  if ( defer ) {
+    num_deferred_widths_ = fragment_continuum_.size()
+      + gamma_continuum_.size();
+  }
+
+  double pool_tol = sdb.get_discrete_pool_tolerance();
+  if ( pool_tol > 0. ) this->pool_discrete_channels( pool_tol );
+
+  // Now that the typed storage will no longer grow, record stable pointers
+  // to the owned channels in sampling order
+  for ( const auto& ref : channel_refs_ ) {
+    exit_channels_.push_back( get_channel(ref) );
+  }
+}
+
+void marley::HauserFeshbachDecay::build_fragment_channels(
+  marley::StructureDatabase& sdb, const OpenFragment& open, double rho_i,
+  bool defer, ChannelOutput& out ) const
+{
+  const marley::Fragment& f = *open.fragment;
+  double Exf_max = open.Exf_max;
+
+  int pdgi = compound_nucleus_.pdg_code();
+  int qi = compound_nucleus_.charge();
+
+  // Get information about the final-state nucleus
+  int Zf = marley_utils::get_particle_Z( pdgi ) - f.get_Z(); // atomic number
+  int Af = marley_utils::get_particle_A( pdgi ) - f.get_A(); // mass number
+  int pdg_final = marley_utils::get_nucleus_pid(Zf, Af);
 
-    // If transitions to the energy continuum are possible, include the
-    // continuum in the decay channels
-    if ( Exf_max > E_c_min ) {
+  // Get discrete level data (if any) and models for the final nucleus
+  marley::DecayScheme* ds = sdb.get_decay_scheme(pdg_final);
 
-      // Create an ExitChannel object to handle decays to the continuum
-      auto ec = std::make_unique<marley::FragmentContinuumExitChannel>(
-        pdgi, qi, Exi_, twoJi_, Pi_, rho_i, sdb, E_c_min, f );
+  // Let the continuum go down to 0 MeV unless there is a decay scheme object
+  // available for the final nuclide (we'll check this in a second).
+  double E_c_min = 0.;
+
+  // If discrete level data are available for the final nuclide, get decay
+  // widths for each accessible level
+  if (ds) {
 
-      total_width_ += ec->width();
+    // Get a vector of pointers to levels in the decay scheme. The levels are
+    // sorted in order of increasing excitation energy.
+    const auto& levels = ds->get_levels();
+
+    // Use the maximum discrete level energy from the decay scheme object as
+    // the lower bound for the continuum
+    // TODO: consider whether this is the best approach
+    if (levels.size() > 0) E_c_min = levels.back()->energy();
 
-      exit_channels_.push_back( std::move(ec) );
+    // Loop over the final discrete nuclear levels in order of increasing
+    // energy until the new level energy exceeds the maximum value. For each
+    // energetically allowed level, if a transition to it for a given
+    // fragment orbital angular momentum l and total angular momentum j
+    // conserves parity, then compute an optical model transmission
+    // coefficient and add it to the total.
+    for (const auto& level : levels) {
+      double Exf = level->energy();
+      if (Exf < Exf_max)  {
+
+        // Store information for this decay channel
+        out.fragment_discrete.emplace_back( pdgi, qi, Exi_, twoJi_, Pi_,
+          rho_i, sdb, *level, f );
+
+        out.refs.push_back( ChannelRef{ ChannelKind::FragmentDiscrete,
+          out.fragment_discrete.size() - 1u } );
+        out.widths.push_back( out.fragment_discrete.back().width() );
+      }
+      else break;
     }
   }
 
+  // If transitions to the energy continuum are possible, include the
+  // continuum in the decay channels
+  if ( Exf_max > E_c_min ) {
+
+    // Create an ExitChannel object to handle decays to the continuum
+    out.fragment_continuum.emplace_back( pdgi, qi, Exi_, twoJi_, Pi_, rho_i,
+      sdb, E_c_min, f, defer );
+
+    const auto& ec = out.fragment_continuum.back();
+    out.refs.push_back( ChannelRef{ ChannelKind::FragmentContinuum,
+      out.fragment_continuum.size() - 1u } );
+    out.widths.push_back( defer ? ec.width_upper_bound() : ec.width() );
+  }
+}
+
+void marley::HauserFeshbachDecay::build_gamma_channels(
+  marley::StructureDatabase& sdb, double rho_i, bool defer,
+  ChannelOutput& out ) const
+{
+  int pdgi = compound_nucleus_.pdg_code();
+  int qi = compound_nucleus_.charge();
+
   marley::DecayScheme* ds = sdb.get_decay_scheme( pdgi );
 
   // For gamma-ray emission, let the continuum go down to Ex = 0 MeV unless
@@ -164,12 +283,12 @@ void marley::HauserFeshbachDecay::build_exit_channels(
     for (const auto& level_f : levels) {
       double Exf = level_f->energy();
       if (Exf < Exi_) {
-        auto ec = std::make_unique<marley::GammaDiscreteExitChannel>( pdgi, qi,
-          Exi_, twoJi_, Pi_, rho_i, sdb, *level_f );
+        out.gamma_discrete.emplace_back( pdgi, qi, Exi_, twoJi_, Pi_, rho_i,
+          sdb, *level_f );
 
-        total_width_ += ec->width();
-
-        exit_channels_.push_back( std::move(ec) );
+        out.refs.push_back( ChannelRef{ ChannelKind::GammaDiscrete,
+          out.gamma_discrete.size() - 1u } );
+        out.widths.push_back( out.gamma_discrete.back().width() );
       }
       else break;
     }
@@ -181,26 +300,290 @@ void marley::HauserFeshbachDecay::build_exit_channels(
 
     // Create an exit channel object to handle gamma-ray emission into the
     // continuum
-    auto ec = std::make_unique<marley::GammaContinuumExitChannel>( pdgi, qi,
-      Exi_, twoJi_, Pi_, rho_i, sdb, E_c_min );
+    out.gamma_continuum.emplace_back( pdgi, qi, Exi_, twoJi_, Pi_, rho_i, sdb,
+      E_c_min, defer );
+
+    const auto& ec = out.gamma_continuum.back();
+    out.refs.push_back( ChannelRef{ ChannelKind::GammaContinuum,
+      out.gamma_continuum.size() - 1u } );
+    out.widths.push_back( defer ? ec.width_upper_bound() : ec.width() );
+  }
+}
+
+void marley::HauserFeshbachDecay::build_channels_in_parallel(
+  marley::StructureDatabase& sdb, double rho_i, bool defer )
+{
+  int pdgi = compound_nucleus_.pdg_code();
+
+  // Each task uses the models of the calling worker. Any that are missing
+  // are created here first, since the tables that hold them may not be
+  // modified while the tasks are running. The decay schemes and coupling
+  // tables are shared safely in concurrent mode.
+  for ( const auto& open : open_fragments_ ) {
+    int Zf = marley_utils::get_particle_Z( pdgi ) - open.fragment->get_Z();
+    int Af = marley_utils::get_particle_A( pdgi ) - open.fragment->get_A();
+    int pdg_final = marley_utils::get_nucleus_pid( Zf, Af );
+    sdb.get_optical_model( pdg_final );
+    sdb.get_level_density_model( pdg_final );
+    sdb.get_decay_scheme( pdg_final );
+  }
+  sdb.get_gamma_strength_function_model( pdgi );
+  sdb.get_decay_scheme( pdgi );
+
+  // One task per open fragment, plus one for gamma-ray emission. Every
+  // fragment leads to a different final nucleus, so no two tasks share a
+  // model. Each thread uses its own scratch arena.
+  const void* worker = marley::StructureDatabase::current_worker();
+  size_t num_fragments = open_fragments_.size();
+  std::vector<ChannelLists> lists( num_fragments + 1u );
+  std::vector< std::function<void()> > tasks;
+  tasks.reserve( lists.size() );
+  for ( size_t t = 0u; t < lists.size(); ++t ) {
+    tasks.emplace_back( [this, &sdb, &lists, worker, t, num_fragments,
+      rho_i, defer]() -> void
+    {
+      thread_local marley::MonotonicArena task_arena;
+      marley::StructureDatabase::TaskScope scope( worker, &task_arena );
+      ChannelOutput out = lists[ t ].output();
+      if ( t < num_fragments ) {
+        build_fragment_channels( sdb, open_fragments_[t], rho_i, defer, out );
+      }
+      else build_gamma_channels( sdb, rho_i, defer, out );
+    } );
+  }
+
+  marley::TaskPool::Instance().run( tasks );
+
+  // Move the channels into the typed storage in the serial order
+  for ( auto& list : lists ) {
+    for ( size_t c = 0u; c < list.refs.size(); ++c ) {
+      const auto& ref = list.refs[ c ];
+      size_t index = 0u;
+      switch ( ref.kind ) {
+        case ChannelKind::FragmentDiscrete:
+          fragment_discrete_.push_back( std::move(
+            list.fragment_discrete[ref.index]) );
+          index = fragment_discrete_.size() - 1u;
+          break;
+        case ChannelKind::FragmentContinuum:
+          fragment_continuum_.push_back( std::move(
+            list.fragment_continuum[ref.index]) );
+          index = fragment_continuum_.size() - 1u;
+          break;
+        case ChannelKind::GammaDiscrete:
+          gamma_discrete_.push_back( std::move(
+            list.gamma_discrete[ref.index]) );
+          index = gamma_discrete_.size() - 1u;
+          break;
+        case ChannelKind::GammaContinuum:
+          gamma_continuum_.push_back( std::move(
+            list.gamma_continuum[ref.index]) );
+          index = gamma_continuum_.size() - 1u;
+          break;
+        case ChannelKind::DiscretePool:
+          break;
+      }
+      channel_refs_.push_back( ChannelRef{ ref.kind, index } );
+      widths_.push_back( list.widths[c] );
+    }
+  }
+}
+
+void marley::HauserFeshbachDecay::pool_discrete_channels( double tolerance )
+{
+  // Find the discrete channels in order of increasing width
+  std::vector<size_t> order;
+  for ( size_t c = 0u; c < channel_refs_.size(); ++c ) {
+    auto kind = channel_refs_[ c ].kind;
+    if ( kind == ChannelKind::FragmentDiscrete
+      || kind == ChannelKind::GammaDiscrete ) order.push_back( c );
+  }
+  std::stable_sort( order.begin(), order.end(),
+    [this]( size_t a, size_t b ) -> bool { return widths_[a] < widths_[b]; } );
+
+  // Pool the narrowest channels as long as their combined width stays below
+  // the requested fraction of the total
+  double max_pooled = tolerance * total_width_;
+  double pooled_width = 0.;
+  std::vector<bool> pooled( channel_refs_.size(), false );
+  size_t num_pooled = 0u;
+  for ( size_t c : order ) {
+    if ( pooled_width + widths_[ c ] > max_pooled ) break;
+    pooled_width += widths_[ c ];
+    pooled[ c ] = true;
+    ++num_pooled;
+  }
+
+  // Pooling a single channel would not save anything
+  if ( num_pooled < 2u ) return;
+
+  // Rebuild the typed storage and the sampling tables without the pooled
+  // channels. The channels hold references, so they are moved into new
+  // vectors rather than erased in place. The kept channels stay in their
+  // original order, and the pools go at the end.
+  std::vector<marley::FragmentDiscreteExitChannel> kept_fragment;
+  std::vector<marley::GammaDiscreteExitChannel> kept_gamma;
+  std::vector<ChannelRef> old_refs;
+  std::vector<double> old_widths;
+  old_refs.swap( channel_refs_ );
+  old_widths.swap( widths_ );
+  total_width_ = 0.;
+
+  for ( size_t c = 0u; c < old_refs.size(); ++c ) {
+    const auto& ref = old_refs[ c ];
+    double width = old_widths[ c ];
+
+    if ( pooled[c] ) {
+      const marley::DiscreteExitChannel* dec = nullptr;
+      int pdg = marley_utils::PHOTON;
+      if ( ref.kind == ChannelKind::FragmentDiscrete ) {
+        dec = &fragment_discrete_[ ref.index ];
+        pdg = fragment_discrete_[ ref.index ].emitted_particle_pdg();
+      }
+      else dec = &gamma_discrete_[ ref.index ];
+
+      auto iter = std::find_if( discrete_pools_.begin(),
+        discrete_pools_.end(), [pdg]( const DiscretePool& pool ) -> bool
+        { return pool.pdg == pdg; } );
+      if ( iter == discrete_pools_.end() ) {
+        discrete_pools_.push_back( DiscretePool{ pdg, {}, {} } );
+        iter = discrete_pools_.end() - 1;
+      }
+      double sum = iter->cumulative_widths.empty() ? 0.
+        : iter->cumulative_widths.back();
+      iter->levels.push_back( &dec->get_final_level() );
+      iter->cumulative_widths.push_back( sum + width );
+      continue;
+    }
 
-    total_width_ += ec->width();
+    switch ( ref.kind ) {
+      case ChannelKind::FragmentDiscrete:
+        kept_fragment.push_back( std::move(fragment_discrete_[ ref.index ]) );
+        add_channel( ref.kind, kept_fragment.size() - 1u, width );
+        break;
+      case ChannelKind::GammaDiscrete:
+        kept_gamma.push_back( std::move(gamma_discrete_[ ref.index ]) );
+        add_channel( ref.kind, kept_gamma.size() - 1u, width );
+        break;
+      default:
+        add_channel( ref.kind, ref.index, width );
+    }
+  }
 
-    exit_channels_.push_back( std::move(ec) );
+  fragment_discrete_.swap( kept_fragment );
+  gamma_discrete_.swap( kept_gamma );
+
+  for ( size_t p = 0u; p < discrete_pools_.size(); ++p ) {
+    add_channel( ChannelKind::DiscretePool, p,
+      discrete_pools_[ p ].cumulative_widths.back() );
   }
 }
 
+marley::ExitChannel* marley::HauserFeshbachDecay::resolve_pooled_channel(
+  const DiscretePool& pool, marley::Generator& gen )
+{
+  // Choose a member with probability proportional to its width
+  double total = pool.cumulative_widths.back();
+  double r = gen.uniform_random_double( 0., total, false );
+  size_t m = std::upper_bound( pool.cumulative_widths.cbegin(),
+    pool.cumulative_widths.cend(), r ) - pool.cumulative_widths.cbegin();
+  m = std::min( m, pool.levels.size() - 1u );
+  const marley::Level& level = *pool.levels[ m ];
+
+  int pdgi = compound_nucleus_.pdg_code();
+  int qi = compound_nucleus_.charge();
+
+  if ( pool.pdg == marley_utils::PHOTON ) {
+    pooled_gamma_.clear();
+    pooled_gamma_.emplace_back( pdgi, qi, Exi_, twoJi_, Pi_, rho_i_, *sdb_,
+      level );
+    return &pooled_gamma_.back();
+  }
+
+  const marley::Fragment* f = marley::StructureDatabase::get_fragment(
+    marley_utils::get_particle_Z(pool.pdg),
+    marley_utils::get_particle_A(pool.pdg) );
+  if ( !f ) throw marley::Error( "Unrecognized fragment PDG code "
+    + std::to_string(pool.pdg) + " encountered in marley::"
+    "HauserFeshbachDecay::resolve_pooled_channel()" );
+
+  pooled_fragment_.clear();
+  pooled_fragment_.emplace_back( pdgi, qi, Exi_, twoJi_, Pi_, rho_i_, *sdb_,
+    level, *f );
+  return &pooled_fragment_.back();
+}
+
+int marley::HauserFeshbachDecay::emitted_particle_pdg( size_t index ) const {
+  const auto& ref = channel_refs_[ index ];
+  if ( ref.kind == ChannelKind::DiscretePool ) {
+    return discrete_pools_[ ref.index ].pdg;
+  }
+  return exit_channels_[ index ]->emitted_particle_pdg();
+}
+
 bool marley::HauserFeshbachDecay::do_decay(double& Exf, int& twoJf,
   marley::Parity& Pf, marley::Particle& emitted_particle,
-  marley::Particle& residual_nucleus, marley::Generator& gen)
+  marley::Particle& residual_nucleus, marley::Generator& gen, double* weight)
 {
-  const auto& ec = this->sample_exit_channel( gen );
+  return this->do_decay( compound_nucleus_, Exf, twoJf, Pf, emitted_particle,
+    residual_nucleus, gen, weight );
+}
 
-  ec->do_decay( Exf, twoJf, Pf, compound_nucleus_, emitted_particle,
-    residual_nucleus, gen );
+bool marley::HauserFeshbachDecay::do_decay(
+  const marley::Particle& compound_nucleus, double& Exf, int& twoJf,
+  marley::Parity& Pf, marley::Particle& emitted_particle,
+  marley::Particle& residual_nucleus, marley::Generator& gen, double* weight)
+{
+  size_t index = this->sample_exit_channel_index( gen, weight );
+  const auto& ref = channel_refs_[ index ];
+
+  // Call the concrete (final) implementations directly to avoid virtual
+  // dispatch
+  switch ( ref.kind ) {
+    case ChannelKind::FragmentDiscrete:
+      fragment_discrete_[ ref.index ].do_decay( Exf, twoJf, Pf,
+        compound_nucleus, emitted_particle, residual_nucleus, gen );
+      return false;
+    case ChannelKind::GammaDiscrete:
+      gamma_discrete_[ ref.index ].do_decay( Exf, twoJf, Pf,
+        compound_nucleus, emitted_particle, residual_nucleus, gen );
+      return false;
+    case ChannelKind::FragmentContinuum:
+      fragment_continuum_[ ref.index ].do_decay( Exf, twoJf, Pf,
+        compound_nucleus, emitted_particle, residual_nucleus, gen );
+      return true;
+    case ChannelKind::GammaContinuum:
+      gamma_continuum_[ ref.index ].do_decay( Exf, twoJf, Pf,
+        compound_nucleus, emitted_particle, residual_nucleus, gen );
+      return true;
+    case ChannelKind::DiscretePool:
+      this->resolve_pooled_channel( discrete_pools_[ ref.index ], gen )
+        ->do_decay( Exf, twoJf, Pf, compound_nucleus, emitted_particle,
+        residual_nucleus, gen );
+      return false;
+  }
+  throw marley::Error( "Unrecognized exit channel type encountered in"
+    " marley::HauserFeshbachDecay::do_decay()" );
+}
+
+size_t marley::HauserFeshbachDecay::memory_usage() const {
+  using marley_utils::vector_bytes;
+  size_t bytes = vector_bytes( fragment_discrete_ )
+    + vector_bytes( fragment_continuum_ ) + vector_bytes( gamma_discrete_ )
+    + vector_bytes( gamma_continuum_ ) + vector_bytes( channel_refs_ )
+    + vector_bytes( widths_ ) + vector_bytes( exit_channels_ )
+    + vector_bytes( channel_weights_ ) + exit_channel_table_.memory_usage()
+    + vector_bytes( discrete_pools_ ) + vector_bytes( pooled_fragment_ )
+    + vector_bytes( pooled_gamma_ );
+
+  for ( const auto& pool : discrete_pools_ ) {
+    bytes += vector_bytes( pool.levels )
+      + vector_bytes( pool.cumulative_widths );
+  }
 
-  bool discrete_level = !ec->is_continuum();
-  return !discrete_level;
+  for ( const auto& ec : fragment_continuum_ ) bytes += ec.memory_usage();
+  for ( const auto& ec : gamma_continuum_ ) bytes += ec.memory_usage();
+  return bytes;
 }
 
 void marley::HauserFeshbachDecay::print(std::ostream& out) const {
@@ -212,48 +595,173 @@ void marley::HauserFeshbachDecay::print(std::ostream& out) const {
     << " with Ex = " << Exi_ << ", spin = " << twoJi_ / 2;
   if (twoJi_ % 2) out << ".5";
   out << ", and parity = " << Pi_ << '\n';
-  out << "Total width = " << total_width_ << " MeV\n";
-  out << "Mean lifetime = " << hbar / total_width_ << " s\n";
-  for (const auto& ec : exit_channels_) {
-    double width = ec->width();
-    bool continuum = ec->is_continuum();
-    bool frag = ec->emits_fragment();
-    int pdg = ec->emitted_particle_pdg();
+
+  // Upper bounds are shown for any continuum widths that have been deferred
+  bool bounded = ( num_deferred_widths_ > 0u );
+  out << "Total width " << ( bounded ? "<=" : "=" ) << ' ' << total_width_
+    << " MeV\n";
+  out << "Mean lifetime " << ( bounded ? ">=" : "=" ) << ' '
+    << hbar / total_width_ << " s\n";
+  for (size_t c = 0u; c < channel_refs_.size(); ++c) {
+    const auto& ref = channel_refs_[ c ];
+    const auto* ec = exit_channels_[ c ];
+    double width = widths_[ c ];
+    int pdg = this->emitted_particle_pdg( c );
     std::string symbol = marley_utils::particle_symbols.at( pdg );
     out << "  ";
-    if ( frag ) out << symbol;
+    if ( pdg != marley_utils::PHOTON ) out << symbol;
     else out << "gamma-ray";
-    if ( continuum ) out << " emission to the continuum width = ";
+    if ( ref.kind == ChannelKind::DiscretePool ) {
+      out << " emission to " << discrete_pools_[ ref.index ].levels.size()
+        << " pooled levels width = " << width << " MeV\n";
+      continue;
+    }
+    if ( ec->is_continuum() ) {
+      bool deferred = ( ref.kind == ChannelKind::FragmentContinuum )
+        ? fragment_continuum_[ ref.index ].width_is_deferred()
+        : gamma_continuum_[ ref.index ].width_is_deferred();
+      out << " emission to the continuum width "
+        << ( deferred ? "<=" : "=" ) << ' ';
+    }
     else {
-      auto* dec = dynamic_cast< marley::DiscreteExitChannel* >( ec.get() );
-      if ( !dec ) throw marley::Error( "Dynamic cast failed in marley::"
-        "HauserFeshbachDecay::print()" );
-      out << " emission to level at " << dec->get_final_level().energy()
+      const marley::Level& lev = ( ref.kind == ChannelKind::FragmentDiscrete )
+        ? fragment_discrete_[ ref.index ].get_final_level()
+        : gamma_discrete_[ ref.index ].get_final_level();
+      out << " emission to level at " << lev.energy()
         << " MeV width = ";
     }
     out << width << " MeV\n";
   }
 }
 
-const std::unique_ptr<marley::ExitChannel>&
-  marley::HauserFeshbachDecay::sample_exit_channel(
-  marley::Generator& gen) const
+const marley::ExitChannel* marley::HauserFeshbachDecay::sample_exit_channel(
+  marley::Generator& gen, double* weight)
+{
+  size_t index = this->sample_exit_channel_index( gen, weight );
+  const auto& ref = channel_refs_[ index ];
+  if ( ref.kind == ChannelKind::DiscretePool ) {
+    return this->resolve_pooled_channel( discrete_pools_[ ref.index ], gen );
+  }
+  return exit_channels_[ index ];
+}
+
+marley::ContinuumExitChannel*
+  marley::HauserFeshbachDecay::get_deferred_channel( size_t index )
+{
+  if ( num_deferred_widths_ == 0u ) return nullptr;
+
+  const auto& ref = channel_refs_[ index ];
+  marley::ContinuumExitChannel* ec = nullptr;
+  if ( ref.kind == ChannelKind::FragmentContinuum ) {
+    ec = &fragment_continuum_[ ref.index ];
+  }
+  else if ( ref.kind == ChannelKind::GammaContinuum ) {
+    ec = &gamma_continuum_[ ref.index ];
+  }
+
+  if ( ec && ec->width_is_deferred() ) return ec;
+  return nullptr;
+}
+
+void marley::HauserFeshbachDecay::resolve_width( size_t index,
+  marley::ContinuumExitChannel& ec )
 {
-  // Throw an error if all decays are impossible
-  if ( total_width_ <= 0. ) throw marley::Error("Cannot sample an exit channel"
-    " for a Hauser-Feshbach decay. All partial decay widths are zero.");
-
-  // Sample an exit channel using a std::discrete distribution and a table of
-  // partial decay widths
-  const auto widths_begin
-    = marley::ExitChannel::make_width_iterator( exit_channels_.cbegin() );
-  const auto widths_end
-    = marley::ExitChannel::make_width_iterator( exit_channels_.cend() );
-
-  std::discrete_distribution<size_t> exit_channel_dist(widths_begin,
-    widths_end);
-  size_t exit_channel_index = gen.sample_from_distribution( exit_channel_dist );
-
-  const auto& ec = exit_channels_.at( exit_channel_index );
-  return ec;
+  ec.resolve_width();
+  widths_[ index ] = ec.width();
+  --num_deferred_widths_;
+
+  // Recompute the total rather than adjusting it to avoid accumulating
+  // round-off error
+  total_width_ = 0.;
+  for ( double w : widths_ ) total_width_ += w;
+
+  // The alias table will be rebuilt from the updated widths on the next
+  // sampling attempt
+  exit_channel_table_.clear();
+  channel_weights_.clear();
+}
+
+void marley::HauserFeshbachDecay::resolve_widths() {
+  for ( size_t c = 0u; c < channel_refs_.size(); ++c ) {
+    auto* ec = this->get_deferred_channel( c );
+    if ( ec ) this->resolve_width( c, *ec );
+  }
+}
+
+size_t marley::HauserFeshbachDecay::sample_exit_channel_index(
+  marley::Generator& gen, double* weight)
+{
+  // Event weights for biased sampling need the exact total width, so
+  // compute any deferred widths right away in that case
+  if ( num_deferred_widths_ > 0u && gen.has_exit_channel_biases() ) {
+    this->resolve_widths();
+  }
+
+  for (;;) {
+
+    // Throw an error if all decays are impossible
+    if ( total_width_ <= 0. ) throw marley::Error("Cannot sample an exit"
+      " channel for a Hauser-Feshbach decay. All partial decay widths are"
+      " zero.");
+
+    size_t index = this->sample_index_from_table( gen );
+
+    auto* ec = this->get_deferred_channel( index );
+    if ( !ec ) {
+      if ( weight && !channel_weights_.empty() ) {
+        *weight *= channel_weights_[ index ];
+      }
+      return index;
+    }
+
+    // The proposed channel used an upper bound on its width. Compute the
+    // true width and accept the proposal with probability width / bound.
+    double bound = widths_[ index ];
+    this->resolve_width( index, *ec );
+    double width = widths_[ index ];
+
+    if ( width > bound ) {
+      // The assumptions behind the bound were violated, so the proposals
+      // made so far may not have the right distribution. Fall back to
+      // computing all of the widths before sampling again.
+      static marley::Logger::RateLimit limit;
+      MARLEY_LOG_WARNING_LIMITED( limit ) << "The total width " << width
+        << " MeV of a continuum exit channel exceeded its estimated upper"
+        << " bound of " << bound << " MeV. All remaining widths will be"
+        << " computed before sampling.";
+      this->resolve_widths();
+      continue;
+    }
+
+    if ( gen.uniform_random_double(0., bound, false) < width ) return index;
+  }
+}
+
+size_t marley::HauserFeshbachDecay::sample_index_from_table(
+  marley::Generator& gen)
+{
+  // Sample an exit channel using an alias table built from the partial decay
+  // widths. The table is built the first time that it is needed.
+  if ( exit_channel_table_.empty() ) {
+    if ( gen.has_exit_channel_biases() ) {
+      // Sample using the biased widths, then replace each of them with the
+      // ratio of the unbiased and biased probabilities for its channel
+      channel_weights_.resize( widths_.size() );
+      double biased_width = 0.;
+      for ( size_t c = 0u; c < widths_.size(); ++c ) {
+        channel_weights_[ c ] = widths_[ c ] * gen.exit_channel_bias(
+          this->emitted_particle_pdg(c) );
+        biased_width += channel_weights_[ c ];
+      }
+      exit_channel_table_.build( channel_weights_.cbegin(),
+        channel_weights_.cend() );
+      for ( size_t c = 0u; c < widths_.size(); ++c ) {
+        channel_weights_[ c ] = biased_width / ( total_width_
+          * gen.exit_channel_bias(this->emitted_particle_pdg(c)) );
+      }
+    }
+    else exit_channel_table_.build( widths_.cbegin(), widths_.cend() );
+  }
+
+  return gen.sample_from_distribution( exit_channel_table_ );
 }
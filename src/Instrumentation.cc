@@ -0,0 +1,194 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Instrumentation.hh"
+
+using Probe = marley::Instrumentation::Probe;
+using StatsTable = marley::Instrumentation::StatsTable;
+
+std::atomic<bool> marley::Instrumentation::enabled_( false );
+
+namespace {
+
+  // Statistics from threads that have exited, grouped by label
+  struct SharedTables {
+    std::mutex mutex;
+    std::map<std::string, StatsTable> tables;
+  };
+
+  SharedTables& shared_tables() {
+    static SharedTables the_tables;
+    return the_tables;
+  }
+
+  // Statistics collected by the current thread. They are merged into the
+  // shared tables when the thread exits or changes its label.
+  struct ThreadTable {
+    std::string label = "main";
+    StatsTable table;
+    bool used = false;
+
+    void merge_into_shared() {
+      if ( !used ) return;
+      auto& shared = shared_tables();
+      std::lock_guard<std::mutex> lock( shared.mutex );
+      StatsTable& dest = shared.tables[ label ];
+      for ( size_t p = 0u; p < table.size(); ++p ) {
+        dest[ p ].merge( table[ p ] );
+      }
+      table = StatsTable();
+      used = false;
+    }
+
+    ~ThreadTable() { merge_into_shared(); }
+  };
+
+  thread_local ThreadTable this_thread_table;
+
+  // Name of the per-call value recorded for each probe (nullptr if none)
+  const char* value_name(Probe probe) {
+    switch ( probe ) {
+      case Probe::ChebyshevConstruction: return "grid_size";
+      case Probe::RejectionSample: return "trials";
+      case Probe::SMatrixElement: return "partial_waves";
+      default: return nullptr;
+    }
+  }
+
+  marley::JSON table_to_json(const StatsTable& table) {
+    marley::JSON result = marley::JSON::object();
+    for ( size_t p = 0u; p < table.size(); ++p ) {
+      const auto& stats = table[ p ];
+      if ( stats.calls == 0u && stats.value_count == 0u ) continue;
+
+      Probe probe = static_cast<Probe>( p );
+      marley::JSON entry = marley::JSON::object();
+      entry[ "calls" ] = static_cast<long>( stats.calls );
+      entry[ "total_s" ] = stats.seconds;
+      if ( stats.calls > 0u ) {
+        entry[ "mean_us" ] = 1e6 * stats.seconds / stats.calls;
+      }
+      const char* name = value_name( probe );
+      if ( name && stats.value_count > 0u ) {
+        entry[ std::string(name) + "_mean" ] = stats.value_sum
+          / stats.value_count;
+        entry[ std::string(name) + "_max" ] = stats.value_max;
+        entry[ std::string(name) + "_total" ] = stats.value_sum;
+      }
+      result[ marley::Instrumentation::probe_name(probe) ] = entry;
+    }
+    return result;
+  }
+
+}
+
+void marley::Instrumentation::Stats::merge(const Stats& other) {
+  calls += other.calls;
+  seconds += other.seconds;
+  if ( other.value_count > 0u ) {
+    value_max = ( value_count > 0u ) ? std::max( value_max, other.value_max )
+      : other.value_max;
+    value_count += other.value_count;
+    value_sum += other.value_sum;
+  }
+}
+
+void marley::Instrumentation::enable(bool enabled) {
+  enabled_.store( enabled, std::memory_order_relaxed );
+}
+
+void marley::Instrumentation::add_time(Probe probe,
+  std::chrono::steady_clock::duration elapsed)
+{
+  auto& local = this_thread_table;
+  auto& stats = local.table[ static_cast<size_t>(probe) ];
+  ++stats.calls;
+  stats.seconds += std::chrono::duration<double>( elapsed ).count();
+  local.used = true;
+}
+
+void marley::Instrumentation::record_value(Probe probe, double value) {
+  auto& local = this_thread_table;
+  auto& stats = local.table[ static_cast<size_t>(probe) ];
+  stats.value_max = ( stats.value_count > 0u )
+    ? std::max( stats.value_max, value ) : value;
+  ++stats.value_count;
+  stats.value_sum += value;
+  local.used = true;
+}
+
+void marley::Instrumentation::set_thread_label(const std::string& label) {
+  auto& local = this_thread_table;
+  if ( label == local.label ) return;
+  local.merge_into_shared();
+  local.label = label;
+}
+
+marley::JSON marley::Instrumentation::report() {
+
+  // Include the statistics collected so far by the calling thread
+  this_thread_table.merge_into_shared();
+
+  std::map<std::string, StatsTable> tables;
+  {
+    auto& shared = shared_tables();
+    std::lock_guard<std::mutex> lock( shared.mutex );
+    tables = shared.tables;
+  }
+
+  marley::JSON threads = marley::JSON::object();
+  StatsTable total;
+  for ( const auto& pair : tables ) {
+    threads[ pair.first ] = table_to_json( pair.second );
+    for ( size_t p = 0u; p < total.size(); ++p ) {
+      total[ p ].merge( pair.second[ p ] );
+    }
+  }
+
+  marley::JSON result = marley::JSON::object();
+  result[ "total" ] = table_to_json( total );
+  result[ "threads" ] = threads;
+  return result;
+}
+
+void marley::Instrumentation::write_report(const std::string& file_name) {
+  std::ofstream out( file_name );
+  if ( !out ) throw marley::Error( "Could not open the instrumentation"
+    " report file \"" + file_name + "\" for writing" );
+  out << report().dump_string( 2 ) << '\n';
+}
+
+const char* marley::Instrumentation::probe_name(Probe probe) {
+  switch ( probe ) {
+    case Probe::SampleReaction: return "sample_reaction";
+    case Probe::CreateEvent: return "create_event";
+    case Probe::ProcessEvent: return "process_event";
+    case Probe::HauserFeshbachDecay: return "hauser_feshbach_decay";
+    case Probe::SMatrixElement: return "s_matrix_element";
+    case Probe::ChebyshevConstruction: return "chebyshev_construction";
+    case Probe::RejectionSample: return "rejection_sample";
+    case Probe::WriteEvent: return "write_event";
+    default: return "unknown";
+  }
+}
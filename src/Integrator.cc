@@ -17,6 +17,7 @@
 #include <cmath>
 
 #include "marley/marley_utils.hh"
+#include "marley/Error.hh"
 #include "marley/Integrator.hh"
 
 marley::Integrator::Integrator(size_t num) : N_(num), weights_(num + 1, 0.),
@@ -47,18 +48,65 @@ marley::Integrator::Integrator(size_t num) : N_(num), weights_(num + 1, 0.),
 double marley::Integrator::num_integrate(const std::function<double(double)>& f,
   double a, double b) const
 {
-  double A = (b - a) / 2.;
-  double B = (b + a) / 2.;
-  double C = (f(a) + f(b)) / 2.;
-
-  double integral = weights_[0] * C; // n = 0 term
-  integral += weights_[N_] * f(B); // n = N_ term
+  return num_integrate< std::function<double(double)> >( f, a, b );
+}
 
-  // n = 1 to n = N_ - 1 terms
-  for (size_t n = 1; n < N_; ++n) {
-    double epoint = A * offsets_[n - 1];
-    integral += weights_[n] * (f(B + epoint) + f(B - epoint));
+marley::AdaptiveIntegrator::AdaptiveIntegrator(double rel_tol,
+  double abs_tol) : rel_tol_( rel_tol ), abs_tol_( abs_tol )
+{
+  if ( !(rel_tol_ >= 0.) || !(abs_tol_ >= 0.) || ( rel_tol_ == 0.
+    && abs_tol_ == 0. ) )
+  {
+    throw marley::Error( "Invalid tolerance passed to the constructor of"
+      " marley::AdaptiveIntegrator. The tolerances must be nonnegative,"
+      " and at least one must be positive." );
   }
+}
+
+const std::vector<double>& marley::AdaptiveIntegrator::nodes() {
+  static const std::vector<double> xs = []() {
+    std::vector<double> temp( MAX_POINTS + 1 );
+    for ( size_t j = 0; j <= MAX_POINTS; ++j ) {
+      temp[ j ] = std::cos( j * marley_utils::pi / MAX_POINTS );
+    }
+    return temp;
+  }();
+  return xs;
+}
+
+const std::vector<double>& marley::AdaptiveIntegrator::weights(
+  size_t num_intervals)
+{
+  // Weights for each of the nested rules, indexed by the base-2 logarithm
+  // of num_intervals / MIN_POINTS
+  static const std::vector< std::vector<double> > all_weights = []() {
+    std::vector< std::vector<double> > temp;
+    for ( size_t n = MIN_POINTS; n <= MAX_POINTS; n *= 2 ) {
+      // See J. Waldvogel, BIT Numer. Math. 46, 195 (2006)
+      std::vector<double> ws( n + 1 );
+      for ( size_t j = 0; j <= n; ++j ) {
+        double sum = 0.;
+        for ( size_t k = 1; k <= n / 2; ++k ) {
+          double b = ( 2 * k == n ) ? 1. : 2.;
+          sum += b * std::cos( 2. * k * j * marley_utils::pi / n )
+            / ( 4. * k * k - 1. );
+        }
+        double c = ( j == 0 || j == n ) ? 1. : 2.;
+        ws[ j ] = c * ( 1. - sum ) / n;
+      }
+      temp.push_back( std::move(ws) );
+    }
+    return temp;
+  }();
+
+  size_t level = 0;
+  for ( size_t n = MIN_POINTS; n < num_intervals; n *= 2 ) ++level;
+  return all_weights.at( level );
+}
 
-  return A * integral;
+const marley::Integrator& marley_utils::default_integrator() {
+  /// @todo remove the hard-coded number of Chebyshev points here in
+  /// favor of adaptive integration.
+  static const marley::Integrator integrator(50);
+  return integrator;
 }
@@ -0,0 +1,115 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "marley/Error.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONParser.hh"
+#include "marley/MappedFile.hh"
+
+namespace {
+
+  // Builds a marley::JSON tree from the values reported by a JSONParser
+  class JSONBuilder : public marley::JSONHandler {
+
+    public:
+
+      // Returns the completed tree. Only the outermost value must be an
+      // object.
+      marley::JSON take_root() {
+        if ( !root_.is_object() ) throw marley::Error("Missing '{' at"
+          " beginning of JSON object");
+        return std::move( root_ );
+      }
+
+      virtual void null_value() override { next_value(); }
+      virtual void boolean_value(bool b) override { next_value() = b; }
+      virtual void integer_value(long i) override { next_value() = i; }
+      virtual void floating_value(double d) override { next_value() = d; }
+
+      virtual void string_value(const marley::JSONStringView& str) override
+        { next_value() = marley::JSON( str.str() ); }
+
+      virtual void start_object() override {
+        marley::JSON& object = next_value();
+        object = marley::JSON::object();
+        stack_.push_back( &object );
+      }
+
+      virtual void key(const marley::JSONStringView& k) override
+        { key_.assign( k.data(), k.size() ); }
+
+      virtual void end_object() override { stack_.pop_back(); }
+
+      virtual void start_array() override {
+        marley::JSON& array = next_value();
+        array = marley::JSON::array();
+        stack_.push_back( &array );
+      }
+
+      virtual void end_array() override { stack_.pop_back(); }
+
+    private:
+
+      // Returns a reference to the location where the next parsed value
+      // should be stored. Elements of a std::deque and of a std::map are
+      // never moved by insertions, so the pointers held in stack_ remain
+      // valid while the tree is built.
+      marley::JSON& next_value() {
+        if ( stack_.empty() ) return root_;
+        marley::JSON& parent = *stack_.back();
+        if ( parent.is_array() ) {
+          return parent[ static_cast<unsigned>(parent.length()) ];
+        }
+        return parent[ key_ ];
+      }
+
+      marley::JSON root_;
+      std::vector<marley::JSON*> stack_;
+      std::string key_;
+  };
+
+}
+
+marley::JSON marley::JSON::load(const char* data, size_t size) {
+  JSONBuilder builder;
+  marley::JSONParser::parse( data, size, builder );
+  return builder.take_root();
+}
+
+marley::JSON marley::JSON::load(const std::string& str) {
+  return load( str.data(), str.size() );
+}
+
+marley::JSON marley::JSON::load(std::istream& in) {
+  JSONBuilder builder;
+  marley::JSONParser::parse( in, builder );
+  return builder.take_root();
+}
+
+marley::JSON marley::JSON::load_file(const std::string& filename) {
+  // Parse directly from a memory mapping of the file rather than copying
+  // its contents into a string first
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( filename ); }
+  catch ( const marley::Error& ) {
+    throw marley::Error("Could not open the file \"" + filename + "\"");
+  }
+  return load( file->data(), file->size() );
+}
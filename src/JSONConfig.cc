@@ -15,29 +15,108 @@
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
 // standard library includes
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
 #include <vector>
 
 // MARLEY includes
 #include "marley/marley_utils.hh"
+#include "marley/ArrayFile.hh"
+#include "marley/CoherentReaction.hh"
+#include "marley/CrossSectionTable.hh"
+#include "marley/ElectronReaction.hh"
 #include "marley/Error.hh"
 #include "marley/FileManager.hh"
 #include "marley/JSONConfig.hh"
 #include "marley/NeutrinoSource.hh"
 #include "marley/NuclearReaction.hh"
 #include "marley/Logger.hh"
+#include "marley/ReactionBundle.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/TaskPool.hh"
 
 using InterpMethod = marley::InterpolationGrid<double>::InterpolationMethod;
 using ProcType = marley::Reaction::ProcessType;
 using CMode = marley::NuclearReaction::CoulombMode;
+using ERMode = marley::ElectronReaction::CosThetaSampling;
+using FFMode = marley::CoherentReaction::FormFactor;
 
 // anonymous namespace for helper functions, etc.
 namespace {
 
+  // Parses a JSON object specifying the nuclidic composition of a neutrino
+  // target. The atoms and their atom fractions are appended to the vectors
+  // passed as arguments.
+  void parse_target_spec( const marley::JSON& tgt_spec,
+    std::vector<marley::TargetAtom>& atoms,
+    std::vector<double>& atom_fractions )
+  {
+    if ( !tgt_spec.is_object() ) throw marley::Error( "Invalid neutrino target"
+      " specification " + tgt_spec.dump_string() );
+
+    if ( !tgt_spec.has_key("nuclides") ) throw marley::Error( "Missing \""
+      "nuclides\" key in the neutrino target specification "
+      + tgt_spec.dump_string() );
+
+    const auto& n_spec = tgt_spec.at( "nuclides" );
+
+    if ( !n_spec.is_array() ) throw marley::Error( "Invalid \"nuclides\""
+      " array given in the neutrino target specification "
+      + tgt_spec.dump_string() );
+
+    if ( !tgt_spec.has_key("atom_fractions") ) throw marley::Error( "Missing \""
+      "atom_fractions\" key in the neutrino target specification "
+      + tgt_spec.dump_string() );
+
+    const auto& af_spec = tgt_spec.at( "atom_fractions" );
+
+    if ( !af_spec.is_array() ) throw marley::Error( "Invalid"
+      " \"atom_fractions\" array given in the neutrino target specification "
+      + tgt_spec.dump_string() );
+
+    // Check that the two arrays used to specify the target are of equal length
+    int num_nuclides = n_spec.length();
+    if ( num_nuclides != af_spec.length() ) throw marley::Error(
+      "Arrays of unequal length specified for the \"nuclides\" and \"atom"
+      "_fractions\" keys in the neutrino target specification "
+      + tgt_spec.dump_string() );
+
+    // Check that at least one target atom is listed
+    if ( num_nuclides < 1 ) throw marley::Error( "At least one target nuclide"
+      " must be included in the neutrino target specification" );
+
+    // Loop over each of the target atoms. Parse their information and add them
+    // to the vectors that will be used to initialize the Target object.
+    for ( int n = 0; n < num_nuclides; ++n ) {
+      const auto& nuc = n_spec.at( n );
+      bool ok = false;
+      int nuc_pdg = nuc.to_long( ok );
+      if ( ok ) atoms.emplace_back( nuc_pdg );
+      // TODO: add support for string parsing
+      //else if ( nuc.is_string() ) {
+      //}
+      else throw marley::Error( "Invalid target nuclide specifier "
+        + nuc.dump_string() );
+
+      // Parse and store the atom fraction. We already check for sane values
+      // while initializing the Target object itself, so just make sure that the
+      // conversion to a double worked out all right.
+      const auto& frac_spec = af_spec.at( n );
+      double frac = frac_spec.to_double( ok );
+      if ( ok ) atom_fractions.push_back( frac );
+      else throw marley::Error( "Invalid atom fraction "
+        + frac_spec.dump_string() );
+    }
+  }
+
   void source_check_positive(double x, const char* description,
     const char* source_type)
   {
@@ -65,6 +144,49 @@ namespace {
     return result;
   }
 
+  // Reads a source parameter array from a .npy file or a headerless file of
+  // little-endian doubles. The file is given either by its name or by an
+  // object with the keys "file", "column" (default 0), and "columns" (the
+  // number of columns in a headerless file, default 1).
+  std::vector<double> get_vector_from_file(const marley::JSON& file_spec,
+    const char* name, const char* description)
+  {
+    std::string file_name;
+    long column = 0;
+    long columns = 1;
+    bool ok = true;
+    if ( file_spec.is_string() ) file_name = file_spec.to_string();
+    else {
+      if ( file_spec.has_key("file") ) {
+        file_name = file_spec.at("file").to_string(ok);
+      }
+      else ok = false;
+      if ( ok && file_spec.has_key("column") ) {
+        column = file_spec.at("column").to_long(ok);
+      }
+      if ( ok && file_spec.has_key("columns") ) {
+        columns = file_spec.at("columns").to_long(ok);
+      }
+    }
+    if ( !ok || column < 0 || columns <= 0 ) throw marley::Error(
+      std::string("Invalid file specification ") + file_spec.dump_string()
+      + " given for the " + name + " key for a " + description + " source");
+
+    // Look for the file using the MARLEY search path if it is not found
+    // relative to the working directory
+    const auto& fm = marley::FileManager::Instance();
+    std::string full_file_name = fm.find_file( file_name );
+    if ( full_file_name.empty() ) throw marley::Error( "Could not locate"
+      " the table file " + file_name + " given for the " + name + " key"
+      " for a " + description + " source" );
+
+    marley::ArrayFile table( full_file_name, columns );
+    std::vector<double> result = table.column( column );
+    MARLEY_LOG_DEBUG() << "Read " << result.size() << ' ' << name
+      << " values from " << full_file_name;
+    return result;
+  }
+
   std::vector<double> get_vector(const char* name, const marley::JSON& spec,
     const char* description)
   {
@@ -74,9 +196,15 @@ namespace {
 
     const marley::JSON& vec = spec.at(name);
 
+    // Large tables may be stored in a separate binary file instead
+    if ( vec.is_string() || vec.is_object() ) {
+      return get_vector_from_file(vec, name, description);
+    }
+
     if ( !vec.is_array() ) throw marley::Error( std::string("The")
       + " value given for the " + name + " key for a " + description
-      + " source should be an array." );
+      + " source should be an array, a file name, or a file specification"
+      + " object." );
 
     std::vector<double> result;
 
@@ -138,8 +266,73 @@ int marley::JSONConfig::neutrino_pdg(const std::string& nu) const {
   return pdg;
 }
 
+void marley::JSONConfig::reconfigure( marley::Generator& gen ) const
+{
+  marley::Generator::Reconfiguration changes;
+
+  // The direction does not affect the normalization, so it may be applied
+  // right away
+  prepare_direction( gen );
+
+  changes.source = create_dm_source();
+  if ( json_.has_key("target") ) changes.target = create_target( gen );
+
+  changes.reactions_enabled = parse_enabled_reactions( gen );
+
+  gen.reconfigure( std::move(changes) );
+}
+
+std::map<size_t, bool> marley::JSONConfig::parse_enabled_reactions(
+  const marley::Generator& gen ) const
+{
+  std::map<size_t, bool> enabled;
+
+  // The enabled reactions are listed by their positions in the vector
+  // returned by Generator::get_reactions() or by their descriptions. All
+  // others are disabled.
+  std::string enabled_key( "enabled_reactions" );
+  if ( !json_.has_key(enabled_key) ) return enabled;
+
+  const marley::JSON& enabled_json = json_.at( enabled_key );
+  if ( !enabled_json.is_array() ) handle_json_error( enabled_key.c_str(),
+    enabled_json );
+
+  const auto& reactions = gen.get_reactions();
+  for ( size_t j = 0u; j < reactions.size(); ++j ) enabled[ j ] = false;
+
+  for ( const auto& entry : enabled_json.array_range() ) {
+    bool found = false;
+    if ( entry.is_integer() ) {
+      long index = entry.to_long();
+      found = ( index >= 0 && static_cast<size_t>(index) < reactions.size() );
+      if ( found ) enabled[ index ] = true;
+    }
+    else if ( entry.is_string() ) {
+      std::string desc = entry.to_string();
+      for ( size_t j = 0u; j < reactions.size(); ++j ) {
+        if ( reactions[ j ]->get_description() != desc ) continue;
+        enabled[ j ] = true;
+        found = true;
+      }
+    }
+    if ( !found ) throw marley::Error( "Unrecognized reaction "
+      + entry.dump_string() + " given in the \"" + enabled_key
+      + "\" array" );
+  }
+
+  return enabled;
+}
+
 marley::Generator marley::JSONConfig::create_generator() const
 {
+  return create_generator( nullptr );
+}
+
+marley::Generator marley::JSONConfig::create_generator(
+  std::shared_ptr<marley::StructureDatabase> sdb ) const
+{
+  marley::StartupProfile::Timer timer( "generator setup" );
+
   uint_fast64_t seed;
   if (json_.has_key("seed")) {
     bool ok;
@@ -157,11 +350,44 @@ marley::Generator marley::JSONConfig::create_generator() const
   gen.dont_normalize_E_pdf_ = true;
 
   // Use the JSON settings to update the generator's parameters
+  prepare_random_engine( gen );
   prepare_direction( gen );
-  prepare_structure( gen );
+  if ( sdb ) gen.set_structure_db( sdb );
+  else prepare_structure( gen );
   //prepare_neutrino_source( gen );
   prepare_dm_source( gen );
-  prepare_reactions( gen );
+
+  // If a reaction bundle is in use, register its contents before loading
+  // the reactions so that the reaction data files need not be parsed again
+  marley::ReactionBundle bundle;
+  bool bundle_loaded = false;
+  std::string bundle_file;
+  std::string bundle_key( "reaction_bundle" );
+  if ( json_.has_key(bundle_key) ) {
+    const marley::JSON& bundle_json = json_.at( bundle_key );
+    if ( !bundle_json.is_string() ) handle_json_error( bundle_key.c_str(),
+      bundle_json );
+
+    bundle_file = bundle_json.to_string();
+    const auto& fm = marley::FileManager::Instance();
+    std::string full_file_name = fm.find_file( bundle_file );
+    if ( full_file_name.empty() ) {
+      MARLEY_LOG_INFO() << "The reaction bundle " << bundle_file
+        << " will be created";
+    }
+    else {
+      // Write any updates back to the same file that was loaded
+      bundle_file = full_file_name;
+      bundle_loaded = marley::ReactionBundle::load( bundle_file, bundle );
+      if ( bundle_loaded ) {
+        bundle.register_reaction_data();
+        MARLEY_LOG_INFO() << "Loaded the reaction bundle " << bundle_file;
+      }
+    }
+  }
+
+  std::vector<std::string> reaction_files;
+  prepare_reactions( gen, reaction_files );
   prepare_target( gen );
 
   // If the user has disabled nuclear de-excitations, then set the
@@ -227,6 +453,199 @@ marley::Generator marley::JSONConfig::create_generator() const
     MARLEY_LOG_INFO() << "Configured Coulomb correction method: " << cmode_str;
   }
 
+  // Set the method used to sample ejectile scattering cosines for
+  // neutrino-electron elastic scattering. By default, the cumulative
+  // distribution function is inverted. Rejection sampling may be selected
+  // instead for validation purposes.
+  std::string es_key( "es_cos_theta_sampling" );
+  if ( json_.has_key(es_key) ) {
+    const marley::JSON& es_json = json_.at( es_key );
+    if ( !es_json.is_string() ) handle_json_error( es_key.c_str(), es_json );
+
+    std::string es_str = es_json.to_string();
+    ERMode es_mode;
+    if ( es_str == "inverse_cdf" ) es_mode = ERMode::INVERSE_CDF;
+    else if ( es_str == "rejection" ) es_mode = ERMode::REJECTION;
+    else throw marley::Error( "Invalid value of " + es_key + " = \""
+      + es_str + "\" encountered in"
+      " marley::JSONConfig::create_generator(). Allowed values are"
+      " \"inverse_cdf\" and \"rejection\"." );
+
+    for ( auto& react : gen.reactions_ ) {
+      auto* er = dynamic_cast< marley::ElectronReaction* >( react.get() );
+      if ( er ) er->set_cos_theta_sampling( es_mode );
+    }
+
+    MARLEY_LOG_INFO() << "Electron scattering angles will be sampled using "
+      << ( es_mode == ERMode::REJECTION ? "rejection sampling"
+      : "the inverse CDF" );
+  }
+
+  // If requested, replace each configured NC reaction that describes pure
+  // CEvNS (a single ground-state Fermi transition) with a dedicated
+  // CoherentReaction object. The generic treatment is kept by default.
+  std::string cevns_key( "cevns_engine" );
+  if ( json_.has_key(cevns_key) ) {
+    const marley::JSON& cevns_json = json_.at( cevns_key );
+    if ( !cevns_json.is_string() ) handle_json_error( cevns_key.c_str(),
+      cevns_json );
+
+    std::string cevns_str = cevns_json.to_string();
+    if ( cevns_str != "generic" && cevns_str != "coherent" ) {
+      throw marley::Error( "Invalid value of " + cevns_key + " = \""
+        + cevns_str + "\" encountered in"
+        " marley::JSONConfig::create_generator(). Allowed values are"
+        " \"generic\" and \"coherent\"." );
+    }
+
+    FFMode ff_mode = FFMode::NONE;
+    std::string ff_key( "cevns_form_factor" );
+    if ( json_.has_key(ff_key) ) {
+      const marley::JSON& ff_json = json_.at( ff_key );
+      if ( !ff_json.is_string() ) handle_json_error( ff_key.c_str(),
+        ff_json );
+      ff_mode = marley::CoherentReaction::form_factor_from_string(
+        ff_json.to_string() );
+    }
+
+    if ( cevns_str == "coherent" ) {
+      for ( auto& react : gen.reactions_ ) {
+        auto* nr = dynamic_cast< marley::NuclearReaction* >( react.get() );
+        if ( !nr ) continue;
+
+        auto cr = marley::CoherentReaction::from_nuclear_reaction( *nr );
+        if ( !cr ) continue;
+
+        cr->set_form_factor( ff_mode );
+        MARLEY_LOG_INFO() << "Using the coherent elastic scattering engine"
+          << " for the reaction " << cr->get_description();
+        react = std::move( cr );
+      }
+    }
+  }
+
+  // Configure importance sampling (if requested). This is done after the
+  // final set of reaction objects has been chosen.
+  prepare_biasing( gen );
+
+  // Configure cuts on the primary interaction (if requested)
+  prepare_event_filter( gen );
+
+  // If requested, tabulate the total cross sections for all configured
+  // nuclear reactions over the energy range of the source. This is done after
+  // the Coulomb mode has been set since the tables depend on it.
+  bool built_xs_table = false;
+  std::string xs_key( "xs_mode" );
+  if ( json_.has_key(xs_key) ) {
+    const marley::JSON& xs_json = json_.at( xs_key );
+    if ( !xs_json.is_string() ) handle_json_error( xs_key.c_str(), xs_json );
+
+    std::string xs_str = xs_json.to_string();
+    if ( xs_str != "exact" && xs_str != "table" ) throw marley::Error(
+      "Invalid value of " + xs_key + " = \"" + xs_str + "\" encountered in"
+      " marley::JSONConfig::create_generator(). Allowed values are"
+      " \"exact\" and \"table\"." );
+
+    if ( xs_str == "table" ) {
+      // The table may be extended beyond the energy range of the source
+      // for use by an external flux driver
+      double KEa_max = gen.get_source().get_Emax();
+      std::string xs_max_key( "xs_table_max_energy" );
+      if ( json_.has_key(xs_max_key) ) {
+        const marley::JSON& xs_max_json = json_.at( xs_max_key );
+        bool ok;
+        double xs_max = xs_max_json.to_double( ok );
+        if ( !ok || !(xs_max > 0.) ) handle_json_error( xs_max_key.c_str(),
+          xs_max_json );
+        KEa_max = std::max( KEa_max, xs_max );
+      }
+
+      // Tables written ahead of time (e.g., by mardumpxs) may be loaded
+      // from a file instead of being built here. A reaction whose table is
+      // missing from the file, or does not reach KEa_max, gets a new one.
+      std::vector<marley::CrossSectionTable> file_tables;
+      std::string xs_file_key( "xs_table_file" );
+      if ( json_.has_key(xs_file_key) ) {
+        const marley::JSON& xs_file_json = json_.at( xs_file_key );
+        bool ok;
+        std::string xs_file = xs_file_json.to_string( ok );
+        if ( !ok ) handle_json_error( xs_file_key.c_str(), xs_file_json );
+        marley::CrossSectionTable::load( xs_file, file_tables );
+      }
+
+      // Tables from a reaction bundle are used only if they were built with
+      // the same Coulomb correction method
+      if ( bundle_loaded && bundle.coulomb_mode == marley::NuclearReaction
+        ::string_from_coulomb_mode(coulomb_mode) )
+      {
+        file_tables.insert( file_tables.end(), bundle.xs_tables.cbegin(),
+          bundle.xs_tables.cend() );
+      }
+
+      for ( auto& react : gen.reactions_ ) {
+        auto* nr = dynamic_cast< marley::NuclearReaction* >( react.get() );
+        if ( !nr ) continue;
+
+        bool loaded = false;
+        for ( const auto& table : file_tables ) {
+          if ( table.KEs.empty() || table.KEs.back() < KEa_max ) continue;
+          loaded = nr->use_xs_table( table );
+          if ( loaded ) break;
+        }
+
+        if ( loaded ) MARLEY_LOG_INFO() << "Loaded the total cross section"
+          << " table for the reaction " << nr->get_description();
+        else {
+          // A reaction with a threshold above KEa_max gets an empty table,
+          // which a reaction bundle need not provide
+          nr->build_xs_table( KEa_max );
+          if ( nr->has_xs_table() ) built_xs_table = true;
+        }
+      }
+    }
+
+    MARLEY_LOG_INFO() << "Total reaction cross sections will be"
+      << ( xs_str == "table" ? " interpolated from tables" :
+      " computed exactly" );
+  }
+
+  // Write a new reaction bundle if none was loaded, or if tables had to be
+  // built that the loaded one did not provide
+  if ( !bundle_file.empty() && (!bundle_loaded || built_xs_table) ) {
+    marley::ReactionBundle::from_generator( reaction_files, gen ).save(
+      bundle_file );
+  }
+
+  // If requested, fill the tables used by the nuclear de-excitation models
+  // for every nuclide that may be reached before any events are generated.
+  // Generators that use an existing StructureDatabase share its results.
+  std::string precompute_key( "precompute_model_tables" );
+  if ( !sdb && gen.do_deexcitations_ && json_.has_key(precompute_key) ) {
+    const marley::JSON& precompute_json = json_.at( precompute_key );
+
+    // Either a boolean, or the number of threads to use (zero means one per
+    // hardware thread)
+    bool precompute = true;
+    long num_threads = 0;
+    bool ok = true;
+    if ( precompute_json.is_bool() ) precompute = precompute_json.to_bool();
+    else {
+      num_threads = precompute_json.to_long( ok );
+      if ( !ok || num_threads < 0 ) handle_json_error( precompute_key.c_str(),
+        precompute_json );
+    }
+
+    if ( precompute ) gen.get_structure_db().precompute_model_tables(
+      gen.max_residue_excitation_energies(),
+      static_cast<unsigned>(num_threads) );
+  }
+
+  // Disable any reactions that were left out of the "enabled_reactions"
+  // array
+  for ( const auto& pair : parse_enabled_reactions(gen) ) {
+    gen.set_reaction_enabled( pair.first, pair.second );
+  }
+
   // Now that the reactions and source are both prepared, check that a neutrino
   // from the source can interact via at least one of the enabled reactions
   bool found_matching_pdg = false;
@@ -242,12 +661,16 @@ marley::Generator marley::JSONConfig::create_generator() const
   // Before returning the newly-created Generator object, print logging
   // messages describing the reactions that are active.
   MARLEY_LOG_INFO() << "Generator configuration complete. Active reactions:";
-  for ( const auto& r : gen.get_reactions() ) {
+  const auto& reactions = gen.get_reactions();
+  for ( size_t j = 0u; j < reactions.size(); ++j ) {
 
+    const auto& r = reactions[ j ];
     const marley::TargetAtom ta = r->atomic_target();
     double atom_frac = gen.get_target().atom_fraction( ta );
 
-    if ( r->pdg_a() == source_pdg && atom_frac > 0. ) {
+    if ( r->pdg_a() == source_pdg && atom_frac > 0.
+      && gen.reaction_enabled(j) )
+    {
 
       std::string proc_type_str;
       if ( r->process_type() == ProcType::NeutrinoCC
@@ -303,6 +726,44 @@ marley::Generator marley::JSONConfig::create_generator() const
   return gen;
 }
 
+//------------------------------------------------------------------------------
+void marley::JSONConfig::prepare_random_engine(marley::Generator& gen) const {
+  // Use the default Mersenne Twister engine unless the user has requested
+  // something different
+  if ( !json_.has_key("random_engine") ) return;
+
+  const marley::JSON& re = json_.at("random_engine");
+  if ( !re.is_object() ) throw marley::Error( "The \"random_engine\""
+    " key in the job configuration file must have a value that is a JSON"
+    " object." );
+
+  std::string type( "mt19937_64" );
+  if ( re.has_key("type") ) type = re.at( "type" ).to_string();
+
+  if ( type == "philox" || type == "philox4x64" ) {
+    gen.set_counter_based_rng( true );
+  }
+  else if ( type != "mt19937_64" ) throw marley::Error( "Unrecognized"
+    " random number engine type \"" + type + "\" given in the job"
+    " configuration file" );
+
+  if ( re.has_key("stream") ) {
+    bool ok;
+    long stream = re.at( "stream" ).to_long( ok );
+    if ( !ok || stream < 0 ) handle_json_error( "random_engine.stream",
+      re.at("stream") );
+    if ( !gen.counter_based_rng() ) throw marley::Error( "The"
+      " \"random_engine.stream\" key may only be used with type"
+      " \"philox\"" );
+    gen.set_rng_stream( static_cast<uint64_t>(stream) );
+  }
+
+  if ( gen.counter_based_rng() ) {
+    MARLEY_LOG_INFO() << "Using the counter-based Philox4x64-10 random"
+      << " number engine with stream ID " << gen.get_rng_stream();
+  }
+}
+
 //------------------------------------------------------------------------------
 void marley::JSONConfig::prepare_direction(marley::Generator& gen) const {
   // Get the incident neutrino direction if the user has specified one
@@ -352,7 +813,17 @@ void marley::JSONConfig::prepare_direction(marley::Generator& gen) const {
   }
 }
 
-void marley::JSONConfig::prepare_reactions(marley::Generator& gen) const {
+void marley::JSONConfig::prepare_reactions(marley::Generator& gen,
+  std::vector<std::string>& file_names) const
+{
+  file_names.clear();
+
+  // Detector configurations with several materials define the reactions
+  // and target together
+  if ( json_.has_key("materials") ) {
+    prepare_materials( gen, file_names );
+    return;
+  }
 
   const auto& fm = marley::FileManager::Instance();
 
@@ -397,6 +868,12 @@ void marley::JSONConfig::prepare_reactions(marley::Generator& gen) const {
             " check that it is readable and conforms to the correct input"
             " format." );
 
+          if ( std::find(file_names.cbegin(), file_names.cend(),
+            full_file_name) == file_names.cend() )
+          {
+            file_names.push_back( full_file_name );
+          }
+
           // All of the Reaction objects loaded from a single file will have
           // the same process type and atomic target, so just save this
           // information from the first one
@@ -453,6 +930,33 @@ void marley::JSONConfig::prepare_structure(marley::Generator& gen) const
 
   auto& sdb = gen.get_structure_db();
 
+  // Apply any precision preset first so that the individual settings below
+  // may override parts of it
+  std::string precision_key( "precision" );
+  if ( json_.has_key(precision_key) ) {
+    const marley::JSON& precision_json = json_.at( precision_key );
+    if ( !precision_json.is_string() ) handle_json_error(
+      precision_key.c_str(), precision_json );
+
+    std::string precision_str = precision_json.to_string();
+    if ( precision_str == "validation" ) {
+      sdb.set_precision( marley::Precision::Validation );
+    }
+    else if ( precision_str == "production" ) {
+      sdb.set_precision( marley::Precision::Production );
+    }
+    else if ( precision_str == "fast" ) {
+      sdb.set_precision( marley::Precision::Fast );
+    }
+    else throw marley::Error( "Invalid value of " + precision_key + " = \""
+      + precision_str + "\" encountered in marley::JSONConfig::"
+      "prepare_structure(). Allowed values are \"validation\","
+      " \"production\", and \"fast\"." );
+
+    MARLEY_LOG_INFO() << "Using the \"" << precision_str << "\" precision"
+      << " preset for nuclear de-excitations";
+  }
+
   std::string flmax_key( "fragment_lmax" );
   if ( json_.has_key(flmax_key) ) {
     bool ok;
@@ -488,6 +992,224 @@ void marley::JSONConfig::prepare_structure(marley::Generator& gen) const
       << " differential decay widths set to l_max = " << g_lmax;
   }
 
+  std::string fltol_key( "fragment_l_tolerance" );
+  if ( json_.has_key(fltol_key) ) {
+    bool ok;
+    const marley::JSON& fltol_json = json_.at( fltol_key );
+    double fl_tol = fltol_json.to_double( ok );
+    if ( !ok ) handle_json_error( fltol_key.c_str(), fltol_json );
+
+    if ( !(fl_tol >= 0. && fl_tol < 1.) ) throw marley::Error( "Invalid"
+      " value of " + fltol_key + " = " + std::to_string(fl_tol)
+      + " encountered in marley::JSONConfig::prepare_structure(). It must"
+      " lie on the interval [0, 1)." );
+
+    sdb.set_fragment_l_tolerance( fl_tol );
+
+    if ( fl_tol > 0. ) MARLEY_LOG_INFO() << "Orbital angular momentum sums"
+      << " for fragment differential decay widths will be truncated with a"
+      << " relative tolerance of " << fl_tol;
+  }
+
+  std::string cache_key( "hf_decay_cache_size" );
+  if ( json_.has_key(cache_key) ) {
+    bool ok;
+    const marley::JSON& cache_json = json_.at( cache_key );
+    long cache_size = cache_json.to_long( ok );
+    if ( !ok ) handle_json_error( cache_key.c_str(), cache_json );
+
+    if ( cache_size < 0 ) throw marley::Error( "Negative value of "
+      + cache_key + " = " + std::to_string(cache_size) + " encountered in"
+      " marley::JSONConfig::prepare_structure()" );
+
+    sdb.set_hf_decay_cache_size( cache_size );
+
+    MARLEY_LOG_INFO() << "Hauser-Feshbach decay cache size set to "
+      << cache_size;
+  }
+
+  std::string tol_key( "integration_tolerance" );
+  if ( json_.has_key(tol_key) ) {
+    bool ok;
+    const marley::JSON& tol_json = json_.at( tol_key );
+    double tol = tol_json.to_double( ok );
+    if ( !ok ) handle_json_error( tol_key.c_str(), tol_json );
+
+    if ( tol < 0. ) throw marley::Error( "Negative value of "
+      + tol_key + " = " + std::to_string(tol) + " encountered in"
+      " marley::JSONConfig::prepare_structure()" );
+
+    sdb.set_integration_tolerance( tol );
+
+    if ( tol > 0. ) MARLEY_LOG_INFO() << "Adaptive numerical integration"
+      << " will be used with a relative tolerance of " << tol;
+  }
+
+  std::string pool_key( "discrete_pool_tolerance" );
+  if ( json_.has_key(pool_key) ) {
+    bool ok;
+    const marley::JSON& pool_json = json_.at( pool_key );
+    double pool_tol = pool_json.to_double( ok );
+    if ( !ok ) handle_json_error( pool_key.c_str(), pool_json );
+
+    if ( !(pool_tol >= 0. && pool_tol < 1.) ) throw marley::Error( "Invalid"
+      " value of " + pool_key + " = " + std::to_string(pool_tol)
+      + " encountered in marley::JSONConfig::prepare_structure(). It must"
+      " lie on the interval [0, 1)." );
+
+    sdb.set_discrete_pool_tolerance( pool_tol );
+
+    if ( pool_tol > 0. ) MARLEY_LOG_INFO() << "Discrete exit channels"
+      << " carrying up to a fraction " << pool_tol << " of each decay width"
+      << " will be pooled";
+  }
+
+  std::string lazy_key( "lazy_continuum_widths" );
+  if ( json_.has_key(lazy_key) ) {
+    bool ok;
+    const marley::JSON& lazy_json = json_.at( lazy_key );
+    bool lazy = lazy_json.to_bool( ok );
+    if ( !ok ) handle_json_error( lazy_key.c_str(), lazy_json );
+
+    sdb.set_lazy_continuum_widths( lazy );
+
+    if ( lazy ) MARLEY_LOG_INFO() << "Continuum decay widths will be"
+      << " computed only when needed for sampling";
+  }
+
+  std::string ect_key( "exit_channel_threads" );
+  if ( json_.has_key(ect_key) ) {
+    bool ok;
+    const marley::JSON& ect_json = json_.at( ect_key );
+    long num_threads = ect_json.to_long( ok );
+    if ( !ok || num_threads < 0 ) handle_json_error( ect_key.c_str(),
+      ect_json );
+
+    // The helper threads are shared by every Generator in the process
+    auto& pool = marley::TaskPool::Instance();
+    if ( pool.num_threads() != static_cast<size_t>(num_threads) ) {
+      pool.set_num_threads( num_threads );
+    }
+    sdb.set_parallel_exit_channels( num_threads > 0 );
+
+    if ( num_threads > 0 ) MARLEY_LOG_INFO() << "Hauser-Feshbach exit"
+      << " channels will be built using " << num_threads << " helper"
+      << " thread(s)";
+  }
+
+  std::string path_key( "cascade_path_tolerance" );
+  if ( json_.has_key(path_key) ) {
+    bool ok;
+    const marley::JSON& path_json = json_.at( path_key );
+    double tol = path_json.to_double( ok );
+    if ( !ok ) handle_json_error( path_key.c_str(), path_json );
+
+    if ( tol < 0. || tol >= 1. ) throw marley::Error( "Invalid value of "
+      + path_key + " = " + std::to_string(tol) + " encountered in"
+      " marley::JSONConfig::prepare_structure()" );
+
+    sdb.set_cascade_path_tolerance( tol );
+
+    if ( tol > 0. ) MARLEY_LOG_INFO() << "Gamma-ray cascades will be"
+      << " sampled using path tables with a tolerance of " << tol;
+  }
+
+  std::string prefetch_key( "prefetch_structure_data" );
+  if ( json_.has_key(prefetch_key) ) {
+    bool ok;
+    const marley::JSON& prefetch_json = json_.at( prefetch_key );
+    bool prefetch = prefetch_json.to_bool( ok );
+    if ( !ok ) handle_json_error( prefetch_key.c_str(), prefetch_json );
+
+    if ( prefetch ) sdb.prefetch_structure_files();
+  }
+
+  std::string budget_key( "memory_budget" );
+  if ( json_.has_key(budget_key) ) {
+    bool ok;
+    const marley::JSON& budget_json = json_.at( budget_key );
+    double budget_MB = budget_json.to_double( ok );
+    if ( !ok ) handle_json_error( budget_key.c_str(), budget_json );
+
+    if ( budget_MB < 0. ) throw marley::Error( "Negative value of "
+      + budget_key + " = " + std::to_string(budget_MB) + " encountered in"
+      " marley::JSONConfig::prepare_structure()" );
+
+    sdb.set_memory_budget( static_cast<size_t>(budget_MB * 1024. * 1024.) );
+
+    MARLEY_LOG_INFO() << "Nuclear structure memory budget set to "
+      << budget_MB << " MB";
+  }
+
+  std::string ldm_key( "level_density_mode" );
+  if ( json_.has_key(ldm_key) ) {
+    const marley::JSON& ldm_json = json_.at( ldm_key );
+    if ( !ldm_json.is_string() ) handle_json_error( ldm_key.c_str(),
+      ldm_json );
+
+    std::string ldm_str = ldm_json.to_string();
+    if ( ldm_str == "exact" ) sdb.set_tabulate_level_densities( false );
+    else if ( ldm_str == "table" ) sdb.set_tabulate_level_densities( true );
+    else throw marley::Error( "Invalid value of " + ldm_key + " = \""
+      + ldm_str + "\" encountered in marley::JSONConfig::prepare_structure()."
+      " Allowed values are \"exact\" and \"table\"." );
+
+    MARLEY_LOG_INFO() << "Nuclear level densities will be"
+      << ( ldm_str == "table" ? " interpolated from tables" :
+      " computed exactly" );
+  }
+
+  std::string gsf_key( "gamma_strength_mode" );
+  if ( json_.has_key(gsf_key) ) {
+    const marley::JSON& gsf_json = json_.at( gsf_key );
+    if ( !gsf_json.is_string() ) handle_json_error( gsf_key.c_str(),
+      gsf_json );
+
+    std::string gsf_str = gsf_json.to_string();
+    if ( gsf_str == "exact" ) {
+      sdb.set_tabulate_gamma_strength_functions( false );
+    }
+    else if ( gsf_str == "table" ) {
+      sdb.set_tabulate_gamma_strength_functions( true );
+    }
+    else throw marley::Error( "Invalid value of " + gsf_key + " = \""
+      + gsf_str + "\" encountered in marley::JSONConfig::prepare_structure()."
+      " Allowed values are \"exact\" and \"table\"." );
+
+    MARLEY_LOG_INFO() << "Gamma-ray transmission coefficients will be"
+      << ( gsf_str == "table" ? " interpolated from tables" :
+      " computed exactly" );
+  }
+
+  std::string tm_key( "transmission_mode" );
+  if ( json_.has_key(tm_key) ) {
+    const marley::JSON& tm_json = json_.at( tm_key );
+    if ( !tm_json.is_string() ) handle_json_error( tm_key.c_str(), tm_json );
+
+    using TMode = marley::OpticalModel::TransmissionMode;
+    std::string tm_str = tm_json.to_string();
+    if ( tm_str == "exact" ) sdb.set_transmission_mode( TMode::Exact );
+    else if ( tm_str == "table" ) sdb.set_transmission_mode( TMode::Table );
+    else throw marley::Error( "Invalid value of " + tm_key + " = \""
+      + tm_str + "\" encountered in marley::JSONConfig::prepare_structure()."
+      " Allowed values are \"exact\" and \"table\"." );
+
+    MARLEY_LOG_INFO() << "Optical model transmission coefficients will be"
+      << ( tm_str == "table" ? " interpolated from tables" :
+      " computed exactly" );
+  }
+
+  // This needs to come last so that the tables are loaded using the final
+  // model settings
+  std::string cache_file_key( "model_table_cache" );
+  if ( json_.has_key(cache_file_key) ) {
+    const marley::JSON& cache_file_json = json_.at( cache_file_key );
+    if ( !cache_file_json.is_string() ) handle_json_error(
+      cache_file_key.c_str(), cache_file_json );
+
+    sdb.set_table_cache_file( cache_file_json.to_string() );
+  }
+
 }
 
 //------------------------------------------------------------------------------
@@ -529,16 +1251,17 @@ InterpMethod marley::JSONConfig::get_interpolation_method(
 //------------------------------------------------------------------------------
 void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
 {
-  // Check whether the user provided their own estimate of the source PDF
-  // maximum value. If they did, adopt that before building the source.
-  // This is useful when automatic searches for the maximum don't work.
-  // The user can put in a value manually to get rejection sampling to work.
+  // Reacting neutrino energies are now sampled using a precomputed CDF, so
+  // a user-supplied estimate of the PDF maximum is no longer needed. Accept
+  // the old key for backwards compatibility, but let the user know that it
+  // has no effect.
   if ( json_.has_key("energy_pdf_max" ) ) {
     bool ok;
     const marley::JSON& max_spec = json_.at("energy_pdf_max");
-    double user_max = max_spec.to_double( ok );
+    max_spec.to_double( ok );
     if ( !ok ) handle_json_error("energy_pdf_max", max_spec);
-    else gen.set_default_E_pdf_max( user_max );
+    else MARLEY_LOG_WARNING() << "The energy_pdf_max key is no longer used"
+      << " and will be ignored";
   }
 
   // Check whether the JSON configuration includes a neutrino source
@@ -554,18 +1277,6 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
     return;
   }
 
-  // Complain if the user didn't specify a source type
-  if ( !source_spec.has_key("type") ) {
-    throw marley::Error(std::string("Missing \"type\" key in")
-      + " neutrino source specification.");
-    return;
-  }
-
-  // Get the neutrino source type
-  bool ok;
-  std::string type = source_spec.at("type").to_string(ok);
-  if ( !ok ) handle_json_error("source.type", source_spec.at("type"));
-
   // Complain if the user didn't specify a neutrino type
   if (!source_spec.has_key("neutrino")) {
     throw marley::Error(std::string("Missing \"neutrino\" key in")
@@ -573,12 +1284,46 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
     return;
   }
   // Get the neutrino type
+  bool ok;
   std::string nu = source_spec.at("neutrino").to_string(ok);
   if (!ok) handle_json_error("source.neutrino", source_spec.at("neutrino"));
 
   // Particle Data Group code for the neutrino type produced by this source
   int pdg = neutrino_pdg(nu);
 
+  std::unique_ptr<marley::NeutrinoSource> source
+    = create_neutrino_source( source_spec, pdg );
+
+  // If the user has specified whether to weight the incident neutrino spectrum
+  // by the reaction cross section(s), then set the weight_flux_ flag in the
+  // new Generator object accordingly
+  if ( source_spec.has_key("weight_flux") ) {
+    bool ok = false;
+    bool should_we_weight = source_spec.at("weight_flux").to_bool(ok);
+    if (!ok) handle_json_error("source.weight_flux",
+      source_spec.at("weight_flux"));
+    gen.set_weight_flux(should_we_weight);
+  }
+
+  // Load the generator with the new source object
+  gen.set_source( std::move(source) );
+
+}
+
+std::unique_ptr<marley::NeutrinoSource>
+  marley::JSONConfig::create_neutrino_source(
+  const marley::JSON& source_spec, int pdg, bool log_source ) const
+{
+  // Complain if the user didn't specify a source type
+  if ( !source_spec.has_key("type") ) {
+    throw marley::Error(std::string("Missing \"type\" key in")
+      + " neutrino source specification.");
+  }
+
+  bool ok;
+  std::string type = source_spec.at("type").to_string(ok);
+  if ( !ok ) handle_json_error("source.type", source_spec.at("type"));
+
   std::unique_ptr<marley::NeutrinoSource> source;
 
   if (type == "mono" || type == "monoenergetic") {
@@ -586,14 +1331,18 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
       "monoenergetic");
     source_check_positive(energy, "energy", "monoenergetic");
     source = std::make_unique<marley::MonoNeutrinoSource>(pdg, energy);
-    MARLEY_LOG_INFO() << "Created monoenergetic "
-      << marley_utils::get_particle_symbol(pdg) << " source with"
-      << " neutrino energy = " << energy << " MeV";
+    if ( log_source ) {
+      MARLEY_LOG_INFO() << "Created monoenergetic "
+        << marley_utils::get_particle_symbol(pdg) << " source with"
+        << " neutrino energy = " << energy << " MeV";
+    }
   }
   else if (type == "dar" || type == "decay-at-rest") {
     source = std::make_unique<marley::DecayAtRestNeutrinoSource>(pdg);
-     MARLEY_LOG_INFO() << "Created muon decay-at-rest "
-       << marley_utils::get_particle_symbol(pdg) << " source";
+    if ( log_source ) {
+      MARLEY_LOG_INFO() << "Created muon decay-at-rest "
+        << marley_utils::get_particle_symbol(pdg) << " source";
+    }
   }
   else if (type == "fd" || type == "fermi-dirac" || type == "fermi_dirac") {
     double Emin = source_get_double("Emin", source_spec, "Fermi-Dirac");
@@ -613,12 +1362,14 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
 
     source = std::make_unique<marley::FermiDiracNeutrinoSource>(pdg, Emin,
       Emax, temp, eta);
-    MARLEY_LOG_INFO() << "Created Fermi-Dirac "
-      << marley_utils::get_particle_symbol(pdg) << " source with parameters";
-    MARLEY_LOG_INFO() << "  Emin = " << Emin << " MeV";
-    MARLEY_LOG_INFO() << "  Emax = " << Emax << " MeV";
-    MARLEY_LOG_INFO() << "  temperature = " << temp << " MeV";
-    MARLEY_LOG_INFO() << "  eta = " << eta;
+    if ( log_source ) {
+      MARLEY_LOG_INFO() << "Created Fermi-Dirac "
+        << marley_utils::get_particle_symbol(pdg) << " source with parameters";
+      MARLEY_LOG_INFO() << "  Emin = " << Emin << " MeV";
+      MARLEY_LOG_INFO() << "  Emax = " << Emax << " MeV";
+      MARLEY_LOG_INFO() << "  temperature = " << temp << " MeV";
+      MARLEY_LOG_INFO() << "  eta = " << eta;
+    }
   }
   else if (type == "bf" || type == "beta" || type == "beta-fit") {
     double Emin = source_get_double("Emin", source_spec, "beta-fit");
@@ -637,12 +1388,14 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
 
     source = std::make_unique<marley::BetaFitNeutrinoSource>(pdg, Emin,
       Emax, Emean, beta);
-    MARLEY_LOG_INFO() << "Created beta-fit "
-      << marley_utils::get_particle_symbol(pdg) << " source with parameters";
-    MARLEY_LOG_INFO() << "  Emin = " << Emin << " MeV";
-    MARLEY_LOG_INFO() << "  Emax = " << Emax << " MeV";
-    MARLEY_LOG_INFO() << "  average energy = " << Emean << " MeV";
-    MARLEY_LOG_INFO() << "  beta = " << beta;
+    if ( log_source ) {
+      MARLEY_LOG_INFO() << "Created beta-fit "
+        << marley_utils::get_particle_symbol(pdg) << " source with parameters";
+      MARLEY_LOG_INFO() << "  Emin = " << Emin << " MeV";
+      MARLEY_LOG_INFO() << "  Emax = " << Emax << " MeV";
+      MARLEY_LOG_INFO() << "  average energy = " << Emean << " MeV";
+      MARLEY_LOG_INFO() << "  beta = " << beta;
+    }
   }
   else if (type == "hist" || type == "histogram") {
 
@@ -681,8 +1434,10 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
     // Create the source
     source = std::make_unique<marley::GridNeutrinoSource>(Es, weights, pdg,
       InterpMethod::Constant);
-    MARLEY_LOG_INFO() << "Created histogram "
-      << marley_utils::get_particle_symbol(pdg) << " source";
+    if ( log_source ) {
+      MARLEY_LOG_INFO() << "Created histogram "
+        << marley_utils::get_particle_symbol(pdg) << " source";
+    }
   }
   else if (type == "grid") {
     std::vector<double> energies = get_vector("energies", source_spec, "grid");
@@ -693,28 +1448,65 @@ void marley::JSONConfig::prepare_neutrino_source(marley::Generator& gen) const
 
     source = std::make_unique<marley::GridNeutrinoSource>(energies, PDs, pdg,
       method);
-    MARLEY_LOG_INFO() << "Created grid "
-      << marley_utils::get_particle_symbol(pdg) << " source";
+    if ( log_source ) {
+      MARLEY_LOG_INFO() << "Created grid "
+        << marley_utils::get_particle_symbol(pdg) << " source";
+    }
+  }
+  else if (type == "time-binned" || type == "time_binned") {
+    source = create_time_binned_source( source_spec, pdg );
   }
   else if (!process_extra_source_types(type, source_spec, pdg, source)) {
     throw marley::Error(std::string("Unrecognized MARLEY neutrino source")
       + " type '" + type + "'");
   }
 
-  // If the user has specified whether to weight the incident neutrino spectrum
-  // by the reaction cross section(s), then set the weight_flux_ flag in the
-  // new Generator object accordingly
-  if ( source_spec.has_key("weight_flux") ) {
-    bool ok = false;
-    bool should_we_weight = source_spec.at("weight_flux").to_bool(ok);
-    if (!ok) handle_json_error("source.weight_flux",
-      source_spec.at("weight_flux"));
-    gen.set_weight_flux(should_we_weight);
+  return source;
+}
+
+std::unique_ptr<marley::NeutrinoSource>
+  marley::JSONConfig::create_time_binned_source(
+  const marley::JSON& source_spec, int pdg ) const
+{
+  std::vector<double> edges = get_vector("time_edges", source_spec,
+    "time-binned");
+  std::vector<double> weights = get_vector("weights", source_spec,
+    "time-binned");
+
+  if ( !source_spec.has_key("bins") ) throw marley::Error("The"
+    " specification for a time-binned source should include a bins key.");
+
+  const marley::JSON& bins = source_spec.at( "bins" );
+  if ( !bins.is_array() ) throw marley::Error("The value given for the bins"
+    " key for a time-binned source should be an array.");
+
+  // Each element of the bins array gives the energy spectrum for one time bin
+  // using the same format as an ordinary source specification. The neutrino
+  // type is inherited from the time-binned source.
+  std::vector< std::unique_ptr<marley::NeutrinoSource> > bin_sources;
+  for ( const auto& bin_spec : bins.array_range() ) {
+    if ( !bin_spec.is_object() ) throw marley::Error("Invalid time bin"
+      " specification " + bin_spec.dump_string() );
+
+    bool ok;
+    std::string bin_type = bin_spec.has_key( "type" )
+      ? bin_spec.at( "type" ).to_string( ok ) : std::string();
+    if ( bin_type == "time-binned" || bin_type == "time_binned" ) {
+      throw marley::Error("Time-binned sources may not be nested");
+    }
+
+    bin_sources.push_back( create_neutrino_source(bin_spec, pdg, false) );
   }
 
-  // Load the generator with the new source object
-  gen.set_source( std::move(source) );
+  auto source = std::make_unique<marley::TimeBinnedNeutrinoSource>( pdg,
+    edges, weights, std::move(bin_sources) );
+
+  MARLEY_LOG_INFO() << "Created time-binned "
+    << marley_utils::get_particle_symbol(pdg) << " source with "
+    << source->num_bins() << " bins between t = " << edges.front()
+    << " and t = " << edges.back();
 
+  return source;
 }
 
 void marley::JSONConfig::prepare_dm_source(marley::Generator& gen) const
@@ -722,9 +1514,16 @@ void marley::JSONConfig::prepare_dm_source(marley::Generator& gen) const
   std::cout<<"Preparing the dm particle source parameters.."<<std::endl;
   std::cout<<"  want to load the mass of the particle, the velocity, and potentially LAMBDA"<<std::endl;
 
+  // Load the generator with the new source object (if any)
+  gen.set_source( create_dm_source() );
+}
+
+std::unique_ptr<marley::NeutrinoSource>
+  marley::JSONConfig::create_dm_source() const
+{
   // Check whether the JSON configuration includes a particle source
   // specification
-  if ( !json_.has_key("source") ) return;
+  if ( !json_.has_key("source") ) return nullptr;
   const marley::JSON& source_spec = json_.at("source");
 
   // If the dm source key has a null value, just return without doing
@@ -732,14 +1531,13 @@ void marley::JSONConfig::prepare_dm_source(marley::Generator& gen) const
   if ( source_spec.is_null() ) {
     MARLEY_LOG_INFO() << "Null source specification detected. Skipping"
       << " dm source configuration.";
-    return;
+    return nullptr;
   }
 
   // Complain if the user didn't specify a source type
   if ( !source_spec.has_key("type") ) {
     throw marley::Error(std::string("Missing \"type\" key in")
       + " dm source specification.");
-    return;
   }
 
   // Get the dm source type
@@ -751,7 +1549,6 @@ void marley::JSONConfig::prepare_dm_source(marley::Generator& gen) const
   if (!source_spec.has_key("neutrino")) {
     throw marley::Error(std::string("Missing \"neutrino\" key in")
       + " neutrino source specification.");
-    return;
   }
   // Get the neutrino type
   std::string nu = source_spec.at("neutrino").to_string(ok);
@@ -770,18 +1567,76 @@ void marley::JSONConfig::prepare_dm_source(marley::Generator& gen) const
     double dm_UV = source_get_double("LAMBDA", source_spec,
       "monoenergetic");
     source_check_positive(energy, "energy", "monoenergetic");
-    source = std::make_unique<marley::MonoDMSource>(pdg, dm_mass, 1.,dm_UV);
+
+    // The dark matter speed is given in units of c
+    double dm_velocity = marley_utils::DM_DEFAULT_VELOCITY;
+    if ( source_spec.has_key("velocity") ) {
+      dm_velocity = source_get_double("velocity", source_spec,
+        "monoenergetic");
+      source_check_positive(dm_velocity, "velocity", "monoenergetic");
+    }
+
+    source = std::make_unique<marley::MonoDMSource>(pdg, dm_mass,
+      dm_velocity, dm_UV);
     MARLEY_LOG_INFO() << "Created monoenergetic "
       << marley_utils::get_particle_symbol(pdg) << " source with"
       << " dm mass = " << dm_mass << " MeV";
   }
+  else if (type == "haloDM") {
+    double dm_mass = source_get_double("mass", source_spec, "halo");
+    double dm_UV = source_get_double("LAMBDA", source_spec, "halo");
+
+    // Standard halo model parameters (km/s)
+    double v0 = 220.;
+    double v_esc = 544.;
+    double v_earth = 232.;
+    if ( source_spec.has_key("v0") ) v0 = source_get_double("v0",
+      source_spec, "halo");
+    if ( source_spec.has_key("v_esc") ) v_esc = source_get_double("v_esc",
+      source_spec, "halo");
+    if ( source_spec.has_key("v_earth") ) v_earth = source_get_double(
+      "v_earth", source_spec, "halo");
+
+    size_t num_bins = marley::HaloDMSource::DEFAULT_NUM_VELOCITY_BINS;
+    if ( source_spec.has_key("velocity_bins") ) {
+      bool ok;
+      long bins = source_spec.at("velocity_bins").to_long(ok);
+      if ( !ok || bins <= 0 ) handle_json_error("source.velocity_bins",
+        source_spec.at("velocity_bins"));
+      num_bins = static_cast<size_t>( bins );
+    }
 
+    const double c = marley_utils::c_km_per_s;
+    auto halo = std::make_unique<marley::HaloDMSource>(pdg, dm_mass, dm_UV,
+      v0 / c, v_esc / c, v_earth / c, num_bins);
 
-  // Load the generator with the new source object
-  gen.set_source( std::move(source) );
+    MARLEY_LOG_INFO() << "Created halo "
+      << marley_utils::get_particle_symbol(pdg) << " source with"
+      << " dm mass = " << dm_mass << " MeV";
+    MARLEY_LOG_INFO() << "  v0 = " << v0 << " km/s, v_esc = " << v_esc
+      << " km/s, v_earth = " << v_earth << " km/s";
+    MARLEY_LOG_INFO() << "  mean speed = " << halo->velocity() * c
+      << " km/s in " << num_bins << " velocity bins";
+
+    source = std::move( halo );
+  }
+  // Other source types produce neutrinos. Their events use the sampled
+  // projectile energy.
+  else source = create_neutrino_source( source_spec, pdg );
+
+  return source;
 }
 
 void marley::JSONConfig::prepare_target( marley::Generator& gen ) const {
+  gen.set_target( create_target(gen) );
+}
+
+std::unique_ptr<marley::Target> marley::JSONConfig::create_target(
+  const marley::Generator& gen ) const
+{
+  // The target for a multi-material configuration is set up by
+  // prepare_materials()
+  if ( json_.has_key("materials") ) return nullptr;
 
   // Temporary storage for the list of target atoms and their atom fractions
   // in the possibly-composite neutrino target
@@ -797,7 +1652,7 @@ void marley::JSONConfig::prepare_target( marley::Generator& gen ) const {
     // configuring the target at all. This only happens in unusual
     // situations.
     const auto& reactions = gen.get_reactions();
-    if ( reactions.empty() ) return;
+    if ( reactions.empty() ) return nullptr;
 
     // Otherwise, store the set of target atoms involved in at least
     // one reaction
@@ -816,78 +1671,434 @@ void marley::JSONConfig::prepare_target( marley::Generator& gen ) const {
   else {
     // If the user has specified a target composition explicitly, parse the
     // JSON object used to define it.
-    const auto& tgt_spec = json_.at( "target" );
-    if ( !tgt_spec.is_object() ) throw marley::Error( "Invalid neutrino target"
-      " specification " + tgt_spec.dump_string() );
+    parse_target_spec( json_.at("target"), atoms, atom_fractions );
+  }
 
-    if ( !tgt_spec.has_key("nuclides") ) throw marley::Error( "Missing \""
-      "nuclides\" key in the neutrino target specification "
-      + tgt_spec.dump_string() );
+  // We're done. Create the new Target object and move it into the Generator.
+  auto target = std::make_unique< marley::Target >( atoms, atom_fractions );
+  if ( target->has_single_nuclide() ) {
+    const marley::TargetAtom& ta = target->atom_fraction_map().cbegin()->first;
+    MARLEY_LOG_INFO() << "Configured pure " << ta << " neutrino target";
+  }
+  else {
+    MARLEY_LOG_INFO() << "Configured composite neutrino target with the"
+      << " following nuclide fractions:\n" << *target;
+  }
+  return target;
+}
 
-    const auto& n_spec = tgt_spec.at( "nuclides" );
+void marley::JSONConfig::prepare_materials( marley::Generator& gen,
+  std::vector<std::string>& file_names ) const
+{
+  const auto& m_spec = json_.at( "materials" );
+  if ( !m_spec.is_array() || m_spec.length() < 1 ) throw marley::Error(
+    "The \"materials\" key must be a non-empty array of material"
+    " specifications" );
+
+  if ( json_.has_key("reactions") || json_.has_key("target") ) {
+    throw marley::Error( "The \"reactions\" and \"target\" keys may not be"
+      " used together with \"materials\". Each material specification should"
+      " define its own." );
+  }
 
-    if ( !n_spec.is_array() ) throw marley::Error( "Invalid \"nuclides\""
-      " array given in the neutrino target specification "
-      + tgt_spec.dump_string() );
+  const auto& fm = marley::FileManager::Instance();
 
-    if ( !tgt_spec.has_key("atom_fractions") ) throw marley::Error( "Missing \""
-      "atom_fractions\" key in the neutrino target specification "
-      + tgt_spec.dump_string() );
+  // Parsed settings for a single detector material
+  struct Material {
+    std::string name;
+    std::map< marley::TargetAtom, double > atom_fractions;
+    std::set< std::string > files;
+    double exposure;
+  };
 
-    const auto& af_spec = tgt_spec.at( "atom_fractions" );
+  std::vector< Material > materials;
 
-    if ( !af_spec.is_array() ) throw marley::Error( "Invalid"
-      " \"atom_fractions\" array given in the neutrino target specification "
-      + tgt_spec.dump_string() );
+  // Exposure-weighted atom fractions for the combined target
+  std::map< marley::TargetAtom, double > combined_fractions;
+  double total_exposure = 0.;
 
-    // Check that the two arrays used to specify the target are of equal length
-    int num_nuclides = n_spec.length();
-    if ( num_nuclides != af_spec.length() ) throw marley::Error(
-      "Arrays of unequal length specified for the \"nuclides\" and \"atom"
-      "_fractions\" keys in the neutrino target specification "
-      + tgt_spec.dump_string() );
+  for ( int m = 0; m < m_spec.length(); ++m ) {
 
-    // Check that at least one target atom is listed
-    if ( num_nuclides < 1 ) throw marley::Error( "At least one target nuclide"
-      " must be included in the neutrino target specification" );
+    const auto& mat = m_spec.at( m );
+    if ( !mat.is_object() ) throw marley::Error( "Invalid material"
+      " specification " + mat.dump_string() );
 
-    // Loop over each of the target atoms. Parse their information and add them
-    // to the vectors that will be used to initialize the Target object.
-    for ( int n = 0; n < num_nuclides; ++n ) {
-      const auto& nuc = n_spec.at( n );
-      bool ok = false;
-      int nuc_pdg = nuc.to_long( ok );
-      if ( ok ) atoms.emplace_back( nuc_pdg );
-      // TODO: add support for string parsing
-      //else if ( nuc.is_string() ) {
-      //}
-      else throw marley::Error( "Invalid target nuclide specifier "
-        + nuc.dump_string() );
+    Material material;
+    material.name = "material " + std::to_string( m );
+    if ( mat.has_key("name") ) material.name = mat.at( "name" ).to_string();
 
-      // Parse and store the atom fraction. We already check for sane values
-      // while initializing the Target object itself, so just make sure that the
-      // conversion to a double worked out all right.
-      const auto& frac_spec = af_spec.at( n );
-      double frac = frac_spec.to_double( ok );
-      if ( ok ) atom_fractions.push_back( frac );
-      else throw marley::Error( "Invalid atom fraction "
-        + frac_spec.dump_string() );
+    if ( !mat.has_key("target") ) throw marley::Error( "Missing \"target\" key"
+      " in the specification for " + material.name );
+
+    std::vector< marley::TargetAtom > atoms;
+    std::vector< double > fractions;
+    parse_target_spec( mat.at("target"), atoms, fractions );
+
+    // Normalize the atom fractions within the material
+    double frac_sum = 0.;
+    for ( double f : fractions ) {
+      if ( f < 0. ) throw marley::Error( "Negative atom fraction given in the"
+        " target specification for " + material.name );
+      frac_sum += f;
+    }
+    if ( frac_sum <= 0. ) throw marley::Error( "The atom fractions given for "
+      + material.name + " do not have a positive sum" );
+    for ( size_t a = 0u; a < atoms.size(); ++a ) {
+      material.atom_fractions[ atoms.at(a) ] += fractions.at( a ) / frac_sum;
+    }
+
+    // The exposure is proportional to the number of target atoms in the
+    // material multiplied by the live time. Only relative values matter.
+    material.exposure = 1.;
+    if ( mat.has_key("exposure") ) {
+      bool ok;
+      material.exposure = mat.at( "exposure" ).to_double( ok );
+      if ( !ok || !(material.exposure > 0.) ) handle_json_error( "exposure",
+        mat.at("exposure") );
+    }
+    total_exposure += material.exposure;
+
+    for ( const auto& pair : material.atom_fractions ) {
+      combined_fractions[ pair.first ] += material.exposure * pair.second;
     }
+
+    if ( !mat.has_key("reactions") ) throw marley::Error( "Missing"
+      " \"reactions\" key in the specification for " + material.name );
+
+    const auto& rs = mat.at( "reactions" );
+    if ( !rs.is_array() ) handle_json_error( "reactions", rs );
+
+    for ( const auto& r : rs.array_range() ) {
+      std::string filename = r.to_string();
+      std::string full_file_name = fm.find_file( filename );
+      if ( full_file_name.empty() ) {
+        throw marley::Error("Could not locate the reaction data file "
+          + filename + ". Please check that the file name is spelled"
+          " correctly and that the file is in a folder"
+          " on the MARLEY search path.");
+      }
+      material.files.insert( full_file_name );
+      if ( std::find(file_names.cbegin(), file_names.cend(), full_file_name)
+        == file_names.cend() ) file_names.push_back( full_file_name );
+    }
+
+    materials.push_back( std::move(material) );
   }
 
-  // We're done. Create the new Target object and move it into the Generator.
-  auto target = std::make_unique< marley::Target >( atoms, atom_fractions );
-  if ( target->has_single_nuclide() ) {
-    const marley::TargetAtom& ta = target->atom_fraction_map().cbegin()->first;
-    MARLEY_LOG_INFO() << "Configured pure " << ta << " neutrino target";
+  // Load each reaction data file once. Reactions are kept only if their
+  // target atom belongs to a material that lists the file. The file that
+  // provided each (TargetAtom, ProcType) pair is remembered for the
+  // consistency check below.
+  std::map< std::pair<marley::TargetAtom, ProcType>, std::string > loaded;
+
+  for ( const auto& full_file_name : file_names ) {
+
+    auto reacts = marley::Reaction::load_from_file(
+      full_file_name, gen.get_structure_db() );
+
+    if ( reacts.empty() ) throw marley::Error( "Failed to load"
+      " any reactions from the file " + full_file_name + ". Please"
+      " check that it is readable and conforms to the correct input"
+      " format." );
+
+    // Atoms present in at least one of the materials that use this file
+    std::set< marley::TargetAtom > file_atoms;
+    for ( const auto& material : materials ) {
+      if ( !material.files.count(full_file_name) ) continue;
+      for ( const auto& pair : material.atom_fractions ) {
+        file_atoms.insert( pair.first );
+      }
+    }
+
+    bool used = false;
+    for ( auto& rct : reacts ) {
+
+      auto temp_atom = rct->atomic_target();
+      if ( !file_atoms.count(temp_atom) ) continue;
+
+      auto temp_pair = std::make_pair( temp_atom, rct->process_type() );
+      auto iter = loaded.find( temp_pair );
+      if ( iter == loaded.end() ) {
+        MARLEY_LOG_INFO() << "Loaded "
+          << marley::Reaction::proc_type_to_string( temp_pair.second )
+          << " reaction data for " << temp_atom << " from "
+          << full_file_name;
+        loaded[ temp_pair ] = full_file_name;
+      }
+      else if ( iter->second != full_file_name ) {
+        MARLEY_LOG_WARNING() << "Reaction settings for the "
+          << marley::Reaction::proc_type_to_string( temp_pair.second )
+          << " process on " << temp_atom << " were already loaded."
+          << " To avoid duplication, those in " << full_file_name
+          << " will be ignored.";
+        continue;
+      }
+
+      gen.add_reaction( std::move(rct) );
+      used = true;
+    }
+
+    if ( !used ) MARLEY_LOG_WARNING() << "None of the reactions in "
+      << full_file_name << " involve a target atom in a material that"
+      << " lists it";
   }
-  else {
-    MARLEY_LOG_INFO() << "Configured composite neutrino target with the"
-      << " following nuclide fractions:\n" << *target;
+
+  // The Generator weights each reaction by the atom fraction of its target.
+  // This is only correct when every material containing a nuclide enables
+  // the same processes on it, so complain about any mismatch.
+  for ( const auto& pair : loaded ) {
+    for ( const auto& material : materials ) {
+      if ( !material.atom_fractions.count(pair.first.first) ) continue;
+      if ( material.files.count(pair.second) ) continue;
+      throw marley::Error( "The "
+        + marley::Reaction::proc_type_to_string( pair.first.second )
+        + " process on " + pair.first.first.to_string() + " is enabled by "
+        + pair.second + ", which is not listed for " + material.name
+        + ". Materials that contain the same nuclide must enable the same"
+        " reactions on it." );
+    }
+  }
+
+  std::vector< marley::TargetAtom > atoms;
+  std::vector< double > atom_fractions;
+  for ( const auto& pair : combined_fractions ) {
+    atoms.push_back( pair.first );
+    atom_fractions.push_back( pair.second );
+  }
+
+  MARLEY_LOG_INFO() << "Configured " << materials.size()
+    << " detector materials:";
+  for ( const auto& material : materials ) {
+    MARLEY_LOG_INFO() << "  " << material.name << " (exposure fraction "
+      << material.exposure / total_exposure << ')';
   }
+
+  auto target = std::make_unique< marley::Target >( atoms, atom_fractions );
+  MARLEY_LOG_INFO() << "Combined neutrino target with the following"
+    << " nuclide fractions:\n" << *target;
   gen.set_target( std::move(target) );
 }
 
+void marley::JSONConfig::prepare_biasing( marley::Generator& gen ) const {
+
+  if ( !json_.has_key("biasing") ) return;
+
+  const auto& b_spec = json_.at( "biasing" );
+  if ( !b_spec.is_object() ) handle_json_error( "biasing", b_spec );
+
+  // Parses a positive bias factor from a JSON object
+  auto get_factor = [this](const marley::JSON& spec, const std::string& name)
+    -> double
+  {
+    if ( !spec.has_key("factor") ) throw marley::Error( "Missing \"factor\""
+      " key in the " + name + " specification " + spec.dump_string() );
+    bool ok = false;
+    double factor = spec.at( "factor" ).to_double( ok );
+    if ( !ok || !(factor > 0.) ) handle_json_error( name + ".factor",
+      spec.at("factor") );
+    return factor;
+  };
+
+  // Reaction and level biases
+  if ( b_spec.has_key("reactions") ) {
+    const auto& r_specs = b_spec.at( "reactions" );
+    if ( !r_specs.is_array() ) handle_json_error( "biasing.reactions",
+      r_specs );
+
+    for ( const auto& r_spec : r_specs.array_range() ) {
+      if ( !r_spec.is_object() ) handle_json_error( "biasing.reactions",
+        r_spec );
+
+      // Reactions may be selected by process type and/or target atom. If
+      // neither is given, then the bias applies to every reaction.
+      bool check_process = r_spec.has_key( "process" );
+      std::string process;
+      if ( check_process ) {
+        const auto& p_spec = r_spec.at( "process" );
+        if ( !p_spec.is_string() ) handle_json_error(
+          "biasing.reactions.process", p_spec );
+        process = p_spec.to_string();
+        if ( process != "CC" && process != "NC" && process != "ES"
+          && process != "DM" ) throw marley::Error( "Invalid process \""
+          + process + "\" given in a reaction bias specification. Allowed"
+          " values are \"CC\", \"NC\", \"ES\", and \"DM\"." );
+      }
+
+      bool check_target = r_spec.has_key( "target" );
+      int target_pdg = 0;
+      if ( check_target ) {
+        bool ok = false;
+        target_pdg = r_spec.at( "target" ).to_long( ok );
+        if ( !ok ) handle_json_error( "biasing.reactions.target",
+          r_spec.at("target") );
+      }
+
+      double factor = 1.;
+      if ( r_spec.has_key("factor") ) {
+        factor = get_factor( r_spec, "biasing.reactions" );
+      }
+
+      std::vector<marley::NuclearReaction::LevelBias> level_biases;
+      if ( r_spec.has_key("levels") ) {
+        const auto& l_specs = r_spec.at( "levels" );
+        if ( !l_specs.is_array() ) handle_json_error(
+          "biasing.reactions.levels", l_specs );
+
+        for ( const auto& l_spec : l_specs.array_range() ) {
+          if ( !l_spec.is_object() ) handle_json_error(
+            "biasing.reactions.levels", l_spec );
+          marley::NuclearReaction::LevelBias lb;
+          bool ok_min = false;
+          bool ok_max = false;
+          lb.Ex_min = l_spec.has_key( "Ex_min" )
+            ? l_spec.at( "Ex_min" ).to_double( ok_min ) : 0.;
+          lb.Ex_max = l_spec.has_key( "Ex_max" )
+            ? l_spec.at( "Ex_max" ).to_double( ok_max )
+            : std::numeric_limits<double>::infinity();
+          if ( l_spec.has_key("Ex_min") && !ok_min ) handle_json_error(
+            "biasing.reactions.levels.Ex_min", l_spec.at("Ex_min") );
+          if ( l_spec.has_key("Ex_max") && !ok_max ) handle_json_error(
+            "biasing.reactions.levels.Ex_max", l_spec.at("Ex_max") );
+          lb.factor = get_factor( l_spec, "biasing.reactions.levels" );
+          level_biases.push_back( lb );
+        }
+      }
+
+      bool found_match = false;
+      const auto& reactions = gen.get_reactions();
+      for ( size_t j = 0u; j < reactions.size(); ++j ) {
+        const auto& r = reactions.at( j );
+
+        if ( check_target && r->atomic_target().pdg() != target_pdg ) {
+          continue;
+        }
+
+        if ( check_process ) {
+          ProcType pt = r->process_type();
+          bool match = ( process == "CC" && (pt == ProcType::NeutrinoCC
+            || pt == ProcType::AntiNeutrinoCC) )
+            || ( process == "NC" && pt == ProcType::NC )
+            || ( process == "ES" && pt == ProcType::NuElectronElastic )
+            || ( process == "DM" && pt == ProcType::DM );
+          if ( !match ) continue;
+        }
+
+        found_match = true;
+        gen.set_reaction_bias( j, gen.reaction_bias(j) * factor );
+
+        if ( !level_biases.empty() ) {
+          auto* nr = dynamic_cast< marley::NuclearReaction* >( r.get() );
+          if ( nr ) for ( const auto& lb : level_biases ) {
+            nr->add_level_bias( lb );
+          }
+        }
+      }
+
+      if ( !found_match ) MARLEY_LOG_WARNING() << "The reaction bias"
+        << " specification " << r_spec.dump_string() << " does not match"
+        << " any configured reaction";
+    }
+
+    const auto& reactions = gen.get_reactions();
+    for ( size_t j = 0u; j < reactions.size(); ++j ) {
+      const auto& r = reactions.at( j );
+      if ( gen.reaction_bias(j) != 1. ) {
+        MARLEY_LOG_INFO() << "Reaction " << r->get_description()
+          << " will be sampled with bias factor " << gen.reaction_bias( j );
+      }
+      auto* nr = dynamic_cast< marley::NuclearReaction* >( r.get() );
+      if ( !nr ) continue;
+      for ( const auto& lb : nr->level_biases() ) {
+        MARLEY_LOG_INFO() << "Final levels of " << r->get_description()
+          << " with " << lb.Ex_min << " MeV <= Ex <= " << lb.Ex_max
+          << " MeV will be sampled with bias factor " << lb.factor;
+      }
+    }
+  }
+
+  // Hauser-Feshbach exit channel biases
+  if ( b_spec.has_key("exit_channels") ) {
+    const auto& e_specs = b_spec.at( "exit_channels" );
+    if ( !e_specs.is_array() ) handle_json_error( "biasing.exit_channels",
+      e_specs );
+
+    for ( const auto& e_spec : e_specs.array_range() ) {
+      if ( !e_spec.is_object() || !e_spec.has_key("particle") ) {
+        handle_json_error( "biasing.exit_channels", e_spec );
+      }
+      bool ok = false;
+      int pdg = e_spec.at( "particle" ).to_long( ok );
+      if ( !ok ) handle_json_error( "biasing.exit_channels.particle",
+        e_spec.at("particle") );
+
+      double factor = get_factor( e_spec, "biasing.exit_channels" );
+      gen.set_exit_channel_bias( pdg, gen.exit_channel_bias(pdg) * factor );
+
+      MARLEY_LOG_INFO() << "Nuclear de-excitations that emit particles with"
+        << " PDG code " << pdg << " will be sampled with bias factor "
+        << gen.exit_channel_bias( pdg );
+    }
+  }
+}
+
+void marley::JSONConfig::prepare_event_filter( marley::Generator& gen ) const
+{
+  if ( !json_.has_key("event_filter") ) return;
+
+  const auto& f_spec = json_.at( "event_filter" );
+  if ( !f_spec.is_object() ) handle_json_error( "event_filter", f_spec );
+
+  // Each cut is an optional pair of bounds on a quantity computed from the
+  // primary interaction
+  struct Cut {
+    double min = -std::numeric_limits<double>::infinity();
+    double max = std::numeric_limits<double>::infinity();
+    bool active = false;
+  };
+
+  auto get_cut = [this, &f_spec](const std::string& name) -> Cut {
+    Cut cut;
+    for ( bool is_min : { true, false } ) {
+      std::string key = name + ( is_min ? "_min" : "_max" );
+      if ( !f_spec.has_key(key) ) continue;
+      bool ok = false;
+      double value = f_spec.at( key ).to_double( ok );
+      if ( !ok ) handle_json_error( "event_filter." + key, f_spec.at(key) );
+      if ( is_min ) cut.min = value;
+      else cut.max = value;
+      cut.active = true;
+    }
+    if ( cut.min > cut.max ) throw marley::Error( "The lower bound on "
+      + name + " given in the event_filter specification exceeds the upper"
+      " bound" );
+    if ( cut.active ) MARLEY_LOG_INFO() << "Events will be kept only if "
+      << cut.min << " <= " << name << " <= " << cut.max;
+    return cut;
+  };
+
+  Cut ke_cut = get_cut( "ejectile_KE" ); // MeV
+  Cut ex_cut = get_cut( "Ex" ); // MeV
+
+  if ( !ke_cut.active && !ex_cut.active ) {
+    MARLEY_LOG_WARNING() << "The event_filter specification "
+      << f_spec.dump_string() << " does not contain any cuts";
+    return;
+  }
+
+  gen.set_event_filter( [ke_cut, ex_cut](const marley::Event& ev) -> bool
+  {
+    if ( ke_cut.active ) {
+      double KE = ev.ejectile().kinetic_energy();
+      if ( KE < ke_cut.min || KE > ke_cut.max ) return false;
+    }
+    if ( ex_cut.active ) {
+      double Ex = ev.Ex();
+      if ( Ex < ex_cut.min || Ex > ex_cut.max ) return false;
+    }
+    return true;
+  } );
+}
+
 std::string marley::JSONConfig::source_get(const char* name,
   const marley::JSON& source_spec, const char* description,
   const char* default_str) const
@@ -0,0 +1,311 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "marley/Error.hh"
+#include "marley/JSONDocument.hh"
+#include "marley/MappedFile.hh"
+#include "marley/MonotonicArena.hh"
+
+using DataType = marley::JSON::DataType;
+
+// A single value in the tree. Children of arrays and objects form a singly
+// linked list so that values can be appended while parsing without knowing
+// how many there will be.
+struct marley::JSONNode {
+  DataType type = DataType::Null;
+  marley::JSONStringView key;
+  marley::JSONStringView str;
+  union {
+    double float_;
+    long integer_;
+    bool boolean_;
+  };
+  const JSONNode* first = nullptr;
+  JSONNode* last = nullptr;
+  const JSONNode* next = nullptr;
+  size_t count = 0u;
+};
+
+namespace {
+
+  using Node = marley::JSONNode;
+
+  // Builds the nodes of a JSONDocument from the values reported by a
+  // JSONParser
+  class NodeBuilder : public marley::JSONHandler {
+
+    public:
+
+      NodeBuilder(marley::MonotonicArena& arena, const char* begin,
+        const char* end) : arena_( arena ), begin_( begin ), end_( end ) {}
+
+      inline const Node* root() const { return root_; }
+
+      virtual void null_value() override { add_node( DataType::Null ); }
+
+      virtual void boolean_value(bool b) override
+        { add_node( DataType::Boolean )->boolean_ = b; }
+
+      virtual void integer_value(long i) override
+        { add_node( DataType::Integral )->integer_ = i; }
+
+      virtual void floating_value(double d) override
+        { add_node( DataType::Floating )->float_ = d; }
+
+      virtual void string_value(const marley::JSONStringView& str) override
+        { add_node( DataType::String )->str = keep( str ); }
+
+      virtual void start_object() override
+        { stack_.push_back( add_node(DataType::Object) ); }
+
+      virtual void key(const marley::JSONStringView& k) override
+        { key_ = keep( k ); }
+
+      virtual void end_object() override { stack_.pop_back(); }
+
+      virtual void start_array() override
+        { stack_.push_back( add_node(DataType::Array) ); }
+
+      virtual void end_array() override { stack_.pop_back(); }
+
+    private:
+
+      // Creates a new node and links it to its parent (if any)
+      Node* add_node(DataType type) {
+        void* storage = arena_.allocate( sizeof(Node), alignof(Node) );
+        Node* node = new (storage) Node();
+        node->type = type;
+
+        if ( stack_.empty() ) {
+          root_ = node;
+          return node;
+        }
+
+        Node* parent = stack_.back();
+        if ( parent->type == DataType::Object ) node->key = key_;
+        if ( parent->last ) parent->last->next = node;
+        else parent->first = node;
+        parent->last = node;
+        ++parent->count;
+        return node;
+      }
+
+      // Returns a view that remains valid for the lifetime of the document.
+      // Views into the parsed buffer are used as-is, while anything else
+      // (e.g., a string whose escape sequences were replaced by the parser)
+      // is copied into the arena.
+      marley::JSONStringView keep(const marley::JSONStringView& view) {
+        if ( view.data() >= begin_ && view.data() + view.size() <= end_ ) {
+          return view;
+        }
+        char* copy = static_cast<char*>( arena_.allocate(view.size() + 1u,
+          alignof(char)) );
+        if ( view.size() > 0u ) std::memcpy( copy, view.data(), view.size() );
+        copy[ view.size() ] = '\0';
+        return marley::JSONStringView( copy, view.size() );
+      }
+
+      marley::MonotonicArena& arena_;
+      const char* begin_;
+      const char* end_;
+      const Node* root_ = nullptr;
+      std::vector<Node*> stack_;
+      marley::JSONStringView key_;
+  };
+
+}
+
+marley::JSONDocument::JSONDocument()
+  : arena_( std::make_unique<marley::MonotonicArena>() ) {}
+
+marley::JSONDocument::JSONDocument(const char* data, size_t size)
+  : JSONDocument()
+{
+  this->parse( data, size );
+}
+
+marley::JSONDocument::JSONDocument(std::string text) : JSONDocument()
+{
+  // Keep the text on the heap so that moving the document does not
+  // invalidate views into it
+  auto owned = std::make_unique<std::string>( std::move(text) );
+  this->parse( owned->data(), owned->size() );
+  text_ = std::move( owned );
+}
+
+marley::JSONDocument::~JSONDocument() = default;
+
+marley::JSONDocument::JSONDocument(marley::JSONDocument&&) = default;
+
+marley::JSONDocument& marley::JSONDocument::operator=(
+  marley::JSONDocument&&) = default;
+
+marley::JSONDocument marley::JSONDocument::load_file(
+  const std::string& file_name)
+{
+  auto file = std::make_unique<marley::MappedFile>( file_name );
+  marley::JSONDocument doc;
+  doc.parse( file->data(), file->size() );
+  doc.file_ = std::move( file );
+  return doc;
+}
+
+void marley::JSONDocument::clear() {
+  root_ = nullptr;
+  if ( arena_ ) arena_->reset();
+  else arena_ = std::make_unique<marley::MonotonicArena>();
+  text_.reset();
+  file_.reset();
+}
+
+size_t marley::JSONDocument::parse(const char* data, size_t size) {
+  this->clear();
+  NodeBuilder builder( *arena_, data, data + size );
+  size_t consumed = 0u;
+  try {
+    consumed = marley::JSONParser::parse( data, size, builder );
+  }
+  catch ( ... ) {
+    root_ = nullptr;
+    throw;
+  }
+  root_ = builder.root();
+  return consumed;
+}
+
+marley::JSONValue::Iterator& marley::JSONValue::Iterator::operator++()
+{
+  node_ = node_->next;
+  return *this;
+}
+
+DataType marley::JSONValue::type() const {
+  return node_ ? node_->type : DataType::Null;
+}
+
+int marley::JSONValue::length() const {
+  if ( is_array() ) return static_cast<int>( node_->count );
+  return -1;
+}
+
+int marley::JSONValue::size() const {
+  if ( is_array() || is_object() ) return static_cast<int>( node_->count );
+  return -1;
+}
+
+bool marley::JSONValue::has_key(const std::string& key) const {
+  if ( !is_object() ) return false;
+  for ( const Node* n = node_->first; n; n = n->next ) {
+    if ( n->key == key ) return true;
+  }
+  return false;
+}
+
+marley::JSONValue marley::JSONValue::at(
+  const std::string& key) const
+{
+  // Later members take precedence over earlier ones with the same key, just
+  // as they do when a marley::JSON object is parsed
+  const Node* found = nullptr;
+  if ( is_object() ) {
+    for ( const Node* n = node_->first; n; n = n->next ) {
+      if ( n->key == key ) found = n;
+    }
+  }
+  if ( !found ) throw marley::Error("Missing JSON key '" + key + '\'');
+  return JSONValue( found );
+}
+
+marley::JSONValue marley::JSONValue::at(
+  unsigned index) const
+{
+  if ( is_array() && index < node_->count ) {
+    const Node* n = node_->first;
+    for ( unsigned i = 0u; i < index; ++i ) n = n->next;
+    return JSONValue( n );
+  }
+  throw marley::Error("JSON array index " + std::to_string(index)
+    + " is out of range");
+}
+
+marley::JSONStringView marley::JSONValue::key() const {
+  return node_ ? node_->key : marley::JSONStringView();
+}
+
+marley::JSONStringView marley::JSONValue::string_view() const {
+  return is_string() ? node_->str : marley::JSONStringView();
+}
+
+std::string marley::JSONValue::to_string(bool& ok) const {
+  ok = is_string();
+  return ok ? json_escape( node_->str.str() ) : std::string("");
+}
+
+double marley::JSONValue::to_double(bool& ok) const {
+  ok = is_float();
+  if ( ok ) return node_->float_;
+  ok = is_integer();
+  if ( ok ) return node_->integer_;
+  return 0.;
+}
+
+long marley::JSONValue::to_long(bool& ok) const {
+  ok = is_integer();
+  return ok ? node_->integer_ : 0;
+}
+
+bool marley::JSONValue::to_bool(bool& ok) const {
+  ok = is_bool();
+  return ok ? node_->boolean_ : false;
+}
+
+marley::JSONValue::Range marley::JSONValue::array_range() const
+{
+  return Range( is_array() ? node_->first : nullptr );
+}
+
+marley::JSONValue::Range marley::JSONValue::object_range() const
+{
+  return Range( is_object() ? node_->first : nullptr );
+}
+
+marley::JSON marley::JSONValue::to_json() const {
+  switch ( type() ) {
+    case DataType::Object: {
+      marley::JSON object = marley::JSON::object();
+      for ( const Node* n = node_->first; n; n = n->next ) {
+        object[ n->key.str() ] = JSONValue( n ).to_json();
+      }
+      return object;
+    }
+    case DataType::Array: {
+      marley::JSON array = marley::JSON::array();
+      for ( const Node* n = node_->first; n; n = n->next ) {
+        array.append( JSONValue(n).to_json() );
+      }
+      return array;
+    }
+    case DataType::String: return marley::JSON( node_->str.str() );
+    case DataType::Floating: return marley::JSON( node_->float_ );
+    case DataType::Integral: return marley::JSON( node_->integer_ );
+    case DataType::Boolean: return marley::JSON( node_->boolean_ );
+    default: return marley::JSON();
+  }
+}
@@ -0,0 +1,401 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "marley/Error.hh"
+#include "marley/JSONParser.hh"
+
+namespace {
+
+  constexpr int END = std::char_traits<char>::eof();
+
+  // Maximum number of characters allowed in the text of a single number
+  constexpr size_t MAX_NUMBER_LENGTH = 128u;
+
+  // Reads characters from a contiguous block of memory
+  class MemorySource {
+
+    public:
+
+      MemorySource(const char* data, size_t size) : begin_( data ),
+        pos_( data ), end_( data + size ) {}
+
+      inline int peek() const
+        { return pos_ < end_ ? static_cast<unsigned char>( *pos_ ) : END; }
+
+      inline int get() {
+        return pos_ < end_ ? static_cast<unsigned char>( *pos_++ ) : END;
+      }
+
+      inline void unget() { --pos_; }
+
+      inline void skip_line() {
+        while ( pos_ < end_ && *pos_++ != '\n' ) continue;
+      }
+
+      // Reads the rest of a string directly from the buffer if it does not
+      // contain any escape sequences. Returns false (without consuming
+      // anything) otherwise.
+      inline bool read_plain_string(marley::JSONStringView& view) {
+        for ( const char* p = pos_; p < end_; ++p ) {
+          if ( *p == '\"' ) {
+            view = marley::JSONStringView( pos_, p - pos_ );
+            pos_ = p + 1;
+            return true;
+          }
+          else if ( *p == '\\' ) return false;
+        }
+        return false;
+      }
+
+      inline size_t consumed() const { return pos_ - begin_; }
+
+    private:
+
+      const char* begin_;
+      const char* pos_;
+      const char* end_;
+  };
+
+  // Reads characters from an input stream
+  class StreamSource {
+
+    public:
+
+      explicit StreamSource(std::istream& in) : in_( in ) {}
+
+      inline int peek() { return in_.peek(); }
+      inline int get() { return in_.get(); }
+      inline void unget() { in_.unget(); }
+
+      inline void skip_line() {
+        in_.ignore( std::numeric_limits<std::streamsize>::max(), '\n' );
+      }
+
+      // Stream contents are not retained, so strings are always copied
+      inline bool read_plain_string(marley::JSONStringView&) { return false; }
+
+    private:
+
+      std::istream& in_;
+  };
+
+  [[noreturn]] void issue_parse_error(int found, const std::string& message)
+  {
+    std::string msg( message );
+    if ( found == END ) msg += "end-of-file";
+    else msg += std::string("\'") + static_cast<char>( found ) + '\'';
+    throw marley::Error( msg );
+  }
+
+  // Recursive descent parser that reports its results to a JSONHandler
+  template <class Source> class Parser {
+
+    public:
+
+      Parser(Source& source, marley::JSONHandler& handler)
+        : source_( source ), handler_( handler ) {}
+
+      void parse_value() {
+        int c = next_char();
+        switch ( c ) {
+          case '{' : parse_object(); return;
+          case '[' : parse_array(); return;
+          case '\"': handler_.string_value( parse_string() ); return;
+          case 't' :
+          case 'f' : parse_bool( c ); return;
+          case 'n' : parse_null(); return;
+          default:
+            if ( (c >= '0' && c <= '9') || c == '-' ) {
+              parse_number( c );
+              return;
+            }
+        }
+        if ( c == END ) throw marley::Error("Unexpected end of JSON"
+          " configuration file found");
+        throw marley::Error(std::string("JSON parse: Unknown starting")
+          + " character '" + static_cast<char>( c ) + '\'');
+      }
+
+    private:
+
+      // Skips whitespace and comments, consuming and returning the first
+      // other character. Comments are technically not valid in JSON (the
+      // standard doesn't allow them), but they are valid in Javascript
+      // object literals.
+      int next_char() {
+        for (;;) {
+          int c = source_.get();
+          if ( c == END ) return c;
+          if ( std::isspace(c) ) continue;
+          if ( c == '/' ) {
+            int n = source_.peek();
+            if ( n == '/' ) {
+              source_.skip_line();
+              continue;
+            }
+            else if ( n == '*' ) {
+              source_.get();
+              while ( (c = source_.get()) != END ) {
+                if ( c == '*' && source_.peek() == '/' ) {
+                  source_.get();
+                  break;
+                }
+              }
+              continue;
+            }
+          }
+          return c;
+        }
+      }
+
+      void parse_object() {
+        handler_.start_object();
+        for (;;) {
+          int c = next_char();
+          if ( c == '}' ) break;
+          else if ( c == '\"' ) handler_.key( parse_string() );
+          else if ( c == END ) issue_parse_error( c, "JSON object: Expected"
+            " key, found " );
+          // The key isn't quoted, so assume it's a single word followed
+          // by a colon. Note that vanilla JSON requires all keys to be quoted,
+          // but Javascript object literals allow unquoted keys.
+          else {
+            scratch_.assign( 1, static_cast<char>(c) );
+            while ( (c = source_.peek()) != END && c != ':'
+              && !std::isspace(c) )
+            {
+              scratch_ += static_cast<char>( source_.get() );
+            }
+            handler_.key( marley::JSONStringView(scratch_.data(),
+              scratch_.size()) );
+          }
+
+          c = next_char();
+          if ( c != ':' ) issue_parse_error( c, "JSON object: Expected colon,"
+            " found " );
+
+          parse_value();
+
+          c = next_char();
+          if ( c == ',' ) continue;
+          else if ( c == '}' ) break;
+          else issue_parse_error( c, "JSON object: Expected comma, found " );
+        }
+        handler_.end_object();
+      }
+
+      void parse_array() {
+        handler_.start_array();
+        for (;;) {
+          int c = next_char();
+          if ( c == ']' ) break;
+          else if ( c != END ) source_.unget();
+
+          parse_value();
+
+          c = next_char();
+          if ( c == ',' ) continue;
+          else if ( c == ']' ) break;
+          else issue_parse_error( c, "JSON array: Expected ',' or ']'"
+            ", found " );
+        }
+        handler_.end_array();
+      }
+
+      // Parses the remainder of a string whose opening quote has already
+      // been consumed
+      marley::JSONStringView parse_string() {
+
+        marley::JSONStringView view;
+        if ( source_.read_plain_string(view) ) return view;
+
+        scratch_.clear();
+        for (;;) {
+          int c = source_.get();
+          if ( c == END ) issue_parse_error( c, "JSON string: Expected '\"',"
+            " found " );
+          else if ( c == '\"' ) break;
+          else if ( c != '\\' ) {
+            scratch_ += static_cast<char>( c );
+            continue;
+          }
+
+          c = source_.get();
+          switch ( c ) {
+            case '\"': scratch_ += '\"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/' : scratch_ += '/' ; break;
+            case 'b' : scratch_ += '\b'; break;
+            case 'f' : scratch_ += '\f'; break;
+            case 'n' : scratch_ += '\n'; break;
+            case 'r' : scratch_ += '\r'; break;
+            case 't' : scratch_ += '\t'; break;
+            // Unicode escapes are kept as-is
+            case 'u' : {
+              scratch_ += "\\u";
+              for ( unsigned i = 1; i <= 4; ++i ) {
+                c = source_.get();
+                if ( std::isxdigit(c) ) scratch_ += static_cast<char>( c );
+                else issue_parse_error( c, "JSON string: Expected hex"
+                  " character in unicode escape, found " );
+              }
+              break;
+            }
+            case END:
+              issue_parse_error( c, "JSON string: Expected '\"', found " );
+            default:
+              scratch_ += '\\';
+              scratch_ += static_cast<char>( c );
+          }
+        }
+
+        return marley::JSONStringView( scratch_.data(), scratch_.size() );
+      }
+
+      void parse_number(int first) {
+
+        char buffer[ MAX_NUMBER_LENGTH + 1 ];
+        size_t length = 0u;
+        auto append = [&buffer, &length](int ch) -> void {
+          if ( length >= MAX_NUMBER_LENGTH ) throw marley::Error("JSON"
+            " number: too many characters");
+          buffer[ length++ ] = static_cast<char>( ch );
+        };
+
+        // Numbers with a decimal point or an exponent are floating-point
+        bool is_double = false;
+        append( first );
+
+        int c;
+        while ( c = source_.peek(), (c >= '0' && c <= '9') || c == '.'
+          || c == '-' )
+        {
+          if ( c == '.' ) is_double = true;
+          append( source_.get() );
+        }
+
+        if ( c == 'e' || c == 'E' ) {
+          is_double = true;
+          append( source_.get() );
+          c = source_.peek();
+          if ( c == '+' || c == '-' ) append( source_.get() );
+          bool found_digit = false;
+          while ( c = source_.peek(), c >= '0' && c <= '9' ) {
+            append( source_.get() );
+            found_digit = true;
+          }
+          if ( !found_digit ) issue_parse_error( c, "JSON number: Expected"
+            " a number for exponent, found " );
+        }
+
+        if ( c != END && !std::isspace(c) && c != ',' && c != ']'
+          && c != '}' && c != '/' )
+        {
+          issue_parse_error( c, "JSON number: unexpected character " );
+        }
+
+        buffer[ length ] = '\0';
+        char* end = nullptr;
+        errno = 0;
+
+        // Convert the complete decimal string at once so that the result is
+        // correctly rounded. Unlike std::stod(), std::strtod() does not throw
+        // for subnormal values.
+        if ( is_double ) {
+          double d = std::strtod( buffer, &end );
+          if ( end == buffer + length ) {
+            handler_.floating_value( d );
+            return;
+          }
+        }
+        else {
+          long i = std::strtol( buffer, &end, 10 );
+          if ( end == buffer + length && errno != ERANGE ) {
+            handler_.integer_value( i );
+            return;
+          }
+        }
+
+        throw marley::Error("JSON number: invalid value '"
+          + std::string(buffer) + '\'');
+      }
+
+      void parse_bool(int first) {
+        const std::string word = ( first == 't' ) ? "true" : "false";
+        std::string s( 1, static_cast<char>(first) );
+        for ( size_t i = 1u; i < word.size(); ++i ) {
+          int c = source_.get();
+          if ( c == END ) break;
+          s += static_cast<char>( c );
+        }
+
+        if ( s == word ) {
+          handler_.boolean_value( first == 't' );
+          return;
+        }
+
+        // Get the entire string if the user supplied an invalid value
+        int c;
+        while ( (c = source_.peek()) != END && !std::isspace(c) ) {
+          s += static_cast<char>( source_.get() );
+        }
+        throw marley::Error("JSON bool: Expected 'true' or 'false', found '"
+          + s + '\'');
+      }
+
+      void parse_null() {
+        std::string s( 1, 'n' );
+        for ( size_t i = 0u; i < 3u; ++i ) {
+          int c = source_.get();
+          if ( c == END ) break;
+          s += static_cast<char>( c );
+        }
+        if ( s != "null" ) throw marley::Error("JSON null: Expected 'null',"
+          " found '" + s + '\'');
+        handler_.null_value();
+      }
+
+      Source& source_;
+      marley::JSONHandler& handler_;
+
+      // Storage for strings and keys that cannot be viewed directly in the
+      // input
+      std::string scratch_;
+  };
+
+}
+
+size_t marley::JSONParser::parse(const char* data, size_t size,
+  marley::JSONHandler& handler)
+{
+  MemorySource source( data, size );
+  Parser<MemorySource> parser( source, handler );
+  parser.parse_value();
+  return source.consumed();
+}
+
+void marley::JSONParser::parse(std::istream& in, marley::JSONHandler& handler)
+{
+  StreamSource source( in );
+  Parser<StreamSource> parser( source, handler );
+  parser.parse_value();
+}
@@ -0,0 +1,149 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include "marley/JSONWriter.hh"
+#include "marley/marley_utils.hh"
+
+marley::JSONWriter::JSONWriter(std::string& out, int indent_step,
+  unsigned current_indent) : out_( out ), pretty_( indent_step >= 0 ),
+  indent_step_( pretty_ ? static_cast<unsigned>(indent_step) : 0u ),
+  indent_( current_indent )
+{
+}
+
+void marley::JSONWriter::indent() {
+  out_.append( indent_, ' ' );
+}
+
+void marley::JSONWriter::begin_value() {
+  // Values that follow a key have already been positioned by key()
+  if ( after_key_ ) {
+    after_key_ = false;
+    return;
+  }
+
+  // Elements of an array are separated by commas (and, when
+  // pretty-printing, newlines) and indented
+  if ( !first_element_.empty() ) {
+    if ( !first_element_.back() ) {
+      out_ += ',';
+      if ( pretty_ ) out_ += '\n';
+    }
+    first_element_.back() = false;
+    this->indent();
+  }
+}
+
+void marley::JSONWriter::begin_object() {
+  this->begin_value();
+  out_ += '{';
+  if ( pretty_ ) {
+    indent_ += indent_step_;
+    out_ += '\n';
+  }
+  first_element_.push_back( true );
+}
+
+void marley::JSONWriter::end_object() {
+  first_element_.pop_back();
+  if ( pretty_ ) {
+    indent_ -= indent_step_;
+    out_ += '\n';
+  }
+  this->indent();
+  out_ += '}';
+}
+
+void marley::JSONWriter::begin_array() {
+  this->begin_value();
+  out_ += '[';
+  if ( pretty_ ) {
+    indent_ += indent_step_;
+    out_ += '\n';
+  }
+  first_element_.push_back( true );
+}
+
+void marley::JSONWriter::end_array() {
+  first_element_.pop_back();
+  if ( pretty_ ) {
+    indent_ -= indent_step_;
+    out_ += '\n';
+  }
+  this->indent();
+  out_ += ']';
+}
+
+void marley::JSONWriter::key(const char* k) {
+  if ( !first_element_.back() ) {
+    out_ += ',';
+    if ( pretty_ ) out_ += '\n';
+  }
+  first_element_.back() = false;
+
+  this->indent();
+  out_ += '\"';
+  this->append_escaped( k );
+  out_ += '\"';
+
+  if ( pretty_ ) out_ += " : ";
+  else out_ += ':';
+
+  after_key_ = true;
+}
+
+void marley::JSONWriter::value(double x) {
+  this->begin_value();
+  char buffer[ marley_utils::SHORTEST_DOUBLE_BUFFER_SIZE ];
+  size_t length = marley_utils::format_shortest_double( x, buffer );
+  out_.append( buffer, length );
+}
+
+void marley::JSONWriter::value(long i) {
+  this->begin_value();
+  out_ += std::to_string( i );
+}
+
+void marley::JSONWriter::value(bool b) {
+  this->begin_value();
+  out_ += ( b ? "true" : "false" );
+}
+
+void marley::JSONWriter::value(const std::string& s) {
+  this->value( s.c_str() );
+}
+
+void marley::JSONWriter::value(const char* s) {
+  this->begin_value();
+  out_ += '\"';
+  this->append_escaped( s );
+  out_ += '\"';
+}
+
+void marley::JSONWriter::append_escaped(const char* s) {
+  for ( ; *s != '\0'; ++s ) {
+    switch ( *s ) {
+      case '\"': out_ += "\\\""; break;
+      case '\\': out_ += "\\\\"; break;
+      case '\b': out_ += "\\b";  break;
+      case '\f': out_ += "\\f";  break;
+      case '\n': out_ += "\\n";  break;
+      case '\r': out_ += "\\r";  break;
+      case '\t': out_ += "\\t";  break;
+      default  : out_ += *s; break;
+    }
+  }
+}
@@ -14,10 +14,17 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <algorithm>
+#include <limits>
+
 #include "marley/marley_utils.hh"
+#include "marley/Error.hh"
 #include "marley/HauserFeshbachDecay.hh"
+#include "marley/Instrumentation.hh"
 #include "marley/Logger.hh"
 #include "marley/KoningDelarocheOpticalModel.hh"
+#include "marley/Tracing.hh"
 
 #include "marley/coulomb_wavefunctions.hh"
 
@@ -41,7 +48,8 @@ marley::KoningDelarocheOpticalModel::optical_model_potential(double r,
     + 2.*target_mass_*fragment_KE_lab) - m_fragment - target_mass_);
 
   calculate_kinematic_variables( KE_tot_CM, fragment_pdg );
-  calculate_om_parameters(fragment_pdg, two_j, l, two_s);
+  calculate_om_parameters( fragment_pdg, two_s );
+  spin_orbit_eigenvalue = compute_spin_orbit_eigenvalue( two_j, l, two_s );
   return omp(r);
 }
 
@@ -75,27 +83,31 @@ marley::KoningDelarocheOpticalModel::omp_minus_Vc(double r) const
 
 // Compute all of the pieces of the optical model that depend on the fragment's
 // kinetic energy in the lab frame fragment_KE_lab but not on its distance from
-// the origin r. Store them in the appropriate class members.
+// the origin r or on the partial wave. Store them in the appropriate class
+// members. The spin-orbit eigenvalue is handled separately by the callers.
 void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
-  int fragment_pdg, int two_j, int l, int two_s)
+  int fragment_pdg, int two_s)
 {
+  // Abbreviate the variable name here for simplicity
+  const double E = fragment_KE_lab_;
+  bool spin_zero = two_s == 0;
+
+  // The stored parameters are still valid if the last call used the same
+  // fragment and energy. This is the usual case when the partial waves are
+  // visited one at a time.
+  if ( om_cache_valid_ && om_cache_pdg_ == fragment_pdg
+    && om_cache_KE_lab_ == E && om_cache_spin_zero_ == spin_zero ) return;
+
+  om_cache_valid_ = true;
+  om_cache_pdg_ = fragment_pdg;
+  om_cache_KE_lab_ = E;
+  om_cache_spin_zero_ = spin_zero;
+
   // Fragment atomic, mass, and neutron numbers
   z = marley_utils::get_particle_Z(fragment_pdg);
   int a = marley_utils::get_particle_A(fragment_pdg);
   int n = a - z;
 
-  // Abbreviate the variable name here for simplicity
-  const double E = fragment_KE_lab_;
-
-  // Eigenvalue of the spin-orbit operator
-  // 2*(l.s) = j*(j + 1)  - l*(l + 1) -  s*(s + 1)
-  // = 0.25*((2j - 2s)*(2j + 2s + 2)) - l*(l+1)
-  // (to keep the units right we take hbar = 1).
-  bool spin_zero = two_s == 0;
-  if (spin_zero) spin_orbit_eigenvalue = 0;
-  else spin_orbit_eigenvalue = 0.25*((two_j - two_s)
-    * (two_j + two_s + 2)) - l*(l + 1);
-
 
   // Geometrical parameters
   Rv = 0;
@@ -192,7 +204,9 @@ void marley::KoningDelarocheOpticalModel::calculate_om_parameters(
 }
 
 marley::KoningDelarocheOpticalModel::KoningDelarocheOpticalModel(int Z,
-  int A, double step_size) : marley::OpticalModel(Z, A), step_size_(step_size)
+  int A, double step_size, double matching_threshold)
+  : marley::OpticalModel(Z, A), step_size_(step_size),
+  matching_threshold_(matching_threshold)
 {
   const auto& mt = marley::MassTable::Instance();
   target_mass_ = mt.get_atomic_mass(Z, A);
@@ -253,6 +267,21 @@ marley::KoningDelarocheOpticalModel::KoningDelarocheOpticalModel(int Z,
 
 }
 
+size_t marley::KoningDelarocheOpticalModel::memory_usage() const {
+  using marley_utils::vector_bytes;
+  size_t bytes = coulomb_cache_.memory_usage();
+  for ( const auto& pair : radial_grids_ ) {
+    const RadialGrid& grid = pair.second;
+    bytes += sizeof( pair ) + vector_bytes( grid.r ) + vector_bytes( grid.f_v )
+      + vector_bytes( grid.dfdr_d ) + vector_bytes( grid.so_shape )
+      + vector_bytes( grid.Vc );
+  }
+  for ( const auto& pair : transmission_tables_ ) {
+    bytes += sizeof( pair ) + vector_bytes( pair.second );
+  }
+  return bytes;
+}
+
 double marley::KoningDelarocheOpticalModel::total_cross_section(
   double fragment_KE_lab, int fragment_pdg, int two_s, size_t l_max,
   int target_charge)
@@ -273,15 +302,15 @@ double marley::KoningDelarocheOpticalModel::total_cross_section(
 
   calculate_kinematic_variables( KE_tot_CM, fragment_pdg );
 
+  marley::ScratchVector<std::pair<int, int> > waves;
+  partial_waves( two_s, static_cast<int>(l_max), waves );
+  marley::ScratchVector<std::complex<double> > Ss;
+  s_matrix_elements( fragment_pdg, two_s, waves, Ss );
+
   double sum = 0.;
-  for (size_t l = 0; l <= l_max; ++l) {
-    int two_l = 2*l;
-    for (int two_j = std::abs(two_l - two_s);
-      two_j <= two_l + two_s; two_j += 2)
-    {
-      std::complex<double> S = s_matrix_element(fragment_pdg, two_j, l, two_s);
-      sum += (two_j + 1) * (1 - S.real());
-    }
+  for (size_t w = 0; w < waves.size(); ++w) {
+    int two_j = waves[w].second;
+    sum += (two_j + 1) * (1 - Ss[w].real());
   }
 
   // Compute the cross section in natural units (MeV^(-2))
@@ -294,10 +323,259 @@ double marley::KoningDelarocheOpticalModel::transmission_coefficient(
   int target_charge)
 {
   if ( total_KE_CM <= 0. ) return 0.;
+  if ( transmission_mode_ == TransmissionMode::Table ) {
+    return tabulated_transmission_coefficient( total_KE_CM, fragment_pdg,
+      two_j, l, two_s, target_charge );
+  }
+  return exact_transmission_coefficient( total_KE_CM, fragment_pdg, two_j,
+    l, two_s, target_charge );
+}
+
+void marley::KoningDelarocheOpticalModel::set_table_energy_step(double step)
+{
+  if ( !(step > 0.) ) throw marley::Error( "Invalid transmission"
+    " coefficient table energy step " + std::to_string(step) + " MeV passed"
+    " to marley::KoningDelarocheOpticalModel::set_table_energy_step()" );
+  table_energy_step_ = step;
+  transmission_tables_.clear();
+}
+
+void marley::KoningDelarocheOpticalModel::write_tables(std::ostream& out)
+  const
+{
+  marley_utils::write_binary( out, step_size_ );
+  marley_utils::write_binary( out, matching_threshold_ );
+  marley_utils::write_binary( out, table_energy_step_ );
+  marley_utils::write_binary( out,
+    static_cast<uint64_t>(transmission_tables_.size()) );
+
+  for ( const auto& pair : transmission_tables_ ) {
+    const TableKey& key = pair.first;
+    marley_utils::write_binary( out, std::get<0>(key) );
+    marley_utils::write_binary( out, std::get<1>(key) );
+    marley_utils::write_binary( out, std::get<2>(key) );
+    marley_utils::write_binary( out, std::get<3>(key) );
+    marley_utils::write_binary( out, std::get<4>(key) );
+    marley_utils::write_binary( out, pair.second );
+  }
+}
+
+bool marley::KoningDelarocheOpticalModel::read_tables(std::istream& in)
+{
+  double step_size, matching_threshold, table_energy_step;
+  uint64_t num_tables;
+  if ( !marley_utils::read_binary(in, step_size)
+    || !marley_utils::read_binary(in, matching_threshold)
+    || !marley_utils::read_binary(in, table_energy_step)
+    || !marley_utils::read_binary(in, num_tables) ) return false;
+
+  // Tables computed on a different grid (or with different numerical
+  // settings) cannot be reused
+  if ( step_size != step_size_ || matching_threshold != matching_threshold_
+    || table_energy_step != table_energy_step_ ) return false;
+
+  // Read everything before changing the current tables so that a truncated
+  // stream leaves them untouched
+  std::map<TableKey, std::vector<double> > tables;
+  for ( uint64_t t = 0u; t < num_tables; ++t ) {
+    int pdg, two_j, l, two_s, charge;
+    std::vector<double> table;
+    if ( !marley_utils::read_binary(in, pdg)
+      || !marley_utils::read_binary(in, two_j)
+      || !marley_utils::read_binary(in, l)
+      || !marley_utils::read_binary(in, two_s)
+      || !marley_utils::read_binary(in, charge)
+      || !marley_utils::read_binary(in, table) ) return false;
+    tables[ TableKey(pdg, two_j, l, two_s, charge) ] = std::move( table );
+  }
+
+  // Fill in any grid points that have not been computed yet
+  for ( auto& pair : tables ) {
+    auto& table = transmission_tables_[ pair.first ];
+    const auto& loaded = pair.second;
+    if ( table.size() < loaded.size() ) table.resize( loaded.size(),
+      std::numeric_limits<double>::quiet_NaN() );
+    for ( size_t n = 0u; n < loaded.size(); ++n ) {
+      if ( std::isnan(table[n]) ) table[n] = loaded[n];
+    }
+  }
+
+  return true;
+}
+
+void marley::KoningDelarocheOpticalModel::tabulate(int fragment_pdg,
+  int two_s, int l_max, double max_KE_CM, int target_charge)
+{
+  if ( !(max_KE_CM > 0.) ) return;
+
+  marley::ScratchVector<std::pair<int, int> > waves;
+  partial_waves( two_s, l_max, waves );
+
+  // Interpolating on the interval [k, k + 1] uses the nodes k - 1 through
+  // k + 2
+  size_t n_max = static_cast<size_t>( max_KE_CM / table_energy_step_ ) + 2u;
+
+  std::vector<std::vector<double>*> tables;
+  for ( const auto& wave : waves ) {
+    auto& table = transmission_tables_[ TableKey(fragment_pdg, wave.second,
+      wave.first, two_s, target_charge) ];
+    if ( table.size() <= n_max ) table.resize( n_max + 1u,
+      std::numeric_limits<double>::quiet_NaN() );
+    tables.push_back( &table );
+  }
+
+  update_target_mass( target_charge );
+
+  marley::ScratchVector<std::complex<double> > Ss;
+  for ( size_t n = 1u; n <= n_max; ++n ) {
+
+    bool missing = false;
+    for ( const auto* table : tables ) {
+      if ( std::isnan((*table)[n]) ) { missing = true; break; }
+    }
+    if ( !missing ) continue;
+
+    calculate_kinematic_variables( n * table_energy_step_, fragment_pdg );
+    s_matrix_elements( fragment_pdg, two_s, waves, Ss );
+
+    for ( size_t w = 0u; w < waves.size(); ++w ) {
+      double& T = (*tables[ w ])[ n ];
+      if ( std::isnan(T) ) T = transmission_coefficient_from_s( Ss[w] );
+    }
+  }
+}
+
+double marley::KoningDelarocheOpticalModel::tabulated_transmission_coefficient(
+  double total_KE_CM, int fragment_pdg, int two_j, int l, int two_s,
+  int target_charge)
+{
+  auto& table = transmission_tables_[ TableKey(fragment_pdg, two_j, l, two_s,
+    target_charge) ];
+
+  // Find the grid interval containing the requested energy. Node k lies
+  // at total_KE_CM = k * table_energy_step_.
+  double x = total_KE_CM / table_energy_step_;
+  size_t k = static_cast<size_t>( x );
+  double t = x - k;
+
+  // Near threshold, the transmission coefficients rise like a power of the
+  // energy (neutrons) or exponentially (charged fragments), which is poorly
+  // described by a cubic. Skip the table on the first grid interval.
+  if ( k == 0u ) return exact_transmission_coefficient( total_KE_CM,
+    fragment_pdg, two_j, l, two_s, target_charge );
+
+  // Retrieves the value at node n, computing it first if needed. The
+  // transmission coefficient vanishes at zero energy.
+  auto node = [&](size_t n) -> double {
+    if ( n == 0u ) return 0.;
+    if ( table.size() <= n ) table.resize( n + 1u,
+      std::numeric_limits<double>::quiet_NaN() );
+    double& T = table[ n ];
+    if ( std::isnan(T) ) T = exact_transmission_coefficient(
+      n * table_energy_step_, fragment_pdg, two_j, l, two_s, target_charge );
+    return T;
+  };
+
+  double T0 = node( k );
+  if ( t == 0. ) return T0;
+  double T1 = node( k + 1u );
+
+  // Secants (per grid step) for the interval of interest and its neighbors
+  double d = T1 - T0;
+  double d_left = T0 - node( k - 1u );
+  double d_right = node( k + 2u ) - T1;
+
+  // Fritsch-Carlson node slopes for a uniform grid: zero at local extrema,
+  // otherwise the harmonic mean of the adjacent secants
+  auto slope = [](double s1, double s2) -> double {
+    if ( s1*s2 <= 0. ) return 0.;
+    return 2. * s1 * s2 / ( s1 + s2 );
+  };
+  double m0 = slope( d_left, d );
+  double m1 = slope( d, d_right );
+
+  // Cubic Hermite interpolation on the unit interval
+  double t2 = t * t;
+  double t3 = t2 * t;
+  double T = (2.*t3 - 3.*t2 + 1.)*T0 + (t3 - 2.*t2 + t)*m0
+    + (-2.*t3 + 3.*t2)*T1 + (t3 - t2)*m1;
+
+  return std::min( 1., std::max( 0., T ) );
+}
+
+double marley::KoningDelarocheOpticalModel::exact_transmission_coefficient(
+  double total_KE_CM, int fragment_pdg, int two_j, int l, int two_s,
+  int target_charge)
+{
   update_target_mass( target_charge );
   calculate_kinematic_variables( total_KE_CM, fragment_pdg );
   std::complex<double> S = s_matrix_element(fragment_pdg, two_j, l, two_s);
+  return transmission_coefficient_from_s( S );
+}
+
+void marley::KoningDelarocheOpticalModel::transmission_coefficients(
+  double total_KE_CM, int fragment_pdg, int two_s, int l_max,
+  marley::ScratchVector<double>& Tljs, int target_charge)
+{
+  // The tables are filled one partial wave at a time, so there is nothing to
+  // gain from the batched calculation
+  if ( total_KE_CM <= 0. || transmission_mode_ == TransmissionMode::Table ) {
+    marley::OpticalModel::transmission_coefficients( total_KE_CM,
+      fragment_pdg, two_s, l_max, Tljs, target_charge );
+    return;
+  }
+
+  update_target_mass( target_charge );
+  calculate_kinematic_variables( total_KE_CM, fragment_pdg );
+
+  // Draw the temporary storage from the same arena (if any) as the output
+  marley::ScratchVector<std::pair<int, int> > waves( Tljs.get_allocator() );
+  partial_waves( two_s, l_max, waves );
+  marley::ScratchVector<std::complex<double> > Ss( Tljs.get_allocator() );
+  s_matrix_elements( fragment_pdg, two_s, waves, Ss );
+
+  Tljs.clear();
+  for ( const auto& S : Ss ) Tljs.push_back( transmission_coefficient_from_s(S) );
+}
+
+void marley::KoningDelarocheOpticalModel::
+  partial_wave_transmission_coefficients(double total_KE_CM, int fragment_pdg,
+  int two_s, const marley::ScratchVector<std::pair<int, int> >& waves,
+  marley::ScratchVector<double>& Tljs, int target_charge)
+{
+  if ( total_KE_CM <= 0. || transmission_mode_ == TransmissionMode::Table ) {
+    marley::OpticalModel::partial_wave_transmission_coefficients( total_KE_CM,
+      fragment_pdg, two_s, waves, Tljs, target_charge );
+    return;
+  }
+
+  update_target_mass( target_charge );
+  calculate_kinematic_variables( total_KE_CM, fragment_pdg );
+
+  marley::ScratchVector<std::complex<double> > Ss( Tljs.get_allocator() );
+  s_matrix_elements( fragment_pdg, two_s, waves, Ss );
+
+  Tljs.clear();
+  for ( const auto& S : Ss ) Tljs.push_back( transmission_coefficient_from_s(S) );
+}
 
+void marley::KoningDelarocheOpticalModel::partial_waves(int two_s,
+  int l_max, marley::ScratchVector<std::pair<int, int> >& waves)
+{
+  waves.clear();
+  for (int l = 0; l <= l_max; ++l) {
+    int two_l = 2*l;
+    for (int two_j = std::abs(two_l - two_s);
+      two_j <= two_l + two_s; two_j += 2)
+    {
+      waves.emplace_back( l, two_j );
+    }
+  }
+}
+
+double marley::KoningDelarocheOpticalModel::transmission_coefficient_from_s(
+  const std::complex<double>& S)
+{
   // Guard against ±inf or NaN values that can occur in edge cases when the
   // Coulomb wavefunctions get huge, e.g., for low-energy alpha emission.
   // Numerical precision problems can lead to wrong answers, such as S == (inf,
@@ -325,83 +603,158 @@ std::complex<double>
 marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
   int two_j, int l, int two_s)
 {
-  // Update the optical model parameters stored in this object for the
-  // given fragment, energy, and angular momenta
-  calculate_om_parameters(fragment_pdg, two_j, l, two_s);
-
-  double step_size2_over_twelve = std::pow(step_size_, 2) / 12.0;
-
-  std::complex<double> u1 = 0, u2 = 0;
-
-  std::complex<double> a_n_minus_two;
-
-  // a(r) really blows up at the origin for the optical model potential, but
-  // we're saved by the boundary condition that u(0) = 0. We just need
-  // something finite here, but we might as well make it zero.
-  std::complex<double> a_n_minus_one = 0;
-  std::complex<double> a_n = a(step_size_, l);
-
-  std::complex<double> u_n_minus_two;
-  // Boundary condition that the wavefunction vanishes at the origin (the
-  // optical model potential blows up at r = 0)
-  std::complex<double> u_n_minus_one = 0;
-
-  // Asymptotic approximation for a regular potential (see J. Thijssen,
-  // Computational Physics, p. 20 for details). We really just need something
-  // finite and nonzero here, since our specific choice only determines the
-  // overall normalization, which isn't important for determining the
-  // transmission coefficients.
-  std::complex<double> u_n = std::pow(step_size_, l + 1);
+  marley::ScratchVector<std::complex<double> > Ss;
+  s_matrix_elements( fragment_pdg, two_s, { {l, two_j} }, Ss );
+  return Ss.front();
+}
 
-  // Optical model potential with and without the Coulomb potential included
-  std::complex<double> U, U_minus_Vc;
+void marley::KoningDelarocheOpticalModel::s_matrix_elements(int fragment_pdg,
+  int two_s, const marley::ScratchVector<std::pair<int, int> >& waves,
+  marley::ScratchVector<std::complex<double> >& Ss)
+{
+  marley::Instrumentation::ScopedTimer timer(
+    marley::Instrumentation::Probe::SMatrixElement );
+  MARLEY_TRACE_ZONE( trace_zone, "Numerov solve" );
+  marley::Instrumentation::add_value(
+    marley::Instrumentation::Probe::SMatrixElement, waves.size() );
+  Ss.clear();
+  if ( waves.empty() ) return;
 
-  double r = step_size_;
-  do {
-    r += step_size_;
-    a_n_minus_two = a_n_minus_one;
-    a_n_minus_one = a_n;
+  // Update the optical model parameters stored in this object for the
+  // given fragment and energy. Of the partial wave quantum numbers, only
+  // the spin-orbit eigenvalue is needed, and it is computed separately for
+  // each wave below.
+  calculate_om_parameters( fragment_pdg, two_s );
 
-    U_minus_Vc = omp_minus_Vc(r),
-    U = U_minus_Vc + Vc(r, Rc, z, Z_);
-    a_n = a(r, l, U);
+  // Radial shapes of the potential for this fragment, tabulated at the
+  // Numerov integration points
+  RadialGrid& grid = radial_grids_[ fragment_pdg ];
+  if ( grid.r.empty() ) extend_radial_grid( grid, 1u );
 
-    u_n_minus_two = u_n_minus_one;
-    u_n_minus_one = u_n;
+  double step_size2_over_twelve = std::pow(step_size_, 2) / 12.0;
 
-    u_n = ((2.0 - 10*step_size2_over_twelve*a_n_minus_one)*u_n_minus_one
-      - (1.0 + step_size2_over_twelve*a_n_minus_two)*u_n_minus_two)
-      / (1.0 + step_size2_over_twelve*a_n);
+  // Integration state for each of the partial waves
+  struct NumerovState {
+    int l;
+    double spin_orbit_eigenvalue;
+    std::complex<double> a_n_minus_two, a_n_minus_one, a_n;
+    std::complex<double> u_n_minus_two, u_n_minus_one, u_n;
+    double r_match_1 = 0., r_match_2 = 0., r_max = 0.;
+    std::complex<double> u1 = 0, u2 = 0;
+    bool reached_r_match_1 = false;
+    bool done = false;
+  };
+
+  // Nuclear part of the optical model potential at grid point n, split into
+  // the central piece (shared by every partial wave) and the spin-orbit
+  // piece for a wave with the given spin-orbit eigenvalue
+  auto U_central = [this, &grid](size_t n) -> std::complex<double>
+  {
+    double temp_Vv = Vv * grid.f_v[n];
+    double temp_Wv = Wv * grid.f_v[n];
+    double temp_Wd = -4 * Wd * ad * grid.dfdr_d[n];
+    return std::complex<double>(-temp_Vv, -temp_Wv - temp_Wd);
+  };
+
+  auto U_minus_Vc = [this, &grid](size_t n, const std::complex<double>& Uc,
+    double so_eigenvalue) -> std::complex<double>
+  {
+    if (so_eigenvalue == 0) return Uc;
+
+    double factor_so = grid.so_shape[n] * so_eigenvalue / grid.r[n];
+    double temp_Vso = Vso * factor_so;
+    double temp_Wso = Wso * factor_so;
+
+    return std::complex<double>(Uc.real() + temp_Vso, Uc.imag() + temp_Wso);
+  };
+
+  marley::ScratchVector<NumerovState> states( waves.size(),
+    Ss.get_allocator() );
+  std::complex<double> Uc_0 = U_central( 0u );
+  for ( size_t w = 0u; w < waves.size(); ++w ) {
+    auto& st = states[w];
+    st.l = waves[w].first;
+    st.spin_orbit_eigenvalue = compute_spin_orbit_eigenvalue( waves[w].second,
+      st.l, two_s );
+
+    // a(r) really blows up at the origin for the optical model potential,
+    // but we're saved by the boundary condition that u(0) = 0. We just need
+    // something finite here, but we might as well make it zero.
+    st.a_n_minus_one = 0;
+    st.a_n = a(grid.r[0], st.l, U_minus_Vc(0u, Uc_0,
+      st.spin_orbit_eigenvalue) + grid.Vc[0]);
+
+    // Boundary condition that the wavefunction vanishes at the origin (the
+    // optical model potential blows up at r = 0)
+    st.u_n_minus_one = 0;
+
+    // Asymptotic approximation for a regular potential (see J. Thijssen,
+    // Computational Physics, p. 20 for details). We really just need
+    // something finite and nonzero here, since our specific choice only
+    // determines the overall normalization, which isn't important for
+    // determining the transmission coefficients.
+    st.u_n = std::pow(step_size_, st.l + 1);
   }
-  while (std::abs(U_minus_Vc) > MATCHING_RADIUS_THRESHOLD);
-
-  double r_match_1 = r;
-  u1 = u_n;
 
+  // Advance all of the partial waves together, one grid point at a time.
+  // Each wave is integrated outward until the nuclear potential becomes
+  // negligible (the first matching radius) and then on to at least 1.2 times
+  // that radius (the second matching radius).
   /// @todo TODO: consider using a more sophisticated method for choosing the
   /// second matching radius
-  // Advance at least as far as r_max. The actual maximum value used (which
-  // will be an integer multiple of the step_size_) will be assigned to
-  // r_match_2.
-  double r_max = 1.2 * r_match_1;
-
-  do {
-    r += step_size_;
-    a_n_minus_two = a_n_minus_one;
-    a_n_minus_one = a_n;
-    a_n = a(r, l);
-
-    u_n_minus_two = u_n_minus_one;
-    u_n_minus_one = u_n;
-
-    u_n = ((2.0 - 10*step_size2_over_twelve*a_n_minus_one)*u_n_minus_one
-      - (1.0 + step_size2_over_twelve*a_n_minus_two)*u_n_minus_two)
-      / (1.0 + step_size2_over_twelve*a_n);
+  size_t num_active = states.size();
+  for ( size_t n = 1u; num_active > 0u; ++n ) {
+
+    if ( grid.r.size() <= n ) extend_radial_grid( grid, 2u * n );
+    double r = grid.r[n];
+
+    // The central potential and the matching test for it are the same for
+    // all waves without a spin-orbit term, so evaluate them only once here
+    std::complex<double> Uc = U_central( n );
+    bool Uc_negligible = !( std::abs(Uc) > matching_threshold_ );
+
+    for ( auto& st : states ) {
+      if ( st.done ) continue;
+
+      st.a_n_minus_two = st.a_n_minus_one;
+      st.a_n_minus_one = st.a_n;
+
+      // Optical model potential with and without the Coulomb potential
+      // included
+      bool has_so = st.spin_orbit_eigenvalue != 0;
+      std::complex<double> U_mVc = U_minus_Vc( n, Uc,
+        st.spin_orbit_eigenvalue );
+      std::complex<double> U = U_mVc + grid.Vc[n];
+      st.a_n = a(r, st.l, U);
+
+      st.u_n_minus_two = st.u_n_minus_one;
+      st.u_n_minus_one = st.u_n;
+
+      st.u_n = ((2.0 - 10*step_size2_over_twelve*st.a_n_minus_one)
+        *st.u_n_minus_one - (1.0 + step_size2_over_twelve*st.a_n_minus_two)
+        *st.u_n_minus_two) / (1.0 + step_size2_over_twelve*st.a_n);
+
+      if ( !st.reached_r_match_1 ) {
+        bool negligible = has_so ? !(std::abs(U_mVc) > matching_threshold_)
+          : Uc_negligible;
+        if ( negligible ) {
+          st.reached_r_match_1 = true;
+          st.r_match_1 = r;
+          st.u1 = st.u_n;
+          // Advance at least as far as r_max. The actual maximum value used
+          // (which will be an integer multiple of the step_size_) will be
+          // assigned to r_match_2.
+          st.r_max = 1.2 * st.r_match_1;
+        }
+      }
+      else if ( !(r < st.r_max) ) {
+        st.r_match_2 = r;
+        st.u2 = st.u_n;
+        st.done = true;
+        --num_active;
+      }
+    }
   }
-  while (r < r_max);
-
-  double r_match_2 = r;
-  u2 = u_n;
 
   // Coulomb (Sommerfeld) parameter
   // Note that the relative (dimensionless) speed of the two particles
@@ -416,25 +769,59 @@ marley::KoningDelarocheOpticalModel::s_matrix_element(int fragment_pdg,
 
   double eta = Z_ * z * marley_utils::alpha / beta_rel;
 
-  // Compute the Coulomb wavefunctions at the matching radii
-  std::complex<double> Hplus1, Hminus1, Hplus2, Hminus2;
-
   // Fragment's CM frame wavenumber
   double k = marley_utils::real_sqrt( CM_frame_momentum_squared_ )
     / marley_utils::hbar_c;
 
-  Hplus1 = coulomb_H_plus(l, eta, k*r_match_1);
+  // Partial waves often share matching radii, so ask for Coulomb
+  // wavefunctions up to the largest l needed whenever a new radius is
+  // encountered
+  int l_max = 0;
+  for ( const auto& st : states ) l_max = std::max( l_max, st.l );
 
-  // H+ and H- are complex conjugates of each other
-  Hminus1 = std::conj(Hplus1);
+  for ( const auto& st : states ) {
 
-  Hplus2 = coulomb_H_plus(l, eta, k*r_match_2);
-  Hminus2 = std::conj(Hplus2);
+    // Compute the Coulomb wavefunctions at the matching radii
+    std::complex<double> Hplus1, Hminus1, Hplus2, Hminus2;
 
-  // Compute the S matrix element using the radial wavefunction
-  // evaluated at the two matching radii
-  std::complex<double> S = (u1*Hminus2 - u2*Hminus1) / (u1*Hplus2 - u2*Hplus1);
-  return S;
+    Hplus1 = coulomb_cache_.H_plus(st.l, l_max, eta, k*st.r_match_1);
+
+    // H+ and H- are complex conjugates of each other
+    Hminus1 = std::conj(Hplus1);
+
+    Hplus2 = coulomb_cache_.H_plus(st.l, l_max, eta, k*st.r_match_2);
+    Hminus2 = std::conj(Hplus2);
+
+    // Compute the S matrix element using the radial wavefunction
+    // evaluated at the two matching radii
+    Ss.push_back( (st.u1*Hminus2 - st.u2*Hminus1)
+      / (st.u1*Hplus2 - st.u2*Hplus1) );
+  }
+}
+
+void marley::KoningDelarocheOpticalModel::extend_radial_grid(
+  RadialGrid& grid, size_t size) const
+{
+  while ( grid.r.size() < size ) {
+    // Accumulate the radius in the same way as a step-by-step integration
+    // would, so that the grid points are reproduced exactly
+    double r = grid.r.empty() ? step_size_ : grid.r.back() + step_size_;
+    grid.r.push_back( r );
+    grid.f_v.push_back( f(r, Rv, av) );
+    grid.dfdr_d.push_back( dfdr(r, Rd, ad) );
+    grid.so_shape.push_back( lambda_piplus2 * dfdr(r, Rso, aso) );
+    grid.Vc.push_back( Vc(r, Rc, z, Z_) );
+  }
+}
+
+double marley::KoningDelarocheOpticalModel::compute_spin_orbit_eigenvalue(
+  int two_j, int l, int two_s)
+{
+  // 2*(l.s) = j*(j + 1)  - l*(l + 1) -  s*(s + 1)
+  // = 0.25*((2j - 2s)*(2j + 2s + 2)) - l*(l+1)
+  // (to keep the units right we take hbar = 1).
+  if ( two_s == 0 ) return 0.;
+  return 0.25*((two_j - two_s) * (two_j + two_s + 2)) - l*(l + 1);
 }
 
 // Version of Schrodinger equation terms with the optical model potential
@@ -447,15 +834,6 @@ std::complex<double> marley::KoningDelarocheOpticalModel::a(double r,
     / marley_utils::hbar_c2;
 }
 
-// Non-derivative radial Schrödinger equation terms to use for computing
-// transmission coefficients via the Numerov method
-std::complex<double> marley::KoningDelarocheOpticalModel::a(double r, int l)
-{
-  return (-l*(l+1) / std::pow(r, 2)) +
-    (1. - (omp(r) / total_CM_frame_KE_)) * CM_frame_momentum_squared_
-    / marley_utils::hbar_c2;
-}
-
 // Coulomb potential for a point particle with charge q*e interacting
 // with a uniformly charged sphere with radius R and charge Q*e
 double marley::KoningDelarocheOpticalModel::Vc(double r, double R, int Q,
@@ -471,7 +849,7 @@ double marley::KoningDelarocheOpticalModel::Vc(double r, double R, int Q,
 double marley::KoningDelarocheOpticalModel::f(double r, double R, double a)
   const
 {
-  return std::pow(1 + std::exp((r - R) / a), -1);
+  return 1. / (1. + std::exp((r - R) / a));
 }
 
 // Compute the optical model potential at radius r
@@ -491,12 +869,25 @@ double marley::KoningDelarocheOpticalModel::dfdr(double r, double R, double a) c
   double exponent = (r - R) / a;
   if (std::abs(exponent) > 100.) return 0;
   double temp = std::exp(exponent);
-  return -temp / (a * std::pow(1 + temp, 2));
+  double one_plus_temp = 1. + temp;
+  return -temp / (a * one_plus_temp * one_plus_temp);
 }
 
 void marley::KoningDelarocheOpticalModel::calculate_kinematic_variables(
   double KE_tot_CM, int fragment_pdg)
 {
+  // Nothing to do if the inputs are unchanged since the last call
+  if ( kin_cache_valid_ && kin_cache_pdg_ == fragment_pdg
+    && kin_cache_KE_CM_ == KE_tot_CM && kin_cache_target_mass_ == target_mass_ )
+  {
+    return;
+  }
+
+  kin_cache_valid_ = true;
+  kin_cache_pdg_ = fragment_pdg;
+  kin_cache_KE_CM_ = KE_tot_CM;
+  kin_cache_target_mass_ = target_mass_;
+
   // Store the total kinetic energy in the CM frame
   total_CM_frame_KE_ = KE_tot_CM;
 
@@ -517,8 +908,12 @@ void marley::KoningDelarocheOpticalModel::calculate_kinematic_variables(
 
 void marley::KoningDelarocheOpticalModel::update_target_mass(int target_charge)
 {
+  // Skip the mass table lookup if the charge state hasn't changed
+  if ( target_charge_valid_ && target_charge_ == target_charge ) return;
+  target_charge_valid_ = true;
+  target_charge_ = target_charge;
+
   // Update the target mass based on its charge state
   const auto& mt = marley::MassTable::Instance();
-  target_mass_ = mt.get_atomic_mass(Z_, A_)
-   - target_charge*mt.get_particle_mass( marley_utils::ELECTRON );
+  target_mass_ = mt.get_ion_mass( Z_, A_, target_charge );
 }
@@ -14,12 +14,218 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <condition_variable>
 #include <iostream>
 #include <exception>
+#include <thread>
 
 #include "marley/Error.hh"
 #include "marley/Logger.hh"
 
+namespace {
+
+  // Buffers used by the current thread to format log messages. A stack is
+  // used so that a message may be formed while another one is still in
+  // progress (e.g., when streaming an object whose operator<< itself logs
+  // something). The buffers are reused to avoid repeated allocations.
+  struct FormatBuffers {
+    std::vector< std::unique_ptr<std::ostringstream> > pool;
+    size_t depth = 0u;
+  };
+
+  thread_local FormatBuffers format_buffers;
+
+  // Default formatting state for a fresh message
+  const std::ostringstream default_format;
+}
+
+// Multiple-producer, single-consumer queue of completed log messages
+// together with the background thread that writes them. The queue is an
+// intrusive linked list based on the design by Dmitry Vyukov: pushing a
+// message is a single atomic exchange, so producers never block each other
+// or the consumer.
+class marley::Logger::AsyncWriter {
+
+  public:
+
+    AsyncWriter(marley::Logger& logger) : logger_( logger ),
+      head_( &stub_ ), tail_( &stub_ )
+    {
+      thread_ = std::thread( &AsyncWriter::run, this );
+    }
+
+    ~AsyncWriter() {
+      stop_.store( true, std::memory_order_release );
+      cv_.notify_one();
+      if ( thread_.joinable() ) thread_.join();
+    }
+
+    void push(LogLevel lev, std::string&& text) {
+      Node* node = new Node;
+      node->level = lev;
+      node->text = std::move( text );
+      push_node( node );
+      pushed_.fetch_add( 1u, std::memory_order_release );
+      cv_.notify_one();
+    }
+
+    // Blocks until every message pushed before this call has been written
+    void wait_until_written() {
+      // Messages may be logged from within the writer thread itself (e.g.,
+      // by a stream's operator<<), so don't wait on ourselves
+      if ( std::this_thread::get_id() == thread_.get_id() ) return;
+      uint64_t target = pushed_.load( std::memory_order_acquire );
+      cv_.notify_one();
+      while ( written_.load(std::memory_order_acquire) < target ) {
+        std::this_thread::yield();
+      }
+    }
+
+  private:
+
+    struct Node {
+      std::atomic<Node*> next{ nullptr };
+      LogLevel level = LogLevel::DISABLED;
+      std::string text;
+    };
+
+    void push_node(Node* node) {
+      node->next.store( nullptr, std::memory_order_relaxed );
+      Node* prev = head_.exchange( node, std::memory_order_acq_rel );
+      prev->next.store( node, std::memory_order_release );
+    }
+
+    // Removes the oldest message from the queue. Returns nullptr if the
+    // queue is empty or if a producer has not yet finished linking in the
+    // next message. Only the writer thread may call this function.
+    Node* pop() {
+      Node* tail = tail_;
+      Node* next = tail->next.load( std::memory_order_acquire );
+      if ( tail == &stub_ ) {
+        if ( !next ) return nullptr;
+        tail_ = next;
+        tail = next;
+        next = next->next.load( std::memory_order_acquire );
+      }
+      if ( next ) {
+        tail_ = next;
+        return tail;
+      }
+      if ( tail != head_.load(std::memory_order_acquire) ) return nullptr;
+      push_node( &stub_ );
+      next = tail->next.load( std::memory_order_acquire );
+      if ( next ) {
+        tail_ = next;
+        return tail;
+      }
+      return nullptr;
+    }
+
+    void drain() {
+      while ( Node* node = pop() ) {
+        logger_.write_record( node->level, node->text );
+        delete node;
+        written_.fetch_add( 1u, std::memory_order_release );
+      }
+    }
+
+    void run() {
+      for (;;) {
+        drain();
+        if ( stop_.load(std::memory_order_acquire)
+          && written_.load() == pushed_.load() ) return;
+
+        // Producers notify without taking the mutex, so a wakeup may
+        // occasionally be missed. The timeout bounds the resulting delay.
+        std::unique_lock<std::mutex> lock( wait_mutex_ );
+        cv_.wait_for( lock, std::chrono::milliseconds(20), [this]() -> bool
+          { return stop_.load() || written_.load() != pushed_.load(); } );
+      }
+    }
+
+    marley::Logger& logger_;
+
+    // Most recently pushed node (written by producers)
+    std::atomic<Node*> head_;
+
+    // Oldest node not yet consumed (used only by the writer thread)
+    Node* tail_;
+
+    // Placeholder node that keeps the list from ever becoming empty
+    Node stub_;
+
+    std::atomic<uint64_t> pushed_{ 0u };
+    std::atomic<uint64_t> written_{ 0u };
+    std::atomic<bool> stop_{ false };
+
+    std::mutex wait_mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+marley::Logger::Message::Message(Logger& logger, LogLevel lev,
+  uint64_t suppressed) : logger_( logger ), level_( lev ),
+  suppressed_( suppressed ), active_( true )
+{
+  auto& bufs = format_buffers;
+  if ( bufs.depth == bufs.pool.size() ) {
+    bufs.pool.push_back( std::make_unique<std::ostringstream>() );
+  }
+  os_ = bufs.pool.at( bufs.depth++ ).get();
+  os_->str( "" );
+  os_->clear();
+  os_->copyfmt( default_format );
+}
+
+marley::Logger::Message::Message(Message&& other) : logger_( other.logger_ ),
+  level_( other.level_ ), suppressed_( other.suppressed_ ), os_( other.os_ ),
+  active_( other.active_ )
+{
+  // Moved-from Message objects should not write anything
+  other.active_ = false;
+}
+
+marley::Logger::Message::~Message() {
+  if ( !active_ ) return;
+  // Never let a failure to log escape from a destructor
+  try {
+    if ( suppressed_ > 0u ) *os_ << " (" << suppressed_ << " similar"
+      << ( suppressed_ == 1u ? " message was" : " messages were" )
+      << " suppressed)";
+    std::string text = os_->str();
+    --format_buffers.depth;
+    logger_.submit( level_, std::move(text) );
+  }
+  catch ( ... ) {
+    if ( format_buffers.depth > 0u && format_buffers.pool.at(
+      format_buffers.depth - 1u ).get() == os_ ) --format_buffers.depth;
+  }
+}
+
+marley::Logger::RateLimit::RateLimit(uint64_t burst, double interval)
+  : burst_( burst ), interval_( std::chrono::duration_cast<
+  std::chrono::steady_clock::duration>(std::chrono::duration<double>(
+  interval)) ) {}
+
+bool marley::Logger::RateLimit::allow() {
+  uint64_t n = count_.fetch_add( 1u, std::memory_order_relaxed );
+  int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+  if ( n < burst_ ) {
+    // Start timing the interval once the burst is used up
+    if ( n + 1u == burst_ ) next_allowed_.store( now + interval_.count(),
+      std::memory_order_relaxed );
+    return true;
+  }
+
+  int64_t next = next_allowed_.load( std::memory_order_relaxed );
+  while ( now >= next ) {
+    if ( next_allowed_.compare_exchange_weak(next, now + interval_.count(),
+      std::memory_order_relaxed) ) return true;
+  }
+  suppressed_.fetch_add( 1u, std::memory_order_relaxed );
+  return false;
+}
+
 const char* marley::Logger::loglevel_to_str(LogLevel lev)
 {
   switch (lev) {
@@ -77,14 +283,20 @@ marley::Logger::OutStreamVector&
 }
 
 void marley::Logger::flush() {
+  if ( async_writer_ ) async_writer_->wait_until_written();
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
   for (auto s : streams_) if (s.enabled_ && s.stream_) s.stream_->flush();
 }
 
 void marley::Logger::newline() {
+  if ( async_writer_ ) async_writer_->wait_until_written();
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
   for (auto s : streams_) if (s.enabled_ && s.stream_) (*s.stream_) << '\n';
 }
 
 void marley::Logger::clear_streams() {
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
+
   // Empty the vector of output streams for the Logger
   streams_.clear();
 
@@ -94,6 +306,12 @@ void marley::Logger::clear_streams() {
   add_stream(std::cerr, LogLevel::WARNING);
 }
 
+void marley::Logger::update_max_level() {
+  LogLevel max = LogLevel::DISABLED;
+  if (enabled_) for (const auto& s : streams_) max = std::max(max, s.level_);
+  max_level_.store( static_cast<int>(max), std::memory_order_relaxed );
+}
+
 marley::Logger::Logger(bool log_enabled) : enabled_(log_enabled),
   old_level_(LogLevel::INFO)
 {
@@ -106,6 +324,11 @@ marley::Logger::Logger(bool log_enabled) : enabled_(log_enabled),
   add_stream(std::cout, LogLevel::INFO);
 }
 
+marley::Logger::~Logger() {
+  async_.store( false, std::memory_order_release );
+  async_writer_.reset();
+}
+
 marley::Logger& marley::Logger::Instance() {
   static Logger instance;
   return instance;
@@ -158,25 +381,33 @@ marley::Logger::OutStream* marley::Logger::find_stream(const std::ostream* os,
 void marley::Logger::add_stream(std::shared_ptr<std::ostream> stream,
   LogLevel level)
 {
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
+
   // Check to see whether we have already added this stream to the logger
   bool enabled;
   marley::Logger::OutStream* os = find_stream(stream.get(), enabled, level);
 
   if (!os) streams_.emplace_back(stream, level, enabled);
+  update_max_level();
 }
 
 void marley::Logger::add_stream(std::ostream& stream, LogLevel level)
 {
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
+
   // Check to see whether we have already added this stream to the logger
   bool enabled;
   marley::Logger::OutStream* os = find_stream(&stream, enabled, level);
 
   if (!os) streams_.emplace_back(stream, level, enabled);
+  update_max_level();
 }
 
 void marley::Logger::enable(bool log_enabled) {
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
   enabled_ = log_enabled;
   for (auto& s : streams_) s.enabled_ = enabled_ && (s.level_ >= old_level_);
+  update_max_level();
 }
 
 marley::Logger::Message marley::Logger::log(LogLevel lev)
@@ -184,27 +415,67 @@ marley::Logger::Message marley::Logger::log(LogLevel lev)
   if (lev == LogLevel::DISABLED) throw marley::Error("marley::Logger::log()"
     " may not be called for the DISABLED logging level.");
 
+  return marley::Logger::Message( *this, lev );
+}
+
+marley::Logger::Message marley::Logger::log(LogLevel lev, RateLimit& limit)
+{
+  if (lev == LogLevel::DISABLED) throw marley::Error("marley::Logger::log()"
+    " may not be called for the DISABLED logging level.");
+
+  return marley::Logger::Message( *this, lev, limit.take_suppressed() );
+}
+
+void marley::Logger::submit(LogLevel lev, std::string&& text) {
+  if ( async_.load(std::memory_order_acquire) ) {
+    async_writer_->push( lev, std::move(text) );
+  }
+  else write_record( lev, text );
+}
+
+void marley::Logger::write_record(LogLevel lev, const std::string& text)
+{
+  std::lock_guard<std::recursive_mutex> lock( mutex_ );
+
+  if (!enabled_) return;
+
   bool level_changed = (lev != old_level_);
 
-  if (enabled_) {
-    // Update the state of each stream based on the logging level (if
-    // needed) and start a new line on each enabled stream for the new
-    // message.
-    for(auto& s : streams_) {
-      if (level_changed) {
-        s.enabled_ = (s.level_ >= lev);
-        // Because writing error and warning messages to stdout will cause
-        // duplication in a terminal when we're also writing to stderr, prevent
-        // stdout from receiving any logger messages that are at the WARNING
-        // log level or below. The user may suppress warnings/errors entirely
-        // by adjusting the log level for std::cerr.
-        if (s.stream_.get() == &std::cout)
-          s.enabled_ = (s.enabled_) && (lev > LogLevel::WARNING);
-      }
-      if (s.enabled_) *s.stream_ << loglevel_to_str(lev);
+  // Update the state of each stream based on the logging level (if
+  // needed) and write the message to each enabled stream.
+  for(auto& s : streams_) {
+    if (level_changed) {
+      s.enabled_ = (s.level_ >= lev);
+      // Because writing error and warning messages to stdout will cause
+      // duplication in a terminal when we're also writing to stderr, prevent
+      // stdout from receiving any logger messages that are at the WARNING
+      // log level or below. The user may suppress warnings/errors entirely
+      // by adjusting the log level for std::cerr.
+      if (s.stream_.get() == &std::cout)
+        s.enabled_ = (s.enabled_) && (lev > LogLevel::WARNING);
+    }
+    if (s.enabled_ && s.stream_) {
+      *s.stream_ << loglevel_to_str(lev) << text << '\n';
     }
-    // Update the old logging level
-    old_level_ = lev;
   }
-  return marley::Logger::Message( streams_ );
+  // Update the old logging level
+  old_level_ = lev;
+}
+
+void marley::Logger::set_async(bool async) {
+  if ( async ) {
+    std::lock_guard<std::recursive_mutex> lock( mutex_ );
+    // The writer is kept alive until the Logger is destroyed, so threads
+    // that saw the old setting may still safely push messages to it
+    if ( !async_writer_ ) {
+      async_writer_ = std::make_unique<AsyncWriter>( *this );
+    }
+    async_.store( true, std::memory_order_release );
+  }
+  else {
+    async_.store( false, std::memory_order_release );
+    // The writer thread needs the mutex to write the queued messages, so
+    // don't hold it while waiting for them
+    if ( async_writer_ ) async_writer_->wait_until_written();
+  }
 }
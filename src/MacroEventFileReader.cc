@@ -42,6 +42,18 @@ bool marley::MacroEventFileReader::next_event(marley::Event& ev) {
   return efr->next_event( ev );
 }
 
+size_t marley::MacroEventFileReader::next_events(size_t max_events,
+  marley::EventBatch& batch)
+{
+  auto* efr = get_refr_pointer( event_file_reader_ );
+  return efr->next_events( max_events, batch );
+}
+
+bool marley::MacroEventFileReader::seek_event(size_t event_index) {
+  auto* efr = get_refr_pointer( event_file_reader_ );
+  return efr->seek_event( event_index );
+}
+
 marley::MacroEventFileReader::operator bool() const {
   auto* efr = get_refr_pointer( event_file_reader_ );
   return static_cast<bool>( *efr );
@@ -0,0 +1,518 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+// MARLEY includes
+#include "marley/marley_utils.hh"
+#include "marley/CompressedStream.hh"
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/JSONDocument.hh"
+#include "marley/Logger.hh"
+#include "marley/MappedEventFileReader.hh"
+
+namespace {
+
+  inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  inline bool is_digit(char c) {
+    return std::isdigit( static_cast<unsigned char>(c) ) != 0;
+  }
+
+  // Returns a pointer to the first character that is not whitespace
+  // (including newlines), or end if there is none
+  const char* skip_whitespace(const char* p, const char* end) {
+    while ( p < end && (is_blank(*p) || *p == '\n') ) ++p;
+    return p;
+  }
+
+  // Returns a pointer to the start of the line following the one that
+  // contains p, or end if there is none
+  const char* next_line(const char* p, const char* end) {
+    const void* nl = std::memchr( p, '\n', static_cast<size_t>(end - p) );
+    return nl ? static_cast<const char*>( nl ) + 1 : end;
+  }
+
+  // Parses a (possibly signed) integer that follows any blanks at p.
+  // Unlike std::strtol(), this never reads past end, which matters because
+  // the mapped file contents are not null-terminated.
+  bool parse_long(const char*& p, const char* end, long& value) {
+    while ( p < end && is_blank(*p) ) ++p;
+
+    bool negative = false;
+    if ( p < end && (*p == '-' || *p == '+') ) {
+      negative = ( *p == '-' );
+      ++p;
+    }
+    if ( p == end || !is_digit(*p) ) return false;
+
+    // Guard against overflow from a corrupted file
+    constexpr long MAX_VALUE = 1l << 40;
+    long v = 0;
+    while ( p < end && is_digit(*p) ) {
+      v = 10*v + ( *p - '0' );
+      if ( v > MAX_VALUE ) return false;
+      ++p;
+    }
+
+    value = negative ? -v : v;
+    return true;
+  }
+
+  // Counts the blank-separated tokens on the line that starts at p
+  size_t count_tokens(const char* p, const char* end) {
+    size_t count = 0u;
+    bool in_token = false;
+    for ( ; p < end && *p != '\n'; ++p ) {
+      if ( is_blank(*p) ) in_token = false;
+      else if ( !in_token ) {
+        in_token = true;
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  // Advances p past the JSON string that begins at p
+  bool skip_json_string(const char*& p, const char* end) {
+    ++p; // Opening quote
+    while ( p < end ) {
+      if ( *p == '\\' ) {
+        if ( ++p == end ) return false;
+      }
+      else if ( *p == '"' ) {
+        ++p;
+        return true;
+      }
+      ++p;
+    }
+    return false;
+  }
+
+  // Advances p past the JSON value that begins at p
+  bool skip_json_value(const char*& p, const char* end) {
+    if ( p == end ) return false;
+    if ( *p == '"' ) return skip_json_string( p, end );
+
+    if ( *p == '{' || *p == '[' ) {
+      int depth = 0;
+      while ( p < end ) {
+        char c = *p;
+        if ( c == '"' ) {
+          if ( !skip_json_string(p, end) ) return false;
+          continue;
+        }
+        else if ( c == '{' || c == '[' ) ++depth;
+        else if ( c == '}' || c == ']' ) {
+          if ( --depth == 0 ) {
+            ++p;
+            return true;
+          }
+        }
+        ++p;
+      }
+      return false;
+    }
+
+    // Numbers, booleans, and null
+    while ( p < end && *p != ',' && *p != '}' && *p != ']'
+      && !is_blank(*p) && *p != '\n' ) ++p;
+    return true;
+  }
+
+}
+
+marley::MappedEventFileReader::MappedEventFileReader(
+  const std::string& file_name) : file_name_( file_name ),
+  file_( file_name ), buffer_( file_.data(), file_.size() ), in_( &buffer_ )
+{
+  this->build_index();
+}
+
+void marley::MappedEventFileReader::build_index() {
+
+  // Compressed files must be decompressed before their contents can be
+  // accessed at random, so they cannot be read usefully through a mapping
+  if ( marley::DecompressingStreamBuf::is_compressed(buffer_) ) {
+    throw marley::Error("The compressed event file \"" + file_name_
+      + "\" cannot be memory mapped. Please use marley::EventFileReader"
+      " to read it instead.");
+  }
+
+  // If the file starts with a valid binary header, then it was written in
+  // MARLEY's native binary format
+  marley::BinaryEventBlock::Header header;
+  if ( marley::BinaryEventBlock::read_header(in_, header) ) {
+    if ( header.layout != marley::BinaryEventBlock::Layout::event ) {
+      throw marley::Error("The binary file \"" + file_name_ + "\" uses the"
+        " kinematics layout, which cannot be read back as marley::Event"
+        " objects");
+    }
+    format_ = marley::OutputFile::Format::BINARY;
+    flux_avg_tot_xs_ = header.flux_avg_tot_xsec;
+    binary_format_version_ = header.format_version;
+    binary_precision_ = header.precision;
+    this->build_binary_index();
+    return;
+  }
+  in_.clear();
+  in_.seekg( 0 );
+
+  const char* begin = file_.data();
+  const char* end = begin + file_.size();
+  const char* p = skip_whitespace( begin, end );
+
+  // JSON files begin with '{'. ASCII files begin with a line containing
+  // only the flux-averaged total cross section, while HEPEVT files begin
+  // with an event header line holding an event number and a particle count.
+  size_t num_tokens = count_tokens( p, end );
+  if ( p < end && *p == '{' ) {
+    format_ = marley::OutputFile::Format::JSON;
+    this->build_json_index();
+  }
+  else if ( num_tokens == 1u ) {
+    format_ = marley::OutputFile::Format::ASCII;
+    in_ >> flux_avg_tot_xs_;
+    if ( !in_ ) throw marley::Error("Could not read the flux-averaged total"
+      " cross section from the ASCII-format event file \"" + file_name_
+      + '\"');
+    this->build_text_index( next_line(p, end) - begin );
+  }
+  else if ( num_tokens == 2u ) {
+    format_ = marley::OutputFile::Format::HEPEVT;
+    this->build_text_index( p - begin );
+
+    // The flux-averaged total cross section is stored in every HEPEVT
+    // event record, so get it from the first one
+    if ( num_events_ > 0u ) {
+      marley::Event temp_event;
+      in_.clear();
+      in_.seekg( event_offsets_.front() );
+      temp_event.read_hepevt( in_, &flux_avg_tot_xs_ );
+    }
+  }
+  else throw marley::Error("Could not read MARLEY events from the file \""
+    + file_name_ + '\"');
+
+  in_.clear();
+}
+
+void marley::MappedEventFileReader::build_text_index(size_t first_line) {
+
+  const char* begin = file_.data();
+  const char* end = begin + file_.size();
+  const char* p = begin + first_line;
+
+  while ( true ) {
+    p = skip_whitespace( p, end );
+    if ( p == end ) break;
+    const char* start = p;
+
+    // ASCII event header lines begin with the numbers of initial and final
+    // particles. HEPEVT ones hold an event number and a particle count.
+    long first, second;
+    bool ok = parse_long( p, end, first ) && parse_long( p, end, second );
+    long num_particles = 0;
+    if ( format_ == marley::OutputFile::Format::ASCII ) {
+      ok = ok && first >= 2 && second >= 2;
+      num_particles = first + second;
+    }
+    else {
+      ok = ok && second >= 0;
+      num_particles = second;
+    }
+
+    if ( !ok ) throw marley::Error("Invalid event header found at byte "
+      + std::to_string(start - begin) + " while indexing the event file \""
+      + file_name_ + '\"');
+
+    // Skip the header line and then one line per particle
+    p = next_line( p, end );
+    long line = 0;
+    for ( ; line < num_particles && p < end; ++line ) p = next_line( p, end );
+
+    if ( line < num_particles ) {
+      MARLEY_LOG_WARNING() << "Ignoring an incomplete event record at the"
+        << " end of the file \"" << file_name_ << '\"';
+      break;
+    }
+
+    event_offsets_.push_back( static_cast<size_t>(start - begin) );
+  }
+
+  num_events_ = event_offsets_.size();
+}
+
+void marley::MappedEventFileReader::build_json_index() {
+
+  const char* begin = file_.data();
+  const char* end = begin + file_.size();
+  const char* p = skip_whitespace( begin, end );
+
+  auto check = [&](bool ok) -> void {
+    if ( !ok ) throw marley::Error("Malformed JSON found at byte "
+      + std::to_string(p - begin) + " while indexing the event file \""
+      + file_name_ + '\"');
+  };
+
+  // Walk through the members of the top-level object, recording the
+  // position of each element of the "events" array. Everything else is
+  // skipped without being parsed.
+  bool found_events = false;
+  bool found_gen_state = false;
+  size_t gen_state_offset = 0u;
+
+  ++p; // Opening '{'
+  while ( true ) {
+    p = skip_whitespace( p, end );
+    check( p < end );
+    if ( *p == '}' ) break;
+
+    check( *p == '"' );
+    const char* key_begin = p + 1;
+    check( skip_json_string(p, end) );
+    std::string key( key_begin, p - 1 );
+
+    p = skip_whitespace( p, end );
+    check( p < end && *p == ':' );
+    p = skip_whitespace( p + 1, end );
+
+    if ( key == "events" ) {
+      check( p < end && *p == '[' );
+      ++p;
+      while ( true ) {
+        p = skip_whitespace( p, end );
+        check( p < end );
+        if ( *p == ']' ) {
+          ++p;
+          break;
+        }
+        else if ( *p == ',' ) {
+          ++p;
+          continue;
+        }
+        const char* event_begin = p;
+        check( *p == '{' && skip_json_value(p, end) );
+        event_offsets_.push_back( static_cast<size_t>(event_begin - begin) );
+      }
+      found_events = true;
+    }
+    else {
+      if ( key == "gen_state" ) {
+        found_gen_state = true;
+        gen_state_offset = static_cast<size_t>( p - begin );
+      }
+      check( skip_json_value(p, end) );
+    }
+
+    p = skip_whitespace( p, end );
+    if ( p < end && *p == ',' ) ++p;
+  }
+
+  if ( !found_events ) throw marley::Error("Missing \"events\" array in"
+    " the JSON-format event file \"" + file_name_ + '\"');
+
+  num_events_ = event_offsets_.size();
+
+  // The generator state is small compared to the event array, so just parse
+  // the whole thing to get the flux-averaged total cross section
+  if ( found_gen_state ) {
+    marley::JSONDocument doc( file_.data() + gen_state_offset,
+      file_.size() - gen_state_offset );
+    auto gen_state = doc.root();
+    if ( gen_state.has_key("flux_avg_xsec") ) {
+      flux_avg_tot_xs_ = gen_state.at( "flux_avg_xsec" ).to_double();
+    }
+  }
+}
+
+void marley::MappedEventFileReader::build_binary_index() {
+
+  // The file header has already been read from in_. Record the position of
+  // each event block until we reach the metadata record (or the end of the
+  // file).
+  size_t total = 0u;
+  marley::BinaryEventBlock::RecordTag tag;
+  while ( marley::BinaryEventBlock::read_tag(in_, tag)
+    && tag == marley::BinaryEventBlock::RecordTag::events )
+  {
+    size_t offset = static_cast<size_t>( in_.tellg() );
+    uint32_t block_size;
+    if ( !marley::BinaryEventBlock::skip(in_, block_size,
+      binary_format_version_, binary_precision_) ) {
+      MARLEY_LOG_WARNING() << "Ignoring an incomplete event block at the"
+        << " end of the file \"" << file_name_ << '\"';
+      break;
+    }
+    block_offsets_.push_back( offset );
+    block_first_events_.push_back( total );
+    total += block_size;
+  }
+
+  num_events_ = total;
+  in_.clear();
+}
+
+void marley::MappedEventFileReader::load_event(size_t index,
+  marley::Event& ev, std::istream& in, BlockCache& cache) const
+{
+  if ( index >= num_events_ ) throw marley::Error("Event index "
+    + std::to_string(index) + " is out of range for the file \""
+    + file_name_ + "\", which contains " + std::to_string(num_events_)
+    + " events");
+
+  in.clear();
+  bool ok = true;
+
+  switch ( format_ ) {
+
+    case marley::OutputFile::Format::ASCII:
+      in.seekg( event_offsets_[index] );
+      ev.read( in );
+      ok = static_cast<bool>( in );
+      break;
+
+    case marley::OutputFile::Format::HEPEVT:
+      in.seekg( event_offsets_[index] );
+      ok = ev.read_hepevt( in, nullptr );
+      break;
+
+    case marley::OutputFile::Format::JSON:
+    {
+      // Parse the event in place from the memory mapping
+      size_t offset = event_offsets_[ index ];
+      cache.json_doc.parse( file_.data() + offset, file_.size() - offset );
+      ev.from_json( cache.json_doc.root() );
+      break;
+    }
+
+    case marley::OutputFile::Format::BINARY: {
+      // Find the block that holds the requested event, loading it if it
+      // isn't already in the cache
+      auto iter = std::upper_bound( block_first_events_.cbegin(),
+        block_first_events_.cend(), index );
+      size_t block = static_cast<size_t>(
+        iter - block_first_events_.cbegin() ) - 1u;
+
+      if ( cache.block_index != block ) {
+        in.seekg( block_offsets_[block] );
+        ok = cache.block.read( in, binary_format_version_,
+          binary_precision_ );
+        cache.block_index = ok ? block : static_cast<size_t>( -1 );
+      }
+
+      if ( ok ) cache.block.get_event( index - block_first_events_[block],
+        ev );
+      break;
+    }
+
+    default:
+      throw marley::Error("Unrecognized file format encountered in"
+        " marley::MappedEventFileReader::load_event()");
+  }
+
+  if ( !ok ) throw marley::Error("Failed to read event "
+    + std::to_string(index) + " from the file \"" + file_name_ + '\"');
+}
+
+void marley::MappedEventFileReader::get_event(size_t index,
+  marley::Event& ev)
+{
+  this->load_event( index, ev, in_, cache_ );
+}
+
+bool marley::MappedEventFileReader::next_event(marley::Event& ev) {
+  if ( next_index_ < num_events_ ) {
+    this->load_event( next_index_++, ev, in_, cache_ );
+    return true;
+  }
+
+  ev = marley::Event();
+  good_ = false;
+  return false;
+}
+
+double marley::MappedEventFileReader::flux_averaged_xsec(
+  bool natural_units) const
+{
+  if ( natural_units ) return flux_avg_tot_xs_;
+  double result = flux_avg_tot_xs_ * marley_utils::hbar_c2
+    * marley_utils::fm2_to_minus40_cm2 * 1e2; // 10^{-42} cm^2
+  return result;
+}
+
+void marley::MappedEventFileReader::parallel_for_each_event(
+  const EventFunction& func, unsigned num_threads) const
+{
+  if ( num_events_ == 0u ) return;
+
+  if ( num_threads == 0u ) {
+    num_threads = std::max( std::thread::hardware_concurrency(), 1u );
+  }
+  if ( num_threads > num_events_ ) {
+    num_threads = static_cast<unsigned>( num_events_ );
+  }
+
+  // The first exception thrown by any of the threads
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  std::atomic<bool> abort( false );
+
+  // Each thread visits a contiguous range of events using its own stream
+  // and block cache, so no locking is needed while reading
+  auto process_events = [&](unsigned thread_index) -> void {
+    size_t first = num_events_ * thread_index / num_threads;
+    size_t last = num_events_ * ( thread_index + 1u ) / num_threads;
+
+    marley::MemoryStreamBuf buffer( file_.data(), file_.size() );
+    std::istream in( &buffer );
+    BlockCache cache;
+    marley::Event ev;
+
+    try {
+      for ( size_t e = first; e < last; ++e ) {
+        if ( abort.load(std::memory_order_relaxed) ) break;
+        this->load_event( e, ev, in, cache );
+        func( ev, thread_index );
+      }
+    }
+    catch ( ... ) {
+      std::lock_guard<std::mutex> lock( error_mutex );
+      if ( !error ) error = std::current_exception();
+      abort.store( true, std::memory_order_relaxed );
+    }
+  };
+
+  // The calling thread handles the first range of events itself
+  std::vector<std::thread> threads;
+  for ( unsigned t = 1u; t < num_threads; ++t ) {
+    threads.emplace_back( process_events, t );
+  }
+  process_events( 0u );
+  for ( auto& thread : threads ) thread.join();
+
+  if ( error ) std::rethrow_exception( error );
+}
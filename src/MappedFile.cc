@@ -0,0 +1,93 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <cerrno>
+#include <cstring>
+
+/// @todo Replace with more portable commands if non-POSIX systems need to
+/// be supported
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
+
+#include "marley/Error.hh"
+#include "marley/MappedFile.hh"
+
+marley::MappedFile::MappedFile(const std::string& file_name)
+{
+  int fd = open( file_name.c_str(), O_RDONLY );
+  if ( fd < 0 ) throw marley::Error( "Could not open the file " + file_name
+    + " for memory mapping: " + std::strerror(errno) );
+
+  struct stat file_stat;
+  if ( fstat(fd, &file_stat) != 0 ) {
+    close( fd );
+    throw marley::Error( "Could not determine the size of the file "
+      + file_name );
+  }
+  size_ = static_cast<size_t>( file_stat.st_size );
+
+  // Empty files cannot be mapped, but there is nothing to read from them
+  // anyway
+  if ( size_ > 0u ) {
+    void* address = mmap( nullptr, size_, PROT_READ, MAP_SHARED, fd, 0 );
+    if ( address == MAP_FAILED ) {
+      close( fd );
+      throw marley::Error( "Could not memory map the file " + file_name
+        + ": " + std::strerror(errno) );
+    }
+    data_ = static_cast<const char*>( address );
+  }
+
+  // The mapping remains valid after the file descriptor is closed
+  close( fd );
+}
+
+marley::MappedFile::~MappedFile() {
+  if ( data_ ) munmap( const_cast<char*>(data_), size_ );
+}
+
+marley::MemoryStreamBuf::MemoryStreamBuf(const char* data, size_t size)
+{
+  // The get area pointers are non-const, but the buffer is never written to
+  char* begin = const_cast<char*>( data );
+  setg( begin, begin, begin + size );
+}
+
+marley::MemoryStreamBuf::pos_type marley::MemoryStreamBuf::seekoff(
+  off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if ( !(which & std::ios_base::in) ) return pos_type( off_type(-1) );
+
+  off_type base = 0;
+  if ( dir == std::ios_base::cur ) base = gptr() - eback();
+  else if ( dir == std::ios_base::end ) base = egptr() - eback();
+
+  off_type target = base + off;
+  if ( target < 0 || target > egptr() - eback() ) {
+    return pos_type( off_type(-1) );
+  }
+
+  setg( eback(), eback() + target, egptr() );
+  return pos_type( target );
+}
+
+marley::MemoryStreamBuf::pos_type marley::MemoryStreamBuf::seekpos(
+  pos_type pos, std::ios_base::openmode which)
+{
+  return seekoff( off_type(pos), std::ios_base::beg, which );
+}
@@ -14,20 +14,72 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
+
 // MARLEY includes
 #include "marley/Error.hh"
 #include "marley/Fragment.hh"
 #include "marley/FileManager.hh"
 #include "marley/JSON.hh"
+#include "marley/MappedFile.hh"
 #include "marley/MassTable.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
 #include "marley/marley_utils.hh"
 
 // Initialize the static data file name
 const std::string marley::MassTable::data_file_name_ = "mass_table.js";
 
+namespace {
+
+  // Identifies files written by marley::MassTable::compile()
+  const std::string MASS_TABLE_MAGIC = "MARLEY mass table";
+
+  // Version number for the format of compiled mass table files
+  constexpr uint32_t MASS_TABLE_FORMAT_VERSION = 1u;
+
+  // Writes the contents of a mass lookup table as two parallel arrays
+  void write_masses(std::ostream& out,
+    const std::unordered_map<int, double>& masses)
+  {
+    std::vector<int> pdgs;
+    std::vector<double> values;
+    for ( const auto& pair : masses ) {
+      pdgs.push_back( pair.first );
+      values.push_back( pair.second );
+    }
+    marley_utils::write_binary( out, pdgs );
+    marley_utils::write_binary( out, values );
+  }
+
+  // Reads a mass lookup table written by write_masses()
+  bool read_masses(std::istream& in, std::unordered_map<int, double>& masses)
+  {
+    std::vector<int> pdgs;
+    std::vector<double> values;
+    if ( !marley_utils::read_binary(in, pdgs)
+      || !marley_utils::read_binary(in, values)
+      || pdgs.size() != values.size() ) return false;
+
+    masses.clear();
+    masses.reserve( pdgs.size() );
+    for ( size_t i = 0u; i < pdgs.size(); ++i ) {
+      masses.emplace( pdgs[i], values[i] );
+    }
+    return true;
+  }
+
+}
+
 marley::MassTable::MassTable() {
 
+  marley::StartupProfile::Timer timer( "mass table" );
+
   // Instantiate the file manager and use it to find
   // the mass table data file
   const auto& fm = marley::FileManager::Instance();
@@ -42,11 +94,31 @@ marley::MassTable::MassTable() {
       " environment variable.");
   }
 
-  MARLEY_LOG_INFO() << "Loading particle and atomic masses from "
-    << full_mt_file_name;
+  // Use a compiled version of the data file if there is an up-to-date one
+  // next to it. Otherwise, parse the JSON file itself.
+  std::string compiled_file_name = full_mt_file_name
+    + marley::StructureDatabase::COMPILED_DECAY_SCHEME_SUFFIX;
+
+  if ( this->read_compiled_table(compiled_file_name, full_mt_file_name) ) {
+    MARLEY_LOG_INFO() << "Loaded particle and atomic masses from "
+      << compiled_file_name;
+  }
+  else {
+    MARLEY_LOG_INFO() << "Loading particle and atomic masses from "
+      << full_mt_file_name;
+    read_json_table( full_mt_file_name, particle_masses_, atomic_masses_ );
+  }
+
+  // Prepare the tables used for fast lookups
+  build_dense_tables();
+}
 
+void marley::MassTable::read_json_table(const std::string& file_name,
+  std::unordered_map<int, double>& particle_masses,
+  std::unordered_map<int, double>& atomic_masses)
+{
   // Read in the mass table from a JSON data file
-  auto json_table = marley::JSON::load_file( full_mt_file_name );
+  auto json_table = marley::JSON::load_file( file_name );
 
   // Store the JSON entries in the relevant unordered maps
   if ( !json_table.has_key("particle_masses") ) {
@@ -54,15 +126,166 @@ marley::MassTable::MassTable() {
       + data_file_name_ + ". Missing \"particle_masses\" JSON array.");
   }
   const auto& pm_json = json_table.at("particle_masses");
-  assign_masses( pm_json, "particle_masses", this->particle_masses_ );
+  assign_masses( pm_json, "particle_masses", particle_masses );
 
   if ( !json_table.has_key("atomic_masses") ) {
     throw marley::Error("Problem reading the mass table data file "
       + data_file_name_ + ". Missing \"atomic_masses\" JSON array.");
   }
   const auto& am_json = json_table.at("atomic_masses");
-  assign_masses( am_json, "atomic_masses", this->atomic_masses_ );
+  assign_masses( am_json, "atomic_masses", atomic_masses );
+}
+
+int marley::MassTable::compile(const std::string& text_file_name,
+  const std::string& binary_file_name)
+{
+  uint64_t hash;
+  if ( !marley_utils::hash_file(text_file_name, hash) ) {
+    throw marley::Error( "Could not read from the data file "
+      + text_file_name );
+  }
+
+  std::unordered_map<int, double> particle_masses, atomic_masses;
+  read_json_table( text_file_name, particle_masses, atomic_masses );
+
+  std::ofstream out( binary_file_name, std::ios::binary );
+  if ( !out ) throw marley::Error( "Could not open the file "
+    + binary_file_name + " for writing" );
+
+  out.write( MASS_TABLE_MAGIC.data(), MASS_TABLE_MAGIC.size() );
+  marley_utils::write_binary( out, MASS_TABLE_FORMAT_VERSION );
+  marley_utils::write_binary( out, hash );
+  write_masses( out, particle_masses );
+  write_masses( out, atomic_masses );
+
+  out.close();
+  if ( !out ) throw marley::Error( "Failed to write the compiled mass table"
+    " file " + binary_file_name );
+
+  return static_cast<int>( particle_masses.size() + atomic_masses.size() );
+}
+
+bool marley::MassTable::read_compiled_table(
+  const std::string& binary_file_name, const std::string& text_file_name)
+{
+  // Most installations do not have a compiled mass table, so check quietly
+  // whether this one does before trying to map it (marley::Error logs its
+  // message)
+  if ( !std::ifstream(binary_file_name).good() ) return false;
+
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( binary_file_name ); }
+  catch ( const marley::Error& ) { return false; }
+
+  marley::MemoryStreamBuf buffer( file->data(), file->size() );
+  std::istream in( &buffer );
+
+  std::string magic( MASS_TABLE_MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+
+  uint32_t format_version;
+  uint64_t stored_hash, hash;
+  if ( !in || magic != MASS_TABLE_MAGIC
+    || !marley_utils::read_binary(in, format_version)
+    || format_version != MASS_TABLE_FORMAT_VERSION
+    || !marley_utils::read_binary(in, stored_hash) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring invalid compiled mass table file "
+      << binary_file_name;
+    return false;
+  }
+
+  if ( !marley_utils::hash_file(text_file_name, hash)
+    || hash != stored_hash )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring the compiled mass table file "
+      << binary_file_name << ", which is out of date with respect to "
+      << text_file_name;
+    return false;
+  }
+
+  if ( !read_masses(in, particle_masses_)
+    || !read_masses(in, atomic_masses_) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring the truncated compiled mass table file "
+      << binary_file_name;
+    particle_masses_.clear();
+    atomic_masses_.clear();
+    return false;
+  }
+
+  return true;
+}
+
+void marley::MassTable::build_dense_tables() {
+
+  constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+  // Decodes a PDG code from the atomic mass table. Only PDG codes in the
+  // standard ground-state nucleus format can be found by the lookup
+  // functions, so false is returned for any others.
+  auto decode = []( int pdg, int& Z, int& A ) -> bool {
+    Z = marley_utils::get_particle_Z( pdg );
+    A = marley_utils::get_particle_A( pdg );
+    return pdg == 10000*Z + 10*A + 1000000000;
+  };
+
+  // Find the range of mass numbers tabulated for each element
+  int Z, A;
+  int Z_max = 0;
+  for ( const auto& pair : atomic_masses_ ) {
+    if ( decode(pair.first, Z, A) && Z > Z_max ) Z_max = Z;
+  }
+
+  std::vector<int> A_min( Z_max + 1, std::numeric_limits<int>::max() );
+  std::vector<int> A_max( Z_max + 1, -1 );
+  for ( const auto& pair : atomic_masses_ ) {
+    if ( !decode(pair.first, Z, A) ) continue;
+    A_min[ Z ] = std::min( A_min[Z], A );
+    A_max[ Z ] = std::max( A_max[Z], A );
+  }
+
+  // Lay out the rows contiguously, one per element
+  atomic_rows_.assign( Z_max + 1, AtomicMassRow() );
+  size_t offset = 0u;
+  for ( int z = 0; z <= Z_max; ++z ) {
+    auto& row = atomic_rows_[ z ];
+    row.offset = offset;
+    if ( A_max[z] < 0 ) continue;
+    row.A_min = A_min[ z ];
+    row.A_count = A_max[ z ] - A_min[ z ] + 1;
+    offset += row.A_count;
+  }
 
+  dense_atomic_masses_.assign( offset, nan );
+  for ( const auto& pair : atomic_masses_ ) {
+    if ( !decode(pair.first, Z, A) ) continue;
+    const auto& row = atomic_rows_[ Z ];
+    dense_atomic_masses_[ row.offset + A - row.A_min ] = pair.second;
+  }
+
+  // Store the masses of the elementary particles and nucleons in MeV so
+  // that the unit conversion is done only once
+  int pdg_max = 0;
+  for ( const auto& pair : particle_masses_ ) {
+    if ( pair.first >= 0 && pair.first < DENSE_PARTICLE_PDG_LIMIT ) {
+      pdg_max = std::max( pdg_max, pair.first );
+    }
+  }
+
+  dense_particle_masses_.assign( pdg_max + 1, nan );
+  for ( const auto& pair : particle_masses_ ) {
+    if ( pair.first >= 0 && pair.first < DENSE_PARTICLE_PDG_LIMIT ) {
+      dense_particle_masses_[ pair.first ] = micro_amu_ * pair.second;
+    }
+  }
+
+  // Premultiply the electron mass for every charge state that a tabulated
+  // element can have
+  double me = micro_amu_ * particle_masses_.at( marley_utils::ELECTRON );
+  int q_max = std::max( Z_max, 1 );
+  electron_masses_.resize( q_max + 1 );
+  for ( int q = 0; q <= q_max; ++q ) electron_masses_[ q ] = q * me;
 }
 
 const marley::MassTable& marley::MassTable::Instance() {
@@ -80,17 +303,6 @@ double marley::MassTable::liquid_drop_model_atomic_mass(int Z, int A) const {
   return liquid_drop_model_mass_excess(Z, A) + micro_amu_*1e6*A;
 }
 
-double marley::MassTable::get_particle_mass(int particle_id) const {
-  int id = particle_id;
-  // The lookup table only includes entries for particles (as opposed to
-  // antiparticles), so flip the sign of the input particle id for the
-  // lookup if it represents an antiparticle.
-  if (id < 0) id *= -1;
-  // Find the particle's mass in the lookup table, and convert its
-  // value from micro-amu to MeV
-  return micro_amu_ * particle_masses_.at(id);
-}
-
 double marley::MassTable::get_atomic_mass(int nucleus_pid, bool theory_ok) const
 {
   bool exp;
@@ -103,17 +315,21 @@ double marley::MassTable::get_atomic_mass(int nucleus_pid, bool theory_ok) const
 double marley::MassTable::lookup_atomic_mass(int nucleus_pid, bool& exp,
   bool theory_ok) const
 {
-  // Find the atom's mass (in micro-amu) in the lookup table using its
-  // nucleus's particle ID number. If it can't be found, either return a
-  // theoretical mass using the liquid drop model or throw an error.
-  // std::unordered_map<int, double>::iterator search
-  auto search = atomic_masses_.find(nucleus_pid);
+  int Z = marley_utils::get_particle_Z(nucleus_pid);
+  int A = marley_utils::get_particle_A(nucleus_pid);
 
-  // If the mass was found in the lookup table, return it and flag it as an
-  // experimental value
-  if (search != atomic_masses_.end()) {
+  // Find the atom's mass (in micro-amu) in the lookup table using its
+  // nucleus's particle ID number. Only ground-state nucleus PDG codes are
+  // tabulated. If the mass can't be found, either return a theoretical mass
+  // using the liquid drop model or throw an error.
+  double mass;
+  if ( nucleus_pid == 10000*Z + 10*A + 1000000000
+    && find_atomic_mass(Z, A, mass) )
+  {
+    // If the mass was found in the lookup table, return it and flag it as an
+    // experimental value
     exp = true;
-    return search->second;
+    return mass;
   }
   // Otherwise, return a theoretical estimate using the liquid drop model or
   // throw an error depending on whether the user has indicated that using a
@@ -122,9 +338,6 @@ double marley::MassTable::lookup_atomic_mass(int nucleus_pid, bool& exp,
   else {
     exp = false;
 
-    int Z = marley_utils::get_particle_Z(nucleus_pid);
-    int A = marley_utils::get_particle_A(nucleus_pid);
-
     if (theory_ok) {
       return liquid_drop_model_atomic_mass(Z, A);
     }
@@ -137,15 +350,16 @@ double marley::MassTable::lookup_atomic_mass(int nucleus_pid, bool& exp,
 double marley::MassTable::lookup_atomic_mass(int Z, int A, bool& exp,
   bool theory_ok) const
 {
-  int nucleus_pid = marley_utils::get_nucleus_pid(Z, A);
-
-  auto search = atomic_masses_.find(nucleus_pid);
+  // The nucleons have their own particle PDG codes, which do not appear in
+  // the atomic mass table
+  bool nucleon = ( A == 1 && ( Z == 0 || Z == 1 ) );
 
   // If the mass was found in the lookup table, return it and flag it as an
   // experimental value
-  if (search != atomic_masses_.end()) {
+  double mass;
+  if ( !nucleon && find_atomic_mass(Z, A, mass) ) {
     exp = true;
-    return search->second;
+    return mass;
   }
   // Otherwise, return a theoretical estimate using the liquid drop model or
   // throw an error depending on whether the user has indicated that using a
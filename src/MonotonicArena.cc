@@ -0,0 +1,81 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <cstdint>
+
+#include "marley/MonotonicArena.hh"
+
+constexpr size_t marley::MonotonicArena::DEFAULT_BLOCK_SIZE;
+
+marley::MonotonicArena::MonotonicArena(size_t block_size)
+  : block_size_( block_size > 0u ? block_size : DEFAULT_BLOCK_SIZE )
+{
+}
+
+void* marley::MonotonicArena::allocate_from(size_t block_index,
+  size_t bytes, size_t alignment)
+{
+  Block& block = blocks_[ block_index ];
+  size_t offset = ( block_index == current_ ) ? offset_ : 0u;
+
+  // Padding needed to reach the requested alignment
+  auto address = reinterpret_cast<std::uintptr_t>( block.data.get() )
+    + offset;
+  size_t padding = static_cast<size_t>( (alignment
+    - address % alignment) % alignment );
+
+  if ( padding > block.size - offset
+    || bytes > block.size - offset - padding ) return nullptr;
+
+  current_ = block_index;
+  offset_ = offset + padding + bytes;
+  return block.data.get() + offset + padding;
+}
+
+void* marley::MonotonicArena::allocate(size_t bytes, size_t alignment) {
+  // Always hand out a unique address, even for empty requests
+  if ( bytes == 0u ) bytes = 1u;
+
+  // Try the current block, then any blocks retained after a rewind
+  for ( size_t b = current_; b < blocks_.size(); ++b ) {
+    void* result = this->allocate_from( b, bytes, alignment );
+    if ( result ) return result;
+  }
+
+  // Add a new block that is large enough for this allocation
+  size_t size = block_size_;
+  if ( bytes + alignment > size ) size = bytes + alignment;
+  blocks_.push_back( Block{ std::unique_ptr<unsigned char[]>(
+    new unsigned char[size]), size } );
+  capacity_ += size;
+
+  // Mark the new block as empty before allocating from it
+  current_ = blocks_.size() - 1u;
+  offset_ = 0u;
+  return this->allocate_from( current_, bytes, alignment );
+}
+
+void marley::MonotonicArena::reset() {
+  current_ = 0u;
+  offset_ = 0u;
+  if ( blocks_.size() <= 1u ) return;
+
+  // Replace the blocks with a single one of the same total size
+  blocks_.clear();
+  blocks_.push_back( Block{ std::unique_ptr<unsigned char[]>(
+    new unsigned char[capacity_]), capacity_ } );
+}
@@ -14,9 +14,12 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "marley/Generator.hh"
+#include "marley/Integrator.hh"
 #include "marley/NeutrinoSource.hh"
 
 marley::NeutrinoSource::NeutrinoSource(int particle_id) {
@@ -42,10 +45,9 @@ const std::set<int> marley::NeutrinoSource::pids_ = {
 double marley::NeutrinoSource::sample_incident_neutrino(int& pdg,
   marley::Generator& gen) const
 {
-  static double max = marley_utils::UNKNOWN_MAX;
   pdg = pid_;
   return gen.rejection_sample([this](double E)
-    -> double { return this->pdf(E); }, get_Emin(), get_Emax(), max);
+    -> double { return this->pdf(E); }, get_Emin(), get_Emax(), pdf_max_);
 }
 
 marley::FermiDiracNeutrinoSource::FermiDiracNeutrinoSource(int particle_id,
@@ -168,4 +170,184 @@ void marley::GridNeutrinoSource::check_for_errors() {
 
   if (sum_of_PDs <= 0.) throw marley::Error(std::string("All probability")
     + " density grid point values are zero for the neutrino source");
+
+  // Modifying the grid points above disables the fast bin lookup, so check
+  // the spacing again now that the grid is final
+  grid_.detect_spacing();
+}
+
+marley::TimeBinnedNeutrinoSource::TimeBinnedNeutrinoSource(int particle_id,
+  const std::vector<double>& time_edges,
+  const std::vector<double>& bin_weights,
+  std::vector< std::unique_ptr<marley::NeutrinoSource> >&& bin_sources)
+  : NeutrinoSource(particle_id), time_edges_(time_edges),
+  bin_sources_(std::move(bin_sources)),
+  Emin_(std::numeric_limits<double>::max()), Emax_(0.)
+{
+  size_t num_bins = bin_sources_.size();
+  if ( num_bins < 1u ) throw marley::Error("At least one time bin must be"
+    " defined for a time-binned neutrino source");
+
+  if ( time_edges_.size() != num_bins + 1u ) throw marley::Error("The"
+    " number of time bin edges for a time-binned neutrino source must be"
+    " one greater than the number of bins");
+
+  if ( bin_weights.size() != num_bins ) throw marley::Error("The number of"
+    " weights given for a time-binned neutrino source must be equal to"
+    " the number of bins");
+
+  for ( size_t j = 0u; j < num_bins; ++j ) {
+    if ( !(time_edges_.at(j) < time_edges_.at(j + 1u)) ) {
+      throw marley::Error("The time bin edges defined for a time-binned"
+        " neutrino source are not strictly increasing");
+    }
+  }
+
+  double weight_sum = 0.;
+  for ( size_t j = 0u; j < num_bins; ++j ) {
+
+    const auto& src = bin_sources_.at( j );
+    if ( !src ) throw marley::Error("Missing spectrum for a bin of a"
+      " time-binned neutrino source");
+
+    if ( src->get_pid() != pid_ ) throw marley::Error("The spectrum for"
+      " each bin of a time-binned neutrino source must produce the same"
+      " neutrino type as the source itself");
+
+    double weight = bin_weights.at( j );
+    if ( !(weight >= 0.) ) throw marley::Error("Negative weight given for"
+      " a bin of a time-binned neutrino source");
+
+    double Emin = src->get_Emin();
+    double Emax = src->get_Emax();
+    if ( !(Emin < Emax) ) throw marley::Error("Monoenergetic spectra may"
+      " not be used for the bins of a time-binned neutrino source");
+
+    // Normalize the spectrum for each bin so that the bin weights determine
+    // the number of neutrinos that it contains
+    double norm = marley_utils::num_integrate( [&src](double E)
+      -> double { return src->pdf(E); }, Emin, Emax );
+    if ( weight > 0. && !(norm > 0.) ) throw marley::Error("The spectrum"
+      " for a bin of a time-binned neutrino source does not have a positive"
+      " integral");
+
+    bin_norms_.push_back( norm > 0. ? norm : 1. );
+    bin_fractions_.push_back( weight );
+    weight_sum += weight;
+
+    Emin_ = std::min( Emin_, Emin );
+    Emax_ = std::max( Emax_, Emax );
+  }
+
+  if ( !(weight_sum > 0.) ) throw marley::Error("The weights given for a"
+    " time-binned neutrino source do not have a positive sum");
+
+  double running_sum = 0.;
+  for ( auto& frac : bin_fractions_ ) {
+    frac /= weight_sum;
+    running_sum += frac;
+    cumulative_fractions_.push_back( running_sum );
+  }
+}
+
+double marley::TimeBinnedNeutrinoSource::pdf(double E) const {
+  double result = 0.;
+  for ( size_t j = 0u, s = bin_sources_.size(); j < s; ++j ) {
+    if ( bin_fractions_[j] > 0. ) result += bin_fractions_[j] * bin_pdf(j, E);
+  }
+  return result;
+}
+
+double marley::TimeBinnedNeutrinoSource::sample_incident_neutrino(int& pdg,
+  marley::Generator& gen) const
+{
+  double r = gen.uniform_random_double( 0., cumulative_fractions_.back(),
+    false );
+  auto iter = std::upper_bound( cumulative_fractions_.cbegin(),
+    cumulative_fractions_.cend(), r );
+  size_t j = std::min<size_t>( iter - cumulative_fractions_.cbegin(),
+    bin_sources_.size() - 1u );
+
+  return bin_sources_[ j ]->sample_incident_neutrino( pdg, gen );
+}
+
+marley::HaloDMSource::HaloDMSource(int particle_id, double M, double LAMBDA,
+  double v0, double v_esc, double v_earth, size_t num_bins)
+  : MonoDMSource(particle_id, M, 0., LAMBDA), v0_(v0), v_esc_(v_esc),
+  v_earth_(v_earth), num_bins_(num_bins)
+{
+  if ( v0_ <= 0. ) throw marley::Error( "The most probable speed for a"
+    " dark matter halo source must be positive" );
+  if ( v_esc_ <= 0. ) throw marley::Error( "The escape speed for a dark"
+    " matter halo source must be positive" );
+  if ( v_earth_ < 0. ) throw marley::Error( "The detector speed for a dark"
+    " matter halo source may not be negative" );
+  if ( max_velocity() >= 1. ) throw marley::Error( "The maximum speed for"
+    " a dark matter halo source must be less than the speed of light" );
+  if ( num_bins_ == 0u ) throw marley::Error( "A dark matter halo source"
+    " needs at least one speed bin" );
+
+  // Tabulate the CDF on a fine uniform grid of speeds using the trapezoid
+  // rule. Its mean is also computed and used as the nominal speed returned by
+  // velocity().
+  constexpr size_t NUM_SPEEDS = 8 * NUM_QUANTILES;
+  double dv = max_velocity() / ( NUM_SPEEDS - 1u );
+  std::vector<double> cdf( NUM_SPEEDS, 0. );
+  double old_density = speed_pdf( 0. );
+  double mean = 0.;
+  for ( size_t i = 1u; i < NUM_SPEEDS; ++i ) {
+    double density = speed_pdf( i*dv );
+    cdf[ i ] = cdf[ i - 1u ] + 0.5 * ( old_density + density ) * dv;
+    mean += 0.5 * ( (i - 1u)*old_density + i*density ) * dv * dv;
+    old_density = density;
+  }
+
+  double norm = cdf.back();
+  if ( !(norm > 0.) ) throw marley::Error( "Failed to normalize the speed"
+    " distribution for a dark matter halo source" );
+  dm_velocity_ = mean / norm;
+
+  // Invert the CDF at equally-spaced probabilities. Between grid points, the
+  // CDF is treated as linear in the speed.
+  quantiles_.resize( NUM_QUANTILES );
+  quantiles_.front() = 0.;
+  quantiles_.back() = max_velocity();
+  size_t i = 1u;
+  for ( size_t k = 1u; k + 1u < NUM_QUANTILES; ++k ) {
+    double target = norm * k / ( NUM_QUANTILES - 1u );
+    while ( i + 1u < NUM_SPEEDS && cdf[ i ] < target ) ++i;
+    double width = cdf[ i ] - cdf[ i - 1u ];
+    double f = ( width > 0. ) ? ( target - cdf[ i - 1u ] ) / width : 0.;
+    quantiles_[ k ] = ( i - 1u + f ) * dv;
+  }
+}
+
+double marley::HaloDMSource::speed_pdf(double v) const {
+  if ( v < 0. || v > max_velocity() ) return 0.;
+
+  double v02 = v0_ * v0_;
+
+  // Limit of the general expression for a detector at rest in the galactic
+  // frame
+  if ( v_earth_ <= 0. ) {
+    if ( v > v_esc_ ) return 0.;
+    return v * v * std::exp( -v*v / v02 );
+  }
+
+  double upper = std::min( v + v_earth_, v_esc_ );
+  double diff = v - v_earth_;
+  double result = v / v_earth_ * ( std::exp(-diff*diff / v02)
+    - std::exp(-upper*upper / v02) );
+  return std::max( result, 0. );
+}
+
+double marley::HaloDMSource::sample_velocity(marley::Generator& gen) const {
+  return quantile( gen.uniform01() );
+}
+
+double marley::HaloDMSource::sample_velocity(marley::Generator& gen,
+  size_t bin) const
+{
+  double u = gen.uniform01();
+  return quantile( (bin + u) / num_bins_ );
 }
@@ -14,12 +14,14 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
 #include <cmath>
 #include <complex>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <limits>
 
 #include "marley/marley_utils.hh"
 #include "marley/Error.hh"
@@ -65,11 +67,14 @@ namespace {
 
 marley::NuclearReaction::NuclearReaction(ProcType pt, int pdg_a, int pdg_b,
   int pdg_c, int pdg_d, int q_d,
-  const std::shared_ptr<std::vector<marley::MatrixElement> >& mat_els)
+  const std::shared_ptr<std::vector<marley::MatrixElement> >& mat_els,
+  const PrecomputedData* precomputed)
   : q_d_( q_d ), matrix_elements_( mat_els )
 {
-  // Initialize the process type (NC, neutrino/antineutrino CC)
+  // Initialize the process type (NC, neutrino/antineutrino CC), and choose
+  // the matching per-level cross section kernel once and for all
   process_type_ = pt;
+  level_xs_kernel_ = select_level_xs_kernel( pt );
 
   // Initialize the PDG codes for the 2->2 scatter particles
   pdg_a_ = pdg_a;
@@ -84,6 +89,57 @@ marley::NuclearReaction::NuclearReaction(ProcType pt, int pdg_a, int pdg_b,
   Zf_ = (pdg_d_ % 10000000) / 10000;
   Af_ = (pdg_d_ % 10000) / 10;
 
+  if ( precomputed ) {
+    ma_ = precomputed->ma;
+    mb_ = precomputed->mb;
+    mc_ = precomputed->mc;
+    md_gs_ = precomputed->md_gs;
+    KEa_threshold_ = precomputed->KEa_threshold;
+  }
+  else compute_masses_and_threshold();
+
+  this->set_description();
+
+  // Terms in the logarithm of the Fermi function that depend only on the
+  // residue and ejectile
+  fermi_s_ = std::sqrt( 1. - std::pow(marley_utils::alpha * Zf_, 2) );
+  fermi_log_coeff_ = std::log( 2. * (1. + fermi_s_) )
+    - 2. * std::lgamma( 1. + 2.*fermi_s_ );
+  fermi_log_2_rho_mc_ = std::log( 2. * nuclear_radius_natural_units( Af_ )
+    * mc_ );
+
+  // Only charged-current reactions apply Coulomb corrections
+  if ( process_type_ != ProcType::NeutrinoCC
+    && process_type_ != ProcType::AntiNeutrinoCC ) return;
+
+  if ( precomputed ) {
+    fermi_table_ = precomputed->fermi_table;
+    fermi_table_eta_coeff_ = precomputed->fermi_table_eta_coeff;
+    fermi_table_x_min_ = precomputed->fermi_table_x_min;
+    fermi_table_inv_dx_ = precomputed->fermi_table_inv_dx;
+  }
+  else build_fermi_table();
+}
+
+marley::NuclearReaction::PrecomputedData
+  marley::NuclearReaction::precomputed_data() const
+{
+  PrecomputedData data;
+  data.pdg_a = pdg_a_;
+  data.ma = ma_;
+  data.mb = mb_;
+  data.mc = mc_;
+  data.md_gs = md_gs_;
+  data.KEa_threshold = KEa_threshold_;
+  data.fermi_table = fermi_table_;
+  data.fermi_table_eta_coeff = fermi_table_eta_coeff_;
+  data.fermi_table_x_min = fermi_table_x_min_;
+  data.fermi_table_inv_dx = fermi_table_inv_dx_;
+  return data;
+}
+
+void marley::NuclearReaction::compute_masses_and_threshold() {
+
   const marley::MassTable& mt = marley::MassTable::Instance();
 
   // Get the particle masses from the mass table
@@ -106,8 +162,7 @@ marley::NuclearReaction::NuclearReaction(ProcType pt, int pdg_a, int pdg_b,
     // (e.g., q_d_ != 0), then approximate its ground-state ionized mass by
     // subtracting the appropriate number of electron masses from its atomic
     // (i.e., neutral) ground state mass.
-    md_gs_ = mt.get_atomic_mass(pdg_d_)
-      - (q_d_ * mt.get_particle_mass(marley_utils::ELECTRON));
+    md_gs_ = mt.get_ion_mass( pdg_d_, q_d_ );
     //std::cout<<"debugging mass: "<<std::endl;
     //std::cout<<"pdg_d_: "<<pdg_d_<<std::endl;
     //std::cout<<"mt.get_atomic_mass: "<<mt.get_atomic_mass(pdg_d_)<<std::endl;
@@ -149,8 +204,56 @@ marley::NuclearReaction::NuclearReaction(ProcType pt, int pdg_a, int pdg_b,
   //std::cout<<"\tmass d: "<<md_gs_<<std::endl;
 
   //std::cout<<"threshold mass required: "<<KEa_threshold_<<std::endl;
+}
 
-  this->set_description();
+void marley::NuclearReaction::build_fermi_table() {
+
+  // Range of ejectile momenta (in units of its mass) covered by the table.
+  // Beyond these limits the Fermi function is evaluated exactly.
+  constexpr double P_OVER_M_MIN = 1e-2;
+  constexpr double P_OVER_M_MAX = 1e4;
+
+  // Number of grid points per decade of ejectile momentum. Linear
+  // interpolation of ln(F) then reproduces the exact Fermi function to
+  // better than one part in 10^5.
+  constexpr int POINTS_PER_DECADE = 200;
+
+  // For a final-state antilepton, the Fermi function is exponentially
+  // suppressed at low speeds by a factor of exp(-2*pi*alpha*Zf / beta_c).
+  // That factor is removed from the tabulated values and restored during
+  // interpolation.
+  bool c_minus = ( pdg_c_ > 0 );
+  fermi_table_eta_coeff_ = c_minus ? 0. : 2. * marley_utils::pi
+    * marley_utils::alpha * Zf_;
+
+  double x_min = std::log( P_OVER_M_MIN );
+  double x_max = std::log( P_OVER_M_MAX );
+  int num_intervals = static_cast<int>( std::lround( POINTS_PER_DECADE
+    * std::log10(P_OVER_M_MAX / P_OVER_M_MIN) ) );
+  double dx = ( x_max - x_min ) / num_intervals;
+
+  fermi_table_.clear();
+  fermi_table_.reserve( num_intervals + 1 );
+  for ( int i = 0; i <= num_intervals; ++i ) {
+    double beta_gamma = std::exp( x_min + i*dx );
+    double beta_c = beta_gamma / std::sqrt( 1. + beta_gamma*beta_gamma );
+    fermi_table_.push_back( log_exact_fermi_function(beta_c)
+      + fermi_table_eta_coeff_ / beta_c );
+  }
+
+  // The logarithm is evaluated directly, so every grid point should be
+  // finite. As a safeguard, drop any leading points that are not so that
+  // they will be handled by exact evaluation instead.
+  size_t first_good = 0u;
+  for ( size_t i = 0u; i < fermi_table_.size(); ++i ) {
+    if ( !std::isfinite(fermi_table_[i]) ) first_good = i + 1u;
+  }
+  fermi_table_.erase( fermi_table_.begin(), fermi_table_.begin()
+    + first_good );
+  if ( fermi_table_.size() < 2u ) fermi_table_.clear();
+
+  fermi_table_x_min_ = x_min + first_good*dx;
+  fermi_table_inv_dx_ = 1. / dx;
 }
 
 // Fermi function used to calculate cross-sections
@@ -161,17 +264,33 @@ marley::NuclearReaction::NuclearReaction(ProcType pt, int pdg_a, int pdg_b,
 // 2-2 scattering.
 double marley::NuclearReaction::fermi_function(double beta_c) const {
 
+  // Interpolate ln(F) from the table if possible
+  if ( !fermi_table_.empty() && beta_c > 0. && beta_c < 1. ) {
+    double x = std::log( beta_c / std::sqrt(1. - beta_c*beta_c) );
+    double u = ( x - fermi_table_x_min_ ) * fermi_table_inv_dx_;
+    if ( u >= 0. && u < fermi_table_.size() - 1u ) {
+      size_t i = static_cast<size_t>( u );
+      double t = u - i;
+      return std::exp( fermi_table_[i] + t*(fermi_table_[i + 1u]
+        - fermi_table_[i]) - fermi_table_eta_coeff_ / beta_c );
+    }
+  }
+
+  return exact_fermi_function( beta_c );
+}
+
+double marley::NuclearReaction::exact_fermi_function(double beta_c) const {
+  return std::exp( log_exact_fermi_function(beta_c) );
+}
+
+double marley::NuclearReaction::log_exact_fermi_function(double beta_c) const
+{
   // If the PDG code for particle c is positive, then it is a
   // negatively-charged lepton.
   bool c_minus = (pdg_c_ > 0);
 
-  // Lorentz factor gamma for particle c
-  double gamma_c = std::pow(1. - beta_c*beta_c, -marley_utils::ONE_HALF);
-
-  double s = std::sqrt(1. - std::pow(marley_utils::alpha * Zf_, 2));
-
-  // Estimate the nuclear radius (in MeV^(-1))
-  double rho = nuclear_radius_natural_units( Af_ );
+  // Product of the speed and Lorentz factor for particle c
+  double beta_gamma_c = beta_c / std::sqrt( 1. - beta_c*beta_c );
 
   // Sommerfeld parameter
   double eta = marley_utils::alpha * Zf_ / beta_c;
@@ -180,13 +299,13 @@ double marley::NuclearReaction::fermi_function(double beta_c) const {
   // an antilepton
   if ( !c_minus ) eta *= -1;
 
-  // Complex variable for the gamma function
-  std::complex<double> a(s, eta);
-  double b = std::tgamma(1 + 2*s);
-
-  return 2 * (1 + s) * std::pow(2*beta_c*gamma_c*rho*mc_, 2*s-2)
-    * std::exp(marley_utils::pi*eta) * std::norm(marley_utils::gamma(a))
-    / std::pow(b, 2);
+  // F = 2(1 + s) * (2*beta*gamma*rho*mc)^(2s - 2) * exp(pi*eta)
+  //   * |Gamma(s + i*eta)|^2 / Gamma(1 + 2s)^2
+  // The factors that do not depend on beta_c were computed by the
+  // constructor.
+  return fermi_log_coeff_ + ( 2.*fermi_s_ - 2. ) * ( fermi_log_2_rho_mc_
+    + std::log(beta_gamma_c) ) + marley_utils::pi * eta
+    + marley_utils::log_norm_gamma( fermi_s_, eta );
 }
 
 // Return the maximum residue excitation energy E_level that can
@@ -206,14 +325,73 @@ double marley::NuclearReaction::max_level_energy(double KEa) const {
   return E_CM - mc_ - md_gs_;
 }
 
+size_t marley::NuclearReaction::prewarm_decays(double KEa_max,
+  marley::StructureDatabase& sdb) const
+{
+  const auto& mt = marley::MassTable::Instance();
+  double Ex_max = max_level_energy( KEa_max );
+  double unbound_threshold = mt.unbound_threshold( pdg_d_ );
+  bool have_levels = ( sdb.get_decay_scheme(pdg_d_) != nullptr );
+
+  int twoJ_gs;
+  marley::Parity P_gs;
+  sdb.get_gs_spin_parity( pdg_b_, twoJ_gs, P_gs );
+
+  // The same rules as in create_event() are used to choose the
+  // spin-parities of the initial states (see NucleusDecayer for the choice
+  // between discrete and continuum de-excitations)
+  size_t num_states = 0u;
+  for ( const auto& me : *matrix_elements_ ) {
+    double E_level = me.level_energy();
+    if ( !(E_level > 0.) || E_level > Ex_max ) continue;
+    if ( have_levels && E_level <= unbound_threshold ) continue;
+
+    std::vector<int> twoJs;
+    marley::Parity P = P_gs;
+    const marley::Level* final_lev = me.level();
+    if ( final_lev ) {
+      twoJs.push_back( final_lev->twoJ() );
+      P = final_lev->parity();
+    }
+    else if ( me.type() == ME_Type::FERMI ) twoJs.push_back( twoJ_gs );
+    else if ( twoJ_gs == 0 ) twoJs.push_back( 2 );
+    else for ( int twoJ = std::abs(twoJ_gs - 2); twoJ <= twoJ_gs + 2;
+      twoJ += 2 ) twoJs.push_back( twoJ );
+
+    marley::Particle residue( pdg_d_, md_gs_ + E_level, q_d_ );
+    for ( int twoJ : twoJs ) {
+      sdb.get_hf_decay( residue, E_level, twoJ, P );
+      ++num_states;
+    }
+  }
+  return num_states;
+}
+
 double marley::NuclearReaction::threshold_kinetic_energy() const {
   return KEa_threshold_;
 }
 
 // Creates an event object by sampling the appropriate quantities and
 // performing kinematic calculations
-marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa, 
+marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
   marley::Generator& gen) const
+{
+  marley::Event ev;
+  this->create_event( pdg_a, KEa, gen, ev );
+  return ev;
+}
+
+marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
+  double dm_mass, double dm_velocity, double dm_cutoff,
+  marley::Generator& gen) const
+{
+  marley::Event ev;
+  this->create_event( pdg_a, KEa, dm_mass, dm_velocity, dm_cutoff, gen, ev );
+  return ev;
+}
+
+void marley::NuclearReaction::create_event(int pdg_a, double KEa,
+  marley::Generator& gen, marley::Event& ev) const
 {
   // Check that the projectile supplied to this event is correct. If not, alert
   // the user that this event does not use the requested projectile.
@@ -231,63 +409,11 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
 
   /// @todo Add more error checks to NuclearReaction::create_event as necessary
 
-  // Create an empty vector of sampling weights (partial total cross
-  // sections to each kinematically accessible final level)
-  std::vector<double> level_weights;
-
-  // Create a discrete distribution object for level sampling.
-  // Its default constructor creates a single weight of 1.
-  // We will always explicitly give it weights to use when sampling
-  // levels, so we won't worry about its default behavior.
-  static std::discrete_distribution<size_t> ldist;
-
-  // Compute the total cross section for a transition to each individual nuclear
-  // level, and save the results in the level_weights vector (which will be
-  // cleared by summed_xs_helper() before being loaded with the cross sections).
-  // The summed_xs_helper() method can also be used for differential
-  // (d\sigma/d\cos\theta_c^{CM}) cross sections, so supply a dummy cos_theta_c_cm
-  // value and request total cross sections by setting the last argument to false.
-  double dummy = 0.;
-  //std::cout<<"summed_xs_helper called here3"<<std::endl;
-  //std::cout<<" any chance you can access process_type_ here?: "<<process_type_<<std::endl;
-  double sum_of_xsecs = summed_xs_helper(pdg_a, KEa, dummy,
-    						&level_weights, false);
-
-  // Note that the elements in matrix_elements_ are given in order of
-  // increasing excitation energy (this is currently enforced by the reaction
-  // data format and is checked during parsing). This ensures that we can
-  // sample a matrix element index from level_weights (which is populated in
-  // the same order by summed_xs_helper()) and have it refer to the correct
-  // object.
-
-  // Complain if none of the levels we have data for are kinematically allowed
-  //std::cout<<"Does it break here1?"<<std::endl;
-  if ( level_weights.empty() ) {
-    throw marley::Error("Could not create this event. The DecayScheme object"
-      " associated with this reaction does not contain data for any"
-      " kinematically accessible levels for a projectile kinetic energy of "
-      + std::to_string(KEa) + " MeV (max E_level = "
-      + std::to_string( max_level_energy(KEa) ) + " MeV).");
-  }
-
-  // Complain if the total cross section (the sum of all partial level cross
-  // sections) is zero or negative (the latter is just to cover all possibilities).
-  if ( sum_of_xsecs <= 0. ) {
-    throw marley::Error("Could not create this event. All kinematically"
-      " accessible levels for a projectile kinetic energy of "
-      + std::to_string(KEa) + " MeV (max E_level = "
-      + std::to_string( max_level_energy(KEa) )
-      + " MeV) have vanishing matrix elements.");
-  }
-
-  // Create a list of parameters used to supply the weights to our discrete
-  // level sampling distribution
-  std::discrete_distribution<size_t>::param_type params( level_weights.begin(),
-    level_weights.end() );
-
-  // Sample a matrix_element using our discrete distribution and the
-  // current set of weights
-  size_t me_index = gen.sample_from_distribution( ldist, params );
+  // Sample a matrix element (and thus a final nuclear level) using the
+  // partial total cross sections as weights
+  double level_weight = 1.;
+  size_t me_index = sample_matrix_element_index( pdg_a, KEa, 0., 0., 0.,
+    false, gen, level_weight );
 
   const auto& sampled_matrix_el = matrix_elements_->at( me_index );
 
@@ -313,8 +439,7 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
 
   // Sample a CM frame azimuthal scattering angle (phi) uniformly on [0, 2*pi).
   // We can do this because the matrix elements are azimuthally invariant
-  double phi_c_cm = gen.uniform_random_double( 0.,
-    marley_utils::two_pi, false );
+  double phi_c_cm = gen.uniform( 0., marley_utils::two_pi );
 
   // Load the initial residue twoJ and parity values into twoJ and P. These
   // variables are included in the event record and used by NucleusDecayer
@@ -398,18 +523,20 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa,
     << " level with Ex = " << E_level << " MeV and spin-parity "
     << static_cast<double>( twoJ ) / 2. << P;
 
-  // Create the preliminary event object (after 2-->2 scattering, but before
-  // de-excitation of the residual nucleus)
-  marley::Event event = make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm,
-    Ec_cm, Ed_cm, E_level, twoJ, P );
+  // Load the preliminary event object (after 2-->2 scattering, but before
+  // de-excitation of the residual nucleus). It will be processed later by
+  // the NucleusDecayer class. Assume that the target is a neutral atom
+  // (q_b = 0) and assign the correct charge to the residue.
+  make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm, Ec_cm, Ed_cm,
+    E_level, twoJ, P, ev, 0, q_d_ );
 
-  // Return the preliminary event object (to be processed later by the
-  // NucleusDecayer class)
-  return event;
+  // Include any level bias in the event weight
+  ev.set_weight( level_weight );
 }
 
-marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
-  marley::Generator& gen) const
+void marley::NuclearReaction::create_event(int pdg_a, double KEa,
+  double dm_mass, double dm_velocity, double dm_cutoff,
+  marley::Generator& gen, marley::Event& ev) const
 {
   // Check that the projectile supplied to this event is correct. If not, alert
   // the user that this event does not use the requested projectile.
@@ -429,70 +556,12 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa, doubl
 
   /// @todo Add more error checks to NuclearReaction::create_event as necessary
 
-  // Create an empty vector of sampling weights (partial total cross
-  // sections to each kinematically accessible final level)
-  std::vector<double> level_weights;
-
-  // Create a discrete distribution object for level sampling.
-  // Its default constructor creates a single weight of 1.
-  // We will always explicitly give it weights to use when sampling
-  // levels, so we won't worry about its default behavior.
-  static std::discrete_distribution<size_t> ldist;
-
-  // Compute the total cross section for a transition to each individual nuclear
-  // level, and save the results in the level_weights vector (which will be
-  // cleared by summed_xs_helper() before being loaded with the cross sections).
-  // The summed_xs_helper() method can also be used for differential
-  // (d\sigma/d\cos\theta_c^{CM}) cross sections, so supply a dummy cos_theta_c_cm
-  // value and request total cross sections by setting the last argument to false.
-  double dummy = 0.;
-  double sum_of_xsecs;
-  //std::cout<<"summed_xs_helper called here1"<<std::endl;
-  //std::cout<<" any chance you can access process_type_ here?: "<<process_type_<<std::endl;
-  if ( process_type_ == 4 ) {
-    sum_of_xsecs = summed_xs_helper(pdg_a, KEa, dm_mass, dm_velocity, dm_cutoff, dummy, &level_weights, false);
-  } // <---- if it's dm use the dm version of summed_xs_helper
-  else { // <--- else just do the normal one..
-
-    sum_of_xsecs = summed_xs_helper(pdg_a, KEa, dummy,
-      &level_weights, false);
-  }
-  //std::cout<<"sum_of_xsecs: "<<sum_of_xsecs<<" |"<<std::endl;
-  // Note that the elements in matrix_elements_ are given in order of
-  // increasing excitation energy (this is currently enforced by the reaction
-  // data format and is checked during parsing). This ensures that we can
-  // sample a matrix element index from level_weights (which is populated in
-  // the same order by summed_xs_helper()) and have it refer to the correct
-  // object.
-
-  // Complain if none of the levels we have data for are kinematically allowed
-  //std::cout<<"Does it break here2?"<<std::endl;
-  if ( level_weights.empty() ) {
-    throw marley::Error("Could not create this event. The DecayScheme object"
-      " associated with this reaction does not contain data for any"
-      " kinematically accessible levels for a projectile kinetic energy of "
-      + std::to_string(KEa) + " MeV (max E_level = "
-      + std::to_string( max_level_energy(KEa) ) + " MeV).");
-  }
-
-  // Complain if the total cross section (the sum of all partial level cross
-  // sections) is zero or negative (the latter is just to cover all possibilities).
-  if ( sum_of_xsecs <= 0. ) {
-    throw marley::Error("Could not create this event. All kinematically"
-      " accessible levels for a projectile kinetic energy of "
-      + std::to_string(KEa) + " MeV (max E_level = "
-      + std::to_string( max_level_energy(KEa) )
-      + " MeV) have vanishing matrix elements.");
-  }
-
-  // Create a list of parameters used to supply the weights to our discrete
-  // level sampling distribution
-  std::discrete_distribution<size_t>::param_type params( level_weights.begin(),
-    level_weights.end() );
-
-  // Sample a matrix_element using our discrete distribution and the
-  // current set of weights
-  size_t me_index = gen.sample_from_distribution( ldist, params );
+  // Sample a matrix element (and thus a final nuclear level) using the
+  // partial total cross sections as weights. Dark matter reactions use the
+  // dark matter version of summed_xs_helper().
+  double level_weight = 1.;
+  size_t me_index = sample_matrix_element_index( pdg_a, KEa, dm_mass,
+    dm_velocity, dm_cutoff, process_type_ == 4, gen, level_weight );
 
   const auto& sampled_matrix_el = matrix_elements_->at( me_index );
 
@@ -521,8 +590,7 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa, doubl
 
   // Sample a CM frame azimuthal scattering angle (phi) uniformly on [0, 2*pi).
   // We can do this because the matrix elements are azimuthally invariant
-  double phi_c_cm = gen.uniform_random_double( 0.,
-    marley_utils::two_pi, false );
+  double phi_c_cm = gen.uniform( 0., marley_utils::two_pi );
 
   // Load the initial residue twoJ and parity values into twoJ and P. These
   // variables are included in the event record and used by NucleusDecayer
@@ -606,32 +674,507 @@ marley::Event marley::NuclearReaction::create_event(int pdg_a, double KEa, doubl
     << " level with Ex = " << E_level << " MeV and spin-parity "
     << static_cast<double>( twoJ ) / 2. << P;
 
-  // Create the preliminary event object (after 2-->2 scattering, but before
-  // de-excitation of the residual nucleus)
-  marley::Event event = make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm,
-    Ec_cm, Ed_cm, E_level, twoJ, P );
+  // Load the preliminary event object (after 2-->2 scattering, but before
+  // de-excitation of the residual nucleus). It will be processed later by
+  // the NucleusDecayer class. Assume that the target is a neutral atom
+  // (q_b = 0) and assign the correct charge to the residue.
+  make_event_object( KEa, pc_cm, cos_theta_c_cm, phi_c_cm, Ec_cm, Ed_cm,
+    E_level, twoJ, P, ev, 0, q_d_ );
 
-  // Return the preliminary event object (to be processed later by the
-  // NucleusDecayer class)
-  return event;
+  // Include any level bias in the event weight
+  ev.set_weight( level_weight );
+}
+
+size_t marley::NuclearReaction::sample_matrix_element_index(int pdg_a,
+  double KEa, double dm_mass, double dm_velocity, double dm_cutoff, bool dm,
+  marley::Generator& gen, double& weight) const
+{
+  // The event weight is the ratio of the unbiased and biased probabilities
+  // of choosing the sampled level
+  auto sample = [this, &gen, &weight](const LevelWeightCache& cache)
+    -> size_t
+  {
+    size_t index = gen.sample_from_distribution( cache.table );
+    weight = 1.;
+    if ( !level_biases_.empty() ) {
+      weight = cache.bias_norm
+        / level_bias( matrix_elements_->at(index).level_energy() );
+    }
+    return index;
+  };
+
+  // Reuse the weights from the previous event if nothing has changed
+  if ( level_cache_.matches(KEa, dm_mass, dm_velocity, dm_cutoff, dm) ) {
+    return sample( level_cache_ );
+  }
+
+  // Dark matter sources with a distribution of speeds request the same
+  // small set of (binned) speeds over and over, so look for weights that
+  // were saved for an earlier event
+  if ( dm ) {
+    for ( const auto& cache : dm_level_caches_ ) {
+      if ( cache.matches(KEa, dm_mass, dm_velocity, dm_cutoff, dm) ) {
+        return sample( cache );
+      }
+    }
+  }
+
+  // Energies covered by the cross section table are handled without
+  // recomputing the level weights. This keeps sources with a continuous
+  // spectrum (and external flux drivers) from redoing work for every event.
+  if ( !dm && in_xs_table(KEa) ) {
+    return sample_tabulated_level( KEa, gen, weight );
+  }
+
+  // Get the vector of sampling weights (partial total cross sections to each
+  // kinematically accessible final level). Its storage is reused from one
+  // event to the next.
+  level_cache_.valid = false;
+  std::vector<double>& level_weights = level_cache_.level_weights;
+
+  // Compute the total cross section for a transition to each individual nuclear
+  // level, and save the results in the level_weights vector (which will be
+  // cleared by summed_xs_helper() before being loaded with the cross sections).
+  // The summed_xs_helper() method can also be used for differential
+  // (d\sigma/d\cos\theta_c^{CM}) cross sections, so supply a dummy cos_theta_c_cm
+  // value and request total cross sections by setting the last argument to false.
+  // If a cross section table is available, interpolate the weights from it.
+  double dummy = 0.;
+  double sum_of_xsecs;
+  if ( dm ) sum_of_xsecs = summed_xs_helper( pdg_a, KEa, dm_mass, dm_velocity,
+    dm_cutoff, dummy, &level_weights, false );
+  else if ( in_xs_table(KEa) ) sum_of_xsecs = tabulated_xs( KEa,
+    &level_weights );
+  else sum_of_xsecs = summed_xs_helper( pdg_a, KEa, dummy, &level_weights,
+    false );
+
+  // Note that the elements in matrix_elements_ are given in order of
+  // increasing excitation energy (this is currently enforced by the reaction
+  // data format and is checked during parsing). This ensures that we can
+  // sample a matrix element index from level_weights (which is populated in
+  // the same order by summed_xs_helper()) and have it refer to the correct
+  // object.
+
+  // Complain if none of the levels we have data for are kinematically allowed
+  if ( level_weights.empty() ) {
+    throw marley::Error("Could not create this event. The DecayScheme object"
+      " associated with this reaction does not contain data for any"
+      " kinematically accessible levels for a projectile kinetic energy of "
+      + std::to_string(KEa) + " MeV (max E_level = "
+      + std::to_string( max_level_energy(KEa) ) + " MeV).");
+  }
+
+  // Complain if the total cross section (the sum of all partial level cross
+  // sections) is zero or negative (the latter is just to cover all possibilities).
+  if ( sum_of_xsecs <= 0. ) {
+    throw marley::Error("Could not create this event. All kinematically"
+      " accessible levels for a projectile kinetic energy of "
+      + std::to_string(KEa) + " MeV (max E_level = "
+      + std::to_string( max_level_energy(KEa) )
+      + " MeV) have vanishing matrix elements.");
+  }
+
+  // Apply the level bias factors (if any)
+  level_cache_.bias_norm = 1.;
+  if ( !level_biases_.empty() ) {
+    double biased_sum = 0.;
+    for ( size_t j = 0u; j < level_weights.size(); ++j ) {
+      level_weights[ j ] *= level_bias( matrix_elements_->at(j)
+        .level_energy() );
+      biased_sum += level_weights[ j ];
+    }
+    level_cache_.bias_norm = biased_sum / sum_of_xsecs;
+  }
+
+  // Build the alias table for the current set of weights and remember the
+  // inputs that produced it
+  level_cache_.table.build( level_weights.cbegin(), level_weights.cend() );
+  level_cache_.dm = dm;
+  level_cache_.KEa = KEa;
+  level_cache_.dm_mass = dm_mass;
+  level_cache_.dm_velocity = dm_velocity;
+  level_cache_.dm_cutoff = dm_cutoff;
+  level_cache_.valid = true;
+
+  if ( dm && dm_level_caches_.size() < MAX_DM_LEVEL_CACHES_ ) {
+    dm_level_caches_.push_back( level_cache_ );
+  }
+
+  return sample( level_cache_ );
+}
+
+size_t marley::NuclearReaction::sample_tabulated_level(double KEa,
+  marley::Generator& gen, double& weight) const
+{
+  size_t num_levels = matrix_elements_->size();
+
+  // Build the running sums of the level weights at every grid point if
+  // needed. Levels with vanishing matrix elements are given zero weight.
+  if ( xs_table_level_cdfs_.empty() ) {
+    xs_table_level_cdfs_.resize( xs_table_levels_.size() );
+    if ( !level_biases_.empty() ) {
+      xs_table_unbiased_cdfs_.resize( xs_table_levels_.size() );
+    }
+    for ( size_t i = 0u; i < xs_table_KEs_.size(); ++i ) {
+      double sum = 0.;
+      double unbiased_sum = 0.;
+      for ( size_t j = 0u; j < num_levels; ++j ) {
+        size_t k = i*num_levels + j;
+        const auto& mat_el = matrix_elements_->at( j );
+        double xs = ( mat_el.strength() == 0. ) ? 0. : xs_table_levels_[ k ];
+        unbiased_sum += xs;
+        sum += xs * level_bias( mat_el.level_energy() );
+        xs_table_level_cdfs_[ k ] = sum;
+        if ( !level_biases_.empty() ) {
+          xs_table_unbiased_cdfs_[ k ] = unbiased_sum;
+        }
+      }
+    }
+  }
+
+  // Find the grid interval containing KEa in the same way as tabulated_xs()
+  auto iter = std::upper_bound( xs_table_KEs_.cbegin(), xs_table_KEs_.cend(),
+    KEa );
+  size_t i_hi = std::min( static_cast<size_t>(iter - xs_table_KEs_.cbegin()),
+    xs_table_KEs_.size() - 1u );
+  size_t i_lo = ( i_hi > 0u ) ? i_hi - 1u : 0u;
+
+  double KE_lo = xs_table_KEs_[ i_lo ];
+  double KE_hi = xs_table_KEs_[ i_hi ];
+  double t = ( KE_hi > KE_lo ) ? ( KEa - KE_lo ) / ( KE_hi - KE_lo ) : 0.;
+
+  // The levels are stored in order of increasing excitation energy, so the
+  // kinematically accessible ones come first
+  double max_E_level = max_level_energy( KEa );
+  size_t num_accessible = std::upper_bound( matrix_elements_->cbegin(),
+    matrix_elements_->cend(), max_E_level, []( double E,
+    const marley::MatrixElement& me ) -> bool
+    { return E < me.level_energy(); } ) - matrix_elements_->cbegin();
+
+  if ( num_accessible == 0u ) {
+    throw marley::Error("Could not create this event. The DecayScheme object"
+      " associated with this reaction does not contain data for any"
+      " kinematically accessible levels for a projectile kinetic energy of "
+      + std::to_string(KEa) + " MeV (max E_level = "
+      + std::to_string( max_E_level ) + " MeV).");
+  }
+
+  const double* cdf_lo = &xs_table_level_cdfs_[ i_lo * num_levels ];
+  const double* cdf_hi = &xs_table_level_cdfs_[ i_hi * num_levels ];
+  size_t last = num_accessible - 1u;
+  double w_lo = ( 1. - t ) * cdf_lo[ last ];
+  double w_hi = t * cdf_hi[ last ];
+
+  if ( !(w_lo + w_hi > 0.) ) {
+    throw marley::Error("Could not create this event. All kinematically"
+      " accessible levels for a projectile kinetic energy of "
+      + std::to_string(KEa) + " MeV (max E_level = "
+      + std::to_string( max_E_level ) + " MeV) have vanishing matrix"
+      " elements.");
+  }
+
+  // Choose a grid point, then a level from its running sums
+  double r = gen.uniform_random_double( 0., w_lo + w_hi, false );
+  const double* cdf = cdf_hi;
+  double x = ( r - w_lo ) / t;
+  if ( r < w_lo ) {
+    cdf = cdf_lo;
+    x = r / ( 1. - t );
+  }
+
+  size_t index = std::upper_bound( cdf, cdf + num_accessible, x ) - cdf;
+
+  // Guard against roundoff by choosing the last level with nonzero weight
+  if ( index >= num_accessible ) {
+    index = std::lower_bound( cdf, cdf + num_accessible, cdf[last] ) - cdf;
+  }
+
+  weight = 1.;
+  if ( !level_biases_.empty() ) {
+    double unbiased_sum = ( 1. - t ) * xs_table_unbiased_cdfs_[
+      i_lo*num_levels + last ] + t * xs_table_unbiased_cdfs_[
+      i_hi*num_levels + last ];
+    weight = ( w_lo + w_hi ) / unbiased_sum
+      / level_bias( matrix_elements_->at(index).level_energy() );
+  }
+
+  return index;
+}
+
+void marley::NuclearReaction::add_level_bias(const LevelBias& bias) {
+  if ( !(bias.factor > 0.) ) throw marley::Error("Invalid level bias factor "
+    + std::to_string(bias.factor) + " encountered for the reaction "
+    + description_ + ". Bias factors must be positive.");
+  if ( bias.Ex_max < bias.Ex_min ) throw marley::Error("Invalid excitation"
+    " energy range [" + std::to_string(bias.Ex_min) + ", "
+    + std::to_string(bias.Ex_max) + "] MeV encountered in a level bias for"
+    " the reaction " + description_);
+
+  level_biases_.push_back( bias );
+
+  // Cached level weights were computed using the old bias factors
+  level_cache_.valid = false;
+  dm_level_caches_.clear();
+  xs_table_level_cdfs_.clear();
+  xs_table_unbiased_cdfs_.clear();
+}
+
+void marley::NuclearReaction::clear_level_biases() {
+  level_biases_.clear();
+  level_cache_.valid = false;
+  dm_level_caches_.clear();
+  xs_table_level_cdfs_.clear();
+  xs_table_unbiased_cdfs_.clear();
+}
+
+double marley::NuclearReaction::level_bias(double Ex) const {
+  double factor = 1.;
+  for ( const auto& bias : level_biases_ ) {
+    if ( Ex >= bias.Ex_min && Ex <= bias.Ex_max ) factor *= bias.factor;
+  }
+  return factor;
 }
 
 // Compute the total reaction cross section (summed over all final nuclear levels)
 // in units of MeV^(-2) using the center of momentum frame.
 double marley::NuclearReaction::total_xs(int pdg_a, double KEa) const {
+  // Use the cross section table if one is available
+  if ( pdg_a == pdg_a_ && in_xs_table(KEa) ) {
+    return tabulated_xs( KEa, nullptr );
+  }
+  return exact_total_xs( pdg_a, KEa );
+}
+
+double marley::NuclearReaction::exact_total_xs(int pdg_a, double KEa) const {
   double dummy_cos_theta = 0.;
   //std::cout<<"summed_xs_helper called here2"<<std::endl;
   return summed_xs_helper(pdg_a, KEa, dummy_cos_theta, nullptr, false);
 }
 
+double marley::NuclearReaction::exact_xs_by_level(double KEa,
+  std::vector<double>& level_xsecs) const
+{
+  std::vector<double> partial_xsecs;
+  double dummy_cos_theta = 0.;
+  double xsec = summed_xs_helper( pdg_a_, KEa, dummy_cos_theta,
+    &partial_xsecs, false );
+
+  // Spread the partial cross sections over all levels. They were stored by
+  // summed_xs_helper() only for the kinematically accessible levels with
+  // nonvanishing matrix elements.
+  level_xsecs.assign( matrix_elements_->size(), 0. );
+  size_t k = 0u;
+  for ( size_t j = 0u; j < matrix_elements_->size()
+    && k < partial_xsecs.size(); ++j )
+  {
+    if ( matrix_elements_->at(j).strength() != 0. ) {
+      level_xsecs[ j ] = partial_xsecs[ k++ ];
+    }
+  }
+
+  return xsec;
+}
+
+void marley::NuclearReaction::build_xs_table( double KEa_max ) {
+
+  clear_xs_table();
+
+  // Nothing needs to be tabulated if the reaction is never above threshold
+  double KEa_min = std::max( KEa_threshold_, 0. );
+  if ( KEa_max <= KEa_min || matrix_elements_->empty() ) return;
+
+  // Number of equal intervals in the initial grid
+  constexpr int NUM_INITIAL_INTERVALS = 64;
+
+  // Maximum number of times that an initial interval may be bisected
+  constexpr int MAX_REFINEMENT_DEPTH = 12;
+
+  // Relative tolerance for linear interpolation of the total cross section
+  constexpr double REL_TOLERANCE = 1e-4;
+
+  // Start with a uniform grid. Also add the energies at which each level
+  // becomes accessible, since the partial cross sections have kinks there.
+  std::vector<double> KEs;
+  for ( int i = 0; i <= NUM_INITIAL_INTERVALS; ++i ) {
+    KEs.push_back( KEa_min + i * (KEa_max - KEa_min) / NUM_INITIAL_INTERVALS );
+  }
+
+  auto KE_levels = level_threshold_KEs( KEa_min, KEa_max );
+  KEs.insert( KEs.end(), KE_levels.cbegin(), KE_levels.cend() );
+
+  std::sort( KEs.begin(), KEs.end() );
+  KEs.erase( std::unique(KEs.begin(), KEs.end()), KEs.end() );
+
+  // Refine the grid by bisecting each interval until the total cross section
+  // at its midpoint is reproduced by linear interpolation
+  std::vector<double> levels;
+  std::vector<double> grid_KEs( 1, KEs.front() );
+
+  // Recursively refines the interval [KE_lo, KE_hi], adding all of the new
+  // grid points (in increasing order) except the lower endpoint
+  std::function<void(double, double, double, double, int)> refine
+    = [&]( double KE_lo, double xs_lo, double KE_hi, double xs_hi, int depth )
+  {
+    double KE_mid = 0.5*( KE_lo + KE_hi );
+    double xs_mid = exact_xs_by_level( KE_mid, levels );
+
+    double error = std::abs( xs_mid - 0.5*(xs_lo + xs_hi) );
+    if ( depth < MAX_REFINEMENT_DEPTH
+      && error > REL_TOLERANCE * std::abs(xs_mid) )
+    {
+      refine( KE_lo, xs_lo, KE_mid, xs_mid, depth + 1 );
+      refine( KE_mid, xs_mid, KE_hi, xs_hi, depth + 1 );
+    }
+    else {
+      grid_KEs.push_back( KE_mid );
+      grid_KEs.push_back( KE_hi );
+    }
+  };
+
+  double xs_prev = exact_xs_by_level( KEs.front(), levels );
+  for ( size_t i = 1u; i < KEs.size(); ++i ) {
+    double xs_next = exact_xs_by_level( KEs[i], levels );
+    refine( KEs[i - 1], xs_prev, KEs[i], xs_next, 0 );
+    xs_prev = xs_next;
+  }
+
+  // Store the partial cross sections to each level at the final grid points
+  std::vector<double> grid_levels;
+  std::vector<double> grid_totals;
+  grid_levels.reserve( grid_KEs.size() * matrix_elements_->size() );
+  grid_totals.reserve( grid_KEs.size() );
+  for ( double KE : grid_KEs ) {
+    grid_totals.push_back( exact_xs_by_level(KE, levels) );
+    grid_levels.insert( grid_levels.end(), levels.cbegin(), levels.cend() );
+  }
+
+  xs_table_KEs_ = std::move( grid_KEs );
+  xs_table_levels_ = std::move( grid_levels );
+  xs_table_totals_ = std::move( grid_totals );
+
+  MARLEY_LOG_INFO() << "Tabulated total cross sections for the reaction "
+    << description_ << " at " << xs_table_KEs_.size() << " projectile"
+    << " kinetic energies between " << KEa_min << " and " << KEa_max
+    << " MeV";
+}
+
+std::vector<double> marley::NuclearReaction::level_threshold_KEs(
+  double KEa_min, double KEa_max ) const
+{
+  std::vector<double> KEs;
+  for ( const auto& mat_el : *matrix_elements_ ) {
+    double E_CM = mc_ + md_gs_ + mat_el.level_energy();
+    double KE_level = ( E_CM*E_CM - std::pow(ma_ + mb_, 2) ) / ( 2.*mb_ );
+    if ( KE_level > KEa_min && KE_level < KEa_max ) KEs.push_back( KE_level );
+  }
+  return KEs;
+}
+
+bool marley::NuclearReaction::use_xs_table(
+  const marley::CrossSectionTable& table )
+{
+  if ( !table.has_levels() || table.KEs.empty()
+    || table.pdg_a != pdg_a_ || table.pdg_b != pdg_b_
+    || table.pdg_c != pdg_c_ || table.pdg_d != pdg_d_
+    || table.level_energies.size() != matrix_elements_->size()
+    || !std::is_sorted( table.KEs.cbegin(), table.KEs.cend() ) )
+  {
+    return false;
+  }
+
+  for ( size_t j = 0u; j < matrix_elements_->size(); ++j ) {
+    if ( table.level_energies[ j ] != matrix_elements_->at( j ).level_energy() )
+    {
+      return false;
+    }
+  }
+
+  clear_xs_table();
+  xs_table_KEs_ = table.KEs;
+  xs_table_levels_ = table.level_xsecs;
+  xs_table_totals_ = table.totals;
+  return true;
+}
+
+marley::CrossSectionTable marley::NuclearReaction::get_xs_table() const {
+  marley::CrossSectionTable table;
+  table.description = description_;
+  table.pdg_a = pdg_a_;
+  table.pdg_b = pdg_b_;
+  table.pdg_c = pdg_c_;
+  table.pdg_d = pdg_d_;
+  if ( !has_xs_table() ) return table;
+
+  table.KEs = xs_table_KEs_;
+  table.totals = xs_table_totals_;
+  table.level_xsecs = xs_table_levels_;
+  for ( const auto& mat_el : *matrix_elements_ ) {
+    table.level_energies.push_back( mat_el.level_energy() );
+  }
+  return table;
+}
+
+void marley::NuclearReaction::clear_xs_table() {
+  xs_table_KEs_.clear();
+  xs_table_levels_.clear();
+  xs_table_totals_.clear();
+  xs_table_level_cdfs_.clear();
+  xs_table_unbiased_cdfs_.clear();
+
+  // Cached level weights may have been interpolated from the table
+  level_cache_.valid = false;
+}
+
+double marley::NuclearReaction::tabulated_xs(double KEa,
+  std::vector<double>* level_xsecs) const
+{
+  // Find the grid interval containing KEa
+  auto iter = std::upper_bound( xs_table_KEs_.cbegin(), xs_table_KEs_.cend(),
+    KEa );
+  size_t i_hi = std::min( static_cast<size_t>(iter - xs_table_KEs_.cbegin()),
+    xs_table_KEs_.size() - 1u );
+  size_t i_lo = ( i_hi > 0u ) ? i_hi - 1u : 0u;
+
+  double KE_lo = xs_table_KEs_[ i_lo ];
+  double KE_hi = xs_table_KEs_[ i_hi ];
+  double t = ( KE_hi > KE_lo ) ? ( KEa - KE_lo ) / ( KE_hi - KE_lo ) : 0.;
+
+  if ( level_xsecs ) {
+
+    // Load the partial cross sections in the same way as summed_xs_helper(),
+    // i.e., only for the kinematically accessible levels with nonvanishing
+    // matrix elements
+    level_xsecs->clear();
+    size_t num_levels = matrix_elements_->size();
+    const double* lo = &xs_table_levels_[ i_lo * num_levels ];
+    const double* hi = &xs_table_levels_[ i_hi * num_levels ];
+    double max_E_level = max_level_energy( KEa );
+    double xsec = 0.;
+    for ( size_t j = 0u; j < num_levels; ++j ) {
+      const auto& mat_el = matrix_elements_->at( j );
+      if ( mat_el.level_energy() > max_E_level ) break;
+      if ( mat_el.strength() == 0. ) continue;
+      double partial_xsec = lo[j] + t*( hi[j] - lo[j] );
+      xsec += partial_xsec;
+      level_xsecs->push_back( partial_xsec );
+    }
+    return xsec;
+  }
+
+  double xs_lo = xs_table_totals_[ i_lo ];
+  double xs_hi = xs_table_totals_[ i_hi ];
+  return xs_lo + t*( xs_hi - xs_lo );
+}
+
 // Compute the total reaction cross section (summed over all final nuclear levels)
 // in units of MeV^(-2) using the center of momentum frame.
-double marley::NuclearReaction::total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff) const {
+double marley::NuclearReaction::total_xs(int pdg_a, double KEa, double dm_mass, double UV_cutoff,
+  double dm_velocity) const {
   double dummy_cos_theta = 0.;
   //std::cout<<"dark matter summed_xs_helper called !"<<std::endl;
   //return summed_xs_helper(pdg_a, KEa, dummy_cos_theta, nullptr, false);
   //return 1.;
-  summed_xs_helper(pdg_a, KEa, dm_mass, 0.001, UV_cutoff, dummy_cos_theta, nullptr, false);
+  return summed_xs_helper(pdg_a, KEa, dm_mass, dm_velocity, UV_cutoff, dummy_cos_theta, nullptr, false);
 
 // double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
 //   double cos_theta_c_cm, std::vector<double>* level_xsecs, bool differential)
@@ -660,6 +1203,22 @@ double marley::NuclearReaction::diff_xs(const marley::MatrixElement& mat_el,
   return xsec;
 }
 
+// Dark matter version of diff_xs() for a single final nuclear level. The
+// partial cross section is computed in the same way as in the dark matter
+// version of summed_xs_helper().
+double marley::NuclearReaction::dm_diff_xs(const marley::MatrixElement& mat_el,
+  double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
+  double cos_theta_c_cm) const
+{
+  if ( std::abs(cos_theta_c_cm) > 1. || dm_mass <= 0. ) return 0.;
+  if ( mat_el.level_energy() > dm_mass || mat_el.strength() == 0. ) return 0.;
+  double beta_c_cm = 0.;
+  double xsec = dm_total_xs(dm_mass, dm_velocity, dm_cutoff, 1.0, mat_el,
+    KEa, beta_c_cm, true);
+  xsec *= mat_el.cos_theta_pdf(cos_theta_c_cm, beta_c_cm);
+  return xsec;
+}
+
 
 // Helper function for total_xs and diff_xs()
 double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa,
@@ -710,10 +1269,7 @@ double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa,
       // current level is kinematically accessible in the check against
       // max_E_level above)
       double beta_c_cm = 0.;
-      double partial_xsec;
-      
-      partial_xsec = dm_total_xs(1.,1.,1.,1.0,mat_el, KEa, beta_c_cm, false);
-      //partial_xsec = total_xs(mat_el, KEa, beta_c_cm, false);
+      double partial_xsec = summed_level_xs( mat_el, KEa, beta_c_cm );
       
 
       // If a differential cross section (d\sigma / d\cos\theta_{CM})
@@ -745,6 +1301,72 @@ double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa,
 }
 
 
+double marley::NuclearReaction::summed_level_xs(
+  const marley::MatrixElement& mat_el, double KEa, double& beta_c_cm) const
+{
+  return dm_total_xs(1., marley_utils::DM_DEFAULT_VELOCITY, 1., 1.0, mat_el,
+    KEa, beta_c_cm, false);
+  //return total_xs(mat_el, KEa, beta_c_cm, false);
+}
+
+void marley::NuclearReaction::total_xs_batch(int pdg_a, const double* KEas,
+  double* out, size_t n) const
+{
+  std::fill( out, out + n, 0. );
+  if ( pdg_a != pdg_a_ ) return;
+
+  // Energies covered by the cross section table are interpolated one at a
+  // time as in total_xs( int, double ). Collect the others so that the
+  // levels can be visited in the outer loop below.
+  std::vector<size_t> exact_indices;
+  std::vector<double> max_E_levels;
+  exact_indices.reserve( n );
+  max_E_levels.reserve( n );
+  double max_E_level_all = -std::numeric_limits<double>::infinity();
+  for ( size_t i = 0u; i < n; ++i ) {
+    double KEa = KEas[ i ];
+    if ( in_xs_table(KEa) ) out[ i ] = tabulated_xs( KEa, nullptr );
+    else if ( KEa > 0. ) {
+      double max_E_level = max_level_energy( KEa );
+      exact_indices.push_back( i );
+      max_E_levels.push_back( max_E_level );
+      max_E_level_all = std::max( max_E_level_all, max_E_level );
+    }
+  }
+
+  // The levels are sorted in order of increasing excitation energy, so we
+  // can stop as soon as none of the requested energies can reach a level.
+  // The partial cross sections are accumulated in the same order as in
+  // summed_xs_helper().
+  for ( const auto& mat_el : *matrix_elements_ ) {
+    double level_energy = mat_el.level_energy();
+    if ( level_energy > max_E_level_all ) break;
+    if ( mat_el.strength() == 0. ) continue;
+
+    for ( size_t k = 0u; k < exact_indices.size(); ++k ) {
+      if ( level_energy > max_E_levels[ k ] ) continue;
+
+      size_t i = exact_indices[ k ];
+      double beta_c_cm = 0.;
+      double partial_xsec = summed_level_xs( mat_el, KEas[i], beta_c_cm );
+
+      if ( std::isnan(partial_xsec) ) {
+        MARLEY_LOG_WARNING() << "Partial cross section for reaction "
+          << description_ << " gave NaN result.";
+        MARLEY_LOG_DEBUG() << "Parameters were level energy = "
+          << level_energy << " MeV, projectile kinetic energy = "
+          << KEas[ i ] << " MeV, and reduced matrix element = "
+          << mat_el.strength();
+        MARLEY_LOG_DEBUG() << "The partial cross section to this level"
+          << " will be set to zero.";
+        partial_xsec = 0.;
+      }
+
+      out[ i ] += partial_xsec;
+    }
+  }
+}
+
 // dm copy of summed_xs_helper but with different inputs. I think this is how this works right?? 
 double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa, double dm_mass, double dm_velocity, double dm_cutoff,
   double cos_theta_c_cm, std::vector<double>* level_xsecs, bool differential)
@@ -759,6 +1381,20 @@ double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa, double d
   // to each nuclear level, then clear it before storing them
   if ( level_xsecs ) level_xsecs->clear();
 
+  // The partial total cross sections scale exactly as LAMBDA^(-4), so they
+  // can be looked up from the table of cutoff-independent values
+  if ( !differential ) {
+    const DMLevelRow& row = dm_level_row( dm_mass, dm_velocity );
+    double scale = 1. / std::pow( dm_cutoff, 4 );
+    if ( level_xsecs ) {
+      level_xsecs->resize( row.level_xs.size() );
+      for ( size_t j = 0u; j < row.level_xs.size(); ++j ) {
+        (*level_xsecs)[ j ] = row.level_xs[ j ] * scale;
+      }
+    }
+    return row.total * scale;
+  }
+
   //double max_E_level = max_level_energy( dm_mass ); // <----- TODO fix this hack
   double max_E_level =  dm_mass ; // <----- TODO fix this hack
   double xsec = 0.;
@@ -826,6 +1462,40 @@ double marley::NuclearReaction::summed_xs_helper(int pdg_a, double KEa, double d
 double marley::NuclearReaction::total_xs(const marley::MatrixElement& me,
   double KEa, double& beta_c_cm, bool check_max_E_level) const
 {
+  return ( this->*level_xs_kernel_ )( me, KEa, beta_c_cm, check_max_E_level );
+}
+
+marley::NuclearReaction::LevelXsKernel
+  marley::NuclearReaction::select_level_xs_kernel( ProcessType pt )
+{
+  switch ( pt ) {
+    case ProcessType::NeutrinoCC:
+      return &NuclearReaction::level_total_xs<ProcessType::NeutrinoCC>;
+    case ProcessType::AntiNeutrinoCC:
+      return &NuclearReaction::level_total_xs<ProcessType::AntiNeutrinoCC>;
+    case ProcessType::NC:
+      return &NuclearReaction::level_total_xs<ProcessType::NC>;
+    case ProcessType::DM:
+      return &NuclearReaction::level_total_xs<ProcessType::DM>;
+    default:
+      return &NuclearReaction::level_total_xs<ProcessType::NuElectronElastic>;
+  }
+}
+
+// The process type is a template parameter here, so each instantiation
+// contains only the branches that apply to it. For example, the NC kernel
+// used for CEvNS never evaluates a Coulomb correction.
+template <marley::Reaction::ProcessType PT>
+  double marley::NuclearReaction::level_total_xs(
+  const marley::MatrixElement& me, double KEa, double& beta_c_cm,
+  bool check_max_E_level) const
+{
+  // The allowed approximation expressions below do not apply to dark matter
+  // absorption, which is handled separately by dm_total_xs()
+  if ( PT == ProcessType::DM ) throw marley::Error( "Per-level neutrino"
+    " cross sections are unavailable for dark matter absorption in"
+    " marley::NuclearReaction::total_xs(). Use dm_total_xs() instead." );
+
   // Don't bother to compute anything if the matrix element vanishes for this
   // level
   if ( me.strength() == 0. ) return 0.;
@@ -869,37 +1539,79 @@ double marley::NuclearReaction::total_xs(const marley::MatrixElement& me,
     std::pow(pc_dot_pd, 2) - mc_*mc_*md2) / pc_dot_pd;
 
 
-  if ( process_type_ != ProcessType::DM )
+  // Common factors for the allowed approximation total cross sections
+  // for both CC and NC reactions
+  double total_xsec = (marley_utils::GF2 / marley_utils::pi)
+    * ( Eb_cm * Ed_cm / s ) * Ec_cm * pc_cm * me.strength();
+
+  // Apply extra factors based on the current process type
+  if ( PT == ProcessType::NeutrinoCC || PT == ProcessType::AntiNeutrinoCC )
   {
-    // Common factors for the allowed approximation total cross sections
-    // for both CC and NC reactions
-    double total_xsec = (marley_utils::GF2 / marley_utils::pi)
-      * ( Eb_cm * Ed_cm / s ) * Ec_cm * pc_cm * me.strength();
-  
+    // Calculate a Coulomb correction factor using either a Fermi function
+    // or the effective momentum approximation
+    double factor_C = coulomb_correction_factor( beta_rel_cd );
+    total_xsec *= marley_utils::Vud2 * factor_C;
+  }
+  else if ( PT == ProcessType::NC )
+  {
+    // For NC, extra factors are only needed for Fermi transitions (which
+    // correspond to CEvNS since they can only access the nuclear ground state)
+    if ( me.type() == ME_Type::FERMI ) {
+      double Q_w = weak_nuclear_charge();
+      total_xsec *= 0.25*std::pow(Q_w, 2);
+    }
+  }
+  else throw marley::Error("Unrecognized process type encountered in"
+    " marley::NuclearReaction::total_xs()");
 
+  return total_xsec;
+}
 
-    // Apply extra factors based on the current process type
-    if ( process_type_ == ProcessType::NeutrinoCC
-      || process_type_ == ProcessType::AntiNeutrinoCC )
-    {
-      // Calculate a Coulomb correction factor using either a Fermi function
-      // or the effective momentum approximation
-      double factor_C = coulomb_correction_factor( beta_rel_cd );
-      total_xsec *= marley_utils::Vud2 * factor_C;
-    }
-    else if ( process_type_ == ProcessType::NC )
-    {
-      // For NC, extra factors are only needed for Fermi transitions (which
-      // correspond to CEvNS since they can only access the nuclear ground state)
-      if ( me.type() == ME_Type::FERMI ) {
-        double Q_w = weak_nuclear_charge();
-        total_xsec *= 0.25*std::pow(Q_w, 2);
-      }
+const marley::NuclearReaction::DMLevelRow&
+  marley::NuclearReaction::dm_level_row(double dm_mass, double dm_velocity)
+  const
+{
+  auto key = std::make_pair( dm_mass, dm_velocity );
+  auto iter = dm_level_table_.find( key );
+  if ( iter != dm_level_table_.end() ) return iter->second;
+
+  // Start over if a long scan has filled up the table
+  if ( dm_level_table_.size() >= MAX_DM_LEVEL_TABLE_ROWS_ ) {
+    dm_level_table_.clear();
+  }
+
+  DMLevelRow& row = dm_level_table_[ key ];
+
+  // The levels are visited in the same way as in summed_xs_helper(), but
+  // with a unit cutoff. The projectile kinetic energy only affects
+  // beta_c_cm, which is not needed here.
+  double max_E_level = dm_mass;
+  for ( const auto& mat_el : *matrix_elements_ ) {
+
+    if ( mat_el.level_energy() > max_E_level ) break;
+    if ( mat_el.strength() == 0. ) continue;
+
+    double beta_c_cm = 0.;
+    double partial_xsec = dm_total_xs( dm_mass, dm_velocity, 1., 1.0,
+      mat_el, 0., beta_c_cm, true );
+
+    if ( std::isnan(partial_xsec) ) {
+      MARLEY_LOG_WARNING() << "Partial cross section for reaction "
+        << description_ << " gave NaN result.";
+      MARLEY_LOG_DEBUG() << "Parameters were level energy = "
+        << mat_el.level_energy() << " MeV, dark matter mass = "
+        << dm_mass << " MeV, and reduced matrix element = "
+        << mat_el.strength();
+      MARLEY_LOG_DEBUG() << "The partial cross section to this level"
+        << " will be set to zero.";
+      partial_xsec = 0.;
     }
-    else throw marley::Error("Unrecognized process type encountered in"
-      " marley::NuclearReaction::total_xs()");
-    return total_xsec;
+
+    row.total += partial_xsec;
+    row.level_xs.push_back( partial_xsec );
   }
+
+  return row;
 }
 
 // Compute the total reaction cross section (in MeV^(-2)) for a transition to a
@@ -998,7 +1710,7 @@ double marley::NuclearReaction::dm_total_xs(double dm_mass, double dm_velocity,
   //std::cout<<"  dm_cutoff: "<<dm_cutoff<<std::endl;
   //std::cout<<"  level_energy: "<< me.level_energy()<<std::endl;
   //std::cout<<"  m_thresh: "<<m_thresh<<std::endl;
-  double vx = 0.001;
+  double vx = dm_velocity;
   double pi = 3.14159265358979323846;
   //double mx = ma_;
   double Z = Zi_;
@@ -1105,44 +1817,33 @@ double marley::NuclearReaction::sample_cos_theta_c_cm(
   const marley::MatrixElement& matrix_el, double beta_c_cm,
   marley::Generator& gen) const
 {
-  // To avoid wasting time searching for the maximum of these distributions
-  // for rejection sampling, set the maximum to the known value before
-  // proceeding.
-  double max;
+  // The angular distributions for both allowed transition types are linear
+  // in the scattering cosine x, with the normalized form
+  // pdf(x) = (1 + a*x) / 2 on [-1, 1]. Find the slope a for this matrix
+  // element so that we can sample by inverting the CDF exactly instead of
+  // using a rejection method.
+  double a;
   if ( matrix_el.type() == ME_Type::FERMI ) {
     // B(F)
-    max = matrix_el.cos_theta_pdf(1., beta_c_cm);
+    a = beta_c_cm;
   }
   else if (matrix_el.type() == ME_Type::GAMOW_TELLER) {
     // B(GT)
-    max = matrix_el.cos_theta_pdf(-1., beta_c_cm);
+    a = -beta_c_cm / 3.;
   }
   else throw marley::Error("Unrecognized matrix element type "
     + std::to_string(matrix_el.type()) + " encountered while sampling a"
     " CM frame scattering angle");
 
-  // Sample a CM frame scattering cosine using the appropriate distribution for
-  // this matrix element.
-  return gen.rejection_sample(
-    [&matrix_el, &beta_c_cm](double cos_theta_c_cm)
-    -> double { return matrix_el.cos_theta_pdf(cos_theta_c_cm, beta_c_cm); },
-    -1., 1., max);
-}
-
-marley::Event marley::NuclearReaction::make_event_object(double KEa,
-  double pc_cm, double cos_theta_c_cm, double phi_c_cm, double Ec_cm,
-  double Ed_cm, double E_level, int twoJ, const marley::Parity& P) const
-{
-  marley::Event event = marley::Reaction::make_event_object(KEa, pc_cm,
-    cos_theta_c_cm, phi_c_cm, Ec_cm, Ed_cm, E_level, twoJ, P);
-
-  // Assume that the target is a neutral atom (q_b = 0)
-  event.target().set_charge(0);
-
-  // Assign the correct charge to the residue
-  event.residue().set_charge(q_d_);
+  // Setting the CDF equal to a uniform random probability u gives the
+  // quadratic equation a*x^2 + 2*x + c = 0, where c = 2 - a - 4*u. Solve it
+  // using a form that remains numerically stable as a approaches zero.
+  double u = gen.uniform_random_double( 0., 1., true );
+  double c = 2. - a - 4.*u;
+  double cos_theta_c_cm = -c / ( 1. + std::sqrt(std::max(0., 1. - a*c)) );
 
-  return event;
+  // Guard against roundoff error pushing the result outside of [-1, 1]
+  return std::min( 1., std::max( -1., cos_theta_c_cm ) );
 }
 
 double marley::NuclearReaction::coulomb_correction_factor(double beta_rel_cd)
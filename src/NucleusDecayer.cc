@@ -19,11 +19,13 @@
 #include "marley/Event.hh"
 #include "marley/Generator.hh"
 #include "marley/HauserFeshbachDecay.hh"
+#include "marley/Instrumentation.hh"
 #include "marley/Level.hh"
 #include "marley/Logger.hh"
 #include "marley/MatrixElement.hh"
 #include "marley/NucleusDecayer.hh"
 #include "marley/Parity.hh"
+#include "marley/Tracing.hh"
 
 using ME_Type = marley::MatrixElement::TransitionType;
 
@@ -46,6 +48,14 @@ namespace {
 void marley::NucleusDecayer::process_event( marley::Event& event,
   marley::Generator& gen )
 {
+  marley::Instrumentation::ScopedTimer timer(
+    marley::Instrumentation::Probe::ProcessEvent );
+  MARLEY_TRACE_ZONE( trace_zone, "process_event" );
+
+  // If the de-excitation takes too long, the states that it visited are
+  // reported to the tracing backend (if any)
+  MARLEY_TRACE_CHAIN( trace_chain );
+
   // Get the residue excitation energy from the event. These values represent
   // its state immediately following the initial two-two scattering reaction.
   double Ex = event.Ex();
@@ -80,8 +90,7 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
   double residue_mass = event.residue().mass();
 
   // Ground-state residue mass
-  double gs_residue_mass = mt.get_atomic_mass( initial_residue_pdg )
-    - qIon*mt.get_particle_mass( marley_utils::ELECTRON );
+  double gs_residue_mass = mt.get_ion_mass( initial_residue_pdg, qIon );
 
   double expected_residue_mass = gs_residue_mass + Ex;
 
@@ -110,8 +119,10 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
   // If we're above the unbound threshold, do a continuum decay. Also start
   // with a continuum decay if no discrete level data are available for the
   // residue.
-  auto* ds = gen.get_structure_db().get_decay_scheme( initial_residue_pdg );
-  double unbound_threshold = mt.unbound_threshold( initial_residue_pdg );
+  auto& sdb = gen.get_structure_db();
+  auto* ds = sdb.get_decay_scheme( initial_residue_pdg );
+  double unbound_threshold = sdb.get_channel_thresholds( initial_residue_pdg )
+    .unbound_threshold;
 
   // If Reaction::set_level_ptrs() changes, you'll want to change this too.
   // TODO: find a better way of keeping the two pieces of code in sync
@@ -122,11 +133,6 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
   // discrete level's excitation energy below.
   bool started_from_continuum = continuum;
 
-  // Get a non-const reference to the nuclear residue. We'll use it to
-  // update the event record during each step of the Hauser-Feshbach
-  // cascade.
-  marley::Particle& residue = event.residue();
-
   if ( continuum ) {
 
     // Dummy particles used for temporary storage of binary decay products
@@ -137,12 +143,28 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
     // the Hauser-Feshbach statistical model.
     while ( continuum && Ex > CONTINUUM_GS_CUTOFF ) {
 
-      auto& sdb = gen.get_structure_db();
-
-      marley::HauserFeshbachDecay hfd( residue, Ex, twoJ, P, sdb );
+      // Get a non-const reference to the nuclear residue. We'll use it to
+      // update the event record during this step of the Hauser-Feshbach
+      // cascade. It is retrieved again for each step since adding a
+      // particle to the event invalidates references to the old ones.
+      marley::Particle& residue = event.residue();
+
+      MARLEY_TRACE_ZONE( step_zone, "Hauser-Feshbach step" );
+      MARLEY_TRACE_TEXT( step_zone, marley::Tracing::describe_state(
+        residue.pdg_code(), Ex, twoJ, P) );
+      MARLEY_TRACE_CHAIN_STATE( trace_chain, residue.pdg_code(), Ex, twoJ,
+        P );
+
+      // Reuse a previously built HauserFeshbachDecay object for this compound
+      // nucleus state if one is available
+      auto& hfd = sdb.get_hf_decay( residue, Ex, twoJ, P );
       MARLEY_LOG_DEBUG() << hfd;
 
-      continuum = hfd.do_decay( Ex, twoJ, P, first, second, gen );
+      // Any exit channel bias is included in the event weight
+      double weight = event.weight();
+      continuum = hfd.do_decay( residue, Ex, twoJ, P, first, second, gen,
+        &weight );
+      event.set_weight( weight );
 
       MARLEY_LOG_DEBUG() << "Hauser-Feshbach decay to " << first.pdg_code()
         << " and " << second.pdg_code();
@@ -160,6 +182,7 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
     // bound level in the residual nucleus. In either case, use gamma-ray decay
     // scheme data to sample the de-excitation gammas and add them to this
     // event's final particle list.
+    const marley::Particle& residue = event.residue();
     marley::DecayScheme* dec_scheme = gen.get_structure_db()
       .get_decay_scheme( residue.pdg_code() );
 
@@ -184,6 +207,9 @@ void marley::NucleusDecayer::process_event( marley::Event& event,
       }
     }
 
+    MARLEY_TRACE_ZONE( cascade_zone, "gamma cascade" );
+    MARLEY_TRACE_CHAIN_STATE( trace_chain, residue.pdg_code(),
+      lev->energy(), lev->twoJ(), lev->parity() );
     dec_scheme->do_cascade( *lev, event, gen, residue.charge() );
   }
 
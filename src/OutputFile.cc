@@ -14,10 +14,19 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+// POSIX includes
+#include <unistd.h>
+
 // MARLEY includes
 #include "marley/Generator.hh"
 #include "marley/Error.hh"
 #include "marley/JSONConfig.hh"
+#include "marley/JSONWriter.hh"
 #include "marley/OutputFile.hh"
 
 #ifdef USE_ROOT
@@ -32,6 +41,8 @@ marley::OutputFile::OutputFile(const std::string& name,
   else if (format == "hepevt") format_ = Format::HEPEVT;
   else if (format == "json") format_ = Format::JSON;
   else if (format == "ascii") format_ = Format::ASCII;
+  else if (format == "binary") format_ = Format::BINARY;
+  else if (format == "hdf5") format_ = Format::HDF5;
   else throw marley::Error("Invalid output file format \"" + format
     + "\" given in an output file specification");
 
@@ -43,11 +54,19 @@ marley::OutputFile::OutputFile(const std::string& name,
       " allowed for the file format \"" + format + '\"');
   }
   else if (mode == "resume") {
-    if (format_ == Format::ROOT || format_ == Format::JSON)
+    if (format_ == Format::ROOT || format_ == Format::JSON
+      || format_ == Format::BINARY || format_ == Format::HDF5)
       mode_ = Mode::RESUME;
     else throw marley::Error("The output mode \"" + mode + "\" is not"
       " allowed for the file format \"" + format + '\"');
   }
+  else if (mode == "restart") {
+    if (format_ == Format::HEPEVT || format_ == Format::ASCII
+      || format_ == Format::JSON || format_ == Format::BINARY)
+      mode_ = Mode::RESTART;
+    else throw marley::Error("The output mode \"" + mode + "\" is not"
+      " allowed for the file format \"" + format + '\"');
+  }
   else throw marley::Error("Invalid output mode \"" + mode
     + "\" given in an output file specification");
 }
@@ -64,13 +83,171 @@ std::unique_ptr<marley::Generator> marley::OutputFile::restore_generator(
   return gen;
 }
 
+void marley::OutputFile::enable_index(const marley::Generator& gen) {
+  std::string index_name = marley::EventIndex::file_name( name_ );
+
+  bool fresh_index = ( mode_ == Mode::OVERWRITE || events_rewritten_ );
+  if ( !fresh_index ) {
+    // Entries are located by their position in the index, so new entries
+    // may only be added to an index that already covers every previous
+    // event. An index may be started for an output file that is still
+    // empty.
+    std::ifstream old_index( index_name, std::ios::in | std::ios::binary );
+    std::ifstream old_file( name_, std::ios::in | std::ios::ate );
+    bool file_empty = !old_file || old_file.tellg() <= 0;
+    if ( marley::EventIndex::read_header(old_index) ) fresh_index = false;
+    else if ( file_empty ) fresh_index = true;
+    else {
+      MARLEY_LOG_WARNING() << "No valid index file was found for the"
+        << " existing events in " << name_ << ". An index file will not be"
+        << " written.";
+      return;
+    }
+  }
+
+  if ( fresh_index ) {
+    index_stream_.open( index_name, std::ios::out | std::ios::trunc
+      | std::ios::binary );
+    marley::EventIndex::write_header( index_stream_ );
+  }
+  else index_stream_.open( index_name, std::ios::out | std::ios::app
+    | std::ios::binary );
+
+  if ( !index_stream_ ) throw marley::Error("Could not open the index"
+    " file \"" + index_name + '\"');
+
+  index_entry_ = marley::EventIndex::Entry();
+  index_entry_.counter_based = gen.counter_based_rng();
+  index_entry_.seed = gen.get_seed();
+  index_entry_.stream_id = gen.get_rng_stream();
+
+  // Events rewritten by resume() came from the same generator and precede
+  // the ones that it will produce next
+  index_entry_.event_number = gen.get_event_number()
+    - rewritten_offsets_.size();
+  if ( index_restarted_ ) index_entry_.event_number = restart_event_number_;
+  for ( const auto& offset : rewritten_offsets_ ) this->index_event( offset );
+  rewritten_offsets_.clear();
+}
+
+void marley::OutputFile::index_event(uint64_t offset, uint32_t sub_index) {
+  if ( !index_stream_.is_open() ) return;
+  index_entry_.offset = offset;
+  index_entry_.sub_index = sub_index;
+  marley::EventIndex::write_entry( index_stream_, index_entry_ );
+  ++index_entry_.event_number;
+}
+
+void marley::OutputFile::write_events(const marley::EventBatch& batch) {
+  marley::Event ev;
+  for ( size_t e = 0u; e < batch.size(); ++e ) {
+    batch.get_event( e, ev );
+    this->write_event( &ev );
+  }
+}
+
+void marley::OutputFile::close_index() {
+  if ( !index_stream_.is_open() ) return;
+  index_stream_.close();
+  if ( index_stream_.fail() ) throw marley::Error("Failed to write the"
+    " index file for \"" + name_ + '\"');
+}
+
+marley::JSON marley::OutputFile::checkpoint(long /*num_events*/) {
+  throw marley::Error("Checkpoints are not supported for the output file \""
+    + name_ + '\"');
+}
+
+void marley::OutputFile::restart(const marley::JSON& /*state*/) {
+  throw marley::Error("Checkpoints are not supported for the output file \""
+    + name_ + '\"');
+}
+
+void marley::OutputFile::checkpoint_index(marley::JSON& state) {
+  if ( !index_stream_.is_open() ) return;
+  index_stream_.flush();
+  if ( !index_stream_ ) throw marley::Error("Failed to write the"
+    " index file for \"" + name_ + '\"');
+  state["index_size"] = static_cast<long>( index_stream_.tellp() );
+  state["index_event_number"] = std::to_string( index_entry_.event_number );
+}
+
+void marley::OutputFile::restart_index(const marley::JSON& state) {
+  // The index will be reopened for appending by enable_index()
+  if ( !state.has_key("index_size") ) return;
+  truncate_file( marley::EventIndex::file_name(name_),
+    state.at("index_size").to_long() );
+  index_restarted_ = true;
+  restart_event_number_ = std::stoull( state.at("index_event_number")
+    .to_string() );
+}
+
+void marley::OutputFile::truncate_file(const std::string& file_name,
+  uint64_t size)
+{
+  if ( ::truncate(file_name.c_str(), size) != 0 ) {
+    throw marley::Error("Could not truncate the file \"" + file_name
+      + "\" to " + std::to_string(size) + " bytes");
+  }
+}
+
 marley::TextOutputFile::TextOutputFile(const std::string& name,
-  const std::string& format, const std::string& mode, bool force, int indent)
-  : marley::OutputFile(name, format, mode, force), indent_(indent)
+  const std::string& format, const std::string& mode, bool force, int indent,
+  const std::string& compression, int compression_level)
+  : marley::OutputFile(name, format, mode, force),
+  compression_level_(compression_level), indent_(indent)
 {
+  if (compression == "zstd") compress_ = true;
+  else if (compression != "none") throw marley::Error("Invalid compression"
+    " algorithm \"" + compression + "\" given for the output file \""
+    + name + '\"');
+
   this->open();
 }
 
+void marley::TextOutputFile::open_stream(std::ios::openmode mode) {
+  stream_.open(name_, mode);
+
+  // When appending, the reported write position stays at the start of the
+  // file until something is written unless we move it explicitly
+  if (mode & std::ios::app) stream_.seekp(0, std::ios::end);
+
+  if (!compress_) return;
+
+  // Each opening starts a new Zstandard frame. Decompressors handle
+  // concatenated frames, so appending to an existing compressed file works.
+  compressor_ = std::make_unique<marley::CompressingStreamBuf>(
+    stream_.rdbuf(), compression_level_);
+  std::ios& ios = stream_;
+  ios.rdbuf(compressor_.get());
+}
+
+void marley::TextOutputFile::close_stream() {
+  if (compressor_) {
+    bool ok = compressor_->finish();
+    // Restore the file buffer owned by the std::fstream
+    std::ios& ios = stream_;
+    ios.rdbuf(stream_.rdbuf());
+    compressor_.reset();
+    if (!ok) throw marley::Error("Failed to write compressed data to the"
+      " output file \"" + name_ + '\"');
+  }
+  stream_.close();
+}
+
+uint64_t marley::TextOutputFile::file_position() {
+  // Query the file buffer directly so that any compressor installed in
+  // stream_ is bypassed
+  return static_cast<uint64_t>( stream_.rdbuf()->pubseekoff(0,
+    std::ios::cur, std::ios::out) );
+}
+
+void marley::TextOutputFile::enable_index(const marley::Generator& gen) {
+  if (compress_) throw marley::Error("An index file cannot be written for"
+    " the compressed output file \"" + name_ + '\"');
+  OutputFile::enable_index(gen);
+}
+
 void marley::TextOutputFile::start_json_output(bool start_array) {
   if (format_ != Format::JSON) throw marley::Error("TextOutputFile"
     "::start_json_output() called for a non-JSON file format");
@@ -95,6 +272,9 @@ void marley::TextOutputFile::start_json_output(bool start_array) {
 }
 
 void marley::TextOutputFile::open() {
+  // When continuing from a checkpoint, the file will be opened by restart()
+  if (mode_ == Mode::RESTART) return;
+
   bool file_exists = check_if_file_exists(name_);
 
   auto open_mode_flag = std::ios::out | std::ios::trunc;
@@ -125,7 +305,7 @@ void marley::TextOutputFile::open() {
     throw marley::Error("Unrecognized file mode encountered in"
       " TextOutputFile::open()");
 
-  stream_.open(name_, open_mode_flag);
+  this->open_stream(open_mode_flag);
 
   // Get the event array started if we're writing a fresh JSON file
   if (format_ == Format::JSON && mode_ == Mode::OVERWRITE) {
@@ -153,10 +333,16 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
   MARLEY_LOG_INFO() << "Continuing previous run from JSON file "
     << name_;
 
-  // Get the JSON objects from the file
-  stream_.close();
+  // Get the JSON objects from the file, decompressing them if needed
+  this->close_stream();
   stream_.open(name_, std::ios::in);
-  marley::JSON temp_json = marley::JSON::load(stream_);
+  marley::JSON temp_json;
+  if (marley::DecompressingStreamBuf::is_compressed(*stream_.rdbuf())) {
+    marley::DecompressingStreamBuf decompressor(stream_.rdbuf());
+    std::istream in(&decompressor);
+    temp_json = marley::JSON::load(in);
+  }
+  else temp_json = marley::JSON::load(stream_);
   stream_.close();
 
   if (!temp_json.has_key("gen_state")) {
@@ -207,7 +393,7 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
 
   // We've loaded all the metadata we need, so erase the file,
   // and write out all the previous events to it again.
-  stream_.open(name_, std::ios::out | std::ios::trunc);
+  this->open_stream(std::ios::out | std::ios::trunc);
 
   start_json_output(true);
 
@@ -217,12 +403,21 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
   auto begin = evt_array.begin();
   auto end = evt_array.end();
 
+  // Keep track of where each event is written in case an index file is
+  // requested later
+  events_rewritten_ = true;
+  rewritten_offsets_.clear();
+
   for (auto iter = begin; iter != end; ++iter) {
     if (iter != begin) stream_ << ',';
-    if (indent_ < 0) stream_ << iter->dump_string();
+    if (indent_ < 0) {
+      rewritten_offsets_.push_back(file_position());
+      stream_ << iter->dump_string();
+    }
     else {
       stream_ << '\n';
       for (int i = 0; i < 2*indent_; ++i) stream_ << ' ';
+      rewritten_offsets_.push_back(file_position());
       iter->print(stream_, indent_, true, 2*indent_);
     }
   }
@@ -233,18 +428,58 @@ bool marley::TextOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
   else needs_comma_ = false;
 
   // Close the file and re-open it, this time appending to the end
-  stream_.close();
-  stream_.open(name_, std::ios::out | std::ios::app);
+  this->close_stream();
+  this->open_stream(std::ios::out | std::ios::app);
 
   return true;
 }
 
+marley::JSON marley::TextOutputFile::checkpoint(long /*num_events*/) {
+  // A compressed file may only be truncated between Zstandard frames, so
+  // end the current frame and start a new one
+  if (compressor_) {
+    this->close_stream();
+    this->open_stream(std::ios::out | std::ios::app);
+  }
+  else stream_.flush();
+
+  if (!stream_) throw marley::Error("Failed to write to the output file \""
+    + name_ + '\"');
+
+  marley::JSON state = marley::JSON::object();
+  state["size"] = static_cast<long>( file_position() );
+  if (format_ == Format::JSON) state["needs_comma"] = needs_comma_;
+  checkpoint_index(state);
+  return state;
+}
+
+void marley::TextOutputFile::restart(const marley::JSON& state) {
+  if (mode_ != Mode::RESTART) throw marley::Error("Cannot call TextOutput"
+    "File::restart() for an output mode other than \"restart\"");
+
+  MARLEY_LOG_INFO() << "Continuing from the last checkpoint of the output"
+    << " file " << name_;
+
+  // Discard anything written after the checkpoint, then continue writing
+  // at the end of the file
+  truncate_file(name_, state.at("size").to_long());
+  restart_index(state);
+  this->open_stream(std::ios::out | std::ios::app);
+  if (!stream_) throw marley::Error("Could not open the output file \""
+    + name_ + '\"');
+
+  if (format_ == Format::JSON) needs_comma_ = state.at("needs_comma")
+    .to_bool();
+}
+
 int_fast64_t marley::TextOutputFile::bytes_written() {
   // If the stream is open, then update the byte count. Otherwise, just
   // use the saved value.
   if (stream_.is_open()) {
-    stream_.flush();
-    byte_count_ = static_cast<int_fast64_t>( stream_.tellp() );
+    // Query the file buffer directly so that the count reflects compressed
+    // bytes and no partial compressed block is flushed prematurely
+    byte_count_ = static_cast<int_fast64_t>( stream_.rdbuf()->pubseekoff(0,
+      std::ios::cur, std::ios::out) );
   }
   return byte_count_;
 }
@@ -255,6 +490,7 @@ void marley::TextOutputFile::write_event(const marley::Event* event) {
 
   switch (format_) {
     case Format::ASCII:
+      if (index_enabled()) index_event(file_position());
       stream_ << *event;
       break;
     case Format::JSON:
@@ -266,15 +502,23 @@ void marley::TextOutputFile::write_event(const marley::Event* event) {
         }
       }
       else needs_comma_ = true;
-      if (indent_ == -1) stream_ << event->to_json();
-      else {
-        event->to_json().print(stream_, indent_, true, 2*indent_);
+      if (index_enabled()) index_event(file_position());
+      {
+        // Serialize the event without building a marley::JSON object
+        event_buffer_.clear();
+        marley::JSONWriter writer( event_buffer_, indent_,
+          indent_ < 0 ? 0u : 2u*indent_ );
+        event->write_json( writer );
+        stream_.write( event_buffer_.data(), event_buffer_.size() );
       }
       break;
     case Format::HEPEVT:
       // TODO: consider incrementing event numbers each time instead of
       // just writing a zero
-      event->write_hepevt(0, flux_avg_tot_xsec_, stream_);
+      if (index_enabled()) index_event(file_position());
+      event_buffer_.clear();
+      event->write_hepevt(0, flux_avg_tot_xsec_, event_buffer_);
+      stream_.write( event_buffer_.data(), event_buffer_.size() );
       break;
     case Format::ROOT:
       throw marley::Error("ROOT format encountered in TextOutputFile::"
@@ -287,7 +531,7 @@ void marley::TextOutputFile::write_event(const marley::Event* event) {
 }
 
 void marley::TextOutputFile::write_generator_state(
-  const marley::JSON& json_config, const marley::Generator& gen,
+  const marley::JSON& json_config, const GeneratorState& gen_state,
   const long num_events)
 {
   if (format_ != Format::JSON) throw marley::Error("TextOutputFile::"
@@ -306,17 +550,17 @@ void marley::TextOutputFile::write_generator_state(
   marley::JSON temp = marley::JSON::object();
 
   temp["config"] = json_config;
-  temp["generator_state_string"] = gen.get_state_string();
-  temp["seed"] = std::to_string(gen.get_seed());
+  temp["generator_state_string"] = gen_state.state_string;
+  temp["seed"] = std::to_string(gen_state.seed);
   temp["event_count"] = num_events;
-  temp["flux_avg_xsec"] = gen.flux_averaged_total_xs();
+  temp["flux_avg_xsec"] = gen_state.flux_avg_xsec;
 
   if (indent_ < 0) stream_ << temp.dump_string();
   else temp.print(stream_, indent_, true, indent_);
 }
 
 void marley::TextOutputFile::close(const marley::JSON& json_config,
-  const marley::Generator& gen, const long num_events)
+  const GeneratorState& gen_state, const long num_events)
 {
   if (format_ == Format::JSON) {
     // End the JSON array of event objects
@@ -328,14 +572,15 @@ void marley::TextOutputFile::close(const marley::JSON& json_config,
 
     // Save the current state of the generator to the JSON file in case
     // we want to resume a run later
-    write_generator_state(json_config, gen, num_events);
+    write_generator_state(json_config, gen_state, num_events);
 
     // Terminate the JSON file with a closing curly brace
     if (indent_ > 0) stream_ << '\n';
     stream_ << '}';
   }
 
-  stream_.close();
+  this->close_stream();
+  this->close_index();
 }
 
 void marley::TextOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
@@ -349,7 +594,8 @@ void marley::TextOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
   // in these file formats.
   /// @todo Consider other ways of handling this
   if (format_ == Format::ASCII) {
-    bool at_start_of_file = stream_.tellp() == 0;
+    bool at_start_of_file = stream_.rdbuf()->pubseekoff(0, std::ios::cur,
+      std::ios::out) == 0;
     if ( !at_start_of_file ) return;
 
     // Use the same trick as in marley::Event::print() to preserve
@@ -365,3 +611,528 @@ void marley::TextOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
   // Store the value for later (it is needed for the HEPEVT format)
   flux_avg_tot_xsec_ = avg_tot_xsec;
 }
+
+marley::BinaryOutputFile::BinaryOutputFile(const std::string& name,
+  const std::string& format, const std::string& mode, bool force,
+  marley::BinaryEventBlock::Layout layout,
+  marley::BinaryEventBlock::Precision precision)
+  : marley::OutputFile(name, format, mode, force)
+{
+  if (format_ != Format::BINARY) throw marley::Error("The output format \""
+    + format + "\" cannot be used with a BinaryOutputFile");
+  if (layout == marley::BinaryEventBlock::Layout::kinematics
+    && precision != marley::BinaryEventBlock::Precision::full)
+  {
+    throw marley::Error("Single precision cannot be used with the"
+      " kinematics layout requested for the binary output file \"" + name
+      + '\"');
+  }
+  header_.layout = layout;
+  header_.precision = precision;
+  this->open();
+}
+
+void marley::BinaryOutputFile::open() {
+  bool file_exists = check_if_file_exists(name_);
+
+  if (mode_ == Mode::OVERWRITE && file_exists && !force_) {
+    bool overwrite = marley_utils::prompt_yes_no("Overwrite file "
+      + name_);
+    if (!overwrite) {
+      MARLEY_LOG_INFO() << "Cancelling overwrite of output file \""
+        << name_ << '\"';
+      mode_ = Mode::RESUME;
+    }
+  }
+
+  if (mode_ == Mode::RESUME) {
+    if (!file_exists) throw marley::Error("Cannot resume run. Could"
+      " not open the binary file \"" + name_ + '\"');
+    // The file will be opened by resume()
+    return;
+  }
+  else if (mode_ == Mode::RESTART) {
+    // The file will be opened by restart()
+    return;
+  }
+  else if (mode_ != Mode::OVERWRITE)
+    throw marley::Error("Unrecognized file mode encountered in"
+      " BinaryOutputFile::open()");
+
+  stream_.open(name_, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!stream_) throw marley::Error("Could not open the binary output file \""
+    + name_ + '\"');
+
+  // Reserve space for the header. It will be rewritten with the final event
+  // count and metadata position when the file is closed.
+  marley::BinaryEventBlock::write_header(stream_, header_);
+}
+
+bool marley::BinaryOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
+  long& num_previous_events)
+{
+  if (mode_ != Mode::RESUME) {
+    throw marley::Error("Cannot call BinaryOutput"
+      "File::resume() for an output mode other than \"resume\"");
+    return false;
+  }
+
+  MARLEY_LOG_INFO() << "Continuing previous run from binary file "
+    << name_;
+
+  auto layout = header_.layout;
+  auto precision = header_.precision;
+  stream_.open(name_, std::ios::in | std::ios::binary);
+  if (!marley::BinaryEventBlock::read_header(stream_, header_)) {
+    throw marley::Error("The file \"" + name_ + "\" is not a MARLEY binary"
+      " event file");
+    return false;
+  }
+
+  // New event blocks are always written using the current version of the
+  // format, so they cannot be appended to a file that uses an older one.
+  // Versions 4 and 5 only changed the header (full-precision blocks are
+  // unchanged), so files written using version 3 may still be resumed.
+  if (header_.format_version < 3u) {
+    throw marley::Error("The binary file \"" + name_ + "\" was written using"
+      " an older version of the format and cannot be resumed");
+    return false;
+  }
+
+  if (header_.layout != layout || header_.precision != precision) {
+    throw marley::Error("The layout or precision of the binary file \""
+      + name_ + "\" does not match the one requested in the job"
+      " configuration");
+    return false;
+  }
+
+  // The metadata record is written when the file is closed. If it is
+  // missing, then the previous run was not terminated cleanly.
+  marley::BinaryEventBlock::RecordTag tag;
+  std::string json_text;
+  bool metadata_ok = header_.metadata_position > 0u
+    && stream_.seekg(header_.metadata_position)
+    && marley::BinaryEventBlock::read_tag(stream_, tag)
+    && tag == marley::BinaryEventBlock::RecordTag::metadata
+    && marley::BinaryEventBlock::read_metadata(stream_, json_text);
+  stream_.close();
+
+  if (!metadata_ok) {
+    throw marley::Error("Missing generator configuration in binary"
+      " file \"" + name_ + "\": could not restore previous state");
+    return false;
+  }
+
+  marley::JSON gen_state = marley::JSON::load(json_text);
+
+  if (!gen_state.has_key("config")) {
+    throw marley::Error("Failed to load previous configuration from"
+      " the binary file \"" + name_ + '\"');
+    return false;
+  }
+  const marley::JSON& config = gen_state.at("config");
+
+  if (!gen_state.has_key("generator_state_string")) {
+    throw marley::Error("Failed to load previous generator state from"
+      " the binary file \"" + name_ + '\"');
+    return false;
+  }
+  std::string state_string
+    = gen_state.at("generator_state_string").to_string();
+
+  if (!gen_state.has_key("seed")) {
+    throw marley::Error("Failed to load previous random number"
+      " generator seed from the binary file \"" + name_ + '\"');
+    return false;
+  }
+  std::string seed = gen_state.at("seed").to_string();
+
+  bool count_ok = true;
+  if (!gen_state.has_key("event_count")) count_ok = false;
+  else num_previous_events = gen_state.at(
+    "event_count").to_long(count_ok);
+
+  if (!count_ok) {
+    throw marley::Error("Failed to load previous event count"
+      " from the binary file \"" + name_ + '\"');
+    return false;
+  }
+
+  gen = this->restore_generator( config );
+  gen->seed_using_state_string( state_string );
+
+  MARLEY_LOG_INFO() << "The previous run was initialized using"
+    << " the random number generator seed " << seed;
+
+  // Discard the old metadata record and continue writing event blocks in
+  // its place. A new record will be written when the file is closed.
+  if ( ::truncate(name_.c_str(), header_.metadata_position) != 0 ) {
+    throw marley::Error("Could not remove the old metadata from the binary"
+      " file \"" + name_ + '\"');
+    return false;
+  }
+
+  header_.event_count = num_previous_events;
+  header_.metadata_position = 0u;
+
+  stream_.open(name_, std::ios::in | std::ios::out | std::ios::binary);
+  stream_.seekp(0, std::ios::end);
+  this->update_header();
+
+  return true;
+}
+
+int_fast64_t marley::BinaryOutputFile::bytes_written() {
+  // If the stream is open, then update the byte count. Otherwise, just
+  // use the saved value.
+  if (stream_.is_open()) {
+    stream_.flush();
+    byte_count_ = static_cast<int_fast64_t>( stream_.tellp() );
+  }
+  return byte_count_;
+}
+
+void marley::BinaryOutputFile::write_event(const marley::Event* event) {
+  if (!event) throw marley::Error("Null pointer passed to"
+    " BinaryOutputFile::write_event()");
+
+  if ( kinematics_only() ) {
+    kinematics_block_.add_event( *event );
+    if ( kinematics_block_.size() >= EVENTS_PER_BLOCK ) this->flush_block();
+    return;
+  }
+
+  block_.add_event( *event );
+  if ( block_.size() >= EVENTS_PER_BLOCK ) this->flush_block();
+}
+
+void marley::BinaryOutputFile::write_events(const marley::EventBatch& batch)
+{
+  // Copy the columns directly, filling the current block before starting a
+  // new one
+  size_t e = 0u;
+  while ( e < batch.size() ) {
+    if ( kinematics_only() ) {
+      size_t count = std::min( batch.size() - e,
+        EVENTS_PER_BLOCK - kinematics_block_.size() );
+      kinematics_block_.append( batch, e, count );
+      e += count;
+      if ( kinematics_block_.size() >= EVENTS_PER_BLOCK ) this->flush_block();
+      continue;
+    }
+    size_t count = std::min( batch.size() - e,
+      EVENTS_PER_BLOCK - block_.size() );
+    block_.append( batch, e, count );
+    e += count;
+    if ( block_.size() >= EVENTS_PER_BLOCK ) this->flush_block();
+  }
+}
+
+void marley::BinaryOutputFile::flush_block() {
+  if ( kinematics_only() ) {
+    if ( kinematics_block_.size() == 0u ) return;
+    kinematics_block_.write( stream_ );
+    kinematics_block_.clear();
+    return;
+  }
+
+  if ( block_.size() == 0u ) return;
+
+  // Index entries for these events refer to the start of the block record
+  if ( index_enabled() ) {
+    uint64_t position = static_cast<uint64_t>( stream_.tellp() );
+    for ( size_t e = 0u; e < block_.size(); ++e ) {
+      this->index_event( position, static_cast<uint32_t>(e) );
+    }
+  }
+
+  block_.write( stream_, header_.precision );
+  block_.clear();
+}
+
+marley::JSON marley::BinaryOutputFile::checkpoint(long num_events) {
+  this->flush_block();
+
+  header_.event_count = num_events;
+  this->update_header();
+  stream_.flush();
+  if (!stream_) throw marley::Error("Failed to write to the binary output"
+    " file \"" + name_ + '\"');
+
+  marley::JSON state = marley::JSON::object();
+  state["size"] = static_cast<long>( stream_.tellp() );
+  checkpoint_index(state);
+  return state;
+}
+
+void marley::BinaryOutputFile::restart(const marley::JSON& state) {
+  if (mode_ != Mode::RESTART) throw marley::Error("Cannot call BinaryOutput"
+    "File::restart() for an output mode other than \"restart\"");
+
+  MARLEY_LOG_INFO() << "Continuing from the last checkpoint of the binary"
+    << " file " << name_;
+
+  // The header was updated when the checkpoint was taken, so it already
+  // describes the events that are kept
+  truncate_file(name_, state.at("size").to_long());
+  restart_index(state);
+
+  auto layout = header_.layout;
+  auto precision = header_.precision;
+  stream_.open(name_, std::ios::in | std::ios::out | std::ios::binary);
+  if (!marley::BinaryEventBlock::read_header(stream_, header_)) {
+    throw marley::Error("The file \"" + name_ + "\" is not a MARLEY binary"
+      " event file");
+  }
+  if (header_.layout != layout || header_.precision != precision) {
+    throw marley::Error("The layout or precision of the binary file \""
+      + name_ + "\" does not match the one requested in the job"
+      " configuration");
+  }
+  stream_.seekp(0, std::ios::end);
+}
+
+void marley::BinaryOutputFile::update_header() {
+  auto position = stream_.tellp();
+  stream_.seekp(0);
+  marley::BinaryEventBlock::write_header(stream_, header_);
+  stream_.seekp(position);
+}
+
+void marley::BinaryOutputFile::write_generator_state(
+  const marley::JSON& json_config, const GeneratorState& gen_state,
+  const long num_events)
+{
+  marley::JSON temp = marley::JSON::object();
+
+  temp["config"] = json_config;
+  temp["generator_state_string"] = gen_state.state_string;
+  temp["seed"] = std::to_string(gen_state.seed);
+  temp["event_count"] = num_events;
+  temp["flux_avg_xsec"] = gen_state.flux_avg_xsec;
+
+  marley::BinaryEventBlock::write_metadata(stream_, temp.dump_string());
+}
+
+void marley::BinaryOutputFile::close(const marley::JSON& json_config,
+  const GeneratorState& gen_state, const long num_events)
+{
+  if ( !stream_.is_open() ) return;
+
+  this->flush_block();
+
+  // Save the current state of the generator to the end of the file in case
+  // we want to resume a run later
+  header_.metadata_position = static_cast<uint64_t>( stream_.tellp() );
+  write_generator_state(json_config, gen_state, num_events);
+
+  header_.event_count = num_events;
+  this->update_header();
+
+  this->bytes_written();
+  stream_.close();
+  this->close_index();
+}
+
+void marley::BinaryOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
+{
+  // Unlike the ASCII format, the cross section is stored in a fixed-size
+  // header, so it can always be updated in place
+  header_.flux_avg_tot_xsec = avg_tot_xsec;
+  this->update_header();
+}
+
+marley::OutputFile::GeneratorState::GeneratorState(
+  const marley::Generator& gen) : state_string( gen.get_state_string() ),
+  seed( gen.get_seed() ), flux_avg_xsec( gen.flux_averaged_total_xs() )
+{
+}
+
+namespace {
+
+  // Counts the integer conversions (e.g., "%d" or "%04d") in a printf-style
+  // file name pattern. Returns -1 if the pattern contains any other kind of
+  // conversion besides "%%".
+  int count_int_conversions(const std::string& pattern) {
+    int count = 0;
+    for ( size_t i = 0u; i < pattern.size(); ++i ) {
+      if ( pattern[i] != '%' ) continue;
+      if ( ++i < pattern.size() && pattern[i] == '%' ) continue;
+      while ( i < pattern.size() && ( pattern[i] == '0'
+        || pattern[i] == '-' ) ) ++i;
+      while ( i < pattern.size() && std::isdigit(
+        static_cast<unsigned char>(pattern[i])) ) ++i;
+      if ( i >= pattern.size() || pattern[i] != 'd' ) return -1;
+      ++count;
+    }
+    return count;
+  }
+
+}
+
+marley::RotatingOutputFile::RotatingOutputFile(const std::string& pattern,
+  const std::string& format, long max_events, int_fast64_t max_bytes,
+  Factory factory) : marley::OutputFile(pattern, format, "overwrite", true),
+  max_events_( max_events ), max_bytes_( max_bytes ),
+  factory_( std::move(factory) )
+{
+  if ( max_events_ < 0 || max_bytes_ < 0 ) throw marley::Error("Negative"
+    " part size limit given for the output file \"" + name_ + '\"');
+
+  part_ = factory_( part_file_name(name_, part_index_) );
+}
+
+marley::RotatingOutputFile::~RotatingOutputFile() {
+  // Errors cannot be reported at this point, so just wait for the
+  // background threads to finish
+  for ( auto& closer : closers_ ) closer.wait();
+}
+
+bool marley::RotatingOutputFile::resume(std::unique_ptr<marley::Generator>&,
+  long&)
+{
+  throw marley::Error("The \"resume\" mode is not supported for the rotating"
+    " output file \"" + name_ + '\"');
+  return false;
+}
+
+bool marley::RotatingOutputFile::is_pattern(const std::string& name) {
+  return count_int_conversions( name ) == 1;
+}
+
+std::string marley::RotatingOutputFile::part_file_name(
+  const std::string& pattern, int index)
+{
+  if ( !is_pattern(pattern) ) throw marley::Error("The file name \""
+    + pattern + "\" must contain exactly one integer conversion (e.g., %04d)"
+    " to be used for rotating output. Any other '%' characters should be"
+    " written as \"%%\".");
+
+  // Leave enough room for the digits plus any requested padding
+  std::vector<char> buffer( pattern.size() + 32u );
+  int length = std::snprintf( buffer.data(), buffer.size(), pattern.c_str(),
+    index );
+  if ( length < 0 || static_cast<size_t>(length) >= buffer.size() ) {
+    throw marley::Error("Could not form a part file name from the pattern \""
+      + pattern + '\"');
+  }
+  return std::string( buffer.data(), length );
+}
+
+std::vector<std::string> marley::RotatingOutputFile::find_parts(
+  const std::string& pattern)
+{
+  std::vector<std::string> names;
+  for ( int s = 0; ; ++s ) {
+    std::string name = part_file_name( pattern, s );
+    if ( !std::ifstream(name).good() ) break;
+    names.push_back( name );
+  }
+  return names;
+}
+
+bool marley::RotatingOutputFile::rotation_due() {
+  ++queued_events_;
+  if ( max_events_ > 0 && queued_events_ - last_boundary_ >= max_events_ ) {
+    return true;
+  }
+  // The size of the current part is only meaningful once the writing
+  // thread has reached every earlier boundary
+  return max_bytes_ > 0 && pending_boundaries_ == 0
+    && queued_events_ > last_boundary_ && part_bytes_ >= max_bytes_;
+}
+
+void marley::RotatingOutputFile::schedule_rotation(
+  const GeneratorState& gen_state)
+{
+  std::lock_guard<std::mutex> lock( boundary_mutex_ );
+  boundaries_.push_back( Boundary{ queued_events_, gen_state } );
+  last_boundary_ = queued_events_;
+  ++pending_boundaries_;
+}
+
+void marley::RotatingOutputFile::write_event(const marley::Event* event) {
+  // Start the next part if a boundary was scheduled before this event
+  if ( pending_boundaries_ > 0 ) {
+    std::unique_lock<std::mutex> lock( boundary_mutex_ );
+    if ( !boundaries_.empty() && boundaries_.front().event
+      == written_events_ )
+    {
+      GeneratorState gen_state = std::move( boundaries_.front().gen_state );
+      boundaries_.pop_front();
+      lock.unlock();
+      this->rotate( gen_state );
+      --pending_boundaries_;
+    }
+  }
+
+  part_->write_event( event );
+  ++written_events_;
+  ++part_events_;
+
+  if ( max_bytes_ > 0 && part_events_ % BYTE_CHECK_INTERVAL == 0 ) {
+    part_bytes_ = part_->bytes_written();
+  }
+}
+
+void marley::RotatingOutputFile::rotate(const GeneratorState& gen_state) {
+  long num_events = part_events_;
+
+  // ROOT keeps global state about the current file, so ROOT-format parts
+  // are closed on the writing thread instead
+  if ( format_ == Format::ROOT ) {
+    part_->close( config_, gen_state, num_events );
+    closed_bytes_ += part_->bytes_written();
+  }
+  else {
+    this->wait_for_closers( MAX_PENDING_CLOSES - 1u );
+    std::shared_ptr<marley::OutputFile> done( std::move(part_) );
+    marley::JSON config = config_;
+    closers_.push_back( std::async(std::launch::async,
+      [done, config, gen_state, num_events]() -> int_fast64_t
+      {
+        done->close( config, gen_state, num_events );
+        return done->bytes_written();
+      }) );
+  }
+
+  part_ = factory_( part_file_name(name_, ++part_index_) );
+  if ( have_xsec_ ) part_->write_flux_avg_tot_xsec( flux_avg_tot_xsec_ );
+  part_events_ = 0;
+  part_bytes_ = 0;
+}
+
+void marley::RotatingOutputFile::wait_for_closers(size_t max_pending) {
+  while ( closers_.size() > max_pending ) {
+    // The future is removed first so that an exception thrown by get()
+    // is only reported once
+    auto closer = std::move( closers_.front() );
+    closers_.pop_front();
+    closed_bytes_ += closer.get();
+  }
+}
+
+void marley::RotatingOutputFile::close(const marley::JSON& json_config,
+  const GeneratorState& gen_state, const long)
+{
+  if ( part_ ) {
+    part_->close( json_config, gen_state, part_events_ );
+    closed_bytes_ += part_->bytes_written();
+    part_.reset();
+  }
+  this->wait_for_closers( 0u );
+}
+
+int_fast64_t marley::RotatingOutputFile::bytes_written() {
+  if ( !part_ ) return closed_bytes_;
+  int_fast64_t part_bytes = part_->bytes_written();
+  part_bytes_ = part_bytes;
+  return closed_bytes_ + part_bytes;
+}
+
+void marley::RotatingOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec)
+{
+  flux_avg_tot_xsec_ = avg_tot_xsec;
+  have_xsec_ = true;
+  if ( part_ ) part_->write_flux_avg_tot_xsec( avg_tot_xsec );
+}
@@ -18,13 +18,18 @@
 
 #include "marley/marley_utils.hh"
 #include "marley/JSON.hh"
+#include "marley/JSONDocument.hh"
+#include "marley/JSONWriter.hh"
 #include "marley/Particle.hh"
+#include "marley/TextTokenReader.hh"
 
 namespace {
   // Helper functions for converting a JSON object into a marley::Particle
   // TODO: reduce code duplication between read_JSON_double() and
   // read_JSON_integer()
-  double read_JSON_double( const std::string& key, const marley::JSON& json ) {
+  template <typename JSONType> double read_JSON_double(
+    const std::string& key, const JSONType& json )
+  {
 
     if ( !json.has_key(key) ) throw marley::Error("Missing key " + key
       + " encountered in an input JSON particle object");
@@ -38,7 +43,9 @@ namespace {
     return result;
   }
 
-  long read_JSON_integer( const std::string& key, const marley::JSON& json ) {
+  template <typename JSONType> long read_JSON_integer(
+    const std::string& key, const JSONType& json )
+  {
 
     if ( !json.has_key(key) ) throw marley::Error("Missing key " + key
       + " encountered in an input JSON particle object");
@@ -113,7 +120,8 @@ void marley::Particle::print(std::ostream& out) const {
 }
 
 void marley::Particle::read(std::istream& in) {
-  in >> pdg_code_ >> four_momentum_[0] >> four_momentum_[1]
+  marley::TextTokenReader reader( in );
+  reader >> pdg_code_ >> four_momentum_[0] >> four_momentum_[1]
     >> four_momentum_[2] >> four_momentum_[3] >> mass_ >> charge_;
 }
 
@@ -129,6 +137,27 @@ marley::JSON marley::Particle::to_json() const {
   return particle;
 }
 
+void marley::Particle::write_json(marley::JSONWriter& writer) const {
+  // Members are written in the same (alphabetical) order used by the
+  // std::map inside a marley::JSON object
+  writer.begin_object();
+  writer.key( "E" );
+  writer.value( four_momentum_[0] );
+  writer.key( "charge" );
+  writer.value( charge_ );
+  writer.key( "mass" );
+  writer.value( mass_ );
+  writer.key( "pdg" );
+  writer.value( pdg_code_ );
+  writer.key( "px" );
+  writer.value( four_momentum_[1] );
+  writer.key( "py" );
+  writer.value( four_momentum_[2] );
+  writer.key( "pz" );
+  writer.value( four_momentum_[3] );
+  writer.end_object();
+}
+
 void marley::Particle::clear() {
   for (size_t j = 0u; j < 4u; ++j ) four_momentum_[j] = 0.;
   pdg_code_ = 0;
@@ -137,6 +166,16 @@ void marley::Particle::clear() {
 }
 
 void marley::Particle::from_json(const marley::JSON& json) {
+  this->load_json( json );
+}
+
+void marley::Particle::from_json(const marley::JSONValue& json) {
+  this->load_json( json );
+}
+
+template <typename JSONType>
+  void marley::Particle::load_json(const JSONType& json)
+{
   this->clear();
   pdg_code_ = read_JSON_integer( "pdg", json );
   charge_ = read_JSON_integer( "charge", json );
@@ -20,6 +20,8 @@
 #include "marley/Generator.hh"
 #include "marley/ProjectileDirectionRotator.hh"
 
+constexpr size_t marley::ProjectileDirectionRotator::MAX_CACHED_ROTATIONS;
+
 marley::ProjectileDirectionRotator::ProjectileDirectionRotator(
   const std::array<double, 3>& dir ) : marley::EventProcessor(),
   dir_vec_( dir )
@@ -55,42 +57,74 @@ void marley::ProjectileDirectionRotator::process_event(marley::Event& ev,
   // desired direction, then we can skip the coordinate rotation.
   if ( pdir == dir_vec_ ) return;
 
-  // If the (unrotated) projectile direction from the event differs from
-  // the last one that was processed, then we need to recompute the
-  // rotation matrix. Do so and save the unrotated projectile direction
-  // to repeat this check next time.
-  if ( pdir != last_pdir_ ) {
-    last_pdir_ = pdir;
-    rot_matrix_ = marley::RotationMatrix( pdir, dir_vec_ );
-  }
+  // Look up or compute the rotation matrix needed for this event
+  this->update_rotation_matrix( pdir );
 
   // Do the actual rotation of the Particle 3-momenta in the event
   this->rotate_event( ev );
 }
 
-void marley::ProjectileDirectionRotator::rotate_event( marley::Event& ev ) {
+void marley::ProjectileDirectionRotator::update_rotation_matrix(
+  const ThreeVector& pdir )
+{
+  // Both pdir and dir_vec_ are already normalized, so the matrix can be
+  // built directly from them. Randomly sampled directions will almost
+  // never repeat, so don't bother to cache their rotations.
+  if ( randomize_projectile_direction_ ) {
+    rot_matrix_ = marley::RotationMatrix::from_unit_vectors( pdir, dir_vec_ );
+    return;
+  }
+
+  auto matches = [&pdir, this]( const CachedRotation& cr ) -> bool
+    { return cr.from == pdir && cr.to == dir_vec_; };
+
+  // The rotation used for the previous event is by far the most likely one
+  // to be needed again, so check it first
+  if ( current_rotation_ < rotation_cache_.size()
+    && matches(rotation_cache_[ current_rotation_ ]) ) return;
 
-  // Rotate the initial particles
-  for ( auto* p : ev.get_initial_particles() ) {
-    rot_matrix_.rotate_particle_inplace( *p );
+  for ( size_t k = 0u; k < rotation_cache_.size(); ++k ) {
+    if ( matches(rotation_cache_[k]) ) {
+      current_rotation_ = k;
+      rot_matrix_ = rotation_cache_[k].matrix;
+      return;
+    }
   }
 
-  // Rotate the final particles
-  for ( auto* p : ev.get_final_particles() ) {
-    rot_matrix_.rotate_particle_inplace( *p );
+  // Compute a new matrix, replacing the oldest entry if the cache is full
+  CachedRotation cr = { pdir, dir_vec_,
+    marley::RotationMatrix::from_unit_vectors( pdir, dir_vec_ ) };
+
+  if ( rotation_cache_.size() < MAX_CACHED_ROTATIONS ) {
+    current_rotation_ = rotation_cache_.size();
+    rotation_cache_.push_back( cr );
+  }
+  else {
+    current_rotation_ = next_rotation_;
+    rotation_cache_[ current_rotation_ ] = cr;
+    next_rotation_ = ( next_rotation_ + 1u ) % MAX_CACHED_ROTATIONS;
   }
 
+  rot_matrix_ = cr.matrix;
+}
+
+void marley::ProjectileDirectionRotator::rotate_event( marley::Event& ev ) {
+
+  // Rotate the initial and final particles. Each group is stored
+  // contiguously, so it can be handled in a single call.
+  rot_matrix_.rotate_particles_inplace( ev.get_initial_particles() );
+  rot_matrix_.rotate_particles_inplace( ev.get_final_particles() );
+
 }
 
 marley::ProjectileDirectionRotator::ThreeVector
   marley::ProjectileDirectionRotator::sample_isotropic_direction(
   marley::Generator& gen ) const
 {
-  // Sample a polar cosine on the interval [-1, 1]
-  double cos_theta = gen.uniform_random_double( -1., 1., true );
-
-  // Sample an azimuthal angle on the interval [0, 2*pi)
-  double phi = gen.uniform_random_double( 0., marley_utils::two_pi, false );
+  // Sample a polar cosine on the interval [-1, 1] and an azimuthal angle on
+  // the interval [0, 2*pi)
+  double cos_theta, phi;
+  gen.isotropic_direction( cos_theta, phi );
 
   // Compute direction unit vector components
   double sin_theta = marley_utils::real_sqrt( 1. - std::pow(cos_theta, 2) );
@@ -0,0 +1,140 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <string>
+
+#include "marley/Error.hh"
+#include "marley/RandomEngine.hh"
+
+namespace {
+
+  // Multipliers and Weyl sequence constants for Philox4x64
+  constexpr uint64_t PHILOX_M0 = 0xD2E7470EE14C6C93u;
+  constexpr uint64_t PHILOX_M1 = 0xCA5A826395121157u;
+  constexpr uint64_t PHILOX_W0 = 0x9E3779B97F4A7C15u;
+  constexpr uint64_t PHILOX_W1 = 0xBB67AE8584CAA73Bu;
+
+  // Number of rounds to use
+  constexpr int PHILOX_ROUNDS = 10;
+
+  // Computes the full 128-bit product of two 64-bit unsigned integers,
+  // storing the high and low halves separately. This is done using
+  // 32-bit pieces to avoid relying on a non-standard 128-bit integer type.
+  inline void mulhilo64(uint64_t a, uint64_t b, uint64_t& hi, uint64_t& lo) {
+    const uint64_t mask = 0xFFFFFFFFu;
+    uint64_t a_lo = a & mask;
+    uint64_t a_hi = a >> 32;
+    uint64_t b_lo = b & mask;
+    uint64_t b_hi = b >> 32;
+
+    uint64_t p0 = a_lo * b_lo;
+    uint64_t p1 = a_lo * b_hi;
+    uint64_t p2 = a_hi * b_lo;
+    uint64_t p3 = a_hi * b_hi;
+
+    uint64_t middle = (p0 >> 32) + (p1 & mask) + (p2 & mask);
+
+    lo = (middle << 32) | (p0 & mask);
+    hi = p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32);
+  }
+
+}
+
+constexpr char marley::RandomEngine::PHILOX_TAG_[];
+
+marley::PhiloxEngine::CounterType marley::PhiloxEngine::block(
+  const CounterType& ctr, const KeyType& key)
+{
+  CounterType x = ctr;
+  KeyType k = key;
+
+  for ( int r = 0; r < PHILOX_ROUNDS; ++r ) {
+    if ( r > 0 ) {
+      k[0] += PHILOX_W0;
+      k[1] += PHILOX_W1;
+    }
+
+    uint64_t hi0, lo0, hi1, lo1;
+    mulhilo64( PHILOX_M0, x[0], hi0, lo0 );
+    mulhilo64( PHILOX_M1, x[2], hi1, lo1 );
+
+    x = {{ hi1 ^ x[1] ^ k[0], lo1, hi0 ^ x[3] ^ k[1], lo0 }};
+  }
+
+  return x;
+}
+
+void marley::PhiloxEngine::print(std::ostream& out) const {
+  out << key_[0] << ' ' << key_[1];
+  for ( const auto& c : counter_ ) out << ' ' << c;
+  for ( const auto& o : output_ ) out << ' ' << o;
+  out << ' ' << index_;
+}
+
+void marley::PhiloxEngine::read(std::istream& in) {
+  marley::PhiloxEngine temp;
+  in >> temp.key_[0] >> temp.key_[1];
+  for ( auto& c : temp.counter_ ) in >> c;
+  for ( auto& o : temp.output_ ) in >> o;
+  in >> temp.index_;
+
+  // Only update the engine if the full state could be read successfully
+  if ( in && temp.index_ <= 4u ) *this = temp;
+  else in.setstate( std::ios::failbit );
+}
+
+void marley::RandomEngine::seed(uint64_t seed) {
+  // This is an attempt to do a decent job of seeding the Mersenne Twister,
+  // but optimally accomplishing this can be tricky (see, for example,
+  // http://www.pcg-random.org/posts/cpp-seeding-surprises.html)
+  std::seed_seq seed_sequence{ seed };
+  mt_.seed( seed_sequence );
+
+  // The counter-based engine needs no such care. The seed is used directly
+  // as part of the key.
+  seed_ = seed;
+  event_number_ = 0u;
+  update_key();
+}
+
+void marley::RandomEngine::print(std::ostream& out) const {
+  // Mersenne Twister state strings are written in the standard format
+  // so that they remain compatible with those saved by earlier versions
+  // of MARLEY
+  if ( !counter_based_ ) out << mt_;
+  else {
+    out << PHILOX_TAG_ << ' ' << seed_ << ' ' << stream_id_ << ' '
+      << event_number_ << ' ' << philox_;
+  }
+}
+
+void marley::RandomEngine::read(std::istream& in) {
+  in >> std::ws;
+  if ( in.peek() == PHILOX_TAG_[0] ) {
+    std::string tag;
+    in >> tag;
+    if ( tag != PHILOX_TAG_ ) {
+      throw marley::Error( "Unrecognized random number engine state \""
+        + tag + "\" encountered" );
+    }
+    in >> seed_ >> stream_id_ >> event_number_ >> philox_;
+    counter_based_ = true;
+  }
+  else {
+    in >> mt_;
+    counter_based_ = false;
+  }
+}
@@ -24,6 +24,7 @@
 #include "marley/MatrixElement.hh"
 #include "marley/NuclearReaction.hh"
 #include "marley/Reaction.hh"
+#include "marley/ReactionDataRegistry.hh"
 #include "marley/StructureDatabase.hh"
 #include "marley/marley_kinematics.hh"
 #include "marley/marley_utils.hh"
@@ -220,10 +221,29 @@ void marley::Reaction::two_two_scatter(double KEa, double& s, double& Ec_cm,
   Ed_cm = std::max(sqrt_s - Ec_cm, md_);
 }
 
-marley::Event marley::Reaction::make_event_object(double KEa,
+void marley::Reaction::total_xs_batch(int pdg_a, const double* KEas,
+  double* out, size_t n) const
+{
+  for ( size_t i = 0u; i < n; ++i ) out[ i ] = this->total_xs( pdg_a, KEas[i] );
+}
+
+void marley::Reaction::create_event(int pdg_a, double KEa,
+  marley::Generator& gen, marley::Event& ev) const
+{
+  ev = this->create_event( pdg_a, KEa, gen );
+}
+
+void marley::Reaction::create_event(int pdg_a, double KEa, double dm_mass,
+  double dm_velocity, double dm_cutoff, marley::Generator& gen,
+  marley::Event& ev) const
+{
+  ev = this->create_event( pdg_a, KEa, dm_mass, dm_velocity, dm_cutoff, gen );
+}
+
+void marley::Reaction::make_event_object(double KEa,
   double pc_cm, double cos_theta_c_cm, double phi_c_cm,
   double Ec_cm, double Ed_cm, double E_level, int twoJ,
-  const marley::Parity& P) const
+  const marley::Parity& P, marley::Event& event, int q_b, int q_d) const
 {
   double sin_theta_c_cm = real_sqrt(1.
     - std::pow(cos_theta_c_cm, 2));
@@ -239,25 +259,19 @@ marley::Event marley::Reaction::make_event_object(double KEa,
   // Determine the magnitude of the lab-frame 3-momentum of the projectile
   double pa = real_sqrt(KEa*(KEa + 2*ma_));
 
-  // Create particle objects representing the projectile and target in the lab
-  // frame
+  // Load the event with particles representing the projectile and target in
+  // the lab frame and the ejectile and residue in the CM frame
   // @todo Allow for projectile directions other than along the z-axis
-  marley::Particle projectile(pdg_a_, Ea, 0, 0, pa, ma_);
-  marley::Particle target(pdg_b_, mb_, 0, 0, 0, mb_);
-
-  // Create particle objects representing the ejectile and residue in the CM
-  // frame.
-  marley::Particle ejectile(pdg_c_, Ec_cm, pc_cm_x, pc_cm_y, pc_cm_z, mc_);
-  marley::Particle residue(pdg_d_, Ed_cm, -pc_cm_x, -pc_cm_y, -pc_cm_z, md_);
-
-  // Boost the ejectile and residue into the lab frame.
+  event.assign( marley::Particle(pdg_a_, Ea, 0, 0, pa, ma_),
+    marley::Particle(pdg_b_, mb_, 0, 0, 0, mb_, q_b),
+    marley::Particle(pdg_c_, Ec_cm, pc_cm_x, pc_cm_y, pc_cm_z, mc_),
+    marley::Particle(pdg_d_, Ed_cm, -pc_cm_x, -pc_cm_y, -pc_cm_z, md_, q_d),
+    E_level, twoJ, P );
+
+  // Boost the ejectile and residue into the lab frame. They are the only
+  // final particles at this point, so this can be done in a single call.
   double beta_z = pa / (Ea + mb_);
-  marley_kinematics::lorentz_boost(0, 0, -beta_z, ejectile);
-  marley_kinematics::lorentz_boost(0, 0, -beta_z, residue);
-
-  // Create the event object and load it with the appropriate information
-  marley::Event event(projectile, target, ejectile, residue, E_level, twoJ, P);
-  return event;
+  marley_kinematics::lorentz_boost(0, 0, -beta_z, event.get_final_particles());
 }
 
 int marley::Reaction::get_ejectile_pdg(int pdg_a, ProcType proc_type) {
@@ -297,108 +311,38 @@ std::vector< std::unique_ptr<marley::Reaction> >
   // Create an empty vector to start
   std::vector< std::unique_ptr<marley::Reaction> > loaded_reactions;
 
-  std::regex rx_comment("#.*"); // Matches comment lines
-
-  // Open the reaction data file for parsing
-  std::ifstream file_in( filename );
-
-  // If the file doesn't exist or some other error
-  // occurred, complain and give up.
-  if ( !file_in.good() ) {
-    throw marley::Error("Could not read from the file " + filename);
-  }
-
-  // String to store the current line of the reaction data file during parsing
-  std::string line;
-
-  /// @todo Add error handling for parsing problems
-  line = marley_utils::get_next_line( file_in, rx_comment, false );
-
-  // Read in the ProcessType code and the target PDG code
-  std::istringstream iss( line );
-  int integer_proc_type;
-  iss >> integer_proc_type;
-
-  auto proc_type = static_cast<ProcType>( integer_proc_type );
+  // Get the parsed contents of the reaction data file. Each file is only
+  // parsed once per process, even if many Generator objects use it.
+  auto data = marley::ReactionDataRegistry::Instance().get( filename );
+  auto proc_type = data->process_type;
 
   // For neutrino-electron elastic scattering, we won't have a table of
   // matrix elements. Instead, a table of atomic target PDG codes appears.
   // Make Reaction objects for each atomic target for each of the possible
   // projectiles (every neutrino species) and return the result.
   if ( proc_type == ProcessType::NuElectronElastic ) {
-
-    do {
-      // Loop over target atoms
-      int target_pdg;
-      while ( iss >> target_pdg ) {
-        // Loop over neutrino species
-        for ( const int& pdg_a : get_projectiles(proc_type) ) {
-          loaded_reactions.emplace_back(
-            std::make_unique<marley::ElectronReaction>(pdg_a, target_pdg) );
-        }
+    for ( int target_pdg : data->atomic_targets ) {
+      // Loop over neutrino species
+      for ( const int& pdg_a : get_projectiles(proc_type) ) {
+        loaded_reactions.emplace_back(
+          std::make_unique<marley::ElectronReaction>(pdg_a, target_pdg) );
       }
-
-      line = marley_utils::get_next_line( file_in, rx_comment, false );
-      /// @todo This can be done more cleanly via
-      /// iss = std::istringstream( line );
-      /// However, GCC 4 does not include the move constructor for string
-      /// streams. This was fixed for GCC 5. Change this line after MARLEY
-      /// drops support for GCC < 5. See https://stackoverflow.com/a/27152585
-      /// and https://stackoverflow.com/q/7623650 for more details.
-      iss.str( line );
-      iss.clear();
-    } while ( !line.empty() );
-
+    }
     return loaded_reactions;
   }
 
   // For nuclear reaction modes, there is a single target nucleus PDG code
-  // per file. After parsing it, we proceed to read in the matrix elements.
-  int pdg_b;
-  iss >> pdg_b;
-
-  // Read in all of the level energy (MeV), squared matrix element (B(F) or
-  // B(GT) strength), and matrix element type identifier (0 represents B(F), 1
-  // represents B(GT)) triplets. Create a vector of MatrixElement objects based
-  // on this information. Use a shared pointer so that the vector can be
-  // re-used by multiple Reaction objects, one for each neutrino species for
-  // which the matrix elements are relevant. This avoids unnecessary
-  // duplication of storage for the matrix elements.
+  // per file
+  int pdg_b = data->pdg_b;
+
+  // Copy the matrix elements so that they can be associated with the
+  // discrete levels owned by this Generator's StructureDatabase. Use a shared
+  // pointer so that the vector can be re-used by multiple Reaction objects,
+  // one for each neutrino species for which the matrix elements are
+  // relevant. This avoids unnecessary duplication of storage for the matrix
+  // elements.
   auto matrix_elements = std::make_shared<std::vector<
-    marley::MatrixElement> >();
-
-  // Set the old energy entry to the lowest representable double
-  // value. This guarantees that we always read in the first energy
-  // value given in the reaction data file
-  double old_energy = std::numeric_limits<double>::lowest();
-  while (line = marley_utils::get_next_line(file_in, rx_comment, false),
-    file_in.good())
-  {
-    iss.str(line);
-    iss.clear();
-    /// @todo Consider implementing a sorting procedure rather than strictly
-    /// enforcing that energies must be given in ascending order.
-
-    // The order of the entries is important because later uses of the vector of
-    // matrix elements assume that they are sorted in order of ascending final
-    // level energy.
-    double energy, strength;
-    int integer_me_type;
-    iss >> energy >> strength >> integer_me_type;
-    if (old_energy >= energy) throw marley::Error(std::string("Invalid")
-      + " reaction dataset. Level energies must be unique and must be"
-      + " given in ascending order.");
-
-    // @todo Right now, 0 corresponds to a Fermi transition, and 1 corresponds
-    // to a Gamow-Teller transition. As you add new matrix element types,
-    // consider changing the convention and its implementation.
-    // All of the level pointers owned by the matrix elements will initially be
-    // set to nullptr. This may be changed later if discrete level data can be
-    // found for the residual nucleus.
-    matrix_elements->emplace_back(energy, strength,
-      static_cast<ME_Type>(integer_me_type), nullptr);
-    old_energy = energy;
-  }
+    marley::MatrixElement> >( data->matrix_elements );
 
   // We now have all the information that we need. Build Reaction objects
   // for all neutrino species that can participate in the process described
@@ -462,8 +406,15 @@ std::vector< std::unique_ptr<marley::Reaction> >
   for ( const int& pdg_a : get_projectiles(proc_type) ) {
     int pdg_c = get_ejectile_pdg(pdg_a, proc_type);
 
+    // Reuse the masses and tables saved in a reaction bundle if possible
+    const marley::NuclearReaction::PrecomputedData* precomputed = nullptr;
+    for ( const auto& pre : data->precomputed ) {
+      if ( pre.pdg_a == pdg_a ) precomputed = &pre;
+    }
+
     loaded_reactions.emplace_back( std::make_unique<marley::NuclearReaction>(
-      proc_type, pdg_a, pdg_b, pdg_c, pdg_d, q_d, matrix_elements) );
+      proc_type, pdg_a, pdg_b, pdg_c, pdg_d, q_d, matrix_elements,
+      precomputed) );
 
   }
 
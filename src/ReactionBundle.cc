@@ -0,0 +1,294 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdio>
+#include <fstream>
+#include <istream>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Generator.hh"
+#include "marley/Logger.hh"
+#include "marley/MappedFile.hh"
+#include "marley/NuclearReaction.hh"
+#include "marley/ReactionBundle.hh"
+#include "marley/marley_utils.hh"
+
+using ME_Type = marley::MatrixElement::TransitionType;
+using ReactionData = marley::ReactionDataRegistry::ReactionData;
+
+constexpr uint32_t marley::ReactionBundle::FORMAT_VERSION;
+
+namespace {
+
+  // Identifies files written by marley::ReactionBundle::save()
+  const std::string BUNDLE_MAGIC = "MARLEY reaction bundle";
+
+  void write_precomputed( std::ostream& out,
+    const marley::NuclearReaction::PrecomputedData& pre )
+  {
+    marley_utils::write_binary( out, pre.pdg_a );
+    marley_utils::write_binary( out, pre.ma );
+    marley_utils::write_binary( out, pre.mb );
+    marley_utils::write_binary( out, pre.mc );
+    marley_utils::write_binary( out, pre.md_gs );
+    marley_utils::write_binary( out, pre.KEa_threshold );
+    marley_utils::write_binary( out, pre.fermi_table );
+    marley_utils::write_binary( out, pre.fermi_table_eta_coeff );
+    marley_utils::write_binary( out, pre.fermi_table_x_min );
+    marley_utils::write_binary( out, pre.fermi_table_inv_dx );
+  }
+
+  bool read_precomputed( std::istream& in,
+    marley::NuclearReaction::PrecomputedData& pre )
+  {
+    return marley_utils::read_binary( in, pre.pdg_a )
+      && marley_utils::read_binary( in, pre.ma )
+      && marley_utils::read_binary( in, pre.mb )
+      && marley_utils::read_binary( in, pre.mc )
+      && marley_utils::read_binary( in, pre.md_gs )
+      && marley_utils::read_binary( in, pre.KEa_threshold )
+      && marley_utils::read_binary( in, pre.fermi_table )
+      && marley_utils::read_binary( in, pre.fermi_table_eta_coeff )
+      && marley_utils::read_binary( in, pre.fermi_table_x_min )
+      && marley_utils::read_binary( in, pre.fermi_table_inv_dx );
+  }
+
+  void write_reaction_data( std::ostream& out, const ReactionData& data ) {
+    marley_utils::write_binary( out, static_cast<int>(data.process_type) );
+    marley_utils::write_binary( out, data.pdg_b );
+    marley_utils::write_binary( out, data.atomic_targets );
+    marley_utils::write_binary( out, data.content_hash );
+
+    std::vector<double> energies, strengths;
+    std::vector<int> types;
+    for ( const auto& mat_el : data.matrix_elements ) {
+      energies.push_back( mat_el.level_energy() );
+      strengths.push_back( mat_el.strength() );
+      types.push_back( static_cast<int>(mat_el.type()) );
+    }
+    marley_utils::write_binary( out, energies );
+    marley_utils::write_binary( out, strengths );
+    marley_utils::write_binary( out, types );
+
+    marley_utils::write_binary( out,
+      static_cast<uint64_t>(data.precomputed.size()) );
+    for ( const auto& pre : data.precomputed ) write_precomputed( out, pre );
+  }
+
+  bool read_reaction_data( std::istream& in, ReactionData& data ) {
+    int proc_type;
+    std::vector<double> energies, strengths;
+    std::vector<int> types;
+    uint64_t num_precomputed;
+    bool ok = marley_utils::read_binary( in, proc_type )
+      && marley_utils::read_binary( in, data.pdg_b )
+      && marley_utils::read_binary( in, data.atomic_targets )
+      && marley_utils::read_binary( in, data.content_hash )
+      && marley_utils::read_binary( in, energies )
+      && marley_utils::read_binary( in, strengths )
+      && marley_utils::read_binary( in, types )
+      && marley_utils::read_binary( in, num_precomputed )
+      && strengths.size() == energies.size()
+      && types.size() == energies.size()
+      && num_precomputed <= marley_utils::max_binary_read_size;
+    if ( !ok ) return false;
+
+    data.process_type = static_cast<marley::Reaction::ProcessType>(
+      proc_type );
+    for ( size_t j = 0u; j < energies.size(); ++j ) {
+      data.matrix_elements.emplace_back( energies[j], strengths[j],
+        static_cast<ME_Type>(types[j]), nullptr );
+    }
+
+    data.precomputed.resize( num_precomputed );
+    for ( auto& pre : data.precomputed ) {
+      if ( !read_precomputed(in, pre) ) return false;
+    }
+    return true;
+  }
+
+}
+
+marley::ReactionBundle marley::ReactionBundle::from_generator(
+  const std::vector<std::string>& file_names, const marley::Generator& gen )
+{
+  ReactionBundle bundle;
+  auto& registry = marley::ReactionDataRegistry::Instance();
+
+  for ( const auto& file_name : file_names ) {
+    auto data = std::make_shared<ReactionData>( *registry.get(file_name) );
+
+    // Save the constructor results for every projectile that reacts with
+    // the target described by this file
+    for ( const auto& react : gen.get_reactions() ) {
+      const auto* nr = dynamic_cast< const marley::NuclearReaction* >(
+        react.get() );
+      if ( !nr || nr->process_type() != data->process_type
+        || nr->pdg_b() != data->pdg_b ) continue;
+
+      bool saved = false;
+      for ( const auto& pre : data->precomputed ) {
+        if ( pre.pdg_a == nr->pdg_a() ) saved = true;
+      }
+      if ( !saved ) data->precomputed.push_back( nr->precomputed_data() );
+    }
+
+    bundle.files.emplace_back( file_name, data );
+  }
+
+  for ( const auto& react : gen.get_reactions() ) {
+    const auto* nr = dynamic_cast< const marley::NuclearReaction* >(
+      react.get() );
+    if ( !nr ) continue;
+
+    // All reactions share the same Coulomb correction method
+    bundle.coulomb_mode = marley::NuclearReaction::string_from_coulomb_mode(
+      nr->coulomb_mode() );
+    if ( nr->has_xs_table() ) bundle.xs_tables.push_back( nr->get_xs_table() );
+  }
+
+  return bundle;
+}
+
+void marley::ReactionBundle::save( const std::string& file_name ) const {
+
+  // Write to a temporary file first so that an interrupted write (or another
+  // job reading the bundle at the same time) never sees a partial file
+  std::string temp_file_name = file_name + ".tmp";
+  std::ofstream out( temp_file_name, std::ios::binary );
+  if ( !out ) throw marley::Error( "Could not open the reaction bundle"
+    " file " + temp_file_name + " for writing" );
+
+  out.write( BUNDLE_MAGIC.data(), BUNDLE_MAGIC.size() );
+  marley_utils::write_binary( out, FORMAT_VERSION );
+  marley_utils::write_binary( out, std::string(MARLEY_VERSION) );
+  marley_utils::write_binary( out, coulomb_mode );
+
+  marley_utils::write_binary( out, static_cast<uint64_t>(files.size()) );
+  for ( const auto& pair : files ) {
+    marley_utils::write_binary( out, pair.first );
+    write_reaction_data( out, *pair.second );
+  }
+
+  marley_utils::write_binary( out, static_cast<uint64_t>(xs_tables.size()) );
+  for ( const auto& table : xs_tables ) table.write( out );
+
+  out.close();
+  if ( !out ) throw marley::Error( "Failed to write the reaction bundle"
+    " file " + temp_file_name );
+
+  if ( std::rename(temp_file_name.c_str(), file_name.c_str()) != 0 ) {
+    throw marley::Error( "Could not rename " + temp_file_name + " to "
+      + file_name + " while saving the reaction bundle" );
+  }
+
+  MARLEY_LOG_INFO() << "Saved the reaction bundle " << file_name;
+}
+
+bool marley::ReactionBundle::load( const std::string& file_name,
+  ReactionBundle& bundle )
+{
+  bundle = ReactionBundle();
+
+  // Read the whole bundle from a single mapping of the file
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( file_name ); }
+  catch ( const marley::Error& ) {
+    MARLEY_LOG_WARNING() << "Could not open the reaction bundle "
+      << file_name;
+    return false;
+  }
+
+  marley::MemoryStreamBuf buf( file->data(), file->size() );
+  std::istream in( &buf );
+
+  std::string magic( BUNDLE_MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+
+  uint32_t format_version;
+  std::string version;
+  uint64_t num_files;
+  if ( !in || magic != BUNDLE_MAGIC
+    || !marley_utils::read_binary(in, format_version)
+    || format_version != FORMAT_VERSION
+    || !marley_utils::read_binary(in, version) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring invalid reaction bundle " << file_name;
+    return false;
+  }
+
+  if ( version != MARLEY_VERSION ) {
+    MARLEY_LOG_WARNING() << "Ignoring the reaction bundle " << file_name
+      << ", which was written by MARLEY version " << version;
+    return false;
+  }
+
+  bool ok = marley_utils::read_binary( in, bundle.coulomb_mode )
+    && marley_utils::read_binary( in, num_files )
+    && num_files <= marley_utils::max_binary_read_size;
+
+  for ( uint64_t f = 0u; ok && f < num_files; ++f ) {
+    std::string data_file_name;
+    auto data = std::make_shared<ReactionData>();
+    ok = marley_utils::read_binary( in, data_file_name )
+      && read_reaction_data( in, *data );
+    if ( ok ) bundle.files.emplace_back( data_file_name, data );
+  }
+
+  uint64_t num_tables = 0u;
+  ok = ok && marley_utils::read_binary( in, num_tables )
+    && num_tables <= marley_utils::max_binary_read_size;
+  for ( uint64_t t = 0u; ok && t < num_tables; ++t ) {
+    marley::CrossSectionTable table;
+    ok = table.read( in );
+    if ( ok ) bundle.xs_tables.push_back( std::move(table) );
+  }
+
+  if ( !ok ) {
+    MARLEY_LOG_WARNING() << "Ignoring invalid reaction bundle " << file_name;
+    bundle = ReactionBundle();
+    return false;
+  }
+
+  // Check that the reaction data files have not changed since the bundle
+  // was written
+  for ( const auto& pair : bundle.files ) {
+    bool current = false;
+    try {
+      marley::MappedFile data_file( pair.first );
+      current = ( marley_utils::fnv1a_hash(data_file.data(), data_file.size())
+        == pair.second->content_hash );
+    }
+    catch ( const marley::Error& ) {}
+
+    if ( !current ) {
+      MARLEY_LOG_WARNING() << "Ignoring the reaction bundle " << file_name
+        << ", which is out of date with the reaction data file "
+        << pair.first;
+      bundle = ReactionBundle();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void marley::ReactionBundle::register_reaction_data() const {
+  auto& registry = marley::ReactionDataRegistry::Instance();
+  for ( const auto& pair : files ) registry.insert( pair.first, pair.second );
+}
@@ -0,0 +1,184 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <istream>
+#include <limits>
+#include <regex>
+#include <sstream>
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/MappedFile.hh"
+#include "marley/ReactionDataRegistry.hh"
+#include "marley/StartupProfile.hh"
+#include "marley/marley_utils.hh"
+
+using ProcType = marley::Reaction::ProcessType;
+using ME_Type = marley::MatrixElement::TransitionType;
+
+marley::ReactionDataRegistry& marley::ReactionDataRegistry::Instance() {
+  static marley::ReactionDataRegistry the_instance;
+  return the_instance;
+}
+
+std::shared_ptr<const marley::ReactionDataRegistry::ReactionData>
+  marley::ReactionDataRegistry::get(const std::string& file_name)
+{
+  // Map the file so that its contents can be hashed (and, if needed, parsed)
+  // without copying them
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( file_name ); }
+  catch ( const marley::Error& ) {
+    throw marley::Error("Could not read from the file " + file_name);
+  }
+
+  auto key = std::make_pair( file_name,
+    marley_utils::fnv1a_hash(file->data(), file->size()) );
+
+  // Hold the lock while parsing so that threads which request the same file
+  // at the same time wait for a single copy to be built
+  std::lock_guard<std::mutex> lock( mutex_ );
+
+  auto iter = entries_.find( key );
+  if ( iter != entries_.end() ) return iter->second;
+
+  auto data = parse( file_name, file->data(), file->size(), key.second );
+  store( key, data );
+  return data;
+}
+
+void marley::ReactionDataRegistry::insert(const std::string& file_name,
+  const std::shared_ptr<const ReactionData>& data)
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  store( std::make_pair(file_name, data->content_hash), data );
+}
+
+void marley::ReactionDataRegistry::store(
+  const std::pair<std::string, uint64_t>& key,
+  const std::shared_ptr<const ReactionData>& data)
+{
+  // Drop any entries for older versions of the same file
+  const auto& file_name = key.first;
+  auto begin = entries_.lower_bound( std::make_pair(file_name, uint64_t(0u)) );
+  auto end = begin;
+  while ( end != entries_.end() && end->first.first == file_name ) ++end;
+  entries_.erase( begin, end );
+
+  entries_.emplace( key, data );
+}
+
+size_t marley::ReactionDataRegistry::size() const {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return entries_.size();
+}
+
+void marley::ReactionDataRegistry::clear() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  entries_.clear();
+}
+
+std::shared_ptr<const marley::ReactionDataRegistry::ReactionData>
+  marley::ReactionDataRegistry::parse(const std::string& file_name,
+  const char* data, size_t size, uint64_t hash)
+{
+  marley::StartupProfile::Timer timer( "reaction data files" );
+
+  auto result = std::make_shared<ReactionData>();
+  result->content_hash = hash;
+
+  std::regex rx_comment("#.*"); // Matches comment lines
+
+  marley::MemoryStreamBuf buf( data, size );
+  std::istream file_in( &buf );
+
+  // String to store the current line of the reaction data file during parsing
+  std::string line;
+
+  /// @todo Add error handling for parsing problems
+  line = marley_utils::get_next_line( file_in, rx_comment, false );
+
+  // Read in the ProcessType code and the target PDG code
+  std::istringstream iss( line );
+  int integer_proc_type;
+  iss >> integer_proc_type;
+
+  auto proc_type = static_cast<ProcType>( integer_proc_type );
+  result->process_type = proc_type;
+
+  // For neutrino-electron elastic scattering, we won't have a table of
+  // matrix elements. Instead, a table of atomic target PDG codes appears.
+  if ( proc_type == ProcType::NuElectronElastic ) {
+
+    do {
+      // Loop over target atoms
+      int target_pdg;
+      while ( iss >> target_pdg ) result->atomic_targets.push_back(
+        target_pdg );
+
+      line = marley_utils::get_next_line( file_in, rx_comment, false );
+      iss.str( line );
+      iss.clear();
+    } while ( !line.empty() );
+
+    return result;
+  }
+
+  // For nuclear reaction modes, there is a single target nucleus PDG code
+  // per file. After parsing it, we proceed to read in the matrix elements.
+  iss >> result->pdg_b;
+
+  // Read in all of the level energy (MeV), squared matrix element (B(F) or
+  // B(GT) strength), and matrix element type identifier (0 represents B(F), 1
+  // represents B(GT)) triplets.
+  auto& matrix_elements = result->matrix_elements;
+
+  // Set the old energy entry to the lowest representable double
+  // value. This guarantees that we always read in the first energy
+  // value given in the reaction data file
+  double old_energy = std::numeric_limits<double>::lowest();
+  while (line = marley_utils::get_next_line(file_in, rx_comment, false),
+    file_in.good())
+  {
+    iss.str(line);
+    iss.clear();
+    /// @todo Consider implementing a sorting procedure rather than strictly
+    /// enforcing that energies must be given in ascending order.
+
+    // The order of the entries is important because later uses of the vector of
+    // matrix elements assume that they are sorted in order of ascending final
+    // level energy.
+    double energy, strength;
+    int integer_me_type;
+    iss >> energy >> strength >> integer_me_type;
+    if (old_energy >= energy) throw marley::Error(std::string("Invalid")
+      + " reaction dataset " + file_name + ". Level energies must be unique"
+      + " and must be given in ascending order.");
+
+    // @todo Right now, 0 corresponds to a Fermi transition, and 1 corresponds
+    // to a Gamow-Teller transition. As you add new matrix element types,
+    // consider changing the convention and its implementation.
+    // All of the level pointers owned by the matrix elements will initially be
+    // set to nullptr. They are assigned later by Reaction::load_from_file()
+    // if discrete level data can be found for the residual nucleus.
+    matrix_elements.emplace_back(energy, strength,
+      static_cast<ME_Type>(integer_me_type), nullptr);
+    old_energy = energy;
+  }
+
+  return result;
+}
@@ -14,6 +14,9 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+// Standard library includes
+#include <algorithm>
+
 // ROOT includes
 #include "TError.h"
 #include "TFile.h"
@@ -65,6 +68,12 @@ void marley::RootEventFileReader::initialize() {
     event_ = std::make_unique<marley::Event>();
     event_ptr_ = event_.get();
     ttree_->SetBranchAddress( "event", &event_ptr_ );
+    event_branch_ = ttree_->GetBranch( "event" );
+
+    // Use a tree cache of the default size for all branches so that
+    // next_events() can prefetch whole clusters of entries
+    ttree_->SetCacheSize( -1 );
+    ttree_->AddBranchToCache( "*", true );
 
     TParameter<double>* temp_param = nullptr;
     tfile_->GetObject( "MARLEY_flux_avg_xsec", temp_param );
@@ -90,12 +99,78 @@ bool marley::RootEventFileReader::next_event( marley::Event& ev )
       return true;
     }
 
+    // Continue with the next part (if any)
+    if ( this->open_next_part() ) return this->next_event( ev );
+
     ev = marley::Event();
     return false;
   }
   else return marley::EventFileReader::next_event( ev );
 }
 
+size_t marley::RootEventFileReader::next_events( size_t max_events,
+  marley::EventBatch& batch )
+{
+  this->ensure_initialized();
+
+  if ( format_ != marley::OutputFile::Format::ROOT ) {
+    return marley::EventFileReader::next_events( max_events, batch );
+  }
+
+  batch.clear();
+
+  // A batch may span more than one part
+  do {
+    Long64_t num_entries = ttree_->GetEntries();
+    Long64_t first = event_num_ + 1;
+    Long64_t last = std::min( num_entries, first
+      + static_cast<Long64_t>(max_events - batch.size()) );
+
+    // Past the end of the tree, behave like next_event() does
+    if ( first >= last ) {
+      event_num_ = std::max( event_num_, static_cast<long>(num_entries) );
+      continue;
+    }
+
+    // Only the baskets needed for this range of entries will be prefetched
+    ttree_->SetCacheEntryRange( first, last );
+
+    batch.reserve( batch.size() + last - first, 0u );
+    for ( Long64_t e = first; e < last; ++e ) {
+      event_branch_->GetEntry( e );
+      batch.add_event( *event_ );
+    }
+    event_num_ = last - 1;
+  } while ( batch.size() < max_events && this->open_next_part() );
+
+  return batch.size();
+}
+
+bool marley::RootEventFileReader::seek_event( size_t event_index )
+{
+  this->ensure_initialized();
+
+  if ( format_ == marley::OutputFile::Format::ROOT ) {
+    if ( !part_names_.empty() ) throw marley::Error("Cannot seek to an"
+      " event in a set of parts. Please read the part \"" + file_name_
+      + "\" (or another one) on its own instead.");
+    if ( static_cast<long>(event_index) >= ttree_->GetEntries() ) {
+      return false;
+    }
+    // next_event() increments the entry number before loading it
+    event_num_ = static_cast<long>( event_index ) - 1;
+    return true;
+  }
+  else return marley::EventFileReader::seek_event( event_index );
+}
+
+bool marley::RootEventFileReader::open_next_part() {
+  if ( !marley::EventFileReader::open_next_part() ) return false;
+  // The event tree was replaced by initialize()
+  event_num_ = -1;
+  return true;
+}
+
 marley::RootEventFileReader::operator bool() const {
   if ( format_ == marley::OutputFile::Format::ROOT ) {
     return ( tfile_ && ttree_ && event_num_ < ttree_->GetEntries() );
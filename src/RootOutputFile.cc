@@ -14,6 +14,9 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <map>
+#include <utility>
+
 #include "marley/Generator.hh"
 #include "marley/OutputFile.hh"
 #include "marley/RootOutputFile.hh"
@@ -22,9 +25,40 @@
 #include "TInterpreter.h"
 #include "TParameter.h"
 
+namespace {
+
+  // Converts a compression algorithm name and level into the integer
+  // representation of the compression settings used by ROOT
+  int root_compression_settings(const std::string& algorithm, int level) {
+
+    if ( algorithm == "none" ) return 0;
+
+    // ROOT algorithm codes and a default level to use for each of them
+    static const std::map<std::string, std::pair<int, int> > algorithms = {
+      { "zlib", { 1, 1 } }, { "lzma", { 2, 7 } }, { "lz4", { 4, 4 } },
+      { "zstd", { 5, 5 } } };
+
+    auto iter = algorithms.find( algorithm );
+    if ( iter == algorithms.end() ) throw marley::Error("Unrecognized"
+      " compression algorithm "" + algorithm + "" requested for a ROOT"
+      " output file");
+
+    if ( level < 0 || level > 9 ) throw marley::Error("Invalid compression"
+      " level " + std::to_string(level) + " requested for a ROOT output"
+      " file. Valid levels range from 1 to 9.");
+
+    if ( level == 0 ) level = iter->second.second;
+
+    // ROOT stores the algorithm in the hundreds digit
+    return 100 * iter->second.first + level;
+  }
+
+}
+
 marley::RootOutputFile::RootOutputFile(const std::string& name,
-  const std::string& format, const std::string& mode, bool force)
-  : marley::OutputFile(name, format, mode, force)
+  const std::string& format, const std::string& mode, bool force,
+  const marley::RootTreeSettings& settings)
+  : marley::OutputFile(name, format, mode, force), settings_( settings )
 {
   load_marley_headers();
   open();
@@ -60,22 +94,52 @@ void marley::RootOutputFile::open() {
   if (file_->IsZombie()) throw marley::Error("Invalid format or other"
     " error encountered while opening the ROOT file \"" + name_ + '\"');
 
+  // New baskets will be compressed using the requested settings
+  if (!settings_.compression.empty()) {
+    file_->SetCompressionSettings( root_compression_settings(
+      settings_.compression, settings_.compression_level) );
+  }
+
   if (mode_ == Mode::OVERWRITE) {
-    // Create a ROOT tree to store the events
-    tree_ = new TTree("MARLEY_event_tree",
-      "Neutrino events generated by MARLEY");
-
-    // We create a branch to store the events here, but set the branch
-    // address to nullptr. This will be fixed later when write_event()
-    // is called.
-    tree_->Branch("event", "marley::Event", nullptr);
+    if (settings_.summary) {
+      // Create a flat summary tree to store the events
+      tree_ = new TTree(marley::RootSummaryTree::TREE_NAME,
+        marley::RootSummaryTree::TREE_TITLE);
+      summary_tree_ = std::make_unique<marley::RootSummaryTree>(tree_, true,
+        settings_.basket_size, settings_.single_precision);
+    }
+    else {
+      // Create a ROOT tree to store the events
+      tree_ = new TTree("MARLEY_event_tree",
+        "Neutrino events generated by MARLEY");
+
+      // We create a branch to store the events here, but set the branch
+      // address to nullptr. This will be fixed later when write_event()
+      // is called.
+      tree_->Branch("event", "marley::Event", nullptr, settings_.basket_size,
+        settings_.split_level);
+    }
+
+    tree_->SetAutoFlush(settings_.auto_flush);
   }
 
   else if (mode_ == Mode::RESUME) {
+    // Continue filling whichever kind of event tree is present in the file
     file_->GetObject("MARLEY_event_tree", tree_);
+    settings_.summary = false;
+    if (!tree_) {
+      file_->GetObject(marley::RootSummaryTree::TREE_NAME, tree_);
+      if (tree_) {
+        settings_.summary = true;
+        summary_tree_ = std::make_unique<marley::RootSummaryTree>(tree_,
+          false);
+      }
+    }
     if (!tree_) throw marley::Error("Cannot resume run. Could not find"
       " a valid MARLEY event tree in the ROOT file \"" + name_ + '\"');
 
+    tree_->SetAutoFlush(settings_.auto_flush);
+
     MARLEY_LOG_INFO() << "Continuing previous run from ROOT file \""
       << name_ << "\"\nwhich contains " << tree_->GetEntries()
       << " events.";
@@ -127,7 +191,7 @@ void marley::RootOutputFile::load_marley_headers() {
 }
 
 void marley::RootOutputFile::write_generator_state(
-  const marley::JSON& json_config, const marley::Generator& gen,
+  const marley::JSON& json_config, const GeneratorState& gen_state,
   const long /*num_events*/)
 {
   // Use std::string objects to store MARLEY configuration and
@@ -136,11 +200,11 @@ void marley::RootOutputFile::write_generator_state(
   // function (see elsewhere in this file for an example).
   file_->cd();
   std::string config( json_config.dump_string() );
-  std::string state( gen.get_state_string() );
-  std::string seed( std::to_string(gen.get_seed()) );
+  std::string state( gen_state.state_string );
+  std::string seed( std::to_string(gen_state.seed) );
 
   TParameter<double> avg_tot_xsec("MARLEY_flux_avg_xsec",
-    gen.flux_averaged_total_xs());
+    gen_state.flux_avg_xsec);
 
   file_->WriteObject(&config, "MARLEY_config", "WriteDelete");
   file_->WriteObject(&state, "MARLEY_state", "WriteDelete");
@@ -150,7 +214,7 @@ void marley::RootOutputFile::write_generator_state(
 }
 
 void marley::RootOutputFile::close(const marley::JSON& json_config,
-  const marley::Generator& gen, const long dummy)
+  const GeneratorState& gen_state, const long dummy)
 {
   // Write the event tree to the ROOT file, replacing the previous
   // version if one exists. Avoid data loss by not deleting the
@@ -161,9 +225,10 @@ void marley::RootOutputFile::close(const marley::JSON& json_config,
 
   // Save the current state of the generator to the ROOT file in case
   // we want to resume a run later
-  write_generator_state(json_config, gen, dummy);
+  write_generator_state(json_config, gen_state, dummy);
 
   file_->Close();
+  this->close_index();
 }
 
 bool marley::RootOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
@@ -210,6 +275,19 @@ bool marley::RootOutputFile::resume(std::unique_ptr<marley::Generator>& gen,
 void marley::RootOutputFile::write_event(const marley::Event* event) {
   if (!event) throw marley::Error("Null pointer passed to"
     " RootOutputFile::write_event()");
-  tree_->SetBranchAddress("event", &event);
-  tree_->Fill();
+
+  if (summary_tree_) summary_tree_->fill(*event, flux_avg_tot_xsec_);
+  else {
+    tree_->SetBranchAddress("event", &event);
+    tree_->Fill();
+  }
+
+  // Index entries for the ROOT format hold the TTree entry number
+  if (index_enabled()) index_event(tree_->GetEntries() - 1);
+}
+
+void marley::RootOutputFile::write_flux_avg_tot_xsec(double avg_tot_xsec) {
+  // Use the same units as marley::EventFileReader::flux_averaged_xsec()
+  flux_avg_tot_xsec_ = avg_tot_xsec * marley_utils::hbar_c2
+    * marley_utils::fm2_to_minus40_cm2 * 1e2; // 10^{-42} cm^2
 }
@@ -0,0 +1,184 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <algorithm>
+#include <string>
+
+#include "marley/Event.hh"
+#include "marley/Particle.hh"
+#include "marley/RootSummaryTree.hh"
+
+namespace {
+  // Initial size of the buffers used to fill the de-excitation product
+  // branches. They are enlarged as needed.
+  constexpr size_t INITIAL_PRODUCT_CAPACITY = 64u;
+}
+
+constexpr const char* marley::RootSummaryTree::TREE_NAME;
+constexpr const char* marley::RootSummaryTree::TREE_TITLE;
+
+marley::RootSummaryTree::RootSummaryTree(TTree* tree, bool create_branches,
+  int basket_size, bool single_precision) : tree_( tree ), pdgs_( INITIAL_PRODUCT_CAPACITY ),
+  Es_( INITIAL_PRODUCT_CAPACITY ), KEs_( INITIAL_PRODUCT_CAPACITY ),
+  pxs_( INITIAL_PRODUCT_CAPACITY ), pys_( INITIAL_PRODUCT_CAPACITY ),
+  pzs_( INITIAL_PRODUCT_CAPACITY )
+{
+  this->connect_branches( create_branches, basket_size, single_precision );
+}
+
+void marley::RootSummaryTree::connect_branches(bool create, int basket_size,
+  bool single_precision)
+{
+  auto& s = summary_;
+
+  // Creates a new branch or sets the address of an existing one
+  auto connect = [this, create, basket_size](const char* name,
+    void* address, const char* leaf_list) -> void
+  {
+    if ( create ) tree_->Branch( name, address, leaf_list, basket_size );
+    else tree_->SetBranchAddress( name, address );
+  };
+
+  // Like connect(), but for the energy and momentum branches. In single
+  // precision, the leaf type "D" (Double_t) is replaced by "d" (Double32_t).
+  // The total energies of heavy nuclei lose their recoil energy at this
+  // precision, but the kinetic energy branches keep it.
+  auto connect_kinematic = [&connect, single_precision](const char* name,
+    void* address, const char* leaf_list) -> void
+  {
+    std::string leaves( leaf_list );
+    if ( single_precision ) leaves.back() = 'd';
+    connect( name, address, leaves.c_str() );
+  };
+
+  // projectile branches
+  connect( "pdgv", &s.pdgv, "pdgv/I" );
+  connect_kinematic( "Ev", &s.Ev, "Ev/D" );
+  connect_kinematic( "KEv", &s.KEv, "KEv/D" );
+  connect_kinematic( "pxv", &s.pxv, "pxv/D" );
+  connect_kinematic( "pyv", &s.pyv, "pyv/D" );
+  connect_kinematic( "pzv", &s.pzv, "pzv/D" );
+
+  // target branches
+  connect( "pdgt", &s.pdgt, "pdgt/I" );
+  connect( "Mt", &s.Mt, "Mt/D" );
+
+  // ejectile branches
+  connect( "pdgl", &s.pdgl, "pdgl/I" );
+  connect_kinematic( "El", &s.El, "El/D" );
+  connect_kinematic( "KEl", &s.KEl, "KEl/D" );
+  connect_kinematic( "pxl", &s.pxl, "pxl/D" );
+  connect_kinematic( "pyl", &s.pyl, "pyl/D" );
+  connect_kinematic( "pzl", &s.pzl, "pzl/D" );
+
+  // residue branches
+  connect( "pdgr", &s.pdgr, "pdgr/I" );
+  connect_kinematic( "Er", &s.Er, "Er/D" );
+  connect_kinematic( "KEr", &s.KEr, "KEr/D" );
+  connect_kinematic( "pxr", &s.pxr, "pxr/D" );
+  connect_kinematic( "pyr", &s.pyr, "pyr/D" );
+  connect_kinematic( "pzr", &s.pzr, "pzr/D" );
+
+  // Nuclear excitation energy branch
+  connect_kinematic( "Ex", &s.Ex, "Ex/D" );
+
+  // Spin and parity branches
+  connect( "twoJ", &s.twoJ, "twoJ/I" );
+  connect( "parity", &s.parity, "parity/I" );
+
+  // De-excitation products (final-state particles other than the
+  // ejectile and ground-state residue)
+  connect( "np", &s.np, "np/I" );
+  connect( "pdgp", pdgs_.data(), "pdgp[np]/I" );
+  connect_kinematic( "Ep",  Es_.data(), "Ep[np]/D" );
+  connect_kinematic( "KEp", KEs_.data(), "KEp[np]/D" );
+  connect_kinematic( "pxp", pxs_.data(), "pxp[np]/D" );
+  connect_kinematic( "pyp", pys_.data(), "pyp[np]/D" );
+  connect_kinematic( "pzp", pzs_.data(), "pzp[np]/D" );
+
+  // Flux-averaged total cross section
+  connect( "xsec", &s.flux_avg_tot_xsec, "xsec/D" );
+
+  // Event weight. Trees written before this branch was added hold
+  // unweighted events.
+  s.weight = 1.;
+  if ( create || tree_->GetBranch("weight") ) {
+    connect( "weight", &s.weight, "weight/D" );
+  }
+
+  // Projectile emission time (zero unless a time-dependent source was used)
+  s.time = 0.;
+  if ( create || tree_->GetBranch("time") ) {
+    connect( "time", &s.time, "time/D" );
+  }
+}
+
+void marley::RootSummaryTree::reserve_products(size_t np) {
+  if ( np <= pdgs_.size() ) return;
+
+  pdgs_.resize( np );
+  Es_.resize( np );
+  KEs_.resize( np );
+  pxs_.resize( np );
+  pys_.resize( np );
+  pzs_.resize( np );
+
+  // Update the branch addresses (resizing the vectors has invalidated them)
+  tree_->SetBranchAddress( "pdgp", pdgs_.data() );
+  tree_->SetBranchAddress( "Ep",  Es_.data() );
+  tree_->SetBranchAddress( "KEp", KEs_.data() );
+  tree_->SetBranchAddress( "pxp", pxs_.data() );
+  tree_->SetBranchAddress( "pyp", pys_.data() );
+  tree_->SetBranchAddress( "pzp", pzs_.data() );
+}
+
+void marley::RootSummaryTree::fill(const marley::Event& ev, double xsec) {
+  summary_.set( ev, xsec );
+  size_t np = static_cast<size_t>( summary_.np );
+  this->reserve_products( np );
+
+  const auto& fparts = ev.get_final_particles();
+  for ( size_t j = 0u; j < np; ++j ) {
+    const auto& fp = fparts.at( j + marley::EventSummary::FIRST_PRODUCT_INDEX );
+    pdgs_[j] = fp.pdg_code();
+    Es_[j] = fp.total_energy();
+    KEs_[j] = fp.kinetic_energy();
+    pxs_[j] = fp.px();
+    pys_[j] = fp.py();
+    pzs_[j] = fp.pz();
+  }
+
+  tree_->Fill();
+}
+
+void marley::RootSummaryTree::fill(const marley::EventSummary& es,
+  const int* pdgs, const double* Es, const double* KEs, const double* pxs,
+  const double* pys, const double* pzs)
+{
+  summary_ = es;
+  size_t np = static_cast<size_t>( summary_.np );
+  this->reserve_products( np );
+
+  std::copy_n( pdgs, np, pdgs_.begin() );
+  std::copy_n( Es, np, Es_.begin() );
+  std::copy_n( KEs, np, KEs_.begin() );
+  std::copy_n( pxs, np, pxs_.begin() );
+  std::copy_n( pys, np, pys_.begin() );
+  std::copy_n( pzs, np, pzs_.begin() );
+
+  tree_->Fill();
+}
@@ -60,7 +60,7 @@ marley::RotationMatrix::RotationMatrix()
 // Returns a copy of the 3-vector v normalized to have unit magnitude
 ThreeVector marley::RotationMatrix::normalize(const ThreeVector& v)
 {
-  static ThreeVector nv({0., 0., 0.});
+  ThreeVector nv = {0., 0., 0.};
   double norm_factor = std::sqrt(std::pow(v[0], 2) + std::pow(v[1], 2)
     + std::pow(v[2], 2));
   if (norm_factor <= 0.) throw marley::Error(std::string("Invalid vector")
@@ -102,6 +102,27 @@ void marley::RotationMatrix::rotate_particle_inplace(marley::Particle& p)
   p.set_pz(rv[2]);
 }
 
+// Rotates the 3-momenta of an array of particles in place
+void marley::RotationMatrix::rotate_particles_inplace(
+  marley::Particle* particles, size_t count)
+{
+  // Copy the matrix elements into local variables once so that they can be
+  // kept in registers throughout the loop
+  const double m00 = matrix_[0][0], m01 = matrix_[0][1], m02 = matrix_[0][2];
+  const double m10 = matrix_[1][0], m11 = matrix_[1][1], m12 = matrix_[1][2];
+  const double m20 = matrix_[2][0], m21 = matrix_[2][1], m22 = matrix_[2][2];
+
+  for ( size_t k = 0u; k < count; ++k ) {
+    marley::Particle& p = particles[ k ];
+    double px = p.px();
+    double py = p.py();
+    double pz = p.pz();
+    p.set_px( m00 * px + m01 * py + m02 * pz );
+    p.set_py( m10 * px + m11 * py + m12 * pz );
+    p.set_pz( m20 * px + m21 * py + m22 * pz );
+  }
+}
+
 /// @details <p>This function is a C++11 version of an original rotation matrix
 /// program by M&ouml;ller &amp; Hughes (see
 /// <a href="http://tinyurl.com/hperc7d">this</a> GitHub page for details)</p>
@@ -125,6 +146,20 @@ marley::RotationMatrix::RotationMatrix(const ThreeVector& from_vec,
   ThreeVector from = normalize(from_vec);
   ThreeVector to = normalize(to_vec);
 
+  this->fill_from_unit_vectors(from, to);
+}
+
+marley::RotationMatrix marley::RotationMatrix::from_unit_vectors(
+  const ThreeVector& from, const ThreeVector& to)
+{
+  RotationMatrix rm;
+  rm.fill_from_unit_vectors(from, to);
+  return rm;
+}
+
+void marley::RotationMatrix::fill_from_unit_vectors(const ThreeVector& from,
+  const ThreeVector& to)
+{
   double e = dot_product(from, to);
   double f = std::abs(e);
 
@@ -0,0 +1,96 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <cstdlib>
+
+#include "marley/SpinCouplingTable.hh"
+
+marley::SpinCouplingTable marley::SpinCouplingTable::fragment_continuum(
+  int twoJi, int two_s, int l_max )
+{
+  SpinCouplingTable table;
+
+  // All allowed values of twoJf have the same remainder modulo two, so the
+  // smallest one is either zero or one
+  table.twoJf_min_ = ( twoJi + two_s ) % 2;
+  table.twoJf_max_ = twoJi + 2*l_max + two_s;
+
+  int T_index = 0;
+  for ( int l = 0; l <= l_max; ++l ) {
+    int two_l = 2*l;
+    for ( int two_j = std::abs(two_l - two_s); two_j <= two_l + two_s;
+      two_j += 2 )
+    {
+      for ( int twoJf = std::abs(twoJi - two_j); twoJf <= twoJi + two_j;
+        twoJf += 2 )
+      {
+        table.terms_.push_back( { l, two_j, twoJf, T_index,
+          (twoJf - table.twoJf_min_) / 2, l % 2 } );
+      }
+      ++T_index;
+    }
+  }
+
+  table.terms_.shrink_to_fit();
+  return table;
+}
+
+marley::SpinCouplingTable marley::SpinCouplingTable::gamma_continuum(
+  int twoJi, int l_max )
+{
+  SpinCouplingTable table;
+
+  table.twoJf_min_ = twoJi % 2;
+  table.twoJf_max_ = twoJi + 2*l_max;
+
+  // There is no monopole radiation, so the sum begins at l = 1
+  for ( int l = 1; l <= l_max; ++l ) {
+    int two_l = 2*l;
+    for ( int twoJf = std::abs(twoJi - two_l); twoJf <= twoJi + two_l;
+      twoJf += 2 )
+    {
+      for ( int p = 0; p < 2; ++p ) {
+        table.terms_.push_back( { l, two_l, twoJf, 2*(l - 1) + p,
+          (twoJf - table.twoJf_min_) / 2, p } );
+      }
+    }
+  }
+
+  table.terms_.shrink_to_fit();
+  return table;
+}
+
+marley::SpinCouplingTable marley::SpinCouplingTable::fragment_discrete(
+  int twoJi, int twoJf, int two_s, bool even_l )
+{
+  SpinCouplingTable table;
+
+  table.twoJf_min_ = twoJf;
+  table.twoJf_max_ = twoJf;
+
+  for ( int two_j = std::abs(twoJi - twoJf); two_j <= twoJi + twoJf;
+    two_j += 2 )
+  {
+    int j_plus_s = ( two_j + two_s ) / 2;
+    for ( int l = std::abs(two_j - two_s) / 2; l <= j_plus_s; ++l ) {
+      if ( (l % 2 == 0) != even_l ) continue;
+      table.terms_.push_back( { l, two_j, twoJf, 0, 0, 0 } );
+    }
+  }
+
+  table.terms_.shrink_to_fit();
+  return table;
+}
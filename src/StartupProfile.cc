@@ -0,0 +1,89 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <iomanip>
+
+// MARLEY includes
+#include "marley/StartupProfile.hh"
+
+marley::StartupProfile::Timer::Timer(const std::string& stage)
+  : stage_( stage ), start_( std::chrono::steady_clock::now() ) {}
+
+marley::StartupProfile::Timer::~Timer() {
+  std::chrono::duration<double> elapsed
+    = std::chrono::steady_clock::now() - start_;
+  marley::StartupProfile::Instance().record( stage_, elapsed.count() );
+}
+
+marley::StartupProfile& marley::StartupProfile::Instance() {
+  static marley::StartupProfile the_instance;
+  return the_instance;
+}
+
+void marley::StartupProfile::record(const std::string& stage,
+  double seconds)
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+
+  // Only a handful of stages are ever recorded, so a linear search is fine
+  auto iter = std::find_if( entries_.begin(), entries_.end(),
+    [&stage](const Entry& e) -> bool { return e.stage == stage; } );
+
+  if ( iter == entries_.end() ) {
+    entries_.emplace_back();
+    iter = entries_.end() - 1;
+    iter->stage = stage;
+  }
+
+  iter->seconds += seconds;
+  ++iter->count;
+}
+
+std::vector<marley::StartupProfile::Entry>
+  marley::StartupProfile::entries() const
+{
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return entries_;
+}
+
+void marley::StartupProfile::report(std::ostream& out) const {
+
+  auto ents = this->entries();
+
+  size_t width = 0u;
+  for ( const auto& e : ents ) width = std::max( width, e.stage.size() );
+
+  // Restore the stream's formatting settings when we're done
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+
+  out << "Startup timing (stages may be nested):";
+  for ( const auto& e : ents ) {
+    out << "\n  " << std::left << std::setw( width ) << e.stage
+      << std::right << std::fixed << std::setprecision( 2 )
+      << std::setw( 10 ) << e.seconds * 1e3 << " ms";
+    if ( e.count > 1u ) out << " (" << e.count << " calls)";
+  }
+  out.flags( flags );
+  out.precision( precision );
+}
+
+void marley::StartupProfile::clear() {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  entries_.clear();
+}
@@ -17,19 +17,36 @@
 
 
 // Standard library includes
+#include <algorithm>
 #include <array>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
 
 // MARLEY includes
 #include "marley/marley_utils.hh"
 #include "marley/BackshiftedFermiGasModel.hh"
+#include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Error.hh"
 #include "marley/FileManager.hh"
 #include "marley/Fragment.hh"
+#include "marley/HauserFeshbachDecay.hh"
+#include "marley/JSON.hh"
 #include "marley/KoningDelarocheOpticalModel.hh"
 #include "marley/Logger.hh"
+#include "marley/MappedFile.hh"
+#include "marley/MassTable.hh"
+#include "marley/MonotonicArena.hh"
 #include "marley/StandardLorentzianModel.hh"
+#include "marley/StartupProfile.hh"
 #include "marley/StructureDatabase.hh"
+#include "marley/TabulatedGammaStrengthFunctionModel.hh"
+#include "marley/TabulatedLevelDensityModel.hh"
 #include "marley/TargetAtom.hh"
+#include "marley/Tracing.hh"
 
 // Define static data members of the StructureDatabase class
 
@@ -43,16 +60,233 @@ std::map<int, marley::Fragment> marley::StructureDatabase::fragment_table_;
 const std::string marley::StructureDatabase
   ::jpi_data_file_name_ = "gs_spin_parity_table.txt";
 
-// Flag indicating whether the ground-state spin-parity data file has already
-// been loaded
-bool marley::StructureDatabase::initialized_gs_spin_parity_table_ = false;
+// Flag used to load the ground-state spin-parity data file only once
+std::once_flag marley::StructureDatabase::jpi_table_once_;
+
+// Suffix appended to the names of compiled discrete level data files
+const std::string marley::StructureDatabase
+  ::COMPILED_DECAY_SCHEME_SUFFIX = ".bin";
+
+namespace {
+
+  // Identifies files written by marley::StructureDatabase::save_model_tables()
+  const std::string TABLE_CACHE_MAGIC = "MARLEY model tables";
+
+  // Labels for the records stored in a model table cache file. Each record
+  // holds the tables for a single model, which are written by the model
+  // itself.
+  enum class TableRecord : int { end = 0, optical_model = 1,
+    level_density = 2, gamma_strength_function = 3 };
+
+  // Identifies files written by
+  // marley::StructureDatabase::compile_decay_schemes()
+  const std::string DECAY_SCHEME_MAGIC = "MARLEY decay schemes";
+
+  // Version number for the format of compiled discrete level data files
+  constexpr uint32_t DECAY_SCHEME_FORMAT_VERSION = 1u;
+
+  // Identifies files written by
+  // marley::StructureDatabase::compile_gs_spin_parity_table()
+  const std::string JPI_TABLE_MAGIC = "MARLEY spin-parity table";
+
+  // Version number for the format of compiled spin-parity table files
+  constexpr uint32_t JPI_TABLE_FORMAT_VERSION = 1u;
+
+  using JPiTable = std::map< int, std::pair<int, marley::Parity> >;
+
+  // Reads a ground-state spin-parity table in its original text format
+  void read_jpi_text(std::istream& in, JPiTable& table) {
+    int nuc_pdg, twoJ;
+    marley::Parity Pi;
+    while ( in >> nuc_pdg >> twoJ >> Pi ) {
+      MARLEY_LOG_DEBUG() << "Nucleus with PDG code " << nuc_pdg
+        << " has spin-parity " << static_cast<double>( twoJ ) / 2.
+        << Pi;
+      table[ nuc_pdg ] = std::pair<int, marley::Parity>( twoJ, Pi );
+    }
+  }
+
+  // Writes a single record, preceded by its size so that readers may skip it
+  void write_table_record(std::ostream& out, TableRecord type, int pdg,
+    const std::string& payload)
+  {
+    marley_utils::write_binary( out, static_cast<int>(type) );
+    marley_utils::write_binary( out, pdg );
+    marley_utils::write_binary( out, payload );
+  }
+
+  // Source of the values of StructureDatabase::worker_generation_. Zero is
+  // never used, so it may mark an empty thread-local cache.
+  std::atomic<uint64_t> next_worker_generation( 1u );
+
+  // Worker chosen by the innermost StructureDatabase::WorkerScope on this
+  // thread, or nullptr if there is none
+  thread_local const void* scope_worker = nullptr;
+
+  // Threads that have not chosen a worker via a WorkerScope each act as
+  // their own worker, which is identified by the address of this variable
+  thread_local char thread_worker;
+
+  // Scratch arena chosen by the innermost StructureDatabase::TaskScope on
+  // this thread, or nullptr if there is none
+  thread_local marley::MonotonicArena* task_arena = nullptr;
+
+}
+
+marley::StructureDatabase::WorkerScope::WorkerScope( const void* worker )
+  : previous_worker_( scope_worker )
+{
+  scope_worker = worker;
+}
+
+marley::StructureDatabase::WorkerScope::~WorkerScope()
+{
+  scope_worker = previous_worker_;
+}
+
+const void* marley::StructureDatabase::current_worker()
+{
+  return scope_worker ? scope_worker : &thread_worker;
+}
+
+marley::StructureDatabase::TaskScope::TaskScope( const void* worker,
+  marley::MonotonicArena* arena ) : worker_scope_( worker ),
+  previous_arena_( task_arena )
+{
+  task_arena = arena;
+}
+
+marley::StructureDatabase::TaskScope::~TaskScope()
+{
+  task_arena = previous_arena_;
+}
+
+void marley::StructureDatabase::WorkerState::clear_hf_decays()
+{
+  hf_decay_cache.clear();
+  hf_decay_lru.clear();
+  hf_decay_bytes = 0u;
+  last_hf_decay_entry = nullptr;
+  uncached_hf_decay.reset();
+}
+
+size_t marley::StructureDatabase::WorkerState::model_memory_usage() const
+{
+  size_t bytes = 0u;
+  for ( const auto& pair : optical_models ) {
+    bytes += pair.second->memory_usage();
+  }
+  for ( const auto& pair : level_density_models ) {
+    bytes += pair.second->memory_usage();
+  }
+  for ( const auto& pair : gamma_strength_function_models ) {
+    bytes += pair.second->memory_usage();
+  }
+  return bytes;
+}
+
+void marley::StructureDatabase::WorkerState::swap_contents(
+  WorkerState& other )
+{
+  // Swapping the containers leaves pointers and iterators to their elements
+  // valid, so last_hf_decay_entry and the lru_iter members may be swapped
+  // along with them
+  std::swap( optical_models, other.optical_models );
+  std::swap( level_density_models, other.level_density_models );
+  std::swap( gamma_strength_function_models,
+    other.gamma_strength_function_models );
+  std::swap( hf_decay_lru, other.hf_decay_lru );
+  std::swap( hf_decay_cache, other.hf_decay_cache );
+  std::swap( hf_decay_bytes, other.hf_decay_bytes );
+  std::swap( hf_decay_evictions, other.hf_decay_evictions );
+  std::swap( last_hf_decay_entry, other.last_hf_decay_entry );
+  std::swap( uncached_hf_decay, other.uncached_hf_decay );
+}
+
+marley::StructureDatabase::WorkerState& marley::StructureDatabase::state()
+  const
+{
+  if ( !concurrent_ ) return main_state_;
+
+  const void* worker = current_worker();
+
+  // Most calls come from the same worker as the previous one on this thread,
+  // so remember its state to avoid locking the mutex
+  struct LastWorker {
+    uint64_t generation;
+    const void* worker;
+    WorkerState* ws;
+  };
+  thread_local LastWorker last = { 0u, nullptr, nullptr };
+  if ( last.generation == worker_generation_ && last.worker == worker ) {
+    return *last.ws;
+  }
+
+  std::lock_guard<std::mutex> lock( worker_mutex_ );
+  auto& ws = worker_states_[ worker ];
+  if ( !ws ) {
+    ws = std::make_unique<WorkerState>();
+    ws->own_arena = std::make_unique<marley::MonotonicArena>();
+    ws->scratch_arena = ws->own_arena.get();
+    ++num_workers_;
+  }
+  last = { worker_generation_, worker, ws.get() };
+  return *ws;
+}
+
+marley::MonotonicArena* marley::StructureDatabase::scratch_arena() const
+{
+  if ( task_arena ) return task_arena;
+  return state().scratch_arena;
+}
+
+template <typename Function> void marley::StructureDatabase::for_each_state(
+  const Function& f ) const
+{
+  if ( !concurrent_ ) {
+    f( main_state_ );
+    return;
+  }
+  std::lock_guard<std::mutex> lock( worker_mutex_ );
+  for ( auto& pair : worker_states_ ) f( *pair.second );
+}
+
+void marley::StructureDatabase::set_concurrent( bool concurrent )
+{
+  if ( concurrent == concurrent_ ) return;
+
+  if ( concurrent ) {
+    // Shared decay schemes must not build anything lazily
+    for ( auto& pair : decay_scheme_table_ ) {
+      if ( pair.second ) pair.second->build_cascade_table();
+    }
+
+    // Hand the existing models and cached objects to the calling thread
+    worker_generation_ = next_worker_generation++;
+    concurrent_ = true;
+    state().swap_contents( main_state_ );
+  }
+  else {
+    // Keep the models and cached objects that belong to the calling thread
+    main_state_.swap_contents( state() );
+    concurrent_ = false;
+    worker_states_.clear();
+    num_workers_ = 0u;
+    worker_generation_ = next_worker_generation++;
+  }
+}
 
 marley::StructureDatabase::StructureDatabase() {}
 
+marley::StructureDatabase::~StructureDatabase() = default;
+
 void marley::StructureDatabase::add_decay_scheme(int pdg,
   std::unique_ptr<marley::DecayScheme>& ds)
 {
   auto* temp_ptr = ds.release();
+  temp_ptr->set_cascade_path_tolerance( cascade_path_tolerance_ );
+  if ( concurrent_ ) temp_ptr->build_cascade_table();
+  std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
   decay_scheme_table_.emplace(pdg, std::unique_ptr<marley::DecayScheme>(temp_ptr));
 }
 
@@ -62,12 +296,116 @@ void marley::StructureDatabase::emplace_decay_scheme(int pdg,
   int Z_ds = (pdg % 10000000)/10000;
   int A_ds = (pdg % 10000)/10;
 
-  // Remove the previous entry (if one exists) for the given PDG code
+  // Remove the previous entry (if one exists) for the given PDG code. Any
+  // cached HauserFeshbachDecay objects may refer to it, so discard those too.
+  clear_hf_decay_cache();
+  auto ds = std::make_unique<marley::DecayScheme>( Z_ds, A_ds, filename,
+    format );
+  ds->set_cascade_path_tolerance( cascade_path_tolerance_ );
+  if ( concurrent_ ) ds->build_cascade_table();
+
+  std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
   decay_scheme_table_.erase(pdg);
 
   // Add the new entry
-  decay_scheme_table_.emplace(pdg, std::make_unique<marley::DecayScheme>(
-    Z_ds, A_ds, filename, format));
+  decay_scheme_table_.emplace( pdg, std::move(ds) );
+}
+
+int marley::StructureDatabase::compile_decay_schemes(
+  const std::string& text_file_name, const std::string& binary_file_name)
+{
+  uint64_t hash;
+  std::ifstream text_in( text_file_name );
+  if ( !text_in.good() || !marley_utils::hash_file(text_file_name, hash) ) {
+    throw marley::Error( "Could not read from the data file "
+      + text_file_name );
+  }
+
+  std::ofstream out( binary_file_name, std::ios::binary );
+  if ( !out ) throw marley::Error( "Could not open the file "
+    + binary_file_name + " for writing" );
+
+  out.write( DECAY_SCHEME_MAGIC.data(), DECAY_SCHEME_MAGIC.size() );
+  marley_utils::write_binary( out, DECAY_SCHEME_FORMAT_VERSION );
+  marley_utils::write_binary( out, hash );
+
+  // Each decay scheme is preceded by a flag. A zero flag marks the
+  // end of the file.
+  int num_schemes = 0;
+  marley::DecayScheme ds;
+  while ( text_in >> ds ) {
+    marley_utils::write_binary( out, 1 );
+    ds.write_binary( out );
+    ++num_schemes;
+  }
+  marley_utils::write_binary( out, 0 );
+
+  out.close();
+  if ( !out ) throw marley::Error( "Failed to write the compiled discrete"
+    " level data file " + binary_file_name );
+
+  return num_schemes;
+}
+
+bool marley::StructureDatabase::read_compiled_decay_schemes(
+  const std::string& binary_file_name, const std::string& text_file_name,
+  std::vector<std::unique_ptr<marley::DecayScheme> >& schemes)
+{
+  schemes.clear();
+
+  // Most data files are not compiled, so check quietly whether this one is
+  // before trying to map it (marley::Error logs its message)
+  if ( !std::ifstream(binary_file_name).good() ) return false;
+
+  // Read straight from the page cache, which is shared by all processes
+  // that load the same file
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( binary_file_name ); }
+  catch ( const marley::Error& ) { return false; }
+
+  marley::MemoryStreamBuf buffer( file->data(), file->size() );
+  std::istream in( &buffer );
+
+  std::string magic( DECAY_SCHEME_MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+
+  uint32_t format_version;
+  uint64_t stored_hash, hash;
+  if ( !in || magic != DECAY_SCHEME_MAGIC
+    || !marley_utils::read_binary(in, format_version)
+    || format_version != DECAY_SCHEME_FORMAT_VERSION
+    || !marley_utils::read_binary(in, stored_hash) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring invalid compiled discrete level data"
+      << " file " << binary_file_name;
+    return false;
+  }
+
+  if ( !marley_utils::hash_file(text_file_name, hash)
+    || hash != stored_hash )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring the compiled discrete level data file "
+      << binary_file_name << ", which is out of date with respect to "
+      << text_file_name;
+    return false;
+  }
+
+  int flag;
+  while ( marley_utils::read_binary(in, flag) && flag != 0 ) {
+    auto ds = std::make_unique< marley::DecayScheme >();
+    ds->read_from_binary_stream( in );
+    if ( !in ) break;
+    schemes.push_back( std::move(ds) );
+  }
+
+  if ( !in ) {
+    MARLEY_LOG_WARNING() << "Ignoring the truncated compiled discrete level"
+      << " data file " << binary_file_name;
+    schemes.clear();
+    return false;
+  }
+
+  return true;
 }
 
 std::set<int> marley::StructureDatabase::find_all_nuclides(
@@ -122,9 +460,38 @@ std::set<int> marley::StructureDatabase::find_all_nuclides(
   return PDGs;
 }
 
+std::string marley::StructureDatabase::read_decay_scheme_file(
+  const std::string& ds_file_name,
+  std::vector< std::unique_ptr<marley::DecayScheme> >& schemes ) const
+{
+  auto& fm = marley::FileManager::Instance();
+  std::string full_ds_file_name = fm.find_file( ds_file_name );
+
+  // Prefer a compiled version of the data file (stored in the same
+  // folder) if an up-to-date one is available. Otherwise, parse the
+  // original.
+  std::string compiled_file_name = full_ds_file_name
+    + COMPILED_DECAY_SCHEME_SUFFIX;
+  if ( !full_ds_file_name.empty() && read_compiled_decay_schemes(
+    compiled_file_name, full_ds_file_name, schemes) )
+  {
+    return compiled_file_name;
+  }
+
+  std::ifstream ds_data_file( full_ds_file_name );
+  auto temp_ds = std::make_unique< marley::DecayScheme >();
+  while ( ds_data_file >> *temp_ds ) {
+    schemes.push_back( std::move(temp_ds) );
+    temp_ds = std::make_unique< marley::DecayScheme >();
+  }
+  return full_ds_file_name;
+}
+
 marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(
   const int particle_id)
 {
+  if ( concurrent_ ) return get_decay_scheme_concurrent( particle_id );
+
   // If we already have the DecayScheme object stored in the lookup table,
   // then just retrieve it
   auto iter = decay_scheme_table_.find( particle_id );
@@ -146,13 +513,15 @@ marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(
     // for, return a pointer to it. Otherwise, print a warning, give up,
     // and return a null pointer.
     std::string ds_file_name = ds_file_iter->second;
-    auto& fm = marley::FileManager::Instance();
-    std::string full_ds_file_name = fm.find_file( ds_file_name );
-    std::ifstream ds_data_file( full_ds_file_name );
+    MARLEY_TRACE_ZONE( trace_zone, "decay scheme load" );
+    MARLEY_TRACE_TEXT( trace_zone, ds_file_name );
+    std::vector< std::unique_ptr<marley::DecayScheme> > schemes;
+    std::string full_ds_file_name = read_decay_scheme_file( ds_file_name,
+      schemes );
+
     bool found_it = false;
-    auto temp_ds = std::make_unique< marley::DecayScheme >();
     int loaded_nuclide_count = 0;
-    while ( ds_data_file >> *temp_ds ) {
+    for ( auto& temp_ds : schemes ) {
       int ds_pdg = temp_ds->pdg();
       if ( particle_id == ds_pdg ) found_it = true;
       this->add_decay_scheme( ds_pdg, temp_ds );
@@ -160,7 +529,6 @@ marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(
       MARLEY_LOG_DEBUG() << "Added decay scheme for " << ta << " from "
         << full_ds_file_name;
       ++loaded_nuclide_count;
-      temp_ds = std::make_unique< marley::DecayScheme >();
     }
     if ( !found_it ) {
       MARLEY_LOG_WARNING() << "Failed to load nuclear structure"
@@ -182,6 +550,76 @@ marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(
   }
 }
 
+marley::DecayScheme* marley::StructureDatabase::get_decay_scheme_concurrent(
+  int particle_id )
+{
+  // The elements of std::map and std::unique_ptr are never moved, so the
+  // pointers returned here stay valid after the mutex is released
+  {
+    std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+    auto iter = decay_scheme_table_.find( particle_id );
+    if ( iter != decay_scheme_table_.end() ) return iter->second.get();
+  }
+
+  marley::TargetAtom ta_requested( particle_id );
+  MARLEY_LOG_DEBUG() << "Looking up structure data for " << ta_requested;
+
+  std::call_once( structure_index_once_, [this]() {
+    std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+    if ( !loaded_structure_index_ ) this->load_structure_index();
+  } );
+
+  std::once_flag* file_once = nullptr;
+  std::string ds_file_name;
+  {
+    std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+    auto ds_file_iter = decay_scheme_filenames_.find( particle_id );
+    if ( ds_file_iter == decay_scheme_filenames_.end() ) return nullptr;
+    ds_file_name = ds_file_iter->second;
+    file_once = &decay_scheme_file_once_[ ds_file_name ];
+  }
+
+  // Each data file is read by a single thread. Any others that need it wait
+  // here until it is done.
+  std::call_once( *file_once, [&]() {
+    MARLEY_TRACE_ZONE( trace_zone, "decay scheme load" );
+    MARLEY_TRACE_TEXT( trace_zone, ds_file_name );
+    std::vector< std::unique_ptr<marley::DecayScheme> > schemes;
+    std::string full_ds_file_name = read_decay_scheme_file( ds_file_name,
+      schemes );
+    for ( auto& ds : schemes ) {
+      ds->set_cascade_path_tolerance( cascade_path_tolerance_ );
+      ds->build_cascade_table();
+    }
+
+    std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+    for ( auto& ds : schemes ) {
+      int ds_pdg = ds->pdg();
+      decay_scheme_table_.emplace( ds_pdg, std::move(ds) );
+      marley::TargetAtom ta( ds_pdg );
+      MARLEY_LOG_DEBUG() << "Added decay scheme for " << ta << " from "
+        << full_ds_file_name;
+    }
+    if ( !schemes.empty() ) {
+      MARLEY_LOG_INFO() << "Loaded structure data for "
+        << schemes.size() << " nuclides from the file "
+        << full_ds_file_name;
+    }
+  } );
+
+  std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+  auto iter = decay_scheme_table_.find( particle_id );
+  if ( iter != decay_scheme_table_.end() ) return iter->second.get();
+
+  MARLEY_LOG_WARNING() << "Failed to load nuclear structure"
+    << " data for " << ta_requested << " from the"
+    << " file " << ds_file_name;
+  // Make a nullptr entry in the lookup table to avoid duplicate attempts
+  // to load the missing data
+  decay_scheme_table_[ particle_id ] = nullptr;
+  return nullptr;
+}
+
 marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(const int Z,
   const int A)
 {
@@ -189,21 +627,49 @@ marley::DecayScheme* marley::StructureDatabase::get_decay_scheme(const int Z,
   return get_decay_scheme( particle_id );
 }
 
+std::unique_ptr<marley::KoningDelarocheOpticalModel>
+  marley::StructureDatabase::create_optical_model(int Z, int A) const
+{
+  const auto& ns = numerical_settings_;
+  auto kd = std::make_unique<marley::KoningDelarocheOpticalModel>( Z, A,
+    ns.numerov_step_size, ns.matching_threshold );
+  kd->set_table_energy_step( ns.transmission_table_step );
+  kd->set_transmission_mode( transmission_mode_ );
+  return kd;
+}
+
+marley::OpticalModel& marley::StructureDatabase::add_optical_model(
+  int nucleus_pid, int Z, int A)
+{
+  MARLEY_TRACE_ZONE( trace_zone, "optical model creation" );
+  MARLEY_TRACE_TEXT( trace_zone, std::to_string(nucleus_pid) );
+  auto kd = create_optical_model( Z, A );
+
+  // Start from the precomputed tables (if any)
+  auto seed = optical_model_seeds_.find( nucleus_pid );
+  if ( seed != optical_model_seeds_.end() ) {
+    std::istringstream in( seed->second );
+    kd->read_tables( in );
+  }
+
+  return *( state().optical_models.emplace(nucleus_pid,
+    std::move(kd)).first->second.get() );
+}
+
 marley::OpticalModel& marley::StructureDatabase::get_optical_model(
   int nucleus_pid)
 {
   /// @todo add check for invalid nucleus particle ID value
-  auto iter = optical_model_table_.find(nucleus_pid);
+  auto& table = state().optical_models;
+  auto iter = table.find(nucleus_pid);
 
-  if (iter == optical_model_table_.end()) {
+  if (iter == table.end()) {
     // The requested level density model wasn't found, so create it and add it
     // to the table, returning a reference to the stored level density model
     // afterwards.
     int Z = marley_utils::get_particle_Z(nucleus_pid);
     int A = marley_utils::get_particle_A(nucleus_pid);
-    return *(optical_model_table_.emplace(nucleus_pid,
-      std::make_unique<marley::KoningDelarocheOpticalModel>(Z, A)).first
-      ->second.get());
+    return this->add_optical_model( nucleus_pid, Z, A );
   }
   else return *(iter->second.get());
 }
@@ -212,37 +678,87 @@ marley::OpticalModel& marley::StructureDatabase::get_optical_model(
   const int Z, const int A)
 {
   int nucleus_pid = marley_utils::get_nucleus_pid(Z, A);
-  auto iter = optical_model_table_.find(nucleus_pid);
+  auto& table = state().optical_models;
+  auto iter = table.find(nucleus_pid);
 
-  if (iter == optical_model_table_.end()) {
+  if (iter == table.end()) {
     // The requested level density model wasn't found, so create it and add it
     // to the table, returning a reference to the stored level density model
     // afterwards.
-    return *(optical_model_table_.emplace(nucleus_pid,
-      std::make_unique<marley::KoningDelarocheOpticalModel>(Z, A)).first
-      ->second.get());
+    return this->add_optical_model( nucleus_pid, Z, A );
   }
   else return *(iter->second.get());
 }
 
+void marley::StructureDatabase::set_transmission_mode(
+  marley::OpticalModel::TransmissionMode mode)
+{
+  transmission_mode_ = mode;
+  for_each_state( [mode]( WorkerState& ws ) {
+    for ( auto& pair : ws.optical_models ) {
+      pair.second->set_transmission_mode( mode );
+    }
+  } );
+
+  // Cached decay widths may have been computed using the other mode
+  clear_hf_decay_cache();
+}
+
 marley::LevelDensityModel& marley::StructureDatabase::get_level_density_model(
   int nucleus_pid)
 {
-  auto iter = level_density_table_.find(nucleus_pid);
+  auto& table = state().level_density_models;
+  auto iter = table.find(nucleus_pid);
 
-  if (iter == level_density_table_.end()) {
+  if (iter == table.end()) {
     // The requested level density model wasn't found, so create it and add it
     // to the table, returning a reference to the stored level density model
     // afterwards.
+    MARLEY_TRACE_ZONE( trace_zone, "level density model creation" );
+    MARLEY_TRACE_TEXT( trace_zone, std::to_string(nucleus_pid) );
     int Z = marley_utils::get_particle_Z( nucleus_pid );
     int A = marley_utils::get_particle_A( nucleus_pid );
-    return *(level_density_table_.emplace(nucleus_pid,
-      std::make_unique<marley::BackshiftedFermiGasModel>(Z, A)).first
-      ->second.get());
+    auto ldm = create_level_density_model( Z, A );
+
+    // Start from the precomputed tables (if any)
+    auto seed = level_density_seeds_.find( nucleus_pid );
+    auto* tab = dynamic_cast<marley::TabulatedLevelDensityModel*>(
+      ldm.get() );
+    if ( tab && seed != level_density_seeds_.end() ) {
+      std::istringstream in( seed->second );
+      tab->read_tables( in );
+    }
+
+    return *(table.emplace(nucleus_pid,
+      std::move(ldm)).first->second.get());
   }
   else return *(iter->second.get());
 }
 
+std::unique_ptr<marley::LevelDensityModel>
+  marley::StructureDatabase::create_level_density_model(int Z, int A) const
+{
+  std::unique_ptr<marley::LevelDensityModel> ldm
+    = std::make_unique<marley::BackshiftedFermiGasModel>(Z, A);
+  if ( tabulate_level_densities_ ) {
+    ldm = std::make_unique<marley::TabulatedLevelDensityModel>(
+      std::move(ldm), numerical_settings_.level_density_table_step );
+  }
+  return ldm;
+}
+
+void marley::StructureDatabase::set_tabulate_level_densities( bool tabulate )
+{
+  if ( tabulate == tabulate_level_densities_ ) return;
+  tabulate_level_densities_ = tabulate;
+  level_density_seeds_.clear();
+
+  // Discard the existing level density models (and any cached decay widths
+  // that used them) so that they will be recreated as needed
+  clear_hf_decay_cache();
+  for_each_state( []( WorkerState& ws ) { ws.level_density_models.clear(); } );
+}
+
 marley::LevelDensityModel& marley::StructureDatabase::get_level_density_model(
   const int Z, const int A)
 {
@@ -265,28 +781,944 @@ marley::GammaStrengthFunctionModel&
 {
   int pid = marley_utils::get_nucleus_pid(Z, A);
 
-  auto iter = gamma_strength_function_table_.find(pid);
+  auto& table = state().gamma_strength_function_models;
+  auto iter = table.find(pid);
 
-  if (iter == gamma_strength_function_table_.end()) {
+  if (iter == table.end()) {
     // The requested gamma-ray strength function model wasn't found, so create
     // it and add it to the table, returning a reference to the stored strength
     // function model afterwards.
-    return *(gamma_strength_function_table_.emplace(pid,
-      std::make_unique<marley::StandardLorentzianModel>(Z, A)).first
-      ->second.get());
+    std::unique_ptr<marley::GammaStrengthFunctionModel> gsfm
+      = std::make_unique<marley::StandardLorentzianModel>(Z, A);
+    if ( tabulate_gamma_strength_functions_ ) {
+      gsfm = std::make_unique<marley::TabulatedGammaStrengthFunctionModel>(
+        std::move(gsfm), numerical_settings_.gamma_strength_table_step );
+    }
+    return *(table.emplace(pid,
+      std::move(gsfm)).first->second.get());
   }
   else return *(iter->second.get());
 }
 
+void marley::StructureDatabase::set_tabulate_gamma_strength_functions(
+  bool tabulate )
+{
+  if ( tabulate == tabulate_gamma_strength_functions_ ) return;
+  tabulate_gamma_strength_functions_ = tabulate;
+
+  // Discard the existing gamma-ray strength function models (and any cached
+  // decay widths that used them) so that they will be recreated as needed
+  clear_hf_decay_cache();
+  for_each_state( []( WorkerState& ws ) {
+    ws.gamma_strength_function_models.clear();
+  } );
+}
+
 void marley::StructureDatabase::remove_decay_scheme(int pdg)
 {
   // Remove the decay scheme with this PDG code if it exists in the database.
-  // If it doesn't, do nothing.
+  // If it doesn't, do nothing. Any cached HauserFeshbachDecay objects may
+  // refer to it, so discard those as well.
+  clear_hf_decay_cache();
+  std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
   decay_scheme_table_.erase( pdg );
 }
 
 void marley::StructureDatabase::clear() {
+  // The cached HauserFeshbachDecay objects refer to the decay schemes, so
+  // remove them first
+  clear_hf_decay_cache();
+  std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
   decay_scheme_table_.clear();
+  decay_scheme_file_once_.clear();
+}
+
+marley::HauserFeshbachDecay& marley::StructureDatabase::get_hf_decay(
+  const marley::Particle& compound_nucleus, double Exi, int twoJi,
+  marley::Parity Pi)
+{
+  auto& ws = state();
+
+  // If caching is disabled, then just rebuild the same object each time
+  if ( hf_decay_cache_size_ == 0u ) {
+    MARLEY_TRACE_ZONE( trace_zone, "HauserFeshbachDecay cache miss" );
+    MARLEY_TRACE_TEXT( trace_zone, marley::Tracing::describe_state(
+      compound_nucleus.pdg_code(), Exi, twoJi, Pi) );
+    if ( ws.uncached_hf_decay ) ws.uncached_hf_decay->reset(
+      compound_nucleus, Exi, twoJi, Pi, *this );
+    else ws.uncached_hf_decay = std::make_unique<
+      marley::HauserFeshbachDecay>( compound_nucleus, Exi, twoJi, Pi, *this );
+    return *ws.uncached_hf_decay;
+  }
+
+  HFDecayKey key( compound_nucleus.pdg_code(), compound_nucleus.charge(),
+    Exi, twoJi, static_cast<bool>(Pi) );
+
+  // The object returned by the previous call may have built continuum CDFs
+  // since then, so measure it again before any eviction decisions are made
+  if ( memory_budget_ > 0u && ws.last_hf_decay_entry ) {
+    update_hf_decay_bytes( ws, *ws.last_hf_decay_entry );
+  }
+
+  // If we already have a matching object, mark it as the most recently used
+  // entry and return it
+  auto iter = ws.hf_decay_cache.find( key );
+  if ( iter != ws.hf_decay_cache.end() ) {
+    ws.hf_decay_lru.splice( ws.hf_decay_lru.begin(), ws.hf_decay_lru,
+      iter->second.lru_iter );
+    ws.last_hf_decay_entry = &iter->second;
+    return *iter->second.hfd;
+  }
+
+  // Otherwise, make room for a new entry by evicting the least recently
+  // used one (if needed). The evicted object is recycled so that its exit
+  // channel storage can be reused.
+  MARLEY_TRACE_ZONE( trace_zone, "HauserFeshbachDecay cache miss" );
+  MARLEY_TRACE_TEXT( trace_zone, marley::Tracing::describe_state(
+    compound_nucleus.pdg_code(), Exi, twoJi, Pi) );
+  std::unique_ptr<marley::HauserFeshbachDecay> hfd;
+  if ( ws.hf_decay_cache.size() >= hf_decay_cache_size_ ) {
+    auto evicted = ws.hf_decay_cache.find( ws.hf_decay_lru.back() );
+    hfd = std::move( evicted->second.hfd );
+    ws.hf_decay_bytes -= evicted->second.bytes;
+    if ( ws.last_hf_decay_entry == &evicted->second ) {
+      ws.last_hf_decay_entry = nullptr;
+    }
+    ws.hf_decay_cache.erase( evicted );
+    ws.hf_decay_lru.pop_back();
+    ++ws.hf_decay_evictions;
+  }
+
+  if ( hfd ) hfd->reset( compound_nucleus, Exi, twoJi, Pi, *this );
+  else hfd = std::make_unique<marley::HauserFeshbachDecay>( compound_nucleus,
+    Exi, twoJi, Pi, *this );
+  auto& result = *hfd;
+
+  ws.hf_decay_lru.push_front( key );
+  auto& entry = ws.hf_decay_cache.emplace( key, HFDecayCacheEntry{
+    std::move(hfd), ws.hf_decay_lru.begin(), 0u } ).first->second;
+  ws.last_hf_decay_entry = &entry;
+
+  if ( memory_budget_ > 0u ) {
+    update_hf_decay_bytes( ws, entry );
+    enforce_memory_budget( ws );
+  }
+
+  return result;
+}
+
+void marley::StructureDatabase::set_hf_decay_cache_size( size_t size ) {
+  hf_decay_cache_size_ = size;
+  clear_hf_decay_cache();
+}
+
+void marley::StructureDatabase::clear_hf_decay_cache() {
+  for_each_state( []( WorkerState& ws ) { ws.clear_hf_decays(); } );
+}
+
+void marley::StructureDatabase::update_hf_decay_bytes( WorkerState& ws,
+  HFDecayCacheEntry& entry )
+{
+  size_t bytes = sizeof( marley::HauserFeshbachDecay )
+    + entry.hfd->memory_usage();
+  ws.hf_decay_bytes += bytes - entry.bytes;
+  entry.bytes = bytes;
+}
+
+void marley::StructureDatabase::enforce_memory_budget( WorkerState& ws ) {
+  // The decay schemes and models are only measured once per call. Only the
+  // HauserFeshbachDecay cache can shrink below.
+  size_t table_bytes = table_memory_usage( ws );
+
+  // In concurrent mode, each worker gets an equal share of the budget
+  size_t budget = memory_budget_;
+  if ( concurrent_ ) budget /= std::max( size_t(1u), num_workers_.load() );
+
+  // Always keep the most recently used entry, which may still be in use by
+  // the caller
+  while ( ws.hf_decay_cache.size() > 1u
+    && table_bytes + ws.hf_decay_bytes > budget )
+  {
+    auto evicted = ws.hf_decay_cache.find( ws.hf_decay_lru.back() );
+    ws.hf_decay_bytes -= evicted->second.bytes;
+    if ( ws.last_hf_decay_entry == &evicted->second ) {
+      ws.last_hf_decay_entry = nullptr;
+    }
+    ws.hf_decay_cache.erase( evicted );
+    ws.hf_decay_lru.pop_back();
+    ++ws.hf_decay_evictions;
+  }
+}
+
+void marley::StructureDatabase::set_integration_tolerance( double rel_tol )
+{
+  if ( !(rel_tol >= 0.) ) throw marley::Error( "Invalid relative tolerance "
+    + std::to_string(rel_tol) + " passed to marley::StructureDatabase::"
+    "set_integration_tolerance()" );
+
+  if ( rel_tol == 0. ) integrator_.reset();
+  else integrator_ = std::make_unique<marley::AdaptiveIntegrator>( rel_tol );
+  clear_hf_decay_cache();
+}
+
+marley::NumericalSettings marley::NumericalSettings::preset(
+  marley::Precision precision )
+{
+  // Start from the defaults used by the individual classes
+  NumericalSettings settings;
+  settings.numerov_step_size
+    = marley::KoningDelarocheOpticalModel::DEFAULT_NUMEROV_STEP_SIZE;
+  settings.matching_threshold
+    = marley::KoningDelarocheOpticalModel::DEFAULT_MATCHING_RADIUS_THRESHOLD;
+  settings.chebyshev_points = marley::DEFAULT_N_CHEBYSHEV;
+  settings.sampling_tolerance = 1e-12;
+  settings.transmission_table_step
+    = marley::KoningDelarocheOpticalModel::DEFAULT_TABLE_ENERGY_STEP;
+  settings.level_density_table_step
+    = marley::TabulatedLevelDensityModel::DEFAULT_ENERGY_STEP;
+  settings.gamma_strength_table_step
+    = marley::TabulatedGammaStrengthFunctionModel::DEFAULT_ENERGY_STEP;
+
+  if ( precision == marley::Precision::Validation ) {
+    settings.numerov_step_size /= 2.;
+    settings.matching_threshold /= 10.;
+    settings.chebyshev_points *= 2u;
+    settings.sampling_tolerance = 1e-14;
+  }
+  else if ( precision == marley::Precision::Fast ) {
+    settings.numerov_step_size *= 1.5;
+    settings.matching_threshold *= 10.;
+    settings.chebyshev_points /= 2u;
+    settings.sampling_tolerance = 1e-8;
+    settings.transmission_table_step *= 2.;
+    settings.level_density_table_step *= 2.;
+    settings.gamma_strength_table_step *= 2.;
+  }
+
+  return settings;
+}
+
+void marley::StructureDatabase::set_numerical_settings(
+  const marley::NumericalSettings& settings )
+{
+  if ( !(settings.numerov_step_size > 0.) || !(settings.matching_threshold
+    > 0.) || settings.chebyshev_points < 2u
+    || !(settings.sampling_tolerance > 0.)
+    || !(settings.transmission_table_step > 0.)
+    || !(settings.level_density_table_step > 0.)
+    || !(settings.gamma_strength_table_step > 0.) )
+  {
+    throw marley::Error( "Invalid numerical settings passed to"
+      " marley::StructureDatabase::set_numerical_settings()" );
+  }
+
+  numerical_settings_ = settings;
+
+  // Discard the models that depend on these settings (and any cached decay
+  // widths that used them) so that they will be recreated as needed
+  clear_hf_decay_cache();
+  optical_model_seeds_.clear();
+  level_density_seeds_.clear();
+  for_each_state( [this]( WorkerState& ws ) {
+    ws.optical_models.clear();
+    if ( tabulate_level_densities_ ) ws.level_density_models.clear();
+    if ( tabulate_gamma_strength_functions_ ) {
+      ws.gamma_strength_function_models.clear();
+    }
+  } );
+}
+
+void marley::StructureDatabase::set_precision( marley::Precision precision )
+{
+  this->set_numerical_settings( marley::NumericalSettings::preset(
+    precision ) );
+
+  if ( precision == marley::Precision::Validation ) {
+    this->set_integration_tolerance( 1e-8 );
+  }
+  else this->set_integration_tolerance( 0. );
+
+  bool tabulate = ( precision == marley::Precision::Fast );
+  this->set_tabulate_level_densities( tabulate );
+  this->set_tabulate_gamma_strength_functions( tabulate );
+  this->set_transmission_mode( tabulate
+    ? marley::OpticalModel::TransmissionMode::Table
+    : marley::OpticalModel::TransmissionMode::Exact );
+}
+
+void marley::StructureDatabase::set_fragment_l_tolerance( double rel_tol )
+{
+  if ( !(rel_tol >= 0. && rel_tol < 1.) ) throw marley::Error( "Invalid"
+    " relative tolerance " + std::to_string(rel_tol) + " passed to"
+    " marley::StructureDatabase::set_fragment_l_tolerance()" );
+
+  fragment_l_tolerance_ = rel_tol;
+  clear_hf_decay_cache();
+}
+
+void marley::StructureDatabase::set_lazy_continuum_widths( bool lazy ) {
+  lazy_continuum_widths_ = lazy;
+  clear_hf_decay_cache();
+}
+
+void marley::StructureDatabase::set_discrete_pool_tolerance(
+  double tolerance )
+{
+  if ( !(tolerance >= 0. && tolerance < 1.) ) throw marley::Error( "Invalid"
+    " discrete exit channel pool tolerance " + std::to_string(tolerance)
+    + " passed to marley::StructureDatabase::set_discrete_pool_tolerance()" );
+
+  discrete_pool_tolerance_ = tolerance;
+  clear_hf_decay_cache();
+}
+
+void marley::StructureDatabase::set_cascade_path_tolerance(
+  double tolerance )
+{
+  if ( tolerance < 0. || tolerance >= 1. ) throw marley::Error( "Invalid"
+    " cascade path tolerance " + std::to_string(tolerance) + " passed to"
+    " marley::StructureDatabase::set_cascade_path_tolerance()" );
+
+  cascade_path_tolerance_ = tolerance;
+
+  std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+  for ( auto& pair : decay_scheme_table_ ) {
+    if ( pair.second ) pair.second->set_cascade_path_tolerance( tolerance );
+  }
+}
+
+void marley::StructureDatabase::check_integration_result(
+  const marley::IntegrationResult& result, double a, double b ) const
+{
+  static marley::Logger::RateLimit limit;
+  MARLEY_LOG_WARNING_LIMITED( limit ) << "Numerical integration on [ " << a
+    << ", " << b << " ] did not reach the requested relative tolerance of "
+    << integrator_->rel_tol() << " after " << result.evaluations
+    << " evaluations. The estimated absolute error of the result "
+    << result.value << " is " << result.error << '.';
+}
+
+void marley::StructureDatabase::set_memory_budget( size_t bytes ) {
+  memory_budget_ = bytes;
+  if ( memory_budget_ == 0u ) return;
+
+  // Bring the recorded sizes of any existing entries up to date
+  for_each_state( [this]( WorkerState& ws ) {
+    for ( auto& pair : ws.hf_decay_cache ) {
+      update_hf_decay_bytes( ws, pair.second );
+    }
+    enforce_memory_budget( ws );
+  } );
+}
+
+template <typename Builder> const marley::SpinCouplingTable&
+  marley::StructureDatabase::get_couplings( const CouplingKey& key,
+  const Builder& build )
+{
+  if ( !concurrent_ ) {
+    auto iter = spin_coupling_table_.find( key );
+    if ( iter == spin_coupling_table_.end() ) {
+      iter = spin_coupling_table_.emplace( key, build() ).first;
+    }
+    return iter->second;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock( spin_coupling_mutex_ );
+    auto iter = spin_coupling_table_.find( key );
+    if ( iter != spin_coupling_table_.end() ) return iter->second;
+  }
+
+  // Build the table without holding the lock. If another thread got there
+  // first, its (identical) table is kept.
+  auto table = build();
+  std::lock_guard<std::mutex> lock( spin_coupling_mutex_ );
+  return spin_coupling_table_.emplace( key, std::move(table) ).first->second;
+}
+
+const marley::StructureDatabase::ChannelThresholds&
+  marley::StructureDatabase::get_channel_thresholds( int nuc_pdg )
+{
+  auto build = [nuc_pdg]() -> ChannelThresholds {
+    const auto& mt = marley::MassTable::Instance();
+    int Z = marley_utils::get_particle_Z( nuc_pdg );
+    int A = marley_utils::get_particle_A( nuc_pdg );
+    ChannelThresholds thresholds;
+    thresholds.unbound_threshold = std::numeric_limits<double>::max();
+    for ( const auto& pair : fragments() ) {
+      double Sa = mt.fragment_emission_threshold( Z, A, pair.second );
+      thresholds.separation_energies.push_back( Sa );
+      thresholds.unbound_threshold = std::min( thresholds.unbound_threshold,
+        Sa );
+    }
+    return thresholds;
+  };
+
+  if ( !concurrent_ ) {
+    auto iter = channel_threshold_table_.find( nuc_pdg );
+    if ( iter == channel_threshold_table_.end() ) {
+      iter = channel_threshold_table_.emplace( nuc_pdg, build() ).first;
+    }
+    return iter->second;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock( channel_threshold_mutex_ );
+    auto iter = channel_threshold_table_.find( nuc_pdg );
+    if ( iter != channel_threshold_table_.end() ) return iter->second;
+  }
+
+  auto thresholds = build();
+  std::lock_guard<std::mutex> lock( channel_threshold_mutex_ );
+  return channel_threshold_table_.emplace( nuc_pdg,
+    std::move(thresholds) ).first->second;
+}
+
+const marley::SpinCouplingTable&
+  marley::StructureDatabase::get_fragment_continuum_couplings( int twoJi,
+  int two_s, int l_max )
+{
+  return get_couplings( CouplingKey( CouplingKind::FragmentContinuum, twoJi,
+    two_s, l_max, 0 ), [=]() { return marley::SpinCouplingTable
+    ::fragment_continuum( twoJi, two_s, l_max ); } );
+}
+
+const marley::SpinCouplingTable&
+  marley::StructureDatabase::get_gamma_continuum_couplings( int twoJi,
+  int l_max )
+{
+  return get_couplings( CouplingKey( CouplingKind::GammaContinuum, twoJi,
+    l_max, 0, 0 ), [=]() { return marley::SpinCouplingTable
+    ::gamma_continuum( twoJi, l_max ); } );
+}
+
+const marley::SpinCouplingTable&
+  marley::StructureDatabase::get_fragment_discrete_couplings( int twoJi,
+  int twoJf, int two_s, bool even_l )
+{
+  return get_couplings( CouplingKey( CouplingKind::FragmentDiscrete, twoJi,
+    twoJf, two_s, even_l ), [=]() { return marley::SpinCouplingTable
+    ::fragment_discrete( twoJi, twoJf, two_s, even_l ); } );
+}
+
+size_t marley::StructureDatabase::shared_memory_usage() const {
+  size_t bytes = 0u;
+  {
+    std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+    for ( const auto& pair : decay_scheme_table_ ) {
+      if ( !pair.second ) continue;
+      bytes += sizeof( marley::DecayScheme ) + pair.second->memory_usage();
+    }
+  }
+  std::lock_guard<std::mutex> lock( spin_coupling_mutex_ );
+  for ( const auto& pair : spin_coupling_table_ ) {
+    bytes += sizeof( marley::SpinCouplingTable ) + pair.second.memory_usage();
+  }
+  return bytes;
+}
+
+size_t marley::StructureDatabase::table_memory_usage(
+  const WorkerState& ws ) const
+{
+  // In concurrent mode, the shared tables are charged equally to each worker
+  size_t shared_bytes = shared_memory_usage();
+  if ( concurrent_ ) shared_bytes /= std::max( size_t(1u),
+    num_workers_.load() );
+  return shared_bytes + ws.model_memory_usage();
+}
+
+size_t marley::StructureDatabase::memory_usage() const {
+  size_t bytes = shared_memory_usage();
+  for_each_state( [&bytes]( const WorkerState& ws ) {
+    bytes += ws.model_memory_usage();
+    for ( const auto& pair : ws.hf_decay_cache ) {
+      bytes += sizeof( marley::HauserFeshbachDecay )
+        + pair.second.hfd->memory_usage();
+    }
+  } );
+  return bytes;
+}
+
+marley::JSON marley::StructureDatabase::memory_report() const {
+
+  // Bytes held for each nuclide, keyed by PDG code and then by data type
+  std::map<int, std::map<std::string, size_t> > nuclide_bytes;
+
+  {
+    std::lock_guard<std::mutex> lock( decay_scheme_mutex_ );
+    for ( const auto& pair : decay_scheme_table_ ) {
+      if ( !pair.second ) continue;
+      nuclide_bytes[ pair.first ][ "decay_scheme" ]
+        += sizeof( marley::DecayScheme ) + pair.second->memory_usage();
+    }
+  }
+
+  // In concurrent mode, the models and cached objects of all workers are
+  // added together
+  size_t num_entries = 0u;
+  size_t num_evictions = 0u;
+  for_each_state( [&]( const WorkerState& ws ) {
+    for ( const auto& pair : ws.optical_models ) {
+      nuclide_bytes[ pair.first ][ "optical_model" ]
+        += pair.second->memory_usage();
+    }
+    for ( const auto& pair : ws.level_density_models ) {
+      nuclide_bytes[ pair.first ][ "level_density_model" ]
+        += pair.second->memory_usage();
+    }
+    for ( const auto& pair : ws.gamma_strength_function_models ) {
+      nuclide_bytes[ pair.first ][ "gamma_strength_function_model" ]
+        += pair.second->memory_usage();
+    }
+    for ( const auto& pair : ws.hf_decay_cache ) {
+      nuclide_bytes[ std::get<0>(pair.first) ][ "hf_decays" ]
+        += sizeof( marley::HauserFeshbachDecay )
+        + pair.second.hfd->memory_usage();
+    }
+    num_entries += ws.hf_decay_cache.size();
+    num_evictions += ws.hf_decay_evictions;
+  } );
+
+  marley::JSON nuclides = marley::JSON::object();
+  std::map<std::string, size_t> type_bytes;
+  size_t total_bytes = 0u;
+  for ( const auto& nuc_pair : nuclide_bytes ) {
+    marley::JSON nuc = marley::JSON::object();
+    for ( const auto& type_pair : nuc_pair.second ) {
+      nuc[ type_pair.first ] = type_pair.second;
+      type_bytes[ type_pair.first ] += type_pair.second;
+      total_bytes += type_pair.second;
+    }
+    nuclides[ std::to_string(nuc_pair.first) ] = nuc;
+  }
+
+  marley::JSON types = marley::JSON::object();
+  for ( const auto& pair : type_bytes ) types[ pair.first ] = pair.second;
+
+  marley::JSON cache = marley::JSON::object();
+  cache[ "entries" ] = num_entries;
+  cache[ "max_entries" ] = hf_decay_cache_size_;
+  cache[ "evictions" ] = num_evictions;
+
+  marley::JSON report = marley::JSON::object();
+  report[ "total_bytes" ] = total_bytes;
+  report[ "budget_bytes" ] = memory_budget_;
+  report[ "types" ] = types;
+  report[ "hf_decay_cache" ] = cache;
+  report[ "nuclides" ] = nuclides;
+  return report;
+}
+
+void marley::StructureDatabase::set_table_cache_file(
+  const std::string& file_name)
+{
+  table_cache_file_ = file_name;
+  if ( file_name.empty() ) return;
+
+  const auto& fm = marley::FileManager::Instance();
+  std::string full_file_name = fm.find_file( file_name );
+  if ( full_file_name.empty() ) {
+    MARLEY_LOG_INFO() << "The model table cache file " << file_name
+      << " will be created";
+    return;
+  }
+
+  // Write any updates back to the same file that was loaded
+  table_cache_file_ = full_file_name;
+  load_model_tables( full_file_name );
+}
+
+void marley::StructureDatabase::save_table_cache() const {
+  if ( !table_cache_file_.empty() ) save_model_tables( table_cache_file_ );
+}
+
+void marley::StructureDatabase::save_model_tables(
+  const std::string& file_name) const
+{
+  // Write to a temporary file first so that an interrupted write (or another
+  // job reading the cache at the same time) never sees a partial file
+  std::string temp_file_name = file_name + ".tmp";
+  std::ofstream out( temp_file_name, std::ios::binary );
+  if ( !out ) throw marley::Error( "Could not open the model table cache"
+    " file " + temp_file_name + " for writing" );
+
+  out.write( TABLE_CACHE_MAGIC.data(), TABLE_CACHE_MAGIC.size() );
+  uint32_t format_version = TABLE_CACHE_FORMAT_VERSION;
+  marley_utils::write_binary( out, format_version );
+  marley_utils::write_binary( out, std::string(MARLEY_VERSION) );
+  marley_utils::write_binary( out, fragment_l_max_ );
+  marley_utils::write_binary( out, gamma_l_max_ );
+
+  // In concurrent mode, each worker has its own copy of the models, and the
+  // copies may hold different parts of the tables. The tables found for each
+  // nuclide are merged into a new model before they are written.
+  using TMode = marley::OpticalModel::TransmissionMode;
+  using Payloads = std::map<int, std::vector<std::string> >;
+  Payloads optical_tables, level_density_tables, gamma_strength_tables;
+  for_each_state( [&]( const WorkerState& ws ) {
+    for ( const auto& pair : ws.optical_models ) {
+      if ( transmission_mode_ != TMode::Table ) break;
+      const auto* kd = dynamic_cast<
+        const marley::KoningDelarocheOpticalModel*>( pair.second.get() );
+      if ( !kd ) continue;
+      std::ostringstream payload;
+      kd->write_tables( payload );
+      optical_tables[ pair.first ].push_back( payload.str() );
+    }
+
+    for ( const auto& pair : ws.level_density_models ) {
+      const auto* tab = dynamic_cast<
+        const marley::TabulatedLevelDensityModel*>( pair.second.get() );
+      if ( !tab ) continue;
+      std::ostringstream payload;
+      tab->write_tables( payload );
+      level_density_tables[ pair.first ].push_back( payload.str() );
+    }
+
+    for ( const auto& pair : ws.gamma_strength_function_models ) {
+      const auto* tab = dynamic_cast<
+        const marley::TabulatedGammaStrengthFunctionModel*>(
+        pair.second.get() );
+      if ( !tab ) continue;
+      std::ostringstream payload;
+      tab->write_tables( payload );
+      gamma_strength_tables[ pair.first ].push_back( payload.str() );
+    }
+  } );
+
+  auto write_records = [&out]( TableRecord type, const Payloads& payloads,
+    const auto& create_model )
+  {
+    for ( const auto& pair : payloads ) {
+      const auto& parts = pair.second;
+      if ( parts.size() == 1u ) {
+        write_table_record( out, type, pair.first, parts.front() );
+        continue;
+      }
+      auto model = create_model( marley_utils::get_particle_Z(pair.first),
+        marley_utils::get_particle_A(pair.first) );
+      for ( const auto& part : parts ) {
+        std::istringstream in( part );
+        model->read_tables( in );
+      }
+      std::ostringstream merged;
+      model->write_tables( merged );
+      write_table_record( out, type, pair.first, merged.str() );
+    }
+  };
+
+  const auto& ns = numerical_settings_;
+  write_records( TableRecord::optical_model, optical_tables,
+    [this]( int Z, int A ) { return create_optical_model( Z, A ); } );
+  write_records( TableRecord::level_density, level_density_tables,
+    [&ns]( int Z, int A ) {
+      return std::make_unique<marley::TabulatedLevelDensityModel>(
+        std::make_unique<marley::BackshiftedFermiGasModel>( Z, A ),
+        ns.level_density_table_step );
+    } );
+  write_records( TableRecord::gamma_strength_function, gamma_strength_tables,
+    [&ns]( int Z, int A ) {
+      return std::make_unique<marley::TabulatedGammaStrengthFunctionModel>(
+        std::make_unique<marley::StandardLorentzianModel>( Z, A ),
+        ns.gamma_strength_table_step );
+    } );
+
+  marley_utils::write_binary( out, static_cast<int>(TableRecord::end) );
+  out.close();
+  if ( !out ) throw marley::Error( "Failed to write the model table cache"
+    " file " + temp_file_name );
+
+  if ( std::rename(temp_file_name.c_str(), file_name.c_str()) != 0 ) {
+    throw marley::Error( "Could not rename " + temp_file_name + " to "
+      + file_name + " while saving the model table cache" );
+  }
+
+  MARLEY_LOG_INFO() << "Model tables saved to " << file_name;
+}
+
+bool marley::StructureDatabase::load_model_tables(
+  const std::string& file_name)
+{
+  std::ifstream in( file_name, std::ios::binary );
+  if ( !in ) {
+    MARLEY_LOG_WARNING() << "Could not open the model table cache file "
+      << file_name;
+    return false;
+  }
+
+  std::string magic( TABLE_CACHE_MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+
+  uint32_t format_version;
+  std::string version;
+  int fragment_l_max, gamma_l_max;
+  if ( !in || magic != TABLE_CACHE_MAGIC
+    || !marley_utils::read_binary(in, format_version)
+    || format_version != TABLE_CACHE_FORMAT_VERSION
+    || !marley_utils::read_binary(in, version)
+    || !marley_utils::read_binary(in, fragment_l_max)
+    || !marley_utils::read_binary(in, gamma_l_max) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring invalid model table cache file "
+      << file_name;
+    return false;
+  }
+
+  if ( version != MARLEY_VERSION || fragment_l_max != fragment_l_max_
+    || gamma_l_max != gamma_l_max_ )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring the model table cache file "
+      << file_name << ", which was written by MARLEY version " << version
+      << " using fragment_lmax = " << fragment_l_max << " and gamma_lmax = "
+      << gamma_l_max;
+    return false;
+  }
+
+  using TMode = marley::OpticalModel::TransmissionMode;
+  int num_loaded = 0;
+  bool ok = true;
+  while ( true ) {
+    int type, pdg;
+    std::string payload;
+    if ( !marley_utils::read_binary(in, type) ) { ok = false; break; }
+    if ( type == static_cast<int>(TableRecord::end) ) break;
+    if ( !marley_utils::read_binary(in, pdg)
+      || !marley_utils::read_binary(in, payload) ) { ok = false; break; }
+
+    // Records for models that are not currently tabulated are skipped
+    std::istringstream payload_in( payload );
+    bool used = false;
+    if ( type == static_cast<int>(TableRecord::optical_model) ) {
+      if ( transmission_mode_ != TMode::Table ) continue;
+      auto* kd = dynamic_cast<marley::KoningDelarocheOpticalModel*>(
+        &get_optical_model(pdg) );
+      used = kd && kd->read_tables( payload_in );
+    }
+    else if ( type == static_cast<int>(TableRecord::level_density) ) {
+      if ( !tabulate_level_densities_ ) continue;
+      auto* tab = dynamic_cast<marley::TabulatedLevelDensityModel*>(
+        &get_level_density_model(pdg) );
+      used = tab && tab->read_tables( payload_in );
+    }
+    else if ( type == static_cast<int>(
+      TableRecord::gamma_strength_function) )
+    {
+      if ( !tabulate_gamma_strength_functions_ ) continue;
+      auto* tab = dynamic_cast<marley::TabulatedGammaStrengthFunctionModel*>(
+        &get_gamma_strength_function_model(pdg) );
+      used = tab && tab->read_tables( payload_in );
+    }
+    if ( used ) ++num_loaded;
+  }
+
+  if ( !ok ) MARLEY_LOG_WARNING() << "The model table cache file "
+    << file_name << " is truncated. Only some of its tables were loaded.";
+
+  MARLEY_LOG_INFO() << "Loaded " << num_loaded << " model table"
+    << ( num_loaded == 1 ? "" : "s" ) << " from " << file_name;
+  return true;
+}
+
+std::map<int, double> marley::StructureDatabase::find_accessible_nuclides(
+  const std::map<int, double>& max_Ex)
+{
+  std::map<int, double> nuclide_Ex;
+  std::map<int, std::map<int, double> > fragment_KE;
+  find_accessible_nuclides( max_Ex, nuclide_Ex, fragment_KE );
+  return nuclide_Ex;
+}
+
+void marley::StructureDatabase::find_accessible_nuclides(
+  const std::map<int, double>& max_Ex, std::map<int, double>& nuclide_Ex,
+  std::map<int, std::map<int, double> >& fragment_KE)
+{
+  // Each emission step lowers the mass number, so this terminates
+  const auto& mt = marley::MassTable::Instance();
+  nuclide_Ex.clear();
+  fragment_KE.clear();
+  std::vector<std::pair<int, double> > pending( max_Ex.cbegin(),
+    max_Ex.cend() );
+  while ( !pending.empty() ) {
+    int pdgi = pending.back().first;
+    double Exi = pending.back().second;
+    pending.pop_back();
+
+    auto iter = nuclide_Ex.find( pdgi );
+    if ( iter != nuclide_Ex.end() && iter->second >= Exi ) continue;
+    nuclide_Ex[ pdgi ] = Exi;
+
+    int Zi = marley_utils::get_particle_Z( pdgi );
+    int Ai = marley_utils::get_particle_A( pdgi );
+    for ( const auto& pair : fragments() ) {
+      const marley::Fragment& f = pair.second;
+      int Zf = Zi - f.get_Z();
+      int Af = Ai - f.get_A();
+      if ( Zf < 1 || Af <= Zf ) continue;
+
+      double Exf_max = Exi - mt.get_fragment_separation_energy( Zi, Ai,
+        f.get_pid() );
+      if ( Exf_max <= 0. ) continue;
+
+      int pdgf = marley_utils::get_nucleus_pid( Zf, Af );
+      double& KE_max = fragment_KE[ pdgf ][ f.get_pid() ];
+      KE_max = std::max( KE_max, Exf_max );
+      pending.emplace_back( pdgf, Exf_max );
+    }
+  }
+}
+
+void marley::StructureDatabase::precompute_model_tables(
+  const std::map<int, double>& max_Ex, unsigned num_threads)
+{
+  using TMode = marley::OpticalModel::TransmissionMode;
+  bool do_optical = ( transmission_mode_ == TMode::Table );
+  bool do_level_density = tabulate_level_densities_;
+  if ( !do_optical && !do_level_density ) {
+    MARLEY_LOG_INFO() << "No nuclear models are tabulated, so there are no"
+      << " model tables to precompute";
+    return;
+  }
+
+  marley::StartupProfile::Timer timer( "model table precomputation" );
+
+  // The optical model tables belong to the nuclide left behind after each
+  // emission, and they are needed up to the largest CM frame kinetic energy
+  // available to each fragment
+  std::map<int, double> level_density_Ex;
+  std::map<int, std::map<int, double> > optical_KE;
+  find_accessible_nuclides( max_Ex, level_density_Ex, optical_KE );
+
+  // Each job fills the tables for one model. It starts from any tables that
+  // are already available so that they are not computed again.
+  struct Job {
+    int pdg;
+    bool optical;
+    std::string tables;
+  };
+  std::vector<Job> jobs;
+  const auto& ws = state();
+  if ( do_optical ) for ( const auto& pair : optical_KE ) {
+    Job job{ pair.first, true, std::string() };
+    auto seed = optical_model_seeds_.find( job.pdg );
+    auto iter = ws.optical_models.find( job.pdg );
+    if ( seed != optical_model_seeds_.end() ) job.tables = seed->second;
+    else if ( iter != ws.optical_models.end() ) {
+      const auto* kd = dynamic_cast<
+        const marley::KoningDelarocheOpticalModel*>( iter->second.get() );
+      std::ostringstream out;
+      if ( kd ) kd->write_tables( out );
+      job.tables = out.str();
+    }
+    jobs.push_back( std::move(job) );
+  }
+  if ( do_level_density ) for ( const auto& pair : level_density_Ex ) {
+    Job job{ pair.first, false, std::string() };
+    auto seed = level_density_seeds_.find( job.pdg );
+    auto iter = ws.level_density_models.find( job.pdg );
+    if ( seed != level_density_seeds_.end() ) job.tables = seed->second;
+    else if ( iter != ws.level_density_models.end() ) {
+      const auto* tab = dynamic_cast<
+        const marley::TabulatedLevelDensityModel*>( iter->second.get() );
+      std::ostringstream out;
+      if ( tab ) tab->write_tables( out );
+      job.tables = out.str();
+    }
+    jobs.push_back( std::move(job) );
+  }
+
+  auto run_job = [&]( Job& job ) {
+    int Z = marley_utils::get_particle_Z( job.pdg );
+    int A = marley_utils::get_particle_A( job.pdg );
+    std::istringstream in( job.tables );
+    std::ostringstream out;
+    if ( job.optical ) {
+      auto kd = create_optical_model( Z, A );
+      if ( !job.tables.empty() ) kd->read_tables( in );
+      for ( const auto& pair : optical_KE.at(job.pdg) ) {
+        const auto* f = get_fragment( pair.first );
+        kd->tabulate( pair.first, f->get_two_s(), fragment_l_max_,
+          pair.second );
+      }
+      kd->write_tables( out );
+    }
+    else {
+      marley::TabulatedLevelDensityModel tab(
+        std::make_unique<marley::BackshiftedFermiGasModel>(Z, A),
+        numerical_settings_.level_density_table_step );
+      if ( !job.tables.empty() ) tab.read_tables( in );
+      tab.tabulate( level_density_Ex.at(job.pdg) );
+      tab.write_tables( out );
+    }
+    job.tables = out.str();
+  };
+
+  // Hand out the jobs to the threads one at a time. Any error is rethrown
+  // once all of them have finished.
+  if ( num_threads == 0u ) num_threads = std::thread::hardware_concurrency();
+  num_threads = std::max( 1u, std::min( num_threads,
+    static_cast<unsigned>(jobs.size()) ) );
+
+  std::atomic<size_t> next_job( 0u );
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto work = [&]() {
+    try {
+      for ( size_t j = next_job++; j < jobs.size(); j = next_job++ ) {
+        run_job( jobs[j] );
+      }
+    }
+    catch ( ... ) {
+      std::lock_guard<std::mutex> lock( error_mutex );
+      if ( !error ) error = std::current_exception();
+      next_job = jobs.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for ( unsigned t = 1u; t < num_threads; ++t ) threads.emplace_back( work );
+  work();
+  for ( auto& t : threads ) t.join();
+  if ( error ) std::rethrow_exception( error );
+
+  // Keep the results for models created later, and also load them into the
+  // existing ones
+  for ( auto& job : jobs ) {
+    int pdg = job.pdg;
+    bool optical = job.optical;
+    const std::string& tables = job.tables;
+    for_each_state( [pdg, optical, &tables]( WorkerState& worker ) {
+      std::istringstream in( tables );
+      if ( optical ) {
+        auto iter = worker.optical_models.find( pdg );
+        if ( iter == worker.optical_models.end() ) return;
+        auto* kd = dynamic_cast<marley::KoningDelarocheOpticalModel*>(
+          iter->second.get() );
+        if ( kd ) kd->read_tables( in );
+      }
+      else {
+        auto iter = worker.level_density_models.find( pdg );
+        if ( iter == worker.level_density_models.end() ) return;
+        auto* tab = dynamic_cast<marley::TabulatedLevelDensityModel*>(
+          iter->second.get() );
+        if ( tab ) tab->read_tables( in );
+      }
+    } );
+    if ( optical ) optical_model_seeds_[ pdg ] = std::move( job.tables );
+    else level_density_seeds_[ pdg ] = std::move( job.tables );
+  }
+
+  MARLEY_LOG_INFO() << "Precomputed model tables for "
+    << level_density_Ex.size() << " nuclide"
+    << ( level_density_Ex.size() == 1 ? "" : "s" ) << " using "
+    << num_threads << " thread" << ( num_threads == 1u ? "" : "s" );
+}
+
+void marley::StructureDatabase::copy_model_tables(
+  const StructureDatabase& other)
+{
+  if ( &other == this ) return;
+  optical_model_seeds_ = other.optical_model_seeds_;
+  level_density_seeds_ = other.level_density_seeds_;
 }
 
 const marley::Fragment* marley::StructureDatabase::get_fragment(
@@ -294,7 +1726,7 @@ const marley::Fragment* marley::StructureDatabase::get_fragment(
 {
   // Before retrieving the fragment, make sure we've loaded the
   // necessary data tables
-  if ( !initialized_gs_spin_parity_table_ ) initialize_jpi_table();
+  std::call_once( jpi_table_once_, initialize_jpi_table );
   auto iter = fragment_table_.find( fragment_pdg );
   if ( iter == fragment_table_.end() ) return nullptr;
   else return &iter->second;
@@ -317,7 +1749,7 @@ void marley::StructureDatabase::get_gs_spin_parity(
 void marley::StructureDatabase::get_gs_spin_parity(int nuc_pdg,
   int& twoJ, marley::Parity& Pi)
 {
-  if ( !initialized_gs_spin_parity_table_ ) initialize_jpi_table();
+  std::call_once( jpi_table_once_, initialize_jpi_table );
   auto iter = jpi_table_.find( nuc_pdg );
   if ( iter == jpi_table_.end() ) throw marley::Error( "Unrecognized"
     " nuclear PDG code " + std::to_string(nuc_pdg) + " passed to"
@@ -327,8 +1759,109 @@ void marley::StructureDatabase::get_gs_spin_parity(int nuc_pdg,
   Pi = pair.second;
 }
 
+int marley::StructureDatabase::compile_gs_spin_parity_table(
+  const std::string& text_file_name, const std::string& binary_file_name)
+{
+  uint64_t hash;
+  std::ifstream text_in( text_file_name );
+  if ( !text_in.good() || !marley_utils::hash_file(text_file_name, hash) ) {
+    throw marley::Error( "Could not read from the data file "
+      + text_file_name );
+  }
+
+  JPiTable table;
+  read_jpi_text( text_in, table );
+
+  // Store the table as parallel arrays sorted by PDG code
+  std::vector<int> pdgs, twoJs, parities;
+  for ( const auto& pair : table ) {
+    pdgs.push_back( pair.first );
+    twoJs.push_back( pair.second.first );
+    parities.push_back( static_cast<bool>(pair.second.second) ? 1 : -1 );
+  }
+
+  std::ofstream out( binary_file_name, std::ios::binary );
+  if ( !out ) throw marley::Error( "Could not open the file "
+    + binary_file_name + " for writing" );
+
+  out.write( JPI_TABLE_MAGIC.data(), JPI_TABLE_MAGIC.size() );
+  marley_utils::write_binary( out, JPI_TABLE_FORMAT_VERSION );
+  marley_utils::write_binary( out, hash );
+  marley_utils::write_binary( out, pdgs );
+  marley_utils::write_binary( out, twoJs );
+  marley_utils::write_binary( out, parities );
+
+  out.close();
+  if ( !out ) throw marley::Error( "Failed to write the compiled"
+    " spin-parity table file " + binary_file_name );
+
+  return static_cast<int>( pdgs.size() );
+}
+
+bool marley::StructureDatabase::read_compiled_jpi_table(
+  const std::string& binary_file_name, const std::string& text_file_name)
+{
+  // Check quietly whether a compiled table exists before trying to map it
+  // (marley::Error logs its message)
+  if ( !std::ifstream(binary_file_name).good() ) return false;
+
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( binary_file_name ); }
+  catch ( const marley::Error& ) { return false; }
+
+  marley::MemoryStreamBuf buffer( file->data(), file->size() );
+  std::istream in( &buffer );
+
+  std::string magic( JPI_TABLE_MAGIC.size(), '\0' );
+  in.read( &magic[0], magic.size() );
+
+  uint32_t format_version;
+  uint64_t stored_hash, hash;
+  if ( !in || magic != JPI_TABLE_MAGIC
+    || !marley_utils::read_binary(in, format_version)
+    || format_version != JPI_TABLE_FORMAT_VERSION
+    || !marley_utils::read_binary(in, stored_hash) )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring invalid compiled spin-parity table"
+      << " file " << binary_file_name;
+    return false;
+  }
+
+  if ( !marley_utils::hash_file(text_file_name, hash)
+    || hash != stored_hash )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring the compiled spin-parity table file "
+      << binary_file_name << ", which is out of date with respect to "
+      << text_file_name;
+    return false;
+  }
+
+  std::vector<int> pdgs, twoJs, parities;
+  if ( !marley_utils::read_binary(in, pdgs)
+    || !marley_utils::read_binary(in, twoJs)
+    || !marley_utils::read_binary(in, parities)
+    || twoJs.size() != pdgs.size() || parities.size() != pdgs.size() )
+  {
+    MARLEY_LOG_WARNING() << "Ignoring the truncated compiled spin-parity"
+      << " table file " << binary_file_name;
+    return false;
+  }
+
+  // The entries were written in order, so each one can be appended to the
+  // end of the map without searching
+  jpi_table_.clear();
+  for ( size_t i = 0u; i < pdgs.size(); ++i ) {
+    jpi_table_.emplace_hint( jpi_table_.end(), pdgs[i],
+      std::make_pair(twoJs[i], marley::Parity(parities[i])) );
+  }
+
+  return true;
+}
+
 void marley::StructureDatabase::initialize_jpi_table() {
 
+  marley::StartupProfile::Timer timer( "ground-state spin-parity table" );
+
   // Instantiate the file manager and use it to find
   // the data file containing the ground-state spin-parities
   // for many nuclei
@@ -344,22 +1877,22 @@ void marley::StructureDatabase::initialize_jpi_table() {
       " environment variable." );
   }
 
-  MARLEY_LOG_INFO() << "Loading ground-state nuclear spin-parities from "
-    << full_jpi_file_name;
+  // Use a compiled version of the data file if there is an up-to-date one
+  // next to it. Otherwise, parse the text file itself.
+  std::string compiled_file_name = full_jpi_file_name
+    + COMPILED_DECAY_SCHEME_SUFFIX;
 
-  std::ifstream table_file( full_jpi_file_name );
-  int nuc_pdg, twoJ;
-  marley::Parity Pi;
-  while ( table_file >> nuc_pdg >> twoJ >> Pi ) {
-    MARLEY_LOG_DEBUG() << "Nucleus with PDG code " << nuc_pdg
-      << " has spin-parity " << static_cast<double>( twoJ ) / 2.
-      << Pi;
-    jpi_table_[ nuc_pdg ] = std::pair<int, marley::Parity>( twoJ, Pi );
+  if ( read_compiled_jpi_table(compiled_file_name, full_jpi_file_name) ) {
+    MARLEY_LOG_INFO() << "Loaded ground-state nuclear spin-parities from "
+      << compiled_file_name;
   }
+  else {
+    MARLEY_LOG_INFO() << "Loading ground-state nuclear spin-parities from "
+      << full_jpi_file_name;
 
-  // Set the flag saying we've initialized the table of ground-state spin-parities.
-  // This will avoid duplicate attempts at initialization.
-  initialized_gs_spin_parity_table_ = true;
+    std::ifstream table_file( full_jpi_file_name );
+    read_jpi_text( table_file, jpi_table_ );
+  }
 
   // Also initialize the table of nuclear fragment properties now that we have
   // the needed information
@@ -368,13 +1901,15 @@ void marley::StructureDatabase::initialize_jpi_table() {
     { NEUTRON, PROTON,  DEUTERON, TRITON,  HELION,  ALPHA };
 
   for ( int f_pdg : FRAGMENTS_TO_CONSIDER ) {
-    // Temporary storage
-    int f_twoJ;
-    marley::Parity f_Pi;
-
     // Look up the spin-parity of the nuclear fragment (assumed to be emitted in
-    // its ground state) in the data table
-    marley::StructureDatabase::get_gs_spin_parity( f_pdg, f_twoJ, f_Pi );
+    // its ground state) in the data table. This is done directly since
+    // get_gs_spin_parity() waits for this function to finish.
+    auto iter = jpi_table_.find( f_pdg );
+    if ( iter == jpi_table_.end() ) throw marley::Error( "Unrecognized"
+      " nuclear PDG code " + std::to_string(f_pdg) + " passed to"
+      " marley::StructureDatabase::get_gs_spin_parity()" );
+    int f_twoJ = iter->second.first;
+    marley::Parity f_Pi = iter->second.second;
 
     // Create a new entry in the table of nuclear fragments that should be
     // considered during unbound nuclear de-excitations
@@ -384,8 +1919,39 @@ void marley::StructureDatabase::initialize_jpi_table() {
 
 }
 
+void marley::StructureDatabase::prefetch_structure_files() {
+
+  marley::StartupProfile::Timer timer( "structure data prefetch" );
+
+  if ( !loaded_structure_index_ ) this->load_structure_index();
+
+  const auto& fm = marley::FileManager::Instance();
+  fm.prefetch();
+
+  // Several nuclides usually share each data file
+  std::set<std::string> file_names;
+  for ( const auto& pair : decay_scheme_filenames_ ) {
+    file_names.insert( pair.second );
+  }
+
+  int num_missing = 0;
+  for ( const auto& name : file_names ) {
+    if ( fm.find_file(name).empty() ) {
+      MARLEY_LOG_WARNING() << "The structure data file " << name
+        << " listed in " << structure_index_filename_ << " could not be"
+        << " found on the MARLEY search path";
+      ++num_missing;
+    }
+  }
+
+  MARLEY_LOG_INFO() << "Found " << file_names.size() - num_missing
+    << " of " << file_names.size() << " structure data files";
+}
+
 void marley::StructureDatabase::load_structure_index() {
 
+  marley::StartupProfile::Timer timer( "structure data index" );
+
   // Instantiate the file manager and use it to find
   // the index to the decay scheme data files
   const auto& fm = marley::FileManager::Instance();
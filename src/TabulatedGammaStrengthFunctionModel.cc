@@ -0,0 +1,132 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "marley/marley_utils.hh"
+#include "marley/Error.hh"
+#include "marley/TabulatedGammaStrengthFunctionModel.hh"
+
+using TrType = marley::GammaStrengthFunctionModel::TransitionType;
+
+marley::TabulatedGammaStrengthFunctionModel::
+  TabulatedGammaStrengthFunctionModel(
+  std::unique_ptr<marley::GammaStrengthFunctionModel> model, double step)
+  : GammaStrengthFunctionModel(model ? model->Z() : 0, model ? model->A() : 0),
+  model_( std::move(model) ), step_( step )
+{
+  if ( !model_ ) throw marley::Error( "Null gamma-ray strength function"
+    " model passed to the constructor of"
+    " marley::TabulatedGammaStrengthFunctionModel" );
+
+  if ( !(step_ > 0.) ) throw marley::Error( "Invalid grid spacing "
+    + std::to_string(step_) + " MeV passed to the constructor of"
+    " marley::TabulatedGammaStrengthFunctionModel" );
+}
+
+double marley::TabulatedGammaStrengthFunctionModel::strength_function(
+  TrType type, int l, double e_gamma)
+{
+  return model_->strength_function( type, l, e_gamma );
+}
+
+size_t marley::TabulatedGammaStrengthFunctionModel::memory_usage() const {
+  size_t bytes = model_->memory_usage();
+  for ( const auto& pair : tables_ ) {
+    bytes += sizeof( pair ) + marley_utils::vector_bytes( pair.second );
+  }
+  return bytes;
+}
+
+double marley::TabulatedGammaStrengthFunctionModel::transmission_coefficient(
+  TrType type, int l, double e_gamma)
+{
+  // Let the wrapped model handle invalid input and the lowest energies.
+  // There the transmission coefficients fall off like a high power of the
+  // gamma-ray energy, which a cubic describes poorly.
+  double x = e_gamma / step_;
+  if ( type == TrType::unphysical || l < 1 || !(x >= NUM_EXACT_INTERVALS) ) {
+    return model_->transmission_coefficient( type, l, e_gamma );
+  }
+
+  size_t k = static_cast<size_t>( x );
+  double t = x - k;
+
+  // Add any missing grid points up to and including k + 2
+  auto& table = tables_[ std::make_pair(type, l) ];
+  while ( table.size() <= k + 2u ) {
+    table.push_back( model_->transmission_coefficient(type, l,
+      table.size() * step_) );
+  }
+
+  // Four-point Lagrange interpolation using grid points k - 1 through k + 2
+  double tp1 = t + 1.;
+  double tm1 = t - 1.;
+  double tm2 = t - 2.;
+  double T = -t*tm1*tm2/6. * table[k - 1u] + tp1*tm1*tm2/2. * table[k]
+    - tp1*t*tm2/2. * table[k + 1u] + tp1*t*tm1/6. * table[k + 2u];
+
+  return std::max( 0., T );
+}
+
+void marley::TabulatedGammaStrengthFunctionModel::write_tables(
+  std::ostream& out) const
+{
+  marley_utils::write_binary( out, step_ );
+  marley_utils::write_binary( out, static_cast<uint64_t>(tables_.size()) );
+  for ( const auto& pair : tables_ ) {
+    marley_utils::write_binary( out, static_cast<int>(pair.first.first) );
+    marley_utils::write_binary( out, pair.first.second );
+    marley_utils::write_binary( out, pair.second );
+  }
+}
+
+bool marley::TabulatedGammaStrengthFunctionModel::read_tables(
+  std::istream& in)
+{
+  double step;
+  uint64_t num_tables;
+  if ( !marley_utils::read_binary(in, step)
+    || !marley_utils::read_binary(in, num_tables) ) return false;
+
+  if ( step != step_ ) return false;
+
+  // Read everything before changing the current tables so that a truncated
+  // stream leaves them untouched
+  std::map< std::pair<TrType, int>, std::vector<double> > tables;
+  for ( uint64_t t = 0u; t < num_tables; ++t ) {
+    int type, l;
+    std::vector<double> table;
+    if ( !marley_utils::read_binary(in, type)
+      || !marley_utils::read_binary(in, l)
+      || !marley_utils::read_binary(in, table) ) return false;
+    if ( type != static_cast<int>(TrType::electric)
+      && type != static_cast<int>(TrType::magnetic) ) return false;
+    tables[ std::make_pair(static_cast<TrType>(type), l) ]
+      = std::move( table );
+  }
+
+  // All tables start at zero energy, so keep the longer of each pair
+  for ( auto& pair : tables ) {
+    auto& table = tables_[ pair.first ];
+    if ( pair.second.size() > table.size() ) {
+      table = std::move( pair.second );
+    }
+  }
+  return true;
+}
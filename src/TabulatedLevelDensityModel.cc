@@ -0,0 +1,154 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <cmath>
+#include <string>
+#include <utility>
+
+#include "marley/marley_utils.hh"
+#include "marley/Error.hh"
+#include "marley/TabulatedLevelDensityModel.hh"
+
+marley::TabulatedLevelDensityModel::TabulatedLevelDensityModel(
+  std::unique_ptr<marley::LevelDensityModel> model, double step)
+  : model_( std::move(model) ), step_( step )
+{
+  if ( !model_ ) throw marley::Error( "Null level density model passed to"
+    " the constructor of marley::TabulatedLevelDensityModel" );
+
+  if ( !(step_ > 0.) ) throw marley::Error( "Invalid grid spacing "
+    + std::to_string(step_) + " MeV passed to the constructor of"
+    " marley::TabulatedLevelDensityModel" );
+}
+
+void marley::TabulatedLevelDensityModel::interpolate(double Ex, double& rho,
+  double& sigma2)
+{
+  // The tables start at Ex = 0. Use the wrapped model directly for
+  // (unphysical) negative excitation energies.
+  if ( !(Ex >= 0.) ) {
+    rho = model_->level_density( Ex );
+    sigma2 = model_->spin_cutoff_squared( Ex );
+    return;
+  }
+
+  double x = Ex / step_;
+  size_t k = static_cast<size_t>( x );
+  double t = x - k;
+
+  extend( k + 1u );
+
+  double log_rho = (1. - t)*log_rhos_[k] + t*log_rhos_[k + 1u];
+  sigma2 = (1. - t)*sigma2s_[k] + t*sigma2s_[k + 1u];
+
+  // If the wrapped model vanishes at either grid point, then the logarithm
+  // is not usable, so just ask the wrapped model
+  if ( !std::isfinite(log_rho) ) {
+    rho = model_->level_density( Ex );
+    sigma2 = model_->spin_cutoff_squared( Ex );
+    return;
+  }
+
+  rho = std::exp( log_rho );
+}
+
+void marley::TabulatedLevelDensityModel::extend(size_t k) {
+  while ( log_rhos_.size() <= k ) {
+    double E = log_rhos_.size() * step_;
+    log_rhos_.push_back( std::log(model_->level_density(E)) );
+    sigma2s_.push_back( model_->spin_cutoff_squared(E) );
+  }
+}
+
+void marley::TabulatedLevelDensityModel::tabulate(double Ex_max) {
+  if ( !(Ex_max >= 0.) ) return;
+  extend( static_cast<size_t>(Ex_max / step_) + 1u );
+}
+
+double marley::TabulatedLevelDensityModel::level_density(double Ex) {
+  double rho, sigma2;
+  interpolate( Ex, rho, sigma2 );
+  return rho;
+}
+
+double marley::TabulatedLevelDensityModel::spin_cutoff_squared(double Ex) {
+  double rho, sigma2;
+  interpolate( Ex, rho, sigma2 );
+  return sigma2;
+}
+
+size_t marley::TabulatedLevelDensityModel::memory_usage() const {
+  return marley_utils::vector_bytes( log_rhos_ )
+    + marley_utils::vector_bytes( sigma2s_ ) + model_->memory_usage();
+}
+
+double marley::TabulatedLevelDensityModel::level_density(double Ex,
+  int two_J)
+{
+  double rho, sigma2;
+  interpolate( Ex, rho, sigma2 );
+  double two_sigma2 = 2. * sigma2;
+  return ((two_J + 1) / two_sigma2) * std::exp(-0.25 * std::pow(two_J + 1, 2)
+    / two_sigma2) * rho;
+}
+
+// rho(Ex, J, Pi) assuming equipartition of parity (the parameter Pi is unused)
+double marley::TabulatedLevelDensityModel::level_density(double Ex,
+  int two_J, marley::Parity /*Pi*/)
+{
+  return 0.5 * level_density(Ex, two_J);
+}
+
+void marley::TabulatedLevelDensityModel::level_density_all_spins(double Ex,
+  marley::Parity /*Pi*/, int two_J_min, int two_J_max,
+  marley::ScratchVector<double>& rhos)
+{
+  rhos.clear();
+  if ( two_J_max < two_J_min ) return;
+
+  double rho, sigma2;
+  interpolate( Ex, rho, sigma2 );
+  double two_sigma2 = 2. * sigma2;
+  for ( int two_J = two_J_min; two_J <= two_J_max; two_J += 2 ) {
+    rhos.push_back( 0.5 * ( ((two_J + 1) / two_sigma2)
+      * std::exp(-0.25 * std::pow(two_J + 1, 2) / two_sigma2) * rho ) );
+  }
+}
+
+void marley::TabulatedLevelDensityModel::write_tables(std::ostream& out)
+  const
+{
+  marley_utils::write_binary( out, step_ );
+  marley_utils::write_binary( out, log_rhos_ );
+  marley_utils::write_binary( out, sigma2s_ );
+}
+
+bool marley::TabulatedLevelDensityModel::read_tables(std::istream& in) {
+  double step;
+  std::vector<double> log_rhos, sigma2s;
+  if ( !marley_utils::read_binary(in, step)
+    || !marley_utils::read_binary(in, log_rhos)
+    || !marley_utils::read_binary(in, sigma2s) ) return false;
+
+  if ( step != step_ || log_rhos.size() != sigma2s.size() ) return false;
+
+  // Both sets of tables start at Ex = 0, so keep the longer one
+  if ( log_rhos.size() > log_rhos_.size() ) {
+    log_rhos_ = std::move( log_rhos );
+    sigma2s_ = std::move( sigma2s );
+  }
+  return true;
+}
@@ -0,0 +1,127 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <exception>
+
+// MARLEY includes
+#include "marley/TaskPool.hh"
+
+marley::TaskPool& marley::TaskPool::Instance() {
+  static marley::TaskPool the_instance;
+  return the_instance;
+}
+
+marley::TaskPool::~TaskPool() {
+  stop_threads();
+}
+
+void marley::TaskPool::set_num_threads( size_t num_threads ) {
+  stop_threads();
+  std::lock_guard<std::mutex> lock( mutex_ );
+  stop_ = false;
+  for ( size_t t = 0u; t < num_threads; ++t ) {
+    threads_.emplace_back( &marley::TaskPool::help, this );
+  }
+}
+
+size_t marley::TaskPool::num_threads() const {
+  std::lock_guard<std::mutex> lock( mutex_ );
+  return threads_.size();
+}
+
+void marley::TaskPool::stop_threads() {
+  std::vector<std::thread> old_threads;
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    stop_ = true;
+    old_threads.swap( threads_ );
+  }
+  work_cv_.notify_all();
+  for ( auto& thread : old_threads ) thread.join();
+}
+
+void marley::TaskPool::run_task( Batch& batch, size_t index,
+  std::unique_lock<std::mutex>& lock )
+{
+  lock.unlock();
+  std::exception_ptr error;
+  try {
+    ( *batch.tasks )[ index ]();
+  }
+  catch ( ... ) {
+    error = std::current_exception();
+  }
+  lock.lock();
+
+  if ( error && !batch.error ) batch.error = error;
+  if ( ++batch.num_done == batch.tasks->size() ) batch.done_cv.notify_all();
+}
+
+void marley::TaskPool::run( std::vector< std::function<void()> >& tasks ) {
+
+  if ( tasks.empty() ) return;
+
+  auto batch = std::make_shared<Batch>();
+  batch->tasks = &tasks;
+
+  std::unique_lock<std::mutex> lock( mutex_ );
+
+  // A single task, or a pool without helpers, gains nothing from queueing
+  bool queued = ( tasks.size() > 1u && !threads_.empty() );
+  if ( queued ) {
+    queue_.push_back( batch );
+    work_cv_.notify_all();
+  }
+
+  // Work through the batch on the calling thread as well
+  while ( batch->next < tasks.size() ) {
+    size_t index = batch->next++;
+    run_task( *batch, index, lock );
+  }
+
+  if ( queued ) {
+    auto iter = std::find( queue_.begin(), queue_.end(), batch );
+    if ( iter != queue_.end() ) queue_.erase( iter );
+  }
+
+  batch->done_cv.wait( lock, [&batch]() -> bool
+    { return batch->num_done == batch->tasks->size(); } );
+
+  if ( batch->error ) std::rethrow_exception( batch->error );
+}
+
+void marley::TaskPool::help() {
+  std::unique_lock<std::mutex> lock( mutex_ );
+  while ( true ) {
+    work_cv_.wait( lock, [this]() -> bool
+      { return stop_ || !queue_.empty(); } );
+    if ( queue_.empty() ) return;
+
+    // Keep a reference to the batch in case its owner removes it from the
+    // queue while the task is running. The owner may already have claimed
+    // the last task.
+    auto batch = queue_.front();
+    if ( batch->next >= batch->tasks->size() ) {
+      queue_.pop_front();
+      continue;
+    }
+    size_t index = batch->next++;
+    if ( batch->next >= batch->tasks->size() ) queue_.pop_front();
+    run_task( *batch, index, lock );
+  }
+}
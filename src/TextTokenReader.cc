@@ -0,0 +1,276 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+
+#include <cerrno>
+#include <cfloat>
+#include <clocale>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "marley/Parity.hh"
+#include "marley/TextTokenReader.hh"
+
+namespace {
+
+  using traits = std::char_traits<char>;
+
+  // Matches the default whitespace classification of the "C" locale
+  inline bool is_space(int c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v'
+      || c == '\f';
+  }
+
+  inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+  bool parse_int(const char* s, const char* end, int& value) {
+    bool negative = false;
+    if ( *s == '+' || *s == '-' ) {
+      negative = ( *s == '-' );
+      ++s;
+    }
+    if ( s == end ) return false;
+
+    // Accumulate the magnitude as a negative number so that the most
+    // negative int can be represented
+    int result = 0;
+    constexpr int min_int = std::numeric_limits<int>::min();
+    for ( ; s != end; ++s ) {
+      if ( !is_digit(*s) ) return false;
+      int digit = *s - '0';
+      if ( result < (min_int + digit) / 10 ) return false;
+      result = 10*result - digit;
+    }
+
+    if ( !negative ) {
+      if ( result == min_int ) return false;
+      result = -result;
+    }
+    value = result;
+    return true;
+  }
+
+  // Parses a decimal floating-point number using the C library. This handles
+  // the cases that are not covered by the fast path in parse_double().
+  bool parse_double_slow(const char* s, const char* end, double& value) {
+    // The C library uses the decimal point of the current C locale, so
+    // substitute it if needed
+    std::string temp( s, end );
+    char point = *std::localeconv()->decimal_point;
+    if ( point != '.' ) {
+      for ( auto& c : temp ) if ( c == '.' ) c = point;
+    }
+
+    errno = 0;
+    char* parse_end = nullptr;
+    double result = std::strtod( temp.c_str(), &parse_end );
+    if ( parse_end != temp.c_str() + temp.size() ) return false;
+
+    // Like operator>>, reject values that overflow
+    if ( errno == ERANGE && std::abs(result) > 1. ) return false;
+
+    value = result;
+    return true;
+  }
+
+  // Parses a decimal floating-point number. Values with at most 19
+  // significant digits that can be computed exactly using a single
+  // floating-point multiplication or division of exactly representable
+  // operands are handled directly (see W. D. Clinger, "How to Read Floating
+  // Point Numbers Accurately", Proc. ACM SIGPLAN '90, pp. 92-101), and
+  // correct rounding is guaranteed for these. Everything else is delegated
+  // to the C library.
+  bool parse_double(const char* s, const char* end, double& value) {
+
+    const char* p = s;
+    bool negative = false;
+    if ( *p == '+' || *p == '-' ) {
+      negative = ( *p == '-' );
+      ++p;
+    }
+
+    // Significant digits and the decimal exponent that applies to them
+    uint64_t mantissa = 0u;
+    int num_digits = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool any_digits = false;
+
+    auto add_digit = [&](char c, bool fractional) -> void {
+      any_digits = true;
+      if ( num_digits < 19 ) {
+        mantissa = 10u*mantissa + static_cast<uint64_t>( c - '0' );
+        if ( mantissa != 0u ) ++num_digits;
+        if ( fractional ) --exponent;
+      }
+      else {
+        if ( c != '0' ) truncated = true;
+        if ( !fractional ) ++exponent;
+      }
+    };
+
+    for ( ; p != end && is_digit(*p); ++p ) add_digit( *p, false );
+    if ( p != end && *p == '.' ) {
+      for ( ++p; p != end && is_digit(*p); ++p ) add_digit( *p, true );
+    }
+    if ( !any_digits ) return false;
+
+    if ( p != end && (*p == 'e' || *p == 'E') ) {
+      ++p;
+      bool negative_exp = false;
+      if ( p != end && (*p == '+' || *p == '-') ) {
+        negative_exp = ( *p == '-' );
+        ++p;
+      }
+      if ( p == end ) return false;
+
+      // Huge exponents will be handled (and probably rejected) by the slow
+      // path, so don't bother to keep track of all of their digits
+      int exp_value = 0;
+      for ( ; p != end && is_digit(*p); ++p ) {
+        if ( exp_value < 100000 ) exp_value = 10*exp_value + ( *p - '0' );
+      }
+      exponent += negative_exp ? -exp_value : exp_value;
+    }
+    if ( p != end ) return false;
+
+    // The fast path relies on IEEE 754 double-precision arithmetic without
+    // any extra intermediate precision
+    #if FLT_EVAL_METHOD == 0
+    if ( !truncated && std::numeric_limits<double>::is_iec559 ) {
+
+      if ( mantissa == 0u ) {
+        value = negative ? -0. : 0.;
+        return true;
+      }
+
+      // Trailing zeros don't need to be part of the mantissa
+      while ( mantissa % 10u == 0u ) {
+        mantissa /= 10u;
+        ++exponent;
+      }
+
+      // Powers of ten that are exactly representable as doubles
+      static constexpr double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4,
+        1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+        1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+      constexpr int max_exact_power = 22;
+      constexpr uint64_t max_exact_mantissa = uint64_t(1) << 53;
+
+      if ( mantissa <= max_exact_mantissa && exponent >= -max_exact_power
+        && exponent <= max_exact_power )
+      {
+        double result = static_cast<double>( mantissa );
+        if ( exponent >= 0 ) result *= powers_of_ten[ exponent ];
+        else result /= powers_of_ten[ -exponent ];
+        value = negative ? -result : result;
+        return true;
+      }
+    }
+    #endif
+
+    return parse_double_slow( s, end, value );
+  }
+
+}
+
+constexpr size_t marley::TextTokenReader::MAX_TOKEN_LENGTH;
+
+marley::TextTokenReader::TextTokenReader(std::istream& in) : in_( in )
+{
+}
+
+bool marley::TextTokenReader::next_token() {
+  length_ = 0u;
+
+  // Like the formatted input operators, do nothing unless the stream is in
+  // a good state
+  if ( !in_.good() ) {
+    in_.setstate( std::ios::failbit );
+    return false;
+  }
+
+  std::streambuf* buf = in_.rdbuf();
+  bool too_long = false;
+
+  // Skip leading whitespace, then collect characters until the next
+  // whitespace character or the end of the input
+  int c = buf->sgetc();
+  while ( c != traits::eof() && is_space(c) ) c = buf->snextc();
+  while ( c != traits::eof() && !is_space(c) ) {
+    if ( length_ < MAX_TOKEN_LENGTH ) {
+      token_[ length_++ ] = traits::to_char_type( c );
+    }
+    else too_long = true;
+    c = buf->snextc();
+  }
+  token_[ length_ ] = '\0';
+
+  if ( c == traits::eof() ) in_.setstate( std::ios::eofbit );
+  if ( length_ == 0u || too_long ) {
+    in_.setstate( std::ios::failbit );
+    return false;
+  }
+  return true;
+}
+
+marley::TextTokenReader& marley::TextTokenReader::operator>>(int& value) {
+  if ( next_token() && !parse_int(token_, token_ + length_, value) ) {
+    in_.setstate( std::ios::failbit );
+  }
+  return *this;
+}
+
+marley::TextTokenReader& marley::TextTokenReader::operator>>(double& value)
+{
+  if ( next_token() && !parse_double(token_, token_ + length_, value) ) {
+    in_.setstate( std::ios::failbit );
+  }
+  return *this;
+}
+
+marley::TextTokenReader& marley::TextTokenReader::operator>>(
+  marley::Parity& parity)
+{
+  if ( next_token() ) {
+    if ( length_ == 1u ) parity.from_char( token_[0] );
+    else in_.setstate( std::ios::failbit );
+  }
+  return *this;
+}
+
+marley::TextTokenReader& marley::TextTokenReader::skip(size_t num_tokens) {
+  for ( size_t t = 0u; t < num_tokens; ++t ) {
+    if ( !next_token() ) break;
+  }
+  return *this;
+}
+
+bool marley::TextTokenReader::token_on_line() {
+  if ( !in_.good() ) return false;
+
+  std::streambuf* buf = in_.rdbuf();
+  int c = buf->sgetc();
+  while ( c == ' ' || c == '\t' ) c = buf->snextc();
+
+  if ( c == traits::eof() ) {
+    in_.setstate( std::ios::eofbit );
+    return false;
+  }
+  return !is_space( c );
+}
@@ -0,0 +1,196 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// POSIX includes
+#ifdef __linux__
+  #include <dirent.h>
+  #include <pthread.h>
+  #include <sched.h>
+#endif
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Logger.hh"
+#include "marley/ThreadAffinity.hh"
+
+namespace {
+
+#ifdef __linux__
+
+  // Parses a CPU list in the format used by sysfs (e.g., "0-3,8,10-11")
+  std::vector<int> parse_cpu_list( const std::string& list ) {
+    std::vector<int> cpus;
+    std::istringstream iss( list );
+    std::string range;
+    while ( std::getline(iss, range, ',') ) {
+      int first = 0;
+      int last = 0;
+      char dash = '\0';
+      std::istringstream range_iss( range );
+      if ( !(range_iss >> first) ) continue;
+      if ( range_iss >> dash >> last ) {
+        if ( dash != '-' || last < first ) continue;
+      }
+      else last = first;
+      for ( int c = first; c <= last; ++c ) cpus.push_back( c );
+    }
+    return cpus;
+  }
+
+  // Returns the CPUs on each NUMA node that the process may run on. Nodes
+  // without any such CPUs are left out.
+  std::vector< std::vector<int> > find_node_cpus() {
+
+    cpu_set_t allowed;
+    CPU_ZERO( &allowed );
+    if ( sched_getaffinity(0, sizeof(allowed), &allowed) != 0 ) return {};
+
+    std::vector<int> node_ids;
+    const std::string node_dir = "/sys/devices/system/node";
+    if ( DIR* dir = opendir(node_dir.c_str()) ) {
+      while ( const dirent* entry = readdir(dir) ) {
+        std::string name( entry->d_name );
+        if ( name.size() < 5u || name.compare(0, 4, "node") != 0
+          || name.find_first_not_of("0123456789", 4) != std::string::npos )
+        {
+          continue;
+        }
+        node_ids.push_back( std::stoi(name.substr(4)) );
+      }
+      closedir( dir );
+    }
+    std::sort( node_ids.begin(), node_ids.end() );
+
+    std::vector< std::vector<int> > result;
+    std::vector<bool> seen( CPU_SETSIZE, false );
+    for ( int id : node_ids ) {
+      std::ifstream in( node_dir + "/node" + std::to_string(id)
+        + "/cpulist" );
+      std::string list;
+      if ( !std::getline(in, list) ) continue;
+
+      std::vector<int> cpus;
+      for ( int c : parse_cpu_list(list) ) {
+        if ( c < CPU_SETSIZE && CPU_ISSET(c, &allowed) && !seen[ c ] ) {
+          cpus.push_back( c );
+          seen[ c ] = true;
+        }
+      }
+      if ( !cpus.empty() ) result.push_back( cpus );
+    }
+
+    // Without any topology information, treat all of the allowed CPUs as a
+    // single node
+    if ( result.empty() ) {
+      std::vector<int> cpus;
+      for ( int c = 0; c < CPU_SETSIZE; ++c ) {
+        if ( CPU_ISSET(c, &allowed) ) cpus.push_back( c );
+      }
+      if ( !cpus.empty() ) result.push_back( cpus );
+    }
+
+    return result;
+  }
+
+#endif
+
+}
+
+marley::ThreadAffinity::ThreadAffinity( Policy policy ) : policy_( policy )
+{
+  if ( policy_ == Policy::None ) return;
+
+#ifdef __linux__
+  node_cpus_ = find_node_cpus();
+#endif
+
+  if ( node_cpus_.empty() ) {
+    MARLEY_LOG_WARNING() << "Could not determine the CPUs available to this"
+      << " process. Threads will not be pinned.";
+    policy_ = Policy::None;
+    return;
+  }
+
+  if ( policy_ == Policy::Compact ) {
+    for ( size_t n = 0u; n < node_cpus_.size(); ++n ) {
+      for ( int c : node_cpus_[ n ] ) slots_.emplace_back( n, c );
+    }
+  }
+  else {
+    // Take one CPU from each node in turn until all of them are used
+    size_t max_cpus = 0u;
+    for ( const auto& cpus : node_cpus_ ) {
+      max_cpus = std::max( max_cpus, cpus.size() );
+    }
+    for ( size_t k = 0u; k < max_cpus; ++k ) {
+      for ( size_t n = 0u; n < node_cpus_.size(); ++n ) {
+        if ( k < node_cpus_[ n ].size() ) {
+          slots_.emplace_back( n, node_cpus_[ n ][ k ] );
+        }
+      }
+    }
+  }
+
+  MARLEY_LOG_INFO() << "Pinning threads to " << slots_.size() << " CPUs on "
+    << node_cpus_.size() << " NUMA node" << ( node_cpus_.size() > 1u
+    ? "s" : "" );
+}
+
+size_t marley::ThreadAffinity::node_for_thread( size_t thread ) const {
+  if ( slots_.empty() ) return 0u;
+  return slots_[ thread % slots_.size() ].first;
+}
+
+void marley::ThreadAffinity::pin_current_thread( size_t thread ) const {
+  if ( slots_.empty() ) return;
+  set_affinity( { slots_[ thread % slots_.size() ].second } );
+}
+
+void marley::ThreadAffinity::pin_current_thread_to_node( size_t node ) const
+{
+  if ( slots_.empty() ) return;
+  set_affinity( node_cpus_.at(node) );
+}
+
+void marley::ThreadAffinity::set_affinity( const std::vector<int>& cpus ) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  for ( int c : cpus ) CPU_SET( c, &set );
+  int status = pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+  if ( status != 0 ) {
+    MARLEY_LOG_WARNING() << "Could not set the CPU affinity of a thread"
+      << " (error code " << status << ')';
+  }
+#else
+  static_cast<void>( cpus );
+#endif
+}
+
+marley::ThreadAffinity::Policy marley::ThreadAffinity::policy_from_string(
+  const std::string& name )
+{
+  if ( name == "none" ) return Policy::None;
+  else if ( name == "compact" ) return Policy::Compact;
+  else if ( name == "spread" ) return Policy::Spread;
+  throw marley::Error( "Unrecognized thread affinity policy \"" + name
+    + "\". Allowed values are \"none\", \"compact\", and \"spread\"." );
+}
@@ -0,0 +1,184 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+
+// Backend includes
+#if defined(MARLEY_TRACING_ITT)
+  #include <ittnotify.h>
+#elif defined(MARLEY_TRACING_PERF)
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+// MARLEY includes
+#include "marley/Tracing.hh"
+
+namespace {
+
+  // Events that take longer than this (s) in the de-excitation step are
+  // tagged as slow
+  constexpr double DEFAULT_SLOW_EVENT_THRESHOLD = 0.01;
+
+  std::atomic<double> slow_threshold( DEFAULT_SLOW_EVENT_THRESHOLD );
+
+#if defined(MARLEY_TRACING_ITT)
+
+  __itt_domain* itt_domain() {
+    static __itt_domain* the_domain = __itt_domain_create( "MARLEY" );
+    return the_domain;
+  }
+
+  __itt_string_handle* itt_text_key() {
+    static __itt_string_handle* the_key = __itt_string_handle_create(
+      "text" );
+    return the_key;
+  }
+
+  __itt_string_handle* itt_slow_event_key() {
+    static __itt_string_handle* the_key = __itt_string_handle_create(
+      "slow event" );
+    return the_key;
+  }
+
+#elif defined(MARLEY_TRACING_PERF)
+
+  // Returns a file descriptor for the ftrace marker file, or -1 if it could
+  // not be opened (e.g., because tracefs is not mounted or writable)
+  int trace_marker_fd() {
+    static int the_fd = []() -> int {
+      for ( const char* path : { "/sys/kernel/tracing/trace_marker",
+        "/sys/kernel/debug/tracing/trace_marker" } )
+      {
+        int fd = open( path, O_WRONLY | O_CLOEXEC );
+        if ( fd >= 0 ) return fd;
+      }
+      return -1;
+    }();
+    return the_fd;
+  }
+
+  // Each marker is written by a single call so that the lines from
+  // different threads are not interleaved. The B|pid|name and E|pid forms
+  // are understood by Perfetto and the other systrace-based viewers.
+  void write_marker( const std::string& marker ) {
+    int fd = trace_marker_fd();
+    if ( fd < 0 ) return;
+    ssize_t status = write( fd, marker.data(), marker.size() );
+    static_cast<void>( status );
+  }
+
+  const std::string& pid_string() {
+    static const std::string the_pid = std::to_string( getpid() );
+    return the_pid;
+  }
+
+#endif
+
+}
+
+void marley::Tracing::set_slow_event_threshold( double seconds ) {
+  slow_threshold.store( seconds, std::memory_order_relaxed );
+}
+
+double marley::Tracing::slow_event_threshold() {
+  return slow_threshold.load( std::memory_order_relaxed );
+}
+
+void marley::Tracing::message( const std::string& text ) {
+#if defined(MARLEY_TRACING_TRACY)
+  TracyMessage( text.c_str(), text.size() );
+#elif defined(MARLEY_TRACING_ITT)
+  __itt_marker( itt_domain(), __itt_null, itt_slow_event_key(),
+    __itt_scope_thread );
+  __itt_metadata_str_add( itt_domain(), __itt_null, itt_text_key(),
+    text.c_str(), text.size() );
+#elif defined(MARLEY_TRACING_PERF)
+  write_marker( "marley: " + text );
+#else
+  static_cast<void>( text );
+#endif
+}
+
+std::string marley::Tracing::describe_state( int pdg, double Ex, int twoJ,
+  marley::Parity Pi )
+{
+  std::ostringstream oss;
+  oss << pdg << " Ex = " << Ex << " MeV ";
+  if ( twoJ % 2 ) oss << twoJ << "/2";
+  else oss << twoJ / 2;
+  oss << Pi;
+  return oss.str();
+}
+
+marley::Tracing::DecayChain::DecayChain()
+  : start_( std::chrono::steady_clock::now() ) {}
+
+marley::Tracing::DecayChain::~DecayChain() {
+  std::chrono::duration<double> elapsed
+    = std::chrono::steady_clock::now() - start_;
+  if ( states_.empty() || elapsed.count() < slow_event_threshold() ) return;
+
+  std::ostringstream oss;
+  oss << "slow event (" << elapsed.count() * 1e3 << " ms): " << states_;
+  message( oss.str() );
+}
+
+void marley::Tracing::DecayChain::add_state( int pdg, double Ex, int twoJ,
+  marley::Parity Pi )
+{
+  if ( !states_.empty() ) states_ += " -> ";
+  states_ += describe_state( pdg, Ex, twoJ, Pi );
+}
+
+#if defined(MARLEY_TRACING_ITT) || defined(MARLEY_TRACING_PERF)
+
+marley::Tracing::Site::Site( const char* name ) : name_( name ) {
+#ifdef MARLEY_TRACING_ITT
+  handle_ = __itt_string_handle_create( name );
+#endif
+}
+
+marley::Tracing::Zone::Zone( const Site& site ) : site_( site ) {
+#ifdef MARLEY_TRACING_ITT
+  __itt_task_begin( itt_domain(), __itt_null, __itt_null,
+    static_cast<__itt_string_handle*>(site_.handle()) );
+#else
+  write_marker( "B|" + pid_string() + '|' + site_.name() );
+#endif
+}
+
+marley::Tracing::Zone::~Zone() {
+#ifdef MARLEY_TRACING_ITT
+  __itt_task_end( itt_domain() );
+#else
+  write_marker( "E|" + pid_string() );
+#endif
+}
+
+void marley::Tracing::Zone::set_text( const std::string& text ) {
+#ifdef MARLEY_TRACING_ITT
+  __itt_metadata_str_add( itt_domain(), __itt_null, itt_text_key(),
+    text.c_str(), text.size() );
+#else
+  write_marker( std::string("marley: ") + site_.name() + ": " + text );
+#endif
+}
+
+#endif
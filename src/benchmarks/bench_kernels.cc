@@ -0,0 +1,255 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/BackshiftedFermiGasModel.hh"
+#include "marley/ChebyshevInterpolant.hh"
+#include "marley/ChebyshevInterpolatingFunction.hh"
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/FileManager.hh"
+#include "marley/Generator.hh"
+#include "marley/HauserFeshbachDecay.hh"
+#include "marley/Integrator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/MassTable.hh"
+#include "marley/OpticalModel.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+// Reaction data files shipped with MARLEY, together with the projectile
+// used to benchmark each one. Neutrino reactions use a monoenergetic source
+// of the matching flavor. Despite its name, ve76GeCC_Thies2012.react
+// describes a dark matter process (process type 4).
+struct BenchmarkReaction {
+  std::string file_name;
+  std::string projectile;
+};
+
+const std::vector<BenchmarkReaction> REACTION_FILES = {
+  { "CEvNS40Ar.react", "ve" }, { "ES.react", "ve" }, { "dm.react", "dm" },
+  { "dmAr.react", "dm" }, { "ve40ArCC_Bhattacharya1998.react", "ve" },
+  { "ve40ArCC_Bhattacharya2009.react", "ve" },
+  { "ve40ArCC_Liu1998.react", "ve" }, { "ve76GeCC_Thies2012.react", "dm" } };
+
+// Energy of the monoenergetic neutrino source
+constexpr double NEUTRINO_ENERGY = 30.; // MeV
+
+// PDG code for a 40K nucleus
+constexpr int PDG_40K = 1000190400;
+
+// Smooth test function and interval used for the numerical kernels
+constexpr double X_MIN = 0.; // MeV
+constexpr double X_MAX = 50.; // MeV
+
+inline double test_pdf( double x ) { return x * x * std::exp( -x / 5. ); }
+
+// Builds a Generator for a single reaction data file. Dark matter
+// reactions use the monoenergetic dark matter source, and neutrino reactions
+// use a monoenergetic source of the requested flavor.
+marley::Generator make_generator( const std::string& react_file,
+  const std::string& projectile = "dm" )
+{
+  const auto& fm = marley::FileManager::Instance();
+  std::string file_name = fm.find_file( react_file, fm.marley_dir()
+    + "/data/react/" );
+
+  marley::JSON config = marley::JSON::object();
+  config[ "seed" ] = 123456;
+  marley::JSON reactions = marley::JSON::array();
+  reactions.append( file_name );
+  config[ "reactions" ] = reactions;
+
+  marley::JSON source = marley::JSON::object();
+  if ( projectile == "dm" ) {
+    source[ "type" ] = "monoDM";
+    source[ "neutrino" ] = "dm";
+    source[ "energy" ] = 10000.;
+    source[ "mass" ] = 10.;
+    source[ "velocity" ] = 0.001;
+    source[ "LAMBDA" ] = 1e6;
+  }
+  else {
+    source[ "type" ] = "monoenergetic";
+    source[ "neutrino" ] = projectile;
+    source[ "energy" ] = NEUTRINO_ENERGY;
+  }
+  config[ "source" ] = source;
+
+  marley::JSONConfig jc( config );
+  return jc.create_generator();
+}
+
+// Generator used by the benchmarks that need a StructureDatabase
+marley::Generator& default_generator() {
+  static marley::Generator gen = make_generator( "dmAr.react" );
+  return gen;
+}
+
+} // anonymous namespace
+
+TEST_CASE( "Numerical integration", "[benchmark]" )
+{
+  marley::Integrator integrator;
+  BENCHMARK( "Integrator::num_integrate" ) {
+    return integrator.num_integrate( test_pdf, X_MIN, X_MAX );
+  };
+
+  marley::AdaptiveIntegrator adaptive;
+  BENCHMARK( "AdaptiveIntegrator::integrate" ) {
+    return adaptive.integrate( test_pdf, X_MIN, X_MAX ).value;
+  };
+}
+
+TEST_CASE( "Chebyshev interpolation", "[benchmark]" )
+{
+  BENCHMARK( "ChebyshevInterpolatingFunction construction (adaptive N)" ) {
+    return marley::ChebyshevInterpolatingFunction( test_pdf, X_MIN, X_MAX,
+      0u );
+  };
+
+  BENCHMARK( "ChebyshevInterpolatingFunction construction (N = "
+    + std::to_string(marley::DEFAULT_N_CHEBYSHEV) + ")" )
+  {
+    return marley::ChebyshevInterpolatingFunction( test_pdf, X_MIN, X_MAX,
+      marley::DEFAULT_N_CHEBYSHEV );
+  };
+
+  marley::ChebyshevInterpolatingFunction func( test_pdf, X_MIN, X_MAX,
+    marley::DEFAULT_N_CHEBYSHEV );
+
+  double x = X_MIN;
+  BENCHMARK( "ChebyshevInterpolatingFunction::evaluate" ) {
+    x += 0.37;
+    if ( x > X_MAX ) x -= X_MAX - X_MIN;
+    return func.evaluate( x );
+  };
+
+  BENCHMARK( "ChebyshevInterpolatingFunction::cdf" ) {
+    return func.cdf();
+  };
+
+  // Generator::inverse_transform_sample() draws a uniform random number
+  // and then calls inverse_cdf(), which does all of the work
+  auto cdf = func.cdf();
+  double prob = 0.;
+  BENCHMARK( "inverse transform sample (inverse_cdf)" ) {
+    prob += 0.0137;
+    if ( prob >= 1. ) prob -= 1.;
+    return cdf.inverse_cdf( prob, 1e-12 );
+  };
+
+  using FixedInterpolant = marley::ChebyshevInterpolant<
+    marley::DEFAULT_N_CHEBYSHEV>;
+
+  BENCHMARK( "ChebyshevInterpolant<"
+    + std::to_string(marley::DEFAULT_N_CHEBYSHEV) + "> construction" )
+  {
+    return FixedInterpolant( test_pdf, X_MIN, X_MAX );
+  };
+
+  FixedInterpolant fixed_func( test_pdf, X_MIN, X_MAX );
+
+  BENCHMARK( "ChebyshevInterpolant::evaluate" ) {
+    x += 0.37;
+    if ( x > X_MAX ) x -= X_MAX - X_MIN;
+    return fixed_func.evaluate( x );
+  };
+
+  BENCHMARK( "ChebyshevInterpolant::cdf" ) {
+    return fixed_func.cdf();
+  };
+
+  auto fixed_cdf = fixed_func.cdf();
+  BENCHMARK( "inverse transform sample (ChebyshevCDF::inverse_cdf)" ) {
+    prob += 0.0137;
+    if ( prob >= 1. ) prob -= 1.;
+    return fixed_cdf.inverse_cdf( prob, 1e-12 );
+  };
+}
+
+TEST_CASE( "Nuclear structure models", "[benchmark]" )
+{
+  auto& sdb = default_generator().get_structure_db();
+  auto& om = sdb.get_optical_model( PDG_40K );
+
+  double KE = 0.;
+  BENCHMARK( "OpticalModel::transmission_coefficient (neutron)" ) {
+    KE += 0.25;
+    if ( KE > 20. ) KE = 0.25;
+    return om.transmission_coefficient( KE, marley_utils::NEUTRON, 1, 0, 1 );
+  };
+
+  marley::BackshiftedFermiGasModel ld( 19, 40 );
+  double Ex = 0.;
+  BENCHMARK( "BackshiftedFermiGasModel::level_density" ) {
+    Ex += 0.25;
+    if ( Ex > 30. ) Ex = 0.25;
+    return ld.level_density( Ex, 2, marley::Parity(true) );
+  };
+
+  // Compound 40K* ion with net charge +1
+  const double Exi = 27.; // MeV
+  const int qi = 1;
+  const auto& mt = marley::MassTable::Instance();
+  double mass = mt.get_atomic_mass( PDG_40K )
+    - qi * mt.get_particle_mass( marley_utils::ELECTRON ) + Exi;
+  marley::Particle compound_nuc( PDG_40K, mass, 0., 0., 0., mass, qi );
+
+  BENCHMARK( "HauserFeshbachDecay construction" ) {
+    return marley::HauserFeshbachDecay( compound_nuc, Exi, 2,
+      marley::Parity(true), sdb );
+  };
+}
+
+TEST_CASE( "Event generation", "[benchmark]" )
+{
+  for ( const auto& reaction : REACTION_FILES ) {
+
+    const std::string& react_file = reaction.file_name;
+
+    // Skip reactions that cannot be simulated with the chosen source
+    std::unique_ptr<marley::Generator> gen;
+    try {
+      gen = std::make_unique<marley::Generator>( make_generator(react_file,
+        reaction.projectile) );
+      marley::Event test_event;
+      gen->create_event( test_event );
+    }
+    catch ( const marley::Error& error ) {
+      WARN( "Skipped " << react_file << ": " << error.what() );
+      continue;
+    }
+
+    marley::Event ev;
+    BENCHMARK( "Generator::create_event (" + react_file + ')' ) {
+      gen->create_event( ev );
+      return ev.weight();
+    };
+  }
+}
@@ -0,0 +1,81 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <string>
+#include <vector>
+
+// This provides a main() function from catch itself
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/JSON.hh"
+
+namespace {
+
+  // Catch2 reporter that writes the results of each benchmark as JSON so
+  // that they may be compared from one run to the next. Select it using
+  // "marbench --reporter json" (optionally with "--out file.json").
+  class JSONBenchmarkReporter
+    : public Catch::StreamingReporterBase<JSONBenchmarkReporter>
+  {
+    public:
+
+      JSONBenchmarkReporter(const Catch::ReporterConfig& config)
+        : StreamingReporterBase( config ),
+        results_( marley::JSON::array() ) {}
+
+      static std::string getDescription() {
+        return "Reports the results of each benchmark as a JSON array";
+      }
+
+      void assertionStarting(const Catch::AssertionInfo&) override {}
+
+      bool assertionEnded(const Catch::AssertionStats&) override
+        { return true; }
+
+      void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+        marley::JSON result = marley::JSON::object();
+        if ( currentTestCaseInfo ) {
+          result[ "test_case" ] = currentTestCaseInfo->name;
+        }
+        result[ "name" ] = stats.info.name;
+        result[ "samples" ] = stats.info.samples;
+        result[ "iterations" ] = stats.info.iterations;
+        result[ "mean_ns" ] = stats.mean.point.count();
+        result[ "mean_lower_ns" ] = stats.mean.lower_bound.count();
+        result[ "mean_upper_ns" ] = stats.mean.upper_bound.count();
+        result[ "std_dev_ns" ] = stats.standardDeviation.point.count();
+        result[ "outlier_variance" ] = stats.outlierVariance;
+        results_.append( result );
+      }
+
+      void testRunEnded(const Catch::TestRunStats& stats) override {
+        marley::JSON report = marley::JSON::object();
+        report[ "benchmarks" ] = results_;
+        stream << report.dump_string( 2 ) << '\n';
+        StreamingReporterBase::testRunEnded( stats );
+      }
+
+    private:
+
+      marley::JSON results_;
+  };
+
+}
+
+CATCH_REGISTER_REPORTER( "json", JSONBenchmarkReporter )
@@ -16,22 +16,37 @@
 
 // Functions to calculate the Coulomb wavefunctions using the GNU Scientific
 // Library
+#include <algorithm>
+#include <cmath>
+
 #include "gsl/gsl_errno.h"
 #include "gsl/gsl_sf_coulomb.h"
 
 #include "marley/coulomb_wavefunctions.hh"
 #include "marley/Logger.hh"
+#include "marley/marley_utils.hh"
 
-std::complex<double> coulomb_H_plus(int l, double eta, double rho) {
+namespace {
 
-  // Enable the MARLEY gsl error handler upon using this function
-  // for the first time
-  static bool error_handler_set = false;
-  if ( !error_handler_set ) {
-    gsl_set_error_handler( &marley_gsl_error_handler );
-    error_handler_set = true;
+  // Enable the MARLEY gsl error handler upon computing Coulomb wavefunctions
+  // for the first time. Initialization of a function-local static variable
+  // is guaranteed to happen exactly once, and concurrent callers wait for it
+  // to finish, so no thread can reach GSL before the handler is installed.
+  // The handler itself only writes to the Logger, which is thread-safe.
+  void set_gsl_error_handler() {
+    static const bool error_handler_set = []() -> bool {
+      gsl_set_error_handler( &marley_gsl_error_handler );
+      return true;
+    }();
+    (void)error_handler_set;
   }
 
+}
+
+std::complex<double> coulomb_H_plus(int l, double eta, double rho) {
+
+  set_gsl_error_handler();
+
   // H+ = G + i F
   gsl_sf_result F, Fp, G, Gp;
   double exp_F, exp_G;
@@ -46,6 +61,76 @@ std::complex<double> coulomb_H_plus(int l, double eta, double rho) {
   return std::complex<double>(G.val, F.val);
 }
 
+void coulomb_H_plus_array(int l_max, double eta, double rho,
+  std::vector<std::complex<double> >& Hs)
+{
+  set_gsl_error_handler();
+
+  std::vector<double> F( l_max + 1 ), G( l_max + 1 );
+  double exp_F, exp_G;
+  int code = gsl_sf_coulomb_wave_FG_array(0., l_max, eta, rho, F.data(),
+    G.data(), &exp_F, &exp_G);
+
+  // On overflow, the values returned by GSL share a common scaling
+  // exponent for each kind of wavefunction
+  double scale_F = 1.;
+  double scale_G = 1.;
+  if (code == GSL_EOVRFLW) {
+    scale_F = std::exp(exp_F);
+    scale_G = std::exp(exp_G);
+  }
+
+  // H+ = G + i F
+  Hs.resize( l_max + 1 );
+  for ( int l = 0; l <= l_max; ++l ) {
+    Hs[l] = std::complex<double>(G[l] * scale_G, F[l] * scale_F);
+  }
+}
+
+marley::CoulombWavefunctionCache::CoulombWavefunctionCache(size_t max_size)
+  : max_size_( max_size )
+{
+}
+
+size_t marley::CoulombWavefunctionCache::memory_usage() const {
+  size_t bytes = marley_utils::vector_bytes( entries_ );
+  for ( const auto& entry : entries_ ) {
+    bytes += marley_utils::vector_bytes( entry.Hs );
+  }
+  return bytes;
+}
+
+std::complex<double> marley::CoulombWavefunctionCache::H_plus(int l,
+  int l_max, double eta, double rho)
+{
+  for ( const auto& entry : entries_ ) {
+    if ( entry.eta == eta && entry.rho == rho
+      && static_cast<size_t>(l) < entry.Hs.size() )
+    {
+      return entry.Hs[l];
+    }
+  }
+
+  // Without any storage, just compute the requested value
+  if ( max_size_ == 0u ) return coulomb_H_plus( l, eta, rho );
+
+  // Compute a new ladder, replacing the oldest entry if the storage is full
+  Entry* entry = nullptr;
+  if ( entries_.size() < max_size_ ) {
+    entries_.push_back( Entry() );
+    entry = &entries_.back();
+  }
+  else {
+    entry = &entries_.at( next_ );
+    next_ = ( next_ + 1u ) % max_size_;
+  }
+
+  entry->eta = eta;
+  entry->rho = rho;
+  coulomb_H_plus_array( std::max(l, l_max), eta, rho, entry->Hs );
+  return entry->Hs[l];
+}
+
 /// Custom GSL error handler used by MARLEY when computing the Coulomb wavefunctions
 void marley_gsl_error_handler(const char* reason, const char* file, int line,
   int gsl_errno)
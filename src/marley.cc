@@ -14,28 +14,54 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <atomic>
+#include <condition_variable>
 #include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "marley/marley_utils.hh"
 
 #ifdef USE_ROOT
+  #include "marley/RootEventFileReader.hh"
   #include "marley/RootJSONConfig.hh"
   #include "marley/RootOutputFile.hh"
 #else
+  #include "marley/EventFileReader.hh"
   #include "marley/JSONConfig.hh"
 #endif
 
 #include "marley/Generator.hh"
 #include "marley/Event.hh"
+#include "marley/EventHistograms.hh"
+#include "marley/EventServer.hh"
+#include "marley/EventSink.hh"
+#include "marley/FileManager.hh"
+#include "marley/HDF5OutputFile.hh"
+#include "marley/Instrumentation.hh"
 #include "marley/Logger.hh"
+#include "marley/MassTable.hh"
 #include "marley/OutputFile.hh"
+#include "marley/StartupProfile.hh"
+#include "marley/StructureDatabase.hh"
+#include "marley/ThreadAffinity.hh"
+#include "marley/Tracing.hh"
 
 #ifdef USE_ROOT
   #include "TFile.h"
@@ -68,6 +94,26 @@ namespace {
 
   constexpr int DEFAULT_STATUS_UPDATE_INTERVAL = 100;
 
+  // Time between refreshes of the status lines shown while events are
+  // being generated
+  constexpr std::chrono::milliseconds STATUS_REFRESH_PERIOD( 500 );
+
+  // Maximum number of events that each worker thread will generate before
+  // handing its results back to the main thread for output. Used only when
+  // more than one thread is requested.
+  constexpr long EVENTS_PER_THREAD_PER_ROUND = 100;
+
+  // Number of completed events that may be waiting to be written to the
+  // output files before event generation is paused
+  constexpr size_t OUTPUT_BUFFER_SIZE = 1024;
+
+  // Number of buffered events that the I/O threads write at a time
+  constexpr size_t OUTPUT_BATCH_SIZE = 128;
+
+  // Maximum number of events per de-excitation thread that may be in
+  // flight at once in the pipelined mode
+  constexpr long PIPELINE_EVENTS_PER_THREAD = 64;
+
   // Show a number using one decimal digit without scientific notation.
   // Used to print certain numbers in this way without affecting the settings
   // currently in use for std::cout.
@@ -98,8 +144,19 @@ namespace {
     constexpr char help_message1[] = "Usage: ";
     constexpr char help_message2[] = " [OPTION...] CONFIG_FILE\n"
       "\n"
-      "  -h, --help     Print this help message\n"
-      "  -v, --version  Print version and exit\n";
+      "  -h, --help          Print this help message\n"
+      "  -v, --version       Print version and exit\n"
+      "  --compile-data      Write compiled versions of the mass and\n"
+      "                      spin-parity tables to speed up startup\n"
+      "  --shard I/N         Generate shard I (counting from zero) of a\n"
+      "                      production split into N shards. Use\n"
+      "                      --shard auto to take I and N from the\n"
+      "                      environment of an MPI or Slurm job array\n"
+      "  --merge N           Combine the output files written by the N\n"
+      "                      shards of a production\n"
+      "  --serve SOCKET      Keep the generators ready and serve batches\n"
+      "                      of events to other processes over the Unix\n"
+      "                      domain socket SOCKET\n";
 
     std::cout << help_message1 + executable_name + help_message2;
     std::cout << "\nMARLEY home page: <http://www.marleygen.org>\n";
@@ -107,6 +164,31 @@ namespace {
     exit(0);
   }
 
+  // Writes a compiled version of each of the data tables that MARLEY loads
+  // at startup next to the original file on the search path
+  void compile_data_files() {
+    const auto& fm = marley::FileManager::Instance();
+    const std::string& suffix
+      = marley::StructureDatabase::COMPILED_DECAY_SCHEME_SUFFIX;
+
+    std::string mt_file = fm.find_file( "mass_table.js" );
+    if ( mt_file.empty() ) throw marley::Error("Could not find the MARLEY"
+      " mass table data file mass_table.js");
+    int count = marley::MassTable::compile( mt_file, mt_file + suffix );
+    std::cout << "Compiled " << count << " masses from " << mt_file
+      << " into " << mt_file + suffix << '\n';
+
+    std::string jpi_file = fm.find_file( "gs_spin_parity_table.txt" );
+    if ( jpi_file.empty() ) throw marley::Error("Could not find the MARLEY"
+      " nuclear ground-state spin-parity data file gs_spin_parity_table.txt");
+    count = marley::StructureDatabase::compile_gs_spin_parity_table(
+      jpi_file, jpi_file + suffix );
+    std::cout << "Compiled " << count << " spin-parities from " << jpi_file
+      << " into " << jpi_file + suffix << '\n';
+
+    exit(0);
+  }
+
   void print_version() {
     std::cout << "MARLEY (Model of Argon Reaction Low Energy Yields) "
       << MARLEY_VERSION << '\n';
@@ -119,6 +201,174 @@ namespace {
     exit(0);
   }
 
+  #ifdef USE_ROOT
+    using ShardReader = marley::RootEventFileReader;
+  #else
+    using ShardReader = marley::EventFileReader;
+  #endif
+
+  // Describes how a production is divided among independent jobs (shards),
+  // which may run on different machines. Each shard generates a contiguous
+  // range of the requested events and writes them to its own output files.
+  // A final job merges the files from all of the shards.
+  struct ShardSettings {
+    enum class Mode { NONE, GENERATE, MERGE };
+    Mode mode = Mode::NONE;
+    int index = 0;
+    int count = 1;
+  };
+
+  // Parses a non-negative integer given on the command line or in an
+  // environment variable
+  int parse_shard_number(const std::string& str, const std::string& what) {
+    bool ok = !str.empty() && str.find_first_not_of("0123456789")
+      == std::string::npos;
+    long value = 0;
+    if ( ok ) {
+      value = std::strtol( str.c_str(), nullptr, 10 );
+      ok = value <= std::numeric_limits<int>::max();
+    }
+    if ( !ok ) throw marley::Error( "Invalid value \"" + str
+      + "\" given for the " + what );
+    return static_cast<int>( value );
+  }
+
+  // Loads the value of an integer environment variable. Returns false if the
+  // variable is not set.
+  bool get_env_number(const char* name, int& value) {
+    const char* str = std::getenv( name );
+    if ( !str || *str == '\0' ) return false;
+    value = parse_shard_number( str, std::string("environment variable ")
+      + name );
+    return true;
+  }
+
+  // Determines the shard to generate from the environment. The variables
+  // MARLEY_SHARD_INDEX and MARLEY_SHARD_COUNT take precedence. Otherwise, the
+  // rank and size of MPI_COMM_WORLD are taken from the variables set by the
+  // MPI launcher (Open MPI or any that uses PMI, such as MPICH and Slurm's
+  // srun), and then the task ID and count of a Slurm job array are used.
+  ShardSettings shard_from_environment() {
+    ShardSettings shard;
+    shard.mode = ShardSettings::Mode::GENERATE;
+
+    int index = 0;
+    int count = 0;
+    bool found = ( get_env_number("MARLEY_SHARD_INDEX", index)
+      && get_env_number("MARLEY_SHARD_COUNT", count) )
+      || ( get_env_number("OMPI_COMM_WORLD_RANK", index)
+      && get_env_number("OMPI_COMM_WORLD_SIZE", count) )
+      || ( get_env_number("PMI_RANK", index)
+      && get_env_number("PMI_SIZE", count) );
+
+    if ( !found && get_env_number("SLURM_ARRAY_TASK_ID", index)
+      && get_env_number("SLURM_ARRAY_TASK_COUNT", count) )
+    {
+      // Array task IDs need not start from zero
+      int min_id = 0;
+      get_env_number( "SLURM_ARRAY_TASK_MIN", min_id );
+      index -= min_id;
+      found = true;
+    }
+
+    if ( !found ) throw marley::Error( "Could not determine the shard to"
+      " generate from the environment. Set MARLEY_SHARD_INDEX and"
+      " MARLEY_SHARD_COUNT or use --shard I/N." );
+
+    shard.index = index;
+    shard.count = count;
+    return shard;
+  }
+
+  // Parses the value given for the --shard command-line option
+  ShardSettings parse_shard_option(const std::string& spec) {
+    if ( spec == "auto" ) return shard_from_environment();
+
+    size_t slash = spec.find( '/' );
+    if ( slash == std::string::npos ) throw marley::Error( "Invalid shard"
+      " specification \"" + spec + "\". Use the form INDEX/COUNT." );
+
+    ShardSettings shard;
+    shard.mode = ShardSettings::Mode::GENERATE;
+    shard.index = parse_shard_number( spec.substr(0, slash),
+      "shard index" );
+    shard.count = parse_shard_number( spec.substr(slash + 1),
+      "shard count" );
+    return shard;
+  }
+
+  // Inserts the shard index into a file name just before its extension(s).
+  // For example, shard 3 of "events.ascii.zst" is written to
+  // "events.shard3.ascii.zst".
+  std::string shard_file_name(const std::string& name, int index) {
+    size_t slash = name.find_last_of( '/' );
+    size_t base_start = ( slash == std::string::npos ) ? 0u : slash + 1u;
+    size_t dot = name.find( '.', base_start + 1u );
+    std::string tag = ".shard" + std::to_string( index );
+    if ( dot == std::string::npos ) return name + tag;
+    return name.substr( 0, dot ) + tag + name.substr( dot );
+  }
+
+  // Copies the events from the output files written by every shard of a
+  // production (in order of the shard index) to the merged output files.
+  // The flux-averaged total cross section is taken from the first shard.
+  // The generator state gen_state is saved with each completed part of a
+  // rotating output file. Returns the total number of events.
+  long merge_shards(const std::string& source_name, int shard_count,
+    std::vector< std::unique_ptr<marley::OutputFile> >& output_files,
+    const marley::OutputFile::GeneratorState& gen_state)
+  {
+    // Make sure that every shard is present before writing anything
+    for ( int s = 0; s < shard_count; ++s ) {
+      std::string name = shard_file_name( source_name, s );
+      if ( !std::ifstream(name).good() ) throw marley::Error( "Could not"
+        " find the output file \"" + name + "\" written by shard "
+        + std::to_string(s) );
+    }
+
+    long num_events = 0;
+    double avg_tot_xs = 0.; // MeV^(-2)
+    marley::Event ev;
+    for ( int s = 0; s < shard_count; ++s ) {
+      std::string name = shard_file_name( source_name, s );
+      ShardReader reader( name );
+
+      double shard_xs = reader.flux_averaged_xsec( true );
+      if ( s == 0 ) {
+        avg_tot_xs = shard_xs;
+        for ( auto& file : output_files ) {
+          file->write_flux_avg_tot_xsec( avg_tot_xs );
+        }
+      }
+      else if ( std::abs(shard_xs - avg_tot_xs)
+        > 1e-10 * std::abs(avg_tot_xs) )
+      {
+        MARLEY_LOG_WARNING() << "The flux-averaged total cross section "
+          << shard_xs << " MeV^(-2) stored in " << name << " differs from"
+          << " the value " << avg_tot_xs << " MeV^(-2) used for the merged"
+          << " output. The shards may have been generated using different"
+          << " job configurations.";
+      }
+
+      long shard_events = 0;
+      while ( reader >> ev ) {
+        for ( auto& file : output_files ) {
+          auto* rf = dynamic_cast< marley::RotatingOutputFile* >(
+            file.get() );
+          if ( rf && rf->rotation_due() ) rf->schedule_rotation( gen_state );
+          file->write_event( &ev );
+        }
+        ++shard_events;
+      }
+
+      MARLEY_LOG_INFO() << "Merged " << shard_events << " events from "
+        << name;
+      num_events += shard_events;
+    }
+
+    return num_events;
+  }
+
   // Use this instead of std::put_time to allow this executable to be built
   // with g++ 4.9 (issue fixed in 5.0). See discussion here:
   // http://stackoverflow.com/a/14137287
@@ -136,11 +386,352 @@ namespace {
     return time_str;
   }
 
+  // Writes events to the output files on background threads so that event
+  // generation and output overlap. Completed events are moved into a
+  // bounded ring buffer, and each output file is served by its own I/O
+  // thread that writes the events in the order they were received. The
+  // buffer slot holding an event is reused once every file has written it.
+  // The producer (the thread calling receive_event()) blocks only when the
+  // buffer is full. On a machine with a single hardware thread, generation
+  // and output cannot overlap, so the events are written synchronously
+  // instead. The producer also decides when each rotating output file
+  // should start a new part.
+  class AsyncEventWriter : public marley::EventSink {
+    public:
+
+      // The number of bytes written to each file will be refreshed after
+      // every byte_count_interval events. The state of gen is saved with
+      // each completed part of a rotating output file. If gen is null
+      // (because the Generator is in use by another thread), then its
+      // state at the start of the run (given by initial_gen) is used
+      // instead.
+      AsyncEventWriter(
+        const std::vector<std::unique_ptr<marley::OutputFile> >& output_files,
+        long byte_count_interval, bool use_threads,
+        const marley::Generator* gen, const marley::Generator& initial_gen)
+        : output_files_( output_files ), use_threads_( use_threads ),
+        tails_( output_files.size(), 0u ),
+        byte_counts_( output_files.size(), 0 ),
+        byte_count_interval_( std::max(byte_count_interval, 1l) ),
+        gen_( gen )
+      {
+        for ( size_t f = 0u; f < output_files_.size(); ++f ) {
+          byte_counts_[ f ] = output_files_[ f ]->bytes_written();
+          auto* rf = dynamic_cast< marley::RotatingOutputFile* >(
+            output_files_[ f ].get() );
+          if ( rf ) rotating_files_.push_back( rf );
+        }
+        if ( !rotating_files_.empty() ) initial_state_ = initial_gen;
+        if ( !use_threads_ ) return;
+        slots_.resize( OUTPUT_BUFFER_SIZE );
+        for ( size_t f = 0u; f < output_files_.size(); ++f ) {
+          threads_.emplace_back( &AsyncEventWriter::write_events, this, f );
+        }
+      }
+
+      // If finish() was never called (e.g., because an exception was
+      // thrown), then stop the I/O threads without writing the remaining
+      // events
+      ~AsyncEventWriter() {
+        if ( threads_.empty() ) return;
+        {
+          std::lock_guard<std::mutex> lock( mutex_ );
+          abort_ = true;
+        }
+        not_empty_.notify_all();
+        for ( auto& t : threads_ ) t.join();
+      }
+
+      // Moves the contents of ev into the buffer, leaving the previous
+      // contents of the buffer slot behind in its place
+      void receive_event( marley::Event& ev ) override {
+        // Any new parts will begin after this event
+        for ( auto* rf : rotating_files_ ) {
+          if ( !rf->rotation_due() ) continue;
+          if ( gen_ ) rf->schedule_rotation( *gen_ );
+          else rf->schedule_rotation( initial_state_ );
+        }
+
+        if ( !use_threads_ ) {
+          for ( const auto& file : output_files_ ) {
+            marley::Instrumentation::ScopedTimer timer(
+              marley::Instrumentation::Probe::WriteEvent );
+            MARLEY_TRACE_ZONE( trace_zone, "write_event" );
+            file->write_event( &ev );
+          }
+          if ( ++head_ % byte_count_interval_ == 0u ) {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            for ( size_t f = 0u; f < output_files_.size(); ++f ) {
+              byte_counts_[ f ] = output_files_[ f ]->bytes_written();
+            }
+          }
+          return;
+        }
+
+        std::unique_lock<std::mutex> lock( mutex_ );
+        not_full_.wait( lock, [this]() -> bool {
+          return error_ || head_ - min_tail() < slots_.size();
+        } );
+        if ( error_ ) std::rethrow_exception( error_ );
+
+        // No I/O thread will access this slot until head_ is incremented
+        marley::Event& slot = slots_[ head_ % slots_.size() ];
+        lock.unlock();
+        std::swap( slot, ev );
+        lock.lock();
+
+        // To limit the number of thread wake-ups, the I/O threads are only
+        // notified once a full batch of events is ready
+        ++head_;
+        bool notify = head_ % OUTPUT_BATCH_SIZE == 0u;
+        lock.unlock();
+        if ( notify ) not_empty_.notify_all();
+      }
+
+      // Waits for all buffered events to be written, then stops the I/O
+      // threads. Rethrows the first error encountered by any of them.
+      void finish() {
+        {
+          std::lock_guard<std::mutex> lock( mutex_ );
+          done_ = true;
+        }
+        not_empty_.notify_all();
+        for ( auto& t : threads_ ) t.join();
+        threads_.clear();
+        if ( error_ ) std::rethrow_exception( error_ );
+      }
+
+      // Waits until every event received so far has been written, then
+      // takes a checkpoint of each output file (see
+      // marley::OutputFile::checkpoint()). The I/O threads are idle while
+      // this is done. Returns a JSON array describing the files.
+      marley::JSON checkpoint( long num_events ) {
+        if ( use_threads_ ) {
+          std::unique_lock<std::mutex> lock( mutex_ );
+          flush_ = true;
+          not_empty_.notify_all();
+          not_full_.wait( lock, [this]() -> bool {
+            return error_ || min_tail() == head_;
+          } );
+          flush_ = false;
+          if ( error_ ) std::rethrow_exception( error_ );
+        }
+
+        marley::JSON files = marley::JSON::array();
+        for ( const auto& file : output_files_ ) {
+          marley::JSON entry = marley::JSON::object();
+          entry[ "file" ] = file->name();
+          entry[ "state" ] = file->checkpoint( num_events );
+          files.append( entry );
+        }
+        return files;
+      }
+
+      const std::string& file_name( size_t f ) const {
+        return output_files_.at( f )->name();
+      }
+
+      // Returns the number of bytes written to file f as of the latest
+      // refresh. This may be called from any thread. The OutputFile objects
+      // themselves may not be used for this purpose while events are being
+      // written to them.
+      int_fast64_t bytes_written( size_t f ) const {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        return byte_counts_.at( f );
+      }
+
+      size_t num_files() const { return output_files_.size(); }
+
+    protected:
+
+      // Main loop for the I/O thread that serves output file f
+      void write_events( size_t f ) {
+        auto& file = *output_files_[ f ];
+        marley::Instrumentation::set_thread_label( "output " + file.name() );
+        std::unique_lock<std::mutex> lock( mutex_ );
+        while ( true ) {
+          not_empty_.wait( lock, [this, f]() -> bool {
+            return abort_ || error_ || done_
+              || head_ - tails_[ f ] >= OUTPUT_BATCH_SIZE
+              || ( flush_ && tails_[ f ] < head_ );
+          } );
+          if ( abort_ || error_ || tails_[ f ] == head_ ) break;
+
+          // Write all of the events that are currently available. The
+          // producer will not touch their slots until tails_[ f ] is
+          // updated.
+          uint64_t begin = tails_[ f ];
+          uint64_t end = head_;
+          lock.unlock();
+
+          int_fast64_t byte_count = -1;
+          try {
+            for ( uint64_t e = begin; e < end; ++e ) {
+              marley::Instrumentation::ScopedTimer timer(
+                marley::Instrumentation::Probe::WriteEvent );
+              MARLEY_TRACE_ZONE( trace_zone, "write_event" );
+              file.write_event( &slots_[ e % slots_.size() ] );
+              if ( ( e + 1u ) % byte_count_interval_ == 0u ) {
+                byte_count = file.bytes_written();
+              }
+            }
+          }
+          catch ( ... ) {
+            lock.lock();
+            if ( !error_ ) error_ = std::current_exception();
+            break;
+          }
+
+          lock.lock();
+          if ( byte_count >= 0 ) byte_counts_[ f ] = byte_count;
+          tails_[ f ] = end;
+          not_full_.notify_one();
+        }
+
+        // Wake up the producer in case it is waiting on this thread
+        not_full_.notify_one();
+      }
+
+      // Position of the I/O thread that is furthest behind. Must be called
+      // with mutex_ locked.
+      uint64_t min_tail() const {
+        if ( tails_.empty() ) return head_;
+        return *std::min_element( tails_.begin(), tails_.end() );
+      }
+
+      const std::vector<std::unique_ptr<marley::OutputFile> >& output_files_;
+
+      // Whether events are written by background I/O threads
+      bool use_threads_;
+
+      // Output files that start a new part when the current one is full
+      std::vector<marley::RotatingOutputFile*> rotating_files_;
+
+      // Ring buffer of events waiting to be written
+      std::vector<marley::Event> slots_;
+
+      // Total number of events received so far
+      uint64_t head_ = 0u;
+
+      // Total number of events written so far to each file
+      std::vector<uint64_t> tails_;
+
+      std::vector<int_fast64_t> byte_counts_;
+      uint64_t byte_count_interval_;
+
+      // Source of the generator state saved with each completed part of a
+      // rotating output file
+      const marley::Generator* gen_;
+      marley::OutputFile::GeneratorState initial_state_;
+
+      std::vector<std::thread> threads_;
+      mutable std::mutex mutex_;
+      std::condition_variable not_empty_;
+      std::condition_variable not_full_;
+      bool done_ = false;
+      bool abort_ = false;
+
+      // Set while checkpoint() waits for the I/O threads to write every
+      // buffered event, including those in an incomplete batch
+      bool flush_ = false;
+
+      std::exception_ptr error_;
+  };
+
+  // Periodically saves everything needed to continue a run after it is
+  // interrupted (e.g., by a batch system time limit): the job
+  // configuration, the number of completed events, the state of the random
+  // number engine used by each thread, and the size of each output file.
+  // The checkpoint file is replaced atomically, so a complete copy is
+  // always available.
+  class Checkpointer {
+    public:
+
+      // No checkpoints are written if file_name is empty. Otherwise, a new
+      // one is written once event_interval events or seconds_interval
+      // seconds have elapsed since the previous one (zero disables either
+      // criterion).
+      Checkpointer(const std::string& file_name, long event_interval,
+        double seconds_interval, long num_old_events)
+        : file_name_( file_name ), event_interval_( event_interval ),
+        seconds_interval_( seconds_interval ),
+        last_count_( num_old_events ),
+        last_time_( std::chrono::steady_clock::now() ) {}
+
+      bool enabled() const { return !file_name_.empty(); }
+
+      // Returns true if a checkpoint should be written now that ev_count
+      // events have been completed
+      bool due( long ev_count ) const {
+        if ( !enabled() ) return false;
+        if ( event_interval_ > 0 && ev_count - last_count_ >= event_interval_ )
+        {
+          return true;
+        }
+        if ( seconds_interval_ > 0. ) {
+          std::chrono::duration<double> elapsed
+            = std::chrono::steady_clock::now() - last_time_;
+          if ( elapsed.count() >= seconds_interval_ ) return true;
+        }
+        return false;
+      }
+
+      // Writes a checkpoint after ev_count events have been completed
+      void write( const marley::JSON& config, long ev_count,
+        const std::vector<marley::Generator*>& gens, AsyncEventWriter& writer )
+      {
+        marley::JSON states = marley::JSON::array();
+        marley::JSON seeds = marley::JSON::array();
+        for ( const auto* gen : gens ) {
+          states.append( gen->get_state_string() );
+          seeds.append( std::to_string(gen->get_seed()) );
+        }
+
+        marley::JSON checkpoint = marley::JSON::object();
+        checkpoint[ "config" ] = config;
+        checkpoint[ "event_count" ] = ev_count;
+        checkpoint[ "seeds" ] = seeds;
+        checkpoint[ "generator_states" ] = states;
+        checkpoint[ "output" ] = writer.checkpoint( ev_count );
+
+        // Write to a temporary file first so that an interruption never
+        // leaves a partial checkpoint behind
+        std::string temp_file_name = file_name_ + ".tmp";
+        std::ofstream out( temp_file_name );
+        out << checkpoint.dump_string() << '\n';
+        out.close();
+        if ( !out ) throw marley::Error( "Failed to write the checkpoint"
+          " file " + temp_file_name );
+
+        if ( std::rename(temp_file_name.c_str(), file_name_.c_str()) != 0 ) {
+          throw marley::Error( "Could not rename " + temp_file_name + " to "
+            + file_name_ + " while saving a checkpoint" );
+        }
+
+        last_count_ = ev_count;
+        last_time_ = std::chrono::steady_clock::now();
+        MARLEY_LOG_DEBUG() << "Saved a checkpoint after " << ev_count
+          << " events to " << file_name_;
+      }
+
+      // Deletes the checkpoint file once the run has been completed
+      void remove() {
+        if ( enabled() ) std::remove( file_name_.c_str() );
+      }
+
+    protected:
+      std::string file_name_;
+      long event_interval_;
+      double seconds_interval_;
+      long last_count_;
+      std::chrono::steady_clock::time_point last_time_;
+  };
+
   // Formats the lines of the status display shown at the bottom of the
   // screen when this executable is running
   std::string makeStatusLines(long ev_count, long num_events, long num_old_events,
     std::chrono::system_clock::time_point start_time_point,
-    const std::vector< std::unique_ptr<marley::OutputFile> >& output_files)
+    const AsyncEventWriter& writer)
   {
     std::chrono::system_clock::time_point current_time_point
       = std::chrono::system_clock::now();
@@ -174,9 +765,9 @@ namespace {
       < marley_utils::seconds<double> >( estimated_total_time )
       << ")\033[K\n";
 
-    for (const auto& file : output_files) {
-      temp_oss << "Data written to " << file->name() << ' '
-        << marley_utils::num_bytes_to_string(file->bytes_written(), 2)
+    for (size_t f = 0; f < writer.num_files(); ++f) {
+      temp_oss << "Data written to " << writer.file_name(f) << ' '
+        << marley_utils::num_bytes_to_string(writer.bytes_written(f), 2)
         << "\033[K\n";
     }
 
@@ -190,7 +781,7 @@ namespace {
     // Move up an extra line in the terminal for each output file because
     // we're displaying the amount of data written to disk for each of them
     // on a separate line.
-    for (size_t i = 0; i < output_files.size(); ++i) temp_oss << "\033[F";
+    for (size_t i = 0; i < writer.num_files(); ++i) temp_oss << "\033[F";
 
     // Move up four lines
     temp_oss << "\033[F\033[F\033[F\033[F";
@@ -198,51 +789,165 @@ namespace {
     return temp_oss.str();
   }
 
-  // Inserts an updated copy of the status lines after each
-  // newline is written to std::cout (e.g., by the marley::Logger
-  // class). Based on https://stackoverflow.com/a/22043916
+  // Keeps the most recent copy of the status lines below any other text
+  // written to std::cout and std::cerr (e.g., by the marley::Logger class).
+  // The status lines are redrawn at the start of each new line of text, but
+  // they are only reformatted by the StatusReporter on a fixed schedule, so
+  // the cost of writing text does not depend on how much of it there is.
+  // Based on https://stackoverflow.com/a/22043916
   class StatusInserter : public std::streambuf {
     public:
-      StatusInserter(std::streambuf* dest, const long& ev_count,
-        const long& num_events, const long& num_old_events,
-        const std::chrono::system_clock::time_point& start_time_point,
-        const std::vector<std::unique_ptr<marley::OutputFile> >& output_files)
-        : std::streambuf(), myDest_( dest ), myIsAtStartOfLine_(true),
-        do_status_(true), ev_count_( ev_count ), num_events_( num_events ),
-        num_old_events_( num_old_events ), start_time_point_( start_time_point ),
-        output_files_( output_files ) {}
-
-      inline void set_do_status(bool do_it) { do_status_ = do_it; }
+      StatusInserter(std::streambuf* dest) : std::streambuf(),
+        myDest_( dest ), myIsAtStartOfLine_(true) {}
+
+      // Replaces the status lines with a new version and draws it
+      // immediately if the cursor is at the start of a line. May be called
+      // from any thread.
+      void set_status(const std::string& status) {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        status_ = status;
+        if ( myIsAtStartOfLine_ ) {
+          myDest_->sputn( status_.data(), status_.size() );
+          myDest_->pubsync();
+        }
+      }
 
     protected:
       std::streambuf* myDest_;
       bool myIsAtStartOfLine_;
-      bool do_status_;
-      const long& ev_count_;
-      const long& num_events_;
-      const long& num_old_events_;
-      const std::chrono::system_clock::time_point& start_time_point_;
-      const std::vector<std::unique_ptr<marley::OutputFile> >& output_files_;
+
+      // Latest status lines (empty if none should be shown)
+      std::string status_;
+
+      // Serializes output from the thread(s) writing text and from the
+      // StatusReporter
+      std::mutex mutex_;
+
+      // Must be called with mutex_ locked
+      int put_char( int ch ) {
+        if ( myIsAtStartOfLine_ && !status_.empty() ) {
+          myDest_->sputn( status_.data(), status_.size() );
+        }
+        myIsAtStartOfLine_ = ch == '\n';
+        if ( myIsAtStartOfLine_ ) {
+          static const std::string erase( "\033[K" );
+          myDest_->sputn( erase.data(), erase.size() );
+        }
+        return myDest_->sputc( ch );
+      }
 
       int overflow( int ch ) override {
-        int retval = 0;
-        if ( ch != traits_type::eof() ) {
-          if ( do_status_ && myIsAtStartOfLine_ ) {
-            std::string status = makeStatusLines(ev_count_,
-              num_events_, num_old_events_, start_time_point_, output_files_);
-            myDest_->sputn( status.data(), status.size() );
-          }
-          myIsAtStartOfLine_ = ch == '\n';
-          if ( myIsAtStartOfLine_ ) {
-            std::string erase( "\033[K" );
-            myDest_->sputn( erase.data(), erase.size() );
+        if ( ch == traits_type::eof() ) return 0;
+        std::lock_guard<std::mutex> lock( mutex_ );
+        return put_char( ch );
+      }
+
+      std::streamsize xsputn( const char* s, std::streamsize n ) override {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        for ( std::streamsize i = 0; i < n; ++i ) {
+          if ( put_char(traits_type::to_int_type(s[i]))
+            == traits_type::eof() ) return i;
+        }
+        return n;
+      }
+
+      int sync() override {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        return myDest_->pubsync();
+      }
+  };
+
+  // Refreshes the status lines on a background thread at a fixed
+  // wall-clock interval. The event loop only needs to update an atomic
+  // counter, so progress reporting costs the same no matter how many
+  // events are generated (or by how many threads).
+  class StatusReporter {
+    public:
+      StatusReporter(StatusInserter& inserter, long num_events,
+        long num_old_events,
+        std::chrono::system_clock::time_point start_time_point,
+        const AsyncEventWriter& writer) : inserter_( inserter ),
+        num_events_( num_events ), num_old_events_( num_old_events ),
+        start_time_point_( start_time_point ), writer_( writer ),
+        ev_count_( num_old_events )
+      {
+        thread_ = std::thread( &StatusReporter::run, this );
+      }
+
+      ~StatusReporter() { stop(); }
+
+      // Sets the number of events completed so far
+      inline void set_event_count( long ev_count )
+        { ev_count_.store( ev_count, std::memory_order_relaxed ); }
+
+      // Stops the background thread after drawing the status lines one
+      // last time
+      void stop() {
+        if ( !thread_.joinable() ) return;
+        {
+          std::lock_guard<std::mutex> lock( mutex_ );
+          stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+      }
+
+    protected:
+
+      void run() {
+        std::unique_lock<std::mutex> lock( mutex_ );
+        bool done = false;
+        while ( !done ) {
+          done = cv_.wait_for( lock, STATUS_REFRESH_PERIOD,
+            [this]() -> bool { return stop_; } );
+          lock.unlock();
+          // Nothing is shown until the first event has been completed
+          long ev_count = ev_count_.load( std::memory_order_relaxed );
+          if ( ev_count > num_old_events_ ) {
+            inserter_.set_status( makeStatusLines(ev_count, num_events_,
+              num_old_events_, start_time_point_, writer_) );
           }
-          retval = myDest_->sputc( ch );
+          lock.lock();
         }
-        return retval;
       }
+
+      StatusInserter& inserter_;
+      long num_events_;
+      long num_old_events_;
+      std::chrono::system_clock::time_point start_time_point_;
+      const AsyncEventWriter& writer_;
+
+      // Number of events completed so far
+      std::atomic<long> ev_count_;
+
+      std::thread thread_;
+      std::mutex mutex_;
+      std::condition_variable cv_;
+      bool stop_ = false;
   };
 
+  // Calls a function on a new thread that is pinned to the CPU assigned to
+  // a thread index, so that any memory the function touches first is placed
+  // on that CPU's NUMA node. Without pinning, the function is called
+  // directly. Any exception thrown by the function is rethrown.
+  template <typename Function> void run_pinned(
+    const marley::ThreadAffinity& affinity, size_t thread, Function f )
+  {
+    if ( affinity.policy() == marley::ThreadAffinity::Policy::None ) {
+      f();
+      return;
+    }
+
+    std::exception_ptr error;
+    std::thread th( [&]() -> void {
+      affinity.pin_current_thread( thread );
+      try { f(); }
+      catch ( ... ) { error = std::current_exception(); }
+    } );
+    th.join();
+    if ( error ) std::rethrow_exception( error );
+  }
+
 }
 
 int main(int argc, char* argv[]) {
@@ -266,6 +971,15 @@ int main(int argc, char* argv[]) {
     // (https://github.com/jarro2783/cxxopts)
     std::string config_file_name;
 
+    // Describes the part of a sharded production (if any) handled by
+    // this job
+    ShardSettings shard;
+
+    // Path of the socket used to serve events to other processes. If this
+    // is not empty, then the executable runs as a long-lived event server
+    // rather than writing events to files.
+    std::string server_socket;
+
     // If the user has not supplied any command-line
     // arguments, display the standard help message
     // and exit
@@ -289,6 +1003,37 @@ int main(int argc, char* argv[]) {
       else if (option == "-v" || option == "--version") {
         print_version();
       }
+      else if (option == "--compile-data") {
+        compile_data_files();
+      }
+      else if (option == "--serve") {
+        if (argc != 4) {
+          std::cout << argv[0] << ": the option '" << option << "' must be"
+            << " followed by the socket path and the configuration file"
+            << " name\n";
+          print_help(argv[0]);
+        }
+        server_socket = argv[2];
+        config_file_name = argv[3];
+      }
+      else if (option == "--shard" || option == "--merge") {
+        if (argc != 4) {
+          std::cout << argv[0] << ": the option '" << option << "' must be"
+            << " followed by a value and the configuration file name\n";
+          print_help(argv[0]);
+        }
+        if (option == "--shard") shard = parse_shard_option(argv[2]);
+        else {
+          shard.mode = ShardSettings::Mode::MERGE;
+          shard.count = parse_shard_number(argv[2], "number of shards");
+        }
+        if (shard.count < 1 || shard.index >= shard.count) {
+          throw marley::Error("Invalid shard " + std::to_string(shard.index)
+            + " requested for a production split into "
+            + std::to_string(shard.count) + " shards");
+        }
+        config_file_name = argv[3];
+      }
       else if (option == "--marley") {
         std::cout << marley_utils::marley_pic;
         exit(0);
@@ -301,6 +1046,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Parse the objects from the JSON-based configuration file
+    auto config_start = std::chrono::steady_clock::now();
     marley::JSON json = marley::JSON::load_file(config_file_name);
 
     // Process them to get the generator configuration. Enable ROOT support if
@@ -311,6 +1057,11 @@ int main(int argc, char* argv[]) {
       marley::JSONConfig jc(json);
     #endif
 
+    std::chrono::duration<double> config_time
+      = std::chrono::steady_clock::now() - config_start;
+    marley::StartupProfile::Instance().record( "job configuration",
+      config_time.count() );
+
     // Get the time that the program was started
     std::chrono::system_clock::time_point start_time_point
       = std::chrono::system_clock::now();
@@ -330,9 +1081,30 @@ int main(int argc, char* argv[]) {
     // if we're doing a continuation run.
     long num_events = ex_set.get_long("events", 1e3);
 
-    // Update the status messages at the bottom of the screen
-    // after this many events have been generated. The user may
-    // set a non-default value from the job configuration file.
+    // When the production is split into shards, this job generates a
+    // contiguous range of the requested events. Each shard writes to its own
+    // output files, which have the shard index inserted into their names.
+    bool generating_shard = ( shard.mode == ShardSettings::Mode::GENERATE );
+    bool merging_shards = ( shard.mode == ShardSettings::Mode::MERGE );
+    long shard_offset = 0;
+    auto shard_name = [&]( const std::string& name ) -> std::string {
+      if ( !generating_shard ) return name;
+      return shard_file_name( name, shard.index );
+    };
+
+    if ( generating_shard ) {
+      shard_offset = num_events * shard.index / shard.count;
+      num_events = num_events * ( shard.index + 1 ) / shard.count
+        - shard_offset;
+      MARLEY_LOG_INFO() << "Generating shard " << shard.index << " of "
+        << shard.count << " (events " << shard_offset + 1 << " through "
+        << shard_offset + num_events << ')';
+    }
+
+    // Refresh the amount of data written to each output file (as shown
+    // in the status lines at the bottom of the screen) after this many
+    // events have been generated. The user may set a non-default value
+    // from the job configuration file.
     int status_update_interval = DEFAULT_STATUS_UPDATE_INTERVAL;
     if ( ex_set.has_key("status_update_interval") ) {
       const auto& sui = ex_set.at( "status_update_interval" );
@@ -349,9 +1121,218 @@ int main(int argc, char* argv[]) {
       else status_update_interval = sui_value;
     }
 
+    // Number of threads to use for event generation. Each thread owns an
+    // independent Generator object built from the same job configuration.
+    int num_threads = 1;
+    if ( ex_set.has_key("threads") ) {
+      const auto& thr = ex_set.at( "threads" );
+
+      bool ok;
+      int thr_value = thr.to_long( ok );
+
+      // Check for settings that are not positive integers
+      if ( !ok || thr_value < 1 ) {
+        throw marley::Error( "Invalid value " + thr.dump_string()
+          + " given for the \"threads\" key in the job configuration file" );
+      }
+      else num_threads = thr_value;
+    }
+
+    // If requested, split event generation into two stages. One thread
+    // creates the primary interactions, and the remaining threads apply the
+    // nuclear de-excitations to whichever events are waiting.
+    bool pipeline = false;
+    if ( ex_set.has_key("pipeline") ) {
+      const auto& pl = ex_set.at( "pipeline" );
+      bool ok;
+      pipeline = pl.to_bool( ok );
+      if ( !ok ) throw marley::Error( "Invalid value " + pl.dump_string()
+        + " given for the \"pipeline\" key in the job configuration file" );
+    }
+
+    // If requested, pin the event generation threads to particular CPUs so
+    // that the memory each one fills first stays on its own NUMA node
+    auto affinity_policy = marley::ThreadAffinity::Policy::None;
+    if ( ex_set.has_key("thread_affinity") ) {
+      const auto& ta = ex_set.at( "thread_affinity" );
+      bool ok;
+      std::string ta_name = ta.to_string( ok );
+      if ( !ok ) throw marley::Error( "Invalid value " + ta.dump_string()
+        + " given for the \"thread_affinity\" key in the job configuration"
+        " file" );
+      affinity_policy = marley::ThreadAffinity::policy_from_string( ta_name );
+    }
+
+    // If requested, give the threads on each NUMA node their own copy of the
+    // shared nuclear structure data
+    bool replicate_structure = false;
+    if ( ex_set.has_key("replicate_structure") ) {
+      const auto& rs = ex_set.at( "replicate_structure" );
+      bool ok;
+      replicate_structure = rs.to_bool( ok );
+      if ( !ok ) throw marley::Error( "Invalid value " + rs.dump_string()
+        + " given for the \"replicate_structure\" key in the job"
+        " configuration file" );
+      if ( replicate_structure && affinity_policy
+        == marley::ThreadAffinity::Policy::None )
+      {
+        throw marley::Error( "The \"replicate_structure\" setting requires"
+          " a \"thread_affinity\" policy other than \"none\"" );
+      }
+    }
+
+    // If requested, collect timing statistics for the steps of event
+    // generation and write them to a JSON file at the end of the run
+    std::string instrumentation_file;
+    if ( ex_set.has_key("instrumentation_file") ) {
+      const auto& inf = ex_set.at( "instrumentation_file" );
+      bool ok;
+      instrumentation_file = shard_name( inf.to_string(ok) );
+      if ( !ok || instrumentation_file.empty() ) {
+        throw marley::Error( "Invalid value " + inf.dump_string()
+          + " given for the \"instrumentation_file\" key in the job"
+          " configuration file" );
+      }
+      marley::Instrumentation::enable( true );
+    }
+
+    // If MARLEY was built with tracing zones, events whose de-excitation
+    // takes longer than this many milliseconds are tagged on the timeline
+    // with the nuclear states that they visited
+    if ( ex_set.has_key("trace_slow_event_ms") ) {
+      const auto& tse = ex_set.at( "trace_slow_event_ms" );
+      bool ok;
+      double threshold = tse.to_double( ok );
+      if ( !ok || threshold < 0. ) throw marley::Error( "Invalid value "
+        + tse.dump_string() + " given for the \"trace_slow_event_ms\" key"
+        " in the job configuration file" );
+      if ( !marley::Tracing::compiled_in() ) {
+        MARLEY_LOG_WARNING() << "MARLEY was built without tracing zones,"
+          << " so the \"trace_slow_event_ms\" setting will be ignored";
+      }
+      marley::Tracing::set_slow_event_threshold( threshold * 1e-3 );
+    }
+
+    // If requested, write a summary of the memory held by the nuclear
+    // structure data for each thread to a JSON file at the end of the run
+    std::string memory_report_file;
+    if ( ex_set.has_key("memory_report_file") ) {
+      const auto& mrf = ex_set.at( "memory_report_file" );
+      bool ok;
+      memory_report_file = shard_name( mrf.to_string(ok) );
+      if ( !ok || memory_report_file.empty() ) {
+        throw marley::Error( "Invalid value " + mrf.dump_string()
+          + " given for the \"memory_report_file\" key in the job"
+          " configuration file" );
+      }
+    }
+
+    // If requested, fill the caches used by the nuclear de-excitation step
+    // before the first event is generated. Either a boolean or the number
+    // of threads to use for the model tables (zero means one per hardware
+    // thread) may be given.
+    bool prewarm = false;
+    long prewarm_threads = 0;
+    if ( ex_set.has_key("prewarm") ) {
+      const auto& pw = ex_set.at( "prewarm" );
+      bool ok = true;
+      if ( pw.is_bool() ) prewarm = pw.to_bool();
+      else {
+        prewarm = true;
+        prewarm_threads = pw.to_long( ok );
+      }
+      if ( !ok || prewarm_threads < 0 ) throw marley::Error( "Invalid value "
+        + pw.dump_string() + " given for the \"prewarm\" key in the job"
+        " configuration file" );
+    }
+
+    // If requested, fill histograms of event observables as the events are
+    // generated and write them to a JSON file at the end of the run
+    std::string histogram_file;
+    std::unique_ptr<marley::EventHistograms> histogram_template;
+    if ( ex_set.has_key("histograms") ) {
+      const auto& hs = ex_set.at( "histograms" );
+      bool ok = hs.is_object() && hs.has_key( "file" )
+        && hs.has_key( "definitions" );
+      if ( ok ) histogram_file = shard_name( hs.at("file").to_string(ok) );
+      if ( !ok || histogram_file.empty() ) {
+        throw marley::Error( "Invalid value " + hs.dump_string()
+          + " given for the \"histograms\" key in the job configuration"
+          " file" );
+      }
+      histogram_template = std::make_unique<marley::EventHistograms>(
+        hs.at("definitions") );
+    }
+
+    // If requested, periodically save checkpoints that allow the run to be
+    // continued if it is killed before it finishes
+    std::string checkpoint_file;
+    long checkpoint_events = 0;
+    double checkpoint_seconds = 0.;
+    if ( ex_set.has_key("checkpoint") ) {
+      const auto& cps = ex_set.at( "checkpoint" );
+      bool ok = cps.is_object() && cps.has_key( "file" );
+      if ( ok ) checkpoint_file = shard_name( cps.at("file").to_string(ok) );
+      if ( ok && cps.has_key("events") ) {
+        checkpoint_events = cps.at( "events" ).to_long( ok );
+        if ( checkpoint_events < 0 ) ok = false;
+      }
+      if ( ok && cps.has_key("seconds") ) {
+        checkpoint_seconds = cps.at( "seconds" ).to_double( ok );
+        if ( checkpoint_seconds < 0. ) ok = false;
+      }
+      if ( !ok || checkpoint_file.empty() || ( checkpoint_events == 0
+        && checkpoint_seconds == 0. ) )
+      {
+        throw marley::Error( "Invalid value " + cps.dump_string()
+          + " given for the \"checkpoint\" key in the job configuration"
+          " file" );
+      }
+    }
+
+    // Merging is quick enough that checkpoints are not needed, and an event
+    // server does not write any output files
+    bool serving = !server_socket.empty();
+    if ( merging_shards || serving ) checkpoint_file.clear();
+
+    // If a previous attempt at this job left a checkpoint behind, continue
+    // from it
+    marley::JSON checkpoint_state;
+    bool restarting = false;
+    if ( !checkpoint_file.empty()
+      && std::ifstream(checkpoint_file).good() )
+    {
+      checkpoint_state = marley::JSON::load_file( checkpoint_file );
+      if ( !checkpoint_state.has_key("config")
+        || checkpoint_state.at("config").dump_string() != json.dump_string() )
+      {
+        throw marley::Error( "The checkpoint file " + checkpoint_file
+          + " was written using a different job configuration. Remove it"
+          " to start a new run." );
+      }
+      if ( checkpoint_state.at("generator_states").size() != num_threads ) {
+        throw marley::Error( "The checkpoint file " + checkpoint_file
+          + " was written by a run that used a different number of"
+          " threads" );
+      }
+      num_old_events = checkpoint_state.at( "event_count" ).to_long();
+      restarting = true;
+      MARLEY_LOG_INFO() << "Continuing the run from the checkpoint saved"
+        << " after " << num_old_events << " events in " << checkpoint_file;
+    }
+
     std::vector<std::unique_ptr<marley::OutputFile> > output_files;
 
-    if ( ex_set.has_key("output") ) {
+    // Output files that should be accompanied by an event index file
+    std::vector<marley::OutputFile*> indexed_files;
+
+    // Name of the first output file whose shards can be read back when
+    // merging a sharded production
+    std::string merge_source;
+
+    // An event server sends its events over a socket instead
+    if ( serving ) {}
+    else if ( ex_set.has_key("output") ) {
       marley::JSON output_set = ex_set.at("output");
       if (!output_set.is_array()) throw marley::Error("The"
         " \"output\" key in the executable settings must have a value that"
@@ -365,9 +1346,79 @@ int main(int argc, char* argv[]) {
         std::string filename = el.at("file").to_string();
         std::string format = el.at("format").to_string();
 
+        // Binary files may use a minimal layout that keeps only the
+        // kinematics of the final particles
+        auto binary_layout = marley::BinaryEventBlock::Layout::event;
+        if (format == "binary" && el.has_key("layout")) {
+          std::string layout = el.at("layout").to_string();
+          if (layout == "kinematics") binary_layout
+            = marley::BinaryEventBlock::Layout::kinematics;
+          else if (layout != "event") throw marley::Error("Invalid"
+            " layout \"" + layout + "\" requested for the binary output"
+            " file \"" + filename + '\"');
+        }
+        bool kinematics_only = ( binary_layout
+          == marley::BinaryEventBlock::Layout::kinematics );
+
+        // The binary, HDF5, and ROOT formats may store the particle
+        // kinematics in single precision to reduce the size of the output
+        bool single_precision = false;
+        if (el.has_key("precision")) {
+          std::string precision = el.at("precision").to_string();
+          if (precision == "single") single_precision = true;
+          else if (precision != "double") throw marley::Error("Invalid"
+            " precision \"" + precision + "\" requested for the output"
+            " file \"" + filename + '\"');
+          if (single_precision && format != "binary" && format != "hdf5"
+            && format != "root") throw marley::Error("Single precision is"
+            " not supported for the \"" + format + "\" format requested for"
+            " the output file \"" + filename + '\"');
+        }
+        auto binary_precision = single_precision
+          ? marley::BinaryEventBlock::Precision::single
+          : marley::BinaryEventBlock::Precision::full;
+
+        // Events may be split among a numbered sequence of files, starting
+        // a new one after a given number of events or bytes (zero disables
+        // either limit)
+        auto get_rotation_limit = [&el, &filename](const std::string& key)
+          -> long
+        {
+          if (!el.has_key(key)) return 0;
+          bool ok = false;
+          const marley::JSON& value = el.at(key);
+          long limit = value.to_long(ok);
+          if (!ok || limit < 0) throw marley::Error("Invalid value "
+            + value.dump_string() + " given for the \"" + key + "\" key"
+            " for the output file \"" + filename + '\"');
+          return limit;
+        };
+        long rotate_events = get_rotation_limit("rotate_events");
+        int_fast64_t rotate_bytes = get_rotation_limit("rotate_bytes");
+        bool rotating = ( rotate_events > 0 || rotate_bytes > 0 );
+
+        #ifdef USE_ROOT
+          bool readable = ( format != "hdf5" && !kinematics_only );
+        #else
+          bool readable = ( format != "hdf5" && format != "root"
+            && !kinematics_only );
+        #endif
+        if ( readable && !rotating && merge_source.empty() ) {
+          merge_source = filename;
+        }
+        filename = shard_name( filename );
+
         std::string mode("overwrite"); // default mode is "overwrite"
         if (el.has_key("mode")) mode = el.at("mode").to_string();
 
+        if (rotating && mode != "overwrite") throw marley::Error("The output"
+          " mode \"" + mode + "\" cannot be used for the rotating output"
+          " file \"" + filename + '\"');
+
+        // When continuing from a checkpoint, every file is truncated to its
+        // size at the time the checkpoint was taken
+        if (restarting) mode = "restart";
+
         bool force = true; // default behavior is to prompt before overwriting
         if (el.has_key("force")) force = el.at("force").to_bool();
 	force = true;
@@ -388,22 +1439,146 @@ int main(int argc, char* argv[]) {
           }
         }
 
+        // Set the compression algorithm and level (if any) for text
+        // output formats
+        std::string compression("none"); // default is no compression
+        if (el.has_key("compression")) {
+          compression = el.at("compression").to_string();
+          if (compression != "none" && format == "binary")
+            throw marley::Error("Compression is not"
+            " supported for the \"" + format + "\" format requested for"
+            " the output file \"" + filename + '\"');
+        }
+
+        bool index = false; // by default, no index file is written
+        if (el.has_key("index")) index = el.at("index").to_bool();
+
+        int compression_level = 0; // zero selects the default level
+        if (el.has_key("compression_level")) {
+          bool ok = false;
+          const marley::JSON& lvl = el.at("compression_level");
+          compression_level = static_cast<int>(lvl.to_long(ok));
+          if (!ok) throw marley::Error("Invalid compression level \""
+            + lvl.dump_string() + "\" for the output file \""
+            + filename + '\"');
+        }
+
+        if (index && kinematics_only) throw marley::Error("Index files"
+          " cannot be written for the binary output file \"" + filename
+          + "\", which uses the kinematics layout");
+
+        if (index && rotating) throw marley::Error("Index files cannot be"
+          " written for the rotating output file \"" + filename + '\"');
+
         #ifdef USE_ROOT
-          if (format == "root") output_files.push_back(
-            std::make_unique<marley::RootOutputFile>(filename, format, mode, force));
-          else output_files.push_back(std::make_unique<marley::TextOutputFile>(
-            filename, format, mode, force, indent));
-        #else
-          output_files.push_back(std::make_unique<marley::TextOutputFile>(filename,
-            format, mode, force, indent));
+          marley::RootTreeSettings tree_settings;
+          if (format == "root") {
+            if (el.has_key("compression")) {
+              tree_settings.compression = compression;
+              tree_settings.compression_level = compression_level;
+            }
+
+            if (el.has_key("layout")) {
+              std::string layout = el.at("layout").to_string();
+              if (layout == "summary") tree_settings.summary = true;
+              else if (layout != "event") throw marley::Error("Invalid"
+                " layout \"" + layout + "\" requested for the ROOT output"
+                " file \"" + filename + '\"');
+            }
+
+            if (single_precision && !tree_settings.summary) throw
+              marley::Error("Single precision requires the summary layout"
+              " for the ROOT output file \"" + filename + '\"');
+            tree_settings.single_precision = single_precision;
+
+            // Reads an optional integer setting for the event tree
+            auto get_tree_setting = [&el, &filename](const std::string& key,
+              long default_value) -> long
+            {
+              if (!el.has_key(key)) return default_value;
+              bool ok = false;
+              const marley::JSON& value = el.at(key);
+              long result = value.to_long(ok);
+              if (!ok) throw marley::Error("Invalid value "
+                + value.dump_string() + " given for the \"" + key
+                + "\" key for the output file \"" + filename + '\"');
+              return result;
+            };
+
+            tree_settings.basket_size = static_cast<int>( get_tree_setting(
+              "basket_size", tree_settings.basket_size) );
+            tree_settings.split_level = static_cast<int>( get_tree_setting(
+              "split_level", tree_settings.split_level) );
+            tree_settings.auto_flush = get_tree_setting("auto_flush",
+              tree_settings.auto_flush);
+
+            if (tree_settings.basket_size <= 0) throw marley::Error("The"
+              " basket size for the ROOT output file \"" + filename
+              + "\" must be positive");
+          }
         #endif
+
+        // Opens the output file (or one part of a rotating output file)
+        // with a given name
+        auto open_file = [=](const std::string& name)
+          -> std::unique_ptr<marley::OutputFile>
+        {
+          if (format == "binary") return std::make_unique<
+            marley::BinaryOutputFile>(name, format, mode, force,
+            binary_layout, binary_precision);
+          else if (format == "hdf5") return std::make_unique<
+            marley::HDF5OutputFile>(name, format, mode, force, compression,
+            compression_level, single_precision);
+          #ifdef USE_ROOT
+            else if (format == "root") return std::make_unique<
+              marley::RootOutputFile>(name, format, mode, force,
+              tree_settings);
+          #endif
+          return std::make_unique<marley::TextOutputFile>(name, format, mode,
+            force, indent, compression, compression_level);
+        };
+
+        if (rotating) output_files.push_back(
+          std::make_unique<marley::RotatingOutputFile>(filename, format,
+          rotate_events, rotate_bytes, open_file));
+        else output_files.push_back(open_file(filename));
+
+        if (index) indexed_files.push_back(output_files.back().get());
       }
     }
     else {
       // If the user didn't specify anything for the output key, then
       // by default write to a single ASCII-format file.
-      output_files.push_back(std::make_unique<marley::TextOutputFile>("events.ascii",
-        "ascii", "overwrite", false));
+      merge_source = "events.ascii";
+      output_files.push_back(std::make_unique<marley::TextOutputFile>(
+        shard_name("events.ascii"), "ascii",
+        restarting ? "restart" : "overwrite", false));
+    }
+
+    // Save the job configuration with each completed part of a rotating
+    // output file
+    for (auto& file : output_files) {
+      auto* rf = dynamic_cast<marley::RotatingOutputFile*>(file.get());
+      if (rf) rf->set_config(json);
+    }
+
+    // Continue each output file from the checkpoint (if any)
+    for (unsigned f = 0u; f < output_files.size(); ++f) {
+      auto& file = output_files[f];
+      if (!checkpoint_file.empty() && !file->supports_checkpoints()) {
+        throw marley::Error("Checkpoints are not supported for the format"
+          " requested for the output file \"" + file->name() + '\"');
+      }
+      if (!restarting) continue;
+
+      const auto& saved_files = checkpoint_state.at("output");
+      if (f >= static_cast<unsigned>(saved_files.size())
+        || saved_files.at(f).at("file").to_string() != file->name())
+      {
+        throw marley::Error("The output file \"" + file->name() + "\" was"
+          " not found in the checkpoint file " + checkpoint_file);
+      }
+      file->restart(saved_files.at(f).at("state"));
     }
 
     // This std::unique_ptr to a Generator object will be initialized below
@@ -426,11 +1601,213 @@ int main(int argc, char* argv[]) {
       }
     }
 
+    // The saved generator state can only be used to continue a
+    // single-threaded run
+    if ( need_to_resume && num_threads > 1 ) throw marley::Error("Resuming a"
+      " previous run is not supported when more than one thread is requested"
+      " via the \"threads\" key.");
+
     // If we didn't resume a run from any of the files, use the current
     // configuration
     if (!need_to_resume) gen = std::make_unique<marley::Generator>(
       jc.create_generator());
 
+    // When continuing from a checkpoint, restore the seed and random number
+    // engine state saved for a given thread
+    auto restore_checkpoint_state = [&]( marley::Generator& tg, unsigned t )
+      -> void
+    {
+      if ( !restarting ) return;
+      std::string seed = checkpoint_state.at( "seeds" ).at( t ).to_string();
+      tg.reseed( std::stoull(seed) );
+      tg.seed_using_state_string( checkpoint_state.at( "generator_states" )
+        .at( t ).to_string() );
+    };
+    restore_checkpoint_state( *gen, 0u );
+
+    // Each shard of a production draws its events from a different part of
+    // the random number sequence. With the counter-based engine, the events
+    // keep the numbers that they would have in an unsharded run, so the
+    // merged output is identical to that of a single job. Otherwise, each
+    // shard (and the merged output, should it be resumed later) uses its own
+    // range of seeds.
+    bool counter_based = gen->counter_based_rng();
+
+    if ( pipeline ) {
+      if ( num_threads < 2 ) throw marley::Error( "The \"pipeline\" mode"
+        " requires at least two threads" );
+      if ( !counter_based ) throw marley::Error( "The \"pipeline\" mode"
+        " requires the counter-based random number engine (see the"
+        " \"random_engine\" key)" );
+      if ( !checkpoint_file.empty() ) throw marley::Error( "Checkpoints are"
+        " not supported in \"pipeline\" mode" );
+    }
+    if ( histogram_template && !checkpoint_file.empty() ) {
+      throw marley::Error( "Checkpoints are not supported together with the"
+        " \"histograms\" key" );
+    }
+    if ( !restarting && !need_to_resume ) {
+      if ( generating_shard ) {
+        if ( counter_based ) gen->set_event_number( shard_offset );
+        else gen->reseed( gen->get_seed()
+          + static_cast<uint_fast64_t>(shard.index) * num_threads );
+      }
+      else if ( merging_shards && !counter_based ) {
+        gen->reseed( gen->get_seed()
+          + static_cast<uint_fast64_t>(shard.count) * num_threads );
+      }
+    }
+
+    // Now that the generator settings are known, start any requested index
+    // files
+    for (auto* file : indexed_files) file->enable_index(*gen);
+
+    // Combine the output files written by the shards of a production rather
+    // than generating new events
+    if ( merging_shards ) {
+      if ( merge_source.empty() ) throw marley::Error("None of the output"
+        " files requested in the job configuration file can be read back to"
+        " merge the shards of a production");
+
+      long total_events = merge_shards( merge_source, shard.count,
+        output_files, *gen );
+      if ( total_events != num_events ) {
+        MARLEY_LOG_WARNING() << "The merged shards contain " << total_events
+          << " events, but " << num_events << " were requested in the job"
+          << " configuration file";
+      }
+
+      // A resumed run will continue after the last merged event
+      if ( counter_based ) gen->set_event_number( total_events );
+
+      for (const auto& file : output_files) {
+        file->close(json, *gen, total_events);
+        std::cout << "Data written to " << file->name() << ' '
+          << marley_utils::num_bytes_to_string(file->bytes_written())
+          << '\n';
+      }
+      return 0;
+    }
+
+    // Create additional Generator objects for the worker threads (if any).
+    // When the counter-based random number engine is in use, every event is
+    // drawn from its own subsequence, so the workers share the seed of the
+    // main Generator and the output is independent of the number of threads.
+    // Otherwise, each worker is reseeded deterministically based on the seed
+    // used by the main Generator so that multi-threaded runs are reproducible.
+    // All threads share the StructureDatabase of the main Generator, which
+    // loads each nuclide's data only once and splits any memory budget
+    // equally among them. Any models that have already been built are kept
+    // for use by the main Generator. If structure replication was requested,
+    // the threads on each NUMA node other than that of the main Generator
+    // share a separate StructureDatabase instead (with its own memory
+    // budget). Each worker is built on a thread pinned to its own CPU so that
+    // its data are placed on the local node.
+    marley::ThreadAffinity affinity( num_threads > 1 ? affinity_policy
+      : marley::ThreadAffinity::Policy::None );
+    if ( replicate_structure && affinity.num_nodes() < 2u ) {
+      replicate_structure = false;
+    }
+
+    // Building the exit channels in parallel also requires concurrent mode
+    auto shared_sdb = gen->get_shared_structure_db();
+    if ( num_threads > 1 || shared_sdb->get_parallel_exit_channels() ) {
+      marley::StructureDatabase::WorkerScope main_worker( gen.get() );
+      shared_sdb->set_concurrent( true );
+    }
+
+    std::map< size_t, std::shared_ptr<marley::StructureDatabase> > node_sdbs;
+    node_sdbs[ affinity.node_for_thread(0u) ] = shared_sdb;
+
+    std::vector< std::unique_ptr<marley::Generator> > worker_gens;
+    for ( int t = 1; t < num_threads; ++t ) {
+      auto sdb = shared_sdb;
+      if ( replicate_structure ) sdb = node_sdbs[ affinity.node_for_thread(t) ];
+
+      run_pinned( affinity, t, [&]() -> void {
+        if ( sdb ) {
+          worker_gens.push_back( std::make_unique<marley::Generator>(
+            jc.create_generator(sdb)) );
+          return;
+        }
+        // The first worker on this node loads a new replica of the
+        // structure data
+        worker_gens.push_back( std::make_unique<marley::Generator>(
+          jc.create_generator()) );
+        sdb = worker_gens.back()->get_shared_structure_db();
+        marley::StructureDatabase::WorkerScope worker(
+          worker_gens.back().get() );
+        sdb->set_concurrent( true );
+      } );
+      if ( replicate_structure ) node_sdbs[ affinity.node_for_thread(t) ] = sdb;
+
+      if ( counter_based ) worker_gens.back()->reseed( gen->get_seed() );
+      else worker_gens.back()->reseed( gen->get_seed() + t );
+      restore_checkpoint_state( *worker_gens.back(), t );
+    }
+
+    if ( replicate_structure ) {
+      MARLEY_LOG_INFO() << "Using " << node_sdbs.size() << " copies of the"
+        << " nuclear structure data";
+    }
+
+    // Each Generator keeps its own cache of Hauser-Feshbach decays, so the
+    // worker Generators fill theirs on separate threads once the shared
+    // model tables are ready. Replicas of the structure data receive their
+    // own copies of the tables.
+    if ( prewarm ) {
+      marley::StartupProfile::Timer timer( "cache prewarming" );
+      gen->prewarm( static_cast<unsigned>(prewarm_threads) );
+
+      for ( const auto& pair : node_sdbs ) {
+        if ( pair.second == shared_sdb ) continue;
+        const auto& replica = pair.second;
+        std::thread th( [&]() -> void {
+          affinity.pin_current_thread_to_node( pair.first );
+          replica->copy_model_tables( *shared_sdb );
+        } );
+        th.join();
+      }
+
+      std::vector<std::exception_ptr> errors( worker_gens.size() );
+      std::vector<std::thread> threads;
+      for ( size_t w = 0u; w < worker_gens.size(); ++w ) {
+        threads.emplace_back( [w, &affinity, &worker_gens, &errors]() -> void
+        {
+          affinity.pin_current_thread( w + 1u );
+          try { worker_gens[ w ]->prewarm_decays(); }
+          catch ( ... ) { errors[ w ] = std::current_exception(); }
+        } );
+      }
+      for ( auto& th : threads ) th.join();
+      for ( const auto& e : errors ) if ( e ) std::rethrow_exception( e );
+    }
+
+    // Serve events to other processes until the user interrupts execution.
+    // Each thread's Generator serves one request at a time.
+    if ( serving ) {
+      std::vector< std::unique_ptr<marley::Generator> > server_gens;
+      server_gens.push_back( std::move(gen) );
+      for ( auto& wg : worker_gens ) server_gens.push_back( std::move(wg) );
+
+      marley::EventServer server( std::move(server_gens), server_socket );
+      std::signal( SIGINT, signal_handler );
+      std::signal( SIGTERM, signal_handler );
+      server.run( []() -> bool { return !interrupted; } );
+
+      MARLEY_LOG_INFO() << "Served " << server.requests_served()
+        << " requests";
+      return 0;
+    }
+
+    std::vector<marley::Generator*> thread_gens = { gen.get() };
+    for ( auto& wg : worker_gens ) thread_gens.push_back( wg.get() );
+
+    // Report where the time before event generation was spent
+    std::ostringstream startup_report;
+    marley::StartupProfile::Instance().report( startup_report );
+    MARLEY_LOG_INFO() << startup_report.str();
+
     // Use the signal handler defined above to deal with
     // SIGINT signals (e.g., ctrl+c interruptions initiated
     // by the user). This will allow us to terminate the
@@ -442,11 +1819,17 @@ int main(int argc, char* argv[]) {
     auto event = std::make_unique<marley::Event>();
     long ev_count = 1 + num_old_events;
 
+    // Completed events are handed off to background threads that write
+    // them to the output files
+    bool async_output = std::thread::hardware_concurrency() != 1u;
+    // In "pipeline" mode, the generator is in use by another thread when
+    // each event is written
+    AsyncEventWriter writer( output_files, status_update_interval,
+      async_output, pipeline ? nullptr : gen.get(), *gen );
+
     // Make std::cout use our "status inserter" std::streambuf
-    // object so that the status lines get automatically updated
-    // with every newline
-    StatusInserter my_status_inserter(cout_default_buf, ev_count,
-      num_events, num_old_events, start_time_point, output_files);
+    // object so that the status lines stay below any other output
+    StatusInserter my_status_inserter( cout_default_buf );
     std::cout.rdbuf( &my_status_inserter );
     std::cerr.rdbuf( &my_status_inserter );
 
@@ -466,33 +1849,306 @@ int main(int argc, char* argv[]) {
     start_time_point = std::chrono::system_clock::now();
     start_time = std::chrono::system_clock::to_time_t( start_time_point );
 
-    for (; ev_count <= num_events && !interrupted; ++ev_count) {
+    // Show the progress of the simulation in status lines at the bottom
+    // of the screen
+    StatusReporter reporter( my_status_inserter, num_events, num_old_events,
+      start_time_point, writer );
 
-      // Create an event using the generator object
-      *event = gen->create_event();
+    Checkpointer checkpointer( checkpoint_file, checkpoint_events,
+      checkpoint_seconds, num_old_events );
 
-      for (const auto& file : output_files) {
-        file->write_event(event.get());
+    // Each thread fills its own copy of the histograms (if any). The copies
+    // are merged at the end of the run.
+    std::vector<marley::EventHistograms> thread_hists;
+    if ( histogram_template ) thread_hists.assign( num_threads,
+      *histogram_template );
+    bool histogramming = !thread_hists.empty();
+
+    // Queues a completed event for output and records it in the status
+    // lines. The contents of the event are moved away.
+    auto record_event = [&]( marley::Event& ev ) {
+      writer.receive_event( ev );
+      reporter.set_event_count( ev_count );
+    };
+
+    if ( num_threads == 1 ) {
+      for (; ev_count <= num_events && !interrupted; ++ev_count) {
+
+        // Create an event using the generator object
+        gen->create_event( *event );
+        if ( histogramming ) thread_hists[ 0 ].fill( *event );
+
+        record_event( *event );
+
+        if ( checkpointer.due(ev_count) ) {
+          checkpointer.write( json, ev_count, thread_gens, writer );
+        }
+      }
+    }
+    else if ( pipeline ) {
+      // Events pass through a window of slots. Thread 0 creates the primary
+      // interaction for each event in order. The other threads take the
+      // oldest event that has not been claimed yet and de-excite it, so a
+      // few expensive decays do not hold up the remaining events. The main
+      // thread writes the finished events in order. Every event is finished
+      // using its own random numbers, so the output is independent of the
+      // scheduling and of the number of threads.
+      long window = ( num_threads - 1 ) * PIPELINE_EVENTS_PER_THREAD;
+      std::vector<marley::Event> slots( window );
+      std::vector<uint64_t> slot_event_nums( window );
+      std::vector<char> slot_done( window, false );
+
+      long first_event = ev_count;
+      long num_requested = num_events - ev_count + 1;
+      long num_primary = 0; // Events created by stage 1
+      long num_claimed = 0; // Events taken by a stage 2 thread
+      long num_written = 0; // Events handed to the writer
+      bool primary_done = false;
+      bool failed = false;
+      std::exception_ptr error;
+      std::mutex mutex;
+      std::condition_variable cv;
+
+      auto& logger = marley::Logger::Instance();
+      logger.set_async( true );
+
+      auto fail = [&]() -> void {
+        std::lock_guard<std::mutex> lock( mutex );
+        if ( !error ) error = std::current_exception();
+        failed = true;
+        cv.notify_all();
+      };
+
+      // Stage 1: primary interactions
+      std::thread primary_thread( [&]() -> void {
+        marley::Instrumentation::set_thread_label( "primary" );
+        affinity.pin_current_thread( 0u );
+        auto& tg = *thread_gens[ 0 ];
+        try {
+          for ( long k = 0; k < num_requested; ++k ) {
+            {
+              std::unique_lock<std::mutex> lock( mutex );
+              cv.wait( lock, [&]() -> bool
+                { return failed || k - num_written < window; } );
+              if ( failed || interrupted ) break;
+            }
+
+            // Nobody else touches a slot between its release by the writer
+            // and the update of num_primary below
+            long s = k % window;
+            slot_event_nums[ s ] = tg.create_primary_event( slots[ s ] );
+
+            std::lock_guard<std::mutex> lock( mutex );
+            num_primary = k + 1;
+            cv.notify_all();
+          }
+        }
+        catch ( ... ) { fail(); }
+
+        std::lock_guard<std::mutex> lock( mutex );
+        primary_done = true;
+        cv.notify_all();
+      } );
+
+      // Stage 2: de-excitations
+      std::vector<std::thread> workers;
+      for ( int t = 1; t < num_threads; ++t ) {
+        workers.emplace_back( [&, t]() -> void {
+          marley::Instrumentation::set_thread_label( "worker "
+            + std::to_string(t) );
+          affinity.pin_current_thread( t );
+          auto& tg = *thread_gens[ t ];
+          try {
+            for (;;) {
+              long k;
+              {
+                std::unique_lock<std::mutex> lock( mutex );
+                cv.wait( lock, [&]() -> bool { return failed
+                  || num_claimed < num_primary || primary_done; } );
+                if ( failed || num_claimed >= num_primary ) break;
+                k = num_claimed++;
+              }
+
+              long s = k % window;
+              tg.finish_event( slots[ s ], slot_event_nums[ s ] );
+              if ( histogramming ) thread_hists[ t ].fill( slots[ s ] );
+
+              std::lock_guard<std::mutex> lock( mutex );
+              slot_done[ s ] = true;
+              cv.notify_all();
+            }
+          }
+          catch ( ... ) { fail(); }
+        } );
       }
 
-      // Print status messages about simulation progress after every
-      // status_update_interval events have been generated
-      if ( (ev_count - num_old_events) % status_update_interval == 1
-        || ev_count == num_events || status_update_interval == 1 )
-      {
-        // Temporarily disable the auto-printing of the status lines by
-        // the StatusInserter class. This will avoid duplication of the
-        // information.
-        my_status_inserter.set_do_status( false );
+      // Reorder stage: write the finished events in order
+      for (;;) {
+        long s = num_written % window;
+        {
+          std::unique_lock<std::mutex> lock( mutex );
+          cv.wait( lock, [&]() -> bool { return failed || slot_done[ s ]
+            || ( primary_done && num_written >= num_primary ); } );
+          if ( failed || !slot_done[ s ] ) break;
+          slot_done[ s ] = false;
+        }
+
+        ev_count = first_event + num_written;
+        record_event( slots[ s ] );
+
+        std::lock_guard<std::mutex> lock( mutex );
+        ++num_written;
+        cv.notify_all();
+      }
+      ev_count = first_event + num_written;
+
+      primary_thread.join();
+      for ( auto& w : workers ) w.join();
+      logger.set_async( false );
+
+      if ( error ) std::rethrow_exception( error );
+    }
+    else {
+      // Events are generated in rounds. Within each round, the k-th event is
+      // produced by thread k % num_threads, and the events are written in
+      // order of k once all threads have finished. The contents of the output
+      // files are therefore independent of how the threads are scheduled.
+      std::vector< std::vector<marley::Event> > thread_events( num_threads );
+      std::vector< std::exception_ptr > thread_errors( num_threads );
+
+      // Let the worker threads hand their log messages to a background
+      // writer rather than waiting for each other to write them
+      auto& logger = marley::Logger::Instance();
+      logger.set_async( true );
+
+      while ( ev_count <= num_events && !interrupted ) {
+
+        long round_size = std::min( num_events - ev_count + 1,
+          num_threads * EVENTS_PER_THREAD_PER_ROUND );
+
+        // Zero-based index of the first event in this round
+        long first_event = ev_count - 1;
+
+        std::vector<std::thread> workers;
+        for ( int t = 0; t < num_threads; ++t ) {
+
+          long num_for_thread = round_size / num_threads
+            + ( t < round_size % num_threads ? 1 : 0 );
+
+          workers.emplace_back( [t, num_for_thread, first_event, num_threads,
+            counter_based, shard_offset, histogramming, &affinity,
+            &thread_gens, &thread_events, &thread_errors, &thread_hists]()
+            -> void
+          {
+            marley::Instrumentation::set_thread_label( "worker "
+              + std::to_string(t) );
+            affinity.pin_current_thread( t );
+
+            // The Event objects from the previous round are reused
+            auto& evs = thread_events[ t ];
+            auto& tg = *thread_gens[ t ];
+            try {
+              if ( !counter_based ) tg.create_events( num_for_thread, evs );
+              else {
+                evs.resize( num_for_thread );
+                for ( long i = 0; i < num_for_thread; ++i ) {
+                  tg.set_event_number( shard_offset + first_event + t
+                    + i*num_threads );
+                  tg.create_event( evs[ i ] );
+                }
+              }
+              if ( histogramming ) {
+                for ( const auto& ev : evs ) thread_hists[ t ].fill( ev );
+              }
+            }
+            catch ( ... ) {
+              thread_errors[ t ] = std::current_exception();
+            }
+          } );
+        }
+
+        for ( auto& w : workers ) w.join();
+
+        // Propagate any errors encountered by the worker threads
+        for ( const auto& err : thread_errors ) {
+          if ( err ) std::rethrow_exception( err );
+        }
 
-        // Print a status message showing the current number of events
-        std::cout << makeStatusLines(ev_count, num_events, num_old_events,
-          start_time_point, output_files);
+        // Write the events in a reproducible order. If the user interrupted
+        // execution during this round, the completed events are still kept.
+        for ( long k = 0; k < round_size; ++k, ++ev_count ) {
+          record_event( thread_events[ k % num_threads ][ k / num_threads ] );
+        }
+
+        // Checkpoints are only taken between rounds, so the rounds that
+        // follow a restart are the same as in an uninterrupted run
+        if ( checkpointer.due(ev_count - 1) ) {
+          checkpointer.write( json, ev_count - 1, thread_gens, writer );
+        }
+      }
+
+      logger.set_async( false );
+    }
+
+    // If the run was interrupted, save a final checkpoint so that it may be
+    // continued later
+    if ( interrupted && checkpointer.enabled() ) {
+      checkpointer.write( json, ev_count - 1, thread_gens, writer );
+    }
+
+    // Wait for the I/O threads to write any remaining events
+    writer.finish();
+
+    // Show the final status lines
+    reporter.stop();
 
-        // Re-enable the auto-printing of the status lines now that we've
-        // printed them manually
-        my_status_inserter.set_do_status( true );
+    if ( !instrumentation_file.empty() ) {
+      marley::Instrumentation::write_report( instrumentation_file );
+    }
+
+    // If an event filter was used, report the fraction of primary
+    // interactions that passed it. The filtered events correspond to this
+    // fraction of the flux-averaged total cross section.
+    if ( gen->has_event_filter() ) {
+      uint64_t trials = 0u;
+      uint64_t accepted = 0u;
+      double accepted_weight = 0.;
+      for ( const auto* tg : thread_gens ) {
+        trials += tg->filter_trials();
+        accepted += tg->filter_accepted();
+        accepted_weight += tg->filter_accepted_weight();
       }
+      double fraction = ( trials > 0u ) ? accepted_weight / trials : 1.;
+      MARLEY_LOG_INFO() << "The event filter accepted " << accepted
+        << " of " << trials << " primary interactions (weighted fraction "
+        << fraction << ')';
+      MARLEY_LOG_INFO() << "Flux-averaged total cross section for the"
+        << " filtered events: " << avg_tot_xs * fraction << " MeV^(-2)";
+    }
+
+    // Summarize the memory held by the nuclear structure data. The report
+    // for a shared StructureDatabase covers all of the threads that use it.
+    size_t structure_bytes = 0u;
+    marley::JSON memory_reports = marley::JSON::array();
+    std::set<const marley::StructureDatabase*> reported_sdbs;
+    for ( auto* tg : thread_gens ) {
+      const auto& sdb = tg->get_structure_db();
+      if ( !reported_sdbs.insert( &sdb ).second ) continue;
+      marley::JSON report = sdb.memory_report();
+      structure_bytes += report.at( "total_bytes" ).to_long();
+      memory_reports.append( report );
+    }
+    MARLEY_LOG_INFO() << "Nuclear structure data used "
+      << marley_utils::num_bytes_to_string( structure_bytes )
+      << " of memory";
+
+    if ( !memory_report_file.empty() ) {
+      std::ofstream mr_out( memory_report_file );
+      if ( !mr_out ) throw marley::Error( "Could not open the memory report"
+        " file \"" + memory_report_file + "\" for writing" );
+      marley::JSON memory_json = marley::JSON::object();
+      memory_json[ "threads" ] = memory_reports;
+      mr_out << memory_json.dump_string( 2 ) << '\n';
     }
 
     // Restore the default std::streambuf to std::cout
@@ -508,6 +2164,22 @@ int main(int argc, char* argv[]) {
         << "\033[K\n";
     }
 
+    if ( histogramming ) {
+      auto& hists = thread_hists.front();
+      for ( size_t t = 1u; t < thread_hists.size(); ++t ) {
+        hists.merge( thread_hists[ t ] );
+      }
+      hists.write( histogram_file, avg_tot_xs );
+      std::cout << "Histograms of " << hists.num_events() << " events"
+        << " written to " << histogram_file << "\033[K\n";
+    }
+
+    // Keep any tabulated model values for use in future runs
+    gen->get_structure_db().save_table_cache();
+
+    // A completed run will not need to be continued
+    if ( !interrupted ) checkpointer.remove();
+
     // Display the time that the program terminated
     std::chrono::system_clock::time_point end_time_point
       = std::chrono::system_clock::now();
@@ -0,0 +1,275 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+#include <array>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/marley_c.h"
+
+// The opaque handle used by the C interface
+struct marley_generator {
+
+  marley_generator( marley::Generator&& g ) : gen( std::move(g) ) {}
+
+  marley::Generator gen;
+
+  // Reused for every event so that no memory is allocated per event once
+  // the particle vectors have grown to their working size
+  marley::Event scratch;
+
+  // True if scratch holds an event that did not fit in the caller's
+  // buffers during the previous call to a generation function
+  bool pending = false;
+};
+
+namespace {
+
+  // Message for the most recent error on each thread
+  thread_local std::string last_error;
+
+  marley_status fail( marley_status status, const std::string& message ) {
+    last_error = message;
+    return status;
+  }
+
+  // Runs a function, converting any exception that it throws into a status
+  // code. C++ exceptions must not propagate into the caller's code.
+  template <typename Function> marley_status guarded( Function func ) {
+    try {
+      return func();
+    }
+    catch ( const std::exception& error ) {
+      return fail( MARLEY_ERROR, error.what() );
+    }
+    catch ( ... ) {
+      return fail( MARLEY_ERROR, "Unknown error" );
+    }
+  }
+
+  // Stores an event at the end of the caller's buffers. Returns false if
+  // there is not enough room left.
+  bool store_event( const marley::Event& ev, marley_event_buffers& buf ) {
+    size_t num_initial = ev.initial_particle_count();
+    size_t num_final = ev.final_particle_count();
+    if ( buf.num_events >= buf.event_capacity || num_initial + num_final
+      > buf.particle_capacity - buf.num_particles ) return false;
+
+    size_t e = buf.num_events;
+    if ( buf.Ex ) buf.Ex[ e ] = ev.Ex();
+    if ( buf.twoJ ) buf.twoJ[ e ] = ev.twoJ();
+    if ( buf.parity ) buf.parity[ e ] = static_cast<int>( ev.parity() );
+    if ( buf.weight ) buf.weight[ e ] = ev.weight();
+    if ( buf.time ) buf.time[ e ] = ev.time();
+    if ( buf.num_initial ) buf.num_initial[ e ] = num_initial;
+    if ( buf.num_final ) buf.num_final[ e ] = num_final;
+    if ( buf.first_particle ) buf.first_particle[ e ] = buf.num_particles;
+
+    auto store_particle = [&buf]( const marley::Particle& p ) -> void {
+      size_t i = buf.num_particles++;
+      if ( buf.pdg ) buf.pdg[ i ] = p.pdg_code();
+      if ( buf.E ) buf.E[ i ] = p.total_energy();
+      if ( buf.px ) buf.px[ i ] = p.px();
+      if ( buf.py ) buf.py[ i ] = p.py();
+      if ( buf.pz ) buf.pz[ i ] = p.pz();
+      if ( buf.mass ) buf.mass[ i ] = p.mass();
+      if ( buf.charge ) buf.charge[ i ] = static_cast<int32_t>( p.charge() );
+    };
+
+    for ( const auto& p : ev.get_initial_particles() ) store_particle( p );
+    for ( const auto& p : ev.get_final_particles() ) store_particle( p );
+
+    ++buf.num_events;
+    return true;
+  }
+
+  // Shared implementation of the generation functions. The create function
+  // loads the next event into the scratch Event object.
+  template <typename Create> marley_status generate( marley_generator* gen,
+    size_t num_events, marley_event_buffers* buffers, Create create )
+  {
+    if ( !gen || !buffers ) return fail( MARLEY_INVALID_ARGUMENT,
+      "Null pointer passed to a MARLEY event generation function" );
+
+    buffers->num_events = 0u;
+    buffers->num_particles = 0u;
+
+    return guarded( [&]() -> marley_status {
+      while ( buffers->num_events < num_events ) {
+        if ( !gen->pending ) {
+          create( gen->scratch );
+          gen->pending = true;
+        }
+        if ( !store_event(gen->scratch, *buffers) ) {
+          if ( buffers->num_events > 0u ) break;
+          return fail( MARLEY_BUFFER_TOO_SMALL, "The buffers passed to a"
+            " MARLEY event generation function are too small to hold a"
+            " single event" );
+        }
+        gen->pending = false;
+      }
+      return MARLEY_OK;
+    } );
+  }
+
+  marley_status create_generator( const marley::JSON& json,
+    marley_generator** gen )
+  {
+    marley::JSONConfig jc( json );
+    *gen = new marley_generator( jc.create_generator() );
+    return MARLEY_OK;
+  }
+
+}
+
+const char* marley_last_error(void) {
+  return last_error.c_str();
+}
+
+const char* marley_version(void) {
+  return MARLEY_VERSION;
+}
+
+marley_status marley_generator_create_from_file(const char* file_name,
+  marley_generator** gen)
+{
+  if ( !file_name || !gen ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_generator_create_from_file()" );
+  *gen = nullptr;
+  return guarded( [&]() -> marley_status {
+    return create_generator( marley::JSON::load_file(file_name), gen );
+  } );
+}
+
+marley_status marley_generator_create_from_string(const char* json_text,
+  marley_generator** gen)
+{
+  if ( !json_text || !gen ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_generator_create_from_string()" );
+  *gen = nullptr;
+  return guarded( [&]() -> marley_status {
+    return create_generator( marley::JSON::load(std::string(json_text)),
+      gen );
+  } );
+}
+
+void marley_generator_destroy(marley_generator* gen) {
+  delete gen;
+}
+
+marley_status marley_generate_events(marley_generator* gen,
+  size_t num_events, marley_event_buffers* buffers)
+{
+  return generate( gen, num_events, buffers,
+    [gen]( marley::Event& ev ) -> void { gen->gen.create_event( ev ); } );
+}
+
+marley_status marley_generate_fixed_events(marley_generator* gen,
+  size_t num_events, int pdg_a, double KEa, int pdg_atom,
+  const double* direction, marley_event_buffers* buffers)
+{
+  std::array<double, 3> dir_vec = { 0., 0., 1. };
+  if ( direction ) dir_vec = { direction[0], direction[1], direction[2] };
+  return generate( gen, num_events, buffers,
+    [&]( marley::Event& ev ) -> void
+  {
+    ev = gen->gen.create_event( pdg_a, KEa, pdg_atom, dir_vec );
+  } );
+}
+
+marley_status marley_flux_averaged_total_xs(marley_generator* gen,
+  double* xs)
+{
+  if ( !gen || !xs ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_flux_averaged_total_xs()" );
+  return guarded( [&]() -> marley_status {
+    *xs = gen->gen.flux_averaged_total_xs();
+    return MARLEY_OK;
+  } );
+}
+
+marley_status marley_total_xs(marley_generator* gen, int pdg_a, double KEa,
+  int pdg_atom, double* xs)
+{
+  if ( !gen || !xs ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_total_xs()" );
+  return guarded( [&]() -> marley_status {
+    *xs = gen->gen.total_xs( pdg_a, KEa, pdg_atom );
+    return MARLEY_OK;
+  } );
+}
+
+marley_status marley_total_xs_batch(marley_generator* gen, int pdg_a,
+  const double* KEas, double* xs, size_t n)
+{
+  if ( !gen || (n > 0u && (!KEas || !xs)) ) return fail(
+    MARLEY_INVALID_ARGUMENT, "Null pointer passed to"
+    " marley_total_xs_batch()" );
+  return guarded( [&]() -> marley_status {
+    gen->gen.total_xs_batch( pdg_a, KEas, xs, n );
+    return MARLEY_OK;
+  } );
+}
+
+marley_status marley_get_seed(marley_generator* gen, uint64_t* seed) {
+  if ( !gen || !seed ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_get_seed()" );
+  *seed = gen->gen.get_seed();
+  return MARLEY_OK;
+}
+
+marley_status marley_reseed(marley_generator* gen, uint64_t seed) {
+  if ( !gen ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_reseed()" );
+  return guarded( [&]() -> marley_status {
+    gen->gen.reseed( seed );
+    gen->pending = false;
+    return MARLEY_OK;
+  } );
+}
+
+marley_status marley_get_state(marley_generator* gen, char* buffer,
+  size_t capacity, size_t* length)
+{
+  if ( !gen || !length || (capacity > 0u && !buffer) ) return fail(
+    MARLEY_INVALID_ARGUMENT, "Null pointer passed to marley_get_state()" );
+  return guarded( [&]() -> marley_status {
+    std::string state = gen->gen.get_state_string();
+    *length = state.size();
+    if ( capacity <= state.size() ) return fail( MARLEY_BUFFER_TOO_SMALL,
+      "A buffer of at least " + std::to_string(state.size() + 1u)
+      + " bytes is needed to store the MARLEY generator state" );
+    state.copy( buffer, state.size() );
+    buffer[ state.size() ] = '\0';
+    return MARLEY_OK;
+  } );
+}
+
+marley_status marley_set_state(marley_generator* gen, const char* state) {
+  if ( !gen || !state ) return fail( MARLEY_INVALID_ARGUMENT,
+    "Null pointer passed to marley_set_state()" );
+  return guarded( [&]() -> marley_status {
+    gen->gen.seed_using_state_string( state );
+    gen->pending = false;
+    return MARLEY_OK;
+  } );
+}
@@ -33,6 +33,63 @@ namespace {
     return beta2;
   }
 
+  // Precomputed parameters for a Lorentz boost, which may be applied to any
+  // number of particles
+  class LorentzBoost {
+
+    public:
+
+      LorentzBoost(double beta_x, double beta_y, double beta_z)
+        : beta_x_( beta_x ), beta_y_( beta_y ), beta_z_( beta_z ),
+        beta2_( get_beta2(beta_x, beta_y, beta_z) )
+      {
+        // Calculate the Lorentz factor based on the boost velocity
+        if ( beta2_ != 0. ) gamma_ = 1. / std::sqrt( 1. - beta2_ );
+      }
+
+      // If beta is zero in all directions, then we don't need to do the
+      // boost at all
+      inline bool is_identity() const { return beta2_ == 0.; }
+
+      // Replaces the energy and momentum of a particle with the boosted
+      // versions
+      void apply(marley::Particle& particle) const {
+        if ( this->is_identity() ) return;
+
+        double E = particle.total_energy();
+        double px = particle.px();
+        double py = particle.py();
+        double pz = particle.pz();
+        double m = particle.mass();
+
+        // Compute the boosted energy and 3-momentum for the particle (the
+        // expressions we use here are based on
+        // https://en.wikipedia.org/wiki/Lorentz_transformation#Boost_in_any_direction)
+        double beta_dot_p = beta_x_ * px + beta_y_ * py + beta_z_ * pz;
+        double factor = ( gamma_ - 1. ) * beta_dot_p / beta2_;
+
+        double new_E = gamma_ * ( E - beta_dot_p );
+
+        // The new energy could conceivably dip slightly below the mass
+        // of the particle due to roundoff errors. If this is the case,
+        // set it to the particle mass.
+        if (new_E < m) new_E = m;
+
+        double shift = -gamma_ * E + factor;
+
+        particle.set_total_energy( new_E );
+        particle.set_px( shift * beta_x_ + px );
+        particle.set_py( shift * beta_y_ + py );
+        particle.set_pz( shift * beta_z_ + pz );
+      }
+
+    private:
+
+      double beta_x_, beta_y_, beta_z_;
+      double beta2_;
+      double gamma_ = 1.;
+  };
+
 }
 
 // Rotates a particle's 3-momentum so that it points in the (x, y, z) direction
@@ -62,41 +119,22 @@ void marley_kinematics::rotate_momentum_vector(double x, double y, double z,
 void marley_kinematics::lorentz_boost(double beta_x, double beta_y,
   double beta_z, marley::Particle& particle_to_boost)
 {
-  double beta2 = get_beta2(beta_x, beta_y, beta_z);
-
-  // If beta is zero in all directions, then we don't need to do the boost at all
-  if ( beta2 == 0. ) return;
-
-  // Calculate the Lorentz factor based on the boost velocity
-  double gamma = 1. / std::sqrt( 1. - beta2 );
-
-  double E = particle_to_boost.total_energy();
-  double px = particle_to_boost.px();
-  double py = particle_to_boost.py();
-  double pz = particle_to_boost.pz();
-  double m = particle_to_boost.mass();
-
-  // Compute the boosted energy and 3-momentum for the particle (the expressions
-  // we use here are based on
-  // https://en.wikipedia.org/wiki/Lorentz_transformation#Boost_in_any_direction)
-  double beta_dot_p = beta_x * px + beta_y * py + beta_z * pz;
-  double factor = ( gamma - 1. ) * beta_dot_p / beta2;
-
-  double new_E = gamma * ( E - beta_dot_p );
-
-  // The new energy could conceivably dip slightly below the mass
-  // of the particle due to roundoff errors. If this is the case,
-  // set it to the particle mass.
-  if (new_E < m) new_E = m;
+  lorentz_boost( beta_x, beta_y, beta_z, &particle_to_boost, 1u );
+}
 
-  double new_px = ( -gamma * E + factor ) * beta_x + px;
-  double new_py = ( -gamma * E + factor ) * beta_y + py;
-  double new_pz = ( -gamma * E + factor ) * beta_z + pz;
+void marley_kinematics::lorentz_boost(double beta_x, double beta_y,
+  double beta_z, std::vector<marley::Particle>& particles_to_boost)
+{
+  lorentz_boost( beta_x, beta_y, beta_z, particles_to_boost.data(),
+    particles_to_boost.size() );
+}
 
-  particle_to_boost.set_total_energy( new_E );
-  particle_to_boost.set_px( new_px );
-  particle_to_boost.set_py( new_py );
-  particle_to_boost.set_pz( new_pz );
+void marley_kinematics::lorentz_boost(double beta_x, double beta_y,
+  double beta_z, marley::Particle* particles_to_boost, size_t count)
+{
+  LorentzBoost boost( beta_x, beta_y, beta_z );
+  if ( boost.is_identity() ) return;
+  for ( size_t k = 0u; k < count; ++k ) boost.apply( particles_to_boost[k] );
 }
 
 // Right now, this function assumes that the coordinate axes in the lab
@@ -178,8 +216,9 @@ void marley_kinematics::two_body_decay(const marley::Particle& initial_particle,
 
   // Boost both products to the lab frame by replacing their
   // energies and momenta with the boosted versions
-  lorentz_boost( beta_x, beta_y, beta_z, first_product );
-  lorentz_boost( beta_x, beta_y, beta_z, second_product );
+  LorentzBoost boost( beta_x, beta_y, beta_z );
+  boost.apply( first_product );
+  boost.apply( second_product );
 }
 
 // Get the square of the total energy of two particles in their center of
@@ -19,9 +19,13 @@
 #include <cfloat>
 #include <cmath>
 #include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <random>
 #include <regex>
 #include <string>
@@ -30,6 +34,7 @@
 #include "marley/marley_utils.hh"
 #include "marley/Integrator.hh"
 #include "marley/Error.hh"
+#include "marley/MappedFile.hh"
 
 // Strings to use for latex table output of ENSDF data
 std::string marley_utils::latex_table_1 = "\\documentclass[12pt]{article}\n"
@@ -107,6 +112,16 @@ std::string marley_utils::latex_table_4 = "\\end{longtable}\n"
   "\\end{center}\n"
   "\\end{document}";
 
+namespace {
+  // Parameters for the Lanczos approximation to the gamma function (g = 7,
+  // n = 9) shared by marley_utils::gamma() and marley_utils::log_norm_gamma()
+  constexpr int LANCZOS_G = 7;
+  constexpr double LANCZOS_P[ LANCZOS_G + 2 ] = { 0.99999999999980993,
+    676.5203681218851, -1259.1392167224028, 771.32342877765313,
+    -176.61502916214059, 12.507343278686905, -0.13857109526572012,
+    9.9843695780195716e-6, 1.5056327351493116e-7 };
+}
+
 // This implementation of the complex gamma function is based on the
 // Lanczos approximation and its Python implementation given
 // on Wikipedia (https://en.wikipedia.org/wiki/Lanczos_approximation)
@@ -114,16 +129,8 @@ std::string marley_utils::latex_table_4 = "\\end{longtable}\n"
 // http://bytes.com/topic/c/answers/576697-c-routine-complex-gamma-function
 std::complex<double> marley_utils::gamma(std::complex<double> z)
 {
-  // Initialize some constants used in the algorithm. The "static
-  // const" keywords ensure that these constants are initialized only
-  // once (not reinitialized each time this function is called)
-  static const int g=7;
   static const double pi =
   3.1415926535897932384626433832795028841972;
-  static const double p[g+2] = {0.99999999999980993, 676.5203681218851,
-  -1259.1392167224028, 771.32342877765313, -176.61502916214059,
-  12.507343278686905, -0.13857109526572012, 9.9843695780195716e-6,
-  1.5056327351493116e-7};
 
   if (std::real(z) < 0.5) {
     return pi / (std::sin(pi*z)*gamma(1.0-z));
@@ -131,120 +138,65 @@ std::complex<double> marley_utils::gamma(std::complex<double> z)
 
   z -= 1.0;
 
-  std::complex<double> x = p[0];
+  std::complex<double> x = LANCZOS_P[0];
 
-  for (int j = 1; j < g + 2; ++j) {
-    x += p[j]/(z+std::complex<double>(j,0));
+  for (int j = 1; j < LANCZOS_G + 2; ++j) {
+    x += LANCZOS_P[j]/(z+std::complex<double>(j,0));
   }
 
-  std::complex<double> t = z + (g + 0.5);
+  std::complex<double> t = z + (LANCZOS_G + 0.5);
 
   return std::sqrt(2*pi) * std::pow(t, z + 0.5) * std::exp(-t) * x;
 }
 
-// This function is a modified version of a public-domain implementation of
-// Brent's algorithm for minimizing a function. You can download the original
-// source code from http://tinyurl.com/hhoy3ky.
-
-// The return value of minimize is the minimum of the function f.
-// The location where f takes its minimum is returned in the variable minLoc.
-// Notation and implementation based on Chapter 5 of Richard Brent's book
-// "Algorithms for Minimization Without Derivatives".
-double marley_utils::minimize(const std::function<double(double)> f, // [in] objective function to minimize
-  double leftEnd,     // [in] smaller value of bracketing interval
-  double rightEnd,    // [in] larger value of bracketing interval
-  double epsilon,     // [in] stopping tolerance
-  double& minLoc)     // [out] location of minimum
+// Uses the same Lanczos approximation as gamma(), but takes the real part of
+// the logarithm term by term. Only |t| and arg(t) are then needed from the
+// complex power, so no complex exponential is evaluated and the result stays
+// finite even when |Gamma(z)| itself would overflow or underflow.
+double marley_utils::log_norm_gamma(double x, double y)
 {
-    double d, e, m, p, q, r, tol, t2, u, v, w, fu, fv, fw, fx;
-    static const double c = 0.5*(3.0 - std::sqrt(5.0));
-    static const double SQRT_DBL_EPSILON = std::sqrt(DBL_EPSILON);
-
-    double& a = leftEnd;
-    double& b = rightEnd;
-    double& x = minLoc;
-
-    v = w = x = a + c*(b - a);
-    d = e = 0.0;
-    fv = fw = fx = f(x);
-
-    // Check stopping criteria
-    while (m = 0.5*(a + b),
-      tol = SQRT_DBL_EPSILON*fabs(x) + epsilon,
-      t2 = 2.0*tol,
-      fabs(x - m) > t2 - 0.5*(b - a))
-    {
-        p = q = r = 0.0;
-        if (fabs(e) > tol)
-        {
-            // fit parabola
-            r = (x - w)*(fx - fv);
-            q = (x - v)*(fx - fw);
-            p = (x - v)*q - (x - w)*r;
-            q = 2.0*(q - r);
-            (q > 0.0) ? p = -p : q = -q;
-            r = e; e = d;
-        }
-        if (fabs(p) < fabs(0.5*q*r) && p < q*(a - x) && p < q*(b - x))
-        {
-            // A parabolic interpolation step
-            d = p/q;
-            u = x + d;
-            // f must not be evaluated too close to a or b
-            if (u - a < t2 || b - u < t2)
-                d = (x < m) ? tol : -tol;
-        }
-        else
-        {
-            // A golden section step
-            e = (x < m) ? b : a;
-            e -= x;
-            d = c*e;
-        }
-        // f must not be evaluated too close to x
-        if (fabs(d) >= tol)
-            u = x + d;
-        else if (d > 0.0)
-            u = x + tol;
-        else
-            u = x - tol;
-        fu = f(u);
-        // Update a, b, v, w, and x
-        if (fu <= fx)
-        {
-            (u < x) ? b = x : a = x;
-            v = w; fv = fw;
-            w = x; fw = fx;
-            x = u; fx = fu;
-        }
-        else
-        {
-            (u < x) ? a = u : b = u;
-            if (fu <= fw || w == x)
-            {
-                v = w; fv = fw;
-                w = u; fw = fu;
-            }
-            else if (fu <= fv || v == x || v == w)
-            {
-                v = u; fv = fu;
-            }
-        }
-    }
-    return  fx;
+  // For 0 < x < 1/2, use Gamma(z) = Gamma(z + 1) / z rather than the
+  // reflection formula employed by gamma(), whose sine factor overflows for
+  // large |y|
+  if ( x < 0.5 ) {
+    if ( x <= 0. ) return std::log( std::norm(gamma({ x, y })) );
+    return log_norm_gamma( x + 1., y ) - std::log( x*x + y*y );
+  }
+
+  std::complex<double> z( x - 1., y );
+  std::complex<double> sum = LANCZOS_P[0];
+  for ( int j = 1; j < LANCZOS_G + 2; ++j ) {
+    sum += LANCZOS_P[j] / ( z + static_cast<double>(j) );
+  }
+
+  // Re[ ln Gamma(z + 1) ] = ln(2*pi)/2 + Re[ (z + 1/2) ln t ] - Re(t)
+  //   + ln|sum|, with t = z + g + 1/2
+  std::complex<double> t = z + ( LANCZOS_G + 0.5 );
+  double log_abs_t = 0.5 * std::log( std::norm(t) );
+  double arg_t = std::arg( t );
+  double re_log_gamma = 0.5 * std::log( 2. * pi )
+    + ( z.real() + 0.5 ) * log_abs_t - z.imag() * arg_t
+    - t.real() + 0.5 * std::log( std::norm(sum) );
+
+  return 2. * re_log_gamma;
+}
+
+// Minimize a function of one variable using Brent's method. This is a thin
+// wrapper around the templated version in marley_utils.hh.
+double marley_utils::minimize(const std::function<double(double)> f,
+  double leftEnd, double rightEnd, double epsilon, double& minLoc)
+{
+  return minimize< std::function<double(double)> >( f, leftEnd, rightEnd,
+    epsilon, minLoc );
 }
 
 // We can maximize a function using the same technique by minimizing its
 // opposite
-double marley_utils::maximize(const std::function<double(double)> f, // [in] objective function to maximize
-  double leftEnd,     // [in] smaller value of bracketing interval
-  double rightEnd,    // [in] larger value of bracketing interval
-  double epsilon,     // [in] stopping tolerance
-  double& maxLoc)     // [out] location of maximum
+double marley_utils::maximize(const std::function<double(double)> f,
+  double leftEnd, double rightEnd, double epsilon, double& maxLoc)
 {
-  double result = minimize([&f](double x) -> double { return -1.0*f(x); },
-    leftEnd, rightEnd, epsilon, maxLoc);
-  return -1.0*result;
+  return maximize< std::function<double(double)> >( f, leftEnd, rightEnd,
+    epsilon, maxLoc );
 }
 
 // Numerically integrate a given function f (that takes a
@@ -253,10 +205,7 @@ double marley_utils::maximize(const std::function<double(double)> f, // [in] obj
 double marley_utils::num_integrate(const std::function<double(double)> &f,
   double a, double b)
 {
-  /// @todo remove the hard-coded number of Chebyshev points here in
-  /// favor of adaptive integration.
-  static marley::Integrator integrator(50);
-  return integrator.num_integrate(f, a, b);
+  return default_integrator().num_integrate(f, a, b);
 }
 
 // Solves a quadratic equation of the form A*x^2 + B*x + C = 0
@@ -386,6 +335,373 @@ std::string marley_utils::num_bytes_to_string(double bytes,
   return out.str();
 }
 
+namespace {
+
+  // Conversion of doubles to shortest decimal strings using the Grisu2
+  // algorithm of Florian Loitsch ("Printing Floating-Point Numbers Quickly
+  // and Accurately with Integers", PLDI 2010). The structure follows the
+  // implementation in the JSON for Modern C++ library by Niels Lohmann
+  // (https://github.com/nlohmann/json). The digits produced always read
+  // back as the original double, and they are the shortest such digits in
+  // all but a tiny fraction of cases.
+
+  // Floating-point number f * 2^e with a 64-bit significand
+  struct DiyFp {
+    uint64_t f;
+    int e;
+
+    constexpr DiyFp(uint64_t f_, int e_) : f( f_ ), e( e_ ) {}
+
+    // Difference of two numbers with the same exponent (x.f >= y.f)
+    static DiyFp sub(const DiyFp& x, const DiyFp& y) {
+      return DiyFp( x.f - y.f, x.e );
+    }
+
+    // Product of two numbers, rounded to 64 bits
+    static DiyFp mul(const DiyFp& x, const DiyFp& y) {
+      const uint64_t u_lo = x.f & 0xFFFFFFFFu;
+      const uint64_t u_hi = x.f >> 32u;
+      const uint64_t v_lo = y.f & 0xFFFFFFFFu;
+      const uint64_t v_hi = y.f >> 32u;
+
+      const uint64_t p0 = u_lo * v_lo;
+      const uint64_t p1 = u_lo * v_hi;
+      const uint64_t p2 = u_hi * v_lo;
+      const uint64_t p3 = u_hi * v_hi;
+
+      uint64_t q = ( p0 >> 32u ) + ( p1 & 0xFFFFFFFFu ) + ( p2 & 0xFFFFFFFFu );
+      q += uint64_t( 1u ) << 31u; // round to nearest
+
+      const uint64_t h = p3 + ( p1 >> 32u ) + ( p2 >> 32u ) + ( q >> 32u );
+      return DiyFp( h, x.e + y.e + 64 );
+    }
+
+    // Shift the significand left until its highest bit is set
+    static DiyFp normalize(DiyFp x) {
+      while ( ( x.f >> 63u ) == 0u ) {
+        x.f <<= 1u;
+        --x.e;
+      }
+      return x;
+    }
+
+    // Shift the significand left to reach the target exponent
+    static DiyFp normalize_to(const DiyFp& x, int target_exponent) {
+      return DiyFp( x.f << ( x.e - target_exponent ), target_exponent );
+    }
+  };
+
+  // Normalized value v and the boundaries m- and m+ of its rounding
+  // interval. All three share the same exponent.
+  struct Boundaries {
+    DiyFp w;
+    DiyFp minus;
+    DiyFp plus;
+  };
+
+  // Requires a finite, positive value
+  Boundaries compute_boundaries(double value) {
+    constexpr int PRECISION = std::numeric_limits<double>::digits; // 53
+    constexpr int BIAS = std::numeric_limits<double>::max_exponent - 1
+      + ( PRECISION - 1 );
+    constexpr int MIN_EXPONENT = 1 - BIAS;
+    constexpr uint64_t HIDDEN_BIT = uint64_t( 1u ) << ( PRECISION - 1 );
+
+    uint64_t bits;
+    std::memcpy( &bits, &value, sizeof(bits) );
+    const uint64_t E = bits >> ( PRECISION - 1 );
+    const uint64_t F = bits & ( HIDDEN_BIT - 1u );
+
+    const DiyFp v = ( E == 0u ) ? DiyFp( F, MIN_EXPONENT )
+      : DiyFp( F + HIDDEN_BIT, static_cast<int>(E) - BIAS );
+
+    // The distance to the next smaller double is halved at powers of two
+    const bool lower_boundary_is_closer = F == 0u && E > 1u;
+    const DiyFp m_plus( 2u*v.f + 1u, v.e - 1 );
+    const DiyFp m_minus = lower_boundary_is_closer
+      ? DiyFp( 4u*v.f - 1u, v.e - 2 ) : DiyFp( 2u*v.f - 1u, v.e - 1 );
+
+    const DiyFp w_plus = DiyFp::normalize( m_plus );
+    const DiyFp w_minus = DiyFp::normalize_to( m_minus, w_plus.e );
+
+    return { DiyFp::normalize(v), w_minus, w_plus };
+  }
+
+  // Range for the binary exponent of the scaled values used by Grisu2
+  constexpr int GRISU_ALPHA = -60;
+  constexpr int GRISU_GAMMA = -32;
+
+  // Normalized approximation f * 2^e of the power of ten 10^k
+  struct CachedPower {
+    uint64_t f;
+    int e;
+    int k;
+  };
+
+  // Powers of ten 10^k for k = -300, -292, ..., 324. Each significand is
+  // the exact value of 10^k rounded to 64 bits.
+  constexpr int CACHED_POWERS_MIN_DEC_EXP = -300;
+  constexpr int CACHED_POWERS_DEC_STEP = 8;
+  constexpr CachedPower CACHED_POWERS[] = {
+    { 0xAB70FE17C79AC6CA, -1060, -300 },
+    { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+    { 0xBE5691EF416BD60C, -1007, -284 },
+    { 0x8DD01FAD907FFC3C,  -980, -276 },
+    { 0xD3515C2831559A83,  -954, -268 },
+    { 0x9D71AC8FADA6C9B5,  -927, -260 },
+    { 0xEA9C227723EE8BCB,  -901, -252 },
+    { 0xAECC49914078536D,  -874, -244 },
+    { 0x823C12795DB6CE57,  -847, -236 },
+    { 0xC21094364DFB5637,  -821, -228 },
+    { 0x9096EA6F3848984F,  -794, -220 },
+    { 0xD77485CB25823AC7,  -768, -212 },
+    { 0xA086CFCD97BF97F4,  -741, -204 },
+    { 0xEF340A98172AACE5,  -715, -196 },
+    { 0xB23867FB2A35B28E,  -688, -188 },
+    { 0x84C8D4DFD2C63F3B,  -661, -180 },
+    { 0xC5DD44271AD3CDBA,  -635, -172 },
+    { 0x936B9FCEBB25C996,  -608, -164 },
+    { 0xDBAC6C247D62A584,  -582, -156 },
+    { 0xA3AB66580D5FDAF6,  -555, -148 },
+    { 0xF3E2F893DEC3F126,  -529, -140 },
+    { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+    { 0x87625F056C7C4A8B,  -475, -124 },
+    { 0xC9BCFF6034C13053,  -449, -116 },
+    { 0x964E858C91BA2655,  -422, -108 },
+    { 0xDFF9772470297EBD,  -396, -100 },
+    { 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+    { 0xF8A95FCF88747D94,  -343,  -84 },
+    { 0xB94470938FA89BCF,  -316,  -76 },
+    { 0x8A08F0F8BF0F156B,  -289,  -68 },
+    { 0xCDB02555653131B6,  -263,  -60 },
+    { 0x993FE2C6D07B7FAC,  -236,  -52 },
+    { 0xE45C10C42A2B3B06,  -210,  -44 },
+    { 0xAA242499697392D3,  -183,  -36 },
+    { 0xFD87B5F28300CA0E,  -157,  -28 },
+    { 0xBCE5086492111AEB,  -130,  -20 },
+    { 0x8CBCCC096F5088CC,  -103,  -12 },
+    { 0xD1B71758E219652C,   -77,   -4 },
+    { 0x9C40000000000000,   -50,    4 },
+    { 0xE8D4A51000000000,   -24,   12 },
+    { 0xAD78EBC5AC620000,     3,   20 },
+    { 0x813F3978F8940984,    30,   28 },
+    { 0xC097CE7BC90715B3,    56,   36 },
+    { 0x8F7E32CE7BEA5C70,    83,   44 },
+    { 0xD5D238A4ABE98068,   109,   52 },
+    { 0x9F4F2726179A2245,   136,   60 },
+    { 0xED63A231D4C4FB27,   162,   68 },
+    { 0xB0DE65388CC8ADA8,   189,   76 },
+    { 0x83C7088E1AAB65DB,   216,   84 },
+    { 0xC45D1DF942711D9A,   242,   92 },
+    { 0x924D692CA61BE758,   269,  100 },
+    { 0xDA01EE641A708DEA,   295,  108 },
+    { 0xA26DA3999AEF774A,   322,  116 },
+    { 0xF209787BB47D6B85,   348,  124 },
+    { 0xB454E4A179DD1877,   375,  132 },
+    { 0x865B86925B9BC5C2,   402,  140 },
+    { 0xC83553C5C8965D3D,   428,  148 },
+    { 0x952AB45CFA97A0B3,   455,  156 },
+    { 0xDE469FBD99A05FE3,   481,  164 },
+    { 0xA59BC234DB398C25,   508,  172 },
+    { 0xF6C69A72A3989F5C,   534,  180 },
+    { 0xB7DCBF5354E9BECE,   561,  188 },
+    { 0x88FCF317F22241E2,   588,  196 },
+    { 0xCC20CE9BD35C78A5,   614,  204 },
+    { 0x98165AF37B2153DF,   641,  212 },
+    { 0xE2A0B5DC971F303A,   667,  220 },
+    { 0xA8D9D1535CE3B396,   694,  228 },
+    { 0xFB9B7CD9A4A7443C,   720,  236 },
+    { 0xBB764C4CA7A44410,   747,  244 },
+    { 0x8BAB8EEFB6409C1A,   774,  252 },
+    { 0xD01FEF10A657842C,   800,  260 },
+    { 0x9B10A4E5E9913129,   827,  268 },
+    { 0xE7109BFBA19C0C9D,   853,  276 },
+    { 0xAC2820D9623BF429,   880,  284 },
+    { 0x80444B5E7AA7CF85,   907,  292 },
+    { 0xBF21E44003ACDD2D,   933,  300 },
+    { 0x8E679C2F5E44FF8F,   960,  308 },
+    { 0xD433179D9C8CB841,   986,  316 },
+    { 0x9E19DB92B4E31BA9,  1013,  324 }
+  };
+
+  // Returns a cached power of ten c = 10^k such that the binary exponent of
+  // c * 2^e lies within [GRISU_ALPHA, GRISU_GAMMA]
+  CachedPower get_cached_power_for_binary_exponent(int e) {
+    // 78913 / 2^18 approximates log10(2)
+    const int f = GRISU_ALPHA - e - 1;
+    const int k = ( f * 78913 ) / ( 1 << 18 ) + ( f > 0 ? 1 : 0 );
+    const int index = ( -CACHED_POWERS_MIN_DEC_EXP + k
+      + ( CACHED_POWERS_DEC_STEP - 1 ) ) / CACHED_POWERS_DEC_STEP;
+    return CACHED_POWERS[ index ];
+  }
+
+  // Returns the number of decimal digits in n (n < 10^10) and sets pow10 to
+  // 10^(digits - 1)
+  int find_largest_pow10(uint32_t n, uint32_t& pow10) {
+    int digits = 10;
+    pow10 = 1000000000u;
+    while ( digits > 1 && n < pow10 ) {
+      pow10 /= 10u;
+      --digits;
+    }
+    return digits;
+  }
+
+  // Moves the last digit towards the exact value while staying within the
+  // rounding interval
+  void grisu2_round(char* buffer, int length, uint64_t dist, uint64_t delta,
+    uint64_t rest, uint64_t ten_k)
+  {
+    while ( rest < dist && delta - rest >= ten_k
+      && ( rest + ten_k < dist || dist - rest > rest + ten_k - dist ) )
+    {
+      --buffer[ length - 1 ];
+      rest += ten_k;
+    }
+  }
+
+  // Generates the shortest digits of w that lie within (M-, M+)
+  void grisu2_digit_gen(char* buffer, int& length, int& decimal_exponent,
+    DiyFp M_minus, DiyFp w, DiyFp M_plus)
+  {
+    uint64_t delta = DiyFp::sub( M_plus, M_minus ).f;
+    uint64_t dist = DiyFp::sub( M_plus, w ).f;
+
+    // Split M+ into integral and fractional parts
+    const DiyFp one( uint64_t( 1u ) << -M_plus.e, M_plus.e );
+    uint32_t p1 = static_cast<uint32_t>( M_plus.f >> -one.e );
+    uint64_t p2 = M_plus.f & ( one.f - 1u );
+
+    uint32_t pow10;
+    int n = find_largest_pow10( p1, pow10 );
+
+    // Digits of the integral part
+    while ( n > 0 ) {
+      const uint32_t d = p1 / pow10;
+      p1 %= pow10;
+      buffer[ length++ ] = static_cast<char>( '0' + d );
+      --n;
+
+      const uint64_t rest = ( uint64_t( p1 ) << -one.e ) + p2;
+      if ( rest <= delta ) {
+        decimal_exponent += n;
+        const uint64_t ten_n = uint64_t( pow10 ) << -one.e;
+        grisu2_round( buffer, length, dist, delta, rest, ten_n );
+        return;
+      }
+      pow10 /= 10u;
+    }
+
+    // Digits of the fractional part
+    int m = 0;
+    while ( true ) {
+      p2 *= 10u;
+      const uint64_t d = p2 >> -one.e;
+      p2 &= one.f - 1u;
+      buffer[ length++ ] = static_cast<char>( '0' + d );
+      ++m;
+
+      delta *= 10u;
+      dist *= 10u;
+      if ( p2 <= delta ) break;
+    }
+
+    decimal_exponent -= m;
+    grisu2_round( buffer, length, dist, delta, p2, one.f );
+  }
+
+  // Writes the digits of a finite, positive value to buffer (without a
+  // terminator) such that value = digits * 10^decimal_exponent
+  void grisu2(char* buffer, int& length, int& decimal_exponent,
+    double value)
+  {
+    const Boundaries b = compute_boundaries( value );
+    const CachedPower cached = get_cached_power_for_binary_exponent(
+      b.plus.e );
+    const DiyFp c_minus_k( cached.f, cached.e );
+
+    const DiyFp w = DiyFp::mul( b.w, c_minus_k );
+    const DiyFp w_minus = DiyFp::mul( b.minus, c_minus_k );
+    const DiyFp w_plus = DiyFp::mul( b.plus, c_minus_k );
+
+    // Shrink the interval by one unit on each side to account for the
+    // rounding errors in the products
+    const DiyFp M_minus( w_minus.f + 1u, w_minus.e );
+    const DiyFp M_plus( w_plus.f - 1u, w_plus.e );
+
+    length = 0;
+    decimal_exponent = -cached.k;
+    grisu2_digit_gen( buffer, length, decimal_exponent, M_minus, w, M_plus );
+  }
+
+}
+
+size_t marley_utils::format_shortest_double(double x, char* buffer) {
+  // Non-finite values are printed as "inf", "nan", etc.
+  if ( !std::isfinite(x) ) return std::snprintf( buffer,
+    SHORTEST_DOUBLE_BUFFER_SIZE, "%g", x );
+
+  char* out = buffer;
+  if ( std::signbit(x) ) {
+    *out++ = '-';
+    x = -x;
+  }
+
+  if ( x == 0. ) {
+    *out++ = '0';
+    *out = '\0';
+    return out - buffer;
+  }
+
+  char digits[ 18 ];
+  int num_digits, decimal_exponent;
+  grisu2( digits, num_digits, decimal_exponent, x );
+
+  // Choose between fixed and scientific notation using the same rule as the
+  // %g printf conversion with a precision of 17 digits (as in previous
+  // versions of MARLEY, which used std::numeric_limits<double>::max_digits10)
+  constexpr int PRECISION = std::numeric_limits<double>::max_digits10;
+  const int X = num_digits + decimal_exponent - 1; // exponent of first digit
+
+  if ( X < -4 || X >= PRECISION ) {
+    *out++ = digits[ 0 ];
+    if ( num_digits > 1 ) {
+      *out++ = '.';
+      std::memcpy( out, digits + 1, num_digits - 1 );
+      out += num_digits - 1;
+    }
+    out += std::snprintf( out, 8, "e%c%02d", X < 0 ? '-' : '+',
+      X < 0 ? -X : X );
+    return out - buffer;
+  }
+
+  if ( X < 0 ) {
+    // 0.000ddd
+    *out++ = '0';
+    *out++ = '.';
+    for ( int z = 0; z < -X - 1; ++z ) *out++ = '0';
+    std::memcpy( out, digits, num_digits );
+    out += num_digits;
+  }
+  else if ( num_digits <= X + 1 ) {
+    // ddd000
+    std::memcpy( out, digits, num_digits );
+    out += num_digits;
+    for ( int z = num_digits; z <= X; ++z ) *out++ = '0';
+  }
+  else {
+    // ddd.ddd
+    std::memcpy( out, digits, X + 1 );
+    out += X + 1;
+    *out++ = '.';
+    std::memcpy( out, digits + X + 1, num_digits - X - 1 );
+    out += num_digits - X - 1;
+  }
+
+  *out = '\0';
+  return out - buffer;
+}
+
 // This function exploits the observation (given in the first answer at
 // http://stackoverflow.com/questions/11062804/measuring-the-runtime-of-a-c-code)
 // that the difference of two std::chrono::system_clock::time_point objects
@@ -405,6 +721,24 @@ std::string marley_utils::elapsed_time_string(
     <std::chrono::system_clock::duration>(time_elapsed);
 }
 
+uint64_t marley_utils::fnv1a_hash(const char* data, size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+  for ( size_t b = 0u; b < size; ++b ) {
+    hash ^= static_cast<unsigned char>( data[b] );
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool marley_utils::hash_file(const std::string& file_name, uint64_t& hash) {
+  std::unique_ptr<marley::MappedFile> file;
+  try { file = std::make_unique<marley::MappedFile>( file_name ); }
+  catch ( const marley::Error& ) { return false; }
+
+  hash = fnv1a_hash( file->data(), file->size() );
+  return true;
+}
+
 // Efficiently read in an entire file as a std::string
 // This function was taken from
 // http://insanecoding.blogspot.in/2011/11/how-to-read-in-file-in-c.html
@@ -431,9 +765,9 @@ std::string marley_utils::get_file_contents(std::string filename) {
   throw marley::Error("Could not read from file " + filename);
 }
 
-// Advance to the next line of an ifstream that either matches (match == true)
-// or does not match (match == false) a given regular expression
-std::string marley_utils::get_next_line(std::ifstream &file_in,
+// Advance to the next line of an input stream that either matches (match ==
+// true) or does not match (match == false) a given regular expression
+std::string marley_utils::get_next_line(std::istream &file_in,
   const std::regex &rx, bool match)
 {
 
@@ -457,7 +791,7 @@ std::string marley_utils::get_next_line(std::ifstream &file_in,
 
 // Version of get_next_line that stores the number of lines
 // scanned into num_lines
-std::string marley_utils::get_next_line(std::ifstream &file_in,
+std::string marley_utils::get_next_line(std::istream &file_in,
   const std::regex &rx, bool match, int& num_lines)
 {
 
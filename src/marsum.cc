@@ -14,209 +14,449 @@
 // Please respect the MCnet academic usage guidelines. See GUIDELINES
 // or visit https://www.montecarlonet.org/GUIDELINES for details.
 
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
-#ifndef USE_ROOT
-  #error Building the marsum executable requires ROOT
+#ifdef USE_ROOT
+  // ROOT includes
+  #include "TFile.h"
+  #include "TROOT.h"
+  #include "TTree.h"
 #endif
 
-// ROOT includes
-#include "TFile.h"
-#include "TTree.h"
-
 // MARLEY includes
 #include "marley/marley_utils.hh"
+#include "marley/BinaryEventBlock.hh"
+#include "marley/Error.hh"
 #include "marley/Event.hh"
-#include "marley/RootEventFileReader.hh"
+#include "marley/EventSummary.hh"
+#include "marley/OutputFile.hh"
 #include "marley/Particle.hh"
 
+#ifdef USE_ROOT
+  #include "marley/RootEventFileReader.hh"
+  #include "marley/RootSummaryTree.hh"
+#else
+  #include "marley/EventFileReader.hh"
+#endif
+
 namespace {
-  // Index of the first final-state particle that is not the
-  // ejectile or residue (first de-excitation product).
-  // TODO: Make this easier to maintain. If you change the layout of
-  // marley::Event, this will break.
-  constexpr size_t FIRST_PROD_IDX = 2u;
+  #ifdef USE_ROOT
+    using Reader = marley::RootEventFileReader;
+  #else
+    using Reader = marley::EventFileReader;
+  #endif
+
+  // Kinds of files that marsum can produce
+  enum class OutputFormat {
+    ROOT, // "flat" ROOT file containing the mst summary tree
+    BINARY // merged events in MARLEY's native binary format
+  };
+
+  // Contents of a single input file, prepared for merging into the output
+  struct FileContents {
+    size_t num_events = 0u;
+    double flux_avg_tot_xsec = 0.;
+
+    // Summary tree values (ROOT output only). The de-excitation products of
+    // every event are stored contiguously in event order.
+    std::vector<marley::EventSummary> events;
+    std::vector<int> PDGs;
+    std::vector<double> Es, KEs, pXs, pYs, pZs;
+
+    // Encoded event block records (binary output only)
+    std::string records;
+  };
+
+  void summarize_event(const marley::Event& ev, double xsec,
+    FileContents& fc)
+  {
+    marley::EventSummary es;
+    es.set( ev, xsec );
+
+    const auto& fparts = ev.get_final_particles();
+    for ( size_t j = marley::EventSummary::FIRST_PRODUCT_INDEX;
+      j < fparts.size(); ++j )
+    {
+      const auto& fp = fparts.at( j );
+      fc.PDGs.push_back( fp.pdg_code() );
+      fc.Es.push_back( fp.total_energy() );
+      fc.KEs.push_back( fp.kinetic_energy() );
+      fc.pXs.push_back( fp.px() );
+      fc.pYs.push_back( fp.py() );
+      fc.pZs.push_back( fp.pz() );
+    }
+
+    fc.events.push_back( es );
+  }
+
+  // If the input file is in the current version of MARLEY's binary format
+  // and uses the requested precision, copy its event block records verbatim
+  // (without decoding them) and return true. Otherwise, return false.
+  bool copy_binary_records(const std::string& file_name,
+    marley::BinaryEventBlock::Precision precision, FileContents& fc)
+  {
+    std::ifstream in( file_name, std::ios::in | std::ios::binary );
+    marley::BinaryEventBlock::Header header;
+    if ( !marley::BinaryEventBlock::read_header(in, header) ) return false;
+
+    if ( header.layout != marley::BinaryEventBlock::Layout::event ) {
+      throw marley::Error("The binary file \"" + file_name + "\" uses the"
+        " kinematics layout and cannot be merged");
+    }
+
+    // Blocks written using an older version of the format or a different
+    // precision have a different layout, so they need to be decoded and
+    // written again
+    if ( header.format_version != marley::BinaryEventBlock::FORMAT_VERSION
+      || header.precision != precision ) return false;
+
+    fc.flux_avg_tot_xsec = header.flux_avg_tot_xsec;
+
+    // Event blocks are followed by the metadata record (if any), which is
+    // not copied
+    marley::BinaryEventBlock::RecordTag tag;
+    std::streampos start = in.tellg();
+    while ( marley::BinaryEventBlock::read_tag(in, tag)
+      && tag == marley::BinaryEventBlock::RecordTag::events )
+    {
+      uint32_t num_events;
+      if ( !marley::BinaryEventBlock::skip(in, num_events,
+        header.format_version, header.precision) ) {
+        throw marley::Error("Invalid event block encountered in the binary"
+          " file \"" + file_name + '\"');
+      }
+      std::streampos end = in.tellg();
+
+      size_t old_size = fc.records.size();
+      size_t record_size = static_cast<size_t>( end - start );
+      fc.records.resize( old_size + record_size );
+      in.seekg( start );
+      in.read( &fc.records[old_size], record_size );
+      if ( !in ) throw marley::Error("The binary file \"" + file_name
+        + "\" is truncated");
+
+      fc.num_events += num_events;
+      start = end;
+    }
+
+    return true;
+  }
+
+  // Prepares the contents of an input file for merging. This is safe to call
+  // concurrently for different files.
+  FileContents read_file(const std::string& file_name, OutputFormat format,
+    marley::BinaryEventBlock::Precision precision)
+  {
+    FileContents fc;
+
+    // Event blocks from binary input files can be copied directly to a
+    // binary output file
+    if ( format == OutputFormat::BINARY
+      && copy_binary_records(file_name, precision, fc) ) return fc;
+
+    Reader reader( file_name );
+
+    // Temporary objects to use for reading in saved events
+    marley::Event ev;
+    marley::BinaryEventBlock block;
+    std::ostringstream records;
+
+    // Event loop
+    while ( reader >> ev ) {
+      if ( format == OutputFormat::ROOT ) {
+        summarize_event( ev, reader.flux_averaged_xsec(), fc );
+      }
+      else {
+        block.add_event( ev );
+        if ( block.size() >= marley::BinaryOutputFile::EVENTS_PER_BLOCK ) {
+          block.write( records, precision );
+          block.clear();
+        }
+      }
+      ++fc.num_events;
+    }
+
+    if ( format == OutputFormat::BINARY ) {
+      if ( block.size() > 0u ) block.write( records, precision );
+      fc.records = records.str();
+    }
+
+    // The binary header stores the cross section in natural units
+    fc.flux_avg_tot_xsec = reader.flux_averaged_xsec(
+      format == OutputFormat::BINARY );
+    return fc;
+  }
+
+  // Reads the input files using up to num_threads concurrent workers, then
+  // passes their contents to the merge function one at a time in the same
+  // order as the input file names
+  void for_each_file(const std::vector<std::string>& file_names,
+    OutputFormat format, marley::BinaryEventBlock::Precision precision,
+    size_t num_threads,
+    const std::function<void(const std::string&, FileContents&)>& merge)
+  {
+    // With a single thread, read each file in the main thread when it is
+    // needed
+    auto policy = ( num_threads > 1u ) ? std::launch::async
+      : std::launch::deferred;
+
+    std::deque< std::future<FileContents> > pending;
+    size_t next_file = 0u;
+    auto launch_next = [&]() -> void {
+      pending.push_back( std::async(policy, read_file,
+        std::cref(file_names.at(next_file)), format, precision) );
+      ++next_file;
+    };
+
+    while ( next_file < file_names.size() && pending.size() < num_threads ) {
+      launch_next();
+    }
+
+    for ( const auto& file_name : file_names ) {
+      FileContents fc = pending.front().get();
+      pending.pop_front();
+
+      // Keep the workers busy while this file is merged
+      if ( next_file < file_names.size() ) launch_next();
+
+      merge( file_name, fc );
+      std::cout << "Merged " << fc.num_events << " events from \""
+        << file_name << "\"\n";
+    }
+  }
+
+  #ifdef USE_ROOT
+  void write_summary_tree(const std::string& output_file_name,
+    const std::vector<std::string>& input_file_names,
+    marley::BinaryEventBlock::Precision precision, size_t num_threads)
+  {
+    // ROOT must be told that more than one thread will open files
+    if ( num_threads > 1u ) ROOT::EnableThreadSafety();
+
+    TFile out_tfile( output_file_name.c_str(), "recreate" );
+    TTree* out_tree = new TTree( marley::RootSummaryTree::TREE_NAME,
+      marley::RootSummaryTree::TREE_TITLE );
+    marley::RootSummaryTree summary_tree( out_tree, true, 32000,
+      precision == marley::BinaryEventBlock::Precision::single );
+
+    for_each_file( input_file_names, OutputFormat::ROOT, precision,
+      num_threads,
+      [&](const std::string&, FileContents& fc) -> void
+    {
+      size_t first_product = 0u;
+      for ( const auto& es : fc.events ) {
+        summary_tree.fill( es, fc.PDGs.data() + first_product,
+          fc.Es.data() + first_product, fc.KEs.data() + first_product,
+          fc.pXs.data() + first_product, fc.pYs.data() + first_product,
+          fc.pZs.data() + first_product );
+        first_product += static_cast<size_t>( es.np );
+      }
+    });
+
+    out_tfile.cd();
+    out_tree->Write();
+    out_tfile.Close();
+  }
+  #endif
+
+  void write_binary_file(const std::string& output_file_name,
+    const std::vector<std::string>& input_file_names,
+    marley::BinaryEventBlock::Precision precision, size_t num_threads)
+  {
+    std::ofstream out( output_file_name, std::ios::out | std::ios::trunc
+      | std::ios::binary );
+    if ( !out ) throw marley::Error("Could not open the binary output file \""
+      + output_file_name + '\"');
+
+    // Reserve space for the header. It will be rewritten with the final
+    // event count after all files have been merged. The merged file has no
+    // metadata record since its events may come from more than one run.
+    marley::BinaryEventBlock::Header header;
+    header.precision = precision;
+    marley::BinaryEventBlock::write_header( out, header );
+
+    bool have_xsec = false;
+    bool warned_about_xsec = false;
+
+    for_each_file( input_file_names, OutputFormat::BINARY, precision,
+      num_threads,
+      [&](const std::string& file_name, FileContents& fc) -> void
+    {
+      out.write( fc.records.data(), fc.records.size() );
+      header.event_count += fc.num_events;
+
+      // The binary format stores a single cross section, so use the one
+      // from the first file and complain if any of the others disagree.
+      // Files in formats that do not store a cross section (e.g., HEPEVT)
+      // report zero and are ignored here.
+      if ( fc.num_events == 0u || fc.flux_avg_tot_xsec == 0. ) return;
+      if ( !have_xsec ) {
+        header.flux_avg_tot_xsec = fc.flux_avg_tot_xsec;
+        have_xsec = true;
+      }
+      else if ( !warned_about_xsec && std::abs(fc.flux_avg_tot_xsec
+        - header.flux_avg_tot_xsec) > 1e-10 * std::abs(
+        header.flux_avg_tot_xsec) )
+      {
+        std::cout << "WARNING: The flux-averaged total cross section for"
+          << " the file \"" << file_name << "\" differs from the one for"
+          << " the first input file. Only the latter will be stored in \""
+          << output_file_name << "\".\n";
+        warned_about_xsec = true;
+      }
+    });
+
+    out.seekp( 0 );
+    marley::BinaryEventBlock::write_header( out, header );
+    out.close();
+    if ( !out ) throw marley::Error("Failed to write the binary output file \""
+      + output_file_name + '\"');
+  }
+
+  void print_usage(const char* executable_name) {
+    std::cout << "Usage: " << executable_name << " [-j NUM_THREADS]"
+      << " [-f root|binary] [-p double|single]\n       OUTPUT_FILE"
+      << " INPUT_FILE...\n"
+      << "  -j NUM_THREADS  Number of input files to read concurrently"
+      << " (default 1, 0 uses\n                  one per hardware thread)\n"
+      << "  -f FORMAT       Write a \"flat\" ROOT summary file (root) or"
+      << " merge the events\n                  into a MARLEY binary event"
+      << " file (binary)\n"
+      << "  -p PRECISION    Store the particle kinematics in double"
+      << " (default) or single\n                  precision\n"
+      << "An INPUT_FILE may also be a file name pattern (e.g.,"
+      << " events_%04d.ascii) that\nselects every part of a rotating output"
+      << " file.\n";
+  }
 }
 
 int main(int argc, char* argv[]) {
 
+  #ifdef USE_ROOT
+    OutputFormat format = OutputFormat::ROOT;
+  #else
+    OutputFormat format = OutputFormat::BINARY;
+  #endif
+  size_t num_threads = 1u;
+  auto precision = marley::BinaryEventBlock::Precision::full;
+
+  // Parse any command-line options that precede the file names
+  int arg = 1;
+  while ( arg + 1 < argc && argv[arg][0] == '-' ) {
+    std::string option = argv[arg];
+    std::string value = argv[arg + 1];
+    arg += 2;
+
+    if ( option == "-j" ) {
+      long n = -1;
+      try { n = std::stol( value ); }
+      catch ( const std::exception& ) {}
+      if ( n < 0 ) {
+        std::cout << "Invalid number of threads \"" << value << "\"\n";
+        return 1;
+      }
+      num_threads = ( n == 0 ) ? std::max( 1u,
+        std::thread::hardware_concurrency() ) : static_cast<size_t>( n );
+    }
+    else if ( option == "-f" ) {
+      if ( value == "root" ) format = OutputFormat::ROOT;
+      else if ( value == "binary" ) format = OutputFormat::BINARY;
+      else {
+        std::cout << "Unrecognized output format \"" << value << "\"\n";
+        return 1;
+      }
+    }
+    else if ( option == "-p" ) {
+      if ( value == "double" ) precision
+        = marley::BinaryEventBlock::Precision::full;
+      else if ( value == "single" ) precision
+        = marley::BinaryEventBlock::Precision::single;
+      else {
+        std::cout << "Unrecognized precision \"" << value << "\"\n";
+        return 1;
+      }
+    }
+    else {
+      std::cout << "Unrecognized option \"" << option << "\"\n";
+      print_usage( argv[0] );
+      return 1;
+    }
+  }
+
   // If the user has not supplied enough command-line arguments, display the
   // standard help message and exit
-  if (argc <= 2) {
-    std::cout << "Usage: " << argv[0] << " OUTPUT_FILE INPUT_FILE...\n";
+  if ( argc - arg < 2 ) {
+    print_usage( argv[0] );
     return 0;
   }
 
-  // Temporary storage for output TTree branch variables
-  double Ex; // nuclear excitation energy
-  int twoJ; // two times the residue spin immediately after the two-two
-            // scattering reaction
-  int par; // integer representation of the intrinsic parity of the
-           // residue immediately following the two-two reaction
-  double flux_avg_tot_xsec; // flux-averaged total cross section
-  double Ev, KEv, pxv, pyv, pzv; // projectile
-  double Mt; // target mass
-  double El, KEl, pxl, pyl, pzl; // ejectile
-  double Er, KEr, pxr, pyr, pzr; // residue (after de-excitations)
-  int pdgv, pdgt, pdgl, pdgr; // PDG codes
-  int np; // number of de-excitation products (final-state particles other
-          // than the ejectile and residue)
-
-  // Inpormation about each of the other final-state particles
-  std::vector<int> PDGs;
-  std::vector<double> Es, KEs, pXs, pYs, pZs;
+  #ifndef USE_ROOT
+    if ( format == OutputFormat::ROOT ) {
+      std::cout << "This copy of marsum was built without ROOT support."
+        << " Only binary output is available.\n";
+      return 1;
+    }
+  #endif
+
+  std::string output_file_name = argv[arg];
 
   // Check whether the output file exists and warn the user before
   // overwriting it if it does
-  std::ifstream temp_stream( argv[1] );
+  std::ifstream temp_stream( output_file_name );
   if ( temp_stream ) {
     bool overwrite = marley_utils::prompt_yes_no(
-      "Really overwrite " + std::string(argv[1]) + '?');
+      "Really overwrite " + output_file_name + '?');
     if ( !overwrite ) {
       std::cout << "Action aborted.\n";
       return 0;
     }
   }
 
-  TFile out_tfile( argv[1], "recreate" );
-  TTree* out_tree = new TTree("mst", "MARLEY summary tree");
-
-  // projectile branches
-  out_tree->Branch("pdgv", &pdgv, "pdgv/I");
-  out_tree->Branch("Ev", &Ev, "Ev/D");
-  out_tree->Branch("KEv", &KEv, "KEv/D");
-  out_tree->Branch("pxv", &pxv, "pxv/D");
-  out_tree->Branch("pyv", &pyv, "pyv/D");
-  out_tree->Branch("pzv", &pzv, "pzv/D");
-
-  // target branches
-  out_tree->Branch("pdgt", &pdgt, "pdgt/I");
-  out_tree->Branch("Mt", &Mt, "Mt/D");
-
-  // ejectile branches
-  out_tree->Branch("pdgl", &pdgl, "pdgl/I");
-  out_tree->Branch("El", &El, "El/D");
-  out_tree->Branch("KEl", &KEl, "KEl/D");
-  out_tree->Branch("pxl", &pxl, "pxl/D");
-  out_tree->Branch("pyl", &pyl, "pyl/D");
-  out_tree->Branch("pzl", &pzl, "pzl/D");
-
-  // residue branches
-  out_tree->Branch("pdgr", &pdgr, "pdgr/I");
-  out_tree->Branch("Er", &Er, "Er/D");
-  out_tree->Branch("KEr", &KEr, "KEr/D");
-  out_tree->Branch("pxr", &pxr, "pxr/D");
-  out_tree->Branch("pyr", &pyr, "pyr/D");
-  out_tree->Branch("pzr", &pzr, "pzr/D");
-
-  // Nuclear excitation energy branch
-  out_tree->Branch("Ex", &Ex, "Ex/D");
-
-  // Spin and parity branches
-  out_tree->Branch("twoJ", &twoJ, "twoJ/I");
-  out_tree->Branch("parity", &par, "parity/I");
-
-  // De-excitation products (final-state particles other than the
-  // ejectile and ground-state residue)
-  out_tree->Branch("np", &np, "np/I");
-  out_tree->Branch("pdgp", PDGs.data(), "pdgp[np]/I");
-  out_tree->Branch("Ep",  Es.data(), "Ep[np]/D");
-  out_tree->Branch("KEp", KEs.data(), "KEp[np]/D");
-  out_tree->Branch("pxp", pXs.data(), "pxp[np]/D");
-  out_tree->Branch("pyp", pYs.data(), "pyp[np]/D");
-  out_tree->Branch("pzp", pZs.data(), "pzp[np]/D");
-
-  // Flux-averaged total cross section
-  out_tree->Branch("xsec", &flux_avg_tot_xsec, "xsec/D");
-
-  // Prepare to read the input file(s)
+  // Prepare to read the input file(s). A file name pattern (see
+  // marley::RotatingOutputFile) stands for every part of a rotating output
+  // file, which are read in order.
   std::vector<std::string> input_file_names;
-  for ( int i = 2; i < argc; ++i ) input_file_names.push_back( argv[i] );
-
-  // File loop
-  for ( const auto& file_name : input_file_names ) {
-
-    // Open the current file for reading
-    marley::RootEventFileReader refr( file_name );
-    std::cout << "Opened file \"" << file_name << "\"\n";
-
-    // Temporary object to use for reading in saved events
-    marley::Event ev;
-
-    // Event loop
-    int event_num = 0;
-    while ( refr >> ev ) {
-
-      if ( event_num % 1000 == 0 ) std::cout << "Event " << event_num << '\n';
-
-      PDGs.clear();
-      Es.clear();
-      KEs.clear();
-      pXs.clear();
-      pYs.clear();
-      pZs.clear();
-
-      pdgv = ev.projectile().pdg_code();
-      Ev = ev.projectile().total_energy();
-      KEv = ev.projectile().kinetic_energy();
-      pxv = ev.projectile().px();
-      pyv = ev.projectile().py();
-      pzv = ev.projectile().pz();
-
-      pdgt = ev.target().pdg_code();
-      Mt = ev.target().mass();
-
-      pdgl = ev.ejectile().pdg_code();
-      El = ev.ejectile().total_energy();
-      KEl = ev.ejectile().kinetic_energy();
-      pxl = ev.ejectile().px();
-      pyl = ev.ejectile().py();
-      pzl = ev.ejectile().pz();
-
-      pdgr = ev.residue().pdg_code();
-      Er = ev.residue().total_energy();
-      KEr = ev.residue().kinetic_energy();
-      pxr = ev.residue().px();
-      pyr = ev.residue().py();
-      pzr = ev.residue().pz();
-
-      Ex = ev.Ex();
-      twoJ = ev.twoJ();
-      par = static_cast<int>( ev.parity() );
-      flux_avg_tot_xsec = refr.flux_averaged_xsec();
-
-      const auto& fparts = ev.get_final_particles();
-      np = fparts.size() - FIRST_PROD_IDX;
-      for ( size_t j = FIRST_PROD_IDX; j < fparts.size(); ++j ) {
-        const auto* fp = fparts.at( j );
-        PDGs.push_back( fp->pdg_code() );
-        Es.push_back( fp->total_energy() );
-        KEs.push_back( fp->kinetic_energy() );
-        pXs.push_back( fp->px() );
-        pYs.push_back( fp->py() );
-        pZs.push_back( fp->pz() );
-      }
-
-      // Update the branch addresses (manipulating the vectors may have
-      // invalidated them)
-      out_tree->SetBranchAddress("pdgp", PDGs.data());
-      out_tree->SetBranchAddress("Ep",  Es.data());
-      out_tree->SetBranchAddress("KEp", KEs.data());
-      out_tree->SetBranchAddress("pxp", pXs.data());
-      out_tree->SetBranchAddress("pyp", pYs.data());
-      out_tree->SetBranchAddress("pzp", pZs.data());
+  for ( int i = arg + 1; i < argc; ++i ) {
+    std::string name = argv[i];
+    if ( !marley::RotatingOutputFile::is_pattern(name)
+      || std::ifstream(name).good() )
+    {
+      input_file_names.push_back( name );
+      continue;
+    }
 
-      out_tree->Fill();
+    auto parts = marley::RotatingOutputFile::find_parts( name );
+    if ( parts.empty() ) {
+      std::cout << "Could not find any parts matching the file name pattern"
+        << " \"" << name << "\"\n";
+      return 1;
+    }
+    input_file_names.insert( input_file_names.end(), parts.begin(),
+      parts.end() );
+  }
 
-      ++event_num;
-    } // event loop
-  } // file loop
+  #ifdef USE_ROOT
+    if ( format == OutputFormat::ROOT ) {
+      write_summary_tree( output_file_name, input_file_names, precision,
+        num_threads );
+      return 0;
+    }
+  #endif
 
-  out_tfile.cd();
-  out_tree->Write();
-  out_tfile.Close();
+  write_binary_file( output_file_name, input_file_names, precision,
+    num_threads );
   return 0;
 }
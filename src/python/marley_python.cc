@@ -0,0 +1,220 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Python bindings for MARLEY built using pybind11. The module exposes the
+// job configuration, the Generator, and batches of events. The columns of an
+// EventBatch are returned as numpy arrays that share memory with the batch
+// (no copies are made), so large numbers of events can be analyzed without
+// writing them to files first. Build the module using "make python" in the
+// build folder.
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventBatch.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+
+namespace py = pybind11;
+
+namespace {
+
+  // Returns a numpy array that views one of the columns of an EventBatch.
+  // The owner keeps the batch alive for as long as the array exists. The
+  // arrays are read-only because the batch stores the offsets that locate
+  // each event's particles.
+  template <typename T> py::array_t<T> column_view(
+    const std::vector<T>& column, py::handle owner )
+  {
+    py::array_t<T> result( { static_cast<py::ssize_t>(column.size()) },
+      { static_cast<py::ssize_t>(sizeof(T)) }, column.data(), owner );
+    py::detail::array_proxy( result.ptr() )->flags
+      &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return result;
+  }
+
+  // Registers a read-only property that returns a column of an EventBatch
+  // as a numpy array
+  template <typename T> void add_column( py::class_<marley::EventBatch,
+    std::shared_ptr<marley::EventBatch> >& cls, const char* name,
+    const std::vector<T>& (marley::EventBatch::*getter)() const,
+    const char* doc )
+  {
+    cls.def_property_readonly( name, [getter]( py::object self )
+      -> py::array_t<T>
+    {
+      const auto& batch = self.cast<const marley::EventBatch&>();
+      return column_view( (batch.*getter)(), self );
+    }, doc );
+  }
+
+  // Creates a new batch of events sampled from the configured neutrino
+  // source. The GIL is released while the events are generated.
+  std::shared_ptr<marley::EventBatch> create_batch( marley::Generator& gen,
+    size_t num_events )
+  {
+    auto batch = std::make_shared<marley::EventBatch>();
+    py::gil_scoped_release release;
+    gen.create_events( num_events, *batch );
+    return batch;
+  }
+
+  // Creates a new batch of events for a fixed projectile species, kinetic
+  // energy, atomic target, and direction
+  std::shared_ptr<marley::EventBatch> create_fixed_batch(
+    marley::Generator& gen, size_t num_events, int pdg_a, double KEa,
+    int pdg_atom, const std::array<double, 3>& dir_vec )
+  {
+    auto batch = std::make_shared<marley::EventBatch>();
+    py::gil_scoped_release release;
+    batch->reserve( num_events, 0u );
+    for ( size_t e = 0u; e < num_events; ++e ) {
+      batch->add_event( gen.create_event(pdg_a, KEa, pdg_atom, dir_vec) );
+    }
+    return batch;
+  }
+
+  // Evaluates the abundance-weighted total cross section (MeV^(-2) / atom)
+  // at each kinetic energy in a numpy array
+  py::array_t<double> total_xs_array( const marley::Generator& gen,
+    int pdg_a, py::array_t<double, py::array::c_style | py::array::forcecast>
+    KEas )
+  {
+    py::array_t<double> result( KEas.request().shape );
+    const double* in = KEas.data();
+    double* out = result.mutable_data();
+    size_t n = static_cast<size_t>( KEas.size() );
+    {
+      py::gil_scoped_release release;
+      gen.total_xs_batch( pdg_a, in, out, n );
+    }
+    return result;
+  }
+
+}
+
+PYBIND11_MODULE(marley, m) {
+
+  m.doc() = "Python bindings for MARLEY (Model of Argon Reaction Low Energy"
+    " Yields)";
+
+  py::register_exception<marley::Error>( m, "Error" );
+
+  py::class_<marley::EventBatch, std::shared_ptr<marley::EventBatch> >
+    batch( m, "EventBatch", "Structure-of-arrays storage for a batch of"
+    " events. Each column is returned as a read-only numpy array that shares"
+    " memory with the batch. The particles of event i occupy the indices"
+    " from first_particles[i] up to first_particles[i] + num_initials[i]"
+    " + num_finals[i]." );
+
+  batch.def( py::init<>() )
+    .def( "__len__", &marley::EventBatch::size )
+    .def_property_readonly( "num_particles",
+      &marley::EventBatch::num_particles,
+      "Total number of particles stored in the batch" );
+
+  add_column( batch, "Exs", &marley::EventBatch::Exs,
+    "Excitation energy of the residue for each event (MeV)" );
+  add_column( batch, "twoJs", &marley::EventBatch::twoJs,
+    "Two times the spin of the residue for each event" );
+  add_column( batch, "parities", &marley::EventBatch::parities,
+    "Parity of the residue for each event" );
+  add_column( batch, "weights", &marley::EventBatch::weights,
+    "Weight of each event" );
+  add_column( batch, "times", &marley::EventBatch::times,
+    "Projectile emission time for each event" );
+  add_column( batch, "num_initials", &marley::EventBatch::num_initials,
+    "Number of initial particles in each event" );
+  add_column( batch, "num_finals", &marley::EventBatch::num_finals,
+    "Number of final particles in each event" );
+  add_column( batch, "first_particles", &marley::EventBatch::first_particles,
+    "Index of each event's first particle in the particle columns" );
+  add_column( batch, "pdgs", &marley::EventBatch::pdgs,
+    "PDG code of each particle" );
+  add_column( batch, "Es", &marley::EventBatch::Es,
+    "Total energy of each particle (MeV)" );
+  add_column( batch, "pxs", &marley::EventBatch::pxs,
+    "x-component of the 3-momentum of each particle (MeV)" );
+  add_column( batch, "pys", &marley::EventBatch::pys,
+    "y-component of the 3-momentum of each particle (MeV)" );
+  add_column( batch, "pzs", &marley::EventBatch::pzs,
+    "z-component of the 3-momentum of each particle (MeV)" );
+  add_column( batch, "masses", &marley::EventBatch::masses,
+    "Mass of each particle (MeV)" );
+  add_column( batch, "charges", &marley::EventBatch::charges,
+    "Charge of each particle (in units of the elementary charge)" );
+
+  py::class_<marley::Generator>( m, "Generator", "MARLEY event generator."
+    " A Generator may be used by only one Python thread at a time, but"
+    " separate Generator objects may create events in parallel." )
+    .def( "create_events", &create_batch, py::arg("num_events"),
+      "Create a new EventBatch holding events sampled from the configured"
+      " neutrino source" )
+    .def( "create_events", &create_fixed_batch, py::arg("num_events"),
+      py::arg("pdg_a"), py::arg("KEa"), py::arg("pdg_atom"),
+      py::arg("direction") = std::array<double, 3>{ 0., 0., 1. },
+      "Create a new EventBatch holding events for a fixed projectile"
+      " species, kinetic energy (MeV), atomic target, and direction" )
+    .def( "total_xs", &total_xs_array, py::arg("pdg_a"), py::arg("KEas"),
+      "Abundance-weighted total cross section (MeV^-2 / atom) at each"
+      " projectile kinetic energy (MeV) in an array" )
+    .def( "total_xs", py::overload_cast<int, double, int>(
+      &marley::Generator::total_xs, py::const_ ), py::arg("pdg_a"),
+      py::arg("KEa"), py::arg("pdg_atom"), "Total cross section"
+      " (MeV^-2) for a projectile striking a single atomic target" )
+    .def( "flux_averaged_total_xs",
+      &marley::Generator::flux_averaged_total_xs,
+      "Flux-averaged total cross section (MeV^-2) for the configured"
+      " neutrino source" )
+    .def( "reseed", &marley::Generator::reseed, py::arg("seed"),
+      "Reseed the random number engine" )
+    .def( "set_reaction_enabled", &marley::Generator::set_reaction_enabled,
+      py::arg("index"), py::arg("enabled"), "Enable or disable the reaction"
+      " at the given position in the list of configured reactions" )
+    .def( "reaction_enabled", &marley::Generator::reaction_enabled,
+      py::arg("index"), "Whether the reaction at the given position is"
+      " enabled" )
+    .def_property_readonly( "seed", &marley::Generator::get_seed )
+    .def_property( "event_number", &marley::Generator::get_event_number,
+      &marley::Generator::set_event_number, "Number of the next event"
+      " (used by the counter-based random number engine)" );
+
+  py::class_<marley::JSONConfig>( m, "JSONConfig", "Job configuration"
+    " loaded from the same JSON format used by the marley executable" )
+    .def( py::init<const std::string&>(), py::arg("file_name") )
+    .def_static( "from_string", []( const std::string& text )
+      -> marley::JSONConfig
+    {
+      return marley::JSONConfig( marley::JSON::load(text) );
+    }, py::arg("text"), "Create a JSONConfig from JSON text" )
+    .def( "create_generator", []( const marley::JSONConfig& jc )
+      -> std::unique_ptr<marley::Generator>
+    {
+      return std::make_unique<marley::Generator>( jc.create_generator() );
+    }, "Create a Generator using the configuration" )
+    .def( "reconfigure", &marley::JSONConfig::reconfigure, py::arg("gen"),
+      "Apply the source, target, direction, and enabled reactions from the"
+      " configuration to an existing Generator, keeping its caches" );
+}
@@ -0,0 +1,258 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/ArrayFile.hh"
+#include "marley/Error.hh"
+
+namespace {
+
+  const std::string FILE_NAME = "marley_test_array.npy";
+
+  bool host_is_little_endian() {
+    const uint16_t one = 1u;
+    unsigned char byte;
+    std::memcpy( &byte, &one, 1u );
+    return byte == 1u;
+  }
+
+  // Appends the bytes of a value in the requested byte order
+  template <typename T> void append_value( std::string& bytes, T value,
+    bool big_endian )
+  {
+    char buffer[ sizeof(T) ];
+    std::memcpy( buffer, &value, sizeof(T) );
+    if ( big_endian == host_is_little_endian() ) {
+      std::reverse( buffer, buffer + sizeof(T) );
+    }
+    bytes.append( buffer, sizeof(T) );
+  }
+
+  // Builds the contents of a .npy file with the given header dictionary.
+  // The header is padded so that the data begin on a 64-byte boundary.
+  std::string make_npy( const std::string& dict, const std::string& data,
+    int major_version = 1 )
+  {
+    size_t length_size = ( major_version >= 2 ) ? 4u : 2u;
+    std::string header = dict;
+    size_t prefix_size = 8u + length_size;
+    while ( (prefix_size + header.size() + 1u) % 64u != 0u ) header += ' ';
+    header += '\n';
+
+    std::string bytes( "\x93NUMPY", 6u );
+    bytes += static_cast<char>( major_version );
+    bytes += '\0';
+    if ( length_size == 4u ) {
+      append_value( bytes, static_cast<uint32_t>(header.size()), false );
+    }
+    else append_value( bytes, static_cast<uint16_t>(header.size()), false );
+    return bytes + header + data;
+  }
+
+  // Returns the values stored using the requested type and byte order
+  template <typename T> std::string make_data(
+    const std::vector<double>& values, bool big_endian = false )
+  {
+    std::string bytes;
+    for ( double v : values ) {
+      append_value( bytes, static_cast<T>(v), big_endian );
+    }
+    return bytes;
+  }
+
+  void write_file( const std::string& contents ) {
+    std::ofstream out( FILE_NAME, std::ios::binary | std::ios::trunc );
+    out.write( contents.data(), contents.size() );
+  }
+
+  // Values of the 3x2 test array in C (row-major) order
+  const std::vector<double> VALUES = { 1.5, -2., 3.25, 4., -5.75, 6.125 };
+
+  // The same array in Fortran (column-major) order
+  const std::vector<double> VALUES_F = { 1.5, 3.25, -5.75, -2., 4., 6.125 };
+
+  void check_3x2( const marley::ArrayFile& af ) {
+    REQUIRE( af.rows() == 3u );
+    REQUIRE( af.columns() == 2u );
+    for ( size_t r = 0u; r < 3u; ++r ) {
+      for ( size_t c = 0u; c < 2u; ++c ) {
+        INFO( "Row " << r << ", column " << c );
+        CHECK( af.value(r, c) == VALUES.at(2u*r + c) );
+      }
+    }
+    CHECK( af.column(0u) == std::vector<double>({ 1.5, 3.25, -5.75 }) );
+    CHECK( af.column(1u) == std::vector<double>({ -2., 4., 6.125 }) );
+  }
+
+}
+
+TEST_CASE( "Headers of .npy files are parsed", "[array_file]" )
+{
+  SECTION( "Version 1 header, C order" ) {
+    write_file( make_npy( "{'descr': '<f8', 'fortran_order': False,"
+      " 'shape': (3, 2), }", make_data<double>(VALUES) ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+  }
+
+  SECTION( "Version 2 header" ) {
+    write_file( make_npy( "{'descr': '<f8', 'fortran_order': False,"
+      " 'shape': (3, 2), }", make_data<double>(VALUES), 2 ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+  }
+
+  SECTION( "Fortran order" ) {
+    write_file( make_npy( "{'descr': '<f8', 'fortran_order': True,"
+      " 'shape': (3, 2), }", make_data<double>(VALUES_F) ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+  }
+
+  SECTION( "Single precision" ) {
+    write_file( make_npy( "{'descr': '<f4', 'fortran_order': False,"
+      " 'shape': (3, 2), }", make_data<float>(VALUES) ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+  }
+
+  SECTION( "Big-endian values" ) {
+    write_file( make_npy( "{'descr': '>f8', 'fortran_order': False,"
+      " 'shape': (3, 2), }", make_data<double>(VALUES, true) ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+
+    write_file( make_npy( "{'descr': '>f4', 'fortran_order': True,"
+      " 'shape': (3, 2), }", make_data<float>(VALUES_F, true) ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+  }
+
+  SECTION( "Key order and spacing don't matter" ) {
+    write_file( make_npy( "{'shape':(3,2),'fortran_order':False,"
+      "'descr':'<f8'}", make_data<double>(VALUES) ) );
+    check_3x2( marley::ArrayFile(FILE_NAME) );
+  }
+
+  SECTION( "1D arrays have a single column" ) {
+    write_file( make_npy( "{'descr': '<f8', 'fortran_order': False,"
+      " 'shape': (6,), }", make_data<double>(VALUES) ) );
+    marley::ArrayFile af( FILE_NAME );
+    CHECK( af.rows() == 6u );
+    CHECK( af.columns() == 1u );
+    CHECK( af.column(0u) == VALUES );
+    CHECK( af.value(4u, 0u) == -5.75 );
+    CHECK_THROWS_AS( af.value(6u, 0u), marley::Error );
+    CHECK_THROWS_AS( af.column(1u), marley::Error );
+  }
+
+  SECTION( "Empty arrays" ) {
+    write_file( make_npy( "{'descr': '<f8', 'fortran_order': False,"
+      " 'shape': (0, 2), }", "" ) );
+    marley::ArrayFile af( FILE_NAME );
+    CHECK( af.rows() == 0u );
+    CHECK( af.columns() == 2u );
+    CHECK( af.column(1u).empty() );
+  }
+
+  std::remove( FILE_NAME.c_str() );
+}
+
+TEST_CASE( "Malformed .npy files are rejected", "[array_file]" )
+{
+  const std::string data = make_data<double>( VALUES );
+
+  SECTION( "Unsupported data types" ) {
+    for ( const char* descr : { "'<i4'", "'|u1'", "'<f2'", "'<c16'",
+      "'<f16'", "<f8" } )
+    {
+      INFO( "descr = " << descr );
+      write_file( make_npy( std::string("{'descr': ") + descr
+        + ", 'fortran_order': False, 'shape': (3, 2), }", data ) );
+      CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME), marley::Error );
+    }
+  }
+
+  SECTION( "Unknown byte order" ) {
+    write_file( make_npy( "{'descr': '?f8', 'fortran_order': False,"
+      " 'shape': (3, 2), }", data ) );
+    CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME), marley::Error );
+  }
+
+  SECTION( "Missing keys" ) {
+    for ( const char* dict : {
+      "{'fortran_order': False, 'shape': (3, 2), }",
+      "{'descr': '<f8', 'shape': (3, 2), }",
+      "{'descr': '<f8', 'fortran_order': False, }" } )
+    {
+      INFO( "Header: " << dict );
+      write_file( make_npy(dict, data) );
+      CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME), marley::Error );
+    }
+  }
+
+  SECTION( "Invalid shapes" ) {
+    for ( const char* shape : { "3, 2", "[3, 2]", "(3, 2", "()",
+      "(1, 3, 2)" } )
+    {
+      INFO( "shape = " << shape );
+      write_file( make_npy( std::string("{'descr': '<f8',"
+        " 'fortran_order': False, 'shape': ") + shape + ", }", data ) );
+      CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME), marley::Error );
+    }
+  }
+
+  SECTION( "Truncated files" ) {
+    std::string full = make_npy( "{'descr': '<f8', 'fortran_order': False,"
+      " 'shape': (3, 2), }", data );
+    size_t header_end = full.size() - data.size();
+    // Cut inside the version bytes, the header length, the header itself,
+    // and the data
+    for ( size_t size : { size_t(7u), size_t(9u), size_t(30u),
+      header_end - 1u, full.size() - 1u } )
+    {
+      INFO( "File size " << size );
+      write_file( full.substr(0u, size) );
+      CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME), marley::Error );
+    }
+  }
+
+  std::remove( FILE_NAME.c_str() );
+}
+
+TEST_CASE( "Headerless files hold little-endian doubles", "[array_file]" )
+{
+  std::string data;
+  for ( double v : VALUES ) append_value( data, v, false );
+  write_file( data );
+
+  check_3x2( marley::ArrayFile(FILE_NAME, 2u) );
+
+  marley::ArrayFile single( FILE_NAME );
+  CHECK( single.rows() == 6u );
+  CHECK( single.column(0u) == VALUES );
+
+  CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME, 4u), marley::Error );
+  CHECK_THROWS_AS( marley::ArrayFile(FILE_NAME, 0u), marley::Error );
+
+  std::remove( FILE_NAME.c_str() );
+}
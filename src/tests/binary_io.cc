@@ -0,0 +1,201 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/BinaryEventBlock.hh"
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/MappedEventFileReader.hh"
+#include "marley/OutputFile.hh"
+
+namespace {
+
+  using Precision = marley::BinaryEventBlock::Precision;
+
+  // Spans several blocks of the binary format, with a partial final block
+  constexpr int NUM_EVENTS = 2500;
+
+  // Returns true if two doubles have the same bit pattern
+  bool same_bits( double a, double b ) {
+    return std::memcmp( &a, &b, sizeof(double) ) == 0;
+  }
+
+  // Rounds a double to single precision and back
+  double round_to_float( double x ) {
+    return static_cast<double>( static_cast<float>(x) );
+  }
+
+  // Generates events using a job configuration given as JSON text
+  void generate_events( const std::string& json_text,
+    std::vector<marley::Event>& events, int num_events )
+  {
+    marley::JSONConfig config( marley::JSON::load(json_text) );
+    marley::Generator gen = config.create_generator();
+    for ( int e = 0; e < num_events; ++e ) {
+      events.push_back( gen.create_event() );
+    }
+  }
+
+  // Checks that an event read from a file matches the one that was written.
+  // The particle kinematics read from a single-precision file are compared
+  // with the originals after rounding the kinetic energy and 3-momentum to
+  // single precision.
+  void check_event( const marley::Event& read, const marley::Event& written,
+    Precision precision )
+  {
+    CHECK( same_bits(read.Ex(), written.Ex()) );
+    CHECK( read.twoJ() == written.twoJ() );
+    CHECK( read.parity() == written.parity() );
+    CHECK( same_bits(read.weight(), written.weight()) );
+    CHECK( same_bits(read.time(), written.time()) );
+
+    const auto& ri = read.get_initial_particles();
+    const auto& wi = written.get_initial_particles();
+    const auto& rf = read.get_final_particles();
+    const auto& wf = written.get_final_particles();
+    REQUIRE( ri.size() == wi.size() );
+    REQUIRE( rf.size() == wf.size() );
+
+    std::vector<const marley::Particle*> rps, wps;
+    for ( size_t p = 0u; p < ri.size(); ++p ) {
+      rps.push_back( &ri[p] );
+      wps.push_back( &wi[p] );
+    }
+    for ( size_t p = 0u; p < rf.size(); ++p ) {
+      rps.push_back( &rf[p] );
+      wps.push_back( &wf[p] );
+    }
+
+    for ( size_t p = 0u; p < rps.size(); ++p ) {
+      const marley::Particle& r = *rps[p];
+      const marley::Particle& w = *wps[p];
+      INFO( "Particle " << p << " with PDG code " << w.pdg_code() );
+
+      CHECK( r.pdg_code() == w.pdg_code() );
+      CHECK( same_bits(r.mass(), w.mass()) );
+      CHECK( same_bits(r.charge(), w.charge()) );
+
+      if ( precision == Precision::full ) {
+        CHECK( same_bits(r.total_energy(), w.total_energy()) );
+        CHECK( same_bits(r.px(), w.px()) );
+        CHECK( same_bits(r.py(), w.py()) );
+        CHECK( same_bits(r.pz(), w.pz()) );
+      }
+      else {
+        double KE = round_to_float( w.total_energy() - w.mass() );
+        CHECK( same_bits(r.total_energy(), KE + w.mass()) );
+        CHECK( same_bits(r.px(), round_to_float(w.px())) );
+        CHECK( same_bits(r.py(), round_to_float(w.py())) );
+        CHECK( same_bits(r.pz(), round_to_float(w.pz())) );
+      }
+    }
+  }
+
+}
+
+TEST_CASE( "Events survive a round trip through the binary format",
+  "[binary_io]" )
+{
+  // Combine events with nonzero times (neutrino-electron elastic scattering
+  // from a time-binned source) and low-energy nuclear recoils (CEvNS)
+  std::vector<marley::Event> events;
+  generate_events( "{ seed: 123456,"
+    " target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },"
+    " reactions: [ \"ES.react\" ],"
+    " source: { type: \"time-binned\", neutrino: \"ve\","
+    "   time_edges: [ 0., 1., 3. ], weights: [ 1., 2. ],"
+    "   bins: [ { type: \"dar\" }, { type: \"fermi-dirac\","
+    "     Emin: 0., Emax: 50., temperature: 3.5 } ] },"
+    " log: [ { file: \"stdout\", level: \"warning\" } ] }",
+    events, NUM_EVENTS / 2 );
+
+  generate_events( "{ seed: 654321,"
+    " reactions: [ \"CEvNS40Ar.react\" ], cevns_engine: \"coherent\","
+    " source: { type: \"dar\", neutrino: \"vu\" },"
+    " log: [ { file: \"stdout\", level: \"warning\" } ] }",
+    events, NUM_EVENTS - NUM_EVENTS / 2 );
+
+  for ( Precision precision : { Precision::full, Precision::single } ) {
+
+    bool single = ( precision == Precision::single );
+    INFO( "Precision: " << ( single ? "single" : "full" ) );
+    const std::string file_name = single ? "marley_test_single.bin"
+      : "marley_test_full.bin";
+
+    {
+      marley::BinaryOutputFile out( file_name, "binary", "overwrite", true,
+        marley::BinaryEventBlock::Layout::event, precision );
+      for ( const auto& ev : events ) out.write_event( &ev );
+      out.close( marley::JSON::object(), marley::OutputFile::GeneratorState(),
+        events.size() );
+    }
+
+    SECTION( std::string("EventFileReader, ")
+      + ( single ? "single" : "full" ) + " precision" )
+    {
+      marley::EventFileReader reader( file_name );
+      marley::Event ev;
+      size_t e = 0u;
+      while ( reader >> ev ) {
+        REQUIRE( e < events.size() );
+        INFO( "Event " << e );
+        check_event( ev, events.at(e), precision );
+        ++e;
+      }
+      CHECK( e == events.size() );
+    }
+
+    SECTION( std::string("MappedEventFileReader, ")
+      + ( single ? "single" : "full" ) + " precision" )
+    {
+      marley::MappedEventFileReader reader( file_name );
+      REQUIRE( reader.num_events() == events.size() );
+
+      marley::Event ev;
+      size_t e = 0u;
+      while ( reader >> ev ) {
+        REQUIRE( e < events.size() );
+        INFO( "Event " << e );
+        check_event( ev, events.at(e), precision );
+        ++e;
+      }
+      CHECK( e == events.size() );
+
+      // Random access should give the same results
+      for ( size_t index : { size_t(0u), size_t(1023u), size_t(1024u),
+        events.size() - 1u, size_t(7u) } )
+      {
+        INFO( "Event " << index );
+        reader.get_event( index, ev );
+        check_event( ev, events.at(index), precision );
+      }
+    }
+
+    std::remove( file_name.c_str() );
+  }
+}
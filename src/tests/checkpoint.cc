@@ -0,0 +1,162 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/EventFileReader.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/OutputFile.hh"
+
+namespace {
+
+  constexpr long NUM_EVENTS = 300;
+
+  // Number of events written before the checkpoint is taken
+  constexpr long NUM_CHECKPOINT_EVENTS = 120;
+
+  // Number of events written after the checkpoint but before the simulated
+  // crash. These will be discarded when the run is continued.
+  constexpr long NUM_LOST_EVENTS = 50;
+
+  // Opens an output file in the requested format and mode
+  std::unique_ptr<marley::OutputFile> open_file( const std::string& name,
+    const std::string& format, const std::string& mode )
+  {
+    if ( format == "binary" ) {
+      return std::make_unique<marley::BinaryOutputFile>( name, format, mode,
+        true );
+    }
+    return std::make_unique<marley::TextOutputFile>( name, format, mode,
+      true );
+  }
+
+  void write_events( marley::Generator& gen, marley::OutputFile& file,
+    long num_events )
+  {
+    for ( long e = 0; e < num_events; ++e ) {
+      marley::Event ev = gen.create_event();
+      file.write_event( &ev );
+    }
+  }
+
+  std::string read_file( const std::string& name ) {
+    std::ifstream in( name, std::ios::binary );
+    return std::string( std::istreambuf_iterator<char>(in),
+      std::istreambuf_iterator<char>() );
+  }
+
+  // Returns the ASCII representation of every event stored in a file. The
+  // doubles are printed so that they read back exactly, so equal strings
+  // imply bit-identical events.
+  std::string read_events( const std::string& name ) {
+    marley::EventFileReader reader( name );
+    marley::Event ev;
+    std::ostringstream out;
+    while ( reader >> ev ) out << ev << '\n';
+    return out.str();
+  }
+
+}
+
+TEST_CASE( "Continuing from a checkpoint reproduces an uninterrupted run",
+  "[checkpoint]" )
+{
+  for ( const char* engine : { "mt19937_64", "philox" } ) {
+    marley::JSON config = marley::JSON::load( "{ seed: 123456,"
+      " target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },"
+      " reactions: [ \"ES.react\" ],"
+      " source: { type: \"dar\", neutrino: \"ve\" },"
+      " random_engine: { type: \"" + std::string(engine) + "\" },"
+      " log: [ { file: \"stdout\", level: \"warning\" } ] }" );
+    marley::JSONConfig jc( config );
+
+    for ( const char* format : { "ascii", "hepevt", "json", "binary" } ) {
+      INFO( "Engine " << engine << ", format " << format );
+      const std::string ref_name = std::string( "marley_test_ref." )
+        + format;
+      const std::string name = std::string( "marley_test_checkpoint." )
+        + format;
+
+      // Uninterrupted run
+      {
+        marley::Generator gen = jc.create_generator();
+        auto file = open_file( ref_name, format, "overwrite" );
+        write_events( gen, *file, NUM_EVENTS );
+        file->close( config, gen, NUM_EVENTS );
+      }
+
+      // Run that takes a checkpoint and then stops without closing the
+      // output file
+      marley::JSON file_state;
+      std::string seed_string, state_string;
+      {
+        marley::Generator gen = jc.create_generator();
+        auto file = open_file( name, format, "overwrite" );
+        REQUIRE( file->supports_checkpoints() );
+        write_events( gen, *file, NUM_CHECKPOINT_EVENTS );
+
+        file_state = file->checkpoint( NUM_CHECKPOINT_EVENTS );
+        seed_string = std::to_string( gen.get_seed() );
+        state_string = gen.get_state_string();
+
+        write_events( gen, *file, NUM_LOST_EVENTS );
+      }
+
+      // Continue from the checkpoint in the same way as the marley
+      // executable
+      {
+        marley::Generator gen = jc.create_generator();
+        gen.reseed( std::stoull(seed_string) );
+        gen.seed_using_state_string( state_string );
+
+        auto file = open_file( name, format, "restart" );
+        file->restart( file_state );
+        write_events( gen, *file, NUM_EVENTS - NUM_CHECKPOINT_EVENTS );
+        file->close( config, gen, NUM_EVENTS );
+      }
+
+      // Text files should be byte-identical. A binary file ends its current
+      // event block at each checkpoint, so the same events are compared
+      // instead.
+      if ( std::string(format) == "binary" ) {
+        std::string expected = read_events( ref_name );
+        CHECK( !expected.empty() );
+        CHECK( read_events(name) == expected );
+      }
+      else {
+        std::string expected = read_file( ref_name );
+        CHECK( !expected.empty() );
+        CHECK( read_file(name) == expected );
+      }
+
+      std::remove( ref_name.c_str() );
+      std::remove( name.c_str() );
+    }
+  }
+}
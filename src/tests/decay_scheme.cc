@@ -0,0 +1,232 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cmath>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/marley_utils.hh"
+#include "marley/DecayScheme.hh"
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/Level.hh"
+#include "marley/MassTable.hh"
+#include "marley/Parity.hh"
+#include "marley/Particle.hh"
+
+namespace {
+
+  constexpr int Z = 18;
+  constexpr int A = 40;
+
+  constexpr size_t NUM_CASCADES = 200000u;
+
+  // Excitation energies (MeV) of the levels in the test decay scheme. The
+  // level at 1 MeV has no gammas, so cascades can end there as well as in
+  // the ground state.
+  const std::vector<double> LEVEL_ENERGIES = { 0., 1., 1.5, 2.2, 3., 3.7,
+    4.5 };
+  constexpr size_t ISOMER = 1u;
+
+  // Builds a decay scheme in which every excited level except the isomer
+  // emits gammas to all of the lower levels. The uneven relative
+  // intensities give many cascades with a wide range of probabilities.
+  void fill_decay_scheme( marley::DecayScheme& ds ) {
+    std::vector<marley::Level*> levels;
+    for ( double E : LEVEL_ENERGIES ) {
+      levels.push_back( &ds.add_level(marley::Level(E, 0,
+        marley::Parity(true))) );
+    }
+    for ( size_t k = 2u; k < levels.size(); ++k ) {
+      for ( size_t f = 0u; f < k; ++f ) {
+        double intensity = 1. + ( (3u*k + 5u*f) % 7u );
+        levels[ k ]->add_gamma( LEVEL_ENERGIES[k] - LEVEL_ENERGIES[f],
+          intensity, levels[f] );
+      }
+    }
+  }
+
+  // Exact probability of each (final level, gamma multiplicity) pair for
+  // cascades that begin at level k, indexed as [final level][multiplicity]
+  using Table = std::vector< std::vector<double> >;
+
+  Table exact_probabilities( const marley::DecayScheme& ds, size_t k ) {
+    size_t num_levels = LEVEL_ENERGIES.size();
+    Table probs( num_levels, std::vector<double>(num_levels, 0.) );
+    const auto& gammas = ds.get_levels().at( k )->gammas();
+    if ( gammas.empty() ) {
+      probs[ k ][ 0 ] = 1.;
+      return probs;
+    }
+
+    double total = 0.;
+    for ( const auto& g : gammas ) total += g.relative_intensity();
+    for ( const auto& g : gammas ) {
+      size_t f = 0u;
+      while ( ds.get_levels().at(f).get() != g.end_level() ) ++f;
+      Table sub = exact_probabilities( ds, f );
+      for ( size_t e = 0u; e < num_levels; ++e ) {
+        for ( size_t m = 0u; m + 1u < num_levels; ++m ) {
+          probs[ e ][ m + 1u ] += g.relative_intensity() / total
+            * sub[ e ][ m ];
+        }
+      }
+    }
+    return probs;
+  }
+
+  // Simulates cascades that begin at level k and counts the final levels
+  // and gamma multiplicities
+  Table sample_frequencies( marley::DecayScheme& ds, size_t k,
+    marley::Generator& gen )
+  {
+    const marley::MassTable& mt = marley::MassTable::Instance();
+    int pdg = marley_utils::get_nucleus_pid( Z, A );
+    double gs_mass = mt.get_atomic_mass( pdg );
+
+    marley::Level& initial_level = *ds.get_levels().at( k );
+    marley::Event base_event( initial_level.energy() );
+    base_event.residue() = marley::Particle( pdg,
+      gs_mass + initial_level.energy(), 0 );
+
+    size_t num_levels = LEVEL_ENERGIES.size();
+    Table counts( num_levels, std::vector<double>(num_levels, 0.) );
+    marley::Event ev;
+    for ( size_t c = 0u; c < NUM_CASCADES; ++c ) {
+      ev = base_event;
+      ds.do_cascade( initial_level, ev, gen, 0 );
+
+      // Identify the final level using the mass of the residue
+      double Ex = ev.residue().mass() - gs_mass;
+      size_t e = 0u;
+      for ( size_t f = 1u; f < num_levels; ++f ) {
+        if ( std::abs(Ex - LEVEL_ENERGIES[f])
+          < std::abs(Ex - LEVEL_ENERGIES[e]) ) e = f;
+      }
+      size_t multiplicity = ev.final_particle_count() - 2u;
+      if ( multiplicity >= num_levels ) FAIL( "Too many gammas" );
+      counts[ e ][ multiplicity ] += 1.;
+    }
+
+    for ( auto& row : counts ) for ( auto& n : row ) n /= NUM_CASCADES;
+    return counts;
+  }
+
+  // Checks that sampled frequencies agree with the expected probabilities
+  // to within five standard deviations
+  void check_frequencies( const Table& freqs, const Table& probs ) {
+    size_t num_levels = LEVEL_ENERGIES.size();
+    std::vector<double> level_freqs( num_levels, 0. );
+    std::vector<double> level_probs( num_levels, 0. );
+    std::vector<double> mult_freqs( num_levels, 0. );
+    std::vector<double> mult_probs( num_levels, 0. );
+    for ( size_t e = 0u; e < num_levels; ++e ) {
+      for ( size_t m = 0u; m < num_levels; ++m ) {
+        level_freqs[ e ] += freqs[ e ][ m ];
+        level_probs[ e ] += probs[ e ][ m ];
+        mult_freqs[ m ] += freqs[ e ][ m ];
+        mult_probs[ m ] += probs[ e ][ m ];
+      }
+    }
+
+    auto check = []( double freq, double prob ) {
+      double sigma = std::sqrt( prob * (1. - prob) / NUM_CASCADES );
+      CHECK( std::abs(freq - prob) <= 5.*sigma );
+    };
+
+    for ( size_t e = 0u; e < num_levels; ++e ) {
+      INFO( "Final level " << e );
+      check( level_freqs[e], level_probs[e] );
+    }
+    for ( size_t m = 0u; m < num_levels; ++m ) {
+      INFO( "Multiplicity " << m );
+      check( mult_freqs[m], mult_probs[m] );
+    }
+  }
+
+}
+
+TEST_CASE( "Cascade path tables sample the same cascades as step-by-step"
+  " sampling", "[decay_scheme]" )
+{
+  marley::DecayScheme ds( Z, A );
+  fill_decay_scheme( ds );
+
+  marley::Generator gen;
+  gen.reseed( 123456u );
+
+  size_t top = LEVEL_ENERGIES.size() - 1u;
+  Table probs = exact_probabilities( ds, top );
+
+  // Both cascade endings should be possible
+  double isomer_prob = 0.;
+  for ( double p : probs[ISOMER] ) isomer_prob += p;
+  REQUIRE( isomer_prob > 0.05 );
+  REQUIRE( isomer_prob < 0.95 );
+
+  Table step_freqs = sample_frequencies( ds, top, gen );
+  {
+    INFO( "Step-by-step sampling" );
+    check_frequencies( step_freqs, probs );
+  }
+
+  // Store only a few paths for each level so that many cascades are
+  // sampled by sample_unlisted_path(), then list nearly all of them
+  for ( size_t max_paths : { size_t(1u), size_t(4u),
+    marley::DecayScheme::DEFAULT_MAX_CASCADE_PATHS } )
+  {
+    for ( double tolerance : { 1e-3, 0.3 } ) {
+      INFO( "Path tables with tolerance " << tolerance << " and at most "
+        << max_paths << " paths" );
+      ds.set_cascade_path_tolerance( tolerance, max_paths );
+      ds.build_cascade_table();
+      Table path_freqs = sample_frequencies( ds, top, gen );
+      check_frequencies( path_freqs, probs );
+
+      // Compare with the step-by-step sample as well. The two independent
+      // samples give twice the variance.
+      for ( size_t e = 0u; e < LEVEL_ENERGIES.size(); ++e ) {
+        for ( size_t m = 0u; m < LEVEL_ENERGIES.size(); ++m ) {
+          double p = probs[ e ][ m ];
+          double sigma = std::sqrt( 2. * p * (1. - p) / NUM_CASCADES );
+          INFO( "Final level " << e << ", multiplicity " << m );
+          CHECK( std::abs(path_freqs[e][m] - step_freqs[e][m])
+            <= 5.*sigma );
+        }
+      }
+    }
+  }
+
+  // Cascades from a level without gammas emit nothing
+  ds.set_cascade_path_tolerance( 0.01 );
+  Table isomer_freqs = sample_frequencies( ds, ISOMER, gen );
+  CHECK( isomer_freqs[ ISOMER ][ 0 ] == 1. );
+}
+
+TEST_CASE( "Invalid cascade path settings are rejected", "[decay_scheme]" )
+{
+  marley::DecayScheme ds( Z, A );
+  CHECK_THROWS_AS( ds.set_cascade_path_tolerance(-0.1), marley::Error );
+  CHECK_THROWS_AS( ds.set_cascade_path_tolerance(1.), marley::Error );
+  CHECK_THROWS_AS( ds.set_cascade_path_tolerance(0.1, 0u), marley::Error );
+  ds.set_cascade_path_tolerance( 0.1, 8u );
+  CHECK( ds.get_cascade_path_tolerance() == 0.1 );
+}
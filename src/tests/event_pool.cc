@@ -0,0 +1,152 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Error.hh"
+#include "marley/Event.hh"
+#include "marley/EventPool.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+
+namespace {
+
+  constexpr size_t NUM_CONSUMERS = 3u;
+  constexpr size_t NUM_EVENTS = 500u;
+
+  // Creates a Generator for neutrino-electron elastic scattering with the
+  // given seed
+  std::unique_ptr<marley::Generator> make_generator( long seed ) {
+    marley::JSONConfig config( marley::JSON::load( "{ seed: "
+      + std::to_string(seed) + ","
+      " target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },"
+      " reactions: [ \"ES.react\" ],"
+      " source: { type: \"dar\", neutrino: \"ve\" },"
+      " log: [ { file: \"stdout\", level: \"warning\" } ] }" ) );
+    return std::make_unique<marley::Generator>( config.create_generator() );
+  }
+
+  // Returns the ASCII representation of an event. The doubles are printed
+  // so that they read back exactly, so equal strings imply bit-identical
+  // events.
+  std::string to_string( const marley::Event& ev ) {
+    std::ostringstream out;
+    out << ev;
+    return out.str();
+  }
+
+  // Creates the events expected for each consumer using Generators that
+  // are seeded in the same way as the ones owned by the pool
+  std::vector< std::vector<std::string> > expected_events() {
+    std::vector< std::vector<std::string> > expected( NUM_CONSUMERS );
+    for ( size_t c = 0u; c < NUM_CONSUMERS; ++c ) {
+      auto gen = make_generator( 1000 + c );
+      for ( const auto& ev : gen->create_events(NUM_EVENTS) ) {
+        expected.at( c ).push_back( to_string(ev) );
+      }
+    }
+    return expected;
+  }
+
+  std::vector< std::unique_ptr<marley::Generator> > pool_generators() {
+    std::vector< std::unique_ptr<marley::Generator> > gens;
+    for ( size_t c = 0u; c < NUM_CONSUMERS; ++c ) {
+      gens.push_back( make_generator(1000 + c) );
+    }
+    return gens;
+  }
+
+}
+
+TEST_CASE( "EventPool consumers receive the events of their Generator in"
+  " order", "[event_pool]" )
+{
+  const auto expected = expected_events();
+
+  // A depth smaller than the number of events makes the ring buffers wrap
+  // around many times
+  for ( size_t depth : { size_t(1u), size_t(7u),
+    marley::EventPool::DEFAULT_DEPTH } )
+  {
+    INFO( "Depth " << depth );
+    marley::EventPool pool( pool_generators(), depth );
+    REQUIRE( pool.num_consumers() == NUM_CONSUMERS );
+    CHECK( pool.depth() == depth );
+    for ( size_t c = 0u; c < NUM_CONSUMERS; ++c ) {
+      CHECK( pool.get_generator(c).get_seed() == 1000u + c );
+    }
+
+    // Consumers take events at different rates. Consumer c takes c + 1
+    // events from each round.
+    std::vector<size_t> counts( NUM_CONSUMERS, 0u );
+    marley::Event ev;
+    bool done = false;
+    while ( !done ) {
+      done = true;
+      for ( size_t c = 0u; c < NUM_CONSUMERS; ++c ) {
+        for ( size_t k = 0u; k <= c && counts[c] < NUM_EVENTS; ++k ) {
+          pool.pop( c, ev );
+          INFO( "Consumer " << c << ", event " << counts[c] );
+          CHECK( to_string(ev) == expected.at(c).at(counts[c]) );
+          ++counts[ c ];
+        }
+        if ( counts[c] < NUM_EVENTS ) done = false;
+      }
+    }
+  }
+}
+
+TEST_CASE( "EventPool::try_pop() follows the same sequence as pop()",
+  "[event_pool]" )
+{
+  const auto expected = expected_events();
+  marley::EventPool pool( pool_generators(), 16u );
+
+  marley::Event ev;
+  for ( size_t c = 0u; c < NUM_CONSUMERS; ++c ) {
+    for ( size_t e = 0u; e < NUM_EVENTS; ++e ) {
+      INFO( "Consumer " << c << ", event " << e );
+      // Mix non-blocking and blocking requests
+      if ( e % 2u == 0u || !pool.try_pop(c, ev) ) pool.pop( c, ev );
+      CHECK( to_string(ev) == expected.at(c).at(e) );
+    }
+  }
+}
+
+TEST_CASE( "EventPool rejects invalid arguments", "[event_pool]" )
+{
+  CHECK_THROWS_AS( marley::EventPool(pool_generators(), 0u),
+    marley::Error );
+
+  std::vector< std::unique_ptr<marley::Generator> > gens;
+  gens.push_back( nullptr );
+  CHECK_THROWS_AS( marley::EventPool(std::move(gens)), marley::Error );
+
+  marley::EventPool pool( pool_generators(), 4u );
+  marley::Event ev;
+  CHECK_THROWS_AS( pool.pop(NUM_CONSUMERS, ev), marley::Error );
+  CHECK_THROWS_AS( pool.try_pop(NUM_CONSUMERS, ev), marley::Error );
+  CHECK_THROWS_AS( pool.get_generator(NUM_CONSUMERS), marley::Error );
+}
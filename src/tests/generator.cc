@@ -0,0 +1,146 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <string>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/CoherentReaction.hh"
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  constexpr int NUM_EVENTS = 1000;
+
+  // Creates a Generator from a job configuration given as JSON text
+  marley::Generator make_generator( const std::string& json_text ) {
+    marley::JSONConfig config( marley::JSON::load(json_text) );
+    return config.create_generator();
+  }
+
+}
+
+TEST_CASE( "Monoenergetic sources produce projectiles at the source energy",
+  "[generator]" )
+{
+  constexpr double E_NU = 15.; // MeV
+
+  marley::Generator gen = make_generator( "{ seed: 123456,"
+    " target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },"
+    " reactions: [ \"ES.react\" ],"
+    " source: { type: \"monoenergetic\", neutrino: \"ve\", energy: "
+    + std::to_string(E_NU) + " },"
+    " log: [ { file: \"stdout\", level: \"warning\" } ] }" );
+
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = gen.create_event();
+    const auto& proj = ev.projectile();
+    REQUIRE( proj.pdg_code() == marley_utils::ELECTRON_NEUTRINO );
+    CHECK( proj.kinetic_energy() == Approx(E_NU) );
+  }
+}
+
+TEST_CASE( "CEvNS events can be generated using the coherent engine",
+  "[generator]" )
+{
+  constexpr double E_NU = 30.; // MeV
+  constexpr int PDG_40AR = 1000180400;
+
+  marley::Generator gen = make_generator( "{ seed: 123456,"
+    " reactions: [ \"CEvNS40Ar.react\" ],"
+    " cevns_engine: \"coherent\","
+    " source: { type: \"monoenergetic\", neutrino: \"vu\", energy: "
+    + std::to_string(E_NU) + " },"
+    " log: [ { file: \"stdout\", level: \"warning\" } ] }" );
+
+  // Each of the NC reactions (one per neutrino species) should have been
+  // replaced by the dedicated engine
+  for ( const auto& react : gen.get_reactions() ) {
+    REQUIRE( dynamic_cast<const marley::CoherentReaction*>(react.get()) );
+  }
+
+  // Elastic scattering leaves the projectile species and the target nucleus
+  // (in its ground state) unchanged, and conserves four-momentum
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = gen.create_event();
+    INFO( "Event " << e );
+
+    CHECK( ev.projectile().pdg_code() == marley_utils::MUON_NEUTRINO );
+    CHECK( ev.projectile().kinetic_energy() == Approx(E_NU) );
+    CHECK( ev.ejectile().pdg_code() == marley_utils::MUON_NEUTRINO );
+    CHECK( ev.residue().pdg_code() == PDG_40AR );
+    CHECK( ev.Ex() == 0. );
+    CHECK( ev.residue().kinetic_energy() >= 0. );
+
+    double E_initial = ev.projectile().total_energy()
+      + ev.target().total_energy();
+    double E_final = 0.;
+    for ( const auto& p : ev.get_final_particles() ) {
+      E_final += p.total_energy();
+    }
+    CHECK( E_final == Approx(E_initial) );
+  }
+}
+
+TEST_CASE( "Time-binned sources set the projectile energy and event time",
+  "[generator]" )
+{
+  // The two time bins use non-overlapping energy ranges, so the energy of
+  // each projectile shows which bin was chosen
+  marley::Generator gen = make_generator( "{ seed: 123456,"
+    " target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },"
+    " reactions: [ \"ES.react\" ],"
+    " source: { type: \"time-binned\", neutrino: \"ve\","
+    "   time_edges: [ 0., 1., 3. ], weights: [ 1., 1. ],"
+    "   bins: [ { type: \"histogram\", E_bin_lefts: [ 5. ],"
+    "               weights: [ 1. ], Emax: 10. },"
+    "           { type: \"histogram\", E_bin_lefts: [ 20. ],"
+    "               weights: [ 1. ], Emax: 30. } ] },"
+    " log: [ { file: \"stdout\", level: \"warning\" } ] }" );
+
+  int early_count = 0;
+  int late_count = 0;
+  for ( int e = 0; e < NUM_EVENTS; ++e ) {
+    marley::Event ev = gen.create_event();
+    double KEa = ev.projectile().kinetic_energy();
+    double t = ev.time();
+    INFO( "Event " << e << ": KEa = " << KEa << ", t = " << t );
+
+    REQUIRE( t >= 0. );
+    REQUIRE( t < 3. );
+    if ( t < 1. ) {
+      ++early_count;
+      CHECK( KEa >= 5. );
+      CHECK( KEa <= 10. );
+    }
+    else {
+      ++late_count;
+      CHECK( KEa >= 20. );
+      CHECK( KEa <= 30. );
+    }
+  }
+
+  // Both time bins should be sampled
+  CHECK( early_count > 0 );
+  CHECK( late_count > 0 );
+}
@@ -0,0 +1,192 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/Event.hh"
+#include "marley/Generator.hh"
+#include "marley/JSON.hh"
+#include "marley/JSONConfig.hh"
+#include "marley/Parity.hh"
+#include "marley/Particle.hh"
+
+namespace {
+
+  constexpr double GEV_TO_MEV = 1000.;
+
+  // Writes a particle in the same way as the original std::ostream
+  // implementation of marley::Event::write_hepevt()
+  void reference_particle( std::ostream& os, const marley::Particle& p,
+    int status, int jmohep1 = 0, int jmohep2 = 0 )
+  {
+    os << status << ' ';
+    os << p.pdg_code() << ' ' << jmohep1 << ' ' << jmohep2 << " 0 0 "
+      << p.px() / GEV_TO_MEV << ' ' << p.py() / GEV_TO_MEV
+      << ' ' << p.pz() / GEV_TO_MEV << ' ' << p.total_energy() / GEV_TO_MEV
+      << ' ' << p.mass() / GEV_TO_MEV << " 0. 0. 0. 0." << '\n';
+  }
+
+  // HEPEVT record produced by the original std::ostream implementation,
+  // which formatted every value with a std::ostringstream
+  std::string reference_hepevt( const marley::Event& ev, size_t event_num,
+    double flux_avg_tot_xsec )
+  {
+    marley::Particle dummy;
+    dummy.set_total_energy( ev.Ex() * GEV_TO_MEV );
+    dummy.set_mass( flux_avg_tot_xsec * GEV_TO_MEV );
+    dummy.set_px( ev.weight() * GEV_TO_MEV );
+    dummy.set_py( ev.time() * GEV_TO_MEV );
+
+    size_t num_particles = 1 + ev.initial_particle_count()
+      + ev.final_particle_count();
+
+    std::ostringstream temp;
+    temp.precision( std::numeric_limits<double>::max_digits10 );
+    temp << std::scientific;
+    temp << event_num << ' ' << num_particles << '\n';
+    for ( const auto& i : ev.get_initial_particles() ) {
+      reference_particle( temp, i, marley::HEPEVT_INITIAL_STATE_STATUS_CODE );
+    }
+    reference_particle( temp, dummy, marley::HEPEVT_MARLEY_INFO_STATUS_CODE,
+      ev.twoJ(), static_cast<int>(ev.parity()) );
+    for ( const auto& f : ev.get_final_particles() ) {
+      reference_particle( temp, f, marley::HEPEVT_FINAL_STATE_STATUS_CODE );
+    }
+    return temp.str();
+  }
+
+  // Returns the double with the given bit pattern
+  double from_bits( uint64_t bits ) {
+    double x;
+    std::memcpy( &x, &bits, sizeof(double) );
+    return x;
+  }
+
+  // Draws doubles that exercise the formatting: random bit patterns
+  // (including infinities and NaNs), signed zeros, subnormals, values
+  // near the limits of the double range, and values typical of MARLEY
+  // events
+  double random_double( std::mt19937_64& rng ) {
+    static const std::vector<double> special = { 0., -0., DBL_MAX, -DBL_MAX,
+      DBL_MIN, DBL_EPSILON, from_bits(1u), -from_bits(0x000fffffffffffffu),
+      std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity(),
+      std::numeric_limits<double>::quiet_NaN(), 0.1, 1e-5, 1e16, 1e17 };
+    std::uniform_real_distribution<double> typical( -100., 100. );
+    switch ( rng() % 3u ) {
+      case 0u: return from_bits( rng() );
+      case 1u: return special.at( rng() % special.size() );
+      default: return typical( rng );
+    }
+  }
+
+  // The charge is given explicitly since most of the random PDG codes do
+  // not belong to known particles
+  marley::Particle random_particle( std::mt19937_64& rng ) {
+    int pdg = static_cast<int>( rng() );
+    return marley::Particle( pdg, random_double(rng), random_double(rng),
+      random_double(rng), random_double(rng), random_double(rng), 0 );
+  }
+
+  marley::Event random_event( std::mt19937_64& rng ) {
+    marley::Event ev( random_particle(rng), random_particle(rng),
+      random_particle(rng), random_particle(rng), random_double(rng),
+      static_cast<int>(rng()), marley::Parity(rng() % 2u == 0u) );
+    ev.set_weight( random_double(rng) );
+    ev.set_time( random_double(rng) );
+    size_t num_extra = rng() % 8u;
+    for ( size_t k = 0u; k < num_extra; ++k ) {
+      ev.add_final_particle( random_particle(rng) );
+    }
+    return ev;
+  }
+
+  // Checks both write_hepevt() overloads against the reference output
+  void check_event( const marley::Event& ev, size_t event_num,
+    double flux_avg_tot_xsec )
+  {
+    std::string expected = reference_hepevt( ev, event_num,
+      flux_avg_tot_xsec );
+
+    std::string buffer;
+    ev.write_hepevt( event_num, flux_avg_tot_xsec, buffer );
+    CHECK( buffer == expected );
+
+    // The std::ostream overload should leave the stream's formatting
+    // settings alone
+    std::ostringstream out;
+    out << std::fixed << std::setprecision( 3 );
+    ev.write_hepevt( event_num, flux_avg_tot_xsec, out );
+    CHECK( out.str() == expected );
+    CHECK( out.precision() == 3 );
+    CHECK( (out.flags() & std::ios_base::floatfield) == std::ios_base::fixed );
+  }
+
+}
+
+TEST_CASE( "HEPEVT records written to strings match the stream output",
+  "[hepevt]" )
+{
+  SECTION( "Randomized particle records" ) {
+    std::mt19937_64 rng( 123456u );
+    for ( int e = 0; e < 2000; ++e ) {
+      marley::Event ev = random_event( rng );
+      size_t event_num = ( e % 2 ) ? rng() : e;
+      double xs = random_double( rng );
+      INFO( "Event " << e );
+      check_event( ev, event_num, xs );
+    }
+  }
+
+  SECTION( "Generated events" ) {
+    marley::JSONConfig config( marley::JSON::load( "{ seed: 123456,"
+      " target: { nuclides: [ 1000180400 ], atom_fractions: [ 1.0 ] },"
+      " reactions: [ \"ES.react\" ],"
+      " source: { type: \"dar\", neutrino: \"ve\" },"
+      " log: [ { file: \"stdout\", level: \"warning\" } ] }" ) );
+    marley::Generator gen = config.create_generator();
+    double xs = gen.flux_averaged_total_xs();
+    for ( size_t e = 0u; e < 200u; ++e ) {
+      INFO( "Event " << e );
+      check_event( gen.create_event(), e, xs );
+    }
+  }
+
+  SECTION( "Records are appended to the buffer" ) {
+    std::mt19937_64 rng( 654321u );
+    std::string buffer = "header\n";
+    std::string expected = buffer;
+    for ( size_t e = 0u; e < 50u; ++e ) {
+      marley::Event ev = random_event( rng );
+      ev.write_hepevt( e, 1., buffer );
+      expected += reference_hepevt( ev, e, 1. );
+    }
+    CHECK( buffer == expected );
+  }
+}
@@ -0,0 +1,251 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/marley_utils.hh"
+#include "marley/InterpolationGrid.hh"
+
+namespace {
+
+  using Grid = marley::InterpolationGrid<double>;
+  using Spacing = Grid::Spacing;
+
+  constexpr size_t NUM_POINTS = 1000u;
+
+  // Moves x by the given number of representable doubles
+  double shift_ulps( double x, int ulps ) {
+    double direction = ( ulps > 0 ) ? marley_utils::infinity
+      : marley_utils::minus_infinity;
+    for ( int k = 0; k < std::abs(ulps); ++k ) {
+      x = std::nextafter( x, direction );
+    }
+    return x;
+  }
+
+  // Adds rounding noise to every interior point of a grid. Deviations of a
+  // few ulps mimic grids computed in different ways. The larger relative
+  // deviations are still within the tolerance used to detect the spacing,
+  // but they may move the computed bin index by one.
+  std::vector<double> add_noise( std::vector<double> xs, double step,
+    std::mt19937_64& rng )
+  {
+    std::uniform_int_distribution<int> ulps_dist( -4, 4 );
+    std::uniform_real_distribution<double> frac_dist( -5e-7, 5e-7 );
+    for ( size_t j = 1u; j + 1u < xs.size(); ++j ) {
+      if ( j % 2u ) xs[ j ] = shift_ulps( xs[j], ulps_dist(rng) );
+      else xs[ j ] += frac_dist( rng ) * step;
+    }
+    return xs;
+  }
+
+  // Builds a grid that uses constant interpolation and stores the index of
+  // each point as its y value. Within the grid, interpolate(x) then returns
+  // the index of the point before the one found by lower_bound().
+  Grid make_index_grid( const std::vector<double>& xs ) {
+    std::vector<double> ys;
+    for ( size_t j = 0u; j < xs.size(); ++j ) ys.push_back( j );
+    return Grid( xs, ys, Grid::InterpolationMethod::Constant,
+      Grid::ExtrapolationMethod::Endpoint );
+  }
+
+  // Index of the grid point used by constant interpolation at x, found
+  // using std::lower_bound()
+  double expected_index( const std::vector<double>& xs, double x ) {
+    if ( x <= xs.front() ) return 0.;
+    if ( x > xs.back() ) return xs.size() - 1u;
+    auto iter = std::lower_bound( xs.begin(), xs.end(), x );
+    return static_cast<double>( iter - xs.begin() ) - 1.;
+  }
+
+  // Values of x to look up: every grid point, its neighboring doubles,
+  // points near it, bin midpoints, random points, and points outside the
+  // grid
+  std::vector<double> query_points( const std::vector<double>& xs,
+    std::mt19937_64& rng )
+  {
+    std::vector<double> qs;
+    for ( size_t j = 0u; j < xs.size(); ++j ) {
+      double x = xs[ j ];
+      for ( int ulps : { -2, -1, 0, 1, 2 } ) {
+        qs.push_back( shift_ulps(x, ulps) );
+      }
+      qs.push_back( x * (1. - 1e-9) );
+      qs.push_back( x * (1. + 1e-9) );
+      if ( j + 1u < xs.size() ) qs.push_back( 0.5*(x + xs[j + 1u]) );
+    }
+    std::uniform_real_distribution<double> dist( xs.front(), xs.back() );
+    for ( int k = 0; k < 10000; ++k ) qs.push_back( dist(rng) );
+    qs.push_back( xs.front() - 1. );
+    qs.push_back( xs.back() * 2. );
+    return qs;
+  }
+
+  // Checks that the bins found by a grid with detected spacing agree with
+  // std::lower_bound()
+  void check_lookup( const std::vector<double>& xs, Spacing spacing,
+    std::mt19937_64& rng )
+  {
+    Grid grid = make_index_grid( xs );
+    REQUIRE( grid.spacing() == spacing );
+    for ( double x : query_points(xs, rng) ) {
+      INFO( "x = " << std::hexfloat << x << std::defaultfloat );
+      CHECK( grid.interpolate(x) == expected_index(xs, x) );
+    }
+  }
+
+  // Checks that linear interpolation gives bit-identical results with and
+  // without the spacing-based lookup
+  void check_interpolation( const std::vector<double>& xs,
+    std::mt19937_64& rng )
+  {
+    std::uniform_real_distribution<double> y_dist( 0., 1. );
+    std::vector<double> ys;
+    for ( size_t j = 0u; j < xs.size(); ++j ) ys.push_back( y_dist(rng) );
+
+    Grid spaced( xs, ys, Grid::InterpolationMethod::LinearLinear,
+      Grid::ExtrapolationMethod::Continue );
+    REQUIRE( spaced.spacing() != Spacing::Irregular );
+
+    // Access through the non-const at() makes the copy irregular, so it
+    // uses the binary search
+    Grid irregular( spaced );
+    irregular.at( 0u );
+    REQUIRE( irregular.spacing() == Spacing::Irregular );
+
+    for ( double x : query_points(xs, rng) ) {
+      INFO( "x = " << std::hexfloat << x << std::defaultfloat );
+      CHECK( spaced.interpolate(x) == irregular.interpolate(x) );
+    }
+  }
+
+  std::vector<double> uniform_xs( double x0, double step ) {
+    std::vector<double> xs;
+    for ( size_t j = 0u; j < NUM_POINTS; ++j ) xs.push_back( x0 + j*step );
+    return xs;
+  }
+
+  std::vector<double> log_uniform_xs( double x0, double log_step ) {
+    std::vector<double> xs;
+    for ( size_t j = 0u; j < NUM_POINTS; ++j ) {
+      xs.push_back( x0 * std::exp(j*log_step) );
+    }
+    return xs;
+  }
+
+}
+
+TEST_CASE( "Spaced grid lookups agree with std::lower_bound",
+  "[interpolation_grid]" )
+{
+  std::mt19937_64 rng( 123456u );
+
+  SECTION( "Uniform grids" ) {
+    for ( double step : { 1e-3, 0.1, 0.37, 7. } ) {
+      INFO( "step = " << step );
+      std::vector<double> xs = uniform_xs( -3.2, step );
+      check_lookup( xs, Spacing::Uniform, rng );
+      check_lookup( add_noise(xs, step, rng), Spacing::Uniform, rng );
+      check_interpolation( add_noise(xs, step, rng), rng );
+    }
+
+    // Grid points accumulated by repeated addition carry rounding errors
+    std::vector<double> xs;
+    double x = 0.;
+    for ( size_t j = 0u; j < NUM_POINTS; ++j, x += 0.1 ) xs.push_back( x );
+    check_lookup( xs, Spacing::Uniform, rng );
+  }
+
+  SECTION( "Log-uniform grids" ) {
+    for ( double log_step : { 1e-3, 0.01, 0.05 } ) {
+      INFO( "log_step = " << log_step );
+      std::vector<double> xs = log_uniform_xs( 1e-4, log_step );
+      check_lookup( xs, Spacing::LogUniform, rng );
+      // Shift the interior points by up to four ulps
+      std::vector<double> noisy = xs;
+      for ( size_t j = 1u; j + 1u < xs.size(); ++j ) {
+        noisy[ j ] = shift_ulps( xs[j], static_cast<int>(j % 9u) - 4 );
+      }
+      check_lookup( noisy, Spacing::LogUniform, rng );
+      check_interpolation( noisy, rng );
+    }
+  }
+
+  SECTION( "Irregular grids" ) {
+    std::vector<double> xs = uniform_xs( 0., 1. );
+    xs[ NUM_POINTS / 2u ] += 0.25;
+    check_lookup( xs, Spacing::Irregular, rng );
+  }
+}
+
+TEST_CASE( "Inserting points keeps the grid spacing up to date",
+  "[interpolation_grid]" )
+{
+  SECTION( "Filling a grid in order" ) {
+    for ( bool log_spacing : { false, true } ) {
+      INFO( "log_spacing = " << log_spacing );
+      std::vector<double> xs = log_spacing ? log_uniform_xs( 0.5, 0.01 )
+        : uniform_xs( 0.5, 0.25 );
+      Grid grid;
+      for ( size_t j = 0u; j < xs.size(); ++j ) grid.insert( xs[j], j );
+
+      Spacing expected = log_spacing ? Spacing::LogUniform
+        : Spacing::Uniform;
+      CHECK( grid.spacing() == expected );
+      Grid detected = make_index_grid( xs );
+      CHECK( detected.spacing() == expected );
+    }
+  }
+
+  SECTION( "Off-grid insertions make the grid irregular" ) {
+    Grid grid;
+    for ( size_t j = 0u; j < 10u; ++j ) grid.insert( j, j );
+    REQUIRE( grid.spacing() == Spacing::Uniform );
+
+    // Extending the grid at either end keeps it uniform
+    grid.insert( -1., -1. );
+    CHECK( grid.spacing() == Spacing::Uniform );
+    grid.insert( 10., 10. );
+    CHECK( grid.spacing() == Spacing::Uniform );
+
+    Grid middle( grid );
+    middle.insert( 4.5, 4.5 );
+    CHECK( middle.spacing() == Spacing::Irregular );
+
+    Grid end( grid );
+    end.insert( 11.5, 11.5 );
+    CHECK( end.spacing() == Spacing::Irregular );
+
+    // An irregular grid stays irregular when regular points are appended
+    end.insert( 12.5, 12.5 );
+    CHECK( end.spacing() == Spacing::Irregular );
+    end.detect_spacing();
+    CHECK( end.spacing() == Spacing::Irregular );
+
+    // A repeated x value (a discontinuity) is not uniform spacing
+    Grid repeated( grid );
+    repeated.insert( 10., 11. );
+    CHECK( repeated.spacing() == Spacing::Irregular );
+  }
+}
@@ -0,0 +1,111 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cmath>
+#include <complex>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  // The Lanczos approximation is good to a few parts in 10^15. The same
+  // tolerance is used as an absolute one near zero.
+  constexpr double TOLERANCE = 1e-13;
+
+  Approx close_to( double expected ) {
+    return Approx( expected ).epsilon( TOLERANCE ).margin( TOLERANCE );
+  }
+
+  // ln cosh(a) and ln sinh(a) for a > 0, written so that they do not
+  // overflow for large a
+  double log_cosh( double a ) {
+    return a + std::log1p( std::exp(-2.*a) ) - std::log( 2. );
+  }
+
+  double log_sinh( double a ) {
+    return a + std::log1p( -std::exp(-2.*a) ) - std::log( 2. );
+  }
+
+}
+
+TEST_CASE( "ln|Gamma(x + iy)|^2 matches closed forms", "[log_norm_gamma]" )
+{
+  using marley_utils::pi;
+
+  SECTION( "|Gamma(1/2 + iy)|^2 = pi / cosh(pi*y)" ) {
+    for ( double y = -500.; y <= 500.; y += 0.0137 ) {
+      double expected = std::log( pi ) - log_cosh( pi * std::abs(y) );
+      INFO( "y = " << y );
+      CHECK( marley_utils::log_norm_gamma(0.5, y) == close_to(expected) );
+    }
+  }
+
+  SECTION( "|Gamma(1 + iy)|^2 = pi*y / sinh(pi*y)" ) {
+    CHECK( marley_utils::log_norm_gamma(1., 0.) == close_to(0.) );
+    for ( double y = -500.; y <= 500.; y += 0.0137 ) {
+      if ( y == 0. ) continue;
+      double a = pi * std::abs( y );
+      double expected = std::log( a ) - log_sinh( a );
+      INFO( "y = " << y );
+      CHECK( marley_utils::log_norm_gamma(1., y) == close_to(expected) );
+    }
+  }
+
+  SECTION( "|Gamma(3/2 + iy)|^2 = (1/4 + y^2) pi / cosh(pi*y)" ) {
+    for ( double y = -200.; y <= 200.; y += 0.0731 ) {
+      double expected = std::log( (0.25 + y*y) * pi )
+        - log_cosh( pi * std::abs(y) );
+      INFO( "y = " << y );
+      CHECK( marley_utils::log_norm_gamma(1.5, y) == close_to(expected) );
+    }
+  }
+
+  // Values of x below 1/2 are handled using Gamma(z) = Gamma(z + 1) / z
+  SECTION( "Real arguments agree with std::lgamma()" ) {
+    for ( double x = 0.01; x < 150.; x += 0.0173 ) {
+      INFO( "x = " << x );
+      CHECK( marley_utils::log_norm_gamma(x, 0.)
+        == close_to(2. * std::lgamma(x)) );
+    }
+  }
+}
+
+TEST_CASE( "ln|Gamma(x + iy)|^2 agrees with the complex gamma function",
+  "[log_norm_gamma]" )
+{
+  // Cover the values of x used by the Fermi function, x = sqrt(1 - (aZ)^2),
+  // and a range of Sommerfeld parameters y. Stay in the region where
+  // std::norm(gamma(z)) itself does not overflow or underflow.
+  for ( double x = 0.05; x <= 20.; x += 0.0917 ) {
+    for ( double y = -40.; y <= 40.; y += 0.377 ) {
+      double expected = std::log( std::norm(marley_utils::gamma({ x, y })) );
+      INFO( "x = " << x << ", y = " << y );
+      CHECK( marley_utils::log_norm_gamma(x, y) == close_to(expected) );
+    }
+  }
+
+  // Far from the real axis, |Gamma(z)|^2 underflows, but its logarithm
+  // should still be finite and follow the closed form
+  double y = 1e4;
+  CHECK( std::norm(marley_utils::gamma({ 0.5, y })) == 0. );
+  CHECK( marley_utils::log_norm_gamma(0.5, y)
+    == close_to(std::log(marley_utils::pi) - log_cosh(marley_utils::pi * y)) );
+}
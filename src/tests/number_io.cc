@@ -0,0 +1,242 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/TextTokenReader.hh"
+#include "marley/marley_utils.hh"
+
+namespace {
+
+  // Formats a double using marley_utils::format_shortest_double()
+  std::string format( double x ) {
+    char buffer[ marley_utils::SHORTEST_DOUBLE_BUFFER_SIZE ];
+    size_t length = marley_utils::format_shortest_double( x, buffer );
+    REQUIRE( length < marley_utils::SHORTEST_DOUBLE_BUFFER_SIZE );
+    REQUIRE( std::strlen(buffer) == length );
+    return std::string( buffer, length );
+  }
+
+  // Checks that the formatted value reads back as exactly the same double
+  // (including the sign of zero)
+  void check_round_trip( double x ) {
+    std::string str = format( x );
+    double y = std::strtod( str.c_str(), nullptr );
+    INFO( "x = " << std::hexfloat << x << ", formatted as \"" << str
+      << "\", read back as " << y << std::defaultfloat );
+    CHECK( std::memcmp(&x, &y, sizeof(double)) == 0 );
+  }
+
+  // Parses a double using a marley::TextTokenReader
+  bool parse( const std::string& str, double& value ) {
+    std::istringstream in( str );
+    marley::TextTokenReader reader( in );
+    reader >> value;
+    return static_cast<bool>( reader );
+  }
+
+  // Checks that a marley::TextTokenReader parses the string to exactly the
+  // same double as strtod(), and that values that overflow are rejected
+  void check_parse( const std::string& str ) {
+    INFO( "Parsing \"" << str << '"' );
+    double expected = std::strtod( str.c_str(), nullptr );
+    double value = 0.;
+    bool ok = parse( str, value );
+    if ( std::isinf(expected) ) CHECK( !ok );
+    else {
+      REQUIRE( ok );
+      INFO( "strtod() gave " << std::hexfloat << expected << ", parsed "
+        << value << std::defaultfloat );
+      CHECK( std::memcmp(&expected, &value, sizeof(double)) == 0 );
+    }
+  }
+
+  // Returns the double with the given bit pattern
+  double from_bits( uint64_t bits ) {
+    double x;
+    std::memcpy( &x, &bits, sizeof(double) );
+    return x;
+  }
+
+}
+
+TEST_CASE( "Formatted doubles read back exactly", "[number_io]" )
+{
+  SECTION( "Signed zeros" ) {
+    CHECK( format(0.) == "0" );
+    CHECK( format(-0.) == "-0" );
+    check_round_trip( 0. );
+    check_round_trip( -0. );
+  }
+
+  SECTION( "Notation follows the %g rules at 17 digits" ) {
+    CHECK( format(1.) == "1" );
+    CHECK( format(0.1) == "0.1" );
+    CHECK( format(-123.5) == "-123.5" );
+    CHECK( format(1e-4) == "0.0001" );
+    CHECK( format(1e-5) == "1e-05" );
+    CHECK( format(1e16) == "10000000000000000" );
+    CHECK( format(1e17) == "1e+17" );
+    CHECK( format(1.5e300) == "1.5e+300" );
+  }
+
+  SECTION( "Powers of ten" ) {
+    for ( int p = DBL_MIN_10_EXP - 16; p <= DBL_MAX_10_EXP; ++p ) {
+      std::string str = "1e" + std::to_string( p );
+      double x = std::strtod( str.c_str(), nullptr );
+      check_round_trip( x );
+      check_round_trip( -x );
+      // Powers of ten that are exactly representable as doubles should be
+      // printed using a single significant digit
+      if ( p >= 0 && p < 17 ) {
+        CHECK( format(x) == '1' + std::string(p, '0') );
+      }
+      else if ( p >= 17 && p <= 22 ) {
+        CHECK( format(x) == "1e+" + std::to_string(p) );
+      }
+    }
+  }
+
+  SECTION( "Values near the limits of the double range" ) {
+    std::vector<double> limits = { DBL_MAX, DBL_MIN,
+      std::nextafter( DBL_MAX, 0. ), std::nextafter( DBL_MIN, 0. ),
+      std::nextafter( DBL_MIN, 1. ), std::nextafter( 1., 0. ),
+      std::nextafter( 1., 2. ), DBL_EPSILON };
+    for ( double x : limits ) {
+      check_round_trip( x );
+      check_round_trip( -x );
+    }
+  }
+
+  SECTION( "Subnormal values" ) {
+    // The smallest subnormal, a few of its multiples, and the largest
+    // subnormal
+    for ( uint64_t m = 1u; m <= 64u; ++m ) check_round_trip( from_bits(m) );
+    check_round_trip( from_bits(0x000fffffffffffffu) );
+    check_round_trip( from_bits(0x0008000000000000u) );
+    check_round_trip( -from_bits(1u) );
+  }
+
+  SECTION( "Random bit patterns" ) {
+    std::mt19937_64 rng( 123456u );
+    for ( int i = 0; i < 100000; ++i ) {
+      double x = from_bits( rng() );
+      if ( !std::isfinite(x) ) continue;
+      check_round_trip( x );
+    }
+  }
+}
+
+TEST_CASE( "Text tokens are parsed as doubles exactly", "[number_io]" )
+{
+  SECTION( "Signed zeros" ) {
+    for ( const char* str : { "0", "-0", "0.0", "-0.0", "0e10", "-0e-400",
+      "000000000000000000000000.000" } ) check_parse( str );
+  }
+
+  SECTION( "Values near 2^53" ) {
+    // The largest mantissa allowed on the fast path is 2^53. Larger ones
+    // need to be rounded, which is left to the slow path. 2^53 + 1 lies
+    // exactly halfway between two doubles.
+    for ( const char* str : { "9007199254740991", "9007199254740992",
+      "9007199254740993", "9007199254740994", "9007199254740995",
+      "-9007199254740993", "9007199254740993e5", "9.007199254740993e-3",
+      "18014398509481983", "18014398509481985" } ) check_parse( str );
+  }
+
+  SECTION( "Exact halfway cases" ) {
+    // 1 + 2^-53 and 1 + 3*2^-53 lie halfway between neighboring doubles and
+    // need all of their digits to be rounded correctly
+    for ( const char* str : {
+      "1.00000000000000011102230246251565404236316680908203125",
+      "1.00000000000000011102230246251565404236316680908203124",
+      "1.00000000000000011102230246251565404236316680908203126",
+      "1.00000000000000033306690738754696212708950042724609375",
+      "0.5000000000000000277555756156289135105907917022705078125" } )
+    {
+      check_parse( str );
+    }
+  }
+
+  SECTION( "Long mantissas" ) {
+    // Up to 19 significant digits are kept. Trailing zeros beyond that
+    // don't prevent use of the fast path.
+    for ( const char* str : { "1234567890123456789", "12345678901234567890",
+      "1234567890123456789012345", "0.1234567890123456789",
+      "1000000000000000000000000e-3", "0.00000000000000000000000001",
+      "3.14159265358979323846264338327950288", "123456789012345678e-5" } )
+    {
+      check_parse( str );
+    }
+  }
+
+  SECTION( "Large exponents" ) {
+    // Powers of ten beyond 10^22 are not exact, so these values fall back
+    // to the slow path
+    for ( const char* str : { "1e22", "1e23", "1e-22", "1e-23", "9e22",
+      "1.7976931348623157e308", "1.7976931348623159e308", "1e308", "1e309",
+      "-1e400", "2.2250738585072011e-308", "2.2250738585072014e-308",
+      "4.9406564584124654e-324", "2e-324", "1e-400", "1e99999",
+      "1e-99999", "1e+0022", "+12.5E+003" } ) check_parse( str );
+  }
+
+  SECTION( "Malformed values are rejected" ) {
+    for ( const char* str : { "", "-", "+", ".", "e5", "1e", "1e+", "1.5x",
+      "--1", "0x1p3", "1,5", "nan", "inf" } )
+    {
+      double value = 0.;
+      INFO( "Parsing \"" << str << '"' );
+      CHECK( !parse(str, value) );
+    }
+  }
+
+  SECTION( "Random decimal strings" ) {
+    std::mt19937_64 rng( 123456u );
+    std::uniform_int_distribution<int> num_digits_dist( 1, 25 );
+    std::uniform_int_distribution<int> digit_dist( 0, 9 );
+    std::uniform_int_distribution<int> point_dist( 0, 25 );
+    std::uniform_int_distribution<int> exp_dist( -330, 330 );
+    for ( int i = 0; i < 100000; ++i ) {
+      std::string str;
+      if ( rng() % 2u ) str += '-';
+      int num_digits = num_digits_dist( rng );
+      int point = point_dist( rng );
+      for ( int d = 0; d < num_digits; ++d ) {
+        if ( d == point ) str += '.';
+        str += static_cast<char>( '0' + digit_dist(rng) );
+      }
+      if ( rng() % 2u ) {
+        int exponent = exp_dist( rng );
+        if ( rng() % 2u ) exponent /= 10;
+        str += 'e' + std::to_string( exponent );
+      }
+      check_parse( str );
+    }
+  }
+}
@@ -0,0 +1,180 @@
+/// @file
+/// @copyright Copyright (C) 2016-2021 Steven Gardiner
+/// @license GNU General Public License, version 3
+//
+// This file is part of MARLEY (Model of Argon Reaction Low Energy Yields)
+//
+// MARLEY is free software: you can redistribute it and/or modify it under the
+// terms of version 3 of the GNU General Public License as published by the
+// Free Software Foundation.
+//
+// For the full text of the license please see COPYING or
+// visit http://opensource.org/licenses/GPL-3.0
+//
+// Please respect the MCnet academic usage guidelines. See GUIDELINES
+// or visit https://www.montecarlonet.org/GUIDELINES for details.
+
+// Standard library includes
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+// Catch2 includes
+#include "catch2/catch.hpp"
+
+// MARLEY includes
+#include "marley/RandomEngine.hh"
+
+namespace {
+
+  using CounterType = marley::PhiloxEngine::CounterType;
+  using KeyType = marley::PhiloxEngine::KeyType;
+
+  // Known-answer test vectors for Philox4x64-10 taken from the Random123
+  // distribution (kat_vectors)
+  struct PhiloxKAT {
+    CounterType ctr;
+    KeyType key;
+    CounterType expected;
+  };
+
+  const std::vector<PhiloxKAT> PHILOX_KATS = {
+    { {{ 0u, 0u, 0u, 0u }}, {{ 0u, 0u }},
+      {{ 0x16554d9eca36314cu, 0xdb20fe9d672d0fdcu, 0xd7e772cee186176bu,
+         0x7e68b68aec7ba23bu }} },
+    { {{ ~0ull, ~0ull, ~0ull, ~0ull }}, {{ ~0ull, ~0ull }},
+      {{ 0x87b092c3013fe90bu, 0x438c3c67be8d0224u, 0x9cc7d7c69cd777b6u,
+         0xa09caebf594f0ba0u }} },
+    { {{ 0x243f6a8885a308d3u, 0x13198a2e03707344u, 0xa4093822299f31d0u,
+         0x082efa98ec4e6c89u }},
+      {{ 0x452821e638d01377u, 0xbe5466cf34e90c6cu }},
+      {{ 0xa528f45403e61d95u, 0x38c72dbd566e9788u, 0xa5a1610e72fd18b5u,
+         0x57bd43b5e52b7fe6u }} },
+  };
+
+  // Draws the requested number of values from an engine
+  template <typename Engine> std::vector<uint64_t> draw( Engine& eng,
+    size_t num )
+  {
+    std::vector<uint64_t> values;
+    for ( size_t i = 0u; i < num; ++i ) values.push_back( eng() );
+    return values;
+  }
+
+}
+
+TEST_CASE( "Philox4x64-10 matches the Random123 known answers", "[random]" )
+{
+  for ( const auto& kat : PHILOX_KATS ) {
+    CHECK( marley::PhiloxEngine::block(kat.ctr, kat.key) == kat.expected );
+
+    // The engine should return the words of the block in order
+    marley::PhiloxEngine pe( kat.key[0], kat.key[1] );
+    pe.set_counter( kat.ctr );
+    for ( uint64_t word : kat.expected ) CHECK( pe() == word );
+  }
+
+  // The 256-bit counter should carry between its words
+  marley::PhiloxEngine pe;
+  pe.set_counter({{ ~0ull, 0u, 0u, 0u }});
+  draw( pe, 4u );
+  CHECK( pe.counter() == CounterType({{ 0u, 1u, 0u, 0u }}) );
+}
+
+TEST_CASE( "Random engine states survive a print/read round trip",
+  "[random]" )
+{
+  SECTION( "PhiloxEngine" ) {
+    marley::PhiloxEngine pe( 123u, 456u );
+    // Stop partway through an output block
+    draw( pe, 6u );
+
+    std::stringstream ss;
+    ss << pe;
+    auto expected = draw( pe, 20u );
+
+    marley::PhiloxEngine restored;
+    ss >> restored;
+    REQUIRE( ss );
+    CHECK( restored.key() == pe.key() );
+    CHECK( draw(restored, 20u) == expected );
+  }
+
+  SECTION( "RandomEngine" ) {
+    for ( bool counter_based : { false, true } ) {
+      INFO( "counter_based = " << counter_based );
+      marley::RandomEngine re;
+      re.seed( 123456u );
+      re.set_counter_based( counter_based );
+      re.set_stream_id( 7u );
+      re.start_event();
+      draw( re, 5u );
+
+      std::stringstream ss;
+      ss << re;
+      auto expected = draw( re, 20u );
+
+      marley::RandomEngine restored;
+      ss >> restored;
+      REQUIRE( ss );
+      CHECK( restored.counter_based() == counter_based );
+      // Mersenne Twister states use the standard format, which doesn't
+      // include the settings used by the counter-based engine
+      if ( counter_based ) {
+        CHECK( restored.stream_id() == re.stream_id() );
+        CHECK( restored.event_number() == re.event_number() );
+      }
+      CHECK( draw(restored, 20u) == expected );
+    }
+  }
+
+  SECTION( "Incomplete states are rejected" ) {
+    marley::PhiloxEngine other( 3u, 4u );
+    std::stringstream bad( "1 2 3" );
+    bad >> other;
+    CHECK( !bad );
+    // The engine should be left unchanged
+    CHECK( other.key() == KeyType({{ 3u, 4u }}) );
+  }
+}
+
+TEST_CASE( "Event substreams are reproducible", "[random]" )
+{
+  marley::RandomEngine re;
+  re.seed( 123456u );
+  re.set_counter_based( true );
+
+  re.start_event_substream( 5u, 1u );
+  auto first = draw( re, 10u );
+
+  // Drawing other values in between should make no difference
+  re.start_event();
+  draw( re, 37u );
+  re.start_event_substream( 5u, 1u );
+  CHECK( draw(re, 10u) == first );
+
+  // A second engine with the same seed should agree
+  marley::RandomEngine re2;
+  re2.seed( 123456u );
+  re2.set_counter_based( true );
+  re2.start_event_substream( 5u, 1u );
+  CHECK( draw(re2, 10u) == first );
+
+  // The event number used by start_event() is not changed
+  CHECK( re.event_number() == 1u );
+
+  // Substream zero is the one used by start_event()
+  re.start_event_substream( 5u, 0u );
+  auto zero = draw( re, 10u );
+  re2.set_event_number( 5u );
+  re2.start_event();
+  CHECK( draw(re2, 10u) == zero );
+
+  // Different substreams, events, and stream IDs give different values
+  CHECK( zero != first );
+  re.start_event_substream( 6u, 1u );
+  CHECK( draw(re, 10u) != first );
+  re.set_stream_id( 1u );
+  re.start_event_substream( 5u, 1u );
+  CHECK( draw(re, 10u) != first );
+}
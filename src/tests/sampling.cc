@@ -18,8 +18,10 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <string>
+#include <vector>
 
 // Catch2 includes
 #include "catch2/catch.hpp"
@@ -39,6 +41,9 @@
 #else
   #include "marley/JSONConfig.hh"
 #endif
+#include "marley/AliasTable.hh"
+#include "marley/ChebyshevInterpolant.hh"
+#include "marley/ChebyshevInterpolatingFunction.hh"
 #include "marley/Error.hh"
 #include "marley/Event.hh"
 #include "marley/Generator.hh"
@@ -778,3 +783,133 @@ TEST_CASE( "Events match their underlying distributions", "[physics]" )
     CHECK( passed );
   }
 }
+
+TEST_CASE( "Alias tables sample their discrete distributions", "[sampling]" )
+{
+  std::mt19937_64 rng( 123456u );
+
+  SECTION( "Frequencies match the weights" ) {
+    // Include a zero-weight entry and weights that differ by a large factor
+    const std::vector<double> weights = { 1., 2.5, 0., 7., 0.25, 30., 4. };
+    marley::AliasTable table( weights.cbegin(), weights.cend() );
+    REQUIRE( table.size() == weights.size() );
+
+    double total_weight = 0.;
+    for ( double w : weights ) total_weight += w;
+    CHECK( table.total_weight() == Approx(total_weight) );
+
+    size_t num_bins = weights.size();
+    marley::tests::Histogram observed_hist( num_bins, 0., num_bins );
+    for ( int e = 0; e < NUM_EVENTS; ++e ) {
+      size_t index = table( rng );
+      REQUIRE( index < num_bins );
+      observed_hist.increment_bin( index );
+    }
+
+    // The zero-weight entry should never be sampled
+    CHECK( observed_hist.get_bin_content(2) == 0 );
+
+    std::vector<double> expected_counts;
+    for ( double w : weights ) {
+      expected_counts.push_back( NUM_EVENTS * w / total_weight );
+    }
+
+    bool passed;
+    double chi2, p_value;
+    int ndof;
+    observed_hist.chi2_test( expected_counts, passed, chi2, ndof, p_value );
+    CHECK( passed );
+  }
+
+  SECTION( "Zero-weight entries are never sampled" ) {
+    const std::vector<double> weights = { 0., 0., 3., 0., 1., 0. };
+    marley::AliasTable table( weights.cbegin(), weights.cend() );
+    for ( int e = 0; e < NUM_EVENTS; ++e ) {
+      size_t index = table( rng );
+      CHECK( weights.at(index) > 0. );
+    }
+  }
+
+  SECTION( "A table with a single entry always returns it" ) {
+    const std::vector<double> weights = { 2. };
+    marley::AliasTable table( weights.cbegin(), weights.cend() );
+
+    // No random numbers should be consumed
+    std::mt19937_64 copy = rng;
+    for ( int e = 0; e < 100; ++e ) CHECK( table(rng) == 0u );
+    CHECK( rng == copy );
+  }
+
+  SECTION( "The first entry is used when every weight is zero" ) {
+    const std::vector<double> weights = { 0., 0., 0. };
+    marley::AliasTable table( weights.cbegin(), weights.cend() );
+    for ( int e = 0; e < 100; ++e ) CHECK( table(rng) == 0u );
+  }
+
+  SECTION( "Negative weights are rejected" ) {
+    const std::vector<double> weights = { 1., -1., 2. };
+    marley::AliasTable table;
+    CHECK_THROWS_AS( table.build(weights.cbegin(), weights.cend()),
+      marley::Error );
+  }
+}
+
+TEST_CASE( "Inverting a Chebyshev CDF recovers the probability",
+  "[sampling]" )
+{
+  constexpr double X_MIN = 0.;
+  constexpr double X_MAX = 40.;
+  constexpr double TOLERANCE = 1e-10;
+
+  // A strongly skewed density and a narrow peak that is negligible over
+  // most of the interval. Both are smooth enough to be represented well by
+  // the default grid.
+  std::vector< std::function<double(double)> > pdfs = {
+    [](double x) -> double { return x * x * std::exp( -x / 3. ); },
+    [](double x) -> double { return std::exp( -std::pow(x - 25., 2) / 18. ); },
+  };
+
+  std::vector<double> probs = { 0., 1e-12, 1e-6, 0.001, 0.01, 0.1, 0.25,
+    0.5, 0.75, 0.9, 0.99, 0.999, 1. - 1e-9, 1. };
+  for ( int i = 1; i < 200; ++i ) probs.push_back( i / 200. );
+
+  for ( size_t f = 0u; f < pdfs.size(); ++f ) {
+    const auto& pdf = pdfs.at( f );
+    INFO( "PDF " << f );
+
+    marley::ChebyshevInterpolatingFunction func( pdf, X_MIN, X_MAX );
+    marley::ChebyshevInterpolatingFunction cdf = func.cdf();
+    REQUIRE( cdf.has_inverse_table() );
+    double norm = cdf.evaluate( X_MAX );
+
+    marley::ChebyshevInterpolant<marley::DEFAULT_N_CHEBYSHEV> fixed_func(
+      pdf, X_MIN, X_MAX );
+    auto fixed_cdf = fixed_func.cdf();
+    double fixed_norm = fixed_cdf.evaluate( X_MAX );
+
+    for ( double p : probs ) {
+      INFO( "p = " << p );
+
+      double x = cdf.inverse_cdf( p, TOLERANCE );
+      CHECK( x >= X_MIN );
+      CHECK( x <= X_MAX );
+      CHECK( cdf.evaluate(x) / norm == Approx(p).margin(1e-8) );
+
+      double fixed_x = fixed_cdf.inverse_cdf( p, TOLERANCE );
+      CHECK( fixed_x >= X_MIN );
+      CHECK( fixed_x <= X_MAX );
+      CHECK( fixed_cdf.evaluate(fixed_x) / fixed_norm
+        == Approx(p).margin(1e-8) );
+    }
+
+    // The endpoints of the interval should be returned exactly
+    CHECK( cdf.inverse_cdf(0., TOLERANCE) == X_MIN );
+    CHECK( cdf.inverse_cdf(1., TOLERANCE) == X_MAX );
+    CHECK( fixed_cdf.inverse_cdf(0., TOLERANCE) == X_MIN );
+    CHECK( fixed_cdf.inverse_cdf(1., TOLERANCE) == X_MAX );
+  }
+
+  // Only CDFs can be inverted
+  marley::ChebyshevInterpolatingFunction func( pdfs.front(), X_MIN, X_MAX );
+  CHECK_THROWS_AS( func.inverse_cdf(0.5, TOLERANCE), marley::Error );
+}